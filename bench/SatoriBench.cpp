@@ -0,0 +1,317 @@
+// Microbenchmarks for the DSP hot paths. Each case runs until it has spent
+// at least --min-time seconds (after a short warm-up) and reports the cost per
+// output sample and the real-time factor at 48 kHz; transforms report the
+// cost per call instead. Names are matched as substrings: SatoriBench engine
+// runs only the engine cases.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dsp/ConvolutionReverb.h"
+#include "dsp/Denormals.h"
+#include "dsp/Fft.h"
+#include "dsp/PartitionedConvolver.h"
+#include "dsp/SympatheticStrings.h"
+#include "engine/StringSynthEngine.h"
+#include "synthesis/KarplusStrongString.h"
+
+namespace {
+
+constexpr double kSampleRate = 48000.0;
+
+struct Options {
+    double minSeconds = 0.3;
+    std::vector<std::string> filters;
+};
+
+// One timed unit of work and the number of samples it produces (0 for
+// benchmarks measured per call).
+struct Case {
+    std::string name;
+    std::size_t samplesPerRun = 0;
+    std::function<std::function<void()>()> setup;  // builds state, returns the run
+};
+
+volatile float gSink = 0.0f;  // keeps results observable
+
+bool Selected(const Options& options, const std::string& name) {
+    if (options.filters.empty()) {
+        return true;
+    }
+    return std::any_of(options.filters.begin(), options.filters.end(),
+                       [&](const std::string& f) { return name.find(f) != std::string::npos; });
+}
+
+void RunCase(const Case& c, const Options& options) {
+    using Clock = std::chrono::steady_clock;
+    const std::function<void()> run = c.setup();
+
+    // Warm up caches, lazily built tables and branch predictors.
+    const auto warmEnd = Clock::now() + std::chrono::milliseconds(50);
+    while (Clock::now() < warmEnd) {
+        run();
+    }
+
+    std::size_t runs = 0;
+    const auto start = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < options.minSeconds) {
+        for (int i = 0; i < 8; ++i) {
+            run();
+        }
+        runs += 8;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    const double nsPerRun = elapsed * 1e9 / static_cast<double>(runs);
+    if (c.samplesPerRun > 0) {
+        const double nsPerSample = nsPerRun / static_cast<double>(c.samplesPerRun);
+        const double realtime = 1e9 / (nsPerSample * kSampleRate);
+        std::printf("%-44s %12.2f ns/sample %10.1fx realtime\n", c.name.c_str(), nsPerSample,
+                    realtime);
+    } else {
+        std::printf("%-44s %12.1f ns/call\n", c.name.c_str(), nsPerRun);
+    }
+    std::fflush(stdout);
+}
+
+// Exponentially decaying noise, roughly the shape of a room response.
+std::vector<float> SyntheticIr(std::size_t frames, unsigned seed) {
+    std::vector<float> ir(frames);
+    unsigned state = seed * 2654435761u + 1u;
+    for (std::size_t i = 0; i < frames; ++i) {
+        state = state * 1664525u + 1013904223u;
+        const float noise = static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+        ir[i] = noise * std::exp(-3.0f * static_cast<float>(i) / static_cast<float>(frames));
+    }
+    return ir;
+}
+
+void AddStringCases(std::vector<Case>& cases) {
+    cases.push_back({"string/processSample", 1024, [] {
+        auto string = std::make_shared<synthesis::KarplusStrongString>();
+        synthesis::StringConfig config;
+        config.sampleRate = kSampleRate;
+        config.decay = 0.9999f;
+        string->updateConfig(config);
+        string->start(220.0);
+        return std::function<void()>([string] {
+            if (!string->active()) {
+                string->start(220.0);
+            }
+            float acc = 0.0f;
+            for (int i = 0; i < 1024; ++i) {
+                acc += string->processSample();
+            }
+            gSink = acc;
+        });
+    }});
+    cases.push_back({"string/processBlock", 1024, [] {
+        auto string = std::make_shared<synthesis::KarplusStrongString>();
+        synthesis::StringConfig config;
+        config.sampleRate = kSampleRate;
+        config.decay = 0.9999f;
+        string->updateConfig(config);
+        string->start(220.0);
+        auto out = std::make_shared<std::vector<float>>(1024);
+        return std::function<void()>([string, out] {
+            if (!string->active()) {
+                string->start(220.0);
+            }
+            string->processBlock(out->data(), out->size());
+            gSink = (*out)[0];
+        });
+    }});
+}
+
+// `voices` notes held and re-struck every half second of rendered audio so
+// the voice count stays constant however long the case runs.
+void AddEngineCase(std::vector<Case>& cases, std::size_t voices, std::size_t blockFrames,
+                   float room, float spread = 0.0f, float courseDetune = 0.0f) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "engine/voices=%zu/block=%zu%s%s%s", voices, blockFrames,
+                  room > 0.0f ? "/room" : "", spread > 0.0f ? "/stereo" : "",
+                  courseDetune > 0.0f ? "/course" : "");
+    cases.push_back({name, blockFrames, [voices, blockFrames, room, spread, courseDetune] {
+        auto engine = std::make_shared<engine::StringSynthEngine>(
+            synthesis::StringConfig{}, std::max(voices, engine::StringSynthEngine::kDefaultMaxVoices));
+        engine->setRenderMode(engine::RenderMode::Offline);
+        engine->setSampleRate(kSampleRate);
+        engine->setParam(engine::ParamId::RoomAmount, room);
+        engine->setParam(engine::ParamId::StereoSpread, spread);
+        engine->setParam(engine::ParamId::CourseDetune, courseDetune);
+        auto out = std::make_shared<std::vector<float>>(blockFrames * 2);
+        auto restrikeAt = std::make_shared<std::uint64_t>(0);
+        return std::function<void()>([engine, out, restrikeAt, voices, blockFrames] {
+            if (engine->renderedFrames() >= *restrikeAt) {
+                for (std::size_t v = 0; v < voices; ++v) {
+                    const double frequency = 110.0 * std::pow(2.0, static_cast<double>(v % 36) / 12.0);
+                    engine->noteOn(static_cast<int>(v + 1), frequency, 0.8f);
+                }
+                *restrikeAt = engine->renderedFrames() + static_cast<std::uint64_t>(kSampleRate / 2);
+            }
+            engine::ProcessBlock block{out->data(), blockFrames, 2};
+            engine->process(block);
+            gSink = (*out)[0];
+        });
+    }});
+}
+
+void AddConvolverCases(std::vector<Case>& cases) {
+    // Uniform 256-sample partitions over a 2 s mono IR.
+    cases.push_back({"convolver/block=256/ir=2s", 256, [] {
+        const std::size_t block = 256;
+        const auto ir = SyntheticIr(static_cast<std::size_t>(2.0 * kSampleRate), 1);
+        auto kernel = std::make_shared<dsp::ConvolutionKernel>(
+            dsp::PartitionedConvolver::buildKernelFromIr(ir, block, block * 2));
+        auto conv = std::make_shared<dsp::PartitionedConvolver>();
+        conv->configure(block, block * 2, kernel->partitionCount);
+        conv->reset();
+        auto in = std::make_shared<std::vector<float>>(SyntheticIr(block, 2));
+        auto out = std::make_shared<std::vector<float>>(block);
+        return std::function<void()>([kernel, conv, in, out] {
+            conv->pushInputBlock(in->data());
+            conv->convolve(*kernel, out->data());
+            gSink = (*out)[0];
+        });
+    }});
+}
+
+void AddFftCases(std::vector<Case>& cases) {
+    for (const std::size_t size : {512u, 2048u, 8192u}) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "fft/real/n=%zu (forward+inverse)", size);
+        cases.push_back({name, 0, [size] {
+            auto fft = std::make_shared<dsp::Fft>(size);
+            auto time = std::make_shared<std::vector<float>>(SyntheticIr(size, 3));
+            auto spectrum = std::make_shared<std::vector<std::complex<float>>>(fft->realBins());
+            return std::function<void()>([fft, time, spectrum] {
+                fft->forwardReal(time->data(), spectrum->data());
+                fft->inverseReal(spectrum->data(), time->data());
+                // The round trip scales by n; undo it so values stay bounded.
+                const float scale = 1.0f / static_cast<float>(fft->size());
+                for (float& v : *time) {
+                    v *= scale;
+                }
+                gSink = (*time)[0];
+            });
+        }});
+    }
+}
+
+void AddReverbCases(std::vector<Case>& cases) {
+    // The room layout: 256 head-of-tail stage plus 1024 and 4096 stages.
+    for (const bool stereo : {false, true}) {
+        cases.push_back({stereo ? "reverb/processBlockWet/stereo-ir=2.5s"
+                                : "reverb/processBlockWet/mono-ir=2.5s",
+                         256, [stereo] {
+            const auto layout = dsp::PartitionLayout::FromBlockSizes({256, 1024, 4096});
+            const std::size_t frames = static_cast<std::size_t>(2.5 * kSampleRate);
+            const auto left = SyntheticIr(frames, 4);
+            const auto right = SyntheticIr(frames, 5);
+            std::vector<dsp::StereoConvolutionKernel> kernels;
+            kernels.push_back(layout.buildKernel(left.data(), stereo ? right.data() : nullptr, frames));
+            auto reverb = std::make_shared<dsp::ConvolutionReverb>();
+            reverb->setPartitionLayout(layout);
+            reverb->setIrKernels(std::move(kernels));
+            reverb->setSampleRate(kSampleRate);
+            reverb->setMix(1.0f);
+            auto in = std::make_shared<std::vector<float>>(SyntheticIr(256, 6));
+            auto outL = std::make_shared<std::vector<float>>(256);
+            auto outR = std::make_shared<std::vector<float>>(256);
+            return std::function<void()>([reverb, in, outL, outR] {
+                reverb->processBlockWet(in->data(), outL->data(), outR->data());
+                gSink = (*outL)[0] + (*outR)[0];
+            });
+        }});
+    }
+}
+
+void AddSympatheticCases(std::vector<Case>& cases) {
+    // Guitar and koto tunings: two and four lane groups.
+    using dsp::SympatheticStrings;
+    for (const auto preset :
+         {SympatheticStrings::Preset::Guitar, SympatheticStrings::Preset::Koto}) {
+        const std::size_t strings = SympatheticStrings::PresetTuning(preset).size();
+        char name[64];
+        std::snprintf(name, sizeof(name), "sympathetic/strings=%zu/block=256", strings);
+        cases.push_back({name, 256, [preset] {
+            auto bank = std::make_shared<SympatheticStrings>();
+            bank->setSampleRate(kSampleRate);
+            bank->setTuning(SympatheticStrings::PresetTuning(preset));
+            bank->setAmount(0.5f);
+            auto source = std::make_shared<std::vector<float>>(SyntheticIr(256, 7));
+            auto block = std::make_shared<std::vector<float>>(256);
+            return std::function<void()>([bank, source, block] {
+                std::copy(source->begin(), source->end(), block->begin());
+                bank->processBlock(block->data(), block->size());
+                gSink = (*block)[0];
+            });
+        }});
+    }
+}
+
+void PrintUsage() {
+    std::printf("用法: SatoriBench [--min-time 0.3] [--list] [名称过滤 ...]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    bool listOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        }
+        if (arg == "--list") {
+            listOnly = true;
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.minSeconds = std::max(0.01, std::atof(argv[++i]));
+        } else {
+            options.filters.push_back(arg);
+        }
+    }
+
+    std::vector<Case> cases;
+    AddStringCases(cases);
+    for (const std::size_t voices : {1u, 8u, 32u, 128u}) {
+        for (const std::size_t block : {64u, 256u, 1024u}) {
+            AddEngineCase(cases, voices, block, 0.0f);
+        }
+    }
+    AddEngineCase(cases, 32, 256, 0.5f);
+    AddEngineCase(cases, 32, 256, 0.0f, 1.0f);
+    for (const std::size_t voices : {8u, 32u}) {
+        AddEngineCase(cases, voices, 256, 0.0f, 0.0f, 4.0f);
+    }
+    AddConvolverCases(cases);
+    AddFftCases(cases);
+    AddReverbCases(cases);
+    AddSympatheticCases(cases);
+
+    // The audio thread and reverb worker run this way; so do the benchmarks.
+    dsp::ScopedDenormalsDisable denormalsGuard;
+    std::printf("FFT backend: %s\n", dsp::Fft::backendName());
+    for (const auto& c : cases) {
+        if (!Selected(options, c.name)) {
+            continue;
+        }
+        if (listOnly) {
+            std::printf("%s\n", c.name.c_str());
+        } else {
+            RunCase(c, options);
+        }
+    }
+    return 0;
+}
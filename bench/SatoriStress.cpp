@@ -0,0 +1,247 @@
+// Real-time budget stress test. A render thread calls StringSynthEngine
+// ::process() once per buffer period, as the WASAPI/ASIO callbacks do, while
+// a synthetic MIDI stream (rolling chords plus fast repeated notes, room
+// fully wet) keeps every voice busy. Reports callback time percentiles
+// against the buffer period and counts deadline misses; --find-max raises
+// polyphony until the budget no longer holds.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dsp/Denormals.h"
+#include "engine/MidiNote.h"
+#include "engine/RealtimeThread.h"
+#include "engine/StringSynthEngine.h"
+
+namespace {
+
+struct Options {
+    double sampleRate = 48000.0;
+    std::size_t blockFrames = 256;
+    std::size_t voices = 32;
+    std::size_t renderThreads = 0;
+    double seconds = 10.0;
+    float room = 1.0f;
+    bool findMax = false;
+    // --find-max accepts a polyphony while p99 stays under this share of the
+    // period and no callback misses its deadline.
+    double maxP99Load = 0.7;
+};
+
+struct Report {
+    std::size_t callbacks = 0;
+    std::size_t deadlineMisses = 0;
+    double periodUs = 0.0;
+    double p50Us = 0.0;
+    double p90Us = 0.0;
+    double p99Us = 0.0;
+    double p999Us = 0.0;
+    double maxUs = 0.0;
+    double meanVoices = 0.0;
+    engine::RoomTelemetry room;
+};
+
+// Deterministic note stream: a chord of up to eight notes every 120 ms, each
+// held 400 ms, plus one note re-struck every 25 ms. With maxVoices set to the
+// target polyphony the pool stays full and stealing is exercised too.
+class SyntheticMidi {
+public:
+    SyntheticMidi(double sampleRate, std::size_t voices)
+        : chordPeriod_(static_cast<std::uint64_t>(0.12 * sampleRate)),
+          chordHold_(static_cast<std::uint64_t>(0.4 * sampleRate)),
+          repeatPeriod_(static_cast<std::uint64_t>(0.025 * sampleRate)),
+          repeatHold_(static_cast<std::uint64_t>(0.02 * sampleRate)),
+          chordSize_(std::clamp<std::size_t>(voices / 4, 1, 8)) {}
+
+    void queueUpTo(engine::StringSynthEngine& engine, std::uint64_t endFrame) {
+        while (nextChord_ < endFrame) {
+            for (std::size_t n = 0; n < chordSize_; ++n) {
+                // Walk the keyboard so concurrent voices differ in pitch.
+                const int key = 36 + static_cast<int>((chordIndex_ * 5 + n * 4) % 48);
+                const float velocity = 0.5f + 0.5f * static_cast<float>((chordIndex_ + n) % 4) / 3.0f;
+                Strike(engine, nextNoteId_++, engine::MidiNoteToFrequency(key), velocity,
+                       nextChord_, chordHold_);
+            }
+            ++chordIndex_;
+            nextChord_ += chordPeriod_;
+        }
+        while (nextRepeat_ < endFrame) {
+            // Same id every time: re-strikes one voice.
+            Strike(engine, 1, 659.26, 0.9f, nextRepeat_, repeatHold_);
+            nextRepeat_ += repeatPeriod_;
+        }
+    }
+
+private:
+    static void Strike(engine::StringSynthEngine& engine, int noteId, double frequency,
+                       float velocity, std::uint64_t frame, std::uint64_t hold) {
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = noteId;
+        on.frequency = frequency;
+        on.velocity = velocity;
+        engine.enqueueEventAt(on, frame);
+        engine::Event off{};
+        off.type = engine::EventType::NoteOff;
+        off.noteId = noteId;
+        engine.enqueueEventAt(off, frame + hold);
+    }
+
+    std::uint64_t chordPeriod_;
+    std::uint64_t chordHold_;
+    std::uint64_t repeatPeriod_;
+    std::uint64_t repeatHold_;
+    std::size_t chordSize_;
+    std::uint64_t nextChord_ = 0;
+    std::uint64_t nextRepeat_ = 0;
+    std::size_t chordIndex_ = 0;
+    int nextNoteId_ = 2;
+};
+
+double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    const std::size_t index = std::min(
+        values.size() - 1, static_cast<std::size_t>(std::ceil(p * values.size())) - 1);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index),
+                     values.end());
+    return values[index];
+}
+
+Report RunLoad(const Options& options, std::size_t voices) {
+    Report report;
+    std::thread render([&] {
+        const engine::ScopedRealtimeThread realtime(engine::RealtimeThreadRole::Render);
+        dsp::ScopedDenormalsDisable denormalsGuard;
+        using Clock = std::chrono::steady_clock;
+
+        engine::StringSynthEngine synth(synthesis::StringConfig{}, voices, options.renderThreads);
+        synth.setRenderMode(engine::RenderMode::Realtime);
+        synth.setSampleRate(options.sampleRate);
+        synth.setParam(engine::ParamId::RoomAmount, options.room);
+        SyntheticMidi midi(options.sampleRate, voices);
+
+        const auto period = std::chrono::duration<double>(
+            static_cast<double>(options.blockFrames) / options.sampleRate);
+        const std::size_t callbacks = static_cast<std::size_t>(
+            std::ceil(options.seconds * options.sampleRate / options.blockFrames));
+        std::vector<float> buffer(options.blockFrames * 2);
+        std::vector<double> timesUs;
+        timesUs.reserve(callbacks);
+        double voiceSum = 0.0;
+
+        auto deadline = Clock::now();
+        for (std::size_t i = 0; i < callbacks; ++i) {
+            // Like a device, the next buffer is due one period after the last
+            // deadline; an overrun eats into the following buffer's time.
+            deadline += std::chrono::duration_cast<Clock::duration>(period);
+            midi.queueUpTo(synth, synth.renderedFrames() + options.blockFrames);
+
+            const auto start = Clock::now();
+            engine::ProcessBlock block{buffer.data(), options.blockFrames, 2};
+            synth.process(block);
+            const auto end = Clock::now();
+
+            timesUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            voiceSum += static_cast<double>(synth.activeVoiceCount());
+            if (end > deadline) {
+                ++report.deadlineMisses;
+                deadline = end;  // the device would have glitched and resynced
+            } else {
+                std::this_thread::sleep_until(deadline);
+            }
+        }
+
+        report.callbacks = callbacks;
+        report.periodUs = std::chrono::duration<double, std::micro>(period).count();
+        report.p50Us = Percentile(timesUs, 0.50);
+        report.p90Us = Percentile(timesUs, 0.90);
+        report.p99Us = Percentile(timesUs, 0.99);
+        report.p999Us = Percentile(timesUs, 0.999);
+        report.maxUs = timesUs.empty() ? 0.0 : *std::max_element(timesUs.begin(), timesUs.end());
+        report.meanVoices = callbacks > 0 ? voiceSum / static_cast<double>(callbacks) : 0.0;
+        report.room = synth.roomTelemetry();
+    });
+    render.join();
+    return report;
+}
+
+void PrintReport(std::size_t voices, const Report& r) {
+    auto load = [&](double us) { return 100.0 * us / r.periodUs; };
+    std::printf("voices=%-4zu (mean active %.1f)  p50 %7.1fus (%5.1f%%)  p90 %7.1fus (%5.1f%%)  "
+                "p99 %7.1fus (%5.1f%%)  p99.9 %7.1fus  max %7.1fus  misses %zu/%zu  "
+                "room late %llu (tail p99 %.0fus, queue peak %zu/%zu)\n",
+                voices, r.meanVoices, r.p50Us, load(r.p50Us), r.p90Us, load(r.p90Us), r.p99Us,
+                load(r.p99Us), r.p999Us, r.maxUs, r.deadlineMisses, r.callbacks,
+                static_cast<unsigned long long>(r.room.lateBlocks), r.room.tailBlockUsP99,
+                r.room.dryQueueHighWater, r.room.wetQueueHighWater);
+    std::fflush(stdout);
+}
+
+void PrintUsage() {
+    std::printf(
+        "用法: SatoriStress [--block 256] [--samplerate 48000] [--voices 32] [--seconds 10] "
+        "[--room 1.0] [--threads 0] [--find-max] [--max-load 0.7]\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage();
+            return 0;
+        } else if (arg == "--find-max") {
+            options.findMax = true;
+        } else if (arg == "--block" && hasValue) {
+            options.blockFrames = std::clamp<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 16, 8192);
+        } else if (arg == "--samplerate" && hasValue) {
+            options.sampleRate = std::max(8000.0, std::atof(argv[++i]));
+        } else if (arg == "--voices" && hasValue) {
+            options.voices = std::clamp<std::size_t>(std::strtoul(argv[++i], nullptr, 10), 1,
+                                                     engine::StringSynthEngine::kMaxVoicesLimit);
+        } else if (arg == "--seconds" && hasValue) {
+            options.seconds = std::max(0.1, std::atof(argv[++i]));
+        } else if (arg == "--room" && hasValue) {
+            options.room = std::clamp(static_cast<float>(std::atof(argv[++i])), 0.0f, 1.0f);
+        } else if (arg == "--threads" && hasValue) {
+            options.renderThreads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--max-load" && hasValue) {
+            options.maxP99Load = std::clamp(std::atof(argv[++i]), 0.05, 1.0);
+        }
+    }
+
+    std::printf("block %zu @ %.0f Hz (period %.1f us), room %.2f, render threads %zu\n",
+                options.blockFrames, options.sampleRate,
+                1e6 * static_cast<double>(options.blockFrames) / options.sampleRate, options.room,
+                options.renderThreads);
+
+    if (!options.findMax) {
+        PrintReport(options.voices, RunLoad(options, options.voices));
+        return 0;
+    }
+
+    // Step up in eights; each step runs the full --seconds.
+    std::size_t best = 0;
+    for (std::size_t voices = 8; voices <= engine::StringSynthEngine::kMaxVoicesLimit; voices += 8) {
+        const Report report = RunLoad(options, voices);
+        PrintReport(voices, report);
+        if (report.deadlineMisses > 0 || report.p99Us > options.maxP99Load * report.periodUs) {
+            break;
+        }
+        best = voices;
+    }
+    std::printf("max polyphony within budget: %zu\n", best);
+    return best > 0 ? 0 : 1;
+}
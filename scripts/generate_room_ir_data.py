@@ -8,11 +8,22 @@ Output: RoomIrData.h / RoomIrData.cpp with static arrays (no runtime file IO).
 Notes:
 - `.wv` (WavPack) decoding is done via an external tool:
   - Prefer `ffmpeg` if available on PATH, otherwise try `wvunpack`.
+- Each IR also gets a peak-envelope and Schroeder energy-decay curve (dB,
+  --envelope points each) and an RT60 estimate, so the UI never scans the
+  samples itself.
+- With --kernel_rates, partitioned frequency-domain kernels are emitted too
+  (same split, bin layout and resampling as the runtime), so the Room module
+  can use them without FFTs. The runtime checks the layout and falls back to
+  building kernels itself on any mismatch.
+- With --storage int16, samples are embedded as 16-bit integers plus a scale
+  per IR (half the size); dsp::RoomIrLibrary decodes an IR to floats the
+  first time it is asked for and keeps it.
 """
 
 from __future__ import annotations
 
 import argparse
+import cmath
 import math
 import os
 import re
@@ -133,24 +144,351 @@ def _build_preview(samples: List[float], max_samples: int) -> List[float]:
     return out
 
 
-def _format_float_array(name: str, values: List[float]) -> str:
+_DB_FLOOR = -96.0
+
+
+def _to_db(value: float, reference: float) -> float:
+    if value <= 0.0 or reference <= 0.0:
+        return _DB_FLOOR
+    return max(_DB_FLOOR, 20.0 * math.log10(value / reference))
+
+
+def _build_decay_data(channels: List[List[float]],
+                      sample_rate: int,
+                      points: int) -> Tuple[List[float], List[float], float]:
+    """(peak envelope dB, energy decay curve dB, RT60 seconds) of the IR.
+
+    Both curves have `points` values, one per equal slice of the IR: the
+    envelope is the slice's peak relative to the IR peak, the EDC is the
+    Schroeder backward integral at the slice start relative to the total.
+    RT60 extrapolates the EDC slope between -5 dB and -35 dB (T30), or the
+    deepest of -25/-15 dB the curve reaches; 0 if it reaches none.
+    """
+    frames = len(channels[0]) if channels else 0
+    if points <= 0 or frames == 0:
+        return [], [], 0.0
+    energy = [0.0] * frames
+    peak_abs = [0.0] * frames
+    for ch in channels:
+        for i, v in enumerate(ch):
+            energy[i] += v * v
+            peak_abs[i] = max(peak_abs[i], abs(v))
+    remaining = [0.0] * (frames + 1)
+    for i in range(frames - 1, -1, -1):
+        remaining[i] = remaining[i + 1] + energy[i]
+    total = remaining[0]
+    peak = max(peak_abs)
+
+    envelope: List[float] = []
+    edc: List[float] = []
+    for p in range(points):
+        begin = min(frames - 1, p * frames // points)
+        end = max(begin + 1, (p + 1) * frames // points)
+        envelope.append(_to_db(max(peak_abs[begin:end]), peak))
+        # Energy ratio -> dB is 10*log10, i.e. _to_db on the square root.
+        edc.append(_to_db(math.sqrt(remaining[begin]), math.sqrt(total)))
+
+    rt60 = 0.0
+    if total > 0.0:
+        edc_db = [10.0 * math.log10(r / total) if r > 0.0 else -math.inf
+                  for r in remaining[:frames]]
+        for low in (-35.0, -25.0, -15.0):
+            idx = [i for i, d in enumerate(edc_db) if low <= d <= -5.0]
+            if not idx or edc_db[-1] > low:
+                continue
+            # Least-squares line through the EDC (dB vs seconds).
+            n = float(len(idx))
+            ts = [i / sample_rate for i in idx]
+            mean_t = sum(ts) / n
+            mean_d = sum(edc_db[i] for i in idx) / n
+            var = sum((t - mean_t) ** 2 for t in ts)
+            if var <= 0.0:
+                continue
+            slope = sum((t - mean_t) * (edc_db[i] - mean_d) for t, i in zip(ts, idx)) / var
+            if slope < 0.0:
+                rt60 = -60.0 / slope
+            break
+    return envelope, edc, rt60
+
+
+def _float_literal(v: float) -> str:
     # Keep file size reasonable: 7 significant digits is plenty for IRs.
+    base = f"{v:.7g}"
+    # Ensure it's a valid float literal when suffixed with 'f' (e.g. "0f" is invalid).
+    if re.fullmatch(r"-?\d+", base):
+        base = base + ".0"
+    return f"{base}f"
+
+
+def _format_float_array(name: str, values: List[float], aligned: bool = False) -> str:
     parts: List[str] = []
     line: List[str] = []
     for v in values:
-        base = f"{v:.7g}"
-        # Ensure it's a valid float literal when suffixed with 'f' (e.g. "0f" is invalid).
-        if re.fullmatch(r"-?\d+", base):
-            base = base + ".0"
-        s = f"{base}f"
-        line.append(s)
+        line.append(_float_literal(v))
         if len(line) >= 12:
             parts.append(", ".join(line))
             line = []
     if line:
         parts.append(", ".join(line))
     body = ",\n    ".join(parts)
-    return f"static const float {name}[] = {{\n    {body}\n}};\n"
+    prefix = "alignas(64) " if aligned else ""
+    return f"{prefix}static const float {name}[] = {{\n    {body}\n}};\n"
+
+
+def _f32(v: float) -> float:
+    return struct.unpack("<f", struct.pack("<f", v))[0]
+
+
+def _embedded(values: List[float]) -> List[float]:
+    """Samples as the runtime sees them (parsed back from the emitted literals)."""
+    return [_f32(float(f"{v:.7g}")) for v in values]
+
+
+def _scale_literal(v: float) -> str:
+    # Nine digits round-trip a float exactly, so the scale the generator
+    # decodes with is the one the runtime parses.
+    return f"{v:.9g}f"
+
+
+def _int16_scale(item: "IrItem") -> float:
+    peak = max((abs(v) for v in item.samples_l), default=0.0)
+    if item.samples_r is not None:
+        peak = max(peak, max((abs(v) for v in item.samples_r), default=0.0))
+    if peak <= 0.0:
+        peak = 1.0
+    return _f32(float(_scale_literal(_f32(peak / 32767.0))[:-1]))
+
+
+def _quantize_int16(values: List[float], scale: float) -> List[int]:
+    return [max(-32767, min(32767, int(round(v / scale)))) for v in values]
+
+
+def _decoded_int16(values: List[int], scale: float) -> List[float]:
+    """Mirrors RoomIrLibrary's decode: float(q) * scale, rounded once to float."""
+    return [_f32(float(q) * scale) for q in values]
+
+
+def _stored(item: "IrItem", values: List[float], storage: str) -> List[float]:
+    """Samples as the runtime sees them for the chosen storage."""
+    if storage == "int16":
+        scale = _int16_scale(item)
+        return _decoded_int16(_quantize_int16(values, scale), scale)
+    return _embedded(values)
+
+
+def _format_int16_array(name: str, values: List[int]) -> str:
+    parts: List[str] = []
+    for start in range(0, len(values), 16):
+        parts.append(", ".join(str(v) for v in values[start:start + 16]))
+    body = ",\n    ".join(parts)
+    return f"static const std::int16_t {name}[] = {{\n    {body}\n}};\n"
+
+
+def _resampled_frames(count: int, src_rate: int, dst_rate: int) -> int:
+    if count == 0:
+        return 0
+    if src_rate == dst_rate:
+        return count
+    # std::llround: halves away from zero.
+    return max(1, int(math.floor(count * (dst_rate / src_rate) + 0.5)))
+
+
+_POLYPHASE_HALF_TAPS = 32
+_POLYPHASE_CUTOFF = 0.95
+_POLYPHASE_KAISER_BETA = 9.0
+_POLYPHASE_LANES = 4
+_BANKS = {}
+
+
+def _bessel_i0(x: float) -> float:
+    q = 0.25 * x * x
+    term = 1.0
+    total = 1.0
+    k = 1
+    while k < 64 and term > 1.0e-12 * total:
+        term *= q / (k * k)
+        total += term
+        k += 1
+    return total
+
+
+def _polyphase_bank(src_rate: int, dst_rate: int) -> Tuple[int, int, int, List[List[float]]]:
+    """Mirrors dsp::PolyphaseFilterBank: (L, M, taps, float-rounded rows)."""
+    key = (src_rate, dst_rate)
+    bank = _BANKS.get(key)
+    if bank is not None:
+        return bank
+    g = math.gcd(src_rate, dst_rate)
+    up = dst_rate // g
+    down = src_rate // g
+    scale = min(1.0, up / down)
+    cutoff = _POLYPHASE_CUTOFF * scale
+    half = int(math.ceil(_POLYPHASE_HALF_TAPS / scale))
+    taps = (2 * half + _POLYPHASE_LANES - 1) // _POLYPHASE_LANES * _POLYPHASE_LANES
+    width = float(taps // 2)
+    centre = float(taps // 2 - 1)
+    norm = 1.0 / _bessel_i0(_POLYPHASE_KAISER_BETA)
+    rows: List[List[float]] = []
+    for p in range(up):
+        frac = p / up
+        row = []
+        for k in range(taps):
+            d = k - centre - frac
+            x = d / width
+            h = 0.0
+            if abs(x) < 1.0:
+                arg = math.pi * cutoff * d
+                sinc = 1.0 if abs(arg) < 1.0e-12 else math.sin(arg) / arg
+                h = cutoff * sinc * _bessel_i0(_POLYPHASE_KAISER_BETA * math.sqrt(1.0 - x * x)) * norm
+            row.append(h)
+        total = sum(row)
+        rows.append([_f32(h / total) for h in row])
+    bank = (up, down, taps, rows)
+    _BANKS[key] = bank
+    return bank
+
+
+def _resample_polyphase(src: List[float], src_rate: int, dst_rate: int) -> List[float]:
+    """Mirrors dsp::PolyphaseResampler::process (sums in double, not lane order)."""
+    if src_rate == dst_rate:
+        return src[:]
+    up, down, taps, rows = _polyphase_bank(src_rate, dst_rate)
+    n = len(src)
+    centre = taps // 2 - 1
+    padded = [0.0] * taps + src + [0.0] * (2 * taps + 1)
+    out = []
+    for i in range(_resampled_frames(n, src_rate, dst_rate)):
+        pos = i * down
+        i0 = pos // up
+        base = i0 + taps - centre
+        window = padded[base:base + taps]
+        out.append(_f32(sum(h * x for h, x in zip(rows[pos % up], window))))
+    return out
+
+
+def _is_dual_mono(left: List[float], right: List[float]) -> bool:
+    """Mirrors RoomProcessor::SourceIr: stereo files with L==R (~-60dB) are mono."""
+    energy = 0.0
+    diff_energy = 0.0
+    for l, r in zip(left, right):
+        energy += 0.5 * (l * l + r * r)
+        diff_energy += (l - r) * (l - r)
+    if energy <= 2.2250738585072014e-308:
+        return True
+    frames = float(len(left))
+    return math.sqrt(diff_energy / frames) / max(1e-12, math.sqrt(energy / frames)) < 1e-3
+
+
+_TWIDDLES = {}
+
+
+def _fft_real_half(x: List[float], n: int) -> List[complex]:
+    """Bins 0..n/2 of the forward DFT of x zero-padded to n (double precision)."""
+    plan = _TWIDDLES.get(n)
+    if plan is None:
+        bits = n.bit_length() - 1
+        plan = ([cmath.exp(-2j * math.pi * k / n) for k in range(n // 2)],
+                [int(format(i, f"0{bits}b")[::-1], 2) for i in range(n)])
+        _TWIDDLES[n] = plan
+    tw, rev = plan
+    a = [0j] * n
+    for i, v in enumerate(x):
+        a[rev[i]] = complex(v, 0.0)
+    size = 2
+    while size <= n:
+        half = size // 2
+        step = n // size
+        for start in range(0, n, size):
+            for k in range(half):
+                w = tw[k * step]
+                u = a[start + k]
+                v = a[start + k + half] * w
+                a[start + k] = u + v
+                a[start + k + half] = u - v
+        size *= 2
+    return a[: n // 2 + 1]
+
+
+def _layout_offsets(blocks: List[int]) -> List[int]:
+    """Mirrors dsp::PartitionLayout::FromBlockSizes."""
+    base = blocks[0]
+    offsets = [0]
+    for s in range(1, len(blocks)):
+        prev_offset = offsets[-1]
+        prev_block = blocks[s - 1]
+        needed = max(0, 2 * blocks[s] - 2 * base - prev_offset)
+        parts = max(1, (needed + prev_block - 1) // prev_block)
+        offsets.append(prev_offset + parts * prev_block)
+    return offsets
+
+
+def _stage_spectra(ir: List[float], block: int, bin_stride: int) -> Tuple[int, List[float], List[float]]:
+    """Partition-major split re/im rows, as PartitionedConvolver::buildKernelFromIr."""
+    parts = (len(ir) + block - 1) // block
+    re: List[float] = []
+    im: List[float] = []
+    pad = [0.0] * (bin_stride - (block + 1))
+    for p in range(parts):
+        spectrum = _fft_real_half(ir[p * block:(p + 1) * block], 2 * block)
+        re.extend(c.real for c in spectrum)
+        re.extend(pad)
+        im.extend(c.imag for c in spectrum)
+        im.extend(pad)
+    return parts, re, im
+
+
+@dataclass(frozen=True)
+class KernelStage:
+    block: int
+    offset: int
+    parts: int
+    left: Tuple[List[float], List[float]]
+    right: Optional[Tuple[List[float], List[float]]]
+
+
+@dataclass(frozen=True)
+class KernelSet:
+    item_index: int
+    sample_rate: int
+    channels: int
+    stages: List[KernelStage]
+
+
+def _build_kernel_sets(items: List["IrItem"],
+                       rates: List[int],
+                       blocks: List[int],
+                       skip: int,
+                       align: int,
+                       storage: str) -> List[KernelSet]:
+    offsets = _layout_offsets(blocks)
+    sets: List[KernelSet] = []
+    for index, it in enumerate(items):
+        left_src = _stored(it, it.samples_l, storage)
+        right_src = _stored(it, it.samples_r, storage) if it.samples_r is not None else None
+        if right_src is not None and _is_dual_mono(left_src, right_src):
+            right_src = None
+        for rate in rates:
+            channels = [left_src] if right_src is None else [left_src, right_src]
+            resampled = [_resample_polyphase(ch, it.sample_rate, rate)[skip:] for ch in channels]
+            frames = len(resampled[0])
+            stages: List[KernelStage] = []
+            for s, block in enumerate(blocks):
+                begin = min(offsets[s], frames)
+                end = min(offsets[s + 1], frames) if s + 1 < len(offsets) else frames
+                if begin >= end:
+                    break
+                stride = (block + 1 + align - 1) // align * align
+                spectra = [_stage_spectra(ch[begin:end], block, stride) for ch in resampled]
+                stages.append(KernelStage(block=block,
+                                          offset=offsets[s],
+                                          parts=spectra[0][0],
+                                          left=(spectra[0][1], spectra[0][2]),
+                                          right=(spectra[1][1], spectra[1][2]) if len(spectra) > 1 else None))
+            sets.append(KernelSet(item_index=index,
+                                  sample_rate=rate,
+                                  channels=len(channels),
+                                  stages=stages))
+    return sets
 
 
 @dataclass(frozen=True)
@@ -162,6 +500,9 @@ class IrItem:
     samples_l: List[float]
     samples_r: Optional[List[float]]
     preview: List[float]
+    envelope_db: List[float]
+    edc_db: List[float]
+    rt60: float
 
 
 def main() -> int:
@@ -170,6 +511,18 @@ def main() -> int:
     ap.add_argument("--out_h", required=True)
     ap.add_argument("--out_cpp", required=True)
     ap.add_argument("--preview", type=int, default=512)
+    ap.add_argument("--envelope", type=int, default=128,
+                    help="points in the per-IR envelope and energy decay curves")
+    ap.add_argument("--kernel_rates", default="",
+                    help="comma-separated sample rates to precompute kernels for (none if empty)")
+    ap.add_argument("--kernel_blocks", default="256,1024,4096",
+                    help="partition layout block sizes (dsp::PartitionLayout::FromBlockSizes)")
+    ap.add_argument("--kernel_skip", type=int, default=0,
+                    help="leading IR samples left out of the kernels (convolved by the IR head)")
+    ap.add_argument("--kernel_align", type=int, default=16,
+                    help="bins per row are padded to a multiple of this (dsp::AlignedStride)")
+    ap.add_argument("--storage", choices=("float", "int16"), default="float",
+                    help="how IR samples are embedded; int16 is decoded on first use")
     args = ap.parse_args()
 
     in_dir = Path(args.input_dir)
@@ -200,13 +553,23 @@ def main() -> int:
         else:
             preview_src = [(l + r) * 0.5 for (l, r) in zip(samples_l, samples_r)]
         preview = _build_preview(preview_src, int(args.preview))
+        decay_src = [samples_l] if samples_r is None else [samples_l, samples_r]
+        envelope_db, edc_db, rt60 = _build_decay_data(decay_src, sr, max(1, int(args.envelope)))
         items.append(IrItem(ir_id=ir_id,
                             display=display,
                             sample_rate=sr,
                             channels=ch,
                             samples_l=samples_l,
                             samples_r=samples_r,
-                            preview=preview))
+                            preview=preview,
+                            envelope_db=envelope_db,
+                            edc_db=edc_db,
+                            rt60=rt60))
+
+    rates = [int(r) for r in args.kernel_rates.replace(";", ",").split(",") if r.strip()]
+    blocks = [int(b) for b in args.kernel_blocks.split(",") if b.strip()]
+    kernel_sets = _build_kernel_sets(items, rates, blocks, args.kernel_skip,
+                                     args.kernel_align, args.storage) if rates else []
 
     out_h = Path(args.out_h)
     out_cpp = Path(args.out_cpp)
@@ -217,9 +580,12 @@ def main() -> int:
     h.append("#pragma once\n")
     h.append("\n")
     h.append("#include <cstddef>\n")
+    h.append("#include <cstdint>\n")
     h.append("\n")
     h.append("namespace dsp::room_ir {\n")
     h.append("\n")
+    h.append("// Samples are either floats (samplesL/R) or, with --storage int16,\n")
+    h.append("// packedL/R * packedScale; the other pair is null.\n")
     h.append("struct Item {\n")
     h.append("    const char* id;\n")
     h.append("    const char* displayName;\n")
@@ -227,13 +593,48 @@ def main() -> int:
     h.append("    int channels;\n")
     h.append("    const float* samplesL;\n")
     h.append("    const float* samplesR;\n")
+    h.append("    const std::int16_t* packedL;\n")
+    h.append("    const std::int16_t* packedR;\n")
+    h.append("    float packedScale;\n")
     h.append("    std::size_t frameCount;\n")
     h.append("    const float* preview;\n")
     h.append("    std::size_t previewCount;\n")
+    h.append("    // Per-slice peak envelope and energy decay curve, dB re. peak/total.\n")
+    h.append("    const float* envelopeDb;\n")
+    h.append("    const float* edcDb;\n")
+    h.append("    std::size_t envelopeCount;\n")
+    h.append("    float rt60Seconds;\n")
     h.append("};\n")
     h.append("\n")
+    h.append("// Compile-time size of items(), e.g. for constexpr parameter ranges.\n")
+    h.append(f"inline constexpr std::size_t kItemCount = {len(items)};\n")
+    h.append("\n")
     h.append("const Item* items(std::size_t* outCount);\n")
     h.append("\n")
+    h.append("// One partition-layout stage of a precomputed kernel: partitionCount rows\n")
+    h.append("// of binStride split re/im bins, 64-byte aligned.\n")
+    h.append("struct KernelStage {\n")
+    h.append("    std::size_t blockSize;\n")
+    h.append("    std::size_t offset;\n")
+    h.append("    std::size_t partitionCount;\n")
+    h.append("    std::size_t binStride;\n")
+    h.append("    const float* leftRe;\n")
+    h.append("    const float* leftIm;\n")
+    h.append("    const float* rightRe;\n")
+    h.append("    const float* rightIm;\n")
+    h.append("};\n")
+    h.append("\n")
+    h.append("struct KernelSet {\n")
+    h.append("    std::size_t itemIndex;\n")
+    h.append("    int sampleRate;\n")
+    h.append("    std::size_t skipFrames;\n")
+    h.append("    int channels;\n")
+    h.append("    const KernelStage* stages;\n")
+    h.append("    std::size_t stageCount;\n")
+    h.append("};\n")
+    h.append("\n")
+    h.append("const KernelSet* kernelSets(std::size_t* outCount);\n")
+    h.append("\n")
     h.append("}  // namespace dsp::room_ir\n")
 
     cpp = []
@@ -242,15 +643,25 @@ def main() -> int:
     cpp.append("namespace dsp::room_ir {\n")
     cpp.append("\n")
 
+    packed = args.storage == "int16"
+    kind = "packed" if packed else "samples"
     for idx, it in enumerate(items):
         base = re.sub(r"[^A-Za-z0-9_]", "_", it.ir_id)
-        cpp.append(_format_float_array(f"kIr_{base}_samplesL", it.samples_l))
-        cpp.append("\n")
+        channels = [("L", it.samples_l)]
         if it.channels == 2 and it.samples_r is not None:
-            cpp.append(_format_float_array(f"kIr_{base}_samplesR", it.samples_r))
+            channels.append(("R", it.samples_r))
+        for side, values in channels:
+            if packed:
+                cpp.append(_format_int16_array(f"kIr_{base}_packed{side}",
+                                               _quantize_int16(values, _int16_scale(it))))
+            else:
+                cpp.append(_format_float_array(f"kIr_{base}_samples{side}", values))
             cpp.append("\n")
         cpp.append(_format_float_array(f"kIr_{base}_preview", it.preview))
         cpp.append("\n")
+        cpp.append(_format_float_array(f"kIr_{base}_envelopeDb", it.envelope_db))
+        cpp.append(_format_float_array(f"kIr_{base}_edcDb", it.edc_db))
+        cpp.append("\n")
 
     cpp.append("static const Item kItems[] = {\n")
     for it in items:
@@ -260,17 +671,60 @@ def main() -> int:
         cpp.append(f'        "{it.display}",\n')
         cpp.append(f"        {it.sample_rate},\n")
         cpp.append(f"        {it.channels},\n")
-        cpp.append(f"        kIr_{base}_samplesL,\n")
-        if it.channels == 2 and it.samples_r is not None:
-            cpp.append(f"        kIr_{base}_samplesR,\n")
+        stereo = it.channels == 2 and it.samples_r is not None
+        left = f"kIr_{base}_{kind}L"
+        right = f"kIr_{base}_{kind}R" if stereo else "nullptr"
+        if packed:
+            cpp.append("        nullptr,\n")
+            cpp.append("        nullptr,\n")
+            cpp.append(f"        {left},\n")
+            cpp.append(f"        {right},\n")
+            cpp.append(f"        {_scale_literal(_int16_scale(it))},\n")
+            cpp.append(f"        sizeof({left}) / sizeof(std::int16_t),\n")
         else:
+            cpp.append(f"        {left},\n")
+            cpp.append(f"        {right},\n")
+            cpp.append("        nullptr,\n")
             cpp.append("        nullptr,\n")
-        cpp.append(f"        sizeof(kIr_{base}_samplesL) / sizeof(float),\n")
+            cpp.append("        0.0f,\n")
+            cpp.append(f"        sizeof({left}) / sizeof(float),\n")
         cpp.append(f"        kIr_{base}_preview,\n")
         cpp.append(f"        sizeof(kIr_{base}_preview) / sizeof(float),\n")
+        cpp.append(f"        kIr_{base}_envelopeDb,\n")
+        cpp.append(f"        kIr_{base}_edcDb,\n")
+        cpp.append(f"        sizeof(kIr_{base}_envelopeDb) / sizeof(float),\n")
+        cpp.append(f"        {_float_literal(it.rt60)},\n")
         cpp.append("    },\n")
     cpp.append("};\n")
     cpp.append("\n")
+    for ks in kernel_sets:
+        base = re.sub(r"[^A-Za-z0-9_]", "_", items[ks.item_index].ir_id) + f"_{ks.sample_rate}"
+        for s, st in enumerate(ks.stages):
+            cpp.append(_format_float_array(f"kK_{base}_s{s}_Lre", st.left[0], aligned=True))
+            cpp.append(_format_float_array(f"kK_{base}_s{s}_Lim", st.left[1], aligned=True))
+            if st.right is not None:
+                cpp.append(_format_float_array(f"kK_{base}_s{s}_Rre", st.right[0], aligned=True))
+                cpp.append(_format_float_array(f"kK_{base}_s{s}_Rim", st.right[1], aligned=True))
+            cpp.append("\n")
+        cpp.append(f"static const KernelStage kK_{base}_stages[] = {{\n")
+        for s, st in enumerate(ks.stages):
+            stride = len(st.left[0]) // st.parts
+            right = (f"kK_{base}_s{s}_Rre, kK_{base}_s{s}_Rim" if st.right is not None
+                     else "nullptr, nullptr")
+            cpp.append(f"    {{{st.block}, {st.offset}, {st.parts}, {stride}, "
+                       f"kK_{base}_s{s}_Lre, kK_{base}_s{s}_Lim, {right}}},\n")
+        cpp.append("};\n")
+        cpp.append("\n")
+
+    if kernel_sets:
+        cpp.append("static const KernelSet kKernelSets[] = {\n")
+        for ks in kernel_sets:
+            base = re.sub(r"[^A-Za-z0-9_]", "_", items[ks.item_index].ir_id) + f"_{ks.sample_rate}"
+            cpp.append(f"    {{{ks.item_index}, {ks.sample_rate}, {args.kernel_skip}, {ks.channels}, "
+                       f"kK_{base}_stages, sizeof(kK_{base}_stages) / sizeof(KernelStage)}},\n")
+        cpp.append("};\n")
+        cpp.append("\n")
+
     cpp.append("const Item* items(std::size_t* outCount) {\n")
     cpp.append("    if (outCount) {\n")
     cpp.append("        *outCount = sizeof(kItems) / sizeof(Item);\n")
@@ -278,6 +732,19 @@ def main() -> int:
     cpp.append("    return kItems;\n")
     cpp.append("}\n")
     cpp.append("\n")
+    cpp.append("const KernelSet* kernelSets(std::size_t* outCount) {\n")
+    if kernel_sets:
+        cpp.append("    if (outCount) {\n")
+        cpp.append("        *outCount = sizeof(kKernelSets) / sizeof(KernelSet);\n")
+        cpp.append("    }\n")
+        cpp.append("    return kKernelSets;\n")
+    else:
+        cpp.append("    if (outCount) {\n")
+        cpp.append("        *outCount = 0;\n")
+        cpp.append("    }\n")
+        cpp.append("    return nullptr;\n")
+    cpp.append("}\n")
+    cpp.append("\n")
     cpp.append("}  // namespace dsp::room_ir\n")
 
     out_h.write_text("".join(h), encoding="utf-8", newline="\n")
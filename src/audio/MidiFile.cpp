@@ -0,0 +1,210 @@
+#include "audio/MidiFile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace audio {
+
+namespace {
+std::uint32_t ReadU32Be(const std::uint8_t* p) {
+    return (std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) |
+           (std::uint32_t{p[2]} << 8) | std::uint32_t{p[3]};
+}
+
+std::uint16_t ReadU16Be(const std::uint8_t* p) {
+    return static_cast<std::uint16_t>((p[0] << 8) | p[1]);
+}
+
+bool HasTag(const std::vector<std::uint8_t>& bytes, std::size_t pos, const char (&tag)[5]) {
+    return pos + 4 <= bytes.size() && std::equal(tag, tag + 4, bytes.begin() + pos);
+}
+
+constexpr double kDefaultQuarterSeconds = 0.5;  // 120 bpm until the first tempo event
+}  // namespace
+
+bool MidiFileReader::open(const std::filesystem::path& path, std::string& errorMessage) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        errorMessage = "无法打开 MIDI 文件: " + path.string();
+        tracks_.clear();
+        return false;
+    }
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                                    std::istreambuf_iterator<char>());
+    if (!openBytes(std::move(bytes), errorMessage)) {
+        errorMessage += ": " + path.string();
+        return false;
+    }
+    return true;
+}
+
+bool MidiFileReader::openBytes(std::vector<std::uint8_t> bytes, std::string& errorMessage) {
+    errorMessage.clear();
+    tracks_.clear();
+    bytes_ = std::move(bytes);
+    if (!HasTag(bytes_, 0, "MThd") || bytes_.size() < 14 || ReadU32Be(&bytes_[4]) < 6) {
+        errorMessage = "不是标准 MIDI 文件";
+        return false;
+    }
+    format_ = ReadU16Be(&bytes_[8]);
+    division_ = ReadU16Be(&bytes_[12]);
+    if (format_ > 2 || division_ == 0) {
+        errorMessage = "不支持的 MIDI 文件格式";
+        return false;
+    }
+    // Chunks that are not tracks are skipped; a truncated last track is read
+    // as far as it goes.
+    std::size_t pos = 8 + ReadU32Be(&bytes_[4]);
+    while (pos + 8 <= bytes_.size()) {
+        const std::size_t length = ReadU32Be(&bytes_[pos + 4]);
+        const std::size_t begin = pos + 8;
+        const std::size_t end = std::min(bytes_.size(), begin + length);
+        if (HasTag(bytes_, pos, "MTrk")) {
+            Track track;
+            track.begin = begin;
+            track.end = end;
+            tracks_.push_back(track);
+        }
+        pos = end;
+    }
+    if (tracks_.empty()) {
+        errorMessage = "MIDI 文件没有音轨";
+        return false;
+    }
+    rewind();
+    return true;
+}
+
+void MidiFileReader::rewind() {
+    if (division_ & 0x8000u) {
+        // SMPTE timing: frames per second (negated) and ticks per frame; -29
+        // stands for 29.97 drop-frame.
+        const int fps = -static_cast<std::int8_t>(division_ >> 8);
+        const double rate = fps == 29 ? 29.97 : static_cast<double>(fps);
+        secondsPerTick_ = 1.0 / (std::max(1.0, rate) * std::max(1, division_ & 0xFF));
+    } else {
+        secondsPerTick_ = kDefaultQuarterSeconds / division_;
+    }
+    tempoTick_ = 0;
+    tempoSeconds_ = 0.0;
+    for (Track& track : tracks_) {
+        track.pos = track.begin;
+        track.tick = 0;
+        track.runningStatus = 0;
+        track.done = false;
+        advanceDelta(track);
+    }
+}
+
+bool MidiFileReader::next(MidiFileEvent& event) {
+    for (;;) {
+        // Earliest pending event; ties go to the lower track, so a format 1
+        // conductor track's tempo lands before notes at the same tick.
+        Track* track = nullptr;
+        for (Track& candidate : tracks_) {
+            if (!candidate.done && (!track || candidate.tick < track->tick)) {
+                track = &candidate;
+            }
+        }
+        if (!track) {
+            return false;
+        }
+
+        std::uint8_t status = bytes_[track->pos];
+        if (status & 0x80u) {
+            ++track->pos;
+        } else {
+            status = track->runningStatus;  // data byte: running status
+        }
+        if (status < 0x80u) {
+            track->done = true;
+            continue;
+        }
+        const std::uint64_t tick = track->tick;
+
+        if (status == 0xFFu || status == 0xF0u || status == 0xF7u) {
+            // Meta and SysEx events cancel running status.
+            track->runningStatus = 0;
+            std::uint8_t metaType = 0;
+            if (status == 0xFFu) {
+                if (track->pos >= track->end) {
+                    track->done = true;
+                    continue;
+                }
+                metaType = bytes_[track->pos++];
+            }
+            std::uint32_t length = 0;
+            if (!readVarLen(*track, length) || track->end - track->pos < length) {
+                track->done = true;
+                continue;
+            }
+            const std::uint8_t* data = bytes_.data() + track->pos;
+            track->pos += length;
+            if (status == 0xFFu && metaType == 0x2Fu) {
+                track->done = true;  // end of track
+                continue;
+            }
+            if (status == 0xFFu && metaType == 0x51u && length >= 3 && !(division_ & 0x8000u)) {
+                const std::uint32_t quarterUs = (std::uint32_t{data[0]} << 16) |
+                                                (std::uint32_t{data[1]} << 8) | data[2];
+                tempoSeconds_ = secondsAt(tick);
+                tempoTick_ = tick;
+                secondsPerTick_ = static_cast<double>(quarterUs) * 1e-6 / division_;
+            }
+            advanceDelta(*track);
+            continue;
+        }
+        if (status >= 0xF0u) {
+            // System common/realtime bytes have no business in a file.
+            track->done = true;
+            continue;
+        }
+
+        track->runningStatus = status;
+        const std::uint8_t type = status & 0xF0u;
+        const std::size_t dataBytes = (type == 0xC0u || type == 0xD0u) ? 1 : 2;
+        if (track->end - track->pos < dataBytes) {
+            track->done = true;
+            continue;
+        }
+        event.seconds = secondsAt(tick);
+        event.status = status;
+        event.data1 = static_cast<std::uint8_t>(bytes_[track->pos] & 0x7Fu);
+        event.data2 = dataBytes == 2 ? static_cast<std::uint8_t>(bytes_[track->pos + 1] & 0x7Fu) : 0;
+        track->pos += dataBytes;
+        advanceDelta(*track);
+        return true;
+    }
+}
+
+void MidiFileReader::advanceDelta(Track& track) {
+    std::uint32_t delta = 0;
+    if (track.done || track.pos >= track.end || !readVarLen(track, delta) ||
+        track.pos >= track.end) {
+        track.done = true;
+        return;
+    }
+    track.tick += delta;
+}
+
+bool MidiFileReader::readVarLen(Track& track, std::uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (track.pos >= track.end) {
+            return false;
+        }
+        const std::uint8_t byte = bytes_[track.pos++];
+        value = (value << 7) | (byte & 0x7Fu);
+        if (!(byte & 0x80u)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double MidiFileReader::secondsAt(std::uint64_t tick) const {
+    return tempoSeconds_ + static_cast<double>(tick - tempoTick_) * secondsPerTick_;
+}
+
+}  // namespace audio
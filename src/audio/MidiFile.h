@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace audio {
+
+// One channel message from a Standard MIDI File, timed in seconds from the
+// start of the file after the tempo map is applied.
+struct MidiFileEvent {
+    double seconds = 0.0;
+    std::uint8_t status = 0;  // 0x80..0xEF: message type in the high nibble, channel in the low
+    std::uint8_t data1 = 0;
+    std::uint8_t data2 = 0;
+
+    std::uint8_t type() const { return static_cast<std::uint8_t>(status & 0xF0u); }
+    std::uint8_t channel() const { return static_cast<std::uint8_t>(status & 0x0Fu); }
+};
+
+// Reads format 0 and 1 SMF files. The file's bytes are loaded once; events
+// are decoded on demand, merged across tracks in time order, so a long file
+// never turns into one big event list. Tempo changes are applied as they go
+// by; SysEx and other meta events are skipped.
+class MidiFileReader {
+public:
+    bool open(const std::filesystem::path& path, std::string& errorMessage);
+    // Same, from file bytes already in memory.
+    bool openBytes(std::vector<std::uint8_t> bytes, std::string& errorMessage);
+
+    // The next channel message, or false at the end of every track.
+    bool next(MidiFileEvent& event);
+    // Back to the first event.
+    void rewind();
+
+    bool isOpen() const { return !tracks_.empty(); }
+    std::uint16_t format() const { return format_; }
+    std::size_t trackCount() const { return tracks_.size(); }
+
+private:
+    struct Track {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        std::size_t pos = 0;
+        std::uint64_t tick = 0;  // of the event at pos
+        std::uint8_t runningStatus = 0;
+        bool done = false;
+    };
+
+    // Reads the delta time in front of the track's next event.
+    void advanceDelta(Track& track);
+    bool readVarLen(Track& track, std::uint32_t& value);
+    // Seconds at `tick` under the tempo map seen so far.
+    double secondsAt(std::uint64_t tick) const;
+
+    std::vector<std::uint8_t> bytes_;
+    std::vector<Track> tracks_;
+    std::uint16_t format_ = 0;
+    std::uint16_t division_ = 0;
+    double secondsPerTick_ = 0.0;     // current tempo, or fixed for SMPTE timing
+    std::uint64_t tempoTick_ = 0;     // where the current tempo took over
+    double tempoSeconds_ = 0.0;
+};
+
+}  // namespace audio
@@ -0,0 +1,266 @@
+#include "audio/OscPacket.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace audio {
+
+namespace {
+constexpr std::uint64_t kNtpToUnixSeconds = 2'208'988'800ull;  // 1900-01-01 to 1970-01-01
+constexpr int kMaxBundleDepth = 8;
+
+std::uint32_t ReadU32Be(const std::uint8_t* p) {
+    return (std::uint32_t{p[0]} << 24) | (std::uint32_t{p[1]} << 16) |
+           (std::uint32_t{p[2]} << 8) | std::uint32_t{p[3]};
+}
+
+std::uint64_t ReadU64Be(const std::uint8_t* p) {
+    return (std::uint64_t{ReadU32Be(p)} << 32) | ReadU32Be(p + 4);
+}
+
+void WriteU32Be(std::vector<std::uint8_t>& out, std::uint32_t value) {
+    out.push_back(static_cast<std::uint8_t>(value >> 24));
+    out.push_back(static_cast<std::uint8_t>(value >> 16));
+    out.push_back(static_cast<std::uint8_t>(value >> 8));
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+void WritePaddedString(std::vector<std::uint8_t>& out, const std::string& text) {
+    out.insert(out.end(), text.begin(), text.end());
+    // At least one terminating zero, then up to the next multiple of four.
+    do {
+        out.push_back(0);
+    } while (out.size() % 4 != 0);
+}
+
+// Reads a zero-terminated, four-byte padded string at `pos`.
+bool ReadPaddedString(const std::uint8_t* data, std::size_t size, std::size_t& pos,
+                      std::string& text) {
+    const auto* begin = data + pos;
+    const auto* end = std::find(begin, data + size, std::uint8_t{0});
+    if (end == data + size) {
+        return false;
+    }
+    text.assign(reinterpret_cast<const char*>(begin), static_cast<std::size_t>(end - begin));
+    const std::size_t padded = (text.size() + 4) & ~std::size_t{3};
+    if (pos + padded > size) {
+        return false;
+    }
+    pos += padded;
+    return true;
+}
+
+bool ParseMessage(const std::uint8_t* data, std::size_t size, std::uint64_t timeTag,
+                  std::vector<OscMessage>& messages, std::string& errorMessage) {
+    OscMessage message;
+    message.timeTag = timeTag;
+    std::size_t pos = 0;
+    if (!ReadPaddedString(data, size, pos, message.address) || message.address.empty() ||
+        message.address.front() != '/') {
+        errorMessage = "OSC 地址无效";
+        return false;
+    }
+    std::string tags;
+    if (pos < size && !ReadPaddedString(data, size, pos, tags)) {
+        errorMessage = "OSC 类型标签无效: " + message.address;
+        return false;
+    }
+    // Very old senders omit the type tags; such a message has no arguments
+    // we could read.
+    if (!tags.empty() && tags.front() != ',') {
+        errorMessage = "OSC 类型标签无效: " + message.address;
+        return false;
+    }
+    for (std::size_t t = 1; t < tags.size(); ++t) {
+        OscArgument arg;
+        arg.type = tags[t];
+        switch (arg.type) {
+        case 'i':
+        case 'f':
+        case 'b':
+            if (pos + 4 > size) {
+                errorMessage = "OSC 参数不完整: " + message.address;
+                return false;
+            }
+            break;
+        case 'h':
+        case 'd':
+        case 't':
+            if (pos + 8 > size) {
+                errorMessage = "OSC 参数不完整: " + message.address;
+                return false;
+            }
+            break;
+        default:
+            break;
+        }
+        switch (arg.type) {
+        case 'i':
+            arg.intValue = static_cast<std::int32_t>(ReadU32Be(data + pos));
+            pos += 4;
+            break;
+        case 'f':
+            arg.floatValue = std::bit_cast<float>(ReadU32Be(data + pos));
+            pos += 4;
+            break;
+        case 'h':
+            arg.intValue = static_cast<std::int64_t>(ReadU64Be(data + pos));
+            pos += 8;
+            break;
+        case 'd':
+            arg.floatValue = std::bit_cast<double>(ReadU64Be(data + pos));
+            pos += 8;
+            break;
+        case 't':
+            pos += 8;  // a time tag as an argument carries nothing we play
+            continue;
+        case 's':
+        case 'S':
+            if (!ReadPaddedString(data, size, pos, arg.text)) {
+                errorMessage = "OSC 参数不完整: " + message.address;
+                return false;
+            }
+            break;
+        case 'b': {
+            const std::size_t length = ReadU32Be(data + pos);
+            const std::size_t padded = (length + 3) & ~std::size_t{3};
+            if (padded > size - pos - 4) {
+                errorMessage = "OSC 参数不完整: " + message.address;
+                return false;
+            }
+            pos += 4 + padded;
+            continue;
+        }
+        case 'T':
+            arg.intValue = 1;
+            break;
+        case 'F':
+        case 'N':
+        case 'I':
+            break;
+        default:
+            // The size of an unknown type is unknown, so nothing after it
+            // can be read.
+            errorMessage = "不支持的 OSC 参数类型: " + message.address;
+            return false;
+        }
+        message.arguments.push_back(std::move(arg));
+    }
+    messages.push_back(std::move(message));
+    return true;
+}
+
+bool ParseElement(const std::uint8_t* data, std::size_t size, std::uint64_t timeTag, int depth,
+                  std::vector<OscMessage>& messages, std::string& errorMessage) {
+    static constexpr char kBundleTag[8] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', '\0'};
+    if (size == 0 || size % 4 != 0) {
+        errorMessage = "OSC 数据包长度无效";
+        return false;
+    }
+    if (size < 16 || std::memcmp(data, kBundleTag, sizeof(kBundleTag)) != 0) {
+        return ParseMessage(data, size, timeTag, messages, errorMessage);
+    }
+    if (depth >= kMaxBundleDepth) {
+        errorMessage = "OSC 包嵌套过深";
+        return false;
+    }
+    const std::uint64_t bundleTag = ReadU64Be(data + 8);
+    std::size_t pos = 16;
+    while (pos + 4 <= size) {
+        const std::size_t length = ReadU32Be(data + pos);
+        pos += 4;
+        if (length > size - pos) {
+            errorMessage = "OSC 包元素长度无效";
+            return false;
+        }
+        if (!ParseElement(data + pos, length, bundleTag, depth + 1, messages, errorMessage)) {
+            return false;
+        }
+        pos += length;
+    }
+    return true;
+}
+}  // namespace
+
+bool OscArgument::isNumber() const {
+    switch (type) {
+    case 'i':
+    case 'h':
+    case 'f':
+    case 'd':
+    case 'T':
+    case 'F':
+        return true;
+    default:
+        return false;
+    }
+}
+
+float OscArgument::asFloat() const {
+    if (type == 'f' || type == 'd') {
+        return static_cast<float>(floatValue);
+    }
+    return isNumber() ? static_cast<float>(intValue) : 0.0f;
+}
+
+int OscArgument::asInt() const {
+    if (type == 'f' || type == 'd') {
+        return static_cast<int>(std::lround(floatValue));
+    }
+    return isNumber() ? static_cast<int>(intValue) : 0;
+}
+
+bool ParseOscPacket(const std::uint8_t* data, std::size_t size, std::vector<OscMessage>& messages,
+                    std::string& errorMessage) {
+    errorMessage.clear();
+    return ParseElement(data, size, kOscImmediately, 0, messages, errorMessage);
+}
+
+std::vector<std::uint8_t> EncodeOscMessage(const OscMessage& message) {
+    std::vector<std::uint8_t> out;
+    WritePaddedString(out, message.address);
+    std::string tags = ",";
+    for (const auto& arg : message.arguments) {
+        switch (arg.type) {
+        case 'i':
+        case 's':
+        case 'T':
+        case 'F':
+            tags += arg.type;
+            break;
+        default:
+            tags += 'f';
+            break;
+        }
+    }
+    WritePaddedString(out, tags);
+    for (std::size_t i = 0; i < message.arguments.size(); ++i) {
+        const auto& arg = message.arguments[i];
+        switch (tags[i + 1]) {
+        case 'i':
+            WriteU32Be(out, static_cast<std::uint32_t>(static_cast<std::int32_t>(arg.intValue)));
+            break;
+        case 's':
+            WritePaddedString(out, arg.text);
+            break;
+        case 'f':
+            WriteU32Be(out, std::bit_cast<std::uint32_t>(static_cast<float>(arg.floatValue)));
+            break;
+        default:
+            break;
+        }
+    }
+    return out;
+}
+
+std::int64_t OscTimeTagToUnixNanos(std::uint64_t timeTag) {
+    const auto seconds = static_cast<std::int64_t>(timeTag >> 32) -
+                         static_cast<std::int64_t>(kNtpToUnixSeconds);
+    const std::uint64_t fraction = timeTag & 0xFFFFFFFFull;
+    return seconds * 1'000'000'000ll +
+           static_cast<std::int64_t>((fraction * 1'000'000'000ull) >> 32);
+}
+
+}  // namespace audio
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace audio {
+
+// OSC 1.0 time tag: NTP seconds since 1900 in the high word, fraction in the
+// low word. The value 1 means "immediately".
+constexpr std::uint64_t kOscImmediately = 1;
+
+// One argument of an OSC message. Integers and booleans ('i', 'h', 'T', 'F')
+// fill `intValue`, floats ('f', 'd') `floatValue`, strings and symbols ('s',
+// 'S') `text`. Blobs are skipped when parsing.
+struct OscArgument {
+    char type = 'i';
+    std::int64_t intValue = 0;
+    double floatValue = 0.0;
+    std::string text;
+
+    bool isNumber() const;
+    // Any numeric or boolean argument as a float; 0 for strings.
+    float asFloat() const;
+    int asInt() const;
+};
+
+// A message with the time tag of the bundle it came in (kOscImmediately
+// when it was sent on its own).
+struct OscMessage {
+    std::string address;
+    std::vector<OscArgument> arguments;
+    std::uint64_t timeTag = kOscImmediately;
+};
+
+// Decodes one UDP datagram: a message, or a bundle of messages and bundles,
+// flattened in order. Nested bundles keep their own time tag. On a malformed
+// packet the messages decoded before the fault are kept and false is
+// returned.
+bool ParseOscPacket(const std::uint8_t* data, std::size_t size, std::vector<OscMessage>& messages,
+                    std::string& errorMessage);
+
+// Encodes a message (types 'i', 'f', 's', 'T', 'F'; anything else is sent
+// as 'f'). For clients and tests.
+std::vector<std::uint8_t> EncodeOscMessage(const OscMessage& message);
+
+// Converts an OSC time tag to nanoseconds since the Unix epoch.
+std::int64_t OscTimeTagToUnixNanos(std::uint64_t timeTag);
+
+}  // namespace audio
@@ -0,0 +1,349 @@
+#include "audio/SampleConvert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SATORI_CONVERT_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SATORI_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace audio {
+
+namespace {
+
+float Clamp(float v) {
+    return std::max(-1.0f, std::min(1.0f, v));
+}
+
+// Matches llround on the clamped, scaled value.
+std::int32_t Quantize(float v, double scale) {
+    return static_cast<std::int32_t>(std::llround(static_cast<double>(Clamp(v)) * scale));
+}
+
+template <std::size_t Bytes>
+void StoreBytes(std::uint8_t* dst, std::uint64_t bits, bool bigEndian) {
+    for (std::size_t i = 0; i < Bytes; ++i) {
+        const std::size_t shift = 8 * (bigEndian ? Bytes - 1 - i : i);
+        dst[i] = static_cast<std::uint8_t>((bits >> shift) & 0xFFu);
+    }
+}
+
+template <std::size_t Bytes>
+std::uint64_t LoadBytes(const std::uint8_t* src, bool bigEndian) {
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < Bytes; ++i) {
+        const std::size_t shift = 8 * (bigEndian ? Bytes - 1 - i : i);
+        bits |= static_cast<std::uint64_t>(src[i]) << shift;
+    }
+    return bits;
+}
+
+template <bool BigEndian>
+void ToInt16(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::uint8_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s = static_cast<std::uint16_t>(Quantize(src[i], 32767.0));
+        StoreBytes<2>(out + 2 * i, s, BigEndian);
+    }
+}
+
+template <bool BigEndian>
+void ToInt24(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::uint8_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s = static_cast<std::uint32_t>(Quantize(src[i], 8388607.0));
+        StoreBytes<3>(out + 3 * i, s, BigEndian);
+    }
+}
+
+template <bool BigEndian>
+void ToInt32(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::uint8_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s = static_cast<std::uint32_t>(Quantize(src[i], 2147483647.0));
+        StoreBytes<4>(out + 4 * i, s, BigEndian);
+    }
+}
+
+template <bool BigEndian>
+void ToInt32Left24(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::uint8_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s = static_cast<std::uint32_t>(Quantize(src[i], 8388607.0)) << 8;
+        StoreBytes<4>(out + 4 * i, s, BigEndian);
+    }
+}
+
+template <bool BigEndian>
+void ToFloat32(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::uint8_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const float v = Clamp(src[i]);
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &v, sizeof(bits));
+        StoreBytes<4>(out + 4 * i, bits, BigEndian);
+    }
+}
+
+template <bool BigEndian>
+void ToFloat64(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::uint8_t*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const double v = static_cast<double>(Clamp(src[i]));
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &v, sizeof(bits));
+        StoreBytes<8>(out + 8 * i, bits, BigEndian);
+    }
+}
+
+// Device -> float: full scale is the format's negative limit, so every
+// value reads back inside [-1, 1).
+template <bool BigEndian>
+void FromInt16(const void* src, float* dst, std::size_t count) {
+    const auto* in = static_cast<const std::uint8_t*>(src);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s = static_cast<std::int16_t>(LoadBytes<2>(in + 2 * i, BigEndian));
+        dst[i] = static_cast<float>(s) * (1.0f / 32768.0f);
+    }
+}
+
+template <bool BigEndian>
+void FromInt24(const void* src, float* dst, std::size_t count) {
+    const auto* in = static_cast<const std::uint8_t*>(src);
+    for (std::size_t i = 0; i < count; ++i) {
+        // Into the top of 32 bits, so the arithmetic shift sign-extends.
+        const auto bits = static_cast<std::uint32_t>(LoadBytes<3>(in + 3 * i, BigEndian)) << 8;
+        const std::int32_t s = static_cast<std::int32_t>(bits) >> 8;
+        dst[i] = static_cast<float>(s) * (1.0f / 8388608.0f);
+    }
+}
+
+template <bool BigEndian>
+void FromInt32(const void* src, float* dst, std::size_t count) {
+    const auto* in = static_cast<const std::uint8_t*>(src);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto s = static_cast<std::int32_t>(LoadBytes<4>(in + 4 * i, BigEndian));
+        dst[i] = static_cast<float>(static_cast<double>(s) * (1.0 / 2147483648.0));
+    }
+}
+
+template <bool BigEndian>
+void FromInt32Left24(const void* src, float* dst, std::size_t count) {
+    const auto* in = static_cast<const std::uint8_t*>(src);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::int32_t s = static_cast<std::int32_t>(LoadBytes<4>(in + 4 * i, BigEndian)) >> 8;
+        dst[i] = static_cast<float>(s) * (1.0f / 8388608.0f);
+    }
+}
+
+template <bool BigEndian>
+void FromFloat32(const void* src, float* dst, std::size_t count) {
+    const auto* in = static_cast<const std::uint8_t*>(src);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto bits = static_cast<std::uint32_t>(LoadBytes<4>(in + 4 * i, BigEndian));
+        std::memcpy(dst + i, &bits, sizeof(bits));
+    }
+}
+
+template <bool BigEndian>
+void FromFloat64(const void* src, float* dst, std::size_t count) {
+    const auto* in = static_cast<const std::uint8_t*>(src);
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint64_t bits = LoadBytes<8>(in + 8 * i, BigEndian);
+        double v = 0.0;
+        std::memcpy(&v, &bits, sizeof(v));
+        dst[i] = static_cast<float>(v);
+    }
+}
+
+#if defined(SATORI_CONVERT_SSE2)
+// Little-endian fast paths for the layouts drivers actually use.
+void ToFloat32Sse2(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<float*>(dst);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_min_ps(hi, _mm_max_ps(lo, _mm_loadu_ps(src + i))));
+    }
+    ToFloat32<false>(src + i, out + i, count - i);
+}
+
+void ToInt16Sse2(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::int16_t*>(dst);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 a = _mm_mul_ps(_mm_min_ps(hi, _mm_max_ps(lo, _mm_loadu_ps(src + i))), scale);
+        const __m128 b =
+            _mm_mul_ps(_mm_min_ps(hi, _mm_max_ps(lo, _mm_loadu_ps(src + i + 4))), scale);
+        const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    ToInt16<false>(src + i, out + i, count - i);
+}
+
+void ToInt32Sse2(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::int32_t*>(dst);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(2147483648.0f);
+    // Largest float below 2^31, so +1.0 doesn't wrap.
+    const __m128 top = _mm_set1_ps(2147483520.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_min_ps(hi, _mm_max_ps(lo, _mm_loadu_ps(src + i)));
+        const __m128 scaled = _mm_min_ps(top, _mm_mul_ps(v, scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_cvtps_epi32(scaled));
+    }
+    ToInt32<false>(src + i, out + i, count - i);
+}
+#elif defined(SATORI_CONVERT_NEON)
+// Same fast paths; vcvtnq rounds to nearest even like _mm_cvtps_epi32.
+void ToFloat32Neon(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<float*>(dst);
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vminq_f32(hi, vmaxq_f32(lo, vld1q_f32(src + i))));
+    }
+    ToFloat32<false>(src + i, out + i, count - i);
+}
+
+void ToInt16Neon(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::int16_t*>(dst);
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    const float32x4_t scale = vdupq_n_f32(32767.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t a =
+            vmulq_f32(vminq_f32(hi, vmaxq_f32(lo, vld1q_f32(src + i))), scale);
+        const float32x4_t b =
+            vmulq_f32(vminq_f32(hi, vmaxq_f32(lo, vld1q_f32(src + i + 4))), scale);
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)),
+                                        vqmovn_s32(vcvtnq_s32_f32(b))));
+    }
+    ToInt16<false>(src + i, out + i, count - i);
+}
+
+void ToInt32Neon(const float* src, void* dst, std::size_t count) {
+    auto* out = static_cast<std::int32_t*>(dst);
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    const float32x4_t scale = vdupq_n_f32(2147483648.0f);
+    // Largest float below 2^31, so +1.0 doesn't wrap.
+    const float32x4_t top = vdupq_n_f32(2147483520.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t v = vminq_f32(hi, vmaxq_f32(lo, vld1q_f32(src + i)));
+        vst1q_s32(out + i, vcvtnq_s32_f32(vminq_f32(top, vmulq_f32(v, scale))));
+    }
+    ToInt32<false>(src + i, out + i, count - i);
+}
+#endif
+
+}  // namespace
+
+SampleConvertFn GetSampleConverter(SampleFormat format, bool bigEndian) {
+    switch (format) {
+        case SampleFormat::Int16:
+#if defined(SATORI_CONVERT_SSE2)
+            if (!bigEndian) {
+                return &ToInt16Sse2;
+            }
+#elif defined(SATORI_CONVERT_NEON)
+            if (!bigEndian) {
+                return &ToInt16Neon;
+            }
+#endif
+            return bigEndian ? &ToInt16<true> : &ToInt16<false>;
+        case SampleFormat::Int24:
+            return bigEndian ? &ToInt24<true> : &ToInt24<false>;
+        case SampleFormat::Int32:
+#if defined(SATORI_CONVERT_SSE2)
+            if (!bigEndian) {
+                return &ToInt32Sse2;
+            }
+#elif defined(SATORI_CONVERT_NEON)
+            if (!bigEndian) {
+                return &ToInt32Neon;
+            }
+#endif
+            return bigEndian ? &ToInt32<true> : &ToInt32<false>;
+        case SampleFormat::Int32Left24:
+            return bigEndian ? &ToInt32Left24<true> : &ToInt32Left24<false>;
+        case SampleFormat::Float32:
+#if defined(SATORI_CONVERT_SSE2)
+            if (!bigEndian) {
+                return &ToFloat32Sse2;
+            }
+#elif defined(SATORI_CONVERT_NEON)
+            if (!bigEndian) {
+                return &ToFloat32Neon;
+            }
+#endif
+            return bigEndian ? &ToFloat32<true> : &ToFloat32<false>;
+        case SampleFormat::Float64:
+            return bigEndian ? &ToFloat64<true> : &ToFloat64<false>;
+    }
+    return nullptr;
+}
+
+SampleReadFn GetSampleReader(SampleFormat format, bool bigEndian) {
+    switch (format) {
+        case SampleFormat::Int16:
+            return bigEndian ? &FromInt16<true> : &FromInt16<false>;
+        case SampleFormat::Int24:
+            return bigEndian ? &FromInt24<true> : &FromInt24<false>;
+        case SampleFormat::Int32:
+            return bigEndian ? &FromInt32<true> : &FromInt32<false>;
+        case SampleFormat::Int32Left24:
+            return bigEndian ? &FromInt32Left24<true> : &FromInt32Left24<false>;
+        case SampleFormat::Float32:
+            return bigEndian ? &FromFloat32<true> : &FromFloat32<false>;
+        case SampleFormat::Float64:
+            return bigEndian ? &FromFloat64<true> : &FromFloat64<false>;
+    }
+    return nullptr;
+}
+
+std::size_t SampleBytes(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int16:
+            return 2;
+        case SampleFormat::Int24:
+            return 3;
+        case SampleFormat::Float64:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+void Deinterleave(const float* interleaved, std::size_t channels, std::size_t channel,
+                  float* dst, std::size_t frames) {
+    const float* src = interleaved + channel;
+    for (std::size_t f = 0; f < frames; ++f) {
+        dst[f] = src[f * channels];
+    }
+}
+
+void Interleave(const float* src, std::size_t channels, std::size_t channel,
+                float* interleaved, std::size_t frames) {
+    float* dst = interleaved + channel;
+    for (std::size_t f = 0; f < frames; ++f) {
+        dst[f * channels] = src[f];
+    }
+}
+
+}  // namespace audio
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace audio {
+
+// Device sample layouts for float <-> native conversion (e.g. ASIO buffers).
+enum class SampleFormat {
+    Int16,
+    Int24,        // packed 3 bytes
+    Int32,
+    Int32Left24,  // 24-bit value in the upper 3 bytes of 32
+    Float32,
+    Float64,
+};
+
+// Converts one non-interleaved channel, clamping to [-1, 1].
+using SampleConvertFn = void (*)(const float* src, void* dst, std::size_t count);
+
+// Picks the fastest converter for the layout; resolve once, not per buffer.
+SampleConvertFn GetSampleConverter(SampleFormat format, bool bigEndian);
+std::size_t SampleBytes(SampleFormat format);
+
+// Reads one non-interleaved channel of captured samples back to float.
+using SampleReadFn = void (*)(const void* src, float* dst, std::size_t count);
+SampleReadFn GetSampleReader(SampleFormat format, bool bigEndian);
+
+// Copies channel `channel` of an interleaved buffer into `dst`.
+void Deinterleave(const float* interleaved, std::size_t channels, std::size_t channel,
+                  float* dst, std::size_t frames);
+// Copies `src` into channel `channel` of an interleaved buffer.
+void Interleave(const float* src, std::size_t channels, std::size_t channel,
+                float* interleaved, std::size_t frames);
+
+}  // namespace audio
@@ -0,0 +1,198 @@
+#include "audio/WaveReader.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace audio {
+
+namespace {
+
+// Read-only view of a whole file; empty if it could not be mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+        file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file_, &size) || size.QuadPart <= 0) {
+            return;
+        }
+        mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) {
+            return;
+        }
+        data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        size_ = data_ ? static_cast<std::size_t>(size.QuadPart) : 0;
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            return;
+        }
+        struct stat info {};
+        if (::fstat(fd_, &info) != 0 || info.st_size <= 0) {
+            return;
+        }
+        void* view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE,
+                            fd_, 0);
+        if (view == MAP_FAILED) {
+            return;
+        }
+        data_ = static_cast<const unsigned char*>(view);
+        size_ = static_cast<std::size_t>(info.st_size);
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_) {
+            CloseHandle(mapping_);
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+        }
+#else
+        if (data_) {
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+    const unsigned char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+uint16_t GetU16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t GetU32(const unsigned char* p) {
+    return static_cast<uint32_t>(GetU16(p)) | (static_cast<uint32_t>(GetU16(p + 2)) << 16);
+}
+
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+
+float DecodeSample(const unsigned char* p, bool isFloat, uint16_t bits) {
+    if (isFloat) {
+        if (bits == 64) {
+            double value;
+            std::memcpy(&value, p, sizeof(value));
+            return static_cast<float>(value);
+        }
+        float value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    switch (bits) {
+    case 16:
+        return static_cast<float>(static_cast<int16_t>(GetU16(p))) / 32768.0f;
+    case 24: {
+        const int32_t value = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                                                   (static_cast<uint32_t>(p[1]) << 16) |
+                                                   (static_cast<uint32_t>(p[2]) << 24)) >>
+                              8;
+        return static_cast<float>(value) / 8388608.0f;
+    }
+    default:
+        return static_cast<float>(static_cast<double>(static_cast<int32_t>(GetU32(p))) /
+                                  2147483648.0);
+    }
+}
+
+}  // namespace
+
+bool WaveReader::read(const std::filesystem::path& path,
+                      WaveData& data,
+                      std::string& errorMessage) const {
+    errorMessage.clear();
+    data = WaveData{};
+    const MappedFile file(path);
+    if (!file.data()) {
+        errorMessage = "无法打开 WAV 文件: " + path.string();
+        return false;
+    }
+    const unsigned char* bytes = file.data();
+    const std::size_t size = file.size();
+    if (size < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+        errorMessage = "不是 WAV 文件: " + path.string();
+        return false;
+    }
+
+    uint16_t format = 0;
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bits = 0;
+    const unsigned char* payload = nullptr;
+    std::size_t payloadBytes = 0;
+    for (std::size_t pos = 12; pos + 8 <= size;) {
+        const unsigned char* chunk = bytes + pos;
+        const std::size_t chunkSize = GetU32(chunk + 4);
+        const std::size_t available = std::min(chunkSize, size - pos - 8);
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && available >= 16) {
+            format = GetU16(chunk + 8);
+            channels = GetU16(chunk + 10);
+            sampleRate = GetU32(chunk + 12);
+            bits = GetU16(chunk + 22);
+            if (format == kFormatExtensible && available >= 40) {
+                format = GetU16(chunk + 32);  // first two bytes of the sub-format GUID
+            }
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            payload = chunk + 8;
+            payloadBytes = available;  // a truncated file keeps what it has
+        }
+        pos += 8 + chunkSize + (chunkSize & 1u);
+    }
+
+    const bool isFloat = format == kFormatFloat;
+    const bool supported = (format == kFormatPcm && (bits == 16 || bits == 24 || bits == 32)) ||
+                           (isFloat && (bits == 32 || bits == 64));
+    if (!supported || channels == 0 || sampleRate == 0 || !payload) {
+        errorMessage = "不支持的 WAV 格式: " + path.string();
+        return false;
+    }
+
+    const std::size_t sampleBytes = bits / 8;
+    const std::size_t frames = payloadBytes / (sampleBytes * channels);
+    data.sampleRate = sampleRate;
+    data.channels = channels;
+    data.samples.resize(frames * channels);
+    for (std::size_t i = 0; i < data.samples.size(); ++i) {
+        data.samples[i] = DecodeSample(payload + i * sampleBytes, isFloat, bits);
+    }
+    return true;
+}
+
+}  // namespace audio
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace audio {
+
+struct WaveData {
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    std::vector<float> samples;  // interleaved, in [-1, 1] for PCM
+};
+
+// Reads 16/24/32-bit PCM and 32/64-bit IEEE float WAV files, including
+// WAVE_FORMAT_EXTENSIBLE headers. The file is memory-mapped and decoded
+// straight from the mapping, so nothing beyond the samples is buffered.
+class WaveReader {
+public:
+    bool read(const std::filesystem::path& path, WaveData& data, std::string& errorMessage) const;
+};
+
+}  // namespace audio
@@ -1,77 +1,163 @@
 #include "audio/WaveWriter.h"
 
 #include <algorithm>
-#include <fstream>
 #include <limits>
 
 namespace audio {
 
 namespace {
-struct WaveHeader {
-    char chunkId[4] = {'R', 'I', 'F', 'F'};
-    uint32_t chunkSize = 0;
-    char format[4] = {'W', 'A', 'V', 'E'};
-
-    char subchunk1Id[4] = {'f', 'm', 't', ' '};
-    uint32_t subchunk1Size = 16;
-    uint16_t audioFormat = 1;  // PCM
-    uint16_t numChannels = 1;
-    uint32_t sampleRate = 44100;
-    uint32_t byteRate = 0;
-    uint16_t blockAlign = 0;
-    uint16_t bitsPerSample = 16;
-
-    char subchunk2Id[4] = {'d', 'a', 't', 'a'};
-    uint32_t subchunk2Size = 0;
-};
+void PutTag(std::vector<char>& out, const char (&tag)[5]) {
+    out.insert(out.end(), tag, tag + 4);
+}
+
+void PutU16(std::vector<char>& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFFu));
+    out.push_back(static_cast<char>((value >> 8) & 0xFFu));
+}
+
+void PutU32(std::vector<char>& out, uint32_t value) {
+    PutU16(out, static_cast<uint16_t>(value & 0xFFFFu));
+    PutU16(out, static_cast<uint16_t>(value >> 16));
+}
+
+bool IsFloat(SampleFormat format) {
+    return format == SampleFormat::Float32 || format == SampleFormat::Float64;
+}
+
+// Little-endian RIFF header. Float files carry the extended fmt chunk and the
+// fact chunk non-PCM data requires. Sizes past 4 GiB saturate.
+std::vector<char> MakeHeader(const WaveFormat& format, std::uint64_t samples) {
+    const bool isFloat = IsFloat(format.sampleFormat);
+    const auto bytesPerSample = static_cast<uint16_t>(SampleBytes(format.sampleFormat));
+    const uint16_t channels = std::max<uint16_t>(1, format.channels);
+    const uint16_t blockAlign = static_cast<uint16_t>(channels * bytesPerSample);
+    const auto saturate = [](std::uint64_t value) {
+        return static_cast<uint32_t>(
+            std::min<std::uint64_t>(value, std::numeric_limits<uint32_t>::max()));
+    };
+    const uint32_t fmtSize = isFloat ? 18 : 16;
+    const uint32_t factSize = isFloat ? 12 : 0;
+    const uint32_t dataSize = saturate(samples * bytesPerSample);
+
+    std::vector<char> header;
+    header.reserve(58);
+    PutTag(header, "RIFF");
+    const uint32_t pad = dataSize & 1u;  // RIFF chunks are word-aligned
+    PutU32(header, saturate(std::uint64_t{4} + 8 + fmtSize + factSize + 8 + dataSize + pad));
+    PutTag(header, "WAVE");
+    PutTag(header, "fmt ");
+    PutU32(header, fmtSize);
+    PutU16(header, isFloat ? 3 : 1);  // IEEE float : PCM
+    PutU16(header, channels);
+    PutU32(header, format.sampleRate);
+    PutU32(header, format.sampleRate * blockAlign);
+    PutU16(header, blockAlign);
+    PutU16(header, static_cast<uint16_t>(bytesPerSample * 8));
+    if (isFloat) {
+        PutU16(header, 0);  // cbSize
+        PutTag(header, "fact");
+        PutU32(header, 4);
+        PutU32(header, saturate(samples / channels));
+    }
+    PutTag(header, "data");
+    PutU32(header, dataSize);
+    return header;
+}
+
+constexpr std::size_t kEncodeChunk = 4096;  // samples per stream write
 }  // namespace
 
 bool WaveWriter::write(const std::filesystem::path& path,
                        const std::vector<float>& samples,
                        const WaveFormat& format,
                        std::string& errorMessage) const {
-    errorMessage.clear();
+    WaveStreamWriter stream;
+    return stream.open(path, format, errorMessage) &&
+           stream.write(samples.data(), samples.size(), errorMessage) &&
+           stream.close(errorMessage);
+}
 
-    auto pcm = quantize(samples);
-    WaveHeader header{};
-    header.numChannels = format.channels;
-    header.sampleRate = format.sampleRate;
-    header.bitsPerSample = format.bitsPerSample;
-    const uint16_t bytesPerSample = header.bitsPerSample / 8;
-    header.blockAlign = header.numChannels * bytesPerSample;
-    header.byteRate = header.sampleRate * header.blockAlign;
-    header.subchunk2Size = static_cast<uint32_t>(pcm.size() * bytesPerSample);
-    header.chunkSize = 36 + header.subchunk2Size;
-
-    std::ofstream stream(path, std::ios::binary);
-    if (!stream.is_open()) {
+WaveStreamWriter::~WaveStreamWriter() {
+    if (stream_.is_open()) {
+        std::string ignored;
+        close(ignored);
+    }
+}
+
+bool WaveStreamWriter::open(const std::filesystem::path& path,
+                            const WaveFormat& format,
+                            std::string& errorMessage) {
+    errorMessage.clear();
+    if (stream_.is_open()) {
+        stream_.close();
+    }
+    if (format.sampleFormat == SampleFormat::Int32Left24 || format.sampleRate == 0) {
+        errorMessage = "不支持的 WAV 格式";
+        return false;
+    }
+    path_ = path;
+    format_ = format;
+    // WAV data is little-endian on every platform.
+    convert_ = GetSampleConverter(format.sampleFormat, false);
+    sampleBytes_ = SampleBytes(format.sampleFormat);
+    samplesWritten_ = 0;
+    stream_.open(path, std::ios::binary | std::ios::trunc);
+    if (!stream_.is_open()) {
         errorMessage = "无法打开输出文件: " + path.string();
         return false;
     }
+    // Placeholder sizes; close() rewrites the header.
+    if (!writeHeader()) {
+        errorMessage = "写入 WAV 文件失败: " + path_.string();
+        stream_.close();
+        return false;
+    }
+    return true;
+}
 
-    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
-    stream.write(reinterpret_cast<const char*>(pcm.data()),
-                 static_cast<std::streamsize>(pcm.size() * sizeof(int16_t)));
-
-    if (!stream.good()) {
-        errorMessage = "写入 WAV 文件失败: " + path.string();
+bool WaveStreamWriter::write(const float* samples,
+                             std::size_t count,
+                             std::string& errorMessage) {
+    if (!stream_.is_open()) {
+        errorMessage = "输出文件未打开";
         return false;
     }
+    encoded_.resize(std::min(count, kEncodeChunk) * sampleBytes_);
+    for (std::size_t done = 0; done < count;) {
+        const std::size_t chunk = std::min(kEncodeChunk, count - done);
+        convert_(samples + done, encoded_.data(), chunk);
+        stream_.write(encoded_.data(), static_cast<std::streamsize>(chunk * sampleBytes_));
+        done += chunk;
+    }
+    samplesWritten_ += count;
+    if (!stream_.good()) {
+        errorMessage = "写入 WAV 文件失败: " + path_.string();
+        return false;
+    }
+    return true;
+}
 
+bool WaveStreamWriter::close(std::string& errorMessage) {
+    if (!stream_.is_open()) {
+        return true;
+    }
+    if ((samplesWritten_ * sampleBytes_) & 1u) {
+        stream_.put('\0');
+    }
+    stream_.seekp(0);
+    const bool ok = writeHeader();
+    stream_.close();
+    if (!ok) {
+        errorMessage = "写入 WAV 文件失败: " + path_.string();
+        return false;
+    }
     return true;
 }
 
-std::vector<int16_t> WaveWriter::quantize(
-    const std::vector<float>& samples) {
-    std::vector<int16_t> pcm(samples.size());
-    constexpr float kMax = static_cast<float>(std::numeric_limits<int16_t>::max());
-
-    std::transform(samples.begin(), samples.end(), pcm.begin(),
-                   [](float sample) {
-                       sample = std::clamp(sample, -1.0f, 1.0f);
-                       return static_cast<int16_t>(sample * kMax);
-                   });
-    return pcm;
+bool WaveStreamWriter::writeHeader() {
+    const std::vector<char> header = MakeHeader(format_, samplesWritten_);
+    stream_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    return stream_.good();
 }
 
 }  // namespace audio
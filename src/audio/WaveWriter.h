@@ -1,15 +1,21 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <filesystem>
+#include <fstream>
 #include <string>
 #include <vector>
 
+#include "audio/SampleConvert.h"
+
 namespace audio {
 
+// Int16, Int24 and Int32 are written as PCM, Float32 and Float64 as IEEE
+// float; Int32Left24 is a device-only layout and is rejected.
 struct WaveFormat {
     uint32_t sampleRate = 44100;
-    uint16_t bitsPerSample = 16;
+    SampleFormat sampleFormat = SampleFormat::Int16;
     uint16_t channels = 1;
 };
 
@@ -19,9 +25,38 @@ public:
                const std::vector<float>& samples,
                const WaveFormat& format,
                std::string& errorMessage) const;
+};
+
+// Incremental counterpart of WaveWriter: samples are converted and appended
+// as they arrive, a fixed-size chunk per stream write, and the RIFF sizes are patched
+// in close(), so memory use does not grow with the length of the render.
+class WaveStreamWriter {
+public:
+    WaveStreamWriter() = default;
+    WaveStreamWriter(const WaveStreamWriter&) = delete;
+    WaveStreamWriter& operator=(const WaveStreamWriter&) = delete;
+    ~WaveStreamWriter();
+
+    bool open(const std::filesystem::path& path,
+              const WaveFormat& format,
+              std::string& errorMessage);
+    bool write(const float* samples, std::size_t count, std::string& errorMessage);
+    // Finalises the header; the file is incomplete until this succeeds.
+    bool close(std::string& errorMessage);
+
+    bool isOpen() const { return stream_.is_open(); }
+    std::uint64_t samplesWritten() const { return samplesWritten_; }
 
 private:
-    static std::vector<int16_t> quantize(const std::vector<float>& samples);
+    bool writeHeader();
+
+    std::ofstream stream_;
+    std::filesystem::path path_;
+    WaveFormat format_;
+    SampleConvertFn convert_ = nullptr;
+    std::size_t sampleBytes_ = 0;
+    std::uint64_t samplesWritten_ = 0;
+    std::vector<char> encoded_;  // one chunk of converted samples
 };
 
 }  // namespace audio
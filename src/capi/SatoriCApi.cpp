@@ -0,0 +1,222 @@
+#include "capi/satori.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+
+#include "engine/LatencyHistogram.h"
+#include "engine/RealtimeThread.h"
+#include "engine/StringParams.h"
+#include "engine/StringSynthEngine.h"
+
+struct satori_engine {
+    satori_engine(std::size_t maxVoices, std::size_t parts)
+        : synth(synthesis::StringConfig{}, maxVoices, 0, parts) {}
+
+    engine::StringSynthEngine synth;
+    engine::LatencyHistogram processTimes;
+};
+
+namespace {
+
+// Events converted per enqueueEvents() call; on the caller's stack.
+constexpr std::size_t kEventBatch = 64;
+
+const engine::ParamInfo* ParamFor(std::uint32_t param) {
+    return engine::GetParamInfo(static_cast<engine::ParamId>(param));
+}
+
+// False for an event the engine has no meaning for.
+bool ConvertEvent(const satori_event& in, std::uint64_t position, engine::Event& out) {
+    out = engine::Event{};
+    out.frameOffset = position + in.offset;
+    out.part = in.part;
+    out.noteId = in.note_id;
+    switch (in.type) {
+        case SATORI_EVENT_NOTE_ON:
+            out.type = engine::EventType::NoteOn;
+            out.frequency = in.frequency;
+            out.velocity = std::clamp(in.velocity, 0.0f, 1.0f);
+            return in.frequency > 0.0;
+        case SATORI_EVENT_NOTE_OFF:
+            out.type = engine::EventType::NoteOff;
+            return true;
+        case SATORI_EVENT_PARAM:
+            out.type = engine::EventType::ParamChange;
+            out.param = static_cast<engine::ParamId>(in.param);
+            out.paramValue = in.value;
+            return ParamFor(in.param) != nullptr;
+        case SATORI_EVENT_NOTE_EXPRESSION:
+            out.type = engine::EventType::NoteExpression;
+            out.expression = static_cast<engine::NoteExpression>(in.param);
+            out.paramValue = in.value;
+            return in.param <= SATORI_EXPRESSION_TIMBRE;
+    }
+    return false;
+}
+
+}  // namespace
+
+extern "C" {
+
+uint32_t satori_api_version(void) {
+    return SATORI_API_VERSION;
+}
+
+satori_engine* satori_create(double sample_rate, uint32_t max_voices, uint32_t parts) {
+    if (!(sample_rate > 0.0)) {
+        return nullptr;
+    }
+    const std::size_t voices =
+        max_voices == 0 ? engine::StringSynthEngine::kDefaultMaxVoices : max_voices;
+    auto* handle = new (std::nothrow) satori_engine(voices, std::max<uint32_t>(parts, 1));
+    if (!handle) {
+        return nullptr;
+    }
+    handle->synth.setRenderMode(engine::RenderMode::Realtime);
+    handle->synth.setSampleRate(sample_rate);
+    return handle;
+}
+
+void satori_destroy(satori_engine* engine) {
+    delete engine;
+}
+
+void satori_reset(satori_engine* engine) {
+    if (engine) {
+        engine->synth.reset();
+    }
+}
+
+void satori_set_offline(satori_engine* engine, int offline) {
+    if (engine) {
+        engine->synth.setRenderMode(offline ? engine::RenderMode::Offline
+                                            : engine::RenderMode::Realtime);
+    }
+}
+
+int satori_set_sample_rate(satori_engine* engine, double sample_rate) {
+    if (!engine || !(sample_rate > 0.0)) {
+        return 0;
+    }
+    engine->synth.setSampleRate(sample_rate);
+    return 1;
+}
+
+uint32_t satori_param_count(void) {
+    return static_cast<uint32_t>(engine::kParamCount);
+}
+
+int32_t satori_find_param(const char* name) {
+    const engine::ParamInfo* info = name ? engine::FindParamByName(name) : nullptr;
+    return info ? static_cast<int32_t>(info->id) : -1;
+}
+
+int satori_param_info_get(uint32_t param, satori_param_info* info) {
+    const engine::ParamInfo* found = ParamFor(param);
+    if (!found || !info) {
+        return 0;
+    }
+    info->name = found->name;
+    info->min_value = found->minValue;
+    info->max_value = found->maxValue;
+    info->default_value = found->defaultValue;
+    info->type = static_cast<uint32_t>(found->type);
+    return 1;
+}
+
+int satori_set_param(satori_engine* engine, uint32_t part, uint32_t param, float value) {
+    if (!engine || !ParamFor(param) || part >= engine->synth.partCount()) {
+        return 0;
+    }
+    engine->synth.setPartParam(part, static_cast<engine::ParamId>(param), value);
+    return 1;
+}
+
+float satori_get_param(const satori_engine* engine, uint32_t part, uint32_t param) {
+    const engine::ParamInfo* info = ParamFor(param);
+    if (!engine || !info || part >= engine->synth.partCount()) {
+        return info ? info->defaultValue : 0.0f;
+    }
+    return engine->synth.getPartParam(part, static_cast<engine::ParamId>(param));
+}
+
+size_t satori_submit_events(satori_engine* engine, const satori_event* events, size_t count) {
+    if (!engine || !events) {
+        return 0;
+    }
+    const std::uint64_t position = engine->synth.renderedFrames();
+    std::array<engine::Event, kEventBatch> batch;
+    size_t taken = 0;
+    while (taken < count) {
+        // A run ends early at an event that does not convert, so what is
+        // refused is always a suffix.
+        std::size_t run = 0;
+        bool valid = true;
+        while (run < batch.size() && taken + run < count) {
+            if (!ConvertEvent(events[taken + run], position, batch[run])) {
+                valid = false;
+                break;
+            }
+            ++run;
+        }
+        const std::size_t queued =
+            engine->synth.enqueueEvents(std::span<const engine::Event>(batch.data(), run));
+        taken += queued;
+        if (queued < run || !valid) {
+            break;
+        }
+    }
+    return taken;
+}
+
+void satori_process(satori_engine* engine, float* const* channels, uint32_t channel_count,
+                    uint32_t frames) {
+    if (!engine || !channels || channel_count == 0 || frames == 0) {
+        return;
+    }
+    // The host's audio thread: its FP mode is not ours to rely on.
+    const engine::ScopedDspThread dspThread("satori process");
+    const auto start = std::chrono::steady_clock::now();
+    const auto channelCount =
+        static_cast<std::uint16_t>(std::min<uint32_t>(channel_count, UINT16_MAX));
+    engine->synth.process(engine::PlanarProcessBlock{channels, frames, channelCount});
+    const double elapsedUs =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count();
+    const double rate = engine->synth.sampleRate();
+    const double periodUs = rate > 0.0 ? static_cast<double>(frames) * 1e6 / rate : 0.0;
+    engine->processTimes.record(elapsedUs, periodUs);
+}
+
+int satori_get_metrics(const satori_engine* engine, satori_metrics* metrics) {
+    constexpr std::size_t kRequired =
+        offsetof(satori_metrics, rendered_frames) + sizeof(uint64_t);
+    if (!engine || !metrics || metrics->size < kRequired) {
+        return 0;
+    }
+    const engine::EngineStatus status = engine->synth.status();
+    const engine::LatencyHistogram::Snapshot times = engine->processTimes.snapshot();
+    satori_metrics full{};
+    full.size = metrics->size;
+    full.active_voices = static_cast<uint32_t>(status.activeVoices);
+    full.voice_limit = static_cast<uint32_t>(status.voiceLimit);
+    full.queued_events = static_cast<uint32_t>(status.queuedEvents);
+    full.sample_rate = status.sampleRate;
+    full.rendered_frames = status.renderedFrames;
+    full.process_calls = times.callbacks;
+    full.process_overruns = times.overruns;
+    full.process_us_p50 = times.percentileUs(0.50);
+    full.process_us_p99 = times.percentileUs(0.99);
+    full.process_us_max = times.maxUs();
+    full.room_late_blocks = engine->synth.roomLateBlocks();
+    std::memcpy(metrics, &full, std::min<std::size_t>(metrics->size, sizeof(full)));
+    return 1;
+}
+
+}  // extern "C"
@@ -0,0 +1,144 @@
+#pragma once
+
+// C interface to the Satori engine (engine::StringSynthEngine), for hosts
+// that embed it as a shared library. Handles are opaque, buffers belong to
+// the caller, and nothing crosses the boundary but plain C types, so the
+// ABI holds across compilers. The library is built as libsatori (CMake
+// target SatoriCApi); SatoriCApiStatic links the same functions statically
+// and defines SATORI_CAPI_STATIC for its users.
+//
+// Threads: satori_process() runs on one audio thread at a time and never
+// allocates, locks or blocks. satori_submit_events(), the parameter calls
+// and satori_get_metrics() are lock-free and may be called from any thread.
+// satori_create(), satori_destroy(), satori_reset(), satori_set_offline()
+// and satori_set_sample_rate() are for a control thread while no
+// satori_process() is running. Calls returning int give nonzero on success.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(SATORI_CAPI_STATIC)
+#define SATORI_API
+#elif defined(_WIN32)
+#if defined(SATORI_CAPI_BUILD)
+#define SATORI_API __declspec(dllexport)
+#else
+#define SATORI_API __declspec(dllimport)
+#endif
+#else
+#define SATORI_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bumped when a declaration below changes incompatibly; additions keep it.
+#define SATORI_API_VERSION 1
+
+typedef struct satori_engine satori_engine;
+
+typedef enum satori_event_type {
+    SATORI_EVENT_NOTE_ON = 0,
+    SATORI_EVENT_NOTE_OFF = 1,
+    SATORI_EVENT_PARAM = 2,
+    SATORI_EVENT_NOTE_EXPRESSION = 3
+} satori_event_type;
+
+// NOTE_EXPRESSION values: the note's own pitch bend in semitones, pressure
+// 0..1 and timbre 0..1 (0.5 neutral).
+typedef enum satori_expression {
+    SATORI_EXPRESSION_PITCH_BEND = 0,
+    SATORI_EXPRESSION_PRESSURE = 1,
+    SATORI_EXPRESSION_TIMBRE = 2
+} satori_expression;
+
+// One timed event; 40 bytes, no implicit padding.
+typedef struct satori_event {
+    uint32_t type;     // satori_event_type
+    uint32_t offset;   // frames after the engine's position at submission
+    int32_t note_id;   // NOTE_*: the caller's id for the note, per part
+    uint32_t part;     // 0 .. parts - 1
+    double frequency;  // NOTE_ON: Hz
+    float velocity;    // NOTE_ON: 0..1
+    float value;       // PARAM: plain value in the parameter's range; NOTE_EXPRESSION: its value
+    uint32_t param;    // PARAM: parameter id; NOTE_EXPRESSION: satori_expression
+    uint32_t reserved; // 0
+} satori_event;
+
+typedef struct satori_param_info {
+    const char* name;  // static; valid for the life of the library
+    float min_value;
+    float max_value;
+    float default_value;
+    uint32_t type;     // 0 = continuous, 1 = switch, 2 = list of steps
+} satori_param_info;
+
+// Set `size` to sizeof(satori_metrics) before the call; a library with more
+// fields fills only the ones the caller knows about.
+typedef struct satori_metrics {
+    uint32_t size;
+    uint32_t active_voices;  // including voices fading out after a steal
+    uint32_t voice_limit;
+    uint32_t queued_events;  // submitted or scheduled, not yet played
+    double sample_rate;
+    uint64_t rendered_frames;
+    // satori_process() calls and their duration, from a 10 us histogram;
+    // overruns took longer than the block they rendered lasts.
+    uint64_t process_calls;
+    uint64_t process_overruns;
+    double process_us_p50;
+    double process_us_p99;
+    double process_us_max;
+    uint64_t room_late_blocks;  // room tail blocks not ready when due
+} satori_metrics;
+
+SATORI_API uint32_t satori_api_version(void);
+
+// `max_voices` per part is clamped to 1..128 and `parts` to 1..8; 0 picks
+// 16 voices and one part. The room tail renders on a worker thread (see
+// satori_set_offline()). Null if the engine cannot be built.
+SATORI_API satori_engine* satori_create(double sample_rate, uint32_t max_voices, uint32_t parts);
+SATORI_API void satori_destroy(satori_engine* engine);
+
+// Drops sounding and queued notes and clears the room.
+SATORI_API void satori_reset(satori_engine* engine);
+// Nonzero renders the room tail inside satori_process() instead, for
+// bounces that run faster than realtime.
+SATORI_API void satori_set_offline(satori_engine* engine, int offline);
+SATORI_API int satori_set_sample_rate(satori_engine* engine, double sample_rate);
+
+// Parameters are addressed by id, 0 .. satori_param_count() - 1: the
+// engine's ParamId values, which stay stable across versions (new ones are
+// added at the end). Names are those of presets and the CLAP plugin.
+SATORI_API uint32_t satori_param_count(void);
+// -1 for an unknown name; case-insensitive.
+SATORI_API int32_t satori_find_param(const char* name);
+SATORI_API int satori_param_info_get(uint32_t param, satori_param_info* info);
+// Values are clamped to the parameter's range; parts share the room's.
+SATORI_API int satori_set_param(satori_engine* engine, uint32_t part, uint32_t param,
+                                float value);
+SATORI_API float satori_get_param(const satori_engine* engine, uint32_t part, uint32_t param);
+
+// Queues `count` events, each at its own offset from the engine's current
+// position; submit them on the audio thread right before satori_process()
+// for sample-accurate timing. Returns how many were taken from the front:
+// the rest start with one the queue had no room for or that names
+// something that does not exist. Any thread.
+SATORI_API size_t satori_submit_events(satori_engine* engine, const satori_event* events,
+                                       size_t count);
+
+// Renders `frames` frames into `channel_count` caller-owned buffers, written
+// in place (1 = mono, 2 = stereo; null buffers are skipped). The first call
+// after satori_create() or satori_set_sample_rate() sets up the room and
+// allocates; render one block before going live.
+SATORI_API void satori_process(satori_engine* engine, float* const* channels,
+                               uint32_t channel_count, uint32_t frames);
+
+// 0 if `metrics` is null or its size is too small for the fields up to
+// rendered_frames.
+SATORI_API int satori_get_metrics(const satori_engine* engine, satori_metrics* metrics);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
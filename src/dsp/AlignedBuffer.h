@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace dsp {
+
+// Cache-line aligned allocator so SIMD kernels can stream rows without
+// straddling lines.
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+using AlignedFloatVector = std::vector<float, AlignedAllocator<float>>;
+
+// Floats per 64-byte line; slab rows are padded to a multiple of this.
+inline constexpr std::size_t kAlignedFloats = 64 / sizeof(float);
+
+inline constexpr std::size_t AlignedStride(std::size_t count) {
+    return (count + kAlignedFloats - 1) / kAlignedFloats * kAlignedFloats;
+}
+
+// One aligned allocation carved into float buffers, each starting on its own
+// cache line. Owners lay their buffers out twice: once after release(), when
+// take() only counts, and again after allocate(used()), when it hands out
+// the slices in the same order.
+class FloatArena {
+public:
+    void release() {
+        block_ = AlignedFloatVector();
+        used_ = 0;
+    }
+    // Zeroed; take() starts again from the front.
+    void allocate(std::size_t floats) {
+        block_.assign(floats, 0.0f);
+        used_ = 0;
+    }
+    // The next `count` floats, or an empty span while counting or once the
+    // block is used up.
+    std::span<float> take(std::size_t count) {
+        const std::size_t start = used_;
+        used_ += AlignedStride(count);
+        if (count == 0 || used_ > block_.size()) {
+            return {};
+        }
+        return {block_.data() + start, count};
+    }
+    // Zeroes every buffer at once.
+    void zero() { std::fill(block_.begin(), block_.end(), 0.0f); }
+
+    // Floats taken since the last release() or allocate(), padding included.
+    std::size_t used() const { return used_; }
+    std::size_t heapBytes() const { return block_.capacity() * sizeof(float); }
+
+private:
+    AlignedFloatVector block_;
+    std::size_t used_ = 0;
+};
+
+}  // namespace dsp
@@ -0,0 +1,250 @@
+#include "dsp/ComplexMac.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SATORI_MAC_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define SATORI_MAC_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace dsp {
+
+void ComplexMacScalar(const float* xr, const float* xi, const float* hr, const float* hi,
+                      float* accR, float* accI, std::size_t n) {
+    for (std::size_t k = 0; k < n; ++k) {
+        accR[k] += xr[k] * hr[k] - xi[k] * hi[k];
+        accI[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+}
+
+void ComplexMacStereoScalar(const float* xr, const float* xi, const float* hLr,
+                            const float* hLi, const float* hRr, const float* hRi,
+                            float* accLr, float* accLi, float* accRr, float* accRi,
+                            std::size_t n) {
+    for (std::size_t k = 0; k < n; ++k) {
+        const float a = xr[k];
+        const float b = xi[k];
+        accLr[k] += a * hLr[k] - b * hLi[k];
+        accLi[k] += a * hLi[k] + b * hLr[k];
+        accRr[k] += a * hRr[k] - b * hRi[k];
+        accRi[k] += a * hRi[k] + b * hRr[k];
+    }
+}
+
+namespace {
+
+#if defined(SATORI_MAC_X86)
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SATORI_MAC_SSE2 1
+void ComplexMacSse2(const float* xr, const float* xi, const float* hr, const float* hi,
+                    float* accR, float* accI, std::size_t n) {
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128 a = _mm_loadu_ps(xr + k);
+        const __m128 b = _mm_loadu_ps(xi + k);
+        const __m128 c = _mm_loadu_ps(hr + k);
+        const __m128 d = _mm_loadu_ps(hi + k);
+        const __m128 re = _mm_sub_ps(_mm_mul_ps(a, c), _mm_mul_ps(b, d));
+        const __m128 im = _mm_add_ps(_mm_mul_ps(a, d), _mm_mul_ps(b, c));
+        _mm_storeu_ps(accR + k, _mm_add_ps(_mm_loadu_ps(accR + k), re));
+        _mm_storeu_ps(accI + k, _mm_add_ps(_mm_loadu_ps(accI + k), im));
+    }
+    ComplexMacScalar(xr + k, xi + k, hr + k, hi + k, accR + k, accI + k, n - k);
+}
+
+void ComplexMacStereoSse2(const float* xr, const float* xi, const float* hLr,
+                          const float* hLi, const float* hRr, const float* hRi,
+                          float* accLr, float* accLi, float* accRr, float* accRi,
+                          std::size_t n) {
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const __m128 a = _mm_loadu_ps(xr + k);
+        const __m128 b = _mm_loadu_ps(xi + k);
+        const __m128 lc = _mm_loadu_ps(hLr + k);
+        const __m128 ld = _mm_loadu_ps(hLi + k);
+        const __m128 rc = _mm_loadu_ps(hRr + k);
+        const __m128 rd = _mm_loadu_ps(hRi + k);
+        const __m128 lre = _mm_sub_ps(_mm_mul_ps(a, lc), _mm_mul_ps(b, ld));
+        const __m128 lim = _mm_add_ps(_mm_mul_ps(a, ld), _mm_mul_ps(b, lc));
+        const __m128 rre = _mm_sub_ps(_mm_mul_ps(a, rc), _mm_mul_ps(b, rd));
+        const __m128 rim = _mm_add_ps(_mm_mul_ps(a, rd), _mm_mul_ps(b, rc));
+        _mm_storeu_ps(accLr + k, _mm_add_ps(_mm_loadu_ps(accLr + k), lre));
+        _mm_storeu_ps(accLi + k, _mm_add_ps(_mm_loadu_ps(accLi + k), lim));
+        _mm_storeu_ps(accRr + k, _mm_add_ps(_mm_loadu_ps(accRr + k), rre));
+        _mm_storeu_ps(accRi + k, _mm_add_ps(_mm_loadu_ps(accRi + k), rim));
+    }
+    ComplexMacStereoScalar(xr + k, xi + k, hLr + k, hLi + k, hRr + k, hRi + k, accLr + k,
+                           accLi + k, accRr + k, accRi + k, n - k);
+}
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SATORI_TARGET_AVX __attribute__((target("avx")))
+#else
+#define SATORI_TARGET_AVX
+#endif
+
+SATORI_TARGET_AVX
+void ComplexMacAvx(const float* xr, const float* xi, const float* hr, const float* hi,
+                   float* accR, float* accI, std::size_t n) {
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m256 a = _mm256_loadu_ps(xr + k);
+        const __m256 b = _mm256_loadu_ps(xi + k);
+        const __m256 c = _mm256_loadu_ps(hr + k);
+        const __m256 d = _mm256_loadu_ps(hi + k);
+        const __m256 re = _mm256_sub_ps(_mm256_mul_ps(a, c), _mm256_mul_ps(b, d));
+        const __m256 im = _mm256_add_ps(_mm256_mul_ps(a, d), _mm256_mul_ps(b, c));
+        _mm256_storeu_ps(accR + k, _mm256_add_ps(_mm256_loadu_ps(accR + k), re));
+        _mm256_storeu_ps(accI + k, _mm256_add_ps(_mm256_loadu_ps(accI + k), im));
+    }
+    for (; k < n; ++k) {
+        accR[k] += xr[k] * hr[k] - xi[k] * hi[k];
+        accI[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+}
+
+SATORI_TARGET_AVX
+void ComplexMacStereoAvx(const float* xr, const float* xi, const float* hLr,
+                         const float* hLi, const float* hRr, const float* hRi,
+                         float* accLr, float* accLi, float* accRr, float* accRi,
+                         std::size_t n) {
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        const __m256 a = _mm256_loadu_ps(xr + k);
+        const __m256 b = _mm256_loadu_ps(xi + k);
+        const __m256 lc = _mm256_loadu_ps(hLr + k);
+        const __m256 ld = _mm256_loadu_ps(hLi + k);
+        const __m256 rc = _mm256_loadu_ps(hRr + k);
+        const __m256 rd = _mm256_loadu_ps(hRi + k);
+        const __m256 lre = _mm256_sub_ps(_mm256_mul_ps(a, lc), _mm256_mul_ps(b, ld));
+        const __m256 lim = _mm256_add_ps(_mm256_mul_ps(a, ld), _mm256_mul_ps(b, lc));
+        const __m256 rre = _mm256_sub_ps(_mm256_mul_ps(a, rc), _mm256_mul_ps(b, rd));
+        const __m256 rim = _mm256_add_ps(_mm256_mul_ps(a, rd), _mm256_mul_ps(b, rc));
+        _mm256_storeu_ps(accLr + k, _mm256_add_ps(_mm256_loadu_ps(accLr + k), lre));
+        _mm256_storeu_ps(accLi + k, _mm256_add_ps(_mm256_loadu_ps(accLi + k), lim));
+        _mm256_storeu_ps(accRr + k, _mm256_add_ps(_mm256_loadu_ps(accRr + k), rre));
+        _mm256_storeu_ps(accRi + k, _mm256_add_ps(_mm256_loadu_ps(accRi + k), rim));
+    }
+    for (; k < n; ++k) {
+        const float a = xr[k];
+        const float b = xi[k];
+        accLr[k] += a * hLr[k] - b * hLi[k];
+        accLi[k] += a * hLi[k] + b * hLr[k];
+        accRr[k] += a * hRr[k] - b * hRi[k];
+        accRi[k] += a * hRi[k] + b * hRr[k];
+    }
+}
+
+bool CpuHasAvx() {
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) {
+        return false;
+    }
+    // OS must save YMM state (XCR0 bits 1 and 2).
+    return (_xgetbv(0) & 0x6) == 0x6;
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#else
+    return false;
+#endif
+}
+
+#endif  // SATORI_MAC_X86
+
+#if defined(SATORI_MAC_NEON)
+void ComplexMacNeon(const float* xr, const float* xi, const float* hr, const float* hi,
+                    float* accR, float* accI, std::size_t n) {
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const float32x4_t a = vld1q_f32(xr + k);
+        const float32x4_t b = vld1q_f32(xi + k);
+        const float32x4_t c = vld1q_f32(hr + k);
+        const float32x4_t d = vld1q_f32(hi + k);
+        const float32x4_t re = vsubq_f32(vmulq_f32(a, c), vmulq_f32(b, d));
+        const float32x4_t im = vaddq_f32(vmulq_f32(a, d), vmulq_f32(b, c));
+        vst1q_f32(accR + k, vaddq_f32(vld1q_f32(accR + k), re));
+        vst1q_f32(accI + k, vaddq_f32(vld1q_f32(accI + k), im));
+    }
+    ComplexMacScalar(xr + k, xi + k, hr + k, hi + k, accR + k, accI + k, n - k);
+}
+
+void ComplexMacStereoNeon(const float* xr, const float* xi, const float* hLr,
+                          const float* hLi, const float* hRr, const float* hRi,
+                          float* accLr, float* accLi, float* accRr, float* accRi,
+                          std::size_t n) {
+    std::size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        const float32x4_t a = vld1q_f32(xr + k);
+        const float32x4_t b = vld1q_f32(xi + k);
+        const float32x4_t lc = vld1q_f32(hLr + k);
+        const float32x4_t ld = vld1q_f32(hLi + k);
+        const float32x4_t rc = vld1q_f32(hRr + k);
+        const float32x4_t rd = vld1q_f32(hRi + k);
+        const float32x4_t lre = vsubq_f32(vmulq_f32(a, lc), vmulq_f32(b, ld));
+        const float32x4_t lim = vaddq_f32(vmulq_f32(a, ld), vmulq_f32(b, lc));
+        const float32x4_t rre = vsubq_f32(vmulq_f32(a, rc), vmulq_f32(b, rd));
+        const float32x4_t rim = vaddq_f32(vmulq_f32(a, rd), vmulq_f32(b, rc));
+        vst1q_f32(accLr + k, vaddq_f32(vld1q_f32(accLr + k), lre));
+        vst1q_f32(accLi + k, vaddq_f32(vld1q_f32(accLi + k), lim));
+        vst1q_f32(accRr + k, vaddq_f32(vld1q_f32(accRr + k), rre));
+        vst1q_f32(accRi + k, vaddq_f32(vld1q_f32(accRi + k), rim));
+    }
+    ComplexMacStereoScalar(xr + k, xi + k, hLr + k, hLi + k, hRr + k, hRi + k, accLr + k,
+                           accLi + k, accRr + k, accRi + k, n - k);
+}
+#endif
+
+struct MacSelection {
+    ComplexMacFn fn = &ComplexMacScalar;
+    ComplexMacStereoFn stereo = &ComplexMacStereoScalar;
+    const char* name = "scalar";
+};
+
+MacSelection SelectComplexMac() {
+    MacSelection selection;
+#if defined(SATORI_MAC_X86)
+#if defined(SATORI_MAC_SSE2)
+    selection = {&ComplexMacSse2, &ComplexMacStereoSse2, "sse2"};
+#endif
+    if (CpuHasAvx()) {
+        selection = {&ComplexMacAvx, &ComplexMacStereoAvx, "avx"};
+    }
+#elif defined(SATORI_MAC_NEON)
+    selection = {&ComplexMacNeon, &ComplexMacStereoNeon, "neon"};
+#endif
+    return selection;
+}
+
+const MacSelection& ComplexMacSelection() {
+    static const MacSelection selection = SelectComplexMac();
+    return selection;
+}
+
+}  // namespace
+
+ComplexMacFn GetComplexMac() {
+    return ComplexMacSelection().fn;
+}
+
+ComplexMacStereoFn GetComplexMacStereo() {
+    return ComplexMacSelection().stereo;
+}
+
+const char* ComplexMacName() {
+    return ComplexMacSelection().name;
+}
+
+}  // namespace dsp
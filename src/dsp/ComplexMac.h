@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include "dsp/AlignedBuffer.h"
+
+namespace dsp {
+
+// Split (planar) complex buffer: separate real and imaginary arrays, which is
+// the layout the vectorised multiply-accumulate kernels want.
+struct SplitComplex {
+    AlignedFloatVector re;
+    AlignedFloatVector im;
+
+    void assign(std::size_t n) {
+        re.assign(n, 0.0f);
+        im.assign(n, 0.0f);
+    }
+    void clear() {
+        std::fill(re.begin(), re.end(), 0.0f);
+        std::fill(im.begin(), im.end(), 0.0f);
+    }
+    std::size_t size() const { return re.size(); }
+};
+
+// acc += x * h over n complex bins (split layout).
+using ComplexMacFn = void (*)(const float* xr, const float* xi, const float* hr,
+                              const float* hi, float* accR, float* accI, std::size_t n);
+
+// accL += x * hL and accR += x * hR in one pass over x, for true-stereo
+// kernels sharing an input history.
+using ComplexMacStereoFn = void (*)(const float* xr, const float* xi, const float* hLr,
+                                    const float* hLi, const float* hRr, const float* hRi,
+                                    float* accLr, float* accLi, float* accRr, float* accRi,
+                                    std::size_t n);
+
+// Returns the fastest kernel for the running CPU (AVX, SSE2, NEON or scalar).
+// Selected once on first use.
+ComplexMacFn GetComplexMac();
+ComplexMacStereoFn GetComplexMacStereo();
+// Name of the selected kernel, for logging/tests.
+const char* ComplexMacName();
+
+void ComplexMacScalar(const float* xr, const float* xi, const float* hr, const float* hi,
+                      float* accR, float* accI, std::size_t n);
+void ComplexMacStereoScalar(const float* xr, const float* xi, const float* hLr,
+                            const float* hLi, const float* hRr, const float* hRi,
+                            float* accLr, float* accLi, float* accRr, float* accRi,
+                            std::size_t n);
+
+}  // namespace dsp
@@ -0,0 +1,241 @@
+#include "dsp/ConvolutionHead.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "dsp/Simd.h"
+#include "dsp/StateSnapshot.h"
+
+namespace dsp {
+
+static_assert(ConvolutionHead::kFirTaps == ConvolutionHead::kBlockSize,
+              "Partitioned head stage must start exactly one block into the IR");
+static_assert(ConvolutionHead::kFirTaps % simd::kLanes == 0,
+              "FIR taps must fill whole SIMD lanes");
+
+ConvolutionHead::ConvolutionHead(std::size_t headLength, std::size_t fadeSamples)
+    : headLength_(std::max(kFirTaps, (headLength + kBlockSize - 1) / kBlockSize * kBlockSize)),
+      fadeSamples_(std::max<std::size_t>(1, fadeSamples)) {
+    const std::size_t partitions = (headLength_ - kFirTaps) / kBlockSize;
+    convolver_.configure(kBlockSize, 2 * kBlockSize, std::max<std::size_t>(1, partitions));
+    block_.assign(kBlockSize, 0.0f);
+    reset();
+}
+
+bool ConvolutionHead::isStereo(int index) const {
+    return index >= 0 && index < irCount() && irs_[static_cast<std::size_t>(index)].isStereo;
+}
+
+void ConvolutionHead::addIr(const float* left, const float* right, std::size_t frames) {
+    IrHead head;
+    head.isStereo = (right != nullptr);
+
+    const auto build = [&](const float* ir, std::vector<float>& fir, ConvolutionKernel& part) {
+        fir.assign(kFirTaps, 0.0f);
+        if (!ir) {
+            return;
+        }
+        const std::size_t firCount = std::min(kFirTaps, frames);
+        std::copy(ir, ir + firCount, fir.begin());
+        const std::size_t end = std::min(headLength_, frames);
+        if (end > kFirTaps) {
+            part = PartitionedConvolver::buildKernelFromIr(
+                std::vector<float>(ir + kFirTaps, ir + end), kBlockSize, 2 * kBlockSize);
+        }
+    };
+    build(left, head.firL, head.partL);
+    if (right) {
+        build(right, head.firR, head.partR);
+    }
+    irs_.push_back(std::move(head));
+}
+
+void ConvolutionHead::setIrIndex(int index) {
+    if (irs_.empty()) {
+        irIndex_ = 0;
+        pendingIrIndex_ = -1;
+        return;
+    }
+    index = std::clamp(index, 0, irCount() - 1);
+    if (index == irIndex_ && pendingIrIndex_ < 0) {
+        return;
+    }
+    pendingIrIndex_ = index;
+    fadePos_ = 0;
+    resetPath(pending_);
+}
+
+void ConvolutionHead::resetPath(Path& path) {
+    path.overlapL.assign(kBlockSize, 0.0f);
+    path.overlapR.assign(kBlockSize, 0.0f);
+    path.outL.assign(kBlockSize, 0.0f);
+    path.outR.assign(kBlockSize, 0.0f);
+}
+
+std::size_t ConvolutionHead::heapBytes() const {
+    std::size_t floats = block_.capacity();
+    for (const IrHead& ir : irs_) {
+        floats += ir.firL.capacity() + ir.firR.capacity();
+    }
+    for (const Path* path : {&current_, &pending_}) {
+        floats += path->overlapL.capacity() + path->overlapR.capacity() +
+                  path->outL.capacity() + path->outR.capacity();
+    }
+    std::size_t bytes = floats * sizeof(float) + convolver_.heapBytes();
+    for (const IrHead& ir : irs_) {
+        bytes += ir.partL.heapBytes() + ir.partR.heapBytes();
+    }
+    return bytes;
+}
+
+void ConvolutionHead::reset() {
+    history_.fill(0.0f);
+    historyPos_ = 0;
+    convolver_.reset();
+    std::fill(block_.begin(), block_.end(), 0.0f);
+    blockPos_ = 0;
+    resetPath(current_);
+    resetPath(pending_);
+    if (pendingIrIndex_ >= 0) {
+        irIndex_ = pendingIrIndex_;
+        pendingIrIndex_ = -1;
+    }
+    fadePos_ = 0;
+}
+
+void ConvolutionHead::saveState(StateWriter& out) const {
+    out.pod(headLength_);
+    out.pod(irs_.size());
+    out.pod(irIndex_);
+    out.pod(pendingIrIndex_);
+    out.pod(fadePos_);
+    out.pod(history_);
+    out.pod(historyPos_);
+    convolver_.saveState(out);
+    out.floats(block_.data(), kBlockSize);
+    out.pod(blockPos_);
+    for (const Path* path : {&current_, &pending_}) {
+        for (const auto* channel : {&path->overlapL, &path->overlapR, &path->outL, &path->outR}) {
+            out.floats(channel->data(), kBlockSize);
+        }
+    }
+}
+
+bool ConvolutionHead::loadState(StateReader& in) {
+    std::size_t headLength = 0;
+    std::size_t irs = 0;
+    if (in.pod(headLength) && headLength != headLength_) {
+        in.fail();
+    }
+    if (in.pod(irs) && irs != irs_.size()) {
+        in.fail();
+    }
+    in.pod(irIndex_);
+    in.pod(pendingIrIndex_);
+    in.pod(fadePos_);
+    in.pod(history_);
+    in.pod(historyPos_);
+    convolver_.loadState(in);
+    in.floats(block_.data(), kBlockSize);
+    in.pod(blockPos_);
+    for (Path* path : {&current_, &pending_}) {
+        for (auto* channel : {&path->overlapL, &path->overlapR, &path->outL, &path->outR}) {
+            in.floats(channel->data(), kBlockSize);
+        }
+    }
+    if (in.ok() && (irIndex_ < 0 || irIndex_ >= std::max(1, irCount()) ||
+                    pendingIrIndex_ < -1 || pendingIrIndex_ >= irCount() ||
+                    historyPos_ >= kFirTaps || blockPos_ >= kBlockSize)) {
+        in.fail();
+    }
+    if (!in.ok()) {
+        irIndex_ = 0;
+        pendingIrIndex_ = -1;
+        reset();
+    }
+    return in.ok();
+}
+
+void ConvolutionHead::fir(const IrHead& ir, float& outL, float& outR) const {
+    const float* x = history_.data() + historyPos_;
+    const float* hl = ir.firL.data();
+    const float* hr = ir.isStereo ? ir.firR.data() : hl;
+    simd::Float4 accL = simd::Set1(0.0f);
+    simd::Float4 accR = simd::Set1(0.0f);
+    for (std::size_t k = 0; k < kFirTaps; k += simd::kLanes) {
+        const simd::Float4 xv = simd::Load(x + k);
+        accL = simd::Add(accL, simd::Mul(simd::Load(hl + k), xv));
+        accR = simd::Add(accR, simd::Mul(simd::Load(hr + k), xv));
+    }
+    float lanesL[simd::kLanes];
+    float lanesR[simd::kLanes];
+    simd::Store(lanesL, accL);
+    simd::Store(lanesR, accR);
+    outL = (lanesL[0] + lanesL[1]) + (lanesL[2] + lanesL[3]);
+    outR = (lanesR[0] + lanesR[1]) + (lanesR[2] + lanesR[3]);
+}
+
+void ConvolutionHead::runPartitions(const IrHead& ir, Path& path) {
+    if (ir.partL.empty()) {
+        std::fill(path.outL.begin(), path.outL.end(), 0.0f);
+        std::fill(path.outR.begin(), path.outR.end(), 0.0f);
+        return;
+    }
+    if (ir.isStereo) {
+        convolver_.convolveStereoWithOverlap(ir.partL, ir.partR, path.outL.data(),
+                                             path.outR.data(), path.overlapL, path.overlapR);
+    } else {
+        convolver_.convolveWithOverlap(ir.partL, path.outL.data(), path.overlapL);
+        std::copy(path.outL.begin(), path.outL.end(), path.outR.begin());
+    }
+}
+
+void ConvolutionHead::process(float input, float& outL, float& outR) {
+    historyPos_ = (historyPos_ == 0 ? kFirTaps : historyPos_) - 1;
+    history_[historyPos_] = input;
+    history_[historyPos_ + kFirTaps] = input;
+
+    outL = 0.0f;
+    outR = 0.0f;
+    if (irs_.empty()) {
+        return;
+    }
+
+    const auto& a = irs_[static_cast<std::size_t>(irIndex_)];
+    fir(a, outL, outR);
+    outL += current_.outL[blockPos_];
+    outR += current_.outR[blockPos_];
+
+    if (pendingIrIndex_ >= 0) {
+        const auto& b = irs_[static_cast<std::size_t>(pendingIrIndex_)];
+        float bL = 0.0f;
+        float bR = 0.0f;
+        fir(b, bL, bR);
+        bL += pending_.outL[blockPos_];
+        bR += pending_.outR[blockPos_];
+        const float t = static_cast<float>(fadePos_) / static_cast<float>(fadeSamples_);
+        outL = outL * (1.0f - t) + bL * t;
+        outR = outR * (1.0f - t) + bR * t;
+    }
+
+    // The partitioned stage covers IR offsets >= kBlockSize, so a finished
+    // input block only feeds the following block's output.
+    block_[blockPos_] = input;
+    if (++blockPos_ == kBlockSize) {
+        blockPos_ = 0;
+        convolver_.pushInputBlock(block_.data());
+        runPartitions(a, current_);
+        if (pendingIrIndex_ >= 0) {
+            runPartitions(irs_[static_cast<std::size_t>(pendingIrIndex_)], pending_);
+        }
+    }
+
+    if (pendingIrIndex_ >= 0 && ++fadePos_ >= fadeSamples_) {
+        irIndex_ = pendingIrIndex_;
+        pendingIrIndex_ = -1;
+        fadePos_ = 0;
+        std::swap(current_, pending_);
+    }
+}
+
+}  // namespace dsp
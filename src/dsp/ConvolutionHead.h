@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "dsp/PartitionedConvolver.h"
+
+namespace dsp {
+
+class StateReader;
+class StateWriter;
+
+// Zero-latency head of a convolution reverb, run sample by sample on the audio
+// thread. The first kFirTaps samples of each IR are a direct-form FIR; the rest
+// of the head (up to headLength) is a short uniformly partitioned stage whose
+// one-block latency is hidden behind the FIR. The IR tail beyond headLength is
+// expected to be convolved elsewhere (e.g. a worker running headLength behind).
+class ConvolutionHead {
+public:
+    static constexpr std::size_t kFirTaps = 128;
+    static constexpr std::size_t kBlockSize = 128;
+
+    // headLength is rounded up to a multiple of kBlockSize (min kFirTaps).
+    // fadeSamples is the IR switch crossfade length.
+    ConvolutionHead(std::size_t headLength, std::size_t fadeSamples);
+
+    std::size_t headLength() const { return headLength_; }
+
+    // Adds one IR; `right` is null for mono. Only the first headLength()
+    // samples are used.
+    void addIr(const float* left, const float* right, std::size_t frames);
+    int irCount() const { return static_cast<int>(irs_.size()); }
+    bool isStereo(int index) const;
+
+    void setIrIndex(int index);  // crossfades from the current IR
+    int irIndex() const { return irIndex_; }
+    bool crossfading() const { return pendingIrIndex_ >= 0; }
+
+    void reset();
+    // FIR history, partitioned-stage state and IR crossfade, for snapshots.
+    // loadState() is false (and resets) unless the head holds as many IRs of
+    // the same length.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    // IR taps and spectra plus the running state, for memory accounting.
+    std::size_t heapBytes() const;
+
+    // Head-only wet output for one input sample (no wet level applied).
+    void process(float input, float& outL, float& outR);
+
+private:
+    struct IrHead {
+        std::vector<float> firL;  // kFirTaps taps
+        std::vector<float> firR;  // empty if mono
+        ConvolutionKernel partL;
+        ConvolutionKernel partR;  // empty if mono
+        bool isStereo = false;
+    };
+
+    // Per-IR running state: partitioned-stage overlap and current output block.
+    struct Path {
+        std::vector<float> overlapL;
+        std::vector<float> overlapR;
+        std::vector<float> outL;
+        std::vector<float> outR;
+    };
+
+    void resetPath(Path& path);
+    void runPartitions(const IrHead& ir, Path& path);
+    void fir(const IrHead& ir, float& outL, float& outR) const;
+
+    std::size_t headLength_ = 0;
+    std::size_t fadeSamples_ = 1;
+    std::vector<IrHead> irs_;
+    int irIndex_ = 0;
+    int pendingIrIndex_ = -1;
+    std::size_t fadePos_ = 0;
+
+    // FIR history, newest first and written twice so the last kFirTaps inputs
+    // are always contiguous at history_[historyPos_, historyPos_ + kFirTaps).
+    std::array<float, 2 * kFirTaps> history_{};
+    std::size_t historyPos_ = 0;
+
+    PartitionedConvolver convolver_;
+    std::vector<float> block_;  // kBlockSize input accumulation
+    std::size_t blockPos_ = 0;
+    Path current_;
+    Path pending_;
+};
+
+}  // namespace dsp
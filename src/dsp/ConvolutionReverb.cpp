@@ -2,6 +2,10 @@
 
 #include <algorithm>
 #include <cmath>
+#include <utility>
+
+#include "dsp/FastMath.h"
+#include "dsp/StateSnapshot.h"
 
 namespace dsp {
 
@@ -11,7 +15,7 @@ float ComputeOnePoleAlpha(double sampleRate, double timeSeconds) {
     if (sampleRate <= 0.0 || timeSeconds <= 0.0) {
         return 1.0f;
     }
-    const double a = 1.0 - std::exp(-1.0 / (sampleRate * timeSeconds));
+    const double a = 1.0 - FastExp(-1.0 / (sampleRate * timeSeconds));
     return static_cast<float>(std::clamp(a, 0.0, 1.0));
 }
 
@@ -22,22 +26,278 @@ void AddInPlace(const float* src, float* dst, std::size_t count) {
 }
 
 void Clear(float* dst, std::size_t count) { std::fill(dst, dst + count, 0.0f); }
+
+bool IsSilent(const float* src, std::size_t count) {
+    return std::all_of(src, src + count, [](float v) { return v == 0.0f; });
+}
+
+// Buffers go in by role rather than as the arena: IR switches swap slices
+// between roles.
+void SaveBuffer(StateWriter& out, std::span<const float> buffer) {
+    out.pod(buffer.size());
+    out.floats(buffer.data(), buffer.size());
+}
+
+void LoadBuffer(StateReader& in, std::span<float> buffer) {
+    std::size_t size = 0;
+    if (in.pod(size) && size != buffer.size()) {
+        in.fail();
+    }
+    in.floats(buffer.data(), buffer.size());
+}
+
+void SaveSpectrum(StateWriter& out, const SplitComplex& spectrum) {
+    SaveBuffer(out, spectrum.re);
+    SaveBuffer(out, spectrum.im);
+}
+
+void LoadSpectrum(StateReader& in, SplitComplex& spectrum) {
+    LoadBuffer(in, spectrum.re);
+    LoadBuffer(in, spectrum.im);
+}
+
+bool IsPowerOfTwo(std::size_t n) { return n != 0 && (n & (n - 1)) == 0; }
+
+std::size_t NextPowerOfTwo(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// Parallel slices: fewer partitions than this per range aren't worth a job.
+constexpr std::size_t kMinPartitionsPerJob = 2;
+
+// Default head/tail split: zero-latency 256 head, 1024 and 4096 tail stages.
+const std::vector<std::size_t> kDefaultStageBlockSizes = {256, 1024, 4096};
 }  // namespace
 
+PartitionLayout PartitionLayout::FromBlockSizes(const std::vector<std::size_t>& blockSizes) {
+    PartitionLayout layout;
+    for (const std::size_t size : blockSizes) {
+        if (!IsPowerOfTwo(size) || (!layout.blockSizes.empty() && size <= layout.blockSizes.back())) {
+            continue;
+        }
+        layout.blockSizes.push_back(size);
+    }
+    if (layout.blockSizes.empty()) {
+        return layout;
+    }
+
+    // A stage with block B (ratio R = B / B0) finishes a chunk R - 1 base
+    // blocks after it was filled, and the chunk's first output sample lands at
+    // (offset - B) past the fill point. Spreading over R blocks therefore needs
+    // offset >= 2B - 2B0; earlier stages are extended in whole partitions to
+    // meet it.
+    const std::size_t base = layout.blockSizes.front();
+    layout.offsets.push_back(0);
+    for (std::size_t s = 1; s < layout.blockSizes.size(); ++s) {
+        const std::size_t prevOffset = layout.offsets.back();
+        const std::size_t prevBlock = layout.blockSizes[s - 1];
+        const std::size_t minOffset = 2 * layout.blockSizes[s] - 2 * base;
+        const std::size_t needed = minOffset > prevOffset ? minOffset - prevOffset : 0;
+        const std::size_t parts = std::max<std::size_t>(1, (needed + prevBlock - 1) / prevBlock);
+        layout.offsets.push_back(prevOffset + parts * prevBlock);
+    }
+    return layout;
+}
+
+bool PartitionLayout::valid() const {
+    if (blockSizes.empty() || offsets.size() != blockSizes.size() || offsets.front() != 0) {
+        return false;
+    }
+    const std::size_t base = blockSizes.front();
+    if (!IsPowerOfTwo(base)) {
+        return false;
+    }
+    for (std::size_t s = 1; s < blockSizes.size(); ++s) {
+        const std::size_t block = blockSizes[s];
+        if (!IsPowerOfTwo(block) || block <= blockSizes[s - 1] || offsets[s] <= offsets[s - 1] ||
+            (offsets[s] % base) != 0 || offsets[s] < 2 * block - 2 * base) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t PartitionLayout::partitionCount(std::size_t stage, std::size_t frames) const {
+    if (stage >= blockSizes.size()) {
+        return 0;
+    }
+    const std::size_t begin = std::min(offsets[stage], frames);
+    const std::size_t end =
+        (stage + 1 < offsets.size()) ? std::min(offsets[stage + 1], frames) : frames;
+    return (end - begin + blockSizes[stage] - 1) / blockSizes[stage];
+}
+
+StereoConvolutionKernel PartitionLayout::buildKernel(const float* left,
+                                                     const float* right,
+                                                     std::size_t frames,
+                                                     ParallelRun run,
+                                                     void* runner) const {
+    StereoConvolutionKernel kernel;
+    if (!left || frames == 0 || !valid()) {
+        return kernel;
+    }
+    kernel.isStereo = (right != nullptr);
+
+    struct Jobs {
+        const PartitionLayout* layout;
+        const float* irs[2];
+        std::size_t channels;
+        std::size_t frames;
+        std::vector<ConvolutionKernel> built;  // stage-major
+    };
+    Jobs jobs{this, {left, right}, right ? 2u : 1u, frames, {}};
+    jobs.built.resize(stageCount() * jobs.channels);
+    const ParallelJob buildStage = [](void* context, std::size_t job) {
+        auto& jobs = *static_cast<Jobs*>(context);
+        const PartitionLayout& layout = *jobs.layout;
+        // Highest job first is the last (largest) stage, so it starts first.
+        const std::size_t index = jobs.built.size() - 1 - job;
+        const std::size_t s = index / jobs.channels;
+        const float* ir = jobs.irs[index % jobs.channels];
+        const std::size_t begin = std::min(layout.offsets[s], jobs.frames);
+        const std::size_t end = (s + 1 < layout.offsets.size())
+                                    ? std::min(layout.offsets[s + 1], jobs.frames)
+                                    : jobs.frames;
+        if (begin >= end) {
+            return;
+        }
+        const std::vector<float> segment(ir + begin, ir + end);
+        jobs.built[index] = PartitionedConvolver::buildKernelFromIr(
+            segment, layout.blockSizes[s], 2 * layout.blockSizes[s]);
+    };
+    if (run) {
+        run(runner, buildStage, &jobs, jobs.built.size());
+    } else {
+        for (std::size_t job = 0; job < jobs.built.size(); ++job) {
+            buildStage(&jobs, job);
+        }
+    }
+
+    const auto stage = [&jobs](std::size_t s, std::size_t channel) -> ConvolutionKernel& {
+        return jobs.built[s * jobs.channels + channel];
+    };
+    kernel.left = std::move(stage(0, 0));
+    if (right) {
+        kernel.right = std::move(stage(0, 1));
+    }
+    for (std::size_t s = 1; s < blockSizes.size(); ++s) {
+        kernel.tailLeft.push_back(std::move(stage(s, 0)));
+        if (right) {
+            kernel.tailRight.push_back(std::move(stage(s, 1)));
+        }
+    }
+    return kernel;
+}
+
+void StereoDecorrelator::reset() {
+    mono_.fill(0.0f);
+    lp_ = 0.0f;
+}
+
+void StereoDecorrelator::saveState(StateWriter& out) const {
+    out.pod(mono_);
+    out.pod(lp_);
+}
+
+bool StereoDecorrelator::loadState(StateReader& in) {
+    in.pod(mono_);
+    in.pod(lp_);
+    if (!in.ok()) {
+        reset();
+    }
+    return in.ok();
+}
+
+void StereoDecorrelator::processBlock(const float* wetL, const float* wetR, bool enabled,
+                                      float* outL, float* outR, std::size_t frames) {
+    float* const mono = mono_.data() + kLongTap;
+    while (frames > 0) {
+        const std::size_t n = std::min(frames, kChunk);
+        for (std::size_t i = 0; i < n; ++i) {
+            mono[i] = 0.5f * (wetL[i] + wetR[i]);
+        }
+        // After this loop only the mono history is read, so the outputs may
+        // overwrite the inputs.
+        if (enabled) {
+            float lp = lp_;
+            for (std::size_t i = 0; i < n; ++i) {
+                lp = 0.25f * mono[i - kLongTap] + 0.75f * lp;
+                outR[i] = lp;
+            }
+            lp_ = lp;
+            for (std::size_t i = 0; i < n; ++i) {
+                outL[i] = mono[i];
+                outR[i] = 0.6f * mono[i - kShortTap] + 0.4f * outR[i];
+            }
+        } else {
+            float lp = lp_;
+            for (std::size_t i = 0; i < n; ++i) {
+                lp = 0.25f * mono[i - kLongTap] + 0.75f * lp;
+            }
+            lp_ = lp;
+            if (outL != wetL) {
+                std::copy(wetL, wetL + n, outL);
+            }
+            if (outR != wetR) {
+                std::copy(wetR, wetR + n, outR);
+            }
+        }
+        std::copy(mono + n - kLongTap, mono + n, mono_.begin());
+        wetL += n;
+        wetR += n;
+        outL += n;
+        outR += n;
+        frames -= n;
+    }
+}
+
+ConvolutionReverb::ConvolutionReverb()
+    : layout_(PartitionLayout::FromBlockSizes(kDefaultStageBlockSizes)) {
+    rebuildForCurrentKernels();
+}
+
+ConvolutionReverb::~ConvolutionReverb() {
+    delete publishedKernels_.exchange(nullptr, std::memory_order_acq_rel);
+    delete retiredKernels_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
 void ConvolutionReverb::setSampleRate(double sampleRate) {
     if (sampleRate <= 0.0) {
         return;
     }
     sampleRate_ = sampleRate;
     mixSmoothingAlpha_ = ComputeOnePoleAlpha(sampleRate_, 0.01);
-    // block size stays fixed for now; we may tune later.
+    rebuildForCurrentKernels();
+}
+
+void ConvolutionReverb::setPartitionLayout(PartitionLayout layout) {
+    if (!layout.valid()) {
+        return;
+    }
+    layout_ = std::move(layout);
     rebuildForCurrentKernels();
 }
 
 void ConvolutionReverb::setMix(float mix01) { targetMix_ = Clamp01(mix01); }
 
-void ConvolutionReverb::setIrKernels(std::vector<StereoConvolutionKernel> kernels) {
+void ConvolutionReverb::setIrKernels(std::vector<StereoConvolutionKernel> kernels,
+                                     std::size_t maxIrFrames) {
+    std::vector<SharedConvolutionKernel> shared;
+    shared.reserve(kernels.size());
+    for (auto& kernel : kernels) {
+        shared.push_back(std::make_shared<const StereoConvolutionKernel>(std::move(kernel)));
+    }
+    setIrKernels(std::move(shared), maxIrFrames);
+}
+
+void ConvolutionReverb::setIrKernels(std::vector<SharedConvolutionKernel> kernels,
+                                     std::size_t maxIrFrames) {
     kernels_ = std::move(kernels);
+    reservedIrFrames_ = maxIrFrames;
     if (kernels_.empty()) {
         irIndex_ = 0;
     } else {
@@ -48,6 +308,115 @@ void ConvolutionReverb::setIrKernels(std::vector<StereoConvolutionKernel> kernel
     rebuildForCurrentKernels();
 }
 
+bool ConvolutionReverb::hasIrKernel(int index) const {
+    if (index < 0 || index >= irCount()) {
+        return false;
+    }
+    const auto& k = irKernel(index);
+    return !k.left.empty() || !k.tailLeft.empty();
+}
+
+void ConvolutionReverb::setIrKernel(int index, SharedConvolutionKernel kernel) {
+    if (index < 0 || index >= irCount()) {
+        return;
+    }
+    kernels_[static_cast<std::size_t>(index)] = std::move(kernel);
+}
+
+void ConvolutionReverb::setIrKernel(int index, StereoConvolutionKernel kernel) {
+    setIrKernel(index, std::make_shared<const StereoConvolutionKernel>(std::move(kernel)));
+}
+
+std::vector<SharedConvolutionKernel> ConvolutionReverb::releaseIrKernels() {
+    std::vector<SharedConvolutionKernel> kernels = std::move(kernels_);
+    setIrKernels(std::vector<SharedConvolutionKernel>{});
+    return kernels;
+}
+
+void ConvolutionReverb::publishIrKernels(std::vector<SharedConvolutionKernel> kernels,
+                                         std::size_t maxIrFrames) {
+    auto* set = new KernelSet{std::move(kernels), maxIrFrames};
+    delete publishedKernels_.exchange(set, std::memory_order_acq_rel);
+}
+
+bool ConvolutionReverb::adoptPublishedIrKernels() {
+    if (!publishedKernels_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    KernelSet* set = publishedKernels_.exchange(nullptr, std::memory_order_acq_rel);
+    if (!set) {
+        return false;
+    }
+    if (stagesFit(*set)) {
+        // Only a change to the IRs being heard restarts the tail.
+        const auto changed = [&](int index) {
+            return index >= 0 && (static_cast<std::size_t>(index) >= set->kernels.size() ||
+                                  set->kernels[static_cast<std::size_t>(index)] !=
+                                      kernels_[static_cast<std::size_t>(index)]);
+        };
+        const bool restart = kernels_.empty() || set->kernels.empty() || changed(irIndex_) ||
+                             changed(pendingIrIndex_) || changed(queuedIrIndex_);
+        kernels_.swap(set->kernels);
+        reservedIrFrames_ = std::max(reservedIrFrames_, set->maxIrFrames);
+        if (restart) {
+            irIndex_ = kernels_.empty()
+                           ? 0
+                           : std::clamp(irIndex_, 0, static_cast<int>(kernels_.size() - 1));
+            reset();
+        }
+    } else {
+        std::vector<SharedConvolutionKernel> incoming = std::move(set->kernels);
+        set->kernels = std::move(kernels_);
+        setIrKernels(std::move(incoming), set->maxIrFrames);
+    }
+    delete retiredKernels_.exchange(set, std::memory_order_acq_rel);
+    return true;
+}
+
+void ConvolutionReverb::releaseRetiredIrKernels() {
+    delete retiredKernels_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+bool ConvolutionReverb::stagesFit(const KernelSet& set) const {
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        const std::size_t capacity = stages_[s].convolver.maxPartitions();
+        if (layout_.partitionCount(s, set.maxIrFrames) > capacity) {
+            return false;
+        }
+        for (const auto& k : set.kernels) {
+            for (const bool right : {false, true}) {
+                const auto* kernel = k ? StageKernel(*k, s, right) : nullptr;
+                if (kernel && kernel->partitionCount > capacity) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+const StereoConvolutionKernel& ConvolutionReverb::irKernel(int index) const {
+    static const StereoConvolutionKernel kEmpty;
+    const auto& kernel = kernels_[static_cast<std::size_t>(index)];
+    return kernel ? *kernel : kEmpty;
+}
+
+void ConvolutionReverb::setParallelism(std::size_t jobs, ParallelRun run, void* runner) {
+    parallelJobs_ = std::max<std::size_t>(1, jobs);
+    parallelRun_ = parallelJobs_ > 1 ? run : nullptr;
+    parallelRunner_ = parallelRun_ ? runner : nullptr;
+    rebuildForCurrentKernels();
+}
+
+void ConvolutionReverb::setCrossfadeMode(IrCrossfade mode) {
+    if (mode == crossfadeMode_) {
+        return;
+    }
+    crossfadeMode_ = mode;
+    pendingIrIndex_ = -1;
+    rebuildForCurrentKernels();
+}
+
 void ConvolutionReverb::setIrIndex(int index) {
     if (kernels_.empty()) {
         irIndex_ = 0;
@@ -56,93 +425,173 @@ void ConvolutionReverb::setIrIndex(int index) {
         return;
     }
     index = std::clamp(index, 0, static_cast<int>(kernels_.size() - 1));
+    if (crossfadeMode_ == IrCrossfade::RingOut) {
+        if (!ringingOut_) {
+            if (index != irIndex_) {
+                beginRingOut(index);
+            }
+        } else if (index != pendingIrIndex_) {
+            queuedIrIndex_ = index;
+        } else if (fadeSamplePos_ == 0) {
+            queuedIrIndex_ = -1;  // back to the IR already ringing in
+        }
+        return;
+    }
     if (index == irIndex_) {
         return;
     }
     pendingIrIndex_ = index;
     fadeSamplePos_ = 0;
-    std::fill(overlapBL_.begin(), overlapBL_.end(), 0.0f);
-    std::fill(overlapBR_.begin(), overlapBR_.end(), 0.0f);
-    std::fill(overlapLateBL_.begin(), overlapLateBL_.end(), 0.0f);
-    std::fill(overlapLateBR_.begin(), overlapLateBR_.end(), 0.0f);
-    std::fill(scheduledBL_.begin(), scheduledBL_.end(), 0.0f);
-    std::fill(scheduledBR_.begin(), scheduledBR_.end(), 0.0f);
+    std::fill(scheduled_[kPathBL].begin(), scheduled_[kPathBL].end(), 0.0f);
+    std::fill(scheduled_[kPathBR].begin(), scheduled_[kPathBR].end(), 0.0f);
+
+    // Chunks already in flight catch up on the slices they have run so far,
+    // so the target IR's tail is complete when they finish.
+    const auto& b = irKernel(pendingIrIndex_);
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        auto& stage = stages_[s];
+        for (const Path path : {kPathBL, kPathBR}) {
+            std::fill(stage.overlap[path].begin(), stage.overlap[path].end(), 0.0f);
+            stage.acc[path].clear();
+        }
+        if (stage.phase + 1 < stage.blocksPerChunk) {
+            accumulateSlices(s, b, kPathBL, 0, stage.phase + 1);
+        }
+    }
 }
 
 void ConvolutionReverb::reset() {
-    convolverEarly_.reset();
-    convolverLate_.reset();
-    std::fill(inBlock_.begin(), inBlock_.end(), 0.0f);
-    std::fill(wetBlockAL_.begin(), wetBlockAL_.end(), 0.0f);
-    std::fill(wetBlockAR_.begin(), wetBlockAR_.end(), 0.0f);
-    std::fill(wetBlockBL_.begin(), wetBlockBL_.end(), 0.0f);
-    std::fill(wetBlockBR_.begin(), wetBlockBR_.end(), 0.0f);
-    std::fill(lateInBlock_.begin(), lateInBlock_.end(), 0.0f);
-    std::fill(lateOutAL_.begin(), lateOutAL_.end(), 0.0f);
-    std::fill(lateOutAR_.begin(), lateOutAR_.end(), 0.0f);
-    std::fill(lateOutBL_.begin(), lateOutBL_.end(), 0.0f);
-    std::fill(lateOutBR_.begin(), lateOutBR_.end(), 0.0f);
-    std::fill(scheduledAL_.begin(), scheduledAL_.end(), 0.0f);
-    std::fill(scheduledAR_.begin(), scheduledAR_.end(), 0.0f);
-    std::fill(scheduledBL_.begin(), scheduledBL_.end(), 0.0f);
-    std::fill(scheduledBR_.begin(), scheduledBR_.end(), 0.0f);
+    for (auto& stage : stages_) {
+        stage.convolver.reset();
+        stage.ringOut.reset();
+        for (std::size_t p = 0; p < kPathCount; ++p) {
+            stage.acc[p].clear();
+        }
+        stage.inputPos = 0;
+        stage.phase = stage.blocksPerChunk;
+        stage.chunkBlock = 0;
+    }
+    arena_.zero();  // inputs, overlaps, outputs and the schedule rings
     inPos_ = 0;
     outPos_ = 0;
     wetReady_ = false;
     pendingIrIndex_ = -1;
     fadeSamplePos_ = 0;
-    lateInPos_ = 0;
+    ringingOut_ = false;
+    queuedIrIndex_ = -1;
+    ringOutQuietBlocks_ = 0;
     blockIndex_ = 0;
+    quietBlocks_ = 0;
 
     currentMix_ = targetMix_;
-    std::fill(overlapAL_.begin(), overlapAL_.end(), 0.0f);
-    std::fill(overlapAR_.begin(), overlapAR_.end(), 0.0f);
-    std::fill(overlapBL_.begin(), overlapBL_.end(), 0.0f);
-    std::fill(overlapBR_.begin(), overlapBR_.end(), 0.0f);
-    std::fill(overlapLateAL_.begin(), overlapLateAL_.end(), 0.0f);
-    std::fill(overlapLateAR_.begin(), overlapLateAR_.end(), 0.0f);
-    std::fill(overlapLateBL_.begin(), overlapLateBL_.end(), 0.0f);
-    std::fill(overlapLateBR_.begin(), overlapLateBR_.end(), 0.0f);
 
-    stereoDelay_.fill(0.0f);
-    stereoPos_ = 0;
-    stereoLp_ = 0.0f;
+    decorrelator_.reset();
+}
+
+void ConvolutionReverb::saveState(StateWriter& out) const {
+    out.pod(blockSize_);
+    out.pod(stages_.size());
+    for (const Stage& stage : stages_) {
+        stage.convolver.saveState(out);
+        stage.ringOut.saveState(out);
+        SaveBuffer(out, stage.input);
+        SaveBuffer(out, stage.ringOutInput);
+        out.pod(stage.inputPos);
+        out.pod(stage.phase);
+        out.pod(stage.chunkBlock);
+        for (std::size_t p = 0; p < kPathCount; ++p) {
+            SaveSpectrum(out, stage.acc[p]);
+            SaveBuffer(out, stage.overlap[p]);
+        }
+    }
+    for (const auto block : {inBlock_, wetBlockAL_, wetBlockAR_, wetBlockBL_, wetBlockBR_}) {
+        SaveBuffer(out, block);
+    }
+    for (const auto ring : scheduled_) {
+        SaveBuffer(out, ring);
+    }
+    out.pod(irIndex_);
+    out.pod(pendingIrIndex_);
+    out.pod(fadeSamplePos_);
+    out.pod(ringingOut_);
+    out.pod(queuedIrIndex_);
+    out.pod(ringOutQuietBlocks_);
+    out.pod(blockIndex_);
+    out.pod(inPos_);
+    out.pod(outPos_);
+    out.pod(wetReady_);
+    out.pod(quietBlocks_);
+    out.pod(currentMix_);
+    decorrelator_.saveState(out);
+}
+
+bool ConvolutionReverb::loadState(StateReader& in) {
+    std::size_t blockSize = 0;
+    std::size_t stages = 0;
+    if (in.pod(blockSize) && blockSize != blockSize_) {
+        in.fail();
+    }
+    if (in.pod(stages) && stages != stages_.size()) {
+        in.fail();
+    }
+    for (std::size_t s = 0; s < stages_.size() && in.ok(); ++s) {
+        Stage& stage = stages_[s];
+        stage.convolver.loadState(in);
+        stage.ringOut.loadState(in);
+        LoadBuffer(in, stage.input);
+        LoadBuffer(in, stage.ringOutInput);
+        in.pod(stage.inputPos);
+        in.pod(stage.phase);
+        in.pod(stage.chunkBlock);
+        if (stage.inputPos >= stage.blockSize || stage.phase > stage.blocksPerChunk) {
+            in.fail();
+        }
+        for (std::size_t p = 0; p < kPathCount; ++p) {
+            LoadSpectrum(in, stage.acc[p]);
+            LoadBuffer(in, stage.overlap[p]);
+        }
+    }
+    for (const auto block : {inBlock_, wetBlockAL_, wetBlockAR_, wetBlockBL_, wetBlockBR_}) {
+        LoadBuffer(in, block);
+    }
+    for (const auto ring : scheduled_) {
+        LoadBuffer(in, ring);
+    }
+    in.pod(irIndex_);
+    in.pod(pendingIrIndex_);
+    in.pod(fadeSamplePos_);
+    in.pod(ringingOut_);
+    in.pod(queuedIrIndex_);
+    in.pod(ringOutQuietBlocks_);
+    in.pod(blockIndex_);
+    in.pod(inPos_);
+    in.pod(outPos_);
+    in.pod(wetReady_);
+    in.pod(quietBlocks_);
+    in.pod(currentMix_);
+    decorrelator_.loadState(in);
+    const auto inRange = [this](int index) { return index >= -1 && index < irCount(); };
+    if (in.ok() && (irIndex_ < 0 || irIndex_ >= std::max(1, irCount()) ||
+                    !inRange(pendingIrIndex_) || !inRange(queuedIrIndex_) ||
+                    inPos_ > blockSize_ || outPos_ > blockSize_)) {
+        in.fail();
+    }
+    if (!in.ok()) {
+        irIndex_ = std::clamp(irIndex_, 0, std::max(0, irCount() - 1));
+        reset();
+    }
+    return in.ok();
 }
 
 void ConvolutionReverb::processSample(float input, float& outL, float& outR) {
     const float dry = input;
     currentMix_ += (targetMix_ - currentMix_) * mixSmoothingAlpha_;
 
-    float wetLBase = 0.0f;
-    float wetRBase = 0.0f;
+    float wetL = 0.0f;
+    float wetR = 0.0f;
     if (wetReady_ && outPos_ < blockSize_) {
-        wetLBase = wetBlockAL_[outPos_];
-        wetRBase = wetBlockAR_[outPos_];
-    }
-    wetLBase *= wetLevel_;
-    wetRBase *= wetLevel_;
-
-    float wetL = wetLBase;
-    float wetR = wetRBase;
-    const bool useDecorrelation =
-        (!kernels_.empty() && pendingIrIndex_ < 0 && !kernels_[static_cast<std::size_t>(irIndex_)].isStereo);
-    {
-        // Keep decorrelator state in sync even when bypassed (prevents jumps when
-        // switching between mono and stereo IRs).
-        const float wetMono = 0.5f * (wetLBase + wetRBase);
-        stereoDelay_[stereoPos_] = wetMono;
-        const std::size_t size = stereoDelay_.size();
-        const auto tap = [&](std::size_t delaySamples) -> float {
-            return stereoDelay_[(stereoPos_ + size - (delaySamples % size)) % size];
-        };
-        const float tapShort = tap(7);
-        const float tapLong = tap(19);
-        stereoLp_ = 0.25f * tapLong + 0.75f * stereoLp_;
-        if (useDecorrelation) {
-            wetL = wetMono;
-            wetR = 0.6f * tapShort + 0.4f * stereoLp_;
-        }
-        stereoPos_ = (stereoPos_ + 1) % size;
+        wetL = wetBlockAL_[outPos_];
+        wetR = wetBlockAR_[outPos_];
     }
 
     outL = dry * (1.0f - currentMix_) + wetL * currentMix_;
@@ -157,6 +606,7 @@ void ConvolutionReverb::processSample(float input, float& outL, float& outR) {
 
     if (inPos_ >= blockSize_) {
         processBlock();
+        finishWetBlock(wetBlockAL_.data(), wetBlockAR_.data());
         inPos_ = 0;
         outPos_ = 0;
         wetReady_ = true;
@@ -176,208 +626,386 @@ void ConvolutionReverb::processBlockWet(const float* input,
     }
 
     std::copy(input, input + blockSize_, inBlock_.begin());
-    processBlock();  // fills wetBlockA* for this block (early+late+xfade), advances blockIndex_
+    processBlock();  // fills wetBlockA* for this block (all stages + xfade), advances blockIndex_
 
-    const bool useDecorrelation =
-        (!kernels_.empty() && pendingIrIndex_ < 0 &&
-         !kernels_[static_cast<std::size_t>(irIndex_)].isStereo);
+    finishWetBlock(outWetL, outWetR);
+}
 
+void ConvolutionReverb::finishWetBlock(float* outL, float* outR) {
     for (std::size_t i = 0; i < blockSize_; ++i) {
-        float wetLBase = wetBlockAL_[i] * wetLevel_;
-        float wetRBase = wetBlockAR_[i] * wetLevel_;
-
-        float wetL = wetLBase;
-        float wetR = wetRBase;
-        {
-            // Keep decorrelator state in sync even when bypassed.
-            const float wetMono = 0.5f * (wetLBase + wetRBase);
-            stereoDelay_[stereoPos_] = wetMono;
-            const std::size_t size = stereoDelay_.size();
-            const auto tap = [&](std::size_t delaySamples) -> float {
-                return stereoDelay_[(stereoPos_ + size - (delaySamples % size)) % size];
-            };
-            const float tapShort = tap(7);
-            const float tapLong = tap(19);
-            stereoLp_ = 0.25f * tapLong + 0.75f * stereoLp_;
-            if (useDecorrelation) {
-                wetL = wetMono;
-                wetR = 0.6f * tapShort + 0.4f * stereoLp_;
+        outL[i] = wetBlockAL_[i] * kWetLevel;
+        outR[i] = wetBlockAR_[i] * kWetLevel;
+    }
+    decorrelator_.processBlock(outL, outR, useDecorrelation(), outL, outR, blockSize_);
+}
+
+bool ConvolutionReverb::useDecorrelation() const {
+    return decorrelationEnabled_ && !kernels_.empty() && pendingIrIndex_ < 0 &&
+           !irKernel(irIndex_).isStereo;
+}
+
+void ConvolutionReverb::rebuildForCurrentKernels() {
+    blockSize_ = layout_.baseBlockSize();
+    stages_.assign(layout_.stageCount(), Stage{});
+    std::size_t scheduleBlocks = 2;
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        auto& stage = stages_[s];
+        stage.blockSize = layout_.blockSizes[s];
+        stage.blocksPerChunk = stage.blockSize / blockSize_;
+        stage.leadBlocks = layout_.offsets[s] / blockSize_;
+
+        // Max partitions may vary per IR; pick the maximum per stage.
+        std::size_t maxParts = std::max<std::size_t>(1, layout_.partitionCount(s, reservedIrFrames_));
+        for (const auto& k : kernels_) {
+            for (const bool right : {false, true}) {
+                if (const auto* kernel = k ? StageKernel(*k, s, right) : nullptr) {
+                    maxParts = std::max(maxParts, kernel->partitionCount);
+                }
+            }
+        }
+        stage.convolver.configure(stage.blockSize, 2 * stage.blockSize, maxParts);
+        if (crossfadeMode_ == IrCrossfade::RingOut) {
+            stage.ringOut.configure(stage.blockSize, 2 * stage.blockSize, maxParts);
+        }
+        for (std::size_t p = 0; p < kPathCount; ++p) {
+            stage.acc[p].assign(stage.convolver.binStride());
+        }
+        if (parallelRun_ && s > 0) {
+            stage.partials.resize(kPathCount * (parallelJobs_ - 1));
+            for (auto& partial : stage.partials) {
+                partial.assign(stage.convolver.binStride());
             }
-            stereoPos_ = (stereoPos_ + 1) % size;
         }
 
-        outWetL[i] = wetL;
-        outWetR[i] = wetR;
+        // Output reaches up to leadBlocks - blocksPerChunk + 1 blocks ahead of
+        // the block that finishes the chunk.
+        scheduleBlocks = std::max(scheduleBlocks, stage.leadBlocks + 2 - stage.blocksPerChunk);
+    }
+    jobs_.clear();
+    if (parallelRun_) {
+        jobs_.reserve(stages_.size() * kPathCount * parallelJobs_);
     }
+    scheduleBlocks = NextPowerOfTwo(scheduleBlocks);
+    scheduleMask_ = scheduleBlocks - 1;
+    arena_.release();
+    carveBuffers(scheduleBlocks);  // counts
+    arena_.allocate(arena_.used());
+    carveBuffers(scheduleBlocks);
+    reset();
 }
 
-void ConvolutionReverb::rebuildForCurrentKernels() {
-    static_assert(kLateBlocksPerChunk * 256 == kLateBlockSize,
-                  "Late block size must be an integer multiple of the early block size");
-    static_assert(kLateStartBlocks == kLateBlocksPerChunk,
-                  "Late start blocks assumes tail begins after one late chunk");
-    static_assert((kScheduleBlocks & (kScheduleBlocks - 1)) == 0,
-                  "Schedule ring must be power-of-two");
-
-    inBlock_.assign(blockSize_, 0.0f);
-    wetBlockAL_.assign(blockSize_, 0.0f);
-    wetBlockAR_.assign(blockSize_, 0.0f);
-    wetBlockBL_.assign(blockSize_, 0.0f);
-    wetBlockBR_.assign(blockSize_, 0.0f);
-    overlapAL_.assign(blockSize_, 0.0f);
-    overlapAR_.assign(blockSize_, 0.0f);
-    overlapBL_.assign(blockSize_, 0.0f);
-    overlapBR_.assign(blockSize_, 0.0f);
-    overlapLateAL_.assign(kLateBlockSize, 0.0f);
-    overlapLateAR_.assign(kLateBlockSize, 0.0f);
-    overlapLateBL_.assign(kLateBlockSize, 0.0f);
-    overlapLateBR_.assign(kLateBlockSize, 0.0f);
-
-    lateInBlock_.assign(kLateBlockSize, 0.0f);
-    lateOutAL_.assign(kLateBlockSize, 0.0f);
-    lateOutAR_.assign(kLateBlockSize, 0.0f);
-    lateOutBL_.assign(kLateBlockSize, 0.0f);
-    lateOutBR_.assign(kLateBlockSize, 0.0f);
-
-    scheduledAL_.assign(kScheduleBlocks * blockSize_, 0.0f);
-    scheduledAR_.assign(kScheduleBlocks * blockSize_, 0.0f);
-    scheduledBL_.assign(kScheduleBlocks * blockSize_, 0.0f);
-    scheduledBR_.assign(kScheduleBlocks * blockSize_, 0.0f);
-
-    // Max partitions may vary per IR; pick the maximum per stage.
-    std::size_t maxPartsEarly = 1;
-    std::size_t maxPartsLate = 1;
-    for (const auto& k : kernels_) {
-        maxPartsEarly = std::max(maxPartsEarly, k.left.partitions.size());
-        if (k.isStereo) {
-            maxPartsEarly = std::max(maxPartsEarly, k.right.partitions.size());
-        }
-        if (k.hasLate) {
-            maxPartsLate = std::max(maxPartsLate, k.leftLate.partitions.size());
-            if (k.isStereo) {
-                maxPartsLate = std::max(maxPartsLate, k.rightLate.partitions.size());
+void ConvolutionReverb::carveBuffers(std::size_t scheduleBlocks) {
+    inBlock_ = arena_.take(blockSize_);
+    wetBlockAL_ = arena_.take(blockSize_);
+    wetBlockAR_ = arena_.take(blockSize_);
+    wetBlockBL_ = arena_.take(blockSize_);
+    wetBlockBR_ = arena_.take(blockSize_);
+    for (auto& stage : stages_) {
+        stage.input = arena_.take(stage.blockSize);
+        stage.ringOutInput =
+            arena_.take(crossfadeMode_ == IrCrossfade::RingOut ? stage.blockSize : 0);
+        stage.out = arena_.take(stage.blockSize);
+        for (auto& overlap : stage.overlap) {
+            overlap = arena_.take(stage.blockSize);
+        }
+    }
+    for (auto& ring : scheduled_) {
+        ring = arena_.take(scheduleBlocks * blockSize_);
+    }
+}
+
+const ConvolutionKernel* ConvolutionReverb::StageKernel(const StereoConvolutionKernel& kernels,
+                                                        std::size_t stage,
+                                                        bool right) {
+    const ConvolutionKernel* kernel = nullptr;
+    if (stage == 0) {
+        kernel = right ? &kernels.right : &kernels.left;
+    } else {
+        const auto& tail = right ? kernels.tailRight : kernels.tailLeft;
+        if (stage - 1 < tail.size()) {
+            kernel = &tail[stage - 1];
+        }
+    }
+    if (right && !kernels.isStereo) {
+        return nullptr;
+    }
+    return (kernel && !kernel->empty()) ? kernel : nullptr;
+}
+
+void ConvolutionReverb::accumulateSlices(std::size_t stageIndex,
+                                         const StereoConvolutionKernel& kernels,
+                                         Path left,
+                                         std::size_t firstSlice,
+                                         std::size_t endSlice) {
+    auto& stage = stages_[stageIndex];
+    const std::size_t slices = stage.blocksPerChunk;
+    PartitionedConvolver& convolver = pathConvolver(stage, left);
+    const auto* kernelL = StageKernel(kernels, stageIndex, false);
+    const auto* kernelR = StageKernel(kernels, stageIndex, true);
+    if (kernelL && kernelR && kernelL->partitionCount == kernelR->partitionCount) {
+        // True stereo: one pass over the history feeds both channels.
+        const std::size_t parts = kernelL->partitionCount;
+        convolver.accumulateStereo(*kernelL, *kernelR, stage.acc[left], stage.acc[left + 1],
+                                   firstSlice * parts / slices, endSlice * parts / slices);
+        return;
+    }
+    for (const bool right : {false, true}) {
+        const auto* kernel = right ? kernelR : kernelL;
+        if (!kernel) {
+            continue;
+        }
+        // Slice k covers partitions [k * P / R, (k + 1) * P / R).
+        const std::size_t parts = kernel->partitionCount;
+        convolver.accumulate(*kernel, stage.acc[left + (right ? 1 : 0)],
+                             firstSlice * parts / slices, endSlice * parts / slices);
+    }
+}
+
+void ConvolutionReverb::schedule(Path path,
+                                 const float* src,
+                                 std::uint64_t firstBlock,
+                                 std::size_t blocks) {
+    auto& ring = scheduled_[path];
+    for (std::size_t b = 0; b < blocks; ++b) {
+        const std::size_t slot = static_cast<std::size_t>((firstBlock + b) & scheduleMask_);
+        AddInPlace(src + b * blockSize_, &ring[slot * blockSize_], blockSize_);
+    }
+}
+
+void ConvolutionReverb::advanceStage(std::size_t stageIndex) {
+    auto& stage = stages_[stageIndex];
+    std::copy(inBlock_.begin(), inBlock_.end(),
+              stage.input.begin() + static_cast<std::ptrdiff_t>(stage.inputPos));
+    if (ringingOut_) {
+        Clear(stage.ringOutInput.data() + stage.inputPos, blockSize_);
+    }
+    stage.inputPos += blockSize_;
+    if (stage.inputPos >= stage.blockSize) {
+        stage.convolver.pushInputBlock(stage.input.data());
+        if (ringingOut_) {
+            // Silence still has to age the old history through its partitions.
+            stage.ringOut.pushInputBlock(stage.ringOutInput.data());
+        }
+        stage.inputPos = 0;
+        stage.phase = 0;
+        stage.chunkBlock = blockIndex_;
+    } else if (stage.phase < stage.blocksPerChunk) {
+        ++stage.phase;
+    }
+}
+
+// One slice of the multiply-accumulate per base block and busy stage.
+void ConvolutionReverb::accumulateDueSlices(const StereoConvolutionKernel& a,
+                                            const StereoConvolutionKernel* b) {
+    if (!parallelRun_) {
+        for (std::size_t s = 0; s < stages_.size(); ++s) {
+            const std::size_t phase = stages_[s].phase;
+            if (phase >= stages_[s].blocksPerChunk) {
+                continue;
+            }
+            accumulateSlices(s, a, kPathAL, phase, phase + 1);
+            if (b) {
+                accumulateSlices(s, *b, kPathBL, phase, phase + 1);
             }
         }
+        return;
+    }
+
+    jobs_.clear();
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        if (stages_[s].phase >= stages_[s].blocksPerChunk) {
+            continue;
+        }
+        queueSlice(s, a, kPathAL);
+        if (b) {
+            queueSlice(s, *b, kPathBL);
+        }
+    }
+    if (jobs_.empty()) {
+        return;
+    }
+    parallelRun_(parallelRunner_, &RunAccumulateJob, this, jobs_.size());
+    const auto addPartial = [](SplitComplex* partial, SplitComplex* target) {
+        if (!target) {
+            return;
+        }
+        AddInPlace(partial->re.data(), target->re.data(), partial->size());
+        AddInPlace(partial->im.data(), target->im.data(), partial->size());
+        partial->clear();
+    };
+    for (const auto& job : jobs_) {
+        addPartial(job.acc, job.target);
+        addPartial(job.accRight, job.targetRight);
     }
-    convolverEarly_.configure(blockSize_, fftSize_, maxPartsEarly);
-    convolverLate_.configure(kLateBlockSize, kLateFftSize, maxPartsLate);
-    reset();
 }
 
-void ConvolutionReverb::processBlock() {
-    convolverEarly_.pushInputBlock(inBlock_.data());
+// Splits this block's slice of `kernels` on stage `stageIndex` into
+// contiguous ranges; the head stage stays whole.
+void ConvolutionReverb::queueSlice(std::size_t stageIndex,
+                                   const StereoConvolutionKernel& kernels,
+                                   Path left) {
+    auto& stage = stages_[stageIndex];
+    const std::size_t slices = stage.blocksPerChunk;
+    const PartitionedConvolver& convolver = pathConvolver(stage, left);
+    const auto* kernelL = StageKernel(kernels, stageIndex, false);
+    const auto* kernelR = StageKernel(kernels, stageIndex, true);
+    const bool stereo =
+        kernelL && kernelR && kernelL->partitionCount == kernelR->partitionCount;
+    for (const bool right : {false, true}) {
+        const auto* kernel = right ? kernelR : kernelL;
+        if (!kernel || (right && stereo)) {
+            continue;
+        }
+        const Path path = static_cast<Path>(left + (right ? 1 : 0));
+        const std::size_t parts = kernel->partitionCount;
+        const std::size_t first = stage.phase * parts / slices;
+        const std::size_t count = (stage.phase + 1) * parts / slices - first;
+        if (count == 0) {
+            continue;
+        }
+        const std::size_t ranges =
+            stage.partials.empty()
+                ? 1
+                : std::clamp<std::size_t>(count / kMinPartitionsPerJob, 1, parallelJobs_);
+        for (std::size_t r = 0; r < ranges; ++r) {
+            AccumulateJob job;
+            job.convolver = &convolver;
+            job.kernel = kernel;
+            job.firstPartition = first + count * r / ranges;
+            job.endPartition = first + count * (r + 1) / ranges;
+            const auto accFor = [&](Path p) {
+                return r == 0 ? &stage.acc[p]
+                              : &stage.partials[p * (parallelJobs_ - 1) + r - 1];
+            };
+            job.acc = accFor(path);
+            job.target = r == 0 ? nullptr : &stage.acc[path];
+            if (stereo) {
+                // The range carries both channels through the stereo kernel.
+                const Path pathR = static_cast<Path>(path + 1);
+                job.kernelRight = kernelR;
+                job.accRight = accFor(pathR);
+                job.targetRight = r == 0 ? nullptr : &stage.acc[pathR];
+            }
+            jobs_.push_back(job);
+        }
+    }
+}
 
-    const std::size_t scheduleMask = kScheduleBlocks - 1;
-    const std::size_t scheduleSlot =
-        static_cast<std::size_t>(blockIndex_ & scheduleMask);
+void ConvolutionReverb::RunAccumulateJob(void* context, std::size_t job) {
+    const auto& j = static_cast<ConvolutionReverb*>(context)->jobs_[job];
+    if (j.kernelRight) {
+        j.convolver->accumulateStereo(*j.kernel, *j.kernelRight, *j.acc, *j.accRight,
+                                      j.firstPartition, j.endPartition);
+    } else {
+        j.convolver->accumulate(*j.kernel, *j.acc, j.firstPartition, j.endPartition);
+    }
+}
+
+// Last slice: inverse transform and schedule the chunk's output, which
+// starts offset - blockSize samples after the chunk was filled.
+void ConvolutionReverb::finishStage(std::size_t stageIndex,
+                                    const StereoConvolutionKernel& a,
+                                    const StereoConvolutionKernel* b) {
+    auto& stage = stages_[stageIndex];
+    const std::uint64_t firstBlock =
+        stage.chunkBlock + 1 + stage.leadBlocks - stage.blocksPerChunk;
+    const auto finishPaths = [&](const StereoConvolutionKernel& kernels, Path left) {
+        const Path right = static_cast<Path>(left + 1);
+        if (!StageKernel(kernels, stageIndex, false)) {
+            return;
+        }
+        PartitionedConvolver& convolver = pathConvolver(stage, left);
+        convolver.finish(stage.acc[left], stage.out.data(), stage.overlap[left].data());
+        schedule(left, stage.out.data(), firstBlock, stage.blocksPerChunk);
+        if (!kernels.isStereo) {
+            // Mono IR: both channels share the left result.
+            schedule(right, stage.out.data(), firstBlock, stage.blocksPerChunk);
+        } else if (StageKernel(kernels, stageIndex, true)) {
+            convolver.finish(stage.acc[right], stage.out.data(), stage.overlap[right].data());
+            schedule(right, stage.out.data(), firstBlock, stage.blocksPerChunk);
+        }
+    };
+    finishPaths(a, kPathAL);
+    if (b) {
+        finishPaths(*b, kPathBL);
+    }
+}
+
+void ConvolutionReverb::processBlock() {
+    adoptPublishedIrKernels();
+    const std::size_t scheduleSlot = static_cast<std::size_t>(blockIndex_ & scheduleMask_);
     const std::size_t scheduleOffset = scheduleSlot * blockSize_;
 
     if (kernels_.empty()) {
         std::fill(wetBlockAL_.begin(), wetBlockAL_.end(), 0.0f);
         std::fill(wetBlockAR_.begin(), wetBlockAR_.end(), 0.0f);
-        Clear(&scheduledAL_[scheduleOffset], blockSize_);
-        Clear(&scheduledAR_[scheduleOffset], blockSize_);
-        Clear(&scheduledBL_[scheduleOffset], blockSize_);
-        Clear(&scheduledBR_[scheduleOffset], blockSize_);
+        for (auto& ring : scheduled_) {
+            Clear(&ring[scheduleOffset], blockSize_);
+        }
         ++blockIndex_;
         return;
     }
 
-    const auto& a = kernels_[static_cast<std::size_t>(irIndex_)];
-    convolverEarly_.convolveWithOverlap(a.left, wetBlockAL_.data(), overlapAL_);
-    if (a.isStereo) {
-        convolverEarly_.convolveWithOverlap(a.right, wetBlockAR_.data(), overlapAR_);
-    } else {
-        std::copy(wetBlockAL_.begin(), wetBlockAL_.end(), wetBlockAR_.begin());
+    const bool silentInput = IsSilent(inBlock_.data(), blockSize_);
+    if (silentInput && idle() && pendingIrIndex_ < 0) {
+        idleBlock();
+        return;
     }
 
-    // Add scheduled late-tail contributions for this output block.
-    AddInPlace(&scheduledAL_[scheduleOffset], wetBlockAL_.data(), blockSize_);
-    AddInPlace(&scheduledAR_[scheduleOffset], wetBlockAR_.data(), blockSize_);
-    Clear(&scheduledAL_[scheduleOffset], blockSize_);
-    Clear(&scheduledAR_[scheduleOffset], blockSize_);
-
-    if (pendingIrIndex_ >= 0) {
-        const auto& b = kernels_[static_cast<std::size_t>(pendingIrIndex_)];
-        convolverEarly_.convolveWithOverlap(b.left, wetBlockBL_.data(), overlapBL_);
-        if (b.isStereo) {
-            convolverEarly_.convolveWithOverlap(b.right, wetBlockBR_.data(), overlapBR_);
-        } else {
-            std::copy(wetBlockBL_.begin(), wetBlockBL_.end(), wetBlockBR_.begin());
+    const auto& a = irKernel(irIndex_);
+    const StereoConvolutionKernel* b = pendingIrIndex_ >= 0 ? &irKernel(pendingIrIndex_) : nullptr;
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        advanceStage(s);
+    }
+    accumulateDueSlices(a, b);
+    for (std::size_t s = 0; s < stages_.size(); ++s) {
+        if (stages_[s].phase + 1 == stages_[s].blocksPerChunk) {
+            finishStage(s, a, b);
         }
+    }
+    quietBlocks_ = silentInput && stagesQuiet() ? quietBlocks_ + 1 : 0;
 
-        AddInPlace(&scheduledBL_[scheduleOffset], wetBlockBL_.data(), blockSize_);
-        AddInPlace(&scheduledBR_[scheduleOffset], wetBlockBR_.data(), blockSize_);
-        Clear(&scheduledBL_[scheduleOffset], blockSize_);
-        Clear(&scheduledBR_[scheduleOffset], blockSize_);
-    } else {
-        Clear(&scheduledBL_[scheduleOffset], blockSize_);
-        Clear(&scheduledBR_[scheduleOffset], blockSize_);
-    }
-
-    // Late-stage input accumulation (every 8 blocks => 2048 samples).
-    if (lateInBlock_.size() == kLateBlockSize && lateInPos_ + blockSize_ <= kLateBlockSize) {
-        std::copy(inBlock_.begin(), inBlock_.end(),
-                  lateInBlock_.begin() + static_cast<std::ptrdiff_t>(lateInPos_));
-        lateInPos_ += blockSize_;
-        if (lateInPos_ >= kLateBlockSize) {
-            convolverLate_.pushInputBlock(lateInBlock_.data());
-
-            // Convolve and schedule for A.
-            if (a.hasLate && !a.leftLate.partitions.empty()) {
-                convolverLate_.convolveWithOverlap(a.leftLate, lateOutAL_.data(), overlapLateAL_);
-                if (a.isStereo) {
-                    convolverLate_.convolveWithOverlap(a.rightLate, lateOutAR_.data(), overlapLateAR_);
-                } else {
-                    std::copy(lateOutAL_.begin(), lateOutAL_.end(), lateOutAR_.begin());
-                }
-
-                const std::uint64_t targetStartBlock = blockIndex_ + 1;
-                for (std::size_t b = 0; b < kLateBlocksPerChunk; ++b) {
-                    const std::uint64_t targetBlock = targetStartBlock + b;
-                    const std::size_t slot =
-                        static_cast<std::size_t>(targetBlock & scheduleMask);
-                    const std::size_t off = slot * blockSize_;
-                    const std::size_t srcOff = b * blockSize_;
-                    for (std::size_t i = 0; i < blockSize_; ++i) {
-                        scheduledAL_[off + i] += lateOutAL_[srcOff + i];
-                        scheduledAR_[off + i] += lateOutAR_[srcOff + i];
-                    }
-                }
-            }
+    // Collect everything the stages scheduled for this output block.
+    const auto take = [&](Path path, std::span<float> dst) {
+        float* slot = &scheduled_[path][scheduleOffset];
+        std::copy(slot, slot + blockSize_, dst.begin());
+        Clear(slot, blockSize_);
+    };
+    take(kPathAL, wetBlockAL_);
+    take(kPathAR, wetBlockAR_);
+    take(kPathBL, wetBlockBL_);
+    take(kPathBR, wetBlockBR_);
 
-            // Convolve and schedule for B during crossfade.
-            if (pendingIrIndex_ >= 0) {
-                const auto& b = kernels_[static_cast<std::size_t>(pendingIrIndex_)];
-                if (b.hasLate && !b.leftLate.partitions.empty()) {
-                    convolverLate_.convolveWithOverlap(b.leftLate, lateOutBL_.data(), overlapLateBL_);
-                    if (b.isStereo) {
-                        convolverLate_.convolveWithOverlap(b.rightLate, lateOutBR_.data(), overlapLateBR_);
-                    } else {
-                        std::copy(lateOutBL_.begin(), lateOutBL_.end(), lateOutBR_.begin());
-                    }
-
-                    const std::uint64_t targetStartBlock = blockIndex_ + 1;
-                    for (std::size_t bb = 0; bb < kLateBlocksPerChunk; ++bb) {
-                        const std::uint64_t targetBlock = targetStartBlock + bb;
-                        const std::size_t slot =
-                            static_cast<std::size_t>(targetBlock & scheduleMask);
-                        const std::size_t off = slot * blockSize_;
-                        const std::size_t srcOff = bb * blockSize_;
-                        for (std::size_t i = 0; i < blockSize_; ++i) {
-                            scheduledBL_[off + i] += lateOutBL_[srcOff + i];
-                            scheduledBR_[off + i] += lateOutBR_[srcOff + i];
-                        }
-                    }
-                }
+    if (ringingOut_) {
+        // The paths hold disjoint input, so they simply add. A switch queued
+        // meanwhile fades the rest of the old ring-out instead of waiting.
+        const std::size_t totalSamples =
+            std::max<std::size_t>(1, static_cast<std::size_t>(fadeTotalBlocks_) * blockSize_);
+        const bool hurry = queuedIrIndex_ >= 0;
+        const std::size_t base = fadeSamplePos_;
+        for (std::size_t i = 0; i < blockSize_; ++i) {
+            const float keep =
+                hurry ? 1.0f - Clamp01(static_cast<float>(base + i) /
+                                       static_cast<float>(totalSamples))
+                      : 1.0f;
+            wetBlockAL_[i] = wetBlockAL_[i] * keep + wetBlockBL_[i];
+            wetBlockAR_[i] = wetBlockAR_[i] * keep + wetBlockBR_[i];
+        }
+        // Done once the old side's history, overlaps and scheduled output
+        // are all spent (or faded away).
+        ringOutQuietBlocks_ = ringOutQuiet() ? ringOutQuietBlocks_ + 1 : 0;
+        if (hurry) {
+            fadeSamplePos_ += blockSize_;
+        }
+        if (ringOutQuietBlocks_ > scheduleMask_ || (hurry && fadeSamplePos_ >= totalSamples)) {
+            const int queued = queuedIrIndex_;
+            finishIrSwitch();
+            if (queued >= 0 && queued != irIndex_) {
+                beginRingOut(queued);
             }
-
-            lateInPos_ = 0;
         }
-    }
-
-    // Crossfade between kernels if needed.
-    if (pendingIrIndex_ >= 0) {
+    } else if (pendingIrIndex_ >= 0) {
+        // Crossfade between kernels.
         const std::size_t totalSamples =
             std::max<std::size_t>(1, static_cast<std::size_t>(fadeTotalBlocks_) * blockSize_);
         const std::size_t base = fadeSamplePos_;
@@ -390,24 +1018,106 @@ void ConvolutionReverb::processBlock() {
 
         fadeSamplePos_ += blockSize_;
         if (fadeSamplePos_ >= totalSamples) {
-            irIndex_ = pendingIrIndex_;
-            pendingIrIndex_ = -1;
-            fadeSamplePos_ = 0;
-            overlapAL_.swap(overlapBL_);
-            overlapAR_.swap(overlapBR_);
-            overlapLateAL_.swap(overlapLateBL_);
-            overlapLateAR_.swap(overlapLateBR_);
-            scheduledAL_.swap(scheduledBL_);
-            scheduledAR_.swap(scheduledBR_);
-            std::fill(overlapBL_.begin(), overlapBL_.end(), 0.0f);
-            std::fill(overlapBR_.begin(), overlapBR_.end(), 0.0f);
-            std::fill(overlapLateBL_.begin(), overlapLateBL_.end(), 0.0f);
-            std::fill(overlapLateBR_.begin(), overlapLateBR_.end(), 0.0f);
-            std::fill(scheduledBL_.begin(), scheduledBL_.end(), 0.0f);
-            std::fill(scheduledBR_.begin(), scheduledBR_.end(), 0.0f);
+            finishIrSwitch();
+        }
+    }
+
+    ++blockIndex_;
+}
+
+// B becomes A: the target IR's state moves onto the A paths.
+void ConvolutionReverb::finishIrSwitch() {
+    irIndex_ = pendingIrIndex_;
+    pendingIrIndex_ = -1;
+    queuedIrIndex_ = -1;
+    fadeSamplePos_ = 0;
+    ringingOut_ = false;
+    for (auto& stage : stages_) {
+        if (!stage.ringOut.historySilent()) {
+            stage.ringOut.reset();  // what a hurried ring-out faded away
+        }
+        for (const auto& [from, to] : {std::pair{kPathBL, kPathAL}, std::pair{kPathBR, kPathAR}}) {
+            std::swap(stage.acc[from], stage.acc[to]);
+            std::swap(stage.overlap[from], stage.overlap[to]);
+            stage.acc[from].clear();
+            std::fill(stage.overlap[from].begin(), stage.overlap[from].end(), 0.0f);
+        }
+    }
+    std::swap(scheduled_[kPathAL], scheduled_[kPathBL]);
+    std::swap(scheduled_[kPathAR], scheduled_[kPathBR]);
+    std::fill(scheduled_[kPathBL].begin(), scheduled_[kPathBL].end(), 0.0f);
+    std::fill(scheduled_[kPathBR].begin(), scheduled_[kPathBR].end(), 0.0f);
+}
+
+// RingOut: the current history (and the chunk being filled) moves to the
+// ring-out side for path A; the new IR starts on an empty history, so
+// there is nothing to catch up.
+void ConvolutionReverb::beginRingOut(int index) {
+    pendingIrIndex_ = index;
+    queuedIrIndex_ = -1;
+    fadeSamplePos_ = 0;
+    ringingOut_ = true;
+    ringOutQuietBlocks_ = 0;
+    std::fill(scheduled_[kPathBL].begin(), scheduled_[kPathBL].end(), 0.0f);
+    std::fill(scheduled_[kPathBR].begin(), scheduled_[kPathBR].end(), 0.0f);
+    for (auto& stage : stages_) {
+        std::swap(stage.convolver, stage.ringOut);
+        std::swap(stage.input, stage.ringOutInput);
+        Clear(stage.input.data(), stage.inputPos);
+        for (const Path path : {kPathBL, kPathBR}) {
+            std::fill(stage.overlap[path].begin(), stage.overlap[path].end(), 0.0f);
+            stage.acc[path].clear();
         }
     }
+}
+
+bool ConvolutionReverb::ringOutQuiet() const {
+    for (const auto& stage : stages_) {
+        if (!stage.ringOut.historySilent()) {
+            return false;
+        }
+        for (const Path path : {kPathAL, kPathAR}) {
+            if (!IsSilent(stage.overlap[path].data(), stage.overlap[path].size())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+PartitionedConvolver& ConvolutionReverb::pathConvolver(Stage& stage, Path path) {
+    return ringingOut_ && path < kPathBL ? stage.ringOut : stage.convolver;
+}
 
+bool ConvolutionReverb::stagesQuiet() const {
+    for (const auto& stage : stages_) {
+        if (!stage.convolver.historySilent() || !stage.ringOut.historySilent()) {
+            return false;
+        }
+        for (const auto& overlap : stage.overlap) {
+            if (!IsSilent(overlap.data(), overlap.size())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Silent input into a rung-out tail: the output is zero and the state stays
+// zero, so only the chunk positions move on (keeping later chunks aligned).
+void ConvolutionReverb::idleBlock() {
+    Clear(wetBlockAL_.data(), blockSize_);
+    Clear(wetBlockAR_.data(), blockSize_);
+    Clear(wetBlockBL_.data(), blockSize_);
+    Clear(wetBlockBR_.data(), blockSize_);
+    for (auto& stage : stages_) {
+        Clear(stage.input.data() + stage.inputPos, blockSize_);
+        stage.inputPos += blockSize_;
+        if (stage.inputPos >= stage.blockSize) {
+            stage.inputPos = 0;
+        }
+        stage.phase = stage.blocksPerChunk;
+    }
     ++blockIndex_;
 }
 
@@ -1,77 +1,313 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
+#include <span>
 #include <vector>
 
+#include "dsp/AlignedBuffer.h"
 #include "dsp/PartitionedConvolver.h"
 
 namespace dsp {
 
+class StateReader;
+class StateWriter;
+
 struct StereoConvolutionKernel {
+    // Head stage (stage 0 of the partition layout).
     ConvolutionKernel left;
     ConvolutionKernel right;  // empty if mono
     bool isStereo = false;
 
-    // Optional late-tail kernel for non-uniform partitioning.
-    // When provided, the reverb runs a two-stage convolution:
-    // - early stage: 256/512 (sample-accurate early reflections)
-    // - late stage:  2048/4096, computed less frequently and scheduled ahead
-    ConvolutionKernel leftLate;
-    ConvolutionKernel rightLate;  // empty if mono
-    bool hasLate = false;
+    // Tail stages 1..N-1 of the partition layout, in order. Missing or empty
+    // entries are skipped.
+    std::vector<ConvolutionKernel> tailLeft;
+    std::vector<ConvolutionKernel> tailRight;  // empty if mono
+
+    std::size_t heapBytes() const {
+        std::size_t bytes = left.heapBytes() + right.heapBytes();
+        for (const auto* stages : {&tailLeft, &tailRight}) {
+            for (const ConvolutionKernel& kernel : *stages) {
+                bytes += kernel.heapBytes();
+            }
+        }
+        return bytes;
+    }
+};
+
+// Kernels are immutable once built, so any number of reverbs (on any
+// threads) can convolve with one copy. Null is an empty kernel.
+using SharedConvolutionKernel = std::shared_ptr<const StereoConvolutionKernel>;
+
+// Fork/join hook for splitting work: run(runner, job, context, jobs) calls
+// job(context, 0..jobs-1), possibly concurrently, and returns once all are done.
+using ParallelJob = void (*)(void* context, std::size_t job);
+using ParallelRun = void (*)(void* runner, ParallelJob job, void* context, std::size_t jobs);
+
+// Non-uniform partition layout. Stage s convolves blocks of blockSizes[s]
+// samples (FFT size 2x) against the IR range [offsets[s], offsets[s + 1]);
+// the last stage takes the rest of the IR. Tail stages start late enough that
+// their work can be spread over blockSizes[s] / blockSizes[0] base blocks.
+struct PartitionLayout {
+    std::vector<std::size_t> blockSizes;
+    std::vector<std::size_t> offsets;
+
+    // Builds offsets for ascending power-of-two block sizes, e.g.
+    // {128, 512, 2048, 8192}. Entries that are not powers of two or not larger
+    // than the previous stage are dropped.
+    static PartitionLayout FromBlockSizes(const std::vector<std::size_t>& blockSizes);
+
+    // Ascending power-of-two blocks with offsets that leave every tail stage
+    // its spreading lead (offset >= 2 * block - 2 * base).
+    bool valid() const;
+
+    std::size_t stageCount() const { return blockSizes.size(); }
+    // Partitions stage `stage` needs for an IR of `frames` samples.
+    std::size_t partitionCount(std::size_t stage, std::size_t frames) const;
+    std::size_t baseBlockSize() const { return blockSizes.empty() ? 0 : blockSizes.front(); }
+
+    // Splits an IR into per-stage kernels. `right` is null for mono IRs.
+    // With `run`, each stage of each channel is its own job.
+    StereoConvolutionKernel buildKernel(const float* left,
+                                        const float* right,
+                                        std::size_t frames,
+                                        ParallelRun run = nullptr,
+                                        void* runner = nullptr) const;
+};
+
+// Lightweight stereo decorrelation used to widen the wet signal of mono IRs:
+// L is the mono wet, R a short delay of it blended with a low-passed longer
+// one. Runs over whole blocks against a linear history, so everything but
+// the one-pole low-pass vectorises.
+class StereoDecorrelator {
+public:
+    void reset();
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    // Outputs may alias the inputs. Advances the delay line even when
+    // `enabled` is false, so switching between mono and stereo IRs doesn't
+    // jump. Disabled = pass-through.
+    void processBlock(const float* wetL, const float* wetR, bool enabled, float* outL,
+                      float* outR, std::size_t frames);
+
+private:
+    static constexpr std::size_t kShortTap = 7;
+    static constexpr std::size_t kLongTap = 19;
+    static constexpr std::size_t kChunk = 256;
+
+    // The last kLongTap mono samples, then the chunk being processed.
+    std::array<float, kLongTap + kChunk> mono_{};
+    float lp_ = 0.0f;
+};
+
+// How ConvolutionReverb::setIrIndex() moves to a new IR.
+enum class IrCrossfade {
+    // Both kernels convolve the whole history and their outputs crossfade
+    // over 16 blocks: twice the work while it lasts.
+    Output,
+    // New input feeds only the new kernel while the old one rings out on the
+    // input it already had. Silent history rows are skipped, so the pair
+    // costs about one convolution; each stage keeps a second history.
+    RingOut,
 };
 
 // Convolution reverb wrapper that provides:
 // - block-based processing internally (sample-in/sample-out)
+// - non-uniform partitioned convolution driven by a PartitionLayout
 // - IR selection with click-free crossfade between kernels
 // - wet/dry mix
 class ConvolutionReverb {
 public:
+    ConvolutionReverb();
+    ~ConvolutionReverb();
+    ConvolutionReverb(const ConvolutionReverb&) = delete;
+    ConvolutionReverb& operator=(const ConvolutionReverb&) = delete;
+
     void setSampleRate(double sampleRate);
 
+    // Kernels passed to setIrKernels() must be built with the same layout.
+    void setPartitionLayout(PartitionLayout layout);
+    const PartitionLayout& partitionLayout() const { return layout_; }
+
     void setMix(float mix01);     // 0..1
     float mix() const { return targetMix_; }
 
-    void setIrKernels(std::vector<StereoConvolutionKernel> kernels);
+    // maxIrFrames reserves history for kernels of IRs up to that length that
+    // are filled in later with setIrKernel(); empty entries render silence.
+    void setIrKernels(std::vector<SharedConvolutionKernel> kernels, std::size_t maxIrFrames = 0);
+    // Takes sole ownership of each kernel.
+    void setIrKernels(std::vector<StereoConvolutionKernel> kernels, std::size_t maxIrFrames = 0);
     int irCount() const { return static_cast<int>(kernels_.size()); }
+    bool hasIrKernel(int index) const;
+
+    // Fills one entry in place without touching the convolution state. Meant
+    // for entries not currently playing; kernels longer than the reserved
+    // history are truncated.
+    void setIrKernel(int index, SharedConvolutionKernel kernel);
+    void setIrKernel(int index, StereoConvolutionKernel kernel);
+
+    // Moves the kernels out (e.g. into a cache); the reverb is left without IRs.
+    std::vector<SharedConvolutionKernel> releaseIrKernels();
+    const std::vector<SharedConvolutionKernel>& irKernels() const { return kernels_; }
+
+    // Hands over a kernel set built on any thread. The processing thread
+    // swaps it in at the next block boundary (or adoptPublishedIrKernels()).
+    // A set that fits the stages as built (maxIrFrames and every kernel's
+    // partitions) goes in without allocating, and the tail carries on
+    // unless the IR playing or being switched to changed, which restarts it
+    // like setIrKernels(). A larger set rebuilds the stages. A newer publish
+    // replaces a set not yet adopted.
+    void publishIrKernels(std::vector<SharedConvolutionKernel> kernels,
+                          std::size_t maxIrFrames = 0);
+    // Processing thread: swaps in a published set now; false if none.
+    bool adoptPublishedIrKernels();
+    // Frees the set the last adoption replaced. Safe from any thread while
+    // the reverb processes; call it from one that may free memory. A set
+    // still unreleased at the next adoption is freed there.
+    void releaseRetiredIrKernels();
 
-    void setIrIndex(int index);   // 0..irCount-1
+    // Splits each tail-stage slice into up to `jobs` contiguous partition
+    // ranges run through `run`; the partial spectra are summed in a fixed
+    // order, so the result doesn't depend on scheduling. jobs <= 1 or a null
+    // `run` keeps everything on the calling thread. Set up front.
+    void setParallelism(std::size_t jobs, ParallelRun run, void* runner);
+    std::size_t parallelJobs() const { return parallelRun_ ? parallelJobs_ : 1; }
+
+    // Set up front like the layout: switching rebuilds the stages.
+    void setCrossfadeMode(IrCrossfade mode);
+    IrCrossfade crossfadeMode() const { return crossfadeMode_; }
+
+    // 0..irCount-1. In RingOut mode a switch made while the old IR is still
+    // ringing out fades that remainder over 16 blocks, then starts its own.
+    void setIrIndex(int index);
     int irIndex() const { return irIndex_; }
 
     void reset();
 
+    // Histories, overlaps, scheduled output and IR switch state, for
+    // snapshots. The restoring reverb must already have the same layout,
+    // history sizes and kernels for activeIrIndices() as the saved one;
+    // loadState() is false (and resets) if the first two differ.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+    // The IR playing, the one faded to and the one queued behind a ring-out
+    // (-1 where none).
+    std::array<int, 3> activeIrIndices() const {
+        return {irIndex_, pendingIrIndex_, queuedIrIndex_};
+    }
+
+    // Wet level applied to the convolution output (IRs are peak-normalized
+    // but can still have large overall energy).
+    static constexpr float kWetLevel = 0.25f;
+
+    // When disabled, mono IRs produce identical L/R wet and the caller is
+    // expected to decorrelate (e.g. after summing with a separately computed
+    // IR head). Enabled by default.
+    void setStereoDecorrelation(bool enabled) { decorrelationEnabled_ = enabled; }
+
     // Process one mono sample and output stereo.
     // Dry stays centered; for mono IRs the wet is lightly decorrelated for width.
     void processSample(float input, float& outL, float& outR);
 
     // Process one input block and output wet-only stereo, aligned to the block.
-    // input length = 256, out buffers length = 256.
+    // input and out buffers hold partitionLayout().baseBlockSize() samples.
     // Intended for realtime worker threads; avoids an extra block of latency
     // introduced by the sample-in/sample-out wrapper.
     void processBlockWet(const float* input, float* outWetL, float* outWetR);
 
+    // True once the input has stayed silent until the whole tail rang out;
+    // further silent blocks then skip every stage.
+    bool idle() const { return quietBlocks_ > scheduleMask_; }
+
 private:
+    // Wet paths: current IR (A) and crossfade target (B), left/right.
+    enum Path : std::size_t { kPathAL, kPathAR, kPathBL, kPathBR, kPathCount };
+
+    // Float buffers below are slices of arena_.
+    struct Stage {
+        std::size_t blockSize = 0;
+        std::size_t blocksPerChunk = 1;  // blockSize / base block size
+        std::size_t leadBlocks = 0;      // IR offset in base blocks
+        PartitionedConvolver convolver;
+        std::span<float> input;          // blockSize, filled one base block at a time
+        // RingOut mode: history and pending input of the IR being left.
+        PartitionedConvolver ringOut;
+        std::span<float> ringOutInput;
+        std::size_t inputPos = 0;
+        std::size_t phase = 0;           // calls since the last chunk; blocksPerChunk = idle
+        std::uint64_t chunkBlock = 0;    // base block that completed the chunk
+        std::array<SplitComplex, kPathCount> acc;
+        // Parallel slices: accumulators for ranges after the first, per path.
+        std::vector<SplitComplex> partials;
+        std::array<std::span<float>, kPathCount> overlap;
+        std::span<float> out;            // blockSize
+    };
+
+    // One contiguous partition range of a slice. Ranges after the first
+    // accumulate into a partial that is added to `target` afterwards. True
+    // stereo ranges carry the right channel too.
+    struct AccumulateJob {
+        const PartitionedConvolver* convolver = nullptr;
+        const ConvolutionKernel* kernel = nullptr;
+        SplitComplex* acc = nullptr;
+        SplitComplex* target = nullptr;
+        const ConvolutionKernel* kernelRight = nullptr;
+        SplitComplex* accRight = nullptr;
+        SplitComplex* targetRight = nullptr;
+        std::size_t firstPartition = 0;
+        std::size_t endPartition = 0;
+    };
+
+    struct KernelSet {
+        std::vector<SharedConvolutionKernel> kernels;
+        std::size_t maxIrFrames = 0;
+    };
+
     void rebuildForCurrentKernels();
+    // Points every float buffer at its slice of arena_.
+    void carveBuffers(std::size_t scheduleBlocks);
+    // True if the stages already hold enough history for `set`.
+    bool stagesFit(const KernelSet& set) const;
     void processBlock();
+    void advanceStage(std::size_t stageIndex);
+    void accumulateDueSlices(const StereoConvolutionKernel& a, const StereoConvolutionKernel* b);
+    void queueSlice(std::size_t stageIndex, const StereoConvolutionKernel& kernels, Path left);
+    static void RunAccumulateJob(void* context, std::size_t job);
+    void finishStage(std::size_t stageIndex, const StereoConvolutionKernel& a,
+                     const StereoConvolutionKernel* b);
+    void idleBlock();
+    bool stagesQuiet() const;
+    void beginRingOut(int index);
+    bool ringOutQuiet() const;
+    void finishIrSwitch();
+    PartitionedConvolver& pathConvolver(Stage& stage, Path path);
+    bool useDecorrelation() const;
+    // Wet level and decorrelation for the block processBlock() just left in
+    // wetBlockA*; `outL`/`outR` may be those buffers.
+    void finishWetBlock(float* outL, float* outR);
+    void accumulateSlices(std::size_t stageIndex, const StereoConvolutionKernel& kernels,
+                          Path left, std::size_t firstSlice, std::size_t endSlice);
+    void schedule(Path path, const float* src, std::uint64_t firstBlock, std::size_t blocks);
+    const StereoConvolutionKernel& irKernel(int index) const;
+    static const ConvolutionKernel* StageKernel(const StereoConvolutionKernel& kernels,
+                                                std::size_t stage, bool right);
 
     double sampleRate_ = 44100.0;
+    PartitionLayout layout_;
     std::size_t blockSize_ = 256;
-    std::size_t fftSize_ = 512;
-
-    // Late stage uses a smaller FFT to reduce CPU spikes (computed every 4 blocks).
-    static constexpr std::size_t kLateBlockSize = 1024;
-    static constexpr std::size_t kLateFftSize = 2048;
-    static constexpr std::size_t kLateBlocksPerChunk = 4;  // 1024 / 256
-    static constexpr std::size_t kLateStartBlocks = 4;     // IR tail starts after 1024 samples
-    static constexpr std::size_t kScheduleBlocks = 64;     // power-of-two ring
 
     float targetMix_ = 0.0f;
     float currentMix_ = 0.0f;
     float mixSmoothingAlpha_ = 1.0f;
 
-    std::vector<StereoConvolutionKernel> kernels_;
+    std::vector<SharedConvolutionKernel> kernels_;
+    std::size_t reservedIrFrames_ = 0;
+    std::atomic<KernelSet*> publishedKernels_{nullptr};  // any thread -> processing
+    std::atomic<KernelSet*> retiredKernels_{nullptr};    // processing -> release
     int irIndex_ = 0;
     int pendingIrIndex_ = -1;
 
@@ -79,47 +315,40 @@ private:
     int fadeTotalBlocks_ = 16;  // ~90ms at 44.1k with 256-blocks
     std::size_t fadeSamplePos_ = 0;
 
-    PartitionedConvolver convolverEarly_;
-    PartitionedConvolver convolverLate_;
-    std::vector<float> overlapAL_;
-    std::vector<float> overlapAR_;
-    std::vector<float> overlapBL_;
-    std::vector<float> overlapBR_;
-    std::vector<float> overlapLateAL_;
-    std::vector<float> overlapLateAR_;
-    std::vector<float> overlapLateBL_;
-    std::vector<float> overlapLateBR_;
-    std::vector<float> inBlock_;
-    std::vector<float> wetBlockAL_;
-    std::vector<float> wetBlockAR_;
-    std::vector<float> wetBlockBL_;
-    std::vector<float> wetBlockBR_;
-    std::vector<float> lateInBlock_;   // 2048
-    std::vector<float> lateOutAL_;     // 2048
-    std::vector<float> lateOutAR_;     // 2048
-    std::vector<float> lateOutBL_;     // 2048
-    std::vector<float> lateOutBR_;     // 2048
-    std::size_t lateInPos_ = 0;        // 0..2048
+    std::size_t parallelJobs_ = 1;
+    ParallelRun parallelRun_ = nullptr;
+    void* parallelRunner_ = nullptr;
+    std::vector<AccumulateJob> jobs_;  // reserved at rebuild
+
+    IrCrossfade crossfadeMode_ = IrCrossfade::Output;
+    bool ringingOut_ = false;  // path A rings out on stage.ringOut
+    int queuedIrIndex_ = -1;   // switch requested during a ring-out
+    std::size_t ringOutQuietBlocks_ = 0;
+
+    std::vector<Stage> stages_;
+    // The block-rate state of the stages and paths in one 64-byte aligned
+    // allocation, made at rebuild: reset() is one fill of it.
+    FloatArena arena_;
+    std::span<float> inBlock_;
+    std::span<float> wetBlockAL_;
+    std::span<float> wetBlockAR_;
+    std::span<float> wetBlockBL_;
+    std::span<float> wetBlockBR_;
     std::uint64_t blockIndex_ = 0;
 
-    // Scheduled late-tail contributions keyed by output block index.
+    // Stage outputs keyed by output block index, one ring per path.
     // Layout: [blockSlot * blockSize + sampleIndex]
-    std::vector<float> scheduledAL_;
-    std::vector<float> scheduledAR_;
-    std::vector<float> scheduledBL_;
-    std::vector<float> scheduledBR_;
+    std::array<std::span<float>, kPathCount> scheduled_;
+    std::size_t scheduleMask_ = 0;  // ring blocks - 1 (power of two)
     std::size_t inPos_ = 0;
     std::size_t outPos_ = 0;
     bool wetReady_ = false;
+    // Consecutive silent input blocks with every stage's history and
+    // overlap at zero; past the schedule length the output is silence.
+    std::size_t quietBlocks_ = 0;
 
-    // Keep reverb output in a reasonable range (IRs are peak-normalized but can
-    // still have large overall energy).
-    float wetLevel_ = 0.25f;
-
-    // Lightweight stereo decorrelation on the wet signal.
-    std::array<float, 64> stereoDelay_{};
-    std::size_t stereoPos_ = 0;
-    float stereoLp_ = 0.0f;
+    StereoDecorrelator decorrelator_;
+    bool decorrelationEnabled_ = true;
 };
 
 }  // namespace dsp
@@ -3,7 +3,16 @@
 #include <cstdint>
 
 #if defined(__SSE__) || defined(_M_IX86) || defined(_M_X64)
+#define SATORI_DENORMALS_SSE 1
 #include <xmmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SATORI_DENORMALS_ARM64 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#ifndef ARM64_FPCR
+#define ARM64_FPCR ARM64_SYSREG(3, 3, 4, 4, 0)
+#endif
+#endif
 #endif
 
 namespace dsp {
@@ -13,14 +22,20 @@ namespace dsp {
 class ScopedDenormalsDisable {
 public:
     ScopedDenormalsDisable() {
-#if defined(__SSE__) || defined(_M_IX86) || defined(_M_X64)
+#if defined(SATORI_DENORMALS_SSE)
         oldCsr_ = static_cast<std::uint32_t>(_mm_getcsr());
         // MXCSR bits:
         // - DAZ (Denormals-Are-Zero) = bit 6  (0x0040)
         // - FTZ (Flush-To-Zero)     = bit 15 (0x8000)
-        const std::uint32_t csr = oldCsr_ | 0x0040u | 0x8000u;
+        const std::uint32_t csr = static_cast<std::uint32_t>(oldCsr_) | 0x0040u | 0x8000u;
         _mm_setcsr(csr);
         active_ = true;
+#elif defined(SATORI_DENORMALS_ARM64)
+        oldCsr_ = ReadFpcr();
+        // FPCR.FZ (bit 24) flushes subnormal inputs and results alike, so it
+        // covers both MXCSR bits.
+        WriteFpcr(oldCsr_ | (std::uint64_t{1} << 24));
+        active_ = true;
 #endif
     }
 
@@ -28,17 +43,40 @@ public:
     ScopedDenormalsDisable& operator=(const ScopedDenormalsDisable&) = delete;
 
     ~ScopedDenormalsDisable() {
-#if defined(__SSE__) || defined(_M_IX86) || defined(_M_X64)
+#if defined(SATORI_DENORMALS_SSE)
         if (active_) {
             _mm_setcsr(static_cast<unsigned int>(oldCsr_));
         }
+#elif defined(SATORI_DENORMALS_ARM64)
+        if (active_) {
+            WriteFpcr(oldCsr_);
+        }
 #endif
     }
 
 private:
-    std::uint32_t oldCsr_ = 0;
+#if defined(SATORI_DENORMALS_ARM64)
+    static std::uint64_t ReadFpcr() {
+#if defined(_MSC_VER)
+        return static_cast<std::uint64_t>(_ReadStatusReg(ARM64_FPCR));
+#else
+        std::uint64_t value = 0;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(value));
+        return value;
+#endif
+    }
+    static void WriteFpcr(std::uint64_t value) {
+#if defined(_MSC_VER)
+        _WriteStatusReg(ARM64_FPCR, static_cast<__int64>(value));
+#else
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(value));
+#endif
+    }
+#endif
+
+    // MXCSR or FPCR as it was before the guard.
+    std::uint64_t oldCsr_ = 0;
     bool active_ = false;
 };
 
 }  // namespace dsp
-
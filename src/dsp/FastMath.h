@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+namespace dsp {
+
+// Approximations of exp2/exp/log2/tan/atan for coefficient code (pitch
+// ratios, smoothing constants, phase delays) that runs per voice on note-on
+// and at control rate. Branch-light polynomial kernels with no table and no
+// libm call, for float and double alike, so loops over them vectorise.
+// Bounds, measured against libm over the whole range (see core_tests):
+//   FastExp2   relative error < 1e-8
+//   FastLog2   absolute error < 1e-9
+//   FastAtan   absolute error < 1e-9 (FastAtan2 likewise)
+//   FastTan    relative error < 1e-9 for |x| < pi/2 - 1e-3
+// in double. In float the polynomial is below float rounding and the result
+// is within a few ulp (FastTan: of its distance from pi/2). FastExp and
+// FastLog2 expect finite input (FastLog2 positive and normal); FastExp2
+// clamps to the normal exponent range.
+
+namespace detail {
+
+template <typename T>
+constexpr T Poly(T x, T c0, T c1) {
+    return c0 + x * c1;
+}
+
+template <typename T, typename... Rest>
+constexpr T Poly(T x, T c0, T c1, Rest... rest) {
+    return c0 + x * Poly(x, c1, static_cast<T>(rest)...);
+}
+
+template <typename T>
+struct FloatBits;
+
+template <>
+struct FloatBits<float> {
+    using Int = std::int32_t;
+    static constexpr int kMantissaBits = 23;
+    static constexpr int kBias = 127;
+};
+
+template <>
+struct FloatBits<double> {
+    using Int = std::int64_t;
+    static constexpr int kMantissaBits = 52;
+    static constexpr int kBias = 1023;
+};
+
+// atan on [0, 1]: folded once more about tan(pi/8), then an odd
+// polynomial on |a| <= tan(pi/8).
+template <typename T>
+T AtanUnit(T a) {
+    constexpr T kTanPi8 = static_cast<T>(0.41421356237309504880);
+    constexpr T kPi4 = static_cast<T>(0.78539816339744830962);
+    const bool folded = a > kTanPi8;
+    const T r = folded ? (a - T(1)) / (a + T(1)) : a;
+    const T u = r * r;
+    const T p = r * Poly(u, T(0.9999999993712282), T(-0.33333306893050346),
+                         T(0.1999818304113814), T(-0.14239532670370092),
+                         T(0.10569828810855945), T(-0.060263052378973093));
+    return folded ? kPi4 + p : p;
+}
+
+}  // namespace detail
+
+template <typename T>
+T FastExp2(T x) {
+    static_assert(std::is_floating_point_v<T>);
+    using Bits = detail::FloatBits<T>;
+    using Int = typename Bits::Int;
+    x = std::clamp(x, static_cast<T>(1 - Bits::kBias), static_cast<T>(Bits::kBias));
+    // x = n + f with |f| <= 1/2; 2^f = 1 + f q(f), exact at f = 0.
+    const T n = static_cast<T>(static_cast<Int>(x + (x < 0 ? T(-0.5) : T(0.5))));
+    const T f = x - n;
+    const T q = detail::Poly(f, T(0.6931471880262285), T(0.24022650760567846),
+                             T(0.05550357114219147), T(0.009618082557302569),
+                             T(0.001339086336462805), T(0.00015453162939509034));
+    const T scale = std::bit_cast<T>(static_cast<Int>(static_cast<Int>(n) + Bits::kBias)
+                                     << Bits::kMantissaBits);
+    return (T(1) + f * q) * scale;
+}
+
+template <typename T>
+T FastExp(T x) {
+    return FastExp2(x * static_cast<T>(1.44269504088896340736));
+}
+
+template <typename T>
+T FastLog2(T x) {
+    static_assert(std::is_floating_point_v<T>);
+    using Bits = detail::FloatBits<T>;
+    using Int = typename Bits::Int;
+    constexpr Int kMantissaMask = (Int{1} << Bits::kMantissaBits) - 1;
+    constexpr Int kOne = Int{Bits::kBias} << Bits::kMantissaBits;
+    constexpr T kSqrt2 = static_cast<T>(1.41421356237309504880);
+    // x = 2^e m with m in [sqrt(1/2), sqrt(2)); log2 m = t r(t^2) with
+    // t = (m - 1) / (m + 1).
+    const Int bits = std::bit_cast<Int>(x);
+    T e = static_cast<T>((bits >> Bits::kMantissaBits) - Bits::kBias);
+    T m = std::bit_cast<T>((bits & kMantissaMask) | kOne);
+    const bool high = m > kSqrt2;
+    m = high ? m * T(0.5) : m;
+    e = high ? e + T(1) : e;
+    const T t = (m - T(1)) / (m + T(1));
+    const T u = t * t;
+    return e + t * detail::Poly(u, T(2.885390079803338), T(0.9617988388012692),
+                                T(0.5767151860876166), T(0.43171769604983956));
+}
+
+template <typename T>
+T FastAtan(T x) {
+    static_assert(std::is_floating_point_v<T>);
+    constexpr T kPi2 = static_cast<T>(1.57079632679489661923);
+    const T a = x < 0 ? -x : x;
+    const bool inverted = a > T(1);
+    const T r = detail::AtanUnit(inverted ? T(1) / a : a);
+    const T result = inverted ? kPi2 - r : r;
+    return x < 0 ? -result : result;
+}
+
+// Quadrants as std::atan2; (0, 0) gives 0.
+template <typename T>
+T FastAtan2(T y, T x) {
+    static_assert(std::is_floating_point_v<T>);
+    constexpr T kPi = static_cast<T>(3.14159265358979323846);
+    constexpr T kPi2 = static_cast<T>(1.57079632679489661923);
+    const T ax = x < 0 ? -x : x;
+    const T ay = y < 0 ? -y : y;
+    const T larger = std::max(ax, ay);
+    const T smaller = std::min(ax, ay);
+    T r = detail::AtanUnit(larger > 0 ? smaller / larger : T(0));
+    r = ay > ax ? kPi2 - r : r;
+    r = x < 0 ? kPi - r : r;
+    return y < 0 ? -r : r;
+}
+
+// |x| < pi/2. sin and cos of the angle folded into [0, pi/4], tan as their
+// ratio (or its inverse past pi/4).
+template <typename T>
+T FastTan(T x) {
+    static_assert(std::is_floating_point_v<T>);
+    constexpr T kPi2 = static_cast<T>(1.57079632679489661923);
+    constexpr T kPi4 = static_cast<T>(0.78539816339744830962);
+    const T a = x < 0 ? -x : x;
+    const bool folded = a > kPi4;
+    const T r = folded ? kPi2 - a : a;
+    const T u = r * r;
+    const T s = r * detail::Poly(u, T(0.999999999995673), T(-0.1666666663159121),
+                                 T(0.008333328782463947), T(-0.00019839202213813695),
+                                 T(2.717345698545241e-06));
+    const T c = detail::Poly(u, T(0.9999999999524894), T(-0.49999999614857515),
+                             T(0.0416666166925251), T(-0.0013886617999425682),
+                             T(2.437983123082832e-05));
+    const T result = folded ? c / s : s / c;
+    return x < 0 ? -result : result;
+}
+
+}  // namespace dsp
@@ -0,0 +1,260 @@
+#include "dsp/FdnReverb.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dsp/StateSnapshot.h"
+
+namespace dsp {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Mutually prime-ish line lengths (ms) for a small to mid-size room.
+constexpr std::array<double, FdnReverb::kLines> kDelayMs = {
+    31.7, 37.3, 41.9, 47.1, 53.3, 59.9, 67.1, 73.7,
+};
+// Input spread and output taps; alternating signs keep L and R apart.
+constexpr std::array<float, FdnReverb::kLines> kInputSigns = {
+    1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f, -1.0f, -1.0f,
+};
+// Output level is normalised to this rate: convolution wet energy grows with
+// the rate (more IR samples), a lossless network's does not.
+constexpr double kReferenceRate = 48000.0;
+// Split point for the high-frequency decay estimate.
+constexpr double kHighBandHz = 4000.0;
+
+// In-place normalised 8-point Walsh-Hadamard transform; fixed-size loops the
+// compiler vectorises.
+void Hadamard8(std::array<float, FdnReverb::kLines>& v) {
+    for (std::size_t h = 1; h < FdnReverb::kLines; h *= 2) {
+        for (std::size_t i = 0; i < FdnReverb::kLines; i += 2 * h) {
+            for (std::size_t j = i; j < i + h; ++j) {
+                const float a = v[j];
+                const float b = v[j + h];
+                v[j] = a + b;
+                v[j + h] = a - b;
+            }
+        }
+    }
+    const float scale = static_cast<float>(1.0 / std::sqrt(static_cast<double>(FdnReverb::kLines)));
+    for (float& x : v) {
+        x *= scale;
+    }
+}
+
+// RT60 extrapolated from the energy decay curve of `energy` between -5 dB
+// and the deepest of -35/-25/-15 dB it reaches; 0 if it reaches none.
+double DecayTime(const std::vector<double>& energy, double sampleRate) {
+    double total = 0.0;
+    for (double e : energy) {
+        total += e;
+    }
+    if (total <= 0.0) {
+        return 0.0;
+    }
+    const auto crossing = [&](double db) -> double {
+        const double floor = total * std::pow(10.0, db / 10.0);
+        double remaining = total;
+        for (std::size_t f = 0; f < energy.size(); ++f) {
+            if (remaining <= floor) {
+                return static_cast<double>(f) / sampleRate;
+            }
+            remaining -= energy[f];
+        }
+        return -1.0;
+    };
+    const double start = crossing(-5.0);
+    if (start < 0.0) {
+        return 0.0;
+    }
+    for (double depth : {-35.0, -25.0, -15.0}) {
+        const double end = crossing(depth);
+        if (end > start) {
+            return (end - start) * 60.0 / (-5.0 - depth);
+        }
+    }
+    return 0.0;
+}
+
+}  // namespace
+
+FdnReverb::FdnReverb() {
+    for (std::size_t i = 0; i < kLines; ++i) {
+        const auto capacity =
+            static_cast<std::size_t>(std::ceil(kDelayMs[i] * 0.001 * kMaxSampleRate)) + 1;
+        lines_[i].assign(capacity, 0.0f);
+    }
+    setSampleRate(sampleRate_);
+}
+
+void FdnReverb::setSampleRate(double sampleRate) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    sampleRate_ = std::min(sampleRate, kMaxSampleRate);
+    for (std::size_t i = 0; i < kLines; ++i) {
+        const auto length = static_cast<std::size_t>(std::lround(kDelayMs[i] * 0.001 * sampleRate_));
+        lengths_[i] = std::clamp<std::size_t>(length, 1, lines_[i].size());
+    }
+    updateCoefficients();
+    reset();
+}
+
+void FdnReverb::setSettings(const Settings& settings) {
+    settings_.rt60Seconds = std::max(0.01, settings.rt60Seconds);
+    settings_.highRatio = std::clamp(settings.highRatio, 0.05, 1.0);
+    settings_.gain = std::max(0.0f, settings.gain);
+    updateCoefficients();
+}
+
+void FdnReverb::reset() {
+    for (auto& line : lines_) {
+        std::fill(line.begin(), line.end(), 0.0f);
+    }
+    positions_.fill(0);
+    dampState_.fill(0.0f);
+}
+
+void FdnReverb::saveState(StateWriter& out) const {
+    out.pod(sampleRate_);
+    out.pod(settings_);
+    out.pod(positions_);
+    out.pod(dampState_);
+    // Only the part of each line the current rate reaches.
+    for (std::size_t i = 0; i < kLines; ++i) {
+        out.floats(lines_[i].data(), lengths_[i]);
+    }
+}
+
+bool FdnReverb::loadState(StateReader& in) {
+    double sampleRate = 0.0;
+    Settings settings;
+    if (in.pod(sampleRate) && in.pod(settings)) {
+        if (sampleRate != sampleRate_) {
+            setSampleRate(sampleRate);
+        }
+        setSettings(settings);
+    }
+    in.pod(positions_);
+    in.pod(dampState_);
+    for (std::size_t i = 0; i < kLines; ++i) {
+        if (in.ok() && positions_[i] >= lengths_[i]) {
+            in.fail();
+        }
+        in.floats(lines_[i].data(), lengths_[i]);
+    }
+    if (!in.ok()) {
+        reset();
+    }
+    return in.ok();
+}
+
+void FdnReverb::updateCoefficients() {
+    const double lowRt = settings_.rt60Seconds;
+    const double highRt = lowRt * settings_.highRatio;
+    for (std::size_t i = 0; i < kLines; ++i) {
+        // Gains per pass at DC and Nyquist for -60 dB after the RT60.
+        const double seconds = static_cast<double>(lengths_[i]) / sampleRate_;
+        const double g0 = std::pow(10.0, -3.0 * seconds / lowRt);
+        const double gPi = std::pow(10.0, -3.0 * seconds / highRt);
+        const double a = (g0 - gPi) / (g0 + gPi);
+        dampA_[i] = static_cast<float>(a);
+        dampB_[i] = static_cast<float>(g0 * (1.0 - a));
+    }
+    // Four lines per side.
+    outputScale_ = static_cast<float>(settings_.gain * 0.5 * std::sqrt(sampleRate_ / kReferenceRate));
+}
+
+void FdnReverb::process(const float* input, float* outL, float* outR, std::size_t frames) {
+    if (!input || !outL || !outR) {
+        return;
+    }
+    std::array<float, kLines> v{};
+    for (std::size_t n = 0; n < frames; ++n) {
+        const float x = input[n];
+        for (std::size_t i = 0; i < kLines; ++i) {
+            v[i] = lines_[i][positions_[i]];
+        }
+        for (std::size_t i = 0; i < kLines; ++i) {
+            dampState_[i] = dampB_[i] * v[i] + dampA_[i] * dampState_[i];
+            v[i] = dampState_[i];
+        }
+        float left = 0.0f;
+        float right = 0.0f;
+        for (std::size_t i = 0; i < kLines; i += 2) {
+            left += v[i];
+            right += v[i + 1];
+        }
+        Hadamard8(v);
+        for (std::size_t i = 0; i < kLines; ++i) {
+            lines_[i][positions_[i]] = v[i] + x * kInputSigns[i];
+            if (++positions_[i] == lengths_[i]) {
+                positions_[i] = 0;
+            }
+        }
+        outL[n] = left * outputScale_;
+        outR[n] = right * outputScale_;
+    }
+}
+
+FdnReverb::Settings FdnReverb::FitToIr(const float* left,
+                                       const float* right,
+                                       std::size_t frames,
+                                       double sampleRate) {
+    Settings fit{};
+    if (!left || frames == 0 || sampleRate <= 0.0) {
+        return fit;
+    }
+    // Per-channel energy, broadband and above kHighBandHz (one-pole highpass).
+    const double hpA = std::exp(-2.0 * kPi * std::min(kHighBandHz, 0.4 * sampleRate) / sampleRate);
+    std::vector<double> broad(frames);
+    std::vector<double> high(frames);
+    double lowL = 0.0;
+    double lowR = 0.0;
+    double irEnergy = 0.0;
+    for (std::size_t f = 0; f < frames; ++f) {
+        const double l = static_cast<double>(left[f]);
+        const double r = right ? static_cast<double>(right[f]) : l;
+        lowL = (1.0 - hpA) * l + hpA * lowL;
+        lowR = (1.0 - hpA) * r + hpA * lowR;
+        const double hl = l - lowL;
+        const double hr = r - lowR;
+        broad[f] = 0.5 * (l * l + r * r);
+        high[f] = 0.5 * (hl * hl + hr * hr);
+        irEnergy += broad[f];
+    }
+
+    const double rt = DecayTime(broad, sampleRate);
+    if (rt > 0.0) {
+        fit.rt60Seconds = rt;
+        const double highRt = DecayTime(high, sampleRate);
+        if (highRt > 0.0) {
+            fit.highRatio = std::clamp(highRt / rt, 0.05, 1.0);
+        }
+    }
+
+    // Level: the network's impulse energy against the IR's, at this rate.
+    FdnReverb probe;
+    probe.setSampleRate(sampleRate);
+    fit.gain = 1.0f;
+    probe.setSettings(fit);
+    const std::size_t length = frames + static_cast<std::size_t>(fit.rt60Seconds * sampleRate);
+    std::vector<float> impulse(length, 0.0f);
+    std::vector<float> outL(length);
+    std::vector<float> outR(length);
+    impulse[0] = 1.0f;
+    probe.process(impulse.data(), outL.data(), outR.data(), length);
+    double fdnEnergy = 0.0;
+    for (std::size_t f = 0; f < length; ++f) {
+        fdnEnergy += 0.5 * (static_cast<double>(outL[f]) * outL[f] +
+                            static_cast<double>(outR[f]) * outR[f]);
+    }
+    if (fdnEnergy > 0.0 && irEnergy > 0.0) {
+        fit.gain = static_cast<float>(std::sqrt(irEnergy / fdnEnergy));
+    }
+    return fit;
+}
+
+}  // namespace dsp
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace dsp {
+
+class StateReader;
+class StateWriter;
+
+// Feedback delay network reverb: kLines delay lines fed back through a
+// normalised Hadamard matrix, each with a one-pole damping filter sized so
+// the network decays in rt60Seconds at low frequencies and in
+// rt60Seconds * highRatio near Nyquist. A small, fixed cost per sample, as a
+// cheap stand-in for ConvolutionReverb. Delay lines are allocated for
+// kMaxSampleRate up front, so nothing allocates after construction.
+class FdnReverb {
+public:
+    static constexpr std::size_t kLines = 8;
+    static constexpr double kMaxSampleRate = 192000.0;
+
+    struct Settings {
+        double rt60Seconds = 0.6;
+        double highRatio = 0.5;  // high-frequency RT60 / rt60Seconds, in (0, 1]
+        float gain = 1.0f;
+    };
+
+    FdnReverb();
+
+    // Clamped to (0, kMaxSampleRate]; resets the network.
+    void setSampleRate(double sampleRate);
+    double sampleRate() const { return sampleRate_; }
+    void setSettings(const Settings& settings);
+    const Settings& settings() const { return settings_; }
+    void reset();
+    // Sample rate, settings and the delay lines, for snapshots; loadState()
+    // applies the first two, so the network needs no setup beforehand.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    // Mono in, wet-only stereo out. The outputs may alias the input.
+    void process(const float* input, float* outL, float* outR, std::size_t frames);
+
+    // Settings whose impulse response follows an IR's broadband and
+    // high-frequency decay and matches its energy at `sampleRate`. `right`
+    // is null for mono IRs. Renders the network once, so not for the audio
+    // thread.
+    static Settings FitToIr(const float* left,
+                            const float* right,
+                            std::size_t frames,
+                            double sampleRate);
+
+private:
+    void updateCoefficients();
+
+    std::array<std::vector<float>, kLines> lines_;
+    std::array<std::size_t, kLines> lengths_{};
+    std::array<std::size_t, kLines> positions_{};
+    // Damping filter per line: y = b * x + a * y[-1].
+    std::array<float, kLines> dampB_{};
+    std::array<float, kLines> dampA_{};
+    std::array<float, kLines> dampState_{};
+    float outputScale_ = 1.0f;
+    double sampleRate_ = 48000.0;
+    Settings settings_{};
+};
+
+}  // namespace dsp
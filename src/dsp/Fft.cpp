@@ -2,14 +2,184 @@
 
 #include <algorithm>
 #include <cmath>
+#include <utility>
+
+#if defined(SATORI_FFT_PFFFT)
+#include <pffft.h>
+#elif defined(SATORI_FFT_VDSP)
+#include <Accelerate/Accelerate.h>
+#endif
 
 namespace dsp {
 
 namespace {
-constexpr float kPi = 3.14159265358979323846f;
+constexpr double kPi = 3.14159265358979323846;
 }  // namespace
 
-Fft::Fft(std::size_t size) { resize(size); }
+// External real-FFT plan. forward()/inverse() follow the forwardReal() /
+// inverseReal() contract; create() returns null for unsupported sizes.
+#if defined(SATORI_FFT_PFFFT)
+
+struct Fft::ExternalPlan {
+    PFFFT_Setup* setup = nullptr;
+    float* in = nullptr;    // pffft wants 16-byte aligned buffers
+    float* out = nullptr;
+    float* work = nullptr;
+    std::size_t size = 0;
+
+    ~ExternalPlan() {
+        pffft_aligned_free(work);
+        pffft_aligned_free(out);
+        pffft_aligned_free(in);
+        if (setup) {
+            pffft_destroy_setup(setup);
+        }
+    }
+
+    static std::unique_ptr<ExternalPlan> create(std::size_t n) {
+        // Real pffft transforms need N to be a multiple of 32.
+        if (n < 32 || (n % 32) != 0) {
+            return nullptr;
+        }
+        auto plan = std::make_unique<ExternalPlan>();
+        plan->setup = pffft_new_setup(static_cast<int>(n), PFFFT_REAL);
+        if (!plan->setup) {
+            return nullptr;
+        }
+        plan->size = n;
+        plan->in = static_cast<float*>(pffft_aligned_malloc(n * sizeof(float)));
+        plan->out = static_cast<float*>(pffft_aligned_malloc(n * sizeof(float)));
+        plan->work = static_cast<float*>(pffft_aligned_malloc(n * sizeof(float)));
+        if (!plan->in || !plan->out || !plan->work) {
+            return nullptr;
+        }
+        return plan;
+    }
+
+    // Ordered real layout: [X0.re, X(N/2).re, X1.re, X1.im, ...].
+    void forward(const float* input, std::complex<float>* spectrum) {
+        std::copy(input, input + size, in);
+        pffft_transform_ordered(setup, in, out, work, PFFFT_FORWARD);
+        const std::size_t half = size / 2;
+        spectrum[0] = {out[0], 0.0f};
+        spectrum[half] = {out[1], 0.0f};
+        for (std::size_t k = 1; k < half; ++k) {
+            spectrum[k] = {out[2 * k], out[2 * k + 1]};
+        }
+    }
+
+    void inverse(const std::complex<float>* spectrum, float* output) {
+        const std::size_t half = size / 2;
+        in[0] = spectrum[0].real();
+        in[1] = spectrum[half].real();
+        for (std::size_t k = 1; k < half; ++k) {
+            in[2 * k] = spectrum[k].real();
+            in[2 * k + 1] = spectrum[k].imag();
+        }
+        pffft_transform_ordered(setup, in, out, work, PFFFT_BACKWARD);
+        const float invN = 1.0f / static_cast<float>(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            output[i] = out[i] * invN;
+        }
+    }
+};
+
+const char* Fft::backendName() { return "pffft"; }
+
+#elif defined(SATORI_FFT_VDSP)
+
+struct Fft::ExternalPlan {
+    FFTSetup setup = nullptr;
+    vDSP_Length log2n = 0;
+    std::size_t size = 0;
+    std::vector<float> re;
+    std::vector<float> im;
+
+    ~ExternalPlan() {
+        if (setup) {
+            vDSP_destroy_fftsetup(setup);
+        }
+    }
+
+    static std::unique_ptr<ExternalPlan> create(std::size_t n) {
+        if (n < 4 || !isPowerOfTwo(n)) {
+            return nullptr;
+        }
+        auto plan = std::make_unique<ExternalPlan>();
+        while ((static_cast<std::size_t>(1) << plan->log2n) < n) {
+            ++plan->log2n;
+        }
+        plan->setup = vDSP_create_fftsetup(plan->log2n, kFFTRadix2);
+        if (!plan->setup) {
+            return nullptr;
+        }
+        plan->size = n;
+        plan->re.assign(n / 2, 0.0f);
+        plan->im.assign(n / 2, 0.0f);
+        return plan;
+    }
+
+    // vDSP packs DC in re[0] and Nyquist in im[0]; the forward result is 2x.
+    void forward(const float* input, std::complex<float>* spectrum) {
+        const std::size_t half = size / 2;
+        DSPSplitComplex split{re.data(), im.data()};
+        vDSP_ctoz(reinterpret_cast<const DSPComplex*>(input), 2, &split, 1, half);
+        vDSP_fft_zrip(setup, &split, 1, log2n, kFFTDirection_Forward);
+        spectrum[0] = {0.5f * re[0], 0.0f};
+        spectrum[half] = {0.5f * im[0], 0.0f};
+        for (std::size_t k = 1; k < half; ++k) {
+            spectrum[k] = {0.5f * re[k], 0.5f * im[k]};
+        }
+    }
+
+    // The inverse of an unscaled packed spectrum yields N * x.
+    void inverse(const std::complex<float>* spectrum, float* output) {
+        const std::size_t half = size / 2;
+        re[0] = spectrum[0].real();
+        im[0] = spectrum[half].real();
+        for (std::size_t k = 1; k < half; ++k) {
+            re[k] = spectrum[k].real();
+            im[k] = spectrum[k].imag();
+        }
+        DSPSplitComplex split{re.data(), im.data()};
+        vDSP_fft_zrip(setup, &split, 1, log2n, kFFTDirection_Inverse);
+        vDSP_ztoc(&split, 1, reinterpret_cast<DSPComplex*>(output), 2, half);
+        const float invN = 1.0f / static_cast<float>(size);
+        vDSP_vsmul(output, 1, &invN, output, 1, size);
+    }
+};
+
+const char* Fft::backendName() { return "vdsp"; }
+
+#else
+
+struct Fft::ExternalPlan {
+    static std::unique_ptr<ExternalPlan> create(std::size_t) { return nullptr; }
+    void forward(const float*, std::complex<float>*) {}
+    void inverse(const std::complex<float>*, float*) {}
+};
+
+const char* Fft::backendName() { return "builtin"; }
+
+#endif
+
+Fft::Fft(std::size_t size, Backend backend) : backend_(backend) { resize(size); }
+
+Fft::~Fft() = default;
+
+// Plans own scratch buffers, so copies build their own.
+Fft::Fft(const Fft& other) : Fft(other.size_, other.backend_) {}
+
+Fft& Fft::operator=(const Fft& other) {
+    if (this != &other) {
+        Fft copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+Fft::Fft(Fft&& other) noexcept = default;
+Fft& Fft::operator=(Fft&& other) noexcept = default;
 
 bool Fft::isPowerOfTwo(std::size_t n) {
     return n != 0 && (n & (n - 1)) == 0;
@@ -20,31 +190,54 @@ void Fft::resize(std::size_t size) {
         return;
     }
     size_ = size;
-    buildBitReverse();
+    buildTables();
+    plan_.reset();
+    if (backend_ == Backend::Default && size_ > 0 && isPowerOfTwo(size_)) {
+        plan_ = ExternalPlan::create(size_);
+    }
 }
 
-void Fft::buildBitReverse() {
-    bitReverse_.clear();
-    if (size_ == 0) {
-        return;
-    }
-    if (!isPowerOfTwo(size_)) {
-        // Leave empty; transform() will no-op.
-        return;
+std::vector<std::size_t> Fft::BuildBitReverse(std::size_t n) {
+    std::vector<std::size_t> table;
+    if (n == 0 || !isPowerOfTwo(n)) {
+        // Leave empty; Transform() will no-op.
+        return table;
     }
-    bitReverse_.resize(size_);
+    table.resize(n);
     std::size_t bits = 0;
-    while ((static_cast<std::size_t>(1) << bits) < size_) {
+    while ((static_cast<std::size_t>(1) << bits) < n) {
         ++bits;
     }
-    for (std::size_t i = 0; i < size_; ++i) {
+    for (std::size_t i = 0; i < n; ++i) {
         std::size_t x = i;
         std::size_t r = 0;
         for (std::size_t b = 0; b < bits; ++b) {
             r = (r << 1) | (x & 1);
             x >>= 1;
         }
-        bitReverse_[i] = r;
+        table[i] = r;
+    }
+    return table;
+}
+
+void Fft::buildTables() {
+    bitReverse_ = BuildBitReverse(size_);
+    halfBitReverse_.clear();
+    twiddles_.clear();
+    halfScratch_.clear();
+    if (bitReverse_.empty() || size_ < 2) {
+        return;
+    }
+    const std::size_t half = size_ / 2;
+    halfBitReverse_ = BuildBitReverse(half);
+    halfScratch_.assign(half, {});
+    // Computed in double once per size; every stage indexes into this table
+    // instead of accumulating w *= wLen.
+    twiddles_.resize(half + 1);
+    for (std::size_t k = 0; k <= half; ++k) {
+        const double angle = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(size_);
+        twiddles_[k] = std::complex<float>(static_cast<float>(std::cos(angle)),
+                                           static_cast<float>(std::sin(angle)));
     }
 }
 
@@ -63,37 +256,130 @@ void Fft::inverse(std::vector<std::complex<float>>& data) const {
     }
 }
 
+void Fft::forwardReal(const float* input, std::complex<float>* spectrum) {
+    if (!input || !spectrum || halfBitReverse_.empty()) {
+        return;
+    }
+    if (plan_) {
+        plan_->forward(input, spectrum);
+        return;
+    }
+    const std::size_t half = size_ / 2;
+    // Pack even/odd samples as one half-size complex sequence.
+    for (std::size_t m = 0; m < half; ++m) {
+        halfScratch_[m] = std::complex<float>(input[2 * m], input[2 * m + 1]);
+    }
+    Transform(halfScratch_.data(), half, halfBitReverse_, twiddles_.data(), 2, /*inverse=*/false);
+
+    // Split into even/odd spectra and combine with the N-point twiddles.
+    const std::complex<float> minusI(0.0f, -1.0f);
+    for (std::size_t k = 0; k <= half; ++k) {
+        const std::complex<float> zk = halfScratch_[k % half];
+        const std::complex<float> zr = std::conj(halfScratch_[(half - k) % half]);
+        const std::complex<float> even = 0.5f * (zk + zr);
+        const std::complex<float> odd = 0.5f * minusI * (zk - zr);
+        spectrum[k] = even + twiddles_[k] * odd;
+    }
+}
+
+void Fft::inverseReal(const std::complex<float>* spectrum, float* output) {
+    if (!spectrum || !output || halfBitReverse_.empty()) {
+        return;
+    }
+    if (plan_) {
+        plan_->inverse(spectrum, output);
+        return;
+    }
+    const std::size_t half = size_ / 2;
+    const std::complex<float> plusI(0.0f, 1.0f);
+    for (std::size_t k = 0; k < half; ++k) {
+        const std::complex<float> xk = spectrum[k];
+        const std::complex<float> xr = std::conj(spectrum[half - k]);
+        const std::complex<float> even = 0.5f * (xk + xr);
+        const std::complex<float> odd = 0.5f * (xk - xr) * std::conj(twiddles_[k]);
+        halfScratch_[k] = even + plusI * odd;
+    }
+    Transform(halfScratch_.data(), half, halfBitReverse_, twiddles_.data(), 2, /*inverse=*/true);
+
+    const float invHalf = 1.0f / static_cast<float>(half);
+    for (std::size_t m = 0; m < half; ++m) {
+        output[2 * m] = halfScratch_[m].real() * invHalf;
+        output[2 * m + 1] = halfScratch_[m].imag() * invHalf;
+    }
+}
+
 void Fft::transform(std::vector<std::complex<float>>& data, bool inverse) const {
     if (size_ == 0 || data.size() != size_) {
         return;
     }
-    if (bitReverse_.empty()) {
+    Transform(data.data(), size_, bitReverse_, twiddles_.data(), 1, inverse);
+}
+
+void Fft::Transform(std::complex<float>* data, std::size_t n,
+                    const std::vector<std::size_t>& bitReverse,
+                    const std::complex<float>* twiddles, std::size_t twiddleStride,
+                    bool inverse) {
+    if (n == 0 || bitReverse.size() != n) {
         return;
     }
 
     // Bit-reversal permutation.
-    for (std::size_t i = 0; i < size_; ++i) {
-        const std::size_t j = bitReverse_[i];
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t j = bitReverse[i];
         if (j > i) {
             std::swap(data[i], data[j]);
         }
     }
 
-    // Cooley-Tukey (iterative, radix-2).
-    for (std::size_t len = 2; len <= size_; len <<= 1) {
-        const float angSign = inverse ? 1.0f : -1.0f;
-        const float angStep = angSign * (2.0f * kPi / static_cast<float>(len));
-        const std::complex<float> wLen(std::cos(angStep), std::sin(angStep));
+    // twiddles[k * twiddleStride] = exp(-2*pi*i*k/n) for k < n/2.
+    const auto twiddle = [&](std::size_t k) {
+        const std::complex<float> w = twiddles[k * twiddleStride];
+        return inverse ? std::conj(w) : w;
+    };
+
+    std::size_t stages = 0;
+    while ((static_cast<std::size_t>(1) << stages) < n) {
+        ++stages;
+    }
+
+    // Odd stage count: one trivial radix-2 pass first (all twiddles are 1).
+    if (stages & 1u) {
+        for (std::size_t i = 0; i < n; i += 2) {
+            const auto u = data[i];
+            const auto v = data[i + 1];
+            data[i] = u + v;
+            data[i + 1] = u - v;
+        }
+    }
+
+    // Radix-4 passes: each sweep fuses two radix-2 stages (lengths quad/2 and
+    // quad), so the data is touched half as often.
+    for (std::size_t quad = (stages & 1u) ? 8 : 4; quad <= n; quad <<= 2) {
+        const std::size_t quarter = quad >> 2;
+        const std::size_t step = n / quad;
+        // exp(-/+ i*pi/2) = -i forward, +i inverse.
+        const float rot = inverse ? 1.0f : -1.0f;
+        for (std::size_t i = 0; i < n; i += quad) {
+            for (std::size_t j = 0; j < quarter; ++j) {
+                const auto w1 = twiddle(2 * j * step);
+                const auto w2 = twiddle(j * step);
+
+                const auto x0 = data[i + j];
+                const auto x1 = data[i + j + quarter] * w1;
+                const auto x2 = data[i + j + 2 * quarter];
+                const auto x3 = data[i + j + 3 * quarter] * w1;
+
+                const auto a0 = x0 + x1;
+                const auto a1 = x0 - x1;
+                const auto a2 = (x2 + x3) * w2;
+                const auto b3 = (x2 - x3) * w2;
+                // Multiply by -/+i.
+                const std::complex<float> a3(-rot * b3.imag(), rot * b3.real());
 
-        for (std::size_t i = 0; i < size_; i += len) {
-            std::complex<float> w(1.0f, 0.0f);
-            const std::size_t half = len >> 1;
-            for (std::size_t j = 0; j < half; ++j) {
-                const auto u = data[i + j];
-                const auto v = data[i + j + half] * w;
-                data[i + j] = u + v;
-                data[i + j + half] = u - v;
-                w *= wLen;
+                data[i + j] = a0 + a2;
+                data[i + j + 2 * quarter] = a0 - a2;
+                data[i + j + quarter] = a1 + a3;
+                data[i + j + 3 * quarter] = a1 - a3;
             }
         }
     }
@@ -2,31 +2,76 @@
 
 #include <complex>
 #include <cstddef>
+#include <memory>
 #include <vector>
 
 namespace dsp {
 
-// Minimal radix-2 FFT (in-place). Intended for small fixed sizes used by the
-// partitioned convolution reverb. Not a general-purpose FFT API.
+// Minimal radix-4 FFT (in-place) with per-size twiddle tables. Intended for
+// small fixed sizes used by the partitioned convolution reverb. Not a
+// general-purpose FFT API.
+//
+// The real transforms (the convolver's hot path) can be routed to an optimised
+// library picked at configure time with SATORI_FFT_BACKEND (pffft, vdsp); the
+// built-in code remains the fallback for sizes the library rejects.
 class Fft {
 public:
-    explicit Fft(std::size_t size = 0);
+    enum class Backend {
+        Default,  // configured backend, falling back to built-in
+        BuiltIn,  // always the built-in transform
+    };
+
+    explicit Fft(std::size_t size = 0, Backend backend = Backend::Default);
+    ~Fft();
+    Fft(const Fft& other);
+    Fft& operator=(const Fft& other);
+    Fft(Fft&& other) noexcept;
+    Fft& operator=(Fft&& other) noexcept;
 
     void resize(std::size_t size);
     std::size_t size() const { return size_; }
 
+    // Number of bins produced by forwardReal(): size()/2 + 1.
+    std::size_t realBins() const { return size_ >= 2 ? size_ / 2 + 1 : 0; }
+
     // Forward transform (time -> frequency).
     void forward(std::vector<std::complex<float>>& data) const;
     // Inverse transform (frequency -> time). Scales by 1/N.
     void inverse(std::vector<std::complex<float>>& data) const;
 
+    // Real-input forward transform: `input` has size() samples, `spectrum`
+    // receives the non-redundant realBins() bins. Runs one size()/2 complex
+    // transform internally.
+    void forwardReal(const float* input, std::complex<float>* spectrum);
+    // Inverse of forwardReal(): realBins() bins in, size() real samples out.
+    // Scales by 1/N like inverse().
+    void inverseReal(const std::complex<float>* spectrum, float* output);
+
     static bool isPowerOfTwo(std::size_t n);
+    // Name of the configured backend ("builtin", "pffft", "vdsp").
+    static const char* backendName();
+    // True if this instance's real transforms run on the external backend.
+    bool usesExternalBackend() const { return plan_ != nullptr; }
 
 private:
+    struct ExternalPlan;
+
     std::size_t size_ = 0;
+    Backend backend_ = Backend::Default;
+    std::unique_ptr<ExternalPlan> plan_;
     std::vector<std::size_t> bitReverse_;
+    std::vector<std::size_t> halfBitReverse_;
+    std::vector<std::complex<float>> twiddles_;  // exp(-2*pi*i*k/N), k = 0..N/2
+    std::vector<std::complex<float>> halfScratch_;
 
-    void buildBitReverse();
+    static std::vector<std::size_t> BuildBitReverse(std::size_t n);
+    void buildTables();
+    // Radix-4 (with one radix-2 pass for odd log2 n) over a twiddle table
+    // sampled every `twiddleStride` entries.
+    static void Transform(std::complex<float>* data, std::size_t n,
+                          const std::vector<std::size_t>& bitReverse,
+                          const std::complex<float>* twiddles, std::size_t twiddleStride,
+                          bool inverse);
     void transform(std::vector<std::complex<float>>& data, bool inverse) const;
 };
 
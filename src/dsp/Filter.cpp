@@ -2,15 +2,32 @@
 
 #include <algorithm>
 #include <cmath>
+#include <complex>
+
+#include "dsp/FastMath.h"
 
 namespace dsp {
 
 namespace {
+constexpr double kPi = 3.14159265358979323846;
+
 float clamp01(float value) {
     return std::max(0.0f, std::min(1.0f, value));
 }
+
+// Design frequencies stay clear of DC and Nyquist, where the cookbook and
+// tan() prewarping both break down.
+double clampDesignFrequency(double frequencyHz, double sampleRate) {
+    return std::clamp(frequencyHz, 1.0, 0.49 * sampleRate);
+}
 }  // namespace
 
+void Filter::process(const float* input, float* output, std::size_t frames) {
+    for (std::size_t i = 0; i < frames; ++i) {
+        output[i] = process(input[i]);
+    }
+}
+
 OnePoleLowPass::OnePoleLowPass(float alpha)
     : alpha_(clamp01(alpha)), state_(0.0f) {}
 
@@ -23,6 +40,16 @@ float OnePoleLowPass::process(float input) {
     return state_;
 }
 
+void OnePoleLowPass::process(const float* input, float* output, std::size_t frames) {
+    const float a = alpha_;
+    float state = state_;
+    for (std::size_t i = 0; i < frames; ++i) {
+        state = a * input[i] + (1.0f - a) * state;
+        output[i] = state;
+    }
+    state_ = state;
+}
+
 void OnePoleLowPass::reset() {
     state_ = 0.0f;
 }
@@ -42,10 +69,232 @@ float FirstOrderAllPass::process(float input) {
     return y;
 }
 
+void FirstOrderAllPass::process(const float* input, float* output, std::size_t frames) {
+    const float c = coefficient_;
+    float z1 = z1_;
+    for (std::size_t i = 0; i < frames; ++i) {
+        const float x = input[i];
+        const float y = -c * x + z1;
+        z1 = x + c * y;
+        output[i] = y;
+    }
+    z1_ = z1;
+}
+
 void FirstOrderAllPass::reset() {
     z1_ = 0.0f;
 }
 
+void BiquadFilter::design(Type type, double sampleRate, double frequencyHz, double q,
+                          double gainDb) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    const double w0 = 2.0 * kPi * clampDesignFrequency(frequencyHz, sampleRate) / sampleRate;
+    const double cosw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * std::max(q, 1e-3));
+    const double a = std::pow(10.0, gainDb / 40.0);
+    const double shelf = 2.0 * std::sqrt(a) * alpha;
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a0 = 1.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+    switch (type) {
+    case Type::LowPass:
+        b0 = b2 = 0.5 * (1.0 - cosw);
+        b1 = 1.0 - cosw;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    case Type::HighPass:
+        b0 = b2 = 0.5 * (1.0 + cosw);
+        b1 = -(1.0 + cosw);
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    case Type::BandPass:  // 0 dB at the centre
+        b0 = alpha;
+        b2 = -alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    case Type::Notch:
+        b0 = b2 = 1.0;
+        b1 = -2.0 * cosw;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    case Type::AllPass:
+        b0 = 1.0 - alpha;
+        b1 = -2.0 * cosw;
+        b2 = 1.0 + alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha;
+        break;
+    case Type::Peak:
+        b0 = 1.0 + alpha * a;
+        b1 = -2.0 * cosw;
+        b2 = 1.0 - alpha * a;
+        a0 = 1.0 + alpha / a;
+        a1 = -2.0 * cosw;
+        a2 = 1.0 - alpha / a;
+        break;
+    case Type::LowShelf:
+        b0 = a * ((a + 1.0) - (a - 1.0) * cosw + shelf);
+        b1 = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosw);
+        b2 = a * ((a + 1.0) - (a - 1.0) * cosw - shelf);
+        a0 = (a + 1.0) + (a - 1.0) * cosw + shelf;
+        a1 = -2.0 * ((a - 1.0) + (a + 1.0) * cosw);
+        a2 = (a + 1.0) + (a - 1.0) * cosw - shelf;
+        break;
+    case Type::HighShelf:
+        b0 = a * ((a + 1.0) + (a - 1.0) * cosw + shelf);
+        b1 = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosw);
+        b2 = a * ((a + 1.0) + (a - 1.0) * cosw - shelf);
+        a0 = (a + 1.0) - (a - 1.0) * cosw + shelf;
+        a1 = 2.0 * ((a - 1.0) - (a + 1.0) * cosw);
+        a2 = (a + 1.0) - (a - 1.0) * cosw - shelf;
+        break;
+    }
+    setCoefficients(static_cast<float>(b0 / a0), static_cast<float>(b1 / a0),
+                    static_cast<float>(b2 / a0), static_cast<float>(a1 / a0),
+                    static_cast<float>(a2 / a0));
+}
+
+void BiquadFilter::setCoefficients(float b0, float b1, float b2, float a1, float a2) {
+    b0_ = b0;
+    b1_ = b1;
+    b2_ = b2;
+    a1_ = a1;
+    a2_ = a2;
+}
+
+float BiquadFilter::process(float input) {
+    const float y = b0_ * input + z1_;
+    z1_ = b1_ * input - a1_ * y + z2_;
+    z2_ = b2_ * input - a2_ * y;
+    return y;
+}
+
+void BiquadFilter::process(const float* input, float* output, std::size_t frames) {
+    const float b0 = b0_;
+    const float b1 = b1_;
+    const float b2 = b2_;
+    const float a1 = a1_;
+    const float a2 = a2_;
+    float z1 = z1_;
+    float z2 = z2_;
+    for (std::size_t i = 0; i < frames; ++i) {
+        const float x = input[i];
+        const float y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        output[i] = y;
+    }
+    z1_ = z1;
+    z2_ = z2;
+}
+
+void BiquadFilter::reset() {
+    z1_ = 0.0f;
+    z2_ = 0.0f;
+}
+
+double BiquadFilter::magnitude(double frequencyHz, double sampleRate) const {
+    if (sampleRate <= 0.0) {
+        return 1.0;
+    }
+    const std::complex<double> z1 = std::polar(1.0, -2.0 * kPi * frequencyHz / sampleRate);
+    const std::complex<double> z2 = z1 * z1;
+    const std::complex<double> num = static_cast<double>(b0_) +
+                                     static_cast<double>(b1_) * z1 + static_cast<double>(b2_) * z2;
+    const std::complex<double> den =
+        1.0 + static_cast<double>(a1_) * z1 + static_cast<double>(a2_) * z2;
+    return std::abs(num / den);
+}
+
+void StateVariableFilter::design(Type type, double sampleRate, double frequencyHz, double q) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    const double g = FastTan(kPi * clampDesignFrequency(frequencyHz, sampleRate) / sampleRate);
+    const double k = 1.0 / std::max(q, 1e-3);
+    const double a1 = 1.0 / (1.0 + g * (g + k));
+    a1_ = static_cast<float>(a1);
+    a2_ = static_cast<float>(g * a1);
+    a3_ = static_cast<float>(g * g * a1);
+    const auto kf = static_cast<float>(k);
+    switch (type) {
+    case Type::LowPass:
+        setMix(0.0f, 0.0f, 1.0f);
+        break;
+    case Type::HighPass:
+        setMix(1.0f, -kf, -1.0f);
+        break;
+    case Type::BandPass:
+        setMix(0.0f, kf, 0.0f);  // 0 dB at the centre, as BiquadFilter's
+        break;
+    case Type::Notch:
+        setMix(1.0f, -kf, 0.0f);
+        break;
+    case Type::Peak:
+        setMix(1.0f, -kf, -2.0f);
+        break;
+    case Type::AllPass:
+        setMix(1.0f, -2.0f * kf, 0.0f);
+        break;
+    }
+}
+
+void StateVariableFilter::setMix(float input, float band, float low) {
+    m0_ = input;
+    m1_ = band;
+    m2_ = low;
+}
+
+float StateVariableFilter::process(float input) {
+    const float v3 = input - ic2_;
+    const float v1 = a1_ * ic1_ + a2_ * v3;
+    const float v2 = ic2_ + a2_ * ic1_ + a3_ * v3;
+    ic1_ = 2.0f * v1 - ic1_;
+    ic2_ = 2.0f * v2 - ic2_;
+    return m0_ * input + m1_ * v1 + m2_ * v2;
+}
+
+void StateVariableFilter::process(const float* input, float* output, std::size_t frames) {
+    const float a1 = a1_;
+    const float a2 = a2_;
+    const float a3 = a3_;
+    const float m0 = m0_;
+    const float m1 = m1_;
+    const float m2 = m2_;
+    float ic1 = ic1_;
+    float ic2 = ic2_;
+    for (std::size_t i = 0; i < frames; ++i) {
+        const float x = input[i];
+        const float v3 = x - ic2;
+        const float v1 = a1 * ic1 + a2 * v3;
+        const float v2 = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = 2.0f * v1 - ic1;
+        ic2 = 2.0f * v2 - ic2;
+        output[i] = m0 * x + m1 * v1 + m2 * v2;
+    }
+    ic1_ = ic1;
+    ic2_ = ic2;
+}
+
+void StateVariableFilter::reset() {
+    ic1_ = 0.0f;
+    ic2_ = 0.0f;
+}
+
 void FilterChain::addFilter(std::unique_ptr<Filter> filter) {
     filters_.emplace_back(std::move(filter));
 }
@@ -72,4 +321,18 @@ float FilterChain::process(float input) {
     return value;
 }
 
+void FilterChain::process(const float* input, float* output, std::size_t frames) {
+    if (filters_.empty()) {
+        if (input != output) {
+            std::copy(input, input + frames, output);
+        }
+        return;
+    }
+    // The first filter moves the block into `output`; the rest run in place.
+    filters_.front()->process(input, output, frames);
+    for (std::size_t i = 1; i < filters_.size(); ++i) {
+        filters_[i]->process(output, output, frames);
+    }
+}
+
 }  // namespace dsp
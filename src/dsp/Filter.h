@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
 #include <memory>
 #include <vector>
 
@@ -9,28 +13,37 @@ class Filter {
 public:
     virtual ~Filter() = default;
     virtual float process(float input) = 0;
+    // `frames` samples at once; output is identical to calling process()
+    // per sample, and `output` may be `input`. The default does just that;
+    // filters override it with a loop that keeps the state in registers.
+    virtual void process(const float* input, float* output, std::size_t frames);
     virtual void reset() {}
 };
 
-class OnePoleLowPass : public Filter {
+class OnePoleLowPass final : public Filter {
 public:
     explicit OnePoleLowPass(float alpha = 0.5f);
 
     void setAlpha(float alpha);
     float process(float input) override;
+    void process(const float* input, float* output, std::size_t frames) override;
     void reset() override;
+    // The filter's memory, for snapshots.
+    float state() const { return state_; }
+    void setState(float state) { state_ = state; }
 
 private:
     float alpha_;
     float state_;
 };
 
-class FirstOrderAllPass : public Filter {
+class FirstOrderAllPass final : public Filter {
 public:
     explicit FirstOrderAllPass(float coefficient = 0.0f);
 
     void setCoefficient(float coefficient);
     float process(float input) override;
+    void process(const float* input, float* output, std::size_t frames) override;
     void reset() override;
 
 private:
@@ -38,6 +51,64 @@ private:
     float z1_;
 };
 
+// Second-order section in transposed direct form II, designed from the RBJ
+// audio EQ cookbook. Coefficient changes keep the state, so small steps
+// between blocks are fine; sweeps are smoother through StateVariableFilter.
+// Passes audio through until designed.
+class BiquadFilter final : public Filter {
+public:
+    enum class Type { LowPass, HighPass, BandPass, Notch, AllPass, Peak, LowShelf, HighShelf };
+
+    // frequencyHz is kept inside (0, Nyquist) and q above 0; gainDb only
+    // moves Peak and the shelves.
+    void design(Type type, double sampleRate, double frequencyHz, double q,
+                double gainDb = 0.0);
+    // Normalised coefficients (a0 = 1).
+    void setCoefficients(float b0, float b1, float b2, float a1, float a2);
+    float process(float input) override;
+    void process(const float* input, float* output, std::size_t frames) override;
+    void reset() override;
+    // |H| at frequencyHz, e.g. for a response display.
+    double magnitude(double frequencyHz, double sampleRate) const;
+
+private:
+    float b0_ = 1.0f;
+    float b1_ = 0.0f;
+    float b2_ = 0.0f;
+    float a1_ = 0.0f;
+    float a2_ = 0.0f;
+    float z1_ = 0.0f;
+    float z2_ = 0.0f;
+};
+
+// Trapezoidal state-variable filter (Simper's linear SVF): every response
+// comes from one pair of integrators, and the state stays well behaved
+// when the cutoff or resonance moves every block, which makes it the one
+// to modulate. Passes audio through until designed.
+class StateVariableFilter final : public Filter {
+public:
+    enum class Type { LowPass, HighPass, BandPass, Notch, Peak, AllPass };
+
+    // frequencyHz is kept inside (0, Nyquist) and q above 0.
+    void design(Type type, double sampleRate, double frequencyHz, double q);
+    float process(float input) override;
+    void process(const float* input, float* output, std::size_t frames) override;
+    void reset() override;
+
+private:
+    void setMix(float input, float band, float low);
+
+    float a1_ = 1.0f;
+    float a2_ = 0.0f;
+    float a3_ = 0.0f;
+    // Output mix of the input, bandpass and lowpass taps.
+    float m0_ = 1.0f;
+    float m1_ = 0.0f;
+    float m2_ = 0.0f;
+    float ic1_ = 0.0f;
+    float ic2_ = 0.0f;
+};
+
 class FilterChain {
 public:
     void addFilter(std::unique_ptr<Filter> filter);
@@ -45,9 +116,117 @@ public:
     void reset();
     bool empty() const;
     float process(float input);
+    // Each filter runs over the whole block in turn; `output` may be `input`.
+    void process(const float* input, float* output, std::size_t frames);
 
 private:
     std::vector<std::unique_ptr<Filter>> filters_;
 };
 
+// Fixed-topology loop filter: up to MaxAllPass first-order allpass stages
+// followed by an optional one-pole lowpass. Same arithmetic as a FilterChain
+// of FirstOrderAllPass + OnePoleLowPass, but with all state in one flat
+// struct and no virtual dispatch, for use inside feedback loops.
+template <std::size_t MaxAllPass>
+class StringLoopFilter {
+public:
+    static constexpr std::size_t kMaxAllPass = MaxAllPass;
+
+    void clear() {
+        allPassCount_ = 0;
+        lowpassEnabled_ = false;
+        reset();
+    }
+
+    void reset() {
+        state_.allPassZ1.fill(0.0f);
+        state_.lowpassState = 0.0f;
+    }
+
+    bool empty() const { return allPassCount_ == 0 && !lowpassEnabled_; }
+    std::size_t allPassCount() const { return allPassCount_; }
+    bool lowpassEnabled() const { return lowpassEnabled_; }
+
+    // Appends an allpass stage; returns false once all stages are in use.
+    bool addAllPass(float coefficient) {
+        if (allPassCount_ >= MaxAllPass) {
+            return false;
+        }
+        state_.allPassCoeff[allPassCount_] = ClampCoefficient(coefficient);
+        state_.allPassZ1[allPassCount_] = 0.0f;
+        ++allPassCount_;
+        return true;
+    }
+
+    // Retunes an existing stage in place, keeping its state.
+    void setAllPass(std::size_t index, float coefficient) {
+        if (index < allPassCount_) {
+            state_.allPassCoeff[index] = ClampCoefficient(coefficient);
+        }
+    }
+
+    void setLowPass(float alpha) {
+        state_.lowpassAlpha = std::max(0.0f, std::min(1.0f, alpha));
+        lowpassEnabled_ = true;
+    }
+
+    float process(float input) {
+        float value = input;
+        for (std::size_t i = 0; i < allPassCount_; ++i) {
+            const float c = state_.allPassCoeff[i];
+            const float y = -c * value + state_.allPassZ1[i];
+            state_.allPassZ1[i] = value + c * y;
+            value = y;
+        }
+        if (lowpassEnabled_) {
+            const float a = state_.lowpassAlpha;
+            state_.lowpassState = a * value + (1.0f - a) * state_.lowpassState;
+            value = state_.lowpassState;
+        }
+        return value;
+    }
+
+    // process() with the topology fixed at compile time, so the stage loop
+    // unrolls and the lowpass test disappears. Stages and Lowpass must match
+    // allPassCount() and lowpassEnabled(); the arithmetic is identical.
+    template <std::size_t Stages, bool Lowpass>
+    float processFixed(float input) {
+        static_assert(Stages <= MaxAllPass);
+        float value = input;
+        for (std::size_t i = 0; i < Stages; ++i) {
+            const float c = state_.allPassCoeff[i];
+            const float y = -c * value + state_.allPassZ1[i];
+            state_.allPassZ1[i] = value + c * y;
+            value = y;
+        }
+        if constexpr (Lowpass) {
+            const float a = state_.lowpassAlpha;
+            state_.lowpassState = a * value + (1.0f - a) * state_.lowpassState;
+            value = state_.lowpassState;
+        }
+        return value;
+    }
+
+    struct State {
+        std::array<float, MaxAllPass> allPassCoeff{};
+        std::array<float, MaxAllPass> allPassZ1{};
+        float lowpassAlpha = 0.5f;
+        float lowpassState = 0.0f;
+    };
+
+    // Raw state access for lane-parallel kernels that run several filters at once.
+    const State& state() const { return state_; }
+    State& state() { return state_; }
+
+private:
+    static float ClampCoefficient(float coefficient) {
+        const float clamped = std::max(0.0f, std::min(1.0f, std::abs(coefficient)));
+        return (coefficient < 0.0f) ? -clamped : clamped;
+    }
+
+    State state_;
+    std::size_t allPassCount_ = 0;
+    bool lowpassEnabled_ = false;
+};
+
 }  // namespace dsp
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+namespace dsp {
+
+// Serves output buffers of any length from a source that always renders one
+// fixed block size, e.g. a shared-mode device whose free space changes every
+// wakeup. Whole blocks are pulled straight into the output; the part of a
+// block the output had no room for waits here and starts the next call. The
+// source runs ahead by bufferedFrames() and adds no delay. Nothing allocates
+// after configure().
+class FixedBlockStream {
+public:
+    static constexpr std::size_t kMinBlockFrames = 16;
+    static constexpr std::size_t kMaxBlockFrames = 128;
+
+    // The largest power of two within [kMinBlockFrames, kMaxBlockFrames] that
+    // fits one device buffer of `bufferFrames` (0 if unknown), so every
+    // callback renders at least one block.
+    static std::size_t BlockFramesFor(std::size_t bufferFrames) {
+        if (bufferFrames == 0) {
+            return kMaxBlockFrames;
+        }
+        return std::clamp(std::bit_floor(bufferFrames), kMinBlockFrames, kMaxBlockFrames);
+    }
+
+    // Allocates; call off the audio thread. blockFrames 0 passes every
+    // request straight through.
+    void configure(std::size_t blockFrames, std::size_t channels) {
+        blockFrames_ = blockFrames;
+        channels_ = channels;
+        block_.assign(blockFrames * channels, 0.0f);
+        reset();
+    }
+    bool matches(std::size_t blockFrames, std::size_t channels) const {
+        return blockFrames_ == blockFrames && channels_ == channels;
+    }
+    // Drops the rendered frames not yet handed out.
+    void reset() {
+        start_ = 0;
+        buffered_ = 0;
+    }
+
+    std::size_t blockFrames() const { return blockFrames_; }
+    std::size_t channels() const { return channels_; }
+    // Frames the source has rendered past what the output was given.
+    std::size_t bufferedFrames() const { return buffered_; }
+
+    // Writes `frames` interleaved output frames. pull(float* interleaved,
+    // std::size_t frames) is asked for blockFrames() at a time.
+    template <typename Pull>
+    void process(float* output, std::size_t frames, Pull&& pull) {
+        if (channels_ == 0) {
+            return;
+        }
+        if (blockFrames_ == 0) {
+            pull(output, frames);
+            return;
+        }
+        std::size_t done = take(output, frames);
+        while (frames - done >= blockFrames_) {
+            pull(output + done * channels_, blockFrames_);
+            done += blockFrames_;
+        }
+        if (done < frames) {
+            pull(block_.data(), blockFrames_);
+            start_ = 0;
+            buffered_ = blockFrames_;
+            done += take(output + done * channels_, frames - done);
+        }
+    }
+
+private:
+    // Hands out what is left of the last block, up to `frames`.
+    std::size_t take(float* output, std::size_t frames) {
+        const std::size_t count = std::min(frames, buffered_);
+        const float* from = block_.data() + start_ * channels_;
+        std::copy(from, from + count * channels_, output);
+        start_ += count;
+        buffered_ -= count;
+        return count;
+    }
+
+    std::size_t blockFrames_ = 0;
+    std::size_t channels_ = 0;
+    std::vector<float> block_;  // one interleaved block
+    std::size_t start_ = 0;     // first frame of block_ not handed out
+    std::size_t buffered_ = 0;
+};
+
+}  // namespace dsp
@@ -0,0 +1,88 @@
+#include "dsp/Halfband.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dsp/KaiserWindow.h"
+
+namespace dsp {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::array<float, HalfbandTaps::kSideTaps> DesignSideTaps() {
+    std::array<double, HalfbandTaps::kSideTaps> taps{};
+    const double span = static_cast<double>(HalfbandTaps::kCentre + 1);
+    const KaiserWindow window(HalfbandTaps::kKaiserBeta);
+    double sum = 0.0;
+    for (std::size_t k = 0; k < taps.size(); ++k) {
+        const double offset = static_cast<double>(2 * k + 1);
+        const double x = offset / span;
+        const double sinc = std::sin(0.5 * kPi * offset) / (kPi * offset);
+        taps[k] = sinc * window(x);
+        sum += taps[k];
+    }
+    // Unity DC gain: the two sides make up the half the centre leaves.
+    std::array<float, HalfbandTaps::kSideTaps> side{};
+    for (std::size_t k = 0; k < taps.size(); ++k) {
+        side[k] = static_cast<float>(taps[k] * 0.25 / sum);
+    }
+    return side;
+}
+
+}  // namespace
+
+const std::array<float, HalfbandTaps::kSideTaps>& HalfbandTaps::side() {
+    static const std::array<float, kSideTaps> taps = DesignSideTaps();
+    return taps;
+}
+
+void HalfbandDecimator::process(const float* input, float* output, std::size_t frames) {
+    const auto& side = HalfbandTaps::side();
+    constexpr std::size_t kCentre = HalfbandTaps::kCentre;
+    float work[kHistory + 2 * kChunkFrames];
+    std::copy(history_.begin(), history_.end(), work);
+    for (std::size_t done = 0; done < frames;) {
+        const std::size_t chunk = std::min(kChunkFrames, frames - done);
+        std::copy_n(input + 2 * done, 2 * chunk, work + kHistory);
+        for (std::size_t n = 0; n < chunk; ++n) {
+            const float* centre = work + 2 * n + kCentre;
+            float sum = 0.5f * centre[0];
+            for (std::size_t k = 0; k < HalfbandTaps::kSideTaps; ++k) {
+                const std::size_t offset = 2 * k + 1;
+                sum += side[k] * (centre[-static_cast<std::ptrdiff_t>(offset)] + centre[offset]);
+            }
+            output[done + n] = sum;
+        }
+        // The last kHistory inputs stay for the next chunk.
+        std::copy_n(work + 2 * chunk, kHistory, work);
+        done += chunk;
+    }
+    std::copy_n(work, kHistory, history_.begin());
+}
+
+std::size_t UpsampleHalfband(const float* input, std::size_t frames, float* output,
+                             std::size_t maxOutput) {
+    const auto& side = HalfbandTaps::side();
+    const std::size_t count = std::min(2 * frames, maxOutput);
+    for (std::size_t j = 0; j < count; ++j) {
+        const std::size_t n = j / 2;
+        if (j % 2 == 0) {
+            output[j] = 0.5f * input[n];
+            continue;
+        }
+        // Odd outputs fall between inputs n and n + 1; tap k reaches k
+        // inputs further each way.
+        float sum = 0.0f;
+        for (std::size_t k = 0; k < HalfbandTaps::kSideTaps; ++k) {
+            const float before = n >= k ? input[n - k] : 0.0f;
+            const float after = n + 1 + k < frames ? input[n + 1 + k] : 0.0f;
+            sum += side[k] * (before + after);
+        }
+        output[j] = sum;
+    }
+    return count;
+}
+
+}  // namespace dsp
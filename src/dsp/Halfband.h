@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace dsp {
+
+// Linear-phase halfband lowpass for 2x oversampling: a Kaiser-windowed sinc
+// cut at a quarter of the higher rate. Every other tap except the centre
+// (0.5) is zero, so a 63-tap filter costs 16 folded multiply-adds per
+// output sample. Passband to ~0.42 of the lower rate, ~-80 dB stopband
+// from ~0.58.
+struct HalfbandTaps {
+    static constexpr std::size_t kSideTaps = 16;  // non-zero taps per side
+    static constexpr std::size_t kLength = 4 * kSideTaps - 1;
+    static constexpr std::size_t kCentre = kLength / 2;  // delay at the higher rate
+    static constexpr double kKaiserBeta = 8.0;
+
+    // side()[k] multiplies the samples kCentre -/+ (2k + 1) away.
+    static const std::array<float, kSideTaps>& side();
+};
+
+// Streaming 2:1 decimator. Output sample n is the filtered input
+// 2n - kCentre, so the output lags by kCentre / 2 samples of the lower rate.
+class HalfbandDecimator {
+public:
+    static constexpr std::size_t kHistory = HalfbandTaps::kLength - 1;
+
+    void reset() { history_.fill(0.0f); }
+
+    // Reads 2 * frames samples from `input`; `input` and `output` may not
+    // overlap.
+    void process(const float* input, float* output, std::size_t frames);
+
+private:
+    static constexpr std::size_t kChunkFrames = 128;
+
+    std::array<float, kHistory> history_{};
+};
+
+// 1:2 interpolation of a whole buffer (e.g. an impulse response moving to a
+// voice's oversampled rate), with the filter delay taken out: output 2n
+// lines up with input n. Values are halved so a response keeps its DC sum,
+// i.e. convolving at the higher rate gives the same gain. Writes
+// min(2 * frames, maxOutput) samples and returns that count.
+std::size_t UpsampleHalfband(const float* input, std::size_t frames, float* output,
+                             std::size_t maxOutput);
+
+}  // namespace dsp
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cmath>
+
+namespace dsp {
+
+// Modified Bessel function of the first kind, order 0 (power series).
+inline double BesselI0(double x) {
+    const double q = 0.25 * x * x;
+    double term = 1.0;
+    double sum = 1.0;
+    for (int k = 1; k < 64 && term > 1.0e-12 * sum; ++k) {
+        term *= q / (static_cast<double>(k) * static_cast<double>(k));
+        sum += term;
+    }
+    return sum;
+}
+
+// Kaiser window for filter design, evaluated at x in [-1, 1] (0 at the
+// centre) and normalised to 1 there: I0(beta * sqrt(1 - x^2)) / I0(beta).
+class KaiserWindow {
+public:
+    explicit KaiserWindow(double beta) : beta_(beta), norm_(1.0 / BesselI0(beta)) {}
+
+    double operator()(double x) const {
+        return BesselI0(beta_ * std::sqrt(1.0 - x * x)) * norm_;
+    }
+
+private:
+    double beta_;
+    double norm_;
+};
+
+}  // namespace dsp
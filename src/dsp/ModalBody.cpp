@@ -0,0 +1,218 @@
+#include "dsp/ModalBody.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dsp/Simd.h"
+#include "dsp/StateSnapshot.h"
+
+namespace dsp {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Flat-top steel-string guitar: the Helmholtz air mode, the first top and
+// back plate modes, then a thinning cluster of higher plate modes.
+constexpr std::array<ModalBody::Mode, 16> kGuitarModes = {{
+    {100.0f, 0.25f, 2.0f},  {205.0f, 0.22f, 2.4f},  {245.0f, 0.20f, 1.2f},
+    {290.0f, 0.18f, 0.9f},  {380.0f, 0.16f, 1.1f},  {450.0f, 0.15f, 0.8f},
+    {540.0f, 0.13f, 0.9f},  {650.0f, 0.12f, 0.7f},  {780.0f, 0.10f, 0.6f},
+    {920.0f, 0.09f, 0.55f}, {1100.0f, 0.08f, 0.5f}, {1350.0f, 0.07f, 0.45f},
+    {1650.0f, 0.06f, 0.4f}, {2000.0f, 0.05f, 0.35f}, {2500.0f, 0.04f, 0.3f},
+    {3200.0f, 0.035f, 0.25f},
+}};
+
+// Koto: a long, thin paulownia box with lower, denser and longer-ringing
+// modes than the guitar.
+constexpr std::array<ModalBody::Mode, 16> kKotoModes = {{
+    {85.0f, 0.35f, 1.6f},   {140.0f, 0.30f, 1.8f},  {190.0f, 0.28f, 1.4f},
+    {260.0f, 0.25f, 1.5f},  {330.0f, 0.22f, 1.2f},  {410.0f, 0.20f, 1.1f},
+    {500.0f, 0.18f, 1.0f},  {600.0f, 0.16f, 0.9f},  {720.0f, 0.14f, 0.8f},
+    {860.0f, 0.12f, 0.7f},  {1020.0f, 0.10f, 0.6f}, {1250.0f, 0.09f, 0.55f},
+    {1500.0f, 0.08f, 0.5f}, {1850.0f, 0.07f, 0.45f}, {2300.0f, 0.06f, 0.4f},
+    {2900.0f, 0.05f, 0.35f},
+}};
+
+// Gains are tilted around this frequency by bodyTone.
+constexpr double kTiltPivotHz = 500.0;
+// Resonator state below this (-400 dB) is flushed to zero.
+constexpr float kSilentState = 1e-20f;
+
+}  // namespace
+
+std::span<const ModalBody::Mode> ModalBody::PresetModes(Preset preset) {
+    switch (preset) {
+    case Preset::Koto:
+        return kKotoModes;
+    case Preset::Guitar:
+    default:
+        return kGuitarModes;
+    }
+}
+
+ModalBody::ModalBody() {
+    setModes(kGuitarModes);
+}
+
+void ModalBody::setSampleRate(double sampleRate) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    sampleRate_ = sampleRate;
+    updateCoefficients();
+    reset();
+}
+
+void ModalBody::setModes(std::span<const Mode> modes) {
+    modeCount_ = std::min(modes.size(), kMaxModes);
+    std::copy_n(modes.begin(), modeCount_, modes_.begin());
+    std::fill(modes_.begin() + static_cast<std::ptrdiff_t>(modeCount_), modes_.end(), Mode{});
+    groupCount_ = (modeCount_ + simd::kLanes - 1) / simd::kLanes;
+    updateCoefficients();
+    reset();
+}
+
+void ModalBody::setShape(float tone, float size) {
+    tone_ = std::clamp(tone, 0.0f, 1.0f);
+    size_ = std::clamp(size, 0.0f, 1.0f);
+    updateCoefficients();
+}
+
+void ModalBody::reset() {
+    left_ = State{};
+    right_ = State{};
+    rightLive_ = false;
+}
+
+void ModalBody::saveState(StateWriter& out) const {
+    out.pod(modeCount_);
+    out.pod(left_);
+    out.pod(right_);
+    out.pod(rightLive_);
+}
+
+bool ModalBody::loadState(StateReader& in) {
+    std::size_t modes = 0;
+    if (in.pod(modes) && modes != modeCount_) {
+        in.fail();
+    }
+    in.pod(left_);
+    in.pod(right_);
+    in.pod(rightLive_);
+    if (!in.ok()) {
+        reset();
+    }
+    return in.ok();
+}
+
+void ModalBody::updateCoefficients() {
+    const double frequencyScale = std::exp2((0.5 - static_cast<double>(size_)) * 1.0);
+    const double decayScale = 0.7 + 0.6 * static_cast<double>(size_);
+    const double tilt = (static_cast<double>(tone_) - 0.5) * 1.5;
+    double modeEnergy = 0.0;
+    for (std::size_t m = 0; m < kMaxModes; ++m) {
+        b_[m] = 0.0f;
+        a1_[m] = 0.0f;
+        a2_[m] = 0.0f;
+        const Mode& mode = modes_[m];
+        const double frequency = static_cast<double>(mode.frequencyHz) * frequencyScale;
+        const double decay = static_cast<double>(mode.decaySeconds) * decayScale;
+        if (m >= modeCount_ || frequency <= 0.0 || frequency >= 0.45 * sampleRate_ ||
+            decay <= 0.0 || mode.gain == 0.0f) {
+            continue;
+        }
+        const double r = std::pow(10.0, -3.0 / (decay * sampleRate_));
+        const double w = 2.0 * kPi * frequency / sampleRate_;
+        const double gain = static_cast<double>(mode.gain) *
+                            std::clamp(std::pow(frequency / kTiltPivotHz, tilt), 0.25, 4.0);
+        // Peak gain of b (1 - z^-2) / (1 - a1 z^-1 + a2 z^-2) is ~b / (1 - r).
+        const double b = gain * (1.0 - r);
+        b_[m] = static_cast<float>(b);
+        a1_[m] = static_cast<float>(2.0 * r * std::cos(w));
+        a2_[m] = static_cast<float>(r * r);
+        // Impulse energy of that filter: 2 b^2 / (1 - r^2).
+        modeEnergy += 2.0 * b * b / (1.0 - r * r);
+    }
+    outputScale_ = static_cast<float>(1.0 / std::sqrt(1.0 + modeEnergy));
+}
+
+void ModalBody::processBlock(float* left, float* right, std::size_t frames) {
+    if (!left || groupCount_ == 0) {
+        return;
+    }
+    if (right && !rightLive_) {
+        right_ = left_;
+    }
+    rightLive_ = right != nullptr;
+    processChannel(left, frames, left_);
+    if (right) {
+        processChannel(right, frames, right_);
+    }
+}
+
+void ModalBody::processChannel(float* samples, std::size_t frames, State& state) const {
+    using simd::Float4;
+    constexpr std::size_t kGroups = kMaxModes / simd::kLanes;
+    Float4 b[kGroups];
+    Float4 a1[kGroups];
+    Float4 a2[kGroups];
+    Float4 y1[kGroups];
+    Float4 y2[kGroups];
+    const std::size_t groups = groupCount_;
+    for (std::size_t g = 0; g < groups; ++g) {
+        const std::size_t offset = g * simd::kLanes;
+        b[g] = simd::Load(b_.data() + offset);
+        a1[g] = simd::Load(a1_.data() + offset);
+        a2[g] = simd::Load(a2_.data() + offset);
+        y1[g] = simd::Load(state.y1.data() + offset);
+        y2[g] = simd::Load(state.y2.data() + offset);
+    }
+    float x1 = state.x1;
+    float x2 = state.x2;
+    const float scale = outputScale_;
+    alignas(16) float lanes[simd::kLanes];
+    for (std::size_t n = 0; n < frames; ++n) {
+        const float x = samples[n];
+        const Float4 drive = simd::Set1(x - x2);
+        Float4 sum = simd::Set1(0.0f);
+        for (std::size_t g = 0; g < groups; ++g) {
+            const Float4 y = simd::Sub(simd::Add(simd::Mul(b[g], drive), simd::Mul(a1[g], y1[g])),
+                                       simd::Mul(a2[g], y2[g]));
+            y2[g] = y1[g];
+            y1[g] = y;
+            sum = simd::Add(sum, y);
+        }
+        simd::Store(lanes, sum);
+        samples[n] = (x + ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]))) * scale;
+        x2 = x1;
+        x1 = x;
+    }
+    for (std::size_t g = 0; g < groups; ++g) {
+        const std::size_t offset = g * simd::kLanes;
+        simd::Store(state.y1.data() + offset, y1[g]);
+        simd::Store(state.y2.data() + offset, y2[g]);
+    }
+    // Silent modes would decay into subnormals on threads without FTZ.
+    for (std::size_t m = 0; m < groups * simd::kLanes; ++m) {
+        if (std::abs(state.y1[m]) < kSilentState && std::abs(state.y2[m]) < kSilentState) {
+            state.y1[m] = 0.0f;
+            state.y2[m] = 0.0f;
+        }
+    }
+    state.x1 = x1;
+    state.x2 = x2;
+}
+
+void ModalBody::impulseResponse(float* out, std::size_t frames) const {
+    if (!out || frames == 0) {
+        return;
+    }
+    ModalBody probe = *this;
+    probe.reset();
+    std::fill(out, out + frames, 0.0f);
+    out[0] = 1.0f;
+    probe.processBlock(out, frames);
+}
+
+}  // namespace dsp
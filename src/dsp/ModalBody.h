@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+
+namespace dsp {
+
+class StateReader;
+class StateWriter;
+
+// Instrument body as a bank of two-pole resonators, one per mode, summed on
+// top of the dry signal. Each mode is
+//     y[n] = b (x[n] - x[n-2]) + a1 y[n-1] - a2 y[n-2],
+// a bandpass with `gain` at its peak and a -60 dB decay after decaySeconds.
+// Modes run four to a simd::Float4, so the cost grows by one lane group per
+// four modes. bodySize scales every frequency (bigger is lower and rings
+// longer); bodyTone tilts the gains towards the low or high modes.
+class ModalBody {
+public:
+    static constexpr std::size_t kMaxModes = 64;
+
+    struct Mode {
+        float frequencyHz = 0.0f;
+        float decaySeconds = 0.0f;
+        float gain = 0.0f;
+    };
+
+    enum class Preset { Guitar, Koto };
+
+    // Built-in mode tables (static storage).
+    static std::span<const Mode> PresetModes(Preset preset);
+
+    ModalBody();
+
+    void setSampleRate(double sampleRate);
+    // Takes the first kMaxModes modes; resets the resonators.
+    void setModes(std::span<const Mode> modes);
+    // tone and size in [0, 1]; keeps the resonator state.
+    void setShape(float tone, float size);
+    std::size_t modeCount() const { return modeCount_; }
+    void reset();
+    // Resonator state for snapshots; the modes and shape are the caller's to
+    // set up first. loadState() is false (and resets) if the mode count
+    // differs.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    // In place: dry plus the modes, scaled so a unit impulse keeps roughly
+    // unit energy.
+    void processBlock(float* samples, std::size_t frames) {
+        processBlock(samples, nullptr, frames);
+    }
+    // Both channels through the same modes, each with its own state; a null
+    // `right` runs mono. The right state starts as a copy of the left, so a
+    // mono signal can turn stereo without a click.
+    void processBlock(float* left, float* right, std::size_t frames);
+
+    // The first `frames` samples of the impulse response at the current
+    // settings. Not for the audio thread with long outputs.
+    void impulseResponse(float* out, std::size_t frames) const;
+
+private:
+    struct State {
+        alignas(16) std::array<float, kMaxModes> y1{};
+        alignas(16) std::array<float, kMaxModes> y2{};
+        float x1 = 0.0f;
+        float x2 = 0.0f;
+    };
+
+    void updateCoefficients();
+    void processChannel(float* samples, std::size_t frames, State& state) const;
+
+    std::array<Mode, kMaxModes> modes_{};
+    std::size_t modeCount_ = 0;
+    std::size_t groupCount_ = 0;  // lane groups in use
+    // Per-mode coefficients and state, zero past modeCount_.
+    alignas(16) std::array<float, kMaxModes> b_{};
+    alignas(16) std::array<float, kMaxModes> a1_{};
+    alignas(16) std::array<float, kMaxModes> a2_{};
+    State left_;
+    State right_;
+    bool rightLive_ = false;  // right_ tracked the last block
+    float outputScale_ = 1.0f;
+    float tone_ = 0.5f;
+    float size_ = 0.5f;
+    double sampleRate_ = 44100.0;
+};
+
+}  // namespace dsp
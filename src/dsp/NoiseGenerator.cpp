@@ -0,0 +1,81 @@
+#include "dsp/NoiseGenerator.h"
+
+#include <algorithm>
+
+namespace dsp {
+
+namespace {
+
+constexpr std::uint32_t kOneBits = 0x3F800000u;  // 1.0f
+constexpr std::uint32_t kSignBit = 0x80000000u;
+
+simd::UInt4 Xorshift(simd::UInt4 s) {
+    s = simd::Xor(s, simd::ShiftLeft<13>(s));
+    s = simd::Xor(s, simd::ShiftRight<17>(s));
+    return simd::Xor(s, simd::ShiftLeft<5>(s));
+}
+
+// Steps every lane once per four outputs; `convert` maps the lane bits to
+// samples. A partial last step writes only `count % 4` of them.
+template <typename Convert>
+void Fill(std::uint32_t* state, float* out, std::size_t count, Convert convert) {
+    simd::UInt4 s = simd::Load(state);
+    std::size_t i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        s = Xorshift(s);
+        simd::Store(out + i, convert(s));
+    }
+    if (i < count) {
+        s = Xorshift(s);
+        alignas(16) float tail[simd::kLanes];
+        simd::Store(tail, convert(s));
+        std::copy(tail, tail + (count - i), out + i);
+    }
+    simd::Store(state, s);
+}
+
+}  // namespace
+
+NoiseGenerator::NoiseGenerator(std::uint32_t seed) {
+    std::uint64_t z = static_cast<std::uint64_t>(seed);
+    for (auto& lane : state_) {
+        z += 0x9E3779B97F4A7C15ull;
+        std::uint64_t x = z;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        lane = static_cast<std::uint32_t>(x >> 32) | 1u;  // xorshift state must be non-zero
+    }
+}
+
+void NoiseGenerator::fillUniform(float* out, std::size_t count) {
+    if (!out) {
+        return;
+    }
+    // The top 23 bits as a mantissa give [1, 2); 2x - 3 maps that exactly
+    // onto [-1, 1).
+    Fill(state_.data(), out, count, [](simd::UInt4 s) {
+        const simd::Float4 x =
+            simd::BitCast(simd::Or(simd::ShiftRight<9>(s), simd::Set1U32(kOneBits)));
+        return simd::Sub(simd::Mul(x, simd::Set1(2.0f)), simd::Set1(3.0f));
+    });
+}
+
+void NoiseGenerator::fillBinary(float* out, std::size_t count) {
+    if (!out) {
+        return;
+    }
+    // The top bit becomes the sign of 1.0f.
+    Fill(state_.data(), out, count, [](simd::UInt4 s) {
+        return simd::BitCast(
+            simd::Or(simd::And(s, simd::Set1U32(kSignBit)), simd::Set1U32(kOneBits)));
+    });
+}
+
+std::uint32_t NoiseGenerator::nextSeed() {
+    simd::UInt4 s = Xorshift(simd::Load(state_.data()));
+    simd::Store(state_.data(), s);
+    return state_[0];
+}
+
+}  // namespace dsp
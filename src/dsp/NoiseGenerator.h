@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "dsp/Simd.h"
+
+namespace dsp {
+
+// Excitation noise: four xorshift32 streams, one per simd lane, seeded from
+// one 32-bit seed through splitmix64. Construction is a handful of multiplies
+// and a block fill makes four samples per step with shifts and xors only, so
+// a burst costs well under a nanosecond per sample. A given seed gives the
+// same samples with and without SSE2.
+class NoiseGenerator {
+public:
+    explicit NoiseGenerator(std::uint32_t seed);
+
+    // Uniform in [-1, 1).
+    void fillUniform(float* out, std::size_t count);
+    // +1 or -1 with equal odds.
+    void fillBinary(float* out, std::size_t count);
+    // Seed for the burst after this one.
+    std::uint32_t nextSeed();
+
+private:
+    alignas(16) std::array<std::uint32_t, simd::kLanes> state_{};
+};
+
+}  // namespace dsp
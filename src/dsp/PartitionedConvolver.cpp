@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cmath>
 
+#include "dsp/StateSnapshot.h"
+
 namespace dsp {
 
 void PartitionedConvolver::configure(std::size_t blockSize,
@@ -14,42 +16,111 @@ void PartitionedConvolver::configure(std::size_t blockSize,
     ringIndex_ = 0;
 
     fft_.resize(fftSize_);
+    binCount_ = fft_.realBins();
+    binStride_ = AlignedStride(binCount_);
+    mac_ = GetComplexMac();
+    macStereo_ = GetComplexMacStereo();
 
-    xRing_.assign(ringSize_, std::vector<std::complex<float>>(fftSize_));
-    workTime_.assign(fftSize_, {});
-    workFreq_.assign(fftSize_, {});
-    accFreq_.assign(fftSize_, {});
+    xRing_.assign(ringSize_ * binStride_);
+    slotSilent_.assign(ringSize_, 1);
+    silentSlots_ = ringSize_;
+    workTime_.assign(fftSize_, 0.0f);
+    workFreq_.assign(binCount_, {});
+    accFreq_.assign(binStride_);
+    accFreqR_.assign(binStride_);
     overlap_.assign(blockSize_, 0.0f);
 }
 
+std::size_t PartitionedConvolver::heapBytes() const {
+    return (xRing_.re.capacity() + xRing_.im.capacity() + accFreq_.re.capacity() +
+            accFreq_.im.capacity() + accFreqR_.re.capacity() + accFreqR_.im.capacity() +
+            workTime_.capacity() + overlap_.capacity()) *
+               sizeof(float) +
+           workFreq_.capacity() * sizeof(std::complex<float>) + slotSilent_.capacity();
+}
+
 void PartitionedConvolver::reset() {
-    for (auto& frame : xRing_) {
-        std::fill(frame.begin(), frame.end(), std::complex<float>(0.0f, 0.0f));
-    }
+    xRing_.clear();
+    std::fill(slotSilent_.begin(), slotSilent_.end(), 1);
+    silentSlots_ = ringSize_;
     std::fill(overlap_.begin(), overlap_.end(), 0.0f);
     ringIndex_ = 0;
 }
 
+void PartitionedConvolver::saveState(StateWriter& out) const {
+    out.pod(xRing_.size());
+    out.floats(xRing_.re.data(), xRing_.size());
+    out.floats(xRing_.im.data(), xRing_.size());
+    out.pod(ringIndex_);
+    for (const unsigned char silent : slotSilent_) {
+        out.pod(silent);
+    }
+    out.pod(silentSlots_);
+    out.pod(overlap_.size());
+    out.floats(overlap_.data(), overlap_.size());
+}
+
+bool PartitionedConvolver::loadState(StateReader& in) {
+    std::size_t ringFloats = 0;
+    if (in.pod(ringFloats) && ringFloats != xRing_.size()) {
+        in.fail();
+    }
+    in.floats(xRing_.re.data(), xRing_.size());
+    in.floats(xRing_.im.data(), xRing_.size());
+    if (in.pod(ringIndex_) && ringSize_ > 0 && ringIndex_ >= ringSize_) {
+        in.fail();
+    }
+    for (unsigned char& silent : slotSilent_) {
+        in.pod(silent);
+    }
+    in.pod(silentSlots_);
+    std::size_t overlap = 0;
+    if (in.pod(overlap) && overlap != overlap_.size()) {
+        in.fail();
+    }
+    in.floats(overlap_.data(), overlap_.size());
+    if (!in.ok()) {
+        reset();
+    }
+    return in.ok();
+}
+
 void PartitionedConvolver::pushInputBlock(const float* input) {
-    if (!input || blockSize_ == 0 || fftSize_ == 0 || xRing_.empty()) {
+    if (!input || blockSize_ == 0 || binCount_ == 0 || ringSize_ == 0) {
         return;
     }
 
-    // Time buffer (zero-padded).
-    for (std::size_t i = 0; i < blockSize_; ++i) {
-        workTime_[i] = std::complex<float>(input[i], 0.0f);
+    // Store in ring (split layout), one slot below the previous newest.
+    ringIndex_ = (ringIndex_ == 0 ? ringSize_ : ringIndex_) - 1;
+    float* dstRe = xRing_.re.data() + ringIndex_ * binStride_;
+    float* dstIm = xRing_.im.data() + ringIndex_ * binStride_;
+    unsigned char& silent = slotSilent_[ringIndex_];
+
+    // A silent block has a zero spectrum: skip the transform, and the row
+    // only needs clearing if it last held sound.
+    if (std::all_of(input, input + blockSize_, [](float v) { return v == 0.0f; })) {
+        if (!silent) {
+            std::fill(dstRe, dstRe + binStride_, 0.0f);
+            std::fill(dstIm, dstIm + binStride_, 0.0f);
+            silent = 1;
+            ++silentSlots_;
+        }
+        return;
     }
-    for (std::size_t i = blockSize_; i < fftSize_; ++i) {
-        workTime_[i] = std::complex<float>(0.0f, 0.0f);
+    if (silent) {
+        silent = 0;
+        --silentSlots_;
     }
 
-    workFreq_ = workTime_;
-    fft_.forward(workFreq_);
+    // Time buffer (zero-padded).
+    std::copy(input, input + blockSize_, workTime_.begin());
+    std::fill(workTime_.begin() + static_cast<std::ptrdiff_t>(blockSize_), workTime_.end(), 0.0f);
 
-    // Store in ring.
-    auto& dst = xRing_[ringIndex_];
-    dst = workFreq_;
-    ringIndex_ = (ringIndex_ + 1) % ringSize_;
+    fft_.forwardReal(workTime_.data(), workFreq_.data());
+    for (std::size_t k = 0; k < binCount_; ++k) {
+        dstRe[k] = workFreq_[k].real();
+        dstIm[k] = workFreq_[k].imag();
+    }
 }
 
 void PartitionedConvolver::convolve(const ConvolutionKernel& kernel, float* out) {
@@ -59,42 +130,145 @@ void PartitionedConvolver::convolve(const ConvolutionKernel& kernel, float* out)
 void PartitionedConvolver::convolveWithOverlap(const ConvolutionKernel& kernel,
                                                float* out,
                                                std::vector<float>& overlap) {
-    if (!out || blockSize_ == 0 || fftSize_ == 0 || xRing_.empty()) {
+    if (!out || blockSize_ == 0 || binCount_ == 0 || ringSize_ == 0) {
         return;
     }
-    if (kernel.partitions.empty()) {
+    if (kernel.empty() || kernel.binStride != binStride_) {
         std::fill(out, out + blockSize_, 0.0f);
         return;
     }
-    if (overlap.size() != blockSize_) {
-        overlap.assign(blockSize_, 0.0f);
+
+    accFreq_.clear();
+    accumulate(kernel, accFreq_, 0, kernel.partitionCount);
+    finish(accFreq_, out, overlap);
+}
+
+void PartitionedConvolver::accumulate(const ConvolutionKernel& kernel,
+                                      SplitComplex& acc,
+                                      std::size_t firstPartition,
+                                      std::size_t endPartition) const {
+    if (ringSize_ == 0 || kernel.binStride != binStride_ || acc.size() != binStride_) {
+        return;
+    }
+    endPartition = std::min({endPartition, kernel.partitionCount, ringSize_});
+    if (firstPartition >= endPartition) {
+        return;
+    }
+
+    // Partition p pairs with history slot ringIndex_ + p (newest first), so
+    // both slabs are walked forward with a single wrap of the history.
+    const float* hRe = kernel.partitionRe(firstPartition);
+    const float* hIm = kernel.partitionIm(firstPartition);
+    std::size_t slot = (ringIndex_ + firstPartition) % ringSize_;
+    for (std::size_t p = firstPartition; p < endPartition; ++p) {
+        if (!slotSilent_[slot]) {
+            const float* xRe = xRing_.re.data() + slot * binStride_;
+            const float* xIm = xRing_.im.data() + slot * binStride_;
+            mac_(xRe, xIm, hRe, hIm, acc.re.data(), acc.im.data(), binStride_);
+        }
+        hRe += binStride_;
+        hIm += binStride_;
+        if (++slot == ringSize_) {
+            slot = 0;
+        }
     }
+}
 
-    const std::size_t partCount = kernel.partitions.size();
-    std::fill(accFreq_.begin(), accFreq_.end(), std::complex<float>(0.0f, 0.0f));
+void PartitionedConvolver::convolveStereoWithOverlap(const ConvolutionKernel& left,
+                                                     const ConvolutionKernel& right,
+                                                     float* outL,
+                                                     float* outR,
+                                                     std::vector<float>& overlapL,
+                                                     std::vector<float>& overlapR) {
+    if (!outL || !outR || blockSize_ == 0 || binCount_ == 0 || ringSize_ == 0) {
+        return;
+    }
+    if (left.binStride != binStride_ || right.binStride != binStride_) {
+        convolveWithOverlap(left, outL, overlapL);
+        convolveWithOverlap(right, outR, overlapR);
+        return;
+    }
 
-    // ringIndex_ points to the next write; most recent block is ringIndex_-1.
-    for (std::size_t p = 0; p < partCount; ++p) {
-        const std::size_t idx =
-            (ringIndex_ + ringSize_ - 1 - p) % ringSize_;
-        const auto& X = xRing_[idx];
-        const auto& H = kernel.partitions[p];
-        if (H.size() != fftSize_ || X.size() != fftSize_) {
-            continue;
+    accFreq_.clear();
+    accFreqR_.clear();
+    accumulateStereo(left, right, accFreq_, accFreqR_, 0,
+                     std::max(left.partitionCount, right.partitionCount));
+    finish(accFreq_, outL, overlapL);
+    finish(accFreqR_, outR, overlapR);
+}
+
+void PartitionedConvolver::accumulateStereo(const ConvolutionKernel& left,
+                                            const ConvolutionKernel& right,
+                                            SplitComplex& accL,
+                                            SplitComplex& accR,
+                                            std::size_t firstPartition,
+                                            std::size_t endPartition) const {
+    if (ringSize_ == 0 || left.binStride != binStride_ || right.binStride != binStride_ ||
+        accL.size() != binStride_ || accR.size() != binStride_) {
+        return;
+    }
+    // The shared range runs through the stereo kernel; any excess of the
+    // longer channel falls back to the mono one.
+    const std::size_t shared =
+        std::min({endPartition, left.partitionCount, right.partitionCount, ringSize_});
+    if (shared < endPartition) {
+        accumulate(left, accL, std::max(firstPartition, shared), endPartition);
+        accumulate(right, accR, std::max(firstPartition, shared), endPartition);
+    }
+    if (firstPartition >= shared) {
+        return;
+    }
+
+    const float* lRe = left.partitionRe(firstPartition);
+    const float* lIm = left.partitionIm(firstPartition);
+    const float* rRe = right.partitionRe(firstPartition);
+    const float* rIm = right.partitionIm(firstPartition);
+    std::size_t slot = (ringIndex_ + firstPartition) % ringSize_;
+    for (std::size_t p = firstPartition; p < shared; ++p) {
+        if (!slotSilent_[slot]) {
+            const float* xRe = xRing_.re.data() + slot * binStride_;
+            const float* xIm = xRing_.im.data() + slot * binStride_;
+            macStereo_(xRe, xIm, lRe, lIm, rRe, rIm, accL.re.data(), accL.im.data(),
+                       accR.re.data(), accR.im.data(), binStride_);
         }
-        for (std::size_t k = 0; k < fftSize_; ++k) {
-            accFreq_[k] += X[k] * H[k];
+        lRe += binStride_;
+        lIm += binStride_;
+        rRe += binStride_;
+        rIm += binStride_;
+        if (++slot == ringSize_) {
+            slot = 0;
         }
     }
+}
 
-    workTime_ = accFreq_;
-    fft_.inverse(workTime_);
+void PartitionedConvolver::finish(SplitComplex& acc, float* out, std::vector<float>& overlap) {
+    if (overlap.size() != blockSize_) {
+        overlap.assign(blockSize_, 0.0f);
+    }
+    finish(acc, out, overlap.data());
+}
+
+void PartitionedConvolver::finish(SplitComplex& acc, float* out, float* overlap) {
+    if (!out || !overlap || blockSize_ == 0 || binCount_ == 0 || acc.size() != binStride_) {
+        return;
+    }
+    if (historySilent()) {
+        // Nothing was accumulated, so the inverse transform would be zero.
+        std::copy(overlap, overlap + blockSize_, out);
+        std::fill(overlap, overlap + blockSize_, 0.0f);
+        return;
+    }
+
+    for (std::size_t k = 0; k < binCount_; ++k) {
+        workFreq_[k] = std::complex<float>(acc.re[k], acc.im[k]);
+    }
+    acc.clear();
+    fft_.inverseReal(workFreq_.data(), workTime_.data());
 
     // Overlap-add: output first block, keep second block as overlap.
     for (std::size_t i = 0; i < blockSize_; ++i) {
-        const float v = workTime_[i].real();
-        out[i] = v + overlap[i];
-        overlap[i] = workTime_[i + blockSize_].real();
+        out[i] = workTime_[i] + overlap[i];
+        overlap[i] = workTime_[i + blockSize_];
     }
 }
 
@@ -107,25 +281,29 @@ ConvolutionKernel PartitionedConvolver::buildKernelFromIr(const std::vector<floa
     }
     const std::size_t partCount =
         (ir.size() + blockSize - 1) / blockSize;
-    kernel.partitions.assign(partCount, std::vector<std::complex<float>>(fftSize));
 
     Fft fft(fftSize);
-    std::vector<std::complex<float>> time(fftSize);
+    const std::size_t bins = fft.realBins();
+    kernel.partitionCount = partCount;
+    kernel.binStride = AlignedStride(bins);
+    kernel.spectra.assign(partCount * kernel.binStride);
+    std::vector<float> time(fftSize);
+    std::vector<std::complex<float>> freq(bins);
     for (std::size_t p = 0; p < partCount; ++p) {
         const std::size_t offset = p * blockSize;
         const std::size_t copyCount =
             std::min(blockSize, ir.size() - offset);
 
-        for (std::size_t i = 0; i < copyCount; ++i) {
-            time[i] = std::complex<float>(ir[offset + i], 0.0f);
-        }
-        for (std::size_t i = copyCount; i < fftSize; ++i) {
-            time[i] = std::complex<float>(0.0f, 0.0f);
-        }
+        std::fill(time.begin(), time.end(), 0.0f);
+        std::copy_n(ir.begin() + static_cast<std::ptrdiff_t>(offset), copyCount, time.begin());
 
-        auto freq = time;
-        fft.forward(freq);
-        kernel.partitions[p] = std::move(freq);
+        fft.forwardReal(time.data(), freq.data());
+        float* re = kernel.spectra.re.data() + p * kernel.binStride;
+        float* im = kernel.spectra.im.data() + p * kernel.binStride;
+        for (std::size_t k = 0; k < bins; ++k) {
+            re[k] = freq[k].real();
+            im[k] = freq[k].imag();
+        }
     }
     return kernel;
 }
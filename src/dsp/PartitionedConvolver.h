@@ -4,13 +4,48 @@
 #include <cstddef>
 #include <vector>
 
+#include "dsp/ComplexMac.h"
 #include "dsp/Fft.h"
 
 namespace dsp {
 
+class StateReader;
+class StateWriter;
+
 struct ConvolutionKernel {
-    // Frequency-domain partitions. Each partition has fftSize bins.
-    std::vector<std::vector<std::complex<float>>> partitions;
+    // Frequency-domain partitions in one partition-major slab. Each row holds
+    // the fftSize/2 + 1 non-redundant bins of a real transform, zero-padded to
+    // binStride, stored split re/im for the vectorised multiply-accumulate.
+    std::size_t partitionCount = 0;
+    std::size_t binStride = 0;
+    SplitComplex spectra;  // partitionCount x binStride
+
+    // Set instead of `spectra` for kernels that view static data (e.g.
+    // spectra generated at build time); both must be 64-byte aligned.
+    const float* viewRe = nullptr;
+    const float* viewIm = nullptr;
+
+    static ConvolutionKernel View(const float* re, const float* im, std::size_t partitionCount,
+                                  std::size_t binStride) {
+        ConvolutionKernel kernel;
+        kernel.partitionCount = (re && im) ? partitionCount : 0;
+        kernel.binStride = binStride;
+        kernel.viewRe = re;
+        kernel.viewIm = im;
+        return kernel;
+    }
+
+    bool empty() const { return partitionCount == 0; }
+    // Owned spectra only; views point at data in the binary.
+    std::size_t heapBytes() const {
+        return (spectra.re.capacity() + spectra.im.capacity()) * sizeof(float);
+    }
+    const float* partitionRe(std::size_t p) const {
+        return (viewRe ? viewRe : spectra.re.data()) + p * binStride;
+    }
+    const float* partitionIm(std::size_t p) const {
+        return (viewIm ? viewIm : spectra.im.data()) + p * binStride;
+    }
 };
 
 // Partitioned convolution with a shared input history.
@@ -21,9 +56,22 @@ public:
 
     void configure(std::size_t blockSize, std::size_t fftSize, std::size_t maxPartitions);
     void reset();
+    // Input history and overlap for snapshots; the caller configures first.
+    // loadState() is false (and resets) if the sizes differ.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
 
     std::size_t blockSize() const { return blockSize_; }
     std::size_t fftSize() const { return fftSize_; }
+    std::size_t binCount() const { return binCount_; }
+    std::size_t binStride() const { return binStride_; }
+    // Longest kernel (in partitions) the history covers.
+    std::size_t maxPartitions() const { return ringSize_; }
+    // History and work buffers, for memory accounting.
+    std::size_t heapBytes() const;
+    // Every history slot holds a silent block; the convolution then reduces
+    // to flushing the overlap.
+    bool historySilent() const { return silentSlots_ == ringSize_; }
 
     void pushInputBlock(const float* input);          // input length = blockSize
     void convolve(const ConvolutionKernel& kernel, float* out);  // out length = blockSize
@@ -31,6 +79,35 @@ public:
                              float* out,
                              std::vector<float>& overlap);  // overlap length = blockSize
 
+    // convolveWithOverlap() split in two so one block's work can be spread
+    // over several calls: accumulate() adds partitions [first, end) into
+    // `acc` (binStride() bins), finish() runs the inverse transform and
+    // overlap-add and leaves `acc` cleared. The input history must not change
+    // in between.
+    void accumulate(const ConvolutionKernel& kernel,
+                    SplitComplex& acc,
+                    std::size_t firstPartition,
+                    std::size_t endPartition) const;
+    void finish(SplitComplex& acc, float* out, std::vector<float>& overlap);
+    // As above with caller-owned overlap of blockSize() samples.
+    void finish(SplitComplex& acc, float* out, float* overlap);
+
+    // True-stereo variants: both channels' partitions in one pass over the
+    // shared input history. Partitions one kernel has beyond the other are
+    // accumulated on their own.
+    void accumulateStereo(const ConvolutionKernel& left,
+                          const ConvolutionKernel& right,
+                          SplitComplex& accL,
+                          SplitComplex& accR,
+                          std::size_t firstPartition,
+                          std::size_t endPartition) const;
+    void convolveStereoWithOverlap(const ConvolutionKernel& left,
+                                   const ConvolutionKernel& right,
+                                   float* outL,
+                                   float* outR,
+                                   std::vector<float>& overlapL,
+                                   std::vector<float>& overlapR);
+
     static ConvolutionKernel buildKernelFromIr(const std::vector<float>& ir,
                                                std::size_t blockSize,
                                                std::size_t fftSize);
@@ -38,15 +115,27 @@ public:
 private:
     std::size_t blockSize_ = 0;
     std::size_t fftSize_ = 0;
+    std::size_t binCount_ = 0;   // fftSize_/2 + 1
+    std::size_t binStride_ = 0;  // binCount_ rounded up to a cache line
     std::size_t ringSize_ = 0;
-    std::size_t ringIndex_ = 0;  // next write
+    std::size_t ringIndex_ = 0;  // slot holding the newest spectrum
 
     Fft fft_;
-    std::vector<std::vector<std::complex<float>>> xRing_;  // ringSize_ x fftSize_
+    ComplexMacFn mac_ = &ComplexMacScalar;
+    ComplexMacStereoFn macStereo_ = &ComplexMacStereoScalar;
+    // Input spectrum history, one slab of ringSize_ rows. Newer spectra are
+    // written at descending slots so partition p reads slot ringIndex_ + p:
+    // history and kernel rows then advance through memory together.
+    SplitComplex xRing_;
+    // Per slot: 1 if the block pushed there was all zeros (its row is then
+    // zero and the multiply-accumulate skips it).
+    std::vector<unsigned char> slotSilent_;
+    std::size_t silentSlots_ = 0;
 
-    std::vector<std::complex<float>> workTime_;
-    std::vector<std::complex<float>> workFreq_;
-    std::vector<std::complex<float>> accFreq_;
+    std::vector<float> workTime_;                  // fftSize_
+    std::vector<std::complex<float>> workFreq_;    // binCount_
+    SplitComplex accFreq_;
+    SplitComplex accFreqR_;  // right channel of convolveStereoWithOverlap()
     std::vector<float> overlap_;  // blockSize_
 };
 
@@ -0,0 +1,238 @@
+#include "dsp/Resampler.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <numeric>
+
+#include "dsp/KaiserWindow.h"
+#include "dsp/Simd.h"
+
+namespace dsp {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr std::array<int, 4> kCommonRates = {44100, 48000, 88200, 96000};
+
+int CommonRateIndex(int rate) {
+    for (std::size_t i = 0; i < kCommonRates.size(); ++i) {
+        if (kCommonRates[i] == rate) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// Shared bank for common pairs, otherwise one built into `own`.
+const PolyphaseFilterBank* SelectBank(int srcRate,
+                                      int dstRate,
+                                      std::unique_ptr<PolyphaseFilterBank>& own) {
+    own.reset();
+    if (srcRate == dstRate) {
+        return nullptr;
+    }
+    if (const auto* common = PolyphaseFilterBank::Common(srcRate, dstRate)) {
+        return common;
+    }
+    own = std::make_unique<PolyphaseFilterBank>(srcRate, dstRate);
+    return own.get();
+}
+
+float Dot(const float* h, const float* x, std::size_t taps) {
+    simd::Float4 acc = simd::Set1(0.0f);
+    for (std::size_t k = 0; k < taps; k += simd::kLanes) {
+        acc = simd::Add(acc, simd::Mul(simd::Load(h + k), simd::Load(x + k)));
+    }
+    float lanes[simd::kLanes];
+    simd::Store(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+}  // namespace
+
+PolyphaseFilterBank::PolyphaseFilterBank(int srcRate, int dstRate) {
+    const int src = std::max(1, srcRate);
+    const int dst = std::max(1, dstRate);
+    const int g = std::gcd(src, dst);
+    up_ = static_cast<std::size_t>(dst / g);
+    down_ = static_cast<std::size_t>(src / g);
+
+    const double scale = std::min(1.0, static_cast<double>(up_) / static_cast<double>(down_));
+    const double cutoff = kCutoff * scale;
+    const std::size_t half = static_cast<std::size_t>(
+        std::ceil(static_cast<double>(kHalfTaps) / scale));
+    taps_ = (2 * half + simd::kLanes - 1) / simd::kLanes * simd::kLanes;
+    coeffs_.assign(up_ * taps_, 0.0f);
+
+    const double width = static_cast<double>(taps_ / 2);
+    const KaiserWindow window(kKaiserBeta);
+    const double centre = static_cast<double>(centreTap());
+    std::vector<double> row(taps_);
+    for (std::size_t p = 0; p < up_; ++p) {
+        const double frac = static_cast<double>(p) / static_cast<double>(up_);
+        double sum = 0.0;
+        for (std::size_t k = 0; k < taps_; ++k) {
+            const double d = static_cast<double>(k) - centre - frac;
+            const double x = d / width;
+            double h = 0.0;
+            if (std::abs(x) < 1.0) {
+                const double arg = kPi * cutoff * d;
+                const double sinc = std::abs(arg) < 1.0e-12 ? 1.0 : std::sin(arg) / arg;
+                h = cutoff * sinc * window(x);
+            }
+            row[k] = h;
+            sum += h;
+        }
+        float* out = coeffs_.data() + p * taps_;
+        for (std::size_t k = 0; k < taps_; ++k) {
+            out[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+}
+
+const PolyphaseFilterBank* PolyphaseFilterBank::Common(int srcRate, int dstRate) {
+    const int si = CommonRateIndex(srcRate);
+    const int di = CommonRateIndex(dstRate);
+    if (si < 0 || di < 0 || si == di) {
+        return nullptr;
+    }
+    constexpr std::size_t kCount = kCommonRates.size();
+    static std::array<std::once_flag, kCount * kCount> once;
+    static std::array<std::unique_ptr<PolyphaseFilterBank>, kCount * kCount> banks;
+    const std::size_t slot = static_cast<std::size_t>(si) * kCount + static_cast<std::size_t>(di);
+    std::call_once(once[slot], [&] {
+        banks[slot] = std::make_unique<PolyphaseFilterBank>(srcRate, dstRate);
+    });
+    return banks[slot].get();
+}
+
+PolyphaseResampler::PolyphaseResampler(int srcRate, int dstRate)
+    : srcRate_(std::max(1, srcRate)), dstRate_(std::max(1, dstRate)) {
+    bank_ = SelectBank(srcRate_, dstRate_, ownBank_);
+}
+
+std::size_t PolyphaseResampler::OutputFrames(std::size_t frames, int srcRate, int dstRate) {
+    if (frames == 0 || srcRate <= 0 || dstRate <= 0) {
+        return 0;
+    }
+    if (srcRate == dstRate) {
+        return frames;
+    }
+    const double ratio = static_cast<double>(dstRate) / static_cast<double>(srcRate);
+    return std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::llround(static_cast<double>(frames) * ratio)));
+}
+
+std::vector<float> PolyphaseResampler::process(const float* input,
+                                               std::size_t frames,
+                                               std::size_t maxFrames) const {
+    const std::size_t outFrames =
+        std::min(OutputFrames(frames, srcRate_, dstRate_), maxFrames);
+    std::vector<float> out(outFrames, 0.0f);
+    if (outFrames == 0 || input == nullptr) {
+        return out;
+    }
+    if (bank_ == nullptr) {
+        std::copy(input, input + outFrames, out.begin());
+        return out;
+    }
+
+    // Zero-padded copy so every row can run over whole lanes without bounds
+    // checks; only the input the requested outputs actually reach is copied.
+    const std::size_t taps = bank_->taps();
+    const std::size_t up = bank_->phases();
+    const std::size_t down = bank_->decimation();
+    const std::size_t pad = taps;
+    const std::size_t lastInput = ((outFrames - 1) * down) / up + taps;
+    const std::size_t used = std::min(frames, lastInput + 1);
+    std::vector<float> padded(pad + lastInput + pad, 0.0f);
+    std::copy(input, input + used, padded.begin() + static_cast<std::ptrdiff_t>(pad));
+
+    const std::size_t lead = pad - bank_->centreTap();
+    for (std::size_t n = 0; n < outFrames; ++n) {
+        const std::uint64_t pos = static_cast<std::uint64_t>(n) * down;
+        const std::size_t i0 = static_cast<std::size_t>(pos / up);
+        const std::size_t phase = static_cast<std::size_t>(pos % up);
+        out[n] = Dot(bank_->row(phase), padded.data() + i0 + lead, taps);
+    }
+    return out;
+}
+
+void StreamingResampler::configure(int srcRate, int dstRate, std::size_t channels) {
+    srcRate_ = std::max(1, srcRate);
+    dstRate_ = std::max(1, dstRate);
+    channels_ = channels;
+    bank_ = SelectBank(srcRate_, dstRate_, ownBank_);
+    if (bank_ == nullptr || channels_ == 0) {
+        ringSize_ = 0;
+        rings_.clear();
+        block_.clear();
+        return;
+    }
+    ringSize_ = std::bit_ceil(bank_->taps() + kInputBlockFrames);
+    rings_.assign(channels_ * 2 * ringSize_, 0.0f);
+    block_.assign(channels_ * kInputBlockFrames, 0.0f);
+    reset();
+}
+
+bool StreamingResampler::matches(int srcRate, int dstRate, std::size_t channels) const {
+    return srcRate_ == std::max(1, srcRate) && dstRate_ == std::max(1, dstRate) &&
+           channels_ == channels;
+}
+
+void StreamingResampler::reset() {
+    std::fill(rings_.begin(), rings_.end(), 0.0f);
+    written_ = bank_ != nullptr ? bank_->centreTap() : 0;
+    window_ = 0;
+    phase_ = 0;
+}
+
+double StreamingResampler::latencyFrames() const {
+    if (bank_ == nullptr || channels_ == 0) {
+        return 0.0;
+    }
+    // Output centred on input i needs up to i + taps - centreTap - 1.
+    const auto lookAhead = static_cast<double>(bank_->taps() - bank_->centreTap() - 1);
+    return lookAhead + 0.5 * static_cast<double>(kInputBlockFrames);
+}
+
+std::size_t StreamingResampler::render(float* output, std::size_t frames) {
+    const std::size_t taps = bank_->taps();
+    const std::size_t up = bank_->phases();
+    const std::size_t down = bank_->decimation();
+    const std::size_t mask = ringSize_ - 1;
+    const std::size_t stride = 2 * ringSize_;
+    std::size_t n = 0;
+    for (; n < frames && window_ + taps <= written_; ++n) {
+        const float* h = bank_->row(phase_);
+        const float* x = rings_.data() + (static_cast<std::size_t>(window_) & mask);
+        float* out = output + n * channels_;
+        for (std::size_t ch = 0; ch < channels_; ++ch) {
+            out[ch] = Dot(h, x + ch * stride, taps);
+        }
+        phase_ += down;
+        window_ += phase_ / up;
+        phase_ %= up;
+    }
+    return n;
+}
+
+void StreamingResampler::pushBlock() {
+    const std::size_t mask = ringSize_ - 1;
+    const std::size_t stride = 2 * ringSize_;
+    for (std::size_t f = 0; f < kInputBlockFrames; ++f) {
+        const std::size_t slot = static_cast<std::size_t>(written_ + f) & mask;
+        const float* frame = block_.data() + f * channels_;
+        for (std::size_t ch = 0; ch < channels_; ++ch) {
+            float* ring = rings_.data() + ch * stride;
+            ring[slot] = frame[ch];
+            ring[slot + ringSize_] = frame[ch];
+        }
+    }
+    written_ += kInputBlockFrames;
+}
+
+}  // namespace dsp
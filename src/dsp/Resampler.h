@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace dsp {
+
+// Kaiser-windowed sinc filter bank for a rational rate change. The ratio
+// dstRate / srcRate is reduced to L / M; row p holds the taps for output
+// samples that fall p / L of an input sample past an input sample. Rows are
+// padded to whole SIMD lanes and normalised to unity DC gain.
+class PolyphaseFilterBank {
+public:
+    // Taps on each side of the centre at a 1:1 cutoff; downsampling widens
+    // the filter by the ratio to keep the same transition band.
+    static constexpr std::size_t kHalfTaps = 32;
+    // Passband edge as a fraction of the lower Nyquist.
+    static constexpr double kCutoff = 0.95;
+    static constexpr double kKaiserBeta = 9.0;  // ~-90 dB stopband
+
+    PolyphaseFilterBank(int srcRate, int dstRate);
+
+    // Shared bank for a common device-rate pair (44.1/48/88.2/96 kHz), built
+    // on first use; null for other pairs or equal rates.
+    static const PolyphaseFilterBank* Common(int srcRate, int dstRate);
+
+    std::size_t phases() const { return up_; }       // L
+    std::size_t decimation() const { return down_; }  // M
+    std::size_t taps() const { return taps_; }        // per row
+    // Row tap k multiplies input sample (i0 + k - centreTap()).
+    std::size_t centreTap() const { return taps_ / 2 - 1; }
+    const float* row(std::size_t phase) const { return coeffs_.data() + phase * taps_; }
+
+private:
+    std::size_t up_ = 1;
+    std::size_t down_ = 1;
+    std::size_t taps_ = 0;
+    std::vector<float> coeffs_;  // phases x taps
+};
+
+// Whole-buffer resampling through a PolyphaseFilterBank (e.g. IR conversion).
+// Output frame n sits at input position n * srcRate / dstRate; samples
+// outside the input count as zero. Equal rates copy.
+class PolyphaseResampler {
+public:
+    PolyphaseResampler(int srcRate, int dstRate);
+
+    // llround(frames * dstRate / srcRate), at least 1 for non-empty input and
+    // 0 for invalid rates.
+    static std::size_t OutputFrames(std::size_t frames, int srcRate, int dstRate);
+
+    // Converts at most the first maxFrames output frames.
+    std::vector<float> process(const float* input,
+                               std::size_t frames,
+                               std::size_t maxFrames = std::numeric_limits<std::size_t>::max()) const;
+
+private:
+    int srcRate_ = 0;
+    int dstRate_ = 0;
+    const PolyphaseFilterBank* bank_ = nullptr;
+    std::unique_ptr<PolyphaseFilterBank> ownBank_;  // for uncommon ratios
+};
+
+// Streaming counterpart for a live output path. Interleaved input is pulled
+// in fixed blocks and split into per-channel rings stored twice over, so
+// every filter window is contiguous and nothing allocates after configure().
+// Produces the same samples as PolyphaseResampler on the same input.
+class StreamingResampler {
+public:
+    static constexpr std::size_t kInputBlockFrames = 256;
+
+    // Allocates; call off the audio thread. Equal rates pass input through.
+    void configure(int srcRate, int dstRate, std::size_t channels);
+    bool matches(int srcRate, int dstRate, std::size_t channels) const;
+    // Drops buffered input; history restarts from silence.
+    void reset();
+
+    std::size_t channels() const { return channels_; }
+    // Average delay the stream adds, in input frames: pulled input waits for
+    // the filter's look-ahead and, on average, half an input block before the
+    // output reaches it. 0 when rates are equal.
+    double latencyFrames() const;
+
+    // Writes `frames` interleaved output frames. pull(float* interleaved,
+    // std::size_t frames) is asked for kInputBlockFrames at a time.
+    template <typename Pull>
+    void process(float* output, std::size_t frames, Pull&& pull) {
+        if (channels_ == 0) {
+            return;
+        }
+        if (bank_ == nullptr) {
+            pull(output, frames);
+            return;
+        }
+        std::size_t done = 0;
+        while (true) {
+            done += render(output + done * channels_, frames - done);
+            if (done >= frames) {
+                break;
+            }
+            pull(block_.data(), kInputBlockFrames);
+            pushBlock();
+        }
+    }
+
+private:
+    // Renders as many frames as the buffered input allows.
+    std::size_t render(float* output, std::size_t frames);
+    void pushBlock();
+
+    int srcRate_ = 0;
+    int dstRate_ = 0;
+    std::size_t channels_ = 0;
+    const PolyphaseFilterBank* bank_ = nullptr;
+    std::unique_ptr<PolyphaseFilterBank> ownBank_;
+    std::size_t ringSize_ = 0;   // power of two, >= taps + one input block
+    std::vector<float> rings_;   // channels x (2 * ringSize_)
+    std::vector<float> block_;   // one interleaved input block
+    std::uint64_t written_ = 0;  // ring frames written; starts at centreTap()
+    std::uint64_t window_ = 0;   // first ring frame of the next output's taps
+    std::size_t phase_ = 0;
+};
+
+}  // namespace dsp
@@ -2,7 +2,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <mutex>
 
+#include "dsp/ConvolutionReverb.h"
 #include "room_ir/RoomIrData.h"
 
 namespace dsp {
@@ -20,6 +22,44 @@ BuiltInsView BuiltIns() {
     return v;
 }
 
+// IRs embedded as int16 are decoded here the first time they are asked for
+// and kept, so their pointers stay valid like the float arrays'.
+struct DecodedIr {
+    std::once_flag once;
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+void DecodePacked(const std::int16_t* packed, std::size_t count, float scale,
+                  std::vector<float>& out) {
+    out.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(packed[i]) * scale;
+    }
+}
+
+// Float channel pointers for item `index` (< built.count), decoding it first
+// if it is packed.
+void ChannelPointers(const BuiltInsView& built, std::size_t index,
+                     const float** left, const float** right) {
+    const auto& it = built.items[index];
+    if (!it.packedL) {
+        *left = it.samplesL;
+        *right = it.samplesR;
+        return;
+    }
+    static std::vector<DecodedIr> decoded(built.count);
+    auto& ir = decoded[index];
+    std::call_once(ir.once, [&] {
+        DecodePacked(it.packedL, it.frameCount, it.packedScale, ir.left);
+        if (it.packedR) {
+            DecodePacked(it.packedR, it.frameCount, it.packedScale, ir.right);
+        }
+    });
+    *left = ir.left.data();
+    *right = it.packedR ? ir.right.data() : nullptr;
+}
+
 }  // namespace
 
 const std::vector<RoomIrInfo>& RoomIrLibrary::list() {
@@ -33,6 +73,7 @@ const std::vector<RoomIrInfo>& RoomIrLibrary::list() {
             info.displayName = built.items[i].displayName;
             info.sampleRate = built.items[i].sampleRate;
             info.channels = built.items[i].channels;
+            info.frameCount = built.items[i].frameCount;
             out.push_back(info);
         }
         return out;
@@ -59,8 +100,7 @@ RoomIrLibrary::Samples RoomIrLibrary::samples(int index) {
     Samples out;
     out.sampleRate = it.sampleRate;
     out.channels = it.channels;
-    out.left = it.samplesL;
-    out.right = it.samplesR;
+    ChannelPointers(built, static_cast<std::size_t>(index), &out.left, &out.right);
     out.frameCount = it.frameCount;
     return out;
 }
@@ -77,7 +117,29 @@ const float* RoomIrLibrary::samplesMono(int index,
     const auto& it = built.items[static_cast<std::size_t>(index)];
     if (outCount) *outCount = it.frameCount;
     if (outSampleRate) *outSampleRate = it.sampleRate;
-    return it.samplesL;
+    const float* left = nullptr;
+    const float* right = nullptr;
+    ChannelPointers(built, static_cast<std::size_t>(index), &left, &right);
+    return left;
+}
+
+RoomIrLibrary::Preview RoomIrLibrary::preview(int index) {
+    const auto built = BuiltIns();
+    if (index < 0 || static_cast<std::size_t>(index) >= built.count) {
+        return {};
+    }
+    const auto& it = built.items[static_cast<std::size_t>(index)];
+    Preview out;
+    out.waveform = it.preview;
+    out.waveformCount = it.preview ? it.previewCount : 0;
+    out.envelopeDb = it.envelopeDb;
+    out.edcDb = it.edcDb;
+    out.envelopeCount = (it.envelopeDb && it.edcDb) ? it.envelopeCount : 0;
+    out.rt60Seconds = it.rt60Seconds;
+    out.durationSeconds =
+        it.sampleRate > 0 ? static_cast<float>(it.frameCount) / static_cast<float>(it.sampleRate)
+                          : 0.0f;
+    return out;
 }
 
 std::vector<float> RoomIrLibrary::previewMono(int index, std::size_t maxSamples) {
@@ -129,4 +191,44 @@ std::vector<float> RoomIrLibrary::previewMono(int index, std::size_t maxSamples)
     return std::vector<float>(it.preview, it.preview + n);
 }
 
+StereoConvolutionKernel RoomIrLibrary::precomputedKernel(int index,
+                                                         int sampleRate,
+                                                         const PartitionLayout& layout,
+                                                         std::size_t skipFrames) {
+    std::size_t count = 0;
+    const room_ir::KernelSet* sets = room_ir::kernelSets(&count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& set = sets[i];
+        if (static_cast<int>(set.itemIndex) != index || set.sampleRate != sampleRate ||
+            set.skipFrames != skipFrames || set.stageCount > layout.stageCount()) {
+            continue;
+        }
+        StereoConvolutionKernel kernel;
+        kernel.isStereo = (set.channels == 2);
+        for (std::size_t s = 0; s < set.stageCount; ++s) {
+            const auto& stage = set.stages[s];
+            // Generated for a different split or bin padding: don't use it.
+            if (stage.blockSize != layout.blockSizes[s] || stage.offset != layout.offsets[s] ||
+                stage.binStride != AlignedStride(stage.blockSize + 1)) {
+                return {};
+            }
+            const auto left =
+                ConvolutionKernel::View(stage.leftRe, stage.leftIm, stage.partitionCount, stage.binStride);
+            const auto right = ConvolutionKernel::View(stage.rightRe, stage.rightIm,
+                                                       stage.partitionCount, stage.binStride);
+            if (s == 0) {
+                kernel.left = left;
+                kernel.right = kernel.isStereo ? right : ConvolutionKernel{};
+            } else {
+                kernel.tailLeft.push_back(left);
+                if (kernel.isStereo) {
+                    kernel.tailRight.push_back(right);
+                }
+            }
+        }
+        return kernel;
+    }
+    return {};
+}
+
 }  // namespace dsp
@@ -1,16 +1,21 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <string_view>
 #include <vector>
 
 namespace dsp {
 
+struct PartitionLayout;
+struct StereoConvolutionKernel;
+
 struct RoomIrInfo {
     std::string_view id;           // stable ID for presets
     std::string_view displayName;  // user-facing name
     int sampleRate = 44100;
     int channels = 1;             // 1=mono, 2=stereo
+    std::size_t frameCount = 0;   // at sampleRate
 };
 
 // Built-in IRs compiled into the program (no runtime file IO).
@@ -31,14 +36,43 @@ public:
     static int findIndexById(std::string_view id);
 
     // Returns raw IR samples in [-1,1] (non-interleaved).
-    // The returned pointer remains valid for the program lifetime.
+    // The returned pointer remains valid for the program lifetime. IRs
+    // embedded as int16 (SATORI_IR_STORAGE) are decoded on the first call for
+    // that index; thread-safe.
     static Samples samples(int index);
 
     // Compatibility: returns the left channel (or mono).
     static const float* samplesMono(int index, std::size_t* outCount, int* outSampleRate);
 
+    // Display data generated at build time; views static storage.
+    struct Preview {
+        const float* waveform = nullptr;  // mono, decimated, in [-1,1]
+        std::size_t waveformCount = 0;
+        // envelopeCount points over the IR's length: per-slice peak and the
+        // Schroeder energy decay curve, in dB (0 = IR peak / total energy).
+        const float* envelopeDb = nullptr;
+        const float* edcDb = nullptr;
+        std::size_t envelopeCount = 0;
+        float rt60Seconds = 0.0f;  // 0 if the decay was too short to fit
+        float durationSeconds = 0.0f;
+
+        bool empty() const { return waveformCount == 0 && envelopeCount == 0; }
+    };
+
+    // Empty for an invalid index. No computation or allocation.
+    static Preview preview(int index);
+
     // Returns a downsampled preview (<= maxSamples) normalized to [-1,1].
     static std::vector<float> previewMono(int index, std::size_t maxSamples);
+
+    // Kernels generated at build time (SATORI_PRECOMPUTED_IR_KERNELS) for IR
+    // `index` resampled to `sampleRate`, with the first `skipFrames` samples
+    // left out and the rest split by `layout`. The kernel views static data.
+    // Empty if nothing matching was generated; callers then build their own.
+    static StereoConvolutionKernel precomputedKernel(int index,
+                                                     int sampleRate,
+                                                     const PartitionLayout& layout,
+                                                     std::size_t skipFrames);
 };
 
 }  // namespace dsp
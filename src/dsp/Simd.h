@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SATORI_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SATORI_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace dsp::simd {
+
+// Minimal 4-lane float vector used by the lane-parallel DSP kernels. Every
+// operation is a plain IEEE mul/add/sub/div (no FMA), so lane results match the
+// scalar code paths bit for bit.
+inline constexpr std::size_t kLanes = 4;
+
+#if defined(SATORI_SIMD_SSE2)
+
+struct Float4 {
+    __m128 v;
+};
+
+inline Float4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+inline void Store(float* p, Float4 a) { _mm_storeu_ps(p, a.v); }
+inline Float4 Set1(float value) { return {_mm_set1_ps(value)}; }
+inline Float4 Add(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float4 Sub(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float4 Mul(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float4 Neg(Float4 a) { return {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; }
+inline Float4 Div(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+// a < b ? a : b and a > b ? a : b, i.e. std::min(b, a) and std::max(b, a).
+inline Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+
+// Lane mask with all bits set where `flags[i]` is true.
+inline Float4 MaskFromFlags(const bool* flags) {
+    return {_mm_castsi128_ps(_mm_set_epi32(flags[3] ? -1 : 0, flags[2] ? -1 : 0,
+                                           flags[1] ? -1 : 0, flags[0] ? -1 : 0))};
+}
+
+// mask ? a : b per lane.
+inline Float4 Select(Float4 mask, Float4 a, Float4 b) {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+
+// 4-lane unsigned 32-bit vector for the integer kernels (noise generation).
+struct UInt4 {
+    __m128i v;
+};
+
+inline UInt4 Load(const std::uint32_t* p) {
+    return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+}
+inline void Store(std::uint32_t* p, UInt4 a) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v);
+}
+inline UInt4 Set1U32(std::uint32_t value) {
+    return {_mm_set1_epi32(static_cast<int>(value))};
+}
+inline UInt4 And(UInt4 a, UInt4 b) { return {_mm_and_si128(a.v, b.v)}; }
+inline UInt4 Or(UInt4 a, UInt4 b) { return {_mm_or_si128(a.v, b.v)}; }
+inline UInt4 Xor(UInt4 a, UInt4 b) { return {_mm_xor_si128(a.v, b.v)}; }
+template <int N>
+inline UInt4 ShiftLeft(UInt4 a) {
+    return {_mm_slli_epi32(a.v, N)};
+}
+template <int N>
+inline UInt4 ShiftRight(UInt4 a) {
+    return {_mm_srli_epi32(a.v, N)};
+}
+// Reinterprets the lane bits as floats.
+inline Float4 BitCast(UInt4 a) { return {_mm_castsi128_ps(a.v)}; }
+
+#elif defined(SATORI_SIMD_NEON)
+
+struct Float4 {
+    float32x4_t v;
+};
+
+inline Float4 Load(const float* p) { return {vld1q_f32(p)}; }
+inline void Store(float* p, Float4 a) { vst1q_f32(p, a.v); }
+inline Float4 Set1(float value) { return {vdupq_n_f32(value)}; }
+inline Float4 Add(Float4 a, Float4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Float4 Sub(Float4 a, Float4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline Float4 Mul(Float4 a, Float4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline Float4 Neg(Float4 a) { return {vnegq_f32(a.v)}; }
+inline Float4 Div(Float4 a, Float4 b) { return {vdivq_f32(a.v, b.v)}; }
+// Compare and select rather than vminq/vmaxq, which differ from the scalar
+// ternary on NaN and signed zeros.
+inline Float4 Min(Float4 a, Float4 b) { return {vbslq_f32(vcltq_f32(a.v, b.v), a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {vbslq_f32(vcgtq_f32(a.v, b.v), a.v, b.v)}; }
+
+inline Float4 MaskFromFlags(const bool* flags) {
+    const std::uint32_t bits[kLanes] = {flags[0] ? 0xFFFFFFFFu : 0u, flags[1] ? 0xFFFFFFFFu : 0u,
+                                        flags[2] ? 0xFFFFFFFFu : 0u, flags[3] ? 0xFFFFFFFFu : 0u};
+    return {vreinterpretq_f32_u32(vld1q_u32(bits))};
+}
+
+inline Float4 Select(Float4 mask, Float4 a, Float4 b) {
+    return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};
+}
+
+struct UInt4 {
+    uint32x4_t v;
+};
+
+inline UInt4 Load(const std::uint32_t* p) { return {vld1q_u32(p)}; }
+inline void Store(std::uint32_t* p, UInt4 a) { vst1q_u32(p, a.v); }
+inline UInt4 Set1U32(std::uint32_t value) { return {vdupq_n_u32(value)}; }
+inline UInt4 And(UInt4 a, UInt4 b) { return {vandq_u32(a.v, b.v)}; }
+inline UInt4 Or(UInt4 a, UInt4 b) { return {vorrq_u32(a.v, b.v)}; }
+inline UInt4 Xor(UInt4 a, UInt4 b) { return {veorq_u32(a.v, b.v)}; }
+template <int N>
+inline UInt4 ShiftLeft(UInt4 a) {
+    return {vshlq_n_u32(a.v, N)};
+}
+template <int N>
+inline UInt4 ShiftRight(UInt4 a) {
+    return {vshrq_n_u32(a.v, N)};
+}
+inline Float4 BitCast(UInt4 a) { return {vreinterpretq_f32_u32(a.v)}; }
+
+#else
+
+struct Float4 {
+    float v[kLanes];
+};
+
+inline Float4 Load(const float* p) {
+    Float4 r;
+    std::memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+inline void Store(float* p, Float4 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline Float4 Set1(float value) { return {{value, value, value, value}}; }
+inline Float4 Add(Float4 a, Float4 b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+inline Float4 Sub(Float4 a, Float4 b) {
+    return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+}
+inline Float4 Mul(Float4 a, Float4 b) {
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+inline Float4 Neg(Float4 a) { return {{-a.v[0], -a.v[1], -a.v[2], -a.v[3]}}; }
+inline Float4 Div(Float4 a, Float4 b) {
+    return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}};
+}
+inline Float4 Min(Float4 a, Float4 b) {
+    Float4 r;
+    for (std::size_t i = 0; i < kLanes; ++i) {
+        r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+inline Float4 Max(Float4 a, Float4 b) {
+    Float4 r;
+    for (std::size_t i = 0; i < kLanes; ++i) {
+        r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+
+inline Float4 MaskFromFlags(const bool* flags) {
+    Float4 r;
+    for (std::size_t i = 0; i < kLanes; ++i) {
+        const std::uint32_t bits = flags[i] ? 0xFFFFFFFFu : 0u;
+        std::memcpy(&r.v[i], &bits, sizeof(bits));
+    }
+    return r;
+}
+
+inline Float4 Select(Float4 mask, Float4 a, Float4 b) {
+    Float4 r;
+    for (std::size_t i = 0; i < kLanes; ++i) {
+        std::uint32_t m = 0;
+        std::memcpy(&m, &mask.v[i], sizeof(m));
+        r.v[i] = m ? a.v[i] : b.v[i];
+    }
+    return r;
+}
+
+struct UInt4 {
+    std::uint32_t v[kLanes];
+};
+
+inline UInt4 Load(const std::uint32_t* p) {
+    UInt4 r;
+    std::memcpy(r.v, p, sizeof(r.v));
+    return r;
+}
+inline void Store(std::uint32_t* p, UInt4 a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline UInt4 Set1U32(std::uint32_t value) { return {{value, value, value, value}}; }
+inline UInt4 And(UInt4 a, UInt4 b) {
+    return {{a.v[0] & b.v[0], a.v[1] & b.v[1], a.v[2] & b.v[2], a.v[3] & b.v[3]}};
+}
+inline UInt4 Or(UInt4 a, UInt4 b) {
+    return {{a.v[0] | b.v[0], a.v[1] | b.v[1], a.v[2] | b.v[2], a.v[3] | b.v[3]}};
+}
+inline UInt4 Xor(UInt4 a, UInt4 b) {
+    return {{a.v[0] ^ b.v[0], a.v[1] ^ b.v[1], a.v[2] ^ b.v[2], a.v[3] ^ b.v[3]}};
+}
+template <int N>
+inline UInt4 ShiftLeft(UInt4 a) {
+    return {{a.v[0] << N, a.v[1] << N, a.v[2] << N, a.v[3] << N}};
+}
+template <int N>
+inline UInt4 ShiftRight(UInt4 a) {
+    return {{a.v[0] >> N, a.v[1] >> N, a.v[2] >> N, a.v[3] >> N}};
+}
+inline Float4 BitCast(UInt4 a) {
+    Float4 r;
+    std::memcpy(r.v, a.v, sizeof(r.v));
+    return r;
+}
+
+#endif
+
+}  // namespace dsp::simd
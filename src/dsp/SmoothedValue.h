@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+// One-pole glide towards a target for control values that change while
+// audio runs (gains, filter settings). Snaps once within kSettleEpsilon so
+// callers can skip per-sample work while the value is steady.
+class SmoothedValue {
+public:
+    static constexpr float kSettleEpsilon = 1.0e-5f;
+
+    explicit SmoothedValue(float value = 0.0f) : current_(value), target_(value) {}
+
+    void setTime(double sampleRate, double seconds) {
+        if (sampleRate <= 0.0 || seconds <= 0.0) {
+            coeff_ = 1.0f;
+            return;
+        }
+        coeff_ = static_cast<float>(
+            std::clamp(1.0 - std::exp(-1.0 / (sampleRate * seconds)), 0.0, 1.0));
+    }
+
+    void setTarget(float target) { target_ = target; }
+    // Jumps straight to `value` (initial state, resets).
+    void snap(float value) {
+        current_ = value;
+        target_ = value;
+    }
+
+    float next() {
+        current_ += (target_ - current_) * coeff_;
+        if (std::abs(target_ - current_) < kSettleEpsilon) {
+            current_ = target_;
+        }
+        return current_;
+    }
+
+    bool settled() const { return current_ == target_; }
+    float current() const { return current_; }
+    float target() const { return target_; }
+
+private:
+    float current_ = 0.0f;
+    float target_ = 0.0f;
+    float coeff_ = 1.0f;
+};
+
+}  // namespace dsp
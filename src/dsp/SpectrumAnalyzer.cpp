@@ -0,0 +1,66 @@
+#include "dsp/SpectrumAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dsp {
+
+SpectrumAnalyzer::SpectrumAnalyzer(std::size_t fftSize)
+    : fft_(Fft::isPowerOfTwo(fftSize) && fftSize >= 16 ? fftSize : 2048) {
+    const std::size_t n = fft_.size();
+    window_.resize(n);
+    windowed_.resize(n);
+    spectrum_.resize(fft_.realBins());
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        window_[i] = 0.5f - 0.5f * static_cast<float>(
+                                       std::cos(2.0 * 3.14159265358979323846 *
+                                                static_cast<double>(i) / static_cast<double>(n)));
+        sum += window_[i];
+    }
+    // A sine of amplitude A peaks at A * sum(w) / 2 in its bin.
+    windowGain_ = sum > 0.0 ? static_cast<float>(2.0 / sum) : 1.0f;
+}
+
+void SpectrumAnalyzer::analyze(const float* samples,
+                               double sampleRate,
+                               std::size_t bands,
+                               float minHz,
+                               std::vector<float>& bandsDb,
+                               float floorDb) {
+    bandsDb.assign(bands, floorDb);
+    if (!samples || bands == 0 || sampleRate <= 0.0) {
+        return;
+    }
+    const std::size_t n = fft_.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        windowed_[i] = samples[i] * window_[i];
+    }
+    fft_.forwardReal(windowed_.data(), spectrum_.data());
+
+    const double nyquist = sampleRate * 0.5;
+    const double binHz = sampleRate / static_cast<double>(n);
+    const double low = std::clamp(static_cast<double>(minHz), binHz, nyquist * 0.5);
+    const double ratio = std::log(nyquist / low);
+    const std::size_t lastBin = spectrum_.size() - 1;
+    for (std::size_t b = 0; b < bands; ++b) {
+        const double f0 = low * std::exp(ratio * static_cast<double>(b) / static_cast<double>(bands));
+        const double f1 =
+            low * std::exp(ratio * static_cast<double>(b + 1) / static_cast<double>(bands));
+        // Narrow low bands may fall between bins; they take the nearest one.
+        std::size_t bin0 = static_cast<std::size_t>(std::lround(f0 / binHz));
+        std::size_t bin1 = static_cast<std::size_t>(std::lround(f1 / binHz));
+        bin0 = std::min(bin0, lastBin);
+        bin1 = std::clamp(bin1, bin0 + 1, lastBin + 1);
+        float peak = 0.0f;
+        for (std::size_t k = bin0; k < bin1; ++k) {
+            peak = std::max(peak, std::abs(spectrum_[k]));
+        }
+        const float magnitude = peak * windowGain_;
+        if (magnitude > 0.0f) {
+            bandsDb[b] = std::max(floorDb, 20.0f * std::log10(magnitude));
+        }
+    }
+}
+
+}  // namespace dsp
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "dsp/Fft.h"
+
+namespace dsp {
+
+// Display spectrum for meters: Hann-windowed magnitude of the last fftSize
+// samples, reduced to log-spaced bands. Each band reports the peak bin in
+// dBFS (a full-scale sine reads about 0 dB). UI-side; allocates only when
+// the size or band layout changes.
+class SpectrumAnalyzer {
+public:
+    explicit SpectrumAnalyzer(std::size_t fftSize = 2048);
+
+    std::size_t fftSize() const { return fft_.size(); }
+
+    // `samples` holds fftSize() values. `bandsDb` is resized to `bands`
+    // spanning minHz..sampleRate/2; floorDb clamps silence.
+    void analyze(const float* samples,
+                 double sampleRate,
+                 std::size_t bands,
+                 float minHz,
+                 std::vector<float>& bandsDb,
+                 float floorDb = -96.0f);
+
+private:
+    Fft fft_;
+    std::vector<float> window_;
+    std::vector<float> windowed_;
+    std::vector<std::complex<float>> spectrum_;
+    float windowGain_ = 1.0f;
+};
+
+}  // namespace dsp
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dsp {
+
+// Running DSP state as raw bytes, for engine snapshots. Values go in byte
+// for byte with no conversion, so a snapshot only restores into the same
+// build on the same architecture; callers tag what they write and check it
+// on the way back. Neither side is real-time safe (the writer grows a vector).
+class StateWriter {
+public:
+    template <typename T>
+    void pod(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot values are copied as bytes");
+        append(&value, sizeof(T));
+    }
+    void floats(const float* data, std::size_t count) { append(data, count * sizeof(float)); }
+
+    const std::vector<std::uint8_t>& bytes() const { return bytes_; }
+    std::vector<std::uint8_t> release() { return std::move(bytes_); }
+
+private:
+    void append(const void* data, std::size_t size) {
+        const auto* from = static_cast<const std::uint8_t*>(data);
+        bytes_.insert(bytes_.end(), from, from + size);
+    }
+
+    std::vector<std::uint8_t> bytes_;
+};
+
+// Reads what a StateWriter wrote, in the same order. A read past the end, or
+// a fail() from a caller that found a value it cannot take, leaves the target
+// untouched and turns every later read into a no-op, so a load can run to the
+// end and check ok() once.
+class StateReader {
+public:
+    explicit StateReader(std::span<const std::uint8_t> bytes) : bytes_(bytes) {}
+
+    template <typename T>
+    bool pod(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "snapshot values are copied as bytes");
+        return take(&value, sizeof(T));
+    }
+    bool floats(float* data, std::size_t count) { return take(data, count * sizeof(float)); }
+
+    void fail() { ok_ = false; }
+    bool ok() const { return ok_; }
+    bool atEnd() const { return offset_ == bytes_.size(); }
+    std::size_t remaining() const { return bytes_.size() - offset_; }
+
+private:
+    bool take(void* data, std::size_t size) {
+        if (!ok_ || bytes_.size() - offset_ < size) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(data, bytes_.data() + offset_, size);
+        offset_ += size;
+        return true;
+    }
+
+    std::span<const std::uint8_t> bytes_;
+    std::size_t offset_ = 0;
+    bool ok_ = true;
+};
+
+}  // namespace dsp
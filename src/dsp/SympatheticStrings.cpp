@@ -0,0 +1,232 @@
+#include "dsp/SympatheticStrings.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "dsp/Simd.h"
+#include "dsp/StateSnapshot.h"
+
+namespace dsp {
+
+namespace {
+
+// Standard guitar tuning, E2 to E4.
+constexpr std::array<float, 6> kGuitarTuning = {82.41f, 110.00f, 146.83f,
+                                                196.00f, 246.94f, 329.63f};
+
+// Thirteen-string koto in hirajoshi, D4 G3 A3 Bb3 D4 Eb4 G4 A4 Bb4 D5 Eb5 G5 A5.
+constexpr std::array<float, 13> kKotoTuning = {293.66f, 196.00f, 220.00f, 233.08f, 293.66f,
+                                               311.13f, 392.00f, 440.00f, 466.16f, 587.33f,
+                                               622.25f, 783.99f, 880.00f};
+
+// -60 dB ring time of an undamped open string; the interpolation adds more
+// loss towards the top.
+constexpr double kDecaySeconds = 2.5;
+// Input and output below this (-160 dB) count as silence.
+constexpr float kSilentLevel = 1e-8f;
+
+}  // namespace
+
+std::span<const float> SympatheticStrings::PresetTuning(Preset preset) {
+    switch (preset) {
+    case Preset::Koto:
+        return kKotoTuning;
+    case Preset::Guitar:
+    default:
+        return kGuitarTuning;
+    }
+}
+
+SympatheticStrings::SympatheticStrings() {
+    setSampleRate(sampleRate_);
+    setTuning(kGuitarTuning);
+}
+
+void SympatheticStrings::setSampleRate(double sampleRate) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    sampleRate_ = sampleRate;
+    // Longest loop plus its second tap and the sample being written.
+    const auto longest = static_cast<std::size_t>(std::ceil(sampleRate_ / kMinFrequencyHz));
+    ringSize_ = std::bit_ceil(longest + 2);
+    rings_.assign(kMaxStrings * ringSize_, 0.0f);
+    updateCoefficients();
+    reset();
+}
+
+void SympatheticStrings::setTuning(std::span<const float> frequenciesHz) {
+    stringCount_ = std::min(frequenciesHz.size(), kMaxStrings);
+    std::copy_n(frequenciesHz.begin(), stringCount_, frequencies_.begin());
+    std::fill(frequencies_.begin() + static_cast<std::ptrdiff_t>(stringCount_),
+              frequencies_.end(), 0.0f);
+    groupCount_ = (stringCount_ + simd::kLanes - 1) / simd::kLanes;
+    updateCoefficients();
+    reset();
+}
+
+void SympatheticStrings::setAmount(float amount) {
+    amount_ = std::clamp(amount, 0.0f, 1.0f);
+}
+
+void SympatheticStrings::reset() {
+    std::fill(rings_.begin(), rings_.end(), 0.0f);
+    writeIndex_ = 0;
+    quietFrames_ = 0;
+    idle_ = true;
+}
+
+void SympatheticStrings::saveState(StateWriter& out) const {
+    out.pod(ringSize_);
+    out.pod(groupCount_);
+    out.pod(writeIndex_);
+    out.pod(quietFrames_);
+    out.pod(appliedAmount_);
+    out.pod(idle_);
+    if (!idle_) {
+        // Rows are groupCount_ * kLanes wide; the rest of rings_ is unused.
+        out.floats(rings_.data(), ringSize_ * groupCount_ * simd::kLanes);
+    }
+}
+
+bool SympatheticStrings::loadState(StateReader& in) {
+    std::size_t ringSize = 0;
+    std::size_t groups = 0;
+    if (in.pod(ringSize) && in.pod(groups) && (ringSize != ringSize_ || groups != groupCount_)) {
+        in.fail();
+    }
+    in.pod(writeIndex_);
+    in.pod(quietFrames_);
+    in.pod(appliedAmount_);
+    in.pod(idle_);
+    if (in.ok() && !idle_) {
+        in.floats(rings_.data(), ringSize_ * groupCount_ * simd::kLanes);
+    }
+    writeIndex_ &= ringSize_ - 1;
+    if (!in.ok()) {
+        reset();
+    } else if (idle_) {
+        std::fill(rings_.begin(), rings_.end(), 0.0f);
+    }
+    return in.ok();
+}
+
+void SympatheticStrings::updateCoefficients() {
+    for (std::size_t s = 0; s < kMaxStrings; ++s) {
+        length_[s] = 1;
+        inputGain_[s] = 0.0f;
+        nearTap_[s] = 0.0f;
+        farTap_[s] = 0.0f;
+        if (s >= stringCount_ || frequencies_[s] <= 0.0f) {
+            continue;
+        }
+        const double frequency = std::clamp(static_cast<double>(frequencies_[s]), kMinFrequencyHz,
+                                            0.25 * sampleRate_);
+        const double period = sampleRate_ / frequency;
+        const double whole = std::floor(period);
+        const double fraction = period - whole;
+        const double g = std::pow(10.0, -3.0 / (kDecaySeconds * frequency));
+        length_[s] = static_cast<std::size_t>(whole);
+        // (1 - g) keeps each resonance peak near unit gain.
+        inputGain_[s] = static_cast<float>(1.0 - g);
+        nearTap_[s] = static_cast<float>(g * (1.0 - fraction));
+        farTap_[s] = static_cast<float>(g * fraction);
+    }
+    const auto strings = std::max<std::size_t>(stringCount_, 1);
+    outputScale_ = 1.0f / std::sqrt(static_cast<float>(strings));
+}
+
+void SympatheticStrings::processBlock(float* left, float* right, std::size_t frames,
+                                      const float* excite) {
+    if (!left || frames == 0 || groupCount_ == 0) {
+        return;
+    }
+    if (amount_ == 0.0f && appliedAmount_ == 0.0f) {
+        if (!idle_) {
+            reset();
+        }
+        return;
+    }
+    float inputPeak = 0.0f;
+    for (std::size_t n = 0; n < frames; ++n) {
+        inputPeak = std::max(inputPeak, std::abs(left[n]));
+        if (right) {
+            inputPeak = std::max(inputPeak, std::abs(right[n]));
+        }
+        if (excite) {
+            inputPeak = std::max(inputPeak, std::abs(excite[n]));
+        }
+    }
+    if (idle_ && inputPeak < kSilentLevel) {
+        appliedAmount_ = amount_;
+        return;
+    }
+    idle_ = false;
+
+    using simd::Float4;
+    constexpr std::size_t kGroups = kMaxStrings / simd::kLanes;
+    Float4 inputGain[kGroups];
+    Float4 nearTap[kGroups];
+    Float4 farTap[kGroups];
+    const std::size_t groups = groupCount_;
+    for (std::size_t g = 0; g < groups; ++g) {
+        const std::size_t offset = g * simd::kLanes;
+        inputGain[g] = simd::Load(inputGain_.data() + offset);
+        nearTap[g] = simd::Load(nearTap_.data() + offset);
+        farTap[g] = simd::Load(farTap_.data() + offset);
+    }
+    const std::size_t strings = groups * simd::kLanes;
+    const std::size_t mask = ringSize_ - 1;
+    std::size_t write = writeIndex_;
+    float amount = appliedAmount_;
+    const float step = (amount_ - appliedAmount_) / static_cast<float>(frames);
+    float outputPeak = 0.0f;
+    alignas(16) float nearValue[kMaxStrings];
+    alignas(16) float farValue[kMaxStrings];
+    alignas(16) float lanes[simd::kLanes];
+    float* rings = rings_.data();
+    for (std::size_t n = 0; n < frames; ++n) {
+        const float x =
+            (right ? 0.5f * (left[n] + right[n]) : left[n]) + (excite ? excite[n] : 0.0f);
+        for (std::size_t s = 0; s < strings; ++s) {
+            nearValue[s] = rings[((write - length_[s]) & mask) * strings + s];
+            farValue[s] = rings[((write - length_[s] - 1) & mask) * strings + s];
+        }
+        const Float4 drive = simd::Set1(x);
+        Float4 sum = simd::Set1(0.0f);
+        for (std::size_t g = 0; g < groups; ++g) {
+            const std::size_t offset = g * simd::kLanes;
+            const Float4 y = simd::Add(
+                simd::Mul(inputGain[g], drive),
+                simd::Add(simd::Mul(nearTap[g], simd::Load(nearValue + offset)),
+                          simd::Mul(farTap[g], simd::Load(farValue + offset))));
+            simd::Store(rings + write * strings + offset, y);
+            sum = simd::Add(sum, y);
+        }
+        simd::Store(lanes, sum);
+        const float wet = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) * outputScale_;
+        outputPeak = std::max(outputPeak, std::abs(wet));
+        amount += step;
+        left[n] += amount * wet;
+        if (right) {
+            right[n] += amount * wet;
+        }
+        write = (write + 1) & mask;
+    }
+    writeIndex_ = write;
+    appliedAmount_ = amount_;
+
+    // Once a ring's worth of silence has gone by the loops hold nothing
+    // audible; clear them before they decay into subnormals.
+    if (inputPeak < kSilentLevel && outputPeak < kSilentLevel) {
+        quietFrames_ += frames;
+        if (quietFrames_ >= ringSize_) {
+            reset();
+        }
+    } else {
+        quietFrames_ = 0;
+    }
+}
+
+}  // namespace dsp
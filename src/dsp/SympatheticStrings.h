@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace dsp {
+
+class StateReader;
+class StateWriter;
+
+// Open strings ringing along with the ones being played: a fixed bank of
+// lightly damped string loops, all driven by the voice mix and added back on
+// top of it. Each loop is
+//     y[n] = (1 - g) x[n] + g ((1 - f) y[n-L] + f y[n-L-1]),
+// a comb whose two-tap interpolation sets the fractional length L + f and
+// doubles as the loss filter, so only partials shared with an open string
+// build up. Loops run four to a simd::Float4; the cost depends on the number
+// of strings, not on how many voices feed the bus.
+class SympatheticStrings {
+public:
+    static constexpr std::size_t kMaxStrings = 16;
+    // Lower tunings are raised to this so the rings never reallocate.
+    static constexpr double kMinFrequencyHz = 40.0;
+
+    enum class Preset { Guitar, Koto };
+
+    // Built-in open-string tunings in Hz (static storage).
+    static std::span<const float> PresetTuning(Preset preset);
+
+    SympatheticStrings();
+
+    // Allocates the rings; not for the audio thread.
+    void setSampleRate(double sampleRate);
+    // Takes the first kMaxStrings frequencies; resets the strings.
+    void setTuning(std::span<const float> frequenciesHz);
+    // Wet level in [0, 1]; ramps over the next block. 0 bypasses the bank once
+    // it has rung out.
+    void setAmount(float amount);
+    std::size_t stringCount() const { return stringCount_; }
+    void reset();
+    // The rings and level ramp for snapshots; tuning and rate are the
+    // caller's to set up first. loadState() is false (and resets) if the
+    // rings are laid out differently.
+    void saveState(StateWriter& out) const;
+    bool loadState(StateReader& in);
+
+    // In place: dry plus amount times the strings' output.
+    void processBlock(float* samples, std::size_t frames) {
+        processBlock(samples, nullptr, frames);
+    }
+    // Stereo: the strings are driven by the mid and ring in both channels.
+    // A null `right` runs mono. A non-null `excite` (frames samples) drives
+    // the strings as well without being passed through.
+    void processBlock(float* left, float* right, std::size_t frames,
+                      const float* excite = nullptr);
+
+private:
+    void updateCoefficients();
+
+    std::array<float, kMaxStrings> frequencies_{};
+    std::size_t stringCount_ = 0;
+    std::size_t groupCount_ = 0;
+    // Per-string loop length and tap weights, zero past stringCount_.
+    std::array<std::size_t, kMaxStrings> length_{};
+    alignas(16) std::array<float, kMaxStrings> inputGain_{};
+    alignas(16) std::array<float, kMaxStrings> nearTap_{};
+    alignas(16) std::array<float, kMaxStrings> farTap_{};
+    // Power-of-two rings of ringSize_ samples, interleaved: each row holds
+    // one sample of every string in use (groupCount_ * kLanes of them), so
+    // a step writes one contiguous row and the rings never alias in cache.
+    std::vector<float> rings_;
+    std::size_t ringSize_ = 0;
+    std::size_t writeIndex_ = 0;
+    std::size_t quietFrames_ = 0;  // consecutive silent frames in and out
+    float amount_ = 0.0f;
+    float appliedAmount_ = 0.0f;
+    float outputScale_ = 1.0f;
+    bool idle_ = true;  // rings are all zero
+    double sampleRate_ = 44100.0;
+};
+
+}  // namespace dsp
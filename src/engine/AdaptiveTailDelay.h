@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include "dsp/StateSnapshot.h"
+
+namespace engine {
+
+// How many blocks behind its input the room's worker tail is consumed,
+// adapted to the worker's timing. It starts at the minimum; a tail block
+// missing when due adds a block, up to the maximum. A window of on-time
+// blocks that each had at least two more queued behind them takes one back,
+// and the caller skips ahead a block to match. One thread only.
+class AdaptiveTailDelay {
+public:
+    AdaptiveTailDelay(std::size_t minBlocks, std::size_t maxBlocks, std::size_t windowBlocks)
+        : minBlocks_(minBlocks),
+          maxBlocks_(std::max(minBlocks, maxBlocks)),
+          windowBlocks_(std::max<std::size_t>(1, windowBlocks)),
+          blocks_(minBlocks) {}
+
+    std::size_t blocks() const { return blocks_; }
+    std::size_t minBlocks() const { return minBlocks_; }
+    std::size_t maxBlocks() const { return maxBlocks_; }
+
+    // The block due was missing. Without `adapt` (the worker was stalled on
+    // purpose) the delay stays; the window restarts either way.
+    void late(bool adapt) {
+        if (adapt && blocks_ < maxBlocks_) {
+            ++blocks_;
+        }
+        restartWindow();
+    }
+
+    // The block due was there with `spare` more queued behind it;
+    // `nextReady` when the first of those is the block after it. True when
+    // the delay just shrank: the caller plays that next block instead,
+    // crossfading from this one.
+    bool onTime(std::size_t spare, bool nextReady) {
+        minSpare_ = std::min(minSpare_, spare);
+        if (++cleanBlocks_ < windowBlocks_) {
+            return false;
+        }
+        const bool shrink = minSpare_ >= 2 && blocks_ > minBlocks_ && nextReady;
+        if (shrink) {
+            --blocks_;
+        }
+        restartWindow();
+        return shrink;
+    }
+
+    // Forgets the on-time blocks counted so far, keeping the delay.
+    void restartWindow() {
+        cleanBlocks_ = 0;
+        minSpare_ = std::numeric_limits<std::size_t>::max();
+    }
+
+    void reset() {
+        blocks_ = minBlocks_;
+        restartWindow();
+    }
+
+    void saveState(dsp::StateWriter& out) const {
+        out.pod(blocks_);
+        out.pod(cleanBlocks_);
+        out.pod(minSpare_);
+    }
+
+    // Fails the reader on a delay outside [minBlocks, maxBlocks].
+    bool loadState(dsp::StateReader& in) {
+        if (in.pod(blocks_) && (blocks_ < minBlocks_ || blocks_ > maxBlocks_)) {
+            in.fail();
+        }
+        in.pod(cleanBlocks_);
+        in.pod(minSpare_);
+        if (!in.ok()) {
+            reset();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::size_t minBlocks_;
+    std::size_t maxBlocks_;
+    std::size_t windowBlocks_;
+    std::size_t blocks_;
+    std::size_t cleanBlocks_ = 0;
+    std::size_t minSpare_ = std::numeric_limits<std::size_t>::max();
+};
+
+}  // namespace engine
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "dsp/Simd.h"
+
+namespace engine {
+
+// A release ends once the envelope falls below this.
+inline constexpr float kEnvelopeFloor = 1e-5f;
+inline constexpr double kDefaultAttackSecondsValue = 0.004;
+
+namespace detail {
+
+// level * min(1, (first + k) / length) for the attack, level * max(0, 1 -
+// (first + k) / length) for the release, four samples per step. The same
+// float operations as AmpEnvelope::next(), so the curves match it exactly
+// (indices stay far below 2^24).
+template <bool Release>
+void FillEnvelopeRamp(float* out, std::size_t count, std::size_t first, std::size_t length,
+                      float level) {
+    namespace simd = dsp::simd;
+    alignas(16) static constexpr float kOffsets[simd::kLanes] = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float denominator = static_cast<float>(length);
+    const simd::Float4 vDenominator = simd::Set1(denominator);
+    const simd::Float4 vLevel = simd::Set1(level);
+    const simd::Float4 one = simd::Set1(1.0f);
+    const simd::Float4 zero = simd::Set1(0.0f);
+    const simd::Float4 stride = simd::Set1(static_cast<float>(simd::kLanes));
+    simd::Float4 index = simd::Add(simd::Set1(static_cast<float>(first)), simd::Load(kOffsets));
+    std::size_t k = 0;
+    for (; k + simd::kLanes <= count; k += simd::kLanes) {
+        const simd::Float4 t = simd::Div(index, vDenominator);
+        const simd::Float4 shape =
+            Release ? simd::Max(simd::Sub(one, t), zero) : simd::Min(t, one);
+        simd::Store(out + k, simd::Mul(vLevel, shape));
+        index = simd::Add(index, stride);
+    }
+    for (; k < count; ++k) {
+        const float t = static_cast<float>(first + k) / denominator;
+        out[k] = level * (Release ? std::max(0.0f, 1.0f - t) : std::min(1.0f, t));
+    }
+}
+
+}  // namespace detail
+
+// A note's amplitude: a linear attack to the strike level, held until
+// noteOff(), then a linear release. next() steps it a sample at a time and
+// render() a block at a time, with the same samples either way.
+class AmpEnvelope {
+public:
+    AmpEnvelope() = default;
+
+    void setSampleRate(double sampleRate) {
+        sampleRate_ = sampleRate > 0.0 ? sampleRate : sampleRate_;
+        updateAttackSamples();
+        updateReleaseSamples();
+    }
+
+    void setAttackSeconds(double seconds) {
+        attackSeconds_ = std::max(0.0, seconds);
+        updateAttackSamples();
+    }
+
+    void setReleaseSeconds(double seconds) {
+        releaseSeconds_ = std::max(0.0, seconds);
+        updateReleaseSamples();
+    }
+
+    void noteOn(float targetLevel) {
+        targetLevel_ = std::max(0.0f, targetLevel);
+        stageCursor_ = 0;
+        if (attackSamples_ == 0) {
+            level_ = targetLevel_;
+            stage_ = Stage::Sustain;
+        } else {
+            level_ = 0.0f;
+            stage_ = Stage::Attack;
+        }
+    }
+
+    void noteOff() {
+        if (stage_ == Stage::Idle) {
+            return;
+        }
+        stage_ = Stage::Release;
+        stageCursor_ = 0;
+        updateReleaseSamples();
+        releaseStartLevel_ = level_;
+        if (releaseSamples_ == 0) {
+            level_ = 0.0f;
+            stage_ = Stage::Idle;
+        }
+    }
+
+    float next() {
+        switch (stage_) {
+            case Stage::Idle:
+                level_ = 0.0f;
+                return level_;
+            case Stage::Attack: {
+                if (attackSamples_ == 0) {
+                    level_ = targetLevel_;
+                    stage_ = Stage::Sustain;
+                    return level_;
+                }
+                const float t = static_cast<float>(stageCursor_ + 1) /
+                                static_cast<float>(attackSamples_);
+                level_ = targetLevel_ * std::min(1.0f, t);
+                if (++stageCursor_ >= attackSamples_) {
+                    stage_ = Stage::Sustain;
+                    stageCursor_ = 0;
+                }
+                return level_;
+            }
+            case Stage::Sustain:
+                level_ = targetLevel_;
+                return level_;
+            case Stage::Release: {
+                if (releaseSamples_ == 0) {
+                    level_ = 0.0f;
+                    stage_ = Stage::Idle;
+                    return level_;
+                }
+                const float t = static_cast<float>(stageCursor_) /
+                                static_cast<float>(releaseSamples_);
+                const float factor = std::max(0.0f, 1.0f - t);
+                level_ = releaseStartLevel_ * factor;
+                if (++stageCursor_ >= releaseSamples_ || level_ < kEnvelopeFloor) {
+                    level_ = 0.0f;
+                    stage_ = Stage::Idle;
+                }
+                return level_;
+            }
+        }
+        return 0.0f;
+    }
+
+    // Fills gains with what `frames` calls to next() would return, a stage
+    // at a time: ramps via FillEnvelopeRamp(), sustain and idle as constants.
+    void render(float* gains, std::size_t frames) {
+        std::size_t i = 0;
+        while (i < frames) {
+            switch (stage_) {
+                case Stage::Idle:
+                    level_ = 0.0f;
+                    std::fill(gains + i, gains + frames, 0.0f);
+                    return;
+                case Stage::Sustain:
+                    level_ = targetLevel_;
+                    std::fill(gains + i, gains + frames, level_);
+                    return;
+                case Stage::Attack: {
+                    // A length shortened under the cursor ends on the next sample.
+                    if (stageCursor_ >= attackSamples_) {
+                        gains[i++] = next();
+                        break;
+                    }
+                    const std::size_t n = std::min(frames - i, attackSamples_ - stageCursor_);
+                    detail::FillEnvelopeRamp<false>(gains + i, n, stageCursor_ + 1, attackSamples_,
+                                            targetLevel_);
+                    level_ = gains[i + n - 1];
+                    stageCursor_ += n;
+                    if (stageCursor_ >= attackSamples_) {
+                        stage_ = Stage::Sustain;
+                        stageCursor_ = 0;
+                    }
+                    i += n;
+                    break;
+                }
+                case Stage::Release: {
+                    if (stageCursor_ >= releaseSamples_) {
+                        gains[i++] = next();
+                        break;
+                    }
+                    const std::size_t n = std::min(frames - i, releaseSamples_ - stageCursor_);
+                    detail::FillEnvelopeRamp<true>(gains + i, n, stageCursor_, releaseSamples_,
+                                           releaseStartLevel_);
+                    // The release ends (returning 0) on its last sample or the
+                    // first one below the floor; the ramp never rises, so that
+                    // is a partition point.
+                    const std::size_t above = static_cast<std::size_t>(
+                        std::partition_point(gains + i, gains + i + n,
+                                             [](float g) { return g >= kEnvelopeFloor; }) -
+                        (gains + i));
+                    const bool reachesEnd = stageCursor_ + n == releaseSamples_;
+                    const std::size_t last = std::min(above, reachesEnd ? n - 1 : n);
+                    if (last < n) {
+                        gains[i + last] = 0.0f;
+                        level_ = 0.0f;
+                        stage_ = Stage::Idle;
+                        i += last + 1;
+                        break;
+                    }
+                    level_ = gains[i + n - 1];
+                    stageCursor_ += n;
+                    i += n;
+                    break;
+                }
+            }
+        }
+    }
+
+    bool isIdle() const { return stage_ == Stage::Idle; }
+    bool isReleasing() const { return stage_ == Stage::Release; }
+    bool isSustaining() const { return stage_ == Stage::Sustain; }
+    float level() const { return level_; }
+
+private:
+    enum class Stage { Idle, Attack, Sustain, Release };
+
+    void updateAttackSamples() {
+        attackSamples_ = static_cast<std::size_t>(
+            std::max(0.0, std::round(attackSeconds_ * sampleRate_)));
+    }
+
+    void updateReleaseSamples() {
+        releaseSamples_ = static_cast<std::size_t>(
+            std::max(0.0, std::round(releaseSeconds_ * sampleRate_)));
+    }
+
+    // next() only touches the fields up to releaseSamples_.
+    Stage stage_ = Stage::Idle;
+    float level_ = 0.0f;
+    float targetLevel_ = 1.0f;
+    float releaseStartLevel_ = 0.0f;
+    std::size_t stageCursor_ = 0;
+    std::size_t attackSamples_ = 0;
+    std::size_t releaseSamples_ = 0;
+    double sampleRate_ = 44100.0;
+    double attackSeconds_ = kDefaultAttackSecondsValue;
+    double releaseSeconds_ = 0.35;
+};
+
+}  // namespace engine
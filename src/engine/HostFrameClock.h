@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+
+namespace engine {
+
+// Maps host timestamps (e.g. QPC ticks) to engine frames so input events
+// can be scheduled where they happened instead of at the next block start.
+// The audio thread anchors the clock at the start of every block; an event
+// stamped t then plays at
+//     anchorFrame + (t - anchorTicks) * framesPerTick + latencyFrames,
+// i.e. a constant one-block delay instead of up to a block of jitter.
+// Events older than the anchor land on the anchor's block start at the
+// earliest. Writer never waits; readers retry a publish they raced.
+class HostFrameClock {
+public:
+    // An anchor this many blocks old means the stream stopped or stalled;
+    // frameAt() then declines rather than scheduling into the far future.
+    static constexpr double kStaleBlocks = 8.0;
+
+    // Audio thread, once per block before rendering it.
+    void publish(std::int64_t hostTicks,
+                 std::uint64_t frame,
+                 double framesPerTick,
+                 std::uint64_t latencyFrames) {
+        const std::uint32_t seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        anchorTicks_.store(hostTicks, std::memory_order_relaxed);
+        anchorFrame_.store(frame, std::memory_order_relaxed);
+        framesPerTick_.store(framesPerTick, std::memory_order_relaxed);
+        latencyFrames_.store(latencyFrames, std::memory_order_relaxed);
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any thread: engine frame for an event stamped `hostTicks`; nullopt
+    // before the first publish() or when the last anchor is stale.
+    std::optional<std::uint64_t> frameAt(std::int64_t hostTicks) const {
+        return frameAt(hostTicks, hostTicks);
+    }
+
+    // Same for an event scheduled ahead (e.g. an OSC bundle's time tag): the
+    // anchor's age is judged at `nowTicks`, so `hostTicks` may lie any
+    // distance past the current block.
+    std::optional<std::uint64_t> frameAt(std::int64_t hostTicks, std::int64_t nowTicks) const {
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            const std::uint32_t before = sequence_.load(std::memory_order_acquire);
+            if (before == 0) {
+                return std::nullopt;
+            }
+            if (before & 1u) {
+                continue;  // publish in progress
+            }
+            const std::int64_t ticks = anchorTicks_.load(std::memory_order_relaxed);
+            const std::uint64_t frame = anchorFrame_.load(std::memory_order_relaxed);
+            const double rate = framesPerTick_.load(std::memory_order_relaxed);
+            const std::uint64_t latency = latencyFrames_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+            const double age = std::round(static_cast<double>(nowTicks - ticks) * rate);
+            if (age > kStaleBlocks * static_cast<double>(std::max<std::uint64_t>(latency, 1))) {
+                return std::nullopt;
+            }
+            const double elapsed = std::round(static_cast<double>(hostTicks - ticks) * rate);
+            const double delta = elapsed + static_cast<double>(latency);
+            return frame + static_cast<std::uint64_t>(std::max(0.0, delta));
+        }
+        return std::nullopt;
+    }
+
+private:
+    std::atomic<std::uint32_t> sequence_{0};  // odd while publishing
+    std::atomic<std::int64_t> anchorTicks_{0};
+    std::atomic<std::uint64_t> anchorFrame_{0};
+    std::atomic<double> framesPerTick_{0.0};
+    std::atomic<std::uint64_t> latencyFrames_{0};
+};
+
+}  // namespace engine
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+// Fixed-bucket histogram of callback durations. record() is wait-free and
+// meant for the audio thread; snapshot() copies the counters from any other
+// thread without stopping the writer. Counters only grow, so a measurement
+// window is the difference between two snapshots and resetting it never
+// touches the audio side.
+class LatencyHistogram {
+public:
+    static constexpr double kBucketUs = 10.0;
+    // The last bucket collects everything from kBucketCount-1 buckets up
+    // (about 41 ms).
+    static constexpr std::size_t kBucketCount = 4096;
+
+    struct Snapshot {
+        std::array<std::uint32_t, kBucketCount> counts{};
+        std::uint64_t callbacks = 0;
+        std::uint64_t overruns = 0;  // callbacks longer than their period
+
+        // Upper edge of the bucket holding the p-quantile (0..1), so the
+        // estimate errs towards slow by at most one bucket.
+        double percentileUs(double p) const {
+            std::uint64_t total = 0;
+            for (const std::uint32_t c : counts) {
+                total += c;
+            }
+            if (total == 0) {
+                return 0.0;
+            }
+            const double clamped = p < 0.0 ? 0.0 : (p > 1.0 ? 1.0 : p);
+            std::uint64_t rank = static_cast<std::uint64_t>(clamped * static_cast<double>(total));
+            rank = rank < 1 ? 1 : (rank > total ? total : rank);
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < kBucketCount; ++i) {
+                seen += counts[i];
+                if (seen >= rank) {
+                    return static_cast<double>(i + 1) * kBucketUs;
+                }
+            }
+            return static_cast<double>(kBucketCount) * kBucketUs;
+        }
+        // Upper edge of the highest non-empty bucket.
+        double maxUs() const {
+            for (std::size_t i = kBucketCount; i-- > 0;) {
+                if (counts[i] != 0) {
+                    return static_cast<double>(i + 1) * kBucketUs;
+                }
+            }
+            return 0.0;
+        }
+        // Counts accumulated since `baseline` was taken.
+        Snapshot since(const Snapshot& baseline) const {
+            Snapshot window;
+            for (std::size_t i = 0; i < kBucketCount; ++i) {
+                window.counts[i] = counts[i] - baseline.counts[i];
+            }
+            window.callbacks = callbacks - baseline.callbacks;
+            window.overruns = overruns - baseline.overruns;
+            return window;
+        }
+    };
+
+    // Audio thread. `periodUs` is the buffer's duration; 0 skips the
+    // overrun check.
+    void record(double elapsedUs, double periodUs) {
+        std::size_t index = kBucketCount - 1;
+        if (elapsedUs < static_cast<double>(kBucketCount - 1) * kBucketUs) {
+            index = elapsedUs > 0.0 ? static_cast<std::size_t>(elapsedUs / kBucketUs) : 0;
+        }
+        counts_[index].fetch_add(1, std::memory_order_relaxed);
+        if (periodUs > 0.0 && elapsedUs > periodUs) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        callbacks_.fetch_add(1, std::memory_order_release);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.callbacks = callbacks_.load(std::memory_order_acquire);
+        s.overruns = overruns_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < kBucketCount; ++i) {
+            s.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+private:
+    std::array<std::atomic<std::uint32_t>, kBucketCount> counts_{};
+    std::atomic<std::uint64_t> callbacks_{0};
+    std::atomic<std::uint64_t> overruns_{0};
+};
+
+}  // namespace engine
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace engine {
+
+// A whole file mapped read-only into memory; pages come in as they are
+// touched, so opening a large file costs nothing up front.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Replaces any open mapping. An empty file opens with no bytes.
+    bool open(const std::filesystem::path& path, std::string& errorMessage);
+    void close();
+
+    bool isOpen() const { return open_; }
+    std::span<const std::uint8_t> bytes() const { return {data_, size_}; }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool open_ = false;
+#if defined(_WIN32)
+    void* mapping_ = nullptr;  // HANDLE of the file mapping object
+#endif
+};
+
+}  // namespace engine
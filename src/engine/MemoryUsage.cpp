@@ -0,0 +1,72 @@
+#include "engine/MemoryUsage.h"
+
+#include <atomic>
+#include <utility>
+
+namespace engine {
+
+namespace {
+
+// Constant-initialised and trivially destroyed, so owners in other statics
+// can count in and out at any point of start-up or exit.
+constinit std::array<std::atomic<std::size_t>, kMemoryCategoryCount> gTotals{};
+
+void Adjust(MemoryCategory category, std::size_t add, std::size_t remove) {
+    auto& total = gTotals[static_cast<std::size_t>(category)];
+    if (add > remove) {
+        total.fetch_add(add - remove, std::memory_order_relaxed);
+    } else if (remove > add) {
+        total.fetch_sub(remove - add, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace
+
+MemoryUsage ReadMemoryUsage() {
+    MemoryUsage usage;
+    for (std::size_t i = 0; i < kMemoryCategoryCount; ++i) {
+        usage.bytes[i] = gTotals[i].load(std::memory_order_relaxed);
+    }
+    return usage;
+}
+
+TrackedBytes::TrackedBytes(MemoryCategory category, std::size_t bytes)
+    : category_(category), bytes_(bytes) {
+    Adjust(category_, bytes_, 0);
+}
+
+TrackedBytes::TrackedBytes(const TrackedBytes& other)
+    : TrackedBytes(other.category_, other.bytes_) {}
+
+TrackedBytes::TrackedBytes(TrackedBytes&& other) noexcept
+    : category_(other.category_), bytes_(std::exchange(other.bytes_, 0)) {}
+
+TrackedBytes& TrackedBytes::operator=(const TrackedBytes& other) {
+    if (this != &other) {
+        Adjust(category_, 0, bytes_);
+        category_ = other.category_;
+        bytes_ = other.bytes_;
+        Adjust(category_, bytes_, 0);
+    }
+    return *this;
+}
+
+TrackedBytes& TrackedBytes::operator=(TrackedBytes&& other) noexcept {
+    if (this != &other) {
+        Adjust(category_, 0, bytes_);
+        category_ = other.category_;
+        bytes_ = std::exchange(other.bytes_, 0);
+    }
+    return *this;
+}
+
+TrackedBytes::~TrackedBytes() {
+    Adjust(category_, 0, bytes_);
+}
+
+void TrackedBytes::set(std::size_t bytes) {
+    Adjust(category_, bytes, bytes_);
+    bytes_ = bytes;
+}
+
+}  // namespace engine
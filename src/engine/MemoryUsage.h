@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+// Where the process's large allocations go, for deciding which reduction
+// features a memory-bound box needs.
+enum class MemoryCategory : std::uint8_t {
+    Kernels,  // room convolution kernels and heads
+    Voices,   // voice pool: strings, scratch
+    Queues,   // event queue, room dry/wet block rings
+    Samples,  // frozen parts, pre-shaped excitations, loaded IRs
+    Preview,  // UI previews and scope captures
+    Count
+};
+
+inline constexpr std::size_t kMemoryCategoryCount = static_cast<std::size_t>(MemoryCategory::Count);
+
+inline const char* MemoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Kernels: return "kernels";
+        case MemoryCategory::Voices: return "voices";
+        case MemoryCategory::Queues: return "queues";
+        case MemoryCategory::Samples: return "samples";
+        case MemoryCategory::Preview: return "preview";
+        default: return "?";
+    }
+}
+
+// Bytes per category, summed over every engine in the process.
+struct MemoryUsage {
+    std::array<std::size_t, kMemoryCategoryCount> bytes{};
+
+    std::size_t operator[](MemoryCategory category) const {
+        return bytes[static_cast<std::size_t>(category)];
+    }
+    std::size_t total() const {
+        std::size_t sum = 0;
+        for (const std::size_t b : bytes) {
+            sum += b;
+        }
+        return sum;
+    }
+};
+
+// Any thread; a handful of relaxed loads.
+MemoryUsage ReadMemoryUsage();
+
+// The bytes one owner holds in a category, counted in ReadMemoryUsage()
+// while it lives. Owners set() it where they allocate, from any thread
+// (it is one atomic add, so the audio thread may too). A copy counts again,
+// as the owner's copy duplicates the memory; a move hands the count over.
+class TrackedBytes {
+public:
+    explicit TrackedBytes(MemoryCategory category, std::size_t bytes = 0);
+    TrackedBytes(const TrackedBytes& other);
+    TrackedBytes(TrackedBytes&& other) noexcept;
+    TrackedBytes& operator=(const TrackedBytes& other);
+    TrackedBytes& operator=(TrackedBytes&& other) noexcept;
+    ~TrackedBytes();
+
+    void set(std::size_t bytes);
+    std::size_t bytes() const { return bytes_; }
+    MemoryCategory category() const { return category_; }
+
+private:
+    MemoryCategory category_;
+    std::size_t bytes_ = 0;
+};
+
+// Capacity of a contiguous container, in bytes.
+template <typename Container>
+std::size_t CapacityBytes(const Container& c) {
+    return c.capacity() * sizeof(typename Container::value_type);
+}
+
+}  // namespace engine
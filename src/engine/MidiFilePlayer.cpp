@@ -0,0 +1,221 @@
+#include "engine/MidiFilePlayer.h"
+
+#include <algorithm>
+
+#include "engine/MidiNote.h"
+
+namespace engine {
+
+namespace {
+int NoteId(std::uint8_t channel, std::uint8_t key) { return channel * 128 + key; }
+
+// Pitch bend, pressure, timbre.
+constexpr std::array<float, 3> kNeutralExpression = {0.0f, 0.0f, 0.5f};
+}  // namespace
+
+bool MidiFilePlayer::open(const std::filesystem::path& path, std::string& errorMessage) {
+    finished_ = true;
+    return reader_.open(path, errorMessage);
+}
+
+bool MidiFilePlayer::openBytes(std::vector<std::uint8_t> bytes, std::string& errorMessage) {
+    finished_ = true;
+    return reader_.openBytes(std::move(bytes), errorMessage);
+}
+
+void MidiFilePlayer::start(std::uint64_t startFrame, double sampleRate) {
+    reader_.rewind();
+    startFrame_ = startFrame;
+    sampleRate_ = sampleRate;
+    lastEventFrame_ = startFrame;
+    hasHeld_ = false;
+    finished_ = !reader_.isOpen() || sampleRate <= 0.0;
+    sounding_.reset();
+    bent_.reset();
+    mpe_ = mpeRequested_;
+    channelExpression_.fill(kNeutralExpression);
+}
+
+std::size_t MidiFilePlayer::schedule(StringSynthEngine& synth, std::uint64_t horizonFrame) {
+    std::size_t queued = 0;
+    while (!finished_) {
+        if (!hasHeld_) {
+            if (!reader_.next(held_)) {
+                finished_ = true;
+                break;
+            }
+            heldFrame_ = startFrame_ + static_cast<std::uint64_t>(
+                                           std::llround(std::max(0.0, held_.seconds) * sampleRate_));
+            hasHeld_ = true;
+        }
+        if (heldFrame_ >= horizonFrame) {
+            break;
+        }
+        if (!dispatch(synth, held_, heldFrame_)) {
+            break;  // queue full: retry from here next time
+        }
+        hasHeld_ = false;
+        lastEventFrame_ = std::max(lastEventFrame_, heldFrame_);
+        ++queued;
+    }
+    return queued;
+}
+
+void MidiFilePlayer::stop(StringSynthEngine& synth, std::uint64_t frame) {
+    for (std::uint8_t channel = 0; channel < 16; ++channel) {
+        releaseNotes(synth, channel, frame);
+        if (bent_.test(channel)) {
+            const std::size_t part =
+                mpe_ ? 0 : channel % std::max<std::size_t>(1, synth.partCount());
+            (void)enqueueParam(synth, part, ParamId::SustainPedal, 0.0f, frame);
+            (void)enqueueParam(synth, part, ParamId::SostenutoPedal, 0.0f, frame);
+            (void)enqueueParam(synth, part, ParamId::PitchBend, 0.0f, frame);
+        }
+    }
+    bent_.reset();
+    hasHeld_ = false;
+    finished_ = true;
+}
+
+bool MidiFilePlayer::dispatch(StringSynthEngine& synth, const audio::MidiFileEvent& event,
+                              std::uint64_t frame) {
+    const std::uint8_t channel = event.channel();
+    const std::size_t part = mpe_ ? 0 : channel % std::max<std::size_t>(1, synth.partCount());
+    const bool member = mpe_ && channel > 0;
+    const int noteId = NoteId(channel, event.data1);
+    Event out{};
+    out.part = part;
+    switch (event.type()) {
+        case 0x90:
+            if (event.data2 > 0) {
+                out.type = EventType::NoteOn;
+                out.noteId = noteId;
+                out.frequency = MidiNoteToFrequency(event.data1);
+                out.velocity = static_cast<float>(event.data2) / 127.0f;
+                if (!synth.enqueueEventAt(out, frame)) {
+                    return false;
+                }
+                sounding_.set(static_cast<std::size_t>(noteId));
+                // The channel's expression so far applies to its new note.
+                if (member) {
+                    for (std::size_t e = 0; e < kNeutralExpression.size(); ++e) {
+                        const float value = channelExpression_[channel][e];
+                        if (value != kNeutralExpression[e]) {
+                            (void)sendExpression(synth, noteId, static_cast<NoteExpression>(e),
+                                                 value, frame);
+                        }
+                    }
+                }
+                return true;
+            }
+            [[fallthrough]];  // velocity 0 is a note off
+        case 0x80:
+            out.type = EventType::NoteOff;
+            out.noteId = noteId;
+            if (!synth.enqueueEventAt(out, frame)) {
+                return false;
+            }
+            sounding_.reset(static_cast<std::size_t>(noteId));
+            return true;
+        case 0xB0:
+            switch (event.data1) {
+                case 64:
+                case 66:
+                    bent_.set(channel);
+                    return enqueueParam(synth, part,
+                                        event.data1 == 64 ? ParamId::SustainPedal
+                                                          : ParamId::SostenutoPedal,
+                                        event.data2 >= 64 ? 1.0f : 0.0f, frame);
+                case 74:
+                    if (member) {
+                        return setChannelExpression(synth, channel, NoteExpression::Timbre,
+                                                    static_cast<float>(event.data2) / 127.0f,
+                                                    frame);
+                    }
+                    return true;
+                case 120:
+                case 123:
+                    releaseNotes(synth, channel, frame);
+                    return true;
+                default:
+                    return true;
+            }
+        case 0xD0:
+            if (member) {
+                return setChannelExpression(synth, channel, NoteExpression::Pressure,
+                                            static_cast<float>(event.data1) / 127.0f, frame);
+            }
+            return true;
+        case 0xE0: {
+            const int bend = (event.data2 << 7 | event.data1) - 8192;
+            if (member) {
+                return setChannelExpression(
+                    synth, channel, NoteExpression::PitchBend,
+                    static_cast<float>(bend) / 8192.0f * kMpeBendRangeSemitones, frame);
+            }
+            bent_.set(channel);
+            return enqueueParam(synth, part, ParamId::PitchBend,
+                                static_cast<float>(bend) / 8192.0f * kPitchBendRangeSemitones,
+                                frame);
+        }
+        default:
+            return true;
+    }
+}
+
+bool MidiFilePlayer::enqueueParam(StringSynthEngine& synth, std::size_t part, ParamId id,
+                                  float value, std::uint64_t frame) {
+    Event event{};
+    event.type = EventType::ParamChange;
+    event.param = id;
+    event.paramValue = value;
+    event.part = part;
+    return synth.enqueueEventAt(event, frame);
+}
+
+bool MidiFilePlayer::setChannelExpression(StringSynthEngine& synth, std::uint8_t channel,
+                                          NoteExpression expression, float value,
+                                          std::uint64_t frame) {
+    channelExpression_[channel][static_cast<std::size_t>(expression)] = value;
+    // The values are absolute, so a retry after a full queue only repeats.
+    for (std::uint8_t key = 0; key < 128; ++key) {
+        const int noteId = NoteId(channel, key);
+        if (sounding_.test(static_cast<std::size_t>(noteId)) &&
+            !sendExpression(synth, noteId, expression, value, frame)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MidiFilePlayer::sendExpression(StringSynthEngine& synth, int noteId,
+                                    NoteExpression expression, float value,
+                                    std::uint64_t frame) {
+    Event event{};
+    event.type = EventType::NoteExpression;
+    event.noteId = noteId;
+    event.expression = expression;
+    event.paramValue = value;
+    event.part = 0;
+    return synth.enqueueEventAt(event, frame);
+}
+
+void MidiFilePlayer::releaseNotes(StringSynthEngine& synth, std::uint8_t channel,
+                                  std::uint64_t frame) {
+    // Best effort: a full queue drops some of these offs rather than
+    // leaving the rest to be repeated.
+    const std::size_t part = mpe_ ? 0 : channel % std::max<std::size_t>(1, synth.partCount());
+    for (std::uint8_t key = 0; key < 128; ++key) {
+        const auto id = static_cast<std::size_t>(NoteId(channel, key));
+        if (sounding_.test(id)) {
+            Event off{};
+            off.type = EventType::NoteOff;
+            off.noteId = static_cast<int>(id);
+            off.part = part;
+            (void)synth.enqueueEventAt(off, frame);
+            sounding_.reset(id);
+        }
+    }
+}
+
+}  // namespace engine
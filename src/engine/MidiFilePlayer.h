@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "audio/MidiFile.h"
+#include "engine/StringSynthEngine.h"
+
+namespace engine {
+
+// Plays a Standard MIDI File through StringSynthEngine::enqueueEventAt,
+// staying only a bounded window ahead of the render: each schedule() call
+// decodes and queues the events up to a horizon frame, so the engine's queue
+// holds a fraction of a second of the file however long the file is.
+// Offline renders call it before every block; live playback calls it from a
+// timer with the render position plus some lookahead.
+//
+// MIDI channel n plays part n % partCount() with note ids channel * 128 +
+// key; sustain (CC 64), sostenuto (CC 66), pitch bend (+-2 semitones) and all
+// notes off (CC 120/123) are honoured, everything else is skipped.
+//
+// In MPE mode (lower zone) every channel plays part 0: channel 1 is the
+// master and works as above, while on channels 2-16 pitch bend (+-48
+// semitones), channel pressure and CC 74 become the expression of the notes
+// on that channel (StringSynthEngine::noteExpression).
+class MidiFilePlayer {
+public:
+    static constexpr double kDefaultLookaheadSeconds = 0.25;
+    static constexpr float kPitchBendRangeSemitones = 2.0f;
+    static constexpr float kMpeBendRangeSemitones = 48.0f;
+
+    bool open(const std::filesystem::path& path, std::string& errorMessage);
+    bool openBytes(std::vector<std::uint8_t> bytes, std::string& errorMessage);
+
+    // Rewinds and anchors the file's time zero at `startFrame` of the synth
+    // timeline, at `sampleRate`.
+    void start(std::uint64_t startFrame, double sampleRate);
+    // Queues every event due before `horizonFrame`; returns how many. A
+    // full engine queue leaves the rest for the next call.
+    std::size_t schedule(StringSynthEngine& synth, std::uint64_t horizonFrame);
+    // Releases whatever the file holds down (notes, pedals, bend) at
+    // `frame` and ends playback.
+    void stop(StringSynthEngine& synth, std::uint64_t frame);
+
+    // Takes effect from the next start().
+    void setMpe(bool enabled) { mpeRequested_ = enabled; }
+    bool mpe() const { return mpeRequested_; }
+
+    bool isOpen() const { return reader_.isOpen(); }
+    // Every event has been queued.
+    bool finished() const { return finished_; }
+    // Frame of the latest event queued so far.
+    std::uint64_t lastEventFrame() const { return lastEventFrame_; }
+
+private:
+    // Turns a file event into engine events; false if the queue was full.
+    bool dispatch(StringSynthEngine& synth, const audio::MidiFileEvent& event,
+                  std::uint64_t frame);
+    bool enqueueParam(StringSynthEngine& synth, std::size_t part, ParamId id, float value,
+                      std::uint64_t frame);
+    // Note offs for every note the file holds on `channel`.
+    void releaseNotes(StringSynthEngine& synth, std::uint8_t channel, std::uint64_t frame);
+    // MPE: sets a member channel's expression and sends it to its notes.
+    bool setChannelExpression(StringSynthEngine& synth, std::uint8_t channel,
+                              NoteExpression expression, float value, std::uint64_t frame);
+    bool sendExpression(StringSynthEngine& synth, int noteId, NoteExpression expression,
+                        float value, std::uint64_t frame);
+
+    audio::MidiFileReader reader_;
+    std::uint64_t startFrame_ = 0;
+    double sampleRate_ = 0.0;
+    std::uint64_t lastEventFrame_ = 0;
+    audio::MidiFileEvent held_{};  // read but not yet queued
+    std::uint64_t heldFrame_ = 0;
+    bool hasHeld_ = false;
+    bool finished_ = true;
+    std::bitset<16 * 128> sounding_;  // notes the file has on, by note id
+    std::bitset<16> bent_;            // channels with a pedal or bend applied
+    bool mpeRequested_ = false;
+    bool mpe_ = false;
+    // MPE member channels' current expression, by NoteExpression.
+    std::array<std::array<float, 3>, 16> channelExpression_{};
+};
+
+}  // namespace engine
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cmath>
+
+namespace engine {
+
+// Equal-tempered frequency of a MIDI key, A4 (69) = 440 Hz. Every path that
+// turns a key into a pitch goes through here, so a note cached for a key
+// and one played live at it start from the same frequency.
+inline double MidiNoteToFrequency(int key) {
+    return 440.0 * std::pow(2.0, (key - 69) / 12.0);
+}
+
+}  // namespace engine
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "dsp/FastMath.h"
+
+namespace engine {
+
+// Per-voice sources: the two LFOs are bipolar and run from each note-on,
+// the envelope rises 0 -> 1 -> sustain, velocity is 0..1 and key tracking
+// is octaves from A4 over three (-1..1). Pressure (0..1) and timbre (-1..1)
+// are the note's expression (see NoteExpression), neutral until it is sent.
+enum class ModSource : std::uint8_t { Lfo1, Lfo2, Envelope, Velocity, KeyTrack, Pressure, Timbre };
+// Added to the voice's own value (after the note-on velocity mapping) and
+// clamped to the parameter's range. Brightness and decay move on a sounding
+// string; pick position shapes the excitation, so it is read when the
+// string is struck (note-on and restrike).
+enum class ModTarget : std::uint8_t { Brightness, Decay, PickPosition };
+
+inline constexpr std::size_t kModSourceCount = 7;
+inline constexpr std::size_t kModTargetCount = 3;
+inline constexpr std::size_t kMaxModRoutes = 8;
+
+enum class LfoShape : std::uint8_t { Sine, Triangle };
+
+struct ModLfo {
+    float rateHz = 5.0f;
+    LfoShape shape = LfoShape::Sine;
+};
+
+struct ModEnvelope {
+    float attackSeconds = 0.01f;
+    float decaySeconds = 0.3f;  // time constant towards the sustain level
+    float sustain = 0.0f;
+};
+
+struct ModRoute {
+    ModSource source = ModSource::Lfo1;
+    ModTarget target = ModTarget::Brightness;
+    float amount = 0.0f;  // in the target's units per unit of source
+};
+
+// Fixed size, so it can be handed to the audio thread by value.
+struct ModulationSettings {
+    std::array<ModLfo, 2> lfos{};
+    ModEnvelope envelope{};
+    std::array<ModRoute, kMaxModRoutes> routes{};
+    std::size_t routeCount = 0;
+
+    // False once all kMaxModRoutes are in use.
+    bool addRoute(ModSource source, ModTarget target, float amount) {
+        if (routeCount >= routes.size()) {
+            return false;
+        }
+        routes[routeCount++] = {source, target, amount};
+        return true;
+    }
+};
+
+// Evaluates ModulationSettings for every voice once per kControlFrames
+// rather than per sample: a tick advances the voice's LFOs and envelope,
+// sums the routes into one offset per target and smooths those, so the
+// per-sample loop only ever sees a coefficient that steps every 32 frames.
+// Rates are folded into per-tick increments when the settings or sample
+// rate change; ticking touches only the voice's own state.
+class ModulationMatrix {
+public:
+    static constexpr std::size_t kControlFrames = 32;
+    static constexpr double kSmoothingSeconds = 0.005;
+
+    struct VoiceState {
+        std::array<float, 2> lfoPhase{};  // cycles, [0, 1)
+        float envelope = 0.0f;
+        bool attacking = true;
+        float velocity = 0.0f;
+        float keyTrack = 0.0f;
+        float pressure = 0.0f;
+        float timbre = 0.0f;
+        std::array<float, kModTargetCount> offsets{};  // smoothed
+    };
+
+    void configure(const ModulationSettings& settings, double sampleRate) {
+        settings_ = settings;
+        sampleRate_ = sampleRate > 0.0 ? sampleRate : sampleRate_;
+        const double tickSeconds = static_cast<double>(kControlFrames) / sampleRate_;
+        for (std::size_t i = 0; i < lfoStep_.size(); ++i) {
+            lfoStep_[i] = static_cast<float>(std::max(0.0f, settings.lfos[i].rateHz) * tickSeconds);
+        }
+        const float attack = std::max(settings.envelope.attackSeconds, 1e-4f);
+        attackStep_ = static_cast<float>(tickSeconds / attack);
+        const float decay = std::max(settings.envelope.decaySeconds, 1e-4f);
+        decayCoeff_ = static_cast<float>(1.0 - std::exp(-tickSeconds / decay));
+        smoothing_ = static_cast<float>(1.0 - std::exp(-tickSeconds / kSmoothingSeconds));
+        sustain_ = std::clamp(settings.envelope.sustain, 0.0f, 1.0f);
+        routeCount_ = 0;
+        usesLfo_ = {};
+        for (std::size_t r = 0; r < std::min(settings.routeCount, settings.routes.size()); ++r) {
+            const ModRoute& route = settings.routes[r];
+            const auto source = static_cast<std::size_t>(route.source);
+            const auto target = static_cast<std::size_t>(route.target);
+            if (source >= kModSourceCount || target >= kModTargetCount || route.amount == 0.0f) {
+                continue;
+            }
+            routes_[routeCount_++] = {static_cast<std::uint8_t>(source),
+                                      static_cast<std::uint8_t>(target), route.amount};
+            if (source < usesLfo_.size()) {
+                usesLfo_[source] = true;
+            }
+        }
+    }
+
+    void setSampleRate(double sampleRate) { configure(settings_, sampleRate); }
+
+    bool active() const { return routeCount_ > 0; }
+
+    // Note-on: the offsets start where the sources are, unsmoothed.
+    void startVoice(VoiceState& state, float velocity, double frequency) const {
+        state = {};
+        state.velocity = std::clamp(velocity, 0.0f, 1.0f);
+        const double octaves = frequency > 0.0 ? dsp::FastLog2(frequency / 440.0) : 0.0;
+        state.keyTrack = static_cast<float>(std::clamp(octaves / 3.0, -1.0, 1.0));
+        state.offsets = targetOffsets(state);
+    }
+
+    // One control period.
+    void tick(VoiceState& state) const {
+        for (std::size_t i = 0; i < lfoStep_.size(); ++i) {
+            if (usesLfo_[i]) {
+                state.lfoPhase[i] += lfoStep_[i];
+                state.lfoPhase[i] -= std::floor(state.lfoPhase[i]);
+            }
+        }
+        if (state.attacking) {
+            state.envelope += attackStep_;
+            if (state.envelope >= 1.0f) {
+                state.envelope = 1.0f;
+                state.attacking = false;
+            }
+        } else {
+            state.envelope += decayCoeff_ * (sustain_ - state.envelope);
+        }
+        const auto raw = targetOffsets(state);
+        for (std::size_t t = 0; t < kModTargetCount; ++t) {
+            state.offsets[t] += smoothing_ * (raw[t] - state.offsets[t]);
+        }
+    }
+
+    static float Offset(const VoiceState& state, ModTarget target) {
+        return state.offsets[static_cast<std::size_t>(target)];
+    }
+
+private:
+    struct Route {
+        std::uint8_t source = 0;
+        std::uint8_t target = 0;
+        float amount = 0.0f;
+    };
+
+    float lfoValue(const VoiceState& state, std::size_t lfo) const {
+        const float phase = state.lfoPhase[lfo];
+        if (settings_.lfos[lfo].shape == LfoShape::Triangle) {
+            return 1.0f - 4.0f * std::abs(phase - 0.5f);
+        }
+        return static_cast<float>(std::sin(6.283185307179586 * phase));
+    }
+
+    std::array<float, kModTargetCount> targetOffsets(const VoiceState& state) const {
+        std::array<float, kModSourceCount> sources{};
+        sources[0] = usesLfo_[0] ? lfoValue(state, 0) : 0.0f;
+        sources[1] = usesLfo_[1] ? lfoValue(state, 1) : 0.0f;
+        sources[2] = state.envelope;
+        sources[3] = state.velocity;
+        sources[4] = state.keyTrack;
+        sources[5] = state.pressure;
+        sources[6] = state.timbre;
+        std::array<float, kModTargetCount> offsets{};
+        for (std::size_t r = 0; r < routeCount_; ++r) {
+            const Route& route = routes_[r];
+            offsets[route.target] += route.amount * sources[route.source];
+        }
+        return offsets;
+    }
+
+    ModulationSettings settings_{};
+    double sampleRate_ = 44100.0;
+    std::array<Route, kMaxModRoutes> routes_{};
+    std::size_t routeCount_ = 0;
+    std::array<bool, 2> usesLfo_{};
+    std::array<float, 2> lfoStep_{};
+    float attackStep_ = 0.0f;
+    float decayCoeff_ = 0.0f;
+    float smoothing_ = 0.0f;
+    float sustain_ = 0.0f;
+};
+
+}  // namespace engine
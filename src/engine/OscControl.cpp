@@ -0,0 +1,101 @@
+#include "engine/OscControl.h"
+
+#include <algorithm>
+#include <string_view>
+
+#include "engine/MidiNote.h"
+
+namespace engine {
+
+namespace {
+constexpr std::string_view kNoteOn = "/satori/note/on";
+constexpr std::string_view kNoteOff = "/satori/note/off";
+constexpr std::string_view kParam = "/satori/param";
+constexpr std::string_view kPanic = "/satori/panic";
+
+bool ReadNote(const audio::OscMessage& message, OscCommand& command, std::string& errorMessage) {
+    if (message.arguments.empty() || !message.arguments[0].isNumber()) {
+        errorMessage = "缺少音符编号: " + message.address;
+        return false;
+    }
+    command.note = message.arguments[0].asInt();
+    if (command.note < 0 || command.note > 127) {
+        errorMessage = "音符编号超出范围: " + message.address;
+        return false;
+    }
+    return true;
+}
+}  // namespace
+
+bool DecodeOscCommand(const audio::OscMessage& message, OscCommand& command,
+                      std::string& errorMessage) {
+    errorMessage.clear();
+    command = OscCommand{};
+    const std::string_view address = message.address;
+    const auto& args = message.arguments;
+
+    if (address == kNoteOn) {
+        if (!ReadNote(message, command, errorMessage)) {
+            return false;
+        }
+        command.kind = OscCommand::Kind::NoteOn;
+        if (args.size() > 1 && args[1].isNumber()) {
+            float velocity = args[1].asFloat();
+            if (velocity > 1.0f) {
+                velocity /= 127.0f;
+            }
+            command.velocity = std::clamp(velocity, 0.0f, 1.0f);
+        }
+        command.frequency = MidiNoteToFrequency(command.note);
+        if (args.size() > 2 && args[2].isNumber() && args[2].asFloat() > 0.0f) {
+            command.frequency = args[2].asFloat();
+        }
+        // Note on with velocity 0 is a note off, as in MIDI.
+        if (args.size() > 1 && command.velocity <= 0.0f) {
+            command.kind = OscCommand::Kind::NoteOff;
+        }
+        return true;
+    }
+    if (address == kNoteOff) {
+        command.kind = OscCommand::Kind::NoteOff;
+        return ReadNote(message, command, errorMessage);
+    }
+    if (address == kPanic) {
+        command.kind = OscCommand::Kind::Panic;
+        return true;
+    }
+    if (address.substr(0, kParam.size()) == kParam) {
+        command.kind = OscCommand::Kind::Param;
+        std::string_view name;
+        std::size_t valueIndex = 0;
+        if (address.size() == kParam.size()) {
+            if (args.empty() || (args[0].type != 's' && args[0].type != 'S')) {
+                errorMessage = "缺少参数名: " + message.address;
+                return false;
+            }
+            name = args[0].text;
+            valueIndex = 1;
+        } else if (address[kParam.size()] == '/') {
+            name = address.substr(kParam.size() + 1);
+        } else {
+            errorMessage = "未知的 OSC 地址: " + message.address;
+            return false;
+        }
+        const ParamInfo* info = FindParamByName(name);
+        if (!info) {
+            errorMessage = "未知参数: " + std::string(name);
+            return false;
+        }
+        if (args.size() <= valueIndex || !args[valueIndex].isNumber()) {
+            errorMessage = "缺少参数值: " + message.address;
+            return false;
+        }
+        command.param = info->id;
+        command.value = ClampToRange(*info, args[valueIndex].asFloat());
+        return true;
+    }
+    errorMessage = "未知的 OSC 地址: " + message.address;
+    return false;
+}
+
+}  // namespace engine
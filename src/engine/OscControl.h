@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include "audio/OscPacket.h"
+#include "engine/StringParams.h"
+
+namespace engine {
+
+// What an OSC control message asks the synth to do. The address space:
+//     /satori/note/on  note [velocity [frequency]]
+//     /satori/note/off note
+//     /satori/param    name value
+//     /satori/param/<name> value
+//     /satori/panic
+// Notes are MIDI numbers; the frequency defaults to equal temperament from
+// A4 = 440 Hz. A velocity above 1 is read as MIDI velocity (0..127).
+// Parameter names are those of GetParamInfoList(), in any case.
+struct OscCommand {
+    enum class Kind { NoteOn, NoteOff, Param, Panic };
+
+    Kind kind = Kind::NoteOn;
+    int note = 0;
+    float velocity = 1.0f;
+    double frequency = 440.0;
+    ParamId param = ParamId::Decay;
+    float value = 0.0f;
+};
+
+// False for an address outside the space above or arguments that do not
+// fit it; `errorMessage` then says why.
+bool DecodeOscCommand(const audio::OscMessage& message, OscCommand& command,
+                      std::string& errorMessage);
+
+}  // namespace engine
@@ -0,0 +1,122 @@
+#include "engine/OutputRecorder.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+#include "engine/Tracer.h"
+
+namespace engine {
+
+namespace {
+// How often the writer wakes to drain; the ring covers seconds, so this only
+// bounds how much sits in memory, not whether it fits.
+constexpr auto kDrainInterval = std::chrono::milliseconds(10);
+}  // namespace
+
+OutputRecorder::OutputRecorder(std::size_t capacitySamples)
+    : ring_(std::bit_ceil(std::max<std::size_t>(capacitySamples, 2)), 0.0f),
+      mask_(ring_.size() - 1) {}
+
+OutputRecorder::~OutputRecorder() {
+    std::string ignored;
+    stop(ignored);
+}
+
+bool OutputRecorder::start(const std::filesystem::path& path, const audio::WaveFormat& format,
+                           std::string& errorMessage) {
+    errorMessage.clear();
+    if (thread_.joinable()) {
+        errorMessage = "录音已在进行中";
+        return false;
+    }
+    if (format.channels == 0 || format.sampleRate == 0) {
+        errorMessage = "不支持的 WAV 格式";
+        return false;
+    }
+    if (!writer_.open(path, format, errorMessage)) {
+        return false;
+    }
+    writeError_.clear();
+    // Anything a late push left behind belongs to no recording.
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    channels_.store(format.channels, std::memory_order_relaxed);
+    sampleRate_.store(format.sampleRate, std::memory_order_relaxed);
+    framesWritten_.store(0, std::memory_order_relaxed);
+    overruns_.store(0, std::memory_order_relaxed);
+    stopWriter_.store(false, std::memory_order_relaxed);
+    thread_ = std::thread(&OutputRecorder::writerLoop, this);
+    recording_.store(true, std::memory_order_release);
+    return true;
+}
+
+bool OutputRecorder::stop(std::string& errorMessage) {
+    errorMessage.clear();
+    if (!thread_.joinable()) {
+        return true;
+    }
+    recording_.store(false, std::memory_order_release);
+    stopWriter_.store(true, std::memory_order_release);
+    thread_.join();
+    std::string closeError;
+    const bool closed = writer_.close(closeError);
+    errorMessage = !writeError_.empty() ? writeError_ : closeError;
+    return closed && writeError_.empty();
+}
+
+void OutputRecorder::push(const float* interleaved, std::size_t frames, std::size_t channels) {
+    if (!recording_.load(std::memory_order_acquire) || !interleaved || frames == 0) {
+        return;
+    }
+    const std::size_t count = frames * channels;
+    const std::uint64_t head = head_.load(std::memory_order_relaxed);
+    const std::uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (channels != channels_.load(std::memory_order_relaxed) ||
+        head - tail + count > ring_.size()) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const std::size_t start = static_cast<std::size_t>(head) & mask_;
+    const std::size_t first = std::min(count, ring_.size() - start);
+    std::memcpy(ring_.data() + start, interleaved, first * sizeof(float));
+    std::memcpy(ring_.data(), interleaved + first, (count - first) * sizeof(float));
+    head_.store(head + count, std::memory_order_release);
+}
+
+void OutputRecorder::writerLoop() {
+    SetTraceThreadName("recorder");
+    while (!stopWriter_.load(std::memory_order_acquire)) {
+        drain();
+        std::this_thread::sleep_for(kDrainInterval);
+    }
+    // push() has seen recording_ cleared by now, bar one block in flight.
+    drain();
+}
+
+void OutputRecorder::drain() {
+    const TraceZone zone("recorder drain");
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail < head) {
+        const std::size_t start = static_cast<std::size_t>(tail) & mask_;
+        const auto span = static_cast<std::size_t>(
+            std::min<std::uint64_t>(head - tail, ring_.size() - start));
+        // After a write error the ring keeps draining so the audio thread is
+        // not left overrunning; the error is reported by stop().
+        if (writeError_.empty()) {
+            std::string error;
+            if (!writer_.write(ring_.data() + start, span, error)) {
+                writeError_ = error;
+            }
+        }
+        tail += span;
+        tail_.store(tail, std::memory_order_release);
+    }
+    if (writeError_.empty()) {
+        const std::size_t channels = std::max<std::size_t>(1, channels_.load(std::memory_order_relaxed));
+        framesWritten_.store(writer_.samplesWritten() / channels, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace engine
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/WaveWriter.h"
+
+namespace engine {
+
+// Records the output to a WAV file while it plays. The audio thread copies
+// each block into a single-producer/single-consumer ring and returns; a
+// writer thread drains the ring through audio::WaveStreamWriter. A block
+// that does not fit because the disk fell behind is dropped whole and
+// counted, so a stall costs a gap in the file, never a glitch on the output.
+class OutputRecorder {
+public:
+    // Ring size in samples (rounded up to a power of two); the default holds
+    // about ten seconds of 48 kHz stereo.
+    static constexpr std::size_t kDefaultCapacity = std::size_t{1} << 20;
+
+    explicit OutputRecorder(std::size_t capacitySamples = kDefaultCapacity);
+    ~OutputRecorder();
+    OutputRecorder(const OutputRecorder&) = delete;
+    OutputRecorder& operator=(const OutputRecorder&) = delete;
+
+    // Control thread. start() opens the file and begins taking blocks of
+    // `format.channels` interleaved channels; stop() writes what is queued,
+    // finalises the file and reports the first write error, if any.
+    bool start(const std::filesystem::path& path, const audio::WaveFormat& format,
+               std::string& errorMessage);
+    bool stop(std::string& errorMessage);
+    bool isRecording() const { return recording_.load(std::memory_order_acquire); }
+
+    // Audio thread: queues one block, or counts it as an overrun if the
+    // ring is full or the layout does not match. Never allocates or waits.
+    void push(const float* interleaved, std::size_t frames, std::size_t channels);
+
+    // Any thread; reset by start().
+    std::uint64_t framesWritten() const { return framesWritten_.load(std::memory_order_relaxed); }
+    std::uint64_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+    std::uint32_t sampleRate() const { return sampleRate_.load(std::memory_order_relaxed); }
+
+private:
+    void writerLoop();
+    // Writer thread: hands everything queued to the file.
+    void drain();
+
+    std::vector<float> ring_;
+    std::size_t mask_ = 0;
+    std::atomic<std::uint64_t> head_{0};  // samples ever pushed
+    std::atomic<std::uint64_t> tail_{0};  // samples ever drained
+
+    std::atomic<bool> recording_{false};
+    std::atomic<bool> stopWriter_{false};
+    std::atomic<std::size_t> channels_{0};
+    std::atomic<std::uint32_t> sampleRate_{0};
+    std::atomic<std::uint64_t> framesWritten_{0};
+    std::atomic<std::uint64_t> overruns_{0};
+
+    audio::WaveStreamWriter writer_;  // writer thread while recording
+    std::string writeError_;
+    std::thread thread_;
+};
+
+}  // namespace engine
@@ -0,0 +1,286 @@
+#include "engine/Preset.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <sstream>
+
+#include "dsp/RoomIrLibrary.h"
+#include "engine/StringParams.h"
+#include "engine/StringSynthEngine.h"
+
+namespace engine {
+
+namespace {
+
+std::string ToLower(std::string_view value) {
+    std::string lower(value);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ToLowerAscii);
+    return lower;
+}
+
+// The raw value after `"key":`; strings come back unquoted, with escaped
+// quotes and backslashes undone. A flat scan, which is all the preset files
+// need.
+std::optional<std::string> ExtractValue(std::string_view text, std::string_view key) {
+    const std::string needle = "\"" + std::string(key) + "\"";
+    const auto keyPos = text.find(needle);
+    if (keyPos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const auto colonPos = text.find(':', keyPos + needle.size());
+    if (colonPos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    const auto valueStart = text.find_first_not_of(" \t\r\n", colonPos + 1);
+    if (valueStart == std::string_view::npos) {
+        return std::nullopt;
+    }
+    if (text[valueStart] == '"') {
+        std::string value;
+        for (std::size_t i = valueStart + 1; i < text.size(); ++i) {
+            if (text[i] == '"') {
+                return value;
+            }
+            if (text[i] == '\\' && i + 1 < text.size()) {
+                ++i;
+            }
+            value.push_back(text[i]);
+        }
+        return std::nullopt;
+    }
+    auto valueEnd = text.find_first_of(",}\r\n", valueStart);
+    if (valueEnd == std::string_view::npos) {
+        valueEnd = text.size();
+    }
+    return std::string(text.substr(valueStart, valueEnd - valueStart));
+}
+
+bool ParseFloat(const std::string& raw, float& value) {
+    char* end = nullptr;
+    value = std::strtof(raw.c_str(), &end);
+    return end != raw.c_str();
+}
+
+bool ParseUint(const std::string& raw, unsigned int& value) {
+    char* end = nullptr;
+    const unsigned long parsed = std::strtoul(raw.c_str(), &end, 10);
+    value = static_cast<unsigned int>(parsed);
+    return end != raw.c_str();
+}
+
+std::string Escape(std::string_view text) {
+    std::string escaped;
+    for (const char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            escaped.push_back('\\');
+        }
+        escaped.push_back(ch);
+    }
+    return escaped;
+}
+
+const char* BodyModelName(synthesis::BodyModel model) {
+    switch (model) {
+        case synthesis::BodyModel::Guitar:
+            return "guitar";
+        case synthesis::BodyModel::Koto:
+            return "koto";
+        case synthesis::BodyModel::Tilt:
+        default:
+            return "tilt";
+    }
+}
+
+}  // namespace
+
+bool ParsePresetJson(std::string_view content, Preset& preset, std::string& errorMessage) {
+    synthesis::StringConfig config = preset.config;
+    float masterGain = preset.masterGain;
+    double ampRelease = preset.ampRelease;
+    auto store = [&](ParamId id, float value) {
+        if (const auto* info = GetParamInfo(id)) {
+            StoreParamValue(id, ClampToRange(*info, value), config, masterGain, ampRelease);
+        }
+    };
+    auto fail = [&](std::string_view key) {
+        errorMessage = "预设字段解析失败: " + std::string(key);
+        return false;
+    };
+
+    constexpr std::pair<std::string_view, ParamId> kFloatFields[] = {
+        {"decay", ParamId::Decay},
+        {"brightness", ParamId::Brightness},
+        {"excitationBrightness", ParamId::ExcitationBrightness},
+        {"excitationVelocity", ParamId::ExcitationVelocity},
+        {"excitationMix", ParamId::ExcitationMix},
+        {"dispersionAmount", ParamId::DispersionAmount},
+        {"bodyTone", ParamId::BodyTone},
+        {"bodySize", ParamId::BodySize},
+        {"pickPosition", ParamId::PickPosition},
+        {"sympatheticAmount", ParamId::SympatheticAmount},
+        {"stereoSpread", ParamId::StereoSpread},
+        {"courseDetune", ParamId::CourseDetune},
+        {"masterGain", ParamId::MasterGain},
+        {"ampRelease", ParamId::AmpRelease},
+    };
+    for (const auto& [key, id] : kFloatFields) {
+        if (auto raw = ExtractValue(content, key)) {
+            float value = 0.0f;
+            if (!ParseFloat(*raw, value)) {
+                return fail(key);
+            }
+            store(id, value);
+        }
+    }
+
+    if (auto bodyMode = ExtractValue(content, "bodyMode")) {
+        store(ParamId::BodyMode, ToLower(*bodyMode) == "commuted" ? 1.0f : 0.0f);
+    }
+    if (auto bodyModel = ExtractValue(content, "bodyModel")) {
+        const auto lower = ToLower(*bodyModel);
+        store(ParamId::BodyModel, lower == "koto" ? 2.0f : (lower == "guitar" ? 1.0f : 0.0f));
+    }
+
+    // Room mix: prefer the current field; fall back to the legacy one.
+    auto mix = ExtractValue(content, "roomMix");
+    const std::string_view mixKey = mix ? "roomMix" : "roomAmount";
+    if (!mix) {
+        mix = ExtractValue(content, "roomAmount");
+    }
+    if (mix) {
+        float value = 0.0f;
+        if (!ParseFloat(*mix, value)) {
+            return fail(mixKey);
+        }
+        store(ParamId::RoomAmount, value);
+    }
+
+    // Room IR by stable id; an unknown id keeps the current room.
+    if (auto ir = ExtractValue(content, "roomIR")) {
+        const int index = dsp::RoomIrLibrary::findIndexById(*ir);
+        if (index >= 0) {
+            store(ParamId::RoomIR, static_cast<float>(index));
+        }
+    }
+    if (auto roomType = ExtractValue(content, "roomType")) {
+        store(ParamId::RoomType, ToLower(*roomType) == "algorithmic" ? 1.0f : 0.0f);
+    }
+
+    if (auto lowpass = ExtractValue(content, "enableLowpass")) {
+        const auto lower = ToLower(*lowpass);
+        if (lower.rfind("true", 0) == 0) {
+            store(ParamId::EnableLowpass, 1.0f);
+        } else if (lower.rfind("false", 0) == 0) {
+            store(ParamId::EnableLowpass, 0.0f);
+        } else {
+            return fail("enableLowpass");
+        }
+    }
+    if (auto noise = ExtractValue(content, "noiseType")) {
+        store(ParamId::NoiseType, ToLower(*noise) == "binary" ? 1.0f : 0.0f);
+    }
+
+    if (auto excitationMode = ExtractValue(content, "excitationMode")) {
+        const auto lower = ToLower(*excitationMode);
+        if (lower == "fixed") {
+            config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        } else if (lower == "random") {
+            config.excitationMode = synthesis::ExcitationMode::RandomNoisePick;
+        } else {
+            return fail("excitationMode");
+        }
+    }
+    if (auto excitationType = ExtractValue(content, "excitationType")) {
+        const auto lower = ToLower(*excitationType);
+        if (lower == "pluck") {
+            config.excitationType = synthesis::ExcitationType::Pluck;
+        } else if (lower == "hammer") {
+            config.excitationType = synthesis::ExcitationType::Hammer;
+        } else {
+            return fail("excitationType");
+        }
+    }
+    if (auto seed = ExtractValue(content, "seed")) {
+        if (!ParseUint(*seed, config.seed)) {
+            return fail("seed");
+        }
+    }
+
+    if (auto name = ExtractValue(content, "name")) {
+        preset.name = *name;
+    }
+    preset.config = config;
+    preset.masterGain = masterGain;
+    preset.ampRelease = static_cast<float>(ampRelease);
+    return true;
+}
+
+std::string SerializePresetJson(const Preset& preset) {
+    const auto& config = preset.config;
+    const auto& irList = dsp::RoomIrLibrary::list();
+    std::string roomIrId = "small-room";
+    if (!irList.empty()) {
+        const int idx = std::clamp(config.roomIrIndex, 0, static_cast<int>(irList.size() - 1));
+        roomIrId = std::string(irList[static_cast<std::size_t>(idx)].id);
+    }
+
+    std::ostringstream oss;
+    oss << "{\n";
+    if (!preset.name.empty()) {
+        oss << "  \"name\": \"" << Escape(preset.name) << "\",\n";
+    }
+    oss << "  \"decay\": " << config.decay << ",\n"
+        << "  \"brightness\": " << config.brightness << ",\n"
+        << "  \"excitationBrightness\": " << config.excitationBrightness << ",\n"
+        << "  \"excitationVelocity\": " << config.excitationVelocity << ",\n"
+        << "  \"excitationMix\": " << config.excitationMix << ",\n"
+        << "  \"dispersionAmount\": " << config.dispersionAmount << ",\n"
+        << "  \"bodyTone\": " << config.bodyTone << ",\n"
+        << "  \"bodySize\": " << config.bodySize << ",\n"
+        << "  \"bodyMode\": \""
+        << (config.bodyMode == synthesis::BodyMode::Commuted ? "commuted" : "postFilter")
+        << "\",\n"
+        << "  \"bodyModel\": \"" << BodyModelName(config.bodyModel) << "\",\n"
+        << "  \"sympatheticAmount\": " << config.sympatheticAmount << ",\n"
+        << "  \"stereoSpread\": " << config.stereoSpread << ",\n"
+        << "  \"courseDetune\": " << config.courseDetuneCents << ",\n"
+        << "  \"roomMix\": " << config.roomAmount << ",\n"
+        << "  \"roomIR\": \"" << roomIrId << "\",\n"
+        << "  \"roomType\": \""
+        << (config.roomType == synthesis::RoomType::Algorithmic ? "algorithmic" : "convolution")
+        << "\",\n"
+        // Legacy field for older presets/tools.
+        << "  \"roomAmount\": " << config.roomAmount << ",\n"
+        << "  \"pickPosition\": " << config.pickPosition << ",\n"
+        << "  \"enableLowpass\": " << (config.enableLowpass ? "true" : "false") << ",\n"
+        << "  \"noiseType\": \""
+        << (config.noiseType == synthesis::NoiseType::Binary ? "binary" : "white") << "\",\n"
+        << "  \"excitationType\": \""
+        << (config.excitationType == synthesis::ExcitationType::Hammer ? "hammer" : "pluck")
+        << "\",\n"
+        << "  \"excitationMode\": \""
+        << (config.excitationMode == synthesis::ExcitationMode::FixedNoisePick ? "fixed" : "random")
+        << "\",\n"
+        << "  \"seed\": " << config.seed << ",\n"
+        << "  \"masterGain\": " << preset.masterGain << ",\n"
+        << "  \"ampRelease\": " << preset.ampRelease << "\n"
+        << "}\n";
+    return oss.str();
+}
+
+bool LoadPresetJson(const std::filesystem::path& path, Preset& preset,
+                    std::string& errorMessage) {
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+        errorMessage = "无法打开预设文件: " + path.string();
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    preset.name = path.stem().string();
+    return ParsePresetJson(buffer.str(), preset, errorMessage);
+}
+
+}  // namespace engine
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "synthesis/KarplusStrongString.h"
+
+namespace engine {
+
+// One patch: the string configuration plus the part's gain and release.
+struct Preset {
+    std::string name;
+    synthesis::StringConfig config;
+    float masterGain = 1.0f;
+    float ampRelease = 0.35f;
+};
+
+// JSON preset text. Fields the text leaves out keep the values already in
+// `preset`; values are clamped to their parameter ranges. The room IR is
+// stored by its stable library id.
+bool ParsePresetJson(std::string_view content, Preset& preset, std::string& errorMessage);
+std::string SerializePresetJson(const Preset& preset);
+
+// Reads a JSON preset file; a preset without a "name" is named after the
+// file.
+bool LoadPresetJson(const std::filesystem::path& path, Preset& preset,
+                    std::string& errorMessage);
+
+}  // namespace engine
@@ -0,0 +1,260 @@
+#include "engine/PresetBank.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+#include "dsp/RoomIrLibrary.h"
+#include "engine/StringParams.h"
+#include "engine/StringSynthEngine.h"
+
+namespace engine {
+
+namespace {
+
+// The file is the in-memory layout; a big-endian port would byte-swap here.
+static_assert(std::endian::native == std::endian::little);
+
+constexpr char kMagic[8] = {'S', 'A', 'T', 'B', 'A', 'N', 'K', '\0'};
+constexpr std::size_t kIrIdSize = 32;
+constexpr std::size_t kValueSlots = 32;
+static_assert(kParamCount <= kValueSlots, "preset bank records need more value slots");
+
+struct BankHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t recordCount;
+    std::uint32_t paramCount;
+    std::uint32_t nameIndexOffset;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(BankHeader) == 32);
+
+struct BankRecord {
+    char name[kPresetBankNameSize];
+    char roomIrId[kIrIdSize];
+    float values[kValueSlots];
+    std::uint32_t seed;
+    std::uint8_t excitationType;
+    std::uint8_t excitationMode;
+    std::uint8_t reserved[26];
+};
+static_assert(sizeof(BankRecord) == 256);
+
+int CompareIgnoreCase(std::string_view a, std::string_view b) {
+    const std::size_t common = std::min(a.size(), b.size());
+    for (std::size_t i = 0; i < common; ++i) {
+        const auto ca = static_cast<unsigned char>(ToLowerAscii(a[i]));
+        const auto cb = static_cast<unsigned char>(ToLowerAscii(b[i]));
+        if (ca != cb) {
+            return ca < cb ? -1 : 1;
+        }
+    }
+    return a.size() == b.size() ? 0 : (a.size() < b.size() ? -1 : 1);
+}
+
+// Copies `text` into a NUL-padded field, cutting before a UTF-8
+// continuation byte rather than through a character.
+void CopyField(std::string_view text, char* field, std::size_t fieldSize) {
+    std::size_t length = std::min(text.size(), fieldSize - 1);
+    if (length < text.size()) {
+        while (length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+            --length;
+        }
+    }
+    std::memset(field, 0, fieldSize);
+    std::memcpy(field, text.data(), length);
+}
+
+std::string_view FieldView(const char* field, std::size_t fieldSize) {
+    const auto* end = static_cast<const char*>(std::memchr(field, '\0', fieldSize));
+    return {field, end ? static_cast<std::size_t>(end - field) : fieldSize};
+}
+
+BankRecord EncodeRecord(const Preset& preset) {
+    BankRecord record{};
+    CopyField(preset.name, record.name, sizeof(record.name));
+    const auto& irList = dsp::RoomIrLibrary::list();
+    const int irIndex = preset.config.roomIrIndex;
+    if (irIndex >= 0 && static_cast<std::size_t>(irIndex) < irList.size()) {
+        CopyField(irList[static_cast<std::size_t>(irIndex)].id, record.roomIrId,
+                  sizeof(record.roomIrId));
+    }
+    for (const auto& info : GetParamInfoList()) {
+        record.values[static_cast<std::size_t>(info.id)] =
+            LoadParamValue(info.id, preset.config, preset.masterGain, preset.ampRelease);
+    }
+    record.seed = preset.config.seed;
+    record.excitationType = static_cast<std::uint8_t>(preset.config.excitationType);
+    record.excitationMode = static_cast<std::uint8_t>(preset.config.excitationMode);
+    return record;
+}
+
+}  // namespace
+
+bool WritePresetBank(const std::filesystem::path& path, std::span<const Preset> presets,
+                     std::string& errorMessage) {
+    std::vector<BankRecord> records;
+    records.reserve(presets.size());
+    for (const auto& preset : presets) {
+        records.push_back(EncodeRecord(preset));
+    }
+    std::vector<std::uint32_t> order(records.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return CompareIgnoreCase(FieldView(records[a].name, kPresetBankNameSize),
+                                 FieldView(records[b].name, kPresetBankNameSize)) < 0;
+    });
+
+    BankHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kPresetBankVersion;
+    header.recordSize = sizeof(BankRecord);
+    header.recordCount = static_cast<std::uint32_t>(records.size());
+    header.paramCount = static_cast<std::uint32_t>(kParamCount);
+    header.nameIndexOffset =
+        static_cast<std::uint32_t>(sizeof(BankHeader) + records.size() * sizeof(BankRecord));
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        errorMessage = "无法写入预设库: " + path.string();
+        return false;
+    }
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(BankRecord)));
+    stream.write(reinterpret_cast<const char*>(order.data()),
+                 static_cast<std::streamsize>(order.size() * sizeof(std::uint32_t)));
+    if (!stream.good()) {
+        errorMessage = "写入预设库失败: " + path.string();
+        return false;
+    }
+    return true;
+}
+
+bool PresetBank::open(const std::filesystem::path& path, std::string& errorMessage) {
+    close();
+    MappedFile file;
+    if (!file.open(path, errorMessage)) {
+        return false;
+    }
+    const auto bytes = file.bytes();
+    BankHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        errorMessage = "预设库文件过短";
+        return false;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        errorMessage = "不是预设库文件";
+        return false;
+    }
+    if (header.version != kPresetBankVersion) {
+        errorMessage = "不支持的预设库版本: " + std::to_string(header.version);
+        return false;
+    }
+    const std::uint64_t recordsEnd =
+        sizeof(header) + std::uint64_t{header.recordSize} * header.recordCount;
+    const std::uint64_t indexEnd =
+        std::uint64_t{header.nameIndexOffset} + std::uint64_t{4} * header.recordCount;
+    if (header.recordSize < sizeof(BankRecord) || header.paramCount > kValueSlots ||
+        header.nameIndexOffset < recordsEnd || header.nameIndexOffset % 4 != 0 ||
+        indexEnd > bytes.size()) {
+        errorMessage = "预设库文件已损坏";
+        return false;
+    }
+    file_ = std::move(file);
+    count_ = header.recordCount;
+    recordSize_ = header.recordSize;
+    paramCount_ = header.paramCount;
+    indexOffset_ = header.nameIndexOffset;
+    return true;
+}
+
+void PresetBank::close() {
+    file_.close();
+    count_ = 0;
+    recordSize_ = 0;
+    paramCount_ = 0;
+    indexOffset_ = 0;
+}
+
+const std::uint8_t* PresetBank::record(std::size_t index) const {
+    return file_.bytes().data() + sizeof(BankHeader) + index * recordSize_;
+}
+
+std::string_view PresetBank::name(std::size_t index) const {
+    if (index >= count_) {
+        return {};
+    }
+    return FieldView(reinterpret_cast<const char*>(record(index)), kPresetBankNameSize);
+}
+
+std::size_t PresetBank::sortedIndex(std::size_t rank) const {
+    if (rank >= count_) {
+        return count_;
+    }
+    std::uint32_t index = 0;
+    std::memcpy(&index, file_.bytes().data() + indexOffset_ + rank * 4, sizeof(index));
+    // A damaged index points past the records; clamp rather than read out.
+    return std::min<std::size_t>(index, count_ - 1);
+}
+
+int PresetBank::find(std::string_view wanted) const {
+    std::size_t low = 0;
+    std::size_t high = count_;
+    while (low < high) {
+        const std::size_t mid = low + (high - low) / 2;
+        if (CompareIgnoreCase(name(sortedIndex(mid)), wanted) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low < count_ && CompareIgnoreCase(name(sortedIndex(low)), wanted) == 0) {
+        return static_cast<int>(sortedIndex(low));
+    }
+    return -1;
+}
+
+bool PresetBank::load(std::size_t index, Preset& preset) const {
+    if (index >= count_) {
+        return false;
+    }
+    BankRecord stored{};
+    std::memcpy(&stored, record(index), sizeof(stored));
+
+    Preset decoded;
+    decoded.name = std::string(FieldView(stored.name, sizeof(stored.name)));
+    double ampRelease = decoded.ampRelease;
+    for (std::size_t i = 0; i < std::min(paramCount_, kParamCount); ++i) {
+        const auto& info = GetParamInfoList()[i];
+        const float value = stored.values[i];
+        if (std::isfinite(value)) {
+            StoreParamValue(info.id, ClampToRange(info, value), decoded.config,
+                            decoded.masterGain, ampRelease);
+        }
+    }
+    decoded.ampRelease = static_cast<float>(ampRelease);
+    const int irIndex =
+        dsp::RoomIrLibrary::findIndexById(FieldView(stored.roomIrId, sizeof(stored.roomIrId)));
+    if (irIndex >= 0) {
+        decoded.config.roomIrIndex = irIndex;
+    }
+    decoded.config.seed = stored.seed;
+    decoded.config.excitationType = stored.excitationType == 1
+                                        ? synthesis::ExcitationType::Hammer
+                                        : synthesis::ExcitationType::Pluck;
+    decoded.config.excitationMode = stored.excitationMode == 1
+                                        ? synthesis::ExcitationMode::FixedNoisePick
+                                        : synthesis::ExcitationMode::RandomNoisePick;
+    preset = std::move(decoded);
+    return true;
+}
+
+}  // namespace engine
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "engine/MappedFile.h"
+#include "engine/Preset.h"
+
+namespace engine {
+
+// Binary preset bank (.satbank), little-endian:
+//   header   32 bytes: "SATBANK\0", version, recordSize, recordCount,
+//            paramCount, nameIndexOffset, reserved
+//   records  recordCount x recordSize: name (64, NUL padded), room IR id
+//            (32), parameter values in ParamId order (32 floats), seed,
+//            excitation type and mode
+//   index    recordCount x u32 record numbers, sorted by name ignoring
+//            ASCII case
+// Records are fixed size, so a bank is browsed straight from the mapping:
+// opening checks the header and nothing is parsed until a preset is loaded.
+inline constexpr std::uint32_t kPresetBankVersion = 1;
+inline constexpr std::size_t kPresetBankNameSize = 64;  // bytes, NUL included
+
+// Names longer than the record allows are cut at a UTF-8 boundary.
+bool WritePresetBank(const std::filesystem::path& path, std::span<const Preset> presets,
+                     std::string& errorMessage);
+
+class PresetBank {
+public:
+    bool open(const std::filesystem::path& path, std::string& errorMessage);
+    void close();
+    bool isOpen() const { return file_.isOpen(); }
+
+    std::size_t size() const { return count_; }
+    // Views into the mapping; valid until close().
+    std::string_view name(std::size_t index) const;
+    // Record number of the `rank`-th preset in name order.
+    std::size_t sortedIndex(std::size_t rank) const;
+    // First preset with this name, ignoring ASCII case; -1 when none.
+    int find(std::string_view name) const;
+
+    // Decodes one record over default settings. A room IR the library no
+    // longer has falls back to the stored slot.
+    bool load(std::size_t index, Preset& preset) const;
+
+private:
+    const std::uint8_t* record(std::size_t index) const;
+
+    MappedFile file_;
+    std::size_t count_ = 0;
+    std::size_t recordSize_ = 0;
+    std::size_t paramCount_ = 0;
+    std::size_t indexOffset_ = 0;
+};
+
+}  // namespace engine
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+
+namespace engine {
+
+// Steps render quality down while the audio callback runs short of its
+// buffer period and back up once headroom returns, so CPU pressure costs
+// detail instead of dropouts. Level 0 is full quality and each level up is
+// cheaper; what a level means is up to the caller. A step down needs either
+// the smoothed load over kHighLoad or two overruns within kSettleSeconds,
+// and at most one step is taken per kSettleSeconds so each can take effect.
+// A step back up needs kRecoverSeconds under kLowLoad without an overrun.
+class QualityGovernor {
+public:
+    static constexpr int kMaxLevel = 3;
+    static constexpr double kHighLoad = 0.8;   // share of the period
+    static constexpr double kLowLoad = 0.45;
+    static constexpr double kSmoothing = 0.05;  // per callback
+    static constexpr double kSettleSeconds = 0.5;
+    static constexpr double kRecoverSeconds = 4.0;
+
+    // Audio thread, once per callback; returns the level for the next one.
+    int record(double elapsedUs, double periodUs) {
+        int level = level_.load(std::memory_order_relaxed);
+        if (periodUs <= 0.0) {
+            return level;
+        }
+        const double load = elapsedUs / periodUs;
+        load_ = primed_ ? load_ + kSmoothing * (load - load_) : load;
+        primed_ = true;
+        sinceChangeUs_ += periodUs;
+        sinceOverrunUs_ += periodUs;
+
+        bool pressure = load_ >= kHighLoad;
+        if (load >= 1.0) {
+            pressure = pressure || sinceOverrunUs_ <= kSettleSeconds * 1e6;
+            sinceOverrunUs_ = 0.0;
+            calmUs_ = 0.0;
+        } else if (load_ < kLowLoad) {
+            calmUs_ += periodUs;
+        } else {
+            calmUs_ = 0.0;
+        }
+
+        if (pressure && level < kMaxLevel && sinceChangeUs_ >= kSettleSeconds * 1e6) {
+            ++level;
+        } else if (calmUs_ >= kRecoverSeconds * 1e6 && level > 0) {
+            --level;
+            calmUs_ = 0.0;
+        } else {
+            return level;
+        }
+        sinceChangeUs_ = 0.0;
+        level_.store(level, std::memory_order_relaxed);
+        return level;
+    }
+
+    // Any thread.
+    int level() const { return level_.load(std::memory_order_relaxed); }
+
+    // Audio thread (or while it is stopped): back to full quality.
+    void reset() {
+        load_ = 0.0;
+        primed_ = false;
+        sinceChangeUs_ = kSettleSeconds * 1e6;
+        sinceOverrunUs_ = kSettleSeconds * 1e6 + 1.0;
+        calmUs_ = 0.0;
+        level_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    double load_ = 0.0;  // smoothed elapsed / period
+    bool primed_ = false;
+    double sinceChangeUs_ = kSettleSeconds * 1e6;
+    double sinceOverrunUs_ = kSettleSeconds * 1e6 + 1.0;
+    double calmUs_ = 0.0;  // under kLowLoad without an overrun
+    std::atomic<int> level_{0};
+};
+
+}  // namespace engine
@@ -0,0 +1,70 @@
+#include "engine/RealtimeCheck.h"
+
+#include <atomic>
+
+namespace engine {
+
+namespace {
+
+thread_local int tScopeDepth = 0;
+thread_local int tAllowanceDepth = 0;
+
+std::array<std::atomic<std::uint64_t>, kRealtimeViolationCount> gCounts{};
+std::atomic<const char*> gLastCall{nullptr};
+std::atomic<bool> gHooksInstalled{false};
+
+}  // namespace
+
+const char* RealtimeViolationName(RealtimeViolation kind) {
+    switch (kind) {
+    case RealtimeViolation::Allocation:
+        return "allocation";
+    case RealtimeViolation::MutexWait:
+        return "mutex wait";
+    case RealtimeViolation::BlockingCall:
+        return "blocking call";
+    case RealtimeViolation::Count:
+        break;
+    }
+    return "unknown";
+}
+
+RealtimeScope::RealtimeScope() { ++tScopeDepth; }
+
+RealtimeScope::~RealtimeScope() { --tScopeDepth; }
+
+RealtimeAllowance::RealtimeAllowance() { ++tAllowanceDepth; }
+
+RealtimeAllowance::~RealtimeAllowance() { --tAllowanceDepth; }
+
+bool InRealtimeScope() { return tScopeDepth > 0 && tAllowanceDepth == 0; }
+
+void ReportRealtimeViolation(RealtimeViolation kind, const char* call) {
+    if (!InRealtimeScope() || kind == RealtimeViolation::Count) {
+        return;
+    }
+    gCounts[static_cast<std::size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+    gLastCall.store(call, std::memory_order_relaxed);
+}
+
+RealtimeViolations RealtimeViolationSnapshot() {
+    RealtimeViolations snapshot;
+    for (std::size_t i = 0; i < kRealtimeViolationCount; ++i) {
+        snapshot.counts[i] = gCounts[i].load(std::memory_order_relaxed);
+    }
+    snapshot.lastCall = gLastCall.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void ResetRealtimeViolations() {
+    for (auto& count : gCounts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    gLastCall.store(nullptr, std::memory_order_relaxed);
+}
+
+void SetRealtimeHooksInstalled() { gHooksInstalled.store(true, std::memory_order_relaxed); }
+
+bool RealtimeHooksInstalled() { return gHooksInstalled.load(std::memory_order_relaxed); }
+
+}  // namespace engine
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+// Realtime-safety checking for the audio callback. Code that must not
+// allocate, lock or block opens a RealtimeScope for its duration (process()
+// and the device callback do). The scope itself only bumps a thread-local
+// depth; the checks come from hooks that replace the global allocator and,
+// on glibc, the blocking pthread and sleep entry points, and report whatever
+// they see inside a scope. The hooks are linked into the unit tests
+// (tests/realtime_hooks.cpp), so a regression shows up as a test failure
+// rather than as a dropout.
+enum class RealtimeViolation : std::uint8_t {
+    Allocation,    // operator new / delete
+    MutexWait,     // pthread_mutex_lock (try_lock is fine)
+    BlockingCall,  // condition waits, sleeps, semaphores, joins
+    Count
+};
+
+inline constexpr std::size_t kRealtimeViolationCount =
+    static_cast<std::size_t>(RealtimeViolation::Count);
+
+const char* RealtimeViolationName(RealtimeViolation kind);
+
+struct RealtimeViolations {
+    std::array<std::uint64_t, kRealtimeViolationCount> counts{};
+    const char* lastCall = nullptr;  // static string naming the last offender
+
+    std::uint64_t total() const {
+        std::uint64_t sum = 0;
+        for (std::uint64_t count : counts) {
+            sum += count;
+        }
+        return sum;
+    }
+};
+
+// Marks the calling thread as realtime until destroyed; scopes nest.
+class RealtimeScope {
+public:
+    RealtimeScope();
+    ~RealtimeScope();
+    RealtimeScope(const RealtimeScope&) = delete;
+    RealtimeScope& operator=(const RealtimeScope&) = delete;
+};
+
+// Lifts the check inside a scope for work that is allowed to block there.
+class RealtimeAllowance {
+public:
+    RealtimeAllowance();
+    ~RealtimeAllowance();
+    RealtimeAllowance(const RealtimeAllowance&) = delete;
+    RealtimeAllowance& operator=(const RealtimeAllowance&) = delete;
+};
+
+// True inside a RealtimeScope and outside any RealtimeAllowance.
+bool InRealtimeScope();
+
+// For the hooks: counts `kind` if the calling thread is in a realtime scope.
+// Never allocates or locks, so it is safe from inside operator new.
+void ReportRealtimeViolation(RealtimeViolation kind, const char* call);
+
+// Process-wide totals since the last reset; any thread.
+RealtimeViolations RealtimeViolationSnapshot();
+void ResetRealtimeViolations();
+
+// The hooks announce themselves at static initialisation; without them nothing
+// is ever reported.
+void SetRealtimeHooksInstalled();
+bool RealtimeHooksInstalled();
+
+}  // namespace engine
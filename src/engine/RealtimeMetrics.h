@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "engine/MemoryUsage.h"
+#include "engine/StageProfiler.h"
+#include "engine/StringSynthEngine.h"
+
+namespace engine {
+
+// End-to-end output latency by source, in device frames: how long after
+// the host time a timestamped note is given (noteOnAt) it leaves the
+// device. The room's tail delay is not part of it; the convolution head
+// covers those blocks, so dry and early wet go out on time.
+struct OutputLatency {
+    std::uint32_t sampleRate = 0;  // device rate
+    // Timestamped events land at their offset into the next callback.
+    std::size_t scheduleFrames = 0;
+    // What the backend queues ahead of the output, as it reports it.
+    std::size_t deviceFrames = 0;
+    // Synth-to-device rate conversion (Windows only), averaged.
+    std::size_t resamplerFrames = 0;
+
+    std::size_t totalFrames() const { return scheduleFrames + deviceFrames + resamplerFrames; }
+    double totalMs() const {
+        return sampleRate > 0 ? static_cast<double>(totalFrames()) * 1000.0 / sampleRate : 0.0;
+    }
+};
+
+// What a platform realtime engine (winaudio, posixaudio) reports about its
+// device callbacks and the synth behind them. Filled on the UI thread by
+// metrics(); nothing here is read by the audio thread.
+struct RealtimeMetrics {
+    std::uint64_t callbackCount = 0;
+    double callbackMsAvg = 0.0;
+    double callbackMsMax = 0.0;
+    double callbackPeriodMs = 0.0;  // buffer length of the last callback
+    // callbackMsAvg / callbackPeriodMs: 1 means the callback uses its whole
+    // buffer period.
+    double dspLoad = 0.0;
+    std::uint64_t deviceXruns = 0;  // callbacks the backend flagged as discontinuous
+    // Streams rebuilt after the device stalled or was invalidated; the
+    // synth and its reverb carry on across each one.
+    std::uint64_t streamRecoveries = 0;
+    // Since the last resetMetricsWindow(), from the callback histogram
+    // (10 us buckets, rounded up).
+    std::uint64_t windowCallbacks = 0;
+    std::uint64_t windowOverruns = 0;  // callbacks longer than their buffer
+    double windowMsP50 = 0.0;
+    double windowMsP95 = 0.0;
+    double windowMsP99 = 0.0;
+    double windowMsP999 = 0.0;
+    double windowMsMax = 0.0;
+    // Cumulative per-stage ticks (engine/StageProfiler.h); all zero
+    // unless built with SATORI_ENABLE_PROFILING.
+    bool stageProfiling = SATORI_PROFILING_ENABLED != 0;
+    engine::StageProfile stages;
+    std::uint32_t pendingParamMask = 0;
+    std::size_t roomDelayFrames = 0;
+    std::uint64_t roomLateBlocks = 0;
+    engine::RoomTelemetry room;
+    // Quality the governor has shed to under callback pressure: 0 is full,
+    // higher levels shorten the room tail and then cut the voice count.
+    int qualityLevel = 0;
+    std::size_t voiceLimit = 0;
+    std::size_t activeVoices = 0;
+    double roomLatencyMs = 0.0;  // roomDelayFrames at the synth rate
+    OutputLatency latency;
+    bool recording = false;
+    double recordedSeconds = 0.0;
+    std::uint64_t recordOverruns = 0;  // blocks dropped because the disk fell behind
+    // Process-wide, not just this engine's synth (engine/MemoryUsage.h).
+    engine::MemoryUsage memory;
+};
+
+}  // namespace engine
@@ -0,0 +1,352 @@
+#include "engine/RealtimeThread.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "engine/Tracer.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <avrt.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__linux__)
+#include <charconv>
+#include <fstream>
+#include <string>
+#endif
+
+namespace engine {
+
+namespace {
+
+std::mutex& SettingsMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+RealtimeThreadSettings& SettingsStorage() {
+    static RealtimeThreadSettings settings;
+    return settings;
+}
+
+#if defined(_WIN32)
+AVRT_PRIORITY ToAvrtPriority(RealtimePriority priority) {
+    switch (priority) {
+        case RealtimePriority::Low:
+            return AVRT_PRIORITY_LOW;
+        case RealtimePriority::Normal:
+            return AVRT_PRIORITY_NORMAL;
+        case RealtimePriority::High:
+            return AVRT_PRIORITY_HIGH;
+        case RealtimePriority::Critical:
+            return AVRT_PRIORITY_CRITICAL;
+    }
+    return AVRT_PRIORITY_NORMAL;
+}
+#else
+// Kept under JACK's defaults (its process threads sit around 70-90 on most
+// distributions) so a Satori thread never preempts the server.
+int ToFifoPriority(RealtimePriority priority) {
+    switch (priority) {
+        case RealtimePriority::Low:
+            return 40;
+        case RealtimePriority::Normal:
+            return 50;
+        case RealtimePriority::High:
+            return 55;
+        case RealtimePriority::Critical:
+            return 60;
+    }
+    return 50;
+}
+#endif
+
+// The two kinds of core in the platform's terms: CPU Set ids on Windows, CPU
+// numbers on Linux. On CPUs with one kind every core counts as performance.
+// performanceIndices are the performance cores' logical processor numbers
+// below 64, as affinity masks and PreferredCore count them.
+struct CoreSets {
+    std::vector<unsigned long> performance;
+    std::vector<unsigned long> efficiency;
+    std::vector<int> performanceIndices;
+};
+
+#if defined(_WIN32)
+CoreSets DetectCoreSets() {
+    CoreSets sets;
+    ULONG length = 0;
+    GetSystemCpuSetInformation(nullptr, 0, &length, GetCurrentProcess(), 0);
+    std::vector<std::uint8_t> buffer(length);
+    if (length == 0 ||
+        !GetSystemCpuSetInformation(reinterpret_cast<PSYSTEM_CPU_SET_INFORMATION>(buffer.data()),
+                                    length, &length, GetCurrentProcess(), 0)) {
+        return sets;
+    }
+    std::vector<const SYSTEM_CPU_SET_INFORMATION*> cpus;
+    BYTE lowest = 0xFF;
+    BYTE highest = 0;
+    for (ULONG offset = 0; offset < length;) {
+        const auto* info =
+            reinterpret_cast<const SYSTEM_CPU_SET_INFORMATION*>(buffer.data() + offset);
+        if (info->Size == 0) {
+            break;
+        }
+        if (info->Type == CpuSetInformation) {
+            cpus.push_back(info);
+            lowest = std::min(lowest, info->CpuSet.EfficiencyClass);
+            highest = std::max(highest, info->CpuSet.EfficiencyClass);
+        }
+        offset += info->Size;
+    }
+    // A higher efficiency class is a faster core. Classes in between (a
+    // third tier) are left to the scheduler either way.
+    for (const SYSTEM_CPU_SET_INFORMATION* info : cpus) {
+        const auto& cpu = info->CpuSet;
+        if (cpu.EfficiencyClass == highest) {
+            sets.performance.push_back(cpu.Id);
+            if (cpu.Group == 0 && cpu.LogicalProcessorIndex < 64) {
+                sets.performanceIndices.push_back(cpu.LogicalProcessorIndex);
+            }
+        } else if (cpu.EfficiencyClass == lowest) {
+            sets.efficiency.push_back(cpu.Id);
+        }
+    }
+    return sets;
+}
+#elif defined(__linux__)
+// A sysfs CPU list such as "0-15,20"; empty when the file is missing.
+std::vector<unsigned long> ReadCpuList(const char* path) {
+    std::vector<unsigned long> cpus;
+    std::ifstream file(path);
+    std::string list;
+    if (!std::getline(file, list)) {
+        return cpus;
+    }
+    const char* at = list.data();
+    const char* end = list.data() + list.size();
+    while (at < end) {
+        unsigned long first = 0;
+        auto parsed = std::from_chars(at, end, first);
+        if (parsed.ec != std::errc()) {
+            return {};
+        }
+        unsigned long last = first;
+        if (parsed.ptr < end && *parsed.ptr == '-') {
+            parsed = std::from_chars(parsed.ptr + 1, end, last);
+            if (parsed.ec != std::errc()) {
+                return {};
+            }
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        at = parsed.ptr < end && *parsed.ptr == ',' ? parsed.ptr + 1 : end;
+    }
+    return cpus;
+}
+
+CoreSets DetectCoreSets() {
+    CoreSets sets;
+    // Intel hybrid parts register one perf PMU per core type.
+    sets.performance = ReadCpuList("/sys/devices/cpu_core/cpus");
+    sets.efficiency = ReadCpuList("/sys/devices/cpu_atom/cpus");
+    if (sets.performance.empty() || sets.efficiency.empty()) {
+        sets.performance.clear();
+        sets.efficiency.clear();
+        const unsigned cores = std::thread::hardware_concurrency();
+        for (unsigned cpu = 0; cpu < cores; ++cpu) {
+            sets.performance.push_back(cpu);
+        }
+    }
+    for (unsigned long cpu : sets.performance) {
+        if (cpu < 64) {
+            sets.performanceIndices.push_back(static_cast<int>(cpu));
+        }
+    }
+    return sets;
+}
+#else
+CoreSets DetectCoreSets() {
+    CoreSets sets;
+    const unsigned cores = std::thread::hardware_concurrency();
+    for (unsigned cpu = 0; cpu < cores; ++cpu) {
+        sets.performance.push_back(cpu);
+    }
+    return sets;
+}
+#endif
+
+const CoreSets& Cores() {
+    static const CoreSets sets = [] {
+        CoreSets detected = DetectCoreSets();
+        std::sort(detected.performanceIndices.begin(), detected.performanceIndices.end());
+        return detected;
+    }();
+    return sets;
+}
+
+}  // namespace
+
+void SetRealtimeThreadSettings(const RealtimeThreadSettings& settings) {
+    std::lock_guard<std::mutex> lock(SettingsMutex());
+    SettingsStorage() = settings;
+}
+
+RealtimeThreadSettings GetRealtimeThreadSettings() {
+    std::lock_guard<std::mutex> lock(SettingsMutex());
+    return SettingsStorage();
+}
+
+CpuTopology GetCpuTopology() {
+    const CoreSets& sets = Cores();
+    CpuTopology topology;
+    topology.performanceCores = static_cast<int>(sets.performance.size());
+    topology.efficiencyCores = static_cast<int>(sets.efficiency.size());
+    return topology;
+}
+
+bool SetThreadCoreClass(CoreClass cores) {
+    const CoreSets& sets = Cores();
+    if (sets.efficiency.empty()) {
+        return false;
+    }
+    // Any stays allowed with placement off, so a thread can always be undone.
+    if (cores != CoreClass::Any && !GetRealtimeThreadSettings().hybridPlacement) {
+        return false;
+    }
+#if defined(_WIN32)
+    if (cores == CoreClass::Any) {
+        return SetThreadSelectedCpuSets(GetCurrentThread(), nullptr, 0) != FALSE;
+    }
+    const std::vector<unsigned long>& ids =
+        cores == CoreClass::Performance ? sets.performance : sets.efficiency;
+    return SetThreadSelectedCpuSets(GetCurrentThread(), ids.data(),
+                                    static_cast<ULONG>(ids.size())) != FALSE;
+#elif defined(__linux__)
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (cores != CoreClass::Efficiency) {
+        for (unsigned long cpu : sets.performance) {
+            CPU_SET(cpu, &mask);
+        }
+    }
+    if (cores != CoreClass::Performance) {
+        for (unsigned long cpu : sets.efficiency) {
+            CPU_SET(cpu, &mask);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+    return false;
+#endif
+}
+
+int PreferredCore(RealtimeThreadRole role) {
+    // Counted among performance cores: on hybrid CPUs the last cores are
+    // often efficiency cores.
+    const CoreSets& sets = Cores();
+    if (!sets.efficiency.empty() && sets.performanceIndices.size() >= 2 &&
+        GetRealtimeThreadSettings().hybridPlacement) {
+        const std::size_t last = sets.performanceIndices.size() - 1;
+        return sets.performanceIndices[role == RealtimeThreadRole::Render ? last : last - 1];
+    }
+    const unsigned cores = std::thread::hardware_concurrency();
+    if (cores < 2) {
+        return -1;
+    }
+    // Affinity masks below cover the first 64 cores only.
+    const int last = static_cast<int>(cores < 64 ? cores : 64) - 1;
+    return role == RealtimeThreadRole::Render ? last : last - 1;
+}
+
+ScopedRealtimeThread::ScopedRealtimeThread(RealtimeThreadRole role) {
+#if defined(_WIN32)
+    const RealtimeThreadSettings settings = GetRealtimeThreadSettings();
+    if (settings.useMmcss) {
+        DWORD taskIndex = 0;
+        HANDLE handle = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIndex);
+        if (handle) {
+            const RealtimePriority priority = role == RealtimeThreadRole::Render
+                                                  ? settings.renderPriority
+                                                  : settings.roomWorkerPriority;
+            AvSetMmThreadPriority(handle, ToAvrtPriority(priority));
+            mmcssHandle_ = handle;
+        }
+    }
+    const int core = PreferredCore(role);
+    if (core >= 0) {
+        if (role == RealtimeThreadRole::Render) {
+            SetThreadIdealProcessor(GetCurrentThread(), static_cast<DWORD>(core));
+        } else if (settings.pinRoomWorker) {
+            oldAffinity_ = SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << core);
+        }
+    }
+    placed_ = SetThreadCoreClass(CoreClass::Performance);
+#else
+    const RealtimeThreadSettings settings = GetRealtimeThreadSettings();
+    if (settings.useMmcss) {
+        int policy = 0;
+        sched_param old{};
+        if (pthread_getschedparam(pthread_self(), &policy, &old) == 0 && policy != SCHED_FIFO) {
+            sched_param param{};
+            param.sched_priority = ToFifoPriority(role == RealtimeThreadRole::Render
+                                                      ? settings.renderPriority
+                                                      : settings.roomWorkerPriority);
+            if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0) {
+                oldPolicy_ = policy;
+                oldPriority_ = old.sched_priority;
+            }
+        }
+    }
+    placed_ = SetThreadCoreClass(CoreClass::Performance);
+#endif
+}
+
+ScopedRealtimeThread::~ScopedRealtimeThread() {
+    if (placed_) {
+        SetThreadCoreClass(CoreClass::Any);
+    }
+#if defined(_WIN32)
+    if (oldAffinity_ != 0) {
+        SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(oldAffinity_));
+    }
+    if (mmcssHandle_) {
+        AvRevertMmThreadCharacteristics(static_cast<HANDLE>(mmcssHandle_));
+    }
+#else
+    if (oldPolicy_ >= 0) {
+        sched_param param{};
+        param.sched_priority = oldPriority_;
+        pthread_setschedparam(pthread_self(), oldPolicy_, &param);
+    }
+#endif
+}
+
+ScopedDspThread::ScopedDspThread(const char* name) {
+    SetTraceThreadName(name);
+}
+
+ScopedDspThread::ScopedDspThread(const char* name, RealtimeThreadRole role) {
+    SetTraceThreadName(name);
+    realtime_.emplace(role);
+}
+
+ScopedDspThread::ScopedDspThread(const char* name, CoreClass cores) {
+    SetTraceThreadName(name);
+    placed_ = SetThreadCoreClass(cores);
+}
+
+ScopedDspThread::~ScopedDspThread() {
+    if (placed_) {
+        SetThreadCoreClass(CoreClass::Any);
+    }
+}
+
+}  // namespace engine
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <optional>
+
+#include "dsp/Denormals.h"
+
+namespace engine {
+
+// MMCSS priority within the "Pro Audio" task (AVRT_PRIORITY_*); elsewhere a
+// SCHED_FIFO priority below JACK's own threads.
+enum class RealtimePriority { Low, Normal, High, Critical };
+
+// Process-wide scheduling for Satori's real-time threads, read when each
+// thread starts (set it before starting audio).
+struct RealtimeThreadSettings {
+    bool useMmcss = true;  // off Windows: ask for SCHED_FIFO instead
+    RealtimePriority renderPriority = RealtimePriority::Critical;
+    RealtimePriority roomWorkerPriority = RealtimePriority::High;
+    // Pin the room worker to its own core, away from the render thread's.
+    bool pinRoomWorker = true;
+    // On hybrid CPUs keep the render thread and room worker on performance
+    // cores, and let background threads that ask for it (previews, the UI)
+    // move to efficiency cores. Ignored on CPUs with one kind of core.
+    bool hybridPlacement = true;
+};
+
+void SetRealtimeThreadSettings(const RealtimeThreadSettings& settings);
+RealtimeThreadSettings GetRealtimeThreadSettings();
+
+enum class RealtimeThreadRole { Render, RoomWorker };
+
+// Logical processors by kind. Windows ranks cores by CPU Set efficiency
+// class; Linux reads the kernel's cpu_core/cpu_atom lists. Detected once.
+struct CpuTopology {
+    int performanceCores = 0;  // highest efficiency class, or every core
+    int efficiencyCores = 0;   // lowest class; 0 unless the CPU is hybrid
+    bool hybrid() const { return performanceCores > 0 && efficiencyCores > 0; }
+};
+
+CpuTopology GetCpuTopology();
+
+enum class CoreClass { Any, Performance, Efficiency };
+
+// Restricts the calling thread to one kind of core (Windows CPU Sets, Linux
+// affinity); Any lifts the restriction. False, and nothing changes, on CPUs
+// that are not hybrid, on other platforms, or with hybridPlacement off.
+bool SetThreadCoreClass(CoreClass cores);
+
+// Core each role prefers: the render thread gets the last core and the room
+// worker the one before it, counted among performance cores on hybrid CPUs.
+// -1 on single-core machines.
+int PreferredCore(RealtimeThreadRole role);
+
+// Registers the calling thread with MMCSS "Pro Audio" at the role's priority
+// and steers it to PreferredCore(role): the render thread as its ideal
+// processor, the room worker pinned there when pinRoomWorker is set. On
+// hybrid CPUs both are also kept off efficiency cores.
+// On Linux and macOS the thread is switched to SCHED_FIFO instead, which
+// needs an rtprio limit (or root); without one it stays as it was.
+// Undone on destruction.
+class ScopedRealtimeThread {
+public:
+    explicit ScopedRealtimeThread(RealtimeThreadRole role);
+    ScopedRealtimeThread(const ScopedRealtimeThread&) = delete;
+    ScopedRealtimeThread& operator=(const ScopedRealtimeThread&) = delete;
+    ~ScopedRealtimeThread();
+
+    bool registered() const { return mmcssHandle_ != nullptr || oldPolicy_ >= 0; }
+
+private:
+    void* mmcssHandle_ = nullptr;
+    unsigned long long oldAffinity_ = 0;
+    bool placed_ = false;  // SetThreadCoreClass(Performance) to undo
+    int oldPolicy_ = -1;  // scheduling policy replaced by SCHED_FIFO
+    int oldPriority_ = 0;
+};
+
+// What every thread that runs DSP sets up, in one place: denormals flushed
+// (FTZ/DAZ), a name on the trace timeline and, for the real-time roles,
+// ScopedRealtimeThread. Also right for a driver's callback thread, scoped to
+// one callback. Undone on destruction, except the name.
+class ScopedDspThread {
+public:
+    explicit ScopedDspThread(const char* name);
+    ScopedDspThread(const char* name, RealtimeThreadRole role);
+    // A background thread kept to one kind of core for its lifetime.
+    ScopedDspThread(const char* name, CoreClass cores);
+    ~ScopedDspThread();
+    ScopedDspThread(const ScopedDspThread&) = delete;
+    ScopedDspThread& operator=(const ScopedDspThread&) = delete;
+
+    bool realtime() const { return realtime_ && realtime_->registered(); }
+
+private:
+    dsp::ScopedDenormalsDisable denormals_;
+    std::optional<ScopedRealtimeThread> realtime_;
+    bool placed_ = false;
+};
+
+}  // namespace engine
@@ -0,0 +1,328 @@
+#include "engine/RoomPartitionTuner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#include "dsp/ConvolutionReverb.h"
+#include "engine/StringSynthEngine.h"
+
+namespace engine {
+
+namespace {
+
+constexpr std::size_t kMaxTailStages = 3;
+constexpr std::size_t kMaxStageRatio = 8;     // between neighbouring stages
+constexpr std::size_t kMaxBlockRatio = 64;    // largest stage over the base
+constexpr std::size_t kMinTimedBlocks = 128;
+constexpr double kWorstPercentile = 0.99;
+
+struct SyntheticIr {
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+// Decaying noise, different per channel: the stage cost depends only on
+// the length, but a true-stereo kernel is the expensive case.
+SyntheticIr MakeIr(std::size_t frames) {
+    SyntheticIr ir;
+    ir.left.resize(frames);
+    ir.right.resize(frames);
+    std::uint32_t state = 0x2545F491u;
+    const auto noise = [&state] {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    };
+    const double tau = std::max<double>(1.0, static_cast<double>(frames) / 6.9);  // -60 dB at the end
+    for (std::size_t f = 0; f < frames; ++f) {
+        const auto gain = static_cast<float>(std::exp(-static_cast<double>(f) / tau));
+        ir.left[f] = gain * noise();
+        ir.right[f] = gain * noise();
+    }
+    return ir;
+}
+
+PartitionTiming TimeLayout(const std::vector<std::size_t>& blockSizes, const SyntheticIr& ir) {
+    PartitionTiming timing;
+    timing.blockSizes = blockSizes;
+    const auto layout = dsp::PartitionLayout::FromBlockSizes(blockSizes);
+    if (!layout.valid() || layout.blockSizes != blockSizes || ir.left.empty()) {
+        return timing;
+    }
+    dsp::ConvolutionReverb reverb;
+    reverb.setPartitionLayout(layout);
+    reverb.setStereoDecorrelation(false);
+    reverb.setMix(1.0f);
+    std::vector<dsp::StereoConvolutionKernel> kernels;
+    kernels.push_back(layout.buildKernel(ir.left.data(), ir.right.data(), ir.left.size()));
+    reverb.setIrKernels(std::move(kernels));
+
+    // Until the last stage has its first chunk due, later blocks are cheap.
+    const std::size_t base = layout.baseBlockSize();
+    const std::size_t largest = layout.blockSizes.back();
+    const std::size_t warmup = (layout.offsets.back() + 2 * largest) / base;
+    const std::size_t timed = std::max(kMinTimedBlocks, 4 * largest / base);
+    std::vector<float> input(base);
+    std::vector<float> outL(base);
+    std::vector<float> outR(base);
+    std::vector<double> micros;
+    micros.reserve(timed);
+    std::uint32_t state = 1u;
+    for (std::size_t b = 0; b < warmup + timed; ++b) {
+        for (float& sample : input) {
+            state = state * 1664525u + 1013904223u;
+            sample = static_cast<float>(state >> 8) * (1.0f / 16777216.0f) - 0.5f;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        reverb.processBlockWet(input.data(), outL.data(), outR.data());
+        const auto end = std::chrono::steady_clock::now();
+        if (b >= warmup) {
+            micros.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+    }
+    double sum = 0.0;
+    for (double us : micros) {
+        sum += us;
+    }
+    timing.meanUs = sum / static_cast<double>(micros.size());
+    const auto worst = micros.begin() + static_cast<std::ptrdiff_t>(
+                                            kWorstPercentile * static_cast<double>(micros.size() - 1));
+    std::nth_element(micros.begin(), worst, micros.end());
+    timing.worstUs = *worst;
+    return timing;
+}
+
+void ExtendCandidates(std::vector<std::size_t>& prefix, std::size_t limit,
+                      std::vector<std::vector<std::size_t>>& out) {
+    if (prefix.size() > 1) {
+        out.push_back(prefix);
+    }
+    if (prefix.size() > kMaxTailStages) {
+        return;
+    }
+    const std::size_t last = prefix.back();
+    for (std::size_t size = 2 * last; size <= limit && size <= kMaxStageRatio * last; size *= 2) {
+        prefix.push_back(size);
+        ExtendCandidates(prefix, limit, out);
+        prefix.pop_back();
+    }
+}
+
+std::string MachineName() {
+#if defined(_WIN32)
+    if (const char* id = std::getenv("PROCESSOR_IDENTIFIER"); id && *id) {
+        return id;
+    }
+#elif defined(__APPLE__)
+    char brand[256] = {};
+    std::size_t size = sizeof(brand);
+    if (sysctlbyname("machdep.cpu.brand_string", brand, &size, nullptr, 0) == 0 && brand[0]) {
+        return brand;
+    }
+#else
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            if (const auto colon = line.find(':'); colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+    }
+#endif
+    return "cpu";
+}
+
+}  // namespace
+
+std::vector<std::vector<std::size_t>> PartitionCandidates(std::size_t baseBlockSize,
+                                                          std::size_t irFrames) {
+    std::vector<std::vector<std::size_t>> candidates;
+    if (baseBlockSize == 0) {
+        return candidates;
+    }
+    std::vector<std::size_t> prefix{baseBlockSize};
+    ExtendCandidates(prefix, std::min(kMaxBlockRatio * baseBlockSize, irFrames), candidates);
+    return candidates;
+}
+
+PartitionTiming TimePartitionLayout(const std::vector<std::size_t>& blockSizes,
+                                    std::size_t irFrames) {
+    return TimeLayout(blockSizes, MakeIr(irFrames));
+}
+
+PartitionTiming TunePartitionLayout(const PartitionTuneRequest& request) {
+    const SyntheticIr ir = MakeIr(request.irFrames);
+    PartitionTiming best;
+    bool bestMeets = false;
+    for (const auto& candidate : PartitionCandidates(request.baseBlockSize, request.irFrames)) {
+        const PartitionTiming timing = TimeLayout(candidate, ir);
+        if (timing.meanUs <= 0.0) {
+            continue;
+        }
+        const bool meets = request.deadlineUs <= 0.0 || timing.worstUs <= request.deadlineUs;
+        const bool better = best.blockSizes.empty() || (meets && !bestMeets) ||
+                            (meets == bestMeets && (meets ? timing.meanUs < best.meanUs
+                                                          : timing.worstUs < best.worstUs));
+        if (better) {
+            best = timing;
+            bestMeets = meets;
+        }
+    }
+    return best;
+}
+
+bool PartitionTuneCache::load(const std::filesystem::path& path) {
+    entries_.clear();
+    std::ifstream in(path);
+    if (!in) {
+        return !std::filesystem::exists(path);
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        const auto tab = line.find('\t');
+        if (line.empty() || line[0] == '#' || tab == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(line.substr(tab + 1));
+        std::vector<std::size_t> blockSizes;
+        std::size_t size = 0;
+        while (fields >> size) {
+            blockSizes.push_back(size);
+        }
+        if (!blockSizes.empty()) {
+            entries_[line.substr(0, tab)] = std::move(blockSizes);
+        }
+    }
+    return true;
+}
+
+bool PartitionTuneCache::save(const std::filesystem::path& path, std::string& errorMessage) const {
+    std::error_code ec;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        errorMessage = "无法写入分区调优缓存: " + path.string();
+        return false;
+    }
+    out << "# Satori room partition layouts: machine|rate|buffer|base|IR frames[|offline], "
+           "then block sizes.\n";
+    for (const auto& [key, blockSizes] : entries_) {
+        out << key << '\t';
+        for (std::size_t i = 0; i < blockSizes.size(); ++i) {
+            out << (i > 0 ? " " : "") << blockSizes[i];
+        }
+        out << '\n';
+    }
+    if (!out.good()) {
+        errorMessage = "写入分区调优缓存失败: " + path.string();
+        return false;
+    }
+    return true;
+}
+
+const std::vector<std::size_t>* PartitionTuneCache::find(const std::string& key) const {
+    const auto it = entries_.find(key);
+    return it != entries_.end() ? &it->second : nullptr;
+}
+
+void PartitionTuneCache::store(const std::string& key, std::vector<std::size_t> blockSizes) {
+    entries_[key] = std::move(blockSizes);
+}
+
+std::string PartitionTuneCache::MachineKey() {
+    std::string name = MachineName();
+    std::replace_if(
+        name.begin(), name.end(), [](char c) { return c == '\t' || c == '\n' || c == '|'; }, ' ');
+    return name + "|" + std::to_string(std::thread::hardware_concurrency()) + "t";
+}
+
+std::string PartitionTuneCache::Key(int sampleRate, std::uint32_t bufferFrames,
+                                    std::size_t baseBlockSize, std::size_t irFrames,
+                                    bool offline) {
+    return MachineKey() + "|" + std::to_string(sampleRate) + "|" + std::to_string(bufferFrames) +
+           "|" + std::to_string(baseBlockSize) + "|" + std::to_string(irFrames) +
+           (offline ? "|offline" : "");
+}
+
+std::filesystem::path DefaultPartitionCachePath() {
+    const auto env = [](const char* name) -> std::filesystem::path {
+        const char* value = std::getenv(name);
+        return value && *value ? std::filesystem::path(value) : std::filesystem::path();
+    };
+#if defined(_WIN32)
+    if (const auto local = env("LOCALAPPDATA"); !local.empty()) {
+        return local / "Satori" / "partitions.txt";
+    }
+#else
+    if (const auto cache = env("XDG_CACHE_HOME"); !cache.empty()) {
+        return cache / "satori" / "partitions.txt";
+    }
+    if (const auto home = env("HOME"); !home.empty()) {
+        return home / ".cache" / "satori" / "partitions.txt";
+    }
+#endif
+    return {};
+}
+
+RoomPartitionTuning TuneRoomPartitions(const std::filesystem::path& cacheFile, int sampleRate,
+                                       std::uint32_t bufferFrames, RoomBlockProfile profile) {
+    RoomPartitionTuning tuning;
+    sampleRate = sampleRate > 0 ? sampleRate : 48000;
+    const bool offline = profile == RoomBlockProfile::Offline;
+    if (offline) {
+        bufferFrames = 0;
+    }
+    const auto preset = StringSynthEngine::RoomProfileBlockSizes(profile, bufferFrames);
+    const std::size_t base = preset.front();
+    const std::size_t irFrames = StringSynthEngine::RoomTailFrames(sampleRate, base);
+    const std::string key =
+        PartitionTuneCache::Key(sampleRate, bufferFrames, base, irFrames, offline);
+    PartitionTuneCache cache;
+    if (!cacheFile.empty()) {
+        cache.load(cacheFile);
+    }
+    if (const auto* cached = cache.find(key)) {
+        tuning.blockSizes = *cached;
+        tuning.fromCache = true;
+    } else {
+        // A buffer of several room blocks reaches the worker at once, so the
+        // last of them has that much less of the lead left.
+        const std::size_t burst = std::max<std::size_t>(1, (bufferFrames + base - 1) / base);
+        const std::size_t slack = StringSynthEngine::kRoomLeadBlocks > burst
+                                      ? StringSynthEngine::kRoomLeadBlocks - burst
+                                      : 1;
+        PartitionTuneRequest request;
+        request.baseBlockSize = base;
+        request.irFrames = irFrames;
+        request.deadlineUs =
+            offline ? 0.0 : static_cast<double>(slack * base) * 1e6 / sampleRate;
+        const PartitionTiming best = TunePartitionLayout(request);
+        tuning.blockSizes = best.blockSizes;
+        tuning.meanUs = best.meanUs;
+        tuning.worstUs = best.worstUs;
+        if (!tuning.blockSizes.empty() && !cacheFile.empty()) {
+            cache.store(key, tuning.blockSizes);
+            std::string ignored;
+            cache.save(cacheFile, ignored);
+        }
+    }
+    if (tuning.blockSizes.empty()) {
+        tuning.blockSizes = preset;
+    }
+    tuning.applied = StringSynthEngine::SetRoomPartitionLayout(tuning.blockSizes);
+    return tuning;
+}
+
+}  // namespace engine
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "engine/StringSynthEngine.h"
+
+namespace engine {
+
+// Startup calibration of the room tail's partition layout. Each candidate
+// (the base block, then one to three larger stages) convolves a synthetic
+// stereo IR of the length the room needs, and the cheapest on this CPU
+// whose slow blocks still land within the head's lead wins. Results are
+// cached per machine and setting, so the pass runs once.
+struct PartitionTuneRequest {
+    std::size_t baseBlockSize = 256;
+    std::size_t irFrames = 0;  // the longest IR the layout has to serve
+    // Slowest base block allowed (99th percentile); 0 is no limit.
+    double deadlineUs = 0.0;
+};
+
+struct PartitionTiming {
+    std::vector<std::size_t> blockSizes;
+    double meanUs = 0.0;   // per base block
+    double worstUs = 0.0;  // 99th percentile base block
+};
+
+// Base first, then one to three ascending powers of two from 2x to 64x
+// the base, at most 8x apart and no longer than the IR.
+std::vector<std::vector<std::size_t>> PartitionCandidates(std::size_t baseBlockSize,
+                                                          std::size_t irFrames);
+
+// Runs `blockSizes` over an IR of `irFrames` until every stage is busy,
+// then times each base block. An invalid layout comes back untimed.
+PartitionTiming TimePartitionLayout(const std::vector<std::size_t>& blockSizes,
+                                    std::size_t irFrames);
+
+// Cheapest mean among the candidates under the deadline; the one with the
+// fastest slow blocks when none is.
+PartitionTiming TunePartitionLayout(const PartitionTuneRequest& request);
+
+// Tuned layouts by key, one "key<TAB>block block..." line each.
+class PartitionTuneCache {
+public:
+    // A missing file is an empty cache; unreadable lines are skipped.
+    bool load(const std::filesystem::path& path);
+    bool save(const std::filesystem::path& path, std::string& errorMessage) const;
+
+    const std::vector<std::size_t>* find(const std::string& key) const;
+    void store(const std::string& key, std::vector<std::size_t> blockSizes);
+
+    // CPU model, hardware threads and SIMD width.
+    static std::string MachineKey();
+    // `offline`: tuned without a deadline (RoomBlockProfile::Offline).
+    static std::string Key(int sampleRate, std::uint32_t bufferFrames, std::size_t baseBlockSize,
+                           std::size_t irFrames, bool offline = false);
+
+private:
+    std::map<std::string, std::vector<std::size_t>> entries_;
+};
+
+// $XDG_CACHE_HOME/satori (or ~/.cache/satori); %LOCALAPPDATA%\Satori on
+// Windows. Empty when none of them is set.
+std::filesystem::path DefaultPartitionCachePath();
+
+struct RoomPartitionTuning {
+    std::vector<std::size_t> blockSizes;
+    bool fromCache = false;
+    bool applied = false;  // false once a room was already built
+    double meanUs = 0.0;   // measured this run; 0 from the cache
+    double worstUs = 0.0;
+};
+
+// Looks up or tunes the room layout for this machine, device rate and
+// buffer against the longest library IR, stores it in `cacheFile` (none if
+// empty) and installs it with StringSynthEngine::SetRoomPartitionLayout().
+// The base block comes from `profile` (StringSynthEngine::
+// RoomProfileBlockSizes()), whose stages are used if timing fails. A device
+// buffer of several room blocks arrives at the worker in one burst, so it
+// shortens the deadline; Offline ignores the buffer and has none. Call
+// before the first engine is built.
+RoomPartitionTuning TuneRoomPartitions(const std::filesystem::path& cacheFile, int sampleRate,
+                                       std::uint32_t bufferFrames,
+                                       RoomBlockProfile profile = RoomBlockProfile::Balanced);
+
+}  // namespace engine
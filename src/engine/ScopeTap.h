@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+
+// Live copy of the output for meters and scopes. The audio thread mixes each
+// block to mono, halves the rate and writes it into a ring; a UI thread
+// copies the newest samples out whenever it likes. The writer never waits:
+// a reader that was lapped mid-copy notices (seqlock-style claim counter)
+// and simply tries again next frame.
+class ScopeTap {
+public:
+    static constexpr std::size_t kCapacity = 8192;  // mono samples after decimation
+    static constexpr std::size_t kDecimation = 2;
+
+    // Audio thread.
+    void publish(const float* interleaved, std::size_t frames, std::size_t channels) {
+        if (!interleaved || channels == 0) {
+            return;
+        }
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        const std::uint64_t produced = (pending_ + frames) / kDecimation;
+        // Claim the slots before touching them so a reader can tell.
+        claim_.store(head + produced, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const float channelScale = 1.0f / static_cast<float>(channels);
+        std::uint64_t write = head;
+        for (std::size_t f = 0; f < frames; ++f) {
+            const float* frame = interleaved + f * channels;
+            float mono = 0.0f;
+            for (std::size_t c = 0; c < channels; ++c) {
+                mono += frame[c];
+            }
+            sum_ += mono * channelScale;
+            if (++pending_ == kDecimation) {
+                ring_[write & (kCapacity - 1)].store(sum_ / static_cast<float>(kDecimation),
+                                                     std::memory_order_relaxed);
+                ++write;
+                sum_ = 0.0f;
+                pending_ = 0;
+            }
+        }
+        head_.store(write, std::memory_order_release);
+    }
+
+    // Any thread but the writer: the newest `count` samples, oldest first.
+    // False if fewer were written so far or the writer overran the copy.
+    bool readLatest(float* out, std::size_t count) const {
+        if (!out || count == 0 || count > kCapacity / 2) {
+            return false;
+        }
+        const std::uint64_t head = head_.load(std::memory_order_acquire);
+        if (head < count) {
+            return false;
+        }
+        const std::uint64_t first = head - count;
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = ring_[(first + i) & (kCapacity - 1)].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return claim_.load(std::memory_order_relaxed) <= first + kCapacity;
+    }
+
+    // Decimated samples published so far.
+    std::uint64_t written() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    std::array<std::atomic<float>, kCapacity> ring_{};
+    std::atomic<std::uint64_t> head_{0};
+    std::atomic<std::uint64_t> claim_{0};
+    // Writer-only decimation state carried across blocks.
+    float sum_ = 0.0f;
+    std::size_t pending_ = 0;
+};
+
+}  // namespace engine
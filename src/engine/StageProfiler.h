@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(SATORI_ENABLE_PROFILING)
+#define SATORI_PROFILING_ENABLED 1
+#else
+#define SATORI_PROFILING_ENABLED 0
+#endif
+
+#if SATORI_PROFILING_ENABLED
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+#include <intrin.h>
+#ifndef ARM64_CNTVCT
+#define ARM64_CNTVCT ARM64_SYSREG(3, 3, 14, 0, 2)
+#endif
+#elif !defined(__aarch64__)
+#include <chrono>
+#endif
+#endif
+
+namespace engine {
+
+// Stages of one audio callback, in signal order.
+enum class ProfileStage : std::uint8_t {
+    Events,     // event dispatch and control sync
+    Voices,     // voice rendering and master gain
+    Body,       // sympathetic strings and body filter
+    Room,       // room processor (head, decorrelation, tail mix)
+    Output,     // interleaving into the device buffer
+    Resampler,  // synth rate -> device rate (SatoriRealtimeEngine)
+    Count
+};
+
+inline constexpr std::size_t kProfileStageCount = static_cast<std::size_t>(ProfileStage::Count);
+
+inline const char* ProfileStageName(ProfileStage stage) {
+    switch (stage) {
+        case ProfileStage::Events: return "events";
+        case ProfileStage::Voices: return "voices";
+        case ProfileStage::Body: return "body";
+        case ProfileStage::Room: return "room";
+        case ProfileStage::Output: return "output";
+        case ProfileStage::Resampler: return "resampler";
+        default: return "?";
+    }
+}
+
+// Cumulative ticks per stage. Ticks are TSC cycles on x86, generic timer
+// counts on ARM64 and nanoseconds elsewhere; compare stages or two snapshots
+// of one machine, not machines.
+struct StageProfile {
+    std::array<std::uint64_t, kProfileStageCount> ticks{};
+
+    StageProfile& operator+=(const StageProfile& other) {
+        for (std::size_t i = 0; i < kProfileStageCount; ++i) {
+            ticks[i] += other.ticks[i];
+        }
+        return *this;
+    }
+};
+
+#if SATORI_PROFILING_ENABLED
+inline std::uint64_t ReadProfileTicks() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+    return static_cast<std::uint64_t>(_ReadStatusReg(ARM64_CNTVCT));
+#elif defined(__aarch64__)
+    // Generic timer virtual count: a fixed-rate counter, like an invariant TSC.
+    std::uint64_t ticks = 0;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Per-stage counters with a single writer (the audio thread); snapshot()
+// may be called from any thread.
+class StageProfiler {
+public:
+    void add(ProfileStage stage, std::uint64_t ticks) {
+        auto& counter = ticks_[static_cast<std::size_t>(stage)];
+        counter.store(counter.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+    }
+    StageProfile snapshot() const {
+        StageProfile profile;
+        for (std::size_t i = 0; i < kProfileStageCount; ++i) {
+            profile.ticks[i] = ticks_[i].load(std::memory_order_relaxed);
+        }
+        return profile;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, kProfileStageCount> ticks_{};
+};
+
+// Charges the time since the previous mark (or construction) to a stage.
+class StageLap {
+public:
+    explicit StageLap(StageProfiler& profiler) : profiler_(profiler), last_(ReadProfileTicks()) {}
+    void mark(ProfileStage stage) {
+        const std::uint64_t now = ReadProfileTicks();
+        profiler_.add(stage, now - last_);
+        last_ = now;
+    }
+    // Starts the next lap without charging the time just spent.
+    void skip() { last_ = ReadProfileTicks(); }
+
+private:
+    StageProfiler& profiler_;
+    std::uint64_t last_;
+};
+#else
+class StageProfiler {
+public:
+    void add(ProfileStage, std::uint64_t) {}
+    StageProfile snapshot() const { return {}; }
+};
+
+class StageLap {
+public:
+    explicit StageLap(StageProfiler&) {}
+    void mark(ProfileStage) {}
+    void skip() {}
+};
+#endif  // SATORI_PROFILING_ENABLED
+
+}  // namespace engine
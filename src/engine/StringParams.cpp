@@ -1,79 +1,83 @@
 #include "engine/StringParams.h"
 
-#include <algorithm>
-#include <cctype>
-#include <string>
-
-#include "dsp/RoomIrLibrary.h"
+#include <cstdint>
 
 namespace engine {
 
 namespace {
 
-std::string ToLower(std::string_view value) {
-    std::string lowered(value);
-    std::transform(lowered.begin(), lowered.end(), lowered.begin(),
-                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-    return lowered;
+// FNV-1a over the lowercased name, offset by `seed`, with a final mix so
+// the low bits used for the slot depend on every character.
+constexpr std::uint32_t NameHash(std::string_view name, std::uint32_t seed) {
+    std::uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+    for (const char ch : name) {
+        hash ^= static_cast<std::uint8_t>(ToLowerAscii(ch));
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+    return hash;
 }
 
-}  // namespace
+constexpr std::size_t kNameSlots = 128;  // power of two, well above kParamCount
+static_assert(kParamCount < kNameSlots / 2);
 
-const std::vector<ParamInfo>& GetParamInfoList() {
-    static const std::vector<ParamInfo> kParams = [] {
-        const float maxIr =
-            std::max(0.0f,
-                     static_cast<float>(std::max<std::size_t>(1, dsp::RoomIrLibrary::list().size()) - 1));
-        return std::vector<ParamInfo>{
-            {ParamId::Decay, "decay", ParamType::Float, 0.90f, 0.999f, 0.996f},
-            {ParamId::Brightness, "brightness", ParamType::Float, 0.0f, 1.0f, 0.5f},
-            {ParamId::DispersionAmount, "dispersionAmount", ParamType::Float, 0.0f, 1.0f,
-             0.12f},
-            {ParamId::ExcitationBrightness, "excitationBrightness", ParamType::Float, 0.0f, 1.0f,
-             0.6f},
-            {ParamId::ExcitationVelocity, "excitationVelocity", ParamType::Float, 0.0f, 1.0f,
-             0.5f},
-            {ParamId::ExcitationMix, "excitationMix", ParamType::Float, 0.0f, 1.0f, 1.0f},
-            {ParamId::BodyTone, "bodyTone", ParamType::Float, 0.0f, 1.0f, 0.5f},
-            {ParamId::BodySize, "bodySize", ParamType::Float, 0.0f, 1.0f, 0.5f},
-            {ParamId::RoomAmount, "roomAmount", ParamType::Float, 0.0f, 1.0f, 0.0f},
-            // Discrete IR selection for the convolution reverb.
-            {ParamId::RoomIR, "roomIR", ParamType::Enum, 0.0f, maxIr, 0.0f},
-            {ParamId::PickPosition, "pickPosition", ParamType::Float, 0.05f, 0.95f, 0.5f},
-            {ParamId::EnableLowpass, "enableLowpass", ParamType::Bool, 0.0f, 1.0f, 1.0f},
-            {ParamId::NoiseType, "noiseType", ParamType::Enum, 0.0f, 1.0f, 0.0f},
-            {ParamId::MasterGain, "masterGain", ParamType::Float, 0.0f, 2.0f, 1.0f},
-            {ParamId::AmpRelease, "ampRelease", ParamType::Float, 0.01f, 5.0f, 0.35f},
-        };
-    }();
-    return kParams;
+// The first seed under which no two names share a slot.
+constexpr std::uint32_t FindNameSeed() {
+    for (std::uint32_t seed = 0;; ++seed) {
+        std::array<bool, kNameSlots> used{};
+        bool collided = false;
+        for (const auto& info : detail::kParamTable) {
+            const std::size_t slot = NameHash(info.name, seed) & (kNameSlots - 1);
+            if (used[slot]) {
+                collided = true;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (!collided) {
+            return seed;
+        }
+    }
 }
 
-const ParamInfo* GetParamInfo(ParamId id) {
-    const auto& params = GetParamInfoList();
-    auto it = std::find_if(params.begin(), params.end(),
-                           [id](const ParamInfo& info) { return info.id == id; });
-    if (it == params.end()) {
-        return nullptr;
+constexpr std::uint32_t kNameSeed = FindNameSeed();
+
+// Slot -> ParamId index, -1 when empty.
+constexpr std::array<std::int8_t, kNameSlots> BuildNameSlots() {
+    std::array<std::int8_t, kNameSlots> slots{};
+    slots.fill(-1);
+    for (std::size_t i = 0; i < detail::kParamTable.size(); ++i) {
+        const std::size_t slot = NameHash(detail::kParamTable[i].name, kNameSeed) & (kNameSlots - 1);
+        slots[slot] = static_cast<std::int8_t>(i);
     }
-    return &(*it);
+    return slots;
 }
 
-const ParamInfo* FindParamByName(std::string_view name) {
-    const auto lowered = ToLower(name);
-    const auto& params = GetParamInfoList();
-    auto it = std::find_if(params.begin(), params.end(),
-                           [&lowered](const ParamInfo& info) {
-                               return lowered == ToLower(info.name);
-                           });
-    if (it == params.end()) {
-        return nullptr;
+constexpr std::array<std::int8_t, kNameSlots> kNameSlotTable = BuildNameSlots();
+
+constexpr bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (ToLowerAscii(a[i]) != ToLowerAscii(b[i])) {
+            return false;
+        }
     }
-    return &(*it);
+    return true;
 }
 
-float ClampToRange(const ParamInfo& info, float value) {
-    return std::max(info.minValue, std::min(info.maxValue, value));
+}  // namespace
+
+const ParamInfo* FindParamByName(std::string_view name) {
+    const std::int8_t index = kNameSlotTable[NameHash(name, kNameSeed) & (kNameSlots - 1)];
+    if (index < 0) {
+        return nullptr;
+    }
+    const ParamInfo& info = detail::kParamTable[static_cast<std::size_t>(index)];
+    return EqualsIgnoreCase(name, info.name) ? &info : nullptr;
 }
 
 }  // namespace engine
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
 #include <string_view>
-#include <vector>
+
+#include "room_ir/RoomIrData.h"
 
 namespace engine {
 
@@ -14,15 +19,30 @@ enum class ParamId {
     ExcitationMix,
     BodyTone,
     BodySize,
+    BodyMode,
+    BodyModel,
     RoomAmount,
     RoomIR,
+    RoomType,
     PickPosition,
     EnableLowpass,
     NoiseType,
     MasterGain,
     AmpRelease,
+    PitchBend,
+    VibratoRate,
+    VibratoDepth,
+    SustainPedal,
+    SostenutoPedal,
+    SympatheticAmount,
+    StereoSpread,
+    CourseDetune,
+    InputMode,
+    InputGain,
 };
 
+inline constexpr std::size_t kParamCount = static_cast<std::size_t>(ParamId::InputGain) + 1;
+
 enum class ParamType { Float, Bool, Enum };
 
 struct ParamInfo {
@@ -34,9 +54,91 @@ struct ParamInfo {
     float defaultValue;
 };
 
-const std::vector<ParamInfo>& GetParamInfoList();
-const ParamInfo* GetParamInfo(ParamId id);
+// One parameter's new value, for batched updates (StringSynthEngine::setParams).
+struct ParamValue {
+    ParamId id = ParamId::Decay;
+    float value = 0.0f;
+};
+
+namespace detail {
+// Entry i describes ParamId i, so lookups are a bounds check and an index.
+inline constexpr std::array<ParamInfo, kParamCount> kParamTable = {{
+    {ParamId::Decay, "decay", ParamType::Float, 0.90f, 0.999f, 0.996f},
+    {ParamId::Brightness, "brightness", ParamType::Float, 0.0f, 1.0f, 0.5f},
+    {ParamId::DispersionAmount, "dispersionAmount", ParamType::Float, 0.0f, 1.0f, 0.12f},
+    {ParamId::ExcitationBrightness, "excitationBrightness", ParamType::Float, 0.0f, 1.0f, 0.6f},
+    {ParamId::ExcitationVelocity, "excitationVelocity", ParamType::Float, 0.0f, 1.0f, 0.5f},
+    {ParamId::ExcitationMix, "excitationMix", ParamType::Float, 0.0f, 1.0f, 1.0f},
+    {ParamId::BodyTone, "bodyTone", ParamType::Float, 0.0f, 1.0f, 0.5f},
+    {ParamId::BodySize, "bodySize", ParamType::Float, 0.0f, 1.0f, 0.5f},
+    // 0 = body filter after the mix, 1 = commuted into each excitation.
+    {ParamId::BodyMode, "bodyMode", ParamType::Enum, 0.0f, 1.0f, 0.0f},
+    // 0 = tilt filter, 1 = guitar modes, 2 = koto modes.
+    {ParamId::BodyModel, "bodyModel", ParamType::Enum, 0.0f, 2.0f, 0.0f},
+    {ParamId::RoomAmount, "roomAmount", ParamType::Float, 0.0f, 1.0f, 0.0f},
+    // Discrete IR selection for the room reverb; the slot after the
+    // library's holds a user IR loaded at runtime.
+    {ParamId::RoomIR, "roomIR", ParamType::Enum, 0.0f,
+     static_cast<float>(dsp::room_ir::kItemCount), 0.0f},
+    // 0 = convolution, 1 = feedback delay network fitted to the IR.
+    {ParamId::RoomType, "roomType", ParamType::Enum, 0.0f, 1.0f, 0.0f},
+    {ParamId::PickPosition, "pickPosition", ParamType::Float, 0.05f, 0.95f, 0.5f},
+    {ParamId::EnableLowpass, "enableLowpass", ParamType::Bool, 0.0f, 1.0f, 1.0f},
+    {ParamId::NoiseType, "noiseType", ParamType::Enum, 0.0f, 1.0f, 0.0f},
+    {ParamId::MasterGain, "masterGain", ParamType::Float, 0.0f, 2.0f, 1.0f},
+    {ParamId::AmpRelease, "ampRelease", ParamType::Float, 0.01f, 5.0f, 0.35f},
+    // Performance controls in semitones: they retune sounding notes.
+    {ParamId::PitchBend, "pitchBend", ParamType::Float, -12.0f, 12.0f, 0.0f},
+    {ParamId::VibratoRate, "vibratoRate", ParamType::Float, 0.1f, 12.0f, 5.0f},
+    {ParamId::VibratoDepth, "vibratoDepth", ParamType::Float, 0.0f, 1.0f, 0.0f},
+    // Pedals (MIDI CC64 / CC66): down holds released notes.
+    {ParamId::SustainPedal, "sustainPedal", ParamType::Bool, 0.0f, 1.0f, 0.0f},
+    {ParamId::SostenutoPedal, "sostenutoPedal", ParamType::Bool, 0.0f, 1.0f, 0.0f},
+    // Open strings ringing along with the played ones.
+    {ParamId::SympatheticAmount, "sympatheticAmount", ParamType::Float, 0.0f, 1.0f, 0.0f},
+    // Key-tracked voice panning; 0 keeps the voice mix mono.
+    {ParamId::StereoSpread, "stereoSpread", ParamType::Float, 0.0f, 1.0f, 0.0f},
+    // Cents between the two strings of a doubled course; 0 plays one string.
+    {ParamId::CourseDetune, "courseDetune", ParamType::Float, 0.0f, 20.0f, 0.0f},
+    // Live input (ProcessBlock::input): 0 = off, 1 = through the body and
+    // room, 2 = exciting the sympathetic strings (engine::LiveInputMode).
+    {ParamId::InputMode, "inputMode", ParamType::Enum, 0.0f, 2.0f, 0.0f},
+    {ParamId::InputGain, "inputGain", ParamType::Float, 0.0f, 4.0f, 1.0f},
+}};
+
+constexpr bool TableIndexedById() {
+    for (std::size_t i = 0; i < kParamTable.size(); ++i) {
+        if (static_cast<std::size_t>(kParamTable[i].id) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(TableIndexedById(), "kParamTable must list the parameters in ParamId order");
+}  // namespace detail
+
+// In ParamId order.
+constexpr std::span<const ParamInfo> GetParamInfoList() {
+    return detail::kParamTable;
+}
+
+// Null for an id outside the enum.
+constexpr const ParamInfo* GetParamInfo(ParamId id) {
+    const auto index = static_cast<std::size_t>(id);
+    return index < kParamCount ? &detail::kParamTable[index] : nullptr;
+}
+
+// ASCII only, so names hash and compare the same under any locale.
+constexpr char ToLowerAscii(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// Case-insensitive; a perfect hash over the names, so one probe and one
+// comparison.
 const ParamInfo* FindParamByName(std::string_view name);
-float ClampToRange(const ParamInfo& info, float value);
+
+constexpr float ClampToRange(const ParamInfo& info, float value) {
+    return std::max(info.minValue, std::min(info.maxValue, value));
+}
 
 }  // namespace engine
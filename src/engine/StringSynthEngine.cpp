@@ -3,76 +3,394 @@
 #include <array>
 #include <atomic>
 #include <algorithm>
+#include <bit>
 #include <chrono>
 #include <cmath>
+#include <compare>
 #include <condition_variable>
+#include <filesystem>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <utility>
 
+#include "audio/SampleConvert.h"
+#include "audio/WaveReader.h"
 #include "dsp/Filter.h"
+#include "dsp/ConvolutionHead.h"
 #include "dsp/ConvolutionReverb.h"
+#include "dsp/FdnReverb.h"
+#include "dsp/Halfband.h"
+#include "dsp/ModalBody.h"
 #include "dsp/Denormals.h"
+#include "dsp/FastMath.h"
 #include "dsp/PartitionedConvolver.h"
+#include "dsp/Resampler.h"
 #include "dsp/RoomIrLibrary.h"
+#include "dsp/Simd.h"
+#include "dsp/SmoothedValue.h"
+#include "dsp/StateSnapshot.h"
+#include "dsp/SympatheticStrings.h"
+#include "engine/AdaptiveTailDelay.h"
+#include "engine/AmpEnvelope.h"
+#include "engine/LatencyHistogram.h"
+#include "engine/MemoryUsage.h"
+#include "engine/MidiNote.h"
+#include "engine/RealtimeCheck.h"
+#include "engine/RealtimeThread.h"
+#include "engine/Tracer.h"
+#include "engine/VoiceRenderPool.h"
+#include "synthesis/ExcitationPool.h"
 
 namespace engine {
 
 namespace {
+// Glide time for parameters that change while notes sound.
+constexpr double kParamSmoothingSeconds = 0.01;
+constexpr double kPi = 3.14159265358979323846;
+// Past the 60 dB decay of the slowest built-in body mode (3.1 s at full size).
+constexpr double kStereoHoldSeconds = 4.0;
+
 float Clamp01(float v) { return std::max(0.0f, std::min(1.0f, v)); }
+
+inline void CpuRelax() {
+#if defined(SATORI_SIMD_SSE2)
+    _mm_pause();
+#elif defined(SATORI_SIMD_NEON) && defined(_MSC_VER)
+    __yield();
+#elif defined(SATORI_SIMD_NEON)
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// One segment of a part's output into its stem at `offset`; a mono part
+// (null `right`) fills both sides.
+void CopyPartStem(const StemOutputs::Pair& stem, std::size_t offset, const float* left,
+                  const float* right, std::size_t frames) {
+    if (stem[0]) {
+        std::copy(left, left + frames, stem[0] + offset);
+    }
+    if (stem[1]) {
+        const float* src = right ? right : left;
+        std::copy(src, src + frames, stem[1] + offset);
+    }
+}
+// Live input scaled by a gain ramped linearly from `gain` to `target` over
+// the segment; false (and nothing written) while both are 0. Without input
+// the gain drops to 0, so the next input ramps in.
+bool RampLiveInput(const float* input, float* out, float& gain, float target,
+                   std::size_t frames) {
+    if (!input) {
+        gain = 0.0f;
+        return false;
+    }
+    if (gain == 0.0f && target == 0.0f) {
+        return false;
+    }
+    const float step = (target - gain) / static_cast<float>(frames);
+    float g = gain;
+    for (std::size_t i = 0; i < frames; ++i) {
+        g += step;
+        out[i] = g * input[i];
+    }
+    gain = target;
+    return true;
+}
+
+// A null `right` runs mono.
+void ApplySmoothedGain(dsp::SmoothedValue& gain, float* left, float* right, std::size_t frames) {
+    std::size_t i = 0;
+    for (; i < frames && !gain.settled(); ++i) {
+        const float g = gain.next();
+        left[i] *= g;
+        if (right) {
+            right[i] *= g;
+        }
+    }
+    const float steady = gain.current();
+    const std::size_t gliding = i;
+    for (; i < frames; ++i) {
+        left[i] *= steady;
+    }
+    if (right) {
+        for (i = gliding; i < frames; ++i) {
+            right[i] *= steady;
+        }
+    }
+}
 float ComputeOnePoleAlpha(double sampleRate, double timeSeconds) {
     if (sampleRate <= 0.0 || timeSeconds <= 0.0) {
         return 1.0f;
     }
-    const double a = 1.0 - std::exp(-1.0 / (sampleRate * timeSeconds));
+    const double a = 1.0 - dsp::FastExp(-1.0 / (sampleRate * timeSeconds));
     return static_cast<float>(std::clamp(a, 0.0, 1.0));
 }
 }  // namespace
 
 class BodyFilter {
 public:
+    BodyFilter() {
+        response_.reserve(synthesis::KarplusStrongString::kMaxBodyResponseFrames);
+        responseOversampled_.reserve(synthesis::KarplusStrongString::kMaxBodyResponseFrames);
+    }
+
     void setSampleRate(double sampleRate) {
         if (sampleRate <= 0.0) {
             return;
         }
         sampleRate_ = sampleRate;
+        tone_.setTime(sampleRate, kParamSmoothingSeconds);
+        size_.setTime(sampleRate, kParamSmoothingSeconds);
+        modal_.setSampleRate(sampleRate);
         updateCoefficients();
+        updateResponse();
+    }
+
+    // Switching models resets the newly chosen one.
+    void setModel(synthesis::BodyModel model) {
+        if (model == model_) {
+            return;
+        }
+        model_ = model;
+        applyModes();
     }
 
+    // Replaces the guitar and koto tables; empty restores them. Copies into
+    // fixed storage, so it is fine on the audio thread.
+    void setCustomModes(std::span<const dsp::ModalBody::Mode> modes) {
+        customModeCount_ = std::min(modes.size(), customModes_.size());
+        std::copy_n(modes.begin(), customModeCount_, customModes_.begin());
+        applyModes();
+    }
+
+    // New settings glide in over kParamSmoothingSeconds; snapParams() applies
+    // them at once.
     void setParams(float tone, float size) {
-        tone_ = std::clamp(tone, 0.0f, 1.0f);
-        size_ = std::clamp(size, 0.0f, 1.0f);
+        tone_.setTarget(std::clamp(tone, 0.0f, 1.0f));
+        size_.setTarget(std::clamp(size, 0.0f, 1.0f));
+        updateResponse();
+    }
+
+    void snapParams(float tone, float size) {
+        tone_.snap(std::clamp(tone, 0.0f, 1.0f));
+        size_.snap(std::clamp(size, 0.0f, 1.0f));
         updateCoefficients();
+        updateResponse();
     }
 
+    // Impulse response at the target settings, for commuting the body into
+    // the excitation; the lowpass tail is cut once it falls below -120 dB.
+    // Storage is reserved up front, so data() stays put.
+    const std::vector<float>& response() const { return response_; }
+    // The same at twice the sample rate, for oversampled voices.
+    const std::vector<float>& responseOversampled() const { return responseOversampled_; }
+
     void reset() {
         lowFilter_.reset();
+        lowFilterRight_.reset();
+        modal_.reset();
+    }
+
+    // Filter memory and the glide for snapshots; the model, modes and rate
+    // are the caller's to set up first.
+    void saveState(dsp::StateWriter& out) const {
+        out.pod(model_);
+        out.pod(lowFilter_.state());
+        out.pod(lowFilterRight_.state());
+        out.pod(rightLive_);
+        out.pod(tone_);
+        out.pod(size_);
+        modal_.saveState(out);
+    }
+
+    bool loadState(dsp::StateReader& in) {
+        synthesis::BodyModel model = model_;
+        float low = 0.0f;
+        float lowRight = 0.0f;
+        if (in.pod(model) && model != model_) {
+            in.fail();
+        }
+        in.pod(low);
+        in.pod(lowRight);
+        in.pod(rightLive_);
+        in.pod(tone_);
+        in.pod(size_);
+        modal_.loadState(in);
+        lowFilter_.setState(low);
+        lowFilterRight_.setState(lowRight);
+        updateCoefficients();
+        updateResponse();
+        if (!in.ok()) {
+            reset();
+        }
+        return in.ok();
+    }
+
+    // A null `right` runs mono. Both channels share the settings; the right
+    // one picks up the left's state when it starts, as dsp::ModalBody does.
+    void processBlock(float* left, float* right, std::size_t frames) {
+        if (model_ != synthesis::BodyModel::Tilt) {
+            // The modes retune once per block while the settings glide.
+            if (!(tone_.settled() && size_.settled())) {
+                for (std::size_t i = 0; i < frames; ++i) {
+                    tone_.next();
+                    size_.next();
+                }
+                modal_.setShape(tone_.current(), size_.current());
+            }
+            modal_.processBlock(left, right, frames);
+            return;
+        }
+        if (right && !rightLive_) {
+            lowFilterRight_ = lowFilter_;
+        }
+        rightLive_ = right != nullptr;
+        std::size_t i = 0;
+        for (; i < frames && !(tone_.settled() && size_.settled()); ++i) {
+            tone_.next();
+            size_.next();
+            updateCoefficients();
+            left[i] = process(lowFilter_, left[i]);
+            if (right) {
+                right[i] = process(lowFilterRight_, right[i]);
+            }
+        }
+        processSettled(lowFilter_, left + i, frames - i);
+        if (right) {
+            processSettled(lowFilterRight_, right + i, frames - i);
+        }
     }
 
-    float process(float input) {
-        const float low = lowFilter_.process(input);
+private:
+    struct Coefficients {
+        float alpha = 0.1f;
+        float lowGain = 1.0f;
+        float highGain = 1.0f;
+    };
+
+    float process(dsp::OnePoleLowPass& lowFilter, float input) const {
+        const float low = lowFilter.process(input);
         const float high = input - low;
         return low * lowGain_ + high * highGain_;
     }
 
-private:
-    void updateCoefficients() {
-        const float fc = 180.0f + 800.0f * size_;
-        const float alpha = std::clamp(
+    // process() over a run with the settings steady: the lowpass goes
+    // through as a block and the gains mix it back in, a stack chunk at a
+    // time. The arithmetic is the same.
+    void processSettled(dsp::OnePoleLowPass& lowFilter, float* samples,
+                        std::size_t frames) const {
+        constexpr std::size_t kChunk = 64;
+        float low[kChunk];
+        for (std::size_t done = 0; done < frames; done += kChunk) {
+            const std::size_t count = std::min(kChunk, frames - done);
+            float* x = samples + done;
+            lowFilter.process(x, low, count);
+            for (std::size_t i = 0; i < count; ++i) {
+                x[i] = low[i] * lowGain_ + (x[i] - low[i]) * highGain_;
+            }
+        }
+    }
+
+    Coefficients computeCoefficients(float tone, float size) const {
+        const float fc = 180.0f + 800.0f * size;
+        Coefficients c;
+        c.alpha = std::clamp(
             static_cast<float>((2.0 * 3.141592653589793 * fc) / sampleRate_), 0.001f, 0.99f);
-        lowFilter_.setAlpha(alpha);
-        const float tilt = (tone_ - 0.5f) * 0.6f;
-        lowGain_ = std::clamp(1.0f + (-tilt), 0.6f, 1.6f);
-        highGain_ = std::clamp(1.0f + tilt, 0.6f, 1.6f);
+        const float tilt = (tone - 0.5f) * 0.6f;
+        c.lowGain = std::clamp(1.0f + (-tilt), 0.6f, 1.6f);
+        c.highGain = std::clamp(1.0f + tilt, 0.6f, 1.6f);
+        return c;
+    }
+
+    void updateCoefficients() {
+        const Coefficients c = computeCoefficients(tone_.current(), size_.current());
+        lowFilter_.setAlpha(c.alpha);
+        lowFilterRight_.setAlpha(c.alpha);
+        lowGain_ = c.lowGain;
+        highGain_ = c.highGain;
+        modal_.setShape(tone_.current(), size_.current());
+    }
+
+    void applyModes() {
+        if (customModeCount_ > 0) {
+            modal_.setModes(std::span(customModes_.data(), customModeCount_));
+        } else {
+            modal_.setModes(dsp::ModalBody::PresetModes(model_ == synthesis::BodyModel::Koto
+                                                            ? dsp::ModalBody::Preset::Koto
+                                                            : dsp::ModalBody::Preset::Guitar));
+        }
+        modal_.setShape(tone_.current(), size_.current());
+        updateResponse();
+    }
+
+    void updateResponse() {
+        if (model_ != synthesis::BodyModel::Tilt) {
+            // Modes ring far longer than the response a note-on can afford,
+            // so the commuted body keeps the start and fades out the rest.
+            constexpr std::size_t kFrames = synthesis::KarplusStrongString::kMaxBodyResponseFrames;
+            constexpr std::size_t kFade = kFrames / 4;
+            dsp::ModalBody probe = modal_;
+            probe.setShape(tone_.target(), size_.target());
+            response_.resize(kFrames);
+            probe.impulseResponse(response_.data(), kFrames);
+            for (std::size_t n = 0; n < kFade; ++n) {
+                response_[kFrames - kFade + n] *=
+                    static_cast<float>(kFade - n) / static_cast<float>(kFade);
+            }
+            updateOversampledResponse();
+            return;
+        }
+        const Coefficients c = computeCoefficients(tone_.target(), size_.target());
+        dsp::OnePoleLowPass low(c.alpha);
+        response_.clear();
+        float input = 1.0f;
+        for (std::size_t n = 0; n < synthesis::KarplusStrongString::kMaxBodyResponseFrames; ++n) {
+            const float l = low.process(input);
+            const float tail = l * (c.lowGain - c.highGain);
+            response_.push_back((input - l) * c.highGain + l * c.lowGain);
+            if (n > 0 && std::abs(tail) < 1e-6f) {
+                break;
+            }
+            input = 0.0f;
+        }
+        updateOversampledResponse();
+    }
+
+    // Interpolated rather than designed at 2x: the result only has to match
+    // below the lower Nyquist. A cut-off modal response fades out again.
+    void updateOversampledResponse() {
+        constexpr std::size_t kFrames = synthesis::KarplusStrongString::kMaxBodyResponseFrames;
+        responseOversampled_.resize(std::min(2 * response_.size(), kFrames));
+        dsp::UpsampleHalfband(response_.data(), response_.size(), responseOversampled_.data(),
+                              responseOversampled_.size());
+        if (2 * response_.size() > kFrames) {
+            constexpr std::size_t kFade = kFrames / 4;
+            for (std::size_t n = 0; n < kFade; ++n) {
+                responseOversampled_[kFrames - kFade + n] *=
+                    static_cast<float>(kFade - n) / static_cast<float>(kFade);
+            }
+        }
     }
 
     dsp::OnePoleLowPass lowFilter_{0.1f};
+    dsp::OnePoleLowPass lowFilterRight_{0.1f};
+    bool rightLive_ = false;  // lowFilterRight_ tracked the last block
     double sampleRate_ = 44100.0;
-    float tone_ = 0.5f;
-    float size_ = 0.5f;
+    dsp::SmoothedValue tone_{0.5f};
+    dsp::SmoothedValue size_{0.5f};
     float lowGain_ = 1.0f;
     float highGain_ = 1.0f;
+    synthesis::BodyModel model_ = synthesis::BodyModel::Tilt;
+    dsp::ModalBody modal_;
+    std::array<dsp::ModalBody::Mode, dsp::ModalBody::kMaxModes> customModes_{};
+    std::size_t customModeCount_ = 0;
+    std::vector<float> response_;
+    std::vector<float> responseOversampled_;
 };
 
 class ExpressiveMapping {
@@ -85,7 +403,7 @@ public:
         const double refFreq = 440.0;
         const double ratio = (frequency > 0.0) ? (frequency / refFreq) : 1.0;
         const float keyTrack =
-            static_cast<float>(std::clamp(std::log2(ratio), -3.0, 3.0));
+            static_cast<float>(std::clamp(dsp::FastLog2(ratio), -3.0, 3.0));
 
         const float amp = 0.45f + 0.65f * v;
 
@@ -109,9 +427,32 @@ public:
 
 class RoomProcessor {
 public:
-    RoomProcessor() { startWorker(); }
+    RoomProcessor() {
+        reverb_.setPartitionLayout(RoomPartitionLayout());
+        // The worker decorrelates the tail a block at a time; the audio
+        // thread only decorrelates the head. The stage is linear, so the
+        // sum matches decorrelating head and tail together.
+        // The tail renders wet-only; mix is applied on the audio thread.
+        reverb_.setMix(1.0f);
+        // Room changes let the old tail ring out instead of running both at once.
+        reverb_.setCrossfadeMode(dsp::IrCrossfade::RingOut);
+        // Long IRs split the late stages' partitions across helper threads.
+        if (const std::size_t helpers = TailHelperThreads(); helpers > 0) {
+            tailPool_ = std::make_unique<VoiceRenderPool>(helpers);
+            reverb_.setParallelism(helpers + 1, &RunOnTailPool, tailPool_.get());
+        }
+        // The network fits are left to the worker until a room first asks
+        // for them, so construction doesn't analyse every library IR.
+        startWorker();
+    }
 
-    ~RoomProcessor() { stopWorker(); }
+    ~RoomProcessor() {
+        stopLoader();
+        stopWorker();
+        delete pendingUserIr_.exchange(nullptr, std::memory_order_acq_rel);
+        delete pendingHead_.exchange(nullptr, std::memory_order_acq_rel);
+        delete retiredHead_.exchange(nullptr, std::memory_order_acq_rel);
+    }
 
     void setSampleRate(double sampleRate) {
         if (sampleRate <= 0.0) {
@@ -123,9 +464,10 @@ public:
             return;
         }
         requestedSampleRate_.store(sampleRate, std::memory_order_release);
-        mixSmoothingAlpha_ = ComputeOnePoleAlpha(sampleRate, 0.01);
+        mixSmoothingAlpha_ = ComputeOnePoleAlpha(sampleRate, kParamSmoothingSeconds);
+        rebuildPending_.store(true, std::memory_order_release);
         sampleRateSeq_.fetch_add(1, std::memory_order_acq_rel);
-        dataReady_.notify_one();
+        wakeWorker();
     }
 
     void setMix(float mix) {
@@ -136,1179 +478,4973 @@ public:
         requestedIrIndex_.store(std::max(0, index), std::memory_order_relaxed);
     }
 
+    // Any thread; the loader thread starts on first use. A request made
+    // while another load runs replaces it once that one finishes.
+    void loadUserIr(const std::filesystem::path& path) {
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex_);
+            userIrStatus_.store(UserIrStatus::Loading, std::memory_order_release);
+            loadRequest_ = path;
+            if (!loader_.joinable()) {
+                loaderStop_ = false;
+                loader_ = std::thread(&RoomProcessor::loaderLoop, this);
+            }
+        }
+        loaderWake_.notify_one();
+    }
+
+    UserIrStatus userIrStatus() const { return userIrStatus_.load(std::memory_order_acquire); }
+
+    static int UserIrIndex() { return static_cast<int>(dsp::RoomIrLibrary::list().size()); }
+
+    // False once RoomPartitionLayout() has been read.
+    static bool SetPartitionLayout(const dsp::PartitionLayout& layout) {
+        std::lock_guard<std::mutex> lock(LayoutMutex());
+        if (layoutFixed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        LayoutStorage() = layout;
+        return true;
+    }
+
+    // Without fixing it.
+    static std::vector<std::size_t> PartitionBlockSizes() {
+        std::lock_guard<std::mutex> lock(LayoutMutex());
+        return LayoutStorage().blockSizes;
+    }
+
+    static std::size_t TailFrames(int sampleRate, std::size_t blockFrames) {
+        const std::size_t frames = LibraryIrFrames(sampleRate);
+        return frames - std::min(frames, kOutputDelayBlocks * blockFrames);
+    }
+
+    // Swaps the convolution for the feedback delay network fitted to the
+    // selected IR; the convolution tail stays parked meanwhile.
+    void setAlgorithmic(bool algorithmic) {
+        requestedAlgorithmic_.store(algorithmic, std::memory_order_relaxed);
+    }
+
+    void setRenderMode(RenderMode mode) { renderMode_.store(mode, std::memory_order_relaxed); }
+    RenderMode renderMode() const { return renderMode_.load(std::memory_order_relaxed); }
+
+    void setQuality(RoomQuality quality) {
+        requestedQuality_.store(quality, std::memory_order_relaxed);
+    }
+    RoomQuality quality() const { return requestedQuality_.load(std::memory_order_relaxed); }
+
+    // Current lag of the tail behind its input and the number of tail blocks
+    // that arrived too late.
+    std::size_t outputDelayFrames() const {
+        return reportedDelayBlocks_.load(std::memory_order_relaxed) * blockSize_;
+    }
+    std::uint64_t lateBlocks() const { return lateBlocks_.load(std::memory_order_relaxed); }
+
+    // Any thread.
+    RoomTelemetry telemetry() const {
+        RoomTelemetry t;
+        t.lateBlocks = lateBlocks();
+        t.droppedDryBlocks = droppedDryBlocks_.load(std::memory_order_relaxed);
+        t.droppedWetBlocks = droppedWetBlocks_.load(std::memory_order_relaxed);
+        t.dryQueueHighWater = dryHighWater_.load(std::memory_order_relaxed);
+        t.wetQueueHighWater = wetHighWater_.load(std::memory_order_relaxed);
+        t.outputDelayFrames = outputDelayFrames();
+        t.suspended = suspended_.load(std::memory_order_relaxed);
+        const auto times = tailTimes_.snapshot();
+        t.tailBlocks = times.callbacks;
+        t.tailOverruns = times.overruns;
+        t.tailBlockUsMean = times.callbacks > 0
+                                ? static_cast<double>(tailNanos_.load(std::memory_order_relaxed)) /
+                                      1000.0 / static_cast<double>(times.callbacks)
+                                : 0.0;
+        t.tailBlockUsP99 = times.percentileUs(0.99);
+        t.tailBlockUsMax = times.maxUs();
+        return t;
+    }
+
+    // Not realtime-safe: waits for the worker to finish its current block so
+    // queued input is dropped rather than fed into the freshly reset tail.
     void reset() {
-        resetSeq_.fetch_add(1, std::memory_order_acq_rel);
+        {
+            std::lock_guard<std::mutex> lock(tailMutex_);
+            discardDryBlocksLocked();
+            discardWetBlocks();
+            resetSeq_.fetch_add(1, std::memory_order_acq_rel);
+        }
         // Clear local (audio-thread) state so old wet blocks don't leak through.
+        nextSeq_ = 0;
+        delay_.reset();
+        reportedDelayBlocks_.store(delay_.blocks(), std::memory_order_relaxed);
         blockPos_ = 0;
-        haveWetBlock_ = false;
-        havePlayDryBlock_ = false;
-        haveOutputSeq_ = false;
-        bufferedWet_.reset();
-        for (auto& block : dryHistory_) {
-            block.seq = std::numeric_limits<std::uint64_t>::max();
-        }
-        syncReverb_.reset();
-        syncBuiltOnce_ = false;
+        resetTailResync();
+        if (head_) {
+            head_->reset();
+        }
+        decorrelator_.reset();
+        std::fill(warmHistory_.begin(), warmHistory_.end(), 0.0f);
+        warmPos_ = 0;
+        fdnActive_ = false;
         currentMix_ = Clamp01(requestedMix_.load(std::memory_order_relaxed));
         lastTargetMix_ = 0.0f;
+        suspended_.store(true, std::memory_order_release);
     }
 
-    void process(float input, float& outL, float& outR) {
-        const float targetMix = Clamp01(requestedMix_.load(std::memory_order_relaxed));
-        currentMix_ += (targetMix - currentMix_) * mixSmoothingAlpha_;
+    // Everything the room is sounding, for engine snapshots: the tail
+    // reverb's histories and overlaps, the blocks queued to and from it, the
+    // head, the network and the audio-thread mixing state. The worker is
+    // held off for the save, which first applies what its next block would.
+    // Not realtime-safe.
+    void saveState(dsp::StateWriter& out) {
+        {
+            std::lock_guard<std::mutex> lock(tailMutex_);
+            if (!suspended_.load(std::memory_order_acquire)) {
+                applyTailStateLocked();
+            }
+            const bool built = kernelRate_ > 0;
+            out.pod(built);
+            if (built) {
+                out.pod(tailIrIndex_);
+                reverb_.saveState(out);
+                // A ring-out can start from a slot never built; so must the restore.
+                std::array<bool, 3> kernels{};
+                const auto irs = reverb_.activeIrIndices();
+                for (std::size_t i = 0; i < irs.size(); ++i) {
+                    kernels[i] = irs[i] >= 0 && reverb_.hasIrKernel(irs[i]);
+                }
+                out.pod(kernels);
+            }
+            out.pod(dryQueue_.size());
+            for (std::size_t i = 0; i < dryQueue_.size(); ++i) {
+                const DryBlock* block = dryQueue_.peek(i);
+                out.pod(block->seq);
+                out.floats(block->samples.data(), blockSize_);
+            }
+            out.pod(wetQueue_.size());
+            for (std::size_t i = 0; i < wetQueue_.size(); ++i) {
+                const StereoBlock* block = wetQueue_.peek(i);
+                out.pod(block->seq);
+                out.floats(block->samples.data(), 2 * blockSize_);
+            }
+        }
+        out.pod(blockPos_);
+        out.floats(dryBlock_->samples.data(), blockPos_);
+        out.pod(heldWetBlocks_);
+        delay_.saveState(out);
+        out.pod(tailGain_);
+        out.pod(heldTailL_);
+        out.pod(heldTailR_);
+        out.pod(nextSeq_);
+        out.pod(currentMix_);
+        out.pod(lastTargetMix_);
+        out.floats(warmHistory_.data(), headSamples_);
+        out.pod(warmPos_);
+        out.pod(warmStartPending_);
+        out.pod(inlineTail_);
+        out.pod(offlineDetected_);
+        decorrelator_.saveState(out);
+        out.pod(head_ != nullptr);
+        out.pod(pendingHead_.load(std::memory_order_acquire) != nullptr);
+        if (head_) {
+            out.pod(headIrIndex_);
+            head_->saveState(out);
+        }
+        out.pod(fdnIrIndex_);
+        out.pod(fdnFitSeq_);
+        out.pod(fdnActive_);
+        fdn_.saveState(out);
+        out.pod(suspended_.load(std::memory_order_acquire));
+    }
+
+    // After reset(), with the same sample rate, layout, quality and IRs
+    // loaded as the saved room; the kernels and heads it played from are
+    // built here. False (and reset) if the state does not fit.
+    bool loadState(dsp::StateReader& in) {
+        bool suspended = true;
+        {
+            std::lock_guard<std::mutex> lock(tailMutex_);
+            loadStateLocked(in);
+            in.pod(suspended);
+        }
+        if (!in.ok()) {
+            reset();
+            return false;
+        }
+        reportedDelayBlocks_.store(delay_.blocks(), std::memory_order_relaxed);
+        suspended_.store(suspended, std::memory_order_release);
+        if (!suspended && !inlineTail_) {
+            wakeWorker();
+        }
+        return true;
+    }
 
-        float wetL = 0.0f;
-        float wetR = 0.0f;
+    // Per-sample breakdown of the output, for stems: out = dry * dryGain +
+    // wet.
+    struct Split {
+        float* dryGain = nullptr;
+        float* wetL = nullptr;
+        float* wetR = nullptr;
+    };
 
-        if (useSynchronous_) {
-            syncProcess(input, wetL, wetR);  // wet-only
-            outL = input * (1.0f - currentMix_) + wetL * currentMix_;
-            outR = input * (1.0f - currentMix_) + wetR * currentMix_;
+    // `input` feeds the room (mono); dryL and dryR are the dry channels it
+    // is mixed with, all three the same buffer for a mono voice bus.
+    void processBlock(const float* input, const float* dryL, const float* dryR, float* outL,
+                      float* outR, std::size_t frames, const Split* split = nullptr) {
+        const float targetMix = Clamp01(requestedMix_.load(std::memory_order_relaxed));
+        if (targetMix <= 0.0f) {
+            bypassBlock(input, dryL, dryR, outL, outR, frames);
+            if (split) {
+                std::fill(split->dryGain, split->dryGain + frames, 1.0f);
+                std::fill(split->wetL, split->wetL + frames, 0.0f);
+                std::fill(split->wetR, split->wetR + frames, 0.0f);
+            }
             return;
         }
+        if (requestedAlgorithmic_.load(std::memory_order_relaxed)) {
+            algorithmicBlock(input, dryL, dryR, outL, outR, frames, split);
+            return;
+        }
+        fdnActive_ = false;
+        convolutionBlock(input, dryL, dryR, outL, outR, frames, targetMix, split);
+    }
 
-        if (targetMix <= 0.0f) {
-            if (lastTargetMix_ > 0.0f) {
-                resetSeq_.fetch_add(1, std::memory_order_acq_rel);
-                haveWetBlock_ = false;
-                havePlayDryBlock_ = false;
-                haveOutputSeq_ = false;
-                bufferedWet_.reset();
-                StereoBlock drained{};
-                while (wetQueue_.pop(drained)) {
+    // Mix at zero: dry copy plus the warm-start history, nothing else. The
+    // worker stays parked and no head or tail state is touched.
+    void bypassBlock(const float* input, const float* dryL, const float* dryR, float* outL,
+                     float* outR, std::size_t frames) {
+        if (lastTargetMix_ > 0.0f) {
+            enterBypass();
+        }
+        lastTargetMix_ = 0.0f;
+        fdnActive_ = false;
+        currentMix_ *= static_cast<float>(
+            std::pow(1.0 - static_cast<double>(mixSmoothingAlpha_), static_cast<double>(frames)));
+        std::copy(dryL, dryL + frames, outL);
+        std::copy(dryR, dryR + frames, outR);
+        recordWarmHistory(input, frames);
+    }
+
+    // Algorithmic room: the network runs here on the audio thread, so there
+    // is no worker, head or added latency. The convolution side is parked as
+    // in bypass and warm-starts from the history when chosen again.
+    void algorithmicBlock(const float* input, const float* dryL, const float* dryR, float* outL,
+                          float* outR, std::size_t frames, const Split* split) {
+        if (lastTargetMix_ > 0.0f) {
+            enterBypass();
+        }
+        lastTargetMix_ = 0.0f;
+        const double rate = requestedSampleRate_.load(std::memory_order_relaxed);
+        if (rate > 0.0 && rate != fdn_.sampleRate()) {
+            fdn_.setSampleRate(rate);
+            fdnActive_ = false;
+        }
+        const bool fitted = fitsReady();
+        const std::uint32_t fitSeq = userFitSeq_.load(std::memory_order_acquire);
+        int irIndex = requestedIrIndex_.load(std::memory_order_relaxed);
+        if (irIndex >= UserIrIndex()) {
+            irIndex = fitSeq > 0 ? UserIrIndex() : 0;
+        }
+        if (irIndex == UserIrIndex()) {
+            if (irIndex != fdnIrIndex_ || fitSeq != fdnFitSeq_) {
+                dsp::FdnReverb::Settings fit;
+                fit.rt60Seconds = userFitRt60_.load(std::memory_order_relaxed);
+                fit.highRatio = userFitHighRatio_.load(std::memory_order_relaxed);
+                fit.gain = userFitGain_.load(std::memory_order_relaxed);
+                fdn_.setSettings(fit);
+                fdnIrIndex_ = irIndex;
+                fdnFitSeq_ = fitSeq;
+            }
+        } else if (fitted && !AlgorithmicFits().empty()) {
+            const auto& fits = AlgorithmicFits();
+            irIndex = std::clamp(irIndex, 0, static_cast<int>(fits.size()) - 1);
+            if (irIndex != fdnIrIndex_) {
+                fdn_.setSettings(fits[static_cast<std::size_t>(irIndex)]);
+                fdnIrIndex_ = irIndex;
+            }
+        }
+        if (!fdnActive_) {
+            primeNetworkFromHistory();
+            fdnActive_ = true;
+        }
+
+        const float targetMix = Clamp01(requestedMix_.load(std::memory_order_relaxed));
+        std::array<float, kNetworkChunkFrames> wetL{};
+        std::array<float, kNetworkChunkFrames> wetR{};
+        for (std::size_t offset = 0; offset < frames; offset += kNetworkChunkFrames) {
+            const std::size_t count = std::min(kNetworkChunkFrames, frames - offset);
+            fdn_.process(input + offset, wetL.data(), wetR.data(), count);
+            for (std::size_t i = 0; i < count; ++i) {
+                currentMix_ += (targetMix - currentMix_) * mixSmoothingAlpha_;
+                const float dry = 1.0f - currentMix_;
+                const float wet = currentMix_ * dsp::ConvolutionReverb::kWetLevel;
+                outL[offset + i] = dryL[offset + i] * dry + wetL[i] * wet;
+                outR[offset + i] = dryR[offset + i] * dry + wetR[i] * wet;
+                if (split) {
+                    split->dryGain[offset + i] = dry;
+                    split->wetL[offset + i] = wetL[i] * wet;
+                    split->wetR[offset + i] = wetR[i] * wet;
                 }
             }
-            lastTargetMix_ = targetMix;
-            outL = input;
-            outR = input;
-            return;
         }
+        recordWarmHistory(input, frames);
+    }
+
+    void recordWarmHistory(const float* input, std::size_t frames) {
+        std::size_t i = frames > headSamples_ ? frames - headSamples_ : 0;
+        while (i < frames) {
+            const std::size_t run = std::min(frames - i, headSamples_ - warmPos_);
+            std::copy(input + i, input + i + run,
+                      warmHistory_.begin() + static_cast<std::ptrdiff_t>(warmPos_));
+            warmPos_ = (warmPos_ + run) % headSamples_;
+            i += run;
+        }
+    }
 
+    // Convolution room. Everything that happens at a block boundary (taking
+    // the next tail block, head IR changes, handing the dry block to the
+    // worker) is done once per block; the samples in between only mix.
+    void convolutionBlock(const float* input, const float* dryL, const float* dryR, float* outL,
+                          float* outR, std::size_t frames, float targetMix, const Split* split) {
         if (lastTargetMix_ <= 0.0f) {
-            // Freshly enabled: reset sequencing and clear any stale buffered blocks.
+            // Freshly enabled: reset sequencing and clear any stale buffered
+            // blocks, then wake the tail and warm the head at this boundary.
             resetSeq_.fetch_add(1, std::memory_order_acq_rel);
+            suspended_.store(false, std::memory_order_release);
+            warmStartPending_ = true;
             nextSeq_ = 0;
-            outputSeq_ = 0;
-            haveOutputSeq_ = false;
-            haveWetBlock_ = false;
-            havePlayDryBlock_ = false;
-            bufferedWet_.reset();
-            for (auto& block : dryHistory_) {
-                block.seq = std::numeric_limits<std::uint64_t>::max();
-            }
-            StereoBlock drained{};
-            while (wetQueue_.pop(drained)) {
+            blockPos_ = 0;
+            discardWetBlocks();
+            resetTailResync();
+            if (head_) {
+                head_->reset();
             }
+            decorrelator_.reset();
         }
         lastTargetMix_ = targetMix;
 
-        // Only swap wet blocks on boundaries to avoid mid-block discontinuities.
-        if (blockPos_ == 0) {
-            if (nextSeq_ >= kOutputDelayBlocks) {
-                outputSeq_ = nextSeq_ - kOutputDelayBlocks;
-                haveOutputSeq_ = true;
-                playDryBlock_ =
-                    dryHistory_[static_cast<std::size_t>(outputSeq_ & (kDryHistoryBlocks - 1))];
-                havePlayDryBlock_ = (playDryBlock_.seq == outputSeq_);
-            } else {
-                haveOutputSeq_ = false;
-                havePlayDryBlock_ = false;
-            }
-
-            const std::uint64_t expectedSeq =
-                havePlayDryBlock_ ? playDryBlock_.seq : std::numeric_limits<std::uint64_t>::max();
-            haveWetBlock_ = false;
-            if (expectedSeq == std::numeric_limits<std::uint64_t>::max()) {
-                // Not enough history yet; don't drain the queue.
-            } else if (bufferedWet_ && bufferedWet_->seq == expectedSeq) {
-                wetBlock_ = *bufferedWet_;
-                bufferedWet_.reset();
-                haveWetBlock_ = true;
+        std::size_t offset = 0;
+        while (offset < frames) {
+            const std::size_t count = std::min(frames - offset, blockSize_ - blockPos_);
+            if (blockPos_ == 0) {
+                // The history the head warms from ends with this sample.
+                recordWarmHistory(input + offset, 1);
+                beginBlock();
+                recordWarmHistory(input + offset + 1, count - 1);
             } else {
-                StereoBlock candidate{};
-                while (wetQueue_.pop(candidate)) {
-                    if (candidate.seq < expectedSeq) {
-                        continue;
-                    }
-                    if (candidate.seq == expectedSeq) {
-                        wetBlock_ = candidate;
-                        haveWetBlock_ = true;
-                        break;
-                    }
-                    bufferedWet_ = candidate;
-                    break;
-                }
+                recordWarmHistory(input + offset, count);
             }
+            mixSegment(input + offset, dryL + offset, dryR + offset, outL + offset,
+                       outR + offset, count, targetMix, split, offset);
+            std::copy(input + offset, input + offset + count,
+                      dryBlock_->samples.begin() + static_cast<std::ptrdiff_t>(blockPos_));
+            blockPos_ += count;
+            if (blockPos_ == blockSize_) {
+                submitDryBlock();
+            }
+            offset += count;
+        }
+    }
+
+private:
+    // Block boundary, audio thread. Only here are wet blocks swapped, so the
+    // tail never jumps mid-block.
+    void beginBlock() {
+        inlineTail_ = UseInlineTail();
+        if (inlineTail_) {
+            renderTailInline();
         }
-        if (haveWetBlock_) {
-            wetL = wetBlock_.samples[blockPos_ * 2];
-            wetR = wetBlock_.samples[blockPos_ * 2 + 1];
+        adoptPendingHead();
+        if (head_) {
+            int irIndex = requestedIrIndex_.load(std::memory_order_relaxed);
+            if (irIndex >= UserIrIndex()) {
+                irIndex = head_->irCount() > UserIrIndex() ? UserIrIndex() : 0;
+            }
+            if (irIndex != headIrIndex_) {
+                head_->setIrIndex(irIndex);
+                headIrIndex_ = irIndex;
+            }
+            if (warmStartPending_) {
+                primeHeadFromHistory();
+            }
         }
+        warmStartPending_ = false;
 
-        const float dryOut =
-            havePlayDryBlock_ ? playDryBlock_.samples[blockPos_] : input;
-        outL = dryOut * (1.0f - currentMix_) + wetL * currentMix_;
-        outR = dryOut * (1.0f - currentMix_) + wetR * currentMix_;
+        takeWetBlocks();
+        // Filled in place; a full queue leaves it in dryAccum_ until the
+        // block is handed over.
+        DryBlock* slot = dryQueue_.writeSlot();
+        dryBlock_ = slot ? slot : &dryAccum_;
+    }
 
-        // Input path: accumulate dry into fixed blocks and enqueue for worker.
-        dryAccum_.samples[blockPos_] = input;
-        ++blockPos_;
-        if (blockPos_ >= kBlockSize) {
-            dryAccum_.seq = nextSeq_++;
-            if (dryQueue_.push(dryAccum_)) {
-                pendingDryBlocks_.fetch_add(1, std::memory_order_release);
-                dataReady_.notify_one();
+    // `count` samples from blockPos_ on, all within one block; `at` is
+    // their offset into the Split buffers.
+    void mixSegment(const float* input, const float* dryL, const float* dryR, float* outL,
+                    float* outR, std::size_t count, float targetMix, const Split* split,
+                    std::size_t at) {
+        // Zero-latency head on the audio thread; the dry path is not delayed.
+        float* headL = headWetL_.data();
+        float* headR = headWetR_.data();
+        bool decorrelate = false;
+        if (head_) {
+            for (std::size_t i = 0; i < count; ++i) {
+                head_->process(input[i], headL[i], headR[i]);
+                headL[i] *= dsp::ConvolutionReverb::kWetLevel;
+                headR[i] *= dsp::ConvolutionReverb::kWetLevel;
+            }
+            decorrelate = !head_->crossfading() && !head_->isStereo(head_->irIndex());
+        } else {
+            std::fill(headL, headL + count, 0.0f);
+            std::fill(headR, headR + count, 0.0f);
+        }
+        decorrelator_.processBlock(headL, headR, decorrelate, headL, headR, count);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::size_t pos = blockPos_ + i;
+            currentMix_ += (targetMix - currentMix_) * mixSmoothingAlpha_;
+
+            float tailL = 0.0f;
+            float tailR = 0.0f;
+            if (wetBlock_) {
+                tailL = wetBlock_->samples[pos * 2];
+                tailR = wetBlock_->samples[pos * 2 + 1];
+                if (fadeBlock_) {
+                    // Shrinking the delay skips one tail block; crossfade across it.
+                    const float t = static_cast<float>(pos + 1) / static_cast<float>(blockSize_);
+                    tailL = fadeBlock_->samples[pos * 2] * (1.0f - t) + tailL * t;
+                    tailR = fadeBlock_->samples[pos * 2 + 1] * (1.0f - t) + tailR * t;
+                }
+                heldTailL_ = tailL;
+                heldTailR_ = tailR;
+                tailGain_ = std::min(1.0f, tailGain_ + kResyncStep);
+            } else {
+                // Late block: ramp the last tail sample out instead of cutting it.
+                tailL = heldTailL_;
+                tailR = heldTailR_;
+                tailGain_ = std::max(0.0f, tailGain_ - kResyncStep);
+            }
+            const float wetL = tailL * tailGain_ + headL[i];
+            const float wetR = tailR * tailGain_ + headR[i];
+
+            outL[i] = dryL[i] * (1.0f - currentMix_) + wetL * currentMix_;
+            outR[i] = dryR[i] * (1.0f - currentMix_) + wetR * currentMix_;
+            if (split) {
+                split->dryGain[at + i] = 1.0f - currentMix_;
+                split->wetL[at + i] = wetL * currentMix_;
+                split->wetR[at + i] = wetR * currentMix_;
             }
-            dryHistory_[static_cast<std::size_t>(dryAccum_.seq & (kDryHistoryBlocks - 1))] =
-                dryAccum_;
-            blockPos_ = 0;
-            updateOfflineDetection();
         }
     }
 
-private:
-    static constexpr std::size_t kBlockSize = 256;
-    static constexpr std::size_t kFftSize = 512;
-    static constexpr std::size_t kLateBlockSize = 1024;
-    static constexpr std::size_t kLateFftSize = 2048;
-    static constexpr std::size_t kIrEarlySamples = kLateBlockSize;  // 1024
-    // Strategy A (fixed latency): delay output by a few blocks to absorb worker jitter
-    // and ensure wet blocks arrive in time.
+    // A full block of dry input goes to the tail (rendered at the next
+    // boundary when inline).
+    void submitDryBlock() {
+        dryBlock_->seq = nextSeq_++;
+        bool queued = false;
+        if (dryBlock_ != &dryAccum_) {
+            dryQueue_.commit();
+            queued = true;
+        } else {
+            queued = dryQueue_.push(dryAccum_);  // room may have freed up since
+        }
+        if (queued) {
+            pendingDryBlocks_.fetch_add(1, std::memory_order_release);
+            RaiseHighWater(dryHighWater_, dryQueue_.size());
+            if (!inlineTail_) {
+                wakeWorker();
+            }
+        } else {
+            droppedDryBlocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+        dryBlock_ = &dryAccum_;
+        blockPos_ = 0;
+        updateOfflineDetection();
+    }
+
+    // The worker's wet tail is consumed a few blocks late to absorb its jitter.
+    // The IR head covering those blocks runs on the audio thread
+    // (dsp::ConvolutionHead), so neither dry nor early wet is delayed. Blocks
+    // are the partition layout's base (256 unless set otherwise), so the
+    // head is 1536 samples by default.
     static constexpr std::size_t kOutputDelayBlocks = 6;
-    static constexpr std::size_t kDryHistoryBlocks = 64;  // power-of-two
-    static constexpr std::size_t kQueueCapacity = 256;  // blocks (power-of-two)
+    // Late tail blocks grow the delay (the tail then trails the head by the
+    // excess); a long run with spare queued blocks shrinks it back
+    // (AdaptiveTailDelay).
+    static constexpr std::size_t kMaxOutputDelayBlocks = 12;
+    // Worker spin before parking, in pause instructions.
+    static constexpr std::size_t kMinWorkerSpin = 64;
+    static constexpr std::size_t kMaxWorkerSpin = 4096;
+    static constexpr std::size_t kDelayShrinkWindowBlocks = 2048;  // ~12s at 44.1k
+    static constexpr std::size_t kResyncFadeSamples = 64;
+    static constexpr float kResyncStep = 1.0f / static_cast<float>(kResyncFadeSamples);
+    static constexpr std::size_t kIrFadeBlocks = 16;  // matches ConvolutionReverb
+    // Queues hold the same time at any block size: 256 blocks of 256.
+    static constexpr std::size_t kQueueFrames = 65536;
+    static constexpr std::size_t kNetworkChunkFrames = 256;
+
+    // Helpers for the tail's late stages: none below four cores, since the
+    // render thread and the worker already hold two.
+    static std::size_t TailHelperThreads() {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores >= 8 ? 2 : (cores >= 4 ? 1 : 0);
+    }
 
-    template <typename T, std::size_t Capacity>
+    static void RunOnTailPool(void* pool, dsp::ParallelJob job, void* context, std::size_t jobs) {
+        static_cast<VoiceRenderPool*>(pool)->run(job, context, jobs);
+    }
+
+    // job(0..jobs-1) on `pool`, or inline without one. Kernel builds get the
+    // tail pool only under tailMutex_, between tail blocks.
+    template <typename Job>
+    static void RunBuildJobs(VoiceRenderPool* pool, std::size_t jobs, Job& job) {
+        if (!pool) {
+            for (std::size_t i = 0; i < jobs; ++i) {
+                job(i);
+            }
+            return;
+        }
+        pool->run([](void* context, std::size_t i) { (*static_cast<Job*>(context))(i); }, &job,
+                  jobs);
+    }
+
+    // Single writer per counter, so a plain load/store suffices.
+    static void RaiseHighWater(std::atomic<std::size_t>& mark, std::size_t depth) {
+        if (depth > mark.load(std::memory_order_relaxed)) {
+            mark.store(depth, std::memory_order_relaxed);
+        }
+    }
+
+    // Slots are sized once, up front: copying a block into one (or out into
+    // a block of the same size) never allocates.
+    template <typename T>
     class SpscRing {
     public:
-        static_assert(Capacity >= 2, "Capacity too small");
-        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be power of two");
+        // `capacity` must be a power of two, at least 2.
+        SpscRing(std::size_t capacity, const T& prototype)
+            : buffer_(capacity, prototype), mask_(capacity - 1) {}
+
+        std::size_t capacity() const { return buffer_.size(); }
 
         bool push(const T& value) {
             const std::size_t head = head_.load(std::memory_order_relaxed);
             const std::size_t tail = tail_.load(std::memory_order_acquire);
-            if ((head - tail) >= Capacity) {
+            if ((head - tail) >= buffer_.size()) {
                 return false;
             }
-            buffer_[head & (Capacity - 1)] = value;
+            buffer_[head & mask_] = value;
             head_.store(head + 1, std::memory_order_release);
             return true;
         }
 
-        bool pop(T& out) {
+        // Producer side: the slot push() would fill, written in place and
+        // then published with commit(); null if full.
+        T* writeSlot() {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            const std::size_t tail = tail_.load(std::memory_order_acquire);
+            if ((head - tail) >= buffer_.size()) {
+                return nullptr;
+            }
+            return &buffer_[head & mask_];
+        }
+
+        void commit() {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer side: the entry `offset` places from the front, left
+        // queued (the producer can't reuse it until discarded); null if
+        // fewer are queued.
+        const T* peek(std::size_t offset = 0) const {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (head_.load(std::memory_order_acquire) - tail <= offset) {
+                return nullptr;
+            }
+            return &buffer_[(tail + offset) & mask_];
+        }
+
+        // Drops the front entry.
+        bool discard() {
             const std::size_t tail = tail_.load(std::memory_order_relaxed);
-            const std::size_t head = head_.load(std::memory_order_acquire);
-            if (head == tail) {
+            if (head_.load(std::memory_order_acquire) == tail) {
                 return false;
             }
-            out = buffer_[tail & (Capacity - 1)];
             tail_.store(tail + 1, std::memory_order_release);
             return true;
         }
 
+        // Consumer side: blocks ready to pop.
+        std::size_t size() const {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_relaxed);
+        }
+
     private:
-        std::array<T, Capacity> buffer_{};
+        std::vector<T> buffer_;
+        std::size_t mask_ = 0;
         std::atomic<std::size_t> head_{0};
         std::atomic<std::size_t> tail_{0};
     };
 
     struct DryBlock {
+        explicit DryBlock(std::size_t frames) : samples(frames, 0.0f) {}
         std::uint64_t seq = 0;
-        std::array<float, kBlockSize> samples{};
+        std::vector<float> samples;
     };
 
     struct StereoBlock {
+        explicit StereoBlock(std::size_t frames) : samples(frames * 2, 0.0f) {}
         std::uint64_t seq = 0;
-        std::array<float, kBlockSize * 2> samples{};
+        std::vector<float> samples;  // interleaved
     };
 
-    static_assert(kOutputDelayBlocks < kDryHistoryBlocks,
-                  "Output delay must fit in dry history");
-
-    static std::vector<float> ResampleLinear(const float* src,
-                                             std::size_t srcCount,
-                                             int srcRate,
-                                             int dstRate) {
-        if (!src || srcCount == 0 || srcRate <= 0 || dstRate <= 0) {
-            return {};
-        }
-        if (srcRate == dstRate) {
-            return std::vector<float>(src, src + srcCount);
-        }
-        const double ratio = static_cast<double>(dstRate) / static_cast<double>(srcRate);
-        const std::size_t dstCount =
-            std::max<std::size_t>(1, static_cast<std::size_t>(std::llround(srcCount * ratio)));
-        std::vector<float> dst(dstCount, 0.0f);
-        for (std::size_t i = 0; i < dstCount; ++i) {
-            const double srcPos = static_cast<double>(i) / ratio;
-            const std::size_t idx = static_cast<std::size_t>(std::floor(srcPos));
-            const std::size_t idx1 = std::min(srcCount - 1, idx + 1);
-            const float t = static_cast<float>(srcPos - static_cast<double>(idx));
-            const float a = src[std::min(idx, srcCount - 1)];
-            const float b = src[idx1];
-            dst[i] = a + (b - a) * t;
-        }
-        return dst;
-    }
-
-    void rebuildKernels(double sampleRate,
-                        std::vector<dsp::StereoConvolutionKernel>& kernelsOut) {
-        kernelsOut.clear();
-        const auto& list = dsp::RoomIrLibrary::list();
-        kernelsOut.reserve(list.size());
-
-        for (std::size_t i = 0; i < list.size(); ++i) {
-            const auto ir = dsp::RoomIrLibrary::samples(static_cast<int>(i));
-            const bool stereo = (ir.channels == 2 && ir.right);
-            std::vector<float> resampledL = ResampleLinear(ir.left, ir.frameCount, ir.sampleRate,
-                                                          static_cast<int>(std::lround(sampleRate)));
-            std::vector<float> resampledR;
-            if (stereo) {
-                resampledR = ResampleLinear(ir.right, ir.frameCount, ir.sampleRate,
-                                            static_cast<int>(std::lround(sampleRate)));
-            }
-            if (stereo && resampledR.size() != resampledL.size()) {
-                const std::size_t n = std::min(resampledL.size(), resampledR.size());
-                resampledL.resize(n);
-                resampledR.resize(n);
-            }
-
-            bool treatStereoAsMono = false;
-            if (stereo && !resampledR.empty()) {
-                // Some "stereo" IRs are dual-mono (L==R). In that case, treat it as mono
-                // to keep the classic stereo decorrelation path and cut CPU in half.
-                const std::size_t frames = std::min(resampledL.size(), resampledR.size());
-                double energy = 0.0;
-                double diffEnergy = 0.0;
-                for (std::size_t f = 0; f < frames; ++f) {
-                    const double l = static_cast<double>(resampledL[f]);
-                    const double r = static_cast<double>(resampledR[f]);
-                    energy += 0.5 * (l * l + r * r);
-                    const double d = l - r;
-                    diffEnergy += d * d;
-                }
-                if (energy <= std::numeric_limits<double>::min()) {
-                    treatStereoAsMono = true;
-                } else {
-                    const double rms = std::sqrt(energy / static_cast<double>(frames));
-                    const double diffRms = std::sqrt(diffEnergy / static_cast<double>(frames));
-                    treatStereoAsMono = (diffRms / std::max(1e-12, rms)) < 1e-3;  // ~ -60dB
-                }
-            }
+    static_assert(kOutputDelayBlocks * StringSynthEngine::kMinRoomBlockFrames %
+                          dsp::ConvolutionHead::kBlockSize ==
+                      0,
+                  "IR head must end on a head block boundary");
 
-            dsp::StereoConvolutionKernel kernel;
-            const std::size_t earlyCount = std::min(kIrEarlySamples, resampledL.size());
-            std::vector<float> earlyL(resampledL.begin(), resampledL.begin() + static_cast<std::ptrdiff_t>(earlyCount));
-            kernel.left = dsp::PartitionedConvolver::buildKernelFromIr(
-                earlyL, kBlockSize, kFftSize);
-            if (resampledL.size() > earlyCount) {
-                std::vector<float> lateL(resampledL.begin() + static_cast<std::ptrdiff_t>(earlyCount), resampledL.end());
-                kernel.leftLate = dsp::PartitionedConvolver::buildKernelFromIr(
-                    lateL, kLateBlockSize, kLateFftSize);
-                kernel.hasLate = !kernel.leftLate.partitions.empty();
-            }
-            if (stereo && !treatStereoAsMono) {
-                const std::size_t earlyCountR = std::min(kIrEarlySamples, resampledR.size());
-                std::vector<float> earlyR(resampledR.begin(), resampledR.begin() + static_cast<std::ptrdiff_t>(earlyCountR));
-                kernel.right = dsp::PartitionedConvolver::buildKernelFromIr(
-                    earlyR, kBlockSize, kFftSize);
-                if (resampledR.size() > earlyCountR) {
-                    std::vector<float> lateR(resampledR.begin() + static_cast<std::ptrdiff_t>(earlyCountR), resampledR.end());
-                    kernel.rightLate = dsp::PartitionedConvolver::buildKernelFromIr(
-                        lateR, kLateBlockSize, kLateFftSize);
-                    kernel.hasLate = kernel.hasLate || !kernel.rightLate.partitions.empty();
-                }
-                kernel.isStereo = true;
-            }
-            kernelsOut.push_back(std::move(kernel));
-        }
+    static_assert(kOutputDelayBlocks == StringSynthEngine::kRoomLeadBlocks);
+
+    // Power of two, since the block is.
+    static std::size_t QueueBlocks(std::size_t blockSize) { return kQueueFrames / blockSize; }
+
+    // Both rings: mono dry blocks in, interleaved stereo wet blocks out.
+    static std::size_t QueueBytes(std::size_t blockSize) {
+        return QueueBlocks(blockSize) *
+               (sizeof(DryBlock) + sizeof(StereoBlock) + 3 * blockSize * sizeof(float));
     }
 
-    void updateOfflineDetection() {
-        if (offlineDetected_) {
-            useSynchronous_ = true;
-            return;
-        }
+    // Samples the head of every IR covers: the lead, in base blocks.
+    static std::size_t HeadSamples() {
+        return kOutputDelayBlocks * RoomPartitionLayout().baseBlockSize();
+    }
 
-        processedFramesForTiming_ += kBlockSize;
-        const auto now = std::chrono::steady_clock::now();
-        const auto elapsed = now - timingStart_;
-        const auto elapsedSeconds =
-            std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
-        if (elapsedSeconds <= 0.0) {
-            return;
-        }
-        const double framesPerSecond =
-            static_cast<double>(processedFramesForTiming_) / elapsedSeconds;
-        const double sr =
-            std::max(1.0, requestedSampleRate_.load(std::memory_order_relaxed));
-        const double speedRatio = framesPerSecond / sr;
-        if (speedRatio > 8.0) {
-            ++fastBlockStreak_;
-        } else {
-            fastBlockStreak_ = 0;
-        }
-        if (fastBlockStreak_ >= 2) {
-            offlineDetected_ = true;
-            useSynchronous_ = true;
+    // Base blocks of 256 behind the zero-latency head; by default 1024 and
+    // 4096 tail stages spread their work over 4 and 16 blocks. The first
+    // call fixes the layout, and with it the block size, for the process, so
+    // every kernel and reverb built afterwards agrees on it.
+    static const dsp::PartitionLayout& RoomPartitionLayout() {
+        if (layoutFixed_.load(std::memory_order_acquire)) {
+            return LayoutStorage();
         }
+        std::lock_guard<std::mutex> lock(LayoutMutex());
+        layoutFixed_.store(true, std::memory_order_release);
+        return LayoutStorage();
     }
 
-    void syncApplyPendingState() {
-        const std::uint64_t srSeq = sampleRateSeq_.load(std::memory_order_acquire);
-        if (srSeq != syncSampleRateSeq_) {
-            const double requested = requestedSampleRate_.load(std::memory_order_acquire);
-            if (requested > 0.0) {
-                syncSampleRate_ = requested;
-                rebuildKernels(syncSampleRate_, syncKernels_);
-                syncReverb_.setMix(1.0f);  // wet-only; mix is applied on the audio thread.
-                syncReverb_.setSampleRate(syncSampleRate_);
-                syncReverb_.setIrKernels(syncKernels_);
-                syncBuiltOnce_ = true;
-                builtOnce_.store(true, std::memory_order_release);
+    // Library IR `index` with dual-mono "stereo" files (L==R) reduced to mono,
+    // which keeps the classic decorrelation path and halves the CPU. Each IR
+    // is checked the first time it is used, so packed IRs stay undecoded
+    // until then.
+    static dsp::RoomIrLibrary::Samples SourceIr(int index) {
+        struct DualMono {
+            std::once_flag once;
+            bool value = false;
+        };
+        static std::vector<DualMono> dualMono(dsp::RoomIrLibrary::list().size());
+
+        auto ir = dsp::RoomIrLibrary::samples(index);
+        if (ir.channels != 2 || !ir.right || ir.frameCount == 0) {
+            ir.channels = 1;
+            ir.right = nullptr;
+            return ir;
+        }
+        auto& flag = dualMono[static_cast<std::size_t>(index)];
+        std::call_once(flag.once, [&] {
+            double energy = 0.0;
+            double diffEnergy = 0.0;
+            for (std::size_t f = 0; f < ir.frameCount; ++f) {
+                const double l = static_cast<double>(ir.left[f]);
+                const double r = static_cast<double>(ir.right[f]);
+                energy += 0.5 * (l * l + r * r);
+                const double d = l - r;
+                diffEnergy += d * d;
             }
-            syncSampleRateSeq_ = srSeq;
-            syncIrIndex_ = -1;
+            if (energy <= std::numeric_limits<double>::min()) {
+                flag.value = true;
+            } else {
+                const double frames = static_cast<double>(ir.frameCount);
+                const double rms = std::sqrt(energy / frames);
+                const double diffRms = std::sqrt(diffEnergy / frames);
+                flag.value = (diffRms / std::max(1e-12, rms)) < 1e-3;  // ~ -60dB
+            }
+        });
+        if (flag.value) {
+            ir.channels = 1;
+            ir.right = nullptr;
         }
+        return ir;
+    }
 
-        const std::uint64_t rstSeq = resetSeq_.load(std::memory_order_acquire);
-        if (rstSeq != syncResetSeq_) {
-            syncReverb_.reset();
-            syncResetSeq_ = rstSeq;
-            syncIrIndex_ = -1;
+    // Audio thread: whether AlgorithmicFits() is ready to read. Until it is,
+    // the worker is asked to fit them and the network keeps its current
+    // settings; offline, the fits are made here so the render stays
+    // deterministic.
+    bool fitsReady() {
+        if (fitsReady_.load(std::memory_order_acquire)) {
+            return true;
         }
-        const int irIndex = requestedIrIndex_.load(std::memory_order_relaxed);
-        if (irIndex != syncIrIndex_) {
-            syncReverb_.setIrIndex(irIndex);
-            syncIrIndex_ = irIndex;
+        if (UseInlineTail()) {
+            const RealtimeAllowance offline;
+            AlgorithmicFits();
+            fitsReady_.store(true, std::memory_order_release);
+            return true;
         }
+        // Every block until they land, so a missed wakeup only delays them.
+        fitsWanted_.store(true, std::memory_order_release);
+        wakeWorker();
+        return false;
     }
 
-    void syncProcess(float input, float& outL, float& outR) {
-        syncApplyPendingState();
-        // Output wet-only; dry/mix is applied by the caller.
-        syncReverb_.processSample(input, outL, outR);
+    // Network settings fitted to each library IR at its own rate.
+    static const std::vector<dsp::FdnReverb::Settings>& AlgorithmicFits() {
+        static const std::vector<dsp::FdnReverb::Settings> fits = [] {
+            std::vector<dsp::FdnReverb::Settings> settings;
+            for (std::size_t i = 0; i < dsp::RoomIrLibrary::list().size(); ++i) {
+                const auto ir = SourceIr(static_cast<int>(i));
+                settings.push_back(dsp::FdnReverb::FitToIr(ir.left, ir.right, ir.frameCount,
+                                                           static_cast<double>(ir.sampleRate)));
+            }
+            return settings;
+        }();
+        return fits;
     }
 
-    void startWorker() {
-        if (running_.exchange(true, std::memory_order_acq_rel)) {
-            return;
+    static dsp::PartitionLayout& LayoutStorage() {
+        static dsp::PartitionLayout layout =
+            dsp::PartitionLayout::FromBlockSizes({StringSynthEngine::kRoomBlockFrames, 1024, 4096});
+        return layout;
+    }
+
+    static std::mutex& LayoutMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // Longest IR in the library at `sampleRate`.
+    static std::size_t LibraryIrFrames(int sampleRate) {
+        std::size_t maxFrames = 0;
+        for (const auto& ir : dsp::RoomIrLibrary::list()) {
+            maxFrames = std::max(maxFrames, dsp::PolyphaseResampler::OutputFrames(ir.frameCount, ir.sampleRate, sampleRate));
         }
-        worker_ = std::thread(&RoomProcessor::workerLoop, this);
+        return maxFrames;
     }
 
-    void stopWorker() {
-        if (!running_.exchange(false, std::memory_order_acq_rel)) {
-            return;
+    // The same, less the head when tailOnly.
+    static std::size_t MaxIrFrames(int sampleRate, bool tailOnly) {
+        const std::size_t maxFrames = LibraryIrFrames(sampleRate);
+        return tailOnly ? maxFrames - std::min(maxFrames, HeadSamples()) : maxFrames;
+    }
+
+    // EDC level below which RoomQuality cuts the IR; 0 keeps all of it.
+    static constexpr double TrimDb(RoomQuality quality) {
+        switch (quality) {
+        case RoomQuality::Full:
+            return 0.0;
+        case RoomQuality::High:
+            return -80.0;
+        case RoomQuality::Medium:
+            return -60.0;
+        case RoomQuality::Low:
+            return -40.0;
         }
-        dataReady_.notify_one();
-        if (worker_.joinable()) {
-            worker_.join();
+        return 0.0;
+    }
+
+    // Frames of `ir` (at its own rate) before its energy decay curve, the
+    // energy still to come, falls `trimDb` below the total. The whole IR when
+    // it never gets there.
+    static std::size_t EdcTrimFrames(const dsp::RoomIrLibrary::Samples& ir, double trimDb) {
+        if (trimDb >= 0.0 || !ir.left || ir.frameCount == 0) {
+            return ir.frameCount;
         }
+        const auto energyAt = [&ir](std::size_t f) {
+            const double l = static_cast<double>(ir.left[f]);
+            const double r = ir.right ? static_cast<double>(ir.right[f]) : l;
+            return l * l + r * r;
+        };
+        double total = 0.0;
+        for (std::size_t f = 0; f < ir.frameCount; ++f) {
+            total += energyAt(f);
+        }
+        const double floor = total * std::pow(10.0, trimDb / 10.0);
+        double remaining = total;
+        for (std::size_t f = 0; f < ir.frameCount; ++f) {
+            if (remaining <= floor) {
+                return f;
+            }
+            remaining -= energyAt(f);
+        }
+        return ir.frameCount;
     }
 
-    void workerLoop() {
-        dsp::ScopedDenormalsDisable denormalsGuard;
+    // Drops the partitions that start at or past `frames`. The cut lands on
+    // a partition boundary at or after the trim point, so what it removes is
+    // below the threshold already.
+    static void TrimKernel(dsp::StereoConvolutionKernel& kernel, std::size_t frames) {
+        const auto& layout = RoomPartitionLayout();
+        const auto cut = [&layout, frames](dsp::ConvolutionKernel& k, std::size_t stage) {
+            k.partitionCount = std::min(k.partitionCount, layout.partitionCount(stage, frames));
+        };
+        cut(kernel.left, 0);
+        cut(kernel.right, 0);
+        for (std::size_t s = 0; s < kernel.tailLeft.size(); ++s) {
+            cut(kernel.tailLeft[s], s + 1);
+        }
+        for (std::size_t s = 0; s < kernel.tailRight.size(); ++s) {
+            cut(kernel.tailRight[s], s + 1);
+        }
+    }
 
-        double currentSampleRate = 44100.0;
-        std::uint64_t currentSampleRateSeq = 0;
-        std::uint64_t currentResetSeq = 0;
-        int currentIrIndex = -1;
+    // Kernels for one IR. With tailOnly the first HeadSamples() are left to the
+    // ConvolutionHead and the kernels cover only the rest. Spectra generated at
+    // build time are used as-is when they match; `quality` then trims either.
+    static dsp::StereoConvolutionKernel BuildIrKernel(int index, int sampleRate, bool tailOnly,
+                                                      RoomQuality quality,
+                                                      VoiceRenderPool* pool = nullptr) {
+        auto kernel = BuildFullIrKernel(index, sampleRate, tailOnly, pool);
+        const auto ir = SourceIr(index);
+        const std::size_t trimmed = EdcTrimFrames(ir, TrimDb(quality));
+        if (trimmed < ir.frameCount) {
+            const std::size_t frames =
+                dsp::PolyphaseResampler::OutputFrames(trimmed, ir.sampleRate, sampleRate);
+            const std::size_t skip = tailOnly ? HeadSamples() : 0;
+            // Keep a partition so the IR still counts as built.
+            TrimKernel(kernel, std::max(frames, skip + 1) - skip);
+        }
+        return kernel;
+    }
 
-        // Worker produces wet-only blocks.
-        reverb_.setMix(1.0f);
+    // A kernel counted under Kernels for as long as any reverb or cache
+    // shares it, however many do.
+    static dsp::SharedConvolutionKernel ShareKernel(dsp::StereoConvolutionKernel kernel) {
+        struct Counted {
+            explicit Counted(dsp::StereoConvolutionKernel k) : kernel(std::move(k)) {}
+            dsp::StereoConvolutionKernel kernel;
+            TrackedBytes bytes{MemoryCategory::Kernels, kernel.heapBytes()};
+        };
+        auto counted = std::make_shared<const Counted>(std::move(kernel));
+        return dsp::SharedConvolutionKernel(counted, &counted->kernel);
+    }
 
-        auto applyPendingState = [&] {
-            const std::uint64_t srSeq = sampleRateSeq_.load(std::memory_order_acquire);
-            if (srSeq != currentSampleRateSeq) {
-                const double requested =
-                    requestedSampleRate_.load(std::memory_order_acquire);
-                if (requested > 0.0) {
-                    currentSampleRate = requested;
-                    rebuildKernels(currentSampleRate, kernels_);
-                    reverb_.setMix(1.0f);
-                    reverb_.setSampleRate(currentSampleRate);
-                    reverb_.setIrKernels(kernels_);
-                    builtOnce_.store(true, std::memory_order_release);
+    // Library IR kernels shared by every RoomProcessor in the process: each
+    // is built once per IR, rate, partition layout, head split and quality.
+    // The map only holds weak references, so a kernel is freed once no
+    // reverb or rate cache uses it.
+    static dsp::SharedConvolutionKernel SharedIrKernel(int index, int sampleRate, bool tailOnly,
+                                                       RoomQuality quality,
+                                                       VoiceRenderPool* pool = nullptr) {
+        struct Key {
+            int index = 0;
+            int sampleRate = 0;
+            bool tailOnly = false;
+            RoomQuality quality = RoomQuality::Full;
+            std::vector<std::size_t> blockSizes;
+            auto operator<=>(const Key&) const = default;
+        };
+        static std::mutex mutex;
+        static std::map<Key, std::weak_ptr<const dsp::StereoConvolutionKernel>> kernels;
+
+        const Key key{index, sampleRate, tailOnly, quality, RoomPartitionLayout().blockSizes};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = kernels.find(key);
+            if (it != kernels.end()) {
+                if (auto kernel = it->second.lock()) {
+                    return kernel;
                 }
-                currentSampleRateSeq = srSeq;
-                // Force re-apply for the new instance/state.
-                currentIrIndex = -1;
             }
+        }
+        // Built outside the lock so other rooms' builds are not held up; when
+        // two race on the same key the first one stored wins.
+        dsp::SharedConvolutionKernel built =
+            ShareKernel(BuildIrKernel(index, sampleRate, tailOnly, quality, pool));
+        std::lock_guard<std::mutex> lock(mutex);
+        std::erase_if(kernels, [](const auto& entry) { return entry.second.expired(); });
+        auto& slot = kernels[key];
+        if (auto kernel = slot.lock()) {
+            return kernel;
+        }
+        slot = built;
+        return built;
+    }
 
-            const std::uint64_t rstSeq = resetSeq_.load(std::memory_order_acquire);
-            if (rstSeq != currentResetSeq) {
-                reverb_.reset();
-                currentResetSeq = rstSeq;
-                // Re-apply params after reset.
-                currentIrIndex = -1;
-            }
-            const int irIndex = requestedIrIndex_.load(std::memory_order_relaxed);
-            if (irIndex != currentIrIndex) {
-                reverb_.setIrIndex(irIndex);
-                currentIrIndex = irIndex;
-            }
+    // BuildIrKernel before trimming. With a pool the channels resample, and
+    // then the stages transform, as parallel jobs.
+    static dsp::StereoConvolutionKernel BuildFullIrKernel(int index, int sampleRate,
+                                                          bool tailOnly,
+                                                          VoiceRenderPool* pool = nullptr) {
+        const auto ir = SourceIr(index);
+        auto precomputed = dsp::RoomIrLibrary::precomputedKernel(
+            index, sampleRate, RoomPartitionLayout(), tailOnly ? HeadSamples() : 0);
+        if (!precomputed.left.empty() && precomputed.isStereo == (ir.right != nullptr)) {
+            return precomputed;
+        }
+        const dsp::PolyphaseResampler resampler(ir.sampleRate, sampleRate);
+        std::array<std::vector<float>, 2> channels;
+        auto resample = [&](std::size_t channel) {
+            channels[channel] = resampler.process(channel == 0 ? ir.left : ir.right, ir.frameCount);
         };
+        RunBuildJobs(pool, ir.right ? 2 : 1, resample);
+        const std::vector<float>& left = channels[0];
+        const std::vector<float>& right = channels[1];
+        const std::size_t skip = tailOnly ? std::min(left.size(), HeadSamples()) : 0;
+        return RoomPartitionLayout().buildKernel(
+            left.data() + skip, ir.right ? right.data() + skip : nullptr, left.size() - skip,
+            pool ? &RunOnTailPool : nullptr, pool);
+    }
 
-        DryBlock dry{};
-        std::array<float, kBlockSize> wetL{};
-        std::array<float, kBlockSize> wetR{};
-        while (running_.load(std::memory_order_acquire)) {
-            if (!dryQueue_.pop(dry)) {
-                std::unique_lock<std::mutex> lock(cvMutex_);
-                dataReady_.wait(lock, [&] {
-                    return !running_.load(std::memory_order_acquire) ||
-                           pendingDryBlocks_.load(std::memory_order_acquire) > 0;
-                });
-                continue;
-            }
-            pendingDryBlocks_.fetch_sub(1, std::memory_order_acq_rel);
+    // A user IR at its own rate, as RoomIrLibrary::Samples.
+    struct UserIrSource {
+        int sampleRate = 0;
+        std::vector<float> left;
+        std::vector<float> right;  // empty if mono
+        TrackedBytes bytes{MemoryCategory::Samples};
+
+        dsp::RoomIrLibrary::Samples samples() const {
+            dsp::RoomIrLibrary::Samples ir;
+            ir.sampleRate = sampleRate;
+            ir.channels = right.empty() ? 1 : 2;
+            ir.left = left.data();
+            ir.right = right.empty() ? nullptr : right.data();
+            ir.frameCount = left.size();
+            return ir;
+        }
+    };
 
-            applyPendingState();
+    // Kernel, head and network fit for the user IR at one rate and quality,
+    // built on the loader thread and adopted by the tail at a block boundary.
+    struct UserIrBuild {
+        int sampleRate = 0;
+        RoomQuality quality = RoomQuality::Full;
+        std::size_t tailFrames = 0;
+        dsp::StereoConvolutionKernel kernel;
+        std::unique_ptr<dsp::ConvolutionHead> head;
+        dsp::FdnReverb::Settings fit;
+    };
 
-            StereoBlock wet{};
-            wet.seq = dry.seq;
-            reverb_.processBlockWet(dry.samples.data(), wetL.data(), wetR.data());
-            for (std::size_t i = 0; i < kBlockSize; ++i) {
-                wet.samples[i * 2] = wetL[i];
-                wet.samples[i * 2 + 1] = wetR[i];
+    static constexpr double kMaxUserIrSeconds = 10.0;
+
+    // Library IRs plus the user slot.
+    static std::size_t IrSlotCount() { return dsp::RoomIrLibrary::list().size() + 1; }
+
+    // IR heads are short, so all of them are built up front (only their first
+    // HeadSamples() are resampled). A loaded user IR takes the slot after the
+    // library's. With a pool each IR resamples as its own job.
+    static std::unique_ptr<dsp::ConvolutionHead> BuildHead(int sampleRate,
+                                                           const UserIrSource* user,
+                                                           VoiceRenderPool* pool = nullptr) {
+        const std::size_t headSamples = HeadSamples();
+        auto head = std::make_unique<dsp::ConvolutionHead>(
+            headSamples, kIrFadeBlocks * RoomPartitionLayout().baseBlockSize());
+        const std::size_t libraryCount = dsp::RoomIrLibrary::list().size();
+        struct Resampled {
+            std::vector<float> left;
+            std::vector<float> right;  // empty if mono
+        };
+        std::vector<Resampled> irs(libraryCount + (user ? 1 : 0));
+        auto resample = [&](std::size_t i) {
+            const auto ir = i < libraryCount ? SourceIr(static_cast<int>(i)) : user->samples();
+            const dsp::PolyphaseResampler resampler(ir.sampleRate, sampleRate);
+            irs[i].left = resampler.process(ir.left, ir.frameCount, headSamples);
+            if (ir.right) {
+                irs[i].right = resampler.process(ir.right, ir.frameCount, headSamples);
             }
-            (void)wetQueue_.push(wet);
+        };
+        RunBuildJobs(pool, irs.size(), resample);
+        for (const Resampled& ir : irs) {
+            head->addIr(ir.left.data(), ir.right.empty() ? nullptr : ir.right.data(),
+                        ir.left.size());
         }
+        return head;
     }
 
-    // Audio-thread state.
-    DryBlock dryAccum_{};
-    std::size_t blockPos_ = 0;
-    StereoBlock wetBlock_{};
-    bool haveWetBlock_ = false;
-    DryBlock playDryBlock_{};
-    bool havePlayDryBlock_ = false;
-    std::array<DryBlock, kDryHistoryBlocks> dryHistory_{};
-    std::uint64_t outputSeq_ = 0;
-    bool haveOutputSeq_ = false;
-    std::optional<StereoBlock> bufferedWet_{};
-    std::uint64_t nextSeq_ = 0;
-    float mixSmoothingAlpha_ = 1.0f;
-    float currentMix_ = 0.0f;
-    float lastTargetMix_ = 0.0f;
-
-    // Auto-detect offline rendering (e.g. unit tests) and fall back to synchronous
-    // processing so the DSP remains deterministic when processed faster than realtime.
-    bool offlineDetected_ = false;
-    bool useSynchronous_ = false;
-    std::chrono::steady_clock::time_point timingStart_ = std::chrono::steady_clock::now();
-    std::size_t processedFramesForTiming_ = 0;
-    int fastBlockStreak_ = 0;
-
-    // Synchronous fallback state (audio thread).
-    bool syncBuiltOnce_ = false;
-    double syncSampleRate_ = 44100.0;
-    std::uint64_t syncSampleRateSeq_ = 0;
-    std::uint64_t syncResetSeq_ = 0;
-    int syncIrIndex_ = -1;
-    std::vector<dsp::StereoConvolutionKernel> syncKernels_{};
-    dsp::ConvolutionReverb syncReverb_{};
+    // Decodes a WAV into a user IR: the first two channels, at most
+    // kMaxUserIrSeconds, peak-normalised like the library. Null on failure.
+    static std::shared_ptr<const UserIrSource> DecodeUserIr(const std::filesystem::path& path) {
+        audio::WaveData wave;
+        std::string error;
+        if (!audio::WaveReader().read(path, wave, error) || wave.samples.empty()) {
+            return nullptr;
+        }
+        auto source = std::make_shared<UserIrSource>();
+        source->sampleRate = static_cast<int>(wave.sampleRate);
+        const std::size_t frames =
+            std::min(wave.samples.size() / wave.channels,
+                     static_cast<std::size_t>(kMaxUserIrSeconds * wave.sampleRate));
+        source->left.resize(frames);
+        audio::Deinterleave(wave.samples.data(), wave.channels, 0, source->left.data(), frames);
+        if (wave.channels >= 2) {
+            source->right.resize(frames);
+            audio::Deinterleave(wave.samples.data(), wave.channels, 1, source->right.data(),
+                                frames);
+        }
+        float peak = 0.0f;
+        for (const auto* channel : {&source->left, &source->right}) {
+            for (float v : *channel) {
+                peak = std::max(peak, std::abs(v));
+            }
+        }
+        if (!(peak > 1e-6f) || !std::isfinite(peak)) {
+            return nullptr;
+        }
+        const float scale = 0.95f / peak;
+        for (auto* channel : {&source->left, &source->right}) {
+            for (float& v : *channel) {
+                v *= scale;
+            }
+        }
+        source->bytes.set(CapacityBytes(source->left) + CapacityBytes(source->right));
+        return source;
+    }
 
-    // Cross-thread queues (audio thread <-> reverb worker).
-    SpscRing<DryBlock, kQueueCapacity> dryQueue_{};
-    SpscRing<StereoBlock, kQueueCapacity> wetQueue_{};
+    static std::unique_ptr<UserIrBuild> BuildUserIr(const UserIrSource& source, int sampleRate,
+                                                    RoomQuality quality) {
+        auto build = std::make_unique<UserIrBuild>();
+        build->sampleRate = sampleRate;
+        build->quality = quality;
+        const auto ir = source.samples();
+        const dsp::PolyphaseResampler resampler(ir.sampleRate, sampleRate);
+        std::vector<float> left = resampler.process(ir.left, ir.frameCount);
+        std::vector<float> right;
+        if (ir.right) {
+            right = resampler.process(ir.right, ir.frameCount);
+        }
+        const std::size_t skip = std::min(left.size(), HeadSamples());
+        build->tailFrames = left.size() - skip;
+        build->kernel = RoomPartitionLayout().buildKernel(
+            left.data() + skip, ir.right ? right.data() + skip : nullptr, build->tailFrames);
+        const std::size_t trimmed = EdcTrimFrames(ir, TrimDb(quality));
+        if (trimmed < ir.frameCount && build->tailFrames > 0) {
+            const std::size_t frames =
+                dsp::PolyphaseResampler::OutputFrames(trimmed, ir.sampleRate, sampleRate);
+            TrimKernel(build->kernel, std::max(frames, skip + 1) - skip);
+        }
+        build->head = BuildHead(sampleRate, &source);
+        build->fit = dsp::FdnReverb::FitToIr(ir.left, ir.right, ir.frameCount, ir.sampleRate);
+        return build;
+    }
 
-    std::atomic<bool> running_{false};
-    std::thread worker_{};
-    std::condition_variable dataReady_{};
-    std::mutex cvMutex_{};
-    std::atomic<std::uint32_t> pendingDryBlocks_{0};
+    // Builds the kernel for `index` on first use.
+    static void EnsureIrKernel(dsp::ConvolutionReverb& reverb, int sampleRate, int index,
+                               bool tailOnly, RoomQuality quality,
+                               VoiceRenderPool* pool = nullptr) {
+        // The user slot is built by the loader thread.
+        if (reverb.irCount() == 0 || index >= UserIrIndex()) {
+            return;
+        }
+        index = std::clamp(index, 0, reverb.irCount() - 1);
+        if (!reverb.hasIrKernel(index)) {
+            reverb.setIrKernel(index,
+                               SharedIrKernel(index, sampleRate, tailOnly, quality, pool));
+        }
+    }
 
-    // Control parameters set from any thread; applied on worker thread.
-    std::atomic<double> requestedSampleRate_{44100.0};
-    std::atomic<std::uint64_t> sampleRateSeq_{0};
-    std::atomic<float> requestedMix_{0.0f};
-    std::atomic<int> requestedIrIndex_{0};
-    std::atomic<std::uint64_t> resetSeq_{0};
-    std::atomic<bool> builtOnce_{false};
+    // Kernels used so far, per sample rate, so switching back to a recent
+    // device rate doesn't rebuild anything. Keeps kCachedRates rates; the
+    // library kernels stay shared with other rooms while cached.
+    class KernelCache {
+    public:
+        static constexpr std::size_t kCachedRates = 3;
+
+        // Always returns one (possibly empty) entry per IR slot.
+        std::vector<dsp::SharedConvolutionKernel> take(int sampleRate) {
+            std::vector<dsp::SharedConvolutionKernel> kernels;
+            for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                if (it->first == sampleRate) {
+                    kernels = std::move(it->second);
+                    entries_.erase(it);
+                    break;
+                }
+            }
+            kernels.resize(IrSlotCount());
+            return kernels;
+        }
 
-    std::vector<dsp::StereoConvolutionKernel> kernels_;
-    dsp::ConvolutionReverb reverb_;
-};
+        void store(int sampleRate, std::vector<dsp::SharedConvolutionKernel> kernels) {
+            if (sampleRate <= 0 || kernels.empty()) {
+                return;
+            }
+            if (entries_.size() >= kCachedRates) {
+                entries_.erase(entries_.begin());  // oldest
+            }
+            entries_.emplace_back(sampleRate, std::move(kernels));
+        }
 
-namespace {
+        void clear() { entries_.clear(); }
 
-constexpr float kVoiceSilenceThreshold = 1e-5f;
-constexpr float kEnergyDecay = 0.995f;
-constexpr float kEnvelopeFloor = 1e-5f;
-constexpr double kDefaultAttackSecondsValue = 0.004;
+        // Forgets one slot at every rate, e.g. after the user IR changed.
+        void drop(int index) {
+            for (auto& entry : entries_) {
+                if (index >= 0 && static_cast<std::size_t>(index) < entry.second.size()) {
+                    entry.second[static_cast<std::size_t>(index)] = {};
+                }
+            }
+        }
 
-class AmpEnvelope {
-public:
-    AmpEnvelope() = default;
+    private:
+        std::vector<std::pair<int, std::vector<dsp::SharedConvolutionKernel>>> entries_;
+    };
 
-    void setSampleRate(double sampleRate) {
-        sampleRate_ = sampleRate > 0.0 ? sampleRate : sampleRate_;
-        updateAttackSamples();
-        updateReleaseSamples();
+    // Swaps `reverb` over to `sampleRate`, parking the current kernels in the
+    // cache. Only the selected IR is built now; others are built when chosen.
+    // History is reserved for the library and at least `minIrFrames`.
+    static void SwitchKernelRate(dsp::ConvolutionReverb& reverb, KernelCache& cache,
+                                 int& currentRate, int sampleRate, bool tailOnly,
+                                 std::size_t minIrFrames) {
+        if (currentRate > 0 && currentRate != sampleRate) {
+            cache.store(currentRate, reverb.releaseIrKernels());
+        }
+        if (currentRate != sampleRate) {
+            reverb.setIrKernels(cache.take(sampleRate),
+                                std::max(MaxIrFrames(sampleRate, tailOnly), minIrFrames));
+            currentRate = sampleRate;
+        }
     }
 
-    void setAttackSeconds(double seconds) {
-        attackSeconds_ = std::max(0.0, seconds);
-        updateAttackSamples();
-    }
+    // Auto mode: rendering far faster than realtime for a couple of blocks
+    // (e.g. unit tests) latches the inline tail so output is deterministic.
+    void updateOfflineDetection() {
+        if (offlineDetected_ || renderMode_.load(std::memory_order_relaxed) != RenderMode::Auto) {
+            return;
+        }
 
-    void setReleaseSeconds(double seconds) {
-        releaseSeconds_ = std::max(0.0, seconds);
-        updateReleaseSamples();
+        processedFramesForTiming_ += blockSize_;
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed = now - timingStart_;
+        const auto elapsedSeconds =
+            std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+        if (elapsedSeconds <= 0.0) {
+            return;
+        }
+        const double framesPerSecond =
+            static_cast<double>(processedFramesForTiming_) / elapsedSeconds;
+        const double sr =
+            std::max(1.0, requestedSampleRate_.load(std::memory_order_relaxed));
+        const double speedRatio = framesPerSecond / sr;
+        if (speedRatio > 8.0) {
+            ++fastBlockStreak_;
+        } else {
+            fastBlockStreak_ = 0;
+        }
+        if (fastBlockStreak_ >= 2) {
+            offlineDetected_ = true;
+        }
     }
 
-    void noteOn(float targetLevel) {
-        targetLevel_ = std::max(0.0f, targetLevel);
-        stageCursor_ = 0;
-        if (attackSamples_ == 0) {
-            level_ = targetLevel_;
-            stage_ = Stage::Sustain;
-        } else {
-            level_ = 0.0f;
-            stage_ = Stage::Attack;
+    bool UseInlineTail() const {
+        switch (renderMode_.load(std::memory_order_relaxed)) {
+        case RenderMode::Offline:
+            return true;
+        case RenderMode::Realtime:
+            return false;
+        case RenderMode::Auto:
+            break;
         }
+        return offlineDetected_;
     }
 
-    void noteOff() {
-        if (stage_ == Stage::Idle) {
-            return;
+    // Audio thread, offline: render every queued tail block here instead of
+    // waiting for the worker. The tail then always arrives on time, so the
+    // output is exactly what a live worker that never ran late would give.
+    // Offline means no deadline, so the lock is not a realtime violation.
+    void renderTailInline() {
+        dsp::ScopedDenormalsDisable denormalsGuard;
+        const RealtimeAllowance offline;
+        std::lock_guard<std::mutex> lock(tailMutex_);
+        applyTailStateLocked();  // builds the head before the first block
+        while (renderTailBlockLocked()) {
         }
-        stage_ = Stage::Release;
-        stageCursor_ = 0;
-        updateReleaseSamples();
-        releaseStartLevel_ = level_;
-        if (releaseSamples_ == 0) {
-            level_ = 0.0f;
-            stage_ = Stage::Idle;
-        }
-    }
-
-    float next() {
-        switch (stage_) {
-            case Stage::Idle:
-                level_ = 0.0f;
-                return level_;
-            case Stage::Attack: {
-                if (attackSamples_ == 0) {
-                    level_ = targetLevel_;
-                    stage_ = Stage::Sustain;
-                    return level_;
-                }
-                const float t = static_cast<float>(stageCursor_ + 1) /
-                                static_cast<float>(attackSamples_);
-                level_ = targetLevel_ * std::min(1.0f, t);
-                if (++stageCursor_ >= attackSamples_) {
-                    stage_ = Stage::Sustain;
-                    stageCursor_ = 0;
-                }
-                return level_;
-            }
-            case Stage::Sustain:
-                level_ = targetLevel_;
-                return level_;
-            case Stage::Release: {
-                if (releaseSamples_ == 0) {
-                    level_ = 0.0f;
-                    stage_ = Stage::Idle;
-                    return level_;
-                }
-                const float t = static_cast<float>(stageCursor_) /
-                                static_cast<float>(releaseSamples_);
-                const float factor = std::max(0.0f, 1.0f - t);
-                level_ = releaseStartLevel_ * factor;
-                if (++stageCursor_ >= releaseSamples_ || level_ < kEnvelopeFloor) {
-                    level_ = 0.0f;
-                    stage_ = Stage::Idle;
+    }
+
+    // Tail state below is touched only under tailMutex_, held by the worker
+    // for each block and by the audio thread only when rendering inline.
+    void applyTailStateLocked() {
+        const std::uint64_t srSeq = sampleRateSeq_.load(std::memory_order_acquire);
+        if (srSeq != tailSampleRateSeq_) {
+            const double requested = requestedSampleRate_.load(std::memory_order_acquire);
+            if (requested > 0.0) {
+                const int rate = static_cast<int>(std::lround(requested));
+                const auto user = userSource();
+                // Hand the head to the audio thread; an unclaimed older one is dropped.
+                auto head = BuildHead(rate, user.get(), tailPool_.get());
+                headBytes_.set(head->heapBytes());
+                delete pendingHead_.exchange(head.release(), std::memory_order_acq_rel);
+                SwitchKernelRate(reverb_, kernelCache_, kernelRate_, rate, true,
+                                 UserTailFrames(user.get(), rate));
+                if (user && !reverb_.hasIrKernel(UserIrIndex())) {
+                    requestUserIrBuild(rate);
                 }
-                return level_;
+                reverb_.setMix(1.0f);
+                reverb_.setSampleRate(requested);
+                builtOnce_.store(true, std::memory_order_release);
             }
+            tailSampleRateSeq_ = srSeq;
+            rebuildPending_.store(
+                sampleRateSeq_.load(std::memory_order_acquire) != tailSampleRateSeq_,
+                std::memory_order_release);
+            // Force re-apply for the new instance/state.
+            tailIrIndex_ = -1;
         }
-        return 0.0f;
-    }
 
-    bool isIdle() const { return stage_ == Stage::Idle; }
-    bool isReleasing() const { return stage_ == Stage::Release; }
-    float level() const { return level_; }
+        // A new quality invalidates every kernel built so far, cached or not.
+        const RoomQuality quality = requestedQuality_.load(std::memory_order_relaxed);
+        if (quality != kernelQuality_) {
+            kernelCache_.clear();
+            if (kernelRate_ > 0) {
+                const auto user = userSource();
+                swapTailKernelsLocked(std::vector<dsp::SharedConvolutionKernel>(IrSlotCount()),
+                                      std::max(MaxIrFrames(kernelRate_, true),
+                                               UserTailFrames(user.get(), kernelRate_)));
+                if (user) {
+                    requestUserIrBuild(kernelRate_);
+                }
+            }
+            kernelQuality_ = quality;
+            tailIrIndex_ = -1;
+        }
 
-private:
-    enum class Stage { Idle, Attack, Sustain, Release };
+        // A finished user IR build: adopted only if it still matches.
+        if (UserIrBuild* raw = pendingUserIr_.exchange(nullptr, std::memory_order_acq_rel)) {
+            std::unique_ptr<UserIrBuild> build(raw);
+            if (build->sampleRate == kernelRate_ && build->quality == kernelQuality_) {
+                adoptUserIrLocked(*build);
+            } else if (kernelRate_ > 0) {
+                requestUserIrBuild(kernelRate_);
+            }
+        }
 
-    void updateAttackSamples() {
-        attackSamples_ = static_cast<std::size_t>(
-            std::max(0.0, std::round(attackSeconds_ * sampleRate_)));
+        const std::uint64_t rstSeq = resetSeq_.load(std::memory_order_acquire);
+        if (rstSeq != tailResetSeq_) {
+            reverb_.reset();
+            tailResetSeq_ = rstSeq;
+            // Re-apply params after reset.
+            tailIrIndex_ = -1;
+        }
+        int irIndex = requestedIrIndex_.load(std::memory_order_relaxed);
+        if (irIndex >= UserIrIndex()) {
+            irIndex = reverb_.hasIrKernel(UserIrIndex()) ? UserIrIndex() : 0;
+        }
+        if (irIndex != tailIrIndex_) {
+            EnsureIrKernel(reverb_, kernelRate_, irIndex, true, kernelQuality_, tailPool_.get());
+            reverb_.setIrIndex(irIndex);
+            tailIrIndex_ = irIndex;
+        }
     }
 
-    void updateReleaseSamples() {
-        releaseSamples_ = static_cast<std::size_t>(
-            std::max(0.0, std::round(releaseSeconds_ * sampleRate_)));
+    // The tail restarts only if the user IR is playing; the new head goes to
+    // the audio thread the usual way.
+    void adoptUserIrLocked(UserIrBuild& build) {
+        kernelCache_.drop(UserIrIndex());
+        auto kernels = reverb_.irKernels();
+        kernels.resize(IrSlotCount());
+        kernels[static_cast<std::size_t>(UserIrIndex())] =
+            ShareKernel(std::move(build.kernel));
+        swapTailKernelsLocked(std::move(kernels),
+                              std::max(MaxIrFrames(kernelRate_, true), build.tailFrames));
+        headBytes_.set(build.head ? build.head->heapBytes() : 0);
+        delete pendingHead_.exchange(build.head.release(), std::memory_order_acq_rel);
+        userFitRt60_.store(build.fit.rt60Seconds, std::memory_order_relaxed);
+        userFitHighRatio_.store(build.fit.highRatio, std::memory_order_relaxed);
+        userFitGain_.store(build.fit.gain, std::memory_order_relaxed);
+        userFitSeq_.fetch_add(1, std::memory_order_acq_rel);
+        tailIrIndex_ = -1;
     }
 
-    Stage stage_ = Stage::Idle;
-    double sampleRate_ = 44100.0;
-    double attackSeconds_ = kDefaultAttackSecondsValue;
-    double releaseSeconds_ = 0.35;
-    float level_ = 0.0f;
-    float targetLevel_ = 1.0f;
-    float releaseStartLevel_ = 0.0f;
-    std::size_t stageCursor_ = 0;
-    std::size_t attackSamples_ = 0;
-    std::size_t releaseSamples_ = 0;
-};
+    // Swaps a kernel set into the tail between blocks, without rebuilding
+    // the stages when their history already covers it. The set it replaces
+    // is freed on the loader thread when one runs, off the worker.
+    void swapTailKernelsLocked(std::vector<dsp::SharedConvolutionKernel> kernels,
+                               std::size_t maxIrFrames) {
+        reverb_.publishIrKernels(std::move(kernels), maxIrFrames);
+        reverb_.adoptPublishedIrKernels();
+        bool handedOff = false;
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex_);
+            handedOff = loader_.joinable() && !loaderStop_;
+            releaseKernelsRequested_ = releaseKernelsRequested_ || handedOff;
+        }
+        if (handedOff) {
+            loaderWake_.notify_one();
+        } else {
+            reverb_.releaseRetiredIrKernels();
+        }
+    }
 
-struct Voice {
-    synthesis::KarplusStrongString string;
-    AmpEnvelope envelope;
-    int noteId = -1;
-    double frequency = 0.0;
-    float velocity = 1.0f;
-    std::uint64_t age = 0;
-    float energy = 0.0f;
-};
+    static std::size_t UserTailFrames(const UserIrSource* user, int sampleRate) {
+        if (!user) {
+            return 0;
+        }
+        const std::size_t frames = dsp::PolyphaseResampler::OutputFrames(
+            user->left.size(), user->sampleRate, sampleRate);
+        return frames - std::min(frames, HeadSamples());
+    }
 
-}  // namespace
+    std::shared_ptr<const UserIrSource> userSource() const {
+        std::lock_guard<std::mutex> lock(loaderMutex_);
+        return userSource_;
+    }
 
-class StringSynthEngine::VoiceManager {
-public:
-    VoiceManager(std::size_t maxVoices, double sampleRate, double attackSeconds,
-                 double releaseSeconds)
-        : maxVoices_(maxVoices),
-          sampleRate_(sampleRate > 0.0 ? sampleRate : 44100.0),
-          attackSeconds_(attackSeconds),
-          releaseSeconds_(releaseSeconds) {}
+    // Tail side: asks the loader for the user kernel at `sampleRate`.
+    void requestUserIrBuild(int sampleRate) {
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex_);
+            buildRequestRate_ = sampleRate;
+        }
+        loaderWake_.notify_one();
+    }
 
-    void setSampleRate(double sampleRate) {
-        if (sampleRate <= 0.0) {
-            return;
+    // Loader thread: decodes requested files and builds user IR kernels, one
+    // request at a time, at normal priority. Results go to the tail through
+    // pendingUserIr_; an unclaimed older build is dropped. Also frees the
+    // kernel sets the tail swapped out.
+    void loaderLoop() {
+        // Resamples the file and transforms its partitions.
+        const ScopedDspThread dspThread("room IR loader");
+        for (;;) {
+            std::optional<std::filesystem::path> path;
+            int rate = 0;
+            std::shared_ptr<const UserIrSource> source;
+            bool release = false;
+            {
+                std::unique_lock<std::mutex> lock(loaderMutex_);
+                loaderWake_.wait(lock, [this] {
+                    return loaderStop_ || loadRequest_ || releaseKernelsRequested_ ||
+                           (buildRequestRate_ > 0 && userSource_);
+                });
+                if (loaderStop_) {
+                    return;
+                }
+                path = std::move(loadRequest_);
+                loadRequest_.reset();
+                release = std::exchange(releaseKernelsRequested_, false);
+                if (path || userSource_) {
+                    rate = buildRequestRate_;
+                    buildRequestRate_ = 0;
+                }
+                source = userSource_;
+            }
+            if (release) {
+                reverb_.releaseRetiredIrKernels();
+            }
+            if (!path && rate <= 0) {
+                continue;
+            }
+            if (path) {
+                source = DecodeUserIr(*path);
+                if (!source) {
+                    finishLoad(UserIrStatus::Failed);
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(loaderMutex_);
+                userSource_ = source;
+            }
+            if (rate <= 0) {
+                rate = static_cast<int>(
+                    std::lround(requestedSampleRate_.load(std::memory_order_acquire)));
+            }
+            auto build =
+                BuildUserIr(*source, rate, requestedQuality_.load(std::memory_order_relaxed));
+            delete pendingUserIr_.exchange(build.release(), std::memory_order_acq_rel);
+            if (path) {
+                finishLoad(UserIrStatus::Ready);
+            }
         }
-        sampleRate_ = sampleRate;
-        for (auto& voice : voices_) {
-            voice.envelope.setSampleRate(sampleRate_);
+    }
+
+    // A newer request keeps the status at Loading.
+    void finishLoad(UserIrStatus status) {
+        std::lock_guard<std::mutex> lock(loaderMutex_);
+        if (!loadRequest_) {
+            userIrStatus_.store(status, std::memory_order_release);
         }
     }
 
-    void setAttackSeconds(double seconds) {
-        attackSeconds_ = std::max(0.0, seconds);
-        for (auto& voice : voices_) {
-            voice.envelope.setAttackSeconds(attackSeconds_);
+    void stopLoader() {
+        {
+            std::lock_guard<std::mutex> lock(loaderMutex_);
+            loaderStop_ = true;
+        }
+        loaderWake_.notify_one();
+        if (loader_.joinable()) {
+            loader_.join();
         }
     }
 
-    void setReleaseSeconds(double seconds) {
-        releaseSeconds_ = std::max(0.0, seconds);
-        for (auto& voice : voices_) {
-            voice.envelope.setReleaseSeconds(releaseSeconds_);
+    void discardDryBlocksLocked() {
+        while (dryQueue_.discard()) {
+            pendingDryBlocks_.fetch_sub(1, std::memory_order_acq_rel);
         }
     }
 
-    void noteOn(int noteId, double frequency, float velocity,
-                const synthesis::StringConfig& config) {
-        if (frequency <= 0.0) {
-            return;
+    // Renders one queued dry block into the wet queue; false if none queued.
+    bool renderTailBlockLocked() {
+        // Read and written in place in the queues.
+        const DryBlock* dry = dryQueue_.peek();
+        if (!dry) {
+            return false;
         }
-        Voice* voice = findVoiceByNote(noteId);
-        if (!voice) {
-            voice = allocateVoice();
+        const TraceZone zone("room tail block");
+        applyTailStateLocked();
+
+        const auto start = std::chrono::steady_clock::now();
+        const std::uint64_t seq = dry->seq;
+        reverb_.processBlockWet(dry->samples.data(), tailWetL_.data(), tailWetR_.data());
+        dryQueue_.discard();
+        pendingDryBlocks_.fetch_sub(1, std::memory_order_acq_rel);
+        if (StereoBlock* wet = wetQueue_.writeSlot()) {
+            wet->seq = seq;
+            for (std::size_t i = 0; i < blockSize_; ++i) {
+                wet->samples[i * 2] = tailWetL_[i];
+                wet->samples[i * 2 + 1] = tailWetR_[i];
+            }
+            wetQueue_.commit();
+            RaiseHighWater(wetHighWater_, wetQueue_.size());
+        } else {
+            droppedWetBlocks_.fetch_add(1, std::memory_order_relaxed);
         }
-        if (!voice) {
-            return;
+        const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start).count();
+        tailNanos_.store(tailNanos_.load(std::memory_order_relaxed) +
+                             static_cast<std::uint64_t>(nanos),
+                         std::memory_order_relaxed);
+        const double rate = requestedSampleRate_.load(std::memory_order_relaxed);
+        tailTimes_.record(static_cast<double>(nanos) / 1000.0,
+                          rate > 0.0 ? 1e6 * static_cast<double>(blockSize_) / rate : 0.0);
+        return true;
+    }
+
+    // Audio thread: worker block `seq`, left at the front of the queue;
+    // older blocks are dropped and a newer one stays queued.
+    const StereoBlock* peekWetBlock(std::uint64_t seq) {
+        while (const StereoBlock* block = wetQueue_.peek()) {
+            if (block->seq == seq) {
+                return block;
+            }
+            if (block->seq > seq) {
+                return nullptr;
+            }
+            wetQueue_.discard();
         }
-        voice->noteId = noteId;
-        voice->frequency = frequency;
-        voice->velocity = velocity;
-        voice->age = ++ageCounter_;
-        voice->energy = 0.0f;
+        return nullptr;
+    }
 
-        synthesis::StringConfig voiceConfig = config;
-        const float amp = ExpressiveMapping::Apply(velocity, frequency, config, voiceConfig);
-        voiceConfig.sampleRate = sampleRate_;
-        voice->string.updateConfig(voiceConfig);
-        voice->string.start(frequency, velocity);
+    void discardWetBlocks() {
+        wetBlock_ = nullptr;
+        fadeBlock_ = nullptr;
+        heldWetBlocks_ = 0;
+        while (wetQueue_.discard()) {
+        }
+    }
 
-        voice->envelope.setSampleRate(sampleRate_);
-        voice->envelope.setAttackSeconds(attackSeconds_);
-        voice->envelope.setReleaseSeconds(releaseSeconds_);
-        voice->envelope.noteOn(amp);
+    // Audio thread, at a block boundary: take the tail block due now (worker
+    // seq nextSeq_ - delay) and adapt the delay. A late block grows it by one,
+    // so the tail resumes one block behind where it stopped; a shrink skips
+    // ahead a block, crossfading over the skipped one.
+    void takeWetBlocks() {
+        // The last block's tail is read straight from the queue; free it now.
+        for (; heldWetBlocks_ > 0; --heldWetBlocks_) {
+            wetQueue_.discard();
+        }
+        wetBlock_ = nullptr;
+        fadeBlock_ = nullptr;
+        if (nextSeq_ >= delay_.blocks()) {
+            const std::uint64_t expectedSeq = nextSeq_ - delay_.blocks();
+            wetBlock_ = peekWetBlock(expectedSeq);
+            if (!wetBlock_) {
+                lateBlocks_.fetch_add(1, std::memory_order_relaxed);
+                // Kernel rebuilds stall the worker on purpose; don't adapt to them.
+                delay_.late(!rebuildPending_.load(std::memory_order_acquire));
+            } else {
+                heldWetBlocks_ = 1;
+                const StereoBlock* next = wetQueue_.peek(1);
+                if (delay_.onTime(wetQueue_.size() - 1, next && next->seq == expectedSeq + 1)) {
+                    fadeBlock_ = wetBlock_;
+                    wetBlock_ = next;
+                    heldWetBlocks_ = 2;
+                }
+            }
+        }
+        reportedDelayBlocks_.store(delay_.blocks(), std::memory_order_relaxed);
     }
 
-    void noteOff(int noteId) {
-        if (noteId < 0) {
+    void resetTailResync() {
+        tailGain_ = 1.0f;
+        heldTailL_ = 0.0f;
+        heldTailR_ = 0.0f;
+        delay_.restartWindow();
+    }
+
+    // Audio thread: take a head published by the worker. The old one goes back
+    // to the worker to be freed (deleted here only if the worker hasn't
+    // collected the previous one yet).
+    void adoptPendingHead() {
+        dsp::ConvolutionHead* next = pendingHead_.exchange(nullptr, std::memory_order_acq_rel);
+        if (!next) {
             return;
         }
-        for (auto& voice : voices_) {
-            if (voice.noteId == noteId) {
-                voice.envelope.setReleaseSeconds(releaseSeconds_);
-                voice.envelope.noteOff();
+        dsp::ConvolutionHead* old = head_.release();
+        head_.reset(next);
+        headIrIndex_ = -1;
+        delete retiredHead_.exchange(old, std::memory_order_acq_rel);
+    }
+
+    // loadState() with the worker held off; the tail and audio-thread state
+    // alike, so the heads can build on the tail pool.
+    void loadStateLocked(dsp::StateReader& in) {
+        bool built = false;
+        if (in.pod(built) && built) {
+            applyTailStateLocked();
+            if (kernelRate_ <= 0) {
+                in.fail();
+            }
+            int irIndex = -1;
+            in.pod(irIndex);
+            reverb_.loadState(in);
+            std::array<bool, 3> kernels{};
+            in.pod(kernels);
+            const auto irs = reverb_.activeIrIndices();
+            for (std::size_t i = 0; i < irs.size() && in.ok(); ++i) {
+                if (kernels[i]) {
+                    EnsureIrKernel(reverb_, kernelRate_, irs[i], true, kernelQuality_,
+                                   tailPool_.get());
+                }
+                if (irs[i] >= 0 && reverb_.hasIrKernel(irs[i]) != kernels[i]) {
+                    in.fail();
+                }
+            }
+            tailIrIndex_ = irIndex;
+        }
+        discardDryBlocksLocked();
+        discardWetBlocks();
+        std::size_t blocks = 0;
+        if (in.pod(blocks) && blocks > dryQueue_.capacity()) {
+            in.fail();
+        }
+        for (std::size_t i = 0; i < blocks && in.ok(); ++i) {
+            DryBlock* block = dryQueue_.writeSlot();
+            in.pod(block->seq);
+            in.floats(block->samples.data(), blockSize_);
+            dryQueue_.commit();
+            pendingDryBlocks_.fetch_add(1, std::memory_order_release);
+        }
+        if (in.pod(blocks) && blocks > wetQueue_.capacity()) {
+            in.fail();
+        }
+        for (std::size_t i = 0; i < blocks && in.ok(); ++i) {
+            StereoBlock* block = wetQueue_.writeSlot();
+            in.pod(block->seq);
+            in.floats(block->samples.data(), 2 * blockSize_);
+            wetQueue_.commit();
+        }
+
+        if (in.pod(blockPos_) && blockPos_ >= blockSize_) {
+            in.fail();
+        }
+        DryBlock* slot = dryQueue_.writeSlot();
+        dryBlock_ = slot ? slot : &dryAccum_;
+        in.floats(dryBlock_->samples.data(), blockPos_);
+        if (in.pod(heldWetBlocks_) && heldWetBlocks_ > std::min<std::size_t>(2, wetQueue_.size())) {
+            in.fail();
+        }
+        delay_.loadState(in);
+        in.pod(tailGain_);
+        in.pod(heldTailL_);
+        in.pod(heldTailR_);
+        in.pod(nextSeq_);
+        in.pod(currentMix_);
+        in.pod(lastTargetMix_);
+        in.floats(warmHistory_.data(), headSamples_);
+        if (in.pod(warmPos_) && warmPos_ >= headSamples_) {
+            in.fail();
+        }
+        in.pod(warmStartPending_);
+        in.pod(inlineTail_);
+        in.pod(offlineDetected_);
+        decorrelator_.loadState(in);
+        bool hasHead = false;
+        bool headPending = false;
+        in.pod(hasHead);
+        in.pod(headPending);
+        if (in.ok()) {
+            loadHead(in, hasHead, headPending);
+        }
+        in.pod(fdnIrIndex_);
+        in.pod(fdnFitSeq_);
+        in.pod(fdnActive_);
+        fdn_.loadState(in);
+        if (!in.ok()) {
+            heldWetBlocks_ = 0;
+        }
+        // Held tail blocks are read in place from the front of the queue.
+        wetBlock_ = heldWetBlocks_ > 0 ? wetQueue_.peek(heldWetBlocks_ - 1) : nullptr;
+        fadeBlock_ = heldWetBlocks_ == 2 ? wetQueue_.peek(0) : nullptr;
+    }
+
+    // loadState(): the saved head's state goes into head_. A head the tail
+    // handed over stays pending if the saved room had not adopted its own
+    // yet; head_ is then built separately.
+    void loadHead(dsp::StateReader& in, bool hasHead, bool headPending) {
+        const auto build = [this] {
+            return BuildHead(kernelRate_, userSource().get(), tailPool_.get());
+        };
+        if (!headPending) {
+            adoptPendingHead();
+        } else if (!pendingHead_.load(std::memory_order_acquire)) {
+            if (kernelRate_ <= 0) {
+                in.fail();
+                return;
+            }
+            delete pendingHead_.exchange(build().release(), std::memory_order_acq_rel);
+        }
+        if (!hasHead) {
+            head_.reset();
+            headIrIndex_ = -1;
+            return;
+        }
+        if (!head_) {
+            if (kernelRate_ <= 0) {
+                in.fail();
+                return;
+            }
+            head_ = build();
+        }
+        in.pod(headIrIndex_);
+        head_->loadState(in);
+    }
+
+    // Audio thread, when the mix reaches zero: drop pending tail output and
+    // park the worker. Dry blocks already queued are discarded unrendered.
+    void enterBypass() {
+        resetSeq_.fetch_add(1, std::memory_order_acq_rel);
+        suspended_.store(true, std::memory_order_release);
+        discardWetBlocks();
+        wakeWorker();
+    }
+
+    // Audio thread, on resume: runs the last headSamples_ of dry input
+    // through the freshly reset head, so its early reflections pick up the
+    // notes already sounding instead of starting from silence.
+    void primeHeadFromHistory() {
+        float discardL = 0.0f;
+        float discardR = 0.0f;
+        for (std::size_t i = 0; i < headSamples_; ++i) {
+            head_->process(warmHistory_[(warmPos_ + i) % headSamples_], discardL, discardR);
+        }
+    }
+
+    // Same for the network when it takes over: it starts from the recent
+    // input rather than silence.
+    void primeNetworkFromHistory() {
+        fdn_.reset();
+        std::array<float, kNetworkChunkFrames> ordered{};
+        std::array<float, kNetworkChunkFrames> discardL{};
+        std::array<float, kNetworkChunkFrames> discardR{};
+        for (std::size_t done = 0; done < headSamples_; done += kNetworkChunkFrames) {
+            const std::size_t count = std::min(kNetworkChunkFrames, headSamples_ - done);
+            for (std::size_t i = 0; i < count; ++i) {
+                ordered[i] = warmHistory_[(warmPos_ + done + i) % headSamples_];
+            }
+            fdn_.process(ordered.data(), discardL.data(), discardR.data(), count);
+        }
+    }
+
+    void startWorker() {
+        if (running_.exchange(true, std::memory_order_acq_rel)) {
+            return;
+        }
+        worker_ = std::thread(&RoomProcessor::workerLoop, this);
+    }
+
+    void stopWorker() {
+        if (!running_.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+        wakeWorker();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    void workerLoop() {
+        const ScopedDspThread dspThread("room worker", RealtimeThreadRole::RoomWorker);
+
+        while (running_.load(std::memory_order_acquire)) {
+            if (fitsWanted_.load(std::memory_order_acquire) &&
+                !fitsReady_.load(std::memory_order_acquire)) {
+                const TraceZone zone("room network fits");
+                AlgorithmicFits();
+                fitsReady_.store(true, std::memory_order_release);
+            }
+            bool rendered = false;
+            {
+                std::lock_guard<std::mutex> lock(tailMutex_);
+                // Heads replaced on the audio thread are freed here.
+                delete retiredHead_.exchange(nullptr, std::memory_order_acq_rel);
+                if (suspended_.load(std::memory_order_acquire)) {
+                    discardDryBlocksLocked();
+                } else {
+                    rendered = renderTailBlockLocked();
+                }
+            }
+            if (!rendered) {
+                waitForWork();
+            }
+        }
+    }
+
+    // Parked while suspended: only a resumed, non-empty queue, wanted fits
+    // or shutdown wakes the worker.
+    bool workerHasWork() const {
+        return !running_.load(std::memory_order_acquire) ||
+               (fitsWanted_.load(std::memory_order_acquire) &&
+                !fitsReady_.load(std::memory_order_acquire)) ||
+               (!suspended_.load(std::memory_order_acquire) &&
+                pendingDryBlocks_.load(std::memory_order_acquire) > 0);
+    }
+
+    // Any thread, the audio thread included: no lock, and a futex wake
+    // only when the worker is actually parked.
+    void wakeWorker() {
+        workerWake_.fetch_add(1, std::memory_order_seq_cst);
+        if (workerParked_.load(std::memory_order_seq_cst)) {
+            workerWake_.notify_one();
+        }
+    }
+
+    // Spins briefly before parking, since with several blocks per host
+    // buffer the next one follows within microseconds. The spin doubles
+    // while it catches blocks and halves while the worker parks anyway.
+    void waitForWork() {
+        const std::uint32_t seen = workerWake_.load(std::memory_order_seq_cst);
+        if (workerHasWork()) {
+            return;
+        }
+        for (std::size_t i = 0; i < workerSpin_; ++i) {
+            CpuRelax();
+            if (workerWake_.load(std::memory_order_acquire) != seen) {
+                workerSpin_ = std::min(kMaxWorkerSpin, workerSpin_ * 2);
+                return;
+            }
+        }
+        workerSpin_ = std::max(kMinWorkerSpin, workerSpin_ / 2);
+        // Paired with wakeWorker(): either it sees the flag or this sees
+        // its increment.
+        workerParked_.store(true, std::memory_order_seq_cst);
+        if (workerWake_.load(std::memory_order_seq_cst) == seen) {
+            workerWake_.wait(seen, std::memory_order_acquire);
+        }
+        workerParked_.store(false, std::memory_order_relaxed);
+    }
+
+    // Block and head length, fixed for the process (see RoomPartitionLayout()).
+    const std::size_t blockSize_ = RoomPartitionLayout().baseBlockSize();
+    const std::size_t headSamples_ = kOutputDelayBlocks * blockSize_;
+
+    // Audio-thread state.
+    DryBlock dryAccum_{blockSize_};  // only when the dry queue is full
+    DryBlock* dryBlock_ = &dryAccum_;  // block being filled: a queue slot
+    std::size_t blockPos_ = 0;
+    // Tail blocks read in place from the front of the wet queue, which
+    // holds on to them until the next boundary.
+    const StereoBlock* wetBlock_ = nullptr;
+    const StereoBlock* fadeBlock_ = nullptr;  // block skipped by a delay shrink
+    std::size_t heldWetBlocks_ = 0;
+    AdaptiveTailDelay delay_{kOutputDelayBlocks, kMaxOutputDelayBlocks, kDelayShrinkWindowBlocks};
+    float tailGain_ = 1.0f;
+    float heldTailL_ = 0.0f;
+    float heldTailR_ = 0.0f;
+    std::unique_ptr<dsp::ConvolutionHead> head_;
+    int headIrIndex_ = -1;
+    dsp::StereoDecorrelator decorrelator_;  // head only
+    std::vector<float> headWetL_ = std::vector<float>(blockSize_, 0.0f);
+    std::vector<float> headWetR_ = std::vector<float>(blockSize_, 0.0f);
+    std::uint64_t nextSeq_ = 0;
+    float mixSmoothingAlpha_ = 1.0f;
+    float currentMix_ = 0.0f;
+    float lastTargetMix_ = 0.0f;
+    // Last headSamples_ of dry input, replayed into the head on resume.
+    std::vector<float> warmHistory_ = std::vector<float>(headSamples_, 0.0f);
+    std::size_t warmPos_ = 0;
+    bool warmStartPending_ = false;
+    // Algorithmic room (audio thread); restarted from the history whenever
+    // it takes over.
+    dsp::FdnReverb fdn_;
+    int fdnIrIndex_ = -1;
+    std::uint32_t fdnFitSeq_ = 0;
+    bool fdnActive_ = false;
+
+    bool inlineTail_ = false;  // tail rendered on this thread (see UseInlineTail)
+
+    // Auto-mode offline detection (audio thread).
+    bool offlineDetected_ = false;
+    std::chrono::steady_clock::time_point timingStart_ = std::chrono::steady_clock::now();
+    std::size_t processedFramesForTiming_ = 0;
+    int fastBlockStreak_ = 0;
+
+    // Cross-thread queues (audio thread <-> reverb worker).
+    SpscRing<DryBlock> dryQueue_{QueueBlocks(blockSize_), DryBlock(blockSize_)};
+    SpscRing<StereoBlock> wetQueue_{QueueBlocks(blockSize_), StereoBlock(blockSize_)};
+    TrackedBytes queueBytes_{MemoryCategory::Queues, QueueBytes(blockSize_)};
+    TrackedBytes headBytes_{MemoryCategory::Kernels};  // newest head built
+
+    std::atomic<bool> running_{false};
+    std::thread worker_{};
+    std::atomic<std::uint32_t> workerWake_{0};
+    std::atomic<bool> workerParked_{false};
+    std::size_t workerSpin_ = kMinWorkerSpin;  // worker only
+    std::atomic<std::uint32_t> pendingDryBlocks_{0};
+    std::atomic<bool> suspended_{true};  // mix at zero; starts bypassed
+    std::atomic<bool> fitsWanted_{false};  // see fitsReady()
+    std::atomic<bool> fitsReady_{false};
+    static inline std::atomic<bool> layoutFixed_{false};
+
+    // Control parameters set from any thread; applied on worker thread.
+    std::atomic<double> requestedSampleRate_{44100.0};
+    std::atomic<std::uint64_t> sampleRateSeq_{0};
+    std::atomic<float> requestedMix_{0.0f};
+    std::atomic<int> requestedIrIndex_{0};
+    std::atomic<std::uint64_t> resetSeq_{0};
+    std::atomic<RenderMode> renderMode_{RenderMode::Auto};
+    std::atomic<RoomQuality> requestedQuality_{RoomQuality::Full};
+    std::atomic<bool> requestedAlgorithmic_{false};
+    std::atomic<UserIrStatus> userIrStatus_{UserIrStatus::None};
+    // Network fit for the user IR, published by the tail on adoption.
+    std::atomic<double> userFitRt60_{0.0};
+    std::atomic<double> userFitHighRatio_{1.0};
+    std::atomic<float> userFitGain_{0.0f};
+    std::atomic<std::uint32_t> userFitSeq_{0};
+    std::atomic<UserIrBuild*> pendingUserIr_{nullptr};  // loader -> tail
+
+    // User IR loader, started on the first load.
+    mutable std::mutex loaderMutex_{};
+    std::condition_variable loaderWake_{};
+    std::thread loader_{};
+    bool loaderStop_ = false;
+    std::optional<std::filesystem::path> loadRequest_{};
+    int buildRequestRate_ = 0;
+    bool releaseKernelsRequested_ = false;  // tail -> loader: free reverb_'s retired set
+    std::shared_ptr<const UserIrSource> userSource_{};
+    std::atomic<bool> builtOnce_{false};
+    std::atomic<bool> rebuildPending_{false};
+    std::atomic<std::size_t> reportedDelayBlocks_{kOutputDelayBlocks};
+    std::atomic<std::uint64_t> lateBlocks_{0};
+    // Telemetry. Dry-side counters are written by the audio thread, the rest
+    // under tailMutex_.
+    std::atomic<std::uint64_t> droppedDryBlocks_{0};
+    std::atomic<std::size_t> dryHighWater_{0};
+    std::atomic<std::uint64_t> droppedWetBlocks_{0};
+    std::atomic<std::size_t> wetHighWater_{0};
+    std::atomic<std::uint64_t> tailNanos_{0};
+    LatencyHistogram tailTimes_;
+    std::atomic<dsp::ConvolutionHead*> pendingHead_{nullptr};   // worker -> audio thread
+    std::atomic<dsp::ConvolutionHead*> retiredHead_{nullptr};   // audio thread -> worker
+
+    // Tail state, guarded by tailMutex_.
+    std::mutex tailMutex_{};
+    std::uint64_t tailSampleRateSeq_ = 0;
+    std::uint64_t tailResetSeq_ = 0;
+    int tailIrIndex_ = -1;
+    std::vector<float> tailWetL_ = std::vector<float>(blockSize_, 0.0f);
+    std::vector<float> tailWetR_ = std::vector<float>(blockSize_, 0.0f);
+    KernelCache kernelCache_{};
+    int kernelRate_ = 0;
+    RoomQuality kernelQuality_ = RoomQuality::Full;
+    std::unique_ptr<VoiceRenderPool> tailPool_;  // runs tail jobs under tailMutex_
+    dsp::ConvolutionReverb reverb_;
+};
+
+namespace {
+
+constexpr std::size_t kRenderChunkFrames = 256;
+constexpr float kVoiceSilenceThreshold = 1e-5f;
+// A held voice whose loop can no longer produce more than this (-120 dBFS)
+// is retired without waiting for its note-off.
+constexpr float kDormantLevel = 1e-6f;
+constexpr float kEnergyDecay = 0.995f;
+// A stolen or retriggered voice fades out over this long in a ghost slot
+// while the new note starts in another one; kGhostVoices slots are kept on
+// top of maxVoices for that.
+constexpr double kStealFadeSeconds = 0.005;
+constexpr std::size_t kGhostVoices = 4;
+// Key-tracked panning: C4 sits in the middle and kPanOctaves octaves either
+// side reach the edges at full stereoSpread; the softest notes get half that.
+constexpr double kPanCenterHz = 261.63;
+constexpr double kPanOctaves = 3.0;
+constexpr float kPanVelocityFloor = 0.5f;
+
+// Render cost of a note, relative to a string with the default config at the
+// engine rate (1). Rough shares of that string's per-sample work: the loop
+// and tuning allpass, the lowpass and the two dispersion allpasses; a hammer
+// runs the per-sample path through its contact, a loop longer than a few KB
+// per rail no longer stays in L1, and oversampling doubles the string and
+// adds the decimator. A second course takes the lane next to the first, so
+// it costs less than a whole string. Frozen playback is one interpolated
+// read.
+constexpr float kFrozenVoiceCost = 0.2f;
+constexpr float kCourseCost = 0.8f;
+
+float VoiceCost(const synthesis::StringConfig& config, double frequency, double sampleRate,
+                bool oversampled, bool doubled) {
+    float cost = 0.6f;
+    if (config.enableLowpass) {
+        cost += 0.15f;
+    }
+    if (config.dispersionAmount > 0.0f) {
+        cost += 0.25f;
+    }
+    if (config.excitationType == synthesis::ExcitationType::Hammer) {
+        cost += 0.15f;
+    }
+    const double rate = oversampled ? 2.0 * sampleRate : sampleRate;
+    if (frequency > 0.0 && rate / frequency > 1024.0) {
+        cost += 0.1f;
+    }
+    if (doubled) {
+        cost *= 1.0f + kCourseCost;
+    }
+    return oversampled ? 2.0f * cost + 0.25f : cost;
+}
+
+// Pan position in [-1, 1]: low notes left and high notes right, as seen from
+// the player, with harder strikes further out.
+float PanPosition(double frequency, float velocity) {
+    const double octaves = dsp::FastLog2(frequency / kPanCenterHz) / kPanOctaves;
+    const float width =
+        kPanVelocityFloor + (1.0f - kPanVelocityFloor) * std::clamp(velocity, 0.0f, 1.0f);
+    return static_cast<float>(std::clamp(octaves, -1.0, 1.0)) * width;
+}
+
+// Constant-power pan law scaled to unity in the middle, so a centred voice
+// passes unchanged and a hard-panned one is +3 dB on its side.
+void PanGains(float pan, float& left, float& right) {
+    if (pan == 0.0f) {
+        left = 1.0f;
+        right = 1.0f;
+        return;
+    }
+    const double angle = (1.0 + static_cast<double>(std::clamp(pan, -1.0f, 1.0f))) * 0.25 * kPi;
+    left = static_cast<float>(std::sqrt(2.0) * std::cos(angle));
+    right = static_cast<float>(std::sqrt(2.0) * std::sin(angle));
+}
+
+// left += in * a gain ramped from leftFrom to leftTo (reached on the last
+// sample), the same into right, four samples per step.
+void MixPanned(const float* in, float* left, float* right, std::size_t count, float leftFrom,
+               float leftTo, float rightFrom, float rightTo) {
+    if (count == 0) {
+        return;
+    }
+    namespace simd = dsp::simd;
+    alignas(16) static constexpr float kSteps[simd::kLanes] = {1.0f, 2.0f, 3.0f, 4.0f};
+    const float leftStep = (leftTo - leftFrom) / static_cast<float>(count);
+    const float rightStep = (rightTo - rightFrom) / static_cast<float>(count);
+    const simd::Float4 vLeftFrom = simd::Set1(leftFrom);
+    const simd::Float4 vRightFrom = simd::Set1(rightFrom);
+    const simd::Float4 vLeftStep = simd::Set1(leftStep);
+    const simd::Float4 vRightStep = simd::Set1(rightStep);
+    const simd::Float4 stride = simd::Set1(static_cast<float>(simd::kLanes));
+    simd::Float4 step = simd::Load(kSteps);
+    std::size_t k = 0;
+    for (; k + simd::kLanes <= count; k += simd::kLanes) {
+        const simd::Float4 x = simd::Load(in + k);
+        const simd::Float4 gainL = simd::Add(vLeftFrom, simd::Mul(vLeftStep, step));
+        const simd::Float4 gainR = simd::Add(vRightFrom, simd::Mul(vRightStep, step));
+        simd::Store(left + k, simd::Add(simd::Load(left + k), simd::Mul(x, gainL)));
+        simd::Store(right + k, simd::Add(simd::Load(right + k), simd::Mul(x, gainR)));
+        step = simd::Add(step, stride);
+    }
+    for (; k < count; ++k) {
+        const float n = static_cast<float>(k + 1);
+        left[k] += in[k] * (leftFrom + leftStep * n);
+        right[k] += in[k] * (rightFrom + rightStep * n);
+    }
+}
+
+// A part's notes rendered ahead of time for setPartFrozen(): every key and
+// velocity layer struck once through the string model, cut once the loop
+// has decayed 60 dB and kept as 16-bit samples scaled to the note's peak.
+// Empty until render(); an empty set leaves the part modelled.
+class FrozenNotes {
+public:
+    static constexpr int kLowestKey = 21;   // A0
+    static constexpr int kHighestKey = 108;  // C8
+    static constexpr std::size_t kLayers = StringSynthEngine::kFreezeVelocityLayers;
+    static constexpr float kTrimLevel = 1e-3f;   // -60 dB below the note's peak
+    static constexpr double kEndFadeSeconds = 0.05;  // notes cut at kFreezeSeconds
+
+    struct Note {
+        double frequency = 0.0;
+        float velocity = 1.0f;  // the layer's
+        float scale = 0.0f;     // per sample step
+        std::vector<std::int16_t> samples;
+    };
+
+    bool empty() const { return notes_.empty(); }
+    double sampleRate() const { return sampleRate_; }
+
+    // Renders every note at config.sampleRate, mapped as a note-on would map
+    // it; false if `cancel` was raised first. Not real-time safe.
+    bool render(const synthesis::StringConfig& config, const std::atomic<bool>& cancel) {
+        constexpr std::size_t kChunk = 1024;
+        const double rate = config.sampleRate > 0.0 ? config.sampleRate : 44100.0;
+        const auto maxFrames = static_cast<std::size_t>(StringSynthEngine::kFreezeSeconds * rate);
+        std::vector<Note> notes(static_cast<std::size_t>(kHighestKey - kLowestKey + 1) * kLayers);
+        synthesis::KarplusStrongString string;
+        std::vector<float> rendered;
+        rendered.reserve(maxFrames);
+        for (std::size_t i = 0; i < notes.size(); ++i) {
+            if (cancel.load(std::memory_order_relaxed)) {
+                return false;
+            }
+            Note& note = notes[i];
+            const int key = kLowestKey + static_cast<int>(i / kLayers);
+            note.frequency = MidiNoteToFrequency(key);
+            note.velocity = static_cast<float>(i % kLayers + 1) / static_cast<float>(kLayers);
+            synthesis::StringConfig voiceConfig;
+            ExpressiveMapping::Apply(note.velocity, note.frequency, config, voiceConfig);
+            voiceConfig.sampleRate = rate;
+            string.updateConfig(voiceConfig);
+            string.start(note.frequency, note.velocity);
+
+            rendered.clear();
+            float peak = 0.0f;
+            while (rendered.size() < maxFrames) {
+                const std::size_t start = rendered.size();
+                rendered.resize(std::min(maxFrames, start + kChunk));
+                string.processBlock(rendered.data() + start, rendered.size() - start);
+                for (std::size_t k = start; k < rendered.size(); ++k) {
+                    peak = std::max(peak, std::abs(rendered[k]));
+                }
+                if (!string.active() || (peak > 0.0f && string.storedPeak() < peak * kTrimLevel)) {
+                    break;
+                }
+            }
+            if (rendered.size() >= maxFrames) {
+                const std::size_t fade =
+                    std::min(rendered.size(), static_cast<std::size_t>(kEndFadeSeconds * rate));
+                for (std::size_t k = 0; k < fade; ++k) {
+                    rendered[rendered.size() - 1 - k] *= static_cast<float>(k) /
+                                                         static_cast<float>(fade);
+                }
+            }
+            note.scale = peak / 32767.0f;
+            note.samples.resize(rendered.size());
+            const float toSteps = peak > 0.0f ? 32767.0f / peak : 0.0f;
+            for (std::size_t k = 0; k < rendered.size(); ++k) {
+                note.samples[k] = static_cast<std::int16_t>(std::lround(rendered[k] * toSteps));
+            }
+        }
+        sampleRate_ = rate;
+        notes_ = std::move(notes);
+        std::size_t bytes = CapacityBytes(notes_);
+        for (const Note& note : notes_) {
+            bytes += CapacityBytes(note.samples);
+        }
+        bytes_.set(bytes);
+        return true;
+    }
+
+    // The rendered key and layer nearest `frequency` and `velocity`.
+    const Note& nearest(double frequency, float velocity) const {
+        const double key = 69.0 + 12.0 * std::log2(frequency / 440.0);
+        const int k = std::clamp(static_cast<int>(std::lround(key)), kLowestKey, kHighestKey) -
+                      kLowestKey;
+        const int layers = static_cast<int>(kLayers);
+        const int layer = std::clamp(
+            static_cast<int>(std::lround(velocity * static_cast<float>(layers))) - 1, 0,
+            layers - 1);
+        return notes_[static_cast<std::size_t>(k) * kLayers + static_cast<std::size_t>(layer)];
+    }
+
+private:
+    double sampleRate_ = 0.0;
+    std::vector<Note> notes_;  // key-major
+    TrackedBytes bytes_{MemoryCategory::Samples};
+};
+
+// The fields renderGroup() reads per sample sit right before the string's
+// loop state (at the front of the string); allocation bookkeeping follows.
+struct Voice {
+    AmpEnvelope envelope;
+    float velocity = 1.0f;
+    float energy = 0.0f;
+    synthesis::KarplusStrongString string;
+    float pan = 0.0f;        // PanPosition() of the note
+    float panLeft = 1.0f;    // gains reached at the end of the last block
+    float panRight = 1.0f;
+    int noteId = -1;
+    double frequency = 0.0;
+    std::uint64_t age = 0;
+    float cost = 1.0f;   // VoiceCost() of the note
+    bool ghost = false;  // fading out after a steal; not counted as a note
+    bool keyDown = false;    // between note-on and note-off
+    bool sostenuto = false;  // key was down when the sostenuto pedal went down
+    ModulationMatrix::VoiceState mod;
+    // Per-note bend (NoteExpression::PitchBend), on top of the manager's.
+    double bendTarget = 0.0;
+    double bendSemitones = 0.0;
+    // The strike's own values, before modulation offsets.
+    float baseBrightness = 0.0f;
+    float baseDecay = 0.0f;
+    float basePick = 0.0f;
+    // Set at note-on: the string runs at twice the rate and `decimator`
+    // brings it back down.
+    bool oversampled = false;
+    dsp::HalfbandDecimator decimator;
+    // Set at note-on with a course detune: `string` runs courseSpread below
+    // the note and `course` as far above it, struck with the same
+    // excitation; renderGroup() averages the two.
+    bool doubled = false;
+    double courseSpread = 1.0;
+    synthesis::KarplusStrongString course;
+    // Set at note-on in a frozen part: the voice plays `frozen` back from
+    // `frozenSource` instead of running its string.
+    const FrozenNotes* frozenSource = nullptr;
+    const FrozenNotes::Note* frozen = nullptr;
+    double frozenPos = 0.0;
+    double frozenStep = 1.0;  // sample frames per engine frame
+    float frozenGain = 0.0f;
+};
+
+}  // namespace
+
+class StringSynthEngine::VoiceManager {
+public:
+    static constexpr std::size_t kOversampling = 2;
+
+    VoiceManager(std::size_t maxVoices, double sampleRate, double attackSeconds,
+                 double releaseSeconds)
+        : maxVoices_(maxVoices),
+          sampleRate_(sampleRate > 0.0 ? sampleRate : 44100.0),
+          attackSeconds_(attackSeconds),
+          releaseSeconds_(releaseSeconds),
+          voices_(maxVoices + kGhostVoices),
+          voiceScratch_(kRenderChunkFrames * voices_.size(), 0.0f),
+          oversampledScratch_(kOversampling * kRenderChunkFrames * voices_.size(), 0.0f),
+          courseScratch_(kOversampling * kRenderChunkFrames * voices_.size(), 0.0f) {
+        voiceLimit_ = maxVoices_;
+        groups_.reserve((voices_.size() + dsp::simd::kLanes - 1) / dsp::simd::kLanes);
+        // The pool is built once here; note-on, steal and retire only move
+        // indices between the active and free lists.
+        activeVoices_.reserve(voices_.size());
+        freeVoices_.reserve(voices_.size());
+        for (std::size_t i = voices_.size(); i > 0; --i) {
+            freeVoices_.push_back(i - 1);
+        }
+        // Strings reserve for the oversampled rate, so any voice can take
+        // either without allocating at note-on.
+        for (auto& voice : voices_) {
+            voice.string.prepare(kOversampling * sampleRate_);
+            voice.course.prepare(kOversampling * sampleRate_);
+            voice.envelope.setSampleRate(sampleRate_);
+            voice.envelope.setAttackSeconds(attackSeconds_);
+            voice.envelope.setReleaseSeconds(releaseSeconds_);
+        }
+        countBytes();
+    }
+
+    void setSampleRate(double sampleRate) {
+        if (sampleRate <= 0.0) {
+            return;
+        }
+        sampleRate_ = sampleRate;
+        modulation_.setSampleRate(sampleRate_);
+        for (auto& voice : voices_) {
+            voice.string.prepare(kOversampling * sampleRate_);
+            voice.course.prepare(kOversampling * sampleRate_);
+            voice.envelope.setSampleRate(sampleRate_);
+            if (voice.frozen) {
+                voice.frozenStep = frozenStep(voice);
+            }
+        }
+        countBytes();
+    }
+
+    // Voices already sounding keep their LFO phase and envelope.
+    void setModulation(const ModulationSettings& settings) {
+        modulation_.configure(settings, sampleRate_);
+    }
+
+    void setAttackSeconds(double seconds) {
+        attackSeconds_ = std::max(0.0, seconds);
+        for (auto& voice : voices_) {
+            voice.envelope.setAttackSeconds(attackSeconds_);
+        }
+    }
+
+    void setReleaseSeconds(double seconds) {
+        releaseSeconds_ = std::max(0.0, seconds);
+        for (auto& voice : voices_) {
+            if (!voice.ghost) {
+                voice.envelope.setReleaseSeconds(releaseSeconds_);
+            }
+        }
+    }
+
+    // Pitch bend in semitones, reached over kParamSmoothingSeconds unless
+    // `immediate`. Bend and vibrato retune sounding strings in place.
+    void setPitchBend(double semitones, bool immediate) {
+        bendTarget_ = semitones;
+        if (immediate) {
+            bendSemitones_ = semitones;
+        }
+    }
+
+    // Sustain holds every note released while it is down; sostenuto holds
+    // only the notes whose keys were down when it went down. Lifting either
+    // releases the notes nothing holds any more.
+    void setSustainPedal(bool down) {
+        if (down == sustainDown_) {
+            return;
+        }
+        sustainDown_ = down;
+        if (!down) {
+            releaseUnheldVoices();
+        }
+    }
+
+    void setSostenutoPedal(bool down) {
+        if (down == sostenutoDown_) {
+            return;
+        }
+        sostenutoDown_ = down;
+        for (std::size_t index : activeVoices_) {
+            Voice& voice = voices_[index];
+            voice.sostenuto = down && voice.keyDown && !voice.ghost;
+        }
+        if (!down) {
+            releaseUnheldVoices();
+        }
+    }
+
+    void setVibratoRate(double hz) { vibratoRate_ = std::max(0.0, hz); }
+
+    void setVibratoDepth(double semitones) { vibratoDepth_ = std::max(0.0, semitones); }
+
+    // Voices allowed to sound, at most maxVoices (0 lifts the cap). Lowering
+    // it fades the voices over the cap out like stolen ones.
+    void setVoiceLimit(std::size_t limit) {
+        limit = limit == 0 ? maxVoices_ : std::min(limit, maxVoices_);
+        if (limit == voiceLimit_) {
+            return;
+        }
+        voiceLimit_ = limit;
+        while (activeVoices_.size() - ghostCount_ > voiceLimit_) {
+            fadeOutVoice(*stealCandidate());
+        }
+    }
+
+    // Summed VoiceCost() allowed to sound (0 lifts it). A note that does not
+    // fit steals voices, fewest per cost first, until it does; lowering it
+    // fades voices out the same way. One voice always sounds.
+    void setVoiceBudget(float budget) {
+        budget = std::max(0.0f, budget);
+        if (budget == costBudget_) {
+            return;
+        }
+        costBudget_ = budget;
+        while (activeVoices_.size() - ghostCount_ > 1 && !withinBudget(0.0f, nullptr)) {
+            fadeOutVoice(*stealCandidate());
+        }
+    }
+
+    // Scales every voice's pan position; sounding voices glide to the new
+    // width over one block.
+    void setStereoSpread(float spread) { stereoSpread_ = std::clamp(spread, 0.0f, 1.0f); }
+
+    // Body response commuted into new notes' excitations (null: none), at
+    // the engine rate and at kOversampling times it. Not copied; the caller
+    // keeps both valid.
+    void setBodyResponse(const float* response, std::size_t frames, const float* oversampled,
+                         std::size_t oversampledFrames) {
+        bodyResponse_ = response;
+        bodyResponseFrames_ = response ? frames : 0;
+        bodyResponseOversampled_ = response ? oversampled : nullptr;
+        bodyResponseOversampledFrames_ = bodyResponseOversampled_ ? oversampledFrames : 0;
+    }
+
+    // Pitch from which new notes render oversampled; 0 turns it off.
+    void setOversamplingThreshold(double frequencyHz) {
+        oversamplingThresholdHz_ = std::max(0.0, frequencyHz);
+    }
+
+    // Shared by the parts' strings from their next strike; null: none.
+    void setExcitationPool(synthesis::ExcitationPool* pool) { excitationPool_ = pool; }
+
+    // New notes play `notes` back instead of modelling (null: modelled).
+    // Not owned; the caller keeps it until playsFrozenNotes() is false.
+    void setFrozenNotes(const FrozenNotes* notes) { frozenNotes_ = notes; }
+    bool playsFrozenNotes(const FrozenNotes* notes) const {
+        return std::any_of(activeVoices_.begin(), activeVoices_.end(), [&](std::size_t index) {
+            return voices_[index].frozenSource == notes;
+        });
+    }
+
+    void noteOn(int noteId, double frequency, float velocity,
+                const synthesis::StringConfig& config) {
+        if (frequency <= 0.0) {
+            return;
+        }
+        // A retriggered note fades its old pluck out like a stolen voice
+        // instead of cutting it off.
+        Voice* voice = findVoiceByNote(noteId);
+        if (voice && !voice->envelope.isIdle()) {
+            // A key struck again while a pedal holds its note re-excites the
+            // same string, so pedalled repeats never take another voice.
+            if (!voice->keyDown && !voice->envelope.isReleasing() && !voice->frozen &&
+                restrikeVoice(*voice, frequency, velocity, config)) {
+                return;
+            }
+            voice = replaceVoice(voice);
+        }
+        const bool oversampled = !frozenNotes_ && oversamplingThresholdHz_ > 0.0 &&
+                                 frequency * pitchRatio_ >= oversamplingThresholdHz_;
+        const bool doubled = !frozenNotes_ && config.courseDetuneCents > 0.0f;
+        const float cost = frozenNotes_ ? kFrozenVoiceCost
+                                        : VoiceCost(config, frequency * pitchRatio_, sampleRate_,
+                                                    oversampled, doubled);
+        if (!voice) {
+            voice = allocateVoice(cost);
+        }
+        if (!voice) {
+            return;
+        }
+        voice->noteId = noteId;
+        voice->frequency = frequency;
+        voice->velocity = velocity;
+        voice->age = ++ageCounter_;
+        voice->cost = cost;
+        voice->energy = 0.0f;
+        voice->keyDown = true;
+        voice->sostenuto = false;
+        voice->bendTarget = 0.0;
+        voice->bendSemitones = 0.0;
+        voice->pan = PanPosition(frequency, velocity);
+        PanGains(stereoSpread_ * voice->pan, voice->panLeft, voice->panRight);
+
+        voice->oversampled = oversampled;
+        voice->decimator.reset();
+        voice->doubled = doubled;
+        // Half the detune either side keeps the pair centred on the note.
+        voice->courseSpread =
+            doubled ? dsp::FastExp2(static_cast<double>(config.courseDetuneCents) / 2400.0) : 1.0;
+
+        synthesis::StringConfig voiceConfig = config;
+        const float amp = ExpressiveMapping::Apply(velocity, frequency, config, voiceConfig);
+        modulation_.startVoice(voice->mod, velocity, frequency);
+        if (frozenNotes_) {
+            startFrozen(*voice, velocity);
+        } else {
+            voice->frozenSource = nullptr;
+            voice->frozen = nullptr;
+            applyModulation(*voice, voiceConfig);
+            applyVoiceRate(*voice, voiceConfig);
+            voice->string.updateConfig(voiceConfig);
+            setVoiceBodyResponse(*voice);
+            voice->string.setExcitationPool(excitationPool_);
+            voice->string.start(frequency * pitchRatio_ / voice->courseSpread, velocity);
+            if (voice->doubled) {
+                voice->course.updateConfig(voiceConfig);
+                voice->course.startCourse(voice->string,
+                                          frequency * pitchRatio_ * voice->courseSpread);
+            }
+        }
+
+        voice->envelope.setSampleRate(sampleRate_);
+        voice->envelope.setAttackSeconds(attackSeconds_);
+        voice->envelope.setReleaseSeconds(releaseSeconds_);
+        voice->envelope.noteOn(amp);
+    }
+
+    void noteOff(int noteId) {
+        if (noteId < 0) {
+            return;
+        }
+        for (std::size_t index : activeVoices_) {
+            Voice& voice = voices_[index];
+            if (voice.noteId == noteId) {
+                voice.keyDown = false;
+                if (!sustainDown_ && !voice.sostenuto) {
+                    voice.envelope.setReleaseSeconds(releaseSeconds_);
+                    voice.envelope.noteOff();
+                }
+            }
+        }
+    }
+
+    // Sets the sounding note's slot; released notes still take it, so a
+    // bend can follow the string into its release.
+    void noteExpression(int noteId, NoteExpression expression, float value) {
+        Voice* voice = findVoiceByNote(noteId);
+        if (!voice) {
+            return;
+        }
+        switch (expression) {
+            case NoteExpression::PitchBend:
+                voice->bendTarget = value;
+                break;
+            case NoteExpression::Pressure:
+                voice->mod.pressure = value;
+                break;
+            case NoteExpression::Timbre:
+                voice->mod.timbre = 2.0f * value - 1.0f;
+                break;
+        }
+    }
+
+    // Renders up to kRenderChunkFrames frames of the voice mix into `left`
+    // and `right` (overwritten), before master gain. While every voice sits
+    // in the middle only `left` is written and the call returns false: the
+    // mix is mono. Callers split blocks at event boundaries so that voice
+    // state only changes between calls.
+    bool renderBlock(float* left, float* right, std::size_t frames) {
+        frames = std::min(frames, kRenderChunkFrames);
+        std::fill(left, left + frames, 0.0f);
+        updatePitchModulation(frames);
+
+        // Strings render in groups of simd::kLanes, each voice into its own
+        // scratch slot, so groups can run on any thread. The mix is summed
+        // afterwards in active-list order, which keeps the output identical
+        // with or without the render pool.
+        // Oversampled voices are grouped after the others, since a group
+        // runs at one rate, and frozen ones last.
+        groups_.clear();
+        std::size_t slot = 0;
+        for (const VoiceKind kind : {VoiceKind::Modelled, VoiceKind::Oversampled,
+                                     VoiceKind::Frozen}) {
+            for (std::size_t index : activeVoices_) {
+                Voice& voice = voices_[index];
+                if (voice.envelope.isIdle() || KindOf(voice) != kind) {
+                    continue;
+                }
+                const bool doubled = voice.doubled && kind != VoiceKind::Frozen;
+                const std::size_t lanes = doubled ? 2 : 1;
+                if (groups_.empty() || groups_.back().lanes + lanes > dsp::simd::kLanes ||
+                    groups_.back().kind != kind) {
+                    groups_.push_back({});
+                    groups_.back().kind = kind;
+                }
+                VoiceGroup& group = groups_.back();
+                group.voices[group.count] = &voice;
+                group.outs[group.count] = voiceScratch_.data() + slot * kRenderChunkFrames;
+                group.renders[group.count] =
+                    kind == VoiceKind::Oversampled
+                        ? oversampledScratch_.data() + slot * kOversampling * kRenderChunkFrames
+                        : group.outs[group.count];
+                group.courseRenders[group.count] =
+                    doubled ? courseScratch_.data() + slot * kOversampling * kRenderChunkFrames
+                            : nullptr;
+                ++group.count;
+                group.lanes += lanes;
+                ++slot;
+            }
+        }
+
+        groupFrames_ = frames;
+        if (renderPool_) {
+            renderPool_->run(&VoiceManager::RenderGroupJob, this, groups_.size());
+        } else {
+            for (std::size_t g = 0; g < groups_.size(); ++g) {
+                renderGroup(g);
+            }
+        }
+        controlPhase_ = (controlPhase_ + frames) % ModulationMatrix::kControlFrames;
+
+        // Pans are set per block: each voice ramps from the gains it ended
+        // the last block on to those of its current position. Those only
+        // move when the spread does, since note-on starts a voice on them.
+        bool stereo = stereoSpread_ > 0.0f;
+        for (std::size_t g = 0; g < groups_.size() && !stereo; ++g) {
+            for (std::size_t v = 0; v < groups_[g].count; ++v) {
+                const Voice& voice = *groups_[g].voices[v];
+                stereo = stereo || voice.panLeft != 1.0f || voice.panRight != 1.0f;
+            }
+        }
+        if (stereo) {
+            std::fill(right, right + frames, 0.0f);
+            for (const VoiceGroup& group : groups_) {
+                for (std::size_t v = 0; v < group.count; ++v) {
+                    Voice& voice = *group.voices[v];
+                    float gainL = voice.panLeft;
+                    float gainR = voice.panRight;
+                    if (stereoSpread_ != appliedSpread_) {
+                        PanGains(stereoSpread_ * voice.pan, gainL, gainR);
+                    }
+                    MixPanned(group.outs[v], left, right, frames, voice.panLeft, gainL,
+                              voice.panRight, gainR);
+                    voice.panLeft = gainL;
+                    voice.panRight = gainR;
+                }
+            }
+        } else {
+            for (std::size_t v = 0; v < slot; ++v) {
+                const float* voiceOut = voiceScratch_.data() + v * kRenderChunkFrames;
+                for (std::size_t i = 0; i < frames; ++i) {
+                    left[i] += voiceOut[i];
+                }
+            }
+        }
+
+        appliedSpread_ = stereoSpread_;
+        cleanupSilentVoices();
+        return stereo;
+    }
+
+    // Includes voices still fading out after a steal.
+    std::size_t activeVoices() const { return activeVoices_.size(); }
+
+    // Cuts every voice (no release) and restores the fresh allocation order.
+    void reset() {
+        for (std::size_t index : activeVoices_) {
+            voices_[index].noteId = -1;
+            voices_[index].ghost = false;
+        }
+        activeVoices_.clear();
+        freeVoices_.clear();
+        for (std::size_t i = voices_.size(); i > 0; --i) {
+            freeVoices_.push_back(i - 1);
+        }
+        ghostCount_ = 0;
+        ageCounter_ = 0;
+        controlPhase_ = 0;
+        bendSemitones_ = bendTarget_;
+        vibratoPhase_ = 0.0;
+        pitchRatio_ = dsp::FastExp2(bendSemitones_ / 12.0);
+    }
+
+    // Not owned; null renders every voice on the calling thread.
+    void setRenderPool(VoiceRenderPool* pool) { renderPool_ = pool; }
+
+    // The sounding voices in active-list order, the free list and the
+    // bend, vibrato and pedal state, for an engine snapshot. Frozen notes
+    // are not kept: their voices go back on the free list.
+    void saveState(dsp::StateWriter& out) const {
+        out.pod(voices_.size());
+        out.pod(ageCounter_);
+        out.pod(bendTarget_);
+        out.pod(bendSemitones_);
+        out.pod(vibratoPhase_);
+        out.pod(pitchRatio_);
+        out.pod(sustainDown_);
+        out.pod(sostenutoDown_);
+        out.pod(appliedSpread_);
+        out.pod(controlPhase_);
+        std::vector<std::size_t> free;
+        std::vector<std::size_t> active;
+        for (std::size_t index : activeVoices_) {
+            (voices_[index].frozen ? free : active).push_back(index);
+        }
+        free.insert(free.end(), freeVoices_.begin(), freeVoices_.end());
+        out.pod(active.size());
+        for (std::size_t index : active) {
+            out.pod(index);
+            saveVoice(voices_[index], out);
+        }
+        out.pod(free.size());
+        for (std::size_t index : free) {
+            out.pod(index);
+        }
+    }
+
+    // Takes what saveState() wrote on a manager with as many voices at the
+    // same rate; false (every voice cut, as by reset()) if it does not fit.
+    bool loadState(dsp::StateReader& in) {
+        reset();
+        std::size_t voices = 0;
+        if (in.pod(voices) && voices != voices_.size()) {
+            in.fail();
+        }
+        in.pod(ageCounter_);
+        in.pod(bendTarget_);
+        in.pod(bendSemitones_);
+        in.pod(vibratoPhase_);
+        in.pod(pitchRatio_);
+        in.pod(sustainDown_);
+        in.pod(sostenutoDown_);
+        in.pod(appliedSpread_);
+        in.pod(controlPhase_);
+        // Every slot once, either sounding or free.
+        std::vector<bool> seen(voices_.size(), false);
+        auto takeIndex = [&](std::size_t& index) {
+            if (in.pod(index) && (index >= voices_.size() || seen[index])) {
+                in.fail();
+            }
+            if (in.ok()) {
+                seen[index] = true;
+            }
+            return in.ok();
+        };
+        activeVoices_.clear();
+        freeVoices_.clear();
+        std::size_t count = 0;
+        if (in.pod(count) && count > voices_.size()) {
+            in.fail();
+        }
+        for (std::size_t i = 0; i < count && in.ok(); ++i) {
+            std::size_t index = 0;
+            if (takeIndex(index) && loadVoice(voices_[index], in)) {
+                activeVoices_.push_back(index);
+            }
+        }
+        if (in.pod(count) && count != voices_.size() - activeVoices_.size()) {
+            in.fail();
+        }
+        for (std::size_t i = 0; i < count && in.ok(); ++i) {
+            std::size_t index = 0;
+            if (takeIndex(index)) {
+                freeVoices_.push_back(index);
+            }
+        }
+        if (!in.ok()) {
+            reset();
+            return false;
+        }
+        ghostCount_ = static_cast<std::size_t>(
+            std::count_if(activeVoices_.begin(), activeVoices_.end(),
+                          [&](std::size_t index) { return voices_[index].ghost; }));
+        return true;
+    }
+
+private:
+    static void saveVoice(const Voice& voice, dsp::StateWriter& out) {
+        out.pod(voice.envelope);
+        out.pod(voice.velocity);
+        out.pod(voice.energy);
+        out.pod(voice.pan);
+        out.pod(voice.panLeft);
+        out.pod(voice.panRight);
+        out.pod(voice.noteId);
+        out.pod(voice.frequency);
+        out.pod(voice.age);
+        out.pod(voice.cost);
+        out.pod(voice.ghost);
+        out.pod(voice.keyDown);
+        out.pod(voice.sostenuto);
+        out.pod(voice.mod);
+        out.pod(voice.bendTarget);
+        out.pod(voice.bendSemitones);
+        out.pod(voice.baseBrightness);
+        out.pod(voice.baseDecay);
+        out.pod(voice.basePick);
+        out.pod(voice.oversampled);
+        out.pod(voice.decimator);
+        out.pod(voice.doubled);
+        out.pod(voice.courseSpread);
+        voice.string.saveState(out);
+        if (voice.doubled) {
+            voice.course.saveState(out);
+        }
+    }
+
+    bool loadVoice(Voice& voice, dsp::StateReader& in) const {
+        in.pod(voice.envelope);
+        in.pod(voice.velocity);
+        in.pod(voice.energy);
+        in.pod(voice.pan);
+        in.pod(voice.panLeft);
+        in.pod(voice.panRight);
+        in.pod(voice.noteId);
+        in.pod(voice.frequency);
+        in.pod(voice.age);
+        in.pod(voice.cost);
+        in.pod(voice.ghost);
+        in.pod(voice.keyDown);
+        in.pod(voice.sostenuto);
+        in.pod(voice.mod);
+        in.pod(voice.bendTarget);
+        in.pod(voice.bendSemitones);
+        in.pod(voice.baseBrightness);
+        in.pod(voice.baseDecay);
+        in.pod(voice.basePick);
+        in.pod(voice.oversampled);
+        in.pod(voice.decimator);
+        in.pod(voice.doubled);
+        in.pod(voice.courseSpread);
+        voice.frozenSource = nullptr;
+        voice.frozen = nullptr;
+        if (in.ok()) {
+            voice.string.loadState(in);
+        }
+        if (in.ok() && voice.doubled) {
+            voice.course.loadState(in);
+        }
+        setVoiceBodyResponse(voice);
+        voice.string.setExcitationPool(excitationPool_);
+        return in.ok();
+    }
+
+    enum class VoiceKind : std::uint8_t { Modelled, Oversampled, Frozen };
+
+    static VoiceKind KindOf(const Voice& voice) {
+        if (voice.frozen) {
+            return VoiceKind::Frozen;
+        }
+        return voice.oversampled ? VoiceKind::Oversampled : VoiceKind::Modelled;
+    }
+
+    // A doubled voice takes two lanes, its course next to its string.
+    struct VoiceGroup {
+        Voice* voices[dsp::simd::kLanes] = {};
+        float* outs[dsp::simd::kLanes] = {};
+        float* renders[dsp::simd::kLanes] = {};  // the strings' own rate; outs at 1x
+        float* courseRenders[dsp::simd::kLanes] = {};  // null unless doubled
+        std::size_t count = 0;
+        std::size_t lanes = 0;
+        VoiceKind kind = VoiceKind::Modelled;
+    };
+
+    static void RenderGroupJob(void* context, std::size_t group) {
+        static_cast<VoiceManager*>(context)->renderGroup(group);
+    }
+
+    void renderGroup(std::size_t g) {
+        VoiceGroup& group = groups_[g];
+        const std::size_t frames = groupFrames_;
+        if (group.kind == VoiceKind::Frozen) {
+            for (std::size_t v = 0; v < group.count; ++v) {
+                renderFrozen(*group.voices[v], group.outs[v], frames);
+            }
+        } else {
+            synthesis::KarplusStrongString* strings[dsp::simd::kLanes] = {};
+            float* renders[dsp::simd::kLanes] = {};
+            std::size_t lanes = 0;
+            for (std::size_t v = 0; v < group.count; ++v) {
+                strings[lanes] = &group.voices[v]->string;
+                renders[lanes++] = group.renders[v];
+                if (group.courseRenders[v]) {
+                    strings[lanes] = &group.voices[v]->course;
+                    renders[lanes++] = group.courseRenders[v];
+                }
+            }
+            const std::size_t factor = group.kind == VoiceKind::Oversampled ? kOversampling : 1;
+            if (modulation_.active()) {
+                renderModulated(group, strings, renders, lanes, frames, factor);
+            } else {
+                synthesis::KarplusStrongString::processBlockLanes(strings, renders, lanes,
+                                                                  frames * factor);
+            }
+            for (std::size_t v = 0; v < group.count; ++v) {
+                if (const float* course = group.courseRenders[v]) {
+                    float* render = group.renders[v];
+                    for (std::size_t i = 0; i < frames * factor; ++i) {
+                        render[i] = 0.5f * (render[i] + course[i]);
+                    }
+                }
+            }
+        }
+        if (group.kind == VoiceKind::Oversampled) {
+            for (std::size_t v = 0; v < group.count; ++v) {
+                group.voices[v]->decimator.process(group.renders[v], group.outs[v], frames);
+            }
+        }
+        alignas(16) float gains[kRenderChunkFrames];
+        for (std::size_t v = 0; v < group.count; ++v) {
+            Voice& voice = *group.voices[v];
+            float* samples = group.outs[v];
+            voice.envelope.render(gains, frames);
+            float energy = voice.energy;
+            for (std::size_t i = 0; i < frames; ++i) {
+                const float sample = samples[i] * gains[i] * voice.velocity;
+                energy = kEnergyDecay * energy + (1.0f - kEnergyDecay) * std::abs(sample);
+                samples[i] = sample;
+            }
+            voice.energy = energy;
+        }
+    }
+
+    // Linear interpolation through the voice's sample; zeros past its end.
+    static void renderFrozen(Voice& voice, float* out, std::size_t frames) {
+        const std::vector<std::int16_t>& samples = voice.frozen->samples;
+        const double last = static_cast<double>(samples.size()) - 1.0;
+        double pos = voice.frozenPos;
+        std::size_t i = 0;
+        for (; i < frames && pos < last; ++i) {
+            const auto index = static_cast<std::size_t>(pos);
+            const float frac = static_cast<float>(pos - static_cast<double>(index));
+            const float a = samples[index];
+            const float b = samples[index + 1];
+            out[i] = voice.frozenGain * (a + (b - a) * frac);
+            pos += voice.frozenStep;
+        }
+        std::fill(out + i, out + frames, 0.0f);
+        voice.frozenPos = pos;
+    }
+
+    void startFrozen(Voice& voice, float velocity) const {
+        const FrozenNotes::Note& note = frozenNotes_->nearest(voice.frequency, velocity);
+        voice.frozenSource = frozenNotes_;
+        voice.frozen = &note;
+        voice.frozenPos = 0.0;
+        // Levels follow velocity between the layers.
+        voice.frozenGain = note.scale * velocity / note.velocity;
+        voice.frozenStep = frozenStep(voice);
+    }
+
+    double frozenStep(const Voice& voice) const {
+        return voice.frequency * voiceRatio(voice) / voice.frozen->frequency *
+               voice.frozenSource->sampleRate() / sampleRate_;
+    }
+
+    // Renders the group's strings (`lanes` of them, courses included) in
+    // pieces that end on the manager-wide control boundaries; at each
+    // boundary every voice ticks its modulation and its loops glide to the
+    // new brightness and decay over the period. Voices only touch their own
+    // state, so groups stay independent. `factor` is the group's
+    // oversampling: frames count at the engine rate.
+    void renderModulated(VoiceGroup& group, synthesis::KarplusStrongString* const* strings,
+                         float* const* renders, std::size_t lanes, std::size_t frames,
+                         std::size_t factor) {
+        constexpr std::size_t kPeriod = ModulationMatrix::kControlFrames;
+        float* outs[dsp::simd::kLanes] = {};
+        std::size_t phase = controlPhase_;
+        for (std::size_t done = 0; done < frames;) {
+            if (phase == 0) {
+                for (std::size_t v = 0; v < group.count; ++v) {
+                    Voice& voice = *group.voices[v];
+                    modulation_.tick(voice.mod);
+                    const float brightness =
+                        LoopBrightness(voice, Modulated(ParamId::Brightness, voice.baseBrightness,
+                                                        voice.mod, ModTarget::Brightness));
+                    const float decay =
+                        Modulated(ParamId::Decay, voice.baseDecay, voice.mod, ModTarget::Decay);
+                    voice.string.modulateLoop(brightness, decay, kPeriod * factor);
+                    if (voice.doubled) {
+                        voice.course.modulateLoop(brightness, decay, kPeriod * factor);
+                    }
+                }
+            }
+            const std::size_t piece = std::min(frames - done, kPeriod - phase);
+            for (std::size_t lane = 0; lane < lanes; ++lane) {
+                outs[lane] = renders[lane] + done * factor;
+            }
+            synthesis::KarplusStrongString::processBlockLanes(strings, outs, lanes,
+                                                              piece * factor);
+            done += piece;
+            phase = (phase + piece) % kPeriod;
+        }
+    }
+
+    static float Modulated(ParamId id, float base, const ModulationMatrix::VoiceState& state,
+                           ModTarget target) {
+        const float value = base + ModulationMatrix::Offset(state, target);
+        const ParamInfo* info = GetParamInfo(id);
+        return info ? ClampToRange(*info, value) : value;
+    }
+
+    // The loop lowpass is one pole per sample: an oversampled string takes
+    // the square root of the pole so its loop still loses the same per
+    // second, i.e. keeps the tone it would have at the engine rate.
+    static float LoopBrightness(const Voice& voice, float brightness) {
+        if (!voice.oversampled) {
+            return brightness;
+        }
+        return 1.0f - std::sqrt(std::clamp(1.0f - brightness, 0.0f, 1.0f));
+    }
+
+    // Runs after applyModulation(), which records the unscaled values.
+    void applyVoiceRate(const Voice& voice, synthesis::StringConfig& voiceConfig) const {
+        voiceConfig.sampleRate = voice.oversampled ? kOversampling * sampleRate_ : sampleRate_;
+        voiceConfig.brightness = LoopBrightness(voice, voiceConfig.brightness);
+    }
+
+    void setVoiceBodyResponse(Voice& voice) const {
+        if (voice.oversampled) {
+            voice.string.setBodyResponse(bodyResponseOversampled_, bodyResponseOversampledFrames_);
+            voice.course.setBodyResponse(bodyResponseOversampled_, bodyResponseOversampledFrames_);
+        } else {
+            voice.string.setBodyResponse(bodyResponse_, bodyResponseFrames_);
+            voice.course.setBodyResponse(bodyResponse_, bodyResponseFrames_);
+        }
+    }
+
+    // Records the strike's values and, with routes set, moves them by the
+    // voice's current offsets. Pick position only takes effect here.
+    void applyModulation(Voice& voice, synthesis::StringConfig& voiceConfig) const {
+        voice.baseBrightness = voiceConfig.brightness;
+        voice.baseDecay = voiceConfig.decay;
+        voice.basePick = voiceConfig.pickPosition;
+        if (!modulation_.active()) {
+            return;
+        }
+        voiceConfig.brightness =
+            Modulated(ParamId::Brightness, voice.baseBrightness, voice.mod, ModTarget::Brightness);
+        voiceConfig.decay = Modulated(ParamId::Decay, voice.baseDecay, voice.mod, ModTarget::Decay);
+        voiceConfig.pickPosition = Modulated(ParamId::PickPosition, voice.basePick, voice.mod,
+                                             ModTarget::PickPosition);
+    }
+
+    // Control-rate pitch: bend and vibrato are evaluated once per chunk, at
+    // its end, and each string ramps its tuning allpass to the new value
+    // across the chunk, so the per-sample cost is one add per voice.
+    void updatePitchModulation(std::size_t frames) {
+        const double chunkSeconds = static_cast<double>(frames) / sampleRate_;
+        bendSemitones_ += (bendTarget_ - bendSemitones_) *
+                          (1.0 - std::exp(-chunkSeconds / kParamSmoothingSeconds));
+        if (std::abs(bendTarget_ - bendSemitones_) < 1e-4) {
+            bendSemitones_ = bendTarget_;
+        }
+        double semitones = bendSemitones_;
+        if (vibratoDepth_ > 0.0) {
+            vibratoPhase_ += vibratoRate_ * chunkSeconds;
+            vibratoPhase_ -= std::floor(vibratoPhase_);
+            semitones += vibratoDepth_ * std::sin(2.0 * kPi * vibratoPhase_);
+        } else {
+            vibratoPhase_ = 0.0;  // the next vibrato starts from the note's pitch
+        }
+        const double ratio = dsp::FastExp2(semitones / 12.0);
+        const bool retune = ratio != pitchRatio_;
+        pitchRatio_ = ratio;
+        const double glide = 1.0 - std::exp(-chunkSeconds / kParamSmoothingSeconds);
+        for (std::size_t index : activeVoices_) {
+            Voice& voice = voices_[index];
+            // A note's own bend glides like the manager's.
+            bool bent = false;
+            if (voice.bendSemitones != voice.bendTarget) {
+                voice.bendSemitones += (voice.bendTarget - voice.bendSemitones) * glide;
+                if (std::abs(voice.bendTarget - voice.bendSemitones) < 1e-4) {
+                    voice.bendSemitones = voice.bendTarget;
+                }
+                bent = true;
+            }
+            if ((retune || bent) && !voice.envelope.isIdle()) {
+                if (voice.frozen) {
+                    voice.frozenStep = frozenStep(voice);
+                } else {
+                    const double frequency = voice.frequency * voiceRatio(voice);
+                    const std::size_t glide = voice.oversampled ? frames * kOversampling : frames;
+                    voice.string.setFrequency(frequency / voice.courseSpread, glide);
+                    if (voice.doubled) {
+                        voice.course.setFrequency(frequency * voice.courseSpread, glide);
+                    }
+                }
+            }
+        }
+    }
+
+    // The manager's bend and vibrato times the note's own bend.
+    double voiceRatio(const Voice& voice) const {
+        return voice.bendSemitones == 0.0 ? pitchRatio_
+                                          : pitchRatio_ * dsp::FastExp2(voice.bendSemitones / 12.0);
+    }
+
+    // Adds a new strike to a sounding voice. Its envelope and velocity gain
+    // carry the old note's level, so the strike is scaled to sound as loud as
+    // a fresh note at `velocity` would. False if the voice is too quiet for
+    // that (the caller starts a new one).
+    bool restrikeVoice(Voice& voice, double frequency, float velocity,
+                       const synthesis::StringConfig& config) {
+        const float held = voice.envelope.level() * voice.velocity;
+        if (held < kEnvelopeFloor) {
+            return false;
+        }
+        // The string keeps the rate and course it was started with.
+        synthesis::StringConfig voiceConfig = config;
+        const float amp = ExpressiveMapping::Apply(velocity, frequency, config, voiceConfig);
+        // The note's expression carries over to the new strike.
+        const float pressure = voice.mod.pressure;
+        const float timbre = voice.mod.timbre;
+        modulation_.startVoice(voice.mod, velocity, frequency);
+        voice.mod.pressure = pressure;
+        voice.mod.timbre = timbre;
+        applyModulation(voice, voiceConfig);
+        applyVoiceRate(voice, voiceConfig);
+        voice.string.updateConfig(voiceConfig);
+        // The body the note started with may have been swapped out since.
+        setVoiceBodyResponse(voice);
+        voice.string.setExcitationPool(excitationPool_);
+        const double tuned = frequency * voiceRatio(voice);
+        const float gain = amp * velocity / held;
+        voice.string.restrike(tuned / voice.courseSpread, velocity, gain);
+        if (voice.doubled) {
+            voice.course.updateConfig(voiceConfig);
+            voice.course.restrikeCourse(voice.string, tuned * voice.courseSpread, gain);
+        }
+        voice.frequency = frequency;
+        voice.age = ++ageCounter_;
+        voice.keyDown = true;
+        return true;
+    }
+
+    void releaseUnheldVoices() {
+        for (std::size_t index : activeVoices_) {
+            Voice& voice = voices_[index];
+            if (voice.ghost || voice.keyDown || voice.envelope.isReleasing() ||
+                voice.envelope.isIdle() || sustainDown_ || voice.sostenuto) {
+                continue;
+            }
+            voice.envelope.setReleaseSeconds(releaseSeconds_);
+            voice.envelope.noteOff();
+        }
+    }
+
+    Voice* findVoiceByNote(int noteId) {
+        for (std::size_t index : activeVoices_) {
+            if (!voices_[index].ghost && voices_[index].noteId == noteId) {
+                return &voices_[index];
+            }
+        }
+        return nullptr;
+    }
+
+    Voice* takeFreeVoice() {
+        const std::size_t index = freeVoices_.back();
+        freeVoices_.pop_back();
+        activeVoices_.push_back(index);
+        return &voices_[index];
+    }
+
+    // A voice for a note costing `cost`, within both the voice limit and the
+    // budget; null only when nothing can be stolen.
+    Voice* allocateVoice(float cost) {
+        const bool underLimit = activeVoices_.size() - ghostCount_ < voiceLimit_;
+        if (!freeVoices_.empty() && underLimit && withinBudget(cost, nullptr)) {
+            return takeFreeVoice();
+        }
+        Voice* candidate = stealCandidate();
+        if (!candidate) {
+            return !freeVoices_.empty() && underLimit ? takeFreeVoice() : nullptr;
+        }
+        Voice* slot = replaceVoice(candidate);
+        // An expensive note may need more than one steal to fit.
+        while (!withinBudget(cost, slot)) {
+            Voice* extra = stealCandidate(slot);
+            if (!extra) {
+                break;
+            }
+            fadeOutVoice(*extra);
+        }
+        return slot;
+    }
+
+    // Whether a note costing `cost` fits next to the sounding voices other
+    // than `skip`.
+    bool withinBudget(float cost, const Voice* skip) const {
+        if (costBudget_ <= 0.0f) {
+            return true;
+        }
+        float total = cost;
+        for (std::size_t index : activeVoices_) {
+            const Voice& v = voices_[index];
+            if (!v.ghost && &v != skip) {
+                total += v.cost;
+            }
+        }
+        return total <= costBudget_;
+    }
+
+    // Voice stealing: prefer releasing voices, then notes only a pedal
+    // holds, otherwise the lowest energy per VoiceCost(), then oldest. Null
+    // without a sounding voice other than `skip`.
+    Voice* stealCandidate(const Voice* skip = nullptr) {
+        Voice* candidate = nullptr;
+        for (std::size_t index : activeVoices_) {
+            Voice& v = voices_[index];
+            if (v.ghost || &v == skip) {
+                continue;
+            }
+            if (!candidate) {
+                candidate = &v;
+                continue;
+            }
+            const Voice& best = *candidate;
+            bool better = false;
+            if (v.envelope.isReleasing() != best.envelope.isReleasing()) {
+                better = v.envelope.isReleasing();
+            } else if (v.keyDown != best.keyDown) {
+                better = !v.keyDown;
+            } else if (std::abs(v.energy / v.cost - best.energy / best.cost) >
+                       std::numeric_limits<float>::epsilon()) {
+                better = v.energy / v.cost < best.energy / best.cost;
+            } else {
+                better = v.age < best.age;
+            }
+            if (better) {
+                candidate = &v;
+            }
+        }
+        return candidate;
+    }
+
+    // Moves `voice` into a ghost slot that fades it out over
+    // kStealFadeSeconds and returns the voice the new note should use: a
+    // free slot, else the quietest other ghost (cut, it is mostly faded),
+    // else `voice` itself restarted in place.
+    Voice* replaceVoice(Voice* voice) {
+        Voice* slot = nullptr;
+        if (!freeVoices_.empty()) {
+            slot = takeFreeVoice();
+        } else {
+            for (std::size_t index : activeVoices_) {
+                Voice& v = voices_[index];
+                if (v.ghost && (!slot || v.envelope.level() < slot->envelope.level())) {
+                    slot = &v;
+                }
+            }
+            if (!slot) {
+                return voice;
+            }
+            slot->ghost = false;
+            --ghostCount_;
+        }
+        fadeOutVoice(*voice);
+        return slot;
+    }
+
+    // Turns `voice` into a ghost fading out over kStealFadeSeconds.
+    void fadeOutVoice(Voice& voice) {
+        voice.noteId = -1;
+        voice.ghost = true;
+        ++ghostCount_;
+        voice.envelope.setReleaseSeconds(kStealFadeSeconds);
+        voice.envelope.noteOff();
+    }
+
+    static float StoredPeak(const Voice& voice) {
+        const float peak = voice.string.storedPeak();
+        return voice.doubled ? std::max(peak, voice.course.storedPeak()) : peak;
+    }
+
+    void cleanupSilentVoices() {
+        // Stable in-place compaction of the active list; retired voices keep
+        // their storage and go back on the free list.
+        std::size_t kept = 0;
+        for (std::size_t index : activeVoices_) {
+            Voice& voice = voices_[index];
+            // Held notes decay on their own (loop gain < 1): once the whole
+            // waveguide is below kDormantLevel the voice has nothing left to
+            // say. The O(period) scan only runs for voices already quiet.
+            const bool dormant = !voice.ghost && !voice.frozen && voice.envelope.isSustaining() &&
+                                 voice.energy < kDormantLevel &&
+                                 StoredPeak(voice) * voice.envelope.level() * voice.velocity <
+                                     kDormantLevel;
+            // A frozen note is over when its sample is.
+            const bool played = voice.frozen && voice.frozenPos >=
+                                    static_cast<double>(voice.frozen->samples.size()) - 1.0;
+            const bool silent = voice.envelope.isIdle() ||
+                                (voice.envelope.isReleasing() &&
+                                 voice.energy < kVoiceSilenceThreshold) ||
+                                dormant || played;
+            if (silent) {
+                voice.noteId = -1;
+                if (voice.ghost) {
+                    voice.ghost = false;
+                    --ghostCount_;
+                }
+                freeVoices_.push_back(index);
+            } else {
+                activeVoices_[kept++] = index;
+            }
+        }
+        activeVoices_.resize(kept);
+    }
+
+    // The pool and what prepare() gave its strings; nothing grows between.
+    void countBytes() {
+        std::size_t bytes = CapacityBytes(voices_) + CapacityBytes(activeVoices_) +
+                            CapacityBytes(freeVoices_) + CapacityBytes(voiceScratch_) +
+                            CapacityBytes(oversampledScratch_) + CapacityBytes(courseScratch_) +
+                            CapacityBytes(groups_);
+        for (const Voice& voice : voices_) {
+            bytes += voice.string.heapBytes() + voice.course.heapBytes();
+        }
+        bytes_.set(bytes);
+    }
+
+    const std::size_t maxVoices_;
+    std::size_t voiceLimit_ = 0;  // set to maxVoices_ on construction
+    float costBudget_ = 0.0f;     // 0: no budget
+    double sampleRate_ = 44100.0;
+    double attackSeconds_ = kDefaultAttackSecondsValue;
+    double releaseSeconds_ = 0.35;
+    std::uint64_t ageCounter_ = 0;
+    std::size_t ghostCount_ = 0;  // active voices that are ghosts
+    const float* bodyResponse_ = nullptr;
+    std::size_t bodyResponseFrames_ = 0;
+    const float* bodyResponseOversampled_ = nullptr;
+    std::size_t bodyResponseOversampledFrames_ = 0;
+    double oversamplingThresholdHz_ = 0.0;
+    double bendTarget_ = 0.0;
+    double bendSemitones_ = 0.0;
+    double vibratoRate_ = 5.0;
+    double vibratoDepth_ = 0.0;
+    double vibratoPhase_ = 0.0;  // cycles, [0, 1)
+    double pitchRatio_ = 1.0;    // applied to every voice's note frequency
+    bool sustainDown_ = false;
+    bool sostenutoDown_ = false;
+    float stereoSpread_ = 0.0f;
+    float appliedSpread_ = 0.0f;  // spread the voices' pan gains were set for
+    std::vector<Voice> voices_;
+    std::vector<std::size_t> activeVoices_;
+    std::vector<std::size_t> freeVoices_;
+    std::vector<float> voiceScratch_;
+    std::vector<float> oversampledScratch_;  // kOversampling x voiceScratch_
+    std::vector<float> courseScratch_;       // doubled voices' second string, likewise
+    std::vector<VoiceGroup> groups_;
+    std::size_t groupFrames_ = 0;
+    ModulationMatrix modulation_;
+    std::size_t controlPhase_ = 0;  // frames since the last control tick
+    VoiceRenderPool* renderPool_ = nullptr;
+    synthesis::ExcitationPool* excitationPool_ = nullptr;
+    const FrozenNotes* frozenNotes_ = nullptr;
+    TrackedBytes bytes_{MemoryCategory::Voices};
+};
+
+// Bounded multi-producer / single-consumer queue (Vyukov). Producers are any
+// control thread calling enqueueEvent*/setParam; the consumer is process().
+class StringSynthEngine::EventQueue {
+public:
+    static constexpr std::size_t kCapacity = 4096;  // power-of-two
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "Capacity must be power of two");
+
+    EventQueue() {
+        for (std::size_t i = 0; i < kCapacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const PackedEvent& event) {
+        Cell* cell = nullptr;
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells_[pos & (kCapacity - 1)];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff =
+                static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Full.
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->event = event;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Claims `count` consecutive cells with one CAS when the queue has room
+    // for all of them, else pushes one by one; returns how many went in.
+    // Cells are freed in order, so the last one being free means the whole
+    // run is.
+    std::size_t pushRun(const PackedEvent* events, std::size_t count) {
+        if (count == 0) {
+            return 0;
+        }
+        if (count <= kCapacity) {
+            std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+            for (;;) {
+                const std::size_t lastSeq =
+                    cells_[(pos + count - 1) & (kCapacity - 1)].sequence.load(
+                        std::memory_order_acquire);
+                const std::size_t firstSeq =
+                    cells_[pos & (kCapacity - 1)].sequence.load(std::memory_order_acquire);
+                if (firstSeq != pos || lastSeq != pos + count - 1) {
+                    break;  // not enough room, or another producer moved on
+                }
+                if (enqueuePos_.compare_exchange_weak(pos, pos + count,
+                                                      std::memory_order_relaxed)) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        Cell& cell = cells_[(pos + i) & (kCapacity - 1)];
+                        cell.event = events[i];
+                        cell.sequence.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return count;
+                }
+            }
+        }
+        std::size_t pushed = 0;
+        while (pushed < count && push(events[pushed])) {
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Consumer only.
+    bool pop(PackedEvent& out) {
+        const std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & (kCapacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        out = cell.event;
+        cell.sequence.store(pos + kCapacity, std::memory_order_release);
+        dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Diagnostics only: walks published cells without synchronizing with pop().
+    template <typename Fn>
+    void forEachPending(Fn&& fn) const {
+        const std::size_t begin = dequeuePos_.load(std::memory_order_relaxed);
+        const std::size_t end = enqueuePos_.load(std::memory_order_acquire);
+        for (std::size_t pos = begin; pos != end; ++pos) {
+            const Cell& cell = cells_[pos & (kCapacity - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) == pos + 1) {
+                fn(cell.event);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        PackedEvent event{};
+    };
+
+    std::array<Cell, kCapacity> cells_{};
+    std::atomic<std::size_t> enqueuePos_{0};
+    std::atomic<std::size_t> dequeuePos_{0};
+    TrackedBytes bytes_{MemoryCategory::Queues, sizeof(cells_)};
+};
+
+// A patch prepared by loadPreset(). Until process() takes it, it holds the
+// incoming body and sympathetic strings; from then on the outgoing ones,
+// which keep running until the crossfade is over.
+struct StringSynthEngine::PresetChange {
+    synthesis::StringConfig config;
+    float masterGain = 1.0f;
+    double ampRelease = 0.35;
+    dsp::SympatheticStrings sympathetic;
+    BodyFilter bodyFilter;
+    synthesis::BodyMode bodyMode = synthesis::BodyMode::PostFilter;  // of bodyFilter
+    std::vector<float> fadeLeft;
+    std::vector<float> fadeRight;
+    std::size_t fadeFrames = 0;
+    std::size_t fadeDone = 0;
+};
+
+// One instrument layer: its parameters, voices, sympathetic strings and body.
+// The engine mixes every part's output into the shared room.
+struct StringSynthEngine::Part {
+    ~Part() {
+        delete pendingPreset.exchange(nullptr, std::memory_order_acq_rel);
+        delete retiredPreset.exchange(nullptr, std::memory_order_acq_rel);
+        delete pendingFrozen.exchange(nullptr, std::memory_order_acq_rel);
+        delete retiredFrozen.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    std::array<std::atomic<float>, kParamCount> paramValues{};
+    synthesis::StringConfig renderConfig;
+    float masterGain = 1.0f;
+    dsp::SmoothedValue gainSmoother;
+    double ampReleaseSeconds = 0.35;
+    std::unique_ptr<VoiceManager> voiceManager;
+    std::vector<float> mixLeft;
+    std::vector<float> mixRight;        // written only while the mix is stereo
+    std::size_t stereoHoldFrames = 0;   // stereo body left after the pans centre
+    LiveInputMode inputMode = LiveInputMode::Off;
+    float inputGain = 1.0f;
+    // Where each route's gain ramp ended last segment: a route ramps from 0
+    // when the mode turns to it and back to 0 when it turns away.
+    float bodyInputGain = 0.0f;
+    float stringsInputGain = 0.0f;
+    std::vector<float> inputScratch;    // the live input on the body route
+    std::vector<float> exciteScratch;   // the live input on the strings route
+    dsp::SympatheticStrings sympathetic;
+    BodyFilter bodyFilter;
+    std::atomic<PresetChange*> pendingPreset{nullptr};  // control -> audio thread
+    std::atomic<PresetChange*> retiredPreset{nullptr};  // audio -> control thread
+    std::unique_ptr<PresetChange> fadingPreset;         // audio thread
+    std::unique_ptr<PresetChange> heldPreset;           // faded out, not yet handed back
+    // Empty sets unfreeze; the same handoff as the presets'.
+    std::atomic<FrozenNotes*> pendingFrozen{nullptr};
+    std::atomic<FrozenNotes*> retiredFrozen{nullptr};
+    std::unique_ptr<FrozenNotes> frozen;      // audio thread: new notes play these
+    std::unique_ptr<FrozenNotes> heldFrozen;  // the last set, until its notes end
+};
+
+struct StringSynthEngine::FreezeRender {
+    ~FreezeRender() {
+        cancel.store(true, std::memory_order_relaxed);
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::atomic<bool> cancel{false};
+    std::thread thread;
+};
+
+namespace {
+
+// A part's seed and excitation settings in one word, so partConfig() can read
+// them without the lock.
+constexpr std::uint64_t PackStructure(unsigned int seed, synthesis::ExcitationMode mode,
+                                      synthesis::ExcitationType type) {
+    return static_cast<std::uint64_t>(seed) |
+           (static_cast<std::uint64_t>(mode) << 32) |
+           (static_cast<std::uint64_t>(type) << 40);
+}
+
+constexpr std::array<ParamId, 19> kConfigParams = {
+    ParamId::Decay,          ParamId::Brightness,           ParamId::DispersionAmount,
+    ParamId::ExcitationBrightness, ParamId::ExcitationVelocity, ParamId::ExcitationMix,
+    ParamId::BodyTone,       ParamId::BodySize,             ParamId::BodyMode,
+    ParamId::BodyModel,      ParamId::RoomAmount,           ParamId::RoomIR,
+    ParamId::RoomType,       ParamId::PickPosition,         ParamId::EnableLowpass,
+    ParamId::NoiseType,      ParamId::SympatheticAmount,    ParamId::StereoSpread,
+    ParamId::CourseDetune,
+};
+
+}  // namespace
+
+void StoreParamValue(ParamId id, float value, synthesis::StringConfig& config,
+                     float& masterGain, double& ampRelease) {
+    switch (id) {
+        case ParamId::Decay:
+            config.decay = value;
+            break;
+        case ParamId::Brightness:
+            config.brightness = value;
+            break;
+        case ParamId::DispersionAmount:
+            config.dispersionAmount = value;
+            break;
+        case ParamId::ExcitationBrightness:
+            config.excitationBrightness = value;
+            break;
+        case ParamId::ExcitationVelocity:
+            config.excitationVelocity = value;
+            break;
+        case ParamId::ExcitationMix:
+            config.excitationMix = value;
+            break;
+        case ParamId::BodyTone:
+            config.bodyTone = value;
+            break;
+        case ParamId::BodySize:
+            config.bodySize = value;
+            break;
+        case ParamId::BodyMode:
+            config.bodyMode = (value >= 0.5f) ? synthesis::BodyMode::Commuted
+                                              : synthesis::BodyMode::PostFilter;
+            break;
+        case ParamId::BodyModel:
+            config.bodyModel = static_cast<synthesis::BodyModel>(
+                std::clamp(static_cast<int>(std::lround(value)), 0, 2));
+            break;
+        case ParamId::RoomAmount:
+            config.roomAmount = value;
+            break;
+        case ParamId::SympatheticAmount:
+            config.sympatheticAmount = value;
+            break;
+        case ParamId::StereoSpread:
+            config.stereoSpread = value;
+            break;
+        case ParamId::CourseDetune:
+            config.courseDetuneCents = value;
+            break;
+        case ParamId::RoomIR:
+            config.roomIrIndex = static_cast<int>(std::lround(value));
+            break;
+        case ParamId::RoomType:
+            config.roomType = (value >= 0.5f) ? synthesis::RoomType::Algorithmic
+                                              : synthesis::RoomType::Convolution;
+            break;
+        case ParamId::PickPosition:
+            config.pickPosition = value;
+            break;
+        case ParamId::EnableLowpass:
+            config.enableLowpass = value >= 0.5f;
+            break;
+        case ParamId::NoiseType:
+            config.noiseType =
+                (value >= 0.5f) ? synthesis::NoiseType::Binary : synthesis::NoiseType::White;
+            break;
+        case ParamId::MasterGain:
+            masterGain = value;
+            break;
+        case ParamId::AmpRelease:
+            ampRelease = value;
+            break;
+        default:
+            break;
+    }
+}
+
+float LoadParamValue(ParamId id, const synthesis::StringConfig& config, float masterGain,
+                     double ampRelease) {
+    switch (id) {
+        case ParamId::Decay:
+            return static_cast<float>(config.decay);
+        case ParamId::Brightness:
+            return config.brightness;
+        case ParamId::DispersionAmount:
+            return config.dispersionAmount;
+        case ParamId::ExcitationBrightness:
+            return config.excitationBrightness;
+        case ParamId::ExcitationVelocity:
+            return config.excitationVelocity;
+        case ParamId::ExcitationMix:
+            return config.excitationMix;
+        case ParamId::BodyTone:
+            return config.bodyTone;
+        case ParamId::BodySize:
+            return config.bodySize;
+        case ParamId::BodyMode:
+            return config.bodyMode == synthesis::BodyMode::Commuted ? 1.0f : 0.0f;
+        case ParamId::BodyModel:
+            return static_cast<float>(config.bodyModel);
+        case ParamId::RoomAmount:
+            return config.roomAmount;
+        case ParamId::SympatheticAmount:
+            return config.sympatheticAmount;
+        case ParamId::StereoSpread:
+            return config.stereoSpread;
+        case ParamId::CourseDetune:
+            return config.courseDetuneCents;
+        case ParamId::RoomIR:
+            return static_cast<float>(config.roomIrIndex);
+        case ParamId::RoomType:
+            return config.roomType == synthesis::RoomType::Algorithmic ? 1.0f : 0.0f;
+        case ParamId::PickPosition:
+            return config.pickPosition;
+        case ParamId::EnableLowpass:
+            return config.enableLowpass ? 1.0f : 0.0f;
+        case ParamId::NoiseType:
+            return config.noiseType == synthesis::NoiseType::Binary ? 1.0f : 0.0f;
+        case ParamId::MasterGain:
+            return masterGain;
+        case ParamId::AmpRelease:
+            return static_cast<float>(ampRelease);
+        default: {
+            // Engine-only controls (pitch bend, vibrato) start at their default.
+            const auto* info = GetParamInfo(id);
+            return info ? info->defaultValue : 0.0f;
+        }
+    }
+}
+
+namespace {
+
+// Parameters of the one room every part shares.
+bool IsRoomParam(ParamId id) {
+    return id == ParamId::RoomAmount || id == ParamId::RoomIR || id == ParamId::RoomType;
+}
+
+// The koto body rings with koto strings; the tilt and guitar bodies with a
+// guitar's.
+std::span<const float> SympatheticTuning(synthesis::BodyModel model) {
+    return dsp::SympatheticStrings::PresetTuning(model == synthesis::BodyModel::Koto
+                                                     ? dsp::SympatheticStrings::Preset::Koto
+                                                     : dsp::SympatheticStrings::Preset::Guitar);
+}
+
+}  // namespace
+
+// Min-heap order on (frame, arrival) so equal timestamps keep FIFO order.
+bool StringSynthEngine::ScheduledAfter(const ScheduledEvent& a, const ScheduledEvent& b) {
+    if (a.event.frame != b.event.frame) {
+        return a.event.frame > b.event.frame;
+    }
+    return a.order > b.order;
+}
+
+StringSynthEngine::StringSynthEngine(synthesis::StringConfig config, std::size_t maxVoices,
+                                     std::size_t renderThreads, std::size_t parts)
+    : structure_([&config] {
+          StructuralConfig structure;
+          structure.sampleRate = config.sampleRate;
+          structure.parts.fill({config.seed, config.excitationMode, config.excitationType});
+          return structure;
+      }()),
+      maxVoices_(std::clamp<std::size_t>(maxVoices, 1, kMaxVoicesLimit)),
+      structural_(structure_) {
+    publishStructuralLocked();  // the mirrors; nothing else can see this yet
+    eventQueue_ = std::make_unique<EventQueue>();
+    scheduledEvents_.reserve(kMaxScheduledEvents);
+    if (renderThreads > 0) {
+        renderPool_ = std::make_unique<VoiceRenderPool>(renderThreads);
+    }
+    parts_.resize(std::clamp<std::size_t>(parts, 1, kMaxParts));
+    for (auto& part : parts_) {
+        part = std::make_unique<Part>();
+        part->renderConfig = config;
+        if (const auto* info = GetParamInfo(ParamId::AmpRelease)) {
+            part->ampReleaseSeconds = info->defaultValue;
+        }
+        for (std::size_t i = 0; i < kParamCount; ++i) {
+            part->paramValues[i].store(LoadParamValue(static_cast<ParamId>(i), config,
+                                                      part->masterGain,
+                                                      part->ampReleaseSeconds),
+                                       std::memory_order_relaxed);
+        }
+        part->gainSmoother.setTime(config.sampleRate, kParamSmoothingSeconds);
+        part->gainSmoother.snap(part->masterGain);
+        part->voiceManager = std::make_unique<VoiceManager>(
+            maxVoices_, config.sampleRate, kDefaultAttackSeconds, part->ampReleaseSeconds);
+        part->voiceManager->setReleaseSeconds(part->ampReleaseSeconds);
+        part->voiceManager->setRenderPool(renderPool_.get());
+        part->voiceManager->setStereoSpread(config.stereoSpread);
+        part->mixLeft.assign(kRenderChunkFrames, 0.0f);
+        part->mixRight.assign(kRenderChunkFrames, 0.0f);
+        part->inputScratch.assign(kRenderChunkFrames, 0.0f);
+        part->exciteScratch.assign(kRenderChunkFrames, 0.0f);
+        part->sympathetic.setSampleRate(config.sampleRate);
+        part->sympathetic.setTuning(SympatheticTuning(config.bodyModel));
+        part->sympathetic.setAmount(config.sympatheticAmount);
+        part->bodyFilter.setSampleRate(config.sampleRate);
+        part->bodyFilter.snapParams(config.bodyTone, config.bodySize);
+        part->bodyFilter.setModel(config.bodyModel);
+        updateBodyResponse(*part);
+    }
+    roomSend_.assign(kRenderChunkFrames, 0.0f);
+    liveInput_.assign(kRenderChunkFrames, 0.0f);
+    stemStringsLeft_.assign(kRenderChunkFrames, 0.0f);
+    stemStringsRight_.assign(kRenderChunkFrames, 0.0f);
+    roomDryGain_.assign(kRenderChunkFrames, 1.0f);
+    roomWetLeft_.assign(kRenderChunkFrames, 0.0f);
+    roomWetRight_.assign(kRenderChunkFrames, 0.0f);
+    roomLeft_.assign(kRenderChunkFrames, 0.0f);
+    roomRight_.assign(kRenderChunkFrames, 0.0f);
+    roomProcessor_ = std::make_unique<RoomProcessor>();
+    roomProcessor_->setSampleRate(config.sampleRate);
+    roomProcessor_->setMix(config.roomAmount);
+    roomProcessor_->setIrIndex(config.roomIrIndex);
+    roomProcessor_->setAlgorithmic(config.roomType == synthesis::RoomType::Algorithmic);
+}
+
+StringSynthEngine::~StringSynthEngine() = default;
+
+void StringSynthEngine::setConfig(const synthesis::StringConfig& config) {
+    setPartConfig(0, config);
+}
+
+synthesis::StringConfig StringSynthEngine::stringConfig() const {
+    return partConfig(0);
+}
+
+void StringSynthEngine::setPartConfig(std::size_t part, const synthesis::StringConfig& config) {
+    if (part >= parts_.size()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (part == 0) {
+            structure_.sampleRate = config.sampleRate;
+        }
+        structure_.parts[part] = {config.seed, config.excitationMode, config.excitationType};
+        publishStructuralLocked();
+    }
+    for (ParamId id : kConfigParams) {
+        if (part == 0 || !IsRoomParam(id)) {
+            setPartParam(part, id, LoadParamValue(id, config, 0.0f, 0.0));
+        }
+    }
+}
+
+synthesis::StringConfig StringSynthEngine::partConfig(std::size_t part) const {
+    synthesis::StringConfig config;
+    if (part >= parts_.size()) {
+        return config;
+    }
+    const std::uint64_t structure = structureMirror_[part].load(std::memory_order_acquire);
+    config.sampleRate = sampleRateMirror_.load(std::memory_order_relaxed);
+    config.seed = static_cast<unsigned int>(structure & 0xffffffffu);
+    config.excitationMode = static_cast<synthesis::ExcitationMode>((structure >> 32) & 0xffu);
+    config.excitationType = static_cast<synthesis::ExcitationType>((structure >> 40) & 0xffu);
+    float masterGain = 0.0f;
+    double ampRelease = 0.0;
+    for (ParamId id : kConfigParams) {
+        StoreParamValue(id, getPartParam(part, id), config, masterGain, ampRelease);
+    }
+    return config;
+}
+
+void StringSynthEngine::setSampleRate(double sampleRate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    structure_.sampleRate = sampleRate;
+    publishStructuralLocked();
+}
+
+void StringSynthEngine::setBodyModes(std::span<const dsp::ModalBody::Mode> modes) {
+    BodyModeTable table;
+    table.count = std::min(modes.size(), table.modes.size());
+    std::copy_n(modes.begin(), table.count, table.modes.begin());
+    std::lock_guard<std::mutex> lock(mutex_);
+    bodyModeTable_ = table;
+    bodyModes_.write(table);
+}
+
+void StringSynthEngine::setModulation(const ModulationSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    modulation_.write(settings);
+}
+
+void StringSynthEngine::loadPreset(const Preset& preset, std::size_t part) {
+    if (part >= parts_.size()) {
+        return;
+    }
+    auto change = std::make_unique<PresetChange>();
+    change->config = preset.config;
+    change->masterGain = preset.masterGain;
+    change->ampRelease = preset.ampRelease;
+    auto clampInto = [&](ParamId id) {
+        if (const auto* info = GetParamInfo(id)) {
+            const float value = LoadParamValue(id, change->config, change->masterGain,
+                                               change->ampRelease);
+            StoreParamValue(id, ClampToRange(*info, value), change->config, change->masterGain,
+                            change->ampRelease);
+        }
+    };
+    for (ParamId id : kConfigParams) {
+        clampInto(id);
+    }
+    clampInto(ParamId::MasterGain);
+    clampInto(ParamId::AmpRelease);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const synthesis::StringConfig& config = change->config;
+    change->config.sampleRate = structure_.sampleRate;
+    // Everything the audio thread would otherwise rebuild.
+    change->bodyFilter.setSampleRate(config.sampleRate);
+    change->bodyFilter.setCustomModes(
+        std::span(bodyModeTable_.modes.data(), bodyModeTable_.count));
+    change->bodyFilter.setModel(config.bodyModel);
+    change->bodyFilter.snapParams(config.bodyTone, config.bodySize);
+    change->bodyMode = config.bodyMode;
+    change->sympathetic.setSampleRate(config.sampleRate);
+    change->sympathetic.setTuning(SympatheticTuning(config.bodyModel));
+    change->sympathetic.setAmount(config.sympatheticAmount);
+    change->fadeLeft.assign(kRenderChunkFrames, 0.0f);
+    change->fadeRight.assign(kRenderChunkFrames, 0.0f);
+
+    structure_.parts[part] = {config.seed, config.excitationMode, config.excitationType};
+    publishStructuralLocked();
+    auto publish = [&](ParamId id) {
+        if (std::atomic<float>* slot = paramSlot(part, id)) {
+            slot->store(LoadParamValue(id, config, change->masterGain, change->ampRelease),
+                        std::memory_order_relaxed);
+        }
+    };
+    for (ParamId id : kConfigParams) {
+        if (part == 0 || !IsRoomParam(id)) {
+            publish(id);
+        }
+    }
+    publish(ParamId::MasterGain);
+    publish(ParamId::AmpRelease);
+
+    if (freezeStatus_[part].load(std::memory_order_relaxed) != FreezeStatus::Off) {
+        startFreezeLocked(part, config);
+    }
+
+    Part& target = *parts_[part];
+    delete target.retiredPreset.exchange(nullptr, std::memory_order_acq_rel);
+    // Replaces one process() has not taken yet.
+    delete target.pendingPreset.exchange(change.release(), std::memory_order_acq_rel);
+}
+
+void StringSynthEngine::publishStructuralLocked() {
+    structural_.write(structure_);
+    sampleRateMirror_.store(structure_.sampleRate, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < structure_.parts.size(); ++i) {
+        const PartStructure& part = structure_.parts[i];
+        structureMirror_[i].store(
+            PackStructure(part.seed, part.excitationMode, part.excitationType),
+            std::memory_order_release);
+    }
+}
+
+double StringSynthEngine::sampleRate() const {
+    return sampleRateMirror_.load(std::memory_order_relaxed);
+}
+
+std::atomic<float>* StringSynthEngine::paramSlot(std::size_t part, ParamId id) const {
+    const auto index = static_cast<std::size_t>(id);
+    if (part >= parts_.size() || index >= kParamCount) {
+        return nullptr;
+    }
+    return &parts_[IsRoomParam(id) ? 0 : part]->paramValues[index];
+}
+
+void StringSynthEngine::enqueueEvent(const Event& event) {
+    enqueueEventAt(event, frameCursor_.load(std::memory_order_relaxed));
+}
+
+bool StringSynthEngine::packEvent(const Event& event, std::uint64_t frameOffset,
+                                  PackedEvent& packed) {
+    if (event.part >= parts_.size()) {
+        return false;
+    }
+    packed.frame = frameOffset;
+    packed.type = event.type;
+    packed.part = static_cast<std::uint8_t>(event.part);
+    packed.noteId = event.noteId;
+    packed.value = event.velocity;
+    packed.frequency = static_cast<float>(event.frequency);
+    if (event.type == EventType::ParamChange) {
+        const auto* info = GetParamInfo(event.param);
+        std::atomic<float>* slot = paramSlot(event.part, event.param);
+        if (!info || !slot) {
+            return false;
+        }
+        if (IsRoomParam(event.param)) {
+            packed.part = 0;
+        }
+        packed.param = static_cast<std::uint8_t>(event.param);
+        packed.value = ClampToRange(*info, event.paramValue);
+        slot->store(packed.value, std::memory_order_relaxed);
+    } else if (event.type == EventType::NoteExpression) {
+        if (event.noteId < 0) {
+            return false;
+        }
+        packed.param = static_cast<std::uint8_t>(event.expression);
+        packed.value = event.expression == NoteExpression::PitchBend
+                           ? std::clamp(event.paramValue, -kMaxNoteBendSemitones,
+                                        kMaxNoteBendSemitones)
+                           : std::clamp(event.paramValue, 0.0f, 1.0f);
+    }
+    return true;
+}
+
+bool StringSynthEngine::enqueueEventAt(const Event& event,
+                                       std::uint64_t frameOffset) {
+    PackedEvent packed;
+    if (!packEvent(event, frameOffset, packed)) {
+        return false;
+    }
+    // Count before publishing so process() can never decrement below zero.
+    queuedEventCount_.fetch_add(1, std::memory_order_relaxed);
+    if (!eventQueue_->push(packed)) {
+        queuedEventCount_.fetch_sub(1, std::memory_order_relaxed);
+        if (packed.type == EventType::ParamChange) {
+            // The value is already published; let process() resync from it.
+            paramResyncPending_.store(true, std::memory_order_release);
+        }
+        return false;
+    }
+    return true;
+}
+
+std::size_t StringSynthEngine::enqueueEvents(std::span<const Event> events) {
+    // Packed in runs on the stack, each queued with one claim.
+    constexpr std::size_t kRun = 64;
+    std::array<PackedEvent, kRun> run;
+    std::size_t queued = 0;
+    while (queued < events.size()) {
+        std::size_t packed = 0;
+        bool refused = false;
+        while (packed < kRun && queued + packed < events.size()) {
+            const Event& event = events[queued + packed];
+            if (!packEvent(event, event.frameOffset, run[packed])) {
+                refused = true;
+                break;
+            }
+            ++packed;
+        }
+        queuedEventCount_.fetch_add(packed, std::memory_order_relaxed);
+        const std::size_t pushed = eventQueue_->pushRun(run.data(), packed);
+        queued += pushed;
+        if (pushed < packed) {
+            queuedEventCount_.fetch_sub(packed - pushed, std::memory_order_relaxed);
+            for (std::size_t i = pushed; i < packed; ++i) {
+                if (run[i].type == EventType::ParamChange) {
+                    paramResyncPending_.store(true, std::memory_order_release);
+                    break;
+                }
+            }
+            break;
+        }
+        if (refused) {
+            break;
+        }
+    }
+    return queued;
+}
+
+void StringSynthEngine::noteOn(int noteId, double frequency, float velocity,
+                               double durationSeconds, std::size_t part) {
+    if (frequency <= 0.0) {
+        return;
+    }
+    const std::uint64_t startFrame = frameCursor_.load(std::memory_order_relaxed);
+    const double currentSampleRate = sampleRate();
+    const int resolvedNoteId =
+        noteId < 0 ? nextNoteId_.fetch_add(1, std::memory_order_relaxed) : noteId;
+
+    Event event;
+    event.type = EventType::NoteOn;
+    event.noteId = resolvedNoteId;
+    event.velocity = velocity;
+    event.frequency = frequency;
+    event.part = part;
+    if (!enqueueEventAt(event, startFrame)) {
+        return;
+    }
+
+    if (durationSeconds > 0.0 && currentSampleRate > 0.0) {
+        const auto deltaFrames = static_cast<std::uint64_t>(
+            std::max(0.0, std::round(durationSeconds * currentSampleRate)));
+        Event off;
+        off.type = EventType::NoteOff;
+        off.noteId = resolvedNoteId;
+        off.part = part;
+        enqueueEventAt(off, startFrame + deltaFrames);
+    }
+}
+
+void StringSynthEngine::noteOff(int noteId, std::size_t part) {
+    if (noteId < 0) {
+        return;
+    }
+    Event event;
+    event.type = EventType::NoteOff;
+    event.noteId = noteId;
+    event.part = part;
+    enqueueEvent(event);
+}
+
+void StringSynthEngine::noteExpression(int noteId, NoteExpression expression, float value,
+                                       std::size_t part) {
+    Event event;
+    event.type = EventType::NoteExpression;
+    event.noteId = noteId;
+    event.expression = expression;
+    event.paramValue = value;
+    event.part = part;
+    enqueueEvent(event);
+}
+
+void StringSynthEngine::noteOn(double frequency, double durationSeconds) {
+    noteOn(-1, frequency, 1.0f, durationSeconds);
+}
+
+void StringSynthEngine::setParam(ParamId id, float value) {
+    setPartParam(0, id, value);
+}
+
+float StringSynthEngine::getParam(ParamId id) const {
+    return getPartParam(0, id);
+}
+
+void StringSynthEngine::setPartParam(std::size_t part, ParamId id, float value) {
+    Event event;
+    event.type = EventType::ParamChange;
+    event.param = id;
+    event.paramValue = value;
+    event.part = part;
+    enqueueEvent(event);
+}
+
+void StringSynthEngine::setParams(std::span<const ParamValue> values, std::size_t part) {
+    const std::uint64_t frame = frameCursor_.load(std::memory_order_relaxed);
+    std::array<Event, kParamCount> run;
+    while (!values.empty()) {
+        const std::size_t count = std::min(values.size(), run.size());
+        for (std::size_t i = 0; i < count; ++i) {
+            Event& event = run[i];
+            event.type = EventType::ParamChange;
+            event.param = values[i].id;
+            event.paramValue = values[i].value;
+            event.part = part;
+            event.frameOffset = frame;
+        }
+        const std::size_t queued = enqueueEvents(std::span(run.data(), count));
+        // Past a refused entry or a full queue: publish the values so the
+        // resync in process() applies them.
+        for (std::size_t i = queued; i < count; ++i) {
+            PackedEvent packed;
+            if (packEvent(run[i], frame, packed)) {
+                paramResyncPending_.store(true, std::memory_order_release);
+            }
+        }
+        values = values.subspan(count);
+    }
+}
+
+float StringSynthEngine::getPartParam(std::size_t part, ParamId id) const {
+    const std::atomic<float>* slot = paramSlot(part, id);
+    return slot ? slot->load(std::memory_order_relaxed) : 0.0f;
+}
+
+void StringSynthEngine::syncControlState() {
+    // Structural changes (sample rate, seed, excitation mode) are rare and
+    // arrive as a whole snapshot, so process() never touches mutex_.
+    if (structural_.update()) {
+        const StructuralConfig& structural = structural_.read();
+        for (std::size_t p = 0; p < parts_.size(); ++p) {
+            Part& part = *parts_[p];
+            const PartStructure& structure = structural.parts[p];
+            part.renderConfig.seed = structure.seed;
+            part.renderConfig.excitationMode = structure.excitationMode;
+            part.renderConfig.excitationType = structure.excitationType;
+            // Another part's change must not clear this one's strings and body.
+            if (part.renderConfig.sampleRate == structural.sampleRate) {
+                continue;
+            }
+            part.renderConfig.sampleRate = structural.sampleRate;
+            part.voiceManager->setSampleRate(structural.sampleRate);
+            part.sympathetic.setSampleRate(structural.sampleRate);
+            part.bodyFilter.setSampleRate(structural.sampleRate);
+            updateBodyResponse(part);
+            part.gainSmoother.setTime(structural.sampleRate, kParamSmoothingSeconds);
+        }
+        roomProcessor_->setSampleRate(structural.sampleRate);
+    }
+
+    // Before the mode table, which may be newer than a preset built on it.
+    for (auto& part : parts_) {
+        commitPreset(*part);
+        commitFrozenNotes(*part);
+    }
+
+    const std::size_t voiceLimit = voiceLimit_.load(std::memory_order_relaxed);
+    const float voiceBudget = voiceBudget_.load(std::memory_order_relaxed);
+    const double oversamplingThreshold = oversamplingThreshold_.load(std::memory_order_relaxed);
+    synthesis::ExcitationPool* excitationPool = excitationPool_.load(std::memory_order_acquire);
+    for (auto& part : parts_) {
+        part->voiceManager->setVoiceLimit(voiceLimit);
+        part->voiceManager->setVoiceBudget(voiceBudget);
+        part->voiceManager->setOversamplingThreshold(oversamplingThreshold);
+        part->voiceManager->setExcitationPool(excitationPool);
+    }
+
+    if (bodyModes_.update()) {
+        const BodyModeTable& table = bodyModes_.read();
+        for (auto& part : parts_) {
+            part->bodyFilter.setCustomModes(std::span(table.modes.data(), table.count));
+            updateBodyResponse(*part);
+        }
+    }
+
+    if (modulation_.update()) {
+        for (auto& part : parts_) {
+            part->voiceManager->setModulation(modulation_.read());
+        }
+    }
+
+    if (paramResyncPending_.exchange(false, std::memory_order_acquire)) {
+        for (std::size_t p = 0; p < parts_.size(); ++p) {
+            for (std::size_t i = 0; i < kParamCount; ++i) {
+                const auto id = static_cast<ParamId>(i);
+                if (p == 0 || !IsRoomParam(id)) {
+                    applyParam(*parts_[p], id,
+                               parts_[p]->paramValues[i].load(std::memory_order_relaxed), false);
+                }
+            }
+        }
+    }
+
+    // Move new events into the schedule heap. When it is full, events stay in
+    // the queue (and producers see enqueueEventAt() fail) instead of growing it.
+    ScheduledEvent scheduled;
+    while (scheduledEvents_.size() < kMaxScheduledEvents &&
+           eventQueue_->pop(scheduled.event)) {
+        scheduled.order = scheduleCounter_++;
+        scheduledEvents_.push_back(scheduled);
+        std::push_heap(scheduledEvents_.begin(), scheduledEvents_.end(), ScheduledAfter);
+    }
+}
+
+bool StringSynthEngine::nextEventFrame(std::uint64_t& frame) const {
+    if (scheduledEvents_.empty()) {
+        return false;
+    }
+    frame = scheduledEvents_.front().event.frame;
+    return true;
+}
+
+void StringSynthEngine::dispatchEventsUpTo(std::uint64_t frame) {
+    std::size_t handled = 0;
+    while (!scheduledEvents_.empty() &&
+           scheduledEvents_.front().event.frame <= frame) {
+        std::pop_heap(scheduledEvents_.begin(), scheduledEvents_.end(), ScheduledAfter);
+        handleEvent(scheduledEvents_.back().event);
+        scheduledEvents_.pop_back();
+        ++handled;
+    }
+    if (handled > 0) {
+        queuedEventCount_.fetch_sub(handled, std::memory_order_relaxed);
+    }
+}
+
+template <typename Sink>
+void StringSynthEngine::renderFrames(std::size_t frames, const StemOutputs* stems,
+                                     const LiveInput& input, Sink&& sink) {
+    const RealtimeScope realtime;
+    const TraceZone zone("StringSynthEngine::process");
+    const std::uint64_t blockStartFrame =
+        frameCursor_.load(std::memory_order_relaxed);
+    StageLap lap(profiler_);
+    syncControlState();
+
+    std::size_t frame = 0;
+    while (frame < frames) {
+        // Late events (timestamp before this block) fire at the first frame.
+        const std::uint64_t absoluteFrame = blockStartFrame + frame;
+        dispatchEventsUpTo(absoluteFrame);
+
+        // Render voices in spans that end at the next event (or chunk limit).
+        std::size_t segmentEnd = frames;
+        std::uint64_t nextFrame = 0;
+        if (nextEventFrame(nextFrame) && nextFrame - blockStartFrame < frames) {
+            segmentEnd = static_cast<std::size_t>(nextFrame - blockStartFrame);
+        }
+        const std::size_t segmentFrames =
+            std::min(segmentEnd - frame, kRenderChunkFrames);
+        float* left = roomLeft_.data();
+        float* right = roomRight_.data();
+        lap.mark(ProfileStage::Events);
+        // Part 0 renders straight into the bus; the others are added to it,
+        // and the bus turns stereo as soon as one of them is.
+        float* stringsLeft = nullptr;
+        float* stringsRight = nullptr;
+        if (stems) {
+            stringsLeft = stemStringsLeft_.data();
+            stringsRight = stemStringsRight_.data();
+            std::fill(stringsLeft, stringsLeft + segmentFrames, 0.0f);
+            std::fill(stringsRight, stringsRight + segmentFrames, 0.0f);
+        }
+        const float* live = mixLiveInput(input, frame, segmentFrames);
+        Part& lead = *parts_.front();
+        float* dry = lead.mixLeft.data();
+        float* dryRight = renderPart(lead, segmentFrames, lap, live, stringsLeft, stringsRight);
+        if (stems) {
+            CopyPartStem(stems->parts[0], frame, dry, dryRight, segmentFrames);
+        }
+        for (std::size_t p = 1; p < parts_.size(); ++p) {
+            const float* partLeft = parts_[p]->mixLeft.data();
+            const float* partRight =
+                renderPart(*parts_[p], segmentFrames, lap, live, stringsLeft, stringsRight);
+            if (stems) {
+                CopyPartStem(stems->parts[p], frame, partLeft, partRight, segmentFrames);
+            }
+            if (partRight && !dryRight) {
+                dryRight = lead.mixRight.data();
+                std::copy(dry, dry + segmentFrames, dryRight);
+            }
+            for (std::size_t i = 0; i < segmentFrames; ++i) {
+                dry[i] += partLeft[i];
+            }
+            if (dryRight) {
+                const float* src = partRight ? partRight : partLeft;
+                for (std::size_t i = 0; i < segmentFrames; ++i) {
+                    dryRight[i] += src[i];
+                }
+            }
+            lap.mark(ProfileStage::Body);
+        }
+        // The room is fed the mid; so are outputs past the second.
+        const float* send = dry;
+        if (dryRight) {
+            float* mid = roomSend_.data();
+            for (std::size_t i = 0; i < segmentFrames; ++i) {
+                mid[i] = 0.5f * (dry[i] + dryRight[i]);
+            }
+            send = mid;
+        }
+        RoomProcessor::Split split;
+        if (stems) {
+            split = {roomDryGain_.data(), roomWetLeft_.data(), roomWetRight_.data()};
+        }
+        roomProcessor_->processBlock(send, dry, dryRight ? dryRight : dry, left, right,
+                                     segmentFrames, stems ? &split : nullptr);
+        lap.mark(ProfileStage::Room);
+
+        if (stems) {
+            writeStems(*stems, frame, dry, dryRight ? dryRight : dry, segmentFrames);
+        }
+
+        sink(frame, send, static_cast<const float*>(left), static_cast<const float*>(right),
+             segmentFrames);
+        lap.mark(ProfileStage::Output);
+        frame += segmentFrames;
+    }
+
+    publishStatus();
+    frameCursor_.fetch_add(frames, std::memory_order_relaxed);
+}
+
+const float* StringSynthEngine::mixLiveInput(const LiveInput& input, std::size_t offset,
+                                             std::size_t count) {
+    if (input.channels == 0) {
+        return nullptr;
+    }
+    float* mid = liveInput_.data();
+    if (input.interleaved) {
+        const float* src = input.interleaved + offset * input.channels;
+        if (input.channels >= 2) {
+            for (std::size_t i = 0; i < count; ++i) {
+                mid[i] = 0.5f * (src[i * input.channels] + src[i * input.channels + 1]);
+            }
+        } else {
+            std::copy(src, src + count, mid);
+        }
+        return mid;
+    }
+    const float* first = input.planar[0];
+    const float* second = input.channels >= 2 ? input.planar[1] : nullptr;
+    if (!first || !second) {
+        const float* only = first ? first : second;
+        if (!only) {
+            return nullptr;
+        }
+        std::copy(only + offset, only + offset + count, mid);
+        return mid;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        mid[i] = 0.5f * (first[offset + i] + second[offset + i]);
+    }
+    return mid;
+}
+
+void StringSynthEngine::process(const ProcessBlock& block) {
+    renderInterleaved(block, nullptr);
+}
+
+void StringSynthEngine::process(const ProcessBlock& block, const StemOutputs& stems) {
+    renderInterleaved(block, &stems);
+}
+
+void StringSynthEngine::process(const PlanarProcessBlock& block) {
+    renderPlanar(block, nullptr);
+}
+
+void StringSynthEngine::process(const PlanarProcessBlock& block, const StemOutputs& stems) {
+    renderPlanar(block, &stems);
+}
+
+// Stems of one segment, weighted as the room weighted the dry bus. The part
+// stems were copied in as rendered and are scaled in place.
+void StringSynthEngine::writeStems(const StemOutputs& stems, std::size_t offset,
+                                   const float* dryLeft, const float* dryRight,
+                                   std::size_t frames) {
+    const float* gain = roomDryGain_.data();
+    const float* strings[2] = {stemStringsLeft_.data(), stemStringsRight_.data()};
+    const float* dry[2] = {dryLeft, dryRight};
+    const float* wet[2] = {roomWetLeft_.data(), roomWetRight_.data()};
+    for (std::size_t ch = 0; ch < 2; ++ch) {
+        if (float* out = stems.strings[ch]) {
+            for (std::size_t i = 0; i < frames; ++i) {
+                out[offset + i] = strings[ch][i] * gain[i];
+            }
+        }
+        if (float* out = stems.body[ch]) {
+            for (std::size_t i = 0; i < frames; ++i) {
+                out[offset + i] = (dry[ch][i] - strings[ch][i]) * gain[i];
+            }
+        }
+        if (float* out = stems.room[ch]) {
+            std::copy(wet[ch], wet[ch] + frames, out + offset);
+        }
+        for (std::size_t p = 0; p < parts_.size(); ++p) {
+            if (float* out = stems.parts[p][ch]) {
+                for (std::size_t i = 0; i < frames; ++i) {
+                    out[offset + i] *= gain[i];
+                }
             }
         }
     }
+}
 
-    float renderFrame(float masterGain) {
-        float mixed = 0.0f;
-        for (auto& voice : voices_) {
-            if (voice.envelope.isIdle()) {
-                continue;
+void StringSynthEngine::renderInterleaved(const ProcessBlock& block, const StemOutputs* stems) {
+    if (!block.output || block.frames == 0 || block.channels == 0) {
+        return;
+    }
+    const std::size_t channels = block.channels;
+    LiveInput input;
+    if (block.input) {
+        input.interleaved = block.input;
+        input.channels = block.inputChannels;
+    }
+    renderFrames(block.frames, stems, input, [&](std::size_t offset, const float* dry, const float* left,
+                                   const float* right, std::size_t count) {
+        float* out = block.output + offset * channels;
+        if (channels >= 2) {
+            for (std::size_t i = 0; i < count; ++i) {
+                float* outFrame = out + i * channels;
+                outFrame[0] = left[i];
+                outFrame[1] = right[i];
+                for (std::size_t ch = 2; ch < channels; ++ch) {
+                    outFrame[ch] = dry[i];
+                }
+            }
+        } else {
+            for (std::size_t i = 0; i < count; ++i) {
+                out[i] = 0.5f * (left[i] + right[i]);
             }
-            const float env = voice.envelope.next();
-            const float sample = voice.string.processSample() * env * voice.velocity;
-            voice.energy = kEnergyDecay * voice.energy +
-                           (1.0f - kEnergyDecay) * std::abs(sample);
-            mixed += sample;
         }
+    });
+}
 
-        cleanupSilentVoices();
-        return mixed * masterGain;
+void StringSynthEngine::renderPlanar(const PlanarProcessBlock& block, const StemOutputs* stems) {
+    if (!block.channels || block.frames == 0 || block.channelCount == 0) {
+        return;
     }
-
-    std::size_t activeVoices() const { return voices_.size(); }
-
-private:
-    Voice* findVoiceByNote(int noteId) {
-        auto it = std::find_if(
-            voices_.begin(), voices_.end(),
-            [noteId](const Voice& voice) { return voice.noteId == noteId; });
-        if (it == voices_.end()) {
-            return nullptr;
-        }
-        return &(*it);
+    const std::size_t channels = block.channelCount;
+    LiveInput input;
+    if (block.inputs) {
+        input.planar = block.inputs;
+        input.channels = block.inputCount;
     }
-
-    Voice* allocateVoice() {
-        if (voices_.size() < maxVoices_) {
-            voices_.emplace_back();
-            voices_.back().envelope.setSampleRate(sampleRate_);
-            voices_.back().envelope.setAttackSeconds(attackSeconds_);
-            voices_.back().envelope.setReleaseSeconds(releaseSeconds_);
-            return &voices_.back();
-        }
-        // Voice stealing: prefer releasing voices, otherwise lowest energy, then oldest.
-        auto candidate = std::min_element(
-            voices_.begin(), voices_.end(),
-            [](const Voice& a, const Voice& b) {
-                if (a.envelope.isReleasing() != b.envelope.isReleasing()) {
-                    return a.envelope.isReleasing();
-                }
-                if (std::abs(a.energy - b.energy) > std::numeric_limits<float>::epsilon()) {
-                    return a.energy < b.energy;
+    renderFrames(block.frames, stems, input, [&](std::size_t offset, const float* dry, const float* left,
+                                   const float* right, std::size_t count) {
+        if (channels == 1) {
+            if (float* out = block.channels[0]) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[offset + i] = 0.5f * (left[i] + right[i]);
                 }
-                return a.age < b.age;
-            });
-        if (candidate == voices_.end()) {
-            return nullptr;
+            }
+            return;
         }
-        return &(*candidate);
-    }
+        for (std::size_t ch = 0; ch < channels; ++ch) {
+            float* out = block.channels[ch];
+            if (!out) {
+                continue;
+            }
+            const float* src = ch == 0 ? left : (ch == 1 ? right : dry);
+            std::copy(src, src + count, out + offset);
+        }
+    });
+}
 
-    void cleanupSilentVoices() {
-        voices_.erase(
-            std::remove_if(voices_.begin(), voices_.end(),
-                           [](const Voice& voice) {
-                               return voice.envelope.isIdle() ||
-                                      (voice.envelope.isReleasing() &&
-                                       voice.energy < kVoiceSilenceThreshold);
-                           }),
-            voices_.end());
+std::size_t StringSynthEngine::activeVoiceCount() const {
+    return activeVoices_.load(std::memory_order_relaxed);
+}
+
+void StringSynthEngine::publishStatus() {
+    std::size_t count = 0;
+    for (const auto& part : parts_) {
+        count += part->voiceManager->activeVoices();
     }
+    activeVoices_.store(count, std::memory_order_relaxed);
+    std::uint64_t next = 0;
+    const bool scheduled = nextEventFrame(next);
+    nextEventFrame_.store(next, std::memory_order_relaxed);
+    hasScheduledEvent_.store(scheduled, std::memory_order_relaxed);
+}
 
-    std::vector<Voice> voices_;
-    const std::size_t maxVoices_;
-    double sampleRate_ = 44100.0;
-    double attackSeconds_ = kDefaultAttackSecondsValue;
-    double releaseSeconds_ = 0.35;
-    std::uint64_t ageCounter_ = 0;
-};
+void StringSynthEngine::setVoiceLimit(std::size_t voices) {
+    voiceLimit_.store(std::min(voices, maxVoices_), std::memory_order_relaxed);
+}
 
-StringSynthEngine::StringSynthEngine(synthesis::StringConfig config)
-    : config_(config) {
-    if (const auto* info = GetParamInfo(ParamId::AmpRelease)) {
-        ampReleaseSeconds_ = info->defaultValue;
-    }
-    voiceManager_ = std::make_unique<VoiceManager>(
-        kMaxVoices, config_.sampleRate, kDefaultAttackSeconds, ampReleaseSeconds_);
-    voiceManager_->setReleaseSeconds(ampReleaseSeconds_);
-    bodyFilter_ = std::make_unique<BodyFilter>();
-    bodyFilter_->setSampleRate(config_.sampleRate);
-    bodyFilter_->setParams(config_.bodyTone, config_.bodySize);
-    roomProcessor_ = std::make_unique<RoomProcessor>();
-    roomProcessor_->setSampleRate(config_.sampleRate);
-    roomProcessor_->setMix(config_.roomAmount);
-    roomProcessor_->setIrIndex(config_.roomIrIndex);
+std::size_t StringSynthEngine::voiceLimit() const {
+    const std::size_t limit = voiceLimit_.load(std::memory_order_relaxed);
+    return limit == 0 ? maxVoices_ : limit;
 }
 
-StringSynthEngine::~StringSynthEngine() = default;
+void StringSynthEngine::setVoiceBudget(float cost) {
+    voiceBudget_.store(std::max(0.0f, cost), std::memory_order_relaxed);
+}
 
-void StringSynthEngine::setConfig(const synthesis::StringConfig& config) {
+float StringSynthEngine::voiceBudget() const {
+    return voiceBudget_.load(std::memory_order_relaxed);
+}
+
+void StringSynthEngine::setOversamplingThreshold(double frequencyHz) {
+    oversamplingThreshold_.store(std::isfinite(frequencyHz) ? std::max(0.0, frequencyHz) : 0.0,
+                                 std::memory_order_relaxed);
+}
+
+double StringSynthEngine::oversamplingThreshold() const {
+    return oversamplingThreshold_.load(std::memory_order_relaxed);
+}
+
+void StringSynthEngine::setExcitationPrewarm(bool enabled) {
     std::lock_guard<std::mutex> lock(mutex_);
-    config_.sampleRate = config.sampleRate;
-    config_.seed = config.seed;
-    config_.excitationMode = config.excitationMode;
-    config_.excitationType = config.excitationType;
-    applyParamUnlocked(ParamId::Decay, static_cast<float>(config.decay), config_,
-                       masterGain_);
-    applyParamUnlocked(ParamId::Brightness, config.brightness, config_, masterGain_);
-    applyParamUnlocked(ParamId::DispersionAmount, config.dispersionAmount, config_,
-                       masterGain_);
-    applyParamUnlocked(ParamId::ExcitationBrightness, config.excitationBrightness, config_,
-                       masterGain_);
-    applyParamUnlocked(ParamId::ExcitationVelocity, config.excitationVelocity, config_,
-                       masterGain_);
-    applyParamUnlocked(ParamId::ExcitationMix, config.excitationMix, config_,
-                       masterGain_);
-    applyParamUnlocked(ParamId::BodyTone, config.bodyTone, config_, masterGain_);
-    applyParamUnlocked(ParamId::BodySize, config.bodySize, config_, masterGain_);
-    applyParamUnlocked(ParamId::RoomAmount, config.roomAmount, config_, masterGain_);
-    applyParamUnlocked(ParamId::RoomIR, static_cast<float>(config.roomIrIndex), config_,
-                       masterGain_);
-    applyParamUnlocked(ParamId::PickPosition, config.pickPosition, config_, masterGain_);
-    applyParamUnlocked(ParamId::EnableLowpass, config.enableLowpass ? 1.0f : 0.0f,
-                       config_, masterGain_);
-    applyParamUnlocked(ParamId::NoiseType,
-                       config.noiseType == synthesis::NoiseType::Binary ? 1.0f : 0.0f,
-                       config_, masterGain_);
-    voiceManager_->setSampleRate(config_.sampleRate);
-    if (bodyFilter_) {
-        bodyFilter_->setSampleRate(config_.sampleRate);
-    }
-    if (roomProcessor_) {
-        roomProcessor_->setSampleRate(config_.sampleRate);
-        roomProcessor_->setIrIndex(config_.roomIrIndex);
-        roomProcessor_->setMix(config_.roomAmount);
+    if (enabled && !excitationPoolStorage_) {
+        excitationPoolStorage_ = std::make_unique<synthesis::ExcitationPool>();
     }
+    excitationPool_.store(enabled ? excitationPoolStorage_.get() : nullptr,
+                          std::memory_order_release);
 }
 
-synthesis::StringConfig StringSynthEngine::stringConfig() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return config_;
+bool StringSynthEngine::excitationPrewarm() const {
+    return excitationPool_.load(std::memory_order_relaxed) != nullptr;
 }
 
-void StringSynthEngine::setSampleRate(double sampleRate) {
+void StringSynthEngine::setPartFrozen(std::size_t part, bool frozen) {
+    if (part >= parts_.size()) {
+        return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
-    config_.sampleRate = sampleRate;
-    voiceManager_->setSampleRate(config_.sampleRate);
-    if (bodyFilter_) {
-        bodyFilter_->setSampleRate(config_.sampleRate);
+    if (frozen) {
+        synthesis::StringConfig config = partConfig(part);
+        config.sampleRate = structure_.sampleRate;
+        startFreezeLocked(part, config);
+        return;
+    }
+    freezeRenders_[part].reset();
+    freezeStatus_[part].store(FreezeStatus::Off, std::memory_order_release);
+    Part& target = *parts_[part];
+    delete target.retiredFrozen.exchange(nullptr, std::memory_order_acq_rel);
+    delete target.pendingFrozen.exchange(new FrozenNotes(), std::memory_order_acq_rel);
+}
+
+FreezeStatus StringSynthEngine::partFreezeStatus(std::size_t part) const {
+    return part < parts_.size() ? freezeStatus_[part].load(std::memory_order_acquire)
+                                : FreezeStatus::Off;
+}
+
+void StringSynthEngine::startFreezeLocked(std::size_t part, synthesis::StringConfig config) {
+    // A render still running is for settings that no longer apply.
+    freezeRenders_[part].reset();
+    freezeStatus_[part].store(FreezeStatus::Rendering, std::memory_order_release);
+    auto render = std::make_unique<FreezeRender>();
+    FreezeRender* state = render.get();
+    Part* target = parts_[part].get();
+    std::atomic<FreezeStatus>* status = &freezeStatus_[part];
+    render->thread = std::thread([state, target, status, config]() {
+        const ScopedDspThread dspThread("part freeze");
+        auto notes = std::make_unique<FrozenNotes>();
+        if (!notes->render(config, state->cancel)) {
+            return;
+        }
+        delete target->retiredFrozen.exchange(nullptr, std::memory_order_acq_rel);
+        delete target->pendingFrozen.exchange(notes.release(), std::memory_order_acq_rel);
+        status->store(FreezeStatus::Ready, std::memory_order_release);
+    });
+    freezeRenders_[part] = std::move(render);
+}
+
+void StringSynthEngine::commitFrozenNotes(Part& part) {
+    VoiceManager& voices = *part.voiceManager;
+    if (part.heldFrozen && !voices.playsFrozenNotes(part.heldFrozen.get())) {
+        FrozenNotes* empty = nullptr;
+        if (part.retiredFrozen.compare_exchange_strong(empty, part.heldFrozen.get(),
+                                                       std::memory_order_acq_rel)) {
+            (void)part.heldFrozen.release();
+        }
+    }
+    // As with presets, the audio thread never frees a set.
+    if (part.heldFrozen) {
+        return;
     }
-    if (roomProcessor_) {
-        roomProcessor_->setSampleRate(config_.sampleRate);
+    std::unique_ptr<FrozenNotes> next(part.pendingFrozen.exchange(nullptr,
+                                                                  std::memory_order_acq_rel));
+    if (!next) {
+        return;
     }
+    part.heldFrozen = std::move(part.frozen);
+    part.frozen = std::move(next);
+    voices.setFrozenNotes(part.frozen->empty() ? nullptr : part.frozen.get());
 }
 
-double StringSynthEngine::sampleRate() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return config_.sampleRate;
+std::size_t StringSynthEngine::queuedEventCount() const {
+    return queuedEventCount_.load(std::memory_order_relaxed);
 }
 
-void StringSynthEngine::enqueueEvent(const Event& event) {
-    enqueueEventAt(event, frameCursor_.load(std::memory_order_relaxed));
+std::uint64_t StringSynthEngine::renderedFrames() const {
+    return frameCursor_.load(std::memory_order_relaxed);
 }
 
-void StringSynthEngine::enqueueEventAt(const Event& event,
-                                       std::uint64_t frameOffset) {
-    Event stamped = event;
-    stamped.frameOffset = frameOffset;
-    std::lock_guard<std::mutex> lock(mutex_);
-    eventQueue_.push_back(stamped);
+EngineStatus StringSynthEngine::status() const {
+    EngineStatus status;
+    status.sampleRate = sampleRateMirror_.load(std::memory_order_relaxed);
+    status.renderedFrames = frameCursor_.load(std::memory_order_relaxed);
+    status.activeVoices = activeVoices_.load(std::memory_order_relaxed);
+    status.voiceLimit = voiceLimit();
+    status.queuedEvents = queuedEventCount_.load(std::memory_order_relaxed);
+    status.hasScheduledEvent = hasScheduledEvent_.load(std::memory_order_relaxed);
+    status.nextEventFrame =
+        status.hasScheduledEvent ? nextEventFrame_.load(std::memory_order_relaxed) : 0;
+    return status;
 }
 
-void StringSynthEngine::noteOn(int noteId, double frequency, float velocity,
-                               double durationSeconds) {
-    if (frequency <= 0.0) {
-        return;
+void StringSynthEngine::reset() {
+    syncControlState();
+    // Queued notes are dropped; parameter values are already in the parts'
+    // paramValues.
+    PackedEvent dropped;
+    std::size_t droppedEvents = scheduledEvents_.size();
+    while (eventQueue_->pop(dropped)) {
+        ++droppedEvents;
     }
-    std::uint64_t startFrame = frameCursor_.load(std::memory_order_relaxed);
-    double currentSampleRate = 0.0;
-    int resolvedNoteId = noteId;
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        currentSampleRate = config_.sampleRate;
-        if (resolvedNoteId < 0) {
-            resolvedNoteId = nextNoteId_++;
+    scheduledEvents_.clear();
+    queuedEventCount_.fetch_sub(droppedEvents, std::memory_order_relaxed);
+    paramResyncPending_.store(false, std::memory_order_relaxed);
+    for (std::size_t p = 0; p < parts_.size(); ++p) {
+        Part& part = *parts_[p];
+        for (std::size_t i = 0; i < kParamCount; ++i) {
+            const auto id = static_cast<ParamId>(i);
+            if (p == 0 || !IsRoomParam(id)) {
+                applyParam(part, id, part.paramValues[i].load(std::memory_order_relaxed), true);
+            }
+        }
+        part.voiceManager->reset();
+        part.stereoHoldFrames = 0;
+        part.sympathetic.reset();
+        part.bodyFilter.reset();
+        // Nothing left to fade from.
+        if (part.fadingPreset) {
+            part.heldPreset = std::move(part.fadingPreset);
         }
     }
+    roomProcessor_->reset();
+    publishStatus();
+    frameCursor_.store(0, std::memory_order_relaxed);
+}
 
-    Event event;
-    event.type = EventType::NoteOn;
-    event.noteId = resolvedNoteId;
-    event.velocity = velocity;
-    event.frequency = frequency;
-    enqueueEventAt(event, startFrame);
+namespace {
 
-    if (durationSeconds > 0.0 && currentSampleRate > 0.0) {
-        const auto deltaFrames = static_cast<std::uint64_t>(
-            std::max(0.0, std::round(durationSeconds * currentSampleRate)));
-        Event off;
-        off.type = EventType::NoteOff;
-        off.noteId = resolvedNoteId;
-        enqueueEventAt(off, startFrame + deltaFrames);
+// Snapshot header. Voices and loop state go in as raw bytes, so the layout
+// word changes along with their structs and a stale snapshot is refused.
+constexpr std::uint32_t kSnapshotTag = 0x534E5453;  // "STNS"
+constexpr std::uint32_t kSnapshotVersion = 4;
+constexpr std::uint64_t kSnapshotLayout = (sizeof(Voice) << 8) | sizeof(void*);
+
+}  // namespace
+
+std::vector<std::uint8_t> StringSynthEngine::saveSnapshot() {
+    // What the next block would pick up anyway: queued events join the
+    // schedule and parameter changes land.
+    syncControlState();
+    dsp::StateWriter out;
+    out.pod(kSnapshotTag);
+    out.pod(kSnapshotVersion);
+    out.pod(kSnapshotLayout);
+    out.pod(parts_.front()->renderConfig.sampleRate);
+    out.pod(parts_.size());
+    out.pod(frameCursor_.load(std::memory_order_relaxed));
+    out.pod(scheduleCounter_);
+    out.pod(scheduledEvents_.size());
+    for (const ScheduledEvent& scheduled : scheduledEvents_) {
+        out.pod(scheduled);
+    }
+    for (const auto& part : parts_) {
+        out.pod(part->gainSmoother);
+        out.pod(part->stereoHoldFrames);
+        part->sympathetic.saveState(out);
+        part->bodyFilter.saveState(out);
+        part->voiceManager->saveState(out);
     }
+    roomProcessor_->saveState(out);
+    return out.release();
 }
 
-void StringSynthEngine::noteOff(int noteId) {
-    if (noteId < 0) {
-        return;
+bool StringSynthEngine::restoreSnapshot(std::span<const std::uint8_t> snapshot,
+                                        std::string& errorMessage) {
+    reset();
+    dsp::StateReader in(snapshot);
+    std::uint32_t tag = 0;
+    std::uint32_t version = 0;
+    std::uint64_t layout = 0;
+    in.pod(tag);
+    in.pod(version);
+    in.pod(layout);
+    if (!in.ok() || tag != kSnapshotTag) {
+        errorMessage = "不是引擎快照";
+        return false;
+    }
+    if (version != kSnapshotVersion || layout != kSnapshotLayout) {
+        errorMessage = "快照来自不同版本的引擎";
+        return false;
+    }
+    double sampleRate = 0.0;
+    std::size_t parts = 0;
+    in.pod(sampleRate);
+    in.pod(parts);
+    if (in.ok() && (sampleRate != parts_.front()->renderConfig.sampleRate ||
+                    parts != parts_.size())) {
+        errorMessage = "快照的采样率或声部数与引擎不符";
+        return false;
     }
-    Event event;
-    event.type = EventType::NoteOff;
-    event.noteId = noteId;
-    enqueueEvent(event);
-}
 
-void StringSynthEngine::noteOn(double frequency, double durationSeconds) {
-    noteOn(-1, frequency, 1.0f, durationSeconds);
+    std::uint64_t frame = 0;
+    std::uint64_t order = 0;
+    std::size_t events = 0;
+    in.pod(frame);
+    in.pod(order);
+    if (in.pod(events) && events > kMaxScheduledEvents) {
+        in.fail();
+    }
+    for (std::size_t i = 0; i < events && in.ok(); ++i) {
+        ScheduledEvent scheduled;
+        if (in.pod(scheduled) && scheduled.event.part >= parts_.size()) {
+            in.fail();
+        }
+        scheduledEvents_.push_back(scheduled);
+    }
+    for (const auto& part : parts_) {
+        in.pod(part->gainSmoother);
+        in.pod(part->stereoHoldFrames);
+        part->sympathetic.loadState(in);
+        part->bodyFilter.loadState(in);
+        part->voiceManager->loadState(in);
+    }
+    if (in.ok()) {
+        roomProcessor_->loadState(in);
+    }
+    if (!in.ok() || !in.atEnd()) {
+        // reset() again: also drops the events taken so far.
+        reset();
+        errorMessage = "快照数据不完整或与引擎设置不符";
+        return false;
+    }
+    std::make_heap(scheduledEvents_.begin(), scheduledEvents_.end(), ScheduledAfter);
+    scheduleCounter_ = order;
+    queuedEventCount_.fetch_add(scheduledEvents_.size(), std::memory_order_relaxed);
+    frameCursor_.store(frame, std::memory_order_relaxed);
+    publishStatus();
+    return true;
 }
 
-void StringSynthEngine::setParam(ParamId id, float value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    applyParamUnlocked(id, value, config_, masterGain_);
+void StringSynthEngine::setRenderMode(RenderMode mode) {
+    roomProcessor_->setRenderMode(mode);
 }
 
-float StringSynthEngine::getParam(ParamId id) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    switch (id) {
-        case ParamId::Decay:
-            return static_cast<float>(config_.decay);
-        case ParamId::Brightness:
-            return config_.brightness;
-        case ParamId::DispersionAmount:
-            return config_.dispersionAmount;
-        case ParamId::ExcitationBrightness:
-            return config_.excitationBrightness;
-        case ParamId::ExcitationVelocity:
-            return config_.excitationVelocity;
-        case ParamId::ExcitationMix:
-            return config_.excitationMix;
-        case ParamId::BodyTone:
-            return config_.bodyTone;
-        case ParamId::BodySize:
-            return config_.bodySize;
-        case ParamId::RoomAmount:
-            return config_.roomAmount;
-        case ParamId::RoomIR:
-            return static_cast<float>(config_.roomIrIndex);
-        case ParamId::PickPosition:
-            return config_.pickPosition;
-        case ParamId::EnableLowpass:
-            return config_.enableLowpass ? 1.0f : 0.0f;
-        case ParamId::NoiseType:
-            return config_.noiseType == synthesis::NoiseType::Binary ? 1.0f : 0.0f;
-        case ParamId::MasterGain:
-            return masterGain_;
-        case ParamId::AmpRelease:
-            return static_cast<float>(ampReleaseSeconds_);
-        default:
-            return 0.0f;
-    }
+RenderMode StringSynthEngine::renderMode() const {
+    return roomProcessor_->renderMode();
 }
 
-void StringSynthEngine::process(const ProcessBlock& block) {
-    if (!block.output || block.frames == 0 || block.channels == 0) {
-        return;
-    }
-    const std::size_t totalSamples = block.frames * block.channels;
-    std::fill(block.output, block.output + totalSamples, 0.0f);
+void StringSynthEngine::setRoomQuality(RoomQuality quality) {
+    roomProcessor_->setQuality(quality);
+}
 
-    const std::uint64_t blockStartFrame =
-        frameCursor_.load(std::memory_order_relaxed);
-    const std::uint64_t blockEndFrame = blockStartFrame + block.frames;
+RoomQuality StringSynthEngine::roomQuality() const {
+    return roomProcessor_->quality();
+}
 
-    std::vector<Event> pendingEvents;
-    synthesis::StringConfig currentConfig{};
-    float currentMasterGain = 1.0f;
-    double currentAmpRelease = 0.0;
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        currentConfig = config_;
-        currentMasterGain = masterGain_;
-        currentAmpRelease = ampReleaseSeconds_;
-        pendingEvents.swap(eventQueue_);
-    }
-
-    voiceManager_->setSampleRate(currentConfig.sampleRate);
-    voiceManager_->setReleaseSeconds(currentAmpRelease);
-
-    std::vector<Event> readyEvents;
-    std::vector<Event> futureEvents;
-    readyEvents.reserve(pendingEvents.size());
-    futureEvents.reserve(pendingEvents.size());
-
-    for (auto& event : pendingEvents) {
-        if (event.frameOffset <= blockStartFrame) {
-            event.frameOffset = blockStartFrame;
-            readyEvents.push_back(event);
-        } else if (event.frameOffset < blockEndFrame) {
-            readyEvents.push_back(event);
-        } else {
-            futureEvents.push_back(event);
-        }
-    }
+void StringSynthEngine::loadUserRoomIr(const std::filesystem::path& path) {
+    roomProcessor_->loadUserIr(path);
+}
 
-    std::stable_sort(
-        readyEvents.begin(), readyEvents.end(),
-        [](const Event& a, const Event& b) { return a.frameOffset < b.frameOffset; });
+UserIrStatus StringSynthEngine::userRoomIrStatus() const {
+    return roomProcessor_->userIrStatus();
+}
 
-    std::size_t eventIndex = 0;
-    for (std::size_t frame = 0; frame < block.frames; ++frame) {
-        const std::uint64_t absoluteFrame = blockStartFrame + frame;
-        while (eventIndex < readyEvents.size() &&
-               readyEvents[eventIndex].frameOffset <= absoluteFrame) {
-            handleEvent(readyEvents[eventIndex], currentConfig, currentMasterGain,
-                        currentAmpRelease);
-            ++eventIndex;
-        }
+int StringSynthEngine::userRoomIrIndex() {
+    return RoomProcessor::UserIrIndex();
+}
 
-        float sample = voiceManager_->renderFrame(currentMasterGain);
-        if (bodyFilter_) {
-            sample = bodyFilter_->process(sample);
-        }
-        float left = sample;
-        float right = sample;
-        if (roomProcessor_) {
-            roomProcessor_->process(sample, left, right);
-        }
-        if (block.channels >= 2) {
-            block.output[frame * block.channels] += left;
-            block.output[frame * block.channels + 1] += right;
-            for (uint16_t ch = 2; ch < block.channels; ++ch) {
-                block.output[frame * block.channels + ch] += sample;
-            }
-        } else if (block.channels == 1) {
-            block.output[frame] += 0.5f * (left + right);
-        }
+bool StringSynthEngine::SetRoomPartitionLayout(const std::vector<std::size_t>& blockSizes) {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes(blockSizes);
+    // FromBlockSizes drops entries it cannot use; the layout must be the one asked for.
+    if (!layout.valid() || layout.blockSizes != blockSizes ||
+        layout.baseBlockSize() < kMinRoomBlockFrames ||
+        layout.baseBlockSize() > kMaxRoomBlockFrames) {
+        return false;
     }
+    return RoomProcessor::SetPartitionLayout(layout);
+}
 
-    frameCursor_.fetch_add(block.frames, std::memory_order_relaxed);
+std::vector<std::size_t> StringSynthEngine::RoomPartitionBlockSizes() {
+    return RoomProcessor::PartitionBlockSizes();
+}
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        config_ = currentConfig;
-        masterGain_ = currentMasterGain;
-        ampReleaseSeconds_ = currentAmpRelease;
-        if (!futureEvents.empty()) {
-            eventQueue_.insert(eventQueue_.end(),
-                               std::make_move_iterator(futureEvents.begin()),
-                               std::make_move_iterator(futureEvents.end()));
-            std::stable_sort(
-                eventQueue_.begin(), eventQueue_.end(),
-                [](const Event& a, const Event& b) {
-                    return a.frameOffset < b.frameOffset;
-                });
-        }
+std::vector<std::size_t> StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile profile,
+                                                                   std::uint32_t bufferFrames) {
+    const std::size_t buffer = bufferFrames > 0 ? bufferFrames : kRoomBlockFrames;
+    std::size_t base = kRoomBlockFrames;
+    switch (profile) {
+    case RoomBlockProfile::LowLatency:
+        // Never longer than a buffer, so each callback hands the worker a block.
+        base = std::clamp<std::size_t>(std::bit_floor(buffer), kMinRoomBlockFrames,
+                                       kRoomBlockFrames / 2);
+        break;
+    case RoomBlockProfile::Balanced:
+    case RoomBlockProfile::Offline:
+        break;
+    case RoomBlockProfile::Efficient:
+        // One block per buffer, never below twice the balanced size.
+        base = std::clamp<std::size_t>(std::bit_ceil(buffer), 2 * kRoomBlockFrames,
+                                       kMaxRoomBlockFrames);
+        break;
     }
+    return {base, 4 * base, 16 * base};
 }
 
-std::size_t StringSynthEngine::activeVoiceCount() const {
-    return voiceManager_ ? voiceManager_->activeVoices() : 0;
+std::size_t StringSynthEngine::RoomTailFrames(int sampleRate, std::size_t blockFrames) {
+    return RoomProcessor::TailFrames(sampleRate, blockFrames);
 }
 
-std::size_t StringSynthEngine::queuedEventCount() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return eventQueue_.size();
+std::size_t StringSynthEngine::roomOutputDelayFrames() const {
+    return roomProcessor_ ? roomProcessor_->outputDelayFrames() : 0;
 }
 
-std::uint64_t StringSynthEngine::renderedFrames() const {
-    return frameCursor_.load(std::memory_order_relaxed);
+std::uint64_t StringSynthEngine::roomLateBlocks() const {
+    return roomProcessor_ ? roomProcessor_->lateBlocks() : 0;
+}
+
+RoomTelemetry StringSynthEngine::roomTelemetry() const {
+    return roomProcessor_ ? roomProcessor_->telemetry() : RoomTelemetry{};
 }
 
 std::vector<std::uint64_t> StringSynthEngine::queuedEventFrames() const {
-    std::lock_guard<std::mutex> lock(mutex_);
     std::vector<std::uint64_t> frames;
-    frames.reserve(eventQueue_.size());
-    for (const auto& event : eventQueue_) {
-        frames.push_back(event.frameOffset);
+    frames.reserve(scheduledEvents_.size());
+    for (const auto& scheduled : scheduledEvents_) {
+        frames.push_back(scheduled.event.frame);
     }
+    eventQueue_->forEachPending(
+        [&frames](const PackedEvent& event) { frames.push_back(event.frame); });
+    std::sort(frames.begin(), frames.end());
     return frames;
 }
 
-void StringSynthEngine::handleEvent(const Event& event,
-                                    synthesis::StringConfig& config,
-                                    float& masterGain,
-                                    double& ampRelease) {
+void StringSynthEngine::handleEvent(const PackedEvent& event) {
+    // packEvent() only lets through parts that exist.
+    Part& part = *parts_[event.part];
     switch (event.type) {
         case EventType::NoteOn:
-            voiceManager_->noteOn(event.noteId, event.frequency, event.velocity, config);
+            part.voiceManager->noteOn(event.noteId, event.frequency, event.value,
+                                      part.renderConfig);
             break;
         case EventType::NoteOff:
-            voiceManager_->noteOff(event.noteId);
+            part.voiceManager->noteOff(event.noteId);
             break;
         case EventType::ParamChange:
-            applyParamUnlocked(event.param, event.paramValue, config, masterGain);
-            ampRelease = ampReleaseSeconds_;
-            voiceManager_->setReleaseSeconds(ampRelease);
+            // Values stamped at frame 0 are the initial setup, not a change
+            // to glide through.
+            applyParam(part, static_cast<ParamId>(event.param), event.value, event.frame == 0);
+            break;
+        case EventType::NoteExpression:
+            part.voiceManager->noteExpression(event.noteId,
+                                              static_cast<NoteExpression>(event.param),
+                                              event.value);
             break;
         default:
             break;
     }
 }
 
-void StringSynthEngine::applyParamUnlocked(ParamId id, float value,
-                                           synthesis::StringConfig& config,
-                                           float& masterGain) {
+float* StringSynthEngine::renderPart(Part& part, std::size_t frames, StageLap& lap,
+                                     const float* input, float* stringsLeft,
+                                     float* stringsRight) {
+    float* left = part.mixLeft.data();
+    // A mono voice mix (nothing panned) stays in `left` alone and takes the
+    // cheaper mono path through the body. Once the pans narrow back to the
+    // middle, the body's two states still differ, so both keep running on
+    // the same input until they have rung together.
+    float* right = nullptr;
+    if (part.voiceManager->renderBlock(left, part.mixRight.data(), frames)) {
+        right = part.mixRight.data();
+        part.stereoHoldFrames =
+            static_cast<std::size_t>(kStereoHoldSeconds * part.renderConfig.sampleRate);
+    } else if (part.stereoHoldFrames > 0) {
+        right = part.mixRight.data();
+        std::copy(left, left + frames, right);
+        part.stereoHoldFrames -= std::min(part.stereoHoldFrames, frames);
+    }
+    // The live input on each route at this part's gain, ramped across the
+    // segment so neither a gain nor a mode change steps.
+    const float* excite = nullptr;
+    const float bodyTarget = part.inputMode == LiveInputMode::Body ? part.inputGain : 0.0f;
+    const float stringsTarget = part.inputMode == LiveInputMode::Strings ? part.inputGain : 0.0f;
+    if (RampLiveInput(input, part.exciteScratch.data(), part.stringsInputGain, stringsTarget,
+                      frames)) {
+        excite = part.exciteScratch.data();
+    }
+    if (float* scaled = part.inputScratch.data();
+        RampLiveInput(input, scaled, part.bodyInputGain, bodyTarget, frames)) {
+        // A commuted body is in the voices' excitation, not in the chain,
+        // so the input gets it on its own.
+        if (part.renderConfig.bodyMode == synthesis::BodyMode::Commuted) {
+            part.bodyFilter.processBlock(scaled, nullptr, frames);
+        }
+        for (std::size_t i = 0; i < frames; ++i) {
+            left[i] += scaled[i];
+        }
+        if (right) {
+            for (std::size_t i = 0; i < frames; ++i) {
+                right[i] += scaled[i];
+            }
+        }
+    }
+    ApplySmoothedGain(part.gainSmoother, left, right, frames);
+    if (stringsLeft) {
+        const float* fromRight = right ? right : left;
+        for (std::size_t i = 0; i < frames; ++i) {
+            stringsLeft[i] += left[i];
+            stringsRight[i] += fromRight[i];
+        }
+    }
+    lap.mark(ProfileStage::Voices);
+    if (part.fadingPreset) {
+        renderPresetFade(part, left, right, frames, excite);
+    } else {
+        part.sympathetic.processBlock(left, right, frames, excite);
+        if (part.renderConfig.bodyMode == synthesis::BodyMode::PostFilter) {
+            part.bodyFilter.processBlock(left, right, frames);
+        }
+    }
+    lap.mark(ProfileStage::Body);
+    return right;
+}
+
+void StringSynthEngine::renderPresetFade(Part& part, float* left, float* right,
+                                         std::size_t frames, const float* excite) {
+    PresetChange& old = *part.fadingPreset;
+    float* oldLeft = old.fadeLeft.data();
+    float* oldRight = right ? old.fadeRight.data() : nullptr;
+    std::copy(left, left + frames, oldLeft);
+    if (right) {
+        std::copy(right, right + frames, oldRight);
+    }
+    old.sympathetic.processBlock(oldLeft, oldRight, frames, excite);
+    if (old.bodyMode == synthesis::BodyMode::PostFilter) {
+        old.bodyFilter.processBlock(oldLeft, oldRight, frames);
+    }
+    part.sympathetic.processBlock(left, right, frames, excite);
+    if (part.renderConfig.bodyMode == synthesis::BodyMode::PostFilter) {
+        part.bodyFilter.processBlock(left, right, frames);
+    }
+
+    // Linear: the two bodies hear the same voices, so their outputs are
+    // strongly correlated.
+    const float step = 1.0f / static_cast<float>(old.fadeFrames);
+    float mix = static_cast<float>(old.fadeDone) * step;
+    for (std::size_t i = 0; i < frames; ++i) {
+        const float g = std::min(mix, 1.0f);
+        left[i] = oldLeft[i] + g * (left[i] - oldLeft[i]);
+        if (right) {
+            right[i] = oldRight[i] + g * (right[i] - oldRight[i]);
+        }
+        mix += step;
+    }
+    old.fadeDone += frames;
+    if (old.fadeDone >= old.fadeFrames) {
+        part.heldPreset = std::move(part.fadingPreset);
+    }
+}
+
+void StringSynthEngine::commitPreset(Part& part) {
+    if (part.heldPreset) {
+        PresetChange* empty = nullptr;
+        if (part.retiredPreset.compare_exchange_strong(empty, part.heldPreset.get(),
+                                                       std::memory_order_acq_rel)) {
+            (void)part.heldPreset.release();
+        }
+    }
+    // One change at a time, and only once the last is back with the control
+    // side, so the audio thread never frees one.
+    if (part.fadingPreset || part.heldPreset) {
+        return;
+    }
+    std::unique_ptr<PresetChange> change(
+        part.pendingPreset.exchange(nullptr, std::memory_order_acq_rel));
+    if (!change) {
+        return;
+    }
+    const double sampleRate = part.renderConfig.sampleRate;
+    if (change->config.sampleRate != sampleRate) {
+        // The rate moved on since the preset was built; rare enough to redo.
+        change->bodyFilter.setSampleRate(sampleRate);
+        change->sympathetic.setSampleRate(sampleRate);
+    }
+    std::swap(part.bodyFilter, change->bodyFilter);
+    std::swap(part.sympathetic, change->sympathetic);
+    change->bodyMode = part.renderConfig.bodyMode;
+
+    const bool lead = &part == parts_.front().get();
+    for (ParamId id : kConfigParams) {
+        if (lead || !IsRoomParam(id)) {
+            StoreParamValue(id, LoadParamValue(id, change->config, 0.0f, 0.0), part.renderConfig,
+                            part.masterGain, part.ampReleaseSeconds);
+        }
+    }
+    part.masterGain = change->masterGain;
+    part.ampReleaseSeconds = change->ampRelease;
+    part.gainSmoother.setTarget(part.masterGain);
+    part.voiceManager->setReleaseSeconds(part.ampReleaseSeconds);
+    part.voiceManager->setStereoSpread(part.renderConfig.stereoSpread);
+    updateBodyResponse(part);
+    if (lead) {
+        roomProcessor_->setMix(part.renderConfig.roomAmount);
+        roomProcessor_->setIrIndex(part.renderConfig.roomIrIndex);
+        roomProcessor_->setAlgorithmic(part.renderConfig.roomType ==
+                                       synthesis::RoomType::Algorithmic);
+    }
+
+    change->fadeFrames =
+        std::max<std::size_t>(1, static_cast<std::size_t>(kPresetCrossfadeSeconds * sampleRate));
+    change->fadeDone = 0;
+    part.fadingPreset = std::move(change);
+}
+
+void StringSynthEngine::updateBodyResponse(Part& part) {
+    if (part.renderConfig.bodyMode == synthesis::BodyMode::Commuted) {
+        const auto& response = part.bodyFilter.response();
+        const auto& oversampled = part.bodyFilter.responseOversampled();
+        part.voiceManager->setBodyResponse(response.data(), response.size(), oversampled.data(),
+                                           oversampled.size());
+    } else {
+        part.voiceManager->setBodyResponse(nullptr, 0, nullptr, 0);
+    }
+}
+
+void StringSynthEngine::applyParam(Part& part, ParamId id, float value, bool immediate) {
     const auto* info = GetParamInfo(id);
     if (!info) {
         return;
     }
     const float clamped = ClampToRange(*info, value);
+    StoreParamValue(id, clamped, part.renderConfig, part.masterGain, part.ampReleaseSeconds);
     switch (id) {
-        case ParamId::Decay:
-            config.decay = clamped;
-            break;
-        case ParamId::Brightness:
-            config.brightness = clamped;
-            break;
-        case ParamId::DispersionAmount:
-            config.dispersionAmount = clamped;
-            break;
-        case ParamId::ExcitationBrightness:
-            config.excitationBrightness = clamped;
-            break;
-        case ParamId::ExcitationVelocity:
-            config.excitationVelocity = clamped;
+        case ParamId::BodyTone:
+        case ParamId::BodySize:
+            if (immediate) {
+                part.bodyFilter.snapParams(part.renderConfig.bodyTone, part.renderConfig.bodySize);
+            } else {
+                part.bodyFilter.setParams(part.renderConfig.bodyTone, part.renderConfig.bodySize);
+            }
+            updateBodyResponse(part);
             break;
-        case ParamId::ExcitationMix:
-            config.excitationMix = clamped;
+        case ParamId::BodyModel:
+            part.bodyFilter.setModel(part.renderConfig.bodyModel);
+            part.sympathetic.setTuning(SympatheticTuning(part.renderConfig.bodyModel));
+            updateBodyResponse(part);
             break;
-        case ParamId::BodyTone:
-            config.bodyTone = clamped;
-            if (bodyFilter_) {
-                bodyFilter_->setParams(config.bodyTone, config.bodySize);
+        case ParamId::BodyMode:
+            if (part.renderConfig.bodyMode == synthesis::BodyMode::PostFilter) {
+                part.bodyFilter.reset();  // drop state left from before commuting
             }
+            updateBodyResponse(part);
             break;
-        case ParamId::BodySize:
-            config.bodySize = clamped;
-            if (bodyFilter_) {
-                bodyFilter_->setParams(config.bodyTone, config.bodySize);
+        case ParamId::MasterGain:
+            if (immediate) {
+                part.gainSmoother.snap(part.masterGain);
+            } else {
+                part.gainSmoother.setTarget(part.masterGain);
             }
             break;
         case ParamId::RoomAmount:
-            config.roomAmount = clamped;
-            if (roomProcessor_) {
-                roomProcessor_->setMix(config.roomAmount);
-            }
+            roomProcessor_->setMix(part.renderConfig.roomAmount);
+            break;
+        case ParamId::SympatheticAmount:
+            part.sympathetic.setAmount(part.renderConfig.sympatheticAmount);
+            break;
+        case ParamId::StereoSpread:
+            part.voiceManager->setStereoSpread(part.renderConfig.stereoSpread);
             break;
         case ParamId::RoomIR:
-            config.roomIrIndex = static_cast<int>(std::lround(clamped));
-            if (roomProcessor_) {
-                roomProcessor_->setIrIndex(config.roomIrIndex);
-            }
+            roomProcessor_->setIrIndex(part.renderConfig.roomIrIndex);
             break;
-        case ParamId::PickPosition:
-            config.pickPosition = clamped;
+        case ParamId::RoomType:
+            roomProcessor_->setAlgorithmic(part.renderConfig.roomType ==
+                                           synthesis::RoomType::Algorithmic);
             break;
-        case ParamId::EnableLowpass:
-            config.enableLowpass = clamped >= 0.5f;
+        case ParamId::AmpRelease:
+            part.voiceManager->setReleaseSeconds(part.ampReleaseSeconds);
             break;
-        case ParamId::NoiseType:
-            config.noiseType =
-                (clamped >= 0.5f) ? synthesis::NoiseType::Binary : synthesis::NoiseType::White;
+        case ParamId::PitchBend:
+            part.voiceManager->setPitchBend(clamped, immediate);
             break;
-        case ParamId::MasterGain:
-            masterGain = clamped;
+        case ParamId::VibratoRate:
+            part.voiceManager->setVibratoRate(clamped);
             break;
-        case ParamId::AmpRelease:
-            ampReleaseSeconds_ = clamped;
-            if (voiceManager_) {
-                voiceManager_->setReleaseSeconds(ampReleaseSeconds_);
+        case ParamId::VibratoDepth:
+            part.voiceManager->setVibratoDepth(clamped);
+            break;
+        case ParamId::SustainPedal:
+            part.voiceManager->setSustainPedal(clamped >= 0.5f);
+            break;
+        case ParamId::SostenutoPedal:
+            part.voiceManager->setSostenutoPedal(clamped >= 0.5f);
+            break;
+        case ParamId::InputMode:
+        case ParamId::InputGain:
+            if (id == ParamId::InputMode) {
+                part.inputMode = static_cast<LiveInputMode>(static_cast<int>(clamped + 0.5f));
+            } else {
+                part.inputGain = clamped;
+            }
+            if (immediate) {
+                part.bodyInputGain = part.inputMode == LiveInputMode::Body ? part.inputGain : 0.0f;
+                part.stringsInputGain =
+                    part.inputMode == LiveInputMode::Strings ? part.inputGain : 0.0f;
             }
             break;
         default:
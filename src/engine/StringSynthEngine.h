@@ -1,88 +1,549 @@
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <span>
+#include <string>
 #include <vector>
 
+#include "dsp/ModalBody.h"
+#include "engine/ModulationMatrix.h"
+#include "engine/Preset.h"
+#include "engine/StageProfiler.h"
 #include "engine/StringParams.h"
+#include "engine/TripleBuffer.h"
 #include "synthesis/KarplusStrongString.h"
 
 namespace engine {
 
 class BodyFilter;
 class RoomProcessor;
+class VoiceRenderPool;
 
-enum class EventType { NoteOn, NoteOff, ParamChange };
+enum class EventType : std::uint8_t { NoteOn, NoteOff, ParamChange, NoteExpression };
+
+// Per-note (MPE-style) expression of one sounding note: its own pitch bend in
+// semitones, added to the part's, plus pressure (0..1) and timbre (0..1,
+// 0.5 neutral like CC 74 at 64), which reach the sound through the
+// modulation routes (ModSource::Pressure, ModSource::Timbre).
+enum class NoteExpression : std::uint8_t { PitchBend, Pressure, Timbre };
+inline constexpr float kMaxNoteBendSemitones = 48.0f;  // the MPE default range
 
 struct Event {
     EventType type = EventType::NoteOn;
     int noteId = -1;
     float velocity = 1.0f;
     ParamId param = ParamId::Decay;
+    // NoteExpression events set `expression` of note `noteId` to paramValue.
+    NoteExpression expression = NoteExpression::PitchBend;
     float paramValue = 0.0f;
     double frequency = 440.0;
     double durationSeconds = 1.0;
     // 绝对帧时间戳，基于当前采样率
     std::uint64_t frameOffset = 0;
+    // Part that plays the note or takes the parameter (see partCount()).
+    std::size_t part = 0;
 };
 
 struct ProcessBlock {
     float* output = nullptr;
     std::size_t frames = 0;
     uint16_t channels = 1;
+    // Live input captured in the same device period, `frames` interleaved
+    // frames of `inputChannels`; null (or no channels) for none. Parts take
+    // the mid of its first two channels as ParamId::InputMode routes it.
+    const float* input = nullptr;
+    uint16_t inputChannels = 0;
+};
+
+// Non-interleaved output: channels[ch] points at `frames` contiguous samples
+// (null entries are skipped). Channel layout matches ProcessBlock, and so
+// does the live input in `inputs`, also planar.
+struct PlanarProcessBlock {
+    float* const* channels = nullptr;
+    std::size_t frames = 0;
+    uint16_t channelCount = 1;
+    const float* const* inputs = nullptr;
+    uint16_t inputCount = 0;
+};
+
+// Stems rendered in the same pass as the mix. Each is a planar stereo pair
+// of `frames` samples starting where the block does; null pointers are
+// skipped. strings + body + room add up to the stereo mix, and so do the
+// parts plus room (a mono mix is their mid):
+//   strings   every part's voices (and live input sent to a body), before
+//             sympathetic strings and body
+//   body      what the sympathetic strings and post-filter body change
+//   room      the room's wet return
+//   parts[p]  part p's strings and body, for p < partCount()
+// The dry stems carry the room's dry gain, so they follow the room mix.
+struct StemOutputs {
+    using Pair = std::array<float*, 2>;
+    Pair strings{};
+    Pair body{};
+    Pair room{};
+    std::array<Pair, 8> parts{};  // StringSynthEngine::kMaxParts
+};
+
+// How the room reverb tail is scheduled. Realtime hands it to a worker thread
+// a few blocks ahead of need; Offline renders it inline in process(), so batch
+// renders run as fast as the CPU allows and sound exactly like a live worker
+// that never runs late. Auto starts as Realtime and switches to Offline once
+// process() is seen running far faster than realtime.
+enum class RenderMode { Auto, Realtime, Offline };
+
+// How much of each room IR is convolved. Full runs every IR to its last
+// sample; the others cut it where its energy decay curve (Schroeder
+// integral) has fallen 80, 60 or 40 dB, trading the faintest part of the
+// tail for a shorter kernel on machines that would otherwise drop out.
+enum class RoomQuality { Full, High, Medium, Low };
+
+// Room block size against the device buffer. LowLatency follows small
+// buffers down to 64 frames, so the head the audio thread convolves and the
+// tail's granularity shrink with them; Efficient follows large ones up to
+// 1024 for fewer, cheaper FFTs per second; Balanced keeps 256. Offline
+// keeps Balanced's blocks but has the tuner pick the stages for throughput
+// alone, as nothing waits on a tail rendered inline.
+enum class RoomBlockProfile { LowLatency, Balanced, Efficient, Offline };
+
+// Where a part sends the live input of a block (ParamId::InputMode). Body
+// adds it to the part's voices ahead of the sympathetic strings, body and
+// room, as an effect at the synth's own latency; Strings drives only the
+// sympathetic strings, so what is heard is their resonance (nothing while
+// SympatheticAmount is 0). Off ignores it.
+enum class LiveInputMode { Off, Body, Strings };
+
+// Progress of the last loadUserRoomIr() call.
+enum class UserIrStatus { None, Loading, Ready, Failed };
+
+// A part's setPartFrozen() state; Rendering plays modelled notes meanwhile.
+enum class FreezeStatus { Off, Rendering, Ready };
+
+// Room reverb worker health, cumulative over the engine's lifetime (reset()
+// keeps it).
+struct RoomTelemetry {
+    std::uint64_t lateBlocks = 0;        // tail blocks not ready when due
+    std::uint64_t droppedDryBlocks = 0;  // input blocks lost to a full queue
+    std::uint64_t droppedWetBlocks = 0;  // rendered blocks lost to a full queue
+    std::size_t dryQueueHighWater = 0;   // blocks waiting for the worker
+    std::size_t wetQueueHighWater = 0;   // rendered blocks not yet consumed
+    std::size_t outputDelayFrames = 0;
+    bool suspended = false;  // convolution tail parked (mix at zero or algorithmic room)
+    // Tail render time per block (worker or inline), from a 10 us histogram;
+    // overruns took longer than the block lasts.
+    std::uint64_t tailBlocks = 0;
+    std::uint64_t tailOverruns = 0;
+    double tailBlockUsMean = 0.0;
+    double tailBlockUsP99 = 0.0;
+    double tailBlockUsMax = 0.0;
 };
 
+// What a UI polls for display, read from atomics the engine keeps current
+// (see StringSynthEngine::status()); no lock, no walk over the queue.
+struct EngineStatus {
+    double sampleRate = 0.0;
+    std::uint64_t renderedFrames = 0;
+    std::size_t activeVoices = 0;
+    std::size_t voiceLimit = 0;
+    std::size_t queuedEvents = 0;  // queued or scheduled, not yet handled
+    // Frame of the earliest scheduled event as of the last block, when
+    // hasScheduledEvent.
+    std::uint64_t nextEventFrame = 0;
+    bool hasScheduledEvent = false;
+};
+
+// The StringConfig field (or part gain and release) behind a parameter.
+// Store expects a value already clamped to the parameter's range; ids with
+// no place in the config are ignored on store and read as their default.
+void StoreParamValue(ParamId id, float value, synthesis::StringConfig& config,
+                     float& masterGain, double& ampRelease);
+float LoadParamValue(ParamId id, const synthesis::StringConfig& config, float masterGain,
+                     double ampRelease);
+
 class StringSynthEngine {
 public:
-    explicit StringSynthEngine(synthesis::StringConfig config = {});
+    static constexpr std::size_t kDefaultMaxVoices = 16;
+    static constexpr std::size_t kMaxVoicesLimit = 128;
+    static constexpr std::size_t kMaxParts = 8;
+    static_assert(std::tuple_size_v<decltype(StemOutputs::parts)> == kMaxParts);
+
+    // maxVoices is clamped to [1, kMaxVoicesLimit]; the voice pool is
+    // preallocated for that many voices. renderThreads > 0 adds that many
+    // helper threads for voice rendering (output is identical either way).
+    // `parts` (clamped to [1, kMaxParts]) layers that many instruments, each
+    // with its own config, parameters, maxVoices voices and body, all mixed
+    // into one room; every part starts from `config`.
+    explicit StringSynthEngine(synthesis::StringConfig config = {},
+                               std::size_t maxVoices = kDefaultMaxVoices,
+                               std::size_t renderThreads = 0, std::size_t parts = 1);
     ~StringSynthEngine();
 
+    // Part 0; the part-addressed versions below work on any part. The sample
+    // rate and the room fields (roomAmount, roomIrIndex, roomType) are shared:
+    // only part 0's config sets them, and every part reports them.
     void setConfig(const synthesis::StringConfig& config);
     synthesis::StringConfig stringConfig() const;
+    void setPartConfig(std::size_t part, const synthesis::StringConfig& config);
+    synthesis::StringConfig partConfig(std::size_t part) const;
+    std::size_t partCount() const { return parts_.size(); }
 
     void setSampleRate(double sampleRate);
     double sampleRate() const;
 
+    // Event entry points are lock-free and may be called from any thread.
+    // enqueueEventAt returns false if the event queue is full or the event
+    // names a part that does not exist. Note ids are per part.
     void enqueueEvent(const Event& event);
-    void enqueueEventAt(const Event& event, std::uint64_t frameOffset);
+    bool enqueueEventAt(const Event& event, std::uint64_t frameOffset);
+    // Queues a run of events, each at its own frameOffset, claiming queue
+    // space for as many as fit in one step. Returns how many were taken from
+    // the front; the rest start with one the queue had no room for or that
+    // enqueueEventAt would refuse. NoteOn durations are ignored here, as in
+    // enqueueEventAt; queue the NoteOff alongside.
+    std::size_t enqueueEvents(std::span<const Event> events);
     void noteOn(int noteId, double frequency, float velocity = 1.0f,
-                double durationSeconds = 0.0);
-    void noteOff(int noteId);
+                double durationSeconds = 0.0, std::size_t part = 0);
+    void noteOff(int noteId, std::size_t part = 0);
     void noteOn(double frequency, double durationSeconds);
+    // Changes one expression of a sounding note; a note that has not started
+    // or has ended ignores it, and a fresh note-on starts from neutral. The
+    // voice keeps the values in slots of its own and reads them at control
+    // rate: bend glides like the part's, pressure and timbre feed the
+    // modulation routes.
+    void noteExpression(int noteId, NoteExpression expression, float value,
+                        std::size_t part = 0);
 
+    // Part 0. Room parameters go to the shared room whichever part they are
+    // sent to.
     void setParam(ParamId id, float value);
     float getParam(ParamId id) const;
+    void setPartParam(std::size_t part, ParamId id, float value);
+    float getPartParam(std::size_t part, ParamId id) const;
+    // A snapshot of several parameters, all taking effect at the same frame
+    // and queued with one claim on the event queue per kParamCount-sized
+    // run, where per-parameter calls take one each. Continuous parameters
+    // still glide to their new values. A value the full queue could not take
+    // is picked up at the next block.
+    void setParams(std::span<const ParamValue> values, std::size_t part = 0);
+
+    // Mode table for every part's modal body models (e.g. from a preset),
+    // replacing the built-in guitar and koto tables; empty restores those. Up to
+    // dsp::ModalBody::kMaxModes modes are kept. Safe from any thread; takes
+    // effect at the next block.
+    void setBodyModes(std::span<const dsp::ModalBody::Mode> modes);
+
+    // LFO, envelope, velocity and key-tracking routes onto every part's
+    // voice brightness, decay and pick position, evaluated per voice every
+    // ModulationMatrix::kControlFrames. No routes (the default) leaves the
+    // voices untouched. Safe from any thread; takes effect at the next block.
+    void setModulation(const ModulationSettings& settings);
+
+    // Switches a part to a whole patch without a spike on the audio thread.
+    // The body filter, its commuted response and the sympathetic strings are
+    // built here, on the caller's thread; process() swaps them in at the next
+    // block and crossfades the part from its old body over
+    // kPresetCrossfadeSeconds while the gain glides. Sounding notes ring on
+    // with the settings they started with; the room (part 0 only) changes
+    // over on its worker as usual. The preset's sample rate is ignored. A
+    // preset sent while one is still fading in waits for it to finish;
+    // parameter changes queued before the call may land after it. Control
+    // threads only.
+    void loadPreset(const Preset& preset, std::size_t part = 0);
+    static constexpr double kPresetCrossfadeSeconds = 0.02;
+
+    // Silences all voices, drops queued events and clears filter and room
+    // state, then restarts the timeline at frame 0; parameters and config are
+    // kept. Call from the thread that runs process(), never concurrently with
+    // it (it waits for the room worker).
+    void reset();
+
+    // Everything the engine is sounding, as a binary snapshot: each voice's
+    // string, envelope and modulation, the sympathetic strings, the bodies,
+    // the gain glides, the timeline and the events scheduled on it (queued
+    // ones are drained into the schedule first), and the room: its reverb
+    // histories and overlaps, queued tail blocks, IR head and network.
+    // restoreSnapshot() puts it back so the render carries on sample for
+    // sample, e.g. after a device change or to start an offline segment
+    // mid-render. The restoring engine must already have the same part and
+    // voice counts, sample rate, configs, parameters, body modes, room
+    // quality and user IR; only running state travels, and the room kernels
+    // it needs are built during the restore. Not kept: frozen notes and a
+    // preset crossfade in progress. A snapshot restores only into the same
+    // build on the same architecture. Both calls come from the thread that
+    // runs process(), never concurrently with it (saving briefly holds off
+    // the room worker); not real-time safe.
+    std::vector<std::uint8_t> saveSnapshot();
+    // False, with the reason in `errorMessage`, if the snapshot was cut short
+    // or does not match this engine; the parts are then left silent.
+    bool restoreSnapshot(std::span<const std::uint8_t> snapshot, std::string& errorMessage);
+
+    // Takes effect at the next room block boundary; safe from any thread.
+    void setRenderMode(RenderMode mode);
+    RenderMode renderMode() const;
+
+    // Takes effect at the next room block boundary; the room tail restarts
+    // from silence when the kernels change. Safe from any thread.
+    void setRoomQuality(RoomQuality quality);
+    RoomQuality roomQuality() const;
+
+    // Loads a room IR from a WAV file (mono or stereo; later channels are
+    // ignored) on a background thread. Decoding, resampling and the kernel
+    // build never block the caller or process(); the room switches over at a
+    // block boundary once the kernel is ready. The IR is selected with
+    // ParamId::RoomIR == userRoomIrIndex(); until one is ready that index
+    // plays IR 0. A new load replaces the previous user IR.
+    void loadUserRoomIr(const std::filesystem::path& path);
+    UserIrStatus userRoomIrStatus() const;
+    static int userRoomIrIndex();
+
+    // Room tail partitioning, shared by every engine in the process. The
+    // tail convolves blocks of the layout's base size on the worker,
+    // consumed kRoomLeadBlocks late behind an IR head of that many blocks;
+    // the layout is {kRoomBlockFrames, 1024, 4096} unless
+    // SetRoomPartitionLayout() chose another (ascending powers of two from a
+    // base of kMinRoomBlockFrames to kMaxRoomBlockFrames). That holds only
+    // until the first room is built: it returns false after, or for an
+    // invalid layout. See engine/RoomPartitionTuner.h.
+    static constexpr std::size_t kRoomBlockFrames = 256;
+    static constexpr std::size_t kMinRoomBlockFrames = 64;
+    static constexpr std::size_t kMaxRoomBlockFrames = 1024;
+    static constexpr std::size_t kRoomLeadBlocks = 6;
+    static bool SetRoomPartitionLayout(const std::vector<std::size_t>& blockSizes);
+    static std::vector<std::size_t> RoomPartitionBlockSizes();
+    // The base and 4x and 16x stages for `profile` with a device buffer of
+    // `bufferFrames` (0 if unknown).
+    static std::vector<std::size_t> RoomProfileBlockSizes(RoomBlockProfile profile,
+                                                          std::uint32_t bufferFrames);
+    // Longest library IR at `sampleRate`, less the part the head convolves
+    // with `blockFrames` room blocks.
+    static std::size_t RoomTailFrames(int sampleRate, std::size_t blockFrames = kRoomBlockFrames);
 
     void process(const ProcessBlock& block);
+    void process(const PlanarProcessBlock& block);
+    // The same, also writing `stems` for block.frames frames.
+    void process(const ProcessBlock& block, const StemOutputs& stems);
+    void process(const PlanarProcessBlock& block, const StemOutputs& stems);
+    // Summed over the parts as of the last process() or reset(); maxVoices()
+    // is per part. Safe from any thread.
     std::size_t activeVoiceCount() const;
+    std::size_t maxVoices() const { return maxVoices_; }
+    // Caps the voices each part sounds below maxVoices() (0 lifts the cap),
+    // e.g. to shed load; voices over a lowered cap fade out like stolen
+    // ones. Safe from any thread; takes effect at the next block.
+    void setVoiceLimit(std::size_t voices);
+    std::size_t voiceLimit() const;
+    // Caps what each part's voices cost to render, in units of a string with
+    // the default config at the engine rate (oversampled, hammered or long
+    // strings cost more, frozen notes less); 0 lifts it. A note over the
+    // budget steals the voices with the least energy per cost until it
+    // fits, so cheap voices sound in greater numbers for the same load.
+    // Applies with the voice limit; safe from any thread.
+    void setVoiceBudget(float cost);
+    float voiceBudget() const;
+    // Notes struck at or above this pitch (bend included) render their
+    // string at twice the sample rate and are decimated back through a
+    // halfband filter, which keeps the top register in tune and free of
+    // loop-filter warping; 0 renders every voice at the engine rate. The
+    // body response follows, the room does not. Safe from any thread;
+    // applies from the next note-on.
+    static constexpr double kDefaultOversamplingThresholdHz = 1760.0;
+    void setOversamplingThreshold(double frequencyHz);
+    double oversamplingThreshold() const;
+    // Random-noise notes (seed 0) copy excitations a helper thread shaped
+    // ahead of time from synthesis::ExcitationPool instead of shaping them
+    // at note-on; velocity then moves pick and colour in
+    // ExcitationPool::kVelocityBuckets steps. Off by default so renders
+    // stay reproducible. The pool starts with the first enable and lives as
+    // long as the engine. Control threads; applies from the next note-on.
+    void setExcitationPrewarm(bool enabled);
+    bool excitationPrewarm() const;
+    // Freezes a part into a sampler: a helper thread strikes every key from
+    // A0 to C8 at kFreezeVelocityLayers velocities through the part's
+    // current config (loadPreset() renders again while frozen), and once it
+    // is Ready new notes play the nearest key and layer back, repitched,
+    // instead of modelling a string. Modulation, the commuted body and
+    // oversampling don't reach frozen notes, which end with their sample
+    // (at most kFreezeSeconds); the body filter, sympathetic strings and
+    // room still run. Unfreezing goes back to modelled notes from the next
+    // note-on. Control threads only.
+    static constexpr std::size_t kFreezeVelocityLayers = 3;
+    static constexpr double kFreezeSeconds = 3.0;
+    void setPartFrozen(std::size_t part, bool frozen);
+    FreezeStatus partFreezeStatus(std::size_t part) const;
     std::size_t queuedEventCount() const;
     std::uint64_t renderedFrames() const;
+    // Lock-free, from any thread; values may be a block apart from each
+    // other. getParam(), stringConfig() and sampleRate() take no lock either.
+    EngineStatus status() const;
+    // Room reverb tail: how far it trails its input (adapted to the worker's
+    // timing and covered by the zero-latency head) and how many tail blocks
+    // missed their deadline. Safe to call from any thread.
+    std::size_t roomOutputDelayFrames() const;
+    std::uint64_t roomLateBlocks() const;
+    RoomTelemetry roomTelemetry() const;
+    // Cumulative per-stage time inside process(); all zero unless built with
+    // SATORI_ENABLE_PROFILING. Safe to call from any thread.
+    StageProfile stageProfile() const { return profiler_.snapshot(); }
+    // Diagnostic snapshot that copies the queue; not synchronized with a
+    // concurrent process(). Use status() for polling.
     std::vector<std::uint64_t> queuedEventFrames() const;
 
 private:
     class VoiceManager;
+    class EventQueue;
+    struct Part;
+    struct PresetChange;
+    struct FreezeRender;
 
-    void handleEvent(const Event& event, synthesis::StringConfig& config,
-                     float& masterGain, double& ampRelease);
-    void applyParamUnlocked(ParamId id, float value,
-                            synthesis::StringConfig& config,
-                            float& masterGain);
-    static constexpr std::size_t kMaxVoices = 8;
+    // Settings that rebuild render state rather than being smoothed.
+    struct PartStructure {
+        unsigned int seed = 0;
+        synthesis::ExcitationMode excitationMode = synthesis::ExcitationMode::RandomNoisePick;
+        synthesis::ExcitationType excitationType = synthesis::ExcitationType::Pluck;
+    };
+    struct StructuralConfig {
+        double sampleRate = 44100.0;
+        std::array<PartStructure, kMaxParts> parts{};
+    };
+
+    struct BodyModeTable {
+        std::array<dsp::ModalBody::Mode, dsp::ModalBody::kMaxModes> modes{};
+        std::size_t count = 0;
+    };
+
+    // What the queue and the schedule heap carry: 24 bytes against Event's
+    // 64, so dense automation moves a fraction of the memory. Frequencies
+    // narrow to float (far below a cent); durations are not needed, as
+    // noteOn() turns them into NoteOff events of their own.
+    struct PackedEvent {
+        std::uint64_t frame = 0;
+        EventType type = EventType::NoteOn;
+        std::uint8_t part = 0;
+        std::uint8_t param = 0;   // ParamId, or NoteExpression for NoteExpression
+        std::int32_t noteId = -1;
+        float value = 0.0f;       // velocity, or the parameter value
+        float frequency = 0.0f;
+    };
+    static_assert(sizeof(PackedEvent) == 24, "keep queued events compact");
+
+    struct ScheduledEvent {
+        PackedEvent event;
+        std::uint64_t order = 0;  // Arrival order, breaks timestamp ties.
+    };
+
+    static bool ScheduledAfter(const ScheduledEvent& a, const ScheduledEvent& b);
+
+    // A block's live input, interleaved or planar.
+    struct LiveInput {
+        const float* interleaved = nullptr;
+        const float* const* planar = nullptr;
+        std::size_t channels = 0;
+    };
+
+    // Renders `frames`, handing each segment to sink(offset, dry, left, right,
+    // count) to lay out into the caller's buffer; `stems` may be null.
+    template <typename Sink>
+    void renderFrames(std::size_t frames, const StemOutputs* stems, const LiveInput& input,
+                      Sink&& sink);
+    // The mid of frames [offset, offset + count) of `input` into liveInput_;
+    // null without input.
+    const float* mixLiveInput(const LiveInput& input, std::size_t offset, std::size_t count);
+    void renderInterleaved(const ProcessBlock& block, const StemOutputs* stems);
+    void renderPlanar(const PlanarProcessBlock& block, const StemOutputs* stems);
+    void writeStems(const StemOutputs& stems, std::size_t offset, const float* dryLeft,
+                    const float* dryRight, std::size_t frames);
+    void syncControlState();
+    bool nextEventFrame(std::uint64_t& frame) const;
+    void dispatchEventsUpTo(std::uint64_t frame);
+    void handleEvent(const PackedEvent& event);
+    // enqueueEventAt()'s checks and parameter publishing; false if refused.
+    bool packEvent(const Event& event, std::uint64_t frameOffset, PackedEvent& packed);
+    // Voices, live input, gain, sympathetic strings and body of one part into
+    // its mix buffers; returns the right channel, or null while the part is
+    // mono. `input` is the segment's mono live input, or null. Non-null
+    // `strings` pairs get the voices before the body added in.
+    float* renderPart(Part& part, std::size_t frames, StageLap& lap, const float* input,
+                      float* stringsLeft = nullptr, float* stringsRight = nullptr);
+    // Continuous parameters glide to the new value unless `immediate`.
+    void applyParam(Part& part, ParamId id, float value, bool immediate);
+    // Audio thread: takes a prepared preset once the last one has faded in
+    // and been handed back.
+    void commitPreset(Part& part);
+    // Audio thread: hands the part's voices newly frozen notes once nothing
+    // plays the set before the last.
+    void commitFrozenNotes(Part& part);
+    void startFreezeLocked(std::size_t part, synthesis::StringConfig config);
+    // The part's sympathetic strings and body, run old and new side by side
+    // and mixed over the crossfade; `excite` drives both sets of strings.
+    void renderPresetFade(Part& part, float* left, float* right, std::size_t frames,
+                          const float* excite);
+    // Points the part's new notes at its body response when the body is
+    // commuted.
+    void updateBodyResponse(Part& part);
+    // Where a parameter's value lives: the shared room's in part 0.
+    std::atomic<float>* paramSlot(std::size_t part, ParamId id) const;
+    void publishStructuralLocked();
+    // Audio thread: the voice count and next event frame status() reports.
+    void publishStatus();
     static constexpr double kDefaultAttackSeconds = 0.004;
+    static constexpr std::size_t kMaxScheduledEvents = 16384;
+    static constexpr std::size_t kParamCount =
+        static_cast<std::size_t>(ParamId::InputGain) + 1;
+
+    // Control side: structural config guarded by mutex_ (which only ever
+    // serialises control threads) and handed to process() through
+    // structural_; parameter values are published in each part's atomics.
+    StructuralConfig structure_;  // what structural_ was last given
+    std::size_t maxVoices_ = kDefaultMaxVoices;
+    TripleBuffer<StructuralConfig> structural_;
+    // structure_ for lock-free readers: the rate, and each part's packed
+    // seed and excitation settings (see PackStructure()).
+    std::atomic<double> sampleRateMirror_{44100.0};
+    std::array<std::atomic<std::uint64_t>, kMaxParts> structureMirror_{};
+    TripleBuffer<BodyModeTable> bodyModes_;  // written under mutex_
+    BodyModeTable bodyModeTable_;            // what bodyModes_ was last given
+    TripleBuffer<ModulationSettings> modulation_;  // written under mutex_
+    std::atomic<bool> paramResyncPending_{false};
+    std::atomic<std::size_t> queuedEventCount_{0};
+    std::atomic<std::size_t> voiceLimit_{0};  // 0: maxVoices_
+    std::atomic<float> voiceBudget_{0.0f};    // 0: no budget
+    std::atomic<double> oversamplingThreshold_{kDefaultOversamplingThresholdHz};
+    std::unique_ptr<synthesis::ExcitationPool> excitationPoolStorage_;  // under mutex_
+    std::atomic<synthesis::ExcitationPool*> excitationPool_{nullptr};  // null when off
+    std::unique_ptr<EventQueue> eventQueue_;
 
-    synthesis::StringConfig config_;
-    float masterGain_ = 1.0f;
-    double ampReleaseSeconds_ = 0.35;
-    std::vector<Event> eventQueue_;
-    std::unique_ptr<VoiceManager> voiceManager_;
-    std::unique_ptr<BodyFilter> bodyFilter_;
+    // Audio side: owned by process(). Part 0's mix buffers double as the
+    // bus the other parts are added to.
+    std::unique_ptr<VoiceRenderPool> renderPool_;  // shared by the parts
+    std::vector<std::unique_ptr<Part>> parts_;
+    // Control side, under mutex_; after parts_ so the renders stop first.
+    std::array<std::unique_ptr<FreezeRender>, kMaxParts> freezeRenders_;
+    std::array<std::atomic<FreezeStatus>, kMaxParts> freezeStatus_{};
+    std::vector<ScheduledEvent> scheduledEvents_;  // Min-heap on frameOffset.
+    std::uint64_t scheduleCounter_ = 0;
+    std::vector<float> roomSend_;
+    std::vector<float> liveInput_;  // a segment's mono live input
+    // Stem scratch: the strings before the body and the room's split.
+    std::vector<float> stemStringsLeft_;
+    std::vector<float> stemStringsRight_;
+    std::vector<float> roomDryGain_;
+    std::vector<float> roomWetLeft_;
+    std::vector<float> roomWetRight_;
+    std::vector<float> roomLeft_;
+    std::vector<float> roomRight_;
     std::unique_ptr<RoomProcessor> roomProcessor_;
     std::atomic<std::uint64_t> frameCursor_{0};
-    int nextNoteId_ = 1;
+    std::atomic<std::size_t> activeVoices_{0};
+    std::atomic<std::uint64_t> nextEventFrame_{0};
+    std::atomic<bool> hasScheduledEvent_{false};
+    StageProfiler profiler_;
+    std::atomic<int> nextNoteId_{1};
     mutable std::mutex mutex_;
 };
 
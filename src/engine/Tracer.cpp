@@ -0,0 +1,227 @@
+#include "engine/Tracer.h"
+
+#include <fstream>
+#include <ostream>
+
+#if SATORI_TRACING_ENABLED
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#endif
+
+namespace engine {
+
+#if SATORI_TRACING_ENABLED
+
+namespace {
+
+static_assert((kTraceEventsPerThread & (kTraceEventsPerThread - 1)) == 0,
+              "ring indices wrap with a mask");
+
+// Fields are atomics so a concurrent export reads torn events only as
+// events it then discards (see CollectThread).
+struct TraceSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<std::uint64_t> beginNs{0};
+    std::atomic<std::uint64_t> endNs{0};
+};
+
+enum TraceState : std::uint8_t { kUnused, kExited, kActive };
+
+struct ThreadTrace {
+    std::atomic<std::uint8_t> state{kUnused};
+    std::atomic<std::uint64_t> head{0};  // events ever written, never rewound
+    std::atomic<std::uint64_t> claimedNs{0};  // earlier events are a previous thread's
+    std::atomic<const char*> threadName{nullptr};
+    std::array<TraceSlot, kTraceEventsPerThread> slots;
+};
+
+std::array<ThreadTrace, kMaxTraceThreads> gThreads;
+std::atomic<std::uint64_t> gClearedNs{0};
+
+// Claims a ring on the thread's first event and hands it back when the
+// thread exits. Rings of exited threads keep their zones for export until
+// every unused ring has been taken; threads beyond kMaxTraceThreads live
+// ones are not traced.
+class ThreadRing {
+public:
+    ThreadTrace* get() {
+        if (!claimed_) {
+            claimed_ = true;
+            trace_ = claim(kUnused);
+            if (!trace_) {
+                trace_ = claim(kExited);
+            }
+        }
+        return trace_;
+    }
+
+    ~ThreadRing() {
+        if (trace_) {
+            trace_->state.store(kExited, std::memory_order_release);
+        }
+    }
+
+private:
+    static ThreadTrace* claim(std::uint8_t from) {
+        for (ThreadTrace& trace : gThreads) {
+            std::uint8_t expected = from;
+            if (trace.state.compare_exchange_strong(expected, kActive,
+                                                    std::memory_order_acq_rel)) {
+                trace.threadName.store(nullptr, std::memory_order_relaxed);
+                trace.claimedNs.store(TraceNowNs(), std::memory_order_release);
+                return &trace;
+            }
+        }
+        return nullptr;
+    }
+
+    ThreadTrace* trace_ = nullptr;
+    bool claimed_ = false;
+};
+
+thread_local ThreadRing tRing;
+
+ThreadTrace* CurrentThread() { return tRing.get(); }
+
+struct CollectedZone {
+    const char* name;
+    std::uint64_t beginNs;
+    std::uint64_t endNs;
+    std::size_t thread;
+};
+
+// Copies the thread's retained zones, dropping any the writer may have
+// overwritten while they were being read.
+void CollectThread(std::size_t index, std::uint64_t clearedNs, std::vector<CollectedZone>& out) {
+    const ThreadTrace& trace = gThreads[index];
+    const std::uint64_t sinceNs =
+        std::max(clearedNs, trace.claimedNs.load(std::memory_order_acquire));
+    const std::uint64_t head = trace.head.load(std::memory_order_acquire);
+    const std::uint64_t first = head > kTraceEventsPerThread ? head - kTraceEventsPerThread : 0;
+    const std::size_t start = out.size();
+    for (std::uint64_t i = first; i < head; ++i) {
+        const TraceSlot& slot = trace.slots[i & (kTraceEventsPerThread - 1)];
+        out.push_back({slot.name.load(std::memory_order_relaxed),
+                       slot.beginNs.load(std::memory_order_relaxed),
+                       slot.endNs.load(std::memory_order_relaxed), index});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t after = trace.head.load(std::memory_order_relaxed);
+    const std::uint64_t valid = after > kTraceEventsPerThread ? after - kTraceEventsPerThread : 0;
+    const auto overwritten = static_cast<std::size_t>(std::min(head, std::max(first, valid)) - first);
+    out.erase(out.begin() + static_cast<std::ptrdiff_t>(start),
+              out.begin() + static_cast<std::ptrdiff_t>(start + overwritten));
+    out.erase(std::remove_if(out.begin() + static_cast<std::ptrdiff_t>(start), out.end(),
+                             [&](const CollectedZone& zone) {
+                                 return !zone.name || zone.beginNs < sinceNs;
+                             }),
+              out.end());
+}
+
+void WriteJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        const auto ch = static_cast<unsigned char>(*c);
+        if (ch == '"' || ch == '\\') {
+            out << '\\' << *c;
+        } else if (ch < 0x20) {
+            out << ' ';
+        } else {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+}  // namespace
+
+void SetTraceThreadName(const char* name) {
+    if (ThreadTrace* trace = CurrentThread()) {
+        trace->threadName.store(name, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t TraceNowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+}
+
+void RecordTraceZone(const char* name, std::uint64_t beginNs, std::uint64_t endNs) {
+    ThreadTrace* trace = CurrentThread();
+    if (!trace) {
+        return;
+    }
+    const std::uint64_t head = trace->head.load(std::memory_order_relaxed);
+    TraceSlot& slot = trace->slots[head & (kTraceEventsPerThread - 1)];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.beginNs.store(beginNs, std::memory_order_relaxed);
+    slot.endNs.store(endNs, std::memory_order_relaxed);
+    trace->head.store(head + 1, std::memory_order_release);
+}
+
+bool WriteChromeTrace(std::ostream& out) {
+    const std::uint64_t clearedNs = gClearedNs.load(std::memory_order_relaxed);
+    std::vector<CollectedZone> zones;
+    for (std::size_t t = 0; t < kMaxTraceThreads; ++t) {
+        CollectThread(t, clearedNs, zones);
+    }
+    std::sort(zones.begin(), zones.end(), [](const CollectedZone& a, const CollectedZone& b) {
+        return a.beginNs < b.beginNs;
+    });
+    const std::uint64_t originNs = zones.empty() ? 0 : zones.front().beginNs;
+
+    // Timestamps are microseconds from the first zone, as the format expects.
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (std::size_t t = 0; t < kMaxTraceThreads; ++t) {
+        const char* name = gThreads[t].threadName.load(std::memory_order_relaxed);
+        if (!name || gThreads[t].state.load(std::memory_order_acquire) == kUnused) {
+            continue;
+        }
+        out << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+            << t << ",\"args\":{\"name\":";
+        WriteJsonString(out, name);
+        out << "}}";
+        first = false;
+    }
+    const auto flags = out.flags();
+    out.setf(std::ios::fixed);
+    const auto precision = out.precision(3);
+    for (const CollectedZone& zone : zones) {
+        const std::uint64_t endNs = std::max(zone.endNs, zone.beginNs);
+        out << (first ? "" : ",") << "\n{\"ph\":\"X\",\"name\":";
+        WriteJsonString(out, zone.name);
+        out << ",\"pid\":1,\"tid\":" << zone.thread
+            << ",\"ts\":" << static_cast<double>(zone.beginNs - originNs) / 1000.0
+            << ",\"dur\":" << static_cast<double>(endNs - zone.beginNs) / 1000.0 << "}";
+        first = false;
+    }
+    out.precision(precision);
+    out.flags(flags);
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+void ClearTrace() { gClearedNs.store(TraceNowNs(), std::memory_order_relaxed); }
+
+#else
+
+bool WriteChromeTrace(std::ostream&) { return false; }
+
+void ClearTrace() {}
+
+#endif  // SATORI_TRACING_ENABLED
+
+bool WriteChromeTrace(const std::filesystem::path& path) {
+    if (!SATORI_TRACING_ENABLED) {
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    return out && WriteChromeTrace(out) && out.flush();
+}
+
+}  // namespace engine
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+
+#if defined(SATORI_ENABLE_TRACING)
+#define SATORI_TRACING_ENABLED 1
+#else
+#define SATORI_TRACING_ENABLED 0
+#endif
+
+namespace engine {
+
+// Timeline tracing of the audio callback, the render and room workers and
+// the UI, exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+// so callback overruns, late room blocks and UI stalls line up on one time
+// axis. Each thread appends complete zones to its own fixed ring of
+// kTraceEventsPerThread events, claimed from a static pool of
+// kMaxTraceThreads on first use and returned at thread exit: recording never
+// allocates, locks or waits, and the oldest events are overwritten.
+// Everything compiles to nothing unless built with SATORI_ENABLE_TRACING.
+inline constexpr std::size_t kMaxTraceThreads = 32;
+inline constexpr std::size_t kTraceEventsPerThread = 8192;
+
+#if SATORI_TRACING_ENABLED
+// Labels the calling thread in the trace; `name` must be a string literal
+// (or otherwise outlive the process).
+void SetTraceThreadName(const char* name);
+
+// Steady-clock nanoseconds, the trace's time base.
+std::uint64_t TraceNowNs();
+// Appends a zone to the calling thread's ring.
+void RecordTraceZone(const char* name, std::uint64_t beginNs, std::uint64_t endNs);
+
+// Records the time from construction to destruction under `name` (a string
+// literal).
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : name_(name), beginNs_(TraceNowNs()) {}
+    ~TraceZone() { RecordTraceZone(name_, beginNs_, TraceNowNs()); }
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+private:
+    const char* name_;
+    std::uint64_t beginNs_;
+};
+#else
+inline void SetTraceThreadName(const char*) {}
+
+class TraceZone {
+public:
+    explicit TraceZone(const char*) {}
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+};
+#endif  // SATORI_TRACING_ENABLED
+
+// Any thread, while recording continues: every thread's retained zones as
+// Chrome trace JSON, oldest first. False (writing nothing) when tracing is
+// compiled out or the file cannot be written.
+bool WriteChromeTrace(std::ostream& out);
+bool WriteChromeTrace(const std::filesystem::path& path);
+// Drops the zones recorded so far from later exports.
+void ClearTrace();
+
+}  // namespace engine
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace engine {
+
+// Lock-free snapshot handoff between one writer and one reader. The writer
+// fills a private slot and swaps it into the shared slot; the reader swaps
+// the shared slot out only when something new was published. Neither side
+// blocks, allocates or sees a half-written value.
+template <typename T>
+class TripleBuffer {
+public:
+    explicit TripleBuffer(const T& initial = T{}) { slots_.fill(initial); }
+
+    // Writer side.
+    void write(const T& value) {
+        slots_[writeIndex_] = value;
+        const std::uint8_t prior =
+            shared_.exchange(static_cast<std::uint8_t>(writeIndex_ | kFresh),
+                             std::memory_order_acq_rel);
+        writeIndex_ = prior & kIndexMask;
+    }
+
+    // Reader side: adopts the newest published value; false if none arrived
+    // since the last call.
+    bool update() {
+        if ((shared_.load(std::memory_order_relaxed) & kFresh) == 0) {
+            return false;
+        }
+        const std::uint8_t prior = shared_.exchange(readIndex_, std::memory_order_acq_rel);
+        readIndex_ = prior & kIndexMask;
+        return true;
+    }
+    const T& read() const { return slots_[readIndex_]; }
+
+private:
+    static constexpr std::uint8_t kIndexMask = 0x3;
+    static constexpr std::uint8_t kFresh = 0x4;
+
+    std::array<T, 3> slots_{};
+    std::atomic<std::uint8_t> shared_{1};
+    std::uint8_t writeIndex_ = 0;
+    std::uint8_t readIndex_ = 2;
+};
+
+}  // namespace engine
@@ -0,0 +1,149 @@
+#include "engine/VoiceRenderPool.h"
+
+#include <algorithm>
+
+#include "engine/RealtimeThread.h"
+#include "engine/Tracer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
+namespace engine {
+
+namespace {
+
+constexpr int kWorkerSpinIterations = 4000;
+constexpr int kWaitSpinIterations = 20000;
+
+inline void CpuRelax() {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(_M_ARM64)
+    __yield();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+inline std::uint32_t TicketGeneration(std::uint64_t ticket) {
+    return static_cast<std::uint32_t>(ticket >> 32);
+}
+
+inline std::size_t TicketNext(std::uint64_t ticket) {
+    return static_cast<std::size_t>((ticket >> 16) & 0xFFFFu);
+}
+
+inline std::size_t TicketJobs(std::uint64_t ticket) {
+    return static_cast<std::size_t>(ticket & 0xFFFFu);
+}
+
+}  // namespace
+
+VoiceRenderPool::VoiceRenderPool(std::size_t threads) {
+    const std::size_t count = std::min(threads, kMaxThreads);
+    threads_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        threads_.emplace_back(&VoiceRenderPool::workerLoop, this);
+    }
+}
+
+VoiceRenderPool::~VoiceRenderPool() {
+    quit_.store(true, std::memory_order_release);
+    // Bump the generation with zero jobs so parked helpers wake and exit.
+    ticket_.store(static_cast<std::uint64_t>(generation_ + 1) << 32,
+                  std::memory_order_release);
+    ticket_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+void VoiceRenderPool::run(JobFn fn, void* context, std::size_t jobs) {
+    if (!fn || jobs == 0) {
+        return;
+    }
+    jobs = std::min(jobs, kMaxJobs);
+    if (threads_.empty() || jobs == 1) {
+        for (std::size_t i = 0; i < jobs; ++i) {
+            fn(context, i);
+        }
+        return;
+    }
+
+    // fn_/context_ are only read by helpers that claimed a job of this
+    // generation, and no new run() starts until all of them finished.
+    fn_ = fn;
+    context_ = context;
+    doneJobs_.store(0, std::memory_order_relaxed);
+    ++generation_;
+    // Paired with the helpers' park: either one sees parked_ or the helper
+    // sees the new ticket before it waits.
+    ticket_.store((static_cast<std::uint64_t>(generation_) << 32) | jobs,
+                  std::memory_order_seq_cst);
+    if (parked_.load(std::memory_order_seq_cst) > 0) {
+        ticket_.notify_all();
+    }
+
+    drain(generation_);
+
+    int spins = 0;
+    while (doneJobs_.load(std::memory_order_acquire) < jobs) {
+        if (++spins < kWaitSpinIterations) {
+            CpuRelax();
+        } else {
+            std::this_thread::yield();  // Helper got descheduled; don't starve it.
+        }
+    }
+}
+
+void VoiceRenderPool::drain(std::uint32_t generation) {
+    std::uint64_t ticket = ticket_.load(std::memory_order_acquire);
+    while (TicketGeneration(ticket) == generation &&
+           TicketNext(ticket) < TicketJobs(ticket)) {
+        if (!ticket_.compare_exchange_weak(ticket, ticket + (1u << 16),
+                                           std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+            continue;
+        }
+        fn_(context_, TicketNext(ticket));
+        doneJobs_.fetch_add(1, std::memory_order_release);
+        ticket = ticket_.load(std::memory_order_acquire);
+    }
+}
+
+void VoiceRenderPool::workerLoop() {
+    const ScopedDspThread dspThread("voice render");
+    std::uint32_t seen = 0;
+    while (!quit_.load(std::memory_order_acquire)) {
+        std::uint64_t ticket = ticket_.load(std::memory_order_acquire);
+        int spins = 0;
+        while (TicketGeneration(ticket) == seen && spins < kWorkerSpinIterations) {
+            CpuRelax();
+            ++spins;
+            ticket = ticket_.load(std::memory_order_acquire);
+        }
+        if (TicketGeneration(ticket) == seen) {
+            parked_.fetch_add(1, std::memory_order_seq_cst);
+            if (ticket_.load(std::memory_order_seq_cst) == ticket) {
+                ticket_.wait(ticket, std::memory_order_acquire);
+            }
+            parked_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (quit_.load(std::memory_order_acquire)) {
+            break;
+        }
+        seen = TicketGeneration(ticket);
+        const TraceZone zone("render voices");
+        drain(seen);
+    }
+}
+
+}  // namespace engine
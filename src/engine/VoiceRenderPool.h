@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+// Small fork/join pool for splitting voice rendering across cores. The audio
+// thread publishes a job count, works on jobs itself and then spins until the
+// helpers finish; it never blocks on a lock or condition variable. Helpers spin
+// briefly after each batch and then park on an atomic wait.
+class VoiceRenderPool {
+public:
+    using JobFn = void (*)(void* context, std::size_t job);
+
+    static constexpr std::size_t kMaxThreads = 16;
+    static constexpr std::size_t kMaxJobs = 0xFFFF;
+
+    explicit VoiceRenderPool(std::size_t threads);
+    ~VoiceRenderPool();
+    VoiceRenderPool(const VoiceRenderPool&) = delete;
+    VoiceRenderPool& operator=(const VoiceRenderPool&) = delete;
+
+    std::size_t threadCount() const { return threads_.size(); }
+
+    // Runs fn(context, 0..jobs-1) across the helpers and the calling thread and
+    // returns once every job has finished. Job order is unspecified.
+    void run(JobFn fn, void* context, std::size_t jobs);
+
+private:
+    void workerLoop();
+    // Claims and runs jobs of `generation` until none are left.
+    void drain(std::uint32_t generation);
+
+    std::vector<std::thread> threads_;
+    // generation (32 bits) | next job (16 bits) | job count (16 bits)
+    std::atomic<std::uint64_t> ticket_{0};
+    // Helpers parked on ticket_; run() only issues the futex wake when some are.
+    std::atomic<std::size_t> parked_{0};
+    std::atomic<std::size_t> doneJobs_{0};
+    std::atomic<bool> quit_{false};
+    std::uint32_t generation_ = 0;
+    JobFn fn_ = nullptr;
+    void* context_ = nullptr;
+};
+
+}  // namespace engine
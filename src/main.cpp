@@ -1,15 +1,28 @@
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cmath>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "audio/WaveWriter.h"
+#include "engine/MidiFilePlayer.h"
+#include "engine/MidiNote.h"
+#include "engine/PresetBank.h"
+#include "engine/RealtimeThread.h"
+#include "engine/RoomPartitionTuner.h"
 #include "engine/StringSynthEngine.h"
 #include "synthesis/KarplusStrongSynth.h"
 
@@ -18,6 +31,7 @@ namespace {
 struct AppConfig {
     double frequency = 440.0;
     std::vector<synthesis::NoteEvent> notes;
+    std::filesystem::path midiFile;  // --midi: plays the file instead of the notes
     double duration = 2.0;
     double sampleRate = 44100.0;
     float decay = 0.996f;
@@ -30,6 +44,8 @@ struct AppConfig {
     float bodyTone = 0.5f;
     float bodySize = 0.5f;
     float roomAmount = 0.0f;
+    float sympatheticAmount = 0.0f;
+    float courseDetune = 0.0f;
     bool enableLowpass = true;
     synthesis::NoiseType noiseType = synthesis::NoiseType::White;
     synthesis::ExcitationMode excitationMode =
@@ -37,16 +53,48 @@ struct AppConfig {
     synthesis::ExcitationType excitationType = synthesis::ExcitationType::Pluck;
     unsigned int seed = 0;
     float ampRelease = 0.35f;
+    std::size_t maxVoices = engine::StringSynthEngine::kDefaultMaxVoices;
+    bool normalize = true;
+    // --trim dB (default -90): the render ends once it is past its last
+    // note and silent below this level; 0 (--trim off) keeps the full tail.
+    float silenceLevel = 3.1623e-5f;
+    bool offline = true;  // room tail rendered inline rather than on the worker
+    // --partitions tuned: offline renders time the room's partition layouts
+    // for throughput (cached per machine). Off by default, so the same
+    // command renders the same samples on every machine.
+    bool tunePartitions = false;
+    audio::SampleFormat sampleFormat = audio::SampleFormat::Int16;
+    // Batch mode (enabled by --batchKeys): one file per preset x key x velocity.
+    std::vector<int> batchKeys;
+    std::vector<float> batchVelocities{1.0f};
+    std::filesystem::path batchPresets;
+    std::filesystem::path batchDir = "satori_batch";
+    std::size_t batchJobs = 0;  // 0: one per core
+    std::size_t renderThreads = 0;
     std::filesystem::path output = "satori_demo.wav";
+    std::filesystem::path stemsDir;  // --stems: stereo stem files beside the mix
+    // Preset banks: --makeBank converts JSON presets, --listBank browses one.
+    std::filesystem::path makeBank;
+    std::filesystem::path bankOutput = "presets.satbank";
+    std::filesystem::path listBank;
 };
 
 void printUsage() {
-    std::cout << "用法: Satori [--freq 440] [--notes 440[:start[:dur]],660] [--duration 2.0] "
+    std::cout << "用法: Satori [--freq 440] [--notes 440[:start[:dur]],660] [--midi song.mid] "
+                 "[--duration 2.0] "
                  "[--samplerate 44100] [--decay 0.996] [--brightness 0.5] "
                  "[--dispersion 0.12] [--exciteColor 0.6] [--exciteVel 0.5] [--mix 1.0] [--pickpos 0.5] "
-                 "[--bodyTone 0.5] [--bodySize 0.5] [--room 0.0] [--noise white|binary] "
-                 "[--excitation random|fixed] [--exciteType pluck|hammer] [--filter lowpass|none] "
-                 "[--release 0.35] [--seed 1234] [--output out.wav]\n";
+                 "[--bodyTone 0.5] [--bodySize 0.5] [--room 0.0] [--sympathetic 0.0] [--course 0] "
+                 "[--noise white|binary] [--excitation random|fixed] [--exciteType pluck|hammer] [--filter lowpass|none] "
+                 "[--release 0.35] [--voices 16] [--threads 0] [--seed 1234] [--normalize on|off] "
+                 "[--trim -90|off] [--offline on|off] [--partitions default|tuned] "
+                 "[--format int16|int24|float32] [--output out.wav] "
+                 "[--stems stems/]\n"
+                 "批量: [--batchKeys 21-108|60,64,67] [--batchVelocities 8|0.3,0.6,1.0] "
+                 "[--batchPresets presets.txt] [--batchDir out/] [--jobs 0]\n"
+                 "  presets.txt 每行一个预设: 名称 --参数 值 ...（覆盖命令行参数）\n"
+                 "预设库: [--makeBank presets/|a.json] [--bankOutput presets.satbank] "
+                 "[--listBank presets.satbank]\n";
 }
 
 bool parseDouble(const std::string& value, double& dest) {
@@ -145,6 +193,66 @@ void parseExcitationType(const std::string& value,
     }
 }
 
+void parseSampleFormat(const std::string& value, audio::SampleFormat& dest) {
+    const auto lower = toLower(value);
+    if (lower == "int24") {
+        dest = audio::SampleFormat::Int24;
+    } else if (lower == "float32") {
+        dest = audio::SampleFormat::Float32;
+    } else {
+        dest = audio::SampleFormat::Int16;
+    }
+}
+
+// "21-108" or "60,64,67"; MIDI keys outside 0..127 are dropped.
+std::vector<int> parseKeyList(const std::string& value) {
+    std::vector<int> keys;
+    std::stringstream ss(value);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        const auto dash = token.find('-', 1);
+        double lo = 0.0;
+        double hi = 0.0;
+        if (!parseDouble(token.substr(0, dash), lo)) {
+            continue;
+        }
+        hi = lo;
+        if (dash != std::string::npos && !parseDouble(token.substr(dash + 1), hi)) {
+            continue;
+        }
+        for (int key = static_cast<int>(lo); key <= static_cast<int>(hi); ++key) {
+            if (key >= 0 && key <= 127) {
+                keys.push_back(key);
+            }
+        }
+    }
+    return keys;
+}
+
+// A layer count ("8": 1/8 .. 8/8) or an explicit list ("0.3,0.6,1.0").
+std::vector<float> parseVelocityList(const std::string& value) {
+    std::vector<float> velocities;
+    if (value.find_first_of(".,") == std::string::npos) {
+        double layers = 0.0;
+        if (parseDouble(value, layers) && layers >= 1.0) {
+            const int count = static_cast<int>(layers);
+            for (int i = 1; i <= count; ++i) {
+                velocities.push_back(static_cast<float>(i) / static_cast<float>(count));
+            }
+        }
+        return velocities;
+    }
+    std::stringstream ss(value);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        float velocity = 0.0f;
+        if (parseFloat(token, velocity) && velocity > 0.0f) {
+            velocities.push_back(std::min(velocity, 1.0f));
+        }
+    }
+    return velocities;
+}
+
 float defaultAmpRelease() {
     if (const auto* info = engine::GetParamInfo(engine::ParamId::AmpRelease)) {
         return info->defaultValue;
@@ -166,7 +274,7 @@ float defaultValue(engine::ParamId id, float fallback) {
     return fallback;
 }
 
-AppConfig parseArgs(int argc, char** argv, bool& showHelp) {
+AppConfig parseArgs(const std::vector<std::string>& args, bool& showHelp) {
     AppConfig config;
     config.ampRelease = defaultAmpRelease();
     config.dispersionAmount = defaultDispersionAmount();
@@ -176,17 +284,20 @@ AppConfig parseArgs(int argc, char** argv, bool& showHelp) {
     config.bodyTone = defaultValue(engine::ParamId::BodyTone, 0.5f);
     config.bodySize = defaultValue(engine::ParamId::BodySize, 0.5f);
     config.roomAmount = defaultValue(engine::ParamId::RoomAmount, 0.0f);
+    config.sympatheticAmount = defaultValue(engine::ParamId::SympatheticAmount, 0.0f);
+    config.courseDetune = defaultValue(engine::ParamId::CourseDetune, 0.0f);
     showHelp = false;
 
+    // Later occurrences win, so preset lines can override the command line.
     std::unordered_map<std::string, std::string> kv;
-    for (int i = 1; i < argc; ++i) {
-        std::string arg = argv[i];
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
         if (arg == "--help" || arg == "-h") {
             showHelp = true;
             return config;
         }
-        if (arg.rfind("--", 0) == 0 && i + 1 < argc) {
-            kv[arg.substr(2)] = argv[++i];
+        if (arg.rfind("--", 0) == 0 && i + 1 < args.size()) {
+            kv[arg.substr(2)] = args[++i];
         }
     }
 
@@ -202,6 +313,9 @@ AppConfig parseArgs(int argc, char** argv, bool& showHelp) {
     if (auto it = kv.find("notes"); it != kv.end()) {
         config.notes = parseNoteList(it->second, config.duration);
     }
+    if (auto it = kv.find("midi"); it != kv.end()) {
+        config.midiFile = it->second;
+    }
     if (auto it = kv.find("decay"); it != kv.end()) {
         parseFloat(it->second, config.decay);
     }
@@ -235,6 +349,12 @@ AppConfig parseArgs(int argc, char** argv, bool& showHelp) {
     if (auto it = kv.find("room"); it != kv.end()) {
         parseFloat(it->second, config.roomAmount);
     }
+    if (auto it = kv.find("sympathetic"); it != kv.end()) {
+        parseFloat(it->second, config.sympatheticAmount);
+    }
+    if (auto it = kv.find("course"); it != kv.end()) {
+        parseFloat(it->second, config.courseDetune);
+    }
     if (auto it = kv.find("noise"); it != kv.end()) {
         parseNoise(it->second, config.noiseType);
     }
@@ -250,156 +370,690 @@ AppConfig parseArgs(int argc, char** argv, bool& showHelp) {
     if (auto it = kv.find("release"); it != kv.end()) {
         parseFloat(it->second, config.ampRelease);
     }
+    if (auto it = kv.find("voices"); it != kv.end()) {
+        double tmp = 0.0;
+        if (parseDouble(it->second, tmp) && tmp >= 1.0) {
+            config.maxVoices = static_cast<std::size_t>(tmp);
+        }
+    }
+    if (auto it = kv.find("threads"); it != kv.end()) {
+        double tmp = 0.0;
+        if (parseDouble(it->second, tmp) && tmp >= 0.0) {
+            config.renderThreads = static_cast<std::size_t>(tmp);
+        }
+    }
     if (auto it = kv.find("seed"); it != kv.end()) {
         double tmp = 0.0;
         if (parseDouble(it->second, tmp)) {
             config.seed = static_cast<unsigned int>(tmp);
         }
     }
+    if (auto it = kv.find("normalize"); it != kv.end()) {
+        config.normalize = toLower(it->second) != "off";
+    }
+    if (auto it = kv.find("trim"); it != kv.end()) {
+        double db = 0.0;
+        if (toLower(it->second) == "off") {
+            config.silenceLevel = 0.0f;
+        } else if (parseDouble(it->second, db) && db < 0.0) {
+            config.silenceLevel = static_cast<float>(std::pow(10.0, db / 20.0));
+        }
+    }
+    if (auto it = kv.find("offline"); it != kv.end()) {
+        config.offline = toLower(it->second) != "off";
+    }
+    if (auto it = kv.find("partitions"); it != kv.end()) {
+        config.tunePartitions = toLower(it->second) == "tuned";
+    }
+    if (auto it = kv.find("format"); it != kv.end()) {
+        parseSampleFormat(it->second, config.sampleFormat);
+    }
     if (auto it = kv.find("output"); it != kv.end()) {
         config.output = it->second;
     }
+    if (auto it = kv.find("stems"); it != kv.end()) {
+        config.stemsDir = it->second;
+    }
+    if (auto it = kv.find("batchKeys"); it != kv.end()) {
+        config.batchKeys = parseKeyList(it->second);
+    }
+    if (auto it = kv.find("batchVelocities"); it != kv.end()) {
+        config.batchVelocities = parseVelocityList(it->second);
+    }
+    if (auto it = kv.find("batchPresets"); it != kv.end()) {
+        config.batchPresets = it->second;
+    }
+    if (auto it = kv.find("batchDir"); it != kv.end()) {
+        config.batchDir = it->second;
+    }
+    if (auto it = kv.find("jobs"); it != kv.end()) {
+        double tmp = 0.0;
+        if (parseDouble(it->second, tmp) && tmp >= 0.0) {
+            config.batchJobs = static_cast<std::size_t>(tmp);
+        }
+    }
+    if (auto it = kv.find("makeBank"); it != kv.end()) {
+        config.makeBank = it->second;
+    }
+    if (auto it = kv.find("bankOutput"); it != kv.end()) {
+        config.bankOutput = it->second;
+    }
+    if (auto it = kv.find("listBank"); it != kv.end()) {
+        config.listBank = it->second;
+    }
 
     return config;
 }
 
-float findPeak(const std::vector<float>& buffer) {
-    float peak = 0.0f;
-    for (float sample : buffer) {
-        peak = std::max(peak, std::abs(sample));
+constexpr std::size_t kBlockFrames = 512;
+
+// Stereo stems streamed next to the mix, rendered in the same pass:
+// strings.wav, body.wav and room.wav, plus partN.wav for a layered engine.
+// They add up to the stereo mix; the mono mix file is its mid.
+class StemTake {
+public:
+    bool open(const std::filesystem::path& dir, const AppConfig& appConfig, std::size_t parts,
+              float gain, std::string& errorMessage) {
+        std::error_code dirError;
+        std::filesystem::create_directories(dir, dirError);
+        if (dirError) {
+            errorMessage = "无法创建分轨目录: " + dir.string();
+            return false;
+        }
+        audio::WaveFormat format;
+        format.sampleRate = static_cast<uint32_t>(appConfig.sampleRate);
+        format.sampleFormat = appConfig.sampleFormat;
+        format.channels = 2;
+        std::vector<std::string> names{"strings", "body", "room"};
+        for (std::size_t p = 0; parts > 1 && p < parts; ++p) {
+            names.push_back("part" + std::to_string(p + 1));
+        }
+        for (const auto& name : names) {
+            auto track = std::make_unique<Track>();
+            track->left.assign(kBlockFrames, 0.0f);
+            track->right.assign(kBlockFrames, 0.0f);
+            if (!track->writer.open(dir / (name + ".wav"), format, errorMessage)) {
+                return false;
+            }
+            tracks_.push_back(std::move(track));
+        }
+        const auto pair = [&](std::size_t t) {
+            return engine::StemOutputs::Pair{tracks_[t]->left.data(), tracks_[t]->right.data()};
+        };
+        outputs_.strings = pair(0);
+        outputs_.body = pair(1);
+        outputs_.room = pair(2);
+        for (std::size_t t = 3; t < tracks_.size(); ++t) {
+            outputs_.parts[t - 3] = pair(t);
+        }
+        interleaved_.assign(kBlockFrames * 2, 0.0f);
+        gain_ = gain;
+        return true;
     }
-    return peak;
-}
 
-void normalize(std::vector<float>& buffer, float peak) {
-    if (peak <= 1.0f || peak == 0.0f) {
-        return;
+    // Buffers for one block of up to kBlockFrames frames.
+    const engine::StemOutputs& outputs() const { return outputs_; }
+
+    // Appends the block; after a failed write the rest are dropped and
+    // close() reports it.
+    void write(std::size_t frames) {
+        for (const auto& track : tracks_) {
+            if (!writeError_.empty()) {
+                return;
+            }
+            for (std::size_t i = 0; i < frames; ++i) {
+                interleaved_[i * 2] = track->left[i] * gain_;
+                interleaved_[i * 2 + 1] = track->right[i] * gain_;
+            }
+            track->writer.write(interleaved_.data(), frames * 2, writeError_);
+        }
     }
-    const float invPeak = 1.0f / peak;
-    for (auto& sample : buffer) {
-        sample *= invPeak;
+
+    bool close(std::string& errorMessage) {
+        bool ok = true;
+        for (const auto& track : tracks_) {
+            ok = track->writer.close(errorMessage) && ok;
+        }
+        if (!writeError_.empty()) {
+            errorMessage = writeError_;
+            return false;
+        }
+        return ok;
     }
-}
 
-std::vector<float> renderWithEngine(engine::StringSynthEngine& engine,
-                                    const std::vector<synthesis::NoteEvent>& notes,
-                                    double sampleRate,
-                                    double tailSeconds) {
+private:
+    struct Track {
+        audio::WaveStreamWriter writer;
+        std::vector<float> left;
+        std::vector<float> right;
+    };
+
+    std::vector<std::unique_ptr<Track>> tracks_;
+    std::vector<float> interleaved_;
+    engine::StemOutputs outputs_;
+    float gain_ = 1.0f;
+    std::string writeError_;
+};
+
+using BlockSink = std::function<void(float* samples, std::size_t frames)>;
+// Renders one take from the engine's current state into the sink, and into
+// `stems` when given.
+using Renderer = std::function<void(const BlockSink& sink, StemTake* stems)>;
+
+std::size_t renderFrameCount(const std::vector<synthesis::NoteEvent>& notes,
+                             double sampleRate,
+                             double tailSeconds) {
     if (notes.empty() || sampleRate <= 0.0) {
-        return {};
+        return 0;
     }
-
     double maxTime = 0.0;
     for (const auto& note : notes) {
         maxTime = std::max(maxTime, note.startTime + note.duration);
     }
     const double totalSeconds = maxTime + std::max(0.0, tailSeconds);
-    const std::size_t totalFrames = static_cast<std::size_t>(
-        std::max(0.0, std::ceil(totalSeconds * sampleRate)));
-    if (totalFrames == 0) {
-        return {};
-    }
+    return static_cast<std::size_t>(std::max(0.0, std::ceil(totalSeconds * sampleRate)));
+}
 
-    const uint16_t channels = 1;
-    std::vector<float> buffer(totalFrames * channels, 0.0f);
+// Applies every render setting of appConfig (voice count and render threads
+// are fixed at construction).
+void configureEngine(engine::StringSynthEngine& synthEngine, const AppConfig& appConfig) {
+    synthEngine.setRenderMode(appConfig.offline ? engine::RenderMode::Offline
+                                                 : engine::RenderMode::Realtime);
+    synthEngine.setSampleRate(appConfig.sampleRate);
+    synthEngine.setParam(engine::ParamId::Decay, appConfig.decay);
+    synthEngine.setParam(engine::ParamId::Brightness, appConfig.brightness);
+    synthEngine.setParam(engine::ParamId::DispersionAmount, appConfig.dispersionAmount);
+    synthEngine.setParam(engine::ParamId::ExcitationBrightness,
+                          appConfig.excitationBrightness);
+    synthEngine.setParam(engine::ParamId::ExcitationVelocity, appConfig.excitationVelocity);
+    synthEngine.setParam(engine::ParamId::ExcitationMix, appConfig.excitationMix);
+    synthEngine.setParam(engine::ParamId::PickPosition, appConfig.pickPosition);
+    synthEngine.setParam(engine::ParamId::BodyTone, appConfig.bodyTone);
+    synthEngine.setParam(engine::ParamId::BodySize, appConfig.bodySize);
+    synthEngine.setParam(engine::ParamId::RoomAmount, appConfig.roomAmount);
+    synthEngine.setParam(engine::ParamId::SympatheticAmount, appConfig.sympatheticAmount);
+    synthEngine.setParam(engine::ParamId::CourseDetune, appConfig.courseDetune);
+    synthEngine.setParam(engine::ParamId::EnableLowpass, appConfig.enableLowpass ? 1.0f : 0.0f);
+    synthEngine.setParam(engine::ParamId::NoiseType,
+                          appConfig.noiseType == synthesis::NoiseType::Binary ? 1.0f : 0.0f);
+    synthEngine.setParam(engine::ParamId::MasterGain, 1.0f);
+    synthEngine.setParam(engine::ParamId::AmpRelease, appConfig.ampRelease);
 
+    synthesis::StringConfig synthConfig = synthEngine.stringConfig();
+    synthConfig.seed = appConfig.seed;
+    synthConfig.excitationMode = appConfig.excitationMode;
+    synthConfig.excitationType = appConfig.excitationType;
+    synthEngine.setConfig(synthConfig);
+}
+
+std::unique_ptr<engine::StringSynthEngine> makeEngine(const AppConfig& appConfig) {
+    auto synthEngine =
+        std::make_unique<engine::StringSynthEngine>(synthesis::StringConfig{}, appConfig.maxVoices,
+                                                    appConfig.renderThreads);
+    configureEngine(*synthEngine, appConfig);
+    return synthEngine;
+}
+
+// Renders one block, and its stems when given; false when the block is
+// silent below `silenceLevel` (never with a level of 0) and the engine has no
+// voice left, in which case the caller ends the take without keeping it.
+bool processBlock(engine::StringSynthEngine& engine, const engine::ProcessBlock& block,
+                  StemTake* stems, float silenceLevel = 0.0f) {
+    if (stems) {
+        engine.process(block, stems->outputs());
+    } else {
+        engine.process(block);
+    }
+    if (silenceLevel > 0.0f && engine.activeVoiceCount() == 0) {
+        const std::size_t count = block.frames * block.channels;
+        const bool silent = std::all_of(block.output, block.output + count,
+                                        [silenceLevel](float v) {
+                                            return std::abs(v) < silenceLevel;
+                                        });
+        if (silent) {
+            return false;
+        }
+    }
+    if (stems) {
+        stems->write(block.frames);
+    }
+    return true;
+}
+
+// Renders totalFrames in fixed blocks, handing each to the sink. Notes are
+// queued just before the block they start in, so neither the output nor the
+// event queue grows with the length of the sequence. Past the last note-off
+// the render stops at the first block silent below `silenceLevel`.
+void renderWithEngine(engine::StringSynthEngine& engine,
+                      const std::vector<synthesis::NoteEvent>& notes,
+                      double sampleRate,
+                      std::size_t totalFrames,
+                      float velocity,
+                      float silenceLevel,
+                      const BlockSink& sink,
+                      StemTake* stems = nullptr) {
+    struct TimedNote {
+        std::uint64_t startFrame = 0;
+        std::uint64_t durationFrames = 0;
+        double frequency = 0.0;
+        int noteId = 0;
+    };
+    std::vector<TimedNote> timed;
+    timed.reserve(notes.size());
     int noteId = 1;
     for (const auto& note : notes) {
-        const auto startFrame = static_cast<std::uint64_t>(
+        TimedNote t;
+        t.startFrame = static_cast<std::uint64_t>(
             std::max(0.0, std::round(note.startTime * sampleRate)));
-        const auto durationFrames = static_cast<std::uint64_t>(
+        t.durationFrames = static_cast<std::uint64_t>(
             std::max(0.0, std::round(note.duration * sampleRate)));
-
-        engine::Event on{};
-        on.type = engine::EventType::NoteOn;
-        on.noteId = noteId;
-        on.frequency = note.frequency;
-        on.velocity = 1.0f;
-        engine.enqueueEventAt(on, startFrame);
-
-        engine::Event off{};
-        off.type = engine::EventType::NoteOff;
-        off.noteId = noteId;
-        engine.enqueueEventAt(off, startFrame + durationFrames);
-
-        ++noteId;
+        t.frequency = note.frequency;
+        t.noteId = noteId++;
+        timed.push_back(t);
+    }
+    std::stable_sort(timed.begin(), timed.end(), [](const TimedNote& a, const TimedNote& b) {
+        return a.startFrame < b.startFrame;
+    });
+    std::uint64_t lastOffFrame = 0;
+    for (const TimedNote& note : timed) {
+        lastOffFrame = std::max(lastOffFrame, note.startFrame + note.durationFrames);
     }
 
-    const std::size_t blockFrames = 512;
+    const uint16_t channels = 1;
+    const std::size_t blockFrames = kBlockFrames;
+    std::vector<float> buffer(blockFrames * channels, 0.0f);
+    std::vector<engine::Event> pending;
+    std::size_t next = 0;
     std::size_t cursor = 0;
     while (cursor < totalFrames) {
         const std::size_t framesThisBlock =
             std::min(blockFrames, totalFrames - cursor);
-        engine::ProcessBlock block{
-            buffer.data() + cursor * channels, framesThisBlock, channels};
-        engine.process(block);
+        const std::uint64_t blockEnd = cursor + framesThisBlock;
+        pending.clear();
+        for (; next < timed.size() && timed[next].startFrame < blockEnd; ++next) {
+            const TimedNote& note = timed[next];
+            engine::Event on{};
+            on.type = engine::EventType::NoteOn;
+            on.noteId = note.noteId;
+            on.frequency = note.frequency;
+            on.velocity = velocity;
+            on.frameOffset = note.startFrame;
+            pending.push_back(on);
+
+            engine::Event off{};
+            off.type = engine::EventType::NoteOff;
+            off.noteId = note.noteId;
+            off.frameOffset = note.startFrame + note.durationFrames;
+            pending.push_back(off);
+        }
+        engine.enqueueEvents(pending);
+
+        engine::ProcessBlock block{buffer.data(), framesThisBlock, channels};
+        if (!processBlock(engine, block, stems, cursor >= lastOffFrame ? silenceLevel : 0.0f)) {
+            break;
+        }
+        sink(buffer.data(), framesThisBlock * channels);
         cursor += framesThisBlock;
     }
+}
+
+double tailSecondsFor(const engine::StringSynthEngine& engine) {
+    return std::max(0.5, static_cast<double>(engine.getParam(engine::ParamId::AmpRelease)) * 4.0);
+}
+
+// Plays the file from the start, queueing its events a lookahead window
+// ahead of each block, and stops `tailSeconds` after the last one, or at the
+// first block after it silent below `silenceLevel`.
+void renderMidiWithEngine(engine::StringSynthEngine& engine,
+                          engine::MidiFilePlayer& player,
+                          double sampleRate,
+                          double tailSeconds,
+                          float silenceLevel,
+                          const BlockSink& sink,
+                          StemTake* stems = nullptr) {
+    const uint16_t channels = 1;
+    std::vector<float> buffer(kBlockFrames * channels, 0.0f);
+    const auto lookaheadFrames = static_cast<std::uint64_t>(
+        std::ceil(engine::MidiFilePlayer::kDefaultLookaheadSeconds * sampleRate));
+    const auto tailFrames =
+        static_cast<std::uint64_t>(std::ceil(std::max(0.0, tailSeconds) * sampleRate));
+    const std::uint64_t origin = engine.renderedFrames();
+    player.start(origin, sampleRate);
+    for (std::uint64_t cursor = origin;; cursor += kBlockFrames) {
+        player.schedule(engine, cursor + kBlockFrames + lookaheadFrames);
+        if (player.finished() && cursor >= player.lastEventFrame() + tailFrames) {
+            break;
+        }
+        const bool ended = player.finished() && cursor >= player.lastEventFrame();
+        engine::ProcessBlock block{buffer.data(), kBlockFrames, channels};
+        if (!processBlock(engine, block, stems, ended ? silenceLevel : 0.0f)) {
+            break;
+        }
+        sink(buffer.data(), kBlockFrames * channels);
+    }
+}
+
+// Streams one take of `render` to `path`, and its stems when given.
+bool writeRender(const Renderer& render,
+                 const AppConfig& appConfig,
+                 float gain,
+                 const std::filesystem::path& path,
+                 std::string& errorMessage,
+                 StemTake* stems = nullptr) {
+    audio::WaveStreamWriter writer;
+    audio::WaveFormat format;
+    format.sampleRate = static_cast<uint32_t>(appConfig.sampleRate);
+    format.sampleFormat = appConfig.sampleFormat;
+    if (!writer.open(path, format, errorMessage)) {
+        return false;
+    }
+    bool writeOk = true;
+    render([&](float* samples, std::size_t count) {
+        if (!writeOk) {
+            return;
+        }
+        if (gain != 1.0f) {
+            for (std::size_t i = 0; i < count; ++i) {
+                samples[i] *= gain;
+            }
+        }
+        writeOk = writer.write(samples, count, errorMessage);
+    }, stems);
+    if (stems && !stems->close(errorMessage)) {
+        return false;
+    }
+    return writeOk && writer.close(errorMessage);
+}
+
+struct BatchPreset {
+    std::string name;
+    AppConfig config;
+};
+
+// Each non-empty, non-# line of the preset file is "name --param value ...",
+// layered over the command line. Without a file the command line is the only
+// preset.
+bool loadBatchPresets(const std::vector<std::string>& baseArgs,
+                      const AppConfig& base,
+                      std::vector<BatchPreset>& presets,
+                      std::string& errorMessage) {
+    presets.clear();
+    if (base.batchPresets.empty()) {
+        presets.push_back({"default", base});
+        return true;
+    }
+    std::ifstream file(base.batchPresets);
+    if (!file.is_open()) {
+        errorMessage = "无法打开预设列表: " + base.batchPresets.string();
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream tokens(line);
+        std::string name;
+        if (!(tokens >> name) || name[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> args = baseArgs;
+        for (std::string token; tokens >> token;) {
+            args.push_back(token);
+        }
+        bool ignoredHelp = false;
+        AppConfig config = parseArgs(args, ignoredHelp);
+        if (config.seed == 0) {
+            config.seed = base.seed;
+        }
+        presets.push_back({name, config});
+    }
+    if (presets.empty()) {
+        errorMessage = "预设列表为空: " + base.batchPresets.string();
+        return false;
+    }
+    return true;
+}
 
-    return buffer;
+// Renders every preset x key x velocity to its own file. Each worker keeps
+// one engine (room kernels included) and resets it between files; files are
+// not normalised, so velocity layers keep their relative level.
+int runBatch(const std::vector<std::string>& args, const AppConfig& base) {
+    std::vector<BatchPreset> presets;
+    std::string errorMessage;
+    if (!loadBatchPresets(args, base, presets, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
+    if (base.batchKeys.empty() || base.batchVelocities.empty()) {
+        std::cerr << "批量渲染需要至少一个音高和一个力度。\n";
+        return 1;
+    }
+    std::error_code dirError;
+    std::filesystem::create_directories(base.batchDir, dirError);
+    if (dirError) {
+        std::cerr << "无法创建输出目录: " << base.batchDir.string() << "\n";
+        return 1;
+    }
+
+    const std::size_t keyCount = base.batchKeys.size();
+    const std::size_t layerCount = base.batchVelocities.size();
+    const std::size_t jobCount = presets.size() * keyCount * layerCount;
+    std::size_t workers = base.batchJobs;
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers = std::min(workers, jobCount);
+
+    std::atomic<std::size_t> nextJob{0};
+    std::atomic<std::size_t> written{0};
+    std::mutex errorMutex;
+    std::string firstError;
+    auto work = [&] {
+        const engine::ScopedDspThread dspThread("batch render");
+        engine::StringSynthEngine synthEngine(synthesis::StringConfig{}, base.maxVoices);
+        for (std::size_t job = nextJob++; job < jobCount; job = nextJob++) {
+            const BatchPreset& preset = presets[job / (keyCount * layerCount)];
+            const int key = base.batchKeys[(job / layerCount) % keyCount];
+            const std::size_t layer = job % layerCount;
+
+            configureEngine(synthEngine, preset.config);
+            synthEngine.reset();
+            const double frequency = engine::MidiNoteToFrequency(key);
+            const std::vector<synthesis::NoteEvent> notes{
+                {frequency, preset.config.duration, 0.0}};
+            const std::size_t totalFrames = renderFrameCount(
+                notes, preset.config.sampleRate, tailSecondsFor(synthEngine));
+
+            char name[32];
+            std::snprintf(name, sizeof(name), "_%03d_v%zu.wav", key, layer + 1);
+            const auto path = base.batchDir / (preset.name + name);
+            std::string jobError;
+            const auto render = [&](const BlockSink& sink, StemTake*) {
+                renderWithEngine(synthEngine, notes, preset.config.sampleRate, totalFrames,
+                                 base.batchVelocities[layer], preset.config.silenceLevel, sink);
+            };
+            if (writeRender(render, preset.config, 1.0f, path, jobError)) {
+                ++written;
+            } else {
+                const std::lock_guard<std::mutex> lock(errorMutex);
+                if (firstError.empty()) {
+                    firstError = jobError;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < workers; ++i) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (!firstError.empty()) {
+        std::cerr << firstError << "\n";
+    }
+    std::cout << "已生成 " << written.load() << "/" << jobCount << " 个 WAV 文件: "
+              << std::filesystem::absolute(base.batchDir) << "\n";
+    return written.load() == jobCount ? 0 : 1;
+}
+
+// Converts one JSON preset, or every .json under a directory, into a bank.
+// Files that fail to parse are reported and left out.
+int runMakeBank(const AppConfig& config) {
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    if (std::filesystem::is_directory(config.makeBank, ec)) {
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(config.makeBank, ec)) {
+            if (entry.is_regular_file() && toLower(entry.path().extension().string()) == ".json") {
+                files.push_back(entry.path());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    } else {
+        files.push_back(config.makeBank);
+    }
+
+    std::vector<engine::Preset> presets;
+    presets.reserve(files.size());
+    for (const auto& file : files) {
+        engine::Preset preset;
+        std::string errorMessage;
+        if (engine::LoadPresetJson(file, preset, errorMessage)) {
+            presets.push_back(std::move(preset));
+        } else {
+            std::cerr << file.string() << ": " << errorMessage << "\n";
+        }
+    }
+    if (presets.empty()) {
+        std::cerr << "没有可转换的预设: " << config.makeBank.string() << "\n";
+        return 1;
+    }
+    std::string errorMessage;
+    if (!engine::WritePresetBank(config.bankOutput, presets, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
+    std::cout << "已写入 " << presets.size() << "/" << files.size() << " 个预设: "
+              << std::filesystem::absolute(config.bankOutput) << "\n";
+    return presets.size() == files.size() ? 0 : 1;
+}
+
+// Prints the bank's presets in name order.
+int runListBank(const AppConfig& config) {
+    engine::PresetBank bank;
+    std::string errorMessage;
+    if (!bank.open(config.listBank, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
+    for (std::size_t rank = 0; rank < bank.size(); ++rank) {
+        const std::size_t index = bank.sortedIndex(rank);
+        std::cout << index << "\t" << bank.name(index) << "\n";
+    }
+    std::cout << bank.size() << " 个预设\n";
+    return 0;
 }
 
 }  // namespace
 
 int main(int argc, char** argv) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
     bool showHelp = false;
-    AppConfig appConfig = parseArgs(argc, argv, showHelp);
+    AppConfig appConfig = parseArgs(args, showHelp);
     if (showHelp) {
         printUsage();
         return 0;
     }
 
-    engine::StringSynthEngine synthEngine;
-    synthEngine.setSampleRate(appConfig.sampleRate);
-    synthEngine.setParam(engine::ParamId::Decay, appConfig.decay);
-    synthEngine.setParam(engine::ParamId::Brightness, appConfig.brightness);
-    synthEngine.setParam(engine::ParamId::DispersionAmount, appConfig.dispersionAmount);
-    synthEngine.setParam(engine::ParamId::ExcitationBrightness,
-                         appConfig.excitationBrightness);
-    synthEngine.setParam(engine::ParamId::ExcitationVelocity, appConfig.excitationVelocity);
-    synthEngine.setParam(engine::ParamId::ExcitationMix, appConfig.excitationMix);
-    synthEngine.setParam(engine::ParamId::PickPosition, appConfig.pickPosition);
-    synthEngine.setParam(engine::ParamId::BodyTone, appConfig.bodyTone);
-    synthEngine.setParam(engine::ParamId::BodySize, appConfig.bodySize);
-    synthEngine.setParam(engine::ParamId::RoomAmount, appConfig.roomAmount);
-    synthEngine.setParam(engine::ParamId::EnableLowpass, appConfig.enableLowpass ? 1.0f : 0.0f);
-    synthEngine.setParam(engine::ParamId::NoiseType,
-                         appConfig.noiseType == synthesis::NoiseType::Binary ? 1.0f : 0.0f);
-    synthEngine.setParam(engine::ParamId::MasterGain, 1.0f);
-    synthEngine.setParam(engine::ParamId::AmpRelease, appConfig.ampRelease);
+    // Offline renders run on this thread; long tails are as slow with
+    // denormals here as on the audio thread.
+    const engine::ScopedDspThread dspThread("offline render");
 
-    synthesis::StringConfig synthConfig = synthEngine.stringConfig();
-    synthConfig.seed = appConfig.seed;
-    synthConfig.excitationMode = appConfig.excitationMode;
-    synthConfig.excitationType = appConfig.excitationType;
-    synthEngine.setConfig(synthConfig);
+    if (appConfig.seed == 0) {
+        // Both passes of a normalised render must hear the same noise bursts.
+        appConfig.seed = std::random_device{}();
+    }
+    if (!appConfig.makeBank.empty()) {
+        return runMakeBank(appConfig);
+    }
+    if (!appConfig.listBank.empty()) {
+        return runListBank(appConfig);
+    }
+    // Before the first room is built: the layout is fixed from then on.
+    if (appConfig.offline && appConfig.tunePartitions) {
+        engine::TuneRoomPartitions(engine::DefaultPartitionCachePath(),
+                                   static_cast<int>(appConfig.sampleRate), 0,
+                                   engine::RoomBlockProfile::Offline);
+    }
+    if (!appConfig.batchKeys.empty()) {
+        return runBatch(args, appConfig);
+    }
 
     std::vector<synthesis::NoteEvent> noteSequence = appConfig.notes;
     if (noteSequence.empty()) {
         noteSequence.push_back({appConfig.frequency, appConfig.duration, 0.0});
     }
+    std::string errorMessage;
+    engine::MidiFilePlayer midiPlayer;
+    const bool playMidi = !appConfig.midiFile.empty();
+    if (playMidi && !midiPlayer.open(appConfig.midiFile, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
 
-    const double tailSeconds =
-        std::max(0.5, static_cast<double>(synthEngine.getParam(engine::ParamId::AmpRelease)) * 4.0);
-    auto samples = renderWithEngine(synthEngine, noteSequence, appConfig.sampleRate, tailSeconds);
-    const float peak = findPeak(samples);
-    normalize(samples, peak);
-
-    if (samples.empty()) {
+    auto synthEngine = makeEngine(appConfig);
+    const std::size_t totalFrames =
+        renderFrameCount(noteSequence, appConfig.sampleRate, tailSecondsFor(*synthEngine));
+    if (totalFrames == 0) {
         std::cerr << "生成样本失败，请检查输入参数。\n";
         return 1;
     }
+    // The engine is replaced between passes, so this looks it up each time.
+    const Renderer render = [&](const BlockSink& sink, StemTake* stems) {
+        if (playMidi) {
+            renderMidiWithEngine(*synthEngine, midiPlayer, appConfig.sampleRate,
+                                 tailSecondsFor(*synthEngine), appConfig.silenceLevel, sink,
+                                 stems);
+        } else {
+            renderWithEngine(*synthEngine, noteSequence, appConfig.sampleRate, totalFrames, 1.0f,
+                             appConfig.silenceLevel, sink, stems);
+        }
+    };
 
-    audio::WaveWriter writer;
-    audio::WaveFormat format;
-    format.sampleRate = static_cast<uint32_t>(appConfig.sampleRate);
-    std::string errorMessage;
-    if (!writer.write(appConfig.output, samples, format, errorMessage)) {
+    // Scan-only first pass: find the peak without keeping the render.
+    float gain = 1.0f;
+    if (appConfig.normalize) {
+        float peak = 0.0f;
+        render([&peak](float* samples, std::size_t count) {
+            for (std::size_t i = 0; i < count; ++i) {
+                peak = std::max(peak, std::abs(samples[i]));
+            }
+        }, nullptr);
+        if (peak > 1.0f) {
+            gain = 1.0f / peak;
+        }
+        synthEngine = makeEngine(appConfig);
+    }
+
+    // Stems share the mix's gain, so they still add up to it.
+    std::unique_ptr<StemTake> stems;
+    if (!appConfig.stemsDir.empty()) {
+        stems = std::make_unique<StemTake>();
+        if (!stems->open(appConfig.stemsDir, appConfig, synthEngine->partCount(), gain,
+                         errorMessage)) {
+            std::cerr << errorMessage << "\n";
+            return 1;
+        }
+    }
+    if (!writeRender(render, appConfig, gain, appConfig.output, errorMessage, stems.get())) {
         std::cerr << errorMessage << "\n";
         return 1;
     }
 
     std::cout << "已生成 WAV 文件: " << std::filesystem::absolute(appConfig.output)
               << "\n";
+    if (stems) {
+        std::cout << "已生成分轨: " << std::filesystem::absolute(appConfig.stemsDir) << "\n";
+    }
     return 0;
 }
@@ -0,0 +1,165 @@
+#include "plugin/PluginProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#include "dsp/RoomIrLibrary.h"
+#include "engine/MidiNote.h"
+#include "engine/RealtimeThread.h"
+
+namespace plugin {
+
+namespace {
+// Longest built-in room IR, in seconds.
+double LongestIrSeconds() {
+    double longest = 0.0;
+    for (const auto& info : dsp::RoomIrLibrary::list()) {
+        if (info.sampleRate > 0) {
+            longest = std::max(longest, static_cast<double>(info.frameCount) / info.sampleRate);
+        }
+    }
+    return longest;
+}
+}  // namespace
+
+PluginProcessor::PluginProcessor(std::size_t parts, std::size_t maxVoices)
+    : engine_(synthesis::StringConfig{}, maxVoices, 0, parts) {
+    engine_.setRenderMode(engine::RenderMode::Realtime);
+}
+
+void PluginProcessor::activate(double sampleRate) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    sampleRate_ = sampleRate;
+    engine_.setSampleRate(sampleRate);
+}
+
+void PluginProcessor::setOffline(bool offline) {
+    engine_.setRenderMode(offline ? engine::RenderMode::Offline : engine::RenderMode::Realtime);
+}
+
+void PluginProcessor::reset() {
+    engine_.reset();
+}
+
+void PluginProcessor::process(float* const* outputs, std::uint16_t channels,
+                              std::uint32_t frames, std::span<const PluginEvent> events) {
+    // The host's audio thread: its FP mode is not ours to rely on.
+    const engine::ScopedDspThread dspThread("plugin process");
+    const std::uint64_t blockStart = engine_.renderedFrames();
+    const std::size_t parts = engine_.partCount();
+    std::size_t pending = 0;
+    for (const auto& in : events.first(std::min(events.size(), kMaxEventsPerBlock))) {
+        const std::uint32_t offset = std::min(in.offset, frames > 0 ? frames - 1 : 0u);
+        const std::size_t part = static_cast<std::size_t>(std::max<int>(in.channel, 0)) % parts;
+        if (in.type == PluginEvent::Type::AllNotesOff) {
+            // One note off per key would overrun the batch; the run so far
+            // goes first, then the keys in runs of their own.
+            for (int key = 0; key < 128; ++key) {
+                if (pending == batch_.size()) {
+                    flush(pending);
+                    pending = 0;
+                }
+                engine::Event& out = batch_[pending++];
+                out = engine::Event{};
+                out.type = engine::EventType::NoteOff;
+                out.noteId = key;
+                out.part = part;
+                out.frameOffset = blockStart + offset;
+            }
+            continue;
+        }
+        if (pending == batch_.size()) {
+            flush(pending);
+            pending = 0;
+        }
+        engine::Event& out = batch_[pending++];
+        out = engine::Event{};
+        out.frameOffset = blockStart + offset;
+        out.part = part;
+        switch (in.type) {
+        case PluginEvent::Type::NoteOn:
+            out.type = engine::EventType::NoteOn;
+            out.noteId = in.key;
+            out.velocity = std::clamp(in.velocity, 0.0f, 1.0f);
+            out.frequency = engine::MidiNoteToFrequency(in.key);
+            break;
+        case PluginEvent::Type::NoteOff:
+            out.type = engine::EventType::NoteOff;
+            out.noteId = in.key;
+            break;
+        case PluginEvent::Type::Param:
+            out.type = engine::EventType::ParamChange;
+            out.param = in.param;
+            out.paramValue = in.value;
+            break;
+        case PluginEvent::Type::NoteExpression:
+            out.type = engine::EventType::NoteExpression;
+            out.noteId = in.key;
+            out.expression = in.expression;
+            out.paramValue = in.value;
+            break;
+        case PluginEvent::Type::AllNotesOff:
+            break;
+        }
+    }
+    flush(pending);
+
+    engine::PlanarProcessBlock block{outputs, frames, channels};
+    engine_.process(block);
+}
+
+void PluginProcessor::flush(std::size_t count) {
+    if (count > 0) {
+        (void)engine_.enqueueEvents(std::span<const engine::Event>(batch_.data(), count));
+    }
+}
+
+std::uint32_t PluginProcessor::tailFrames() const {
+    const double release = engine_.getParam(engine::ParamId::AmpRelease);
+    return static_cast<std::uint32_t>(std::ceil((release + LongestIrSeconds()) * sampleRate_));
+}
+
+std::string PluginProcessor::saveState() const {
+    std::ostringstream out;
+    for (const auto& info : engine::GetParamInfoList()) {
+        out << info.name << '=' << engine_.getParam(info.id) << '\n';
+    }
+    return out.str();
+}
+
+bool PluginProcessor::loadState(std::string_view state, std::string& errorMessage) {
+    errorMessage.clear();
+    std::size_t applied = 0;
+    while (!state.empty()) {
+        const std::size_t end = std::min(state.find('\n'), state.size());
+        const std::string_view line = state.substr(0, end);
+        state.remove_prefix(std::min(end + 1, state.size()));
+        const std::size_t eq = line.find('=');
+        if (eq == std::string_view::npos) {
+            continue;
+        }
+        const engine::ParamInfo* info = engine::FindParamByName(line.substr(0, eq));
+        if (!info) {
+            continue;
+        }
+        const std::string text(line.substr(eq + 1));
+        char* parsedEnd = nullptr;
+        const float value = std::strtof(text.c_str(), &parsedEnd);
+        if (parsedEnd == text.c_str()) {
+            continue;
+        }
+        engine_.setParam(info->id, value);
+        ++applied;
+    }
+    if (applied == 0) {
+        errorMessage = "插件状态中没有可用的参数";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace plugin
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "engine/StringParams.h"
+#include "engine/StringSynthEngine.h"
+
+namespace plugin {
+
+// A host event, timed in frames from the start of the block it came with.
+struct PluginEvent {
+    enum class Type : std::uint8_t { NoteOn, NoteOff, Param, AllNotesOff, NoteExpression };
+
+    Type type = Type::NoteOn;
+    std::uint32_t offset = 0;
+    std::int16_t channel = 0;  // MIDI channel; picks the part
+    std::int16_t key = 60;     // MIDI key
+    float velocity = 1.0f;     // 0..1
+    engine::ParamId param = engine::ParamId::Decay;
+    // NoteExpression: which one of `key`'s; `value` in its engine units.
+    engine::NoteExpression expression = engine::NoteExpression::PitchBend;
+    float value = 0.0f;        // plain value, in the parameter's own range
+};
+
+// StringSynthEngine behind a plugin format's process call, independent of
+// the format (see SatoriClap.cpp). Host buffers are rendered in place
+// through a PlanarProcessBlock, and each event goes into the engine's
+// scheduler at renderedFrames() + offset, so it starts on its sample.
+//
+// Instances already share the room IR kernels (built once per process for
+// each IR, rate and quality) and run no voice helper threads: hosts spread
+// plugin instances across their own cores.
+class PluginProcessor {
+public:
+    // Events beyond this in one block are dropped, as a full queue would.
+    static constexpr std::size_t kMaxEventsPerBlock = 1024;
+
+    explicit PluginProcessor(std::size_t parts = 1,
+                             std::size_t maxVoices = engine::StringSynthEngine::kDefaultMaxVoices);
+
+    // Main thread, while deactivated.
+    void activate(double sampleRate);
+    // Offline bounces render the room tail inline instead of on its worker.
+    void setOffline(bool offline);
+    // Audio thread; not realtime-safe (see StringSynthEngine::reset()).
+    void reset();
+
+    // Audio thread. `events` must be sorted by offset; `outputs` holds
+    // `channels` host buffers of `frames` samples, written in place.
+    void process(float* const* outputs, std::uint16_t channels, std::uint32_t frames,
+                 std::span<const PluginEvent> events);
+
+    // Output latency to report to the host. The room tail's lag behind its
+    // input is covered by the IR head rendered on the audio thread, so the
+    // dry signal and the early reverb both leave in the block they were
+    // played in: there is nothing for the host to compensate.
+    std::uint32_t latencyFrames() const { return 0; }
+    // How long the output keeps ringing after the last note: release plus
+    // the longest room IR, in frames at the active rate.
+    std::uint32_t tailFrames() const;
+
+    // Any thread.
+    void setParam(engine::ParamId id, float value) { engine_.setParam(id, value); }
+    float getParam(engine::ParamId id) const { return engine_.getParam(id); }
+
+    // Parameter values as "name=value" lines, the names of
+    // engine::GetParamInfoList(). Loading skips unknown names and damaged
+    // lines and leaves the missing parameters as they are.
+    std::string saveState() const;
+    bool loadState(std::string_view state, std::string& errorMessage);
+
+    engine::StringSynthEngine& engine() { return engine_; }
+    const engine::StringSynthEngine& engine() const { return engine_; }
+
+private:
+    void flush(std::size_t count);
+
+    engine::StringSynthEngine engine_;
+    double sampleRate_ = 44100.0;
+    // Converted events, queued in runs (audio thread).
+    std::array<engine::Event, 64> batch_{};
+};
+
+}  // namespace plugin
@@ -0,0 +1,458 @@
+// CLAP entry point for Satori: one stereo instrument with a note input, every
+// engine parameter automatable, and state saved as PluginProcessor text.
+// Built only when the CLAP headers are found (SATORI_BUILD_CLAP).
+
+#include <clap/clap.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "engine/StringParams.h"
+#include "plugin/PluginProcessor.h"
+
+namespace {
+
+const char* const kFeatures[] = {CLAP_PLUGIN_FEATURE_INSTRUMENT,
+                                 CLAP_PLUGIN_FEATURE_SYNTHESIZER,
+                                 CLAP_PLUGIN_FEATURE_STEREO, nullptr};
+
+const clap_plugin_descriptor_t kDescriptor = {
+    CLAP_VERSION_INIT,
+    "io.github.129s.satori",
+    "Satori",
+    "Satori",
+    "https://github.com/129s/Satori",
+    "",
+    "",
+    "0.1.0",
+    "Karplus-Strong string synthesizer",
+    kFeatures,
+};
+
+struct SatoriClap {
+    clap_plugin_t plugin{};
+    const clap_host_t* host = nullptr;
+    plugin::PluginProcessor processor;
+    // Converted input events, reserved on activate so process() does not
+    // allocate.
+    std::vector<plugin::PluginEvent> events;
+};
+
+SatoriClap* Self(const clap_plugin_t* plugin) {
+    return static_cast<SatoriClap*>(plugin->plugin_data);
+}
+
+const engine::ParamInfo* ParamAt(std::uint32_t index) {
+    const auto params = engine::GetParamInfoList();
+    return index < params.size() ? &params[index] : nullptr;
+}
+
+// CLAP parameter ids are the ParamId values, which stay stable across
+// versions; the list index may not.
+const engine::ParamInfo* ParamById(clap_id id) {
+    return engine::GetParamInfo(static_cast<engine::ParamId>(id));
+}
+
+void CopyName(char* out, std::size_t size, const char* text) {
+    std::snprintf(out, size, "%s", text);
+}
+
+// ---- audio ports ----
+
+std::uint32_t AudioPortsCount(const clap_plugin_t*, bool isInput) {
+    return isInput ? 0 : 1;
+}
+
+bool AudioPortsGet(const clap_plugin_t*, std::uint32_t index, bool isInput,
+                   clap_audio_port_info_t* info) {
+    if (isInput || index != 0) {
+        return false;
+    }
+    info->id = 0;
+    CopyName(info->name, sizeof(info->name), "Main");
+    info->flags = CLAP_AUDIO_PORT_IS_MAIN;
+    info->channel_count = 2;
+    info->port_type = CLAP_PORT_STEREO;
+    info->in_place_pair = CLAP_INVALID_ID;
+    return true;
+}
+
+const clap_plugin_audio_ports_t kAudioPorts = {AudioPortsCount, AudioPortsGet};
+
+// ---- note ports ----
+
+std::uint32_t NotePortsCount(const clap_plugin_t*, bool isInput) {
+    return isInput ? 1 : 0;
+}
+
+bool NotePortsGet(const clap_plugin_t*, std::uint32_t index, bool isInput,
+                  clap_note_port_info_t* info) {
+    if (!isInput || index != 0) {
+        return false;
+    }
+    info->id = 0;
+    info->supported_dialects = CLAP_NOTE_DIALECT_CLAP | CLAP_NOTE_DIALECT_MIDI;
+    info->preferred_dialect = CLAP_NOTE_DIALECT_CLAP;
+    CopyName(info->name, sizeof(info->name), "Notes");
+    return true;
+}
+
+const clap_plugin_note_ports_t kNotePorts = {NotePortsCount, NotePortsGet};
+
+// ---- latency and tail ----
+
+std::uint32_t LatencyGet(const clap_plugin_t* plugin) {
+    return Self(plugin)->processor.latencyFrames();
+}
+
+const clap_plugin_latency_t kLatency = {LatencyGet};
+
+std::uint32_t TailGet(const clap_plugin_t* plugin) {
+    return Self(plugin)->processor.tailFrames();
+}
+
+const clap_plugin_tail_t kTail = {TailGet};
+
+// ---- render mode ----
+
+bool RenderHasHardRealtimeRequirement(const clap_plugin_t*) {
+    return false;
+}
+
+bool RenderSet(const clap_plugin_t* plugin, clap_plugin_render_mode mode) {
+    Self(plugin)->processor.setOffline(mode == CLAP_RENDER_OFFLINE);
+    return true;
+}
+
+const clap_plugin_render_t kRender = {RenderHasHardRealtimeRequirement, RenderSet};
+
+// ---- parameters ----
+
+std::uint32_t ParamsCount(const clap_plugin_t*) {
+    return static_cast<std::uint32_t>(engine::GetParamInfoList().size());
+}
+
+bool ParamsGetInfo(const clap_plugin_t*, std::uint32_t index, clap_param_info_t* info) {
+    const engine::ParamInfo* param = ParamAt(index);
+    if (!param) {
+        return false;
+    }
+    std::memset(info, 0, sizeof(*info));
+    info->id = static_cast<clap_id>(param->id);
+    info->flags = CLAP_PARAM_IS_AUTOMATABLE;
+    if (param->type != engine::ParamType::Float) {
+        info->flags |= CLAP_PARAM_IS_STEPPED;
+    }
+    CopyName(info->name, sizeof(info->name), param->name);
+    info->min_value = param->minValue;
+    info->max_value = param->maxValue;
+    info->default_value = param->defaultValue;
+    return true;
+}
+
+bool ParamsGetValue(const clap_plugin_t* plugin, clap_id id, double* value) {
+    const engine::ParamInfo* param = ParamById(id);
+    if (!param) {
+        return false;
+    }
+    *value = Self(plugin)->processor.getParam(param->id);
+    return true;
+}
+
+bool ParamsValueToText(const clap_plugin_t*, clap_id id, double value, char* display,
+                       std::uint32_t size) {
+    const engine::ParamInfo* param = ParamById(id);
+    if (!param) {
+        return false;
+    }
+    if (param->type == engine::ParamType::Float) {
+        std::snprintf(display, size, "%.3f", value);
+    } else {
+        std::snprintf(display, size, "%d", static_cast<int>(value));
+    }
+    return true;
+}
+
+bool ParamsTextToValue(const clap_plugin_t*, clap_id id, const char* display, double* value) {
+    if (!ParamById(id)) {
+        return false;
+    }
+    char* end = nullptr;
+    *value = std::strtod(display, &end);
+    return end != display;
+}
+
+// Parameter changes while not processing.
+void ParamsFlush(const clap_plugin_t* plugin, const clap_input_events_t* in,
+                 const clap_output_events_t*) {
+    const std::uint32_t count = in->size(in);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const clap_event_header_t* header = in->get(in, i);
+        if (header->space_id != CLAP_CORE_EVENT_SPACE_ID || header->type != CLAP_EVENT_PARAM_VALUE) {
+            continue;
+        }
+        const auto* event = reinterpret_cast<const clap_event_param_value_t*>(header);
+        if (const engine::ParamInfo* param = ParamById(event->param_id)) {
+            Self(plugin)->processor.setParam(param->id, static_cast<float>(event->value));
+        }
+    }
+}
+
+const clap_plugin_params_t kParams = {ParamsCount, ParamsGetInfo, ParamsGetValue,
+                                      ParamsValueToText, ParamsTextToValue, ParamsFlush};
+
+// ---- state ----
+
+bool StateSave(const clap_plugin_t* plugin, const clap_ostream_t* stream) {
+    const std::string state = Self(plugin)->processor.saveState();
+    std::size_t written = 0;
+    while (written < state.size()) {
+        const std::int64_t n = stream->write(stream, state.data() + written, state.size() - written);
+        if (n <= 0) {
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool StateLoad(const clap_plugin_t* plugin, const clap_istream_t* stream) {
+    std::string state;
+    std::array<char, 4096> buffer{};
+    for (;;) {
+        const std::int64_t n = stream->read(stream, buffer.data(), buffer.size());
+        if (n < 0) {
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        state.append(buffer.data(), static_cast<std::size_t>(n));
+    }
+    std::string errorMessage;
+    return Self(plugin)->processor.loadState(state, errorMessage);
+}
+
+const clap_plugin_state_t kState = {StateSave, StateLoad};
+
+// ---- plugin ----
+
+bool PluginInit(const clap_plugin_t*) {
+    return true;
+}
+
+void PluginDestroy(const clap_plugin_t* plugin) {
+    delete Self(plugin);
+}
+
+bool PluginActivate(const clap_plugin_t* plugin, double sampleRate, std::uint32_t,
+                    std::uint32_t) {
+    SatoriClap* self = Self(plugin);
+    self->processor.activate(sampleRate);
+    self->events.reserve(plugin::PluginProcessor::kMaxEventsPerBlock);
+    return true;
+}
+
+void PluginDeactivate(const clap_plugin_t*) {}
+
+bool PluginStartProcessing(const clap_plugin_t*) {
+    return true;
+}
+
+void PluginStopProcessing(const clap_plugin_t*) {}
+
+void PluginReset(const clap_plugin_t* plugin) {
+    Self(plugin)->processor.reset();
+}
+
+// Host events in, in block order: CLAP notes and note expressions (tuning,
+// pressure, brightness as timbre), raw MIDI note messages and parameter
+// values; other events are skipped.
+void TranslateEvents(const clap_input_events_t* in, std::vector<plugin::PluginEvent>& out) {
+    out.clear();
+    const std::uint32_t count = in ? in->size(in) : 0;
+    for (std::uint32_t i = 0; i < count && out.size() < out.capacity(); ++i) {
+        const clap_event_header_t* header = in->get(in, i);
+        if (header->space_id != CLAP_CORE_EVENT_SPACE_ID) {
+            continue;
+        }
+        plugin::PluginEvent event;
+        event.offset = header->time;
+        switch (header->type) {
+        case CLAP_EVENT_NOTE_ON:
+        case CLAP_EVENT_NOTE_OFF:
+        case CLAP_EVENT_NOTE_CHOKE: {
+            const auto* note = reinterpret_cast<const clap_event_note_t*>(header);
+            event.channel = static_cast<std::int16_t>(std::max<std::int16_t>(note->channel, 0));
+            if (note->key < 0) {
+                // Key -1 is a wildcard: every key on the channel.
+                if (header->type == CLAP_EVENT_NOTE_ON) {
+                    continue;
+                }
+                event.type = plugin::PluginEvent::Type::AllNotesOff;
+                break;
+            }
+            event.key = note->key;
+            event.velocity = static_cast<float>(note->velocity);
+            event.type = header->type == CLAP_EVENT_NOTE_ON ? plugin::PluginEvent::Type::NoteOn
+                                                            : plugin::PluginEvent::Type::NoteOff;
+            break;
+        }
+        case CLAP_EVENT_NOTE_EXPRESSION: {
+            const auto* expression =
+                reinterpret_cast<const clap_event_note_expression_t*>(header);
+            if (expression->key < 0) {
+                continue;
+            }
+            event.type = plugin::PluginEvent::Type::NoteExpression;
+            event.channel = static_cast<std::int16_t>(std::max<std::int16_t>(expression->channel, 0));
+            event.key = expression->key;
+            event.value = static_cast<float>(expression->value);
+            switch (expression->expression_id) {
+            case CLAP_NOTE_EXPRESSION_TUNING:
+                event.expression = engine::NoteExpression::PitchBend;
+                break;
+            case CLAP_NOTE_EXPRESSION_PRESSURE:
+                event.expression = engine::NoteExpression::Pressure;
+                break;
+            case CLAP_NOTE_EXPRESSION_BRIGHTNESS:
+                event.expression = engine::NoteExpression::Timbre;
+                break;
+            default:
+                continue;
+            }
+            break;
+        }
+        case CLAP_EVENT_MIDI: {
+            const auto* midi = reinterpret_cast<const clap_event_midi_t*>(header);
+            const std::uint8_t type = midi->data[0] & 0xF0u;
+            event.channel = static_cast<std::int16_t>(midi->data[0] & 0x0Fu);
+            event.key = static_cast<std::int16_t>(midi->data[1] & 0x7Fu);
+            event.velocity = static_cast<float>(midi->data[2] & 0x7Fu) / 127.0f;
+            if (type == 0x90 && midi->data[2] > 0) {
+                event.type = plugin::PluginEvent::Type::NoteOn;
+            } else if (type == 0x80 || type == 0x90) {
+                event.type = plugin::PluginEvent::Type::NoteOff;
+            } else if (type == 0xB0 && (midi->data[1] == 120 || midi->data[1] == 123)) {
+                event.type = plugin::PluginEvent::Type::AllNotesOff;
+            } else {
+                continue;
+            }
+            break;
+        }
+        case CLAP_EVENT_PARAM_VALUE: {
+            const auto* value = reinterpret_cast<const clap_event_param_value_t*>(header);
+            const engine::ParamInfo* param = ParamById(value->param_id);
+            if (!param) {
+                continue;
+            }
+            event.type = plugin::PluginEvent::Type::Param;
+            event.param = param->id;
+            event.value = static_cast<float>(value->value);
+            break;
+        }
+        default:
+            continue;
+        }
+        out.push_back(event);
+    }
+}
+
+clap_process_status PluginProcess(const clap_plugin_t* plugin, const clap_process_t* process) {
+    SatoriClap* self = Self(plugin);
+    TranslateEvents(process->in_events, self->events);
+    if (process->audio_outputs_count == 0 || !process->audio_outputs[0].data32) {
+        return CLAP_PROCESS_CONTINUE;
+    }
+    const clap_audio_buffer_t& output = process->audio_outputs[0];
+    self->processor.process(output.data32, static_cast<std::uint16_t>(output.channel_count),
+                            process->frames_count, self->events);
+    return CLAP_PROCESS_CONTINUE;
+}
+
+const void* PluginGetExtension(const clap_plugin_t*, const char* id) {
+    if (std::strcmp(id, CLAP_EXT_AUDIO_PORTS) == 0) {
+        return &kAudioPorts;
+    }
+    if (std::strcmp(id, CLAP_EXT_NOTE_PORTS) == 0) {
+        return &kNotePorts;
+    }
+    if (std::strcmp(id, CLAP_EXT_LATENCY) == 0) {
+        return &kLatency;
+    }
+    if (std::strcmp(id, CLAP_EXT_TAIL) == 0) {
+        return &kTail;
+    }
+    if (std::strcmp(id, CLAP_EXT_RENDER) == 0) {
+        return &kRender;
+    }
+    if (std::strcmp(id, CLAP_EXT_PARAMS) == 0) {
+        return &kParams;
+    }
+    if (std::strcmp(id, CLAP_EXT_STATE) == 0) {
+        return &kState;
+    }
+    return nullptr;
+}
+
+void PluginOnMainThread(const clap_plugin_t*) {}
+
+// ---- factory and entry ----
+
+std::uint32_t FactoryGetPluginCount(const clap_plugin_factory_t*) {
+    return 1;
+}
+
+const clap_plugin_descriptor_t* FactoryGetPluginDescriptor(const clap_plugin_factory_t*,
+                                                          std::uint32_t index) {
+    return index == 0 ? &kDescriptor : nullptr;
+}
+
+const clap_plugin_t* FactoryCreatePlugin(const clap_plugin_factory_t*, const clap_host_t* host,
+                                         const char* pluginId) {
+    if (!clap_version_is_compatible(host->clap_version) ||
+        std::strcmp(pluginId, kDescriptor.id) != 0) {
+        return nullptr;
+    }
+    auto* self = new (std::nothrow) SatoriClap();
+    if (!self) {
+        return nullptr;
+    }
+    self->host = host;
+    self->plugin.desc = &kDescriptor;
+    self->plugin.plugin_data = self;
+    self->plugin.init = PluginInit;
+    self->plugin.destroy = PluginDestroy;
+    self->plugin.activate = PluginActivate;
+    self->plugin.deactivate = PluginDeactivate;
+    self->plugin.start_processing = PluginStartProcessing;
+    self->plugin.stop_processing = PluginStopProcessing;
+    self->plugin.reset = PluginReset;
+    self->plugin.process = PluginProcess;
+    self->plugin.get_extension = PluginGetExtension;
+    self->plugin.on_main_thread = PluginOnMainThread;
+    return &self->plugin;
+}
+
+const clap_plugin_factory_t kFactory = {FactoryGetPluginCount, FactoryGetPluginDescriptor,
+                                        FactoryCreatePlugin};
+
+bool EntryInit(const char*) {
+    return true;
+}
+
+void EntryDeinit() {}
+
+const void* EntryGetFactory(const char* factoryId) {
+    return std::strcmp(factoryId, CLAP_PLUGIN_FACTORY_ID) == 0 ? &kFactory : nullptr;
+}
+
+}  // namespace
+
+extern "C" CLAP_EXPORT const clap_plugin_entry_t clap_entry = {CLAP_VERSION_INIT, EntryInit,
+                                                               EntryDeinit, EntryGetFactory};
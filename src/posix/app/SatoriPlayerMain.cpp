@@ -0,0 +1,270 @@
+// Headless realtime player for Linux and macOS: plays MIDI files and OSC
+// control messages through a JACK, ALSA or CoreAudio device and prints the
+// engine's health once a second, for installations that run without a
+// screen.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "engine/RoomPartitionTuner.h"
+#include "posix/audio/SatoriRealtimeEngine.h"
+#include "posix/net/OscServer.h"
+
+namespace {
+
+std::atomic<bool> gStop{false};
+
+void HandleSignal(int) {
+    gStop.store(true);
+}
+
+void printUsage() {
+    std::cout << "用法: SatoriPlayer [--backend auto|jack|alsa|coreaudio|null] [--device 名称] "
+                 "[--samplerate 48000] [--channels 2] [--buffer 256] [--midi song.mid] "
+                 "[--loop on|off] [--record out.wav] [--osc-port 9000] [--osc-bind 0.0.0.0] "
+                 "[--partitions auto|default] [--room-profile low-latency|balanced|efficient] "
+                 "[--input 2] [--input-device 名称] [--input-mode body|strings] [--list]\n"
+                 "  没有 --midi 时只运行引擎并输出状态，Ctrl+C 退出。\n"
+                 "  --partitions auto 首次运行时为本机测定房间尾部的分区布局并缓存（默认）。\n"
+                 "  --room-profile 房间块长: low-latency 随小缓冲降到 64 帧，efficient 随大缓冲"
+                 "升到 1024 帧，balanced 为 256（默认）。\n"
+                 "  --osc-port 接收 OSC 控制: /satori/note/on 音符 [力度 [频率]]、"
+                 "/satori/note/off 音符、/satori/param 名称 值、/satori/panic。\n"
+                 "  --input 打开采集声道（全双工，与输出同周期）：外部音频经琴体与房间"
+                 "（body，默认）或激励共鸣弦（strings）。\n";
+}
+
+bool parseBackend(const std::string& text, posixaudio::AudioBackendType& backend) {
+    using posixaudio::AudioBackendType;
+    for (const auto type : {AudioBackendType::Auto, AudioBackendType::Jack, AudioBackendType::Alsa,
+                            AudioBackendType::CoreAudio, AudioBackendType::Null}) {
+        if (text == posixaudio::BackendName(type)) {
+            backend = type;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseRoomProfile(const std::string& text, engine::RoomBlockProfile& profile) {
+    using engine::RoomBlockProfile;
+    if (text == "low-latency") {
+        profile = RoomBlockProfile::LowLatency;
+    } else if (text == "balanced") {
+        profile = RoomBlockProfile::Balanced;
+    } else if (text == "efficient") {
+        profile = RoomBlockProfile::Efficient;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseUnsigned(const std::string& text, std::uint32_t& value) {
+    try {
+        const unsigned long parsed = std::stoul(text);
+        value = static_cast<std::uint32_t>(parsed);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void listDevices() {
+    for (const auto& device : posixaudio::UnifiedAudioEngine::EnumerateDevices()) {
+        std::cout << posixaudio::BackendName(device.backend) << "\t"
+                  << (device.id.empty() ? "(默认)" : device.id) << "\t" << device.name << "\n";
+    }
+}
+
+void printMetrics(const posixaudio::SatoriRealtimeEngine::RealtimeMetrics& m) {
+    std::fprintf(stderr,
+                 "DSP %5.1f%%  p99 %.2f ms / %.2f ms  max %.2f ms  xrun %llu  恢复 %llu  "
+                 "复音 %zu/%zu  质量 %d  混响延迟 %.1f ms  输出延迟 %.1f ms  内存 %.1f MB%s\n",
+                 m.dspLoad * 100.0, m.windowMsP99, m.callbackPeriodMs, m.windowMsMax,
+                 static_cast<unsigned long long>(m.deviceXruns),
+                 static_cast<unsigned long long>(m.streamRecoveries), m.activeVoices, m.voiceLimit,
+                 m.qualityLevel, m.roomLatencyMs, m.latency.totalMs(),
+                 static_cast<double>(m.memory.total()) / 1048576.0,
+                 m.recording ? "  录音中" : "");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    std::unordered_map<std::string, std::string> kv;
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        if (arg == "--list") {
+            listDevices();
+            return 0;
+        }
+        if (arg.rfind("--", 0) == 0 && i + 1 < args.size()) {
+            kv[arg.substr(2)] = args[++i];
+        }
+    }
+
+    posixaudio::AudioEngineConfig config;
+    if (auto it = kv.find("backend"); it != kv.end() && !parseBackend(it->second, config.backend)) {
+        std::cerr << "未知的音频后端: " << it->second << "\n";
+        return 1;
+    }
+    if (auto it = kv.find("device"); it != kv.end()) {
+        config.deviceId = it->second;
+    }
+    std::uint32_t value = 0;
+    if (auto it = kv.find("samplerate"); it != kv.end() && parseUnsigned(it->second, value)) {
+        config.sampleRate = value;
+    }
+    if (auto it = kv.find("channels"); it != kv.end() && parseUnsigned(it->second, value)) {
+        config.channels = static_cast<std::uint16_t>(std::max<std::uint32_t>(1, value));
+    }
+    if (auto it = kv.find("buffer"); it != kv.end() && parseUnsigned(it->second, value)) {
+        config.bufferFrames = value;
+    }
+    if (auto it = kv.find("input"); it != kv.end() && parseUnsigned(it->second, value)) {
+        config.inputChannels = static_cast<std::uint16_t>(std::min<std::uint32_t>(value, 64));
+    }
+    if (auto it = kv.find("input-device"); it != kv.end()) {
+        config.inputDeviceId = it->second;
+    }
+    auto inputMode = engine::LiveInputMode::Body;
+    if (auto it = kv.find("input-mode"); it != kv.end()) {
+        if (it->second == "strings") {
+            inputMode = engine::LiveInputMode::Strings;
+        } else if (it->second != "body") {
+            std::cerr << "未知的输入模式: " << it->second << "\n";
+            return 1;
+        }
+    }
+    const std::filesystem::path midiFile = kv.count("midi") ? kv["midi"] : std::string();
+    const bool loop = kv.count("loop") && kv["loop"] == "on";
+    auto roomProfile = engine::RoomBlockProfile::Balanced;
+    if (auto it = kv.find("room-profile"); it != kv.end() &&
+                                           !parseRoomProfile(it->second, roomProfile)) {
+        std::cerr << "未知的房间配置: " << it->second << "\n";
+        return 1;
+    }
+
+    // Before the first room is built: the layout is fixed from then on.
+    if (!kv.count("partitions") || kv["partitions"] != "default") {
+        const auto tuning = engine::TuneRoomPartitions(engine::DefaultPartitionCachePath(),
+                                                       static_cast<int>(config.sampleRate),
+                                                       config.bufferFrames, roomProfile);
+        std::cerr << "房间分区";
+        for (const std::size_t size : tuning.blockSizes) {
+            std::cerr << " " << size;
+        }
+        std::cerr << (tuning.fromCache ? " (缓存)\n" : " (已测定)\n");
+    } else {
+        engine::StringSynthEngine::SetRoomPartitionLayout(
+            engine::StringSynthEngine::RoomProfileBlockSizes(roomProfile, config.bufferFrames));
+    }
+
+    posixaudio::SatoriRealtimeEngine player(config);
+    if (!player.initialize() || !player.start()) {
+        std::cerr << "无法启动音频设备: " << player.lastError() << "\n";
+        return 1;
+    }
+    const auto& device = player.audioConfig();
+    std::cerr << "音频后端 " << posixaudio::BackendName(device.backend) << ", "
+              << device.sampleRate << " Hz, " << device.channels << " 声道, "
+              << device.bufferFrames << " 帧/周期\n";
+    if (config.inputChannels > 0) {
+        if (device.inputChannels == 0) {
+            std::cerr << "无法打开采集设备，仅输出\n";
+        } else {
+            std::cerr << "采集 " << device.inputChannels << " 声道\n";
+            player.setParam(engine::ParamId::InputMode, static_cast<float>(inputMode));
+        }
+    }
+    const auto latency = player.outputLatency();
+    std::cerr << "输出延迟 " << latency.totalFrames() << " 帧 (" << latency.totalMs()
+              << " ms): 调度 " << latency.scheduleFrames << ", 设备 " << latency.deviceFrames
+              << "\n";
+
+    std::signal(SIGINT, HandleSignal);
+    std::signal(SIGTERM, HandleSignal);
+
+    std::string errorMessage;
+    if (auto it = kv.find("record"); it != kv.end()) {
+        if (!player.startRecording(it->second, audio::SampleFormat::Int24, errorMessage)) {
+            std::cerr << errorMessage << "\n";
+        }
+    }
+    if (!midiFile.empty() && !player.playMidiFile(midiFile, errorMessage)) {
+        std::cerr << errorMessage << "\n";
+        return 1;
+    }
+    posixnet::OscServer osc(player);
+    if (auto it = kv.find("osc-port"); it != kv.end()) {
+        posixnet::OscServerConfig oscConfig;
+        if (!parseUnsigned(it->second, value) || value > 65535) {
+            std::cerr << "无效的 OSC 端口: " << it->second << "\n";
+            return 1;
+        }
+        oscConfig.port = static_cast<std::uint16_t>(value);
+        if (auto bind = kv.find("osc-bind"); bind != kv.end()) {
+            oscConfig.bindAddress = bind->second;
+        }
+        if (!osc.start(oscConfig)) {
+            std::cerr << osc.lastError() << "\n";
+            return 1;
+        }
+        std::cerr << "OSC 监听 " << oscConfig.bindAddress << ":" << osc.port() << "\n";
+    }
+
+    // MIDI playback needs pumping every few tens of milliseconds.
+    constexpr auto kPumpInterval = std::chrono::milliseconds(50);
+    constexpr int kPumpsPerReport = 20;
+    // Room for the last notes' release and the reverb tail before the file
+    // ends (or starts over).
+    constexpr int kTailPumps = 80;
+    int tailPumps = -1;
+    for (int pump = 1; !gStop.load(); ++pump) {
+        std::this_thread::sleep_for(kPumpInterval);
+        if (!midiFile.empty() && !player.pumpMidiFile()) {
+            if (tailPumps < 0) {
+                tailPumps = kTailPumps;
+            } else if (--tailPumps == 0) {
+                if (!loop) {
+                    break;
+                }
+                (void)player.playMidiFile(midiFile, errorMessage);
+                tailPumps = -1;
+            }
+        }
+        if (pump % kPumpsPerReport == 0) {
+            printMetrics(player.metrics());
+            player.resetMetricsWindow();
+            if (osc.isRunning()) {
+                std::fprintf(stderr, "OSC 包 %llu  消息 %llu  拒绝 %llu\n",
+                             static_cast<unsigned long long>(osc.packetCount()),
+                             static_cast<unsigned long long>(osc.messageCount()),
+                             static_cast<unsigned long long>(osc.rejectedCount()));
+            }
+        }
+    }
+
+    osc.stop();
+    player.stopMidiFile();
+    if (player.isRecording() && !player.stopRecording(errorMessage)) {
+        std::cerr << errorMessage << "\n";
+    }
+    player.shutdown();
+    return 0;
+}
@@ -0,0 +1,467 @@
+#include "posix/audio/AlsaAudioEngine.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(SATORI_HAS_ALSA) && (SATORI_HAS_ALSA != 0)
+#include <alsa/asoundlib.h>
+#endif
+
+#include "engine/RealtimeThread.h"
+
+namespace posixaudio {
+
+#if defined(SATORI_HAS_ALSA) && (SATORI_HAS_ALSA != 0)
+
+struct AlsaAudioEngine::Impl {
+    snd_pcm_t* pcm = nullptr;
+    snd_pcm_t* capture = nullptr;  // full duplex: linked to pcm
+    bool linked = false;
+};
+
+namespace {
+// Periods in the device buffer: two keeps latency at one period of slack.
+constexpr snd_pcm_uframes_t kPeriods = 2;
+
+std::string AlsaError(const char* stage, int err) {
+    return std::string("[ALSA] ") + stage + ": " + snd_strerror(err);
+}
+
+void LogError(const std::string& message) {
+    std::fprintf(stderr, "%s\n", message.c_str());
+}
+
+struct FormatChoice {
+    snd_pcm_format_t alsa;
+    audio::SampleFormat format;
+};
+
+// Native-endian layouts, best first.
+constexpr FormatChoice kFormats[] = {
+    {SND_PCM_FORMAT_FLOAT, audio::SampleFormat::Float32},
+    {SND_PCM_FORMAT_S32, audio::SampleFormat::Int32},
+    {SND_PCM_FORMAT_S16, audio::SampleFormat::Int16},
+};
+}  // namespace
+
+AlsaAudioEngine::AlsaAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::Alsa;
+}
+
+AlsaAudioEngine::~AlsaAudioEngine() {
+    shutdown();
+}
+
+bool AlsaAudioEngine::initialize(RenderCallback callback) {
+    shutdown();
+    renderCallback_ = callback;
+    const std::string device = config_.deviceId.empty() ? "default" : config_.deviceId;
+    snd_pcm_t* pcm = nullptr;
+    const int err = snd_pcm_open(&pcm, device.c_str(), SND_PCM_STREAM_PLAYBACK, 0);
+    if (err < 0) {
+        setLastError(AlsaError("snd_pcm_open", err) + " (" + device + ")");
+        return false;
+    }
+    impl_ = std::make_unique<Impl>();
+    impl_->pcm = pcm;
+    if (!configurePcm()) {
+        shutdown();
+        return false;
+    }
+    if (config_.inputChannels > 0 && !openCapture()) {
+        // The synth still plays; effect mode just has nothing to process.
+        LogError(lastError_);
+        if (impl_->capture) {
+            snd_pcm_close(impl_->capture);
+            impl_->capture = nullptr;
+        }
+        config_.inputChannels = 0;
+    }
+    lastError_.clear();
+    return true;
+}
+
+bool AlsaAudioEngine::openCapture() {
+    const std::string device = !config_.inputDeviceId.empty() ? config_.inputDeviceId
+                               : !config_.deviceId.empty()    ? config_.deviceId
+                                                              : "default";
+    snd_pcm_t* capture = nullptr;
+    int err = snd_pcm_open(&capture, device.c_str(), SND_PCM_STREAM_CAPTURE, 0);
+    if (err < 0) {
+        setLastError(AlsaError("snd_pcm_open capture", err) + " (" + device + ")");
+        return false;
+    }
+    impl_->capture = capture;
+
+    // The playback's rate, period and format exactly: a period read is the
+    // period the callback renders, so there is nothing to buffer between.
+    snd_pcm_hw_params_t* hw = nullptr;
+    snd_pcm_hw_params_alloca(&hw);
+    unsigned int channels = config_.inputChannels;
+    snd_pcm_uframes_t period = config_.bufferFrames;
+    snd_pcm_uframes_t bufferSize = period * kPeriods;
+    if ((err = snd_pcm_hw_params_any(capture, hw)) < 0 ||
+        (err = snd_pcm_hw_params_set_access(capture, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
+        (err = snd_pcm_hw_params_set_format(capture, hw,
+                                            static_cast<snd_pcm_format_t>(captureFormat_))) < 0 ||
+        (err = snd_pcm_hw_params_set_channels_near(capture, hw, &channels)) < 0 ||
+        (err = snd_pcm_hw_params_set_rate(capture, hw, config_.sampleRate, 0)) < 0 ||
+        (err = snd_pcm_hw_params_set_period_size(capture, hw, period, 0)) < 0 ||
+        (err = snd_pcm_hw_params_set_buffer_size_near(capture, hw, &bufferSize)) < 0 ||
+        (err = snd_pcm_hw_params(capture, hw)) < 0) {
+        setLastError(AlsaError("snd_pcm_hw_params capture", err));
+        return false;
+    }
+    // Playback no longer starts itself once primed: startStreams() starts
+    // both together.
+    snd_pcm_sw_params_t* sw = nullptr;
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_uframes_t boundary = 0;
+    if ((err = snd_pcm_sw_params_current(impl_->pcm, sw)) < 0 ||
+        (err = snd_pcm_sw_params_get_boundary(sw, &boundary)) < 0 ||
+        (err = snd_pcm_sw_params_set_start_threshold(impl_->pcm, sw, boundary)) < 0 ||
+        (err = snd_pcm_sw_params(impl_->pcm, sw)) < 0) {
+        setLastError(AlsaError("snd_pcm_sw_params", err));
+        return false;
+    }
+    // Linked, both start on one clock edge; devices on separate cards
+    // refuse and are started back to back instead.
+    impl_->linked = snd_pcm_link(capture, impl_->pcm) == 0;
+
+    config_.inputChannels = static_cast<std::uint16_t>(channels);
+    const std::size_t samples = static_cast<std::size_t>(period) * channels;
+    inputBuffer_.assign(samples, 0.0f);
+    captureBuffer_.assign(read_ ? samples * sampleBytes_ : 0, 0);
+    return true;
+}
+
+bool AlsaAudioEngine::startStreams() {
+    snd_pcm_t* pcm = impl_->pcm;
+    int err = snd_pcm_prepare(pcm);
+    if (err >= 0 && impl_->capture && !impl_->linked) {
+        err = snd_pcm_prepare(impl_->capture);
+    }
+    if (err < 0) {
+        setLastError(AlsaError("snd_pcm_prepare", err));
+        return false;
+    }
+    if (!impl_->capture) {
+        return true;  // playback starts itself at the start threshold
+    }
+    // Duplex: the ring is primed with silence and capture started with it,
+    // so each period read comes in as one more can be written.
+    std::fill(deviceBuffer_.begin(), deviceBuffer_.end(), 0);
+    std::fill(renderBuffer_.begin(), renderBuffer_.end(), 0.0f);
+    const void* silence = convert_ ? static_cast<const void*>(deviceBuffer_.data())
+                                   : static_cast<const void*>(renderBuffer_.data());
+    for (snd_pcm_uframes_t i = 0; i < kPeriods; ++i) {
+        if ((err = static_cast<int>(snd_pcm_writei(pcm, silence, config_.bufferFrames))) < 0) {
+            setLastError(AlsaError("snd_pcm_writei", err));
+            return false;
+        }
+    }
+    if ((!impl_->linked && (err = snd_pcm_start(pcm)) < 0) ||
+        (err = snd_pcm_start(impl_->capture)) < 0) {
+        setLastError(AlsaError("snd_pcm_start", err));
+        return false;
+    }
+    return true;
+}
+
+bool AlsaAudioEngine::configurePcm() {
+    snd_pcm_t* pcm = impl_->pcm;
+    snd_pcm_hw_params_t* hw = nullptr;
+    snd_pcm_hw_params_alloca(&hw);
+    int err = snd_pcm_hw_params_any(pcm, hw);
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_access(pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    if (err < 0) {
+        setLastError(AlsaError("snd_pcm_hw_params_set_access", err));
+        return false;
+    }
+
+    const FormatChoice* chosen = nullptr;
+    for (const FormatChoice& choice : kFormats) {
+        if (snd_pcm_hw_params_set_format(pcm, hw, choice.alsa) >= 0) {
+            chosen = &choice;
+            break;
+        }
+    }
+    if (!chosen) {
+        setLastError("[ALSA] 设备不支持浮点、32 位或 16 位整数采样");
+        return false;
+    }
+
+    unsigned int channels = std::max<unsigned int>(1, config_.channels);
+    unsigned int rate = config_.sampleRate > 0 ? config_.sampleRate : 48000;
+    snd_pcm_uframes_t period = std::max<snd_pcm_uframes_t>(16, config_.bufferFrames);
+    snd_pcm_uframes_t bufferSize = period * kPeriods;
+    if ((err = snd_pcm_hw_params_set_channels_near(pcm, hw, &channels)) < 0 ||
+        (err = snd_pcm_hw_params_set_rate_near(pcm, hw, &rate, nullptr)) < 0 ||
+        (err = snd_pcm_hw_params_set_period_size_near(pcm, hw, &period, nullptr)) < 0 ||
+        (err = snd_pcm_hw_params_set_buffer_size_near(pcm, hw, &bufferSize)) < 0 ||
+        (err = snd_pcm_hw_params(pcm, hw)) < 0) {
+        setLastError(AlsaError("snd_pcm_hw_params", err));
+        return false;
+    }
+    snd_pcm_hw_params_get_period_size(hw, &period, nullptr);
+    snd_pcm_hw_params_get_buffer_size(hw, &bufferSize);
+
+    snd_pcm_sw_params_t* sw = nullptr;
+    snd_pcm_sw_params_alloca(&sw);
+    if ((err = snd_pcm_sw_params_current(pcm, sw)) < 0 ||
+        (err = snd_pcm_sw_params_set_start_threshold(pcm, sw, bufferSize - period)) < 0 ||
+        (err = snd_pcm_sw_params_set_avail_min(pcm, sw, period)) < 0 ||
+        (err = snd_pcm_sw_params(pcm, sw)) < 0) {
+        setLastError(AlsaError("snd_pcm_sw_params", err));
+        return false;
+    }
+
+    config_.sampleRate = rate;
+    config_.channels = static_cast<std::uint16_t>(channels);
+    config_.bufferFrames = static_cast<std::uint32_t>(period);
+    // A period is written once one has drained, behind the rest of the ring.
+    config_.outputLatencyFrames = static_cast<std::uint32_t>(bufferSize - period);
+    const bool bigEndian = std::endian::native == std::endian::big;
+    convert_ = chosen->format == audio::SampleFormat::Float32
+                   ? nullptr
+                   : audio::GetSampleConverter(chosen->format, bigEndian);
+    read_ = chosen->format == audio::SampleFormat::Float32
+                ? nullptr
+                : audio::GetSampleReader(chosen->format, bigEndian);
+    captureFormat_ = chosen->alsa;
+    sampleBytes_ = audio::SampleBytes(chosen->format);
+    const std::size_t samples = static_cast<std::size_t>(period) * channels;
+    renderBuffer_.assign(samples, 0.0f);
+    deviceBuffer_.assign(convert_ ? samples * sampleBytes_ : 0, 0);
+    return true;
+}
+
+void AlsaAudioEngine::shutdown() {
+    stop();
+    if (impl_ && impl_->capture) {
+        if (impl_->linked) {
+            snd_pcm_unlink(impl_->capture);
+        }
+        snd_pcm_close(impl_->capture);
+    }
+    if (impl_ && impl_->pcm) {
+        snd_pcm_close(impl_->pcm);
+    }
+    impl_.reset();
+}
+
+bool AlsaAudioEngine::start() {
+    if (!impl_) {
+        setLastError("音频设备未初始化");
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+    if (!startStreams()) {
+        return false;
+    }
+    running_ = true;
+    renderThread_ = std::make_unique<std::thread>(&AlsaAudioEngine::renderLoop, this);
+    return true;
+}
+
+void AlsaAudioEngine::stop() {
+    running_ = false;
+    if (renderThread_ && renderThread_->joinable()) {
+        renderThread_->join();
+    }
+    renderThread_.reset();
+    if (impl_ && impl_->pcm) {
+        snd_pcm_drop(impl_->pcm);
+    }
+    if (impl_ && impl_->capture && !impl_->linked) {
+        snd_pcm_drop(impl_->capture);
+    }
+}
+
+void AlsaAudioEngine::renderLoop() {
+    // Prevent denormal-induced CPU spikes in long decays (e.g. convolution IR tails).
+    const engine::ScopedDspThread dspThread("audio callback", engine::RealtimeThreadRole::Render);
+
+    snd_pcm_t* pcm = impl_->pcm;
+    const std::size_t frames = config_.bufferFrames;
+    const std::size_t channels = config_.channels;
+    RenderTiming timing;
+    timing.sampleRate = config_.sampleRate;
+    timing.channels = config_.channels;
+    snd_pcm_t* capture = impl_->capture;
+    if (capture) {
+        timing.input = inputBuffer_.data();
+        timing.inputChannels = config_.inputChannels;
+    }
+    while (running_) {
+        // Duplex: the blocking read paces the loop, a period behind the
+        // wire, and the write that follows always finds room.
+        if (capture && !readCapture()) {
+            if (!running_) {
+                break;
+            }
+            timing.discontinuity = true;
+            continue;
+        }
+        if (renderCallback_) {
+            timing.hostNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch())
+                                   .count();
+            renderCallback_(renderBuffer_.data(), frames, timing);
+        } else {
+            std::fill(renderBuffer_.begin(), renderBuffer_.end(), 0.0f);
+        }
+        timing.discontinuity = false;
+        const std::uint8_t* data = reinterpret_cast<const std::uint8_t*>(renderBuffer_.data());
+        if (convert_) {
+            convert_(renderBuffer_.data(), deviceBuffer_.data(), frames * channels);
+            data = deviceBuffer_.data();
+        }
+        std::size_t written = 0;
+        while (written < frames && running_) {
+            const snd_pcm_sframes_t n = snd_pcm_writei(
+                pcm, data + written * channels * sampleBytes_, frames - written);
+            if (n == -EAGAIN) {
+                continue;
+            }
+            if (n < 0) {
+                // Underrun (-EPIPE) or suspend (-ESTRPIPE): re-prepare and
+                // keep the same callback going.
+                const int err = snd_pcm_recover(pcm, static_cast<int>(n), 1);
+                if (err < 0) {
+                    const auto message = AlsaError("snd_pcm_writei", err);
+                    setLastError(message);
+                    LogError(message);
+                    running_ = false;
+                    break;
+                }
+                timing.discontinuity = true;
+                streamRecoveries_.fetch_add(1, std::memory_order_relaxed);
+                if (capture) {
+                    // Both streams restart together, primed again.
+                    restartDuplex();
+                    break;
+                }
+                continue;
+            }
+            written += static_cast<std::size_t>(n);
+        }
+        timing.streamFrame += frames;
+    }
+}
+
+bool AlsaAudioEngine::readCapture() {
+    snd_pcm_t* capture = impl_->capture;
+    const std::size_t frames = config_.bufferFrames;
+    const std::size_t channels = config_.inputChannels;
+    void* data = read_ ? static_cast<void*>(captureBuffer_.data())
+                       : static_cast<void*>(inputBuffer_.data());
+    std::size_t done = 0;
+    while (done < frames && running_) {
+        const snd_pcm_sframes_t n =
+            snd_pcm_readi(capture, static_cast<std::uint8_t*>(data) + done * channels * sampleBytes_,
+                          frames - done);
+        if (n == -EAGAIN) {
+            continue;
+        }
+        if (n < 0) {
+            // Overrun: the capture side fell behind the period.
+            streamRecoveries_.fetch_add(1, std::memory_order_relaxed);
+            restartDuplex();
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    if (read_) {
+        read_(captureBuffer_.data(), inputBuffer_.data(), frames * channels);
+    }
+    return done == frames;
+}
+
+void AlsaAudioEngine::restartDuplex() {
+    snd_pcm_drop(impl_->pcm);
+    if (!impl_->linked) {
+        snd_pcm_drop(impl_->capture);
+    }
+    if (!startStreams()) {
+        LogError(lastError_);
+        running_ = false;
+    }
+}
+
+std::vector<AudioDeviceInfo> AlsaAudioEngine::EnumerateOutputDevices() {
+    std::vector<AudioDeviceInfo> devices;
+    void** hints = nullptr;
+    if (snd_device_name_hint(-1, "pcm", &hints) < 0) {
+        return devices;
+    }
+    for (void** hint = hints; *hint; ++hint) {
+        char* name = snd_device_name_get_hint(*hint, "NAME");
+        char* desc = snd_device_name_get_hint(*hint, "DESC");
+        char* io = snd_device_name_get_hint(*hint, "IOID");
+        // No IOID means the PCM does both directions.
+        if (name && std::strcmp(name, "null") != 0 && (!io || std::strcmp(io, "Output") == 0)) {
+            AudioDeviceInfo info;
+            info.backend = AudioBackendType::Alsa;
+            info.id = name;
+            info.name = desc ? desc : name;
+            std::replace(info.name.begin(), info.name.end(), '\n', ' ');
+            devices.push_back(std::move(info));
+        }
+        std::free(name);
+        std::free(desc);
+        std::free(io);
+    }
+    snd_device_name_free_hint(hints);
+    return devices;
+}
+
+void AlsaAudioEngine::setLastError(const std::string& message) {
+    lastError_ = message;
+}
+
+#else
+
+struct AlsaAudioEngine::Impl {};
+
+AlsaAudioEngine::AlsaAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::Alsa;
+}
+
+AlsaAudioEngine::~AlsaAudioEngine() = default;
+
+bool AlsaAudioEngine::initialize(RenderCallback /*callback*/) {
+    setLastError("[ALSA] 此版本未包含 ALSA 支持");
+    return false;
+}
+
+void AlsaAudioEngine::shutdown() {}
+
+bool AlsaAudioEngine::start() {
+    setLastError("[ALSA] 此版本未包含 ALSA 支持");
+    return false;
+}
+
+void AlsaAudioEngine::stop() {}
+
+std::vector<AudioDeviceInfo> AlsaAudioEngine::EnumerateOutputDevices() {
+    return {};
+}
+
+void AlsaAudioEngine::setLastError(const std::string& message) {
+    lastError_ = message;
+}
+
+#endif
+
+}  // namespace posixaudio
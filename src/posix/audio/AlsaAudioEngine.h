@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio/SampleConvert.h"
+#include "posix/audio/AudioEngineTypes.h"
+
+namespace posixaudio {
+
+// ALSA playback on a render thread of its own, writing interleaved periods
+// with blocking snd_pcm_writei. Float is used where the device takes it,
+// else 32- or 16-bit integers. Underruns are counted as discontinuities and
+// recovered in place (snd_pcm_recover). With inputChannels set, a capture
+// PCM of the same rate, period and format is linked to the playback one and
+// read a period at a time ahead of each render (full duplex); a capture PCM
+// that cannot be opened leaves the engine output only. Requires
+// SATORI_HAS_ALSA.
+class AlsaAudioEngine {
+public:
+    explicit AlsaAudioEngine(AudioEngineConfig config = {});
+    ~AlsaAudioEngine();
+
+    bool initialize(RenderCallback callback);
+    void shutdown();
+
+    bool start();
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+    const AudioEngineConfig& config() const { return config_; }
+    const std::string& lastError() const { return lastError_; }
+    // Underruns and suspends the render thread recovered from.
+    std::uint64_t streamRecoveries() const {
+        return streamRecoveries_.load(std::memory_order_relaxed);
+    }
+
+    static std::vector<AudioDeviceInfo> EnumerateOutputDevices();
+
+private:
+    struct Impl;
+
+    bool configurePcm();
+    bool openCapture();
+    // Prepares the streams; in duplex also primes the ring and starts both.
+    bool startStreams();
+    void renderLoop();
+    // One period into inputBuffer_; false after an overrun.
+    bool readCapture();
+    void restartDuplex();
+    void setLastError(const std::string& message);
+
+    AudioEngineConfig config_;
+    RenderCallback renderCallback_;
+    std::string lastError_;
+    std::unique_ptr<Impl> impl_;
+    audio::SampleConvertFn convert_ = nullptr;  // null when the device takes float
+    std::size_t sampleBytes_ = sizeof(float);
+    std::vector<float> renderBuffer_;
+    std::vector<std::uint8_t> deviceBuffer_;
+    audio::SampleReadFn read_ = nullptr;  // capture in the playback's format
+    int captureFormat_ = 0;               // snd_pcm_format_t
+    std::vector<float> inputBuffer_;
+    std::vector<std::uint8_t> captureBuffer_;
+    std::unique_ptr<std::thread> renderThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<std::uint64_t> streamRecoveries_{0};
+};
+
+}  // namespace posixaudio
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace posixaudio {
+
+// Which backends exist depends on the build: JACK and ALSA when their
+// development packages were found, CoreAudio on Apple, Null everywhere.
+enum class AudioBackendType {
+    Auto,       // JACK if a server is running, else ALSA or CoreAudio.
+    Jack,
+    Alsa,
+    CoreAudio,
+    Null,       // No device: a thread paced by the clock, for tests and dry runs.
+};
+
+/// Where one render callback sits on the device's timeline.
+struct RenderTiming {
+    std::uint64_t streamFrame = 0;  // device frames handed out before this buffer
+    std::int64_t hostNanos = 0;     // steady_clock at the callback
+    std::uint32_t sampleRate = 0;   // device rate
+    std::uint16_t channels = 0;     // interleaved channels at `output`
+    // Full duplex: `frames` interleaved frames of `inputChannels` captured in
+    // the same period as `output` is played, or null while output only.
+    const float* input = nullptr;
+    std::uint16_t inputChannels = 0;
+    // The device lost or repeated audio since the previous callback (an
+    // xrun reported by the server or driver, or a stream it had to restart).
+    bool discontinuity = false;
+};
+
+/// Audio render callback, run on the device thread: the callee fills
+/// `frames` interleaved frames at `output`. A plain object and function
+/// pointer pair, so calling it never allocates or locks.
+struct RenderCallback {
+    using Fn = void (*)(void* context, float* output, std::size_t frames,
+                        const RenderTiming& timing);
+
+    Fn fn = nullptr;
+    void* context = nullptr;
+
+    // Binds a member function: RenderCallback::Member<&T::render>(object).
+    template <auto Method, typename T>
+    static RenderCallback Member(T* object) {
+        return {[](void* context, float* output, std::size_t frames, const RenderTiming& timing) {
+                    (static_cast<T*>(context)->*Method)(output, frames, timing);
+                },
+                object};
+    }
+
+    explicit operator bool() const { return fn != nullptr; }
+    void operator()(float* output, std::size_t frames, const RenderTiming& timing) const {
+        fn(context, output, frames, timing);
+    }
+};
+
+struct AudioDeviceInfo {
+    AudioBackendType backend = AudioBackendType::Auto;
+    std::string id;    // ALSA PCM name, JACK port prefix or CoreAudio device UID.
+    std::string name;  // Display name.
+};
+
+struct AudioEngineConfig {
+    AudioBackendType backend = AudioBackendType::Auto;
+    // Empty = the backend's default: ALSA "default", JACK's physical
+    // playback ports, CoreAudio's default output device.
+    std::string deviceId;
+    // Requests. JACK runs at the server's rate and period whatever is asked;
+    // config() reports what the device actually runs at.
+    std::uint32_t sampleRate = 48000;
+    std::uint16_t channels = 2;
+    std::uint32_t bufferFrames = 256;
+    // Capture channels for full duplex (RenderTiming::input), 0 for output
+    // only. config() reports what was opened: 0 where capture failed or the
+    // backend has none (CoreAudio).
+    std::uint16_t inputChannels = 0;
+    // ALSA capture PCM; empty = the same name as deviceId.
+    std::string inputDeviceId;
+    // Reported only: frames the device holds ahead of a callback's buffer,
+    // i.e. how long its first frame waits to be played.
+    std::uint32_t outputLatencyFrames = 0;
+};
+
+const char* BackendName(AudioBackendType backend);
+
+}  // namespace posixaudio
@@ -0,0 +1,328 @@
+#include "posix/audio/CoreAudioEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+#if defined(__APPLE__)
+#include <AudioToolbox/AudioToolbox.h>
+#include <CoreAudio/CoreAudio.h>
+#endif
+
+namespace posixaudio {
+
+#if defined(__APPLE__)
+
+namespace {
+// kAudioObjectPropertyElementMain, spelled so older SDKs take it too.
+constexpr AudioObjectPropertyElement kElementMain = 0;
+
+AudioObjectPropertyAddress GlobalProperty(AudioObjectPropertySelector selector) {
+    return {selector, kAudioObjectPropertyScopeGlobal, kElementMain};
+}
+
+// 0 if the device does not answer.
+UInt32 OutputProperty(AudioObjectID device, AudioObjectPropertySelector selector) {
+    const AudioObjectPropertyAddress address{selector, kAudioObjectPropertyScopeOutput,
+                                             kElementMain};
+    UInt32 value = 0;
+    UInt32 size = sizeof(value);
+    if (AudioObjectGetPropertyData(device, &address, 0, nullptr, &size, &value) != noErr) {
+        return 0;
+    }
+    return value;
+}
+
+std::string StatusError(const char* stage, OSStatus status) {
+    return std::string("[CoreAudio] ") + stage + " failed (" + std::to_string(status) + ")";
+}
+
+std::string ToUtf8(CFStringRef string) {
+    if (!string) {
+        return {};
+    }
+    const CFIndex length = CFStringGetLength(string);
+    std::string out(static_cast<std::size_t>(
+                        CFStringGetMaximumSizeForEncoding(length, kCFStringEncodingUTF8)) + 1,
+                    '\0');
+    if (!CFStringGetCString(string, out.data(), static_cast<CFIndex>(out.size()),
+                            kCFStringEncodingUTF8)) {
+        return {};
+    }
+    out.resize(std::char_traits<char>::length(out.c_str()));
+    return out;
+}
+
+// The default output device, or the one whose UID is `uid`.
+AudioDeviceID FindDevice(const std::string& uid) {
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+    if (uid.empty()) {
+        const auto address = GlobalProperty(kAudioHardwarePropertyDefaultOutputDevice);
+        AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &device);
+        return device;
+    }
+    CFStringRef cfUid = CFStringCreateWithCString(nullptr, uid.c_str(), kCFStringEncodingUTF8);
+    AudioValueTranslation translation{&cfUid, sizeof(cfUid), &device, sizeof(device)};
+    const auto address = GlobalProperty(kAudioHardwarePropertyDeviceForUID);
+    size = sizeof(translation);
+    AudioObjectGetPropertyData(kAudioObjectSystemObject, &address, 0, nullptr, &size, &translation);
+    CFRelease(cfUid);
+    return device;
+}
+}  // namespace
+
+struct CoreAudioEngine::Impl {
+    AudioComponentInstance unit = nullptr;
+    AudioDeviceID device = kAudioObjectUnknown;
+    bool listening = false;
+
+    static OSStatus Render(void* refCon, AudioUnitRenderActionFlags* /*flags*/,
+                           const AudioTimeStamp* /*timeStamp*/, UInt32 /*bus*/, UInt32 frames,
+                           AudioBufferList* data) {
+        auto* self = static_cast<CoreAudioEngine*>(refCon);
+        self->render(static_cast<float*>(data->mBuffers[0].mData), frames);
+        return noErr;
+    }
+
+    static OSStatus Overload(AudioObjectID /*object*/, UInt32 /*count*/,
+                             const AudioObjectPropertyAddress* /*addresses*/, void* client) {
+        static_cast<CoreAudioEngine*>(client)->overloadPending_.store(true,
+                                                                      std::memory_order_relaxed);
+        return noErr;
+    }
+};
+
+CoreAudioEngine::CoreAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::CoreAudio;
+}
+
+CoreAudioEngine::~CoreAudioEngine() {
+    shutdown();
+}
+
+bool CoreAudioEngine::initialize(RenderCallback callback) {
+    shutdown();
+    renderCallback_ = callback;
+    impl_ = std::make_unique<Impl>();
+    impl_->device = FindDevice(config_.deviceId);
+    if (impl_->device == kAudioObjectUnknown) {
+        setLastError("[CoreAudio] 找不到输出设备 " + config_.deviceId);
+        shutdown();
+        return false;
+    }
+
+    AudioComponentDescription desc{};
+    desc.componentType = kAudioUnitType_Output;
+    desc.componentSubType = kAudioUnitSubType_HALOutput;
+    desc.componentManufacturer = kAudioUnitManufacturer_Apple;
+    AudioComponent component = AudioComponentFindNext(nullptr, &desc);
+    OSStatus status = component ? AudioComponentInstanceNew(component, &impl_->unit) : -1;
+    if (status != noErr) {
+        setLastError(StatusError("AudioComponentInstanceNew", status));
+        shutdown();
+        return false;
+    }
+    status = AudioUnitSetProperty(impl_->unit, kAudioOutputUnitProperty_CurrentDevice,
+                                  kAudioUnitScope_Global, 0, &impl_->device,
+                                  sizeof(impl_->device));
+    if (status != noErr) {
+        setLastError(StatusError("kAudioOutputUnitProperty_CurrentDevice", status));
+        shutdown();
+        return false;
+    }
+
+    // The period is the device's; asking is best effort.
+    const auto bufferAddress = GlobalProperty(kAudioDevicePropertyBufferFrameSize);
+    UInt32 frames = std::max<std::uint32_t>(16, config_.bufferFrames);
+    AudioObjectSetPropertyData(impl_->device, &bufferAddress, 0, nullptr, sizeof(frames), &frames);
+    UInt32 size = sizeof(frames);
+    if (AudioObjectGetPropertyData(impl_->device, &bufferAddress, 0, nullptr, &size, &frames) ==
+        noErr) {
+        config_.bufferFrames = frames;
+    }
+    if (config_.sampleRate == 0) {
+        Float64 deviceRate = 0.0;
+        const auto rateAddress = GlobalProperty(kAudioDevicePropertyNominalSampleRate);
+        size = sizeof(deviceRate);
+        AudioObjectGetPropertyData(impl_->device, &rateAddress, 0, nullptr, &size, &deviceRate);
+        config_.sampleRate = deviceRate > 0.0 ? static_cast<std::uint32_t>(deviceRate) : 48000;
+    }
+    config_.channels = std::max<std::uint16_t>(1, config_.channels);
+    config_.inputChannels = 0;  // output unit only: no full duplex yet
+    // The HAL plays a buffer one IO cycle on, after its safety offset and
+    // the device's own latency.
+    config_.outputLatencyFrames = config_.bufferFrames +
+                                  OutputProperty(impl_->device, kAudioDevicePropertySafetyOffset) +
+                                  OutputProperty(impl_->device, kAudioDevicePropertyLatency);
+
+    AudioStreamBasicDescription format{};
+    format.mSampleRate = config_.sampleRate;
+    format.mFormatID = kAudioFormatLinearPCM;
+    format.mFormatFlags = kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked;
+    format.mBitsPerChannel = 32;
+    format.mChannelsPerFrame = config_.channels;
+    format.mFramesPerPacket = 1;
+    format.mBytesPerFrame = sizeof(float) * config_.channels;
+    format.mBytesPerPacket = format.mBytesPerFrame;
+    AURenderCallbackStruct renderCallback{&Impl::Render, this};
+    if ((status = AudioUnitSetProperty(impl_->unit, kAudioUnitProperty_StreamFormat,
+                                       kAudioUnitScope_Input, 0, &format, sizeof(format))) !=
+            noErr ||
+        (status = AudioUnitSetProperty(impl_->unit, kAudioUnitProperty_SetRenderCallback,
+                                       kAudioUnitScope_Input, 0, &renderCallback,
+                                       sizeof(renderCallback))) != noErr ||
+        (status = AudioUnitInitialize(impl_->unit)) != noErr) {
+        setLastError(StatusError("AudioUnit setup", status));
+        shutdown();
+        return false;
+    }
+    const auto overloadAddress = GlobalProperty(kAudioDeviceProcessorOverload);
+    impl_->listening = AudioObjectAddPropertyListener(impl_->device, &overloadAddress,
+                                                      &Impl::Overload, this) == noErr;
+    timing_ = {};
+    timing_.sampleRate = config_.sampleRate;
+    timing_.channels = config_.channels;
+    lastError_.clear();
+    return true;
+}
+
+void CoreAudioEngine::shutdown() {
+    stop();
+    if (!impl_) {
+        return;
+    }
+    if (impl_->listening) {
+        const auto overloadAddress = GlobalProperty(kAudioDeviceProcessorOverload);
+        AudioObjectRemovePropertyListener(impl_->device, &overloadAddress, &Impl::Overload, this);
+    }
+    if (impl_->unit) {
+        AudioUnitUninitialize(impl_->unit);
+        AudioComponentInstanceDispose(impl_->unit);
+    }
+    impl_.reset();
+}
+
+bool CoreAudioEngine::start() {
+    if (!impl_ || !impl_->unit) {
+        setLastError("音频设备未初始化");
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+    running_ = true;
+    const OSStatus status = AudioOutputUnitStart(impl_->unit);
+    if (status != noErr) {
+        running_ = false;
+        setLastError(StatusError("AudioOutputUnitStart", status));
+        return false;
+    }
+    return true;
+}
+
+void CoreAudioEngine::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (impl_ && impl_->unit) {
+        AudioOutputUnitStop(impl_->unit);
+    }
+}
+
+void CoreAudioEngine::render(float* output, std::uint32_t frames) {
+    if (!running_ || !renderCallback_) {
+        std::fill_n(output, static_cast<std::size_t>(frames) * config_.channels, 0.0f);
+        return;
+    }
+    timing_.hostNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    timing_.discontinuity = overloadPending_.exchange(false, std::memory_order_relaxed);
+    renderCallback_(output, frames, timing_);
+    timing_.streamFrame += frames;
+}
+
+std::vector<AudioDeviceInfo> CoreAudioEngine::EnumerateOutputDevices() {
+    std::vector<AudioDeviceInfo> devices;
+    const auto devicesAddress = GlobalProperty(kAudioHardwarePropertyDevices);
+    UInt32 size = 0;
+    if (AudioObjectGetPropertyDataSize(kAudioObjectSystemObject, &devicesAddress, 0, nullptr,
+                                       &size) != noErr) {
+        return devices;
+    }
+    std::vector<AudioDeviceID> ids(size / sizeof(AudioDeviceID));
+    if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &devicesAddress, 0, nullptr, &size,
+                                   ids.data()) != noErr) {
+        return devices;
+    }
+    for (const AudioDeviceID id : ids) {
+        const AudioObjectPropertyAddress streams{kAudioDevicePropertyStreams,
+                                                 kAudioObjectPropertyScopeOutput, kElementMain};
+        UInt32 streamBytes = 0;
+        if (AudioObjectGetPropertyDataSize(id, &streams, 0, nullptr, &streamBytes) != noErr ||
+            streamBytes == 0) {
+            continue;  // input only
+        }
+        AudioDeviceInfo info;
+        info.backend = AudioBackendType::CoreAudio;
+        CFStringRef string = nullptr;
+        UInt32 stringSize = sizeof(string);
+        const auto uidAddress = GlobalProperty(kAudioDevicePropertyDeviceUID);
+        if (AudioObjectGetPropertyData(id, &uidAddress, 0, nullptr, &stringSize, &string) ==
+            noErr) {
+            info.id = ToUtf8(string);
+            CFRelease(string);
+        }
+        const auto nameAddress = GlobalProperty(kAudioObjectPropertyName);
+        stringSize = sizeof(string);
+        if (AudioObjectGetPropertyData(id, &nameAddress, 0, nullptr, &stringSize, &string) ==
+            noErr) {
+            info.name = ToUtf8(string);
+            CFRelease(string);
+        }
+        devices.push_back(std::move(info));
+    }
+    return devices;
+}
+
+void CoreAudioEngine::setLastError(const std::string& message) {
+    lastError_ = message;
+}
+
+#else
+
+struct CoreAudioEngine::Impl {};
+
+CoreAudioEngine::CoreAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::CoreAudio;
+}
+
+CoreAudioEngine::~CoreAudioEngine() = default;
+
+bool CoreAudioEngine::initialize(RenderCallback /*callback*/) {
+    setLastError("[CoreAudio] 此版本未包含 CoreAudio 支持");
+    return false;
+}
+
+void CoreAudioEngine::shutdown() {}
+
+bool CoreAudioEngine::start() {
+    setLastError("[CoreAudio] 此版本未包含 CoreAudio 支持");
+    return false;
+}
+
+void CoreAudioEngine::stop() {}
+
+std::vector<AudioDeviceInfo> CoreAudioEngine::EnumerateOutputDevices() {
+    return {};
+}
+
+void CoreAudioEngine::setLastError(const std::string& message) {
+    lastError_ = message;
+}
+
+#endif
+
+}  // namespace posixaudio
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "posix/audio/AudioEngineTypes.h"
+
+namespace posixaudio {
+
+// CoreAudio output through an AUHAL unit fed interleaved float at the
+// requested rate, which the unit converts to the device's own format. The
+// render callback runs on the device's IO thread. Processor overloads the
+// device reports mark the next callback discontinuous. macOS only.
+class CoreAudioEngine {
+public:
+    explicit CoreAudioEngine(AudioEngineConfig config = {});
+    ~CoreAudioEngine();
+
+    bool initialize(RenderCallback callback);
+    void shutdown();
+
+    bool start();
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+    const AudioEngineConfig& config() const { return config_; }
+    const std::string& lastError() const { return lastError_; }
+    std::uint64_t streamRecoveries() const { return 0; }
+
+    static std::vector<AudioDeviceInfo> EnumerateOutputDevices();
+
+private:
+    struct Impl;
+
+    void render(float* output, std::uint32_t frames);
+    void setLastError(const std::string& message);
+
+    AudioEngineConfig config_;
+    RenderCallback renderCallback_;
+    std::string lastError_;
+    std::unique_ptr<Impl> impl_;
+    RenderTiming timing_;  // IO thread
+    std::atomic<bool> overloadPending_{false};
+    std::atomic<bool> running_{false};
+};
+
+}  // namespace posixaudio
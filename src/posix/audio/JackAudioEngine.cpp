@@ -0,0 +1,339 @@
+#include "posix/audio/JackAudioEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+#if defined(SATORI_HAS_JACK) && (SATORI_HAS_JACK != 0)
+#include <jack/jack.h>
+#endif
+
+#include "audio/SampleConvert.h"
+#include "engine/RealtimeThread.h"
+
+namespace posixaudio {
+
+#if defined(SATORI_HAS_JACK) && (SATORI_HAS_JACK != 0)
+
+struct JackAudioEngine::Impl {
+    jack_client_t* client = nullptr;
+    std::vector<jack_port_t*> ports;
+    std::vector<jack_port_t*> inputPorts;
+};
+
+namespace {
+constexpr const char* kClientName = "Satori";
+
+void LogError(const std::string& message) {
+    std::fprintf(stderr, "%s\n", message.c_str());
+}
+}  // namespace
+
+JackAudioEngine::JackAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::Jack;
+}
+
+JackAudioEngine::~JackAudioEngine() {
+    shutdown();
+}
+
+bool JackAudioEngine::initialize(RenderCallback callback) {
+    shutdown();
+    renderCallback_ = callback;
+    jack_status_t status{};
+    jack_client_t* client = jack_client_open(kClientName, JackNoStartServer, &status);
+    if (!client) {
+        setLastError("[JACK] 无法连接 JACK 服务器");
+        return false;
+    }
+    impl_ = std::make_unique<Impl>();
+    impl_->client = client;
+
+    // The server decides rate and period; the request only picks channels.
+    config_.sampleRate = jack_get_sample_rate(client);
+    config_.bufferFrames = jack_get_buffer_size(client);
+    config_.channels = std::max<std::uint16_t>(1, config_.channels);
+    interleaved_.assign(static_cast<std::size_t>(config_.bufferFrames) * config_.channels, 0.0f);
+    for (std::uint16_t ch = 0; ch < config_.channels; ++ch) {
+        const std::string name = "out_" + std::to_string(ch + 1);
+        jack_port_t* port = jack_port_register(client, name.c_str(), JACK_DEFAULT_AUDIO_TYPE,
+                                               JackPortIsOutput | JackPortIsTerminal, 0);
+        if (!port) {
+            setLastError("[JACK] 无法注册输出端口 " + name);
+            shutdown();
+            return false;
+        }
+        impl_->ports.push_back(port);
+    }
+    // Capture ports read in the same process cycle the outputs are written.
+    inputInterleaved_.assign(static_cast<std::size_t>(config_.bufferFrames) * config_.inputChannels,
+                             0.0f);
+    for (std::uint16_t ch = 0; ch < config_.inputChannels; ++ch) {
+        const std::string name = "in_" + std::to_string(ch + 1);
+        jack_port_t* port = jack_port_register(client, name.c_str(), JACK_DEFAULT_AUDIO_TYPE,
+                                               JackPortIsInput | JackPortIsTerminal, 0);
+        if (!port) {
+            setLastError("[JACK] 无法注册输入端口 " + name);
+            shutdown();
+            return false;
+        }
+        impl_->inputPorts.push_back(port);
+    }
+    jack_set_process_callback(client, &JackAudioEngine::ProcessCallback, this);
+    jack_set_buffer_size_callback(client, &JackAudioEngine::BufferSizeCallback, this);
+    jack_set_xrun_callback(client, &JackAudioEngine::XrunCallback, this);
+    jack_on_shutdown(client, &JackAudioEngine::ShutdownCallback, this);
+    readOutputLatency();
+    timing_ = {};
+    timing_.sampleRate = config_.sampleRate;
+    timing_.channels = config_.channels;
+    timing_.inputChannels = config_.inputChannels;
+    lastError_.clear();
+    return true;
+}
+
+void JackAudioEngine::shutdown() {
+    stop();
+    if (impl_ && impl_->client) {
+        jack_client_close(impl_->client);
+    }
+    impl_.reset();
+}
+
+bool JackAudioEngine::start() {
+    if (!impl_) {
+        setLastError("音频设备未初始化");
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+    // The process callback checks running_, so it is set before the first
+    // cycle can arrive.
+    running_ = true;
+    if (jack_activate(impl_->client) != 0) {
+        running_ = false;
+        setLastError("[JACK] jack_activate 失败");
+        return false;
+    }
+    connectPorts();
+    return true;
+}
+
+void JackAudioEngine::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (impl_ && impl_->client) {
+        jack_deactivate(impl_->client);
+    }
+}
+
+const char** JackAudioEngine::playbackTargets() const {
+    // deviceId names the ports to feed by prefix ("system:playback_" by
+    // default).
+    const char* pattern = config_.deviceId.empty() ? nullptr : config_.deviceId.c_str();
+    const unsigned long flags =
+        JackPortIsInput | (config_.deviceId.empty() ? JackPortIsPhysical : 0);
+    return jack_get_ports(impl_->client, pattern, JACK_DEFAULT_AUDIO_TYPE, flags);
+}
+
+void JackAudioEngine::connectPorts() {
+    // Ours go to the targets in order, wrapping if there are fewer.
+    const char** targets = playbackTargets();
+    if (!targets || !targets[0]) {
+        LogError("[JACK] no playback ports to connect to");
+        jack_free(targets);
+        return;
+    }
+    std::size_t targetCount = 0;
+    while (targets[targetCount]) {
+        ++targetCount;
+    }
+    for (std::size_t ch = 0; ch < impl_->ports.size(); ++ch) {
+        const char* target = targets[ch % targetCount];
+        if (jack_connect(impl_->client, jack_port_name(impl_->ports[ch]), target) != 0) {
+            LogError(std::string("[JACK] could not connect to ") + target);
+        }
+    }
+    jack_free(targets);
+
+    // Physical capture ports feed ours in order, when there are any.
+    if (impl_->inputPorts.empty()) {
+        return;
+    }
+    const char** sources = jack_get_ports(impl_->client, nullptr, JACK_DEFAULT_AUDIO_TYPE,
+                                          JackPortIsOutput | JackPortIsPhysical);
+    if (!sources || !sources[0]) {
+        LogError("[JACK] no capture ports to connect from");
+        jack_free(sources);
+        return;
+    }
+    for (std::size_t ch = 0; ch < impl_->inputPorts.size() && sources[ch]; ++ch) {
+        if (jack_connect(impl_->client, sources[ch], jack_port_name(impl_->inputPorts[ch])) != 0) {
+            LogError(std::string("[JACK] could not connect from ") + sources[ch]);
+        }
+    }
+    jack_free(sources);
+}
+
+void JackAudioEngine::readOutputLatency() {
+    // A playback port's range is what it adds on the way to the speakers;
+    // ours add nothing. Read before connecting, so the targets are asked.
+    jack_nframes_t latency = 0;
+    if (const char** targets = playbackTargets()) {
+        for (std::size_t i = 0; targets[i]; ++i) {
+            if (jack_port_t* port = jack_port_by_name(impl_->client, targets[i])) {
+                jack_latency_range_t range{};
+                jack_port_get_latency_range(port, JackPlaybackLatency, &range);
+                latency = std::max(latency, range.max);
+            }
+        }
+        jack_free(targets);
+    }
+    config_.outputLatencyFrames = latency;
+}
+
+int JackAudioEngine::ProcessCallback(std::uint32_t frames, void* arg) {
+    return static_cast<JackAudioEngine*>(arg)->process(frames);
+}
+
+int JackAudioEngine::BufferSizeCallback(std::uint32_t frames, void* arg) {
+    // Called while the graph is suspended, so resizing cannot race process().
+    auto* self = static_cast<JackAudioEngine*>(arg);
+    self->config_.bufferFrames = frames;
+    self->interleaved_.assign(static_cast<std::size_t>(frames) * self->config_.channels, 0.0f);
+    self->inputInterleaved_.assign(static_cast<std::size_t>(frames) * self->config_.inputChannels,
+                                   0.0f);
+    return 0;
+}
+
+int JackAudioEngine::XrunCallback(void* arg) {
+    static_cast<JackAudioEngine*>(arg)->xrunPending_.store(true, std::memory_order_relaxed);
+    return 0;
+}
+
+void JackAudioEngine::ShutdownCallback(void* arg) {
+    // The server went away; the client is dead but still has to be closed.
+    auto* self = static_cast<JackAudioEngine*>(arg);
+    self->running_ = false;
+    self->setLastError("[JACK] 服务器已关闭");
+}
+
+int JackAudioEngine::process(std::uint32_t frames) {
+    // JACK's thread is already realtime; only the FPU state and name are ours.
+    const engine::ScopedDspThread dspThread("audio callback");
+    const std::size_t channels = impl_->ports.size();
+    if (!running_ || !renderCallback_ ||
+        static_cast<std::size_t>(frames) * channels > interleaved_.size()) {
+        for (jack_port_t* port : impl_->ports) {
+            auto* out = static_cast<float*>(jack_port_get_buffer(port, frames));
+            std::fill_n(out, frames, 0.0f);
+        }
+        return 0;
+    }
+    timing_.hostNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    timing_.discontinuity = xrunPending_.exchange(false, std::memory_order_relaxed);
+    const std::size_t inputs = impl_->inputPorts.size();
+    for (std::size_t ch = 0; ch < inputs; ++ch) {
+        const auto* in =
+            static_cast<const float*>(jack_port_get_buffer(impl_->inputPorts[ch], frames));
+        audio::Interleave(in, inputs, ch, inputInterleaved_.data(), frames);
+    }
+    timing_.input = inputs > 0 ? inputInterleaved_.data() : nullptr;
+    renderCallback_(interleaved_.data(), frames, timing_);
+    for (std::size_t ch = 0; ch < channels; ++ch) {
+        auto* out = static_cast<float*>(jack_port_get_buffer(impl_->ports[ch], frames));
+        audio::Deinterleave(interleaved_.data(), channels, ch, out, frames);
+    }
+    timing_.streamFrame += frames;
+    return 0;
+}
+
+bool JackAudioEngine::ServerAvailable() {
+    jack_status_t status{};
+    jack_client_t* probe = jack_client_open("SatoriProbe", JackNoStartServer, &status);
+    if (!probe) {
+        return false;
+    }
+    jack_client_close(probe);
+    return true;
+}
+
+std::vector<AudioDeviceInfo> JackAudioEngine::EnumerateOutputDevices() {
+    std::vector<AudioDeviceInfo> devices;
+    jack_status_t status{};
+    jack_client_t* probe = jack_client_open("SatoriProbe", JackNoStartServer, &status);
+    if (!probe) {
+        return devices;
+    }
+    AudioDeviceInfo def;
+    def.backend = AudioBackendType::Jack;
+    def.name = "JACK (physical playback)";
+    devices.push_back(def);
+    // Every client's input ports, one entry per client.
+    const char** ports = jack_get_ports(probe, nullptr, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput);
+    for (std::size_t i = 0; ports && ports[i]; ++i) {
+        const std::string port = ports[i];
+        const std::string prefix = port.substr(0, port.find(':') + 1);
+        const bool seen = std::any_of(devices.begin(), devices.end(),
+                                      [&prefix](const AudioDeviceInfo& d) { return d.id == prefix; });
+        if (!seen) {
+            AudioDeviceInfo info;
+            info.backend = AudioBackendType::Jack;
+            info.id = prefix;
+            info.name = "JACK " + prefix.substr(0, prefix.size() - 1);
+            devices.push_back(std::move(info));
+        }
+    }
+    jack_free(ports);
+    jack_client_close(probe);
+    return devices;
+}
+
+void JackAudioEngine::setLastError(const std::string& message) {
+    lastError_ = message;
+}
+
+#else
+
+struct JackAudioEngine::Impl {};
+
+JackAudioEngine::JackAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::Jack;
+}
+
+JackAudioEngine::~JackAudioEngine() = default;
+
+bool JackAudioEngine::initialize(RenderCallback /*callback*/) {
+    setLastError("[JACK] 此版本未包含 JACK 支持");
+    return false;
+}
+
+void JackAudioEngine::shutdown() {}
+
+bool JackAudioEngine::start() {
+    setLastError("[JACK] 此版本未包含 JACK 支持");
+    return false;
+}
+
+void JackAudioEngine::stop() {}
+
+bool JackAudioEngine::ServerAvailable() {
+    return false;
+}
+
+std::vector<AudioDeviceInfo> JackAudioEngine::EnumerateOutputDevices() {
+    return {};
+}
+
+void JackAudioEngine::setLastError(const std::string& message) {
+    lastError_ = message;
+}
+
+#endif
+
+}  // namespace posixaudio
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "posix/audio/AudioEngineTypes.h"
+
+namespace posixaudio {
+
+// JACK client with one output port per channel, and one input port per
+// capture channel for full duplex. The render callback runs inside JACK's
+// process callback, on the server's realtime thread and at its rate and
+// period; the interleaved buffer it fills is split onto the ports, and the
+// input ports of the same cycle are interleaved for it.
+// Xruns the server reports mark the next callback discontinuous. Requires
+// SATORI_HAS_JACK.
+class JackAudioEngine {
+public:
+    explicit JackAudioEngine(AudioEngineConfig config = {});
+    ~JackAudioEngine();
+
+    bool initialize(RenderCallback callback);
+    void shutdown();
+
+    bool start();
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+    const AudioEngineConfig& config() const { return config_; }
+    const std::string& lastError() const { return lastError_; }
+    // Always 0: JACK restarts nothing on the client's behalf.
+    std::uint64_t streamRecoveries() const { return 0; }
+
+    // True if a JACK server answers (without starting one).
+    static bool ServerAvailable();
+    static std::vector<AudioDeviceInfo> EnumerateOutputDevices();
+
+private:
+    struct Impl;
+
+    static int ProcessCallback(std::uint32_t frames, void* arg);
+    static int BufferSizeCallback(std::uint32_t frames, void* arg);
+    static int XrunCallback(void* arg);
+    static void ShutdownCallback(void* arg);
+    int process(std::uint32_t frames);
+    // The ports ours feed (null-terminated, jack_free'd by the caller).
+    const char** playbackTargets() const;
+    void connectPorts();
+    // Largest playback latency among the targets, into config_.
+    void readOutputLatency();
+    void setLastError(const std::string& message);
+
+    AudioEngineConfig config_;
+    RenderCallback renderCallback_;
+    std::string lastError_;
+    std::unique_ptr<Impl> impl_;
+    std::vector<float> interleaved_;  // sized by the buffer size callback
+    std::vector<float> inputInterleaved_;
+    RenderTiming timing_;             // process thread
+    std::atomic<bool> xrunPending_{false};
+    std::atomic<bool> running_{false};
+};
+
+}  // namespace posixaudio
@@ -0,0 +1,97 @@
+#include "posix/audio/NullAudioEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <utility>
+
+#include "engine/RealtimeThread.h"
+
+namespace posixaudio {
+
+NullAudioEngine::NullAudioEngine(AudioEngineConfig config) : config_(std::move(config)) {
+    config_.backend = AudioBackendType::Null;
+}
+
+NullAudioEngine::~NullAudioEngine() {
+    shutdown();
+}
+
+bool NullAudioEngine::initialize(RenderCallback callback) {
+    shutdown();
+    if (config_.sampleRate == 0 || config_.channels == 0 || config_.bufferFrames == 0) {
+        lastError_ = "无效的音频参数";
+        return false;
+    }
+    renderCallback_ = callback;
+    config_.outputLatencyFrames = 0;  // nothing is queued behind the callback
+    buffer_.assign(static_cast<std::size_t>(config_.bufferFrames) * config_.channels, 0.0f);
+    // Full duplex with nothing plugged in: silence.
+    inputBuffer_.assign(static_cast<std::size_t>(config_.bufferFrames) * config_.inputChannels,
+                        0.0f);
+    lastError_.clear();
+    initialized_ = true;
+    return true;
+}
+
+void NullAudioEngine::shutdown() {
+    stop();
+    initialized_ = false;
+}
+
+bool NullAudioEngine::start() {
+    if (!initialized_) {
+        lastError_ = "音频设备未初始化";
+        return false;
+    }
+    if (running_) {
+        return true;
+    }
+    running_ = true;
+    renderThread_ = std::make_unique<std::thread>(&NullAudioEngine::renderLoop, this);
+    return true;
+}
+
+void NullAudioEngine::stop() {
+    running_ = false;
+    if (renderThread_ && renderThread_->joinable()) {
+        renderThread_->join();
+    }
+    renderThread_.reset();
+}
+
+void NullAudioEngine::renderLoop() {
+    const engine::ScopedDspThread dspThread("audio callback", engine::RealtimeThreadRole::Render);
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(config_.bufferFrames) /
+                                      config_.sampleRate));
+    RenderTiming timing;
+    timing.sampleRate = config_.sampleRate;
+    timing.channels = config_.channels;
+    if (config_.inputChannels > 0) {
+        timing.input = inputBuffer_.data();
+        timing.inputChannels = config_.inputChannels;
+    }
+    auto deadline = Clock::now();
+    while (running_) {
+        const auto now = Clock::now();
+        timing.hostNanos =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+        if (renderCallback_) {
+            renderCallback_(buffer_.data(), config_.bufferFrames, timing);
+        }
+        timing.streamFrame += config_.bufferFrames;
+        timing.discontinuity = false;
+        deadline += period;
+        if (Clock::now() > deadline + 4 * period) {
+            // A sleeping machine or a debugger stop: resume from now rather
+            // than firing the missed periods back to back.
+            deadline = Clock::now();
+            timing.discontinuity = true;
+        }
+        std::this_thread::sleep_until(deadline);
+    }
+}
+
+}  // namespace posixaudio
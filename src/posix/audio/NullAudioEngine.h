@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "posix/audio/AudioEngineTypes.h"
+
+namespace posixaudio {
+
+// Deviceless backend: a render thread asks for one buffer every period of
+// the steady clock and throws the audio away. Exercises the whole callback
+// path where no sound card is available (CI, headless dry runs).
+class NullAudioEngine {
+public:
+    explicit NullAudioEngine(AudioEngineConfig config = {});
+    ~NullAudioEngine();
+
+    bool initialize(RenderCallback callback);
+    void shutdown();
+
+    bool start();
+    void stop();
+
+    bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+    const AudioEngineConfig& config() const { return config_; }
+    const std::string& lastError() const { return lastError_; }
+
+private:
+    void renderLoop();
+
+    AudioEngineConfig config_;
+    RenderCallback renderCallback_;
+    std::string lastError_;
+    std::vector<float> buffer_;
+    std::vector<float> inputBuffer_;
+    std::unique_ptr<std::thread> renderThread_;
+    std::atomic<bool> running_{false};
+    bool initialized_ = false;
+};
+
+}  // namespace posixaudio
@@ -0,0 +1,322 @@
+#include "posix/audio/SatoriRealtimeEngine.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include "engine/RealtimeCheck.h"
+#include "engine/RealtimeThread.h"
+#include "engine/Tracer.h"
+
+namespace posixaudio {
+
+SatoriRealtimeEngine::SatoriRealtimeEngine(AudioEngineConfig config, std::size_t maxVoices)
+    : audioConfig_(std::move(config)),
+      synthConfig_(),
+      audioEngine_(audioConfig_),
+      synthEngine_(synthConfig_, maxVoices) {
+    // Device callbacks must never render the reverb tail inline.
+    synthEngine_.setRenderMode(engine::RenderMode::Realtime);
+    // Live playing: shape random-noise plucks ahead of the note-on.
+    synthEngine_.setExcitationPrewarm(true);
+}
+
+SatoriRealtimeEngine::~SatoriRealtimeEngine() {
+    shutdown();
+}
+
+std::int64_t SatoriRealtimeEngine::NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool SatoriRealtimeEngine::initialize() {
+    return reconfigureAudio(audioConfig_);
+}
+
+bool SatoriRealtimeEngine::reconfigureAudio(const AudioEngineConfig& config) {
+    const bool wasRunning = audioEngine_.isRunning();
+    audioEngine_.stop();
+    // The file's rate and layout are the old device's.
+    std::string ignored;
+    recorder_.stop(ignored);
+    if (!audioEngine_.reinitialize(
+            config, RenderCallback::Member<&SatoriRealtimeEngine::handleRender>(this))) {
+        return false;
+    }
+    adoptDeviceConfig();
+    if (wasRunning) {
+        (void)audioEngine_.start();
+    }
+    return true;
+}
+
+void SatoriRealtimeEngine::adoptDeviceConfig() {
+    audioConfig_ = audioEngine_.config();
+    if (audioConfig_.sampleRate > 0 &&
+        std::abs(synthConfig_.sampleRate - static_cast<double>(audioConfig_.sampleRate)) > 1e-6) {
+        synthConfig_.sampleRate = static_cast<double>(audioConfig_.sampleRate);
+        synthEngine_.setSampleRate(synthConfig_.sampleRate);
+    }
+    synthEngine_.setConfig(synthConfig_);
+    // No resampler: the synth runs at the device rate.
+    latency_ = {};
+    latency_.sampleRate = audioConfig_.sampleRate;
+    latency_.scheduleFrames = audioConfig_.bufferFrames;
+    latency_.deviceFrames = audioConfig_.outputLatencyFrames;
+    callbackPeriodMs_.store(0.0, std::memory_order_relaxed);  // the old device's
+}
+
+void SatoriRealtimeEngine::shutdown() {
+    stop();
+    audioEngine_.shutdown();
+    std::string ignored;
+    recorder_.stop(ignored);
+}
+
+bool SatoriRealtimeEngine::start() {
+    return audioEngine_.start();
+}
+
+void SatoriRealtimeEngine::stop() {
+    audioEngine_.stop();
+}
+
+void SatoriRealtimeEngine::noteOn(int midiNote, double frequency, float velocity) {
+    noteOnAt(midiNote, frequency, velocity, NowNanos());
+}
+
+void SatoriRealtimeEngine::noteOff(int midiNote) {
+    noteOffAt(midiNote, NowNanos());
+}
+
+void SatoriRealtimeEngine::noteOnAt(int midiNote, double frequency, float velocity,
+                                    std::int64_t hostNanos) {
+    const auto frame = frameClock_.frameAt(hostNanos, NowNanos());
+    if (!frame || midiNote < 0 || frequency <= 0.0) {
+        synthEngine_.noteOn(midiNote, frequency, velocity);
+        return;
+    }
+    engine::Event event;
+    event.type = engine::EventType::NoteOn;
+    event.noteId = midiNote;
+    event.velocity = velocity;
+    event.frequency = frequency;
+    (void)synthEngine_.enqueueEventAt(event, *frame);
+}
+
+void SatoriRealtimeEngine::noteOffAt(int midiNote, std::int64_t hostNanos) {
+    const auto frame = frameClock_.frameAt(hostNanos, NowNanos());
+    if (!frame || midiNote < 0) {
+        synthEngine_.noteOff(midiNote);
+        return;
+    }
+    engine::Event event;
+    event.type = engine::EventType::NoteOff;
+    event.noteId = midiNote;
+    (void)synthEngine_.enqueueEventAt(event, *frame);
+}
+
+void SatoriRealtimeEngine::setParamAt(engine::ParamId id, float value, std::int64_t hostNanos) {
+    const auto frame = frameClock_.frameAt(hostNanos, NowNanos());
+    if (!frame) {
+        synthEngine_.setParam(id, value);
+        return;
+    }
+    engine::Event event;
+    event.type = engine::EventType::ParamChange;
+    event.param = id;
+    event.paramValue = value;
+    (void)synthEngine_.enqueueEventAt(event, *frame);
+}
+
+void SatoriRealtimeEngine::setSynthConfig(const synthesis::StringConfig& config) {
+    synthConfig_ = config;
+    if (audioConfig_.sampleRate > 0) {
+        synthConfig_.sampleRate = static_cast<double>(audioConfig_.sampleRate);
+    }
+    // Both hand over snapshots the callback picks up, so the stream (and
+    // JACK's port connections) stay up.
+    synthEngine_.setSampleRate(synthConfig_.sampleRate);
+    synthEngine_.setConfig(synthConfig_);
+}
+
+void SatoriRealtimeEngine::loadPreset(const engine::Preset& preset) {
+    synthEngine_.loadPreset(preset);
+    synthConfig_ = synthEngine_.stringConfig();
+}
+
+SatoriRealtimeEngine::RealtimeMetrics SatoriRealtimeEngine::metrics() const {
+    RealtimeMetrics m;
+    m.callbackCount = callbackCount_.load(std::memory_order_relaxed);
+    m.callbackMsAvg = callbackMsAvg_.load(std::memory_order_relaxed);
+    m.callbackMsMax = callbackMsMax_.load(std::memory_order_relaxed);
+    m.callbackPeriodMs = callbackPeriodMs_.load(std::memory_order_relaxed);
+    m.dspLoad = m.callbackPeriodMs > 0.0 ? m.callbackMsAvg / m.callbackPeriodMs : 0.0;
+    m.deviceXruns = deviceXruns_.load(std::memory_order_relaxed);
+    m.streamRecoveries = audioEngine_.streamRecoveries();
+    m.roomDelayFrames = synthEngine_.roomOutputDelayFrames();
+    m.roomLateBlocks = synthEngine_.roomLateBlocks();
+    m.room = synthEngine_.roomTelemetry();
+    m.qualityLevel = governor_.level();
+    m.voiceLimit = synthEngine_.voiceLimit();
+    m.activeVoices = synthEngine_.activeVoiceCount();
+    const double synthRate = synthConfig_.sampleRate;
+    m.roomLatencyMs =
+        synthRate > 0.0 ? static_cast<double>(m.roomDelayFrames) * 1000.0 / synthRate : 0.0;
+    m.latency = outputLatency();
+    m.recording = recorder_.isRecording();
+    const std::uint32_t recordRate = recorder_.sampleRate();
+    m.recordedSeconds = recordRate > 0 ? static_cast<double>(recorder_.framesWritten()) /
+                                             static_cast<double>(recordRate)
+                                       : 0.0;
+    m.recordOverruns = recorder_.overruns();
+    m.memory = engine::ReadMemoryUsage();
+
+    const auto window = callbackHistogram_.snapshot().since(metricsBaseline_);
+    m.windowCallbacks = window.callbacks;
+    m.windowOverruns = window.overruns;
+    m.windowMsP50 = window.percentileUs(0.50) / 1000.0;
+    m.windowMsP95 = window.percentileUs(0.95) / 1000.0;
+    m.windowMsP99 = window.percentileUs(0.99) / 1000.0;
+    m.windowMsP999 = window.percentileUs(0.999) / 1000.0;
+    m.windowMsMax = window.maxUs() / 1000.0;
+    m.stages = synthEngine_.stageProfile();
+    return m;
+}
+
+engine::OutputLatency SatoriRealtimeEngine::outputLatency() const {
+    engine::OutputLatency latency = latency_;
+    // JACK and CoreAudio may call back with other than the configured period.
+    const double periodMs = callbackPeriodMs_.load(std::memory_order_relaxed);
+    if (periodMs > 0.0 && latency.sampleRate > 0) {
+        latency.scheduleFrames =
+            static_cast<std::size_t>(std::llround(periodMs * latency.sampleRate / 1000.0));
+    }
+    return latency;
+}
+
+void SatoriRealtimeEngine::resetMetricsWindow() {
+    metricsBaseline_ = callbackHistogram_.snapshot();
+}
+
+bool SatoriRealtimeEngine::startRecording(const std::filesystem::path& path,
+                                          audio::SampleFormat format,
+                                          std::string& errorMessage) {
+    audio::WaveFormat wave;
+    wave.sampleRate = audioConfig_.sampleRate;
+    wave.sampleFormat = format;
+    wave.channels = audioConfig_.channels;
+    return recorder_.start(path, wave, errorMessage);
+}
+
+bool SatoriRealtimeEngine::playMidiFile(const std::filesystem::path& path,
+                                        std::string& errorMessage) {
+    stopMidiFile();
+    if (!midiPlayer_.open(path, errorMessage)) {
+        return false;
+    }
+    // Time zero one lookahead out, so the first events are not already late.
+    midiPlayer_.start(synthEngine_.renderedFrames() + midiLookaheadFrames(),
+                      synthConfig_.sampleRate);
+    pumpMidiFile();
+    return true;
+}
+
+bool SatoriRealtimeEngine::pumpMidiFile() {
+    if (midiPlayer_.finished()) {
+        return false;
+    }
+    midiPlayer_.schedule(synthEngine_, synthEngine_.renderedFrames() + 2 * midiLookaheadFrames());
+    return !midiPlayer_.finished();
+}
+
+void SatoriRealtimeEngine::stopMidiFile() {
+    if (midiPlayer_.isOpen()) {
+        midiPlayer_.stop(synthEngine_, synthEngine_.renderedFrames());
+    }
+}
+
+std::uint64_t SatoriRealtimeEngine::midiLookaheadFrames() const {
+    return static_cast<std::uint64_t>(
+        std::ceil(engine::MidiFilePlayer::kDefaultLookaheadSeconds * synthConfig_.sampleRate));
+}
+
+void SatoriRealtimeEngine::handleRender(float* output, std::size_t frames,
+                                        const RenderTiming& timing) {
+    const engine::RealtimeScope realtime;
+    // JACK's and CoreAudio's threads belong to them (CoreAudio's with
+    // denormals left on), so it is set up here.
+    const engine::ScopedDspThread dspThread("audio callback");
+    const engine::TraceZone zone("handleRender");
+    const auto start = std::chrono::steady_clock::now();
+    if (timing.discontinuity) {
+        deviceXruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::size_t channels =
+        static_cast<std::size_t>(timing.channels > 0 ? timing.channels : audioConfig_.channels);
+    const double rate = static_cast<double>(timing.sampleRate > 0 ? timing.sampleRate
+                                                                  : audioConfig_.sampleRate);
+
+    // Anchor timestamped input to this block: events stamped during it play
+    // one block later, at their own offset.
+    if (rate > 0.0) {
+        frameClock_.publish(timing.hostNanos > 0 ? timing.hostNanos : NowNanos(),
+                            synthEngine_.renderedFrames(), rate * 1e-9,
+                            static_cast<std::uint64_t>(frames));
+    }
+
+    engine::ProcessBlock block{output, frames, static_cast<std::uint16_t>(channels)};
+    block.input = timing.input;
+    block.inputChannels = timing.inputChannels;
+    synthEngine_.process(block);
+    scopeTap_.publish(output, frames, channels);
+    recorder_.push(output, frames, channels);
+
+    const double elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count();
+    const std::uint64_t count = callbackCount_.fetch_add(1, std::memory_order_relaxed) + 1;
+    const double prevAvg = callbackMsAvg_.load(std::memory_order_relaxed);
+    const double avg = (count <= 1 || prevAvg <= 0.0) ? elapsedMs : (prevAvg * 0.99 + elapsedMs * 0.01);
+    callbackMsAvg_.store(avg, std::memory_order_relaxed);
+    if (elapsedMs > callbackMsMax_.load(std::memory_order_relaxed)) {
+        callbackMsMax_.store(elapsedMs, std::memory_order_relaxed);
+    }
+
+    const double periodUs = rate > 0.0 ? static_cast<double>(frames) * 1e6 / rate : 0.0;
+    callbackPeriodMs_.store(periodUs / 1000.0, std::memory_order_relaxed);
+    callbackHistogram_.record(elapsedMs * 1000.0, periodUs);
+    const int level = governor_.record(elapsedMs * 1000.0, periodUs);
+    if (level != appliedQualityLevel_) {
+        applyQualityLevel(level);
+    }
+}
+
+void SatoriRealtimeEngine::applyQualityLevel(int level) {
+    // Same ladder as the Windows engine: the room tail first, then voices.
+    static constexpr std::array<engine::RoomQuality, engine::QualityGovernor::kMaxLevel + 1>
+        kRoomQuality = {engine::RoomQuality::Full, engine::RoomQuality::Medium,
+                        engine::RoomQuality::Low, engine::RoomQuality::Low};
+    static constexpr std::array<double, engine::QualityGovernor::kMaxLevel + 1> kVoiceShare = {
+        1.0, 1.0, 0.5, 0.25};
+    static constexpr std::size_t kMinVoices = 4;
+    level = std::clamp(level, 0, engine::QualityGovernor::kMaxLevel);
+    const auto index = static_cast<std::size_t>(level);
+    synthEngine_.setRoomQuality(kRoomQuality[index]);
+    // Voices are shed by what they cost to render rather than by count, so
+    // a share of cheap notes still sounds more of them; at full share there
+    // is no budget at all.
+    const double share = static_cast<double>(synthEngine_.maxVoices()) * kVoiceShare[index];
+    synthEngine_.setVoiceBudget(
+        kVoiceShare[index] >= 1.0
+            ? 0.0f
+            : static_cast<float>(std::max(static_cast<double>(kMinVoices), share)));
+    appliedQualityLevel_ = level;
+}
+
+}  // namespace posixaudio
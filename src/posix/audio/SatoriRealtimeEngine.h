@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "audio/SampleConvert.h"
+#include "engine/HostFrameClock.h"
+#include "engine/LatencyHistogram.h"
+#include "engine/MidiFilePlayer.h"
+#include "engine/OutputRecorder.h"
+#include "engine/QualityGovernor.h"
+#include "engine/RealtimeMetrics.h"
+#include "engine/ScopeTap.h"
+#include "engine/StringSynthEngine.h"
+#include "posix/audio/AudioEngineTypes.h"
+#include "posix/audio/UnifiedAudioEngine.h"
+
+namespace posixaudio {
+
+// StringSynthEngine on a JACK, ALSA or CoreAudio device, with the same
+// metrics, recorder, scope and MIDI file playback as the Windows engine.
+// The synth always runs at the device rate: JACK dictates it, and ALSA's
+// and CoreAudio's own converters sit behind any rate that was refused, so
+// there is no resampler here.
+class SatoriRealtimeEngine {
+public:
+    using RealtimeMetrics = engine::RealtimeMetrics;
+
+    explicit SatoriRealtimeEngine(
+        AudioEngineConfig config = {},
+        std::size_t maxVoices = engine::StringSynthEngine::kDefaultMaxVoices);
+    ~SatoriRealtimeEngine();
+
+    bool initialize();
+    void shutdown();
+
+    bool start();
+    void stop();
+    // Stops and reopens the device; the synth keeps its voices and room.
+    bool reconfigureAudio(const AudioEngineConfig& config);
+
+    // Stamped with the current steady_clock time (see noteOnAt).
+    void noteOn(int midiNote, double frequency, float velocity = 1.0f);
+    void noteOff(int midiNote);
+    // Timestamped input: `hostNanos` is a steady_clock time (NowNanos()).
+    // The note lands at that offset into the block after the one it arrived
+    // in; a time still ahead is scheduled that far ahead. Before the first
+    // callback the engine's current frame is used. Any thread.
+    void noteOnAt(int midiNote, double frequency, float velocity, std::int64_t hostNanos);
+    void noteOffAt(int midiNote, std::int64_t hostNanos);
+    // Any thread: the synth queues parameter changes itself.
+    void setParam(engine::ParamId id, float value) { synthEngine_.setParam(id, value); }
+    void setParamAt(engine::ParamId id, float value, std::int64_t hostNanos);
+    float getParam(engine::ParamId id) const { return synthEngine_.getParam(id); }
+    // The config's sample rate is replaced by the device's.
+    void setSynthConfig(const synthesis::StringConfig& config);
+    // Patch change while playing (see StringSynthEngine::loadPreset): built
+    // on this thread, crossfaded in by the callback.
+    void loadPreset(const engine::Preset& preset);
+    const synthesis::StringConfig& synthConfig() const { return synthConfig_; }
+    const AudioEngineConfig& audioConfig() const { return audioConfig_; }
+    const std::string& lastError() const { return audioEngine_.lastError(); }
+
+    // metrics() and resetMetricsWindow() belong to one (control) thread;
+    // neither blocks the audio callback.
+    RealtimeMetrics metrics() const;
+    // End-to-end output latency (also in metrics()): set from the device on
+    // every (re)configuration, with the schedule share following the last
+    // callback's length once the stream runs.
+    engine::OutputLatency outputLatency() const;
+    void resetMetricsWindow();
+    bool readScope(float* out, std::size_t count) const {
+        return scopeTap_.readLatest(out, count);
+    }
+    double scopeSampleRate() const {
+        return static_cast<double>(audioConfig_.sampleRate) / engine::ScopeTap::kDecimation;
+    }
+    // Records what the device plays to a WAV file at the device rate.
+    bool startRecording(const std::filesystem::path& path, audio::SampleFormat format,
+                        std::string& errorMessage);
+    bool stopRecording(std::string& errorMessage) { return recorder_.stop(errorMessage); }
+    bool isRecording() const { return recorder_.isRecording(); }
+    // MIDI file playback, all on one (control) thread; pumpMidiFile() has to
+    // run every few tens of milliseconds and returns false once everything
+    // is queued.
+    bool playMidiFile(const std::filesystem::path& path, std::string& errorMessage);
+    bool pumpMidiFile();
+    void stopMidiFile();
+    bool midiFilePlaying() const { return !midiPlayer_.finished(); }
+
+    static std::int64_t NowNanos();
+
+private:
+    void handleRender(float* output, std::size_t frames, const RenderTiming& timing);
+    // Rate and config from the device just opened.
+    void adoptDeviceConfig();
+    std::uint64_t midiLookaheadFrames() const;
+    // Audio thread: maps the governor's level onto room quality and polyphony.
+    void applyQualityLevel(int level);
+
+    AudioEngineConfig audioConfig_;
+    synthesis::StringConfig synthConfig_;
+    engine::OutputLatency latency_;  // control thread, from adoptDeviceConfig()
+
+    UnifiedAudioEngine audioEngine_;
+    engine::StringSynthEngine synthEngine_;
+
+    std::atomic<std::uint64_t> callbackCount_{0};
+    std::atomic<double> callbackMsMax_{0.0};
+    std::atomic<double> callbackMsAvg_{0.0};
+    std::atomic<double> callbackPeriodMs_{0.0};
+    std::atomic<std::uint64_t> deviceXruns_{0};
+    engine::LatencyHistogram callbackHistogram_;
+    engine::LatencyHistogram::Snapshot metricsBaseline_;
+    engine::ScopeTap scopeTap_;
+    engine::OutputRecorder recorder_;
+    engine::MidiFilePlayer midiPlayer_;
+    engine::HostFrameClock frameClock_;  // steady_clock ns -> synth frames, per callback
+    engine::QualityGovernor governor_;
+    int appliedQualityLevel_ = 0;  // audio thread
+};
+
+}  // namespace posixaudio
@@ -0,0 +1,179 @@
+#include "posix/audio/UnifiedAudioEngine.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace posixaudio {
+
+const char* BackendName(AudioBackendType backend) {
+    switch (backend) {
+        case AudioBackendType::Auto:
+            return "auto";
+        case AudioBackendType::Jack:
+            return "jack";
+        case AudioBackendType::Alsa:
+            return "alsa";
+        case AudioBackendType::CoreAudio:
+            return "coreaudio";
+        case AudioBackendType::Null:
+            return "null";
+    }
+    return "unknown";
+}
+
+UnifiedAudioEngine::UnifiedAudioEngine(AudioEngineConfig config) : requested_(std::move(config)) {
+    backend_ = requested_.backend;
+}
+
+UnifiedAudioEngine::~UnifiedAudioEngine() {
+    shutdown();
+}
+
+bool UnifiedAudioEngine::initialize(RenderCallback callback) {
+    return reinitialize(requested_, callback);
+}
+
+bool UnifiedAudioEngine::reinitialize(AudioEngineConfig config, RenderCallback callback) {
+    shutdown();
+    jack_.reset();
+    alsa_.reset();
+    coreAudio_.reset();
+    null_.reset();
+    lastError_.clear();
+    requested_ = config;
+    backend_ = ResolveBackend(config.backend);
+    config.backend = backend_;
+    if (!BackendAvailable(backend_)) {
+        lastError_ = backend_ == AudioBackendType::Auto
+                         ? std::string("此版本没有可用的音频后端")
+                         : std::string("此版本未包含音频后端: ") + BackendName(backend_);
+        return false;
+    }
+    switch (backend_) {
+        case AudioBackendType::Jack:
+            jack_ = std::make_unique<JackAudioEngine>(std::move(config));
+            return jack_->initialize(callback);
+        case AudioBackendType::Alsa:
+            alsa_ = std::make_unique<AlsaAudioEngine>(std::move(config));
+            return alsa_->initialize(callback);
+        case AudioBackendType::CoreAudio:
+            coreAudio_ = std::make_unique<CoreAudioEngine>(std::move(config));
+            return coreAudio_->initialize(callback);
+        default:
+            null_ = std::make_unique<NullAudioEngine>(std::move(config));
+            return null_->initialize(callback);
+    }
+}
+
+void UnifiedAudioEngine::shutdown() {
+    if (jack_) jack_->shutdown();
+    if (alsa_) alsa_->shutdown();
+    if (coreAudio_) coreAudio_->shutdown();
+    if (null_) null_->shutdown();
+}
+
+bool UnifiedAudioEngine::start() {
+    switch (backend_) {
+        case AudioBackendType::Jack:
+            return jack_ ? jack_->start() : false;
+        case AudioBackendType::Alsa:
+            return alsa_ ? alsa_->start() : false;
+        case AudioBackendType::CoreAudio:
+            return coreAudio_ ? coreAudio_->start() : false;
+        default:
+            return null_ ? null_->start() : false;
+    }
+}
+
+void UnifiedAudioEngine::stop() {
+    if (jack_) jack_->stop();
+    if (alsa_) alsa_->stop();
+    if (coreAudio_) coreAudio_->stop();
+    if (null_) null_->stop();
+}
+
+bool UnifiedAudioEngine::isRunning() const {
+    if (jack_) return jack_->isRunning();
+    if (alsa_) return alsa_->isRunning();
+    if (coreAudio_) return coreAudio_->isRunning();
+    return null_ ? null_->isRunning() : false;
+}
+
+const AudioEngineConfig& UnifiedAudioEngine::config() const {
+    if (jack_) return jack_->config();
+    if (alsa_) return alsa_->config();
+    if (coreAudio_) return coreAudio_->config();
+    if (null_) return null_->config();
+    return requested_;
+}
+
+const std::string& UnifiedAudioEngine::lastError() const {
+    if (!lastError_.empty()) return lastError_;
+    if (jack_) return jack_->lastError();
+    if (alsa_) return alsa_->lastError();
+    if (coreAudio_) return coreAudio_->lastError();
+    if (null_) return null_->lastError();
+    return lastError_;
+}
+
+std::uint64_t UnifiedAudioEngine::streamRecoveries() const {
+    return alsa_ ? alsa_->streamRecoveries() : 0;
+}
+
+bool UnifiedAudioEngine::BackendAvailable(AudioBackendType backend) {
+    switch (backend) {
+        case AudioBackendType::Jack:
+            return SATORI_HAS_JACK != 0;
+        case AudioBackendType::Alsa:
+            return SATORI_HAS_ALSA != 0;
+        case AudioBackendType::CoreAudio:
+#if defined(__APPLE__)
+            return true;
+#else
+            return false;
+#endif
+        case AudioBackendType::Null:
+            return true;
+        case AudioBackendType::Auto:
+            return false;
+    }
+    return false;
+}
+
+AudioBackendType UnifiedAudioEngine::ResolveBackend(AudioBackendType requested) {
+    if (requested != AudioBackendType::Auto) {
+        return requested;
+    }
+    // A running JACK server owns the card; going around it through ALSA
+    // would find the device busy.
+    if (BackendAvailable(AudioBackendType::Jack) && JackAudioEngine::ServerAvailable()) {
+        return AudioBackendType::Jack;
+    }
+    if (BackendAvailable(AudioBackendType::CoreAudio)) {
+        return AudioBackendType::CoreAudio;
+    }
+    if (BackendAvailable(AudioBackendType::Alsa)) {
+        return AudioBackendType::Alsa;
+    }
+    // Never silently the null device: that has to be asked for.
+    return AudioBackendType::Auto;
+}
+
+std::vector<AudioDeviceInfo> UnifiedAudioEngine::EnumerateDevices() {
+    std::vector<AudioDeviceInfo> devices;
+    auto append = [&devices](std::vector<AudioDeviceInfo> more) {
+        devices.insert(devices.end(), std::make_move_iterator(more.begin()),
+                       std::make_move_iterator(more.end()));
+    };
+    append(JackAudioEngine::EnumerateOutputDevices());
+    append(AlsaAudioEngine::EnumerateOutputDevices());
+    append(CoreAudioEngine::EnumerateOutputDevices());
+    AudioDeviceInfo null;
+    null.backend = AudioBackendType::Null;
+    null.name = "Null (no output)";
+    devices.push_back(std::move(null));
+    return devices;
+}
+
+}  // namespace posixaudio
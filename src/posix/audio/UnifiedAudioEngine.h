@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "posix/audio/AlsaAudioEngine.h"
+#include "posix/audio/AudioEngineTypes.h"
+#include "posix/audio/CoreAudioEngine.h"
+#include "posix/audio/JackAudioEngine.h"
+#include "posix/audio/NullAudioEngine.h"
+
+namespace posixaudio {
+
+// Unified backend selector for JACK, ALSA, CoreAudio and the null device.
+// Backends left out of the build fail initialize() with an error naming them.
+class UnifiedAudioEngine {
+public:
+    explicit UnifiedAudioEngine(AudioEngineConfig config = {});
+    ~UnifiedAudioEngine();
+
+    bool initialize(RenderCallback callback);
+    bool reinitialize(AudioEngineConfig config, RenderCallback callback);
+    void shutdown();
+
+    bool start();
+    void stop();
+
+    bool isRunning() const;
+    const AudioEngineConfig& config() const;
+    const std::string& lastError() const;
+    // Streams the backend restarted on its own after an underrun (ALSA).
+    std::uint64_t streamRecoveries() const;
+
+    // Backends compiled into this build.
+    static bool BackendAvailable(AudioBackendType backend);
+    static std::vector<AudioDeviceInfo> EnumerateDevices();
+
+private:
+    // Auto resolves here, once per (re)initialize.
+    static AudioBackendType ResolveBackend(AudioBackendType requested);
+
+    AudioEngineConfig requested_;
+    AudioBackendType backend_ = AudioBackendType::Null;
+    std::unique_ptr<JackAudioEngine> jack_;
+    std::unique_ptr<AlsaAudioEngine> alsa_;
+    std::unique_ptr<CoreAudioEngine> coreAudio_;
+    std::unique_ptr<NullAudioEngine> null_;
+    std::string lastError_;  // selector's own errors (backend not built)
+};
+
+}  // namespace posixaudio
@@ -0,0 +1,160 @@
+#include "posix/net/OscServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace posixnet {
+
+namespace {
+constexpr int kPollTimeoutMs = 100;  // how soon stop() is noticed
+constexpr std::size_t kMaxDatagram = 65536;
+}  // namespace
+
+OscServer::OscServer(posixaudio::SatoriRealtimeEngine& engine) : engine_(engine) {}
+
+OscServer::~OscServer() {
+    stop();
+}
+
+bool OscServer::start(const OscServerConfig& config) {
+    stop();
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config.port);
+    if (inet_pton(AF_INET, config.bindAddress.c_str(), &address.sin_addr) != 1) {
+        lastError_ = "无效的监听地址: " + config.bindAddress;
+        return false;
+    }
+    socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_ < 0) {
+        lastError_ = std::string("无法创建 UDP 套接字: ") + std::strerror(errno);
+        return false;
+    }
+    const int reuse = 1;
+    (void)::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (::bind(socket_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        lastError_ = "无法监听 UDP 端口 " + std::to_string(config.port) + ": " +
+                     std::strerror(errno);
+        ::close(socket_);
+        socket_ = -1;
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    if (::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+        port_ = ntohs(address.sin_port);
+    } else {
+        port_ = config.port;
+    }
+    lastError_.clear();
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&OscServer::receiveLoop, this);
+    return true;
+}
+
+void OscServer::stop() {
+    running_ = false;
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+    thread_.reset();
+    if (socket_ >= 0) {
+        ::close(socket_);
+        socket_ = -1;
+    }
+    const std::int64_t now = posixaudio::SatoriRealtimeEngine::NowNanos();
+    for (std::size_t note = 0; note < heldNotes_.size(); ++note) {
+        if (heldNotes_.test(note)) {
+            engine_.noteOffAt(static_cast<int>(note), now);
+        }
+    }
+    heldNotes_.reset();
+}
+
+void OscServer::receiveLoop() {
+    std::vector<std::uint8_t> buffer(kMaxDatagram);
+    pollfd fd{};
+    fd.fd = socket_;
+    fd.events = POLLIN;
+    while (running_) {
+        const int ready = ::poll(&fd, 1, kPollTimeoutMs);
+        if (ready <= 0 || !(fd.revents & POLLIN)) {
+            continue;
+        }
+        const ssize_t received = ::recv(socket_, buffer.data(), buffer.size(), 0);
+        // Stamped before decoding, so parsing time does not shift the note.
+        const std::int64_t arrival = posixaudio::SatoriRealtimeEngine::NowNanos();
+        if (received <= 0) {
+            continue;
+        }
+        handlePacket(buffer.data(), static_cast<std::size_t>(received), arrival);
+    }
+}
+
+void OscServer::handlePacket(const std::uint8_t* data, std::size_t size,
+                             std::int64_t arrivalNanos) {
+    packets_.fetch_add(1, std::memory_order_relaxed);
+    std::vector<audio::OscMessage> messages;
+    std::string errorMessage;
+    if (!audio::ParseOscPacket(data, size, messages, errorMessage)) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (const auto& message : messages) {
+        engine::OscCommand command;
+        if (!engine::DecodeOscCommand(message, command, errorMessage)) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        messages_.fetch_add(1, std::memory_order_relaxed);
+        apply(command, playbackTime(message.timeTag, arrivalNanos));
+    }
+}
+
+void OscServer::apply(const engine::OscCommand& command, std::int64_t hostNanos) {
+    using Kind = engine::OscCommand::Kind;
+    switch (command.kind) {
+    case Kind::NoteOn:
+        engine_.noteOnAt(command.note, command.frequency, command.velocity, hostNanos);
+        heldNotes_.set(static_cast<std::size_t>(command.note));
+        break;
+    case Kind::NoteOff:
+        engine_.noteOffAt(command.note, hostNanos);
+        heldNotes_.reset(static_cast<std::size_t>(command.note));
+        break;
+    case Kind::Param:
+        engine_.setParamAt(command.param, command.value, hostNanos);
+        break;
+    case Kind::Panic:
+        for (std::size_t note = 0; note < heldNotes_.size(); ++note) {
+            if (heldNotes_.test(note)) {
+                engine_.noteOffAt(static_cast<int>(note), hostNanos);
+            }
+        }
+        heldNotes_.reset();
+        break;
+    }
+}
+
+std::int64_t OscServer::playbackTime(std::uint64_t timeTag, std::int64_t arrivalNanos) const {
+    if (timeTag <= audio::kOscImmediately) {
+        return arrivalNanos;
+    }
+    // Time tags are wall-clock time; the engine schedules on steady_clock.
+    const std::int64_t wallNow = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count();
+    const std::int64_t ahead = audio::OscTimeTagToUnixNanos(timeTag) - wallNow;
+    if (ahead <= 0 || static_cast<double>(ahead) > kMaxAheadSeconds * 1e9) {
+        return arrivalNanos;
+    }
+    return posixaudio::SatoriRealtimeEngine::NowNanos() + ahead;
+}
+
+}  // namespace posixnet
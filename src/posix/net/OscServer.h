@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "engine/OscControl.h"
+#include "posix/audio/SatoriRealtimeEngine.h"
+
+namespace posixnet {
+
+struct OscServerConfig {
+    std::string bindAddress = "0.0.0.0";
+    std::uint16_t port = 9000;
+};
+
+// Receives OSC over UDP on its own thread and plays it on a
+// SatoriRealtimeEngine. Packets are stamped as they arrive and go through the
+// engine's timestamped entry points, which push into the synth's lock-free
+// event queue: a message sent on its own plays one block after it arrived,
+// a bundle at its time tag (if that is still ahead and no more than
+// kMaxAheadSeconds out). See engine::OscCommand for the address space.
+class OscServer {
+public:
+    static constexpr double kMaxAheadSeconds = 10.0;
+
+    explicit OscServer(posixaudio::SatoriRealtimeEngine& engine);
+    ~OscServer();
+
+    OscServer(const OscServer&) = delete;
+    OscServer& operator=(const OscServer&) = delete;
+
+    bool start(const OscServerConfig& config);
+    // Releases the notes OSC still holds.
+    void stop();
+    bool isRunning() const { return thread_ != nullptr; }
+    const std::string& lastError() const { return lastError_; }
+    // The port actually bound (differs from the config's when that was 0).
+    std::uint16_t port() const { return port_; }
+
+    std::uint64_t packetCount() const { return packets_.load(std::memory_order_relaxed); }
+    std::uint64_t messageCount() const { return messages_.load(std::memory_order_relaxed); }
+    std::uint64_t rejectedCount() const { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+    void receiveLoop();
+    void handlePacket(const std::uint8_t* data, std::size_t size, std::int64_t arrivalNanos);
+    void apply(const engine::OscCommand& command, std::int64_t hostNanos);
+    // Steady_clock time for a bundle's time tag, or `arrivalNanos`.
+    std::int64_t playbackTime(std::uint64_t timeTag, std::int64_t arrivalNanos) const;
+
+    posixaudio::SatoriRealtimeEngine& engine_;
+    int socket_ = -1;
+    std::uint16_t port_ = 0;
+    std::atomic<bool> running_{false};
+    std::unique_ptr<std::thread> thread_;
+    std::string lastError_;
+    std::bitset<128> heldNotes_;  // network thread, then stop()
+    std::atomic<std::uint64_t> packets_{0};
+    std::atomic<std::uint64_t> messages_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+};
+
+}  // namespace posixnet
@@ -0,0 +1,147 @@
+#include "synthesis/ExcitationPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <random>
+
+#include "engine/RealtimeThread.h"
+
+namespace synthesis {
+
+namespace {
+
+inline std::size_t Mix(std::size_t hash, std::uint64_t value) {
+    hash ^= static_cast<std::size_t>(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+}  // namespace
+
+ExcitationPool::ExcitationPool(unsigned int seed) : seed_(seed) {
+    if (seed_ == 0) {
+        std::random_device rd;
+        seed_ = rd();
+    }
+    thread_ = std::thread(&ExcitationPool::workerLoop, this);
+}
+
+ExcitationPool::~ExcitationPool() {
+    quit_.store(true, std::memory_order_release);
+    requests_.fetch_add(1, std::memory_order_release);
+    requests_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+float ExcitationPool::SnapVelocity(float velocity) {
+    constexpr float kSteps = static_cast<float>(kVelocityBuckets - 1);
+    return std::round(std::clamp(velocity, 0.0f, 1.0f) * kSteps) / kSteps;
+}
+
+std::size_t ExcitationPool::Hash(const ExcitationShape& shape) {
+    std::size_t hash = std::hash<std::size_t>{}(shape.length);
+    hash = Mix(hash, std::bit_cast<std::uint64_t>(shape.sampleRate));
+    hash = Mix(hash, (static_cast<std::uint64_t>(shape.type) << 8) |
+                         static_cast<std::uint64_t>(shape.noiseType));
+    hash = Mix(hash, std::bit_cast<std::uint32_t>(shape.mix));
+    hash = Mix(hash, std::bit_cast<std::uint32_t>(shape.pickPosition));
+    hash = Mix(hash, std::bit_cast<std::uint32_t>(shape.color));
+    return hash;
+}
+
+void ExcitationPool::request(Slot& slot, const ExcitationShape& shape) {
+    slot.shape = shape;
+    slot.state.store(SlotState::Requested, std::memory_order_release);
+    requests_.fetch_add(1, std::memory_order_release);
+    requests_.notify_one();
+}
+
+bool ExcitationPool::take(const ExcitationShape& shape, float* out) {
+    if (!out || shape.length == 0) {
+        return false;
+    }
+    const std::size_t first = Hash(shape);
+    Slot* victim = nullptr;
+    for (std::size_t probe = 0; probe < kProbeCount; ++probe) {
+        Slot& slot = slots_[(first + probe) % kSlotCount];
+        const SlotState state = slot.state.load(std::memory_order_acquire);
+        if (state == SlotState::Empty) {
+            request(slot, shape);
+            return false;
+        }
+        if (slot.shape == shape) {
+            if (state != SlotState::Ready || slot.samples.size() != shape.length) {
+                return false;  // the worker has it; this note shapes inline
+            }
+            std::copy(slot.samples.begin(), slot.samples.end(), out);
+            request(slot, shape);
+            return true;
+        }
+        if (!victim && state != SlotState::Filling) {
+            victim = &slot;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    // A Requested slot is only ours once the worker can no longer claim it.
+    SlotState state = victim->state.load(std::memory_order_acquire);
+    if (state == SlotState::Ready ||
+        (state == SlotState::Requested &&
+         victim->state.compare_exchange_strong(state, SlotState::Empty,
+                                               std::memory_order_acquire))) {
+        request(*victim, shape);
+    }
+    return false;
+}
+
+std::size_t ExcitationPool::readyCount() const {
+    return static_cast<std::size_t>(
+        std::count_if(slots_.begin(), slots_.end(), [](const Slot& slot) {
+            return slot.state.load(std::memory_order_acquire) == SlotState::Ready;
+        }));
+}
+
+void ExcitationPool::waitIdle() const {
+    const auto busy = [this]() {
+        return std::any_of(slots_.begin(), slots_.end(), [](const Slot& slot) {
+            const SlotState state = slot.state.load(std::memory_order_acquire);
+            return state == SlotState::Requested || state == SlotState::Filling;
+        });
+    };
+    while (busy()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void ExcitationPool::workerLoop() {
+    const engine::ScopedDspThread dspThread("excitation pool");
+    while (!quit_.load(std::memory_order_acquire)) {
+        // Read before the scan: a request made during it changes the count,
+        // so the wait below falls straight through.
+        const std::uint32_t seen = requests_.load(std::memory_order_acquire);
+        for (Slot& slot : slots_) {
+            SlotState expected = SlotState::Requested;
+            if (!slot.state.compare_exchange_strong(expected, SlotState::Filling,
+                                                    std::memory_order_acquire)) {
+                continue;
+            }
+            const std::size_t before = engine::CapacityBytes(slot.samples);
+            seed_ = shaper_.shapeExcitation(slot.shape, seed_, slot.samples);
+            if (const std::size_t after = engine::CapacityBytes(slot.samples); after != before) {
+                sampleBytes_.set(sampleBytes_.bytes() - before + after);
+            }
+            slot.state.store(SlotState::Ready, std::memory_order_release);
+            if (quit_.load(std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        requests_.wait(seen, std::memory_order_acquire);
+    }
+}
+
+}  // namespace synthesis
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "engine/MemoryUsage.h"
+#include "synthesis/KarplusStrongString.h"
+
+namespace synthesis {
+
+// Random-noise excitations shaped ahead of time on a helper thread, so a
+// note-on copies one instead of generating noise and running the pick and
+// colour shaping inline. Slots are keyed by ExcitationShape (period, the
+// velocity-bucketed pick and colour, type, mix): a note-on that misses
+// claims a slot and shapes inline, and the worker fills the slot for the
+// next note with those inputs. A slot is shaped again with fresh noise
+// after every use, so repeated notes still get new bursts.
+//
+// take() is wait-free and belongs to one thread (the audio thread); the
+// worker only allocates and writes samples of slots it has claimed.
+class ExcitationPool {
+public:
+    static constexpr std::size_t kSlotCount = 512;
+    // Slots looked at for a shape before it evicts one.
+    static constexpr std::size_t kProbeCount = 8;
+    // Strings shaping from a pool snap velocity to this many steps, so close
+    // velocities share a slot. Note amplitude still uses the exact value.
+    static constexpr int kVelocityBuckets = 16;
+
+    // seed 0 uses random_device.
+    explicit ExcitationPool(unsigned int seed = 0);
+    ~ExcitationPool();
+    ExcitationPool(const ExcitationPool&) = delete;
+    ExcitationPool& operator=(const ExcitationPool&) = delete;
+
+    static float SnapVelocity(float velocity);
+
+    // Copies a shaped excitation for `shape` (shape.length samples) into
+    // `out` and has the slot shaped again; false if none is ready, which
+    // leaves a request for the worker.
+    bool take(const ExcitationShape& shape, float* out);
+
+    // Slots holding an excitation ready to take.
+    std::size_t readyCount() const;
+    // Returns once the worker has no requests left. Sleeps; not real-time safe.
+    void waitIdle() const;
+
+private:
+    enum class SlotState : std::uint8_t { Empty, Requested, Filling, Ready };
+
+    struct Slot {
+        std::atomic<SlotState> state{SlotState::Empty};
+        // Written by take() while the worker keeps off the slot (Empty,
+        // Ready, or a Requested one it takes back).
+        ExcitationShape shape;
+        // Written by the worker while Filling, read by take() while Ready.
+        std::vector<float> samples;
+    };
+
+    static std::size_t Hash(const ExcitationShape& shape);
+    // Points `slot` at `shape` and asks the worker for it.
+    void request(Slot& slot, const ExcitationShape& shape);
+    void workerLoop();
+
+    std::array<Slot, kSlotCount> slots_;
+    std::atomic<std::uint32_t> requests_{0};
+    std::atomic<bool> quit_{false};
+    unsigned int seed_ = 0;           // worker only
+    KarplusStrongString shaper_;      // worker only
+    engine::TrackedBytes sampleBytes_{engine::MemoryCategory::Samples};  // worker only
+    std::thread thread_;
+};
+
+}  // namespace synthesis
@@ -1,11 +1,18 @@
 #include "synthesis/KarplusStrongString.h"
 
 #include <algorithm>
+#include <bit>
 #include <cmath>
-#include <complex>
+#include <cstdint>
+#include <limits>
 #include <random>
 
+#include "dsp/FastMath.h"
 #include "dsp/Filter.h"
+#include "dsp/NoiseGenerator.h"
+#include "dsp/Simd.h"
+#include "dsp/StateSnapshot.h"
+#include "synthesis/ExcitationPool.h"
 
 namespace synthesis {
 
@@ -18,6 +25,27 @@ float clampPick(float value) {
     return std::max(0.001f, std::min(0.999f, value));
 }
 
+// cos/sin of phase i * step for i = 0, 1, ..., by rotation rather than a
+// trig call per sample (envelopes are a few hundred samples at most).
+class PhaseRotator {
+public:
+    explicit PhaseRotator(double step) : cosStep_(std::cos(step)), sinStep_(std::sin(step)) {}
+
+    double cos() const { return c_; }
+    double sin() const { return s_; }
+    void advance() {
+        const double c = c_ * cosStep_ - s_ * sinStep_;
+        s_ = s_ * cosStep_ + c_ * sinStep_;
+        c_ = c;
+    }
+
+private:
+    double cosStep_;
+    double sinStep_;
+    double c_ = 1.0;
+    double s_ = 0.0;
+};
+
 double firstOrderAllPassPhaseDelaySamples(double coefficient, double omega);
 
 float thiranFractionalDelayCoefficient(double fractionalDelay) {
@@ -30,25 +58,21 @@ float thiranFractionalDelayCoefficient(double fractionalDelay) {
     return static_cast<float>(-aClamped);  // Filter implementation uses opposite sign.
 }
 
+// Closed-form inverse of firstOrderAllPassPhaseDelaySamples(): the
+// coefficient whose phase delay at omega is exactly phaseDelaySamples.
 float allPassCoefficientForPhaseDelay(double phaseDelaySamples, double omega) {
+    constexpr double kMaxCoefficient = 0.9995;
     const double desired = std::clamp(phaseDelaySamples, 0.0, 1.999);
     if (desired < 1e-6 || omega <= 0.0) {
         return 0.0f;
     }
-
-    double lo = -0.9995;
-    double hi = 0.9995;
-    for (int i = 0; i < 60; ++i) {
-        const double mid = 0.5 * (lo + hi);
-        const double d = firstOrderAllPassPhaseDelaySamples(mid, omega);
-        if (d < desired) {
-            lo = mid;
-        } else {
-            hi = mid;
-        }
+    // Past this point no stable coefficient reaches the delay; saturate.
+    const double den = std::sin(0.5 * omega * (1.0 + desired));
+    if (den <= 1e-12) {
+        return static_cast<float>(kMaxCoefficient);
     }
-    const double coeff = 0.5 * (lo + hi);
-    return static_cast<float>(coeff);
+    const double coeff = -std::sin(0.5 * omega * (1.0 - desired)) / den;
+    return static_cast<float>(std::clamp(coeff, -kMaxCoefficient, kMaxCoefficient));
 }
 
 double firstOrderAllPassPhaseDelaySamples(double coefficient, double omega) {
@@ -60,12 +84,10 @@ double firstOrderAllPassPhaseDelaySamples(double coefficient, double omega) {
         return (1.0 + c) / (1.0 - c);
     }
 
-    const std::complex<double> z = std::polar(1.0, -omega);  // e^{-jω}
-    const std::complex<double> num = -static_cast<double>(coefficient) + z;
-    const std::complex<double> den = 1.0 - static_cast<double>(coefficient) * z;
-    const std::complex<double> h = num / den;
-    const double phase = std::atan2(h.imag(), h.real());
-    return -phase / omega;
+    // H = (e^{-jω} - c) / (1 - c e^{-jω}): the numerator's phase is -ω minus
+    // the denominator's, so the delay is 1 + 2 arg(1 - c e^{-jω}) / ω.
+    const double c = static_cast<double>(coefficient);
+    return 1.0 + 2.0 * dsp::FastAtan2(c * std::sin(omega), 1.0 - c * std::cos(omega)) / omega;
 }
 
 double onePoleLowPassPhaseDelaySamples(double alpha, double omega) {
@@ -84,10 +106,8 @@ double onePoleLowPassPhaseDelaySamples(double alpha, double omega) {
         return a / denom;
     }
 
-    const std::complex<double> z = std::polar(1.0, -omega);  // e^{-jω}
-    const std::complex<double> den = 1.0 - a * z;
-    const double phase = -std::atan2(den.imag(), den.real());
-    return -phase / omega;
+    // H = (1 - a) / (1 - a e^{-jω}); arg(1 - a e^{-jω}) = atan2(a sinω, 1 - a cosω).
+    return dsp::FastAtan2(a * std::sin(omega), 1.0 - a * std::cos(omega)) / omega;
 }
 }  // namespace
 
@@ -97,6 +117,7 @@ KarplusStrongString::KarplusStrongString(StringConfig config)
         std::random_device rd;
         rngSeed_ = rd();
     }
+    prepare(config_.sampleRate);
     configureFilters();
 }
 
@@ -108,9 +129,140 @@ void KarplusStrongString::updateConfig(const StringConfig& config) {
         std::random_device rd;
         rngSeed_ = rd();
     }
+    prepare(config_.sampleRate);
+    if (loop_.active) {
+        // Mid-note change: the delay lines and filter state stay; only the
+        // loop coefficients follow the new settings.
+        loop_.decay = clamp01(config_.decay);
+        resizeRails(solveTuning(loop_.length));
+    }
     configureFilters();
 }
 
+void KarplusStrongString::prepare(double sampleRate) {
+    if (sampleRate <= 0.0) {
+        return;
+    }
+    // start() uses floor(roundTrip / 2) samples per rail; the loop filters can
+    // only shorten that, so half a period at kMinFrequencyHz plus slack covers it.
+    const auto railCapacity =
+        static_cast<std::size_t>(std::ceil(0.5 * sampleRate / kMinFrequencyHz)) + 4;
+    // Hammer contact buffers are capped at 4096 samples in start(); a body
+    // response lengthens them by up to kMaxBodyResponseFrames.
+    const std::size_t excitationCapacity =
+        std::max<std::size_t>(railCapacity, 4096) + kMaxBodyResponseFrames;
+    ensureRailCapacity(railCapacity);
+    excitationBuffer_.reserve(excitationCapacity);
+    bodyScratch_.reserve(excitationCapacity);
+    noiseScratch_.reserve(std::max<std::size_t>(railCapacity, 4096));
+    impulseScratch_.reserve(railCapacity);
+    excitationCache_.reserve(std::max<std::size_t>(railCapacity, 4096));
+}
+
+std::size_t KarplusStrongString::heapBytes() const {
+    std::size_t floats = 0;
+    for (const auto* buffer : {&excitationBuffer_, &waveToBridge_, &waveToNut_, &outputBuffer_,
+                               &noiseScratch_, &impulseScratch_, &bodyScratch_,
+                               &excitationCache_}) {
+        floats += buffer->capacity();
+    }
+    return floats * sizeof(float);
+}
+
+void KarplusStrongString::ensureRailCapacity(std::size_t length) {
+    if (length <= waveToBridge_.size()) {
+        return;
+    }
+    const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(length, 2));
+    // Unroll the pending window to the front of the larger rings.
+    auto grow = [&](std::vector<float>& rail) {
+        std::vector<float> ring(capacity, 0.0f);
+        for (std::size_t i = 0; i < loop_.length; ++i) {
+            ring[i] = rail[(loop_.index + i) & loop_.mask];
+        }
+        rail.swap(ring);
+    };
+    grow(waveToBridge_);
+    grow(waveToNut_);
+    loop_.toBridge = waveToBridge_.data();
+    loop_.toNut = waveToNut_.data();
+    loop_.mask = capacity - 1;
+    loop_.index = 0;
+}
+
+void KarplusStrongString::saveState(dsp::StateWriter& out) const {
+    out.pod(loop_);  // the pointers and index are rebuilt on load
+    out.pod(config_);
+    out.pod(rngSeed_);
+    out.pod(tuningAllpassCoefficient_);
+    out.pod(tuningKey_);
+    out.pod(tunedPeriod_);
+    out.pod(hammerSamplesTotal_);
+    out.pod(hammerLowpassState_);
+    out.pod(currentFrequency_);
+    out.pod(currentVelocity_);
+    out.pod(currentPickPosition_);
+    out.pod(currentExcitationColor_);
+    if (!loop_.active) {
+        return;
+    }
+    // Only the pending window is state; it goes out unrolled from index.
+    for (const std::vector<float>* rail : {&waveToBridge_, &waveToNut_}) {
+        for (std::size_t i = 0; i < loop_.length; ++i) {
+            out.pod((*rail)[(loop_.index + i) & loop_.mask]);
+        }
+    }
+    out.floats(excitationBuffer_.data() + excitationBuffer_.size() - loop_.contactFrames,
+               loop_.contactFrames);
+}
+
+bool KarplusStrongString::loadState(dsp::StateReader& in) {
+    LoopState loop;
+    in.pod(loop);
+    in.pod(config_);
+    in.pod(rngSeed_);
+    in.pod(tuningAllpassCoefficient_);
+    in.pod(tuningKey_);
+    in.pod(tunedPeriod_);
+    in.pod(hammerSamplesTotal_);
+    in.pod(hammerLowpassState_);
+    in.pod(currentFrequency_);
+    in.pod(currentVelocity_);
+    in.pod(currentPickPosition_);
+    in.pod(currentExcitationColor_);
+    excitationKey_.reset();
+    // A rail or contact longer than what is left can only be a bad snapshot;
+    // checked before the rails grow for it.
+    const std::size_t left = in.remaining() / sizeof(float);
+    if (loop.active &&
+        (loop.length > left / 2 || loop.contactFrames > left - 2 * loop.length)) {
+        in.fail();
+    }
+    if (in.ok() && loop.active) {
+        ensureRailCapacity(loop.length);
+        in.floats(waveToBridge_.data(), loop.length);
+        in.floats(waveToNut_.data(), loop.length);
+        excitationBuffer_.resize(loop.contactFrames);
+        in.floats(excitationBuffer_.data(), loop.contactFrames);
+    }
+    if (!in.ok()) {
+        loop_.active = false;
+        return false;
+    }
+    loop.toBridge = waveToBridge_.data();
+    loop.toNut = waveToNut_.data();
+    loop.mask = waveToBridge_.empty() ? 0 : waveToBridge_.size() - 1;
+    loop.index = 0;
+    loop_ = loop;
+    steadyKernel_ = SelectSteadyKernel(loop_.filter.allPassCount(), loop_.filter.lowpassEnabled());
+    return true;
+}
+
+void KarplusStrongString::setBodyResponse(const float* response, std::size_t frames) {
+    bodyResponse_ = frames > 0 ? response : nullptr;
+    bodyResponseFrames_ = response ? std::min(frames, kMaxBodyResponseFrames) : 0;
+}
+
 KarplusStrongString::~KarplusStrongString() = default;
 
 KarplusStrongString::KarplusStrongString(KarplusStrongString&&) noexcept = default;
@@ -132,20 +284,33 @@ std::vector<float> KarplusStrongString::pluck(double frequency,
     }
 
     start(frequency, velocity);
-    if (!active_) {
+    if (!loop_.active) {
         return {};
     }
 
     outputBuffer_.assign(totalSamples, 0.0f);
-    for (std::size_t i = 0; i < totalSamples; ++i) {
-        outputBuffer_[i] = processSample();
-    }
+    processBlock(outputBuffer_.data(), totalSamples);
 
-    active_ = false;
-    lastOutput_ = 0.0f;
+    loop_.active = false;
+    loop_.lastOutput = 0.0f;
     return outputBuffer_;
 }
 
+float KarplusStrongString::storedPeak() const {
+    if (!loop_.active) {
+        return 0.0f;
+    }
+    if (loop_.contactFrames > 0) {
+        return std::numeric_limits<float>::infinity();
+    }
+    float peak = std::abs(loop_.lastOutput);
+    for (std::size_t i = 0; i < loop_.length; ++i) {
+        const std::size_t at = (loop_.index + i) & loop_.mask;
+        peak = std::max(peak, std::max(std::abs(waveToBridge_[at]), std::abs(waveToNut_[at])));
+    }
+    return peak;
+}
+
 std::vector<float> KarplusStrongString::excitationBufferPreview(
     std::size_t maxSamples) const {
     if (excitationBuffer_.empty()) {
@@ -163,35 +328,24 @@ void KarplusStrongString::fillExcitationNoise() {
         return;
     }
 
-    std::mt19937 rng(rngSeed_);
+    dsp::NoiseGenerator rng(rngSeed_);
     const bool randomMode =
         config_.excitationMode == ExcitationMode::RandomNoisePick;
     if (randomMode) {
-        rngSeed_ = rng();  // Update seed so next pluck gets a new noise burst.
+        rngSeed_ = rng.nextSeed();  // Update seed so next pluck gets a new noise burst.
     }
 
-    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
-    std::bernoulli_distribution binary(0.5);
-
     const float mix = clamp01(config_.excitationMix);
     const std::size_t n = excitationBuffer_.size();
 
     // 1) Generate noise excitation.
-    std::vector<float> noise(n, 0.0f);
-    for (auto& sample : noise) {
-        switch (config_.noiseType) {
-            case NoiseType::Binary:
-                sample = binary(rng) ? 1.0f : -1.0f;
-                break;
-            case NoiseType::White:
-            default:
-                sample = uniform(rng);
-                break;
-        }
-    }
+    auto& noise = noiseScratch_;
+    noise.resize(n);
+    fillNoise(rng, noise.data(), n);
 
     // 2) Generate a plectrum-shaped impulse (short Hann bump) centered at pick position.
-    std::vector<float> impulse(n, 0.0f);
+    auto& impulse = impulseScratch_;
+    impulse.assign(n, 0.0f);
     constexpr double kImpulseDurationSeconds = 0.005;  // ~5ms pluck transient.
     const double sr = config_.sampleRate > 0.0 ? config_.sampleRate : 44100.0;
     std::size_t windowLen = static_cast<std::size_t>(
@@ -209,15 +363,10 @@ void KarplusStrongString::fillExcitationNoise() {
     }
 
     constexpr double kTwoPi = 6.283185307179586;
+    PhaseRotator hann(kTwoPi / static_cast<double>(windowLen - 1));
     for (std::size_t i = 0; i < windowLen; ++i) {
-        const double phase =
-            (windowLen > 1)
-                ? (kTwoPi * static_cast<double>(i) /
-                   static_cast<double>(windowLen - 1))
-                : 0.0;
-        const float w =
-            static_cast<float>(0.5 - 0.5 * std::cos(phase));  // Hann window
-        impulse[start + i] = w;
+        impulse[start + i] = static_cast<float>(0.5 - 0.5 * hann.cos());  // Hann window
+        hann.advance();
     }
 
     // 3) Mix Noise/Impulse and remove DC.
@@ -236,6 +385,114 @@ void KarplusStrongString::fillExcitationNoise() {
     }
 }
 
+void KarplusStrongString::fillNoise(dsp::NoiseGenerator& rng, float* out, std::size_t count) const {
+    switch (config_.noiseType) {
+        case NoiseType::Binary:
+            rng.fillBinary(out, count);
+            break;
+        case NoiseType::White:
+        default:
+            rng.fillUniform(out, count);
+            break;
+    }
+}
+
+ExcitationShape KarplusStrongString::excitationShape() const {
+    return {config_.sampleRate,
+            excitationBuffer_.size(),
+            config_.excitationType,
+            config_.noiseType,
+            clamp01(config_.excitationMix),
+            currentPickPosition_,
+            currentExcitationColor_};
+}
+
+KarplusStrongString::ExcitationKey KarplusStrongString::excitationKey() const {
+    return {rngSeed_, excitationShape()};
+}
+
+bool KarplusStrongString::usesExcitationPool() const {
+    // A set seed asks for repeatable noise, which the pool cannot give.
+    return excitationPool_ && config_.seed == 0 &&
+           config_.excitationMode == ExcitationMode::RandomNoisePick;
+}
+
+bool KarplusStrongString::takePooledExcitation() {
+    return usesExcitationPool() &&
+           excitationPool_->take(excitationShape(), excitationBuffer_.data());
+}
+
+float KarplusStrongString::shapingVelocity(float velocity) const {
+    velocity = clamp01(velocity);
+    return usesExcitationPool() ? ExcitationPool::SnapVelocity(velocity) : velocity;
+}
+
+unsigned int KarplusStrongString::shapeExcitation(const ExcitationShape& shape,
+                                                  unsigned int seed,
+                                                  std::vector<float>& out) {
+    config_.sampleRate = shape.sampleRate;
+    config_.excitationType = shape.type;
+    config_.noiseType = shape.noiseType;
+    config_.excitationMix = shape.mix;
+    config_.excitationMode = ExcitationMode::RandomNoisePick;
+    currentPickPosition_ = shape.pickPosition;
+    currentExcitationColor_ = shape.color;
+    rngSeed_ = seed;
+    // A hammer's contact length follows from the colour again. This string
+    // has no pool or body response, so the shape comes out untouched.
+    buildExcitation(shape.length);
+    loop_.contactFrames = 0;
+    out.assign(excitationBuffer_.begin(), excitationBuffer_.end());
+    return rngSeed_;
+}
+
+bool KarplusStrongString::loadCachedExcitation() {
+    // Random mode moves the seed on every note, so only fixed noise repeats.
+    if (config_.excitationMode != ExcitationMode::FixedNoisePick || !excitationKey_ ||
+        !(*excitationKey_ == excitationKey())) {
+        return false;
+    }
+    std::copy(excitationCache_.begin(), excitationCache_.end(), excitationBuffer_.begin());
+    return true;
+}
+
+void KarplusStrongString::storeCachedExcitation() {
+    excitationCache_.assign(excitationBuffer_.begin(), excitationBuffer_.end());
+    excitationKey_ = excitationKey();
+}
+
+void KarplusStrongString::applyBodyResponse() {
+    if (!bodyResponse_ || bodyResponseFrames_ == 0 || excitationBuffer_.empty()) {
+        return;
+    }
+    const std::size_t n = excitationBuffer_.size();
+    const std::size_t taps = bodyResponseFrames_;
+    bodyScratch_.assign(n + taps - 1, 0.0f);
+    for (std::size_t i = 0; i < n; ++i) {
+        const float x = excitationBuffer_[i];
+        for (std::size_t k = 0; k < taps; ++k) {
+            bodyScratch_[i + k] += x * bodyResponse_[k];
+        }
+    }
+    excitationBuffer_.swap(bodyScratch_);
+}
+
+void KarplusStrongString::convolveBodyCircular(bool reversed) {
+    const std::size_t n = excitationBuffer_.size();
+    const std::size_t taps = bodyResponseFrames_;
+    bodyScratch_.assign(n, 0.0f);
+    for (std::size_t i = 0; i < n; ++i) {
+        const float x = excitationBuffer_[reversed ? n - 1 - i : i];
+        std::size_t out = i;
+        for (std::size_t k = 0; k < taps; ++k) {
+            bodyScratch_[out] += x * bodyResponse_[k];
+            if (++out == n) {
+                out = 0;
+            }
+        }
+    }
+}
+
 void KarplusStrongString::applyPickPositionShape() {
     if (excitationBuffer_.size() < 3) {
         return;
@@ -297,63 +554,118 @@ float KarplusStrongString::computeExcitationColor() const {
 }
 
 void KarplusStrongString::configureFilters() {
-    const auto dispersion = dispersionCoefficients();
-    const bool needDispersion = !dispersion.empty();
+    std::array<float, decltype(loop_.filter)::kMaxAllPass> allPass{};
+    std::size_t allPassCount = 0;
+    if (std::abs(tuningAllpassCoefficient_) > 1e-8f) {
+        allPass[allPassCount++] = tuningAllpassCoefficient_;
+    }
+    for (float coeff : dispersionCoefficients()) {
+        allPass[allPassCount++] = coeff;
+    }
     const bool needLowpass = config_.enableLowpass;
-    const bool needTuningAllpass = std::abs(tuningAllpassCoefficient_) > 1e-8f;
 
-    if (!needDispersion && !needLowpass && !needTuningAllpass) {
-        filterChain_.reset();
-        return;
+    // Same topology: retune in place so a sounding note keeps its state.
+    if (allPassCount == loop_.filter.allPassCount() &&
+        needLowpass == loop_.filter.lowpassEnabled()) {
+        for (std::size_t i = 0; i < allPassCount; ++i) {
+            loop_.filter.setAllPass(i, allPass[i]);
+        }
+    } else {
+        loop_.filter.clear();
+        for (std::size_t i = 0; i < allPassCount; ++i) {
+            loop_.filter.addAllPass(allPass[i]);
+        }
+    }
+    if (needLowpass) {
+        loop_.filter.setLowPass(clamp01(config_.brightness));
     }
+    steadyKernel_ = SelectSteadyKernel(loop_.filter.allPassCount(), loop_.filter.lowpassEnabled());
+    loop_.glideFrames = 0;
+}
 
-    if (!filterChain_) {
-        filterChain_ = std::make_unique<dsp::FilterChain>();
-    } else {
-        filterChain_->clear();
+std::size_t KarplusStrongString::solveTuning(std::size_t period) {
+    const TuningKey key{config_.sampleRate, currentFrequency_, config_.brightness,
+                        config_.dispersionAmount, config_.enableLowpass, period};
+    if (tuningKey_ && *tuningKey_ == key) {
+        return tunedPeriod_;
     }
 
-    if (needTuningAllpass) {
-        auto ap = std::make_unique<dsp::FirstOrderAllPass>(tuningAllpassCoefficient_);
-        filterChain_->addFilter(std::move(ap));
+    const double targetRoundTripDelay = config_.sampleRate / currentFrequency_;
+    const double omega = std::clamp(6.283185307179586 * currentFrequency_ / config_.sampleRate,
+                                    1e-9, 3.141592653589793);
+
+    double loopFilterDelay = 0.0;
+    for (float coeff : dispersionCoefficients()) {
+        loopFilterDelay += firstOrderAllPassPhaseDelaySamples(coeff, omega);
     }
-    if (needDispersion) {
-        for (float coeff : dispersion) {
-            auto ap = std::make_unique<dsp::FirstOrderAllPass>(coeff);
-            filterChain_->addFilter(std::move(ap));
-        }
+    if (config_.enableLowpass) {
+        loopFilterDelay += onePoleLowPassPhaseDelaySamples(clamp01(config_.brightness), omega);
     }
-    if (needLowpass) {
-        auto lowpass = std::make_unique<dsp::OnePoleLowPass>(clamp01(config_.brightness));
-        filterChain_->addFilter(std::move(lowpass));
+
+    const double propagationDelay =
+        std::max(4.0, targetRoundTripDelay - loopFilterDelay);
+    // A given period is kept while the allpass can still cover the remainder.
+    const double remainder = propagationDelay - 2.0 * static_cast<double>(period);
+    if (period == 0 || remainder < 0.0 || remainder > 1.999) {
+        const double baseOneWayDelay = std::floor(propagationDelay * 0.5);
+        period = static_cast<std::size_t>(std::max(2.0, baseOneWayDelay));
     }
+    const double tuningDelay =
+        std::clamp(propagationDelay - 2.0 * static_cast<double>(period), 0.0, 1.999);
+    tuningAllpassCoefficient_ = allPassCoefficientForPhaseDelay(tuningDelay, omega);
+    tunedPeriod_ = period;
+    tuningKey_ = key;
+    return period;
 }
 
-void KarplusStrongString::initializeWaveguideFromExcitation() {
-    if (excitationBuffer_.empty() || waveToBridge_.empty() || waveToNut_.empty()) {
+void KarplusStrongString::resizeRails(std::size_t period) {
+    period = std::max<std::size_t>(period, 2);
+    if (loop_.length == 0 || period == loop_.length) {
         return;
     }
-    const std::size_t n = waveToBridge_.size();
-    if (waveToNut_.size() != n) {
+    ensureRailCapacity(period);
+    // Moving the read position by the change keeps the write position, so a
+    // longer loop replays the samples it has just read and a shorter one skips
+    // ahead; either way a change costs O(1) and nothing is reallocated.
+    loop_.index = (loop_.index + loop_.length - period) & loop_.mask;
+    loop_.length = period;
+}
+
+void KarplusStrongString::addExcitationToWaveguide(float gain) {
+    if (excitationBuffer_.empty() || loop_.length == 0) {
         return;
     }
+    const std::size_t n = loop_.length;
+    const std::size_t mask = loop_.mask;
+    const std::size_t base = loop_.index;
 
     const std::size_t count = std::min(n, excitationBuffer_.size());
+    if (bodyResponse_ && bodyResponseFrames_ > 0 && count == excitationBuffer_.size()) {
+        // Commuted body: the fill repeats every period, so the response wraps
+        // around it. The bridge rail reaches the bridge in reverse order, so
+        // it gets the response applied to the reversed fill.
+        convolveBodyCircular(false);
+        for (std::size_t i = 0; i < count; ++i) {
+            waveToNut_[(base + i) & mask] += 0.5f * bodyScratch_[i] * gain;
+        }
+        convolveBodyCircular(true);
+        for (std::size_t i = 0; i < count; ++i) {
+            waveToBridge_[(base + i) & mask] += 0.5f * bodyScratch_[i] * gain;
+        }
+        return;
+    }
     for (std::size_t i = 0; i < count; ++i) {
-        const float value = 0.5f * excitationBuffer_[i];
-        waveToNut_[(nutIndex_ + i) % n] = value;
-        waveToBridge_[(bridgeIndex_ + (count - 1 - i)) % n] = value;
+        const float value = 0.5f * excitationBuffer_[i] * gain;
+        waveToNut_[(base + i) & mask] += value;
+        waveToBridge_[(base + count - 1 - i) & mask] += value;
     }
 }
 
 void KarplusStrongString::injectAtPosition(float position, float value) {
-    if (waveToBridge_.empty() || waveToNut_.empty()) {
-        return;
-    }
-    const std::size_t n = waveToBridge_.size();
-    if (waveToNut_.size() != n) {
+    if (loop_.length == 0) {
         return;
     }
+    const std::size_t n = loop_.length;
 
     const float p = clampPick(position);
     const std::size_t toNut =
@@ -361,55 +673,99 @@ void KarplusStrongString::injectAtPosition(float position, float value) {
     const std::size_t toBridge = (n - 1) - toNut;
 
     const float half = 0.5f * value;
-    waveToBridge_[(bridgeIndex_ + toBridge) % n] += half;
-    waveToNut_[(nutIndex_ + toNut) % n] += half;
+    waveToBridge_[(loop_.index + toBridge) & loop_.mask] += half;
+    waveToNut_[(loop_.index + toNut) & loop_.mask] += half;
 }
 
 void KarplusStrongString::start(double frequency, float velocity) {
+    startLoop(frequency, shapingVelocity(velocity), nullptr);
+}
+
+void KarplusStrongString::startCourse(const KarplusStrongString& source, double frequency) {
+    startLoop(frequency, source.currentVelocity_, &source);
+}
+
+void KarplusStrongString::startLoop(double frequency, float velocity,
+                                    const KarplusStrongString* source) {
     if (frequency <= 0.0 || config_.sampleRate <= 0.0) {
-        active_ = false;
+        loop_.active = false;
         return;
     }
 
     currentFrequency_ = frequency;
-    currentVelocity_ = clamp01(velocity);
+    currentVelocity_ = velocity;
     currentPickPosition_ = computeEffectivePickPosition();
     currentExcitationColor_ = computeExcitationColor();
 
-    const double targetRoundTripDelay = config_.sampleRate / frequency;
-    const double omega =
-        std::clamp(6.283185307179586 * frequency / config_.sampleRate, 1e-9, 3.141592653589793);
+    const std::size_t period = solveTuning(0);
+    configureFilters();
 
-    double loopFilterDelay = 0.0;
-    for (float coeff : dispersionCoefficients()) {
-        loopFilterDelay += firstOrderAllPassPhaseDelaySamples(coeff, omega);
+    // The whole ring is cleared: a loop lengthened mid-note replays the
+    // samples just behind the read position.
+    ensureRailCapacity(period);
+    std::fill(waveToBridge_.begin(), waveToBridge_.end(), 0.0f);
+    std::fill(waveToNut_.begin(), waveToNut_.end(), 0.0f);
+    loop_.length = period;
+    loop_.index = 0;
+    loop_.decay = clamp01(config_.decay);
+    loop_.lastOutput = 0.0f;
+    loop_.contactFrames = 0;
+    hammerLowpassState_ = 0.0f;
+
+    if (source) {
+        copyExcitation(*source, period);
+    } else {
+        buildExcitation(period);
     }
-    if (config_.enableLowpass) {
-        loopFilterDelay += onePoleLowPassPhaseDelaySamples(clamp01(config_.brightness), omega);
+    if (config_.excitationType != ExcitationType::Hammer) {
+        addExcitationToWaveguide(1.0f);
     }
 
-    const double propagationDelay =
-        std::max(4.0, targetRoundTripDelay - loopFilterDelay);
-    const double baseOneWayDelay = std::floor(propagationDelay * 0.5);
-    const auto period =
-        static_cast<std::size_t>(std::max(2.0, baseOneWayDelay));
-    const double tuningDelay =
-        std::clamp(propagationDelay - 2.0 * static_cast<double>(period), 0.0, 1.999);
-    tuningAllpassCoefficient_ = allPassCoefficientForPhaseDelay(tuningDelay, omega);
-    configureFilters();
+    loop_.filter.reset();
 
-    waveToBridge_.assign(period, 0.0f);
-    waveToNut_.assign(period, 0.0f);
-    bridgeIndex_ = 0;
-    nutIndex_ = 0;
-    decayFactor_ = clamp01(config_.decay);
-    lastOutput_ = 0.0f;
-    hammerSampleIndex_ = 0;
-    hammerSamplesTotal_ = 0;
-    hammerLowpassState_ = 0.0f;
+    loop_.active = true;
+}
+
+void KarplusStrongString::restrike(double frequency, float velocity, float gain) {
+    restrikeLoop(frequency, shapingVelocity(velocity), gain, nullptr);
+}
+
+void KarplusStrongString::restrikeCourse(const KarplusStrongString& source, double frequency,
+                                         float gain) {
+    restrikeLoop(frequency, source.currentVelocity_, gain, &source);
+}
+
+void KarplusStrongString::restrikeLoop(double frequency, float velocity, float gain,
+                                       const KarplusStrongString* source) {
+    if (!loop_.active || loop_.length == 0) {
+        startLoop(frequency, velocity, source);
+        return;
+    }
+    setFrequency(frequency);
+    currentVelocity_ = velocity;
+    currentPickPosition_ = computeEffectivePickPosition();
+    currentExcitationColor_ = computeExcitationColor();
+
+    if (source) {
+        copyExcitation(*source, loop_.length);
+    } else {
+        buildExcitation(loop_.length);
+    }
+    if (config_.excitationType == ExcitationType::Hammer) {
+        // A copied contact already carries the source's restrike gain.
+        if (!source) {
+            for (float& sample : excitationBuffer_) {
+                sample *= gain;
+            }
+        }
+    } else {
+        addExcitationToWaveguide(gain);
+    }
+}
 
+void KarplusStrongString::buildExcitation(std::size_t period) {
+    hammerSamplesTotal_ = 0;
     if (config_.excitationType == ExcitationType::Hammer) {
-        hammerRng_.seed(rngSeed_);
         const bool randomMode =
             config_.excitationMode == ExcitationMode::RandomNoisePick;
 
@@ -419,87 +775,437 @@ void KarplusStrongString::start(double frequency, float velocity) {
             std::clamp(contactSeconds * config_.sampleRate, 2.0, 4096.0)));
         excitationBuffer_.assign(hammerSamplesTotal_, 0.0f);
 
-        constexpr double kPi = 3.141592653589793;
-        const float mix = clamp01(config_.excitationMix);
-        const float lpAlpha = std::clamp(0.05f + 0.9f * hardness, 0.01f, 0.98f);
-        float state = 0.0f;
-        std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
-        std::bernoulli_distribution binary(0.5);
-
-        for (std::size_t i = 0; i < hammerSamplesTotal_; ++i) {
-            const double phase =
-                (hammerSamplesTotal_ > 1)
-                    ? (kPi * static_cast<double>(i) /
-                       static_cast<double>(hammerSamplesTotal_ - 1))
-                    : 0.0;
-            const float env = static_cast<float>(std::sin(phase));
-            float noiseSample = 0.0f;
-            switch (config_.noiseType) {
-                case NoiseType::Binary:
-                    noiseSample = binary(hammerRng_) ? 1.0f : -1.0f;
-                    break;
-                case NoiseType::White:
-                default:
-                    noiseSample = uniform(hammerRng_);
-                    break;
+        if (!takePooledExcitation() && !loadCachedExcitation()) {
+            dsp::NoiseGenerator rng(rngSeed_);
+            constexpr double kPi = 3.141592653589793;
+            const float mix = clamp01(config_.excitationMix);
+            const float lpAlpha = std::clamp(0.05f + 0.9f * hardness, 0.01f, 0.98f);
+            float state = 0.0f;
+            // hammerSamplesTotal_ >= 2, so the half-sine spans the whole contact.
+            PhaseRotator envelope(kPi / static_cast<double>(hammerSamplesTotal_ - 1));
+
+            auto& noise = noiseScratch_;
+            noise.resize(hammerSamplesTotal_);
+            fillNoise(rng, noise.data(), hammerSamplesTotal_);
+            for (std::size_t i = 0; i < hammerSamplesTotal_; ++i) {
+                const float env = static_cast<float>(envelope.sin());
+                envelope.advance();
+                const float pulse = env;
+                const float combined = (1.0f - mix) * pulse + mix * noise[i];
+                state = lpAlpha * combined + (1.0f - lpAlpha) * state;
+                excitationBuffer_[i] = env * state;
+            }
+            if (randomMode) {
+                rngSeed_ = rng.nextSeed();
+            } else {
+                storeCachedExcitation();
             }
-            const float pulse = env;
-            const float combined = (1.0f - mix) * pulse + mix * noiseSample;
-            state = lpAlpha * combined + (1.0f - lpAlpha) * state;
-            excitationBuffer_[i] = env * state;
-        }
-
-        if (randomMode) {
-            rngSeed_ = hammerRng_();
         }
+        applyBodyResponse();
+        loop_.contactFrames = excitationBuffer_.size();
     } else {
         excitationBuffer_.assign(period, 0.0f);
-        fillExcitationNoise();
-        applyPickPositionShape();
-        applyExcitationColor();
-        initializeWaveguideFromExcitation();
+        if (!takePooledExcitation() && !loadCachedExcitation()) {
+            fillExcitationNoise();
+            applyPickPositionShape();
+            applyExcitationColor();
+            if (config_.excitationMode == ExcitationMode::FixedNoisePick) {
+                storeCachedExcitation();
+            }
+        }
     }
+}
 
-    if (filterChain_) {
-        filterChain_->reset();
+void KarplusStrongString::copyExcitation(const KarplusStrongString& source, std::size_t period) {
+    const std::vector<float>& from = source.excitationBuffer_;
+    if (config_.excitationType == ExcitationType::Hammer) {
+        // The contact already carries the body response.
+        excitationBuffer_.assign(from.begin(), from.end());
+        hammerSamplesTotal_ = source.hammerSamplesTotal_;
+        loop_.contactFrames = excitationBuffer_.size();
+        return;
     }
+    hammerSamplesTotal_ = 0;
+    excitationBuffer_.assign(period, 0.0f);
+    std::copy_n(from.begin(), std::min(period, from.size()), excitationBuffer_.begin());
+}
 
-    active_ = true;
+void KarplusStrongString::setFrequency(double frequency, std::size_t glideFrames) {
+    if (!loop_.active || frequency <= 0.0 || frequency == currentFrequency_) {
+        return;
+    }
+    currentFrequency_ = frequency;
+    retuneLoop(glideFrames);
+}
+
+void KarplusStrongString::modulateLoop(float brightness, float decay, std::size_t glideFrames) {
+    if (!loop_.active) {
+        return;
+    }
+    loop_.decay = clamp01(decay);
+    config_.decay = loop_.decay;
+    if (brightness == config_.brightness) {
+        return;
+    }
+    config_.brightness = brightness;
+    if (config_.enableLowpass) {
+        retuneLoop(glideFrames);
+    }
+}
+
+void KarplusStrongString::retuneLoop(std::size_t glideFrames) {
+    const bool hadTuningStage = std::abs(tuningAllpassCoefficient_) > 1e-8f;
+    const float from = loop_.filter.state().allPassCoeff[0];
+    const std::size_t length = loop_.length;
+    resizeRails(solveTuning(loop_.length));
+    configureFilters();
+    // Ramp only while stage 0 stays the tuning allpass on the same rail
+    // length; across an integer step the coefficient jumps with the length.
+    const bool hasTuningStage = std::abs(tuningAllpassCoefficient_) > 1e-8f;
+    if (glideFrames > 0 && hadTuningStage && hasTuningStage && loop_.length == length) {
+        auto& state = loop_.filter.state();
+        loop_.glideTarget = state.allPassCoeff[0];
+        loop_.glideStep = (loop_.glideTarget - from) / static_cast<float>(glideFrames);
+        loop_.glideFrames = glideFrames;
+        state.allPassCoeff[0] = from;
+    }
 }
 
 float KarplusStrongString::processSample() {
-    if (!active_ || waveToBridge_.empty() || waveToNut_.empty()) {
+    if (!loop_.active || loop_.length == 0) {
         return 0.0f;
     }
 
-    if (config_.excitationType == ExcitationType::Hammer &&
-        hammerSampleIndex_ < excitationBuffer_.size()) {
-        const float injection = excitationBuffer_[hammerSampleIndex_++];
+    if (loop_.contactFrames > 0) {
+        const float injection = excitationBuffer_[excitationBuffer_.size() - loop_.contactFrames];
+        --loop_.contactFrames;
         injectAtPosition(currentPickPosition_, 0.25f * injection);
     }
 
-    const float toBridge = waveToBridge_[bridgeIndex_];
-    const float toNut = waveToNut_[nutIndex_];
-
-    float filtered = toBridge;
-    if (filterChain_ && !filterChain_->empty()) {
-        filtered = filterChain_->process(toBridge);
+    if (loop_.glideFrames > 0) {
+        auto& coeff = loop_.filter.state().allPassCoeff[0];
+        coeff = --loop_.glideFrames > 0 ? coeff + loop_.glideStep : loop_.glideTarget;
     }
 
-    const float fromBridge = -decayFactor_ * filtered;
+    const std::size_t read = loop_.index;
+    const std::size_t write = (read + loop_.length) & loop_.mask;
+    const float toBridge = loop_.toBridge[read];
+    const float toNut = loop_.toNut[read];
+
+    const float filtered = loop_.filter.process(toBridge);
+
+    const float fromBridge = -loop_.decay * filtered;
     const float fromNut = -toNut;
 
-    waveToNut_[bridgeIndex_] = fromBridge;
-    waveToBridge_[nutIndex_] = fromNut;
+    loop_.toNut[write] = fromBridge;
+    loop_.toBridge[write] = fromNut;
+
+    loop_.index = (read + 1) & loop_.mask;
+
+    loop_.lastOutput = (toBridge - fromBridge);
+    return loop_.lastOutput;
+}
+
+void KarplusStrongString::processBlock(float* out, std::size_t frames) {
+    if (!out || frames == 0) {
+        return;
+    }
+    if (!loop_.active || loop_.length == 0) {
+        std::fill(out, out + frames, 0.0f);
+        return;
+    }
+
+    std::size_t done = 0;
+    // The hammer contact phase injects ahead of the read position, so keep it on
+    // the per-sample path; it only lasts a few milliseconds.
+    while (done < frames && loop_.contactFrames > 0) {
+        out[done++] = processSample();
+    }
 
-    bridgeIndex_ = (bridgeIndex_ + 1) % waveToBridge_.size();
-    nutIndex_ = (nutIndex_ + 1) % waveToNut_.size();
+    (this->*steadyKernel_)(out, done, frames);
+}
 
-    lastOutput_ = (toBridge - fromBridge);
-    return lastOutput_;
+template <std::size_t Stages, bool Lowpass>
+void KarplusStrongString::renderSteady(float* out, std::size_t done, std::size_t frames) {
+    // Work on a local copy so the filter state stays in registers for the span.
+    auto loopFilter = loop_.filter;
+    float* toBridgeRail = loop_.toBridge;
+    float* toNutRail = loop_.toNut;
+    const std::size_t mask = loop_.mask;
+    const std::size_t length = loop_.length;
+    const float decay = loop_.decay;
+    float last = loop_.lastOutput;
+
+    std::size_t read = loop_.index;
+    auto run = [&]<bool Glide>(std::size_t end, float step) {
+        for (; done < end; ++done) {
+            if constexpr (Glide) {
+                loopFilter.state().allPassCoeff[0] += step;
+            }
+            const std::size_t write = (read + length) & mask;
+            const float toBridge = toBridgeRail[read];
+            const float toNut = toNutRail[read];
+            const float filtered = loopFilter.template processFixed<Stages, Lowpass>(toBridge);
+            const float fromBridge = -decay * filtered;
+            toNutRail[write] = fromBridge;
+            toBridgeRail[write] = -toNut;
+            last = toBridge - fromBridge;
+            out[done] = last;
+            read = (read + 1) & mask;
+        }
+    };
+    if constexpr (Stages > 0) {
+        // Ramp the tuning allpass; its last step lands exactly on the target.
+        const std::size_t glide = std::min(loop_.glideFrames, frames - done);
+        if (glide > 0) {
+            loop_.glideFrames -= glide;
+            const bool finishes = loop_.glideFrames == 0;
+            run.template operator()<true>(done + glide - (finishes ? 1 : 0), loop_.glideStep);
+            if (finishes) {
+                loopFilter.state().allPassCoeff[0] = loop_.glideTarget;
+            }
+        }
+    }
+    run.template operator()<false>(frames, 0.0f);
+    loop_.index = read;
+    loop_.filter = loopFilter;
+    loop_.lastOutput = last;
+}
+
+KarplusStrongString::SteadyKernel KarplusStrongString::SelectSteadyKernel(std::size_t stages,
+                                                                          bool lowpass) {
+    static_assert(decltype(loop_.filter)::kMaxAllPass == 3);
+    switch (stages) {
+    case 0:
+        return lowpass ? &KarplusStrongString::renderSteady<0, true>
+                       : &KarplusStrongString::renderSteady<0, false>;
+    case 1:
+        return lowpass ? &KarplusStrongString::renderSteady<1, true>
+                       : &KarplusStrongString::renderSteady<1, false>;
+    case 2:
+        return lowpass ? &KarplusStrongString::renderSteady<2, true>
+                       : &KarplusStrongString::renderSteady<2, false>;
+    default:
+        return lowpass ? &KarplusStrongString::renderSteady<3, true>
+                       : &KarplusStrongString::renderSteady<3, false>;
+    }
+}
+
+void KarplusStrongString::processBlockLanes(KarplusStrongString* const* strings,
+                                            float* const* outs, std::size_t count,
+                                            std::size_t frames) {
+    namespace simd = dsp::simd;
+    constexpr std::size_t kLanes = simd::kLanes;
+    constexpr std::size_t kStages = decltype(loop_.filter)::kMaxAllPass;
+
+    std::size_t start = 0;
+    while (start < count) {
+        // Pick up to kLanes strings that are on the steady-state loop; anything
+        // inactive or still in hammer contact goes through the scalar path.
+        KarplusStrongString* lane[kLanes] = {};
+        float* laneOut[kLanes] = {};
+        std::size_t lanes = 0;
+        for (; start < count && lanes < kLanes; ++start) {
+            KarplusStrongString* s = strings[start];
+            const bool steady =
+                s->loop_.active && s->loop_.length > 0 && s->loop_.contactFrames == 0;
+            if (!steady) {
+                s->processBlock(outs[start], frames);
+                continue;
+            }
+            lane[lanes] = s;
+            laneOut[lanes] = outs[start];
+            ++lanes;
+        }
+        if (lanes == 0) {
+            continue;
+        }
+        if (lanes == 1) {
+            lane[0]->processBlock(laneOut[0], frames);
+            continue;
+        }
+
+        // Pack per-lane state. Unused lanes run on a one-sample dummy loop.
+        float dummyBridge = 0.0f;
+        float dummyNut = 0.0f;
+        float* bridgeRail[kLanes];
+        float* nutRail[kLanes];
+        std::size_t length[kLanes];
+        std::size_t mask[kLanes];
+        std::size_t index[kLanes];
+        float negDecay[kLanes];
+        float negCoeff[kStages][kLanes];
+        float coeff[kStages][kLanes];
+        float z1[kStages][kLanes];
+        bool stageOn[kStages][kLanes];
+        float lpAlpha[kLanes];
+        float lpOneMinus[kLanes];
+        float lpState[kLanes];
+        bool lpOn[kLanes];
+        std::size_t glideLeft[kLanes] = {};
+        float glideStep[kLanes] = {};
+        for (std::size_t l = 0; l < kLanes; ++l) {
+            KarplusStrongString* s = lane[l];
+            if (!s) {
+                bridgeRail[l] = &dummyBridge;
+                nutRail[l] = &dummyNut;
+                length[l] = 1;
+                mask[l] = 0;
+                index[l] = 0;
+                negDecay[l] = -0.0f;
+                for (std::size_t k = 0; k < kStages; ++k) {
+                    negCoeff[k][l] = -0.0f;
+                    coeff[k][l] = 0.0f;
+                    z1[k][l] = 0.0f;
+                    stageOn[k][l] = false;
+                }
+                lpAlpha[l] = 0.0f;
+                lpOneMinus[l] = 1.0f;
+                lpState[l] = 0.0f;
+                lpOn[l] = false;
+                continue;
+            }
+            const auto& filter = s->loop_.filter;
+            const auto& state = filter.state();
+            bridgeRail[l] = s->loop_.toBridge;
+            nutRail[l] = s->loop_.toNut;
+            length[l] = s->loop_.length;
+            mask[l] = s->loop_.mask;
+            index[l] = s->loop_.index;
+            negDecay[l] = -s->loop_.decay;
+            for (std::size_t k = 0; k < kStages; ++k) {
+                coeff[k][l] = state.allPassCoeff[k];
+                negCoeff[k][l] = -state.allPassCoeff[k];
+                z1[k][l] = state.allPassZ1[k];
+                stageOn[k][l] = k < filter.allPassCount();
+            }
+            lpAlpha[l] = state.lowpassAlpha;
+            lpOneMinus[l] = 1.0f - state.lowpassAlpha;
+            lpState[l] = state.lowpassState;
+            lpOn[l] = filter.lowpassEnabled();
+            glideLeft[l] = s->loop_.glideFrames;
+            glideStep[l] = s->loop_.glideStep;
+        }
+
+        simd::Float4 vNegCoeff[kStages];
+        simd::Float4 vCoeff[kStages];
+        simd::Float4 vZ1[kStages];
+        simd::Float4 vStageOn[kStages];
+        for (std::size_t k = 0; k < kStages; ++k) {
+            vNegCoeff[k] = simd::Load(negCoeff[k]);
+            vCoeff[k] = simd::Load(coeff[k]);
+            vZ1[k] = simd::Load(z1[k]);
+            vStageOn[k] = simd::MaskFromFlags(stageOn[k]);
+        }
+        const simd::Float4 vLpAlpha = simd::Load(lpAlpha);
+        const simd::Float4 vLpOneMinus = simd::Load(lpOneMinus);
+        const simd::Float4 vLpOn = simd::MaskFromFlags(lpOn);
+        const simd::Float4 vNegDecay = simd::Load(negDecay);
+        simd::Float4 vLpState = simd::Load(lpState);
+
+        float toBridge[kLanes];
+        float toNut[kLanes];
+        float fromBridge[kLanes];
+        float result[kLanes];
+        auto run = [&]<bool Glide>(std::size_t i, std::size_t end, simd::Float4 vStep) {
+            for (; i < end; ++i) {
+                if constexpr (Glide) {
+                    vCoeff[0] = simd::Add(vCoeff[0], vStep);
+                    vNegCoeff[0] = simd::Sub(vNegCoeff[0], vStep);
+                }
+                for (std::size_t l = 0; l < kLanes; ++l) {
+                    toBridge[l] = bridgeRail[l][index[l]];
+                    toNut[l] = nutRail[l][index[l]];
+                }
+                const simd::Float4 input = simd::Load(toBridge);
+                simd::Float4 x = input;
+                for (std::size_t k = 0; k < kStages; ++k) {
+                    const simd::Float4 y = simd::Add(simd::Mul(vNegCoeff[k], x), vZ1[k]);
+                    const simd::Float4 z = simd::Add(x, simd::Mul(vCoeff[k], y));
+                    vZ1[k] = simd::Select(vStageOn[k], z, vZ1[k]);
+                    x = simd::Select(vStageOn[k], y, x);
+                }
+                const simd::Float4 lp =
+                    simd::Add(simd::Mul(vLpAlpha, x), simd::Mul(vLpOneMinus, vLpState));
+                vLpState = simd::Select(vLpOn, lp, vLpState);
+                x = simd::Select(vLpOn, lp, x);
+
+                const simd::Float4 fb = simd::Mul(vNegDecay, x);
+                simd::Store(fromBridge, fb);
+                simd::Store(result, simd::Sub(input, fb));
+                for (std::size_t l = 0; l < kLanes; ++l) {
+                    const std::size_t k = index[l];
+                    const std::size_t write = (k + length[l]) & mask[l];
+                    nutRail[l][write] = fromBridge[l];
+                    bridgeRail[l][write] = -toNut[l];
+                    index[l] = (k + 1) & mask[l];
+                }
+                for (std::size_t l = 0; l < lanes; ++l) {
+                    laneOut[l][i] = result[l];
+                }
+            }
+        };
+        // Lanes ramping their tuning allpass (stage 0) split the block where
+        // a ramp ends; the last step of each lands exactly on its target.
+        std::size_t i = 0;
+        while (i < frames) {
+            std::size_t end = frames;
+            float step[kLanes] = {};
+            bool gliding = false;
+            for (std::size_t l = 0; l < lanes; ++l) {
+                if (glideLeft[l] > 0) {
+                    end = std::min(end, i + glideLeft[l] - 1);
+                    step[l] = glideStep[l];
+                    gliding = true;
+                }
+            }
+            if (!gliding) {
+                run.template operator()<false>(i, frames, simd::Set1(0.0f));
+                break;
+            }
+            run.template operator()<true>(i, end, simd::Load(step));
+            const std::size_t elapsed = end - i;
+            simd::Store(coeff[0], vCoeff[0]);
+            simd::Store(negCoeff[0], vNegCoeff[0]);
+            for (std::size_t l = 0; l < lanes; ++l) {
+                if (glideLeft[l] == 0) {
+                    continue;
+                }
+                glideLeft[l] -= elapsed;
+                if (glideLeft[l] == 1) {
+                    glideLeft[l] = 0;
+                    coeff[0][l] = lane[l]->loop_.glideTarget;
+                    negCoeff[0][l] = -coeff[0][l];
+                }
+            }
+            vCoeff[0] = simd::Load(coeff[0]);
+            vNegCoeff[0] = simd::Load(negCoeff[0]);
+            i = end;
+        }
+
+        for (std::size_t k = 0; k < kStages; ++k) {
+            simd::Store(z1[k], vZ1[k]);
+        }
+        simd::Store(coeff[0], vCoeff[0]);
+        simd::Store(lpState, vLpState);
+        for (std::size_t l = 0; l < lanes; ++l) {
+            KarplusStrongString* s = lane[l];
+            auto& state = s->loop_.filter.state();
+            for (std::size_t k = 0; k < kStages; ++k) {
+                state.allPassZ1[k] = z1[k][l];
+            }
+            state.allPassCoeff[0] = coeff[0][l];
+            s->loop_.glideFrames = glideLeft[l];
+            state.lowpassState = lpState[l];
+            s->loop_.index = index[l];
+            if (frames > 0) {
+                s->loop_.lastOutput = laneOut[l][frames - 1];
+            }
+        }
+    }
 }
 
-std::vector<float> KarplusStrongString::dispersionCoefficients() const {
+KarplusStrongString::DispersionCoefficients KarplusStrongString::dispersionCoefficients() const {
     const float amount = clamp01(config_.dispersionAmount);
     if (amount <= 0.0001f || config_.sampleRate <= 0.0) {
         return {};
@@ -510,7 +1216,7 @@ std::vector<float> KarplusStrongString::dispersionCoefficients() const {
     const float scaled = amount * 0.7f;
     const float coeff1 = std::clamp(scaled * (0.35f + 0.65f * normFreq), -0.85f, 0.85f);
     const float coeff2 = std::clamp(scaled * 0.6f * (0.4f + 0.6f * normFreq), -0.8f, 0.8f);
-    return {coeff1, coeff2};
+    return {{coeff1, coeff2}, 2};
 }
 
 }  // namespace synthesis
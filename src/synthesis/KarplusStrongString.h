@@ -1,19 +1,33 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
-#include <memory>
-#include <random>
+#include <optional>
 #include <vector>
 
+#include "dsp/Filter.h"
+#include "dsp/NoiseGenerator.h"
+
 namespace dsp {
-class FilterChain;
-}
+class StateReader;
+class StateWriter;
+}  // namespace dsp
 
 namespace synthesis {
 
 enum class NoiseType { White, Binary };
 enum class ExcitationMode { RandomNoisePick, FixedNoisePick };
 enum class ExcitationType { Pluck, Hammer };
+// Room engine: the IR convolution, or a feedback delay network fitted to the
+// selected IR that costs far less CPU.
+enum class RoomType { Convolution, Algorithmic };
+// Body resonance: a filter after the voice mix, or commuted into each note's
+// excitation at note-on (no per-sample body cost; body changes reach new
+// notes only).
+enum class BodyMode { PostFilter, Commuted };
+// Body response: the low/high tilt filter, or a bank of resonant modes from a
+// guitar or koto table (dsp::ModalBody).
+enum class BodyModel { Tilt, Guitar, Koto };
 
 struct StringConfig {
     double sampleRate = 44100.0;
@@ -26,8 +40,14 @@ struct StringConfig {
     float dispersionAmount = 0.12f;  // Dispersion amount (0 disables).
     float bodyTone = 0.5f;       // Body tone color.
     float bodySize = 0.5f;       // Body size scaling.
+    BodyMode bodyMode = BodyMode::PostFilter;
+    BodyModel bodyModel = BodyModel::Tilt;
     float roomAmount = 0.0f;     // Room/wet amount.
+    float sympatheticAmount = 0.0f;  // Open-string resonance level.
+    float stereoSpread = 0.0f;   // Key-tracked voice pan width.
+    float courseDetuneCents = 0.0f;  // Doubled course spread (0 = single string).
     int roomIrIndex = 0;         // Built-in IR selection (index into IR library).
+    RoomType roomType = RoomType::Convolution;
     NoiseType noiseType = NoiseType::White;
     bool enableLowpass = true;
     unsigned int seed = 0;  // Noise RNG seed (0 uses random_device).
@@ -35,8 +55,30 @@ struct StringConfig {
     ExcitationType excitationType = ExcitationType::Pluck;
 };
 
+// Inputs that shape a note-on excitation apart from the noise seed (before
+// any body response). `length` is the pluck's period or the hammer's
+// contact in samples.
+struct ExcitationShape {
+    double sampleRate = 0.0;
+    std::size_t length = 0;
+    ExcitationType type = ExcitationType::Pluck;
+    NoiseType noiseType = NoiseType::White;
+    float mix = 0.0f;
+    float pickPosition = 0.0f;
+    float color = 0.0f;
+    bool operator==(const ExcitationShape&) const = default;
+};
+
+class ExcitationPool;
+
 class KarplusStrongString {
 public:
+    // Lowest frequency covered by the preallocated delay lines; lower notes
+    // still work but allocate on start().
+    static constexpr double kMinFrequencyHz = 20.0;
+    // Longest body impulse response start() convolves without allocating.
+    static constexpr std::size_t kMaxBodyResponseFrames = 2048;
+
     explicit KarplusStrongString(StringConfig config = {});
     ~KarplusStrongString();
     KarplusStrongString(const KarplusStrongString&) = delete;
@@ -49,46 +91,230 @@ public:
                              float velocity = 1.0f);
     // Start a real-time pluck.
     void start(double frequency, float velocity = 1.0f);
+    // Strike a sounding string again (a repeated note under the sustain
+    // pedal): a new excitation, scaled by `gain`, is added to what the
+    // waveguide still holds instead of replacing it. Same as start() on an
+    // inactive string.
+    void restrike(double frequency, float velocity, float gain = 1.0f);
+    // Second string of a doubled course: start() or restrike() at
+    // `frequency` with the excitation `source` built on its last start() or
+    // restrike() (same velocity, pick and noise, and for a hammer the same
+    // body response) instead of shaping one of its own. `source` needs the
+    // same config; this string's own body response applies to a pluck.
+    // restrikeCourse() follows the source's restrike(), whose hammer contact
+    // already carries `gain`.
+    void startCourse(const KarplusStrongString& source, double frequency);
+    void restrikeCourse(const KarplusStrongString& source, double frequency, float gain);
+    // Retune a sounding string (pitch bend, vibrato). The integer part of
+    // the delay moves the rail read position and the tuning allpass takes
+    // the fraction, so nothing is reallocated above kMinFrequencyHz. With
+    // glideFrames > 0 the allpass coefficient ramps to the new value over
+    // that many rendered samples instead of stepping (a change of integer
+    // length still lands at once).
+    void setFrequency(double frequency, std::size_t glideFrames = 0);
+    // Control-rate modulation of a sounding string: the loop decay steps to
+    // `decay` and the lowpass to `brightness`, retuned (with the same glide
+    // as setFrequency) so the pitch holds. Values are taken as given; the
+    // config's fields follow until the next updateConfig().
+    void modulateLoop(float brightness, float decay, std::size_t glideFrames);
     // Pull one sample; returns 0 if inactive.
     float processSample();
-    bool active() const { return active_; }
-    float lastOutput() const { return lastOutput_; }
+    // Render a block of samples; output is identical to calling processSample()
+    // `frames` times. Writes zeros if inactive.
+    void processBlock(float* out, std::size_t frames);
+    // Render `count` strings in lockstep, packing them into SIMD lanes. Each
+    // outs[i] receives exactly what strings[i]->processBlock() would produce.
+    static void processBlockLanes(KarplusStrongString* const* strings, float* const* outs,
+                                  std::size_t count, std::size_t frames);
+    bool active() const { return loop_.active; }
+    float lastOutput() const { return loop_.lastOutput; }
+    // Largest magnitude still held in the waveguide (both rails and the last
+    // output), i.e. a bound on what the decaying loop can still produce;
+    // infinite while a hammer is in contact. O(period); 0 if inactive.
+    float storedPeak() const;
 
     // Preview current excitation buffer. For visualization/analysis.
     // Typically read after start() and before processSample(). maxSamples=0 = no truncation.
     std::vector<float> excitationBufferPreview(std::size_t maxSamples = 0) const;
 
+    // Body impulse response convolved into the excitation by start()
+    // (commuted synthesis): circularly into a pluck's one-period waveguide
+    // fill, linearly into a hammer's injected contact. Not copied; must stay
+    // valid until the next start(). Null or 0 frames turns it off.
+    void setBodyResponse(const float* response, std::size_t frames);
+
+    // Random-noise note-ons copy an excitation `pool` shaped ahead of time
+    // when it has one for their inputs, and shape inline otherwise. Velocity
+    // then moves pick and colour in ExcitationPool::kVelocityBuckets steps.
+    // Strings with a fixed seed or FixedNoisePick keep shaping their own.
+    // Not owned; null turns it off.
+    void setExcitationPool(ExcitationPool* pool) { excitationPool_ = pool; }
+    // The excitation a random-noise note-on with `shape` would build from
+    // noise seed `seed`, before any body response, into `out`; returns the
+    // seed that follows. For ExcitationPool's worker, on a string of its own.
+    unsigned int shapeExcitation(const ExcitationShape& shape, unsigned int seed,
+                                 std::vector<float>& out);
+
     const StringConfig& config() const { return config_; }
+    // On a sounding string, decay and loop-filter coefficients are updated in
+    // place (retuned to the current pitch) without resetting its state.
     void updateConfig(const StringConfig& config);
+    // Reserve delay-line and excitation storage so start() does not allocate
+    // for notes >= kMinFrequencyHz at this sample rate. Called from the
+    // constructor and updateConfig(); not real-time safe itself.
+    void prepare(double sampleRate);
+    // Delay-line and excitation storage, for memory accounting.
+    std::size_t heapBytes() const;
+
+    // The sounding note for an engine snapshot: loop state, the rails'
+    // pending window and the rest of a hammer's contact, plus the config and
+    // tuning it was struck with. loadState() needs a string prepared for the
+    // same rate and keeps its own body response and excitation pool; false
+    // (string silenced) if the data does not fit.
+    void saveState(dsp::StateWriter& out) const;
+    bool loadState(dsp::StateReader& in);
 
 private:
+    struct DispersionCoefficients {
+        std::array<float, 2> values{};
+        std::size_t count = 0;
+        const float* begin() const { return values.data(); }
+        const float* end() const { return values.data() + count; }
+        bool empty() const { return count == 0; }
+    };
+
+    // Inputs of a shaped excitation (before any body response). A
+    // fixed-noise note-on with the same key copies the cached shape instead
+    // of generating it again; the result is identical either way.
+    struct ExcitationKey {
+        unsigned int seed = 0;
+        ExcitationShape shape;
+        bool operator==(const ExcitationKey&) const = default;
+    };
+
+    // Shapes a note-on excitation into excitationBuffer_: one period
+    // (`period` samples) for a pluck, the contact for a hammer (which also
+    // arms loop_.contactFrames).
+    void buildExcitation(std::size_t period);
+    // The same for a second course: `source`'s excitation, a pluck's cut or
+    // zero-padded to `period`.
+    void copyExcitation(const KarplusStrongString& source, std::size_t period);
+    // start() and restrike() with the shaping velocity already applied;
+    // a non-null `source` copies its excitation.
+    void startLoop(double frequency, float velocity, const KarplusStrongString* source);
+    void restrikeLoop(double frequency, float velocity, float gain,
+                      const KarplusStrongString* source);
     void fillExcitationNoise();
+    void fillNoise(dsp::NoiseGenerator& rng, float* out, std::size_t count) const;
+    ExcitationShape excitationShape() const;
+    ExcitationKey excitationKey() const;
+    bool usesExcitationPool() const;
+    // Copies a pooled excitation into excitationBuffer_ (already sized).
+    bool takePooledExcitation();
+    // Velocity as pick position and colour see it.
+    float shapingVelocity(float velocity) const;
+    // Copies the cached excitation into excitationBuffer_ (already sized)
+    // if its key matches; only in FixedNoisePick mode.
+    bool loadCachedExcitation();
+    void storeCachedExcitation();
     void applyPickPositionShape();
     void applyExcitationColor();
+    // Linear convolution of a hammer's contact with the body response.
+    void applyBodyResponse();
+    // Circular convolution of a pluck's one-period fill (optionally read
+    // backwards) with the body response, into bodyScratch_.
+    void convolveBodyCircular(bool reversed);
     float computeEffectivePickPosition() const;
     float computeExcitationColor() const;
+    // Inputs of the loop tuning solve; a repeat update with the same values
+    // reuses the previous result.
+    struct TuningKey {
+        double sampleRate = 0.0;
+        double frequency = 0.0;
+        float brightness = 0.0f;
+        float dispersionAmount = 0.0f;
+        bool enableLowpass = false;
+        std::size_t period = 0;
+        bool operator==(const TuningKey&) const = default;
+    };
+
+    // Steady-state loop (after any hammer contact) from frame `done` up to
+    // `frames`, specialised on the loop filter topology. configureFilters()
+    // picks the instance matching loop_.filter.
+    using SteadyKernel = void (KarplusStrongString::*)(float* out, std::size_t done,
+                                                      std::size_t frames);
+    template <std::size_t Stages, bool Lowpass>
+    void renderSteady(float* out, std::size_t done, std::size_t frames);
+    static SteadyKernel SelectSteadyKernel(std::size_t stages, bool lowpass);
+
+    // Everything the per-sample loop reads or writes, at the front of the
+    // object on its own two cache lines; the note-on data behind it (config,
+    // excitation buffers and caches) stays out of L1 while voices render.
+    struct alignas(64) LoopState {
+        // Tuning allpass + two dispersion allpasses + lowpass.
+        dsp::StringLoopFilter<3> filter;
+        // Both rails are power-of-two rings indexed by mask (storage in
+        // waveToBridge_ / waveToNut_). The next sample to reach the bridge
+        // (nut) is at index; each rail delays length samples, so writes land
+        // at index + length.
+        float* toBridge = nullptr;
+        float* toNut = nullptr;
+        std::size_t mask = 0;
+        std::size_t length = 0;
+        std::size_t index = 0;
+        // Hammer samples still to inject; the per-sample path runs until 0.
+        std::size_t contactFrames = 0;
+        // Per-sample ramp of the tuning allpass (stage 0) set by setFrequency().
+        std::size_t glideFrames = 0;
+        float glideStep = 0.0f;
+        float glideTarget = 0.0f;
+        float decay = 1.0f;
+        float lastOutput = 0.0f;
+        bool active = false;
+    };
+    static_assert(sizeof(LoopState) <= 128, "LoopState should fit two cache lines");
+
     void configureFilters();
-    std::vector<float> dispersionCoefficients() const;
-    void initializeWaveguideFromExcitation();
+    // Re-solves the loop for currentFrequency_ and the config, ramping the
+    // tuning allpass over `glideFrames` where it stays on the same rail
+    // length.
+    void retuneLoop(std::size_t glideFrames);
+    // Sets the tuning allpass so the loop hits currentFrequency_ with
+    // `period` samples per rail (0 picks the period too); returns the period.
+    std::size_t solveTuning(std::size_t period);
+    // Grows or shrinks both rails of a sounding string to `period` samples.
+    void resizeRails(std::size_t period);
+    // Grows the rings to hold at least `length` samples per rail, keeping
+    // the pending window. Allocates; a no-op once prepare() has run unless
+    // the note is below kMinFrequencyHz.
+    void ensureRailCapacity(std::size_t length);
+    DispersionCoefficients dispersionCoefficients() const;
+    // Adds gain * a pluck's excitation across both rails.
+    void addExcitationToWaveguide(float gain);
     void injectAtPosition(float position, float value);
 
+    LoopState loop_;
+    SteadyKernel steadyKernel_ = nullptr;
+
     StringConfig config_;
     std::vector<float> excitationBuffer_;
     std::vector<float> waveToBridge_;
     std::vector<float> waveToNut_;
     std::vector<float> outputBuffer_;
-    std::size_t bridgeIndex_ = 0;
-    std::size_t nutIndex_ = 0;
-    float decayFactor_ = 1.0f;
-    bool active_ = false;
-    float lastOutput_ = 0.0f;
+    std::vector<float> noiseScratch_;
+    std::vector<float> impulseScratch_;
+    std::vector<float> bodyScratch_;
+    std::vector<float> excitationCache_;
+    std::optional<ExcitationKey> excitationKey_;
+    const float* bodyResponse_ = nullptr;
+    std::size_t bodyResponseFrames_ = 0;
+    ExcitationPool* excitationPool_ = nullptr;
     unsigned int rngSeed_;
-    std::unique_ptr<dsp::FilterChain> filterChain_;
     float tuningAllpassCoefficient_ = 0.0f;
-    std::size_t hammerSampleIndex_ = 0;
+    std::optional<TuningKey> tuningKey_;
+    std::size_t tunedPeriod_ = 0;
     std::size_t hammerSamplesTotal_ = 0;
     float hammerLowpassState_ = 0.0f;
-    std::mt19937 hammerRng_;
     double currentFrequency_ = 440.0;
     float currentVelocity_ = 1.0f;
     float currentPickPosition_ = 0.5f;
@@ -1,49 +1,100 @@
 #include "synthesis/KarplusStrongSynth.h"
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <utility>
+
+#include "dsp/Denormals.h"
+#include "engine/VoiceRenderPool.h"
 
 namespace synthesis {
 
-KarplusStrongSynth::KarplusStrongSynth(StringConfig config)
-    : baseConfig_(config) {}
+namespace {
 
-std::vector<float> KarplusStrongSynth::renderNotes(
-    const std::vector<NoteEvent>& notes) const {
-    if (notes.empty()) {
-        return {};
+struct StringJob {
+    KarplusStrongString* string = nullptr;
+    float* out = nullptr;
+    std::size_t frames = 0;
+};
+
+void RenderStringJob(void* context, std::size_t job) {
+    const StringJob& j = static_cast<const StringJob*>(context)[job];
+    j.string->processBlock(j.out, j.frames);
+}
+
+}  // namespace
+
+struct KarplusStrongSynth::RenderJob::State {
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> finished{false};
+    std::atomic<std::size_t> framesDone{0};   // summed over both passes
+    std::atomic<std::size_t> framesTotal{0};
+    std::promise<std::size_t> promise;
+    std::shared_future<std::size_t> result = promise.get_future().share();
+};
+
+void KarplusStrongSynth::RenderJob::cancel() {
+    if (state_) {
+        state_->cancelled.store(true, std::memory_order_relaxed);
     }
+}
 
-    double maxTime = 0.0;
-    for (const auto& note : notes) {
-        maxTime = std::max(maxTime, note.startTime + note.duration);
+bool KarplusStrongSynth::RenderJob::cancelled() const {
+    return state_ && state_->cancelled.load(std::memory_order_relaxed);
+}
+
+double KarplusStrongSynth::RenderJob::progress() const {
+    if (!state_) {
+        return 0.0;
     }
-    const std::size_t totalSamples = static_cast<std::size_t>(
-        std::max(0.0, std::ceil(maxTime * baseConfig_.sampleRate)));
-    if (totalSamples == 0) {
-        return {};
+    if (state_->finished.load(std::memory_order_acquire)) {
+        return 1.0;
     }
+    const std::size_t total = state_->framesTotal.load(std::memory_order_relaxed);
+    const std::size_t done = state_->framesDone.load(std::memory_order_relaxed);
+    return total > 0 ? std::min(1.0, static_cast<double>(done) / static_cast<double>(total))
+                     : 0.0;
+}
+
+bool KarplusStrongSynth::RenderJob::finished() const {
+    return state_ && state_->finished.load(std::memory_order_acquire);
+}
 
-    std::vector<std::vector<float>> noteBuffers;
-    std::vector<std::size_t> offsets;
-    noteBuffers.reserve(notes.size());
-        offsets.reserve(notes.size());
+std::shared_future<std::size_t> KarplusStrongSynth::RenderJob::result() const {
+    return state_ ? state_->result : std::shared_future<std::size_t>();
+}
 
-    for (const auto& note : notes) {
-        KarplusStrongString string(baseConfig_);
-        auto samples = string.pluck(note.frequency, note.duration, 1.0f);
-        if (samples.empty()) {
-            continue;
-        }
-        noteBuffers.emplace_back(std::move(samples));
-        const std::size_t offsetSamples =
-            static_cast<std::size_t>(std::max(0.0, std::floor(note.startTime * baseConfig_.sampleRate)));
-        offsets.emplace_back(offsetSamples);
+struct KarplusStrongSynth::SharedString {
+    std::optional<KarplusStrongString> string;  // from the first repeat on
+    std::vector<float> samples;                 // from the note's first frame
+    std::size_t frames = 0;                     // the longest repeat
+    bool silent = false;                        // fell below the threshold; samples end there
+};
+
+KarplusStrongSynth::KarplusStrongSynth(StringConfig config, std::size_t renderThreads)
+    : baseConfig_(config) {
+    if (renderThreads > 0) {
+        renderPool_ = std::make_unique<engine::VoiceRenderPool>(renderThreads);
     }
+}
 
-    auto mixed = mixSamples(noteBuffers, offsets);
-    const float peak = findPeak(mixed);
-    normalize(mixed, peak);
+KarplusStrongSynth::~KarplusStrongSynth() = default;
+KarplusStrongSynth::KarplusStrongSynth(KarplusStrongSynth&&) noexcept = default;
+KarplusStrongSynth& KarplusStrongSynth::operator=(KarplusStrongSynth&&) noexcept = default;
+
+std::vector<float> KarplusStrongSynth::renderNotes(
+    const std::vector<NoteEvent>& notes) const {
+    std::vector<float> mixed;
+    renderNotes(notes, [&mixed](const float* samples, std::size_t frames) {
+        mixed.insert(mixed.end(), samples, samples + frames);
+    });
     return mixed;
 }
 
@@ -58,48 +109,299 @@ std::vector<float> KarplusStrongSynth::renderChord(
     return renderNotes(notes);
 }
 
-std::vector<float> KarplusStrongSynth::mixSamples(
-    const std::vector<std::vector<float>>& noteSamples,
-    const std::vector<std::size_t>& offsets) const {
-    if (noteSamples.empty()) {
-        return {};
+std::size_t KarplusStrongSynth::renderNotes(const std::vector<NoteEvent>& notes,
+                                            const BlockSink& sink,
+                                            bool normalize) const {
+    return renderNotes(notes, sink, normalize, nullptr);
+}
+
+KarplusStrongSynth::RenderJob KarplusStrongSynth::renderAsync(std::vector<NoteEvent> notes,
+                                                              BlockSink sink,
+                                                              const Executor& executor,
+                                                              bool normalize) const {
+    RenderJob job;
+    job.state_ = std::make_shared<RenderJob::State>();
+    auto task = [this, state = job.state_, notes = std::move(notes), sink = std::move(sink),
+                 normalize]() {
+        const std::size_t frames = renderNotes(notes, sink, normalize, state.get());
+        state->finished.store(true, std::memory_order_release);
+        state->promise.set_value(frames);
+    };
+    if (executor) {
+        executor(std::move(task));
+    } else {
+        task();
     }
+    return job;
+}
 
-    std::size_t maxSamples = 0;
-    for (std::size_t i = 0; i < noteSamples.size(); ++i) {
-        maxSamples = std::max(
-            maxSamples, offsets[i] + noteSamples[i].size());
+std::size_t KarplusStrongSynth::renderNotes(const std::vector<NoteEvent>& notes,
+                                            const BlockSink& sink, bool normalize,
+                                            RenderJob::State* job) const {
+    std::size_t sharedCount = 0;
+    const auto plan = planNotes(notes, sharedCount);
+    if (plan.empty() || !sink) {
+        return 0;
+    }
+    std::vector<SharedString> shared(sharedCount);
+    std::size_t spanFrames = 0;
+    for (const auto& note : plan) {
+        if (note.shared != kUnshared) {
+            shared[note.shared].frames = std::max(shared[note.shared].frames, note.frames);
+        }
+        spanFrames = std::max(spanFrames, note.offset + note.frames);
+    }
+    if (job) {
+        job->framesTotal.store(normalize ? 2 * spanFrames : spanFrames,
+                               std::memory_order_relaxed);
     }
 
-    std::vector<float> buffer(maxSamples, 0.0f);
-    for (std::size_t i = 0; i < noteSamples.size(); ++i) {
-        const auto& samples = noteSamples[i];
-        const auto offset = offsets[i];
-        for (std::size_t j = 0; j < samples.size(); ++j) {
-            buffer[offset + j] += samples[j];
+    float gain = 1.0f;
+    if (normalize) {
+        float peak = 0.0f;
+        mixBlocks(
+            plan, shared,
+            [&peak](float* samples, std::size_t frames) {
+                for (std::size_t i = 0; i < frames; ++i) {
+                    peak = std::max(peak, std::abs(samples[i]));
+                }
+            },
+            job);
+        if (job && job->cancelled.load(std::memory_order_relaxed)) {
+            return 0;
+        }
+        if (peak > 1.0f) {
+            gain = 1.0f / peak;
         }
     }
 
-    return buffer;
+    return mixBlocks(
+        plan, shared,
+        [&sink, gain](float* samples, std::size_t frames) {
+            if (gain != 1.0f) {
+                for (std::size_t i = 0; i < frames; ++i) {
+                    samples[i] *= gain;
+                }
+            }
+            sink(samples, frames);
+        },
+        job);
 }
 
-float KarplusStrongSynth::findPeak(const std::vector<float>& buffer) const {
-    float peak = 0.0f;
-    for (float sample : buffer) {
-        peak = std::max(peak, std::abs(sample));
+std::vector<KarplusStrongSynth::PlannedNote> KarplusStrongSynth::planNotes(
+    const std::vector<NoteEvent>& notes, std::size_t& sharedCount) const {
+    std::vector<PlannedNote> plan;
+    sharedCount = 0;
+    const double sampleRate = baseConfig_.sampleRate;
+    if (sampleRate <= 0.0) {
+        return plan;
+    }
+    std::random_device rd;
+    plan.reserve(notes.size());
+    for (const auto& note : notes) {
+        if (note.frequency <= 0.0 || note.duration <= 0.0) {
+            continue;
+        }
+        PlannedNote planned;
+        planned.frequency = note.frequency;
+        planned.offset = static_cast<std::size_t>(
+            std::max(0.0, std::floor(note.startTime * sampleRate)));
+        planned.frames = static_cast<std::size_t>(
+            std::max(0.0, std::floor(note.duration * sampleRate)));
+        // Seed 0 means a fresh random burst per note; draw it once here.
+        planned.seed = baseConfig_.seed != 0 ? baseConfig_.seed : rd();
+        if (planned.frames > 0) {
+            plan.push_back(planned);
+        }
+    }
+
+    // A fixed seed makes a string a function of its frequency alone; a
+    // fresh seed per note never repeats.
+    if (baseConfig_.seed != 0) {
+        std::map<std::uint64_t, std::pair<std::size_t, std::size_t>> byFrequency;  // first, count
+        for (std::size_t i = 0; i < plan.size(); ++i) {
+            auto& [first, count] =
+                byFrequency.try_emplace(std::bit_cast<std::uint64_t>(plan[i].frequency), i, 0)
+                    .first->second;
+            if (++count == 2) {
+                plan[first].shared = sharedCount++;
+            }
+            if (count >= 2) {
+                plan[i].shared = plan[first].shared;
+            }
+        }
     }
-    return peak;
+    return plan;
 }
 
-void KarplusStrongSynth::normalize(std::vector<float>& buffer,
-                                   float peak) const {
-    if (peak <= 1.0f || peak == 0.0f) {
-        return;
+std::size_t KarplusStrongSynth::mixBlocks(
+    const std::vector<PlannedNote>& plan, std::vector<SharedString>& shared,
+    const std::function<void(float*, std::size_t)>& sink, RenderJob::State* job) const {
+    struct Voice {
+        std::optional<KarplusStrongString> string;  // none for shared notes
+        std::size_t index = 0;  // In plan; voices mix in this order.
+    };
+    struct MixSpan {
+        const float* samples = nullptr;  // or from `shared`, once rendered
+        std::size_t shared = kUnshared;
+        std::size_t from = 0;            // Into the shared samples.
+        std::size_t offset = 0;          // Within the block.
+        std::size_t frames = 0;
+    };
+    // Pool helpers flush denormals; match them so threading cannot change
+    // the output.
+    dsp::ScopedDenormalsDisable denormalsGuard;
+
+    std::size_t totalFrames = 0;
+    for (const auto& note : plan) {
+        totalFrames = std::max(totalFrames, note.offset + note.frames);
     }
-    const float invPeak = 1.0f / peak;
-    for (auto& sample : buffer) {
-        sample *= invPeak;
+
+    std::vector<std::size_t> byStart(plan.size());
+    std::iota(byStart.begin(), byStart.end(), std::size_t{0});
+    std::stable_sort(byStart.begin(), byStart.end(), [&plan](std::size_t a, std::size_t b) {
+        return plan[a].offset < plan[b].offset;
+    });
+
+    std::vector<Voice> voices;
+    std::vector<float> block(kRenderBlockFrames);
+    std::vector<float> scratch;   // One kRenderBlockFrames slot per voice.
+    std::vector<StringJob> jobs;
+    std::vector<MixSpan> spans;
+    std::vector<std::size_t> sharedNeeds(shared.size(), 0);  // frames this block
+    std::size_t next = 0;
+    std::size_t blockStart = 0;
+    for (; blockStart < totalFrames; blockStart += kRenderBlockFrames) {
+        // Every string so far stopped early, and no note is left to start.
+        if (silenceThreshold_ > 0.0f && voices.empty() && next == byStart.size() &&
+            blockStart > 0) {
+            break;
+        }
+        if (job && job->cancelled.load(std::memory_order_relaxed)) {
+            break;
+        }
+        const std::size_t frames = std::min(kRenderBlockFrames, totalFrames - blockStart);
+        const std::size_t blockEnd = blockStart + frames;
+
+        while (next < byStart.size() && plan[byStart[next]].offset < blockEnd) {
+            const std::size_t index = byStart[next++];
+            StringConfig config = baseConfig_;
+            config.seed = plan[index].seed;
+            Voice voice{std::nullopt, index};
+            if (plan[index].shared != kUnshared) {
+                SharedString& string = shared[plan[index].shared];
+                if (!string.string) {
+                    string.string.emplace(config);
+                    string.string->start(plan[index].frequency, 1.0f);
+                    string.samples.reserve(string.frames);
+                }
+                if (!string.string->active() && string.samples.empty()) {
+                    continue;
+                }
+            } else {
+                voice.string.emplace(config);
+                voice.string->start(plan[index].frequency, 1.0f);
+                if (!voice.string->active()) {
+                    continue;
+                }
+            }
+            const auto at = std::lower_bound(
+                voices.begin(), voices.end(), index,
+                [](const Voice& v, std::size_t i) { return v.index < i; });
+            voices.insert(at, std::move(voice));
+        }
+
+        if (scratch.size() < voices.size() * kRenderBlockFrames) {
+            scratch.resize(voices.size() * kRenderBlockFrames);
+        }
+        jobs.clear();
+        spans.clear();
+        std::fill(sharedNeeds.begin(), sharedNeeds.end(), 0);
+        std::size_t slot = 0;
+        for (auto& voice : voices) {
+            const PlannedNote& note = plan[voice.index];
+            const std::size_t begin = std::max(note.offset, blockStart);
+            std::size_t end = std::min(note.offset + note.frames, blockEnd);
+            if (note.shared != kUnshared && shared[note.shared].silent) {
+                end = std::min(end, note.offset + shared[note.shared].samples.size());
+            }
+            if (begin >= end) {
+                continue;
+            }
+            if (note.shared != kUnshared) {
+                sharedNeeds[note.shared] = std::max(sharedNeeds[note.shared], end - note.offset);
+                spans.push_back({nullptr, note.shared, begin - note.offset, begin - blockStart,
+                                 end - begin});
+                continue;
+            }
+            float* out = scratch.data() + slot++ * kRenderBlockFrames;
+            jobs.push_back({&*voice.string, out, end - begin});
+            spans.push_back({out, kUnshared, 0, begin - blockStart, end - begin});
+        }
+        // Repeated notes render only past what an earlier one already has.
+        for (std::size_t i = 0; i < shared.size(); ++i) {
+            std::vector<float>& samples = shared[i].samples;
+            const std::size_t have = samples.size();
+            if (sharedNeeds[i] > have && !shared[i].silent) {
+                samples.resize(sharedNeeds[i]);
+                jobs.push_back({&*shared[i].string, samples.data() + have, sharedNeeds[i] - have});
+            }
+        }
+        if (renderPool_ && jobs.size() > 1) {
+            for (std::size_t first = 0; first < jobs.size();
+                 first += engine::VoiceRenderPool::kMaxJobs) {
+                renderPool_->run(&RenderStringJob, jobs.data() + first,
+                                 std::min(engine::VoiceRenderPool::kMaxJobs, jobs.size() - first));
+            }
+        } else {
+            for (std::size_t j = 0; j < jobs.size(); ++j) {
+                RenderStringJob(jobs.data(), j);
+            }
+        }
+
+        std::fill(block.begin(), block.end(), 0.0f);
+        for (const MixSpan& span : spans) {
+            float* out = block.data() + span.offset;
+            const float* rendered = span.shared != kUnshared
+                                        ? shared[span.shared].samples.data() + span.from
+                                        : span.samples;
+            for (std::size_t i = 0; i < span.frames; ++i) {
+                out[i] += rendered[i];
+            }
+        }
+        const float threshold = silenceThreshold_;
+        if (threshold > 0.0f) {
+            for (std::size_t i = 0; i < shared.size(); ++i) {
+                if (sharedNeeds[i] > 0 && !shared[i].silent &&
+                    shared[i].string->storedPeak() < threshold) {
+                    shared[i].silent = true;
+                }
+            }
+        }
+        voices.erase(std::remove_if(voices.begin(), voices.end(),
+                                    [&](const Voice& v) {
+                                        const PlannedNote& note = plan[v.index];
+                                        if (note.offset + note.frames <= blockEnd) {
+                                            return true;
+                                        }
+                                        if (threshold <= 0.0f || note.offset >= blockEnd) {
+                                            return false;
+                                        }
+                                        if (note.shared == kUnshared) {
+                                            return v.string->storedPeak() < threshold;
+                                        }
+                                        const SharedString& string = shared[note.shared];
+                                        return string.silent &&
+                                               note.offset + string.samples.size() <= blockEnd;
+                                    }),
+                     voices.end());
+
+        sink(block.data(), frames);
+        if (job) {
+            job->framesDone.fetch_add(frames, std::memory_order_relaxed);
+        }
     }
+    return std::min(blockStart, totalFrames);
 }
 
 }  // namespace synthesis
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
 #include <vector>
 
 #include "synthesis/KarplusStrongString.h"
 
+namespace engine {
+class VoiceRenderPool;
+}
+
 namespace synthesis {
 
 struct NoteEvent {
@@ -14,21 +23,106 @@ struct NoteEvent {
 
 class KarplusStrongSynth {
 public:
-    explicit KarplusStrongSynth(StringConfig config = {});
+    static constexpr std::size_t kRenderBlockFrames = 1024;
+
+    // Receives consecutive blocks of the mono mix, at most kRenderBlockFrames
+    // frames each.
+    using BlockSink = std::function<void(const float* samples, std::size_t frames)>;
+    // Runs a task, typically on a thread pool of the caller's. It must run
+    // every task it is given, exactly once.
+    using Executor = std::function<void(std::function<void()> task)>;
+
+    // Handle to a renderAsync() job; copies share the job. Safe from any
+    // thread.
+    class RenderJob {
+    public:
+        RenderJob() = default;
+        // Stops the job after the block in progress; the sink gets no
+        // further blocks.
+        void cancel();
+        bool cancelled() const;
+        // Share of the work done, 0..1; a normalised render counts its scan
+        // pass too. 1 once finished, cancelled or not.
+        double progress() const;
+        bool finished() const;
+        // Frames delivered to the sink, ready when the job has finished.
+        std::shared_future<std::size_t> result() const;
+        explicit operator bool() const { return state_ != nullptr; }
+
+    private:
+        friend class KarplusStrongSynth;
+        struct State;
+        std::shared_ptr<State> state_;
+    };
+
+    // renderThreads > 0 adds that many helper threads that render sounding
+    // strings in parallel; each string keeps its own seed and block buffer and
+    // the mix is summed in note order, so output is identical either way.
+    // With a nonzero config seed, notes of the same frequency are all the
+    // same string: it is rendered once per render and the repeats copy it.
+    explicit KarplusStrongSynth(StringConfig config = {}, std::size_t renderThreads = 0);
+    ~KarplusStrongSynth();
+    KarplusStrongSynth(KarplusStrongSynth&&) noexcept;
+    KarplusStrongSynth& operator=(KarplusStrongSynth&&) noexcept;
+
+    // A string whose loop can no longer produce `level` (storedPeak()) stops
+    // before its note's end, leaving silence behind it, and a render whose
+    // strings have all stopped ends there instead of at the last note's end.
+    // 0 (the default) renders every note to its full duration.
+    void setSilenceThreshold(float level) { silenceThreshold_ = std::max(0.0f, level); }
+    float silenceThreshold() const { return silenceThreshold_; }
 
     std::vector<float> renderNotes(const std::vector<NoteEvent>& notes) const;
     std::vector<float> renderChord(const std::vector<double>& frequencies,
                                    double durationSeconds) const;
 
+    // Streams the same mix as renderNotes() in fixed blocks; only sounding
+    // strings and one block buffer are held. With normalize, a scan-only
+    // first pass finds the peak and the second pass scales by it (peaks above
+    // 1 only). Returns the number of frames delivered, which a silence
+    // threshold can make fewer than the notes span.
+    std::size_t renderNotes(const std::vector<NoteEvent>& notes,
+                            const BlockSink& sink,
+                            bool normalize = true) const;
+
+    // The streaming renderNotes() as a job handed to `executor` (run on the
+    // calling thread, before returning, when empty); the sink is called on
+    // whichever thread runs it. The synth must outlive the job and, with
+    // render threads, run one render at a time.
+    RenderJob renderAsync(std::vector<NoteEvent> notes, BlockSink sink,
+                          const Executor& executor, bool normalize = true) const;
+
 private:
-    std::vector<float> mixSamples(
-        const std::vector<std::vector<float>>& noteSamples,
-        const std::vector<std::size_t>& offsets) const;
+    static constexpr std::size_t kUnshared = static_cast<std::size_t>(-1);
+
+    struct PlannedNote {
+        double frequency = 0.0;
+        std::size_t offset = 0;  // First frame.
+        std::size_t frames = 0;
+        unsigned int seed = 0;
+        std::size_t shared = kUnshared;  // SharedString of a repeated note
+    };
+    // A repeated note's string and what it has rendered so far; defined in
+    // the .cpp.
+    struct SharedString;
 
-    float findPeak(const std::vector<float>& buffer) const;
-    void normalize(std::vector<float>& buffer, float peak) const;
+    // Frame spans and per-note seeds, fixed up front so both passes of a
+    // normalised render hear the same strings. Notes that repeat share one
+    // of `sharedCount` strings.
+    std::vector<PlannedNote> planNotes(const std::vector<NoteEvent>& notes,
+                                       std::size_t& sharedCount) const;
+    // renderNotes() reporting to, and stopping for, `job` when not null.
+    std::size_t renderNotes(const std::vector<NoteEvent>& notes, const BlockSink& sink,
+                            bool normalize, RenderJob::State* job) const;
+    // `shared` carries the repeated notes' samples from pass to pass.
+    std::size_t mixBlocks(const std::vector<PlannedNote>& plan,
+                          std::vector<SharedString>& shared,
+                          const std::function<void(float*, std::size_t)>& sink,
+                          RenderJob::State* job) const;
 
     StringConfig baseConfig_;
+    float silenceThreshold_ = 0.0f;
+    std::unique_ptr<engine::VoiceRenderPool> renderPool_;
 };
 
 }  // namespace synthesis
@@ -0,0 +1,103 @@
+#include "synthesis/StringPreviewRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace synthesis {
+
+namespace {
+
+// Finer than any knob step, coarse enough that a knob returning to a
+// value it just had hits the cache.
+constexpr double kParamQuantum = 1.0 / 4096.0;
+constexpr double kFrequencyQuantum = 0.01;  // Hz
+
+std::int64_t Quantize(double value, double quantum) {
+    return static_cast<std::int64_t>(std::llround(value / quantum));
+}
+
+}  // namespace
+
+std::vector<std::int64_t> StringPreviewRenderer::MakeKey(const StringConfig& config,
+                                                         double frequency) {
+    return {
+        Quantize(config.sampleRate, 1.0),
+        Quantize(config.decay, kParamQuantum / 16.0),  // decay lives near 1
+        Quantize(config.brightness, kParamQuantum),
+        Quantize(config.excitationBrightness, kParamQuantum),
+        Quantize(config.excitationVelocity, kParamQuantum),
+        Quantize(config.excitationMix, kParamQuantum),
+        Quantize(config.pickPosition, kParamQuantum),
+        Quantize(config.dispersionAmount, kParamQuantum),
+        Quantize(config.bodyTone, kParamQuantum),
+        Quantize(config.bodySize, kParamQuantum),
+        Quantize(config.roomAmount, kParamQuantum),
+        config.roomIrIndex,
+        static_cast<std::int64_t>(config.noiseType),
+        config.enableLowpass ? 1 : 0,
+        static_cast<std::int64_t>(config.seed),
+        static_cast<std::int64_t>(config.excitationMode),
+        static_cast<std::int64_t>(config.excitationType),
+        Quantize(frequency, kFrequencyQuantum),
+    };
+}
+
+bool StringPreviewRenderer::render(const StringConfig& config,
+                                   float masterGain,
+                                   double frequency,
+                                   const std::function<bool()>& cancelled,
+                                   Preview& out) {
+    if (frequency <= 0.0 || config.sampleRate <= 0.0) {
+        return false;
+    }
+    const auto isCancelled = [&]() { return cancelled && cancelled(); };
+    const auto scaled = [masterGain](const std::vector<float>& samples) {
+        std::vector<float> result(samples);
+        for (auto& sample : result) {
+            sample *= masterGain;
+        }
+        return result;
+    };
+
+    auto key = MakeKey(config, frequency);
+    const auto cached = std::find_if(cache_.begin(), cache_.end(),
+                                     [&](const Entry& entry) { return entry.key == key; });
+    if (cached != cache_.end()) {
+        cached->lastUse = ++useCounter_;
+        ++cacheHits_;
+        out.waveform = scaled(cached->preview.waveform);
+        out.excitation = scaled(cached->preview.excitation);
+        return true;
+    }
+
+    // Same sequence as pluck(): start, snapshot the excitation, then run the
+    // loop. Done in chunks so a superseded request stops early.
+    string_.updateConfig(config);
+    string_.start(frequency, 1.0f);
+    Preview preview;
+    preview.excitation = string_.excitationBufferPreview(kExcitationSamples);
+    const std::size_t total = string_.active() ? kWaveformSamples : 0;
+    preview.waveform.assign(total, 0.0f);
+    for (std::size_t offset = 0; offset < total; offset += kChunkSamples) {
+        if (isCancelled()) {
+            return false;
+        }
+        string_.processBlock(preview.waveform.data() + offset,
+                             std::min(kChunkSamples, total - offset));
+    }
+    ++renders_;
+
+    out.waveform = scaled(preview.waveform);
+    out.excitation = scaled(preview.excitation);
+
+    if (cache_.size() >= kCacheEntries) {
+        const auto oldest = std::min_element(
+            cache_.begin(), cache_.end(),
+            [](const Entry& a, const Entry& b) { return a.lastUse < b.lastUse; });
+        cache_.erase(oldest);
+    }
+    cache_.push_back({std::move(key), std::move(preview), ++useCounter_});
+    return true;
+}
+
+}  // namespace synthesis
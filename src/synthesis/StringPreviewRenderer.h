@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "synthesis/KarplusStrongString.h"
+
+namespace synthesis {
+
+// Renders the UI's waveform/excitation previews. One string instance is
+// reused for every request, recent results are cached by quantised
+// (config, frequency), and a render is abandoned between chunks as soon as
+// `cancelled` reports that a newer request arrived. Not thread-safe: owned
+// by the preview worker.
+class StringPreviewRenderer {
+public:
+    static constexpr std::size_t kWaveformSamples = 2048;
+    static constexpr std::size_t kExcitationSamples = 1024;
+    static constexpr std::size_t kCacheEntries = 32;
+    static constexpr std::size_t kChunkSamples = 256;
+
+    struct Preview {
+        std::vector<float> waveform;
+        std::vector<float> excitation;
+    };
+
+    // False (and `out` untouched) if cancelled or frequency/sample rate are
+    // not positive.
+    // Samples are scaled by masterGain; the cache keeps them unscaled.
+    bool render(const StringConfig& config,
+                float masterGain,
+                double frequency,
+                const std::function<bool()>& cancelled,
+                Preview& out);
+
+    std::size_t cacheHits() const { return cacheHits_; }
+    std::size_t renders() const { return renders_; }
+
+private:
+    struct Entry {
+        std::vector<std::int64_t> key;
+        Preview preview;
+        std::uint64_t lastUse = 0;
+    };
+
+    static std::vector<std::int64_t> MakeKey(const StringConfig& config, double frequency);
+
+    KarplusStrongString string_;
+    std::vector<Entry> cache_;
+    std::uint64_t useCounter_ = 0;
+    std::size_t cacheHits_ = 0;
+    std::size_t renders_ = 0;
+};
+
+}  // namespace synthesis
@@ -0,0 +1,147 @@
+#include "win/app/FrameScheduler.h"
+
+#include <dwmapi.h>
+
+namespace winapp {
+
+namespace {
+// Used when DWM composition is unavailable and DwmFlush returns at once.
+constexpr auto kFallbackFramePeriod = std::chrono::microseconds(16667);
+}  // namespace
+
+FrameScheduler::~FrameScheduler() {
+    stop();
+}
+
+void FrameScheduler::start(HWND window, UINT message) {
+    if (thread_.joinable()) {
+        return;
+    }
+    window_ = window;
+    message_ = message;
+    stop_ = false;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void FrameScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    redrawRequested_ = false;
+    messagePosted_ = false;
+    deadlines_.fill(std::nullopt);
+}
+
+void FrameScheduler::requestFrame() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (redrawRequested_) {
+            return;  // already pending: coalesce
+        }
+        redrawRequested_ = true;
+    }
+    cv_.notify_one();
+}
+
+void FrameScheduler::schedule(std::size_t task, std::chrono::milliseconds delay) {
+    if (task >= kMaxTasks) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deadlines_[task] = Clock::now() + delay;
+    }
+    cv_.notify_one();
+}
+
+void FrameScheduler::cancel(std::size_t task) {
+    if (task >= kMaxTasks) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    deadlines_[task].reset();
+}
+
+FrameScheduler::Frame FrameScheduler::takeFrame() {
+    Frame frame;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        for (std::size_t i = 0; i < kMaxTasks; ++i) {
+            if (deadlines_[i] && *deadlines_[i] <= now) {
+                frame.dueTasks |= 1u << i;
+                deadlines_[i].reset();
+            }
+        }
+        frame.redraw = redrawRequested_;
+        redrawRequested_ = false;
+        messagePosted_ = false;
+    }
+    cv_.notify_one();  // a deadline may still be pending
+    return frame;
+}
+
+bool FrameScheduler::takeRedrawRequest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool requested = redrawRequested_;
+    redrawRequested_ = false;
+    return requested;
+}
+
+std::optional<FrameScheduler::Clock::time_point> FrameScheduler::earliestDeadlineLocked() const {
+    std::optional<Clock::time_point> earliest;
+    for (const auto& deadline : deadlines_) {
+        if (deadline && (!earliest || *deadline < *earliest)) {
+            earliest = deadline;
+        }
+    }
+    return earliest;
+}
+
+bool FrameScheduler::anyDueLocked(Clock::time_point now) const {
+    for (const auto& deadline : deadlines_) {
+        if (deadline && *deadline <= now) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FrameScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (messagePosted_) {
+            // The UI thread has not caught up; takeFrame() wakes us.
+            cv_.wait(lock, [this]() { return stop_ || !messagePosted_; });
+            continue;
+        }
+        if (!redrawRequested_ && !anyDueLocked(Clock::now())) {
+            if (const auto deadline = earliestDeadlineLocked()) {
+                cv_.wait_until(lock, *deadline);
+            } else {
+                cv_.wait(lock);
+            }
+            continue;  // re-evaluate: woken by a request, a deadline or stop
+        }
+
+        // Align to the compositor so everything requested until now lands
+        // in the same present.
+        lock.unlock();
+        const auto before = Clock::now();
+        if (FAILED(DwmFlush())) {
+            std::this_thread::sleep_until(before + kFallbackFramePeriod);
+        }
+        lock.lock();
+        if (stop_) {
+            break;
+        }
+        messagePosted_ = PostMessageW(window_, message_, 0, 0) != FALSE;
+    }
+}
+
+}  // namespace winapp
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <windows.h>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace winapp {
+
+// Paces UI work to the display. Requests made between two compositions are
+// coalesced into one frame message, posted right after DWM's next vblank
+// (DwmFlush), so one present covers every change. Deadline tasks (preview
+// debounce, debug stats) ride on the same messages instead of WM_TIMER.
+// With nothing requested and no deadline pending the pacing thread blocks,
+// so an idle window causes no wakeups.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t kMaxTasks = 8;
+
+    // What a frame message asks the UI thread to do.
+    struct Frame {
+        bool redraw = false;
+        std::uint32_t dueTasks = 0;  // bit i: task i reached its deadline
+
+        bool taskDue(std::size_t task) const { return (dueTasks >> task) & 1u; }
+    };
+
+    FrameScheduler() = default;
+    ~FrameScheduler();
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Frame messages go to `window` as `message`.
+    void start(HWND window, UINT message);
+    void stop();
+
+    // Asks for a redraw at the next vblank. Cheap; call on every change.
+    void requestFrame();
+    // Runs `task` (0..kMaxTasks-1) with the first frame after `delay`;
+    // rescheduling replaces the pending deadline.
+    void schedule(std::size_t task, std::chrono::milliseconds delay);
+    void cancel(std::size_t task);
+
+    // UI thread, on the frame message: takes what is due and allows the
+    // next message to be posted.
+    Frame takeFrame();
+    // Claims a redraw requested since takeFrame(), so work done while
+    // handling a frame is drawn in it instead of the next one.
+    bool takeRedrawRequest();
+
+private:
+    void run();
+    std::optional<Clock::time_point> earliestDeadlineLocked() const;
+    bool anyDueLocked(Clock::time_point now) const;
+
+    HWND window_ = nullptr;
+    UINT message_ = 0;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool stop_ = false;
+    bool redrawRequested_ = false;
+    // A frame message is queued and not yet taken; nothing more is posted.
+    bool messagePosted_ = false;
+    std::array<std::optional<Clock::time_point>, kMaxTasks> deadlines_{};
+};
+
+}  // namespace winapp
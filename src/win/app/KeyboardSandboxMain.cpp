@@ -17,6 +17,7 @@
 #include "win/ui/DebugOverlay.h"
 #include "win/ui/KeyboardKeymap.h"
 #include "win/ui/NunitoFont.h"
+#include "win/ui/UiBenchmark.h"
 #include "win/ui/VirtualKeyboard.h"
 
 using Microsoft::WRL::ComPtr;
@@ -52,6 +53,9 @@ winui::DebugOverlayMode g_debugOverlayMode = winui::DebugOverlayMode::kOff;
 winui::DebugOverlayPalette g_overlayPalette = winui::MakeUnifiedDebugOverlayPalette();
 winui::DebugBoxRenderer g_debugRenderer;
 std::optional<winui::DebugBoxModel> g_debugModel;
+// --benchmark N 时启用，否则保持关闭。
+winui::UiFrameBenchmark g_benchmark;
+int g_benchmarkDrawCalls = -1;
 
 bool g_trackingMouseLeave = false;
 bool g_hasPointerPosition = false;
@@ -203,9 +207,13 @@ HRESULT CreateDeviceResources(HWND hwnd) {
     GetClientRect(hwnd, &rc);
     const D2D1_SIZE_U size =
         D2D1::SizeU(rc.right - rc.left, rc.bottom - rc.top);
+    // 基准测试时不等待垂直同步，帧耗时才反映实际绘制开销。
+    const D2D1_PRESENT_OPTIONS presentOptions = g_benchmark.active()
+                                                    ? D2D1_PRESENT_OPTIONS_IMMEDIATELY
+                                                    : D2D1_PRESENT_OPTIONS_NONE;
     HRESULT hr = g_d2dFactory->CreateHwndRenderTarget(
         D2D1::RenderTargetProperties(),
-        D2D1::HwndRenderTargetProperties(hwnd, size),
+        D2D1::HwndRenderTargetProperties(hwnd, size, presentOptions),
         &g_renderTarget);
     if (FAILED(hr)) {
         return hr;
@@ -277,24 +285,32 @@ void OnRender() {
     const auto size = g_renderTarget->GetSize();
     LayoutKeyboard(size.width, size.height);
 
-    g_renderTarget->BeginDraw();
-    g_renderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
-    g_renderTarget->Clear(D2D1::ColorF(0.02f, 0.02f, 0.04f, 1.0f));
-    if (g_backgroundBrush) {
-        g_renderTarget->FillRectangle(
-            D2D1::RectF(0.0f, 0.0f, size.width, size.height),
-            g_backgroundBrush.Get());
-    }
+    auto drawScene = [size](ID2D1RenderTarget* target) {
+        target->SetTransform(D2D1::Matrix3x2F::Identity());
+        target->Clear(D2D1::ColorF(0.02f, 0.02f, 0.04f, 1.0f));
+        if (g_backgroundBrush) {
+            target->FillRectangle(
+                D2D1::RectF(0.0f, 0.0f, size.width, size.height),
+                g_backgroundBrush.Get());
+        }
 
-    g_keyboard.draw(g_renderTarget.Get(), g_keyboardColors, g_textFormat.Get());
+        g_keyboard.draw(target, g_keyboardColors, g_textFormat.Get());
 
-    if (g_debugOverlayMode == winui::DebugOverlayMode::kBoxModel && g_debugModel) {
-        winui::ScopedAntialiasMode scoped(g_renderTarget.Get(),
-                                          D2D1_ANTIALIAS_MODE_ALIASED);
-        g_debugRenderer.render(g_renderTarget.Get(), *g_debugModel, true);
-    }
+        if (g_debugOverlayMode == winui::DebugOverlayMode::kBoxModel && g_debugModel) {
+            winui::ScopedAntialiasMode scoped(target, D2D1_ANTIALIAS_MODE_ALIASED);
+            g_debugRenderer.render(target, *g_debugModel, true);
+        }
+    };
 
-    const HRESULT hr = g_renderTarget->EndDraw();
+    HRESULT hr = S_OK;
+    if (g_benchmark.running()) {
+        // 基准测试：先录制为命令列表，统计绘制调用数。
+        hr = winui::DrawFrameCounted(g_renderTarget.Get(), drawScene, &g_benchmarkDrawCalls);
+    } else {
+        g_renderTarget->BeginDraw();
+        drawScene(g_renderTarget.Get());
+        hr = g_renderTarget->EndDraw();
+    }
     if (hr == D2DERR_RECREATE_TARGET) {
         DiscardDeviceResources();
     }
@@ -500,6 +516,44 @@ HWND CreateMainWindow(HINSTANCE instance) {
                            width, height, nullptr, nullptr, instance, nullptr);
 }
 
+// --benchmark N：按键自低向高依次按下、抬起，共 N 帧，每帧立即重绘，结束后写出报告并退出。
+int RunBenchmarkLoop(HWND hwnd) {
+    constexpr int kFramesPerKey = 8;
+    const int keyCount = kDefaultOctaveCount * 12 + 1;
+    int heldNote = -1;
+    MSG msg{};
+    while (g_benchmark.running() && g_mainWindow) {
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                return static_cast<int>(msg.wParam);
+            }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        const int frame = g_benchmark.frame();
+        if (frame % kFramesPerKey == 0) {
+            if (heldNote >= 0) {
+                g_keyboard.releaseKeyByMidi(heldNote);
+            }
+            heldNote = kBaseMidiNote + (frame / kFramesPerKey) % keyCount;
+            g_keyboard.pressKeyByMidi(heldNote);
+        }
+
+        g_benchmark.beginFrame();
+        g_benchmarkDrawCalls = -1;
+        RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
+        g_benchmark.endFrame(g_benchmarkDrawCalls);
+    }
+    g_keyboard.releaseAllKeys();
+    g_benchmark.writeReport("SatoriKeyboardSandbox");
+    DestroyWindow(hwnd);
+    while (GetMessage(&msg, nullptr, 0, 0)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    return static_cast<int>(msg.wParam);
+}
+
 int RunKeyboardSandbox(HINSTANCE instance, int show) {
     const HRESULT hrCom = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
     if (FAILED(hrCom)) {
@@ -521,9 +575,17 @@ int RunKeyboardSandbox(HINSTANCE instance, int show) {
         return -1;
     }
 
+    // 在首次绘制之前确定，渲染目标按此选择呈现方式。
+    g_benchmark = winui::UiFrameBenchmark(winui::BenchmarkFramesFromCommandLine());
     ShowWindow(hwnd, show);
     UpdateWindow(hwnd);
 
+    if (g_benchmark.active()) {
+        const int exitCode = RunBenchmarkLoop(hwnd);
+        CoUninitialize();
+        return exitCode;
+    }
+
     MSG msg;
     while (GetMessage(&msg, nullptr, 0, 0)) {
         TranslateMessage(&msg);
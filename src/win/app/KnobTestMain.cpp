@@ -19,6 +19,7 @@
 #include "win/ui/DebugOverlay.h"
 #include "win/ui/NunitoFont.h"
 #include "win/ui/ParameterKnob.h"
+#include "win/ui/UiBenchmark.h"
 
 // 测试程序：仅在窗口中央绘制一个 ParameterKnob，用于独立观察 UI/UX。
 
@@ -49,6 +50,9 @@ std::unique_ptr<winui::ParameterKnob> g_knob;
 winui::DebugOverlayMode g_debugOverlayMode = winui::DebugOverlayMode::kOff;
 winui::DebugBoxRenderer g_debugRenderer;
 std::optional<winui::DebugBoxModel> g_hoverDebugModel;
+// --benchmark N 时启用，否则保持关闭。
+winui::UiFrameBenchmark g_benchmark;
+int g_benchmarkDrawCalls = -1;
 bool g_trackingMouseLeave = false;
 bool g_hasPointerPosition = false;
 float g_lastPointerX = 0.0f;
@@ -304,9 +308,13 @@ HRESULT CreateDeviceResources(HWND hwnd) {
     const UINT height = static_cast<UINT>(rc.bottom - rc.top);
 
     const D2D1_SIZE_U size = D2D1::SizeU(width, height);
+    // 基准测试时不等待垂直同步，帧耗时才反映实际绘制开销。
+    const D2D1_PRESENT_OPTIONS presentOptions = g_benchmark.active()
+                                                    ? D2D1_PRESENT_OPTIONS_IMMEDIATELY
+                                                    : D2D1_PRESENT_OPTIONS_NONE;
     HRESULT hr = g_d2dFactory->CreateHwndRenderTarget(
         D2D1::RenderTargetProperties(),
-        D2D1::HwndRenderTargetProperties(hwnd, size),
+        D2D1::HwndRenderTargetProperties(hwnd, size, presentOptions),
         &g_renderTarget);
     if (FAILED(hr)) {
         return hr;
@@ -381,27 +389,35 @@ void OnRender() {
     const auto size = g_renderTarget->GetSize();
     LayoutKnob(size.width, size.height);
 
-    g_renderTarget->BeginDraw();
-    g_renderTarget->SetTransform(D2D1::Matrix3x2F::Identity());
+    auto drawScene = [size](ID2D1RenderTarget* target) {
+        target->SetTransform(D2D1::Matrix3x2F::Identity());
 
-    // 背景整体填充为深色，突出中间的旋钮。
-    g_renderTarget->Clear(D2D1::ColorF(0.03f, 0.03f, 0.05f, 1.0f));
-    if (g_backgroundBrush) {
-        const auto rect = D2D1::RectF(
-            0.0f, 0.0f, size.width, size.height);
-        g_renderTarget->FillRectangle(rect, g_backgroundBrush.Get());
-    }
-
-    g_knob->draw(g_renderTarget.Get(), g_baseBrush.Get(), g_fillBrush.Get(),
-                 g_accentBrush.Get(), g_textBrush.Get(), g_textFormat.Get());
-    if (g_debugOverlayMode == winui::DebugOverlayMode::kBoxModel &&
-        g_hoverDebugModel) {
-        winui::ScopedAntialiasMode scoped(g_renderTarget.Get(),
-                                          D2D1_ANTIALIAS_MODE_ALIASED);
-        g_debugRenderer.render(g_renderTarget.Get(), *g_hoverDebugModel, true);
-    }
+        // 背景整体填充为深色，突出中间的旋钮。
+        target->Clear(D2D1::ColorF(0.03f, 0.03f, 0.05f, 1.0f));
+        if (g_backgroundBrush) {
+            const auto rect = D2D1::RectF(
+                0.0f, 0.0f, size.width, size.height);
+            target->FillRectangle(rect, g_backgroundBrush.Get());
+        }
 
-    const HRESULT hr = g_renderTarget->EndDraw();
+        g_knob->draw(target, g_baseBrush.Get(), g_fillBrush.Get(),
+                     g_accentBrush.Get(), g_textBrush.Get(), g_textFormat.Get());
+        if (g_debugOverlayMode == winui::DebugOverlayMode::kBoxModel &&
+            g_hoverDebugModel) {
+            winui::ScopedAntialiasMode scoped(target, D2D1_ANTIALIAS_MODE_ALIASED);
+            g_debugRenderer.render(target, *g_hoverDebugModel, true);
+        }
+    };
+
+    HRESULT hr = S_OK;
+    if (g_benchmark.running()) {
+        // 基准测试：先录制为命令列表，统计绘制调用数。
+        hr = winui::DrawFrameCounted(g_renderTarget.Get(), drawScene, &g_benchmarkDrawCalls);
+    } else {
+        g_renderTarget->BeginDraw();
+        drawScene(g_renderTarget.Get());
+        hr = g_renderTarget->EndDraw();
+    }
     if (hr == D2DERR_RECREATE_TARGET) {
         DiscardDeviceResources();
     }
@@ -571,6 +587,35 @@ HWND CreateMainWindow(HINSTANCE instance) {
         nullptr, nullptr, instance, nullptr);
 }
 
+// --benchmark N：旋钮往复扫动 N 帧，每帧立即重绘而不等待输入，结束后写出报告并退出。
+int RunBenchmarkLoop(HWND hwnd) {
+    constexpr float kSweepPerFrame = 6.2831853f / 120.0f;  // 一个来回 120 帧
+    MSG msg{};
+    while (g_benchmark.running() && g_mainWindow && g_knob) {
+        while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+            if (msg.message == WM_QUIT) {
+                return static_cast<int>(msg.wParam);
+            }
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
+        }
+        const float phase = static_cast<float>(g_benchmark.frame()) * kSweepPerFrame;
+        g_knob->setValue(0.5f + 0.5f * std::sin(phase), false);
+
+        g_benchmark.beginFrame();
+        g_benchmarkDrawCalls = -1;
+        RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
+        g_benchmark.endFrame(g_benchmarkDrawCalls);
+    }
+    g_benchmark.writeReport("SatoriKnobSandbox");
+    DestroyWindow(hwnd);
+    while (GetMessage(&msg, nullptr, 0, 0)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+    return static_cast<int>(msg.wParam);
+}
+
 int RunKnobTestApp(HINSTANCE instance, int show) {
     const HRESULT hrCom =
         CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
@@ -595,9 +640,17 @@ int RunKnobTestApp(HINSTANCE instance, int show) {
         return -1;
     }
 
+    // 在首次绘制之前确定，渲染目标按此选择呈现方式。
+    g_benchmark = winui::UiFrameBenchmark(winui::BenchmarkFramesFromCommandLine());
     ShowWindow(hwnd, show);
     UpdateWindow(hwnd);
 
+    if (g_benchmark.active()) {
+        const int exitCode = RunBenchmarkLoop(hwnd);
+        CoUninitialize();
+        return exitCode;
+    }
+
     MSG msg;
     while (GetMessage(&msg, nullptr, 0, 0)) {
         TranslateMessage(&msg);
@@ -0,0 +1,177 @@
+#include "win/app/RawKeyboardInput.h"
+
+#include <utility>
+
+#include "engine/Tracer.h"
+
+namespace winapp {
+
+namespace {
+
+const wchar_t kWindowClassName[] = L"SatoriRawKeyboard";
+constexpr UINT kMsgReleaseAll = WM_APP + 1;
+// HID generic desktop page, keyboard usage.
+constexpr USHORT kUsagePageGeneric = 0x01;
+constexpr USHORT kUsageKeyboard = 0x06;
+
+std::int64_t NowTicks() {
+    LARGE_INTEGER now{};
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+}  // namespace
+
+RawKeyboardInput::~RawKeyboardInput() {
+    close();
+}
+
+bool RawKeyboardInput::open(HWND focusWindow, KeyHandler handler) {
+    close();
+    if (!focusWindow || !handler) {
+        return false;
+    }
+    focusWindow_ = focusWindow;
+    handler_ = std::move(handler);
+
+    HANDLE ready = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!ready) {
+        handler_ = nullptr;
+        return false;
+    }
+    bool started = false;
+    thread_ = std::thread([this, &started, ready]() { run(&started, ready); });
+    WaitForSingleObject(ready, INFINITE);
+    CloseHandle(ready);
+    if (!started) {
+        thread_.join();
+        handler_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void RawKeyboardInput::close() {
+    if (thread_.joinable()) {
+        // The window unregisters and ends the loop; after the join no
+        // handler call is running.
+        PostMessageW(messageWindow_, WM_CLOSE, 0, 0);
+        thread_.join();
+    }
+    messageWindow_ = nullptr;
+    handler_ = nullptr;
+    held_.fill(false);
+}
+
+void RawKeyboardInput::releaseAll() {
+    if (messageWindow_) {
+        PostMessageW(messageWindow_, kMsgReleaseAll, 0, 0);
+    }
+}
+
+void RawKeyboardInput::run(bool* started, HANDLE ready) {
+    engine::SetTraceThreadName("keyboard input");
+    // Above the UI thread, so a busy paint cannot hold a key back.
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+    const HINSTANCE instance = GetModuleHandleW(nullptr);
+    WNDCLASSEXW wc{};
+    wc.cbSize = sizeof(wc);
+    wc.lpfnWndProc = &RawKeyboardInput::WindowProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = kWindowClassName;
+    RegisterClassExW(&wc);  // fails harmlessly when already registered
+
+    HWND window = CreateWindowExW(0, kWindowClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE,
+                                  nullptr, instance, this);
+    // INPUTSINK: a message-only window is never in the foreground, so input
+    // has to be taken regardless and filtered by focusWindow_ below.
+    RAWINPUTDEVICE device{kUsagePageGeneric, kUsageKeyboard, RIDEV_INPUTSINK, window};
+    if (!window || !RegisterRawInputDevices(&device, 1, sizeof(device))) {
+        if (window) {
+            DestroyWindow(window);
+        }
+        SetEvent(ready);
+        return;
+    }
+    messageWindow_ = window;
+    *started = true;
+    SetEvent(ready);
+
+    MSG msg;
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        DispatchMessageW(&msg);
+    }
+}
+
+LRESULT CALLBACK RawKeyboardInput::WindowProc(HWND hwnd, UINT msg, WPARAM wparam,
+                                              LPARAM lparam) {
+    if (msg == WM_NCCREATE) {
+        const auto* create = reinterpret_cast<const CREATESTRUCTW*>(lparam);
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA,
+                          reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+    }
+    auto* self = reinterpret_cast<RawKeyboardInput*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    switch (msg) {
+        case WM_INPUT:
+            if (self) {
+                self->handleInput(reinterpret_cast<HRAWINPUT>(lparam));
+            }
+            break;  // DefWindowProc frees the input
+        case kMsgReleaseAll:
+            if (self) {
+                self->releaseHeld(NowTicks());
+            }
+            return 0;
+        case WM_CLOSE:
+            DestroyWindow(hwnd);
+            return 0;
+        case WM_DESTROY: {
+            RAWINPUTDEVICE device{kUsagePageGeneric, kUsageKeyboard, RIDEV_REMOVE, nullptr};
+            RegisterRawInputDevices(&device, 1, sizeof(device));
+            PostQuitMessage(0);
+            return 0;
+        }
+        default:
+            break;
+    }
+    return DefWindowProcW(hwnd, msg, wparam, lparam);
+}
+
+void RawKeyboardInput::handleInput(HRAWINPUT input) {
+    // Stamped before anything else; this is the time the note is meant for.
+    const std::int64_t ticks = NowTicks();
+    RAWINPUT raw{};
+    UINT size = sizeof(raw);
+    if (GetRawInputData(input, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) ==
+            static_cast<UINT>(-1) ||
+        raw.header.dwType != RIM_TYPEKEYBOARD) {
+        return;
+    }
+    const RAWKEYBOARD& keyboard = raw.data.keyboard;
+    const UINT vk = keyboard.VKey;
+    if (vk == 0 || vk >= held_.size()) {
+        return;  // 0xFF: the fake half of an escaped scan code
+    }
+    const bool pressed = (keyboard.Flags & RI_KEY_BREAK) == 0;
+    if (pressed) {
+        if (held_[vk] || GetForegroundWindow() != focusWindow_) {
+            return;  // autorepeat, or typing into another window
+        }
+    } else if (!held_[vk]) {
+        return;
+    }
+    held_[vk] = pressed;
+    handler_({vk, pressed, ticks});
+}
+
+void RawKeyboardInput::releaseHeld(std::int64_t hostTicks) {
+    for (UINT vk = 0; vk < held_.size(); ++vk) {
+        if (held_[vk]) {
+            held_[vk] = false;
+            handler_({vk, false, hostTicks});
+        }
+    }
+}
+
+}  // namespace winapp
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <windows.h>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace winapp {
+
+struct RawKeyEvent {
+    UINT virtualKey = 0;
+    bool pressed = false;
+    // QueryPerformanceCounter time the input thread received the key.
+    std::int64_t hostTicks = 0;
+};
+
+// PC keyboard through Raw Input (WM_INPUT) on a thread of its own, so notes
+// are stamped and handed on without waiting behind paints and other UI
+// messages. Keys only press while `focusWindow` is the foreground window;
+// autorepeat is dropped and a key held when focus goes is released by
+// releaseAll(). The legacy WM_KEYDOWN/WM_KEYUP messages are still sent.
+//
+// The handler runs on the input thread; like MidiInput's it must be quick
+// and must not block (engine event queues are fine; UI work should be posted).
+class RawKeyboardInput {
+public:
+    using KeyHandler = std::function<void(const RawKeyEvent&)>;
+
+    RawKeyboardInput() = default;
+    ~RawKeyboardInput();
+    RawKeyboardInput(const RawKeyboardInput&) = delete;
+    RawKeyboardInput& operator=(const RawKeyboardInput&) = delete;
+
+    // False if the thread, its window or the registration failed.
+    bool open(HWND focusWindow, KeyHandler handler);
+    void close();
+    bool isOpen() const { return thread_.joinable(); }
+
+    // Any thread: has the input thread release every key it reported held.
+    void releaseAll();
+
+private:
+    static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+    void run(bool* started, HANDLE ready);
+    void handleInput(HRAWINPUT input);
+    void releaseHeld(std::int64_t hostTicks);
+
+    HWND focusWindow_ = nullptr;
+    HWND messageWindow_ = nullptr;
+    KeyHandler handler_;
+    std::thread thread_;
+    std::array<bool, 256> held_{};  // input thread only
+};
+
+}  // namespace winapp
@@ -1,9 +1,12 @@
 #include <windows.h>
 #include <windowsx.h>
+#include <shellapi.h>
 
 #include <cmath>
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cwchar>
 #include <cstdint>
@@ -17,13 +20,24 @@
 #include <unordered_map>
 #include <vector>
 
+#include "dsp/SpectrumAnalyzer.h"
+#include "engine/MemoryUsage.h"
+#include "engine/MidiNote.h"
+#include "engine/RealtimeThread.h"
+#include "engine/RoomPartitionTuner.h"
+#include "engine/Tracer.h"
 #include "synthesis/KarplusStrongString.h"
+#include "synthesis/StringPreviewRenderer.h"
+#include "win/app/FrameScheduler.h"
 #include "win/app/PresetManager.h"
+#include "win/app/RawKeyboardInput.h"
+#include "win/audio/MidiInput.h"
 #include "win/audio/SatoriRealtimeEngine.h"
 #include "win/audio/UnifiedAudioEngine.h"
 #include "win/ui/Direct2DContext.h"
 #include "win/ui/KeyboardKeymap.h"
 #include "win/ui/UIModel.h"
+#include "win/ui/UiBenchmark.h"
 #include "dsp/RoomIrLibrary.h"
 
 namespace {
@@ -31,6 +45,11 @@ namespace {
 const wchar_t kWindowClassName[] = L"SatoriWinClass";
 const wchar_t kWindowTitle[] = L"Satori Synth (Preview)";
 constexpr UINT kMsgPreviewReady = WM_APP + 1;
+constexpr UINT kMsgFrame = WM_APP + 2;  // posted by FrameScheduler after vblank
+constexpr UINT kMsgMidiNoteOn = WM_APP + 3;  // wParam = MIDI note, from the MIDI thread
+constexpr UINT kMsgDeviceLost = WM_APP + 4;  // from the UI present thread
+// wParam = MIDI note, lParam = 1 pressed / 0 released, from the keyboard input thread
+constexpr UINT kMsgRawKey = WM_APP + 5;
 
 // 推荐窗口客户端区域尺寸（也是本迭代的最小可用尺寸）
 constexpr int kMinClientWidth = 1280;
@@ -70,9 +89,65 @@ std::filesystem::path GetExecutableDir() {
     return exePath.remove_filename();
 }
 
-double MidiToFrequency(int midi) {
-    return 440.0 * std::pow(2.0, (static_cast<double>(midi) - 69.0) / 12.0);
-}
+// Startup phases, measured from process start and reported once through
+// OutputDebugString when the first frame is on screen (and as trace zones
+// when tracing is built in).
+class StartupTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // `name` must be a string literal.
+    void mark(const char* name) {
+        const auto now = Clock::now();
+        if (count_ < phases_.size()) {
+            phases_[count_++] = {name, last_, now};
+        }
+#if SATORI_TRACING_ENABLED
+        engine::RecordTraceZone(name, Nanoseconds(last_), Nanoseconds(now));
+#endif
+        last_ = now;
+    }
+
+    void report() {
+        if (reported_) {
+            return;
+        }
+        reported_ = true;
+        std::ostringstream text;
+        text << "Satori: startup";
+        for (std::size_t i = 0; i < count_; ++i) {
+            text << (i == 0 ? " " : ", ") << phases_[i].name << ' '
+                 << Milliseconds(phases_[i].begin, phases_[i].end) << " ms";
+        }
+        text << " (total " << Milliseconds(processStart_, last_) << " ms)\n";
+        OutputDebugStringA(text.str().c_str());
+    }
+
+private:
+    struct Phase {
+        const char* name = nullptr;
+        Clock::time_point begin{};
+        Clock::time_point end{};
+    };
+
+    static long long Milliseconds(Clock::time_point begin, Clock::time_point end) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count();
+    }
+#if SATORI_TRACING_ENABLED
+    static std::uint64_t Nanoseconds(Clock::time_point point) {
+        // The trace's clock is the same steady clock.
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(point.time_since_epoch()).count());
+    }
+#endif
+
+    // Static initialisation runs as the process starts.
+    static inline const Clock::time_point processStart_ = Clock::now();
+    Clock::time_point last_ = processStart_;
+    std::array<Phase, 12> phases_{};
+    std::size_t count_ = 0;
+    bool reported_ = false;
+};
 
 struct PreviewRequest {
     std::uint64_t ticket = 0;
@@ -88,49 +163,17 @@ struct PreviewPayload {
     std::vector<float> excitationSamples;
 };
 
-std::vector<float> GenerateWaveformPreview(const synthesis::StringConfig& config,
-                                           float masterGain,
-                                           double frequency) {
-    if (frequency <= 0.0) {
-        return {};
-    }
-    const std::size_t maxSamples = 2048;
-    const double sampleRate = std::max(1.0, config.sampleRate);
-    const double duration = static_cast<double>(maxSamples) / sampleRate;
-    synthesis::KarplusStrongString string(config);
-    auto samples = string.pluck(frequency, duration);
-    if (samples.size() > maxSamples) {
-        samples.resize(maxSamples);
-    }
-    for (auto& sample : samples) {
-        sample *= masterGain;
-    }
-    return samples;
-}
-
-std::vector<float> GenerateExcitationPreview(const synthesis::StringConfig& config,
-                                             float masterGain,
-                                             double frequency) {
-    if (frequency <= 0.0) {
-        return {};
-    }
-    synthesis::KarplusStrongString string(config);
-    string.start(frequency, 1.0f);
-    auto samples = string.excitationBufferPreview(1024);
-    for (auto& sample : samples) {
-        sample *= masterGain;
-    }
-    return samples;
-}
-
 class SatoriAppState {
 public:
     bool initialize(HWND hwnd);
     void shutdown();
 
     void onSize(int width, int height);
-    void onPaint();
-    void onTimer(UINT_PTR timerId);
+    void onPaint(const RECT& updateRect);
+    void onDeviceLost();
+    void onFrame();
+    void onMidiNoteOn(int midiNote);
+    void onRawKey(int midiNote, bool pressed);
     void onPreviewReady(PreviewPayload* payload);
     bool onKeyDown(UINT vk, LPARAM lparam);
     bool onKeyUp(UINT vk);
@@ -152,6 +195,8 @@ private:
     void refreshAudioOptions();
     void applyAudioConfigFromHeader(bool showDialog);
     void syncSynthConfig();
+    // Hands synthConfig_, masterGain_ and ampRelease_ over as one patch.
+    void applyPreset();
     void scheduleWaveformPreview(double frequency = 440.0);
     void scheduleWaveformPreview(double frequency, UINT delayMs);
     void updateRoomIrPreviewCache();
@@ -167,11 +212,27 @@ private:
     bool handleMidiKeyDown(UINT vk, LPARAM lparam);
     bool handleMidiKeyUp(UINT vk);
     void releaseAllVirtualKeys();
+    void requestRedraw();
+    void startLiveScope();
+    void initializeMidiInput();
+    void onMidiMessage(const winaudio::MidiMessage& message);
+    void initializeRawKeyboard();
+    void onRawKeyEvent(const winapp::RawKeyEvent& event);
+    void pollLiveScope();
+    void refreshAudioHealth();
+    void toggleRecording();
+    void onDropFiles(HDROP drop);
+    void pumpMidiFile();
+    void stepBenchmark();
+#if SATORI_UI_DEBUG_ENABLED
+    void refreshDebugStats();
+#endif
 
     HWND window_ = nullptr;
     std::unique_ptr<winaudio::SatoriRealtimeEngine> engine_;
     std::unique_ptr<winui::Direct2DContext> d2d_;
     std::unique_ptr<winapp::PresetManager> presetManager_;
+    winapp::FrameScheduler frameScheduler_;
     synthesis::StringConfig synthConfig_{};
     float masterGain_ = 1.0f;
     float ampRelease_ = 0.35f;
@@ -186,17 +247,52 @@ private:
     std::wstring presetStatus_ = L"预设：默认";
     std::vector<float> waveformSamples_;
     std::vector<float> excitationSamples_;
-    std::vector<float> roomIrPreviewSamples_;
-    int roomIrPreviewIndex_ = -1;
+    engine::TrackedBytes previewBytes_{engine::MemoryCategory::Preview};
+    dsp::RoomIrLibrary::Preview roomIrPreview_{};
     double lastAuditionFrequency_ = 440.0;
     double pendingPreviewFrequency_ = 440.0;
+    StartupTimeline startup_;
+    bool firstFramePainted_ = false;
+    // --benchmark N; inactive otherwise.
+    winui::UiFrameBenchmark benchmark_;
 #if SATORI_UI_DEBUG_ENABLED
     bool trackingMouseLeave_ = false;
+    // Previous stats refresh, for per-interval stage averages.
+    engine::StageProfile lastStageProfile_{};
+    std::uint64_t lastStageCallbacks_ = 0;
 #endif
     std::unordered_map<UINT, int> virtualKeyToMidi_;
     std::unordered_map<UINT, int> activeVirtualKeys_;
-
-    static constexpr UINT_PTR kWaveformPreviewTimerId = 1;
+    // Set while keyboard keys are pressed for show only: raw input already
+    // played them, and benchmark runs play nothing.
+    bool showingRawKey_ = false;
+
+    // FrameScheduler task slots.
+    static constexpr std::size_t kWaveformPreviewTask = 0;
+    static constexpr std::size_t kDebugStatsTask = 1;
+    static constexpr std::size_t kLiveScopeTask = 2;
+    static constexpr std::size_t kAudioHealthTask = 3;
+    static constexpr std::size_t kMidiFileTask = 4;
+    static constexpr std::chrono::milliseconds kDebugStatsInterval{250};
+    static constexpr std::chrono::milliseconds kAudioHealthInterval{250};
+    // Well inside MidiFilePlayer's lookahead, so a late frame still plays on time.
+    static constexpr std::chrono::milliseconds kMidiFileInterval{50};
+    static constexpr std::chrono::milliseconds kLiveScopeInterval{33};
+    // Leaves the first frames to the window before rendering a preview.
+    static constexpr UINT kStartupPreviewDelayMs = 250;
+    // Live scope: trace length (decimated samples), log bands, and how many
+    // silent polls before it stops until the next note.
+    static constexpr std::size_t kLiveScopeSamples = 512;
+    static constexpr std::size_t kLiveSpectrumBands = 48;
+    static constexpr int kLiveScopeIdlePolls = 15;
+
+    dsp::SpectrumAnalyzer spectrumAnalyzer_{2048};
+    std::vector<float> liveWindow_;
+    std::vector<float> liveScope_;
+    std::vector<float> liveSpectrumDb_;
+    bool liveScopeRunning_ = false;
+    winui::AudioHealth audioHealth_;  // last header bar readout
+    int liveScopeQuietPolls_ = 0;
 
     std::mutex previewMutex_;
     std::condition_variable previewCv_;
@@ -204,21 +300,47 @@ private:
     std::thread previewThread_;
     bool previewStop_ = false;
     std::atomic<std::uint64_t> latestPreviewTicket_{0};
+
+    // Calls into engine_ from the driver thread; closed before engine_ goes.
+    winaudio::MidiInput midiInput_;
+    // Same for the keyboard input thread; reads virtualKeyToMidi_, which is
+    // fixed once it opens. While open, WM_KEYDOWN no longer plays notes.
+    winapp::RawKeyboardInput rawKeyboard_;
 };
 
 bool SatoriAppState::initialize(HWND hwnd) {
     window_ = hwnd;
+    startup_.mark("launch");
+    // Measured once per machine, then read from the cache; it has to be in
+    // place before the engine builds its room. The device rate is not known
+    // until it opens, so the default request stands in for it.
+    const winaudio::AudioEngineConfig defaultAudio;
+    engine::TuneRoomPartitions(engine::DefaultPartitionCachePath(),
+                               static_cast<int>(defaultAudio.sampleRate),
+                               defaultAudio.bufferFrames);
+    startup_.mark("partitions");
     engine_ = std::make_unique<winaudio::SatoriRealtimeEngine>();
     const bool initialized = engine_->initialize();
+    startup_.mark("engine");
     audioReady_ = initialized && engine_->start();
+    startup_.mark("audio");
 
+    // Only the factories: fonts, text formats and the render target are
+    // made by the first paint.
     d2d_ = std::make_unique<winui::Direct2DContext>();
-    if (!d2d_->initialize(hwnd)) {
+    if (!d2d_->initialize(hwnd, kMsgDeviceLost)) {
         MessageBoxW(hwnd, L"初始化 Direct2D 失败", kWindowTitle,
                     MB_ICONERROR | MB_OK);
         PostQuitMessage(-1);
         return false;
     }
+    frameScheduler_.start(hwnd, kMsgFrame);
+    DragAcceptFiles(hwnd, TRUE);
+    benchmark_ = winui::UiFrameBenchmark(winui::BenchmarkFramesFromCommandLine());
+    if (benchmark_.active()) {
+        d2d_->setCountDrawCalls(true);
+        requestRedraw();
+    }
 
     synthConfig_ = engine_->synthConfig();
     masterGain_ = engine_->masterGain();
@@ -228,18 +350,26 @@ bool SatoriAppState::initialize(HWND hwnd) {
     if (desiredAudioConfig_.backend == winaudio::AudioBackendType::WasapiShared) {
         desiredAudioConfig_.sampleRate = 0;
     }
+    startup_.mark("direct2d");
     refreshAudioOptions();
     initializeKeyBindings();
+    initializeMidiInput();
+    initializeRawKeyboard();
+    startup_.mark("devices");
     initializePresetSupport();
+    startup_.mark("presets");
     updateRoomIrPreviewCache();
-    startPreviewWorker();
-    refreshWaveformPreview();
+    // The preview worker starts with the first request, after the window is up.
+    scheduleWaveformPreview(lastAuditionFrequency_, kStartupPreviewDelayMs);
     refreshUI();
     updateAudioStatus(!audioReady_);
     return true;
 }
 
 void SatoriAppState::shutdown() {
+    midiInput_.close();
+    rawKeyboard_.close();
+    frameScheduler_.stop();
     stopPreviewWorker();
     if (engine_) {
         engine_->stop();
@@ -265,7 +395,7 @@ winui::FlowDiagramState SatoriAppState::buildDiagramState() const {
     diagram.noiseType =
         (synthConfig_.noiseType == synthesis::NoiseType::Binary) ? 1 : 0;
     diagram.excitationSamples = excitationSamples_;
-    diagram.roomIrPreviewSamples = roomIrPreviewSamples_;
+    diagram.roomIrPreview = roomIrPreview_;
     diagram.highlightedModule = winui::FlowModule::kNone;
     return diagram;
 }
@@ -301,6 +431,7 @@ winui::UIModel SatoriAppState::buildUIModel() {
     };
 
     model.headerBar.logoText = L"Satori";
+    model.headerBar.health = audioHealth_;
     if (engine_) {
         const auto cfg = engine_->audioConfig();
         const auto sr = cfg.sampleRate;
@@ -339,18 +470,40 @@ winui::UIModel SatoriAppState::buildUIModel() {
     model.headerBar.sampleRate.label = usingAsio ? L"SampleRate" : L"Engine SR";
     model.headerBar.sampleRate.pageSize = 8;
     model.headerBar.sampleRate.items.clear();
-    model.headerBar.sampleRate.items.reserve(audioSampleRateOptions_.size());
+    model.headerBar.sampleRate.items.reserve(audioSampleRateOptions_.size() + 1);
+    // WASAPI: the first entry runs the synth at the mix rate (no resampling).
+    const int rateItemOffset = usingAsio ? 0 : 1;
+    if (!usingAsio) {
+        model.headerBar.sampleRate.items.push_back(L"Device");
+    }
     for (auto sr : audioSampleRateOptions_) {
         model.headerBar.sampleRate.items.push_back(std::to_wstring(sr));
     }
     const std::uint32_t currentEngineSr =
         static_cast<std::uint32_t>(std::lround(std::max(0.0, synthConfig_.sampleRate)));
     const std::uint32_t currentDeviceSr = engine_ ? engine_->audioConfig().sampleRate : 0u;
-    model.headerBar.sampleRate.selectedIndex = findIndexU32(
-        audioSampleRateOptions_,
-        usingAsio ? (desiredAudioConfig_.sampleRate > 0 ? desiredAudioConfig_.sampleRate : currentDeviceSr)
-                  : currentEngineSr);
-    model.headerBar.sampleRate.onChanged = [this](int index) {
+    if (!usingAsio && engine_ && engine_->followDeviceRate()) {
+        model.headerBar.sampleRate.selectedIndex = 0;
+    } else {
+        model.headerBar.sampleRate.selectedIndex =
+            rateItemOffset +
+            findIndexU32(audioSampleRateOptions_,
+                         usingAsio ? (desiredAudioConfig_.sampleRate > 0 ? desiredAudioConfig_.sampleRate
+                                                                         : currentDeviceSr)
+                                   : currentEngineSr);
+    }
+    model.headerBar.sampleRate.onChanged = [this, rateItemOffset](int index) {
+        if (rateItemOffset > 0 && index == 0) {
+            if (engine_) {
+                engine_->setFollowDeviceRate(true);
+                synthConfig_ = engine_->synthConfig();
+            }
+            updateRoomIrPreviewCache();
+            refreshFlowDiagram();
+            refreshUI();
+            return;
+        }
+        index -= rateItemOffset;
         if (index < 0 || static_cast<std::size_t>(index) >= audioSampleRateOptions_.size()) {
             return;
         }
@@ -359,6 +512,9 @@ winui::UIModel SatoriAppState::buildUIModel() {
             desiredAudioConfig_.sampleRate = sr;
             applyAudioConfigFromHeader(/*showDialog=*/true);
         } else {
+            if (engine_) {
+                engine_->setFollowDeviceRate(false);
+            }
             synthConfig_.sampleRate = static_cast<double>(sr);
             syncSynthConfig();
             refreshUI();
@@ -607,6 +763,16 @@ winui::UIModel SatoriAppState::buildUIModel() {
                        scheduleWaveformPreview(lastAuditionFrequency_);
                    },
                    winui::FlowModule::kRoom, true));
+    roomModule.params.push_back(
+        makeParam(L"Spread", 0.0f, 1.0f,
+                  [this]() { return synthConfig_.stereoSpread; },
+                   [this](float value) {
+                       synthConfig_.stereoSpread = value;
+                       if (engine_) {
+                           engine_->setParam(engine::ParamId::StereoSpread, value);
+                       }
+                   },
+                   winui::FlowModule::kRoom, false));
     {
         const float maxIr =
             std::max(0.0f,
@@ -724,9 +890,13 @@ void SatoriAppState::applyAudioConfigFromHeader(bool showDialog) {
 }
 
 void SatoriAppState::updateAudioStatus(bool showDialog) {
+    refreshAudioHealth();
     if (audioReady_) {
         std::wstringstream ss;
         ss << L"音频：在线 (" << static_cast<int>(synthConfig_.sampleRate) << L" Hz)";
+        if (midiInput_.isOpen()) {
+            ss << L" · MIDI：" << midiInput_.deviceName();
+        }
         audioStatus_ = ss.str();
     } else {
         std::wstring message = L"音频：初始化失败";
@@ -735,17 +905,17 @@ void SatoriAppState::updateAudioStatus(bool showDialog) {
             if (!lastError.empty()) {
                 message += L"\n";
                 message += ToWide(lastError);
-            }
-        }
-        audioStatus_ = message;
-        if (showDialog && window_) {
-            MessageBoxW(window_, message.c_str(), kWindowTitle,
-                        MB_ICONWARNING | MB_OK);
-        }
-    }
-    refreshUI();
-}
-
+            }
+        }
+        audioStatus_ = message;
+        if (showDialog && window_) {
+            MessageBoxW(window_, message.c_str(), kWindowTitle,
+                        MB_ICONWARNING | MB_OK);
+        }
+    }
+    refreshUI();
+}
+
 void SatoriAppState::updatePresetStatus(const std::wstring& text) {
     presetStatus_ = text;
     refreshUI();
@@ -756,6 +926,22 @@ void SatoriAppState::syncSynthConfig() {
         engine_->setSynthConfig(synthConfig_);
         engine_->setMasterGain(masterGain_);
         engine_->setParam(engine::ParamId::AmpRelease, ampRelease_);
+        engine_->commitParams();
+        synthConfig_ = engine_->synthConfig();
+        masterGain_ = engine_->masterGain();
+        ampRelease_ = engine_->getParam(engine::ParamId::AmpRelease);
+    }
+    updateRoomIrPreviewCache();
+    refreshFlowDiagram();
+}
+
+void SatoriAppState::applyPreset() {
+    if (engine_) {
+        engine::Preset preset;
+        preset.config = synthConfig_;
+        preset.masterGain = masterGain_;
+        preset.ampRelease = ampRelease_;
+        engine_->loadPreset(preset);
         synthConfig_ = engine_->synthConfig();
         masterGain_ = engine_->masterGain();
         ampRelease_ = engine_->getParam(engine::ParamId::AmpRelease);
@@ -774,23 +960,16 @@ void SatoriAppState::scheduleWaveformPreview(double frequency, UINT delayMs) {
     }
     pendingPreviewFrequency_ = frequency > 0.0 ? frequency : lastAuditionFrequency_;
     delayMs = std::max<UINT>(1, delayMs);
-    KillTimer(window_, kWaveformPreviewTimerId);
-    SetTimer(window_, kWaveformPreviewTimerId, delayMs, nullptr);
+    frameScheduler_.schedule(kWaveformPreviewTask, std::chrono::milliseconds(delayMs));
 }
 
 void SatoriAppState::updateRoomIrPreviewCache() {
-    const int index = synthConfig_.roomIrIndex;
-    if (index == roomIrPreviewIndex_ && !roomIrPreviewSamples_.empty()) {
-        return;
-    }
-    roomIrPreviewIndex_ = index;
-    roomIrPreviewSamples_ = dsp::RoomIrLibrary::previewMono(index, 1024);
+    // Views build-time data, so switching rooms costs nothing.
+    roomIrPreview_ = dsp::RoomIrLibrary::preview(synthConfig_.roomIrIndex);
 }
 
 void SatoriAppState::refreshWaveformPreview(double frequency) {
-    if (window_) {
-        KillTimer(window_, kWaveformPreviewTimerId);
-    }
+    frameScheduler_.cancel(kWaveformPreviewTask);
     lastAuditionFrequency_ = frequency > 0.0 ? frequency : lastAuditionFrequency_;
     updateRoomIrPreviewCache();
     enqueueWaveformPreview(lastAuditionFrequency_);
@@ -801,7 +980,7 @@ void SatoriAppState::handleVirtualKeyEvent(int midiNote, double frequency,
     if (frequency <= 0.0) {
         return;
     }
-    if (engine_ && audioReady_) {
+    if (engine_ && audioReady_ && !showingRawKey_) {
         if (pressed) {
             engine_->noteOn(midiNote, frequency);
         } else {
@@ -811,17 +990,209 @@ void SatoriAppState::handleVirtualKeyEvent(int midiNote, double frequency,
     if (pressed) {
         lastAuditionFrequency_ = frequency;
         refreshWaveformPreview(frequency);
+        startLiveScope();
     }
 }
 
-void SatoriAppState::onTimer(UINT_PTR timerId) {
-    if (timerId != kWaveformPreviewTimerId) {
+void SatoriAppState::onMidiNoteOn(int midiNote) {
+    lastAuditionFrequency_ = engine::MidiNoteToFrequency(midiNote);
+    startLiveScope();
+}
+
+void SatoriAppState::onRawKey(int midiNote, bool pressed) {
+    if (!d2d_) {
         return;
     }
-    if (window_) {
-        KillTimer(window_, kWaveformPreviewTimerId);
+    showingRawKey_ = true;
+    if (pressed) {
+        d2d_->pressKeyboardKey(midiNote);
+    } else {
+        d2d_->releaseKeyboardKey(midiNote);
     }
-    refreshWaveformPreview(pendingPreviewFrequency_);
+    showingRawKey_ = false;
+    requestRedraw();
+}
+
+void SatoriAppState::onFrame() {
+    const auto frame = frameScheduler_.takeFrame();
+    if (benchmark_.running()) {
+        stepBenchmark();
+    }
+    // Knob moves since the last frame reach the callback together.
+    if (engine_) {
+        engine_->commitParams();
+    }
+    if (frame.taskDue(kWaveformPreviewTask)) {
+        refreshWaveformPreview(pendingPreviewFrequency_);
+    }
+    if (frame.taskDue(kLiveScopeTask)) {
+        pollLiveScope();
+    }
+    if (frame.taskDue(kAudioHealthTask)) {
+        refreshAudioHealth();
+    }
+    if (frame.taskDue(kMidiFileTask)) {
+        pumpMidiFile();
+    }
+#if SATORI_UI_DEBUG_ENABLED
+    if (frame.taskDue(kDebugStatsTask) && d2d_ && d2d_->debugOverlayVisible()) {
+        refreshDebugStats();
+        frameScheduler_.schedule(kDebugStatsTask, kDebugStatsInterval);
+    }
+#endif
+    // Tasks above may have asked for a redraw; it goes into this frame.
+    const bool redraw = frameScheduler_.takeRedrawRequest() || frame.redraw;
+    if (redraw && d2d_) {
+        // Paint now, inside this vblank, rather than when WM_PAINT's low
+        // priority lets it through.
+        d2d_->invalidateDirty();
+        UpdateWindow(window_);
+    }
+}
+
+// One scripted step per frame: two knobs sweep, a held key walks up the
+// keyboard and a decaying tone scrolls through the waveform view. The
+// knobs move in synthConfig_ only; the run closes the app when it ends.
+void SatoriAppState::stepBenchmark() {
+    if (!d2d_) {
+        return;
+    }
+    constexpr float kSweepPerFrame = 6.2831853f / 120.0f;
+    constexpr int kFramesPerKey = 8;
+    constexpr std::size_t kWaveformSamples = 1024;
+    const int frame = benchmark_.frame();
+    const float sweep = 0.5f + 0.5f * std::sin(static_cast<float>(frame) * kSweepPerFrame);
+    synthConfig_.brightness = sweep;
+    synthConfig_.pickPosition = 0.05f + 0.9f * (1.0f - sweep);
+    d2d_->syncSliders();
+
+    if (frame % kFramesPerKey == 0) {
+        showingRawKey_ = true;
+        d2d_->releaseAllKeyboardKeys();
+        d2d_->pressKeyboardKey(48 + (frame / kFramesPerKey) % 25);
+        showingRawKey_ = false;
+    }
+
+    waveformSamples_.resize(kWaveformSamples);
+    for (std::size_t i = 0; i < kWaveformSamples; ++i) {
+        const float t = static_cast<float>(i) / static_cast<float>(kWaveformSamples);
+        waveformSamples_[i] = std::exp(-3.0f * t) *
+                              std::sin(static_cast<float>(i) * 0.08f +
+                                       static_cast<float>(frame) * 0.3f);
+    }
+    d2d_->updateWaveformSamples(waveformSamples_);
+    requestRedraw();
+}
+
+void SatoriAppState::requestRedraw() {
+    frameScheduler_.requestFrame();
+}
+
+void SatoriAppState::startLiveScope() {
+    liveScopeQuietPolls_ = 0;
+    if (!liveScopeRunning_) {
+        liveScopeRunning_ = true;
+        frameScheduler_.schedule(kLiveScopeTask, kLiveScopeInterval);
+    }
+}
+
+void SatoriAppState::toggleRecording() {
+    if (!engine_) {
+        return;
+    }
+    std::string error;
+    if (engine_->isRecording()) {
+        const bool ok = engine_->stopRecording(error);
+        OutputDebugStringW(ok ? L"Satori: recording saved\n"
+                              : (L"Satori: recording failed: " + ToWide(error) + L"\n").c_str());
+        return;
+    }
+    // One file per take, named by local start time, 24-bit at the device rate.
+    SYSTEMTIME now{};
+    GetLocalTime(&now);
+    wchar_t name[64];
+    std::swprintf(name, std::size(name), L"satori_%04u%02u%02u_%02u%02u%02u.wav", now.wYear,
+                  now.wMonth, now.wDay, now.wHour, now.wMinute, now.wSecond);
+    if (engine_->startRecording(std::filesystem::path(name), audio::SampleFormat::Int24, error)) {
+        OutputDebugStringW((L"Satori: recording to " + std::wstring(name) + L"\n").c_str());
+    } else {
+        OutputDebugStringW((L"Satori: recording failed: " + ToWide(error) + L"\n").c_str());
+    }
+}
+
+// A dropped .mid plays from the start, replacing whatever file was playing.
+void SatoriAppState::onDropFiles(HDROP drop) {
+    wchar_t path[MAX_PATH] = {};
+    const bool got = DragQueryFileW(drop, 0, path, MAX_PATH) > 0;
+    DragFinish(drop);
+    if (!got || !engine_ || !audioReady_) {
+        return;
+    }
+    std::string error;
+    if (engine_->playMidiFile(std::filesystem::path(path), error)) {
+        frameScheduler_.schedule(kMidiFileTask, kMidiFileInterval);
+    } else {
+        OutputDebugStringW((L"Satori: MIDI file failed: " + ToWide(error) + L"\n").c_str());
+    }
+}
+
+void SatoriAppState::pumpMidiFile() {
+    if (engine_ && engine_->pumpMidiFile()) {
+        frameScheduler_.schedule(kMidiFileTask, kMidiFileInterval);
+    }
+}
+
+// Header bar readout from the metrics snapshot (atomics only; the audio
+// thread is never waited on). Polls while audio runs.
+void SatoriAppState::refreshAudioHealth() {
+    if (!d2d_) {
+        return;
+    }
+    winui::AudioHealth& health = audioHealth_;
+    health = {};
+    if (engine_ && audioReady_) {
+        const auto m = engine_->metrics();
+        health.online = true;
+        health.dspLoad = static_cast<float>(m.dspLoad);
+        health.xruns = m.deviceXruns;
+        health.activeVoices = m.activeVoices;
+        health.voiceLimit = m.voiceLimit;
+        health.reverbLatencyMs = static_cast<float>(m.roomLatencyMs);
+        health.outputLatencyMs = static_cast<float>(m.latency.totalMs());
+        frameScheduler_.schedule(kAudioHealthTask, kAudioHealthInterval);
+    } else {
+        frameScheduler_.cancel(kAudioHealthTask);
+    }
+    d2d_->updateAudioHealth(health);
+    requestRedraw();
+}
+
+// Polls the audio thread's tap at ~30 Hz while something is sounding; after
+// kLiveScopeIdlePolls silent polls it stops so an idle window stays idle.
+void SatoriAppState::pollLiveScope() {
+    if (!engine_ || !audioReady_ || !d2d_) {
+        liveScopeRunning_ = false;
+        return;
+    }
+    liveWindow_.resize(spectrumAnalyzer_.fftSize());
+    if (engine_->readScope(liveWindow_.data(), liveWindow_.size())) {
+        liveScope_.assign(liveWindow_.end() - kLiveScopeSamples, liveWindow_.end());
+        spectrumAnalyzer_.analyze(liveWindow_.data(), engine_->scopeSampleRate(),
+                                  kLiveSpectrumBands, 40.0f, liveSpectrumDb_);
+        d2d_->updateLiveSignal(liveScope_, liveSpectrumDb_);
+        requestRedraw();
+
+        float peak = 0.0f;
+        for (const float s : liveWindow_) {
+            peak = std::max(peak, std::abs(s));
+        }
+        liveScopeQuietPolls_ = peak < 1e-4f ? liveScopeQuietPolls_ + 1 : 0;
+    }
+    if (liveScopeQuietPolls_ >= kLiveScopeIdlePolls) {
+        liveScopeRunning_ = false;
+        return;
+    }
+    frameScheduler_.schedule(kLiveScopeTask, kLiveScopeInterval);
 }
 
 void SatoriAppState::startPreviewWorker() {
@@ -830,6 +1201,8 @@ void SatoriAppState::startPreviewWorker() {
     }
     previewStop_ = false;
     previewThread_ = std::thread([this]() {
+        const engine::ScopedDspThread dspThread("waveform preview", engine::CoreClass::Efficiency);
+        synthesis::StringPreviewRenderer previewRenderer;
         while (true) {
             PreviewRequest request;
             {
@@ -842,15 +1215,23 @@ void SatoriAppState::startPreviewWorker() {
                 pendingPreview_.reset();
             }
 
+            // A newer ticket means a newer request is queued: stop rendering
+            // this one instead of finishing and discarding it.
+            const auto superseded = [this, ticket = request.ticket]() {
+                return ticket != latestPreviewTicket_.load(std::memory_order_relaxed);
+            };
+            synthesis::StringPreviewRenderer::Preview preview;
+            if (!previewRenderer.render(request.config, request.masterGain, request.frequency,
+                                        superseded, preview) ||
+                superseded()) {
+                continue;
+            }
+
             PreviewPayload payload;
             payload.ticket = request.ticket;
             payload.frequency = request.frequency;
-            payload.waveformSamples = GenerateWaveformPreview(request.config, request.masterGain, request.frequency);
-            payload.excitationSamples = GenerateExcitationPreview(request.config, request.masterGain, request.frequency);
-
-            if (payload.ticket != latestPreviewTicket_.load(std::memory_order_relaxed)) {
-                continue;
-            }
+            payload.waveformSamples = std::move(preview.waveform);
+            payload.excitationSamples = std::move(preview.excitation);
 
             auto* heapPayload = new PreviewPayload(std::move(payload));
             if (!PostMessageW(window_, kMsgPreviewReady, 0, reinterpret_cast<LPARAM>(heapPayload))) {
@@ -877,6 +1258,7 @@ void SatoriAppState::enqueueWaveformPreview(double frequency) {
     if (!window_) {
         return;
     }
+    startPreviewWorker();
     const std::uint64_t ticket = latestPreviewTicket_.fetch_add(1, std::memory_order_relaxed) + 1;
 
     PreviewRequest request;
@@ -902,13 +1284,13 @@ void SatoriAppState::onPreviewReady(PreviewPayload* payload) {
     }
     waveformSamples_ = std::move(owned->waveformSamples);
     excitationSamples_ = std::move(owned->excitationSamples);
+    previewBytes_.set(engine::CapacityBytes(waveformSamples_) +
+                      engine::CapacityBytes(excitationSamples_));
     if (d2d_) {
         d2d_->updateWaveformSamples(waveformSamples_);
         d2d_->updateDiagramState(buildDiagramState());
     }
-    if (window_) {
-        InvalidateRect(window_, nullptr, FALSE);
-    }
+    requestRedraw();
 }
 
 void SatoriAppState::initializeKeyBindings() {
@@ -916,6 +1298,59 @@ void SatoriAppState::initializeKeyBindings() {
         winui::MakeKeyboardKeymap(kKeyboardBaseMidiNote, kKeyboardOctaveCount);
 }
 
+void SatoriAppState::initializeMidiInput() {
+    // First device that opens; hot-plugging is not tracked.
+    for (const auto& device : winaudio::MidiInput::EnumerateDevices()) {
+        if (midiInput_.open(device.id, [this](const winaudio::MidiMessage& message) {
+                onMidiMessage(message);
+            })) {
+            break;
+        }
+    }
+}
+
+// MIDI driver thread: straight to the engine's lock-free queue with the
+// device timestamp; the UI only hears about it through a posted message.
+void SatoriAppState::onMidiMessage(const winaudio::MidiMessage& message) {
+    if (!engine_ || !audioReady_) {
+        return;
+    }
+    const std::uint8_t kind = message.status & 0xF0;
+    const int note = message.data1;
+    if (kind == 0x90 && message.data2 > 0) {
+        engine_->noteOnAt(note, engine::MidiNoteToFrequency(note),
+                          static_cast<float>(message.data2) / 127.0f, message.hostTicks);
+        PostMessageW(window_, kMsgMidiNoteOn, static_cast<WPARAM>(note), 0);
+    } else if (kind == 0x80 || kind == 0x90) {
+        engine_->noteOffAt(note, message.hostTicks);
+    }
+}
+
+void SatoriAppState::initializeRawKeyboard() {
+    // Without it (Raw Input refused) keys play from WM_KEYDOWN as before.
+    rawKeyboard_.open(window_, [this](const winapp::RawKeyEvent& event) {
+        onRawKeyEvent(event);
+    });
+}
+
+// Keyboard input thread: mapped keys go to the engine stamped with the time
+// they arrived; the UI shows them from the posted message.
+void SatoriAppState::onRawKeyEvent(const winapp::RawKeyEvent& event) {
+    const auto it = virtualKeyToMidi_.find(event.virtualKey);
+    if (it == virtualKeyToMidi_.end()) {
+        return;
+    }
+    const int note = it->second;
+    if (engine_ && audioReady_) {
+        if (event.pressed) {
+            engine_->noteOnAt(note, engine::MidiNoteToFrequency(note), 1.0f, event.hostTicks);
+        } else {
+            engine_->noteOffAt(note, event.hostTicks);
+        }
+    }
+    PostMessageW(window_, kMsgRawKey, static_cast<WPARAM>(note), event.pressed ? 1 : 0);
+}
+
 void SatoriAppState::initializePresetSupport() {
     const auto presetDir = GetExecutableDir() / L"presets";
     presetManager_ = std::make_unique<winapp::PresetManager>(presetDir);
@@ -923,11 +1358,10 @@ void SatoriAppState::initializePresetSupport() {
     if (std::filesystem::exists(defaultPreset)) {
         std::wstring error;
         if (presetManager_->load(defaultPreset, synthConfig_, masterGain_, ampRelease_, error)) {
-            syncSynthConfig();
+            applyPreset();
             if (d2d_) {
                 d2d_->syncSliders();
             }
-            refreshWaveformPreview();
             updatePresetStatus(L"预设：" + defaultPreset.filename().wstring());
         } else if (window_) {
             MessageBoxW(window_, error.c_str(), kWindowTitle,
@@ -959,7 +1393,7 @@ void SatoriAppState::handleLoadPreset() {
     }
     masterGain_ = loadedGain;
     ampRelease_ = loadedRelease;
-    syncSynthConfig();
+    applyPreset();
     if (d2d_) {
         d2d_->syncSliders();
     }
@@ -982,7 +1416,7 @@ void SatoriAppState::handleSavePreset() {
 }
 
 bool SatoriAppState::handleMidiKeyDown(UINT vk, LPARAM lparam) {
-    if ((lparam & (1 << 30)) != 0) {  // autorepeat
+    if ((lparam & (1 << 30)) != 0 || rawKeyboard_.isOpen()) {  // autorepeat, or played raw
         return virtualKeyToMidi_.find(vk) != virtualKeyToMidi_.end();
     }
     auto it = virtualKeyToMidi_.find(vk);
@@ -995,9 +1429,7 @@ bool SatoriAppState::handleMidiKeyDown(UINT vk, LPARAM lparam) {
     const int midi = it->second;
     if (d2d_ && d2d_->pressKeyboardKey(midi)) {
         activeVirtualKeys_.emplace(vk, midi);
-        if (window_) {
-            InvalidateRect(window_, nullptr, FALSE);
-        }
+        requestRedraw();
         return true;
     }
     return false;
@@ -1012,9 +1444,7 @@ bool SatoriAppState::handleMidiKeyUp(UINT vk) {
         d2d_->releaseKeyboardKey(it->second);
     }
     activeVirtualKeys_.erase(it);
-    if (window_) {
-        InvalidateRect(window_, nullptr, FALSE);
-    }
+    requestRedraw();
     return true;
 }
 
@@ -1024,13 +1454,12 @@ void SatoriAppState::releaseAllVirtualKeys() {
             engine_->noteOff(kv.second);
         }
     }
+    rawKeyboard_.releaseAll();
     if (d2d_) {
         d2d_->releaseAllKeyboardKeys();
     }
     activeVirtualKeys_.clear();
-    if (window_) {
-        InvalidateRect(window_, nullptr, FALSE);
-    }
+    requestRedraw();
 }
 
 void SatoriAppState::onSize(int width, int height) {
@@ -1039,9 +1468,36 @@ void SatoriAppState::onSize(int width, int height) {
     }
 }
 
-void SatoriAppState::onPaint() {
+void SatoriAppState::onDeviceLost() {
     if (d2d_) {
-        d2d_->render();
+        d2d_->handleDeviceLost();
+        d2d_->invalidateAll();
+    }
+}
+
+void SatoriAppState::onPaint(const RECT& updateRect) {
+    const engine::TraceZone zone("UI paint");
+    const bool benchmarking = benchmark_.running();
+    if (benchmarking) {
+        benchmark_.beginFrame();
+    }
+    if (d2d_) {
+        d2d_->render(updateRect);
+    }
+    if (benchmarking) {
+        // Recording only: rasterising happens on the present thread.
+        benchmark_.endFrame(d2d_ ? d2d_->lastFrameDrawCalls() : -1);
+        if (benchmark_.running()) {
+            requestRedraw();
+        } else {
+            benchmark_.writeReport("SatoriWinApp");
+            PostMessageW(window_, WM_CLOSE, 0, 0);
+        }
+    }
+    if (!firstFramePainted_) {
+        firstFramePainted_ = true;
+        startup_.mark("first frame");
+        startup_.report();
     }
 }
 
@@ -1050,11 +1506,45 @@ bool SatoriAppState::onKeyDown(UINT vk, LPARAM lparam) {
     if (vk == VK_F12) {
         if (d2d_) {
             d2d_->toggleDebugOverlay();
-            InvalidateRect(window_, nullptr, FALSE);
+            if (d2d_->debugOverlayVisible()) {
+                refreshDebugStats();
+                frameScheduler_.schedule(kDebugStatsTask, kDebugStatsInterval);
+            } else {
+                frameScheduler_.cancel(kDebugStatsTask);
+            }
+            d2d_->invalidateAll();
+        }
+        return true;
+    }
+    if (vk == VK_F9) {
+        // Starts a fresh percentile/overrun window.
+        if (engine_) {
+            engine_->resetMetricsWindow();
+            refreshDebugStats();
         }
         return true;
     }
 #endif
+#if SATORI_TRACING_ENABLED
+    if (vk == VK_F8) {
+        // Timeline of the last few seconds, for chrome://tracing or Perfetto.
+        const bool written = engine::WriteChromeTrace(std::filesystem::path(L"satori_trace.json"));
+        OutputDebugStringW(written ? L"Satori: trace written to satori_trace.json\n"
+                                   : L"Satori: trace export failed\n");
+        return true;
+    }
+#endif
+    if (vk == VK_F6) {
+        if (engine_) {
+            engine_->stopMidiFile();
+        }
+        frameScheduler_.cancel(kMidiFileTask);
+        return true;
+    }
+    if (vk == VK_F7) {
+        toggleRecording();
+        return true;
+    }
     if (vk == VK_F11) {
         if (d2d_) {
             d2d_->dumpLayoutDebugInfo();
@@ -1073,7 +1563,7 @@ bool SatoriAppState::onPointerDown(float x, float y) {
         if (d2d_->hasPointerCapture()) {
             SetCapture(window_);
         }
-        InvalidateRect(window_, nullptr, FALSE);
+        requestRedraw();
         return true;
     }
     return false;
@@ -1092,7 +1582,7 @@ bool SatoriAppState::onPointerMove(float x, float y) {
     }
 #endif
     if (d2d_ && d2d_->onPointerMove(x, y)) {
-        InvalidateRect(window_, nullptr, FALSE);
+        requestRedraw();
         return true;
     }
     return false;
@@ -1103,7 +1593,7 @@ void SatoriAppState::onPointerUp() {
         d2d_->onPointerUp();
     }
     ReleaseCapture();
-    InvalidateRect(window_, nullptr, FALSE);
+    requestRedraw();
 }
 
 #if SATORI_UI_DEBUG_ENABLED
@@ -1113,6 +1603,87 @@ void SatoriAppState::onMouseLeave() {
         InvalidateRect(window_, nullptr, FALSE);
     }
 }
+
+void SatoriAppState::refreshDebugStats() {
+    if (!engine_ || !d2d_ || !d2d_->debugOverlayVisible()) {
+        return;
+    }
+    const auto m = engine_->metrics();
+    winui::DebugStatsText stats;
+    wchar_t line[160];
+    std::swprintf(line, std::size(line),
+                  L"回调 %llu  超时 %llu  设备断流 %llu  流恢复 %llu  (F9 重置窗口)",
+                  static_cast<unsigned long long>(m.windowCallbacks),
+                  static_cast<unsigned long long>(m.windowOverruns),
+                  static_cast<unsigned long long>(m.deviceXruns),
+                  static_cast<unsigned long long>(m.streamRecoveries));
+    stats.lines.push_back(line);
+    std::swprintf(line, std::size(line),
+                  L"p50 %.2f  p95 %.2f  p99 %.2f  p99.9 %.2f  max %.2f ms", m.windowMsP50,
+                  m.windowMsP95, m.windowMsP99, m.windowMsP999, m.windowMsMax);
+    stats.lines.push_back(line);
+    std::swprintf(line, std::size(line), L"房间延迟 %zu 帧  迟到块 %llu", m.roomDelayFrames,
+                  static_cast<unsigned long long>(m.roomLateBlocks));
+    stats.lines.push_back(line);
+    std::swprintf(line, std::size(line),
+                  L"混响尾部 均值 %.0f  p99 %.0f  max %.0f us  超时 %llu",
+                  m.room.tailBlockUsMean, m.room.tailBlockUsP99, m.room.tailBlockUsMax,
+                  static_cast<unsigned long long>(m.room.tailOverruns));
+    stats.lines.push_back(line);
+    std::swprintf(line, std::size(line), L"队列峰值 dry %zu / wet %zu  丢弃 dry %llu / wet %llu",
+                  m.room.dryQueueHighWater, m.room.wetQueueHighWater,
+                  static_cast<unsigned long long>(m.room.droppedDryBlocks),
+                  static_cast<unsigned long long>(m.room.droppedWetBlocks));
+    stats.lines.push_back(line);
+    std::swprintf(line, std::size(line), L"DSP 负载 %.0f%%  声部 %zu/%zu  降级 %d/%d",
+                  m.dspLoad * 100.0, m.activeVoices, m.voiceLimit, m.qualityLevel,
+                  engine::QualityGovernor::kMaxLevel);
+    stats.lines.push_back(line);
+    {
+        using engine::MemoryCategory;
+        const auto mb = [&](MemoryCategory c) {
+            return static_cast<double>(m.memory[c]) / 1048576.0;
+        };
+        std::swprintf(line, std::size(line),
+                      L"内存 内核 %.1f  声部 %.1f  队列 %.1f  采样 %.1f  预览 %.1f  合计 %.1f MB",
+                      mb(MemoryCategory::Kernels), mb(MemoryCategory::Voices),
+                      mb(MemoryCategory::Queues), mb(MemoryCategory::Samples),
+                      mb(MemoryCategory::Preview),
+                      static_cast<double>(m.memory.total()) / 1048576.0);
+        stats.lines.push_back(line);
+    }
+    if (m.recording) {
+        std::swprintf(line, std::size(line), L"录音 %.1f s  丢块 %llu", m.recordedSeconds,
+                      static_cast<unsigned long long>(m.recordOverruns));
+        stats.lines.push_back(line);
+    }
+
+    if (!m.stageProfiling) {
+        stats.lines.push_back(L"分阶段计时未启用 (SATORI_ENABLE_PROFILING)");
+    } else {
+        // Mean ticks per callback over the last refresh interval.
+        const std::uint64_t callbacks = m.callbackCount - lastStageCallbacks_;
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < engine::kProfileStageCount; ++i) {
+            total += m.stages.ticks[i] - lastStageProfile_.ticks[i];
+        }
+        for (std::size_t i = 0; i < engine::kProfileStageCount; ++i) {
+            const std::uint64_t ticks = m.stages.ticks[i] - lastStageProfile_.ticks[i];
+            const double perCallback =
+                callbacks > 0 ? static_cast<double>(ticks) / static_cast<double>(callbacks) : 0.0;
+            const double share =
+                total > 0 ? 100.0 * static_cast<double>(ticks) / static_cast<double>(total) : 0.0;
+            std::swprintf(line, std::size(line), L"%-10hs %10.1f k ticks/回调  %5.1f%%",
+                          engine::ProfileStageName(static_cast<engine::ProfileStage>(i)),
+                          perCallback / 1000.0, share);
+            stats.lines.push_back(line);
+        }
+        lastStageProfile_ = m.stages;
+        lastStageCallbacks_ = m.callbackCount;
+    }
+    d2d_->setDebugStats(std::move(stats));
+    requestRedraw();
+}
 #endif
 
 void SatoriAppState::onDeactivate() {
@@ -1160,7 +1731,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
             PAINTSTRUCT ps;
             BeginPaint(hwnd, &ps);
             if (state) {
-                state->onPaint();
+                state->onPaint(ps.rcPaint);
             }
             EndPaint(hwnd, &ps);
             return 0;
@@ -1172,13 +1743,42 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
             }
             break;
         }
-        case WM_TIMER: {
+        case kMsgFrame: {
             if (state) {
-                state->onTimer(static_cast<UINT_PTR>(wparam));
+                state->onFrame();
                 return 0;
             }
             break;
         }
+        case kMsgMidiNoteOn: {
+            if (state) {
+                state->onMidiNoteOn(static_cast<int>(wparam));
+                return 0;
+            }
+            break;
+        }
+        case kMsgRawKey: {
+            if (state) {
+                state->onRawKey(static_cast<int>(wparam), lparam != 0);
+                return 0;
+            }
+            break;
+        }
+        case kMsgDeviceLost: {
+            if (state) {
+                state->onDeviceLost();
+                return 0;
+            }
+            break;
+        }
+        case WM_DROPFILES: {
+            if (state) {
+                state->onDropFiles(reinterpret_cast<HDROP>(wparam));
+                return 0;
+            }
+            DragFinish(reinterpret_cast<HDROP>(wparam));
+            return 0;
+        }
         case WM_KEYDOWN: {
             if (state &&
                 state->onKeyDown(static_cast<UINT>(wparam), lparam)) {
@@ -1254,7 +1854,8 @@ ATOM RegisterSatoriWindowClass(HINSTANCE instance) {
     wc.lpfnWndProc = WindowProc;
     wc.hInstance = instance;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
-    wc.hbrBackground = reinterpret_cast<HBRUSH>(COLOR_WINDOW + 1);
+    // DirectComposition shows the client area; there is no GDI surface.
+    wc.hbrBackground = nullptr;
     wc.lpszClassName = kWindowClassName;
     return RegisterClassExW(&wc);
 }
@@ -1267,7 +1868,7 @@ HWND CreateSatoriWindow(HINSTANCE instance) {
     const int height = rect.bottom - rect.top;
 
     return CreateWindowExW(
-        0, kWindowClassName, kWindowTitle,
+        WS_EX_NOREDIRECTIONBITMAP, kWindowClassName, kWindowTitle,
         WS_OVERLAPPEDWINDOW,
         CW_USEDEFAULT, CW_USEDEFAULT,
         width, height,
@@ -1275,6 +1876,9 @@ HWND CreateSatoriWindow(HINSTANCE instance) {
 }
 
 int RunSatoriApp(HINSTANCE instance, int show) {
+    engine::SetTraceThreadName("UI");
+    // Leaves the performance cores of a hybrid CPU to the audio threads.
+    engine::SetThreadCoreClass(engine::CoreClass::Efficiency);
     const HRESULT hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
     if (FAILED(hr)) {
         MessageBoxW(nullptr, L"无法初始化 COM 环境", kWindowTitle,
@@ -11,6 +11,8 @@
 #include <objbase.h>
 #include <unknwn.h>
 
+#include "audio/SampleConvert.h"
+
 #ifndef interface
 #define interface struct
 #endif
@@ -135,6 +137,14 @@ std::string AsioDriverErrorMessage(IASIO* driver) {
     return std::string(buf);
 }
 
+std::uint64_t AsioSamplesToFrames(const ASIOSamples& samples) {
+#if NATIVE_INT64
+    return static_cast<std::uint64_t>(samples);
+#else
+    return (static_cast<std::uint64_t>(samples.hi) << 32) | samples.lo;
+#endif
+}
+
 std::string AsioDriverName(IASIO* driver) {
     if (!driver) {
         return {};
@@ -162,7 +172,22 @@ struct AsioAudioEngine::Impl {
     bool comInitialized = false;
     std::vector<ASIOSampleType> outputTypes;
 
+    // Sized once in initialize(): the callback renders interleaved, then each
+    // channel is split out and converted by a converter chosen per channel.
     std::vector<float> interleaved;
+    std::vector<float> channelScratch;
+    std::vector<audio::SampleConvertFn> converters;  // null: unsupported type, silence
+    std::vector<std::size_t> sampleBytes;
+    // Full duplex: the driver's first inputs, after the outputs in
+    // bufferInfos, read back and interleaved in the same buffer switch.
+    long captureChannels = 0;
+    std::vector<float> inputInterleaved;
+    std::vector<audio::SampleReadFn> readers;  // null: unsupported type, silence
+
+    // Stream position of the next buffer; adopted from the driver whenever
+    // it reports one, so a jump shows up as a discontinuity.
+    std::uint64_t streamFrame = 0;
+    bool positionValid = false;
 
     static AsioAudioEngine* activeEngine;
 
@@ -172,7 +197,9 @@ struct AsioAudioEngine::Impl {
     static long asioMessage(long selector, long value, void* message, double* opt);
 
     static std::size_t bytesPerSample(ASIOSampleType type);
-    static void writeSample(ASIOSampleType type, void* dst, float v);
+    static bool formatFor(ASIOSampleType type, audio::SampleFormat& format, bool& bigEndian);
+    static audio::SampleConvertFn converterFor(ASIOSampleType type);
+    static audio::SampleReadFn readerFor(ASIOSampleType type);
 #endif
 };
 
@@ -180,10 +207,18 @@ struct AsioAudioEngine::Impl {
 AsioAudioEngine* AsioAudioEngine::Impl::activeEngine = nullptr;
 
 void AsioAudioEngine::Impl::bufferSwitch(long index, ASIOBool processNow) {
-    (void)bufferSwitchTimeInfo(nullptr, index, processNow);
+    // Drivers without time info: ask for the position it would have carried.
+    ASIOTime time{};
+    AsioAudioEngine* self = activeEngine;
+    if (self && self->impl_ && self->impl_->driver &&
+        self->impl_->driver->getSamplePosition(&time.timeInfo.samplePosition,
+                                               &time.timeInfo.systemTime) == ASE_OK) {
+        time.timeInfo.flags = kSystemTimeValid | kSamplePositionValid;
+    }
+    (void)bufferSwitchTimeInfo(&time, index, processNow);
 }
 
-ASIOTime* AsioAudioEngine::Impl::bufferSwitchTimeInfo(ASIOTime*, long index, ASIOBool) {
+ASIOTime* AsioAudioEngine::Impl::bufferSwitchTimeInfo(ASIOTime* params, long index, ASIOBool) {
     AsioAudioEngine* self = activeEngine;
     if (!self || !self->impl_ || !self->impl_->driver || !self->renderCallback_) {
         return nullptr;
@@ -194,31 +229,60 @@ ASIOTime* AsioAudioEngine::Impl::bufferSwitchTimeInfo(ASIOTime*, long index, ASI
         return nullptr;
     }
 
-    self->impl_->interleaved.resize(frames * channels);
-    self->renderCallback_(self->impl_->interleaved.data(), frames);
+    Impl& impl = *self->impl_;
+    if (frames * channels > impl.interleaved.size() || frames > impl.channelScratch.size()) {
+        return nullptr;
+    }
+    RenderTiming timing;
+    LARGE_INTEGER now{};
+    QueryPerformanceCounter(&now);
+    timing.hostTicks = now.QuadPart;
+    timing.sampleRate = self->config_.sampleRate;
+    timing.channels = static_cast<uint16_t>(channels);
+    if (params && (params->timeInfo.flags & kSamplePositionValid)) {
+        const std::uint64_t position = AsioSamplesToFrames(params->timeInfo.samplePosition);
+        timing.discontinuity = impl.positionValid && position != impl.streamFrame;
+        impl.streamFrame = position;
+        impl.positionValid = true;
+    }
+    if (params && (params->timeInfo.flags & kSampleRateValid) && params->timeInfo.sampleRate > 0.0) {
+        timing.sampleRate = static_cast<uint32_t>(std::lround(params->timeInfo.sampleRate));
+    }
+    timing.streamFrame = impl.streamFrame;
+    const std::size_t inputs = static_cast<std::size_t>(impl.captureChannels);
+    const std::size_t firstInput = static_cast<std::size_t>(impl.outputChannels);
+    for (std::size_t c = 0; c < inputs; ++c) {
+        const void* src = impl.bufferInfos[firstInput + c].buffers[index ? 1 : 0];
+        float* scratch = impl.channelScratch.data();
+        if (src && impl.readers[c]) {
+            impl.readers[c](src, scratch, frames);
+        } else {
+            std::fill_n(scratch, frames, 0.0f);
+        }
+        audio::Interleave(scratch, inputs, c, impl.inputInterleaved.data(), frames);
+    }
+    if (inputs > 0) {
+        timing.input = impl.inputInterleaved.data();
+        timing.inputChannels = static_cast<uint16_t>(inputs);
+    }
+    self->renderCallback_(impl.interleaved.data(), frames, timing);
+    impl.streamFrame += frames;
 
     const long bufferIndex = index ? 1 : 0;
-    for (long ch = 0; ch < self->impl_->outputChannels; ++ch) {
-        const ASIOSampleType type =
-            (static_cast<std::size_t>(ch) < self->impl_->outputTypes.size())
-                ? self->impl_->outputTypes[static_cast<std::size_t>(ch)]
-                : ASIOSTFloat32LSB;
-        void* dst =
-            self->impl_->bufferInfos[static_cast<std::size_t>(ch)].buffers[bufferIndex];
+    for (long ch = 0; ch < impl.outputChannels; ++ch) {
+        const std::size_t c = static_cast<std::size_t>(ch);
+        void* dst = impl.bufferInfos[c].buffers[bufferIndex];
         if (!dst) {
             continue;
         }
-
-        const bool active = static_cast<std::size_t>(ch) < channels;
-        const std::size_t stride = bytesPerSample(type);
-        std::uint8_t* outBytes = reinterpret_cast<std::uint8_t*>(dst);
-        for (std::size_t f = 0; f < frames; ++f) {
-            const float v = active
-                                ? self->impl_->interleaved[f * channels +
-                                                          static_cast<std::size_t>(ch)]
-                                : 0.0f;
-            writeSample(type, outBytes + f * stride, v);
+        const audio::SampleConvertFn convert = impl.converters[c];
+        if (c >= channels || !convert) {
+            // All-zero bytes are silence in every ASIO sample type.
+            std::memset(dst, 0, frames * impl.sampleBytes[c]);
+            continue;
         }
+        audio::Deinterleave(impl.interleaved.data(), channels, c, impl.channelScratch.data(), frames);
+        convert(impl.channelScratch.data(), dst, frames);
     }
 
     if (self->impl_->supportsOutputReady) {
@@ -269,100 +333,53 @@ std::size_t AsioAudioEngine::Impl::bytesPerSample(ASIOSampleType type) {
     }
 }
 
-void AsioAudioEngine::Impl::writeSample(ASIOSampleType type, void* dst, float v) {
-    v = std::max(-1.0f, std::min(1.0f, v));
+bool AsioAudioEngine::Impl::formatFor(ASIOSampleType type, audio::SampleFormat& format,
+                                      bool& bigEndian) {
     switch (type) {
-        case ASIOSTFloat32LSB: {
-            *reinterpret_cast<float*>(dst) = v;
-            break;
-        }
-        case ASIOSTFloat32MSB: {
-            const float vf = v;
-            const auto* src = reinterpret_cast<const std::uint8_t*>(&vf);
-            auto* b = reinterpret_cast<std::uint8_t*>(dst);
-            b[0] = src[3];
-            b[1] = src[2];
-            b[2] = src[1];
-            b[3] = src[0];
-            break;
-        }
-        case ASIOSTFloat64LSB: {
-            *reinterpret_cast<double*>(dst) = static_cast<double>(v);
-            break;
-        }
-        case ASIOSTFloat64MSB: {
-            const double vd = static_cast<double>(v);
-            const auto* src = reinterpret_cast<const std::uint8_t*>(&vd);
-            auto* b = reinterpret_cast<std::uint8_t*>(dst);
-            for (int i = 0; i < 8; ++i) {
-                b[i] = src[7 - i];
-            }
-            break;
-        }
-        case ASIOSTInt32LSB: {
-            const int32_t s = static_cast<int32_t>(std::llround(v * 2147483647.0));
-            *reinterpret_cast<int32_t*>(dst) = s;
-            break;
-        }
-        case ASIOSTInt32MSB: {
-            const int32_t s = static_cast<int32_t>(std::llround(v * 2147483647.0));
-            const auto* src = reinterpret_cast<const std::uint8_t*>(&s);
-            auto* b = reinterpret_cast<std::uint8_t*>(dst);
-            b[0] = src[3];
-            b[1] = src[2];
-            b[2] = src[1];
-            b[3] = src[0];
-            break;
-        }
-        case ASIOSTInt16LSB: {
-            const int16_t s = static_cast<int16_t>(std::llround(v * 32767.0));
-            *reinterpret_cast<int16_t*>(dst) = s;
+        case ASIOSTInt16LSB:
+        case ASIOSTInt16MSB:
+            format = audio::SampleFormat::Int16;
             break;
-        }
-        case ASIOSTInt16MSB: {
-            const int16_t s = static_cast<int16_t>(std::llround(v * 32767.0));
-            const auto* src = reinterpret_cast<const std::uint8_t*>(&s);
-            auto* b = reinterpret_cast<std::uint8_t*>(dst);
-            b[0] = src[1];
-            b[1] = src[0];
+        case ASIOSTInt24LSB:
+        case ASIOSTInt24MSB:
+            format = audio::SampleFormat::Int24;
             break;
-        }
-        case ASIOSTInt24LSB: {
-            const int32_t s = static_cast<int32_t>(std::llround(v * 8388607.0));
-            uint8_t* b = reinterpret_cast<uint8_t*>(dst);
-            b[0] = static_cast<uint8_t>(s & 0xFF);
-            b[1] = static_cast<uint8_t>((s >> 8) & 0xFF);
-            b[2] = static_cast<uint8_t>((s >> 16) & 0xFF);
+        case ASIOSTInt32LSB:
+        case ASIOSTInt32MSB:
+            format = audio::SampleFormat::Int32;
             break;
-        }
-        case ASIOSTInt24MSB: {
-            const int32_t s = static_cast<int32_t>(std::llround(v * 8388607.0));
-            uint8_t* b = reinterpret_cast<uint8_t*>(dst);
-            b[0] = static_cast<uint8_t>((s >> 16) & 0xFF);
-            b[1] = static_cast<uint8_t>((s >> 8) & 0xFF);
-            b[2] = static_cast<uint8_t>(s & 0xFF);
+        case ASIOSTInt32LSB24:
+        case ASIOSTInt32MSB24:
+            format = audio::SampleFormat::Int32Left24;
             break;
-        }
-        case ASIOSTInt32LSB24: {
-            const int32_t s = static_cast<int32_t>(std::llround(v * 8388607.0));
-            *reinterpret_cast<int32_t*>(dst) = (s << 8);
+        case ASIOSTFloat32LSB:
+        case ASIOSTFloat32MSB:
+            format = audio::SampleFormat::Float32;
             break;
-        }
-        case ASIOSTInt32MSB24: {
-            const int32_t s = static_cast<int32_t>(std::llround(v * 8388607.0));
-            const int32_t packed = (s << 8);
-            const auto* src = reinterpret_cast<const std::uint8_t*>(&packed);
-            auto* b = reinterpret_cast<std::uint8_t*>(dst);
-            b[0] = src[3];
-            b[1] = src[2];
-            b[2] = src[1];
-            b[3] = src[0];
+        case ASIOSTFloat64LSB:
+        case ASIOSTFloat64MSB:
+            format = audio::SampleFormat::Float64;
             break;
-        }
         default:
-            std::memset(dst, 0, bytesPerSample(type));
-            break;
+            return false;
     }
+    bigEndian = type == ASIOSTInt16MSB || type == ASIOSTInt24MSB || type == ASIOSTInt32MSB ||
+                type == ASIOSTInt32MSB24 || type == ASIOSTFloat32MSB || type == ASIOSTFloat64MSB;
+    return true;
+}
+
+audio::SampleConvertFn AsioAudioEngine::Impl::converterFor(ASIOSampleType type) {
+    audio::SampleFormat format{};
+    bool bigEndian = false;
+    return formatFor(type, format, bigEndian) ? audio::GetSampleConverter(format, bigEndian)
+                                              : nullptr;
+}
+
+audio::SampleReadFn AsioAudioEngine::Impl::readerFor(ASIOSampleType type) {
+    audio::SampleFormat format{};
+    bool bigEndian = false;
+    return formatFor(type, format, bigEndian) ? audio::GetSampleReader(format, bigEndian)
+                                              : nullptr;
 }
 #endif
 
@@ -521,12 +538,18 @@ bool AsioAudioEngine::initialize(RenderCallback callback) {
     config_.channels = static_cast<std::uint16_t>(
         std::max<long>(1, std::min<long>(static_cast<long>(config_.channels), impl_->outputChannels)));
 
+    // Inputs share the outputs' buffer switch, so they arrive in lock-step.
+    impl_->captureChannels =
+        std::min<long>(static_cast<long>(config_.inputChannels), impl_->inputChannels);
+    config_.inputChannels = static_cast<std::uint16_t>(impl_->captureChannels);
     impl_->bufferInfos.clear();
-    impl_->bufferInfos.resize(static_cast<std::size_t>(impl_->outputChannels));
-    for (long ch = 0; ch < impl_->outputChannels; ++ch) {
-        ASIOBufferInfo& bi = impl_->bufferInfos[static_cast<std::size_t>(ch)];
-        bi.isInput = ASIOFalse;
-        bi.channelNum = ch;
+    impl_->bufferInfos.resize(
+        static_cast<std::size_t>(impl_->outputChannels + impl_->captureChannels));
+    for (std::size_t i = 0; i < impl_->bufferInfos.size(); ++i) {
+        ASIOBufferInfo& bi = impl_->bufferInfos[i];
+        const long ch = static_cast<long>(i);
+        bi.isInput = ch < impl_->outputChannels ? ASIOFalse : ASIOTrue;
+        bi.channelNum = ch < impl_->outputChannels ? ch : ch - impl_->outputChannels;
         bi.buffers[0] = nullptr;
         bi.buffers[1] = nullptr;
     }
@@ -547,9 +570,30 @@ bool AsioAudioEngine::initialize(RenderCallback callback) {
         }
     }
 
-    const ASIOError createRes =
-        impl_->driver->createBuffers(impl_->bufferInfos.data(), impl_->outputChannels,
-                                     impl_->bufferSize, &impl_->callbacks);
+    impl_->converters.resize(impl_->outputTypes.size());
+    impl_->sampleBytes.resize(impl_->outputTypes.size());
+    for (std::size_t ch = 0; ch < impl_->outputTypes.size(); ++ch) {
+        impl_->converters[ch] = Impl::converterFor(impl_->outputTypes[ch]);
+        impl_->sampleBytes[ch] = Impl::bytesPerSample(impl_->outputTypes[ch]);
+    }
+    impl_->readers.assign(static_cast<std::size_t>(impl_->captureChannels), nullptr);
+    for (long ch = 0; ch < impl_->captureChannels; ++ch) {
+        ASIOChannelInfo ci{};
+        ci.channel = ch;
+        ci.isInput = ASIOTrue;
+        if (impl_->driver->getChannelInfo(&ci) == ASE_OK) {
+            impl_->readers[static_cast<std::size_t>(ch)] = Impl::readerFor(ci.type);
+        }
+    }
+    impl_->interleaved.assign(static_cast<std::size_t>(impl_->bufferSize) * config_.channels, 0.0f);
+    impl_->inputInterleaved.assign(
+        static_cast<std::size_t>(impl_->bufferSize) * static_cast<std::size_t>(impl_->captureChannels),
+        0.0f);
+    impl_->channelScratch.assign(static_cast<std::size_t>(impl_->bufferSize), 0.0f);
+
+    const ASIOError createRes = impl_->driver->createBuffers(
+        impl_->bufferInfos.data(), static_cast<long>(impl_->bufferInfos.size()),
+        impl_->bufferSize, &impl_->callbacks);
     if (createRes != ASE_OK) {
         std::ostringstream oss;
         oss << "[ASIO] createBuffers 失败: " << AsioErrorCodeString(createRes);
@@ -563,6 +607,13 @@ bool AsioAudioEngine::initialize(RenderCallback callback) {
         Impl::activeEngine = nullptr;
         return false;
     }
+    // Valid once the buffers exist; drivers count their own buffer in it.
+    long inputLatency = 0;
+    long outputLatency = 0;
+    config_.outputLatencyFrames =
+        impl_->driver->getLatencies(&inputLatency, &outputLatency) == ASE_OK && outputLatency > 0
+            ? static_cast<std::uint32_t>(outputLatency)
+            : config_.bufferFrames;
 
     initialized_ = true;
     return true;
@@ -604,6 +655,8 @@ bool AsioAudioEngine::start() {
     if (!impl_ || !impl_->driver) {
         return false;
     }
+    impl_->streamFrame = 0;
+    impl_->positionValid = false;
     const ASIOError res = impl_->driver->start();
     if (res != ASE_OK) {
         std::ostringstream oss;
@@ -9,7 +9,9 @@
 namespace winaudio {
 
 // ASIO backend. The functional implementation requires building with
-// `SATORI_ENABLE_ASIO` and providing the Steinberg ASIO SDK.
+// `SATORI_ENABLE_ASIO` and providing the Steinberg ASIO SDK. With
+// inputChannels set, the driver's first inputs are created with the outputs
+// and handed to the callback of the same buffer switch (full duplex).
 class AsioAudioEngine {
 public:
     explicit AsioAudioEngine(AudioEngineConfig config = {});
@@ -2,7 +2,6 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <string>
 #include <vector>
 
@@ -10,8 +9,54 @@ namespace winaudio {
 
 enum class AudioBackendType { WasapiShared, Asio };
 
-/// Audio render callback. Caller fills interleaved float buffer.
-using RenderCallback = std::function<void(float* output, std::size_t frames)>;
+// WASAPI stream setup. Modes the device refuses fall back towards Shared;
+// the engine's config() reports the mode actually in use.
+enum class WasapiMode {
+    Shared,            // IAudioClient at the engine's default period.
+    LowLatencyShared,  // IAudioClient3 at the smallest period >= bufferFrames.
+    Exclusive,         // Exclusive, event-driven at bufferFrames.
+};
+
+/// Where one render callback sits on the device's timeline.
+struct RenderTiming {
+    std::uint64_t streamFrame = 0;  // device frames handed out before this buffer
+    std::int64_t hostTicks = 0;     // QueryPerformanceCounter at the callback
+    uint32_t sampleRate = 0;        // device rate
+    uint16_t channels = 0;          // interleaved channels at `output`
+    // Full duplex: `frames` interleaved frames of `inputChannels` captured in
+    // the same period as `output` is played, or null while output only.
+    const float* input = nullptr;
+    uint16_t inputChannels = 0;
+    // The device lost or repeated audio since the previous callback (an
+    // underrun, a sample position jump reported by the driver, or a stream
+    // the backend had to rebuild).
+    bool discontinuity = false;
+};
+
+/// Audio render callback, run on the device thread: the callee fills
+/// `frames` interleaved frames at `output`. A plain object and function
+/// pointer pair, so calling it never allocates or locks.
+struct RenderCallback {
+    using Fn = void (*)(void* context, float* output, std::size_t frames,
+                        const RenderTiming& timing);
+
+    Fn fn = nullptr;
+    void* context = nullptr;
+
+    // Binds a member function: RenderCallback::Member<&T::render>(object).
+    template <auto Method, typename T>
+    static RenderCallback Member(T* object) {
+        return {[](void* context, float* output, std::size_t frames, const RenderTiming& timing) {
+                    (static_cast<T*>(context)->*Method)(output, frames, timing);
+                },
+                object};
+    }
+
+    explicit operator bool() const { return fn != nullptr; }
+    void operator()(float* output, std::size_t frames, const RenderTiming& timing) const {
+        fn(context, output, frames, timing);
+    }
+};
 
 struct AudioDeviceInfo {
     AudioBackendType backend = AudioBackendType::WasapiShared;
@@ -30,6 +75,20 @@ struct AudioEngineConfig {
     uint32_t sampleRate = 0;
     uint16_t channels = 1;
     uint32_t bufferFrames = 512;
+    WasapiMode wasapiMode = WasapiMode::Shared;
+    // Capture channels for full duplex (RenderTiming::input), 0 for output
+    // only. config() reports what was opened: 0 where capture failed.
+    uint16_t inputChannels = 0;
+    // WASAPI capture endpoint; empty = the system default input. ASIO
+    // captures from the driver's own inputs.
+    std::wstring inputDeviceId;
+    // Reported only: frames the device holds ahead of a callback's buffer,
+    // i.e. how long its first frame waits to be played.
+    uint32_t outputLatencyFrames = 0;
+    // On hybrid CPUs keep the render and room worker threads on performance
+    // cores (engine::RealtimeThreadSettings::hybridPlacement). Applied when
+    // the engine is initialised or reconfigured, before its threads start.
+    bool hybridCorePlacement = true;
 };
 
 }  // namespace winaudio
@@ -0,0 +1,92 @@
+#include "win/audio/MidiInput.h"
+
+#include <utility>
+
+namespace winaudio {
+
+MidiInput::~MidiInput() {
+    close();
+}
+
+std::vector<MidiInputDeviceInfo> MidiInput::EnumerateDevices() {
+    std::vector<MidiInputDeviceInfo> devices;
+    const UINT count = midiInGetNumDevs();
+    for (UINT id = 0; id < count; ++id) {
+        MIDIINCAPSW caps{};
+        if (midiInGetDevCapsW(id, &caps, sizeof(caps)) == MMSYSERR_NOERROR) {
+            devices.push_back({id, caps.szPname});
+        }
+    }
+    return devices;
+}
+
+bool MidiInput::open(UINT deviceId, MessageHandler handler) {
+    close();
+    if (!handler) {
+        return false;
+    }
+    handler_ = std::move(handler);
+
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    ticksPerSecond_ = frequency.QuadPart > 0 ? frequency.QuadPart : 1;
+
+    HMIDIIN handle = nullptr;
+    if (midiInOpen(&handle, deviceId, reinterpret_cast<DWORD_PTR>(&MidiInput::InputProc),
+                   reinterpret_cast<DWORD_PTR>(this), CALLBACK_FUNCTION) != MMSYSERR_NOERROR) {
+        handler_ = nullptr;
+        return false;
+    }
+    handle_ = handle;
+
+    MIDIINCAPSW caps{};
+    deviceName_ = midiInGetDevCapsW(deviceId, &caps, sizeof(caps)) == MMSYSERR_NOERROR
+                      ? std::wstring(caps.szPname)
+                      : std::wstring();
+
+    LARGE_INTEGER now{};
+    QueryPerformanceCounter(&now);
+    startTicks_ = now.QuadPart;
+    if (midiInStart(handle_) != MMSYSERR_NOERROR) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MidiInput::close() {
+    if (handle_) {
+        // midiInReset stops delivery; after midiInClose returns no callback
+        // is running, so the handler can go.
+        midiInStop(handle_);
+        midiInReset(handle_);
+        midiInClose(handle_);
+        handle_ = nullptr;
+    }
+    handler_ = nullptr;
+    deviceName_.clear();
+}
+
+void CALLBACK MidiInput::InputProc(HMIDIIN, UINT message, DWORD_PTR instance,
+                                   DWORD_PTR param1, DWORD_PTR param2) {
+    if (message != MIM_DATA || instance == 0) {
+        return;  // long/SysEx data and open/close notifications are not used
+    }
+    reinterpret_cast<MidiInput*>(instance)->handleData(static_cast<DWORD>(param1),
+                                                       static_cast<DWORD>(param2));
+}
+
+void MidiInput::handleData(DWORD packed, DWORD timestampMs) {
+    if (!handler_) {
+        return;
+    }
+    MidiMessage message;
+    message.status = static_cast<std::uint8_t>(packed & 0xFF);
+    message.data1 = static_cast<std::uint8_t>((packed >> 8) & 0x7F);
+    message.data2 = static_cast<std::uint8_t>((packed >> 16) & 0x7F);
+    message.hostTicks =
+        startTicks_ + static_cast<std::int64_t>(timestampMs) * ticksPerSecond_ / 1000;
+    handler_(message);
+}
+
+}  // namespace winaudio
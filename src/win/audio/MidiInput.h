@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+
+#include <mmsystem.h>
+
+namespace winaudio {
+
+struct MidiInputDeviceInfo {
+    UINT id = 0;
+    std::wstring name;
+};
+
+// Short (channel/system) message from a MIDI input device.
+struct MidiMessage {
+    std::uint8_t status = 0;
+    std::uint8_t data1 = 0;
+    std::uint8_t data2 = 0;
+    // QueryPerformanceCounter time the device stamped the message with.
+    std::int64_t hostTicks = 0;
+};
+
+// WinMM MIDI input. Messages are delivered on the driver's callback thread,
+// so the handler must be quick and must not block (engine event queues are
+// fine; UI work should be posted).
+class MidiInput {
+public:
+    using MessageHandler = std::function<void(const MidiMessage&)>;
+
+    MidiInput() = default;
+    ~MidiInput();
+    MidiInput(const MidiInput&) = delete;
+    MidiInput& operator=(const MidiInput&) = delete;
+
+    static std::vector<MidiInputDeviceInfo> EnumerateDevices();
+
+    bool open(UINT deviceId, MessageHandler handler);
+    void close();
+    bool isOpen() const { return handle_ != nullptr; }
+    const std::wstring& deviceName() const { return deviceName_; }
+
+private:
+    static void CALLBACK InputProc(HMIDIIN handle, UINT message, DWORD_PTR instance,
+                                   DWORD_PTR param1, DWORD_PTR param2);
+    void handleData(DWORD packed, DWORD timestampMs);
+
+    HMIDIIN handle_ = nullptr;
+    MessageHandler handler_;
+    std::wstring deviceName_;
+    // WinMM timestamps count milliseconds from midiInStart(); this is the
+    // QPC value at that moment.
+    std::int64_t startTicks_ = 0;
+    std::int64_t ticksPerSecond_ = 1;
+};
+
+}  // namespace winaudio
@@ -6,30 +6,56 @@
 #include <cstddef>
 #include <cstdint>
 #include <windows.h>
+#include <span>
 #include <utility>
 #include <vector>
 
+#include "engine/RealtimeCheck.h"
+#include "engine/RealtimeThread.h"
+#include "engine/Tracer.h"
+
 namespace winaudio {
 
-SatoriRealtimeEngine::SatoriRealtimeEngine()
+namespace {
+std::int64_t QpcNow() {
+    LARGE_INTEGER now{};
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+void ApplyCorePlacement(const AudioEngineConfig& config) {
+    engine::RealtimeThreadSettings settings = engine::GetRealtimeThreadSettings();
+    settings.hybridPlacement = config.hybridCorePlacement;
+    engine::SetRealtimeThreadSettings(settings);
+}
+}  // namespace
+
+SatoriRealtimeEngine::SatoriRealtimeEngine(std::size_t maxVoices)
     : audioConfig_({AudioBackendType::WasapiShared, L"", 0, 0, 1, 512}),
       synthConfig_(),
       audioEngine_(audioConfig_),
-      synthEngine_(synthConfig_) {}
+      synthEngine_(synthConfig_, maxVoices) {
+    // Device callbacks must never render the reverb tail inline, even when a
+    // burst of buffers is pulled faster than realtime.
+    synthEngine_.setRenderMode(engine::RenderMode::Realtime);
+    // Live playing: shape random-noise plucks ahead of the note-on.
+    synthEngine_.setExcitationPrewarm(true);
+}
 
 SatoriRealtimeEngine::~SatoriRealtimeEngine() {
     shutdown();
 }
 
 bool SatoriRealtimeEngine::initialize() {
-    using namespace std::placeholders;
+    ApplyCorePlacement(audioConfig_);
     const bool ok = audioEngine_.initialize(
-        [this](float* buffer, std::size_t frames) { handleRender(buffer, frames); });
+        RenderCallback::Member<&SatoriRealtimeEngine::handleRender>(this));
     if (ok) {
         audioConfig_ = audioEngine_.config();
         synthConfig_.sampleRate = static_cast<double>(audioConfig_.sampleRate);
         synthEngine_.setSampleRate(synthConfig_.sampleRate);
         synthEngine_.setConfig(synthConfig_);
+        resetResampler();
         masterGain_ = synthEngine_.getParam(engine::ParamId::MasterGain);
         ampReleaseSeconds_ = synthEngine_.getParam(engine::ParamId::AmpRelease);
         for (std::size_t i = 0; i < kParamCount; ++i) {
@@ -45,13 +71,21 @@ bool SatoriRealtimeEngine::reconfigureAudio(const AudioEngineConfig& config) {
     if (wasRunning) {
         audioEngine_.stop();
     }
+    // The file's rate and layout are the old device's.
+    std::string ignored;
+    recorder_.stop(ignored);
+    ApplyCorePlacement(config);
     const bool ok = audioEngine_.reinitialize(
-        config, [this](float* buffer, std::size_t frames) { handleRender(buffer, frames); });
+        config, RenderCallback::Member<&SatoriRealtimeEngine::handleRender>(this));
     if (!ok) {
         return false;
     }
     audioConfig_ = audioEngine_.config();
-    if (audioConfig_.backend == AudioBackendType::Asio && audioConfig_.sampleRate > 0) {
+    // Live input arrives at the device rate, in step with the output, so a
+    // duplex stream runs the synth at that rate too.
+    if ((audioConfig_.backend == AudioBackendType::Asio || followDeviceRate_ ||
+         audioConfig_.inputChannels > 0) &&
+        audioConfig_.sampleRate > 0) {
         synthConfig_.sampleRate = static_cast<double>(audioConfig_.sampleRate);
         synthEngine_.setSampleRate(synthConfig_.sampleRate);
     } else if (synthConfig_.sampleRate <= 0.0) {
@@ -66,9 +100,22 @@ bool SatoriRealtimeEngine::reconfigureAudio(const AudioEngineConfig& config) {
     return true;
 }
 
+void SatoriRealtimeEngine::setFollowDeviceRate(bool enabled) {
+    if (followDeviceRate_ == enabled) {
+        return;
+    }
+    followDeviceRate_ = enabled;
+    if (enabled && audioConfig_.sampleRate > 0 &&
+        std::abs(synthConfig_.sampleRate - static_cast<double>(audioConfig_.sampleRate)) > 1e-6) {
+        setSynthConfig(synthConfig_);
+    }
+}
+
 void SatoriRealtimeEngine::shutdown() {
     stop();
     audioEngine_.shutdown();
+    std::string ignored;
+    recorder_.stop(ignored);
 }
 
 bool SatoriRealtimeEngine::start() {
@@ -84,16 +131,45 @@ void SatoriRealtimeEngine::triggerNote(double frequency, double durationSeconds)
 }
 
 void SatoriRealtimeEngine::noteOn(int midiNote, double frequency, float velocity) {
-    synthEngine_.noteOn(midiNote, frequency, velocity);
+    noteOnAt(midiNote, frequency, velocity, QpcNow());
 }
 
 void SatoriRealtimeEngine::noteOff(int midiNote) {
-    synthEngine_.noteOff(midiNote);
+    noteOffAt(midiNote, QpcNow());
+}
+
+void SatoriRealtimeEngine::noteOnAt(int midiNote, double frequency, float velocity,
+                                    std::int64_t hostTicks) {
+    const auto frame = frameClock_.frameAt(hostTicks);
+    if (!frame || midiNote < 0 || frequency <= 0.0) {
+        synthEngine_.noteOn(midiNote, frequency, velocity);
+        return;
+    }
+    engine::Event event;
+    event.type = engine::EventType::NoteOn;
+    event.noteId = midiNote;
+    event.velocity = velocity;
+    event.frequency = frequency;
+    (void)synthEngine_.enqueueEventAt(event, *frame);
+}
+
+void SatoriRealtimeEngine::noteOffAt(int midiNote, std::int64_t hostTicks) {
+    const auto frame = frameClock_.frameAt(hostTicks);
+    if (!frame || midiNote < 0) {
+        synthEngine_.noteOff(midiNote);
+        return;
+    }
+    engine::Event event;
+    event.type = engine::EventType::NoteOff;
+    event.noteId = midiNote;
+    (void)synthEngine_.enqueueEventAt(event, *frame);
 }
 
 void SatoriRealtimeEngine::setSynthConfig(const synthesis::StringConfig& config) {
     synthesis::StringConfig clamped = config;
-    if (clamped.sampleRate <= 0.0) {
+    if ((followDeviceRate_ || audioConfig_.inputChannels > 0) && audioConfig_.sampleRate > 0) {
+        clamped.sampleRate = static_cast<double>(audioConfig_.sampleRate);
+    } else if (clamped.sampleRate <= 0.0) {
         clamped.sampleRate = synthConfig_.sampleRate > 0.0
                                  ? synthConfig_.sampleRate
                                  : static_cast<double>(audioConfig_.sampleRate);
@@ -113,6 +189,16 @@ void SatoriRealtimeEngine::setSynthConfig(const synthesis::StringConfig& config)
     }
 }
 
+void SatoriRealtimeEngine::loadPreset(const engine::Preset& preset) {
+    // Knob moves still queued for the callback would undo parts of the patch.
+    stagedParamMask_ = 0;
+    pendingParamMask_.store(0, std::memory_order_relaxed);
+    synthEngine_.loadPreset(preset);
+    synthConfig_ = synthEngine_.stringConfig();
+    masterGain_ = synthEngine_.getParam(engine::ParamId::MasterGain);
+    ampReleaseSeconds_ = synthEngine_.getParam(engine::ParamId::AmpRelease);
+}
+
 void SatoriRealtimeEngine::setParam(engine::ParamId id, float value) {
     const auto* info = engine::GetParamInfo(id);
     if (info) {
@@ -120,9 +206,8 @@ void SatoriRealtimeEngine::setParam(engine::ParamId id, float value) {
     }
     const std::size_t index = static_cast<std::size_t>(id);
     if (index < kParamCount) {
-        pendingParamValues_[index].store(value, std::memory_order_relaxed);
-        pendingParamMask_.fetch_or(static_cast<std::uint32_t>(1u << index),
-                                   std::memory_order_release);
+        stagedParamValues_[index] = value;
+        stagedParamMask_ |= static_cast<std::uint32_t>(1u << index);
     }
     switch (id) {
         case engine::ParamId::Decay:
@@ -152,9 +237,30 @@ void SatoriRealtimeEngine::setParam(engine::ParamId id, float value) {
         case engine::ParamId::RoomAmount:
             synthConfig_.roomAmount = value;
             break;
+        case engine::ParamId::SympatheticAmount:
+            synthConfig_.sympatheticAmount = value;
+            break;
+        case engine::ParamId::StereoSpread:
+            synthConfig_.stereoSpread = value;
+            break;
+        case engine::ParamId::CourseDetune:
+            synthConfig_.courseDetuneCents = value;
+            break;
         case engine::ParamId::RoomIR:
             synthConfig_.roomIrIndex = static_cast<int>(std::lround(value));
             break;
+        case engine::ParamId::BodyMode:
+            synthConfig_.bodyMode = (value >= 0.5f) ? synthesis::BodyMode::Commuted
+                                                    : synthesis::BodyMode::PostFilter;
+            break;
+        case engine::ParamId::BodyModel:
+            synthConfig_.bodyModel = static_cast<synthesis::BodyModel>(
+                std::clamp(static_cast<int>(std::lround(value)), 0, 2));
+            break;
+        case engine::ParamId::RoomType:
+            synthConfig_.roomType = (value >= 0.5f) ? synthesis::RoomType::Algorithmic
+                                                    : synthesis::RoomType::Convolution;
+            break;
         case engine::ParamId::PickPosition:
             synthConfig_.pickPosition = value;
             break;
@@ -171,9 +277,48 @@ void SatoriRealtimeEngine::setParam(engine::ParamId id, float value) {
         case engine::ParamId::AmpRelease:
             ampReleaseSeconds_ = value;
             break;
+        case engine::ParamId::PitchBend:
+            pitchBend_ = value;
+            break;
+        case engine::ParamId::VibratoRate:
+            vibratoRate_ = value;
+            break;
+        case engine::ParamId::VibratoDepth:
+            vibratoDepth_ = value;
+            break;
+        case engine::ParamId::SustainPedal:
+            sustainPedal_ = value;
+            break;
+        case engine::ParamId::SostenutoPedal:
+            sostenutoPedal_ = value;
+            break;
+        case engine::ParamId::InputMode:
+            inputMode_ = value;
+            break;
+        case engine::ParamId::InputGain:
+            inputGain_ = value;
+            break;
         default:
             break;
     }
+    if (!audioEngine_.isRunning()) {
+        commitParams();
+    }
+}
+
+void SatoriRealtimeEngine::commitParams() {
+    std::uint32_t mask = stagedParamMask_;
+    if (!mask) {
+        return;
+    }
+    stagedParamMask_ = 0;
+    const std::uint32_t published = mask;
+    while (mask) {
+        const auto index = static_cast<std::size_t>(std::countr_zero(mask));
+        mask &= (mask - 1);
+        pendingParamValues_[index].store(stagedParamValues_[index], std::memory_order_relaxed);
+    }
+    pendingParamMask_.fetch_or(published, std::memory_order_release);
     if (!audioEngine_.isRunning()) {
         applyPendingParams();
     }
@@ -197,10 +342,22 @@ float SatoriRealtimeEngine::getParam(engine::ParamId id) const {
             return synthConfig_.bodyTone;
         case engine::ParamId::BodySize:
             return synthConfig_.bodySize;
+        case engine::ParamId::BodyMode:
+            return synthConfig_.bodyMode == synthesis::BodyMode::Commuted ? 1.0f : 0.0f;
+        case engine::ParamId::BodyModel:
+            return static_cast<float>(synthConfig_.bodyModel);
         case engine::ParamId::RoomAmount:
             return synthConfig_.roomAmount;
+        case engine::ParamId::SympatheticAmount:
+            return synthConfig_.sympatheticAmount;
+        case engine::ParamId::StereoSpread:
+            return synthConfig_.stereoSpread;
+        case engine::ParamId::CourseDetune:
+            return synthConfig_.courseDetuneCents;
         case engine::ParamId::RoomIR:
             return static_cast<float>(synthConfig_.roomIrIndex);
+        case engine::ParamId::RoomType:
+            return synthConfig_.roomType == synthesis::RoomType::Algorithmic ? 1.0f : 0.0f;
         case engine::ParamId::PickPosition:
             return synthConfig_.pickPosition;
         case engine::ParamId::EnableLowpass:
@@ -211,6 +368,20 @@ float SatoriRealtimeEngine::getParam(engine::ParamId id) const {
             return masterGain_;
         case engine::ParamId::AmpRelease:
             return ampReleaseSeconds_;
+        case engine::ParamId::PitchBend:
+            return pitchBend_;
+        case engine::ParamId::VibratoRate:
+            return vibratoRate_;
+        case engine::ParamId::VibratoDepth:
+            return vibratoDepth_;
+        case engine::ParamId::SustainPedal:
+            return sustainPedal_;
+        case engine::ParamId::SostenutoPedal:
+            return sostenutoPedal_;
+        case engine::ParamId::InputMode:
+            return inputMode_;
+        case engine::ParamId::InputGain:
+            return inputGain_;
         default:
             break;
     }
@@ -230,12 +401,103 @@ SatoriRealtimeEngine::RealtimeMetrics SatoriRealtimeEngine::metrics() const {
     m.callbackCount = callbackCount_.load(std::memory_order_relaxed);
     m.callbackMsAvg = callbackMsAvg_.load(std::memory_order_relaxed);
     m.callbackMsMax = callbackMsMax_.load(std::memory_order_relaxed);
+    m.callbackPeriodMs = callbackPeriodMs_.load(std::memory_order_relaxed);
+    m.dspLoad = m.callbackPeriodMs > 0.0 ? m.callbackMsAvg / m.callbackPeriodMs : 0.0;
+    m.deviceXruns = deviceXruns_.load(std::memory_order_relaxed);
+    m.streamRecoveries = audioEngine_.streamRecoveries();
     m.pendingParamMask = pendingParamMask_.load(std::memory_order_relaxed);
+    m.roomDelayFrames = synthEngine_.roomOutputDelayFrames();
+    m.roomLateBlocks = synthEngine_.roomLateBlocks();
+    m.room = synthEngine_.roomTelemetry();
+    m.qualityLevel = governor_.level();
+    m.voiceLimit = synthEngine_.voiceLimit();
+    m.activeVoices = synthEngine_.activeVoiceCount();
+    const double synthRate = synthConfig_.sampleRate;
+    m.roomLatencyMs =
+        synthRate > 0.0 ? static_cast<double>(m.roomDelayFrames) * 1000.0 / synthRate : 0.0;
+    m.latency = outputLatency();
+    m.recording = recorder_.isRecording();
+    const std::uint32_t recordRate = recorder_.sampleRate();
+    m.recordedSeconds = recordRate > 0 ? static_cast<double>(recorder_.framesWritten()) /
+                                             static_cast<double>(recordRate)
+                                       : 0.0;
+    m.recordOverruns = recorder_.overruns();
+    m.memory = engine::ReadMemoryUsage();
+
+    const auto window = callbackHistogram_.snapshot().since(metricsBaseline_);
+    m.windowCallbacks = window.callbacks;
+    m.windowOverruns = window.overruns;
+    m.windowMsP50 = window.percentileUs(0.50) / 1000.0;
+    m.windowMsP95 = window.percentileUs(0.95) / 1000.0;
+    m.windowMsP99 = window.percentileUs(0.99) / 1000.0;
+    m.windowMsP999 = window.percentileUs(0.999) / 1000.0;
+    m.windowMsMax = window.maxUs() / 1000.0;
+    m.stages = synthEngine_.stageProfile();
+    m.stages += profiler_.snapshot();
     return m;
 }
 
+bool SatoriRealtimeEngine::startRecording(const std::filesystem::path& path,
+                                          audio::SampleFormat format,
+                                          std::string& errorMessage) {
+    audio::WaveFormat wave;
+    wave.sampleRate = audioConfig_.sampleRate;
+    wave.sampleFormat = format;
+    wave.channels = audioConfig_.channels;
+    return recorder_.start(path, wave, errorMessage);
+}
+
+bool SatoriRealtimeEngine::playMidiFile(const std::filesystem::path& path,
+                                        std::string& errorMessage) {
+    stopMidiFile();
+    if (!midiPlayer_.open(path, errorMessage)) {
+        return false;
+    }
+    // Time zero one lookahead out, so the first events are not already late.
+    midiPlayer_.start(synthEngine_.renderedFrames() + midiLookaheadFrames(),
+                      synthConfig_.sampleRate);
+    pumpMidiFile();
+    return true;
+}
+
+bool SatoriRealtimeEngine::pumpMidiFile() {
+    if (midiPlayer_.finished()) {
+        return false;
+    }
+    midiPlayer_.schedule(synthEngine_, synthEngine_.renderedFrames() + 2 * midiLookaheadFrames());
+    return !midiPlayer_.finished();
+}
+
+void SatoriRealtimeEngine::stopMidiFile() {
+    if (midiPlayer_.isOpen()) {
+        midiPlayer_.stop(synthEngine_, synthEngine_.renderedFrames());
+    }
+}
+
+std::uint64_t SatoriRealtimeEngine::midiLookaheadFrames() const {
+    return static_cast<std::uint64_t>(
+        std::ceil(engine::MidiFilePlayer::kDefaultLookaheadSeconds * synthConfig_.sampleRate));
+}
+
+engine::OutputLatency SatoriRealtimeEngine::outputLatency() const {
+    engine::OutputLatency latency = latency_;
+    // Shared-mode WASAPI calls back with what has drained, not the buffer.
+    const double periodMs = callbackPeriodMs_.load(std::memory_order_relaxed);
+    if (periodMs > 0.0 && latency.sampleRate > 0) {
+        latency.scheduleFrames =
+            static_cast<std::size_t>(std::llround(periodMs * latency.sampleRate / 1000.0));
+    }
+    return latency;
+}
+
+void SatoriRealtimeEngine::resetMetricsWindow() {
+    metricsBaseline_ = callbackHistogram_.snapshot();
+}
+
 void SatoriRealtimeEngine::applyPendingParams() {
     std::uint32_t mask = pendingParamMask_.exchange(0, std::memory_order_acq_rel);
+    std::array<engine::ParamValue, kParamCount> values;
+    std::size_t count = 0;
     while (mask) {
         const unsigned bit = static_cast<unsigned>(std::countr_zero(mask));
         mask &= (mask - 1);
@@ -243,13 +505,21 @@ void SatoriRealtimeEngine::applyPendingParams() {
         if (index >= kParamCount) {
             continue;
         }
-        const auto id = static_cast<engine::ParamId>(index);
-        const float value = pendingParamValues_[index].load(std::memory_order_relaxed);
-        synthEngine_.setParam(id, value);
+        values[count++] = {static_cast<engine::ParamId>(index),
+                           pendingParamValues_[index].load(std::memory_order_relaxed)};
+    }
+    if (count > 0) {
+        synthEngine_.setParams(std::span(values.data(), count));
     }
 }
 
-void SatoriRealtimeEngine::handleRender(float* output, std::size_t frames) {
+void SatoriRealtimeEngine::handleRender(float* output, std::size_t frames,
+                                        const RenderTiming& timing) {
+    const engine::RealtimeScope realtime;
+    // The backend owns this thread (ASIO's is the driver's, with denormals
+    // left on), so it is set up here.
+    const engine::ScopedDspThread dspThread("audio callback");
+    const engine::TraceZone zone("handleRender");
     LARGE_INTEGER start{};
     LARGE_INTEGER end{};
     static const LONGLONG qpcFreq = [] {
@@ -258,59 +528,71 @@ void SatoriRealtimeEngine::handleRender(float* output, std::size_t frames) {
         return f.QuadPart;
     }();
     QueryPerformanceCounter(&start);
+    if (timing.discontinuity) {
+        deviceXruns_.fetch_add(1, std::memory_order_relaxed);
+    }
 
     applyPendingParams();
 
-    const std::size_t channels = static_cast<std::size_t>(audioConfig_.channels);
-    const double outRate = static_cast<double>(audioConfig_.sampleRate);
+    // A recovered stream may come back with another layout or rate; the
+    // timing describes the buffer actually handed over.
+    const std::size_t channels =
+        static_cast<std::size_t>(timing.channels > 0 ? timing.channels : audioConfig_.channels);
+    const double outRate = static_cast<double>(timing.sampleRate > 0 ? timing.sampleRate
+                                                                      : audioConfig_.sampleRate);
     const double inRate = synthConfig_.sampleRate;
 
-    if (channels == 0 || outRate <= 0.0 || inRate <= 0.0 ||
-        std::abs(inRate - outRate) < 1e-6) {
-        engine::ProcessBlock block;
-        block.output = output;
-        block.frames = frames;
-        block.channels = audioConfig_.channels;
-        synthEngine_.process(block);
-    } else {
-        const bool needReset = (resampleChannels_ != channels) ||
-                               (std::abs(resampleInRate_ - inRate) > 1e-6) ||
-                               (std::abs(resampleOutRate_ - outRate) > 1e-6);
-        if (needReset) {
-            resampleChannels_ = channels;
-            resampleInRate_ = inRate;
-            resampleOutRate_ = outRate;
-            resampleStep_ = resampleInRate_ / resampleOutRate_;
-            resetResampler();
-        }
+    const bool sameRate =
+        channels == 0 || outRate <= 0.0 || inRate <= 0.0 || std::abs(inRate - outRate) < 1e-6;
+
+    // Anchor timestamped input to this block: events stamped during it play
+    // one block's worth of synth frames later, at their own offset. Frames
+    // the block stream already holds were rendered for this block.
+    if (inRate > 0.0 && outRate > 0.0) {
+        const auto synthFrames = static_cast<std::uint64_t>(
+            std::ceil(static_cast<double>(frames) * inRate / outRate));
+        const std::uint64_t ahead = sameRate ? blockStream_.bufferedFrames() : 0;
+        frameClock_.publish(timing.hostTicks > 0 ? timing.hostTicks : start.QuadPart,
+                            synthEngine_.renderedFrames() - ahead,
+                            inRate / static_cast<double>(qpcFreq), synthFrames);
+    }
 
-        if (!resampleReady_) {
-            resampleFrame0_.assign(channels, 0.0f);
-            resampleFrame1_.assign(channels, 0.0f);
-            ensureResampleInputFrames(2);
-            popResampleInputFrame(resampleFrame0_);
-            popResampleInputFrame(resampleFrame1_);
-            resampleReady_ = true;
+    if (sameRate) {
+        if (blockStream_.channels() != channels) {
+            // Normally set up by resetResampler() while stopped.
+            blockStream_.configure(blockStream_.blockFrames(), channels);
         }
-
-        const float phaseEps = 1e-7f;
-        for (std::size_t f = 0; f < frames; ++f) {
-            const float t = static_cast<float>(std::clamp(resamplePhase_, 0.0, 1.0));
-            const float a = 1.0f - t;
-            const std::size_t base = f * channels;
-            for (std::size_t ch = 0; ch < channels; ++ch) {
-                output[base + ch] = resampleFrame0_[ch] * a + resampleFrame1_[ch] * t;
-            }
-
-            resamplePhase_ += resampleStep_;
-            while (resamplePhase_ >= 1.0 - phaseEps) {
-                resamplePhase_ -= 1.0;
-                resampleFrame0_ = resampleFrame1_;
-                ensureResampleInputFrames(1);
-                popResampleInputFrame(resampleFrame1_);
+        blockStream_.process(output, frames, [&](float* samples, std::size_t count) {
+            engine::ProcessBlock block{samples, count, static_cast<std::uint16_t>(channels)};
+            // Pass-through only (see resetResampler()): the input is this
+            // very period's.
+            if (blockStream_.blockFrames() == 0) {
+                block.input = timing.input;
+                block.inputChannels = timing.inputChannels;
             }
+            synthEngine_.process(block);
+        });
+    } else {
+        const int srcRate = static_cast<int>(std::lround(inRate));
+        const int dstRate = static_cast<int>(std::lround(outRate));
+        if (!resampler_.matches(srcRate, dstRate, channels)) {
+            // Rates are normally set up by resetResampler() while stopped.
+            resampler_.configure(srcRate, dstRate, channels);
         }
+        // The synth times its own stages; only the resampler's share is
+        // charged here.
+        engine::StageLap lap(profiler_);
+        resampler_.process(output, frames, [&](float* input, std::size_t count) {
+            lap.mark(engine::ProfileStage::Resampler);
+            engine::ProcessBlock block{input, count, static_cast<std::uint16_t>(channels)};
+            synthEngine_.process(block);
+            lap.skip();
+        });
+        lap.mark(engine::ProfileStage::Resampler);
     }
+    // What the device plays, after resampling.
+    scopeTap_.publish(output, frames, channels);
+    recorder_.push(output, frames, channels);
 
     QueryPerformanceCounter(&end);
     const double elapsedMs =
@@ -329,64 +611,70 @@ void SatoriRealtimeEngine::handleRender(float* output, std::size_t frames) {
     if (elapsedMs > prevMax) {
         callbackMsMax_.store(elapsedMs, std::memory_order_relaxed);
     }
-}
-
-void SatoriRealtimeEngine::resetResampler() {
-    resamplePhase_ = 0.0;
-    resampleFifo_.clear();
-    resampleReadSample_ = 0;
-    resampleFrame0_.clear();
-    resampleFrame1_.clear();
-    resampleReady_ = false;
-}
 
-void SatoriRealtimeEngine::ensureResampleInputFrames(std::size_t frames) {
-    const std::size_t channels = static_cast<std::size_t>(audioConfig_.channels);
-    if (channels == 0) {
-        return;
-    }
-    if (resampleReadSample_ > 0 && resampleReadSample_ >= 8192 * channels) {
-        resampleFifo_.erase(resampleFifo_.begin(),
-                            resampleFifo_.begin() + static_cast<std::ptrdiff_t>(resampleReadSample_));
-        resampleReadSample_ = 0;
+    const double periodUs = outRate > 0.0 ? static_cast<double>(frames) * 1e6 / outRate : 0.0;
+    callbackPeriodMs_.store(periodUs / 1000.0, std::memory_order_relaxed);
+    callbackHistogram_.record(elapsedMs * 1000.0, periodUs);
+    const int level = governor_.record(elapsedMs * 1000.0, periodUs);
+    if (level != appliedQualityLevel_) {
+        applyQualityLevel(level);
     }
+}
 
-    const std::size_t availableSamples =
-        resampleFifo_.size() >= resampleReadSample_ ? (resampleFifo_.size() - resampleReadSample_) : 0;
-    const std::size_t availableFrames = availableSamples / channels;
-    if (availableFrames >= frames) {
-        return;
-    }
-
-    const std::size_t need = frames - availableFrames;
-    const std::size_t renderFrames = std::max<std::size_t>(need, 256);
-
-    std::vector<float> temp(renderFrames * channels, 0.0f);
-    engine::ProcessBlock block{temp.data(), renderFrames, static_cast<uint16_t>(channels)};
-    synthEngine_.process(block);
-    resampleFifo_.insert(resampleFifo_.end(), temp.begin(), temp.end());
+void SatoriRealtimeEngine::applyQualityLevel(int level) {
+    // The room tail goes first: trimming it is inaudible at first and saves
+    // the most. Voices are shed only once the tail is at its shortest.
+    static constexpr std::array<engine::RoomQuality, engine::QualityGovernor::kMaxLevel + 1>
+        kRoomQuality = {engine::RoomQuality::Full, engine::RoomQuality::Medium,
+                        engine::RoomQuality::Low, engine::RoomQuality::Low};
+    static constexpr std::array<double, engine::QualityGovernor::kMaxLevel + 1> kVoiceShare = {
+        1.0, 1.0, 0.5, 0.25};
+    static constexpr std::size_t kMinVoices = 4;
+    level = std::clamp(level, 0, engine::QualityGovernor::kMaxLevel);
+    const auto index = static_cast<std::size_t>(level);
+    synthEngine_.setRoomQuality(kRoomQuality[index]);
+    // Voices are shed by what they cost to render rather than by count, so
+    // a share of cheap notes still sounds more of them; at full share there
+    // is no budget at all.
+    const double share = static_cast<double>(synthEngine_.maxVoices()) * kVoiceShare[index];
+    synthEngine_.setVoiceBudget(
+        kVoiceShare[index] >= 1.0
+            ? 0.0f
+            : static_cast<float>(std::max(static_cast<double>(kMinVoices), share)));
+    appliedQualityLevel_ = level;
 }
 
-void SatoriRealtimeEngine::popResampleInputFrame(std::vector<float>& frame) {
+void SatoriRealtimeEngine::resetResampler() {
+    const int srcRate = static_cast<int>(std::lround(synthConfig_.sampleRate));
+    const int dstRate = static_cast<int>(audioConfig_.sampleRate);
     const std::size_t channels = static_cast<std::size_t>(audioConfig_.channels);
-    if (channels == 0) {
-        frame.clear();
-        return;
+    if (resampler_.matches(srcRate, dstRate, channels)) {
+        resampler_.reset();
+    } else {
+        resampler_.configure(srcRate, dstRate, channels);
     }
-    frame.resize(channels);
-    ensureResampleInputFrames(1);
-
-    const std::size_t availableSamples =
-        resampleFifo_.size() >= resampleReadSample_ ? (resampleFifo_.size() - resampleReadSample_) : 0;
-    if (availableSamples < channels) {
-        std::fill(frame.begin(), frame.end(), 0.0f);
-        return;
+    // Exclusive and ASIO buffers keep one size, which the synth renders as
+    // is. So does a duplex stream whatever the size, since re-blocking would
+    // put a FIFO between the live input and the output.
+    const bool variableBuffers = audioConfig_.backend == AudioBackendType::WasapiShared &&
+                                 audioConfig_.wasapiMode != WasapiMode::Exclusive &&
+                                 audioConfig_.inputChannels == 0;
+    const std::size_t blockFrames =
+        variableBuffers ? dsp::FixedBlockStream::BlockFramesFor(audioConfig_.bufferFrames) : 0;
+    if (blockStream_.matches(blockFrames, channels)) {
+        blockStream_.reset();
+    } else {
+        blockStream_.configure(blockFrames, channels);
     }
-
-    for (std::size_t ch = 0; ch < channels; ++ch) {
-        frame[ch] = resampleFifo_[resampleReadSample_ + ch];
+    latency_ = {};
+    latency_.sampleRate = audioConfig_.sampleRate;
+    latency_.scheduleFrames = audioConfig_.bufferFrames;
+    latency_.deviceFrames = audioConfig_.outputLatencyFrames;
+    if (srcRate > 0) {
+        latency_.resamplerFrames = static_cast<std::size_t>(
+            std::llround(resampler_.latencyFrames() * dstRate / srcRate));
     }
-    resampleReadSample_ += channels;
+    callbackPeriodMs_.store(0.0, std::memory_order_relaxed);  // the old stream's
 }
 
 }  // namespace winaudio
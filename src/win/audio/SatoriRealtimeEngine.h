@@ -2,9 +2,21 @@
 
 #include <array>
 #include <atomic>
+#include <filesystem>
 #include <string>
 #include <vector>
 
+#include "audio/SampleConvert.h"
+#include "dsp/FixedBlockStream.h"
+#include "dsp/Resampler.h"
+#include "engine/HostFrameClock.h"
+#include "engine/LatencyHistogram.h"
+#include "engine/MidiFilePlayer.h"
+#include "engine/OutputRecorder.h"
+#include "engine/QualityGovernor.h"
+#include "engine/RealtimeMetrics.h"
+#include "engine/ScopeTap.h"
+#include "engine/StageProfiler.h"
 #include "engine/StringSynthEngine.h"
 #include "synthesis/KarplusStrongString.h"
 #include "win/audio/AudioEngineTypes.h"
@@ -16,14 +28,10 @@ inline constexpr double kDefaultNoteDurationSeconds = 2.0;
 
 class SatoriRealtimeEngine {
 public:
-    struct RealtimeMetrics {
-        std::uint64_t callbackCount = 0;
-        double callbackMsAvg = 0.0;
-        double callbackMsMax = 0.0;
-        std::uint32_t pendingParamMask = 0;
-    };
-
-    SatoriRealtimeEngine();
+    using RealtimeMetrics = engine::RealtimeMetrics;
+
+    explicit SatoriRealtimeEngine(
+        std::size_t maxVoices = engine::StringSynthEngine::kDefaultMaxVoices);
     ~SatoriRealtimeEngine();
 
     bool initialize();
@@ -34,11 +42,28 @@ public:
 
     void triggerNote(double frequency,
                      double durationSeconds = kDefaultNoteDurationSeconds);
+    // Stamped with the current QPC time (see noteOnAt), so UI notes keep
+    // their spacing instead of bunching at callback boundaries.
     void noteOn(int midiNote, double frequency, float velocity = 1.0f);
     void noteOff(int midiNote);
+    // Timestamped input (MIDI): `hostTicks` is a QueryPerformanceCounter
+    // time. The note lands at that offset into the block after the one it
+    // arrived in, rather than at whichever block boundary comes next.
+    // Before the first callback the engine's current frame is used.
+    void noteOnAt(int midiNote, double frequency, float velocity, std::int64_t hostTicks);
+    void noteOffAt(int midiNote, std::int64_t hostTicks);
     void setSynthConfig(const synthesis::StringConfig& config);
+    // Patch change while playing (see StringSynthEngine::loadPreset): unlike
+    // setSynthConfig() the stream keeps running; the callback crossfades it in.
+    void loadPreset(const engine::Preset& preset);
+    // Staged on the UI thread and handed to the callback by commitParams(),
+    // so a drag that moves a knob several times a frame costs the audio
+    // thread one update. Applied at once while the stream is stopped.
     void setParam(engine::ParamId id, float value);
     float getParam(engine::ParamId id) const;
+    // Once per display frame: publishes the values staged since the last
+    // commit as one snapshot, which the callback applies in one engine call.
+    void commitParams();
     void setMasterGain(float value);
     float masterGain() const;
     const synthesis::StringConfig& synthConfig() const { return synthConfig_; }
@@ -48,43 +73,99 @@ public:
     // mix sample rate is not user-controlled; the synth may run at a different
     // internal rate and be resampled to the device rate.
     bool reconfigureAudio(const AudioEngineConfig& config);
+    // Runs the synth at the device rate instead of resampling to it (ASIO
+    // always does). The room kernels for each rate are cached, so switching
+    // devices back and forth stays cheap.
+    void setFollowDeviceRate(bool enabled);
+    bool followDeviceRate() const { return followDeviceRate_; }
     const std::string& lastError() const { return audioEngine_.lastError(); }
+    // metrics() and resetMetricsWindow() belong to one (UI) thread; neither
+    // blocks the audio callback.
     RealtimeMetrics metrics() const;
+    // End-to-end output latency (also in metrics()): set on every device or
+    // synth-rate change, with the schedule share following the last
+    // callback's length once the stream runs.
+    engine::OutputLatency outputLatency() const;
+    void resetMetricsWindow();
+    // Newest `count` output samples, mono at scopeSampleRate(), for the live
+    // scope. False until enough has played or if the copy raced the callback.
+    bool readScope(float* out, std::size_t count) const {
+        return scopeTap_.readLatest(out, count);
+    }
+    // Records what the device plays, after resampling, to a WAV file at the
+    // device rate (Int24 or Float32 are the useful choices). The callback
+    // only copies into the recorder's ring; the file is written elsewhere.
+    bool startRecording(const std::filesystem::path& path, audio::SampleFormat format,
+                        std::string& errorMessage);
+    bool stopRecording(std::string& errorMessage) { return recorder_.stop(errorMessage); }
+    bool isRecording() const { return recorder_.isRecording(); }
+    // MIDI file playback, all on one (UI) thread. playMidiFile() starts the
+    // file a lookahead window ahead of the render position; pumpMidiFile()
+    // then has to run every few tens of milliseconds to queue the next
+    // stretch, and returns false once everything is queued.
+    bool playMidiFile(const std::filesystem::path& path, std::string& errorMessage);
+    bool pumpMidiFile();
+    void stopMidiFile();
+    bool midiFilePlaying() const { return !midiPlayer_.finished(); }
+    double scopeSampleRate() const {
+        return static_cast<double>(audioConfig_.sampleRate) / engine::ScopeTap::kDecimation;
+    }
 
 private:
-    void handleRender(float* output, std::size_t frames);
+    void handleRender(float* output, std::size_t frames, const RenderTiming& timing);
     void applyPendingParams();
+    // Also refreshes latency_, which depends on both rates.
     void resetResampler();
-    void ensureResampleInputFrames(std::size_t frames);
-    void popResampleInputFrame(std::vector<float>& frame);
+    std::uint64_t midiLookaheadFrames() const;
+    // Audio thread: maps the governor's level onto room quality and polyphony.
+    void applyQualityLevel(int level);
 
     AudioEngineConfig audioConfig_;
     synthesis::StringConfig synthConfig_;
     float masterGain_ = 1.0f;
     float ampReleaseSeconds_ = 0.35f;
+    float pitchBend_ = 0.0f;
+    float vibratoRate_ = 5.0f;
+    float vibratoDepth_ = 0.0f;
+    float sustainPedal_ = 0.0f;
+    float sostenutoPedal_ = 0.0f;
+    float inputMode_ = 0.0f;
+    float inputGain_ = 1.0f;
+    bool followDeviceRate_ = false;
 
     UnifiedAudioEngine audioEngine_;
     engine::StringSynthEngine synthEngine_;
 
     static constexpr std::size_t kParamCount =
-        static_cast<std::size_t>(engine::ParamId::AmpRelease) + 1;
+        static_cast<std::size_t>(engine::ParamId::InputGain) + 1;
+    static_assert(kParamCount <= 32, "pendingParamMask_ holds one bit per param");
     std::array<std::atomic<float>, kParamCount> pendingParamValues_{};
     std::atomic<std::uint32_t> pendingParamMask_{0};
+    // UI thread only.
+    std::array<float, kParamCount> stagedParamValues_{};
+    std::uint32_t stagedParamMask_ = 0;
 
     std::atomic<std::uint64_t> callbackCount_{0};
     std::atomic<double> callbackMsMax_{0.0};
     std::atomic<double> callbackMsAvg_{0.0};
-
-    double resampleInRate_ = 0.0;
-    double resampleOutRate_ = 0.0;
-    std::size_t resampleChannels_ = 0;
-    double resampleStep_ = 1.0;
-    double resamplePhase_ = 0.0;
-    std::vector<float> resampleFifo_;
-    std::size_t resampleReadSample_ = 0;
-    std::vector<float> resampleFrame0_;
-    std::vector<float> resampleFrame1_;
-    bool resampleReady_ = false;
+    std::atomic<double> callbackPeriodMs_{0.0};
+    std::atomic<std::uint64_t> deviceXruns_{0};
+    engine::LatencyHistogram callbackHistogram_;
+    engine::LatencyHistogram::Snapshot metricsBaseline_;
+    engine::StageProfiler profiler_;  // resampler stage; the synth keeps its own
+    engine::ScopeTap scopeTap_;
+    engine::OutputRecorder recorder_;
+    engine::MidiFilePlayer midiPlayer_;
+    engine::HostFrameClock frameClock_;  // QPC -> synth frames, per callback
+    engine::QualityGovernor governor_;
+    int appliedQualityLevel_ = 0;  // audio thread
+
+    // Synth rate -> device rate when they differ (shared-mode WASAPI).
+    dsp::StreamingResampler resampler_;
+    // Shared-mode WASAPI asks for whatever the buffer has free; at equal
+    // rates the synth still renders fixed blocks through this.
+    dsp::FixedBlockStream blockStream_;
+    engine::OutputLatency latency_;  // UI thread, from resetResampler()
 };
 
 }  // namespace winaudio
@@ -100,6 +100,13 @@ const std::string& UnifiedAudioEngine::lastError() const {
     return empty;
 }
 
+std::uint64_t UnifiedAudioEngine::streamRecoveries() const {
+    if (backend_ == AudioBackendType::Asio) {
+        return 0;
+    }
+    return wasapi_ ? wasapi_->streamRecoveries() : 0;
+}
+
 std::vector<AudioDeviceInfo> UnifiedAudioEngine::EnumerateDevices() {
     std::vector<AudioDeviceInfo> devices;
     // WASAPI shared endpoints.
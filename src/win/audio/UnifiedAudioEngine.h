@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -26,6 +27,8 @@ public:
     bool isRunning() const;
     const AudioEngineConfig& config() const;
     const std::string& lastError() const;
+    // Streams the backend rebuilt on its own after a device failure (WASAPI).
+    std::uint64_t streamRecoveries() const;
 
     static std::vector<AudioDeviceInfo> EnumerateDevices();
 
@@ -2,14 +2,17 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <sstream>
 #include <thread>
 
 #include <functiondiscoverykeys_devpkey.h>
+#include <ksmedia.h>
+#include <mmreg.h>
 #include <propsys.h>
 
-#include "dsp/Denormals.h"
+#include "engine/RealtimeThread.h"
 
 namespace winaudio {
 
@@ -70,6 +73,45 @@ bool SetWaveFormatSampleRate(WAVEFORMATEX* format, uint32_t sampleRate) {
     return true;
 }
 
+uint32_t DurationToFrames(REFERENCE_TIME duration, uint32_t sampleRate) {
+    return static_cast<uint32_t>((std::max<REFERENCE_TIME>(0, duration) * sampleRate + 5000000LL) /
+                                 10000000LL);
+}
+
+REFERENCE_TIME FramesToDuration(uint32_t frames, uint32_t sampleRate) {
+    return static_cast<REFERENCE_TIME>(
+        (10000000LL * frames + sampleRate / 2) / std::max<uint32_t>(1, sampleRate));
+}
+
+WAVEFORMATEXTENSIBLE MakeExtensibleFormat(uint32_t sampleRate,
+                                          WORD channels,
+                                          DWORD channelMask,
+                                          bool isFloat,
+                                          WORD bits,
+                                          WORD validBits) {
+    WAVEFORMATEXTENSIBLE format{};
+    format.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    format.Format.nChannels = channels;
+    format.Format.nSamplesPerSec = sampleRate;
+    format.Format.wBitsPerSample = bits;
+    format.Format.nBlockAlign = static_cast<WORD>(channels * bits / 8);
+    format.Format.nAvgBytesPerSec = sampleRate * format.Format.nBlockAlign;
+    format.Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+    format.Samples.wValidBitsPerSample = validBits;
+    format.dwChannelMask = channelMask;
+    format.SubFormat = isFloat ? KSDATAFORMAT_SUBTYPE_IEEE_FLOAT : KSDATAFORMAT_SUBTYPE_PCM;
+    return format;
+}
+
+template <typename T>
+void ConvertToInt(const float* src, std::size_t count, BYTE* dst, double fullScale) {
+    T* out = reinterpret_cast<T*>(dst);
+    for (std::size_t i = 0; i < count; ++i) {
+        const double v = std::clamp(static_cast<double>(src[i]), -1.0, 1.0) * fullScale;
+        out[i] = static_cast<T>(std::lround(v));
+    }
+}
+
 }  // namespace
 
 WASAPIAudioEngine::WASAPIAudioEngine(AudioEngineConfig config)
@@ -86,6 +128,7 @@ bool WASAPIAudioEngine::initialize(RenderCallback callback) {
         return true;
     }
     lastError_.clear();
+    requestedInputChannels_ = config_.inputChannels;
     renderCallback_ = std::move(callback);
     if (!createDevice() || !createClient() || !createEventHandle()) {
         shutdown();
@@ -107,6 +150,7 @@ void WASAPIAudioEngine::shutdown() {
         CloseHandle(audioEvent_);
         audioEvent_ = nullptr;
     }
+    closeCapture();
     renderClient_.Reset();
     audioClient_.Reset();
     device_.Reset();
@@ -138,9 +182,12 @@ void WASAPIAudioEngine::stop() {
     if (audioClient_) {
         audioClient_->Stop();
     }
+    if (captureClient_) {
+        captureClient_->Stop();
+    }
 }
 
-bool WASAPIAudioEngine::createDevice() {
+bool WASAPIAudioEngine::createDevice(bool defaultEndpoint) {
     HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
                                   IID_PPV_ARGS(&enumerator_));
     if (FAILED(hr)) {
@@ -149,14 +196,15 @@ bool WASAPIAudioEngine::createDevice() {
         LogError(message);
         return false;
     }
-    if (!config_.deviceId.empty()) {
+    const bool byId = !defaultEndpoint && !config_.deviceId.empty();
+    if (byId) {
         hr = enumerator_->GetDevice(config_.deviceId.c_str(), &device_);
     } else {
         hr = enumerator_->GetDefaultAudioEndpoint(eRender, eConsole, &device_);
     }
     if (FAILED(hr)) {
         const auto message = FormatHResult(
-            config_.deviceId.empty() ? "GetDefaultAudioEndpoint" : "GetDevice", hr);
+            byId ? "GetDevice" : "GetDefaultAudioEndpoint", hr);
         setLastError(message);
         LogError(message);
         return false;
@@ -212,9 +260,6 @@ bool WASAPIAudioEngine::configureEngine(RenderCallback callback) {
         return false;
     }
 
-    const uint32_t requestedSampleRate = config_.sampleRate;
-    const uint32_t requestedBufferFrames = config_.bufferFrames;
-
     MixFormatHolder mixFormat;
     HRESULT hr = audioClient_->GetMixFormat(&mixFormat);
     if (FAILED(hr) || mixFormat.get() == nullptr) {
@@ -224,52 +269,284 @@ bool WASAPIAudioEngine::configureEngine(RenderCallback callback) {
         return false;
     }
 
+    // Exclusive -> low-latency shared -> shared; each failed attempt leaves a
+    // fresh client behind for the next one.
+    const WasapiMode requested = config_.wasapiMode;
+    bool ready = false;
+    if (requested == WasapiMode::Exclusive) {
+        ready = initializeExclusive(*mixFormat.get());
+        if (ready) {
+            config_.wasapiMode = WasapiMode::Exclusive;
+        } else {
+            LogError("[WASAPI] exclusive mode unavailable, falling back to shared\n");
+        }
+    }
+    if (!ready && requested != WasapiMode::Shared && audioClient_) {
+        ready = initializeLowLatencyShared(mixFormat.get());
+        if (ready) {
+            config_.wasapiMode = WasapiMode::LowLatencyShared;
+        }
+    }
+    if (!ready && audioClient_) {
+        ready = initializeShared(mixFormat.get());
+        config_.wasapiMode = WasapiMode::Shared;
+    }
+    if (!ready || !finishInitialize()) {
+        return false;
+    }
+    config_.inputChannels = 0;
+    if (requestedInputChannels_ > 0 && !openCapture()) {
+        // The synth still plays; effect mode just has nothing to process.
+        LogError("[WASAPI] capture unavailable, output only\n");
+        closeCapture();
+    }
+    return true;
+}
+
+bool WASAPIAudioEngine::openCapture() {
+    HRESULT hr = config_.inputDeviceId.empty()
+                     ? enumerator_->GetDefaultAudioEndpoint(eCapture, eConsole, &captureDevice_)
+                     : enumerator_->GetDevice(config_.inputDeviceId.c_str(), &captureDevice_);
+    if (SUCCEEDED(hr)) {
+        hr = captureDevice_->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
+                                      &captureClient_);
+    }
+    if (FAILED(hr)) {
+        LogError(FormatHResult("capture endpoint", hr));
+        return false;
+    }
+    // Float at the render stream's rate in whatever layout was asked for;
+    // the audio engine converts, so no resampler sits on the capture side.
+    const WORD channels = requestedInputChannels_;
+    const WAVEFORMATEXTENSIBLE format = MakeExtensibleFormat(
+        config_.sampleRate, channels, channels == 1 ? SPEAKER_FRONT_CENTER
+                                                    : SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT,
+        true, 32, 32);
+    // Polled from the render thread; the buffer only has to outlast a
+    // render period or two.
+    const REFERENCE_TIME duration = FramesToDuration(4 * config_.bufferFrames, config_.sampleRate);
+    hr = captureClient_->Initialize(
+        AUDCLNT_SHAREMODE_SHARED,
+        AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY, duration, 0,
+        reinterpret_cast<const WAVEFORMATEX*>(&format), nullptr);
+    if (SUCCEEDED(hr)) {
+        hr = captureClient_->GetService(__uuidof(IAudioCaptureClient), &captureReader_);
+    }
+    if (FAILED(hr)) {
+        LogError(FormatHResult("IAudioClient::Initialize (capture)", hr));
+        return false;
+    }
+    config_.inputChannels = channels;
+    captureHeld_.assign(static_cast<std::size_t>(2 * config_.bufferFrames) * channels, 0.0f);
+    captureHeldFrames_ = 0;
+    inputBuffer_.assign(static_cast<std::size_t>(config_.bufferFrames) * channels, 0.0f);
+    return true;
+}
+
+void WASAPIAudioEngine::closeCapture() {
+    if (captureClient_) {
+        captureClient_->Stop();
+    }
+    captureReader_.Reset();
+    captureClient_.Reset();
+    captureDevice_.Reset();
+    config_.inputChannels = 0;
+    captureHeldFrames_ = 0;
+}
+
+const float* WASAPIAudioEngine::readCapture(UINT32 frames) {
+    const std::size_t channels = config_.inputChannels;
+    const std::size_t capacity = captureHeld_.size() / channels;
+    UINT32 packet = 0;
+    while (SUCCEEDED(captureReader_->GetNextPacketSize(&packet)) && packet > 0) {
+        BYTE* data = nullptr;
+        UINT32 count = 0;
+        DWORD flags = 0;
+        if (FAILED(captureReader_->GetBuffer(&data, &count, &flags, nullptr, nullptr))) {
+            break;
+        }
+        // Oldest first out when the packets outrun the hold.
+        const std::size_t keep = std::min<std::size_t>(count, capacity);
+        const std::size_t drop =
+            captureHeldFrames_ + keep > capacity ? captureHeldFrames_ + keep - capacity : 0;
+        std::copy(captureHeld_.begin() + drop * channels,
+                  captureHeld_.begin() + captureHeldFrames_ * channels, captureHeld_.begin());
+        captureHeldFrames_ -= drop;
+        float* dst = captureHeld_.data() + captureHeldFrames_ * channels;
+        const auto* src = reinterpret_cast<const float*>(data) + (count - keep) * channels;
+        if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+            std::fill_n(dst, keep * channels, 0.0f);
+        } else {
+            std::copy(src, src + keep * channels, dst);
+        }
+        captureHeldFrames_ += keep;
+        captureReader_->ReleaseBuffer(count);
+    }
+    // The period's worth from the front, padded with silence while the
+    // capture stream has not caught up; more than a period left over is
+    // latency and is dropped.
+    const std::size_t take = std::min<std::size_t>(frames, captureHeldFrames_);
+    float* out = inputBuffer_.data();
+    std::copy(captureHeld_.begin(), captureHeld_.begin() + take * channels,
+              out + (frames - take) * channels);
+    std::fill_n(out, (frames - take) * channels, 0.0f);
+    const std::size_t left = captureHeldFrames_ - take;
+    const std::size_t skip = take + (left > frames ? left - frames : 0);
+    std::copy(captureHeld_.begin() + skip * channels,
+              captureHeld_.begin() + captureHeldFrames_ * channels, captureHeld_.begin());
+    captureHeldFrames_ -= skip;
+    return out;
+}
+
+bool WASAPIAudioEngine::initializeExclusive(const WAVEFORMATEX& mixFormat) {
+    const uint32_t sampleRate =
+        config_.sampleRate > 0 ? config_.sampleRate : mixFormat.nSamplesPerSec;
+    const WORD channels = mixFormat.nChannels;
+    DWORD channelMask = 0;
+    if (mixFormat.wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        channelMask = reinterpret_cast<const WAVEFORMATEXTENSIBLE&>(mixFormat).dwChannelMask;
+    }
+
+    struct Candidate {
+        SampleFormat sampleFormat;
+        WORD bits;
+        WORD validBits;
+    };
+    const Candidate candidates[] = {{SampleFormat::Float32, 32, 32},
+                                    {SampleFormat::Int32, 32, 32},
+                                    {SampleFormat::Int32, 32, 24},
+                                    {SampleFormat::Int16, 16, 16}};
+    for (const auto& candidate : candidates) {
+        auto format = MakeExtensibleFormat(sampleRate, channels, channelMask,
+                                           candidate.sampleFormat == SampleFormat::Float32,
+                                           candidate.bits, candidate.validBits);
+        if (audioClient_->IsFormatSupported(AUDCLNT_SHAREMODE_EXCLUSIVE, &format.Format,
+                                            nullptr) != S_OK) {
+            continue;
+        }
+
+        REFERENCE_TIME defaultPeriod = 0;
+        REFERENCE_TIME minPeriod = 0;
+        audioClient_->GetDevicePeriod(&defaultPeriod, &minPeriod);
+        REFERENCE_TIME period =
+            std::max(minPeriod, FramesToDuration(config_.bufferFrames, sampleRate));
+        HRESULT hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE,
+                                              AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period,
+                                              period, &format.Format, nullptr);
+        if (hr == AUDCLNT_E_BUFFER_SIZE_NOT_ALIGNED) {
+            // Retry with the aligned size the driver suggests on a new client.
+            UINT32 alignedFrames = 0;
+            audioClient_->GetBufferSize(&alignedFrames);
+            period = FramesToDuration(alignedFrames, sampleRate);
+            if (!createClient()) {
+                return false;
+            }
+            hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE,
+                                          AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period, period,
+                                          &format.Format, nullptr);
+        }
+        if (SUCCEEDED(hr)) {
+            sampleFormat_ = candidate.sampleFormat;
+            config_.sampleRate = sampleRate;
+            config_.channels = channels;
+            return true;
+        }
+        LogError(FormatHResult("IAudioClient::Initialize (exclusive)", hr));
+        // The device accepted the format but not the stream (e.g. in use by
+        // another exclusive client); other formats won't help.
+        createClient();
+        return false;
+    }
+    return false;
+}
+
+bool WASAPIAudioEngine::initializeLowLatencyShared(const WAVEFORMATEX* mixFormat) {
+    Microsoft::WRL::ComPtr<IAudioClient3> client3;
+    if (FAILED(audioClient_.As(&client3))) {
+        return false;
+    }
+    UINT32 defaultFrames = 0;
+    UINT32 fundamentalFrames = 0;
+    UINT32 minFrames = 0;
+    UINT32 maxFrames = 0;
+    HRESULT hr = client3->GetSharedModeEnginePeriod(mixFormat, &defaultFrames,
+                                                    &fundamentalFrames, &minFrames, &maxFrames);
+    if (FAILED(hr) || fundamentalFrames == 0) {
+        LogError(FormatHResult("IAudioClient3::GetSharedModeEnginePeriod", hr));
+        return false;
+    }
+    // Periods must be multiples of the fundamental period.
+    const uint32_t requested = std::max<uint32_t>(config_.bufferFrames, minFrames);
+    uint32_t period = (requested + fundamentalFrames - 1) / fundamentalFrames * fundamentalFrames;
+    period = std::clamp<uint32_t>(period, minFrames, maxFrames);
+    hr = client3->InitializeSharedAudioStream(AUDCLNT_STREAMFLAGS_EVENTCALLBACK, period,
+                                              mixFormat, nullptr);
+    if (FAILED(hr)) {
+        LogError(FormatHResult("IAudioClient3::InitializeSharedAudioStream", hr));
+        createClient();
+        return false;
+    }
+    // Low-latency streams always run at the mix format.
+    sampleFormat_ = SampleFormat::Float32;
+    config_.sampleRate = mixFormat->nSamplesPerSec;
+    config_.channels = mixFormat->nChannels;
+    return true;
+}
+
+bool WASAPIAudioEngine::initializeShared(WAVEFORMATEX* mixFormat) {
+    MixFormatHolder closestFormat;
+    WAVEFORMATEX* format = mixFormat;
+
     // Keep the device's default channel layout, but allow requesting a different
     // sample rate when supported in shared mode.
-    const uint32_t defaultSampleRate = mixFormat.get()->nSamplesPerSec;
+    const uint32_t requestedSampleRate = config_.sampleRate;
+    const uint32_t defaultSampleRate = format->nSamplesPerSec;
     if (requestedSampleRate > 0 && requestedSampleRate != defaultSampleRate) {
-        const uint32_t oldRate = mixFormat.get()->nSamplesPerSec;
-        const uint32_t oldAvgBytes = mixFormat.get()->nAvgBytesPerSec;
-        SetWaveFormatSampleRate(mixFormat.get(), requestedSampleRate);
+        const uint32_t oldRate = format->nSamplesPerSec;
+        const uint32_t oldAvgBytes = format->nAvgBytesPerSec;
+        SetWaveFormatSampleRate(format, requestedSampleRate);
 
         WAVEFORMATEX* closest = nullptr;
-        hr = audioClient_->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, mixFormat.get(),
-                                             &closest);
+        const HRESULT hr =
+            audioClient_->IsFormatSupported(AUDCLNT_SHAREMODE_SHARED, format, &closest);
         if (hr == S_OK) {
             // Keep requested format.
         } else if (hr == S_FALSE && closest) {
             // Use closest match and reflect the actual configuration.
-            mixFormat.reset(closest);
+            closestFormat.reset(closest);
+            format = closest;
         } else {
             // Unsupported: revert to device mix format sample rate.
-            mixFormat.get()->nSamplesPerSec = oldRate;
-            mixFormat.get()->nAvgBytesPerSec = oldAvgBytes;
+            format->nSamplesPerSec = oldRate;
+            format->nAvgBytesPerSec = oldAvgBytes;
             if (closest) {
                 CoTaskMemFree(closest);
             }
         }
     }
 
-    config_.sampleRate = mixFormat.get()->nSamplesPerSec;
-    config_.channels = mixFormat.get()->nChannels;
-    config_.bufferFrames = requestedBufferFrames;
+    sampleFormat_ = SampleFormat::Float32;
+    config_.sampleRate = format->nSamplesPerSec;
+    config_.channels = format->nChannels;
 
-    REFERENCE_TIME bufferDuration = static_cast<REFERENCE_TIME>(
-        10000000LL * config_.bufferFrames / config_.sampleRate);
-
-    hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_SHARED,
-                                  AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
-                                  bufferDuration, 0, mixFormat.get(), nullptr);
+    const REFERENCE_TIME bufferDuration = FramesToDuration(config_.bufferFrames, config_.sampleRate);
+    const HRESULT hr = audioClient_->Initialize(AUDCLNT_SHAREMODE_SHARED,
+                                                AUDCLNT_STREAMFLAGS_EVENTCALLBACK,
+                                                bufferDuration, 0, format, nullptr);
     if (FAILED(hr)) {
         const auto message = FormatHResult("IAudioClient::Initialize", hr);
         setLastError(message);
         LogError(message);
         return false;
     }
+    return true;
+}
+
+bool WASAPIAudioEngine::finishInitialize() {
     if (!createRenderClient()) {
         return false;
     }
-    hr = audioClient_->SetEventHandle(audioEvent_);
+    HRESULT hr = audioClient_->SetEventHandle(audioEvent_);
     if (FAILED(hr)) {
         const auto message = FormatHResult("IAudioClient::SetEventHandle", hr);
         setLastError(message);
@@ -285,7 +562,22 @@ bool WASAPIAudioEngine::configureEngine(RenderCallback callback) {
         return false;
     }
     config_.bufferFrames = bufferFrameCount;
-    // Pre-fill with silence.
+    // Each event tops the buffer back up, so new frames queue behind at most
+    // a buffer, then the stream's own latency.
+    REFERENCE_TIME streamLatency = 0;
+    if (FAILED(audioClient_->GetStreamLatency(&streamLatency))) {
+        streamLatency = 0;
+    }
+    config_.outputLatencyFrames =
+        bufferFrameCount + DurationToFrames(streamLatency, config_.sampleRate);
+    const std::size_t sampleBytes = sampleFormat_ == SampleFormat::Int16 ? 2 : 4;
+    bytesPerFrame_ = sampleBytes * config_.channels;
+    if (sampleFormat_ == SampleFormat::Float32) {
+        convertBuffer_.clear();
+    } else {
+        convertBuffer_.assign(static_cast<std::size_t>(bufferFrameCount) * config_.channels, 0.0f);
+    }
+    // Pre-fill with silence (all-zero bytes for every sample format).
     BYTE* data = nullptr;
     hr = renderClient_->GetBuffer(bufferFrameCount, &data);
     if (FAILED(hr)) {
@@ -294,8 +586,7 @@ bool WASAPIAudioEngine::configureEngine(RenderCallback callback) {
         LogError(message);
         return false;
     }
-    std::fill_n(reinterpret_cast<float*>(data),
-                bufferFrameCount * config_.channels, 0.0f);
+    std::fill_n(data, static_cast<std::size_t>(bufferFrameCount) * bytesPerFrame_, BYTE{0});
     hr = renderClient_->ReleaseBuffer(bufferFrameCount, 0);
     if (FAILED(hr)) {
         const auto message =
@@ -382,74 +673,176 @@ void WASAPIAudioEngine::renderLoop() {
     const bool comInitialized = SUCCEEDED(initHr);
 
     // Prevent denormal-induced CPU spikes in long decays (e.g. convolution IR tails).
-    dsp::ScopedDenormalsDisable denormalsGuard;
+    const engine::ScopedDspThread dspThread("audio callback", engine::RealtimeThreadRole::Render);
 
+    RenderTiming timing;
+    timing.sampleRate = config_.sampleRate;
+    timing.channels = config_.channels;
+    bool started = false;
     HRESULT hr = audioClient_->Start();
-    if (FAILED(hr)) {
-        const auto message = FormatHResult("IAudioClient::Start", hr);
-        setLastError(message);
-        LogError(message);
-        running_ = false;
-        if (comInitialized) {
-            CoUninitialize();
+    if (SUCCEEDED(hr)) {
+        startCapture();
+    } else {
+        LogError(FormatHResult("IAudioClient::Start", hr));
+        if (!recoverStream(timing)) {
+            running_ = false;
         }
-        return;
     }
-    const UINT32 channels = config_.channels;
-    const UINT32 bytesPerFrame = channels * sizeof(float);
+    // A healthy stream signals every period; this much silence from the
+    // device means it has stopped (or never started) delivering events.
+    constexpr DWORD kStallTimeoutMs = 500;
     while (running_) {
-        DWORD waitResult = WaitForSingleObject(audioEvent_, 2000);
-        if (waitResult != WAIT_OBJECT_0) {
-            const auto message =
-                FormatHResult("WaitForSingleObject", HRESULT_FROM_WIN32(GetLastError()));
-            setLastError(message);
-            LogError(message);
-            running_ = false;
+        const DWORD waitResult = WaitForSingleObject(audioEvent_, kStallTimeoutMs);
+        if (!running_) {
             break;
         }
-        UINT32 padding = 0;
-        hr = audioClient_->GetCurrentPadding(&padding);
-        if (FAILED(hr)) {
-            const auto message = FormatHResult("IAudioClient::GetCurrentPadding", hr);
+        if (waitResult == WAIT_FAILED) {
+            const auto message =
+                FormatHResult("WaitForSingleObject", HRESULT_FROM_WIN32(GetLastError()));
             setLastError(message);
             LogError(message);
             running_ = false;
             break;
         }
-        const UINT32 framesAvailable = config_.bufferFrames - padding;
-        if (framesAvailable == 0) {
+        const char* stage = "WaitForSingleObject (stalled)";
+        hr = waitResult == WAIT_TIMEOUT ? HRESULT_FROM_WIN32(ERROR_TIMEOUT)
+                                        : renderPeriod(timing, started, stage);
+        if (SUCCEEDED(hr)) {
             continue;
         }
-        BYTE* data = nullptr;
-        hr = renderClient_->GetBuffer(framesAvailable, &data);
-        if (FAILED(hr)) {
-            const auto message = FormatHResult("IAudioRenderClient::GetBuffer", hr);
-            setLastError(message);
-            LogError(message);
-            running_ = false;
-            break;
-        }
-        float* samples = reinterpret_cast<float*>(data);
-        if (renderCallback_) {
-            renderCallback_(samples, framesAvailable);
-        } else {
-            std::fill_n(samples, framesAvailable * channels, 0.0f);
-        }
-        hr = renderClient_->ReleaseBuffer(framesAvailable, 0);
-        if (FAILED(hr)) {
-            const auto message = FormatHResult("IAudioRenderClient::ReleaseBuffer", hr);
-            setLastError(message);
-            LogError(message);
-            running_ = false;
+        // Device invalidation, a lost audio service and a stalled stream all
+        // end the same way: a new stream behind the same callback.
+        LogError(FormatHResult(stage, hr));
+        if (!recoverStream(timing)) {
             break;
         }
     }
-    audioClient_->Stop();
+    if (audioClient_) {
+        audioClient_->Stop();
+    }
+    if (captureClient_) {
+        captureClient_->Stop();
+    }
     if (comInitialized) {
         CoUninitialize();
     }
 }
 
+void WASAPIAudioEngine::startCapture() {
+    if (!captureClient_) {
+        return;
+    }
+    captureHeldFrames_ = 0;
+    const HRESULT hr = captureClient_->Start();
+    if (FAILED(hr)) {
+        LogError(FormatHResult("IAudioClient::Start (capture)", hr));
+        closeCapture();
+    }
+}
+
+HRESULT WASAPIAudioEngine::renderPeriod(RenderTiming& timing, bool& started,
+                                        const char*& stage) {
+    // Exclusive event-driven streams hand over the whole buffer each period.
+    const bool exclusive = config_.wasapiMode == WasapiMode::Exclusive;
+    UINT32 padding = 0;
+    HRESULT hr = exclusive ? S_OK : audioClient_->GetCurrentPadding(&padding);
+    if (FAILED(hr)) {
+        stage = "IAudioClient::GetCurrentPadding";
+        return hr;
+    }
+    const UINT32 framesAvailable = config_.bufferFrames - padding;
+    if (framesAvailable == 0) {
+        return S_OK;
+    }
+    // A shared-mode buffer found empty after the first period has
+    // already played out and the engine inserted silence.
+    timing.discontinuity = timing.discontinuity || (started && !exclusive && padding == 0);
+    started = true;
+    BYTE* data = nullptr;
+    hr = renderClient_->GetBuffer(framesAvailable, &data);
+    if (FAILED(hr)) {
+        stage = "IAudioRenderClient::GetBuffer";
+        return hr;
+    }
+    const std::size_t sampleCount = static_cast<std::size_t>(framesAvailable) * config_.channels;
+    float* samples = sampleFormat_ == SampleFormat::Float32 ? reinterpret_cast<float*>(data)
+                                                            : convertBuffer_.data();
+    if (captureReader_) {
+        timing.input = readCapture(framesAvailable);
+        timing.inputChannels = config_.inputChannels;
+    } else {
+        timing.input = nullptr;
+        timing.inputChannels = 0;
+    }
+    if (renderCallback_) {
+        LARGE_INTEGER now{};
+        QueryPerformanceCounter(&now);
+        timing.hostTicks = now.QuadPart;
+        renderCallback_(samples, framesAvailable, timing);
+    } else {
+        std::fill_n(samples, sampleCount, 0.0f);
+    }
+    timing.discontinuity = false;
+    if (sampleFormat_ == SampleFormat::Int16) {
+        ConvertToInt<int16_t>(samples, sampleCount, data, 32767.0);
+    } else if (sampleFormat_ == SampleFormat::Int32) {
+        ConvertToInt<int32_t>(samples, sampleCount, data, 2147483647.0);
+    }
+    timing.streamFrame += framesAvailable;
+    hr = renderClient_->ReleaseBuffer(framesAvailable, 0);
+    if (FAILED(hr)) {
+        stage = "IAudioRenderClient::ReleaseBuffer";
+    }
+    return hr;
+}
+
+bool WASAPIAudioEngine::recoverStream(RenderTiming& timing) {
+    constexpr DWORD kFirstRetryMs = 50;
+    constexpr DWORD kMaxRetryMs = 2000;
+    DWORD retryMs = kFirstRetryMs;
+    for (int attempt = 0; running_; ++attempt) {
+        if (audioClient_) {
+            audioClient_->Stop();
+        }
+        closeCapture();
+        renderClient_.Reset();
+        audioClient_.Reset();
+        device_.Reset();
+        // stop() signals the event, so the backoff never delays shutdown.
+        if (attempt > 0) {
+            WaitForSingleObject(audioEvent_, retryMs);
+            retryMs = std::min(retryMs * 2, kMaxRetryMs);
+            if (!running_) {
+                break;
+            }
+        }
+        // A chosen device that is gone for good gives way to the default
+        // endpoint after the first retry.
+        const bool defaultEndpoint = attempt > 1 && !config_.deviceId.empty();
+        if (!createDevice(defaultEndpoint) || !createClient() ||
+            !configureEngine(renderCallback_)) {
+            continue;
+        }
+        const HRESULT hr = audioClient_->Start();
+        if (FAILED(hr)) {
+            LogError(FormatHResult("IAudioClient::Start (recovery)", hr));
+            continue;
+        }
+        startCapture();
+        // configureEngine() may have landed on another rate, layout or mode;
+        // the callback follows through the timing it is handed.
+        timing.sampleRate = config_.sampleRate;
+        timing.channels = config_.channels;
+        timing.discontinuity = true;
+        lastError_.clear();
+        streamRecoveries_.fetch_add(1, std::memory_order_relaxed);
+        LogError("[WASAPI] stream recovered\n");
+        return true;
+    }
+    // Only stop() ends the retries.
+    return false;
+}
+
 void WASAPIAudioEngine::setLastError(const std::string& message) {
     lastError_ = message;
 }
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <atomic>
-#include <functional>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <thread>
@@ -18,6 +18,13 @@
 
 namespace winaudio {
 
+// WASAPI output, event-driven on a render thread of its own. With
+// inputChannels set, a shared-mode capture stream on the input endpoint is
+// opened at the render rate and drained at the top of every render period.
+// WASAPI has no linked duplex streams, so the two run on their own clocks
+// from one device: the render period takes the capture frames that arrived
+// since the last one, with at most a period held back and silence while
+// capture catches up.
 class WASAPIAudioEngine {
 public:
     explicit WASAPIAudioEngine(AudioEngineConfig config = {});
@@ -33,18 +40,45 @@ public:
     bool isRunning() const { return running_; }
     const AudioEngineConfig& config() const { return config_; }
     const std::string& lastError() const { return lastError_; }
+    // Streams the render thread rebuilt after the device stalled or was
+    // invalidated (unplugged, format changed, audio service restarted).
+    std::uint64_t streamRecoveries() const {
+        return streamRecoveries_.load(std::memory_order_relaxed);
+    }
 
     static std::vector<AudioDeviceInfo> EnumerateOutputDevices();
 
 private:
-    bool createDevice();
+    bool createDevice(bool defaultEndpoint = false);
     bool createClient();
     bool createRenderClient();
     bool createEventHandle();
     bool configureEngine(RenderCallback callback);
+    bool initializeExclusive(const WAVEFORMATEX& mixFormat);
+    bool initializeLowLatencyShared(const WAVEFORMATEX* mixFormat);
+    bool initializeShared(WAVEFORMATEX* mixFormat);
+    bool finishInitialize();
+    // Capture side of full duplex; a failure leaves the engine output only.
+    bool openCapture();
+    void closeCapture();
+    void startCapture();
+    // Render thread: drains the capture stream and returns `frames` frames
+    // of input for this period.
+    const float* readCapture(UINT32 frames);
     void renderLoop();
+    // One device period: fills whatever the buffer has room for. Returns the
+    // failing call's HRESULT and names it in `stage`.
+    HRESULT renderPeriod(RenderTiming& timing, bool& started, const char*& stage);
+    // Render thread: tears down the client and brings up a new stream on the
+    // same (or, once that is gone, the default) endpoint, retrying with
+    // backoff until it succeeds or stop() is called. The render callback and
+    // everything behind it stay as they are.
+    bool recoverStream(RenderTiming& timing);
     void setLastError(const std::string& message);
 
+    // Device sample layout; exclusive mode may not accept float.
+    enum class SampleFormat { Float32, Int16, Int32 };
+
     AudioEngineConfig config_;
     RenderCallback renderCallback_;
     std::string lastError_;
@@ -54,10 +88,21 @@ private:
     Microsoft::WRL::ComPtr<IAudioClient> audioClient_;
     Microsoft::WRL::ComPtr<IAudioRenderClient> renderClient_;
     HANDLE audioEvent_ = nullptr;
+    SampleFormat sampleFormat_ = SampleFormat::Float32;
+    std::size_t bytesPerFrame_ = 0;
+    std::vector<float> convertBuffer_;  // render target for integer formats
+    std::uint16_t requestedInputChannels_ = 0;
+    Microsoft::WRL::ComPtr<IMMDevice> captureDevice_;
+    Microsoft::WRL::ComPtr<IAudioClient> captureClient_;
+    Microsoft::WRL::ComPtr<IAudioCaptureClient> captureReader_;
+    std::vector<float> captureHeld_;  // up to two periods, interleaved
+    std::size_t captureHeldFrames_ = 0;
+    std::vector<float> inputBuffer_;  // the period handed to the callback
 
     std::unique_ptr<std::thread> renderThread_;
     std::atomic<bool> running_{false};
     std::atomic<bool> initialized_{false};
+    std::atomic<std::uint64_t> streamRecoveries_{0};
 };
 
 }  // namespace winaudio
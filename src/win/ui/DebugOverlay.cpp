@@ -3,10 +3,14 @@
 #include <d2d1helper.h>
 
 #include "win/ui/D2DHelpers.h"
+#include "win/ui/UiBenchmark.h"
 
 namespace winui {
 namespace {
 constexpr float kDefaultStrokeWidth = 1.0f;
+constexpr float kStatsPadding = 8.0f;
+constexpr float kStatsLineHeight = 20.0f;
+constexpr float kStatsWidth = 460.0f;
 }  // namespace
 
 DebugOverlayPalette MakeUnifiedDebugOverlayPalette() {
@@ -26,7 +30,7 @@ void DebugBoxRenderer::setPalette(const DebugOverlayPalette& palette) {
     strokeBrush_.Reset();
 }
 
-void DebugBoxRenderer::render(ID2D1HwndRenderTarget* target,
+void DebugBoxRenderer::render(ID2D1RenderTarget* target,
                               const DebugBoxModel& model,
                               bool alignToPixel) {
     if (!target || model.segments.empty()) {
@@ -46,14 +50,53 @@ void DebugBoxRenderer::render(ID2D1HwndRenderTarget* target,
     }
 }
 
-void DebugBoxRenderer::ensureBrushes(ID2D1HwndRenderTarget* target) {
+void DebugBoxRenderer::ensureBrushes(ID2D1RenderTarget* target) {
     if (!target) {
         return;
     }
     if (!strokeBrush_) {
+        CountUiResourceCreation();
         target->CreateSolidColorBrush(palette_.stroke, &strokeBrush_);
     }
 }
+
+void DebugStatsRenderer::render(ID2D1RenderTarget* target, IDWriteTextFormat* format,
+                                const DebugStatsText& text) {
+    if (!target || !format || text.lines.empty()) {
+        return;
+    }
+    ensureBrushes(target);
+    if (!backgroundBrush_ || !textBrush_) {
+        return;
+    }
+    const float height =
+        kStatsPadding * 2.0f + kStatsLineHeight * static_cast<float>(text.lines.size());
+    target->FillRectangle(D2D1::RectF(0.0f, 0.0f, kStatsWidth, height), backgroundBrush_.Get());
+    float y = kStatsPadding;
+    for (const auto& line : text.lines) {
+        const auto rect =
+            D2D1::RectF(kStatsPadding, y, kStatsWidth - kStatsPadding, y + kStatsLineHeight);
+        target->DrawText(line.c_str(), static_cast<UINT32>(line.size()), format, rect,
+                          textBrush_.Get(), D2D1_DRAW_TEXT_OPTIONS_CLIP);
+        y += kStatsLineHeight;
+    }
+}
+
+void DebugStatsRenderer::discardDeviceResources() {
+    backgroundBrush_.Reset();
+    textBrush_.Reset();
+}
+
+void DebugStatsRenderer::ensureBrushes(ID2D1RenderTarget* target) {
+    if (!backgroundBrush_) {
+        CountUiResourceCreation();
+        target->CreateSolidColorBrush(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.75f), &backgroundBrush_);
+    }
+    if (!textBrush_) {
+        CountUiResourceCreation();
+        target->CreateSolidColorBrush(D2D1::ColorF(1.0f, 1.0f, 0.0f, 1.0f), &textBrush_);
+    }
+}
 #endif
 
 }  // namespace winui
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include <d2d1.h>
+#include <dwrite.h>
 #include <wrl/client.h>
 
 #if defined(SATORI_ENABLE_UI_DEBUG)
@@ -38,6 +40,12 @@ struct DebugOverlayPalette {
     float strokeWidth = 1.0f;
 };
 
+// Diagnostic text (callback timing, per-stage profile) drawn in a panel in
+// the top-left corner while the overlay is on.
+struct DebugStatsText {
+    std::vector<std::wstring> lines;
+};
+
 DebugOverlayPalette MakeUnifiedDebugOverlayPalette();
 
 #if SATORI_UI_DEBUG_ENABLED
@@ -46,21 +54,40 @@ public:
     DebugBoxRenderer();
 
     void setPalette(const DebugOverlayPalette& palette);
-    void render(ID2D1HwndRenderTarget* target,
+    void render(ID2D1RenderTarget* target,
                 const DebugBoxModel& model,
                 bool alignToPixel = false);
 
 private:
-    void ensureBrushes(ID2D1HwndRenderTarget* target);
+    void ensureBrushes(ID2D1RenderTarget* target);
 
     DebugOverlayPalette palette_{};
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> strokeBrush_;
 };
+
+class DebugStatsRenderer {
+public:
+    void render(ID2D1RenderTarget* target, IDWriteTextFormat* format,
+                const DebugStatsText& text);
+    void discardDeviceResources();
+
+private:
+    void ensureBrushes(ID2D1RenderTarget* target);
+
+    Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> backgroundBrush_;
+    Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> textBrush_;
+};
 #else
 class DebugBoxRenderer {
 public:
     void setPalette(const DebugOverlayPalette&) {}
-    void render(ID2D1HwndRenderTarget*, const DebugBoxModel&, bool = false) {}
+    void render(ID2D1RenderTarget*, const DebugBoxModel&, bool = false) {}
+};
+
+class DebugStatsRenderer {
+public:
+    void render(ID2D1RenderTarget*, IDWriteTextFormat*, const DebugStatsText&) {}
+    void discardDeviceResources() {}
 };
 #endif  // SATORI_UI_DEBUG_ENABLED
 
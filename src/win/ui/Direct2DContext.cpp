@@ -4,13 +4,16 @@
 #include <cmath>
 #include <cwchar>
 #include <sstream>
+#include <utility>
 
 #include <d2d1helper.h>
 
+#include "engine/Tracer.h"
 #include "win/ui/D2DHelpers.h"
 #include "win/ui/NunitoFont.h"
 #include "win/ui/RenderResources.h"
 #include "win/ui/UIModel.h"
+#include "win/ui/UiBenchmark.h"
 #include "dsp/RoomIrLibrary.h"
 #include "win/ui/nodes/FlowDiagramNode.h"
 #include "win/ui/nodes/ButtonBarNode.h"
@@ -133,8 +136,9 @@ Direct2DContext::Direct2DContext() {
 }
 Direct2DContext::~Direct2DContext() = default;
 
-bool Direct2DContext::initialize(HWND hwnd) {
+bool Direct2DContext::initialize(HWND hwnd, UINT deviceLostMessage) {
     hwnd_ = hwnd;
+    deviceLostMessage_ = deviceLostMessage;
     RECT rc{};
     GetClientRect(hwnd_, &rc);
     width_ = static_cast<UINT>(rc.right - rc.left);
@@ -143,8 +147,8 @@ bool Direct2DContext::initialize(HWND hwnd) {
 #if defined(_DEBUG)
     options.debugLevel = D2D1_DEBUG_LEVEL_INFORMATION;
 #endif
-    HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED,
-                                   __uuidof(ID2D1Factory), &options,
+    HRESULT hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_MULTI_THREADED,
+                                   __uuidof(ID2D1Factory1), &options,
                                    &d2dFactory_);
     if (FAILED(hr)) {
         return false;
@@ -155,7 +159,17 @@ bool Direct2DContext::initialize(HWND hwnd) {
     if (FAILED(hr)) {
         return false;
     }
+    renderCache_.setFactories(d2dFactory_.Get(), dwriteFactory_.Get());
+    // Fonts and the render target wait for the first frame, so the window
+    // shows as soon as it is created.
+    return true;
+}
 
+bool Direct2DContext::createTextResources() {
+    if (textFormat_) {
+        return true;
+    }
+    const engine::TraceZone zone("UI text resources");
     // 按当前皮肤配置创建文本格式，Nunito 为全局默认字体。
     const wchar_t* primaryFont =
         skinConfig_.primaryFontFamily.empty()
@@ -183,16 +197,17 @@ bool Direct2DContext::initialize(HWND hwnd) {
         return false;
     }
     ApplyChineseFontFallback(dwriteFactory_.Get(), textFormat_.Get());
-    return createDeviceResources();
+    return true;
 }
 
 void Direct2DContext::resize(UINT width, UINT height) {
     width_ = width;
     height_ = height;
-    if (renderTarget_) {
-        renderTarget_->Resize(D2D1::SizeU(width, height));
+    if (presenter_.running()) {
+        presenter_.resize(width, height);
     }
     layoutDirty_ = true;
+    fullRepaint_ = true;
 }
 
 void Direct2DContext::handleDeviceLost() {
@@ -204,6 +219,7 @@ void Direct2DContext::handleDeviceLost() {
 void Direct2DContext::setModel(UIModel model) {
     model_ = std::move(model);
     rebuildLayout();
+    fullRepaint_ = true;
 }
 
 void Direct2DContext::updateWaveformSamples(
@@ -212,6 +228,23 @@ void Direct2DContext::updateWaveformSamples(
     // Room preview uses the selected IR waveform (updated via FlowDiagramState), not output waveform samples.
 }
 
+void Direct2DContext::updateLiveSignal(const std::vector<float>& scope,
+                                       const std::vector<float>& spectrumDb) {
+    // Kept so a layout rebuild starts from the last frame rather than blank.
+    liveScope_ = scope;
+    liveSpectrumDb_ = spectrumDb;
+    if (liveScopeNode_) {
+        liveScopeNode_->setLiveSignal(liveScope_, liveSpectrumDb_);
+    }
+}
+
+void Direct2DContext::updateAudioHealth(const AudioHealth& health) {
+    model_.headerBar.health = health;
+    if (headerBarNode_) {
+        headerBarNode_->setHealth(health);
+    }
+}
+
 void Direct2DContext::updateDiagramState(const FlowDiagramState& state) {
     model_.diagram = state;
     if (excitationPreviewNode_) {
@@ -381,6 +414,10 @@ void Direct2DContext::toggleDebugOverlay() {
 #endif
 }
 
+void Direct2DContext::setDebugStats(DebugStatsText stats) {
+    debugStats_ = std::move(stats);
+}
+
 void Direct2DContext::dumpLayoutDebugInfo() {
     if (!rootLayout_) {
         return;
@@ -449,13 +486,34 @@ bool Direct2DContext::createDeviceResources() {
         D2D1::SizeU(static_cast<UINT>(rc.right - rc.left),
                     static_cast<UINT>(rc.bottom - rc.top));
 
-    HRESULT hr = d2dFactory_->CreateHwndRenderTarget(
-        D2D1::RenderTargetProperties(),
-        D2D1::HwndRenderTargetProperties(hwnd_, size),
-        &renderTarget_);
+    // BGRA for Direct2D; WARP when there is no usable GPU.
+    const UINT flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+    HRESULT hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, flags, nullptr,
+                                   0, D3D11_SDK_VERSION, &d3dDevice_, nullptr, nullptr);
     if (FAILED(hr)) {
+        hr = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, flags, nullptr, 0,
+                               D3D11_SDK_VERSION, &d3dDevice_, nullptr, nullptr);
+    }
+    Microsoft::WRL::ComPtr<IDXGIDevice> dxgiDevice;
+    if (FAILED(hr) || FAILED(d3dDevice_.As(&dxgiDevice)) ||
+        FAILED(d2dFactory_->CreateDevice(dxgiDevice.Get(), &d2dDevice_)) ||
+        FAILED(d2dDevice_->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
+                                               &renderTarget_))) {
+        discardDeviceResources();
         return false;
     }
+    const auto dpi = static_cast<float>(GetDpiForWindow(hwnd_));
+    renderTarget_->SetDpi(dpi, dpi);
+    if (!presenter_.start(hwnd_, d3dDevice_.Get(), d2dDevice_.Get(), size.width, size.height,
+                          dpi, deviceLostMessage_)) {
+        discardDeviceResources();
+        return false;
+    }
+    fullRepaint_ = true;
+    float dpiX = 96.0f;
+    float dpiY = 96.0f;
+    renderTarget_->GetDpi(&dpiX, &dpiY);
+    renderCache_.setDpi(dpiX);  // drops layouts and arcs made at another DPI
 
     const SkinBrushColors colors = MakeBrushColors();
 
@@ -600,61 +658,183 @@ void Direct2DContext::discardDeviceResources() {
     keyboardBorderBrush_.Reset();
     keyboardHoverBrush_.Reset();
     keyboardColors_ = {};
+    presenter_.stop();
     renderTarget_.Reset();
+    d2dDevice_.Reset();
+    d3dDevice_.Reset();
     debugBoxRenderer_.setPalette(debugOverlayPalette_);
+    debugStatsRenderer_.discardDeviceResources();
+    renderCache_.clear();
+}
+
+void Direct2DContext::applyModuleHighlight() {
+    FlowModule highlight = FlowModule::kNone;
+    auto pickHighlight = [&](const std::shared_ptr<KnobPanelNode>& panel) {
+        if (!panel) return false;
+        if (auto module = panel->activeModule()) {
+            highlight = *module;
+            return true;
+        }
+        return false;
+    };
+    (void)(pickHighlight(excitationKnobsNode_) ||
+           pickHighlight(stringKnobsNode_) ||
+           pickHighlight(bodyKnobsNode_) ||
+           pickHighlight(roomKnobsNode_));
+    if (highlight == FlowModule::kNone) {
+        if (excitationPreviewNode_ && excitationPreviewNode_->isInteracting()) {
+            highlight = FlowModule::kExcitation;
+        }
+    }
+
+    model_.diagram.highlightedModule = highlight;
+    if (excitationPreviewNode_) excitationPreviewNode_->setHighlighted(highlight == FlowModule::kExcitation);
+    if (stringPreviewNode_) stringPreviewNode_->setHighlighted(highlight == FlowModule::kString);
+    if (bodyPreviewNode_) bodyPreviewNode_->setHighlighted(highlight == FlowModule::kBody);
+    if (excitationCardNode_) excitationCardNode_->setHighlighted(highlight == FlowModule::kExcitation);
+    if (stringCardNode_) stringCardNode_->setHighlighted(highlight == FlowModule::kString);
+    if (bodyCardNode_) bodyCardNode_->setHighlighted(highlight == FlowModule::kBody);
+    if (roomCardNode_) roomCardNode_->setHighlighted(highlight == FlowModule::kRoom);
+}
+
+std::optional<D2D1_RECT_F> Direct2DContext::activeTooltipRect() const {
+    for (const auto& panel : {excitationKnobsNode_, stringKnobsNode_, bodyKnobsNode_,
+                              roomKnobsNode_}) {
+        if (!panel) {
+            continue;
+        }
+        if (auto knob = panel->activeKnob()) {
+            // The tooltip is centred under the knob and at most twice its
+            // dial wide; this box covers it with margin.
+            const auto& b = knob->bounds();
+            const float w = b.right - b.left;
+            const float h = b.bottom - b.top;
+            return D2D1::RectF(b.left - w * 0.5f, b.top, b.right + w * 0.5f,
+                               b.bottom + std::max(h * 0.5f, 48.0f));
+        }
+    }
+    return std::nullopt;
+}
+
+bool Direct2DContext::anyDropdownOpen() const {
+    if (roomIrSelectorNode_ && roomIrSelectorNode_->isOpen()) {
+        return true;
+    }
+    if (headerBarNode_) {
+        for (const auto& selector : headerBarNode_->selectors()) {
+            if (selector->isOpen()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Direct2DContext::invalidateAll() {
+    fullRepaint_ = true;
+    if (hwnd_) {
+        InvalidateRect(hwnd_, nullptr, FALSE);
+    }
+}
+
+void Direct2DContext::invalidateDirty() {
+    if (!hwnd_) {
+        return;
+    }
+    // Dropdown overlays and the debug overlay draw across other nodes.
+    const bool dropdownOpen = anyDropdownOpen();
+    const bool wholeWindow = fullRepaint_ || layoutDirty_ || dropdownOpen ||
+                             dropdownWasOpen_ ||
+                             debugOverlayMode_ != DebugOverlayMode::kOff;
+    dropdownWasOpen_ = dropdownOpen;
+
+    applyModuleHighlight();
+    DirtyRegion region;
+    if (rootLayout_) {
+        rootLayout_->collectDirty(region);
+    }
+    const auto tooltip = activeTooltipRect();
+    if (lastTooltipRect_) {
+        region.add(*lastTooltipRect_);  // where the previous tooltip was drawn
+    }
+    if (tooltip) {
+        region.add(*tooltip);
+    }
+    lastTooltipRect_ = tooltip;
+
+    if (wholeWindow) {
+        InvalidateRect(hwnd_, nullptr, FALSE);
+        return;
+    }
+    if (region.empty()) {
+        return;
+    }
+    float dpiX = 96.0f;
+    float dpiY = 96.0f;
+    if (renderTarget_) {
+        renderTarget_->GetDpi(&dpiX, &dpiY);
+    }
+    const auto& r = region.rect();
+    RECT pixels{static_cast<LONG>(std::floor(r.left * dpiX / 96.0f)) - 1,
+                static_cast<LONG>(std::floor(r.top * dpiY / 96.0f)) - 1,
+                static_cast<LONG>(std::ceil(r.right * dpiX / 96.0f)) + 1,
+                static_cast<LONG>(std::ceil(r.bottom * dpiY / 96.0f)) + 1};
+    InvalidateRect(hwnd_, &pixels, FALSE);
 }
 
-void Direct2DContext::render() {
-    if (!createDeviceResources()) {
+void Direct2DContext::render(const RECT& updateRect) {
+    if (!createTextResources() || !createDeviceResources()) {
         return;
     }
     ensureLayout();
 
+    // The frame is recorded here and rasterised on the present thread.
+    Microsoft::WRL::ComPtr<ID2D1CommandList> frame;
+    CountUiResourceCreation();
+    if (FAILED(renderTarget_->CreateCommandList(&frame))) {
+        handleDeviceLost();
+        return;
+    }
+    renderTarget_->SetTarget(frame.Get());
     renderTarget_->BeginDraw();
     renderTarget_->SetTransform(D2D1::Matrix3x2F::Identity());
 
+    // The presenter's canvas keeps the previous frame, so a partial update
+    // only redraws (and clips to) the invalidated rect.
+    float dpiX = 96.0f;
+    float dpiY = 96.0f;
+    renderTarget_->GetDpi(&dpiX, &dpiY);
+    const auto clip = D2D1::RectF(static_cast<float>(updateRect.left) * 96.0f / dpiX,
+                                  static_cast<float>(updateRect.top) * 96.0f / dpiY,
+                                  static_cast<float>(updateRect.right) * 96.0f / dpiX,
+                                  static_cast<float>(updateRect.bottom) * 96.0f / dpiY);
+    const bool partial = !fullRepaint_ && (updateRect.left > 0 || updateRect.top > 0 ||
+                                           updateRect.right < static_cast<LONG>(width_) ||
+                                           updateRect.bottom < static_cast<LONG>(height_));
+    fullRepaint_ = false;
+    if (partial) {
+        renderTarget_->PushAxisAlignedClip(clip, D2D1_ANTIALIAS_MODE_ALIASED);
+    }
+
     // Global background (not pure black) to preserve hierarchy against module cards.
     D2D1_COLOR_F clearColor =
         D2D1::ColorF(0.117647f, 0.117647f, 0.117647f);  // #1E1E1E
-    renderTarget_->Clear(clearColor);
+    renderTarget_->Clear(clearColor);  // honours the clip
 
     if (rootLayout_) {
-        FlowModule highlight = FlowModule::kNone;
-        auto pickHighlight = [&](const std::shared_ptr<KnobPanelNode>& panel) {
-            if (!panel) return false;
-            if (auto module = panel->activeModule()) {
-                highlight = *module;
-                return true;
-            }
-            return false;
-        };
-        (void)(pickHighlight(excitationKnobsNode_) ||
-               pickHighlight(stringKnobsNode_) ||
-               pickHighlight(bodyKnobsNode_) ||
-               pickHighlight(roomKnobsNode_));
-        if (highlight == FlowModule::kNone) {
-            if (excitationPreviewNode_ && excitationPreviewNode_->isInteracting()) {
-                highlight = FlowModule::kExcitation;
-            }
-        }
-
-        model_.diagram.highlightedModule = highlight;
-        if (excitationPreviewNode_) excitationPreviewNode_->setHighlighted(highlight == FlowModule::kExcitation);
-        if (stringPreviewNode_) stringPreviewNode_->setHighlighted(highlight == FlowModule::kString);
-        if (bodyPreviewNode_) bodyPreviewNode_->setHighlighted(highlight == FlowModule::kBody);
-        if (excitationCardNode_) excitationCardNode_->setHighlighted(highlight == FlowModule::kExcitation);
-        if (stringCardNode_) stringCardNode_->setHighlighted(highlight == FlowModule::kString);
-        if (bodyCardNode_) bodyCardNode_->setHighlighted(highlight == FlowModule::kBody);
-        if (roomCardNode_) roomCardNode_->setHighlighted(highlight == FlowModule::kRoom);
+        applyModuleHighlight();
 
         auto resources = makeResources();
+        resources.partialPaint = partial;
+        resources.paintRect = clip;
         rootLayout_->draw(resources);
         auto drawActiveTooltip = [&](const std::shared_ptr<KnobPanelNode>& panel) {
             if (!panel) return false;
             if (auto knob = panel->activeKnob()) {
                 knob->drawTooltip(resources.target, resources.trackBrush,
                                   resources.fillBrush, resources.accentBrush,
-                                  resources.textBrush, resources.textFormat);
+                                  resources.textBrush, resources.textFormat,
+                                  resources.cache);
                 return true;
             }
             return false;
@@ -679,14 +859,32 @@ void Direct2DContext::render() {
         drawDebugOverlay();
 #endif
     }
+    if (partial) {
+        renderTarget_->PopAxisAlignedClip();
+    }
+    // Marks left by layout during a full repaint are already on screen.
+    if (!partial && rootLayout_) {
+        DirtyRegion drawn;
+        rootLayout_->collectDirty(drawn);
+    }
 
     HRESULT hr = renderTarget_->EndDraw();
+    renderTarget_->SetTarget(nullptr);
+    if (SUCCEEDED(hr)) {
+        hr = frame->Close();
+    }
     if (hr == D2DERR_RECREATE_TARGET) {
         handleDeviceLost();
+        return;
+    }
+    if (SUCCEEDED(hr)) {
+        lastFrameDrawCalls_ = countDrawCalls_ ? CountDrawCommands(frame.Get()) : -1;
+        presenter_.submit(std::move(frame), clip, !partial);
     }
 }
 
 void Direct2DContext::rebuildLayout() {
+    renderCache_.clearOwnerGeometries();
     headerBarNode_ = std::make_shared<HeaderBarNode>();
     headerBarNode_->setModel(model_.headerBar);
     buttonBarNode_.reset();
@@ -783,6 +981,9 @@ void Direct2DContext::rebuildLayout() {
     keyboardNode_->setColors(keyboardColors_);
     keyboardNode_->setConfig(model_.keyboardConfig, model_.keyCallback);
 
+    liveScopeNode_ = std::make_shared<WaveformNode>();
+    liveScopeNode_->setLiveSignal(liveScope_, liveSpectrumDb_);
+
     // Four module cards aligned to the signal flow.
     excitationCardNode_ = std::make_shared<ModuleCardNode>(
         FlowModule::kExcitation, excitationPreviewNode_, excitationKnobsNode_);
@@ -805,7 +1006,10 @@ void Direct2DContext::rebuildLayout() {
     auto rootStack = std::make_shared<UIStackPanel>(8.0f);
     std::vector<UIStackPanel::Item> items;
     items.push_back({headerBarNode_, {UISizeMode::kFixed, 56.0f, 56.0f}});
-    items.push_back({mainRow, {UISizeMode::kAuto, 0.0f, 480.0f}});
+    // The main row gives up 60 DIPs of its minimum so the live scope still
+    // fits the 720-DIP minimum client height.
+    items.push_back({mainRow, {UISizeMode::kAuto, 0.0f, 420.0f}});
+    items.push_back({liveScopeNode_, {UISizeMode::kFixed, 72.0f, 56.0f}});
     items.push_back({keyboardNode_, {UISizeMode::kFixed, 140.0f, 110.0f}});
     rootStack->setItems(std::move(items));
 
@@ -836,6 +1040,7 @@ void Direct2DContext::drawDebugOverlay() {
         !rootLayout_) {
         return;
     }
+    debugStatsRenderer_.render(renderTarget_.Get(), textFormat_.Get(), debugStats_);
     if (!hoverDebugModel_) {
         return;
     }
@@ -971,6 +1176,7 @@ std::optional<DebugBoxModel> Direct2DContext::pickDebugSelection(float x,
 RenderResources Direct2DContext::makeResources() {
     RenderResources resources;
     resources.target = renderTarget_.Get();
+    resources.cache = &renderCache_;
     resources.accentBrush = accentBrush_.Get();
     resources.excitationBrush = excitationBrush_.Get();
     resources.accentFillBrush = accentFillBrush_.Get();
@@ -9,12 +9,15 @@
 #include <utility>
 #include <vector>
 
-#include <d2d1.h>
+#include <d2d1_1.h>
+#include <d3d11.h>
 #include <dwrite.h>
 #include <dwrite_3.h>
 #include <wrl/client.h>
 
 #include "win/ui/DebugOverlay.h"
+#include "win/ui/FramePresenter.h"
+#include "win/ui/RenderCache.h"
 #include "win/ui/RenderResources.h"
 #include "win/ui/UIModel.h"
 #include "win/ui/layout/UILayoutNode.h"
@@ -43,14 +46,27 @@ public:
     Direct2DContext();
     ~Direct2DContext();
 
-    bool initialize(HWND hwnd);
+    // A lost device is reported to `hwnd` as `deviceLostMessage`; the
+    // window then calls handleDeviceLost().
+    bool initialize(HWND hwnd, UINT deviceLostMessage = 0);
     void resize(UINT width, UINT height);
-    void render();
+    // Records the frame for `updateRect` (client pixels, from WM_PAINT) and
+    // hands it to the present thread; everything else keeps the previous
+    // frame. Returns once recorded, without waiting for the GPU or vblank.
+    void render(const RECT& updateRect);
+    // Invalidates the part of the window that changed since the last call:
+    // the union of dirty nodes, tooltips and highlight changes, or all of it
+    // after layout, resize, device loss or while an overlay is open.
+    void invalidateDirty();
+    void invalidateAll();
     void handleDeviceLost();
 
     void setModel(UIModel model);
     void updateWaveformSamples(const std::vector<float>& samples);
     void updateDiagramState(const FlowDiagramState& state);
+    void updateAudioHealth(const AudioHealth& health);
+    // Live output scope and spectrum (see WaveformNode::setLiveSignal).
+    void updateLiveSignal(const std::vector<float>& scope, const std::vector<float>& spectrumDb);
     void syncSliders();
     bool onPointerDown(float x, float y);
     bool onPointerMove(float x, float y);
@@ -63,15 +79,26 @@ public:
 
     void setDebugOverlayMode(DebugOverlayMode mode);
     void toggleDebugOverlay();
+    bool debugOverlayVisible() const { return debugOverlayMode_ != DebugOverlayMode::kOff; }
+    // Shown in the overlay's stats panel; the caller refreshes it.
+    void setDebugStats(DebugStatsText stats);
     void dumpLayoutDebugInfo();
+    // Benchmark runs: counts the draw commands of each recorded frame
+    // (CountDrawCommands); lastFrameDrawCalls() is -1 while this is off.
+    void setCountDrawCalls(bool enabled) { countDrawCalls_ = enabled; }
+    int lastFrameDrawCalls() const { return lastFrameDrawCalls_; }
 
 private:
+    bool createTextResources();
     bool createDeviceResources();
     void discardDeviceResources();
     void rebuildLayout();
     void ensureLayout();
     RenderResources makeResources();
     void drawDebugOverlay();
+    void applyModuleHighlight();
+    std::optional<D2D1_RECT_F> activeTooltipRect() const;
+    bool anyDropdownOpen() const;
     void applyDebugOverlayState();
     bool updateDebugSelection(float x, float y);
     bool clearDebugSelection();
@@ -80,8 +107,16 @@ private:
     HWND hwnd_ = nullptr;
     UINT width_ = 0;
     UINT height_ = 0;
-    Microsoft::WRL::ComPtr<ID2D1Factory> d2dFactory_;
-    Microsoft::WRL::ComPtr<ID2D1HwndRenderTarget> renderTarget_;
+    UINT deviceLostMessage_ = 0;
+    bool countDrawCalls_ = false;
+    int lastFrameDrawCalls_ = -1;
+    // Multithreaded: the presenter draws on the same device.
+    Microsoft::WRL::ComPtr<ID2D1Factory1> d2dFactory_;
+    Microsoft::WRL::ComPtr<ID3D11Device> d3dDevice_;
+    Microsoft::WRL::ComPtr<ID2D1Device> d2dDevice_;
+    // Records frames into command lists; brushes are made on it.
+    Microsoft::WRL::ComPtr<ID2D1DeviceContext> renderTarget_;
+    FramePresenter presenter_;
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> accentBrush_;
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> excitationBrush_;
     Microsoft::WRL::ComPtr<ID2D1SolidColorBrush> textBrush_;
@@ -110,9 +145,15 @@ private:
 
     UIModel model_;
     bool layoutDirty_ = true;
+    bool fullRepaint_ = true;
+    bool dropdownWasOpen_ = false;
+    std::optional<D2D1_RECT_F> lastTooltipRect_;
     DebugOverlayMode debugOverlayMode_ = DebugOverlayMode::kOff;
     DebugOverlayPalette debugOverlayPalette_{};
     DebugBoxRenderer debugBoxRenderer_;
+    DebugStatsRenderer debugStatsRenderer_;
+    DebugStatsText debugStats_;
+    RenderCache renderCache_;
 #if SATORI_UI_DEBUG_ENABLED
     std::optional<DebugBoxModel> hoverDebugModel_;
     bool pointerCaptured_ = false;
@@ -145,6 +186,9 @@ private:
     std::shared_ptr<KnobPanelNode> bodyKnobsNode_;
     std::shared_ptr<KnobPanelNode> roomKnobsNode_;
     std::shared_ptr<KeyboardNode> keyboardNode_;
+    std::shared_ptr<WaveformNode> liveScopeNode_;
+    std::vector<float> liveScope_;
+    std::vector<float> liveSpectrumDb_;
     KeyboardColors keyboardColors_{};
 };
 
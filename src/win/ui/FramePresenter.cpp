@@ -0,0 +1,270 @@
+#include "win/ui/FramePresenter.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <d2d1_1helper.h>
+
+#include "engine/Tracer.h"
+
+namespace winui {
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+
+// Opaque: ClearType needs it, and DWM has nothing to blend.
+constexpr D2D1_PIXEL_FORMAT kPixelFormat{DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE};
+// Long enough for a slow GPU, short enough to notice stop() promptly.
+constexpr DWORD kFrameWaitMs = 100;
+
+// Holds the D2D factory lock around direct D3D/DXGI calls.
+class ScopedMultithread {
+public:
+    explicit ScopedMultithread(ID2D1Multithread* lock) : lock_(lock) { lock_->Enter(); }
+    ~ScopedMultithread() { lock_->Leave(); }
+    ScopedMultithread(const ScopedMultithread&) = delete;
+    ScopedMultithread& operator=(const ScopedMultithread&) = delete;
+
+private:
+    ID2D1Multithread* lock_;
+};
+
+}  // namespace
+
+FramePresenter::~FramePresenter() {
+    stop();
+}
+
+bool FramePresenter::start(HWND window, ID3D11Device* d3dDevice, ID2D1Device* device,
+                           UINT width, UINT height, float dpi, UINT deviceLostMessage) {
+    if (thread_.joinable() || !window || !d3dDevice || !device) {
+        return false;
+    }
+    window_ = window;
+    deviceLostMessage_ = deviceLostMessage;
+    dpi_ = dpi > 0.0f ? dpi : 96.0f;
+    width_ = std::max<UINT>(1, width);
+    height_ = std::max<UINT>(1, height);
+
+    ComPtr<ID2D1Factory> factory;
+    device->GetFactory(&factory);
+    ComPtr<IDXGIDevice> dxgiDevice;
+    ComPtr<IDXGIAdapter> adapter;
+    ComPtr<IDXGIFactory2> dxgiFactory;
+    if (!factory || FAILED(factory.As(&multithread_)) || !multithread_->GetMultithreadProtected() ||
+        FAILED(d3dDevice->QueryInterface(IID_PPV_ARGS(&dxgiDevice))) ||
+        FAILED(dxgiDevice->GetAdapter(&adapter)) ||
+        FAILED(adapter->GetParent(IID_PPV_ARGS(&dxgiFactory)))) {
+        release();
+        return false;
+    }
+
+    DXGI_SWAP_CHAIN_DESC1 desc{};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    desc.BufferCount = 2;
+    desc.Scaling = DXGI_SCALING_STRETCH;
+    desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+    desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+    desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    ComPtr<IDXGISwapChain1> swapChain;
+    if (FAILED(dxgiFactory->CreateSwapChainForComposition(d3dDevice, &desc, nullptr,
+                                                          &swapChain)) ||
+        FAILED(swapChain.As(&swapChain_))) {
+        release();
+        return false;
+    }
+    // One queued frame: the render thread waits for the compositor instead
+    // of Present blocking while it holds the factory lock.
+    swapChain_->SetMaximumFrameLatency(1);
+    frameLatencyWaitable_ = swapChain_->GetFrameLatencyWaitableObject();
+
+    if (FAILED(DCompositionCreateDevice(dxgiDevice.Get(), IID_PPV_ARGS(&composition_))) ||
+        FAILED(composition_->CreateTargetForHwnd(window_, TRUE, &compositionTarget_)) ||
+        FAILED(composition_->CreateVisual(&visual_)) ||
+        FAILED(visual_->SetContent(swapChain_.Get())) ||
+        FAILED(compositionTarget_->SetRoot(visual_.Get())) || FAILED(composition_->Commit())) {
+        release();
+        return false;
+    }
+
+    if (FAILED(device->CreateDeviceContext(D2D1_DEVICE_CONTEXT_OPTIONS_NONE, &context_))) {
+        release();
+        return false;
+    }
+    context_->SetDpi(dpi_, dpi_);
+    if (!resizeTargets()) {
+        release();
+        return false;
+    }
+
+    stop_ = false;
+    lost_ = false;
+    thread_ = std::thread([this]() { run(); });
+    return true;
+}
+
+void FramePresenter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    release();
+}
+
+void FramePresenter::release() {
+    pending_.clear();
+    resizePending_ = false;
+    canvas_.Reset();
+    context_.Reset();
+    visual_.Reset();
+    compositionTarget_.Reset();
+    composition_.Reset();
+    if (frameLatencyWaitable_) {
+        CloseHandle(frameLatencyWaitable_);
+        frameLatencyWaitable_ = nullptr;
+    }
+    swapChain_.Reset();
+    multithread_.Reset();
+}
+
+void FramePresenter::resize(UINT width, UINT height) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        resizePending_ = true;
+        pendingWidth_ = std::max<UINT>(1, width);
+        pendingHeight_ = std::max<UINT>(1, height);
+    }
+    cv_.notify_one();
+}
+
+void FramePresenter::submit(ComPtr<ID2D1CommandList> frame, const D2D1_RECT_F& dirty,
+                            bool full) {
+    if (!frame) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lost_ || !thread_.joinable()) {
+            return;
+        }
+        if (full) {
+            pending_.clear();  // covered by this one
+        }
+        pending_.push_back({std::move(frame), dirty, full});
+    }
+    cv_.notify_one();
+}
+
+void FramePresenter::run() {
+    engine::SetTraceThreadName("UI present");
+    std::vector<Frame> frames;
+    bool presented = true;  // the waitable starts signalled
+    for (;;) {
+        // Wait for the compositor to take the last present first, so the
+        // newest frames are drawn.
+        if (presented && frameLatencyWaitable_) {
+            WaitForSingleObjectEx(frameLatencyWaitable_, kFrameWaitMs, TRUE);
+        }
+        presented = false;
+        bool resize = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_ || !pending_.empty() || resizePending_; });
+            if (stop_) {
+                return;
+            }
+            frames.swap(pending_);
+            if (resizePending_) {
+                resize = true;
+                resizePending_ = false;
+                width_ = pendingWidth_;
+                height_ = pendingHeight_;
+            }
+        }
+        bool ok = !resize || resizeTargets();
+        if (ok && !frames.empty()) {
+            const engine::TraceZone zone("UI present");
+            ok = presentFrames(frames);
+            presented = ok;
+        }
+        frames.clear();
+        if (!ok) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                lost_ = true;
+                pending_.clear();
+            }
+            if (deviceLostMessage_) {
+                PostMessageW(window_, deviceLostMessage_, 0, 0);
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_; });
+            return;
+        }
+    }
+}
+
+bool FramePresenter::resizeTargets() {
+    canvas_.Reset();
+    context_->SetTarget(nullptr);
+    {
+        const ScopedMultithread lock(multithread_.Get());
+        DXGI_SWAP_CHAIN_DESC1 desc{};
+        swapChain_->GetDesc1(&desc);
+        if ((desc.Width != width_ || desc.Height != height_) &&
+            FAILED(swapChain_->ResizeBuffers(0, width_, height_, DXGI_FORMAT_UNKNOWN,
+                                             desc.Flags))) {
+            return false;
+        }
+    }
+    // Window contents between frames; a partial frame redraws part of it.
+    return SUCCEEDED(context_->CreateBitmap(
+        D2D1::SizeU(width_, height_), nullptr, 0,
+        D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_TARGET, kPixelFormat, dpi_, dpi_),
+        &canvas_));
+}
+
+bool FramePresenter::presentFrames(const std::vector<Frame>& frames) {
+    context_->SetTarget(canvas_.Get());
+    context_->BeginDraw();
+    context_->SetTransform(D2D1::Matrix3x2F::Identity());
+    for (const Frame& frame : frames) {
+        if (!frame.full) {
+            context_->PushAxisAlignedClip(frame.dirty, D2D1_ANTIALIAS_MODE_ALIASED);
+        }
+        context_->DrawImage(frame.list.Get());
+        if (!frame.full) {
+            context_->PopAxisAlignedClip();
+        }
+    }
+    if (FAILED(context_->EndDraw())) {
+        return false;
+    }
+    context_->SetTarget(nullptr);
+
+    const ScopedMultithread lock(multithread_.Get());
+    ComPtr<IDXGISurface> surface;
+    ComPtr<ID2D1Bitmap1> backBuffer;
+    if (FAILED(swapChain_->GetBuffer(0, IID_PPV_ARGS(&surface))) ||
+        FAILED(context_->CreateBitmapFromDxgiSurface(
+            surface.Get(),
+            D2D1::BitmapProperties1(D2D1_BITMAP_OPTIONS_TARGET | D2D1_BITMAP_OPTIONS_CANNOT_DRAW,
+                                    kPixelFormat, dpi_, dpi_),
+            &backBuffer)) ||
+        FAILED(backBuffer->CopyFromBitmap(nullptr, canvas_.Get(), nullptr))) {
+        return false;
+    }
+    // DXGI_STATUS_OCCLUDED (minimised) is a success code.
+    return SUCCEEDED(swapChain_->Present(1, 0));
+}
+
+}  // namespace winui
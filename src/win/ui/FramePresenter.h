@@ -0,0 +1,87 @@
+#pragma once
+
+#include <windows.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <d2d1_1.h>
+#include <d3d11.h>
+#include <dcomp.h>
+#include <dxgi1_3.h>
+#include <wrl/client.h>
+
+namespace winui {
+
+// Puts recorded frames on screen from a thread of its own. The message
+// thread draws each frame into an ID2D1CommandList and submits it; this
+// thread plays it into a retained canvas (partial frames only cover their
+// dirty rect), copies the canvas to a flip-model swap chain shown through
+// DirectComposition and waits for vblank in Present. Input handling never
+// waits on rasterisation, the GPU or the present.
+class FramePresenter {
+public:
+    FramePresenter() = default;
+    ~FramePresenter();
+    FramePresenter(const FramePresenter&) = delete;
+    FramePresenter& operator=(const FramePresenter&) = delete;
+
+    // `device` comes from a multithreaded factory over `d3dDevice`. A lost
+    // device is reported to `window` as `deviceLostMessage` (if non-zero),
+    // after which frames are dropped until stop() and a new start().
+    bool start(HWND window, ID3D11Device* d3dDevice, ID2D1Device* device, UINT width,
+               UINT height, float dpi, UINT deviceLostMessage);
+    void stop();
+    bool running() const { return thread_.joinable(); }
+
+    // Takes effect before the next frame, which should then be full.
+    void resize(UINT width, UINT height);
+    // `dirty` (DIPs) is the part of the window `frame` draws. Frames that
+    // arrive while one is presented are all drawn before the next present,
+    // so the screen skips to the newest without losing a partial update.
+    void submit(Microsoft::WRL::ComPtr<ID2D1CommandList> frame, const D2D1_RECT_F& dirty,
+                bool full);
+
+private:
+    struct Frame {
+        Microsoft::WRL::ComPtr<ID2D1CommandList> list;
+        D2D1_RECT_F dirty{};
+        bool full = false;
+    };
+
+    void run();
+    void release();
+    bool resizeTargets();
+    bool presentFrames(const std::vector<Frame>& frames);
+
+    HWND window_ = nullptr;
+    UINT deviceLostMessage_ = 0;
+    float dpi_ = 96.0f;
+    // Render thread only, once started.
+    Microsoft::WRL::ComPtr<ID2D1DeviceContext> context_;
+    // D3D and DXGI calls take the factory lock the message thread's D2D
+    // calls take.
+    Microsoft::WRL::ComPtr<ID2D1Multithread> multithread_;
+    Microsoft::WRL::ComPtr<IDXGISwapChain2> swapChain_;
+    HANDLE frameLatencyWaitable_ = nullptr;
+    Microsoft::WRL::ComPtr<ID2D1Bitmap1> canvas_;
+    Microsoft::WRL::ComPtr<IDCompositionDevice> composition_;
+    Microsoft::WRL::ComPtr<IDCompositionTarget> compositionTarget_;
+    Microsoft::WRL::ComPtr<IDCompositionVisual> visual_;
+    UINT width_ = 0;
+    UINT height_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+    bool stop_ = false;
+    bool lost_ = false;
+    std::vector<Frame> pending_;
+    bool resizePending_ = false;
+    UINT pendingWidth_ = 0;
+    UINT pendingHeight_ = 0;
+};
+
+}  // namespace winui
@@ -2,11 +2,14 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cwchar>
 
 #include <d2d1helper.h>
 #include <wrl/client.h>
 
+#include "win/ui/UiBenchmark.h"
+
 namespace winui {
 
 // 文本测量工具：在没有外部工厂的情况下，本地懒加载一个 DWriteFactory
@@ -21,26 +24,48 @@ Microsoft::WRL::ComPtr<IDWriteFactory> GetLocalDWriteFactory() {
     return s_factory;
 }
 
-static bool MeasureText(IDWriteTextFormat* format,
-                        const wchar_t* text,
-                        UINT32 length,
-                        float maxWidth,
-                        float* outWidth,
-                        float* outHeight) {
-    auto f = GetLocalDWriteFactory();
-    if (!f || !format || !text || !outWidth || !outHeight) return false;
-    Microsoft::WRL::ComPtr<IDWriteTextLayout> layout;
-    HRESULT hr = f->CreateTextLayout(text, length, format,
-                                     maxWidth, 10000.0f, &layout);
-    if (FAILED(hr) || !layout) return false;
-    // Mirror draw behavior
+// Mirror draw behavior
+static void ConfigureMeasureLayout(IDWriteFactory* f, IDWriteTextFormat* format,
+                                   IDWriteTextLayout* layout) {
     layout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP);
     DWRITE_TRIMMING trimming{};
     trimming.granularity = DWRITE_TRIMMING_GRANULARITY_CHARACTER;
     Microsoft::WRL::ComPtr<IDWriteInlineObject> ellipsis;
+    CountUiResourceCreation();
     if (SUCCEEDED(f->CreateEllipsisTrimmingSign(format, &ellipsis))) {
         layout->SetTrimming(&trimming, ellipsis.Get());
     }
+}
+
+// With a cache the layout (and DirectWrite's shaping of it) is reused
+// across frames; without one it is built and dropped per call.
+static bool MeasureText(RenderCache* cache,
+                        IDWriteTextFormat* format,
+                        const wchar_t* text,
+                        UINT32 length,
+                        float maxWidth,
+                        float* outWidth,
+                        float* outHeight) {
+    if (!format || !text || !outWidth || !outHeight) return false;
+    Microsoft::WRL::ComPtr<IDWriteTextLayout> layout;
+    HRESULT hr = S_OK;
+    if (cache && cache->dwriteFactory()) {
+        bool created = false;
+        layout = cache->textLayout(std::wstring(text, length), format, maxWidth, 10000.0f,
+                                   &created);
+        if (!layout) return false;
+        if (created) {
+            ConfigureMeasureLayout(cache->dwriteFactory(), format, layout.Get());
+        }
+    } else {
+        auto f = GetLocalDWriteFactory();
+        if (!f) return false;
+        CountUiResourceCreation();
+        hr = f->CreateTextLayout(text, length, format,
+                                 maxWidth, 10000.0f, &layout);
+        if (FAILED(hr) || !layout) return false;
+        ConfigureMeasureLayout(f.Get(), format, layout.Get());
+    }
     DWRITE_TEXT_METRICS m{};
     hr = layout->GetMetrics(&m);
     if (FAILED(hr)) return false;
@@ -99,6 +124,7 @@ void ParameterKnob::setBounds(const D2D1_RECT_F& bounds) {
 }
 
 bool ParameterKnob::computeLayout(IDWriteTextFormat* textFormat,
+                                  RenderCache* cache,
                                   Layout* outLayout,
                                   float* outLineHeight) const {
     if (!outLayout) {
@@ -179,7 +205,7 @@ bool ParameterKnob::computeLayout(IDWriteTextFormat* textFormat,
     float lineHeight = textFormat ? textFormat->GetFontSize() : 18.0f;
     float lhW = 0.0f;
     float lhH = lineHeight;
-    if (MeasureText(textFormat, L"Hg", 2, 10000.0f, &lhW, &lhH)) {
+    if (MeasureText(cache, textFormat, L"Hg", 2, 10000.0f, &lhW, &lhH)) {
         if (lhH > 0.0f) {
             lineHeight = lhH;
         }
@@ -201,7 +227,7 @@ bool ParameterKnob::computeLayout(IDWriteTextFormat* textFormat,
 
     float measuredLabelW = 0.0f;
     float measuredLabelH = lineHeight;
-    if (MeasureText(textFormat, label_.c_str(),
+    if (MeasureText(cache, textFormat, label_.c_str(),
                     static_cast<UINT32>(label_.size()), 10000.0f,
                     &measuredLabelW, &measuredLabelH) &&
         measuredLabelW > 0.0f) {
@@ -224,48 +250,98 @@ bool ParameterKnob::computeLayout(IDWriteTextFormat* textFormat,
     return true;
 }
 
-void ParameterKnob::draw(ID2D1HwndRenderTarget* target,
+void ParameterKnob::draw(ID2D1RenderTarget* target,
                          ID2D1SolidColorBrush* baseBrush,
                          ID2D1SolidColorBrush* fillBrush,
                          ID2D1SolidColorBrush* accentBrush,
                          ID2D1SolidColorBrush* textBrush,
-                         IDWriteTextFormat* textFormat) const {
-    drawBody(target, baseBrush, fillBrush, accentBrush, textBrush, textFormat);
+                         IDWriteTextFormat* textFormat,
+                         RenderCache* cache) const {
+    drawBody(target, baseBrush, fillBrush, accentBrush, textBrush, textFormat,
+             cache);
     drawTooltip(target, baseBrush, fillBrush, accentBrush, textBrush,
-                textFormat);
+                textFormat, cache);
 }
 
-void ParameterKnob::drawBody(ID2D1HwndRenderTarget* target,
-                             ID2D1SolidColorBrush* baseBrush,
-                             ID2D1SolidColorBrush* fillBrush,
-                             ID2D1SolidColorBrush* accentBrush,
-                             ID2D1SolidColorBrush* textBrush,
-                             IDWriteTextFormat* textFormat) const {
-    if (!target || !baseBrush || !fillBrush || !accentBrush || !textBrush ||
-        !textFormat) {
+namespace {
+constexpr float kKnobPi = 3.1415926f;
+constexpr float kKnobStartAngle = -kKnobPi * 1.25f;  // -225°
+constexpr float kKnobSweep = kKnobPi * 1.5f;         // 270°
+
+// Clockwise value-slot arc from a0 to a1 around `center`.
+void DrawSlotArc(ID2D1RenderTarget* target, RenderCache* cache, D2D1_POINT_2F center,
+                 float slotRadius, float slotThickness, float a0, float a1,
+                 ID2D1SolidColorBrush* brush) {
+    if (!brush) return;
+    const float arcAngle = std::fabs(a1 - a0);
+    if (arcAngle < 1e-3f) return;
+    if (cache) {
+        // Cached arcs are centred on the origin and shared by every knob
+        // with the same radius and sweep bucket.
+        if (auto* arcGeometry = cache->arcGeometry(slotRadius, a0, arcAngle)) {
+            D2D1_MATRIX_3X2_F transform{};
+            target->GetTransform(&transform);
+            target->SetTransform(D2D1::Matrix3x2F::Translation(center.x, center.y) *
+                                 transform);
+            target->DrawGeometry(arcGeometry, brush, slotThickness);
+            target->SetTransform(transform);
+        }
         return;
     }
-
-    debugRectsValid_ = false;
-
-    constexpr float kPi = 3.1415926f;
-
-    Layout layout{};
-    if (!computeLayout(textFormat, &layout, nullptr)) {
-        return;
+    ComPtr<ID2D1Factory> d2dFactory;
+    target->GetFactory(&d2dFactory);
+    if (!d2dFactory) return;
+    const D2D1_POINT_2F startPoint = D2D1::Point2F(center.x + std::cos(a0) * slotRadius,
+                                                   center.y + std::sin(a0) * slotRadius);
+    const D2D1_POINT_2F endPoint = D2D1::Point2F(center.x + std::cos(a1) * slotRadius,
+                                                 center.y + std::sin(a1) * slotRadius);
+    ComPtr<ID2D1PathGeometry> geometry;
+    CountUiResourceCreation();
+    if (SUCCEEDED(d2dFactory->CreatePathGeometry(&geometry)) && geometry) {
+        ComPtr<ID2D1GeometrySink> sink;
+        if (SUCCEEDED(geometry->Open(&sink)) && sink) {
+            sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
+            sink->BeginFigure(startPoint, D2D1_FIGURE_BEGIN_HOLLOW);
+            D2D1_ARC_SEGMENT arc{};
+            arc.point = endPoint;
+            arc.size = D2D1::SizeF(slotRadius, slotRadius);
+            arc.rotationAngle = 0.0f;
+            arc.sweepDirection = D2D1_SWEEP_DIRECTION_CLOCKWISE;
+            arc.arcSize = (arcAngle >= kKnobPi) ? D2D1_ARC_SIZE_LARGE : D2D1_ARC_SIZE_SMALL;
+            sink->AddArc(arc);
+            sink->EndFigure(D2D1_FIGURE_END_OPEN);
+            (void)sink->Close();
+            target->DrawGeometry(geometry.Get(), brush, slotThickness);
+        }
     }
+}
+}  // namespace
 
-    auto dwriteFactory = GetLocalDWriteFactory();
+void ParameterKnob::drawFace(ID2D1RenderTarget* target,
+                             const Layout& layout,
+                             ID2D1SolidColorBrush* ringBrush,
+                             ID2D1SolidColorBrush* discBrush,
+                             ID2D1SolidColorBrush* textBrush,
+                             IDWriteTextFormat* textFormat,
+                             RenderCache* cache,
+                             bool active) const {
+    const float labelBoxW = layout.labelTextRect.right - layout.labelTextRect.left;
+    const float labelBoxH = layout.labelTextRect.bottom - layout.labelTextRect.top;
     bool labelDrawn = false;
-    if (dwriteFactory) {
-        ComPtr<IDWriteTextLayout> labelLayout;
-        if (SUCCEEDED(dwriteFactory->CreateTextLayout(
-                label_.c_str(), static_cast<UINT32>(label_.size()),
-                textFormat,
-                layout.labelTextRect.right - layout.labelTextRect.left,
-                layout.labelTextRect.bottom - layout.labelTextRect.top,
-                &labelLayout)) &&
-            labelLayout) {
+    ComPtr<IDWriteTextLayout> labelLayout;
+    bool configureLabel = true;
+    if (cache) {
+        // A cached layout keeps the settings below; only new ones need them.
+        labelLayout = cache->textLayout(label_, textFormat, labelBoxW, labelBoxH,
+                                        &configureLabel);
+    } else if (auto dwriteFactory = GetLocalDWriteFactory()) {
+        CountUiResourceCreation();
+        (void)dwriteFactory->CreateTextLayout(
+            label_.c_str(), static_cast<UINT32>(label_.size()), textFormat,
+            labelBoxW, labelBoxH, &labelLayout);
+    }
+    if (labelLayout) {
+        if (configureLabel) {
             labelLayout->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER);
             labelLayout->SetParagraphAlignment(
                 DWRITE_PARAGRAPH_ALIGNMENT_CENTER);
@@ -286,24 +362,18 @@ void ParameterKnob::drawBody(ID2D1HwndRenderTarget* target,
                     (void)labelLayout->SetFontSize(newSize, range);
                 }
             }
-            target->DrawTextLayout(
-                D2D1::Point2F(layout.labelTextRect.left,
-                              layout.labelTextRect.top),
-                labelLayout.Get(), textBrush);
-            labelDrawn = true;
         }
+        target->DrawTextLayout(
+            D2D1::Point2F(layout.labelTextRect.left,
+                          layout.labelTextRect.top),
+            labelLayout.Get(), textBrush);
+        labelDrawn = true;
     }
     if (!labelDrawn) {
         target->DrawText(label_.c_str(), static_cast<UINT32>(label_.size()),
                          textFormat, layout.labelTextRect, textBrush);
     }
 
-    const bool active = hovered_ || dragging_;
-
-    ID2D1SolidColorBrush* ringBrush = baseBrush ? baseBrush : fillBrush;
-    ID2D1SolidColorBrush* slotBrush = accentBrush ? accentBrush : textBrush;
-    ID2D1SolidColorBrush* discBrush = fillBrush ? fillBrush : baseBrush;
-
     // Subtle inner disc for depth.
     const D2D1_ELLIPSE ellipse{layout.center, layout.radius, layout.radius};
     if (discBrush) {
@@ -313,68 +383,127 @@ void ParameterKnob::drawBody(ID2D1HwndRenderTarget* target,
         discBrush->SetOpacity(original);
     }
 
+    // Background ring (full sweep, dim).
+    if (ringBrush) {
+        const float original = ringBrush->GetOpacity();
+        ringBrush->SetOpacity(active ? 0.95f : 0.70f);
+        DrawSlotArc(target, cache, layout.center, slotRadius(layout), layout.slotThicknessBase,
+                    kKnobStartAngle, kKnobStartAngle + kKnobSweep, ringBrush);
+        ringBrush->SetOpacity(original);
+    }
+}
+
+float ParameterKnob::slotRadius(const Layout& layout) {
+    // 值槽中心线半径
+    return layout.radius + layout.slotGap + layout.slotThicknessBase * 0.5f;
+}
+
+bool ParameterKnob::drawCachedFace(ID2D1RenderTarget* target,
+                                   const Layout& layout,
+                                   ID2D1SolidColorBrush* ringBrush,
+                                   ID2D1SolidColorBrush* discBrush,
+                                   ID2D1SolidColorBrush* textBrush,
+                                   IDWriteTextFormat* textFormat,
+                                   RenderCache* cache,
+                                   bool active) const {
+    SpriteAtlas& sprites = cache->sprites();
+    // The ring's outer edge plus a pixel of antialiasing, and the label box.
+    const float extent = slotRadius(layout) + layout.slotThicknessBase * 0.5f + 1.0f;
+    const float left = std::min(layout.center.x - extent, layout.labelOuterRect.left);
+    const float top = layout.center.y - extent;
+    const float right = std::max(layout.center.x + extent, layout.labelOuterRect.right);
+    const float bottom = std::max(layout.center.y + extent, layout.labelOuterRect.bottom);
+    // On the pixel grid, so the face keeps its sub-pixel position inside.
+    const D2D1_POINT_2F origin = D2D1::Point2F(sprites.snap(left), sprites.snap(top));
+
+    Layout local = layout;
+    local.center.x -= origin.x;
+    local.center.y -= origin.y;
+    for (D2D1_RECT_F* rect : {&local.labelOuterRect, &local.labelTextRect}) {
+        rect->left -= origin.x;
+        rect->right -= origin.x;
+        rect->top -= origin.y;
+        rect->bottom -= origin.y;
+    }
+
+    GeometryStamp stamp;
+    stamp.add(static_cast<std::uint64_t>(std::hash<std::wstring>{}(label_)))
+        .add(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(textFormat)))
+        .add(textFormat->GetFontSize())
+        .add(local.center.x)
+        .add(local.center.y)
+        .add(local.radius)
+        .add(local.slotGap)
+        .add(local.slotThicknessBase)
+        .add(local.labelTextRect)
+        .add(ringBrush)
+        .add(discBrush)
+        .add(textBrush)
+        .add(static_cast<std::uint64_t>(active));
+    const auto* sprite = sprites.sprite(
+        target, stamp.value(), D2D1::SizeF(right - origin.x, bottom - origin.y),
+        [&](ID2D1RenderTarget* rt) {
+            drawFace(rt, local, ringBrush, discBrush, textBrush, textFormat, cache, active);
+        });
+    if (!sprite) {
+        return false;
+    }
+    sprites.blit(target, *sprite, origin);
+    return true;
+}
+
+void ParameterKnob::drawBody(ID2D1RenderTarget* target,
+                             ID2D1SolidColorBrush* baseBrush,
+                             ID2D1SolidColorBrush* fillBrush,
+                             ID2D1SolidColorBrush* accentBrush,
+                             ID2D1SolidColorBrush* textBrush,
+                             IDWriteTextFormat* textFormat,
+                             RenderCache* cache) const {
+    if (!target || !baseBrush || !fillBrush || !accentBrush || !textBrush ||
+        !textFormat) {
+        return;
+    }
+
+    debugRectsValid_ = false;
+
+    Layout layout{};
+    if (!computeLayout(textFormat, cache, &layout, nullptr)) {
+        return;
+    }
+
+    const bool active = hovered_ || dragging_;
+
+    ID2D1SolidColorBrush* ringBrush = baseBrush ? baseBrush : fillBrush;
+    ID2D1SolidColorBrush* slotBrush = accentBrush ? accentBrush : textBrush;
+    ID2D1SolidColorBrush* discBrush = fillBrush ? fillBrush : baseBrush;
+
+    // Label, disc and background ring only change with the layout, skin or
+    // hover state: with a cache they are one pre-rendered sprite.
+    if (!cache || !drawCachedFace(target, layout, ringBrush, discBrush, textBrush, textFormat,
+                                  cache, active)) {
+        drawFace(target, layout, ringBrush, discBrush, textBrush, textFormat, cache, active);
+    }
+
     // 归一化数值并限制到 [0, 1]，避免非法范围。
     const float range = max_ - min_;
     const float norm =
         range != 0.0f ? (value_ - min_) / range : 0.0f;
     const float clampedNorm = Clamp(norm, 0.0f, 1.0f);
 
-    const float startAngle = -kPi * 1.25f;    // -225°
-    const float sweep = kPi * 1.5f;           // 270°
-    const float slotRadius = layout.radius + layout.slotGap +
-                             layout.slotThicknessBase *
-                                 0.5f;  // 值槽中心线半径
-
+    const float radius = slotRadius(layout);
     const float slotThickness = layout.slotThicknessBase;
 
-    ComPtr<ID2D1Factory> d2dFactory;
-    target->GetFactory(&d2dFactory);
-    auto drawArc = [&](float a0, float a1, ID2D1SolidColorBrush* brush) {
-        if (!d2dFactory || !brush) return;
-        const float arcAngle = std::fabs(a1 - a0);
-        if (arcAngle < 1e-3f) return;
-        const D2D1_POINT_2F startPoint = D2D1::Point2F(
-            layout.center.x + std::cos(a0) * slotRadius,
-            layout.center.y + std::sin(a0) * slotRadius);
-        const D2D1_POINT_2F endPoint = D2D1::Point2F(
-            layout.center.x + std::cos(a1) * slotRadius,
-            layout.center.y + std::sin(a1) * slotRadius);
-        ComPtr<ID2D1PathGeometry> geometry;
-        if (SUCCEEDED(d2dFactory->CreatePathGeometry(&geometry)) && geometry) {
-            ComPtr<ID2D1GeometrySink> sink;
-            if (SUCCEEDED(geometry->Open(&sink)) && sink) {
-                sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
-                sink->BeginFigure(startPoint, D2D1_FIGURE_BEGIN_HOLLOW);
-                D2D1_ARC_SEGMENT arc{};
-                arc.point = endPoint;
-                arc.size = D2D1::SizeF(slotRadius, slotRadius);
-                arc.rotationAngle = 0.0f;
-                arc.sweepDirection = D2D1_SWEEP_DIRECTION_CLOCKWISE;
-                arc.arcSize =
-                    (arcAngle >= kPi) ? D2D1_ARC_SIZE_LARGE : D2D1_ARC_SIZE_SMALL;
-                sink->AddArc(arc);
-                sink->EndFigure(D2D1_FIGURE_END_OPEN);
-                (void)sink->Close();
-                target->DrawGeometry(geometry.Get(), brush, slotThickness);
-            }
-        }
-    };
-
-    // Background ring (full sweep, dim).
-    if (ringBrush) {
-        const float original = ringBrush->GetOpacity();
-        ringBrush->SetOpacity(active ? 0.95f : 0.70f);
-        drawArc(startAngle, startAngle + sweep, ringBrush);
-        ringBrush->SetOpacity(original);
-    }
-
     // Foreground progress arc + endpoint dot.
     if (slotBrush && clampedNorm > 0.001f) {
-        const float endAngle = startAngle + sweep * clampedNorm;
-        drawArc(startAngle, endAngle, slotBrush);
+        // Snapped like the cached arc so the dot sits on its end.
+        const float endAngle =
+            kKnobStartAngle + (cache ? RenderCache::SnapArcSweep(kKnobSweep * clampedNorm)
+                                     : kKnobSweep * clampedNorm);
+        DrawSlotArc(target, cache, layout.center, radius, slotThickness, kKnobStartAngle,
+                    endAngle, slotBrush);
         const D2D1_POINT_2F endPoint = D2D1::Point2F(
-            layout.center.x + std::cos(endAngle) * slotRadius,
-            layout.center.y + std::sin(endAngle) * slotRadius);
+            layout.center.x + std::cos(endAngle) * radius,
+            layout.center.y + std::sin(endAngle) * radius);
         // 端点圆的直径需要与弧线截面（strokeWidth）一致，否则默认状态会显得“缩一圈”。
         const float dotR = slotThickness * 0.50f;
         target->FillEllipse(D2D1::Ellipse(endPoint, dotR, dotR), slotBrush);
@@ -390,12 +519,13 @@ void ParameterKnob::drawBody(ID2D1HwndRenderTarget* target,
 #endif
 }
 
-void ParameterKnob::drawTooltip(ID2D1HwndRenderTarget* target,
+void ParameterKnob::drawTooltip(ID2D1RenderTarget* target,
                                 ID2D1SolidColorBrush* baseBrush,
                                 ID2D1SolidColorBrush* fillBrush,
                                 ID2D1SolidColorBrush* accentBrush,
                                 ID2D1SolidColorBrush* textBrush,
-                                IDWriteTextFormat* textFormat) const {
+                                IDWriteTextFormat* textFormat,
+                                RenderCache* cache) const {
     (void)fillBrush;
     if (!dragging_ || !target || !baseBrush || !textBrush || !textFormat) {
         return;
@@ -403,7 +533,7 @@ void ParameterKnob::drawTooltip(ID2D1HwndRenderTarget* target,
 
     Layout layout{};
     float lineHeight = 0.0f;
-    if (!computeLayout(textFormat, &layout, &lineHeight)) {
+    if (!computeLayout(textFormat, cache, &layout, &lineHeight)) {
         return;
     }
 
@@ -419,31 +549,31 @@ void ParameterKnob::drawTooltip(ID2D1HwndRenderTarget* target,
 
     float lhW = 0.0f;
     float lhH = lineHeight;
-    (void)MeasureText(textFormat, L"Hg", 2, 10000.0f, &lhW, &lhH);
+    (void)MeasureText(cache, textFormat, L"Hg", 2, 10000.0f, &lhW, &lhH);
 
     float labelW = layout.labelTextWidth > 0.0f ? layout.labelTextWidth : lhH;
     float labelH = lhH;
-    (void)MeasureText(textFormat, label_.c_str(),
+    (void)MeasureText(cache, textFormat, label_.c_str(),
                       static_cast<UINT32>(label_.size()), 10000.0f, &labelW,
                       &labelH);
     (void)labelH;
 
     float valueW = 0.0f;
     float valueH = lhH;
-    (void)MeasureText(textFormat, valueBuffer,
+    (void)MeasureText(cache, textFormat, valueBuffer,
                       static_cast<UINT32>(wcslen(valueBuffer)), 10000.0f,
                       &valueW, &valueH);
     (void)valueH;
 
     float w100 = 0.0f;
     float hTmp = lhH;
-    (void)MeasureText(textFormat, L"100%", 4, 10000.0f, &w100, &hTmp);
+    (void)MeasureText(cache, textFormat, L"100%", 4, 10000.0f, &w100, &hTmp);
     float w88 = 0.0f;
     hTmp = lhH;
-    (void)MeasureText(textFormat, L"88%", 3, 10000.0f, &w88, &hTmp);
+    (void)MeasureText(cache, textFormat, L"88%", 3, 10000.0f, &w88, &hTmp);
     float w0 = 0.0f;
     hTmp = lhH;
-    (void)MeasureText(textFormat, L"0%", 2, 10000.0f, &w0, &hTmp);
+    (void)MeasureText(cache, textFormat, L"0%", 2, 10000.0f, &w0, &hTmp);
     const float valueWMax = std::max(w100, std::max(w88, w0));
 
     const float knobWidth = layout.outerRadius * 2.0f;
@@ -479,6 +609,7 @@ void ParameterKnob::drawTooltip(ID2D1HwndRenderTarget* target,
         shadowRect.top += 2.0f;
         shadowRect.bottom += 2.0f;
         ComPtr<ID2D1SolidColorBrush> shadowBrush;
+        CountUiResourceCreation();
         if (SUCCEEDED(target->CreateSolidColorBrush(
                 D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.35f), &shadowBrush))) {
             const auto shadowBubble =
@@ -8,6 +8,7 @@
 #include <dwrite.h>
 
 #include "win/ui/DebugOverlay.h"
+#include "win/ui/RenderCache.h"
 
 namespace winui {
 
@@ -22,25 +23,29 @@ public:
                   Callback onChange);
 
     void setBounds(const D2D1_RECT_F& bounds);
+    const D2D1_RECT_F& bounds() const { return bounds_; }
 
-    void draw(ID2D1HwndRenderTarget* target,
+    void draw(ID2D1RenderTarget* target,
               ID2D1SolidColorBrush* baseBrush,
               ID2D1SolidColorBrush* fillBrush,
               ID2D1SolidColorBrush* accentBrush,
               ID2D1SolidColorBrush* textBrush,
-              IDWriteTextFormat* textFormat) const;
-    void drawBody(ID2D1HwndRenderTarget* target,
+              IDWriteTextFormat* textFormat,
+              RenderCache* cache = nullptr) const;
+    void drawBody(ID2D1RenderTarget* target,
                   ID2D1SolidColorBrush* baseBrush,
                   ID2D1SolidColorBrush* fillBrush,
                   ID2D1SolidColorBrush* accentBrush,
                   ID2D1SolidColorBrush* textBrush,
-                  IDWriteTextFormat* textFormat) const;
-    void drawTooltip(ID2D1HwndRenderTarget* target,
+                  IDWriteTextFormat* textFormat,
+                  RenderCache* cache = nullptr) const;
+    void drawTooltip(ID2D1RenderTarget* target,
                      ID2D1SolidColorBrush* baseBrush,
                      ID2D1SolidColorBrush* fillBrush,
                      ID2D1SolidColorBrush* accentBrush,
                      ID2D1SolidColorBrush* textBrush,
-                     IDWriteTextFormat* textFormat) const;
+                     IDWriteTextFormat* textFormat,
+                     RenderCache* cache = nullptr) const;
 
     bool onPointerDown(float x, float y);
     bool onPointerMove(float x, float y);
@@ -59,8 +64,28 @@ private:
                           const D2D1_RECT_F& content) const;
     struct Layout;
     bool computeLayout(IDWriteTextFormat* textFormat,
+                       RenderCache* cache,
                        Layout* outLayout,
                        float* outLineHeight) const;
+    static float slotRadius(const Layout& layout);
+    // Label, disc and background ring: everything but the value arc.
+    void drawFace(ID2D1RenderTarget* target,
+                  const Layout& layout,
+                  ID2D1SolidColorBrush* ringBrush,
+                  ID2D1SolidColorBrush* discBrush,
+                  ID2D1SolidColorBrush* textBrush,
+                  IDWriteTextFormat* textFormat,
+                  RenderCache* cache,
+                  bool active) const;
+    // The face as a cache sprite; false if none could be made.
+    bool drawCachedFace(ID2D1RenderTarget* target,
+                        const Layout& layout,
+                        ID2D1SolidColorBrush* ringBrush,
+                        ID2D1SolidColorBrush* discBrush,
+                        ID2D1SolidColorBrush* textBrush,
+                        IDWriteTextFormat* textFormat,
+                        RenderCache* cache,
+                        bool active) const;
 
     std::wstring label_;
     float min_ = 0.0f;
@@ -37,7 +37,7 @@ void ParameterSlider::setBounds(const D2D1_RECT_F& bounds) {
                              bounds.bottom - 10.0f);
 }
 
-void ParameterSlider::draw(ID2D1HwndRenderTarget* target,
+void ParameterSlider::draw(ID2D1RenderTarget* target,
                            ID2D1SolidColorBrush* trackBrush,
                            ID2D1SolidColorBrush* fillBrush,
                            ID2D1SolidColorBrush* knobBrush,
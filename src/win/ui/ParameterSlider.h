@@ -20,7 +20,7 @@ public:
                     Callback onChange);
 
     void setBounds(const D2D1_RECT_F& bounds);
-    void draw(ID2D1HwndRenderTarget* target,
+    void draw(ID2D1RenderTarget* target,
               ID2D1SolidColorBrush* trackBrush,
               ID2D1SolidColorBrush* fillBrush,
               ID2D1SolidColorBrush* knobBrush,
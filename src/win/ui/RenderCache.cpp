@@ -0,0 +1,170 @@
+#include "win/ui/RenderCache.h"
+
+#include <cmath>
+#include <functional>
+
+#include <d2d1helper.h>
+
+#include "win/ui/UiBenchmark.h"
+
+namespace winui {
+
+namespace {
+constexpr float kTwoPi = 6.2831853f;
+
+int AngleBucket(float angle) {
+    return static_cast<int>(
+        std::lround(angle / kTwoPi * static_cast<float>(RenderCache::kArcBucketsPerTurn)));
+}
+
+float BucketAngle(int bucket) {
+    return static_cast<float>(bucket) * kTwoPi /
+           static_cast<float>(RenderCache::kArcBucketsPerTurn);
+}
+}  // namespace
+
+std::size_t RenderCache::TextKeyHash::operator()(const TextKey& key) const {
+    GeometryStamp stamp;
+    stamp.add(static_cast<std::uint64_t>(std::hash<std::wstring>{}(key.text)))
+        .add(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key.format)))
+        .add(key.maxWidth)
+        .add(key.maxHeight);
+    return static_cast<std::size_t>(stamp.value());
+}
+
+std::size_t RenderCache::OwnerKeyHash::operator()(const OwnerKey& key) const {
+    GeometryStamp stamp;
+    stamp.add(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(key.owner)))
+        .add(static_cast<std::uint64_t>(key.slot));
+    return static_cast<std::size_t>(stamp.value());
+}
+
+void RenderCache::setFactories(ID2D1Factory* d2dFactory, IDWriteFactory* dwriteFactory) {
+    if (d2dFactory != d2dFactory_ || dwriteFactory != dwriteFactory_) {
+        clear();
+    }
+    d2dFactory_ = d2dFactory;
+    dwriteFactory_ = dwriteFactory;
+}
+
+void RenderCache::setDpi(float dpi) {
+    if (dpi != dpi_) {
+        clear();
+        dpi_ = dpi;
+        sprites_.setDpi(dpi);
+    }
+}
+
+void RenderCache::clear() {
+    textLayouts_.clear();
+    arcs_.clear();
+    ownerGeometries_.clear();
+    sprites_.clear();
+}
+
+void RenderCache::clearOwnerGeometries() {
+    ownerGeometries_.clear();
+}
+
+IDWriteTextLayout* RenderCache::textLayout(const std::wstring& text,
+                                           IDWriteTextFormat* format,
+                                           float maxWidth,
+                                           float maxHeight,
+                                           bool* created) {
+    if (created) {
+        *created = false;
+    }
+    if (!dwriteFactory_ || !format) {
+        return nullptr;
+    }
+    TextKey key{text, format, maxWidth, maxHeight};
+    auto it = textLayouts_.find(key);
+    if (it != textLayouts_.end()) {
+        return it->second.Get();
+    }
+    if (textLayouts_.size() >= kMaxTextLayouts) {
+        textLayouts_.clear();
+    }
+    Microsoft::WRL::ComPtr<IDWriteTextLayout> layout;
+    CountUiResourceCreation();
+    if (FAILED(dwriteFactory_->CreateTextLayout(text.c_str(), static_cast<UINT32>(text.size()),
+                                                format, maxWidth, maxHeight, &layout)) ||
+        !layout) {
+        return nullptr;
+    }
+    if (created) {
+        *created = true;
+    }
+    IDWriteTextLayout* raw = layout.Get();
+    textLayouts_.emplace(std::move(key), std::move(layout));
+    return raw;
+}
+
+float RenderCache::SnapArcSweep(float sweep) {
+    return BucketAngle(AngleBucket(sweep));
+}
+
+ID2D1PathGeometry* RenderCache::arcGeometry(float radius, float startAngle, float sweep) {
+    const int sweepBucket = AngleBucket(sweep);
+    const long radiusEighths = std::lround(radius * 8.0f);
+    if (sweepBucket <= 0 || sweepBucket >= kArcBucketsPerTurn || radiusEighths <= 0) {
+        return nullptr;
+    }
+    const int startBucket = AngleBucket(startAngle);
+    const std::uint64_t key = (static_cast<std::uint64_t>(radiusEighths) << 32) |
+                              (static_cast<std::uint64_t>(startBucket & 0xffff) << 16) |
+                              static_cast<std::uint64_t>(sweepBucket & 0xffff);
+    auto it = arcs_.find(key);
+    if (it != arcs_.end()) {
+        return it->second.Get();
+    }
+    if (arcs_.size() >= kMaxArcs) {
+        arcs_.clear();
+    }
+
+    const float r = static_cast<float>(radiusEighths) / 8.0f;
+    const float a0 = BucketAngle(startBucket);
+    const float a1 = a0 + BucketAngle(sweepBucket);
+    Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry;
+    Microsoft::WRL::ComPtr<ID2D1GeometrySink> sink;
+    if (!openGeometry(&geometry, &sink)) {
+        return nullptr;
+    }
+    sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
+    sink->BeginFigure(D2D1::Point2F(std::cos(a0) * r, std::sin(a0) * r),
+                      D2D1_FIGURE_BEGIN_HOLLOW);
+    D2D1_ARC_SEGMENT arc{};
+    arc.point = D2D1::Point2F(std::cos(a1) * r, std::sin(a1) * r);
+    arc.size = D2D1::SizeF(r, r);
+    arc.rotationAngle = 0.0f;
+    arc.sweepDirection = D2D1_SWEEP_DIRECTION_CLOCKWISE;
+    arc.arcSize = sweepBucket * 2 >= kArcBucketsPerTurn ? D2D1_ARC_SIZE_LARGE
+                                                        : D2D1_ARC_SIZE_SMALL;
+    sink->AddArc(arc);
+    sink->EndFigure(D2D1_FIGURE_END_OPEN);
+    if (FAILED(sink->Close())) {
+        return nullptr;
+    }
+    ID2D1PathGeometry* raw = geometry.Get();
+    arcs_.emplace(key, std::move(geometry));
+    return raw;
+}
+
+bool RenderCache::openGeometry(Microsoft::WRL::ComPtr<ID2D1PathGeometry>* geometry,
+                               Microsoft::WRL::ComPtr<ID2D1GeometrySink>* sink) const {
+    if (!d2dFactory_) {
+        return false;
+    }
+    CountUiResourceCreation();
+    if (FAILED(d2dFactory_->CreatePathGeometry(geometry->ReleaseAndGetAddressOf())) ||
+        !*geometry) {
+        return false;
+    }
+    if (FAILED((*geometry)->Open(sink->ReleaseAndGetAddressOf())) || !*sink) {
+        geometry->Reset();
+        return false;
+    }
+    return true;
+}
+
+}  // namespace winui
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <d2d1.h>
+#include <dwrite.h>
+#include <wrl/client.h>
+
+#include "win/ui/SpriteAtlas.h"
+
+namespace winui {
+
+// Accumulates a 64-bit stamp from the inputs a geometry is built from.
+class GeometryStamp {
+public:
+    GeometryStamp& add(std::uint64_t value) {
+        hash_ ^= value + 0x9e3779b97f4a7c15ull + (hash_ << 6) + (hash_ >> 2);
+        return *this;
+    }
+    GeometryStamp& add(float value) {
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return add(static_cast<std::uint64_t>(bits));
+    }
+    GeometryStamp& add(const D2D1_RECT_F& rect) {
+        return add(rect.left).add(rect.top).add(rect.right).add(rect.bottom);
+    }
+    GeometryStamp& add(const D2D1_COLOR_F& color) {
+        return add(color.r).add(color.g).add(color.b).add(color.a);
+    }
+    // Colour and opacity; a null brush counts as absent.
+    GeometryStamp& add(ID2D1SolidColorBrush* brush) {
+        if (!brush) {
+            return add(std::uint64_t{0});
+        }
+        return add(brush->GetColor()).add(brush->GetOpacity());
+    }
+    GeometryStamp& add(const std::vector<float>& values) {
+        add(static_cast<std::uint64_t>(values.size()));
+        for (const float v : values) {
+            add(v);
+        }
+        return *this;
+    }
+    std::uint64_t value() const { return hash_; }
+
+private:
+    std::uint64_t hash_ = 0xcbf29ce484222325ull;
+};
+
+// Retained text layouts, path geometries and sprites shared by the whole UI
+// tree, so steady frames draw without creating COM objects. Owned by
+// Direct2DContext and cleared on device loss or a DPI change; everything
+// else (a new label, a knob moving to an arc bucket not seen yet) creates an
+// entry once.
+class RenderCache {
+public:
+    // Knob arcs snap their sweep to this many steps per full turn (0.25°).
+    static constexpr int kArcBucketsPerTurn = 1440;
+
+    void setFactories(ID2D1Factory* d2dFactory, IDWriteFactory* dwriteFactory);
+    // Clears the cache when `dpi` differs from the one entries were made at.
+    void setDpi(float dpi);
+    void clear();
+    // Drops per-owner geometries (owners may be gone after a layout rebuild).
+    void clearOwnerGeometries();
+
+    IDWriteFactory* dwriteFactory() const { return dwriteFactory_; }
+    SpriteAtlas& sprites() { return sprites_; }
+
+    // Layout of `text` in `format` inside a maxWidth x maxHeight box. When
+    // `created` is given it reports a new layout, so the caller applies its
+    // one-time settings (alignment, trimming, fitted font size).
+    IDWriteTextLayout* textLayout(const std::wstring& text,
+                                  IDWriteTextFormat* format,
+                                  float maxWidth,
+                                  float maxHeight,
+                                  bool* created = nullptr);
+
+    // Nearest representable arc sweep (radians).
+    static float SnapArcSweep(float sweep);
+    // Open clockwise arc around the origin, from `startAngle` over the
+    // snapped `sweep`; draw it under a translation to the arc's centre.
+    ID2D1PathGeometry* arcGeometry(float radius, float startAngle, float sweep);
+
+    // Geometry kept for (owner, slot) and rebuilt by `build(sink)` only when
+    // `stamp` differs from the one it was built with.
+    template <typename Build>
+    ID2D1PathGeometry* geometry(const void* owner, int slot, std::uint64_t stamp,
+                                Build&& build) {
+        OwnedGeometry& entry = ownerGeometries_[OwnerKey{owner, slot}];
+        if (entry.geometry && entry.stamp == stamp) {
+            return entry.geometry.Get();
+        }
+        entry.geometry.Reset();
+        Microsoft::WRL::ComPtr<ID2D1GeometrySink> sink;
+        if (!openGeometry(&entry.geometry, &sink)) {
+            return nullptr;
+        }
+        build(sink.Get());
+        if (FAILED(sink->Close())) {
+            entry.geometry.Reset();
+            return nullptr;
+        }
+        entry.stamp = stamp;
+        return entry.geometry.Get();
+    }
+
+private:
+    // Caps that bound memory if something keys on unbounded input; the
+    // cache simply starts over when one is reached.
+    static constexpr std::size_t kMaxTextLayouts = 1024;
+    static constexpr std::size_t kMaxArcs = 2048;
+
+    struct TextKey {
+        std::wstring text;
+        IDWriteTextFormat* format = nullptr;
+        float maxWidth = 0.0f;
+        float maxHeight = 0.0f;
+        bool operator==(const TextKey& other) const {
+            return format == other.format && maxWidth == other.maxWidth &&
+                   maxHeight == other.maxHeight && text == other.text;
+        }
+    };
+    struct TextKeyHash {
+        std::size_t operator()(const TextKey& key) const;
+    };
+    struct OwnerKey {
+        const void* owner = nullptr;
+        int slot = 0;
+        bool operator==(const OwnerKey& other) const {
+            return owner == other.owner && slot == other.slot;
+        }
+    };
+    struct OwnerKeyHash {
+        std::size_t operator()(const OwnerKey& key) const;
+    };
+    struct OwnedGeometry {
+        std::uint64_t stamp = 0;
+        Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry;
+    };
+
+    bool openGeometry(Microsoft::WRL::ComPtr<ID2D1PathGeometry>* geometry,
+                      Microsoft::WRL::ComPtr<ID2D1GeometrySink>* sink) const;
+
+    ID2D1Factory* d2dFactory_ = nullptr;
+    IDWriteFactory* dwriteFactory_ = nullptr;
+    float dpi_ = 0.0f;
+    std::unordered_map<TextKey, Microsoft::WRL::ComPtr<IDWriteTextLayout>, TextKeyHash>
+        textLayouts_;
+    // Key packs the radius (1/8 DIP), start-angle and sweep buckets.
+    std::unordered_map<std::uint64_t, Microsoft::WRL::ComPtr<ID2D1PathGeometry>> arcs_;
+    std::unordered_map<OwnerKey, OwnedGeometry, OwnerKeyHash> ownerGeometries_;
+    SpriteAtlas sprites_;
+};
+
+}  // namespace winui
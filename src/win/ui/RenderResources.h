@@ -3,13 +3,15 @@
 #include <d2d1.h>
 #include <dwrite.h>
 
+#include "win/ui/RenderCache.h"
 #include "win/ui/UISkin.h"
+#include "win/ui/layout/DirtyRegion.h"
 
 namespace winui {
 
 // 在一次绘制遍历中需要用到的渲染资源与皮肤信息。
 struct RenderResources {
-    ID2D1HwndRenderTarget* target = nullptr;
+    ID2D1RenderTarget* target = nullptr;
     ID2D1SolidColorBrush* accentBrush = nullptr;
     ID2D1SolidColorBrush* excitationBrush = nullptr;
     ID2D1LinearGradientBrush* accentFillBrush = nullptr;  // Optional (module visualizers)
@@ -21,6 +23,16 @@ struct RenderResources {
     ID2D1SolidColorBrush* shadowBrush = nullptr; // Subtle drop shadows for cards
     ID2D1SolidColorBrush* gridBrush = nullptr;
     IDWriteTextFormat* textFormat = nullptr;
+    // Retained text layouts and geometries; null draws without caching.
+    RenderCache* cache = nullptr;
+
+    // Set when only part of the window is repainted; containers skip
+    // children outside paintRect (drawing there would be clipped anyway).
+    bool partialPaint = false;
+    D2D1_RECT_F paintRect{};
+    bool needsPaint(const D2D1_RECT_F& rect) const {
+        return !partialPaint || RectsIntersect(rect, paintRect);
+    }
 
     // 当前使用的 UI 皮肤（只读视图，由 Direct2DContext 填充）。
     UISkinId skinId = UISkinId::kDefault;
@@ -0,0 +1,126 @@
+#include "win/ui/SpriteAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <d2d1helper.h>
+
+#include "win/ui/UiBenchmark.h"
+
+namespace winui {
+
+void SpriteAtlas::setDpi(float dpi) {
+    if (dpi > 0.0f && dpi != dpi_) {
+        clear();
+        dpi_ = dpi;
+    }
+}
+
+void SpriteAtlas::clear() {
+    sprites_.clear();
+    pages_.clear();
+}
+
+float SpriteAtlas::snap(float dip) const {
+    const float scale = dpi_ / 96.0f;
+    return std::round(dip * scale) / scale;
+}
+
+void SpriteAtlas::blit(ID2D1RenderTarget* target, const Sprite& sprite, D2D1_POINT_2F origin,
+                       float opacity) const {
+    if (!target || !sprite.bitmap) {
+        return;
+    }
+    const float left = snap(origin.x);
+    const float top = snap(origin.y);
+    const auto dest = D2D1::RectF(left, top, left + (sprite.source.right - sprite.source.left),
+                                  top + (sprite.source.bottom - sprite.source.top));
+    // One bitmap pixel per device pixel, so nothing is resampled.
+    target->DrawBitmap(sprite.bitmap, dest, opacity,
+                       D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR, sprite.source);
+}
+
+bool SpriteAtlas::allocate(ID2D1RenderTarget* target, D2D1_SIZE_F size, std::size_t* page,
+                           D2D1_RECT_F* slot) {
+    const float scale = dpi_ / 96.0f;
+    if (!target || size.width <= 0.0f || size.height <= 0.0f) {
+        return false;
+    }
+    // A transparent pixel between neighbours keeps edges from bleeding.
+    const auto width = static_cast<UINT32>(std::ceil(size.width * scale)) + 1;
+    const auto height = static_cast<UINT32>(std::ceil(size.height * scale)) + 1;
+    if (width > kPagePixels || height > kPagePixels) {
+        return false;
+    }
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        if (!pages_.empty()) {
+            Page& last = pages_.back();
+            if (last.cursorX + width > kPagePixels) {
+                last.shelfTop += last.shelfHeight;
+                last.shelfHeight = 0;
+                last.cursorX = 0;
+            }
+            if (last.shelfTop + height <= kPagePixels) {
+                *page = pages_.size() - 1;
+                *slot = D2D1::RectF(static_cast<float>(last.cursorX) / scale,
+                                    static_cast<float>(last.shelfTop) / scale,
+                                    static_cast<float>(last.cursorX + width - 1) / scale,
+                                    static_cast<float>(last.shelfTop + height - 1) / scale);
+                last.cursorX += width;
+                last.shelfHeight = std::max(last.shelfHeight, height);
+                return true;
+            }
+        }
+        if (pages_.size() >= kMaxPages) {
+            clear();
+        }
+        if (!addPage(target)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool SpriteAtlas::addPage(ID2D1RenderTarget* target) {
+    const float scale = dpi_ / 96.0f;
+    const float dips = static_cast<float>(kPagePixels) / scale;
+    Page page;
+    CountUiResourceCreation();
+    if (FAILED(target->CreateCompatibleRenderTarget(
+            D2D1::SizeF(dips, dips), D2D1::SizeU(kPagePixels, kPagePixels),
+            D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
+            D2D1_COMPATIBLE_RENDER_TARGET_OPTIONS_NONE, &page.target)) ||
+        !page.target || FAILED(page.target->GetBitmap(&page.bitmap)) || !page.bitmap) {
+        return false;
+    }
+    // ClearType needs an opaque background to blend against.
+    page.target->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE);
+    pages_.push_back(std::move(page));
+    return true;
+}
+
+void SpriteAtlas::beginPaint(std::size_t page, const D2D1_RECT_F& slot) {
+    ID2D1BitmapRenderTarget* target = pages_[page].target.Get();
+    target->BeginDraw();
+    target->SetTransform(D2D1::Matrix3x2F::Translation(slot.left, slot.top));
+    target->PushAxisAlignedClip(
+        D2D1::RectF(0.0f, 0.0f, slot.right - slot.left, slot.bottom - slot.top),
+        D2D1_ANTIALIAS_MODE_ALIASED);
+    target->Clear(D2D1::ColorF(0.0f, 0.0f, 0.0f, 0.0f));
+}
+
+const SpriteAtlas::Sprite* SpriteAtlas::endPaint(std::size_t page, const D2D1_RECT_F& slot,
+                                                 std::uint64_t key) {
+    ID2D1BitmapRenderTarget* target = pages_[page].target.Get();
+    target->PopAxisAlignedClip();
+    target->SetTransform(D2D1::Matrix3x2F::Identity());
+    if (FAILED(target->EndDraw())) {
+        return nullptr;
+    }
+    Sprite& sprite = sprites_[key];
+    sprite.bitmap = pages_[page].bitmap.Get();
+    sprite.source = slot;
+    return &sprite;
+}
+
+}  // namespace winui
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <d2d1.h>
+#include <wrl/client.h>
+
+namespace winui {
+
+// Pictures drawn once with ordinary D2D calls into a few bitmap pages at the
+// window's DPI, then blitted with DrawBitmap every frame: knob faces and
+// keyboard key states. Keys are GeometryStamp values over everything the
+// picture depends on (size, state, brush colours, label), so a skin change
+// just makes new entries. Owned by RenderCache and dropped with it on device
+// loss or a DPI change.
+class SpriteAtlas {
+public:
+    static constexpr UINT32 kPagePixels = 1024;
+    // Starts over past this many pages (4 MB each).
+    static constexpr std::size_t kMaxPages = 6;
+
+    struct Sprite {
+        ID2D1Bitmap* bitmap = nullptr;
+        D2D1_RECT_F source{};  // DIPs within the page
+    };
+
+    void setDpi(float dpi);
+    void clear();
+    float dpi() const { return dpi_; }
+
+    // Snaps a DIP coordinate to the device pixel grid. Sprites are placed
+    // on it, so their contents land on the same pixels as a direct draw.
+    float snap(float dip) const;
+
+    // Sprite `key` of `size` DIPs, painted by `paint(rt)` on first use with
+    // the sprite's top-left at the origin of `rt`; brushes made on `target`
+    // work there. Valid until the next call. Null if it could not be
+    // created, and the caller then draws directly.
+    template <typename Paint>
+    const Sprite* sprite(ID2D1RenderTarget* target, std::uint64_t key, D2D1_SIZE_F size,
+                         Paint&& paint) {
+        if (const auto it = sprites_.find(key); it != sprites_.end()) {
+            return &it->second;
+        }
+        std::size_t page = 0;
+        D2D1_RECT_F slot{};
+        if (!allocate(target, size, &page, &slot)) {
+            return nullptr;
+        }
+        beginPaint(page, slot);
+        paint(static_cast<ID2D1RenderTarget*>(pages_[page].target.Get()));
+        return endPaint(page, slot, key);
+    }
+
+    // Draws `sprite` with its top-left at the snapped `origin`.
+    void blit(ID2D1RenderTarget* target, const Sprite& sprite, D2D1_POINT_2F origin,
+              float opacity = 1.0f) const;
+
+private:
+    struct Page {
+        Microsoft::WRL::ComPtr<ID2D1BitmapRenderTarget> target;
+        Microsoft::WRL::ComPtr<ID2D1Bitmap> bitmap;
+        // Shelf packing, in pixels.
+        UINT32 shelfTop = 0;
+        UINT32 shelfHeight = 0;
+        UINT32 cursorX = 0;
+    };
+
+    bool allocate(ID2D1RenderTarget* target, D2D1_SIZE_F size, std::size_t* page,
+                  D2D1_RECT_F* slot);
+    bool addPage(ID2D1RenderTarget* target);
+    void beginPaint(std::size_t page, const D2D1_RECT_F& slot);
+    const Sprite* endPaint(std::size_t page, const D2D1_RECT_F& slot, std::uint64_t key);
+
+    float dpi_ = 96.0f;
+    std::vector<Page> pages_;
+    std::unordered_map<std::uint64_t, Sprite> sprites_;
+};
+
+}  // namespace winui
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
 
+#include "dsp/RoomIrLibrary.h"
+
 namespace winui {
 
 enum class UIMode { Play, Internal };
@@ -50,7 +54,7 @@ struct FlowDiagramState {
     float bodySize = 0.0f;
     float roomAmount = 0.0f;
     int roomIrIndex = 0;
-    std::vector<float> roomIrPreviewSamples;
+    dsp::RoomIrLibrary::Preview roomIrPreview{};  // views static IR data
     int noiseType = 0;  // 0 = White, 1 = Binary（或项目内部约定）
     std::vector<float> excitationSamples;  // 激励瞬态/包络预览（用于 Excitation Scope）
     FlowModule highlightedModule = FlowModule::kNone;
@@ -81,9 +85,23 @@ struct DropdownModel {
     std::function<void(int)> onChanged;
 };
 
+// Audio health for the header bar, from the engine's metrics snapshot.
+struct AudioHealth {
+    bool online = false;
+    float dspLoad = 0.0f;  // callback time / buffer period
+    std::uint64_t xruns = 0;
+    std::size_t activeVoices = 0;
+    std::size_t voiceLimit = 0;
+    float reverbLatencyMs = 0.0f;
+    float outputLatencyMs = 0.0f;  // note in to device out, end to end
+
+    bool operator==(const AudioHealth&) const = default;
+};
+
 struct HeaderBarModel {
     std::wstring logoText = L"Satori";
     std::wstring mixSampleRateText;
+    AudioHealth health;
     DropdownModel device;
     DropdownModel sampleRate;
     DropdownModel bufferFrames;
@@ -26,7 +26,8 @@ struct UISkinConfig {
 // 避免在各个控件中分散管理文件路径和纹理坐标。
 struct UISkinResources {
     UISkinConfig config;
-    // TODO: 后续可在此添加 ID2D1Bitmap* 等图形资源句柄。
+    // 预渲染的位图（旋钮表盘、琴键状态）在 RenderCache::sprites() 中，
+    // 按画刷颜色区分，换皮肤或 DPI 时自动重建。
 };
 
 }  // namespace winui
@@ -0,0 +1,276 @@
+#include "win/ui/UiBenchmark.h"
+
+#include <d2d1helper.h>
+#include <shellapi.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cwchar>
+#include <fstream>
+
+namespace winui {
+
+namespace {
+
+std::atomic<std::uint64_t> g_resourceCreations{0};
+
+// Streams a command list and counts what reaches the screen. Lives on the
+// stack for one Stream() call, so reference counting is a no-op.
+class DrawCommandCounter final : public ID2D1CommandSink {
+public:
+    int count() const { return count_; }
+
+    STDMETHODIMP QueryInterface(REFIID riid, void** object) override {
+        if (!object) {
+            return E_POINTER;
+        }
+        if (riid == __uuidof(ID2D1CommandSink) || riid == __uuidof(IUnknown)) {
+            *object = static_cast<ID2D1CommandSink*>(this);
+            return S_OK;
+        }
+        *object = nullptr;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override { return 1; }
+    STDMETHODIMP_(ULONG) Release() override { return 1; }
+
+    STDMETHODIMP BeginDraw() override { return S_OK; }
+    STDMETHODIMP EndDraw() override { return S_OK; }
+    STDMETHODIMP SetAntialiasMode(D2D1_ANTIALIAS_MODE) override { return S_OK; }
+    STDMETHODIMP SetTags(D2D1_TAG, D2D1_TAG) override { return S_OK; }
+    STDMETHODIMP SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE) override { return S_OK; }
+    STDMETHODIMP SetTextRenderingParams(IDWriteRenderingParams*) override { return S_OK; }
+    STDMETHODIMP SetTransform(const D2D1_MATRIX_3X2_F*) override { return S_OK; }
+    STDMETHODIMP SetPrimitiveBlend(D2D1_PRIMITIVE_BLEND) override { return S_OK; }
+    STDMETHODIMP SetUnitMode(D2D1_UNIT_MODE) override { return S_OK; }
+    STDMETHODIMP Clear(const D2D1_COLOR_F*) override { return draw(); }
+    STDMETHODIMP DrawGlyphRun(D2D1_POINT_2F, const DWRITE_GLYPH_RUN*,
+                              const DWRITE_GLYPH_RUN_DESCRIPTION*, ID2D1Brush*,
+                              DWRITE_MEASURING_MODE) override {
+        return draw();
+    }
+    STDMETHODIMP DrawLine(D2D1_POINT_2F, D2D1_POINT_2F, ID2D1Brush*, FLOAT,
+                          ID2D1StrokeStyle*) override {
+        return draw();
+    }
+    STDMETHODIMP DrawGeometry(ID2D1Geometry*, ID2D1Brush*, FLOAT, ID2D1StrokeStyle*) override {
+        return draw();
+    }
+    STDMETHODIMP DrawRectangle(const D2D1_RECT_F*, ID2D1Brush*, FLOAT,
+                               ID2D1StrokeStyle*) override {
+        return draw();
+    }
+    STDMETHODIMP DrawBitmap(ID2D1Bitmap*, const D2D1_RECT_F*, FLOAT, D2D1_INTERPOLATION_MODE,
+                            const D2D1_RECT_F*, const D2D1_MATRIX_4X4_F*) override {
+        return draw();
+    }
+    STDMETHODIMP DrawImage(ID2D1Image*, const D2D1_POINT_2F*, const D2D1_RECT_F*,
+                           D2D1_INTERPOLATION_MODE, D2D1_COMPOSITE_MODE) override {
+        return draw();
+    }
+    STDMETHODIMP DrawGdiMetafile(ID2D1GdiMetafile*, const D2D1_POINT_2F*) override {
+        return draw();
+    }
+    STDMETHODIMP FillMesh(ID2D1Mesh*, ID2D1Brush*) override { return draw(); }
+    STDMETHODIMP FillOpacityMask(ID2D1Bitmap*, ID2D1Brush*, const D2D1_RECT_F*,
+                                 const D2D1_RECT_F*) override {
+        return draw();
+    }
+    STDMETHODIMP FillGeometry(ID2D1Geometry*, ID2D1Brush*, ID2D1Brush*) override {
+        return draw();
+    }
+    STDMETHODIMP FillRectangle(const D2D1_RECT_F*, ID2D1Brush*) override { return draw(); }
+    STDMETHODIMP PushAxisAlignedClip(const D2D1_RECT_F*, D2D1_ANTIALIAS_MODE) override {
+        return S_OK;
+    }
+    STDMETHODIMP PushLayer(const D2D1_LAYER_PARAMETERS1*, ID2D1Layer*) override { return S_OK; }
+    STDMETHODIMP PopAxisAlignedClip() override { return S_OK; }
+    STDMETHODIMP PopLayer() override { return S_OK; }
+
+private:
+    HRESULT draw() {
+        ++count_;
+        return S_OK;
+    }
+
+    int count_ = 0;
+};
+
+// Nearest-rank percentile of sorted values.
+double Percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    const auto rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}  // namespace
+
+void CountUiResourceCreation() {
+    g_resourceCreations.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t UiResourceCreations() {
+    return g_resourceCreations.load(std::memory_order_relaxed);
+}
+
+int CountDrawCommands(ID2D1CommandList* list) {
+    if (!list) {
+        return -1;
+    }
+    DrawCommandCounter counter;
+    if (FAILED(list->Stream(&counter))) {
+        return -1;
+    }
+    return counter.count();
+}
+
+HRESULT DrawFrameCounted(ID2D1RenderTarget* target,
+                         const std::function<void(ID2D1RenderTarget*)>& draw,
+                         int* drawCalls) {
+    if (drawCalls) {
+        *drawCalls = -1;
+    }
+    if (!target || !draw) {
+        return E_INVALIDARG;
+    }
+    Microsoft::WRL::ComPtr<ID2D1DeviceContext> context;
+    Microsoft::WRL::ComPtr<ID2D1Image> screen;
+    Microsoft::WRL::ComPtr<ID2D1CommandList> frame;
+    if (SUCCEEDED(target->QueryInterface(IID_PPV_ARGS(&context)))) {
+        context->GetTarget(&screen);
+    }
+    if (!screen || FAILED(context->CreateCommandList(&frame))) {
+        target->BeginDraw();
+        draw(target);
+        return target->EndDraw();
+    }
+    CountUiResourceCreation();
+
+    context->SetTarget(frame.Get());
+    context->BeginDraw();
+    draw(context.Get());
+    HRESULT hr = context->EndDraw();
+    context->SetTarget(screen.Get());
+    if (SUCCEEDED(hr)) {
+        hr = frame->Close();
+    }
+    if (FAILED(hr)) {
+        return hr;
+    }
+    if (drawCalls) {
+        *drawCalls = CountDrawCommands(frame.Get());
+    }
+    context->BeginDraw();
+    context->SetTransform(D2D1::Matrix3x2F::Identity());
+    context->DrawImage(frame.Get());
+    return context->EndDraw();
+}
+
+int BenchmarkFramesFromCommandLine() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) {
+        return 0;
+    }
+    int frames = 0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::wcscmp(argv[i], L"--benchmark") == 0) {
+            frames = std::max(0, _wtoi(argv[i + 1]));
+            break;
+        }
+    }
+    LocalFree(argv);
+    return frames;
+}
+
+UiFrameBenchmark::UiFrameBenchmark(int frames) : frames_(std::max(0, frames)) {
+    samples_.reserve(static_cast<std::size_t>(frames_));
+    QueryPerformanceFrequency(&frequency_);
+}
+
+void UiFrameBenchmark::beginFrame() {
+    creationsAtStart_ = UiResourceCreations();
+    QueryPerformanceCounter(&frameStart_);
+}
+
+void UiFrameBenchmark::endFrame(int drawCalls) {
+    if (!running()) {
+        return;
+    }
+    LARGE_INTEGER now{};
+    QueryPerformanceCounter(&now);
+    Sample sample;
+    sample.milliseconds = static_cast<double>(now.QuadPart - frameStart_.QuadPart) * 1000.0 /
+                          static_cast<double>(frequency_.QuadPart);
+    sample.drawCalls = drawCalls;
+    sample.creations = UiResourceCreations() - creationsAtStart_;
+    samples_.push_back(sample);
+}
+
+std::string UiFrameBenchmark::report(const char* appName) const {
+    char line[256];
+    std::string text;
+    std::snprintf(line, sizeof(line), "%s: %d frames\n", appName ? appName : "ui",
+                  static_cast<int>(samples_.size()));
+    text += line;
+    if (samples_.empty()) {
+        return text;
+    }
+    const Sample& first = samples_.front();
+    // Steady state: everything after the first frame, or that frame alone.
+    const std::size_t from = samples_.size() > 1 ? 1 : 0;
+    const std::size_t steady = samples_.size() - from;
+
+    std::vector<double> times;
+    times.reserve(steady);
+    double drawSum = 0.0;
+    int drawMax = 0;
+    bool drawsKnown = true;
+    double creationSum = 0.0;
+    std::uint64_t creationMax = 0;
+    for (std::size_t i = from; i < samples_.size(); ++i) {
+        const Sample& s = samples_[i];
+        times.push_back(s.milliseconds);
+        drawsKnown = drawsKnown && s.drawCalls >= 0;
+        drawSum += static_cast<double>(s.drawCalls);
+        drawMax = std::max(drawMax, s.drawCalls);
+        creationSum += static_cast<double>(s.creations);
+        creationMax = std::max(creationMax, s.creations);
+    }
+    std::sort(times.begin(), times.end());
+
+    std::snprintf(line, sizeof(line),
+                  "  frame ms: p50 %.3f  p90 %.3f  p99 %.3f  max %.3f  (first %.3f)\n",
+                  Percentile(times, 0.50), Percentile(times, 0.90), Percentile(times, 0.99),
+                  times.back(), first.milliseconds);
+    text += line;
+    if (drawsKnown) {
+        std::snprintf(line, sizeof(line), "  draw calls/frame: mean %.1f  max %d  (first %d)\n",
+                      drawSum / static_cast<double>(steady), drawMax, first.drawCalls);
+    } else {
+        std::snprintf(line, sizeof(line), "  draw calls/frame: n/a\n");
+    }
+    text += line;
+    std::snprintf(line, sizeof(line),
+                  "  resource creations/frame: mean %.2f  max %llu  (first %llu)\n",
+                  creationSum / static_cast<double>(steady),
+                  static_cast<unsigned long long>(creationMax),
+                  static_cast<unsigned long long>(first.creations));
+    text += line;
+    return text;
+}
+
+bool UiFrameBenchmark::writeReport(const char* appName) const {
+    const std::string text = report(appName);
+    OutputDebugStringA(text.c_str());
+    std::ofstream out("satori_ui_benchmark.txt", std::ios::app);
+    out << text;
+    return static_cast<bool>(out);
+}
+
+}  // namespace winui
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <windows.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <d2d1_1.h>
+
+namespace winui {
+
+// Process-wide count of D2D/DirectWrite objects created while drawing (text
+// layouts, geometries, brushes, atlas pages, command lists). Call sites on the
+// paint path bump it; a benchmark reads the difference across a frame.
+void CountUiResourceCreation();
+std::uint64_t UiResourceCreations();
+
+// Draw commands (fills, strokes, glyph runs, bitmaps, clears) in a closed
+// command list; state changes, clips and layers are not counted. -1 when the
+// list cannot be streamed.
+int CountDrawCommands(ID2D1CommandList* list);
+
+// Runs `draw` between BeginDraw/EndDraw on `target` and returns EndDraw's
+// result. When the target is a device context the frame is recorded into a
+// command list first, counted, then drawn, and `drawCalls` receives the
+// count; otherwise it is drawn directly and `drawCalls` is -1.
+HRESULT DrawFrameCounted(ID2D1RenderTarget* target,
+                         const std::function<void(ID2D1RenderTarget*)>& draw,
+                         int* drawCalls);
+
+// `--benchmark N` on the command line: frames to run, or 0 when absent.
+int BenchmarkFramesFromCommandLine();
+
+// Times a scripted run of N frames on the UI thread. The app animates its
+// widgets from frame() and brackets each paint with beginFrame/endFrame;
+// once running() turns false it writes the report and quits.
+class UiFrameBenchmark {
+public:
+    explicit UiFrameBenchmark(int frames = 0);
+
+    bool active() const { return frames_ > 0; }
+    bool running() const { return active() && static_cast<int>(samples_.size()) < frames_; }
+    // Index of the frame being drawn next.
+    int frame() const { return static_cast<int>(samples_.size()); }
+
+    void beginFrame();
+    // `drawCalls` < 0: not known for this frame.
+    void endFrame(int drawCalls);
+
+    // Frame-time percentiles, draw calls and resource creations per frame.
+    // The first frame builds the caches and is reported on its own.
+    std::string report(const char* appName) const;
+    // Appends report() to satori_ui_benchmark.txt in the working directory
+    // and to the debugger output.
+    bool writeReport(const char* appName) const;
+
+private:
+    struct Sample {
+        double milliseconds = 0.0;
+        int drawCalls = -1;
+        std::uint64_t creations = 0;
+    };
+
+    int frames_ = 0;
+    std::vector<Sample> samples_;
+    LARGE_INTEGER frequency_{};
+    LARGE_INTEGER frameStart_{};
+    std::uint64_t creationsAtStart_ = 0;
+};
+
+}  // namespace winui
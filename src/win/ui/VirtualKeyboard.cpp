@@ -3,10 +3,14 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdint>
 #include <cwchar>
 
 #include <d2d1helper.h>
 
+#include "engine/MidiNote.h"
+#include "win/ui/RenderCache.h"
+
 namespace winui {
 
 namespace {
@@ -15,6 +19,8 @@ constexpr float kPaddingInset = 2.0f;
 constexpr float kBlackWidthRatio = 0.6f;
 constexpr float kBlackHeightRatio = 0.62f;
 constexpr float kBlackCenterShiftRatio = 0.12f;
+// Room around a key sprite for the outline stroke and its antialiasing.
+constexpr float kStrokeMargin = 2.0f;
 
 bool IsBlackNote(int noteIndex) {
     switch (noteIndex) {
@@ -69,11 +75,12 @@ void VirtualKeyboard::setHoverOutline(bool enabled) {
     showHoverOutline_ = enabled;
 }
 
-void VirtualKeyboard::draw(ID2D1HwndRenderTarget* target,
+void VirtualKeyboard::draw(ID2D1RenderTarget* target,
                            ID2D1SolidColorBrush* borderBrush,
                            ID2D1SolidColorBrush* fillBrush,
                            ID2D1SolidColorBrush* activeBrush,
-                           IDWriteTextFormat* textFormat) const {
+                           IDWriteTextFormat* textFormat,
+                           RenderCache* cache) const {
     KeyboardColors colors{};
     colors.whiteBorder = borderBrush;
     colors.blackBorder = borderBrush;
@@ -84,16 +91,18 @@ void VirtualKeyboard::draw(ID2D1HwndRenderTarget* target,
     colors.blackPressed = activeBrush;
     colors.whiteText = borderBrush;
     colors.blackText = borderBrush;
-    draw(target, colors, textFormat);
+    draw(target, colors, textFormat, cache);
 }
 
-void VirtualKeyboard::draw(ID2D1HwndRenderTarget* target,
+void VirtualKeyboard::draw(ID2D1RenderTarget* target,
                            const KeyboardColors& colors,
-                           IDWriteTextFormat* textFormat) const {
+                           IDWriteTextFormat* textFormat,
+                           RenderCache* cache) const {
     if (!target || !textFormat) {
         return;
     }
 
+    SpriteAtlas* sprites = cache ? &cache->sprites() : nullptr;
     auto renderKeyList = [&](const std::vector<std::size_t>& indices) {
         for (std::size_t idx : indices) {
             if (idx >= keys_.size()) {
@@ -114,16 +123,48 @@ void VirtualKeyboard::draw(ID2D1HwndRenderTarget* target,
             if (key.pressed && pressed) {
                 fill = pressed;
             }
-            target->FillRectangle(key.bounds, fill);
-            target->DrawRectangle(key.bounds, border, 1.0f);
-            if (showHoverOutline_ && key.hovered && colors.hoverOutline) {
-                target->DrawRectangle(key.bounds, colors.hoverOutline, 1.5f);
-            }
-            if (showLabels_ && textBrush && !key.label.empty()) {
-                target->DrawText(key.label.c_str(),
-                                 static_cast<UINT32>(key.label.size()),
-                                 textFormat, key.bounds, textBrush);
+            const bool outline = showHoverOutline_ && key.hovered && colors.hoverOutline;
+            const bool label = showLabels_ && textBrush && !key.label.empty();
+            auto paint = [&](ID2D1RenderTarget* rt, const D2D1_RECT_F& rect) {
+                rt->FillRectangle(rect, fill);
+                rt->DrawRectangle(rect, border, 1.0f);
+                if (outline) {
+                    rt->DrawRectangle(rect, colors.hoverOutline, 1.5f);
+                }
+                if (label) {
+                    rt->DrawText(key.label.c_str(), static_cast<UINT32>(key.label.size()),
+                                 textFormat, rect, textBrush);
+                }
+            };
+            if (sprites) {
+                // Every key of a colour and state looks the same apart from
+                // its label, so a few sprites cover the whole keyboard.
+                const D2D1_POINT_2F origin = D2D1::Point2F(
+                    sprites->snap(key.bounds.left - kStrokeMargin),
+                    sprites->snap(key.bounds.top - kStrokeMargin));
+                const auto local = D2D1::RectF(
+                    key.bounds.left - origin.x, key.bounds.top - origin.y,
+                    key.bounds.right - origin.x, key.bounds.bottom - origin.y);
+                GeometryStamp stamp;
+                stamp.add(local)
+                    .add(fill)
+                    .add(border)
+                    .add(outline ? colors.hoverOutline : nullptr)
+                    .add(static_cast<std::uint64_t>(
+                        label ? std::hash<std::wstring>{}(key.label) : 0))
+                    .add(label ? textBrush : nullptr)
+                    .add(static_cast<std::uint64_t>(
+                        reinterpret_cast<std::uintptr_t>(textFormat)));
+                const auto* sprite = sprites->sprite(
+                    target, stamp.value(),
+                    D2D1::SizeF(local.right + kStrokeMargin, local.bottom + kStrokeMargin),
+                    [&](ID2D1RenderTarget* rt) { paint(rt, local); });
+                if (sprite) {
+                    sprites->blit(target, *sprite, origin);
+                    continue;
+                }
             }
+            paint(target, key.bounds);
         }
     };
 
@@ -390,7 +431,7 @@ void VirtualKeyboard::updateHoveredKey(Key* key) {
 }
 
 double VirtualKeyboard::midiToFrequency(int midi) const {
-    return 440.0 * std::pow(2.0, (midi - 69) / 12.0);
+    return engine::MidiNoteToFrequency(midi);
 }
 
 }  // namespace winui
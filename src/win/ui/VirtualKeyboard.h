@@ -10,6 +10,8 @@
 
 namespace winui {
 
+class RenderCache;
+
 struct KeyboardColors {
     ID2D1SolidColorBrush* whiteFill = nullptr;
     ID2D1SolidColorBrush* whitePressed = nullptr;
@@ -35,14 +37,17 @@ public:
     void setHoverOutline(bool enabled);
     void layoutKeys();
 
-    void draw(ID2D1HwndRenderTarget* target,
+    void draw(ID2D1RenderTarget* target,
               ID2D1SolidColorBrush* borderBrush,
               ID2D1SolidColorBrush* fillBrush,
               ID2D1SolidColorBrush* activeBrush,
-              IDWriteTextFormat* textFormat) const;
-    void draw(ID2D1HwndRenderTarget* target,
+              IDWriteTextFormat* textFormat,
+              RenderCache* cache = nullptr) const;
+    // With a cache, each key state is a pre-rendered sprite.
+    void draw(ID2D1RenderTarget* target,
               const KeyboardColors& colors,
-              IDWriteTextFormat* textFormat) const;
+              IDWriteTextFormat* textFormat,
+              RenderCache* cache = nullptr) const;
 
     bool onPointerDown(float x, float y);
     bool onPointerMove(float x, float y);
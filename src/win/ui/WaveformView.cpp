@@ -1,19 +1,121 @@
 #include "win/ui/WaveformView.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
 
 #include <d2d1helper.h>
 
+#include "win/ui/UiBenchmark.h"
+
 namespace winui {
 
+namespace {
+
+bool SameRect(const D2D1_RECT_F& a, const D2D1_RECT_F& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+}  // namespace
+
+void WaveformView::setBounds(const D2D1_RECT_F& bounds) {
+    if (!SameRect(bounds, bounds_)) {
+        bounds_ = bounds;
+        geometryDirty_ = true;
+    }
+}
+
 void WaveformView::setSamples(std::vector<float> samples) {
     samples_ = std::move(samples);
+    // Reduce now when the width is known so draw() only builds the path.
+    rebuildColumns(columnCount_);
+    geometryDirty_ = true;
 }
 
-void WaveformView::draw(ID2D1HwndRenderTarget* target,
+void WaveformView::rebuildColumns(std::size_t columnCount) {
+    columnCount_ = columnCount;
+    columns_.clear();
+    // Until there are two samples per pixel the plain polyline is cheaper
+    // and keeps the shape exact.
+    if (columnCount == 0 || samples_.size() <= columnCount * 2) {
+        return;
+    }
+    columns_.resize(columnCount);
+    const double samplesPerColumn =
+        static_cast<double>(samples_.size()) / static_cast<double>(columnCount);
+    for (std::size_t c = 0; c < columnCount; ++c) {
+        const auto begin = static_cast<std::size_t>(samplesPerColumn * static_cast<double>(c));
+        const auto end = std::min(
+            samples_.size(),
+            std::max(begin + 1,
+                     static_cast<std::size_t>(samplesPerColumn * static_cast<double>(c + 1))));
+        const auto [low, high] =
+            std::minmax_element(samples_.begin() + static_cast<std::ptrdiff_t>(begin),
+                                samples_.begin() + static_cast<std::ptrdiff_t>(end));
+        columns_[c].low = std::clamp(*low, -1.0f, 1.0f);
+        columns_[c].high = std::clamp(*high, -1.0f, 1.0f);
+    }
+}
+
+void WaveformView::rebuildGeometry(ID2D1Factory* factory) {
+    geometry_.Reset();
+    geometryFactory_ = factory;
+    geometryDirty_ = false;
+
+    const float width = bounds_.right - bounds_.left;
+    const float height = bounds_.bottom - bounds_.top;
+    const std::size_t points = columns_.empty() ? samples_.size() : columns_.size();
+    if (!factory || points < 2 || width <= 0.0f || height <= 0.0f) {
+        return;
+    }
+    Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry;
+    CountUiResourceCreation();
+    if (FAILED(factory->CreatePathGeometry(&geometry)) || !geometry) {
+        return;
+    }
+    Microsoft::WRL::ComPtr<ID2D1GeometrySink> sink;
+    if (FAILED(geometry->Open(&sink)) || !sink) {
+        return;
+    }
+
+    const float midY = bounds_.top + height * 0.5f;
+    const float scaleY = height * 0.45f;
+    const float step = width / static_cast<float>(points - 1);
+    if (columns_.empty()) {
+        sink->BeginFigure(
+            D2D1::Point2F(bounds_.left, midY - std::clamp(samples_[0], -1.0f, 1.0f) * scaleY),
+            D2D1_FIGURE_BEGIN_HOLLOW);
+        for (std::size_t i = 1; i < samples_.size(); ++i) {
+            sink->AddLine(D2D1::Point2F(bounds_.left + step * static_cast<float>(i),
+                                        midY - std::clamp(samples_[i], -1.0f, 1.0f) * scaleY));
+        }
+    } else {
+        // One vertical stroke per column, joined in a zigzag so the envelope
+        // stays a single figure.
+        sink->BeginFigure(D2D1::Point2F(bounds_.left, midY - columns_[0].high * scaleY),
+                          D2D1_FIGURE_BEGIN_HOLLOW);
+        for (std::size_t c = 0; c < columns_.size(); ++c) {
+            const float x = bounds_.left + step * static_cast<float>(c);
+            const bool down = (c % 2) == 0;
+            const float first = down ? columns_[c].high : columns_[c].low;
+            const float second = down ? columns_[c].low : columns_[c].high;
+            if (c > 0) {
+                sink->AddLine(D2D1::Point2F(x, midY - first * scaleY));
+            }
+            sink->AddLine(D2D1::Point2F(x, midY - second * scaleY));
+        }
+    }
+    sink->EndFigure(D2D1_FIGURE_END_OPEN);
+    if (SUCCEEDED(sink->Close())) {
+        geometry_ = std::move(geometry);
+    }
+}
+
+void WaveformView::draw(ID2D1RenderTarget* target,
                         ID2D1SolidColorBrush* background,
                         ID2D1SolidColorBrush* grid,
-                        ID2D1SolidColorBrush* waveform) const {
+                        ID2D1SolidColorBrush* waveform) {
     if (!target || !background || !grid || !waveform) {
         return;
     }
@@ -33,19 +135,24 @@ void WaveformView::draw(ID2D1HwndRenderTarget* target,
         return;
     }
 
-    const float scaleY = height * 0.45f;
-    float prevX = bounds_.left;
-    float prevY = midY - std::clamp(samples_[0], -1.0f, 1.0f) * scaleY;
-
-    const float step = width / static_cast<float>(samples_.size() - 1);
-    for (std::size_t i = 1; i < samples_.size(); ++i) {
-        const float x = bounds_.left + step * static_cast<float>(i);
-        const float y =
-            midY - std::clamp(samples_[i], -1.0f, 1.0f) * scaleY;
-        target->DrawLine(D2D1::Point2F(prevX, prevY), D2D1::Point2F(x, y),
-                         waveform, 2.0f);
-        prevX = x;
-        prevY = y;
+    // Columns are device pixels, so a high-DPI display gets full detail.
+    float dpiX = 96.0f;
+    float dpiY = 96.0f;
+    target->GetDpi(&dpiX, &dpiY);
+    const auto columnCount =
+        static_cast<std::size_t>(std::max(1.0f, std::ceil(width * dpiX / 96.0f)));
+    if (columnCount != columnCount_) {
+        rebuildColumns(columnCount);
+        geometryDirty_ = true;
+    }
+
+    Microsoft::WRL::ComPtr<ID2D1Factory> factory;
+    target->GetFactory(&factory);
+    if (geometryDirty_ || factory.Get() != geometryFactory_) {
+        rebuildGeometry(factory.Get());
+    }
+    if (geometry_) {
+        target->DrawGeometry(geometry_.Get(), waveform, 2.0f);
     }
 }
 
@@ -1,24 +1,42 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
 
 #include <d2d1.h>
+#include <wrl/client.h>
 
 namespace winui {
 
+// Draws a sample buffer as a line. Buffers longer than the view is wide are
+// reduced to one min/max pair per device pixel; the resulting path is cached
+// and rebuilt only when the samples, bounds or DPI change.
 class WaveformView {
 public:
-    void setBounds(const D2D1_RECT_F& bounds) { bounds_ = bounds; }
+    void setBounds(const D2D1_RECT_F& bounds);
     void setSamples(std::vector<float> samples);
 
-    void draw(ID2D1HwndRenderTarget* target,
+    void draw(ID2D1RenderTarget* target,
               ID2D1SolidColorBrush* background,
               ID2D1SolidColorBrush* grid,
-              ID2D1SolidColorBrush* waveform) const;
+              ID2D1SolidColorBrush* waveform);
 
 private:
+    struct Column {
+        float low = 0.0f;
+        float high = 0.0f;
+    };
+
+    void rebuildColumns(std::size_t columnCount);
+    void rebuildGeometry(ID2D1Factory* factory);
+
     D2D1_RECT_F bounds_{};
     std::vector<float> samples_;
+    std::vector<Column> columns_;  // empty: samples_ are drawn directly
+    std::size_t columnCount_ = 0;
+    Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry_;
+    ID2D1Factory* geometryFactory_ = nullptr;  // geometry_ belongs to it
+    bool geometryDirty_ = true;
 };
 
 }  // namespace winui
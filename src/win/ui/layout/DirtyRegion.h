@@ -0,0 +1,47 @@
+#pragma once
+
+#include <algorithm>
+
+#include <d2d1.h>
+
+namespace winui {
+
+// Bounding box of everything that needs repainting (DIPs). Direct2D clips
+// to one axis-aligned rect, so separate damage is merged rather than kept
+// as a list.
+class DirtyRegion {
+public:
+    void add(const D2D1_RECT_F& rect) {
+        if (rect.right <= rect.left || rect.bottom <= rect.top) {
+            return;
+        }
+        if (empty_) {
+            rect_ = rect;
+            empty_ = false;
+            return;
+        }
+        rect_.left = std::min(rect_.left, rect.left);
+        rect_.top = std::min(rect_.top, rect.top);
+        rect_.right = std::max(rect_.right, rect.right);
+        rect_.bottom = std::max(rect_.bottom, rect.bottom);
+    }
+    void add(const DirtyRegion& other) {
+        if (!other.empty_) {
+            add(other.rect_);
+        }
+    }
+    void clear() { empty_ = true; }
+
+    bool empty() const { return empty_; }
+    const D2D1_RECT_F& rect() const { return rect_; }
+
+private:
+    D2D1_RECT_F rect_{};
+    bool empty_ = true;
+};
+
+inline bool RectsIntersect(const D2D1_RECT_F& a, const D2D1_RECT_F& b) {
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+}  // namespace winui
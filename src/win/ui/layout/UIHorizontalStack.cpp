@@ -111,15 +111,18 @@ void UIHorizontalStack::arrange(const D2D1_RECT_F& bounds) {
 
 void UIHorizontalStack::draw(const RenderResources& resources) {
     for (const auto& item : items_) {
-        if (item.node) {
+        if (item.node && resources.needsPaint(item.node->bounds())) {
             item.node->draw(resources);
         }
     }
 }
 
 bool UIHorizontalStack::onPointerDown(float x, float y) {
+    pointerTarget_.reset();
     for (auto& item : items_) {
         if (item.node && item.node->onPointerDown(x, y)) {
+            item.node->invalidate();
+            pointerTarget_ = item.node;
             return true;
         }
     }
@@ -130,6 +133,7 @@ bool UIHorizontalStack::onPointerMove(float x, float y) {
     bool handled = false;
     for (auto& item : items_) {
         if (item.node && item.node->onPointerMove(x, y)) {
+            item.node->invalidate();
             handled = true;
         }
     }
@@ -142,6 +146,19 @@ void UIHorizontalStack::onPointerUp() {
             item.node->onPointerUp();
         }
     }
+    if (pointerTarget_) {
+        pointerTarget_->invalidate();
+        pointerTarget_.reset();
+    }
+}
+
+void UIHorizontalStack::collectDirty(DirtyRegion& region) {
+    UILayoutNode::collectDirty(region);
+    for (auto& item : items_) {
+        if (item.node) {
+            item.node->collectDirty(region);
+        }
+    }
 }
 
 float UIHorizontalStack::totalFixedWidth(float) const {
@@ -24,9 +24,11 @@ public:
     bool onPointerDown(float x, float y) override;
     bool onPointerMove(float x, float y) override;
     void onPointerUp() override;
+    void collectDirty(DirtyRegion& region) override;
 
 private:
     std::vector<Item> items_;
+    UILayoutNodePtr pointerTarget_;  // child that took the last pointer down
     float spacing_ = 12.0f;
 
     float totalFixedWidth(float containerWidth) const;
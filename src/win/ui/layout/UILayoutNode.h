@@ -6,6 +6,7 @@
 #include <d2d1.h>
 
 #include "win/ui/RenderResources.h"
+#include "win/ui/layout/DirtyRegion.h"
 
 namespace winui {
 
@@ -24,9 +25,23 @@ public:
     virtual float preferredHeight(float width) const = 0;
     virtual float minimumHeight() const { return 0.0f; }
 
-    virtual void arrange(const D2D1_RECT_F& bounds) { bounds_ = bounds; }
+    virtual void arrange(const D2D1_RECT_F& bounds) {
+        dirty_.add(bounds_);
+        bounds_ = bounds;
+        dirty_.add(bounds_);
+    }
     virtual void draw(const RenderResources& resources) = 0;
 
+    // Damage tracking: a node marks what changed (its whole bounds by
+    // default) and containers gather their children's marks, so
+    // Direct2DContext repaints only that part of the window.
+    void invalidate() { dirty_.add(bounds_); }
+    void invalidateRect(const D2D1_RECT_F& rect) { dirty_.add(rect); }
+    virtual void collectDirty(DirtyRegion& region) {
+        region.add(dirty_);
+        dirty_.clear();
+    }
+
     virtual bool onPointerDown(float x, float y) { return false; }
     virtual bool onPointerMove(float x, float y) { return false; }
     virtual void onPointerUp() {}
@@ -38,6 +53,7 @@ public:
 
 protected:
     D2D1_RECT_F bounds_{};
+    DirtyRegion dirty_;
 };
 
 using UILayoutNodePtr = std::shared_ptr<UILayoutNode>;
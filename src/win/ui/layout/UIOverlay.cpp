@@ -29,15 +29,19 @@ void UIOverlay::arrange(const D2D1_RECT_F& bounds) {
 
 void UIOverlay::draw(const RenderResources& resources) {
     for (const auto& child : children_) {
-        if (child) {
+        if (child && resources.needsPaint(child->bounds())) {
             child->draw(resources);
         }
     }
 }
 
 bool UIOverlay::onPointerDown(float x, float y) {
+    pointerTarget_.reset();
     for (auto& child : children_) {
         if (child && child->onPointerDown(x, y)) {
+            // Layers share bounds; repaint the whole stack over the change.
+            invalidate();
+            pointerTarget_ = child;
             return true;
         }
     }
@@ -48,6 +52,7 @@ bool UIOverlay::onPointerMove(float x, float y) {
     bool handled = false;
     for (auto& child : children_) {
         if (child && child->onPointerMove(x, y)) {
+            child->invalidate();
             handled = true;
         }
     }
@@ -60,6 +65,19 @@ void UIOverlay::onPointerUp() {
             child->onPointerUp();
         }
     }
+    if (pointerTarget_) {
+        pointerTarget_->invalidate();
+        pointerTarget_.reset();
+    }
+}
+
+void UIOverlay::collectDirty(DirtyRegion& region) {
+    UILayoutNode::collectDirty(region);
+    for (auto& child : children_) {
+        if (child) {
+            child->collectDirty(region);
+        }
+    }
 }
 
 }  // namespace winui
@@ -18,9 +18,11 @@ public:
     bool onPointerDown(float x, float y) override;
     bool onPointerMove(float x, float y) override;
     void onPointerUp() override;
+    void collectDirty(DirtyRegion& region) override;
 
 private:
     std::vector<UILayoutNodePtr> children_;
+    UILayoutNodePtr pointerTarget_;  // child that took the last pointer down
 };
 
 }  // namespace winui
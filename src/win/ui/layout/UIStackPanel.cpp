@@ -121,15 +121,18 @@ void UIStackPanel::arrange(const D2D1_RECT_F& bounds) {
 
 void UIStackPanel::draw(const RenderResources& resources) {
     for (const auto& item : items_) {
-        if (item.node) {
+        if (item.node && resources.needsPaint(item.node->bounds())) {
             item.node->draw(resources);
         }
     }
 }
 
 bool UIStackPanel::onPointerDown(float x, float y) {
+    pointerTarget_.reset();
     for (auto& item : items_) {
         if (item.node && item.node->onPointerDown(x, y)) {
+            item.node->invalidate();
+            pointerTarget_ = item.node;
             return true;
         }
     }
@@ -140,6 +143,7 @@ bool UIStackPanel::onPointerMove(float x, float y) {
     bool handled = false;
     for (auto& item : items_) {
         if (item.node && item.node->onPointerMove(x, y)) {
+            item.node->invalidate();
             handled = true;
         }
     }
@@ -152,6 +156,19 @@ void UIStackPanel::onPointerUp() {
             item.node->onPointerUp();
         }
     }
+    if (pointerTarget_) {
+        pointerTarget_->invalidate();
+        pointerTarget_.reset();
+    }
+}
+
+void UIStackPanel::collectDirty(DirtyRegion& region) {
+    UILayoutNode::collectDirty(region);
+    for (auto& item : items_) {
+        if (item.node) {
+            item.node->collectDirty(region);
+        }
+    }
 }
 
 float UIStackPanel::totalFixedHeight(float) const {
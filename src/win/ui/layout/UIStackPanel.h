@@ -26,9 +26,11 @@ public:
     bool onPointerDown(float x, float y) override;
     bool onPointerMove(float x, float y) override;
     void onPointerUp() override;
+    void collectDirty(DirtyRegion& region) override;
 
 private:
     std::vector<Item> items_;
+    UILayoutNodePtr pointerTarget_;  // child that took the last pointer down
     float spacing_;
     mutable float cachedWidth_ = 0.0f;
     mutable float cachedPreferredHeight_ = 0.0f;
@@ -28,6 +28,7 @@ void DropdownSelectorNode::setSelectedIndex(int index) {
         return;
     }
     selectedIndex_ = index;
+    invalidate();
     notifyChanged();
 }
 
@@ -17,14 +17,19 @@ FlowDiagramNode::FlowDiagramNode() = default;
 
 void FlowDiagramNode::setDiagramState(const FlowDiagramState& state) {
     state_ = state;
+    invalidate();
 }
 
 void FlowDiagramNode::setHighlightedModule(FlowModule module) {
-    state_.highlightedModule = module;
+    if (state_.highlightedModule != module) {
+        state_.highlightedModule = module;
+        invalidate();
+    }
 }
 
 void FlowDiagramNode::setWaveformSamples(const std::vector<float>& samples) {
     waveformView_.setSamples(samples);
+    invalidate();
 }
 
 void FlowDiagramNode::setOnModuleSelected(
@@ -170,7 +175,7 @@ void FlowDiagramNode::draw(const RenderResources& resources) {
              roomRect, highlightRoom);
 }
 
-void FlowDiagramNode::drawExcitation(ID2D1HwndRenderTarget* target,
+void FlowDiagramNode::drawExcitation(ID2D1RenderTarget* target,
                                      ID2D1SolidColorBrush* textBrush,
                                      ID2D1SolidColorBrush* gridBrush,
                                      ID2D1SolidColorBrush* excitationBrush,
@@ -284,7 +289,7 @@ void FlowDiagramNode::drawExcitation(ID2D1HwndRenderTarget* target,
     }
 }
 
-void FlowDiagramNode::drawString(ID2D1HwndRenderTarget* target,
+void FlowDiagramNode::drawString(ID2D1RenderTarget* target,
                                  ID2D1SolidColorBrush* textBrush,
                                  ID2D1SolidColorBrush* gridBrush,
                                  ID2D1SolidColorBrush* accentBrush,
@@ -357,7 +362,7 @@ void FlowDiagramNode::drawString(ID2D1HwndRenderTarget* target,
     }
 }
 
-void FlowDiagramNode::drawBody(ID2D1HwndRenderTarget* target,
+void FlowDiagramNode::drawBody(ID2D1RenderTarget* target,
                                ID2D1SolidColorBrush* textBrush,
                                ID2D1SolidColorBrush* gridBrush,
                                ID2D1SolidColorBrush* accentBrush,
@@ -416,7 +421,7 @@ void FlowDiagramNode::drawBody(ID2D1HwndRenderTarget* target,
     target->DrawRectangle(highShelf, accentBrush, thickness);
 }
 
-void FlowDiagramNode::drawRoom(ID2D1HwndRenderTarget* target,
+void FlowDiagramNode::drawRoom(ID2D1RenderTarget* target,
                                ID2D1SolidColorBrush* panelBrush,
                                ID2D1SolidColorBrush* textBrush,
                                ID2D1SolidColorBrush* gridBrush,
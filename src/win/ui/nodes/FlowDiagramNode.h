@@ -32,7 +32,7 @@ private:
     D2D1_RECT_F bodyRect_{};
     D2D1_RECT_F roomRect_{};
 
-    void drawExcitation(ID2D1HwndRenderTarget* target,
+    void drawExcitation(ID2D1RenderTarget* target,
                         ID2D1SolidColorBrush* textBrush,
                         ID2D1SolidColorBrush* gridBrush,
                         ID2D1SolidColorBrush* excitationBrush,
@@ -41,7 +41,7 @@ private:
                         const D2D1_RECT_F& rect,
                         bool highlighted);
 
-    void drawString(ID2D1HwndRenderTarget* target,
+    void drawString(ID2D1RenderTarget* target,
                     ID2D1SolidColorBrush* textBrush,
                     ID2D1SolidColorBrush* gridBrush,
                     ID2D1SolidColorBrush* accentBrush,
@@ -49,7 +49,7 @@ private:
                     const D2D1_RECT_F& rect,
                     bool highlighted);
 
-    void drawBody(ID2D1HwndRenderTarget* target,
+    void drawBody(ID2D1RenderTarget* target,
                   ID2D1SolidColorBrush* textBrush,
                   ID2D1SolidColorBrush* gridBrush,
                   ID2D1SolidColorBrush* accentBrush,
@@ -57,7 +57,7 @@ private:
                   const D2D1_RECT_F& rect,
                   bool highlighted);
 
-    void drawRoom(ID2D1HwndRenderTarget* target,
+    void drawRoom(ID2D1RenderTarget* target,
                   ID2D1SolidColorBrush* panelBrush,
                   ID2D1SolidColorBrush* textBrush,
                   ID2D1SolidColorBrush* gridBrush,
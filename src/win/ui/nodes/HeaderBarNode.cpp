@@ -1,6 +1,10 @@
 #include "win/ui/nodes/HeaderBarNode.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cwchar>
+#include <iterator>
+#include <utility>
 
 #include <d2d1helper.h>
 
@@ -10,6 +14,25 @@ namespace winui {
 
 namespace {
 float RectHeight(const D2D1_RECT_F& r) { return r.bottom - r.top; }
+
+// Load at which the readout turns to the accent colour.
+constexpr float kHighDspLoad = 0.8f;
+constexpr float kLogoWidth = 100.0f;
+constexpr float kMixWidth = 120.0f;
+constexpr float kHealthWidth = 310.0f;
+
+std::wstring FormatHealth(const AudioHealth& health) {
+    if (!health.online) {
+        return {};
+    }
+    wchar_t text[128];
+    std::swprintf(text, std::size(text),
+                  L"DSP %d%%  Xrun %llu  Voice %zu/%zu  Rev %.0fms  Out %.1fms",
+                  static_cast<int>(std::lround(health.dspLoad * 100.0f)),
+                  static_cast<unsigned long long>(health.xruns), health.activeVoices,
+                  health.voiceLimit, health.reverbLatencyMs, health.outputLatencyMs);
+    return text;
+}
 }  // namespace
 
 HeaderBarNode::HeaderBarNode()
@@ -20,6 +43,8 @@ HeaderBarNode::HeaderBarNode()
 void HeaderBarNode::setModel(const HeaderBarModel& model) {
     logoText_ = model.logoText.empty() ? L"Satori" : model.logoText;
     mixSampleRateText_ = model.mixSampleRateText;
+    health_ = model.health;
+    healthText_ = FormatHealth(health_);
 
     deviceLabel_ = model.device.label.empty() ? L"Device" : model.device.label;
     sampleRateLabel_ =
@@ -50,6 +75,23 @@ void HeaderBarNode::setModel(const HeaderBarModel& model) {
     }
 }
 
+void HeaderBarNode::setHealth(const AudioHealth& health) {
+    if (health == health_) {
+        return;
+    }
+    const bool relayout = health.online != health_.online;
+    health_ = health;
+    if (relayout) {
+        // The readout appearing or going takes room from the device group.
+        arrange(bounds_);
+    }
+    std::wstring text = FormatHealth(health_);
+    if (text != healthText_) {
+        healthText_ = std::move(text);
+        invalidateRect(healthRect_);
+    }
+}
+
 std::vector<std::shared_ptr<DropdownSelectorNode>> HeaderBarNode::selectors() const {
     std::vector<std::shared_ptr<DropdownSelectorNode>> list;
     if (deviceSelector_) list.push_back(deviceSelector_);
@@ -108,8 +150,10 @@ void HeaderBarNode::arrange(const D2D1_RECT_F& bounds) {
     // Device group gets the remaining space, but keeps a reasonable minimum width.
     const float deviceDropMaxW = deviceWDefault;
     const float deviceDropMinW = 180.0f;
-    const float remainingForDevice =
-        std::max(0.0f, right - (bounds_.left + paddingX + 160.0f));
+    // The device dropdown gives way to the health readout down to its minimum.
+    const float leftReserve = kLogoWidth + kMixWidth + (health_.online ? kHealthWidth : 40.0f);
+    const float remainingForDevice = std::max(
+        0.0f, right - (bounds_.left + paddingX + leftReserve) - labelWDevice - labelGap - groupGap);
     const float deviceDropW =
         std::clamp(remainingForDevice, deviceDropMinW, deviceDropMaxW);
     placeGroup(labelWDevice, deviceLabel_, deviceDropW, deviceLabelRect_,
@@ -120,8 +164,11 @@ void HeaderBarNode::arrange(const D2D1_RECT_F& bounds) {
     const float logoRight = std::max(logoLeft, deviceLabelRect_.left - groupGap);
     logoRect_ = D2D1::RectF(logoLeft, bounds_.top + paddingY, logoRight,
                             bounds_.bottom - paddingY);
-    const float mixLeft = std::min(logoRect_.right, logoRect_.left + 140.0f);
-    mixRect_ = D2D1::RectF(mixLeft, logoRect_.top, logoRect_.right, logoRect_.bottom);
+    const float mixLeft = std::min(logoRect_.right, logoRect_.left + kLogoWidth);
+    const float mixRight = std::min(logoRect_.right, mixLeft + kMixWidth);
+    mixRect_ = D2D1::RectF(mixLeft, logoRect_.top, mixRight, logoRect_.bottom);
+    // Health readout in what is left before the device group.
+    healthRect_ = D2D1::RectF(mixRight, logoRect_.top, logoRect_.right, logoRect_.bottom);
 }
 
 void HeaderBarNode::draw(const RenderResources& resources) {
@@ -168,6 +215,15 @@ void HeaderBarNode::draw(const RenderResources& resources) {
                                    resources.textFormat, tr, text);
     }
 
+    // Too narrow for the whole readout: drop it rather than clip it.
+    if (!healthText_.empty() && healthRect_.right - healthRect_.left >= kHealthWidth - 20.0f) {
+        const auto tr = D2D1::RectF(healthRect_.left, healthRect_.top + 1.0f, healthRect_.right,
+                                    healthRect_.bottom - 1.0f);
+        auto* brush = health_.dspLoad >= kHighDspLoad ? accent : text;
+        resources.target->DrawText(healthText_.c_str(), static_cast<UINT32>(healthText_.size()),
+                                   resources.textFormat, tr, brush);
+    }
+
     drawLabel(deviceLabel_, deviceLabelRect_);
     drawLabel(sampleRateLabel_, sampleRateLabelRect_);
     drawLabel(bufferFramesLabel_, bufferFramesLabelRect_);
@@ -199,4 +255,11 @@ void HeaderBarNode::onPointerUp() {
     if (bufferFramesSelector_) bufferFramesSelector_->onPointerUp();
 }
 
+void HeaderBarNode::collectDirty(DirtyRegion& region) {
+    UILayoutNode::collectDirty(region);
+    for (const auto& selector : selectors()) {
+        selector->collectDirty(region);
+    }
+}
+
 }  // namespace winui
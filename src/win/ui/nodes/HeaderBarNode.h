@@ -16,6 +16,8 @@ public:
     HeaderBarNode();
 
     void setModel(const HeaderBarModel& model);
+    // Repaints only the health readout, and only when it changed.
+    void setHealth(const AudioHealth& health);
 
     std::shared_ptr<DropdownSelectorNode> deviceSelector() const { return deviceSelector_; }
     std::shared_ptr<DropdownSelectorNode> sampleRateSelector() const { return sampleRateSelector_; }
@@ -30,10 +32,13 @@ public:
     bool onPointerDown(float x, float y) override;
     bool onPointerMove(float x, float y) override;
     void onPointerUp() override;
+    void collectDirty(DirtyRegion& region) override;
 
 private:
     std::wstring logoText_ = L"Satori";
     std::wstring mixSampleRateText_;
+    AudioHealth health_;
+    std::wstring healthText_;
 
     std::wstring deviceLabel_ = L"Device";
     std::wstring sampleRateLabel_ = L"SampleRate";
@@ -45,6 +50,7 @@ private:
 
     D2D1_RECT_F logoRect_{};
     D2D1_RECT_F mixRect_{};
+    D2D1_RECT_F healthRect_{};
     D2D1_RECT_F deviceLabelRect_{};
     D2D1_RECT_F sampleRateLabelRect_{};
     D2D1_RECT_F bufferFramesLabelRect_{};
@@ -60,7 +60,7 @@ void KeyboardNode::draw(const RenderResources& resources) {
         colors.hoverOutline = colors.whiteBorder;
     }
 
-    keyboard_.draw(resources.target, colors, resources.textFormat);
+    keyboard_.draw(resources.target, colors, resources.textFormat, resources.cache);
 }
 
 bool KeyboardNode::onPointerDown(float x, float y) {
@@ -80,15 +80,21 @@ void KeyboardNode::setColors(const KeyboardColors& colors) {
 }
 
 bool KeyboardNode::pressKeyByMidi(int midiNote) {
-    return keyboard_.pressKeyByMidi(midiNote);
+    const bool pressed = keyboard_.pressKeyByMidi(midiNote);
+    if (pressed) {
+        invalidate();
+    }
+    return pressed;
 }
 
 void KeyboardNode::releaseKeyByMidi(int midiNote) {
     keyboard_.releaseKeyByMidi(midiNote);
+    invalidate();
 }
 
 void KeyboardNode::releaseAllKeys() {
     keyboard_.releaseAllKeys();
+    invalidate();
 }
 
 }  // namespace winui
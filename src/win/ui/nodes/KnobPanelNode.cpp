@@ -65,7 +65,10 @@ void KnobPanelNode::setModules(const std::vector<ModuleUI>& modules,
 }
 
 void KnobPanelNode::setExternalHighlight(std::optional<FlowModule> module) {
-    externalHighlight_ = module;
+    if (externalHighlight_ != module) {
+        externalHighlight_ = module;
+        invalidate();
+    }
 }
 
 void KnobPanelNode::syncKnobs() {
@@ -76,6 +79,7 @@ void KnobPanelNode::syncKnobs() {
             }
         }
     }
+    invalidate();
 }
 
 float KnobPanelNode::preferredHeight(float) const {
@@ -178,7 +182,8 @@ void KnobPanelNode::draw(const RenderResources& resources) {
             }
             entry.knob->drawBody(resources.target, resources.trackBrush,
                                  resources.fillBrush, resources.accentBrush,
-                                 resources.textBrush, resources.textFormat);
+                                 resources.textBrush, resources.textFormat,
+                                 resources.cache);
         }
 
     }
@@ -25,7 +25,10 @@ ModuleCardNode::ModuleCardNode(FlowModule module,
     : module_(module), preview_(std::move(preview)), controls_(std::move(controls)) {}
 
 void ModuleCardNode::setHighlighted(bool highlighted) {
-    highlighted_ = highlighted;
+    if (highlighted_ != highlighted) {
+        highlighted_ = highlighted;
+        invalidate();
+    }
 }
 
 float ModuleCardNode::preferredHeight(float width) const {
@@ -168,5 +171,15 @@ void ModuleCardNode::onPointerUp() {
     }
 }
 
+void ModuleCardNode::collectDirty(DirtyRegion& region) {
+    UILayoutNode::collectDirty(region);
+    if (preview_) {
+        preview_->collectDirty(region);
+    }
+    if (controls_) {
+        controls_->collectDirty(region);
+    }
+}
+
 }  // namespace winui
 
@@ -27,6 +27,7 @@ public:
     bool onPointerDown(float x, float y) override;
     bool onPointerMove(float x, float y) override;
     void onPointerUp() override;
+    void collectDirty(DirtyRegion& region) override;
 
 private:
     FlowModule module_ = FlowModule::kNone;
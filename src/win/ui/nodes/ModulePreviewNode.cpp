@@ -4,16 +4,19 @@
 #include <cmath>
 
 #include <d2d1helper.h>
-#include <wrl/client.h>
 
 namespace winui {
 
 namespace {
+// RenderCache slots for this node's retained geometries.
+constexpr int kExcitationFillSlot = 0;
+constexpr int kBodyFillSlot = 1;
+
 bool ContainsPoint(const D2D1_RECT_F& rect, float x, float y) {
     return x >= rect.left && x <= rect.right && y >= rect.top && y <= rect.bottom;
 }
 
-void DrawTitle(ID2D1HwndRenderTarget* target,
+void DrawTitle(ID2D1RenderTarget* target,
                ID2D1SolidColorBrush* textBrush,
                ID2D1SolidColorBrush* gridBrush,
                ID2D1SolidColorBrush* accentBrush,
@@ -43,14 +46,19 @@ ModulePreviewNode::ModulePreviewNode(FlowModule module) : module_(module) {}
 
 void ModulePreviewNode::setDiagramState(const FlowDiagramState& state) {
     state_ = state;
+    invalidate();
 }
 
 void ModulePreviewNode::setWaveformSamples(const std::vector<float>& samples) {
     waveformView_.setSamples(samples);
+    invalidate();
 }
 
 void ModulePreviewNode::setHighlighted(bool highlighted) {
-    highlighted_ = highlighted;
+    if (highlighted_ != highlighted) {
+        highlighted_ = highlighted;
+        invalidate();
+    }
 }
 
 void ModulePreviewNode::setOnSelected(std::function<void(FlowModule)> callback) {
@@ -138,13 +146,12 @@ void ModulePreviewNode::draw(const RenderResources& resources) {
                     }
 
                     // Filled transient area (low opacity) to reduce "noisy line" feeling.
-                    Microsoft::WRL::ComPtr<ID2D1Factory> factory;
-                    resources.target->GetFactory(&factory);
-                    if (factory && points.size() >= 2) {
-                        Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry;
-                        if (SUCCEEDED(factory->CreatePathGeometry(&geometry)) && geometry) {
-                            Microsoft::WRL::ComPtr<ID2D1GeometrySink> sink;
-                            if (SUCCEEDED(geometry->Open(&sink)) && sink) {
+                    // Rebuilt only when the samples or the viz rect change.
+                    if (resources.cache && points.size() >= 2) {
+                        const auto stamp =
+                            GeometryStamp().add(vizRect).add(samples).value();
+                        auto* geometry = resources.cache->geometry(
+                            this, kExcitationFillSlot, stamp, [&](ID2D1GeometrySink* sink) {
                                 sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
                                 sink->BeginFigure(D2D1::Point2F(points.front().x, midY),
                                                   D2D1_FIGURE_BEGIN_FILLED);
@@ -153,27 +160,26 @@ void ModulePreviewNode::draw(const RenderResources& resources) {
                                 }
                                 sink->AddLine(D2D1::Point2F(points.back().x, midY));
                                 sink->EndFigure(D2D1_FIGURE_END_CLOSED);
-                                (void)sink->Close();
-
-                                // Gradient fill under the curve (adds depth without looking like a debug scope).
-                                if (resources.accentFillBrush) {
-                                    const float originalOpacity =
-                                        resources.accentFillBrush->GetOpacity();
-                                    resources.accentFillBrush->SetStartPoint(
-                                        D2D1::Point2F(0.0f, vizRect.top));
-                                    resources.accentFillBrush->SetEndPoint(
-                                        D2D1::Point2F(0.0f, vizRect.bottom));
-                                    resources.accentFillBrush->SetOpacity(
-                                        highlighted_ ? 1.0f : 0.75f);
-                                    resources.target->FillGeometry(geometry.Get(),
-                                                                   resources.accentFillBrush);
-                                    resources.accentFillBrush->SetOpacity(originalOpacity);
-                                } else {
-                                    const float originalOpacity = scopeBrush->GetOpacity();
-                                    scopeBrush->SetOpacity(highlighted_ ? 0.20f : 0.12f);
-                                    resources.target->FillGeometry(geometry.Get(), scopeBrush);
-                                    scopeBrush->SetOpacity(originalOpacity);
-                                }
+                            });
+                        if (geometry) {
+                            // Gradient fill under the curve (adds depth without looking like a debug scope).
+                            if (resources.accentFillBrush) {
+                                const float originalOpacity =
+                                    resources.accentFillBrush->GetOpacity();
+                                resources.accentFillBrush->SetStartPoint(
+                                    D2D1::Point2F(0.0f, vizRect.top));
+                                resources.accentFillBrush->SetEndPoint(
+                                    D2D1::Point2F(0.0f, vizRect.bottom));
+                                resources.accentFillBrush->SetOpacity(
+                                    highlighted_ ? 1.0f : 0.75f);
+                                resources.target->FillGeometry(geometry,
+                                                               resources.accentFillBrush);
+                                resources.accentFillBrush->SetOpacity(originalOpacity);
+                            } else {
+                                const float originalOpacity = scopeBrush->GetOpacity();
+                                scopeBrush->SetOpacity(highlighted_ ? 0.20f : 0.12f);
+                                resources.target->FillGeometry(geometry, scopeBrush);
+                                scopeBrush->SetOpacity(originalOpacity);
                             }
                         }
                     }
@@ -301,36 +307,30 @@ void ModulePreviewNode::draw(const RenderResources& resources) {
                     }
 
                     // Filled under-curve gradient (adds depth).
-                    if (resources.accentFillBrush) {
-                        Microsoft::WRL::ComPtr<ID2D1Factory> factory;
-                        resources.target->GetFactory(&factory);
-                        if (factory) {
-                            Microsoft::WRL::ComPtr<ID2D1PathGeometry> geometry;
-                            if (SUCCEEDED(factory->CreatePathGeometry(&geometry)) && geometry) {
-                                Microsoft::WRL::ComPtr<ID2D1GeometrySink> sink;
-                                if (SUCCEEDED(geometry->Open(&sink)) && sink) {
-                                    sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
-                                    sink->BeginFigure(D2D1::Point2F(points.front().x, vizRect.bottom),
-                                                      D2D1_FIGURE_BEGIN_FILLED);
-                                    for (const auto& p : points) {
-                                        sink->AddLine(p);
-                                    }
-                                    sink->AddLine(D2D1::Point2F(points.back().x, vizRect.bottom));
-                                    sink->EndFigure(D2D1_FIGURE_END_CLOSED);
-                                    (void)sink->Close();
-
-                                    const float originalOpacity =
-                                        resources.accentFillBrush->GetOpacity();
-                                    resources.accentFillBrush->SetStartPoint(
-                                        D2D1::Point2F(0.0f, vizRect.top));
-                                    resources.accentFillBrush->SetEndPoint(
-                                        D2D1::Point2F(0.0f, vizRect.bottom));
-                                    resources.accentFillBrush->SetOpacity(highlighted_ ? 1.0f : 0.75f);
-                                    resources.target->FillGeometry(geometry.Get(),
-                                                                   resources.accentFillBrush);
-                                    resources.accentFillBrush->SetOpacity(originalOpacity);
+                    if (resources.accentFillBrush && resources.cache) {
+                        const auto stamp =
+                            GeometryStamp().add(vizRect).add(tone).add(size).value();
+                        auto* geometry = resources.cache->geometry(
+                            this, kBodyFillSlot, stamp, [&](ID2D1GeometrySink* sink) {
+                                sink->SetFillMode(D2D1_FILL_MODE_ALTERNATE);
+                                sink->BeginFigure(D2D1::Point2F(points.front().x, vizRect.bottom),
+                                                  D2D1_FIGURE_BEGIN_FILLED);
+                                for (const auto& p : points) {
+                                    sink->AddLine(p);
                                 }
-                            }
+                                sink->AddLine(D2D1::Point2F(points.back().x, vizRect.bottom));
+                                sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+                            });
+                        if (geometry) {
+                            const float originalOpacity =
+                                resources.accentFillBrush->GetOpacity();
+                            resources.accentFillBrush->SetStartPoint(
+                                D2D1::Point2F(0.0f, vizRect.top));
+                            resources.accentFillBrush->SetEndPoint(
+                                D2D1::Point2F(0.0f, vizRect.bottom));
+                            resources.accentFillBrush->SetOpacity(highlighted_ ? 1.0f : 0.75f);
+                            resources.target->FillGeometry(geometry, resources.accentFillBrush);
+                            resources.accentFillBrush->SetOpacity(originalOpacity);
                         }
                     }
 
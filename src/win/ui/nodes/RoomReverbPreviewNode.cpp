@@ -1,15 +1,23 @@
 #include "win/ui/nodes/RoomReverbPreviewNode.h"
 
 #include <algorithm>
+#include <cwchar>
+#include <iterator>
 
 #include <d2d1helper.h>
 
+#include "win/ui/RenderCache.h"
+
 namespace winui {
 
 namespace {
 bool ContainsPoint(const D2D1_RECT_F& rect, float x, float y) {
     return x >= rect.left && x <= rect.right && y >= rect.top && y <= rect.bottom;
 }
+
+// The decay overlay spans 0 dB (top) to this level (bottom).
+constexpr float kDecayRangeDb = -60.0f;
+constexpr int kDecayCurveSlot = 0;
 }  // namespace
 
 RoomReverbPreviewNode::RoomReverbPreviewNode()
@@ -18,8 +26,15 @@ RoomReverbPreviewNode::RoomReverbPreviewNode()
 }
 
 void RoomReverbPreviewNode::setDiagramState(const FlowDiagramState& state) {
-    irSamples_ = state.roomIrPreviewSamples;
-    irWaveform_.setSamples(irSamples_);
+    // The preview views static data: same pointers, same IR.
+    const auto& next = state.roomIrPreview;
+    if (next.waveform == preview_.waveform && next.edcDb == preview_.edcDb) {
+        return;
+    }
+    preview_ = next;
+    irWaveform_.setSamples(
+        std::vector<float>(preview_.waveform, preview_.waveform + preview_.waveformCount));
+    invalidate();
 }
 
 void RoomReverbPreviewNode::arrange(const D2D1_RECT_F& bounds) {
@@ -78,7 +93,56 @@ void RoomReverbPreviewNode::draw(const RenderResources& resources) {
     if (ContainsPoint(bounds_, waveformRect_.left, waveformRect_.top)) {
         irWaveform_.setBounds(waveformRect_);
         irWaveform_.draw(resources.target, bg, grid, accent);
+        drawDecayOverlay(resources, text);
+    }
+}
+
+void RoomReverbPreviewNode::drawDecayOverlay(const RenderResources& resources,
+                                             ID2D1SolidColorBrush* brush) const {
+    const float w = waveformRect_.right - waveformRect_.left;
+    const float h = waveformRect_.bottom - waveformRect_.top;
+    if (preview_.envelopeCount < 2 || w <= 0.0f || h <= 0.0f) {
+        return;
     }
+
+    const float originalOpacity = brush->GetOpacity();
+    if (resources.cache) {
+        const auto stamp = GeometryStamp()
+                               .add(waveformRect_)
+                               .add(static_cast<std::uint64_t>(
+                                   reinterpret_cast<std::uintptr_t>(preview_.edcDb)))
+                               .value();
+        auto* geometry = resources.cache->geometry(
+            this, kDecayCurveSlot, stamp, [&](ID2D1GeometrySink* sink) {
+                const float step = w / static_cast<float>(preview_.envelopeCount - 1);
+                for (std::size_t i = 0; i < preview_.envelopeCount; ++i) {
+                    const float db = std::clamp(preview_.edcDb[i], kDecayRangeDb, 0.0f);
+                    const auto point = D2D1::Point2F(waveformRect_.left + step * static_cast<float>(i),
+                                                     waveformRect_.top + h * (db / kDecayRangeDb));
+                    if (i == 0) {
+                        sink->BeginFigure(point, D2D1_FIGURE_BEGIN_HOLLOW);
+                    } else {
+                        sink->AddLine(point);
+                    }
+                }
+                sink->EndFigure(D2D1_FIGURE_END_OPEN);
+            });
+        if (geometry) {
+            brush->SetOpacity(0.55f);
+            resources.target->DrawGeometry(geometry, brush, 1.2f);
+        }
+    }
+
+    if (preview_.rt60Seconds > 0.0f) {
+        wchar_t label[32];
+        std::swprintf(label, std::size(label), L"RT60 %.2f s", preview_.rt60Seconds);
+        const auto labelRect = D2D1::RectF(waveformRect_.right - 96.0f, waveformRect_.top + 2.0f,
+                                           waveformRect_.right - 4.0f, waveformRect_.top + 20.0f);
+        brush->SetOpacity(0.8f);
+        resources.target->DrawText(label, static_cast<UINT32>(std::wcslen(label)),
+                                   resources.textFormat, labelRect, brush);
+    }
+    brush->SetOpacity(originalOpacity);
 }
 
 bool RoomReverbPreviewNode::onPointerDown(float x, float y) {
@@ -101,5 +165,12 @@ void RoomReverbPreviewNode::onPointerUp() {
     }
 }
 
+void RoomReverbPreviewNode::collectDirty(DirtyRegion& region) {
+    UILayoutNode::collectDirty(region);
+    if (selector_) {
+        selector_->collectDirty(region);
+    }
+}
+
 }  // namespace winui
 
@@ -5,6 +5,7 @@
 
 #include <d2d1.h>
 
+#include "dsp/RoomIrLibrary.h"
 #include "win/ui/UIModel.h"
 #include "win/ui/WaveformView.h"
 #include "win/ui/layout/UILayoutNode.h"
@@ -12,7 +13,8 @@
 
 namespace winui {
 
-// Serum-like Room panel preview: dropdown (IR), waveform window (IR), knobs are below (outside this node).
+// Serum-like Room panel preview: dropdown (IR), waveform window (IR) with the
+// energy decay curve and RT60 over it; knobs are below (outside this node).
 class RoomReverbPreviewNode : public UILayoutNode {
 public:
     RoomReverbPreviewNode();
@@ -27,11 +29,15 @@ public:
     bool onPointerDown(float x, float y) override;
     bool onPointerMove(float x, float y) override;
     void onPointerUp() override;
+    void collectDirty(DirtyRegion& region) override;
 
 private:
     std::shared_ptr<DropdownSelectorNode> selector_;
+    void drawDecayOverlay(const RenderResources& resources,
+                          ID2D1SolidColorBrush* brush) const;
+
     WaveformView irWaveform_;
-    std::vector<float> irSamples_;
+    dsp::RoomIrLibrary::Preview preview_{};
 
     D2D1_RECT_F selectorRect_{};
     D2D1_RECT_F waveformRect_{};
@@ -104,6 +104,7 @@ void SliderPanelNode::syncSliders() {
             entry.slider->syncValue(entry.descriptor.getter());
         }
     }
+    invalidate();
 }
 
 }  // namespace winui
@@ -10,6 +10,14 @@ WaveformNode::WaveformNode() = default;
 
 void WaveformNode::setSamples(const std::vector<float>& samples) {
     view_.setSamples(samples);
+    invalidate();
+}
+
+void WaveformNode::setLiveSignal(const std::vector<float>& scope,
+                                 const std::vector<float>& spectrumDb) {
+    view_.setSamples(scope);
+    spectrumDb_ = spectrumDb;
+    invalidate();
 }
 
 float WaveformNode::preferredHeight(float) const {
@@ -21,9 +29,43 @@ void WaveformNode::draw(const RenderResources& resources) {
         !resources.accentBrush) {
         return;
     }
-    view_.setBounds(bounds_);
+    if (spectrumDb_.empty()) {
+        view_.setBounds(bounds_);
+        view_.draw(resources.target, resources.panelBrush, resources.gridBrush,
+                   resources.accentBrush);
+        return;
+    }
+    constexpr float kGap = 8.0f;
+    const float split = bounds_.left + (bounds_.right - bounds_.left) * 0.6f;
+    view_.setBounds(D2D1::RectF(bounds_.left, bounds_.top, split - kGap * 0.5f, bounds_.bottom));
     view_.draw(resources.target, resources.panelBrush, resources.gridBrush,
                resources.accentBrush);
+    drawSpectrum(resources,
+                 D2D1::RectF(split + kGap * 0.5f, bounds_.top, bounds_.right, bounds_.bottom));
+}
+
+void WaveformNode::drawSpectrum(const RenderResources& resources,
+                                const D2D1_RECT_F& rect) const {
+    // Bars span kFloorDb..0 dBFS.
+    constexpr float kFloorDb = -80.0f;
+    const float width = rect.right - rect.left;
+    const float height = rect.bottom - rect.top;
+    if (width <= 0.0f || height <= 0.0f) {
+        return;
+    }
+    resources.target->FillRectangle(rect, resources.panelBrush);
+    const float step = width / static_cast<float>(spectrumDb_.size());
+    const float barWidth = std::max(1.0f, step - 1.0f);
+    for (std::size_t i = 0; i < spectrumDb_.size(); ++i) {
+        const float level = std::clamp((spectrumDb_[i] - kFloorDb) / -kFloorDb, 0.0f, 1.0f);
+        if (level <= 0.0f) {
+            continue;
+        }
+        const float x = rect.left + step * static_cast<float>(i);
+        resources.target->FillRectangle(
+            D2D1::RectF(x, rect.bottom - height * level, x + barWidth, rect.bottom),
+            resources.accentBrush);
+    }
 }
 
 void WaveformNode::setBackgroundOpacity(float) {}
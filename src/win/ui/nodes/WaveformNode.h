@@ -12,13 +12,21 @@ public:
     WaveformNode();
 
     void setSamples(const std::vector<float>& samples);
+    // Live output: `scope` is traced on the left, `spectrumDb` (dBFS per
+    // log-spaced band) drawn as bars on the right. An empty spectrum gives
+    // the whole node to the trace again.
+    void setLiveSignal(const std::vector<float>& scope, const std::vector<float>& spectrumDb);
+    void setPreferredHeight(float height) { preferredHeight_ = height; }
     float preferredHeight(float width) const override;
     void draw(const RenderResources& resources) override;
 
     void setBackgroundOpacity(float opacity);
 
 private:
+    void drawSpectrum(const RenderResources& resources, const D2D1_RECT_F& rect) const;
+
     WaveformView view_;
+    std::vector<float> spectrumDb_;
     float preferredHeight_ = 200.0f;
 };
 
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "capi/satori.h"
+#include "engine/RealtimeCheck.h"
+
+TEST_CASE("C API 按名称查找参数且拒绝越界访问", "[c-api]") {
+    REQUIRE(satori_api_version() == SATORI_API_VERSION);
+    static_assert(sizeof(satori_event) == 40);
+
+    const int32_t gain = satori_find_param("MASTERGAIN");
+    REQUIRE(gain >= 0);
+    satori_param_info info{};
+    REQUIRE(satori_param_info_get(static_cast<uint32_t>(gain), &info));
+    REQUIRE(std::strcmp(info.name, "masterGain") == 0);
+    REQUIRE(info.max_value == 2.0f);
+    REQUIRE(satori_find_param("nope") == -1);
+    REQUIRE(satori_find_param(nullptr) == -1);
+    REQUIRE_FALSE(satori_param_info_get(satori_param_count(), &info));
+
+    REQUIRE(satori_create(0.0, 8, 1) == nullptr);
+    satori_engine* engine = satori_create(48000.0, 8, 2);
+    REQUIRE(engine != nullptr);
+    REQUIRE(satori_set_param(engine, 1, static_cast<uint32_t>(gain), 5.0f));
+    REQUIRE(satori_get_param(engine, 1, static_cast<uint32_t>(gain)) == 2.0f);
+    REQUIRE(satori_get_param(engine, 0, static_cast<uint32_t>(gain)) == 1.0f);
+    REQUIRE_FALSE(satori_set_param(engine, 2, static_cast<uint32_t>(gain), 1.0f));
+    REQUIRE_FALSE(satori_set_param(engine, 0, satori_param_count(), 1.0f));
+
+    satori_metrics metrics{};
+    REQUIRE_FALSE(satori_get_metrics(engine, &metrics));  // size not set
+    metrics.size = sizeof(metrics);
+    REQUIRE(satori_get_metrics(engine, &metrics));
+    REQUIRE(metrics.sample_rate == 48000.0);
+    REQUIRE(metrics.voice_limit == 8);
+    satori_destroy(engine);
+}
+
+TEST_CASE("C API 批量提交事件并原地渲染平面缓冲，渲染中不分配", "[c-api][realtime-safety]") {
+    REQUIRE(engine::RealtimeHooksInstalled());
+    satori_engine* engine = satori_create(48000.0, 16, 1);
+    REQUIRE(engine != nullptr);
+    satori_set_offline(engine, 1);
+
+    constexpr uint32_t kFrames = 256;
+    std::vector<float> left(kFrames, 1.0f);
+    std::vector<float> right(kFrames, 1.0f);
+    float* channels[] = {left.data(), right.data()};
+    // The first block sets up the room, which allocates.
+    satori_process(engine, channels, 2, kFrames);
+
+    // More events than one conversion run.
+    std::vector<satori_event> events(100);
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        satori_event& e = events[i];
+        e.type = i % 2 == 0 ? SATORI_EVENT_NOTE_ON : SATORI_EVENT_NOTE_OFF;
+        e.note_id = static_cast<int32_t>(i / 2);
+        e.offset = 100 + static_cast<uint32_t>(i / 2) * 4096 + (i % 2 == 0 ? 0 : 2048);
+        e.frequency = 110.0 + 10.0 * static_cast<double>(i);
+        e.velocity = 0.8f;
+    }
+    events.back().type = SATORI_EVENT_PARAM;
+    events.back().param = 99;  // no such parameter: refused with what follows
+    REQUIRE(satori_submit_events(engine, events.data(), events.size()) == events.size() - 1);
+
+    engine::ResetRealtimeViolations();
+    satori_process(engine, channels, 2, kFrames);
+    REQUIRE(engine::RealtimeViolationSnapshot().total() == 0);
+
+    // Written in place: silence before the first note, sound from its offset.
+    REQUIRE(std::all_of(left.begin(), left.begin() + 100, [](float s) { return s == 0.0f; }));
+    REQUIRE(std::any_of(left.begin() + 100, left.end(), [](float s) { return s != 0.0f; }));
+
+    // Submitting from the audio thread is as safe as rendering.
+    satori_event bend{};
+    bend.type = SATORI_EVENT_NOTE_EXPRESSION;
+    bend.note_id = 0;
+    bend.param = SATORI_EXPRESSION_PITCH_BEND;
+    bend.value = 2.0f;
+    {
+        engine::RealtimeScope realtime;
+        REQUIRE(satori_submit_events(engine, &bend, 1) == 1);
+        for (int block = 0; block < 8; ++block) {
+            satori_process(engine, channels, 2, kFrames);
+        }
+    }
+    REQUIRE(engine::RealtimeViolationSnapshot().total() == 0);
+
+    satori_metrics metrics{};
+    metrics.size = sizeof(metrics);
+    REQUIRE(satori_get_metrics(engine, &metrics));
+    REQUIRE(metrics.rendered_frames == 10 * kFrames);
+    REQUIRE(metrics.process_calls == 10);
+    REQUIRE(metrics.active_voices == 1);
+    REQUIRE(metrics.queued_events > 0);
+    REQUIRE(metrics.process_us_max >= metrics.process_us_p50);
+
+    // An older caller's smaller struct is filled only as far as it goes.
+    satori_metrics older{};
+    older.size = offsetof(satori_metrics, process_calls);
+    older.process_calls = 12345;
+    REQUIRE(satori_get_metrics(engine, &older));
+    REQUIRE(older.rendered_frames == 10 * kFrames);
+    REQUIRE(older.process_calls == 12345);
+
+    satori_reset(engine);
+    REQUIRE(satori_get_metrics(engine, &metrics));
+    REQUIRE(metrics.queued_events == 0);
+    satori_destroy(engine);
+}
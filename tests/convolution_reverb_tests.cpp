@@ -1,10 +1,24 @@
 #include <catch2/catch_amalgamated.hpp>
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
 
+#include "dsp/AlignedBuffer.h"
+#include "dsp/ComplexMac.h"
+#include "dsp/ConvolutionHead.h"
 #include "dsp/Fft.h"
 #include "dsp/PartitionedConvolver.h"
 #include "dsp/ConvolutionReverb.h"
+#include "dsp/Resampler.h"
+#include "dsp/RoomIrLibrary.h"
+#include "engine/RoomPartitionTuner.h"
+#include "engine/StringSynthEngine.h"
+#include "engine/VoiceRenderPool.h"
 
 TEST_CASE("FFT roundtrip preserves samples (approx)", "[dsp][fft]") {
     dsp::Fft fft(8);
@@ -21,6 +35,99 @@ TEST_CASE("FFT roundtrip preserves samples (approx)", "[dsp][fft]") {
     }
 }
 
+TEST_CASE("FFT matches a double-precision DFT at convolution sizes", "[dsp][fft]") {
+    for (const std::size_t n : {8u, 32u, 512u, 2048u}) {
+        std::vector<std::complex<float>> data(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            data[i] = std::complex<float>(std::sin(static_cast<float>(i) * 0.11f),
+                                          0.5f * std::cos(static_cast<float>(i) * 0.73f));
+        }
+        std::vector<std::complex<double>> reference(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            std::complex<double> sum = 0.0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const double angle = -2.0 * 3.14159265358979323846 *
+                                     static_cast<double>((i * k) % n) / static_cast<double>(n);
+                sum += std::complex<double>(data[i]) * std::polar(1.0, angle);
+            }
+            reference[k] = sum;
+        }
+
+        dsp::Fft fft(n);
+        fft.forward(data);
+        double maxError = 0.0;
+        for (std::size_t k = 0; k < n; ++k) {
+            maxError = std::max(maxError, std::abs(std::complex<double>(data[k]) - reference[k]));
+        }
+        // Table twiddles keep the error near float rounding even at 2048 points.
+        REQUIRE(maxError < 1e-7 * static_cast<double>(n));
+    }
+}
+
+TEST_CASE("Real FFT matches complex FFT half spectrum", "[dsp][fft]") {
+    for (const std::size_t n : {2u, 4u, 16u, 512u}) {
+        dsp::Fft fft(n);
+        REQUIRE(fft.realBins() == n / 2 + 1);
+
+        std::vector<float> input(n);
+        std::vector<std::complex<float>> reference(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            input[i] = std::sin(static_cast<float>(i) * 0.37f) + 0.25f * std::cos(static_cast<float>(i) * 1.9f);
+            reference[i] = std::complex<float>(input[i], 0.0f);
+        }
+        fft.forward(reference);
+
+        std::vector<std::complex<float>> spectrum(fft.realBins());
+        fft.forwardReal(input.data(), spectrum.data());
+        for (std::size_t k = 0; k < spectrum.size(); ++k) {
+            REQUIRE(spectrum[k].real() == Catch::Approx(reference[k].real()).margin(1e-3));
+            REQUIRE(spectrum[k].imag() == Catch::Approx(reference[k].imag()).margin(1e-3));
+        }
+
+        std::vector<float> roundtrip(n, 0.0f);
+        fft.inverseReal(spectrum.data(), roundtrip.data());
+        for (std::size_t i = 0; i < n; ++i) {
+            REQUIRE(roundtrip[i] == Catch::Approx(input[i]).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Configured FFT backend matches the built-in real transform", "[dsp][fft]") {
+    INFO("backend=" << dsp::Fft::backendName());
+    for (const std::size_t n : {16u, 512u, 2048u}) {
+        dsp::Fft native(n);
+        dsp::Fft builtIn(n, dsp::Fft::Backend::BuiltIn);
+        REQUIRE_FALSE(builtIn.usesExternalBackend());
+
+        std::vector<float> input(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            input[i] = std::sin(static_cast<float>(i) * 0.05f) * std::exp(-static_cast<float>(i) / 300.0f);
+        }
+        std::vector<std::complex<float>> a(native.realBins());
+        std::vector<std::complex<float>> b(builtIn.realBins());
+        native.forwardReal(input.data(), a.data());
+        builtIn.forwardReal(input.data(), b.data());
+        for (std::size_t k = 0; k < a.size(); ++k) {
+            REQUIRE(std::abs(a[k] - b[k]) < 1e-3f);
+        }
+
+        std::vector<float> outA(n), outB(n);
+        native.inverseReal(a.data(), outA.data());
+        builtIn.inverseReal(b.data(), outB.data());
+        for (std::size_t i = 0; i < n; ++i) {
+            REQUIRE(outA[i] == Catch::Approx(outB[i]).margin(1e-5));
+        }
+
+        // Copies get their own plan/scratch and stay usable.
+        dsp::Fft copy = native;
+        std::vector<std::complex<float>> c(copy.realBins());
+        copy.forwardReal(input.data(), c.data());
+        for (std::size_t k = 0; k < c.size(); ++k) {
+            REQUIRE(c[k] == a[k]);
+        }
+    }
+}
+
 TEST_CASE("Partitioned convolver reproduces IR for impulse input", "[dsp][convolution]") {
     const std::size_t block = 8;
     const std::size_t fftSize = 16;
@@ -30,7 +137,7 @@ TEST_CASE("Partitioned convolver reproduces IR for impulse input", "[dsp][convol
     const auto kernel = dsp::PartitionedConvolver::buildKernelFromIr(ir, block, fftSize);
 
     dsp::PartitionedConvolver conv;
-    conv.configure(block, fftSize, /*maxPartitions=*/kernel.partitions.size());
+    conv.configure(block, fftSize, /*maxPartitions=*/kernel.partitionCount);
     conv.reset();
 
     std::vector<float> in(block, 0.0f);
@@ -57,6 +164,198 @@ TEST_CASE("Partitioned convolver reproduces IR for impulse input", "[dsp][convol
     }
 }
 
+TEST_CASE("Partitioned convolver matches direct convolution across history wraps", "[dsp][convolution]") {
+    const std::size_t block = 16;
+    const std::size_t fftSize = 32;
+    std::vector<float> ir(block * 5 + 3);
+    for (std::size_t i = 0; i < ir.size(); ++i) {
+        ir[i] = std::cos(static_cast<float>(i) * 0.4f) * std::exp(-static_cast<float>(i) / 40.0f);
+    }
+    const auto kernel = dsp::PartitionedConvolver::buildKernelFromIr(ir, block, fftSize);
+    REQUIRE(kernel.partitionCount == 6);
+    REQUIRE(kernel.binStride % dsp::kAlignedFloats == 0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(kernel.partitionRe(1)) % 64 == 0);
+
+    dsp::PartitionedConvolver conv;
+    conv.configure(block, fftSize, kernel.partitionCount);
+
+    const std::size_t blocks = 20;
+    std::vector<float> input(block * blocks);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = std::sin(static_cast<float>(i) * 0.21f) + ((i % 7) == 0 ? 0.5f : 0.0f);
+    }
+    std::vector<float> out(block);
+    for (std::size_t b = 0; b < blocks; ++b) {
+        conv.pushInputBlock(input.data() + b * block);
+        conv.convolve(kernel, out.data());
+        for (std::size_t i = 0; i < block; ++i) {
+            const std::size_t n = b * block + i;
+            float expected = 0.0f;
+            for (std::size_t j = 0; j < ir.size() && j <= n; ++j) {
+                expected += ir[j] * input[n - j];
+            }
+            REQUIRE(out[i] == Catch::Approx(expected).margin(1e-4));
+        }
+    }
+}
+
+TEST_CASE("Complex MAC kernel matches scalar reference", "[dsp][convolution][simd]") {
+    INFO("kernel=" << dsp::ComplexMacName());
+    const std::size_t n = 37;  // Not a multiple of the vector width.
+    std::vector<float> xr(n), xi(n), hr(n), hi(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        xr[k] = std::sin(0.3f * static_cast<float>(k));
+        xi[k] = std::cos(0.7f * static_cast<float>(k));
+        hr[k] = 0.5f - 0.01f * static_cast<float>(k);
+        hi[k] = std::sin(1.1f * static_cast<float>(k) + 0.2f);
+    }
+    std::vector<float> refR(n, 0.25f), refI(n, -0.5f);
+    std::vector<float> accR = refR, accI = refI;
+    dsp::ComplexMacScalar(xr.data(), xi.data(), hr.data(), hi.data(), refR.data(),
+                          refI.data(), n);
+    dsp::GetComplexMac()(xr.data(), xi.data(), hr.data(), hi.data(), accR.data(),
+                         accI.data(), n);
+    for (std::size_t k = 0; k < n; ++k) {
+        REQUIRE(accR[k] == Catch::Approx(refR[k]).margin(1e-6));
+        REQUIRE(accI[k] == Catch::Approx(refI[k]).margin(1e-6));
+    }
+
+    // Stereo kernel: left uses h, right uses h conjugated and scaled.
+    std::vector<float> h2r(n), h2i(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        h2r[k] = 0.7f * hr[k];
+        h2i[k] = -0.7f * hi[k];
+    }
+    std::vector<float> ref2R(n, 0.1f), ref2I(n, 0.2f);
+    std::vector<float> accLr(n, 0.25f), accLi(n, -0.5f), accRr(n, 0.1f), accRi(n, 0.2f);
+    dsp::ComplexMacScalar(xr.data(), xi.data(), h2r.data(), h2i.data(), ref2R.data(),
+                          ref2I.data(), n);
+    dsp::GetComplexMacStereo()(xr.data(), xi.data(), hr.data(), hi.data(), h2r.data(),
+                               h2i.data(), accLr.data(), accLi.data(), accRr.data(),
+                               accRi.data(), n);
+    for (std::size_t k = 0; k < n; ++k) {
+        REQUIRE(accLr[k] == Catch::Approx(refR[k]).margin(1e-6));
+        REQUIRE(accLi[k] == Catch::Approx(refI[k]).margin(1e-6));
+        REQUIRE(accRr[k] == Catch::Approx(ref2R[k]).margin(1e-6));
+        REQUIRE(accRi[k] == Catch::Approx(ref2I[k]).margin(1e-6));
+    }
+}
+
+TEST_CASE("Stereo partitioned convolution matches two mono passes", "[dsp][convolution]") {
+    const std::size_t block = 16;
+    const std::size_t fftSize = 32;
+    // Unequal lengths: the right channel has two extra partitions.
+    std::vector<float> irL(block * 4), irR(block * 6);
+    for (std::size_t i = 0; i < irR.size(); ++i) {
+        if (i < irL.size()) {
+            irL[i] = std::sin(static_cast<float>(i) * 0.5f) * std::exp(-static_cast<float>(i) / 30.0f);
+        }
+        irR[i] = std::cos(static_cast<float>(i) * 0.3f) * std::exp(-static_cast<float>(i) / 50.0f);
+    }
+    const auto kernelL = dsp::PartitionedConvolver::buildKernelFromIr(irL, block, fftSize);
+    const auto kernelR = dsp::PartitionedConvolver::buildKernelFromIr(irR, block, fftSize);
+
+    dsp::PartitionedConvolver stereo;
+    dsp::PartitionedConvolver mono;
+    stereo.configure(block, fftSize, kernelR.partitionCount);
+    mono.configure(block, fftSize, kernelR.partitionCount);
+
+    std::vector<float> overlapL, overlapR, monoOverlapL, monoOverlapR;
+    std::vector<float> outL(block), outR(block), refL(block), refR(block);
+    for (std::size_t b = 0; b < 24; ++b) {
+        std::vector<float> input(block);
+        for (std::size_t i = 0; i < block; ++i) {
+            input[i] = std::sin(static_cast<float>(b * block + i) * 0.17f);
+        }
+        stereo.pushInputBlock(input.data());
+        mono.pushInputBlock(input.data());
+        stereo.convolveStereoWithOverlap(kernelL, kernelR, outL.data(), outR.data(), overlapL,
+                                         overlapR);
+        mono.convolveWithOverlap(kernelL, refL.data(), monoOverlapL);
+        mono.convolveWithOverlap(kernelR, refR.data(), monoOverlapR);
+        for (std::size_t i = 0; i < block; ++i) {
+            REQUIRE(outL[i] == Catch::Approx(refL[i]).margin(1e-5));
+            REQUIRE(outR[i] == Catch::Approx(refR[i]).margin(1e-5));
+        }
+    }
+}
+
+TEST_CASE("FloatArena carves cache-line aligned buffers from one block", "[dsp][reverb]") {
+    dsp::FloatArena arena;
+    const auto carve = [&](std::vector<std::span<float>>& out) {
+        out.clear();
+        for (const std::size_t count : {256u, 3u, 0u, 1000u}) {
+            out.push_back(arena.take(count));
+        }
+    };
+    std::vector<std::span<float>> buffers;
+    arena.release();
+    carve(buffers);
+    REQUIRE(std::all_of(buffers.begin(), buffers.end(), [](auto b) { return b.empty(); }));
+    const std::size_t floats = arena.used();
+    REQUIRE(floats == 256 + dsp::kAlignedFloats + 1008);
+
+    arena.allocate(floats);
+    carve(buffers);
+    REQUIRE(arena.used() == floats);
+    REQUIRE(buffers[0].size() == 256);
+    REQUIRE(buffers[1].size() == 3);
+    REQUIRE(buffers[2].empty());
+    REQUIRE(buffers[3].size() == 1000);
+    for (const auto& b : buffers) {
+        if (!b.empty()) {
+            REQUIRE(reinterpret_cast<std::uintptr_t>(b.data()) % 64 == 0);
+            REQUIRE(std::all_of(b.begin(), b.end(), [](float v) { return v == 0.0f; }));
+        }
+    }
+    buffers[3].back() = 1.0f;
+    arena.zero();
+    REQUIRE(buffers[3].back() == 0.0f);
+    REQUIRE(arena.take(1).empty());  // used up
+}
+
+TEST_CASE("StereoDecorrelator blocks match the per-sample delay line", "[dsp][reverb]") {
+    // Per-sample reference: R = 0.6 * mono[n-7] + 0.4 * lp(mono[n-19]).
+    std::vector<float> ring(64, 0.0f);
+    std::size_t pos = 0;
+    float lp = 0.0f;
+    const auto reference = [&](float l, float r, bool enabled, float& outL, float& outR) {
+        const float mono = 0.5f * (l + r);
+        ring[pos] = mono;
+        const float tapShort = ring[(pos + 64 - 7) % 64];
+        lp = 0.25f * ring[(pos + 64 - 19) % 64] + 0.75f * lp;
+        outL = enabled ? mono : l;
+        outR = enabled ? 0.6f * tapShort + 0.4f * lp : r;
+        pos = (pos + 1) % 64;
+    };
+
+    dsp::StereoDecorrelator decorrelator;
+    std::uint32_t seed = 12345;
+    const auto noise = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+    };
+    // Blocks shorter than the taps, longer than a chunk, and toggling.
+    int block = 0;
+    for (const std::size_t frames : {1u, 5u, 19u, 256u, 300u, 3u, 600u, 128u}) {
+        const bool enabled = block++ % 3 != 1;
+        std::vector<float> l(frames);
+        std::vector<float> r(frames);
+        for (std::size_t i = 0; i < frames; ++i) {
+            l[i] = noise();
+            r[i] = noise();
+        }
+        std::vector<float> expectL(frames);
+        std::vector<float> expectR(frames);
+        for (std::size_t i = 0; i < frames; ++i) {
+            reference(l[i], r[i], enabled, expectL[i], expectR[i]);
+        }
+        decorrelator.processBlock(l.data(), r.data(), enabled, l.data(), r.data(), frames);
+        REQUIRE(l == expectL);
+        REQUIRE(r == expectR);
+    }
+}
+
 TEST_CASE("ConvolutionReverb mix=0 passes dry", "[dsp][reverb]") {
     const std::size_t block = 8;
     const std::size_t fftSize = 16;
@@ -116,3 +415,667 @@ TEST_CASE("ConvolutionReverb stereo IR produces stereo wet", "[dsp][reverb]") {
         }
     }
 }
+
+TEST_CASE("PartitionLayout leaves every tail stage its spreading lead", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({128, 512, 2048, 8192});
+    REQUIRE(layout.valid());
+    REQUIRE(layout.offsets == std::vector<std::size_t>{0, 768, 3840, 16128});
+
+    // Non-ascending or non power-of-two entries are dropped.
+    const auto sanitized = dsp::PartitionLayout::FromBlockSizes({256, 1000, 128, 1024});
+    REQUIRE(sanitized.blockSizes == std::vector<std::size_t>{256, 1024});
+    REQUIRE(sanitized.offsets == std::vector<std::size_t>{0, 1536});
+}
+
+TEST_CASE("Non-uniform ConvolutionReverb matches direct convolution", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+
+    // Long enough to reach the last stage with several partitions.
+    const std::size_t irLength = 1500;
+    std::vector<float> irL(irLength), irR(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        const float decay = std::exp(-static_cast<float>(i) / 400.0f);
+        irL[i] = decay * std::sin(static_cast<float>(i) * 0.31f);
+        irR[i] = decay * std::cos(static_cast<float>(i) * 0.17f);
+    }
+    std::vector<dsp::StereoConvolutionKernel> kernels;
+    kernels.push_back(layout.buildKernel(irL.data(), irR.data(), irLength));
+    REQUIRE(kernels.front().tailLeft.size() == 2);
+
+    dsp::ConvolutionReverb reverb;
+    reverb.setPartitionLayout(layout);
+    reverb.setIrKernels(std::move(kernels));
+
+    const std::size_t blocks = 160;
+    std::vector<float> input(block * blocks);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = ((i * 7919u) % 113u) / 56.0f - 1.0f;
+    }
+
+    std::vector<float> wetL(block), wetR(block);
+    const float wetLevel = 0.25f;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        reverb.processBlockWet(input.data() + b * block, wetL.data(), wetR.data());
+        for (std::size_t i = 0; i < block; ++i) {
+            const std::size_t n = b * block + i;
+            double expectedL = 0.0;
+            double expectedR = 0.0;
+            for (std::size_t j = 0; j < irLength && j <= n; ++j) {
+                expectedL += static_cast<double>(irL[j]) * input[n - j];
+                expectedR += static_cast<double>(irR[j]) * input[n - j];
+            }
+            REQUIRE(wetL[i] == Catch::Approx(wetLevel * expectedL).margin(2e-3));
+            REQUIRE(wetR[i] == Catch::Approx(wetLevel * expectedR).margin(2e-3));
+        }
+    }
+}
+
+TEST_CASE("ConvolutionReverb kernels filled in after setup use the reserved history", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 1200;
+    std::vector<float> ir(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        ir[i] = std::exp(-static_cast<float>(i) / 300.0f) * std::sin(static_cast<float>(i) * 0.23f);
+    }
+
+    dsp::ConvolutionReverb reverb;
+    reverb.setPartitionLayout(layout);
+    reverb.setIrKernels(std::vector<dsp::StereoConvolutionKernel>(2), irLength);
+    REQUIRE(reverb.irCount() == 2);
+    REQUIRE_FALSE(reverb.hasIrKernel(0));
+    reverb.setIrKernel(0, layout.buildKernel(ir.data(), nullptr, irLength));
+    REQUIRE(reverb.hasIrKernel(0));
+    REQUIRE_FALSE(reverb.hasIrKernel(1));
+
+    const std::size_t blocks = 120;
+    std::vector<float> input(block * blocks);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = ((i * 7919u) % 113u) / 56.0f - 1.0f;
+    }
+    std::vector<float> wetL(block), wetR(block);
+    for (std::size_t b = 0; b < blocks; ++b) {
+        reverb.processBlockWet(input.data() + b * block, wetL.data(), wetR.data());
+        for (std::size_t i = 0; i < block; ++i) {
+            const std::size_t n = b * block + i;
+            double expected = 0.0;
+            for (std::size_t j = 0; j < irLength && j <= n; ++j) {
+                expected += static_cast<double>(ir[j]) * input[n - j];
+            }
+            REQUIRE(wetL[i] == Catch::Approx(dsp::ConvolutionReverb::kWetLevel * expected).margin(2e-3));
+        }
+    }
+
+    const auto released = reverb.releaseIrKernels();
+    REQUIRE(released.size() == 2);
+    REQUIRE(reverb.irCount() == 0);
+}
+
+TEST_CASE("ConvolutionReverb instances convolve with one shared kernel", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 900;
+    std::vector<float> ir(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        ir[i] = std::exp(-static_cast<float>(i) / 250.0f) * std::cos(static_cast<float>(i) * 0.17f);
+    }
+    const auto shared = std::make_shared<const dsp::StereoConvolutionKernel>(
+        layout.buildKernel(ir.data(), nullptr, irLength));
+
+    dsp::ConvolutionReverb owned;
+    dsp::ConvolutionReverb a;
+    dsp::ConvolutionReverb b;
+    owned.setPartitionLayout(layout);
+    owned.setIrKernels({layout.buildKernel(ir.data(), nullptr, irLength)});
+    for (auto* reverb : {&a, &b}) {
+        reverb->setPartitionLayout(layout);
+        reverb->setIrKernels(std::vector<dsp::SharedConvolutionKernel>{shared});
+    }
+    REQUIRE(shared.use_count() == 3);
+
+    std::vector<float> input(block);
+    std::vector<float> ownedL(block), ownedR(block), aL(block), aR(block), bL(block), bR(block);
+    for (std::size_t n = 0; n < 80; ++n) {
+        for (std::size_t i = 0; i < block; ++i) {
+            input[i] = std::sin(static_cast<float>(n * block + i) * 0.05f);
+        }
+        owned.processBlockWet(input.data(), ownedL.data(), ownedR.data());
+        a.processBlockWet(input.data(), aL.data(), aR.data());
+        b.processBlockWet(input.data(), bL.data(), bR.data());
+        REQUIRE(aL == ownedL);
+        REQUIRE(aR == ownedR);
+        REQUIRE(bL == ownedL);
+    }
+
+    // Released kernels are the shared ones, not copies.
+    const auto released = a.releaseIrKernels();
+    REQUIRE(released.size() == 1);
+    REQUIRE(released[0] == shared);
+    b.setIrKernels(std::vector<dsp::SharedConvolutionKernel>{});
+    REQUIRE(shared.use_count() == 2);
+}
+
+TEST_CASE("ConvolutionReverb idles through silence and resumes exactly", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 1500;
+    std::vector<float> irL(irLength), irR(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        const float decay = std::exp(-static_cast<float>(i) / 400.0f);
+        irL[i] = decay * std::sin(static_cast<float>(i) * 0.31f);
+        irR[i] = decay * std::cos(static_cast<float>(i) * 0.17f);
+    }
+    std::vector<dsp::StereoConvolutionKernel> kernels;
+    kernels.push_back(layout.buildKernel(irL.data(), irR.data(), irLength));
+
+    dsp::ConvolutionReverb reverb;
+    reverb.setPartitionLayout(layout);
+    reverb.setIrKernels(std::move(kernels));
+
+    // Burst, a gap long enough for the tail to ring out, then a burst that
+    // starts mid-chunk for the tail stages.
+    const std::size_t burstBlocks = 20;
+    const std::size_t resumeBlock = burstBlocks + irLength / block + 45;
+    const std::size_t blocks = resumeBlock + 120;
+    std::vector<float> input(block * blocks, 0.0f);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        const std::size_t b = i / block;
+        if (b < burstBlocks || b >= resumeBlock) {
+            input[i] = ((i * 7919u) % 113u) / 56.0f - 1.0f;
+        }
+    }
+
+    std::vector<float> wetL(block), wetR(block);
+    bool wentIdle = false;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        reverb.processBlockWet(input.data() + b * block, wetL.data(), wetR.data());
+        wentIdle = wentIdle || reverb.idle();
+        if (b == resumeBlock - 1) {
+            REQUIRE(reverb.idle());
+        }
+        if (b >= resumeBlock) {
+            REQUIRE_FALSE(reverb.idle());
+        }
+        for (std::size_t i = 0; i < block; ++i) {
+            const std::size_t n = b * block + i;
+            double expectedL = 0.0;
+            double expectedR = 0.0;
+            for (std::size_t j = 0; j < irLength && j <= n; ++j) {
+                expectedL += static_cast<double>(irL[j]) * input[n - j];
+                expectedR += static_cast<double>(irR[j]) * input[n - j];
+            }
+            REQUIRE(wetL[i] == Catch::Approx(0.25 * expectedL).margin(2e-3));
+            REQUIRE(wetR[i] == Catch::Approx(0.25 * expectedR).margin(2e-3));
+        }
+    }
+    REQUIRE(wentIdle);
+}
+
+TEST_CASE("Non-uniform ConvolutionReverb settles on the new IR after a switch", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 900;
+
+    std::vector<std::vector<float>> irs(2, std::vector<float>(irLength));
+    for (std::size_t i = 0; i < irLength; ++i) {
+        const float decay = std::exp(-static_cast<float>(i) / 250.0f);
+        irs[0][i] = decay * std::sin(static_cast<float>(i) * 0.23f);
+        irs[1][i] = decay * std::cos(static_cast<float>(i) * 0.41f);
+    }
+    std::vector<dsp::StereoConvolutionKernel> kernels;
+    for (const auto& ir : irs) {
+        kernels.push_back(layout.buildKernel(ir.data(), ir.data(), irLength));
+    }
+
+    dsp::ConvolutionReverb reverb;
+    reverb.setPartitionLayout(layout);
+    reverb.setIrKernels(std::move(kernels));
+
+    const std::size_t switchBlock = 37;  // mid-chunk for both tail stages
+    const std::size_t settledBlock = switchBlock + 16 + irLength / block + 1;
+    const std::size_t blocks = settledBlock + 40;
+    std::vector<float> input(block * blocks);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = std::sin(static_cast<float>(i) * 0.07f) + ((i % 29u) == 0 ? 0.8f : 0.0f);
+    }
+
+    std::vector<float> wetL(block), wetR(block);
+    for (std::size_t b = 0; b < blocks; ++b) {
+        if (b == switchBlock) {
+            reverb.setIrIndex(1);
+        }
+        reverb.processBlockWet(input.data() + b * block, wetL.data(), wetR.data());
+        if (b < settledBlock) {
+            continue;
+        }
+        REQUIRE(reverb.irIndex() == 1);
+        for (std::size_t i = 0; i < block; ++i) {
+            const std::size_t n = b * block + i;
+            double expected = 0.0;
+            for (std::size_t j = 0; j < irLength && j <= n; ++j) {
+                expected += static_cast<double>(irs[1][j]) * input[n - j];
+            }
+            REQUIRE(wetL[i] == Catch::Approx(0.25 * expected).margin(2e-3));
+        }
+    }
+}
+
+TEST_CASE("RingOut IR switch lets the old IR ring out on earlier input", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 900;
+
+    std::vector<std::vector<float>> irs(3, std::vector<float>(irLength));
+    for (std::size_t i = 0; i < irLength; ++i) {
+        const float decay = std::exp(-static_cast<float>(i) / 250.0f);
+        irs[0][i] = decay * std::sin(static_cast<float>(i) * 0.23f);
+        irs[1][i] = decay * std::cos(static_cast<float>(i) * 0.41f);
+        irs[2][i] = decay * std::sin(static_cast<float>(i) * 0.67f);
+    }
+    std::vector<dsp::StereoConvolutionKernel> kernels;
+    for (const auto& ir : irs) {
+        kernels.push_back(layout.buildKernel(ir.data(), nullptr, irLength));
+    }
+
+    dsp::ConvolutionReverb reverb;
+    reverb.setPartitionLayout(layout);
+    reverb.setCrossfadeMode(dsp::IrCrossfade::RingOut);
+    reverb.setIrKernels(std::move(kernels));
+
+    const std::size_t switchBlock = 37;  // mid-chunk for both tail stages
+    const std::size_t doneBlock = switchBlock + irLength / block + 20;
+    const std::size_t blocks = doneBlock + 40;
+    std::vector<float> input(block * blocks);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = std::sin(static_cast<float>(i) * 0.07f) + ((i % 29u) == 0 ? 0.8f : 0.0f);
+    }
+
+    // Input before the switch keeps the old IR, input after it gets the new.
+    const std::size_t switchSample = switchBlock * block;
+    std::vector<float> wetL(block), wetR(block);
+    for (std::size_t b = 0; b < blocks; ++b) {
+        if (b == switchBlock) {
+            reverb.setIrIndex(1);
+        }
+        reverb.processBlockWet(input.data() + b * block, wetL.data(), wetR.data());
+        for (std::size_t i = 0; i < block; ++i) {
+            const std::size_t n = b * block + i;
+            double expected = 0.0;
+            for (std::size_t j = 0; j < irLength && j <= n; ++j) {
+                const auto& ir = (n - j) < switchSample ? irs[0] : irs[1];
+                expected += static_cast<double>(ir[j]) * input[n - j];
+            }
+            REQUIRE(wetL[i] == Catch::Approx(0.25 * expected).margin(2e-3));
+        }
+    }
+    REQUIRE(reverb.irIndex() == 1);
+
+    // A switch during a ring-out fades the rest of it and then rings out
+    // the IR it interrupted.
+    reverb.setIrIndex(2);
+    reverb.setIrIndex(0);
+    for (std::size_t b = 0; b < 16 + irLength / block + 20; ++b) {
+        reverb.processBlockWet(input.data() + b * block, wetL.data(), wetR.data());
+        for (float v : wetL) {
+            REQUIRE(std::isfinite(v));
+        }
+    }
+    REQUIRE(reverb.irIndex() == 0);
+}
+
+TEST_CASE("ConvolutionReverb split across a pool matches the serial tail", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 24000;  // several partitions per tail slice
+    std::vector<float> irL(irLength), irR(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        const float decay = std::exp(-static_cast<float>(i) / 6000.0f);
+        irL[i] = decay * std::sin(static_cast<float>(i) * 0.31f);
+        irR[i] = decay * std::cos(static_cast<float>(i) * 0.17f);
+    }
+    const auto kernel = layout.buildKernel(irL.data(), irR.data(), irLength);
+    const auto swapped = layout.buildKernel(irR.data(), irL.data(), irLength);
+
+    engine::VoiceRenderPool pool(2);
+    const auto runOnPool = [](void* runner, dsp::ParallelJob job, void* context,
+                              std::size_t jobs) {
+        static_cast<engine::VoiceRenderPool*>(runner)->run(job, context, jobs);
+    };
+
+    dsp::ConvolutionReverb serial;
+    dsp::ConvolutionReverb parallel;
+    dsp::ConvolutionReverb rerun;
+    for (auto* reverb : {&serial, &parallel, &rerun}) {
+        reverb->setPartitionLayout(layout);
+        reverb->setIrKernels({kernel, swapped});
+    }
+    parallel.setParallelism(3, runOnPool, &pool);
+    rerun.setParallelism(3, runOnPool, &pool);
+    REQUIRE(parallel.parallelJobs() == 3);
+    REQUIRE(serial.parallelJobs() == 1);
+
+    const std::size_t blocks = 1800;
+    std::vector<float> input(block * blocks);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = ((i * 7919u) % 113u) / 56.0f - 1.0f;
+    }
+    std::vector<float> serialL(block), serialR(block), parallelL(block), parallelR(block);
+    std::vector<float> first;
+    for (std::size_t b = 0; b < blocks; ++b) {
+        if (b == 900) {
+            serial.setIrIndex(1);
+            parallel.setIrIndex(1);
+        }
+        serial.processBlockWet(input.data() + b * block, serialL.data(), serialR.data());
+        parallel.processBlockWet(input.data() + b * block, parallelL.data(), parallelR.data());
+        for (std::size_t i = 0; i < block; ++i) {
+            REQUIRE(parallelL[i] == Catch::Approx(serialL[i]).margin(1e-4));
+            REQUIRE(parallelR[i] == Catch::Approx(serialR[i]).margin(1e-4));
+        }
+        first.insert(first.end(), parallelL.begin(), parallelL.end());
+    }
+
+    // Partials are summed in job order, so a rerun is bit-identical.
+    for (std::size_t b = 0; b < blocks; ++b) {
+        if (b == 900) {
+            rerun.setIrIndex(1);
+        }
+        rerun.processBlockWet(input.data() + b * block, parallelL.data(), parallelR.data());
+        REQUIRE(std::equal(parallelL.begin(), parallelL.end(),
+                           first.begin() + static_cast<std::ptrdiff_t>(b * block)));
+    }
+}
+
+TEST_CASE("PartitionLayout builds the same kernel across a pool", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t irLength = 9000;
+    std::vector<float> irL(irLength), irR(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        const float decay = std::exp(-static_cast<float>(i) / 3000.0f);
+        irL[i] = decay * std::sin(static_cast<float>(i) * 0.23f);
+        irR[i] = decay * std::cos(static_cast<float>(i) * 0.41f);
+    }
+    engine::VoiceRenderPool pool(2);
+    const auto runOnPool = [](void* runner, dsp::ParallelJob job, void* context,
+                              std::size_t jobs) {
+        static_cast<engine::VoiceRenderPool*>(runner)->run(job, context, jobs);
+    };
+    const auto same = [](const dsp::ConvolutionKernel& a, const dsp::ConvolutionKernel& b) {
+        REQUIRE(a.partitionCount == b.partitionCount);
+        REQUIRE(a.binStride == b.binStride);
+        for (std::size_t p = 0; p < a.partitionCount; ++p) {
+            REQUIRE(std::equal(a.partitionRe(p), a.partitionRe(p) + a.binStride, b.partitionRe(p)));
+            REQUIRE(std::equal(a.partitionIm(p), a.partitionIm(p) + a.binStride, b.partitionIm(p)));
+        }
+    };
+    for (const float* right : {static_cast<const float*>(irR.data()),
+                               static_cast<const float*>(nullptr)}) {
+        const auto serial = layout.buildKernel(irL.data(), right, irLength);
+        const auto pooled = layout.buildKernel(irL.data(), right, irLength, runOnPool, &pool);
+        REQUIRE(pooled.isStereo == serial.isStereo);
+        same(pooled.left, serial.left);
+        same(pooled.right, serial.right);
+        REQUIRE(pooled.tailLeft.size() == serial.tailLeft.size());
+        REQUIRE(pooled.tailRight.size() == serial.tailRight.size());
+        for (std::size_t s = 0; s < serial.tailLeft.size(); ++s) {
+            same(pooled.tailLeft[s], serial.tailLeft[s]);
+        }
+        for (std::size_t s = 0; s < serial.tailRight.size(); ++s) {
+            same(pooled.tailRight[s], serial.tailRight[s]);
+        }
+    }
+}
+
+TEST_CASE("ConvolutionHead matches direct convolution with no latency", "[dsp][reverb]") {
+    const std::size_t headLength = 640;  // FIR taps + four partitioned blocks
+    const std::size_t irLength = 900;    // longer than the head: the rest is ignored
+    std::vector<float> irL(irLength), irR(irLength);
+    for (std::size_t i = 0; i < irLength; ++i) {
+        irL[i] = std::exp(-static_cast<float>(i) / 200.0f) * std::sin(static_cast<float>(i) * 0.9f);
+        irR[i] = std::exp(-static_cast<float>(i) / 150.0f) * std::cos(static_cast<float>(i) * 0.3f);
+    }
+
+    dsp::ConvolutionHead head(headLength, 256);
+    REQUIRE(head.headLength() == headLength);
+    head.addIr(irL.data(), irR.data(), irLength);
+    head.addIr(irL.data(), nullptr, irLength);
+    REQUIRE(head.isStereo(0));
+    REQUIRE_FALSE(head.isStereo(1));
+
+    const std::size_t frames = 3000;
+    std::vector<float> input(frames);
+    for (std::size_t i = 0; i < frames; ++i) {
+        input[i] = (i == 0) ? 1.0f : std::sin(static_cast<float>(i) * 0.05f) * 0.5f;
+    }
+    for (std::size_t n = 0; n < frames; ++n) {
+        float outL = 0.0f;
+        float outR = 0.0f;
+        head.process(input[n], outL, outR);
+        double expectedL = 0.0;
+        double expectedR = 0.0;
+        for (std::size_t j = 0; j < headLength && j <= n; ++j) {
+            expectedL += static_cast<double>(irL[j]) * input[n - j];
+            expectedR += static_cast<double>(irR[j]) * input[n - j];
+        }
+        REQUIRE(outL == Catch::Approx(expectedL).margin(1e-3));
+        REQUIRE(outR == Catch::Approx(expectedR).margin(1e-3));
+    }
+
+    // Mono IR after the switch settles: both channels carry the left head.
+    head.setIrIndex(1);
+    for (std::size_t n = 0; n < 256 + headLength; ++n) {
+        float outL = 0.0f;
+        float outR = 0.0f;
+        head.process(input[n], outL, outR);
+    }
+    REQUIRE_FALSE(head.crossfading());
+    float outL = 0.0f;
+    float outR = 0.0f;
+    head.process(0.25f, outL, outR);
+    REQUIRE(outL == outR);
+}
+
+TEST_CASE("Precomputed room IR kernels match runtime-built kernels", "[dsp][reverb]") {
+    // Only present with SATORI_PRECOMPUTED_IR_KERNELS; otherwise every lookup
+    // comes back empty and the checks below are skipped.
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({256, 1024, 4096});
+    const std::size_t skip = 1536;
+    const auto& list = dsp::RoomIrLibrary::list();
+    for (std::size_t i = 0; i < list.size(); ++i) {
+        const int index = static_cast<int>(i);
+        const auto ir = dsp::RoomIrLibrary::samples(index);
+        REQUIRE(dsp::RoomIrLibrary::precomputedKernel(
+                    index, ir.sampleRate, dsp::PartitionLayout::FromBlockSizes({128, 512}), skip)
+                    .left.empty());
+
+        const auto compare = [](const dsp::ConvolutionKernel& a, const dsp::ConvolutionKernel& b) {
+            REQUIRE(a.partitionCount == b.partitionCount);
+            REQUIRE(a.binStride == b.binStride);
+            for (std::size_t p = 0; p < a.partitionCount; ++p) {
+                for (std::size_t k = 0; k < a.binStride; ++k) {
+                    REQUIRE(a.partitionRe(p)[k] == Catch::Approx(b.partitionRe(p)[k]).margin(1e-3));
+                    REQUIRE(a.partitionIm(p)[k] == Catch::Approx(b.partitionIm(p)[k]).margin(1e-3));
+                }
+            }
+        };
+        // The IR's own rate involves no resampling; other rates check that the
+        // generator mirrors dsp::PolyphaseResampler.
+        for (const int rate : {ir.sampleRate, 44100}) {
+            const auto pre = dsp::RoomIrLibrary::precomputedKernel(index, rate, layout, skip);
+            if (pre.left.empty()) {
+                continue;
+            }
+            const dsp::PolyphaseResampler resampler(ir.sampleRate, rate);
+            const auto left = resampler.process(ir.left, ir.frameCount);
+            std::vector<float> right;
+            if (pre.isStereo) {
+                right = resampler.process(ir.right, ir.frameCount);
+            }
+            if (left.size() <= skip) {
+                continue;
+            }
+            const auto built = layout.buildKernel(left.data() + skip,
+                                                  pre.isStereo ? right.data() + skip : nullptr,
+                                                  left.size() - skip);
+            compare(pre.left, built.left);
+            REQUIRE(pre.tailLeft.size() == built.tailLeft.size());
+            for (std::size_t s = 0; s < pre.tailLeft.size(); ++s) {
+                compare(pre.tailLeft[s], built.tailLeft[s]);
+            }
+            if (pre.isStereo) {
+                compare(pre.right, built.right);
+            }
+        }
+    }
+}
+
+TEST_CASE("Partition tuner times valid candidates and caches its pick", "[dsp][reverb][tuning]") {
+    const auto candidates = engine::PartitionCandidates(256, 20000);
+    REQUIRE(std::find(candidates.begin(), candidates.end(),
+                      std::vector<std::size_t>{256, 1024, 4096}) != candidates.end());
+    for (const auto& blockSizes : candidates) {
+        REQUIRE(blockSizes.front() == 256);
+        REQUIRE(blockSizes.size() >= 2);
+        REQUIRE(blockSizes.size() <= 4);
+        REQUIRE(blockSizes.back() <= 16384);
+        REQUIRE(dsp::PartitionLayout::FromBlockSizes(blockSizes).valid());
+    }
+
+    const auto timed = engine::TimePartitionLayout({256, 1024}, 8192);
+    REQUIRE(timed.meanUs > 0.0);
+    REQUIRE(timed.worstUs >= 0.0);
+    REQUIRE(engine::TimePartitionLayout({256, 1000}, 8192).meanUs == 0.0);
+
+    engine::PartitionTuneRequest request;
+    request.irFrames = 8192;
+    const auto best = engine::TunePartitionLayout(request);
+    const auto small = engine::PartitionCandidates(256, 8192);
+    REQUIRE(std::find(small.begin(), small.end(), best.blockSizes) != small.end());
+    REQUIRE(best.meanUs > 0.0);
+
+    const auto path = std::filesystem::temp_directory_path() / "satori_partition_cache_test.txt";
+    std::filesystem::remove(path);
+    engine::PartitionTuneCache cache;
+    REQUIRE(cache.load(path));
+    const auto key = engine::PartitionTuneCache::Key(48000, 256, 256, 8192);
+    REQUIRE(key != engine::PartitionTuneCache::Key(48000, 512, 256, 8192));
+    REQUIRE(key != engine::PartitionTuneCache::Key(48000, 256, 128, 8192));
+    REQUIRE(key != engine::PartitionTuneCache::Key(48000, 256, 256, 8192, true));
+    cache.store(key, best.blockSizes);
+    std::string error;
+    REQUIRE(cache.save(path, error));
+    engine::PartitionTuneCache reloaded;
+    REQUIRE(reloaded.load(path));
+    REQUIRE(reloaded.find(key) != nullptr);
+    REQUIRE(*reloaded.find(key) == best.blockSizes);
+    REQUIRE(reloaded.find(engine::PartitionTuneCache::Key(44100, 256, 256, 8192)) == nullptr);
+    std::filesystem::remove(path);
+
+    // Layouts the room cannot run are refused whether or not a room exists.
+    REQUIRE_FALSE(engine::StringSynthEngine::SetRoomPartitionLayout({32, 128}));
+    REQUIRE_FALSE(engine::StringSynthEngine::SetRoomPartitionLayout({2048, 8192}));
+    REQUIRE_FALSE(engine::StringSynthEngine::SetRoomPartitionLayout({256, 1000, 4096}));
+    REQUIRE(engine::StringSynthEngine::RoomPartitionBlockSizes().front() == 256);
+}
+
+TEST_CASE("Room block profiles follow the device buffer", "[dsp][reverb][tuning]") {
+    using engine::RoomBlockProfile;
+    using engine::StringSynthEngine;
+    using Sizes = std::vector<std::size_t>;
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Balanced, 64) ==
+            Sizes{256, 1024, 4096});
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Balanced, 0) ==
+            StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Balanced, 2048));
+    // Low latency: the buffer rounded down, from 64 to 128 frames.
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::LowLatency, 32).front() ==
+            64);
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::LowLatency, 96) ==
+            Sizes{64, 256, 1024});
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::LowLatency, 1024).front() ==
+            128);
+    // Efficient: the buffer rounded up, from 512 to 1024 frames.
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Efficient, 128).front() ==
+            512);
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Efficient, 768) ==
+            Sizes{1024, 4096, 16384});
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Efficient, 4096).front() ==
+            1024);
+    // Offline starts from the balanced layout; only its tuning differs.
+    REQUIRE(StringSynthEngine::RoomProfileBlockSizes(RoomBlockProfile::Offline, 4096) ==
+            Sizes{256, 1024, 4096});
+    for (const auto profile : {RoomBlockProfile::LowLatency, RoomBlockProfile::Balanced,
+                               RoomBlockProfile::Efficient, RoomBlockProfile::Offline}) {
+        for (const std::uint32_t buffer : {0u, 32u, 64u, 128u, 256u, 512u, 1024u, 4096u}) {
+            const auto sizes = StringSynthEngine::RoomProfileBlockSizes(profile, buffer);
+            REQUIRE(dsp::PartitionLayout::FromBlockSizes(sizes).valid());
+            REQUIRE(sizes.front() >= StringSynthEngine::kMinRoomBlockFrames);
+            REQUIRE(sizes.front() <= StringSynthEngine::kMaxRoomBlockFrames);
+        }
+    }
+
+    // The head covers kRoomLeadBlocks blocks, so smaller blocks leave more tail.
+    const std::size_t tail64 = StringSynthEngine::RoomTailFrames(48000, 64);
+    const std::size_t tail256 = StringSynthEngine::RoomTailFrames(48000, 256);
+    REQUIRE(tail64 - tail256 == StringSynthEngine::kRoomLeadBlocks * (256 - 64));
+}
+
+TEST_CASE("ConvolutionReverb adopts published kernel sets at a block boundary", "[dsp][reverb]") {
+    const auto layout = dsp::PartitionLayout::FromBlockSizes({16, 64, 256});
+    const std::size_t block = layout.baseBlockSize();
+    const std::size_t irLength = 1000;
+    const auto makeKernel = [&](float rate) {
+        std::vector<float> ir(irLength);
+        for (std::size_t i = 0; i < irLength; ++i) {
+            ir[i] = std::exp(-static_cast<float>(i) / 200.0f) * std::sin(static_cast<float>(i) * rate);
+        }
+        return std::make_shared<const dsp::StereoConvolutionKernel>(
+            layout.buildKernel(ir.data(), nullptr, irLength));
+    };
+    const auto first = makeKernel(0.21f);
+    const auto second = makeKernel(0.37f);
+    const auto replacement = makeKernel(0.05f);
+
+    dsp::ConvolutionReverb reverb;
+    dsp::ConvolutionReverb reference;
+    for (auto* r : {&reverb, &reference}) {
+        r->setPartitionLayout(layout);
+        r->setIrKernels(std::vector<dsp::SharedConvolutionKernel>{first, second}, irLength);
+    }
+
+    std::vector<float> input(block), wetL(block), wetR(block), refL(block), refR(block);
+    std::size_t n = 0;
+    const auto run = [&](std::size_t blocks) {
+        for (std::size_t b = 0; b < blocks; ++b, ++n) {
+            for (std::size_t i = 0; i < block; ++i) {
+                input[i] = std::sin(static_cast<float>(n * block + i) * 0.09f);
+            }
+            reverb.processBlockWet(input.data(), wetL.data(), wetR.data());
+            reference.processBlockWet(input.data(), refL.data(), refR.data());
+            REQUIRE(wetL == refL);
+            REQUIRE(wetR == refR);
+        }
+    };
+    run(20);
+
+    // Replacing the IR that is not playing leaves the tail untouched.
+    std::thread publisher([&] {
+        reverb.publishIrKernels(std::vector<dsp::SharedConvolutionKernel>{first, replacement},
+                                irLength);
+    });
+    publisher.join();
+    run(20);
+    REQUIRE(reverb.irKernels()[1] == replacement);
+    REQUIRE(second.use_count() == 3);  // this test, the reference and the retired set
+    reverb.releaseRetiredIrKernels();
+    REQUIRE(second.use_count() == 2);
+
+    // Replacing the playing IR restarts the tail on the new kernel.
+    reverb.publishIrKernels(std::vector<dsp::SharedConvolutionKernel>{replacement, second},
+                            irLength);
+    REQUIRE(reverb.adoptPublishedIrKernels());
+    REQUIRE_FALSE(reverb.adoptPublishedIrKernels());
+    reference.setIrKernels(std::vector<dsp::SharedConvolutionKernel>{replacement, second},
+                           irLength);
+    run(20);
+}
@@ -1,12 +1,56 @@
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <random>
+#include <thread>
 #include <vector>
 
 #include <catch2/catch_amalgamated.hpp>
 
+#include "audio/MidiFile.h"
+#include "audio/OscPacket.h"
+#include "audio/SampleConvert.h"
+#include "audio/WaveReader.h"
+#include "audio/WaveWriter.h"
+#include "dsp/Denormals.h"
+#include "dsp/FastMath.h"
+#include "dsp/Filter.h"
+#include "dsp/FixedBlockStream.h"
+#include "dsp/Resampler.h"
+#include "dsp/FdnReverb.h"
+#include "dsp/Halfband.h"
+#include "dsp/ModalBody.h"
+#include "dsp/NoiseGenerator.h"
+#include "dsp/RoomIrLibrary.h"
+#include "dsp/SpectrumAnalyzer.h"
+#include "dsp/SympatheticStrings.h"
+#include "engine/AdaptiveTailDelay.h"
+#include "engine/AmpEnvelope.h"
+#include "engine/HostFrameClock.h"
+#include "engine/LatencyHistogram.h"
+#include "engine/MemoryUsage.h"
+#include "engine/MidiFilePlayer.h"
+#include "engine/OscControl.h"
+#include "engine/OutputRecorder.h"
+#include "engine/QualityGovernor.h"
+#include "engine/RealtimeThread.h"
+#include "engine/ScopeTap.h"
 #include "engine/StringSynthEngine.h"
+#include "engine/Tracer.h"
+#include "synthesis/ExcitationPool.h"
 #include "synthesis/KarplusStrongString.h"
 #include "synthesis/KarplusStrongSynth.h"
+#include "synthesis/StringPreviewRenderer.h"
 
 namespace {
 
@@ -160,6 +204,227 @@ TEST_CASE("KarplusStrongSynth 可混合多音并归一化", "[ks-synth]") {
     REQUIRE(maxSample <= Catch::Approx(1.0f).epsilon(0.001f));
 }
 
+TEST_CASE("KarplusStrongSynth 分块流式渲染与整段渲染一致", "[ks-synth]") {
+    std::vector<synthesis::NoteEvent> notes;
+    for (int i = 0; i < 12; ++i) {
+        notes.push_back({110.0 * (1.0 + 0.25 * i), 0.6, 0.013 * i});
+    }
+
+    // How loud the stacked plucks sum depends on the noise draw; the seeds
+    // land on both sides of full scale.
+    for (const std::uint32_t seed : {77u, 5u, 1u}) {
+        CAPTURE(seed);
+        synthesis::StringConfig config;
+        config.sampleRate = 44100.0;
+        config.decay = 0.995f;
+        config.seed = seed;
+        synthesis::KarplusStrongSynth synth(config);
+
+        std::vector<float> raw;
+        std::size_t largestBlock = 0;
+        const std::size_t frames = synth.renderNotes(
+            notes,
+            [&](const float* samples, std::size_t count) {
+                largestBlock = std::max(largestBlock, count);
+                raw.insert(raw.end(), samples, samples + count);
+            },
+            false);
+        REQUIRE(frames == raw.size());
+        REQUIRE(frames == static_cast<std::size_t>(std::floor((0.013 * 11 + 0.6) * 44100.0)));
+        REQUIRE(largestBlock == synthesis::KarplusStrongSynth::kRenderBlockFrames);
+
+        // Normalisation only brings peaks above 1 down to 1.
+        const float rawPeak = maxAbs(raw);
+        REQUIRE(rawPeak > 0.0f);
+        const float gain = rawPeak > 1.0f ? 1.0f / rawPeak : 1.0f;
+
+        const auto normalized = synth.renderNotes(notes);
+        REQUIRE(normalized.size() == raw.size());
+        REQUIRE(maxAbs(normalized) == Catch::Approx(std::min(rawPeak, 1.0f)).epsilon(1.0e-5));
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < raw.size(); ++i) {
+            if (normalized[i] != raw[i] * gain) {
+                ++mismatches;
+            }
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("KarplusStrongSynth 异步渲染可报告进度并取消", "[ks-synth][threads]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 44100.0;
+    config.seed = 5u;
+    synthesis::KarplusStrongSynth synth(config);
+    std::vector<synthesis::NoteEvent> notes;
+    for (int i = 0; i < 6; ++i) {
+        notes.push_back({110.0 * (1.0 + 0.5 * i), 0.5, 0.05 * i});
+    }
+    const auto expected = synth.renderNotes(notes);
+
+    // The caller's executor: here one thread per task.
+    std::vector<std::thread> threads;
+    const synthesis::KarplusStrongSynth::Executor executor =
+        [&threads](std::function<void()> task) { threads.emplace_back(std::move(task)); };
+
+    std::vector<float> streamed;
+    auto job = synth.renderAsync(
+        notes,
+        [&streamed](const float* samples, std::size_t frames) {
+            streamed.insert(streamed.end(), samples, samples + frames);
+        },
+        executor);
+    REQUIRE(job);
+    REQUIRE(job.result().get() == expected.size());
+    REQUIRE(job.finished());
+    REQUIRE_FALSE(job.cancelled());
+    REQUIRE(job.progress() == 1.0);
+    REQUIRE(streamed == expected);
+
+    // Cancelled from its own sink after the first block: nothing more
+    // arrives and the result counts only what did.
+    synthesis::KarplusStrongSynth::RenderJob cancelled;
+    std::size_t blocks = 0;
+    std::atomic<bool> started{false};
+    cancelled = synth.renderAsync(
+        notes,
+        [&](const float*, std::size_t) {
+            while (!started.load()) {
+                std::this_thread::yield();
+            }
+            ++blocks;
+            cancelled.cancel();
+        },
+        executor, false);
+    started = true;
+    REQUIRE(cancelled.result().get() == synthesis::KarplusStrongSynth::kRenderBlockFrames);
+    REQUIRE(blocks == 1);
+    REQUIRE(cancelled.cancelled());
+    REQUIRE(cancelled.progress() == 1.0);
+
+    // No executor: the job has run by the time renderAsync() returns.
+    std::size_t inlineFrames = 0;
+    const auto inlineJob = synth.renderAsync(
+        notes, [&](const float*, std::size_t frames) { inlineFrames += frames; }, {});
+    REQUIRE(inlineJob.finished());
+    REQUIRE(inlineFrames == expected.size());
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST_CASE("KarplusStrongSynth 多线程离线渲染与单线程输出一致", "[ks-synth][threads]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 48000.0;
+    config.seed = 4242u;
+    config.excitationMode = synthesis::ExcitationMode::RandomNoisePick;
+
+    std::vector<synthesis::NoteEvent> notes;
+    for (int i = 0; i < 20; ++i) {
+        notes.push_back({82.41 * std::pow(2.0, i / 5.0), 0.25 + 0.01 * i, 0.021 * i});
+    }
+
+    const auto single = synthesis::KarplusStrongSynth(config).renderNotes(notes);
+    const auto threaded = synthesis::KarplusStrongSynth(config, 3).renderNotes(notes);
+    REQUIRE(single.size() == threaded.size());
+    REQUIRE(single == threaded);
+    REQUIRE(maxAbs(single) > 0.0f);
+}
+
+TEST_CASE("KarplusStrongSynth 重复音符只渲染一次且输出不变", "[ks-synth]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 44100.0;
+    config.seed = 99u;
+    config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    const auto raw = [](const synthesis::KarplusStrongSynth& synth,
+                        const std::vector<synthesis::NoteEvent>& notes) {
+        std::vector<float> out;
+        synth.renderNotes(
+            notes, [&](const float* samples, std::size_t count) {
+                out.insert(out.end(), samples, samples + count);
+            },
+            false);
+        return out;
+    };
+
+    // One string, rendered alone, is what every repeat must hear.
+    const auto longest = raw(synthesis::KarplusStrongSynth(config), {{196.0, 0.5, 0.0}});
+    const auto other = raw(synthesis::KarplusStrongSynth(config), {{293.66, 0.2, 0.0}});
+    // Repeats overlap, start off the block grid and a later one outlasts
+    // the first, so the shared string is extended part-way.
+    const std::vector<synthesis::NoteEvent> notes = {
+        {196.0, 0.2, 0.0}, {293.66, 0.2, 0.01}, {196.0, 0.3, 0.0537}, {196.0, 0.5, 0.131},
+    };
+    std::vector<float> expected(static_cast<std::size_t>(std::floor(0.131 * 44100.0)) +
+                                    longest.size(),
+                                0.0f);
+    // Summed in note order, as the synth mixes.
+    const auto add = [&](const std::vector<float>& note, double start, double duration) {
+        const auto offset = static_cast<std::size_t>(std::floor(start * 44100.0));
+        const auto frames = static_cast<std::size_t>(std::floor(duration * 44100.0));
+        for (std::size_t i = 0; i < frames; ++i) {
+            expected[offset + i] += note[i];
+        }
+    };
+    add(longest, 0.0, 0.2);
+    add(other, 0.01, 0.2);
+    add(longest, 0.0537, 0.3);
+    add(longest, 0.131, 0.5);
+
+    const auto mixed = raw(synthesis::KarplusStrongSynth(config), notes);
+    REQUIRE(mixed.size() == expected.size());
+    REQUIRE(mixed == expected);
+    REQUIRE(raw(synthesis::KarplusStrongSynth(config, 2), notes) == expected);
+
+    // Normalised renders hear the same strings in both passes.
+    const auto normalized = synthesis::KarplusStrongSynth(config).renderNotes(notes);
+    REQUIRE(maxAbs(normalized) <= 1.0f);
+    REQUIRE(normalized.size() == expected.size());
+}
+
+TEST_CASE("KarplusStrongSynth 静音阈值提前结束衰减完的音符", "[ks-synth]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 44100.0;
+    config.seed = 21u;
+    config.decay = 0.95f;
+    const std::vector<synthesis::NoteEvent> notes = {
+        {330.0, 4.0, 0.0}, {330.0, 4.0, 0.25}, {247.0, 4.0, 0.1},
+    };
+    const auto raw = [&](float threshold, std::size_t& frames) {
+        synthesis::KarplusStrongSynth synth(config);
+        synth.setSilenceThreshold(threshold);
+        std::vector<float> out;
+        frames = synth.renderNotes(
+            notes, [&](const float* samples, std::size_t count) {
+                out.insert(out.end(), samples, samples + count);
+            },
+            false);
+        return out;
+    };
+
+    std::size_t fullFrames = 0;
+    std::size_t trimmedFrames = 0;
+    const auto full = raw(0.0f, fullFrames);
+    const auto trimmed = raw(1e-4f, trimmedFrames);
+    REQUIRE(fullFrames == static_cast<std::size_t>(std::floor(4.25 * 44100.0)));
+    REQUIRE(trimmedFrames == trimmed.size());
+    REQUIRE(trimmedFrames < fullFrames / 2);
+    // Until a string stops, the render is the full one; what is cut is below
+    // the threshold.
+    REQUIRE(trimmedFrames % synthesis::KarplusStrongSynth::kRenderBlockFrames == 0);
+    float cutPeak = 0.0f;
+    for (std::size_t i = trimmedFrames; i < fullFrames; ++i) {
+        cutPeak = std::max(cutPeak, std::abs(full[i]));
+    }
+    REQUIRE(cutPeak < 3e-4f);
+    std::size_t differences = 0;
+    for (std::size_t i = 0; i < trimmedFrames; ++i) {
+        differences += std::abs(trimmed[i] - full[i]) < 3e-4f ? 0 : 1;
+    }
+    REQUIRE(differences == 0);
+    REQUIRE(maxAbs(trimmed) > 0.1f);
+}
+
 TEST_CASE("KarplusStrongString 具备可调分数延迟以便精确调律",
           "[ks-string][tuning]") {
     synthesis::StringConfig config;
@@ -187,6 +452,240 @@ TEST_CASE("KarplusStrongString 具备可调分数延迟以便精确调律",
     REQUIRE(std::abs(cents) < 5.0);
 }
 
+TEST_CASE("KarplusStrongString 发声中更新参数时原位重调滤波器", "[ks-string][tuning]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 48000.0;
+    config.decay = 0.999f;
+    config.dispersionAmount = 0.3f;
+    config.brightness = 0.35f;
+    config.seed = 321u;
+    config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    const double targetHz = 330.0;
+    constexpr std::size_t kFrames = 24000;
+    constexpr std::size_t kSplit = 4000;
+
+    synthesis::KarplusStrongString reference(config);
+    synthesis::KarplusStrongString updated(config);
+    reference.start(targetHz);
+    updated.start(targetHz);
+    std::vector<float> expected(kFrames);
+    std::vector<float> actual(kFrames);
+    reference.processBlock(expected.data(), kFrames);
+    updated.processBlock(actual.data(), kSplit);
+    // Unchanged settings must not disturb the sounding loop.
+    updated.updateConfig(config);
+    updated.processBlock(actual.data() + kSplit, kFrames - kSplit);
+    REQUIRE(actual == expected);
+
+    // A brighter loop has less lowpass delay; the tuning allpass makes up
+    // for it so the pitch holds.
+    synthesis::StringConfig brighter = config;
+    brighter.brightness = 0.8f;
+    synthesis::KarplusStrongString modulated(config);
+    modulated.start(targetHz);
+    std::vector<float> head(kSplit);
+    modulated.processBlock(head.data(), kSplit);
+    modulated.updateConfig(brighter);
+    std::vector<float> tail(kFrames);
+    modulated.processBlock(tail.data(), kFrames);
+    REQUIRE(std::all_of(tail.begin(), tail.end(), [](float v) { return std::isfinite(v); }));
+    const double estimatedHz = estimateFundamentalAutocorr(tail, config.sampleRate, targetHz);
+    const double cents = 1200.0 * std::log2(estimatedHz / targetHz);
+    INFO("estimatedHz=" << estimatedHz << " cents=" << cents);
+    REQUIRE(std::abs(cents) < 5.0);
+}
+
+TEST_CASE("KarplusStrongString 发声中滑音改变延迟长度并保持音准", "[ks-string][tuning]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 48000.0;
+    config.decay = 0.9995f;
+    config.brightness = 0.6f;
+    config.seed = 9u;
+    config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+
+    // Bend a semitone down and two back up, 64 frames per step; the rail
+    // length crosses several integer periods on the way.
+    synthesis::KarplusStrongString string(config);
+    string.start(220.0);
+    std::vector<float> block(64);
+    const double startHz = 220.0;
+    const double endHz = 220.0 * std::pow(2.0, 1.0 / 12.0);
+    for (int step = 0; step <= 150; ++step) {
+        const double t = step / 150.0;
+        const double semitones = t < 1.0 / 3.0 ? -3.0 * t : -1.0 + 3.0 * (t - 1.0 / 3.0);
+        string.setFrequency(startHz * std::pow(2.0, std::min(semitones, 1.0) / 12.0));
+        string.processBlock(block.data(), block.size());
+        REQUIRE(std::all_of(block.begin(), block.end(), [](float v) { return std::isfinite(v); }));
+    }
+    string.setFrequency(endHz);
+
+    std::vector<float> tail(24000);
+    string.processBlock(tail.data(), tail.size());
+    REQUIRE(maxAbs(tail) > 1e-3f);
+    const double estimatedHz = estimateFundamentalAutocorr(tail, config.sampleRate, endHz);
+    const double cents = 1200.0 * std::log2(estimatedHz / endHz);
+    INFO("estimatedHz=" << estimatedHz << " cents=" << cents);
+    REQUIRE(std::abs(cents) < 5.0);
+
+    // Bent to a pitch, the loop rings like a note started there.
+    synthesis::KarplusStrongString direct(config);
+    direct.start(endHz);
+    std::vector<float> reference(tail.size());
+    direct.processBlock(reference.data(), reference.size());
+    const double directHz = estimateFundamentalAutocorr(reference, config.sampleRate, endHz);
+    REQUIRE(std::abs(1200.0 * std::log2(estimatedHz / directHz)) < 2.0);
+}
+
+TEST_CASE("KarplusStrongString 激励噪声按种子可复现且随机模式每次不同", "[ks-string][excitation]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 48000.0;
+    config.excitationMix = 1.0f;
+    config.excitationBrightness = 0.0f;  // Raw noise, no colour filter.
+    config.excitationVelocity = 0.0f;
+    config.seed = 99u;
+
+    auto burst = [](synthesis::KarplusStrongString& string) {
+        string.start(110.0);
+        return string.excitationBufferPreview();
+    };
+
+    config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    synthesis::KarplusStrongString fixedA(config);
+    synthesis::KarplusStrongString fixedB(config);
+    const auto first = burst(fixedA);
+    REQUIRE(first.size() > 100);
+    REQUIRE(burst(fixedA) == first);
+    REQUIRE(burst(fixedB) == first);
+
+    config.excitationMode = synthesis::ExcitationMode::RandomNoisePick;
+    synthesis::KarplusStrongString random(config);
+    const auto a = burst(random);
+    const auto b = burst(random);
+    REQUIRE(a != b);
+    REQUIRE(std::all_of(a.begin(), a.end(), [](float v) { return std::abs(v) <= 1.0f; }));
+    REQUIRE(maxAbs(a) > 0.1f);
+}
+
+TEST_CASE("ScopedDenormalsDisable 在作用域内把次正规数冲刷为零", "[dsp][denormals]") {
+    // volatile keeps the products at run time, under the thread's FP mode.
+    volatile float tiny = std::numeric_limits<float>::min();
+    volatile float half = 0.5f;
+    const float before = tiny * half;
+    REQUIRE(before != 0.0f);
+#if defined(SATORI_DENORMALS_SSE) || defined(SATORI_DENORMALS_ARM64)
+    {
+        dsp::ScopedDenormalsDisable guard;
+        const float flushed = tiny * half;
+        CHECK(flushed == 0.0f);
+    }
+    {
+        // Every DSP thread's setup includes the same guard.
+        const engine::ScopedDspThread dspThread("denormals test");
+        const float flushed = tiny * half;
+        CHECK(flushed == 0.0f);
+    }
+#endif
+    const float after = tiny * half;
+    CHECK(after == before);
+}
+
+TEST_CASE("NoiseGenerator 分块生成按种子可复现且分布正确", "[dsp][excitation]") {
+    std::vector<float> a(100003);
+    std::vector<float> b(a.size());
+    dsp::NoiseGenerator first(42u);
+    dsp::NoiseGenerator second(42u);
+    first.fillUniform(a.data(), a.size());
+    second.fillUniform(b.data(), b.size());
+    REQUIRE(a == b);
+    REQUIRE(first.nextSeed() == second.nextSeed());
+    REQUIRE(std::all_of(a.begin(), a.end(), [](float v) { return v >= -1.0f && v < 1.0f; }));
+    double mean = 0.0;
+    double power = 0.0;
+    for (const float v : a) {
+        mean += v;
+        power += static_cast<double>(v) * v;
+    }
+    REQUIRE(std::abs(mean / static_cast<double>(a.size())) < 0.01);
+    REQUIRE(power / static_cast<double>(a.size()) == Catch::Approx(1.0 / 3.0).epsilon(0.01));
+
+    std::vector<float> binary(1001);
+    dsp::NoiseGenerator(7u).fillBinary(binary.data(), binary.size());
+    REQUIRE(std::all_of(binary.begin(), binary.end(),
+                        [](float v) { return v == 1.0f || v == -1.0f; }));
+    REQUIRE(std::abs(std::accumulate(binary.begin(), binary.end(), 0.0f)) < 150.0f);
+
+    dsp::NoiseGenerator other(43u);
+    other.fillUniform(b.data(), b.size());
+    REQUIRE(a != b);
+}
+
+TEST_CASE("KarplusStrongString 固定噪声激励复用缓存且与重新生成一致", "[ks-string][excitation]") {
+    for (const auto type : {synthesis::ExcitationType::Pluck, synthesis::ExcitationType::Hammer}) {
+        synthesis::StringConfig config;
+        config.sampleRate = 48000.0;
+        config.seed = 21u;
+        config.excitationType = type;
+        config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        config.excitationVelocity = 1.0f;
+
+        // Alternating velocities and notes move the pick position, colour and
+        // length, so the cached shape must only be reused for exact repeats.
+        synthesis::KarplusStrongString strummed(config);
+        const std::pair<double, float> hits[] = {
+            {110.0, 0.8f}, {110.0, 0.8f}, {110.0, 0.3f}, {147.0, 0.3f}, {110.0, 0.8f}};
+        for (const auto& [frequency, velocity] : hits) {
+            strummed.start(frequency, velocity);
+            synthesis::KarplusStrongString fresh(config);
+            fresh.start(frequency, velocity);
+            REQUIRE(strummed.excitationBufferPreview() == fresh.excitationBufferPreview());
+        }
+    }
+}
+
+TEST_CASE("KarplusStrongString 随机激励从预备池取用并在用后补充", "[ks-string][excitation]") {
+    for (const auto type : {synthesis::ExcitationType::Pluck, synthesis::ExcitationType::Hammer}) {
+        synthesis::StringConfig config;
+        config.sampleRate = 48000.0;
+        config.excitationType = type;
+        config.excitationVelocity = 1.0f;
+        config.excitationMix = 0.7f;
+
+        constexpr unsigned int kPoolSeed = 5u;
+        synthesis::ExcitationPool pool(kPoolSeed);
+        synthesis::KarplusStrongString pooled(config);
+        pooled.setExcitationPool(&pool);
+
+        // The worker shapes from its own seed chain with the velocity snapped
+        // to a bucket: a seeded string without a pool gives the same bursts.
+        synthesis::StringConfig reference = config;
+        reference.seed = kPoolSeed;
+        synthesis::KarplusStrongString expected(reference);
+        const float snapped = synthesis::ExcitationPool::SnapVelocity(0.7f);
+        REQUIRE(snapped != 0.7f);
+
+        pooled.start(220.0, 0.7f);  // miss: shaped inline, slot requested
+        pool.waitIdle();
+        REQUIRE(pool.readyCount() == 1);
+        for (int note = 0; note < 2; ++note) {
+            pooled.start(220.0, 0.7f);
+            expected.start(220.0, snapped);
+            REQUIRE(pooled.excitationBufferPreview() == expected.excitationBufferPreview());
+            pool.waitIdle();  // refilled with the next burst
+            REQUIRE(pool.readyCount() == 1);
+        }
+
+        // A set seed asks for repeatable noise, so the pool is left alone.
+        synthesis::KarplusStrongString seeded(reference);
+        seeded.setExcitationPool(&pool);
+        seeded.start(330.0, 0.7f);
+        synthesis::KarplusStrongString unpooled(reference);
+        unpooled.start(330.0, 0.7f);
+        REQUIRE(seeded.excitationBufferPreview() == unpooled.excitationBufferPreview());
+        pool.waitIdle();
+        REQUIRE(pool.readyCount() == 1);
+    }
+}
+
 TEST_CASE("String Loop 频散模块在极端参数下保持稳定", "[ks-string][dispersion]") {
     auto renderWithConfig = [](const synthesis::StringConfig& cfg, double freq,
                                std::size_t frames) {
@@ -254,304 +753,4187 @@ TEST_CASE("String Loop 在关闭低通时仍保持稳定", "[ks-string][dispersi
     REQUIRE(peak < 2.5f);
 }
 
-TEST_CASE("Body 模块在极端参数下保持有限增益", "[engine-body]") {
-    const double sampleRate = 44100.0;
+TEST_CASE("KarplusStrongString processBlock 与逐样本输出一致", "[ks-string][block]") {
+    auto compare = [](synthesis::ExcitationType type, float dispersion, bool lowpass) {
+        synthesis::StringConfig config;
+        config.sampleRate = 48000.0;
+        config.decay = 0.997f;
+        config.dispersionAmount = dispersion;
+        config.enableLowpass = lowpass;
+        config.seed = 77u;
+        config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        config.excitationType = type;
 
-    auto toFrames = [sampleRate](double seconds) {
-        return static_cast<std::uint64_t>(
-            std::max(0.0, std::round(seconds * sampleRate)));
-    };
+        synthesis::KarplusStrongString reference(config);
+        synthesis::KarplusStrongString blocked(config);
+        reference.start(196.0, 0.8f);
+        blocked.start(196.0, 0.8f);
 
-    auto renderWithTone = [&](float tone, float size) {
-        engine::StringSynthEngine engine;
-        engine.setSampleRate(sampleRate);
-        engine.setParam(engine::ParamId::AmpRelease, 0.08f);
-        engine.setParam(engine::ParamId::BodyTone, tone);
-        engine.setParam(engine::ParamId::BodySize, size);
-        engine::Event on{};
-        on.type = engine::EventType::NoteOn;
-        on.noteId = 1;
-        on.frequency = 196.0;
-        on.velocity = 0.9f;
-        on.frameOffset = 0;
+        const std::size_t totalFrames = 6000;
+        std::vector<float> expected(totalFrames);
+        for (auto& v : expected) {
+            v = reference.processSample();
+        }
 
-        engine::Event off{};
-        off.type = engine::EventType::NoteOff;
-        off.noteId = 1;
-        off.frameOffset = toFrames(0.12);
+        // Odd block sizes cross both the hammer contact and delay-line wrap.
+        std::vector<float> actual(totalFrames, 0.0f);
+        std::size_t done = 0;
+        std::size_t blockSize = 1;
+        while (done < totalFrames) {
+            const std::size_t n = std::min(blockSize, totalFrames - done);
+            blocked.processBlock(actual.data() + done, n);
+            done += n;
+            blockSize = blockSize * 3 + 1;
+        }
 
-        const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.4);
-        return renderEngineSequence(engine, {on, off}, totalFrames);
+        for (std::size_t i = 0; i < totalFrames; ++i) {
+            INFO("frame=" << i);
+            REQUIRE(actual[i] == expected[i]);
+        }
+        REQUIRE(blocked.lastOutput() == reference.lastOutput());
     };
 
-    auto neutral = renderWithTone(0.5f, 0.5f);
-    auto bright = renderWithTone(1.0f, 1.0f);
-    auto warm = renderWithTone(0.0f, 0.2f);
+    // Every loop filter topology has its own specialised block kernel.
+    for (const float dispersion : {0.0f, 0.4f}) {
+        for (const bool lowpass : {true, false}) {
+            compare(synthesis::ExcitationType::Pluck, dispersion, lowpass);
+            compare(synthesis::ExcitationType::Hammer, dispersion, lowpass);
+        }
+    }
+}
 
-    REQUIRE(std::all_of(neutral.begin(), neutral.end(),
-                        [](float v) { return std::isfinite(v); }));
-    REQUIRE(std::all_of(bright.begin(), bright.end(),
-                        [](float v) { return std::isfinite(v); }));
-    REQUIRE(std::all_of(warm.begin(), warm.end(),
-                        [](float v) { return std::isfinite(v); }));
+TEST_CASE("KarplusStrongString 多弦 SIMD 并行渲染与逐弦一致", "[ks-string][block][simd]") {
+    struct Setup {
+        double freq;
+        float dispersion;
+        bool lowpass;
+        synthesis::ExcitationType type;
+    };
+    const std::vector<Setup> setups = {
+        {82.41, 0.0f, true, synthesis::ExcitationType::Pluck},
+        {196.0, 0.6f, true, synthesis::ExcitationType::Pluck},
+        {440.0, 0.3f, false, synthesis::ExcitationType::Pluck},
+        {659.25, 0.0f, false, synthesis::ExcitationType::Pluck},
+        {1318.5, 0.9f, true, synthesis::ExcitationType::Hammer},
+        {261.63, 0.2f, true, synthesis::ExcitationType::Pluck},
+    };
 
-    REQUIRE(maxAbs(neutral) < 2.0f);
-    REQUIRE(maxAbs(bright) < 2.0f);
-    REQUIRE(maxAbs(warm) < 2.0f);
-    const auto energyStart = toFrames(0.05);
-    const auto energyEnd = toFrames(0.2);
-    const float neutralEnergy = rms(neutral, energyStart, energyEnd);
-    const float brightEnergy = rms(bright, energyStart, energyEnd);
-    const float warmEnergy = rms(warm, energyStart, energyEnd);
+    auto makeStrings = [&setups] {
+        std::vector<synthesis::KarplusStrongString> strings;
+        for (std::size_t i = 0; i < setups.size(); ++i) {
+            synthesis::StringConfig config;
+            config.sampleRate = 48000.0;
+            config.dispersionAmount = setups[i].dispersion;
+            config.enableLowpass = setups[i].lowpass;
+            config.excitationType = setups[i].type;
+            config.seed = 500u + static_cast<unsigned int>(i);
+            config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+            strings.emplace_back(config);
+            strings.back().start(setups[i].freq, 0.7f);
+        }
+        return strings;
+    };
 
-    REQUIRE(neutralEnergy > 0.0f);
-    REQUIRE(brightEnergy < 2.5f);
-    REQUIRE(warmEnergy < 2.5f);
-    REQUIRE(brightEnergy / neutralEnergy < 2.5f);
-    REQUIRE(warmEnergy / neutralEnergy < 2.5f);
-    REQUIRE(brightEnergy / neutralEnergy > 0.35f);
-    REQUIRE(warmEnergy / neutralEnergy > 0.35f);
-    REQUIRE(brightEnergy != Catch::Approx(warmEnergy));
+    auto scalar = makeStrings();
+    auto lanes = makeStrings();
+    const std::size_t frames = 300;
+    std::vector<std::vector<float>> expected(setups.size(), std::vector<float>(frames));
+    std::vector<std::vector<float>> actual(setups.size(), std::vector<float>(frames));
+    std::vector<synthesis::KarplusStrongString*> stringPtrs;
+    std::vector<float*> outPtrs;
+    for (std::size_t i = 0; i < setups.size(); ++i) {
+        stringPtrs.push_back(&lanes[i]);
+        outPtrs.push_back(actual[i].data());
+    }
+
+    std::size_t mismatches = 0;
+    for (int block = 0; block < 8; ++block) {
+        for (std::size_t i = 0; i < setups.size(); ++i) {
+            scalar[i].processBlock(expected[i].data(), frames);
+        }
+        synthesis::KarplusStrongString::processBlockLanes(stringPtrs.data(), outPtrs.data(),
+                                                          stringPtrs.size(), frames);
+        for (std::size_t i = 0; i < setups.size(); ++i) {
+            for (std::size_t f = 0; f < frames; ++f) {
+                if (expected[i][f] != actual[i][f]) {
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    REQUIRE(mismatches == 0);
 }
 
-TEST_CASE("Room 模块提供可控的立体扩展", "[engine-room]") {
-    const double sampleRate = 48000.0;
+TEST_CASE("StringPreviewRenderer 复用弦实例且按参数缓存、可取消", "[ks-string][preview]") {
+    synthesis::StringConfig config;
+    config.sampleRate = 48000.0;
+    config.seed = 91u;
+    config.excitationType = synthesis::ExcitationType::Hammer;
+    synthesis::StringConfig other = config;
+    other.brightness = 0.8f;
+    other.excitationType = synthesis::ExcitationType::Pluck;
 
-    auto toFrames = [sampleRate](double seconds) {
-        return static_cast<std::uint64_t>(
-            std::max(0.0, std::round(seconds * sampleRate)));
+    // What a freshly constructed string would show for the same request.
+    auto expectedFor = [](const synthesis::StringConfig& c, double frequency) {
+        synthesis::KarplusStrongString string(c);
+        string.start(frequency, 1.0f);
+        synthesis::StringPreviewRenderer::Preview preview;
+        preview.excitation = string.excitationBufferPreview(
+            synthesis::StringPreviewRenderer::kExcitationSamples);
+        preview.waveform.resize(synthesis::StringPreviewRenderer::kWaveformSamples);
+        string.processBlock(preview.waveform.data(), preview.waveform.size());
+        return preview;
     };
 
-    engine::Event on{};
-    on.type = engine::EventType::NoteOn;
-    on.noteId = 1;
-    on.frequency = 330.0;
-    on.velocity = 0.7f;
-    on.frameOffset = 0;
+    synthesis::StringPreviewRenderer renderer;
+    synthesis::StringPreviewRenderer::Preview preview;
+    REQUIRE(renderer.render(config, 1.0f, 220.0, {}, preview));
+    const auto first = expectedFor(config, 220.0);
+    REQUIRE(preview.waveform == first.waveform);
+    REQUIRE(preview.excitation == first.excitation);
 
-    engine::Event off{};
-    off.type = engine::EventType::NoteOff;
-    off.noteId = 1;
-    off.frameOffset = toFrames(0.2);
+    // The reused string carries nothing over from the previous request.
+    REQUIRE(renderer.render(other, 1.0f, 330.0, {}, preview));
+    const auto second = expectedFor(other, 330.0);
+    REQUIRE(preview.waveform == second.waveform);
+    REQUIRE(preview.excitation == second.excitation);
+    REQUIRE(renderer.renders() == 2);
 
-    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.5);
+    // Returning to an earlier setting is served from the cache, gain applied.
+    config.brightness += 1e-6f;  // below the quantisation step
+    REQUIRE(renderer.render(config, 0.5f, 220.0, {}, preview));
+    REQUIRE(renderer.renders() == 2);
+    REQUIRE(renderer.cacheHits() == 1);
+    REQUIRE(preview.waveform.size() == first.waveform.size());
+    for (std::size_t i = 0; i < preview.waveform.size(); ++i) {
+        REQUIRE(preview.waveform[i] == first.waveform[i] * 0.5f);
+    }
 
-    auto stereoRms = [](const std::vector<float>& buffer, std::size_t startFrame,
-                        std::size_t endFrame) {
-        if (buffer.size() < 2) {
-            return 0.0f;
+    // A superseded request gives up without producing or caching anything.
+    synthesis::StringPreviewRenderer::Preview untouched;
+    other.decay = 0.9f;
+    REQUIRE_FALSE(renderer.render(other, 1.0f, 330.0, [] { return true; }, untouched));
+    REQUIRE(untouched.waveform.empty());
+    REQUIRE_FALSE(renderer.render(other, 1.0f, 330.0, [] { return true; }, untouched));
+    REQUIRE(renderer.renders() == 2);
+    REQUIRE(renderer.cacheHits() == 1);
+}
+
+TEST_CASE("StringLoopFilter 与 FilterChain 输出一致", "[dsp][filter]") {
+    const float coeffs[] = {-0.42f, 0.31f, 0.18f};
+    const float alpha = 0.37f;
+
+    dsp::FilterChain chain;
+    dsp::StringLoopFilter<3> loop;
+    for (float c : coeffs) {
+        chain.addFilter(std::make_unique<dsp::FirstOrderAllPass>(c));
+        REQUIRE(loop.addAllPass(c));
+    }
+    chain.addFilter(std::make_unique<dsp::OnePoleLowPass>(alpha));
+    loop.setLowPass(alpha);
+    REQUIRE_FALSE(loop.addAllPass(0.5f));
+
+    std::size_t mismatches = 0;
+    for (int i = 0; i < 2048; ++i) {
+        const float x = std::sin(0.013f * static_cast<float>(i)) +
+                        ((i % 97) == 0 ? 1.0f : 0.0f);
+        if (chain.process(x) != loop.process(x)) {
+            ++mismatches;
         }
-        const std::size_t totalFrames = buffer.size() / 2;
-        const std::size_t clampedEnd = std::min(endFrame, totalFrames);
-        double sum = 0.0;
-        std::size_t count = 0;
-        for (std::size_t frame = startFrame; frame < clampedEnd; ++frame) {
-            const std::size_t idx = frame * 2;
-            if (idx + 1 >= buffer.size()) {
-                break;
-            }
-            const float mono = 0.5f * (buffer[idx] + buffer[idx + 1]);
-            sum += static_cast<double>(mono) * static_cast<double>(mono);
-            ++count;
+    }
+    REQUIRE(mismatches == 0);
+
+    loop.clear();
+    REQUIRE(loop.empty());
+    REQUIRE(loop.process(0.75f) == 0.75f);
+}
+
+TEST_CASE("Filter 块处理与逐样本输出一致", "[dsp][filter]") {
+    constexpr double kRate = 48000.0;
+    auto make = [&](int kind) -> std::unique_ptr<dsp::Filter> {
+        switch (kind) {
+        case 0:
+            return std::make_unique<dsp::OnePoleLowPass>(0.23f);
+        case 1:
+            return std::make_unique<dsp::FirstOrderAllPass>(-0.37f);
+        case 2: {
+            auto biquad = std::make_unique<dsp::BiquadFilter>();
+            biquad->design(dsp::BiquadFilter::Type::Peak, kRate, 1800.0, 1.4, 5.0);
+            return biquad;
+        }
+        case 3: {
+            auto biquad = std::make_unique<dsp::BiquadFilter>();
+            biquad->design(dsp::BiquadFilter::Type::LowShelf, kRate, 250.0, 0.7, -4.0);
+            return biquad;
+        }
+        default: {
+            auto svf = std::make_unique<dsp::StateVariableFilter>();
+            svf->design(dsp::StateVariableFilter::Type::BandPass, kRate, 700.0, 3.0);
+            return svf;
         }
-        if (count == 0) {
-            return 0.0f;
         }
-        return static_cast<float>(std::sqrt(sum / static_cast<double>(count)));
     };
+    std::vector<float> input(1031);
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        input[i] = std::sin(0.021f * static_cast<float>(i)) + ((i % 113) == 0 ? 0.8f : 0.0f);
+    }
+    for (int kind = 0; kind < 5; ++kind) {
+        auto single = make(kind);
+        auto block = make(kind);
+        std::vector<float> expected(input.size());
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            expected[i] = single->process(input[i]);
+        }
+        // Uneven blocks, in place.
+        std::vector<float> actual = input;
+        for (std::size_t done = 0, n = 1; done < actual.size(); done += n, n = n * 3 % 97 + 1) {
+            n = std::min(n, actual.size() - done);
+            block->process(actual.data() + done, actual.data() + done, n);
+        }
+        INFO("kind " << kind);
+        REQUIRE(actual == expected);
+    }
 
-    auto renderWithRoom = [&](float amount) {
-        engine::StringSynthEngine engine;
-        engine.setSampleRate(sampleRate);
-        // Make excitation deterministic to avoid flaky energy/peak assertions.
-        auto cfg = engine.stringConfig();
-        cfg.seed = 1234;
-        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
-        engine.setConfig(cfg);
-        engine.setParam(engine::ParamId::RoomAmount, amount);
-        return renderEngineSequence(engine, {on, off}, totalFrames, 2);
+    dsp::FilterChain chain;
+    chain.addFilter(make(1));
+    chain.addFilter(make(4));
+    dsp::FilterChain blockChain;
+    blockChain.addFilter(make(1));
+    blockChain.addFilter(make(4));
+    std::vector<float> chained(input.size());
+    blockChain.process(input.data(), chained.data(), chained.size());
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        mismatches += chain.process(input[i]) != chained[i] ? 1 : 0;
+    }
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("BiquadFilter 与 StateVariableFilter 响应符合设计", "[dsp][filter]") {
+    constexpr double kRate = 48000.0;
+    // Steady-state gain for a sine at `frequency`.
+    auto gainAt = [&](dsp::Filter& filter, double frequency) {
+        filter.reset();
+        std::vector<float> signal(9600);
+        for (std::size_t i = 0; i < signal.size(); ++i) {
+            signal[i] = static_cast<float>(
+                std::sin(2.0 * 3.141592653589793 * frequency * static_cast<double>(i) / kRate));
+        }
+        filter.process(signal.data(), signal.data(), signal.size());
+        return rms(signal, signal.size() / 2, signal.size()) / std::sqrt(0.5f);
     };
 
-    auto dry = renderWithRoom(0.0f);
-    auto wet = renderWithRoom(1.0f);
+    dsp::BiquadFilter lowpass;
+    REQUIRE(lowpass.magnitude(1000.0, kRate) == Catch::Approx(1.0));
+    lowpass.design(dsp::BiquadFilter::Type::LowPass, kRate, 1000.0, std::sqrt(0.5));
+    REQUIRE(lowpass.magnitude(0.0, kRate) == Catch::Approx(1.0).margin(1e-4));
+    REQUIRE(lowpass.magnitude(1000.0, kRate) == Catch::Approx(std::sqrt(0.5)).margin(1e-3));
+    REQUIRE(lowpass.magnitude(16000.0, kRate) < 0.01);
+    REQUIRE(gainAt(lowpass, 100.0) == Catch::Approx(1.0f).margin(0.01f));
+    REQUIRE(gainAt(lowpass, 12000.0) < 0.02f);
 
-    REQUIRE(std::all_of(dry.begin(), dry.end(),
-                        [](float v) { return std::isfinite(v); }));
-    REQUIRE(std::all_of(wet.begin(), wet.end(),
-                        [](float v) { return std::isfinite(v); }));
+    dsp::BiquadFilter peak;
+    peak.design(dsp::BiquadFilter::Type::Peak, kRate, 2000.0, 1.0, 6.0);
+    REQUIRE(peak.magnitude(2000.0, kRate) == Catch::Approx(std::pow(10.0, 6.0 / 20.0)).margin(1e-3));
+    REQUIRE(peak.magnitude(40.0, kRate) == Catch::Approx(1.0).margin(0.01));
+    dsp::BiquadFilter shelf;
+    shelf.design(dsp::BiquadFilter::Type::HighShelf, kRate, 3000.0, std::sqrt(0.5), -6.0);
+    REQUIRE(shelf.magnitude(20000.0, kRate) == Catch::Approx(std::pow(10.0, -6.0 / 20.0)).margin(0.01));
+    REQUIRE(shelf.magnitude(50.0, kRate) == Catch::Approx(1.0).margin(0.01));
 
-    const auto energyStart = toFrames(0.05);
-    const auto energyEnd = toFrames(0.25);
-    const float dryEnergy = stereoRms(dry, energyStart, energyEnd);
-    const float wetEnergy = stereoRms(wet, energyStart, energyEnd);
-    auto stereoSideRms = [](const std::vector<float>& buffer, std::size_t startFrame,
-                            std::size_t endFrame) {
-        if (buffer.size() < 2) {
-            return 0.0f;
-        }
-        const std::size_t totalFrames = buffer.size() / 2;
-        const std::size_t clampedEnd = std::min(endFrame, totalFrames);
-        double sum = 0.0;
-        std::size_t count = 0;
-        for (std::size_t frame = startFrame; frame < clampedEnd; ++frame) {
-            const std::size_t idx = frame * 2;
-            if (idx + 1 >= buffer.size()) {
-                break;
+    dsp::StateVariableFilter svf;
+    svf.design(dsp::StateVariableFilter::Type::LowPass, kRate, 1000.0, std::sqrt(0.5));
+    REQUIRE(gainAt(svf, 100.0) == Catch::Approx(1.0f).margin(0.01f));
+    REQUIRE(gainAt(svf, 1000.0) == Catch::Approx(std::sqrt(0.5f)).margin(0.01f));
+    REQUIRE(gainAt(svf, 12000.0) < 0.02f);
+    svf.design(dsp::StateVariableFilter::Type::HighPass, kRate, 1000.0, std::sqrt(0.5));
+    REQUIRE(gainAt(svf, 100.0) < 0.02f);
+    REQUIRE(gainAt(svf, 12000.0) == Catch::Approx(1.0f).margin(0.01f));
+    svf.design(dsp::StateVariableFilter::Type::BandPass, kRate, 1000.0, 2.0);
+    REQUIRE(gainAt(svf, 1000.0) == Catch::Approx(1.0f).margin(0.01f));
+    REQUIRE(gainAt(svf, 4000.0) < 0.2f);
+    svf.design(dsp::StateVariableFilter::Type::AllPass, kRate, 1000.0, 1.0);
+    REQUIRE(gainAt(svf, 300.0) == Catch::Approx(1.0f).margin(0.01f));
+    REQUIRE(gainAt(svf, 5000.0) == Catch::Approx(1.0f).margin(0.01f));
+}
+
+TEST_CASE("FastMath 近似误差在文档给出的范围内", "[dsp][fastmath]") {
+    constexpr double kPi = 3.141592653589793;
+    constexpr int kSteps = 200000;
+    double exp2Error = 0.0;
+    double logError = 0.0;
+    double atanError = 0.0;
+    double atan2Error = 0.0;
+    double tanError = 0.0;
+    for (int i = 0; i <= kSteps; ++i) {
+        const double t = static_cast<double>(i) / kSteps;
+        const double x = -60.0 + 120.0 * t;
+        exp2Error = std::max(exp2Error, std::abs(dsp::FastExp2(x) / std::exp2(x) - 1.0));
+        const double positive = std::exp2(-40.0 + 80.0 * t);
+        logError = std::max(logError, std::abs(dsp::FastLog2(positive) - std::log2(positive)));
+        const double slope = std::tan((t - 0.5) * (kPi - 1e-6));
+        atanError = std::max(atanError, std::abs(dsp::FastAtan(slope) - std::atan(slope)));
+        const double angle = (2.0 * t - 1.0) * kPi;
+        const double radius = 0.5 + t;
+        atan2Error = std::max(atan2Error,
+                              std::abs(dsp::FastAtan2(radius * std::sin(angle),
+                                                      radius * std::cos(angle)) -
+                                       std::atan2(radius * std::sin(angle),
+                                                  radius * std::cos(angle))));
+        const double tanArg = (t - 0.5) * (kPi - 2e-3);
+        tanError = std::max(tanError, std::abs(dsp::FastTan(tanArg) / std::tan(tanArg) - 1.0));
+    }
+    CHECK(exp2Error < 1e-8);
+    CHECK(logError < 1e-9);
+    CHECK(atanError < 1e-9);
+    CHECK(atan2Error < 1e-9);
+    CHECK(tanError < 1e-9);
+
+    // Exact where coefficient code relies on it.
+    REQUIRE(dsp::FastExp2(0.0) == 1.0);
+    REQUIRE(dsp::FastExp2(3.0) == 8.0);
+    REQUIRE(dsp::FastExp2(-2.0f) == 0.25f);
+    REQUIRE(dsp::FastLog2(1.0) == 0.0);
+    REQUIRE(dsp::FastLog2(1024.0f) == 10.0f);
+    REQUIRE(dsp::FastAtan2(0.0, 0.0) == 0.0);
+    REQUIRE(dsp::FastAtan2(0.0, -1.0) == Catch::Approx(kPi));
+    REQUIRE(dsp::FastAtan2(-1.0, 0.0) == Catch::Approx(-0.5 * kPi));
+
+    // Float: within float rounding of libm.
+    for (int i = 0; i <= 2000; ++i) {
+        const float t = static_cast<float>(i) / 2000.0f;
+        const float x = -20.0f + 40.0f * t;
+        REQUIRE(std::abs(dsp::FastExp2(x) / std::exp2(x) - 1.0f) < 1e-6f);
+        REQUIRE(std::abs(dsp::FastExp(0.25f * x) / std::exp(0.25f * x) - 1.0f) < 1e-6f);
+        const float positive = std::exp2(x);
+        REQUIRE(std::abs(dsp::FastLog2(positive) - std::log2(positive)) < 4e-6f);
+        const float angle = (t - 0.5f) * 3.0f + 1e-4f;
+        REQUIRE(std::abs(dsp::FastTan(angle) / std::tan(angle) - 1.0f) < 2e-6f);
+        REQUIRE(std::abs(dsp::FastAtan(x) - std::atan(x)) < 1e-6f);
+    }
+    // Out of range exponents saturate instead of wrapping.
+    REQUIRE(dsp::FastExp2(1000.0f) > 1e38f);
+    REQUIRE(dsp::FastExp2(-1000.0f) >= 0.0f);
+    REQUIRE(dsp::FastExp2(-1000.0f) < 1e-37f);
+}
+
+TEST_CASE("PolyphaseResampler 保留通带并抑制镜像与混叠", "[dsp][resampler]") {
+    constexpr double kPi = 3.14159265358979323846;
+    const auto tone = [&](double freq, int rate, std::size_t frames) {
+        std::vector<float> x(frames);
+        for (std::size_t i = 0; i < frames; ++i) {
+            x[i] = static_cast<float>(std::sin(2.0 * kPi * freq * static_cast<double>(i) / rate));
+        }
+        return x;
+    };
+    const std::size_t frames = 9600;
+
+    // In-band tone comes through with unity gain and no delay, both ways.
+    for (const auto& [src, dst] : {std::pair{48000, 44100}, std::pair{44100, 96000},
+                                   std::pair{48000, 32000}}) {
+        const dsp::PolyphaseResampler resampler(src, dst);
+        const auto in = tone(1000.0, src, frames);
+        const auto out = resampler.process(in.data(), in.size());
+        REQUIRE(out.size() == dsp::PolyphaseResampler::OutputFrames(frames, src, dst));
+        const auto ideal = tone(1000.0, dst, out.size());
+        float maxErr = 0.0f;
+        for (std::size_t i = 200; i + 200 < out.size(); ++i) {
+            maxErr = std::max(maxErr, std::abs(out[i] - ideal[i]));
+        }
+        REQUIRE(maxErr < 1e-3f);
+
+        const auto prefix = resampler.process(in.data(), in.size(), 300);
+        REQUIRE(prefix.size() == 300);
+        REQUIRE(std::equal(prefix.begin(), prefix.end(), out.begin()));
+    }
+
+    // 30 kHz at 96 kHz would alias to 14.1 kHz at 44.1 kHz.
+    {
+        const dsp::PolyphaseResampler resampler(96000, 44100);
+        const auto in = tone(30000.0, 96000, frames);
+        const auto out = resampler.process(in.data(), in.size());
+        double energy = 0.0;
+        for (std::size_t i = 200; i + 200 < out.size(); ++i) {
+            energy += static_cast<double>(out[i]) * out[i];
+        }
+        REQUIRE(std::sqrt(energy / static_cast<double>(out.size() - 400)) < 1e-3);
+    }
+
+    // 20 kHz upsampled to 96 kHz must not leave its 24.1 kHz image.
+    {
+        const dsp::PolyphaseResampler resampler(44100, 96000);
+        const auto in = tone(20000.0, 44100, frames);
+        const auto out = resampler.process(in.data(), in.size());
+        double re = 0.0;
+        double im = 0.0;
+        const std::size_t begin = 400;
+        const std::size_t end = out.size() - 400;
+        for (std::size_t i = begin; i < end; ++i) {
+            const double phase = 2.0 * kPi * 24100.0 * static_cast<double>(i) / 96000.0;
+            re += out[i] * std::cos(phase);
+            im += out[i] * std::sin(phase);
+        }
+        const double amplitude = 2.0 * std::hypot(re, im) / static_cast<double>(end - begin);
+        REQUIRE(amplitude < 1e-3);
+    }
+
+    const dsp::PolyphaseResampler same(48000, 48000);
+    const auto in = tone(1000.0, 48000, 64);
+    REQUIRE(same.process(in.data(), in.size()) == in);
+}
+
+TEST_CASE("StreamingResampler 分块输出与整段重采样一致", "[dsp][resampler]") {
+    const std::size_t inputFrames = 24000;
+    std::vector<float> left(inputFrames);
+    std::vector<float> right(inputFrames);
+    for (std::size_t i = 0; i < inputFrames; ++i) {
+        left[i] = std::sin(0.031f * static_cast<float>(i));
+        right[i] = ((i * 7919u) % 113u) / 113.0f - 0.5f;
+    }
+
+    for (const auto& [src, dst] : {std::pair{44100, 48000}, std::pair{48000, 44100},
+                                   std::pair{32000, 96000}}) {
+        const dsp::PolyphaseResampler offline(src, dst);
+        const auto expectL = offline.process(left.data(), left.size());
+        const auto expectR = offline.process(right.data(), right.size());
+
+        dsp::StreamingResampler stream;
+        stream.configure(src, dst, 2);
+        std::size_t readPos = 0;
+        const auto pull = [&](float* input, std::size_t frames) {
+            for (std::size_t f = 0; f < frames; ++f, ++readPos) {
+                input[2 * f] = readPos < inputFrames ? left[readPos] : 0.0f;
+                input[2 * f + 1] = readPos < inputFrames ? right[readPos] : 0.0f;
             }
-            const double side = static_cast<double>(buffer[idx] - buffer[idx + 1]);
-            sum += side * side;
-            ++count;
+        };
+
+        // Odd callback sizes, stopping well before the offline zero padding.
+        const std::size_t outputFrames = expectL.size() / 2;
+        std::vector<float> out(outputFrames * 2);
+        std::size_t done = 0;
+        for (std::size_t chunk = 1; done < outputFrames; chunk = chunk * 3 % 509 + 1) {
+            const std::size_t frames = std::min(chunk, outputFrames - done);
+            stream.process(out.data() + 2 * done, frames, pull);
+            done += frames;
         }
-        if (count == 0) {
-            return 0.0f;
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < outputFrames; ++i) {
+            mismatches += out[2 * i] != expectL[i] || out[2 * i + 1] != expectR[i];
+        }
+        REQUIRE(mismatches == 0);
+
+        stream.reset();
+        readPos = 0;
+        std::vector<float> again(2 * 64);
+        stream.process(again.data(), 64, pull);
+        REQUIRE(std::equal(again.begin(), again.end(), out.begin()));
+
+        // latencyFrames() is the input pulled ahead of the output, averaged.
+        stream.reset();
+        readPos = 0;
+        double ahead = 0.0;
+        const std::size_t probes = 8000;
+        for (std::size_t n = 0; n < probes; ++n) {
+            stream.process(again.data(), 1, pull);
+            ahead += static_cast<double>(readPos) - static_cast<double>(n) * src / dst;
+        }
+        REQUIRE(ahead / probes == Catch::Approx(stream.latencyFrames()).margin(2.0));
+    }
+
+    dsp::StreamingResampler same;
+    same.configure(48000, 48000, 2);
+    REQUIRE(same.latencyFrames() == 0.0);
+}
+
+TEST_CASE("FixedBlockStream 以固定块渲染任意长度的设备缓冲", "[dsp][block-stream]") {
+    REQUIRE(dsp::FixedBlockStream::BlockFramesFor(0) == dsp::FixedBlockStream::kMaxBlockFrames);
+    REQUIRE(dsp::FixedBlockStream::BlockFramesFor(100) == 64);
+    REQUIRE(dsp::FixedBlockStream::BlockFramesFor(1056) == 128);
+    REQUIRE(dsp::FixedBlockStream::BlockFramesFor(8) == dsp::FixedBlockStream::kMinBlockFrames);
+
+    constexpr std::size_t kBlock = 64;
+    dsp::FixedBlockStream stream;
+    stream.configure(kBlock, 2);
+    std::size_t rendered = 0;
+    std::size_t badPulls = 0;
+    const auto pull = [&](float* samples, std::size_t frames) {
+        badPulls += frames != kBlock;
+        for (std::size_t f = 0; f < frames; ++f, ++rendered) {
+            samples[2 * f] = static_cast<float>(rendered);
+            samples[2 * f + 1] = -static_cast<float>(rendered);
         }
-        return static_cast<float>(std::sqrt(sum / static_cast<double>(count)));
     };
-    const float wetSide = stereoSideRms(wet, energyStart, energyEnd);
 
-    REQUIRE(dryEnergy > 0.0f);
-    REQUIRE(wetEnergy > 0.0f);
-    // Wet energy should stay in the same order of magnitude as dry.
-    REQUIRE(wetEnergy < dryEnergy * 6.0f);
-    REQUIRE(wetEnergy > dryEnergy * 0.1f);
-    // Stereo width should be present in the wet signal.
-    REQUIRE(wetSide > wetEnergy * 0.01f);
+    // Device-like sizes: the output is the source's frames in order, and the
+    // source is never more than one block ahead.
+    constexpr std::size_t kTotal = 20000;
+    std::vector<float> out(2 * kTotal);
+    std::size_t done = 0;
+    for (std::size_t chunk = 1; done < kTotal; chunk = chunk * 7 % 541 + 1) {
+        const std::size_t frames = std::min(chunk, kTotal - done);
+        stream.process(out.data() + 2 * done, frames, pull);
+        done += frames;
+        REQUIRE(rendered == done + stream.bufferedFrames());
+        REQUIRE(stream.bufferedFrames() < kBlock);
+    }
+    REQUIRE(badPulls == 0);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < kTotal; ++i) {
+        mismatches += out[2 * i] != static_cast<float>(i) || out[2 * i + 1] != -out[2 * i];
+    }
+    REQUIRE(mismatches == 0);
 
-    float leftPeak = 0.0f;
-    float rightPeak = 0.0f;
-    for (std::size_t frame = 0; frame + 1 < wet.size() / 2; ++frame) {
-        const std::size_t idx = frame * 2;
-        leftPeak = std::max(leftPeak, std::abs(wet[idx]));
-        rightPeak = std::max(rightPeak, std::abs(wet[idx + 1]));
+    stream.reset();
+    REQUIRE(stream.bufferedFrames() == 0);
+
+    // Block size 0 passes requests through unchanged.
+    dsp::FixedBlockStream direct;
+    direct.configure(0, 2);
+    std::size_t asked = 0;
+    direct.process(out.data(), 37, [&](float*, std::size_t frames) { asked = frames; });
+    REQUIRE(asked == 37);
+}
+
+TEST_CASE("SampleConvert 各设备格式与标量参考一致", "[audio][convert]") {
+    std::vector<float> src;
+    for (int i = -40; i <= 40; ++i) {
+        src.push_back(static_cast<float>(i) / 37.0f);  // includes out-of-range values
     }
-    REQUIRE(leftPeak > 0.001f);
-    REQUIRE(rightPeak > 0.001f);
+    src.push_back(1.0f);
+    src.push_back(-1.0f);
+    src.push_back(0.0f);
+
+    struct Case {
+        audio::SampleFormat format;
+        double scale;
+        int shift;
+    };
+    const Case cases[] = {{audio::SampleFormat::Int16, 32767.0, 0},
+                          {audio::SampleFormat::Int24, 8388607.0, 0},
+                          {audio::SampleFormat::Int32, 2147483647.0, 0},
+                          {audio::SampleFormat::Int32Left24, 8388607.0, 8}};
+    for (const bool bigEndian : {false, true}) {
+        for (const auto& c : cases) {
+            const std::size_t bytes = audio::SampleBytes(c.format);
+            std::vector<std::uint8_t> out(src.size() * bytes);
+            audio::GetSampleConverter(c.format, bigEndian)(src.data(), out.data(), src.size());
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                std::uint64_t bits = 0;
+                for (std::size_t b = 0; b < bytes; ++b) {
+                    const std::size_t shift = 8 * (bigEndian ? bytes - 1 - b : b);
+                    bits |= static_cast<std::uint64_t>(out[i * bytes + b]) << shift;
+                }
+                // Sign-extend from the stored width.
+                const int width = static_cast<int>(8 * bytes);
+                std::int64_t value = static_cast<std::int64_t>(bits << (64 - width)) >> (64 - width);
+                value >>= c.shift;
+                const double expected =
+                    std::round(std::clamp(static_cast<double>(src[i]), -1.0, 1.0) * c.scale);
+                // One LSB, or float resolution for the 32-bit SIMD path.
+                REQUIRE(std::abs(static_cast<double>(value) - expected) <=
+                        std::max(1.0, c.scale * 1e-7));
+            }
+        }
+
+        std::vector<float> f32(src.size());
+        std::vector<double> f64(src.size());
+        audio::GetSampleConverter(audio::SampleFormat::Float32, false)(src.data(), f32.data(),
+                                                                       src.size());
+        audio::GetSampleConverter(audio::SampleFormat::Float64, false)(src.data(), f64.data(),
+                                                                       src.size());
+        for (std::size_t i = 0; i < src.size(); ++i) {
+            REQUIRE(f32[i] == std::clamp(src[i], -1.0f, 1.0f));
+            REQUIRE(f64[i] == static_cast<double>(std::clamp(src[i], -1.0f, 1.0f)));
+        }
+    }
+
+    const float interleaved[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f};
+    float right[3] = {};
+    audio::Deinterleave(interleaved, 2, 1, right, 3);
+    REQUIRE(right[0] == 2.0f);
+    REQUIRE(right[1] == 4.0f);
+    REQUIRE(right[2] == 6.0f);
 }
 
-TEST_CASE("StringSynthEngine NoteOn/Off 控制尾音长度", "[engine-core]") {
-    const double sampleRate = 48000.0;
-    engine::StringSynthEngine engine;
-    engine.setSampleRate(sampleRate);
-    engine.setParam(engine::ParamId::AmpRelease, 0.05f);
-    engine.setParam(engine::ParamId::Decay, 0.992f);
-    INFO("engine sampleRate=" << engine.sampleRate());
+TEST_CASE("SampleConvert 采集格式读回浮点，往返误差在两个量化步长内", "[audio][convert]") {
+    std::vector<float> src;
+    for (int i = -40; i <= 40; ++i) {
+        src.push_back(static_cast<float>(i) / 41.0f);
+    }
+    src.push_back(1.0f);
+    src.push_back(-1.0f);
 
-    auto toFrames = [sampleRate](double seconds) {
-        return static_cast<std::uint64_t>(
-            std::max(0.0, std::round(seconds * sampleRate)));
+    struct Case {
+        audio::SampleFormat format;
+        float step;
     };
+    const Case cases[] = {{audio::SampleFormat::Int16, 1.0f / 32767.0f},
+                          {audio::SampleFormat::Int24, 1.0f / 8388607.0f},
+                          {audio::SampleFormat::Int32, 1e-7f},
+                          {audio::SampleFormat::Int32Left24, 1.0f / 8388607.0f},
+                          {audio::SampleFormat::Float32, 0.0f},
+                          {audio::SampleFormat::Float64, 0.0f}};
+    for (const bool bigEndian : {false, true}) {
+        for (const auto& c : cases) {
+            std::vector<std::uint8_t> device(src.size() * audio::SampleBytes(c.format));
+            std::vector<float> back(src.size());
+            audio::GetSampleConverter(c.format, bigEndian)(src.data(), device.data(), src.size());
+            audio::GetSampleReader(c.format, bigEndian)(device.data(), back.data(), src.size());
+            for (std::size_t i = 0; i < src.size(); ++i) {
+                // Writers scale by the positive limit and readers by the
+                // negative one, so full scale is off by up to a step more.
+                REQUIRE(std::abs(back[i] - src[i]) <= 2.0f * c.step);
+            }
+        }
+    }
+    // Negative full scale is exactly -1.
+    const std::int16_t minimum = -32768;
+    float read = 0.0f;
+    audio::GetSampleReader(audio::SampleFormat::Int16, false)(&minimum, &read, 1);
+    REQUIRE(read == -1.0f);
 
-    engine::Event on{};
-    on.type = engine::EventType::NoteOn;
-    on.noteId = 1;
-    on.frequency = 440.0;
-    on.frameOffset = 0;
+    float interleaved[6] = {};
+    const float left[3] = {1.0f, 3.0f, 5.0f};
+    audio::Interleave(left, 2, 0, interleaved, 3);
+    REQUIRE(interleaved[0] == 1.0f);
+    REQUIRE(interleaved[1] == 0.0f);
+    REQUIRE(interleaved[4] == 5.0f);
+}
 
-    engine::Event off{};
-    off.type = engine::EventType::NoteOff;
-    off.noteId = 1;
-    off.frameOffset = toFrames(0.05);
+TEST_CASE("WaveStreamWriter 分块写出 24 位与浮点 WAV", "[audio][wav]") {
+    std::vector<float> samples(10001);  // odd, so 24-bit mono needs a pad byte
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = 0.9f * std::sin(0.01f * static_cast<float>(i));
+    }
+    const auto path = std::filesystem::temp_directory_path() / "satori_wav_stream_test.wav";
 
-    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.3);
-    auto buffer = renderEngineSequence(engine, {on, off}, totalFrames);
+    auto readFile = [&] {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(in),
+                                 std::istreambuf_iterator<char>());
+    };
+    auto u32 = [](const std::vector<char>& bytes, std::size_t at) {
+        std::uint32_t v = 0;
+        for (std::size_t b = 0; b < 4; ++b) {
+            v |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[at + b])) << (8 * b);
+        }
+        return v;
+    };
+    auto u16 = [](const std::vector<char>& bytes, std::size_t at) {
+        return static_cast<std::uint16_t>(static_cast<std::uint8_t>(bytes[at]) |
+                                          (static_cast<std::uint8_t>(bytes[at + 1]) << 8));
+    };
+    auto write = [&](audio::SampleFormat sampleFormat) {
+        audio::WaveFormat format;
+        format.sampleRate = 48000;
+        format.sampleFormat = sampleFormat;
+        audio::WaveStreamWriter writer;
+        std::string error;
+        REQUIRE(writer.open(path, format, error));
+        // Uneven blocks, as a streaming render would hand them over.
+        for (std::size_t done = 0; done < samples.size();) {
+            const std::size_t count = std::min<std::size_t>(777, samples.size() - done);
+            REQUIRE(writer.write(samples.data() + done, count, error));
+            done += count;
+        }
+        REQUIRE(writer.samplesWritten() == samples.size());
+        REQUIRE(writer.close(error));
+        return readFile();
+    };
 
-    const float earlyEnergy = rms(buffer, 0, toFrames(0.1));
-    const float tailEnergy = rms(buffer, toFrames(0.2), buffer.size());
-    INFO("peak=" << maxAbs(buffer) << " early=" << earlyEnergy << " tail=" << tailEnergy);
+    SECTION("24-bit PCM") {
+        const auto bytes = write(audio::SampleFormat::Int24);
+        REQUIRE(bytes.size() == 44 + samples.size() * 3 + 1);
+        REQUIRE(std::memcmp(bytes.data(), "RIFF", 4) == 0);
+        REQUIRE(u32(bytes, 4) == bytes.size() - 8);
+        REQUIRE(u16(bytes, 20) == 1);
+        REQUIRE(u16(bytes, 34) == 24);
+        REQUIRE(u32(bytes, 28) == 48000u * 3u);
+        REQUIRE(std::memcmp(bytes.data() + 36, "data", 4) == 0);
+        REQUIRE(u32(bytes, 40) == samples.size() * 3);
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            const std::size_t at = 44 + i * 3;
+            const std::uint32_t raw = static_cast<std::uint8_t>(bytes[at]) |
+                                      (static_cast<std::uint8_t>(bytes[at + 1]) << 8) |
+                                      (static_cast<std::uint8_t>(bytes[at + 2]) << 16);
+            const auto value = static_cast<std::int32_t>(raw << 8) >> 8;
+            REQUIRE(std::abs(value - std::lround(samples[i] * 8388607.0)) <= 1);
+        }
+    }
 
-    REQUIRE(earlyEnergy > 0.001f);
-    REQUIRE(tailEnergy < earlyEnergy * 0.25f);
-    REQUIRE(tailEnergy < 0.0005f);
+    SECTION("32-bit float") {
+        const auto bytes = write(audio::SampleFormat::Float32);
+        const std::size_t dataAt = 12 + 8 + 18 + 12 + 8;
+        REQUIRE(bytes.size() == dataAt + samples.size() * 4);
+        REQUIRE(u32(bytes, 4) == bytes.size() - 8);
+        REQUIRE(u32(bytes, 16) == 18);
+        REQUIRE(u16(bytes, 20) == 3);
+        REQUIRE(u16(bytes, 34) == 32);
+        REQUIRE(std::memcmp(bytes.data() + 38, "fact", 4) == 0);
+        REQUIRE(u32(bytes, 46) == samples.size());
+        REQUIRE(u32(bytes, dataAt - 4) == samples.size() * 4);
+        std::vector<float> decoded(samples.size());
+        std::memcpy(decoded.data(), bytes.data() + dataAt, decoded.size() * sizeof(float));
+        REQUIRE(decoded == samples);
+    }
+
+    std::filesystem::remove(path);
 }
 
-TEST_CASE("StringSynthEngine 支持多复音叠加", "[engine-core]") {
-    const double sampleRate = 44100.0;
-    engine::StringSynthEngine engine;
-    engine.setSampleRate(sampleRate);
-    engine.setParam(engine::ParamId::AmpRelease, 0.08f);
-    engine.setParam(engine::ParamId::Decay, 0.995f);
+TEST_CASE("WaveReader 读回 PCM 与浮点 WAV", "[audio][wav]") {
+    std::vector<float> samples(2 * 3001);  // stereo, interleaved
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = 0.8f * std::sin(0.013f * static_cast<float>(i));
+    }
+    const auto path = std::filesystem::temp_directory_path() / "satori_wav_reader_test.wav";
+    std::string error;
 
-    auto toFrames = [sampleRate](double seconds) {
-        return static_cast<std::uint64_t>(
-            std::max(0.0, std::round(seconds * sampleRate)));
+    auto roundTrip = [&](audio::SampleFormat sampleFormat, float tolerance) {
+        audio::WaveFormat format;
+        format.sampleRate = 44100;
+        format.sampleFormat = sampleFormat;
+        format.channels = 2;
+        REQUIRE(audio::WaveWriter().write(path, samples, format, error));
+        audio::WaveData data;
+        REQUIRE(audio::WaveReader().read(path, data, error));
+        REQUIRE(data.sampleRate == 44100u);
+        REQUIRE(data.channels == 2);
+        REQUIRE(data.samples.size() == samples.size());
+        float worst = 0.0f;
+        for (std::size_t i = 0; i < samples.size(); ++i) {
+            worst = std::max(worst, std::abs(data.samples[i] - samples[i]));
+        }
+        REQUIRE(worst <= tolerance);
     };
+    roundTrip(audio::SampleFormat::Int16, 1.0f / 16384.0f);
+    roundTrip(audio::SampleFormat::Int24, 1.0f / 4194304.0f);
+    roundTrip(audio::SampleFormat::Float32, 0.0f);
+    roundTrip(audio::SampleFormat::Float64, 0.0f);
 
-    engine::Event a{};
-    a.type = engine::EventType::NoteOn;
-    a.noteId = 1;
-    a.frequency = 220.0;
-    a.frameOffset = 0;
+    {
+        std::ofstream junk(path, std::ios::binary | std::ios::trunc);
+        junk << "RIFF....WAVEnothing here";
+    }
+    audio::WaveData data;
+    REQUIRE_FALSE(audio::WaveReader().read(path, data, error));
+    REQUIRE_FALSE(error.empty());
+    std::filesystem::remove(path);
+    REQUIRE_FALSE(audio::WaveReader().read(path, data, error));
+}
 
-    engine::Event b = a;
-    b.noteId = 2;
-    b.frequency = 330.0;
-    b.frameOffset = toFrames(0.1);
+namespace {
 
-    engine::Event c = b;
-    c.noteId = 3;
-    c.frequency = 440.0;
-    c.frameOffset = toFrames(0.18);
+// Builds an SMF from raw track bodies (delta-time-prefixed events).
+std::vector<std::uint8_t> MakeMidiFile(std::uint16_t format, std::uint16_t division,
+                                       const std::vector<std::vector<std::uint8_t>>& tracks) {
+    auto putU32 = [](std::vector<std::uint8_t>& out, std::uint32_t v) {
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<std::uint8_t>(v >> shift));
+        }
+    };
+    std::vector<std::uint8_t> bytes = {'M', 'T', 'h', 'd', 0, 0, 0, 6};
+    bytes.push_back(static_cast<std::uint8_t>(format >> 8));
+    bytes.push_back(static_cast<std::uint8_t>(format));
+    bytes.push_back(0);
+    bytes.push_back(static_cast<std::uint8_t>(tracks.size()));
+    bytes.push_back(static_cast<std::uint8_t>(division >> 8));
+    bytes.push_back(static_cast<std::uint8_t>(division));
+    for (const auto& track : tracks) {
+        bytes.insert(bytes.end(), {'M', 'T', 'r', 'k'});
+        putU32(bytes, static_cast<std::uint32_t>(track.size()));
+        bytes.insert(bytes.end(), track.begin(), track.end());
+    }
+    return bytes;
+}
 
-    engine::Event offA{};
-    offA.type = engine::EventType::NoteOff;
-    offA.noteId = 1;
-    offA.frameOffset = toFrames(0.35);
+}  // namespace
 
-    engine::Event offB = offA;
-    offB.noteId = 2;
-    offB.frameOffset = toFrames(0.4);
+TEST_CASE("MidiFileReader 按时间合并音轨并应用速度表", "[audio][midi]") {
+    // Conductor track: 120 bpm, then 60 bpm from beat 2.
+    const std::vector<std::uint8_t> tempo = {0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+                                             0x83, 0x60, 0xFF, 0x51, 0x03, 0x0F, 0x42, 0x40,
+                                             0x00, 0xFF, 0x2F, 0x00};
+    // A note from beat 0 to 1 (running status, velocity-0 off), a SysEx, a
+    // pedal on channel 2, then a note and a bend at beat 3.
+    const std::vector<std::uint8_t> notes = {0x00, 0x90, 60, 100,
+                                             0x83, 0x60, 60, 0,
+                                             0x00, 0xF0, 0x02, 0x01, 0xF7,
+                                             0x00, 0xB1, 64, 127,
+                                             0x87, 0x40, 0x91, 67, 90,
+                                             0x00, 0xE1, 0x00, 0x60,
+                                             0x00, 0xFF, 0x2F, 0x00};
+    audio::MidiFileReader reader;
+    std::string error;
+    REQUIRE(reader.openBytes(MakeMidiFile(1, 480, {tempo, notes}), error));
+    REQUIRE(reader.format() == 1);
+    REQUIRE(reader.trackCount() == 2);
 
-    engine::Event offC = offA;
-    offC.noteId = 3;
-    offC.frameOffset = toFrames(0.45);
+    std::vector<audio::MidiFileEvent> events;
+    for (audio::MidiFileEvent event; reader.next(event);) {
+        events.push_back(event);
+    }
+    REQUIRE(events.size() == 5);
+    REQUIRE(events[0].type() == 0x90);
+    REQUIRE(events[0].seconds == Catch::Approx(0.0));
+    REQUIRE(events[1].type() == 0x90);
+    REQUIRE(events[1].data2 == 0);
+    REQUIRE(events[1].seconds == Catch::Approx(0.5));
+    REQUIRE(events[2].type() == 0xB0);
+    REQUIRE(events[2].channel() == 1);
+    // Beat 1 at 120 bpm is 0.5 s; beats 2 and 3 take a second each at 60 bpm.
+    REQUIRE(events[3].data1 == 67);
+    REQUIRE(events[3].seconds == Catch::Approx(2.5));
+    REQUIRE(events[4].type() == 0xE0);
+    REQUIRE(events[4].data2 == 0x60);
 
-    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.6);
-    auto buffer =
-        renderEngineSequence(engine, {a, b, c, offA, offB, offC}, totalFrames);
+    reader.rewind();
+    audio::MidiFileEvent first;
+    REQUIRE(reader.next(first));
+    REQUIRE(first.data1 == 60);
 
-    const float peak = maxAbs(buffer);
-    INFO("peak=" << peak);
-    REQUIRE(peak > 0.01f);
-    REQUIRE(peak < 1.5f);
+    REQUIRE_FALSE(reader.openBytes({'R', 'I', 'F', 'F', 0, 0, 0, 0}, error));
+    REQUIRE_FALSE(error.empty());
+    // A truncated track ends early instead of reading past the data.
+    auto cut = MakeMidiFile(0, 96, {{0x00, 0x90, 60, 100, 0x60, 0x80, 60}});
+    REQUIRE(reader.openBytes(cut, error));
+    std::size_t count = 0;
+    for (audio::MidiFileEvent event; reader.next(event);) {
+        ++count;
+    }
+    REQUIRE(count == 1);
 }
 
-TEST_CASE("StringSynthEngine 在 voice stealing 下保持稳定输出", "[engine-core]") {
-    const double sampleRate = 48000.0;
-    engine::StringSynthEngine engine;
-    engine.setSampleRate(sampleRate);
-    engine.setParam(engine::ParamId::AmpRelease, 0.02f);
-    engine.setParam(engine::ParamId::Decay, 0.991f);
+namespace {
+audio::OscArgument OscInt(int value) {
+    audio::OscArgument arg;
+    arg.type = 'i';
+    arg.intValue = value;
+    return arg;
+}
+
+audio::OscArgument OscFloat(float value) {
+    audio::OscArgument arg;
+    arg.type = 'f';
+    arg.floatValue = value;
+    return arg;
+}
+
+audio::OscArgument OscString(std::string text) {
+    audio::OscArgument arg;
+    arg.type = 's';
+    arg.text = std::move(text);
+    return arg;
+}
+
+audio::OscMessage OscMsg(std::string address, std::vector<audio::OscArgument> arguments) {
+    audio::OscMessage message;
+    message.address = std::move(address);
+    message.arguments = std::move(arguments);
+    return message;
+}
+}  // namespace
+
+TEST_CASE("OSC 数据包解析消息与嵌套包并保留时间标签", "[audio][osc]") {
+    // "/a" ,if 7 0.5 by hand, per the OSC 1.0 layout.
+    const std::vector<std::uint8_t> raw = {'/', 'a', 0, 0, ',', 'i', 'f', 0, 0, 0, 0, 7,
+                                           0x3F, 0x00, 0x00, 0x00};
+    std::vector<audio::OscMessage> messages;
+    std::string error;
+    REQUIRE(audio::ParseOscPacket(raw.data(), raw.size(), messages, error));
+    REQUIRE(messages.size() == 1);
+    REQUIRE(messages[0].address == "/a");
+    REQUIRE(messages[0].timeTag == audio::kOscImmediately);
+    REQUIRE(messages[0].arguments.size() == 2);
+    REQUIRE(messages[0].arguments[0].asInt() == 7);
+    REQUIRE(messages[0].arguments[1].asFloat() == Catch::Approx(0.5f));
+    REQUIRE(audio::EncodeOscMessage(OscMsg("/a", {OscInt(7), OscFloat(0.5f)})) == raw);
+
+    // A bundle holding a message and a nested bundle with its own tag.
+    auto appendElement = [](std::vector<std::uint8_t>& out, const std::vector<std::uint8_t>& e) {
+        const auto size = static_cast<std::uint32_t>(e.size());
+        out.insert(out.end(), {static_cast<std::uint8_t>(size >> 24),
+                               static_cast<std::uint8_t>(size >> 16),
+                               static_cast<std::uint8_t>(size >> 8),
+                               static_cast<std::uint8_t>(size)});
+        out.insert(out.end(), e.begin(), e.end());
+    };
+    auto bundle = [](std::uint8_t tagByte) {
+        std::vector<std::uint8_t> out = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0,
+                                         0, 0, 0, tagByte, 0, 0, 0, 0};
+        return out;
+    };
+    auto inner = bundle(0x22);
+    appendElement(inner, audio::EncodeOscMessage(OscMsg("/inner", {OscString("decay")})));
+    auto outer = bundle(0x11);
+    appendElement(outer, audio::EncodeOscMessage(OscMsg("/outer", {})));
+    appendElement(outer, inner);
+    messages.clear();
+    REQUIRE(audio::ParseOscPacket(outer.data(), outer.size(), messages, error));
+    REQUIRE(messages.size() == 2);
+    REQUIRE(messages[0].address == "/outer");
+    REQUIRE(messages[0].timeTag == 0x11ull << 32);
+    REQUIRE(messages[1].address == "/inner");
+    REQUIRE(messages[1].timeTag == 0x22ull << 32);
+    REQUIRE(messages[1].arguments.at(0).text == "decay");
+
+    // Truncation keeps what came before and reports the fault.
+    outer.resize(outer.size() - 4);
+    messages.clear();
+    REQUIRE_FALSE(audio::ParseOscPacket(outer.data(), outer.size(), messages, error));
+    REQUIRE_FALSE(error.empty());
+    REQUIRE(messages.size() == 1);
+
+    // 1970-01-01 plus half a second.
+    REQUIRE(audio::OscTimeTagToUnixNanos((2'208'988'800ull << 32) | 0x80000000ull) ==
+            500'000'000);
+}
+
+TEST_CASE("OSC 控制消息映射为音符与参数命令", "[engine-core][osc]") {
+    engine::OscCommand command;
+    std::string error;
+    REQUIRE(engine::DecodeOscCommand(OscMsg("/satori/note/on", {OscInt(69), OscInt(127)}),
+                                     command, error));
+    REQUIRE(command.kind == engine::OscCommand::Kind::NoteOn);
+    REQUIRE(command.note == 69);
+    REQUIRE(command.velocity == Catch::Approx(1.0f));
+    REQUIRE(command.frequency == Catch::Approx(440.0));
+    REQUIRE(engine::DecodeOscCommand(
+        OscMsg("/satori/note/on", {OscInt(60), OscFloat(0.5f), OscFloat(250.0f)}), command,
+        error));
+    REQUIRE(command.velocity == Catch::Approx(0.5f));
+    REQUIRE(command.frequency == Catch::Approx(250.0));
+    // Velocity 0 releases, as in MIDI.
+    REQUIRE(engine::DecodeOscCommand(OscMsg("/satori/note/on", {OscInt(60), OscInt(0)}),
+                                     command, error));
+    REQUIRE(command.kind == engine::OscCommand::Kind::NoteOff);
+
+    REQUIRE(engine::DecodeOscCommand(OscMsg("/satori/param", {OscString("DECAY"), OscFloat(50.0f)}),
+                                     command, error));
+    REQUIRE(command.kind == engine::OscCommand::Kind::Param);
+    REQUIRE(command.param == engine::ParamId::Decay);
+    REQUIRE(command.value == Catch::Approx(engine::GetParamInfo(engine::ParamId::Decay)->maxValue));
+    REQUIRE(engine::DecodeOscCommand(OscMsg("/satori/param/masterGain", {OscFloat(0.25f)}),
+                                     command, error));
+    REQUIRE(command.param == engine::ParamId::MasterGain);
+    REQUIRE(command.value == Catch::Approx(0.25f));
+
+    REQUIRE_FALSE(engine::DecodeOscCommand(OscMsg("/satori/param/nope", {OscFloat(1.0f)}),
+                                           command, error));
+    REQUIRE_FALSE(error.empty());
+    REQUIRE_FALSE(engine::DecodeOscCommand(OscMsg("/satori/note/off", {OscInt(300)}), command,
+                                           error));
+    REQUIRE_FALSE(engine::DecodeOscCommand(OscMsg("/other", {}), command, error));
+}
+
+TEST_CASE("MidiFilePlayer 只在前瞻窗口内向引擎排队事件", "[engine-core][midi]") {
+    // 2000 quarter notes at 120 bpm, 96 ticks per beat: far more than the
+    // engine's queue holds at once.
+    std::vector<std::uint8_t> track;
+    for (int i = 0; i < 2000; ++i) {
+        const auto key = static_cast<std::uint8_t>(48 + i % 24);
+        track.insert(track.end(), {0x00, 0x90, key, 90, 0x60, 0x80, key, 0});
+    }
+    track.insert(track.end(), {0x00, 0xFF, 0x2F, 0x00});
+    engine::MidiFilePlayer player;
+    std::string error;
+    REQUIRE(player.openBytes(MakeMidiFile(0, 96, {track}), error));
+
+    synthesis::StringConfig cfg;
+    cfg.sampleRate = 48000.0;
+    cfg.seed = 5u;
+    engine::StringSynthEngine synth(cfg, 8);
+    synth.setRenderMode(engine::RenderMode::Offline);
+    player.start(synth.renderedFrames(), cfg.sampleRate);
+
+    constexpr std::size_t kFrames = 512;
+    const auto lookahead = static_cast<std::uint64_t>(
+        engine::MidiFilePlayer::kDefaultLookaheadSeconds * cfg.sampleRate);
+    std::vector<float> buffer(kFrames, 0.0f);
+    std::size_t maxQueued = 0;
+    double energy = 0.0;
+    // Ten seconds: twenty notes.
+    for (int b = 0; b < 940; ++b) {
+        player.schedule(synth, synth.renderedFrames() + kFrames + lookahead);
+        maxQueued = std::max(maxQueued, synth.queuedEventCount());
+        synth.process(engine::ProcessBlock{buffer.data(), kFrames, 1});
+        for (float v : buffer) {
+            energy += static_cast<double>(v) * v;
+        }
+    }
+    REQUIRE_FALSE(player.finished());
+    REQUIRE(energy > 0.0);
+    // A quarter second ahead holds one note's on and off at most.
+    REQUIRE(maxQueued <= 4);
+    REQUIRE(player.lastEventFrame() <= synth.renderedFrames() + lookahead);
+
+    player.stop(synth, synth.renderedFrames());
+    REQUIRE(player.finished());
+    for (int b = 0; b < 400; ++b) {
+        synth.process(engine::ProcessBlock{buffer.data(), kFrames, 1});
+    }
+    REQUIRE(synth.activeVoiceCount() == 0);
+}
+
+TEST_CASE("MidiFilePlayer 在 MPE 模式下把成员通道弯音变为每音符表情", "[engine-core][midi][mpe]") {
+    // Channel 2 bends up an octave (+12 of +-48) before its note; the master
+    // channel's full-range bend would only be two semitones.
+    const std::vector<std::uint8_t> track = {0x00, 0xE1, 0x00, 0x50, 0x00, 0x91, 57, 100,
+                                             0x00, 0xFF, 0x2F, 0x00};
+    auto render = [&](bool mpe) {
+        engine::MidiFilePlayer player;
+        std::string error;
+        REQUIRE(player.openBytes(MakeMidiFile(0, 96, {track}), error));
+        player.setMpe(mpe);
+        synthesis::StringConfig cfg;
+        cfg.sampleRate = 48000.0;
+        cfg.decay = 0.999f;
+        cfg.dispersionAmount = 0.0f;
+        engine::StringSynthEngine synth(cfg, 8, 0, 2);
+        synth.setRenderMode(engine::RenderMode::Offline);
+        player.start(0, cfg.sampleRate);
+        player.schedule(synth, 48000);
+        return renderEngineSequence(synth, {}, 24000);
+    };
+    const auto mpe = render(true);
+    const double hz = estimateFundamentalAutocorr(mpe, 48000.0, 440.0);
+    INFO("mpe=" << hz);
+    REQUIRE(std::abs(1200.0 * std::log2(hz / 440.0)) < 3.0);
+    // Without MPE the bend is the part's, at its +-2 semitone range.
+    const auto plain = render(false);
+    const double plainHz = estimateFundamentalAutocorr(plain, 48000.0, 220.0 * std::exp2(0.5 / 12.0));
+    REQUIRE(std::abs(1200.0 * std::log2(plainHz / (220.0 * std::exp2(0.5 / 12.0)))) < 3.0);
+}
+
+TEST_CASE("OutputRecorder 把回调输出写入 WAV 并对写不下的块计数", "[audio][wav][recorder]") {
+    const auto path = std::filesystem::temp_directory_path() / "satori_recorder_test.wav";
+    audio::WaveFormat format;
+    format.sampleRate = 48000;
+    format.sampleFormat = audio::SampleFormat::Float32;
+    format.channels = 2;
+    std::string error;
+
+    SECTION("blocks arrive in order and intact") {
+        engine::OutputRecorder recorder;
+        REQUIRE(recorder.start(path, format, error));
+        REQUIRE(recorder.isRecording());
+        std::vector<float> block(2 * 256);
+        std::vector<float> expected;
+        for (int b = 0; b < 200; ++b) {
+            for (std::size_t i = 0; i < block.size(); ++i) {
+                block[i] = 0.5f * std::sin(0.01f * static_cast<float>(expected.size() + i));
+            }
+            expected.insert(expected.end(), block.begin(), block.end());
+            recorder.push(block.data(), 256, 2);
+        }
+        REQUIRE(recorder.stop(error));
+        REQUIRE_FALSE(recorder.isRecording());
+        REQUIRE(recorder.overruns() == 0);
+        REQUIRE(recorder.framesWritten() == 200u * 256u);
+        // Not recording: ignored, not counted.
+        recorder.push(block.data(), 256, 2);
+        REQUIRE(recorder.overruns() == 0);
+
+        audio::WaveData data;
+        REQUIRE(audio::WaveReader().read(path, data, error));
+        REQUIRE(data.sampleRate == 48000u);
+        REQUIRE(data.channels == 2);
+        REQUIRE(data.samples == expected);
+    }
+
+    SECTION("a full ring or a layout change drops whole blocks") {
+        engine::OutputRecorder recorder(1024);
+        REQUIRE(recorder.start(path, format, error));
+        std::vector<float> block(2 * 1024, 0.25f);
+        recorder.push(block.data(), 1024, 2);  // twice the ring
+        recorder.push(block.data(), 64, 1);
+        recorder.push(block.data(), 128, 2);
+        REQUIRE(recorder.stop(error));
+        REQUIRE(recorder.overruns() == 2);
+        REQUIRE(recorder.framesWritten() == 128u);
+    }
+
+    SECTION("an unwritable path fails up front") {
+        engine::OutputRecorder recorder;
+        REQUIRE_FALSE(recorder.start(path / "missing" / "take.wav", format, error));
+        REQUIRE_FALSE(error.empty());
+        REQUIRE_FALSE(recorder.isRecording());
+        REQUIRE(recorder.stop(error));
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Body 模块在极端参数下保持有限增益", "[engine-body]") {
+    const double sampleRate = 44100.0;
 
     auto toFrames = [sampleRate](double seconds) {
         return static_cast<std::uint64_t>(
             std::max(0.0, std::round(seconds * sampleRate)));
     };
 
-    std::vector<engine::Event> events;
-    const std::vector<double> freqs = {110.0, 140.0, 176.0, 220.0, 261.63,
-                                       330.0, 392.0, 466.0, 523.25, 659.25};
-    int noteId = 1;
-    for (double freq : freqs) {
+    auto renderWithTone = [&](float tone, float size) {
+        // Fixed seed: the energy ratios below compare renders of the same excitation.
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::AmpRelease, 0.08f);
+        engine.setParam(engine::ParamId::BodyTone, tone);
+        engine.setParam(engine::ParamId::BodySize, size);
         engine::Event on{};
         on.type = engine::EventType::NoteOn;
-        on.noteId = noteId;
-        on.frequency = freq;
+        on.noteId = 1;
+        on.frequency = 196.0;
+        on.velocity = 0.9f;
         on.frameOffset = 0;
-        events.push_back(on);
 
         engine::Event off{};
         off.type = engine::EventType::NoteOff;
-        off.noteId = noteId;
-        off.frameOffset = toFrames(0.12 + 0.01 * noteId);
-        events.push_back(off);
-        ++noteId;
-    }
+        off.noteId = 1;
+        off.frameOffset = toFrames(0.12);
 
-    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.4);
-    auto buffer = renderEngineSequence(engine, events, totalFrames);
+        const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.4);
+        return renderEngineSequence(engine, {on, off}, totalFrames);
+    };
 
-    REQUIRE(std::all_of(buffer.begin(), buffer.end(),
-                        [](float s) { return std::isfinite(s); }));
-    const float lateEnergy = rms(buffer, toFrames(0.32), buffer.size());
+    auto neutral = renderWithTone(0.5f, 0.5f);
+    auto bright = renderWithTone(1.0f, 1.0f);
+    auto warm = renderWithTone(0.0f, 0.2f);
+
+    REQUIRE(std::all_of(neutral.begin(), neutral.end(),
+                        [](float v) { return std::isfinite(v); }));
+    REQUIRE(std::all_of(bright.begin(), bright.end(),
+                        [](float v) { return std::isfinite(v); }));
+    REQUIRE(std::all_of(warm.begin(), warm.end(),
+                        [](float v) { return std::isfinite(v); }));
+
+    REQUIRE(maxAbs(neutral) < 2.0f);
+    REQUIRE(maxAbs(bright) < 2.0f);
+    REQUIRE(maxAbs(warm) < 2.0f);
+    const auto energyStart = toFrames(0.05);
+    const auto energyEnd = toFrames(0.2);
+    const float neutralEnergy = rms(neutral, energyStart, energyEnd);
+    const float brightEnergy = rms(bright, energyStart, energyEnd);
+    const float warmEnergy = rms(warm, energyStart, energyEnd);
+
+    REQUIRE(neutralEnergy > 0.0f);
+    REQUIRE(brightEnergy < 2.5f);
+    REQUIRE(warmEnergy < 2.5f);
+    REQUIRE(brightEnergy / neutralEnergy < 2.5f);
+    REQUIRE(warmEnergy / neutralEnergy < 2.5f);
+    REQUIRE(brightEnergy / neutralEnergy > 0.35f);
+    REQUIRE(warmEnergy / neutralEnergy > 0.35f);
+    REQUIRE(brightEnergy != Catch::Approx(warmEnergy));
+}
+
+TEST_CASE("Body 模块可交换进激励并与后置滤波一致", "[engine-body]") {
+    const double sampleRate = 44100.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.3);
+
+    auto render = [&](synthesis::ExcitationType type, float mode, float tone, float size) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        cfg.excitationType = type;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::BodyMode, mode);
+        engine.setParam(engine::ParamId::BodyTone, tone);
+        engine.setParam(engine::ParamId::BodySize, size);
+        REQUIRE(engine.getParam(engine::ParamId::BodyMode) == mode);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 146.8;
+        on.velocity = 0.9f;
+        on.frameOffset = 0;
+        return renderEngineSequence(engine, {on}, totalFrames);
+    };
+
+    // The string and the body are both linear, so moving the body in front
+    // of the string changes little; the pluck's fill wraps around one period.
+    for (const auto type : {synthesis::ExcitationType::Pluck, synthesis::ExcitationType::Hammer}) {
+        INFO("hammer=" << (type == synthesis::ExcitationType::Hammer));
+        const auto post = render(type, 0.0f, 0.0f, 0.1f);
+        const auto commuted = render(type, 1.0f, 0.0f, 0.1f);
+        const auto neutral = render(type, 1.0f, 0.5f, 0.5f);
+        double error = 0.0;
+        double signal = 0.0;
+        double change = 0.0;
+        for (std::size_t i = 0; i < totalFrames; ++i) {
+            error += std::pow(static_cast<double>(post[i] - commuted[i]), 2.0);
+            change += std::pow(static_cast<double>(post[i] - neutral[i]), 2.0);
+            signal += std::pow(static_cast<double>(post[i]), 2.0);
+        }
+        REQUIRE(signal > 0.0);
+        CAPTURE(error / signal, change / signal);
+        REQUIRE(error < 0.01 * signal);
+        REQUIRE(change > 10.0 * error);
+    }
+}
+
+TEST_CASE("ModalBody 各模态按设定频率与衰减谐振", "[dsp][engine-body]") {
+    const double sampleRate = 48000.0;
+    const std::size_t frames = static_cast<std::size_t>(sampleRate * 0.5);
+    auto windowEnergy = [&](const std::vector<float>& x, double from, double to) {
+        double sum = 0.0;
+        for (std::size_t i = static_cast<std::size_t>(from * sampleRate);
+             i < static_cast<std::size_t>(to * sampleRate); ++i) {
+            sum += static_cast<double>(x[i]) * x[i];
+        }
+        return sum;
+    };
+    auto level = [&](const std::vector<float>& x, double hz) {
+        // Goertzel over the first 0.2 s, past the dry impulse.
+        const double w = 2.0 * 3.14159265358979323846 * hz / sampleRate;
+        double s1 = 0.0;
+        double s2 = 0.0;
+        for (std::size_t i = 1; i < static_cast<std::size_t>(0.2 * sampleRate); ++i) {
+            const double s = x[i] + 2.0 * std::cos(w) * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        return s1 * s1 + s2 * s2 - 2.0 * std::cos(w) * s1 * s2;
+    };
+
+    // Five modes: one full lane group plus a partial one.
+    const std::vector<dsp::ModalBody::Mode> modes = {
+        {440.0f, 0.5f, 1.0f}, {700.0f, 0.2f, 0.5f}, {1100.0f, 0.2f, 0.5f},
+        {1500.0f, 0.2f, 0.5f}, {2300.0f, 0.2f, 0.5f},
+    };
+    dsp::ModalBody body;
+    body.setSampleRate(sampleRate);
+    body.setModes(modes);
+    REQUIRE(body.modeCount() == modes.size());
+    std::vector<float> ir(frames);
+    body.impulseResponse(ir.data(), frames);
+    REQUIRE(std::all_of(ir.begin(), ir.end(), [](float v) { return std::isfinite(v); }));
+
+    // Late on only the 440 Hz mode is left: 60 dB per 0.5 s.
+    const double early = windowEnergy(ir, 0.20, 0.25);
+    const double late = windowEnergy(ir, 0.35, 0.40);
+    REQUIRE(10.0 * std::log10(early / late) == Catch::Approx(18.0).margin(1.5));
+    REQUIRE(level(ir, 440.0) > 100.0 * level(ir, 580.0));
+    REQUIRE(level(ir, 2300.0) > 10.0 * level(ir, 1900.0));
+
+    // Block processing matches the one-shot response, and a bigger body
+    // moves the modes down.
+    std::vector<float> blocks(frames, 0.0f);
+    blocks[0] = 1.0f;
+    body.reset();
+    for (std::size_t i = 0; i < frames; i += 100) {
+        body.processBlock(blocks.data() + i, std::min<std::size_t>(100, frames - i));
+    }
+    REQUIRE(blocks == ir);
+    body.setShape(0.5f, 1.0f);
+    body.impulseResponse(ir.data(), frames);
+    REQUIRE(level(ir, 440.0 * std::sqrt(0.5)) > 100.0 * level(ir, 440.0));
+}
+
+TEST_CASE("Body 模块的吉他与筝模态模型保持有限增益并可交换", "[engine-body]") {
+    const double sampleRate = 44100.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.4);
+
+    auto render = [&](float model, float mode) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::BodyModel, model);
+        engine.setParam(engine::ParamId::BodyMode, mode);
+        REQUIRE(engine.getParam(engine::ParamId::BodyModel) == model);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 110.0;
+        on.velocity = 0.9f;
+        on.frameOffset = 0;
+        return renderEngineSequence(engine, {on}, totalFrames);
+    };
+    auto energy = [](const std::vector<float>& a, const std::vector<float>* b) {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            const double d = b ? a[i] - (*b)[i] : a[i];
+            sum += d * d;
+        }
+        return sum;
+    };
+
+    const auto tilt = render(0.0f, 0.0f);
+    for (const float model : {1.0f, 2.0f}) {
+        INFO("model=" << model);
+        const auto modal = render(model, 0.0f);
+        REQUIRE(std::all_of(modal.begin(), modal.end(), [](float v) { return std::isfinite(v); }));
+        REQUIRE(maxAbs(modal) < 2.0f);
+        const double level = energy(modal, nullptr) / energy(tilt, nullptr);
+        REQUIRE(level > 0.35);
+        REQUIRE(level < 2.5);
+        REQUIRE(energy(modal, &tilt) > 0.01 * energy(tilt, nullptr));
+
+        // Commuted, the modes are cut to the note-on response length, so
+        // only roughly the same.
+        const auto commuted = render(model, 1.0f);
+        CAPTURE(energy(commuted, &modal) / energy(modal, nullptr));
+        REQUIRE(energy(commuted, &modal) < 0.15 * energy(modal, nullptr));
+    }
+
+    // A custom table replaces the built-in modes.
+    synthesis::StringConfig cfg;
+    cfg.seed = 2024u;
+    engine::StringSynthEngine engine(cfg);
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::BodyModel, 1.0f);
+    const std::array<dsp::ModalBody::Mode, 1> single = {{{300.0f, 0.3f, 1.5f}}};
+    engine.setBodyModes(single);
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 110.0;
+    on.velocity = 0.9f;
+    on.frameOffset = 0;
+    const auto custom = renderEngineSequence(engine, {on}, totalFrames);
+    REQUIRE(energy(custom, &tilt) > 0.001 * energy(tilt, nullptr));
+    REQUIRE(energy(custom, &tilt) < energy(render(1.0f, 0.0f), &tilt));
+}
+
+TEST_CASE("SympatheticStrings 只在开放弦音高上共振", "[dsp][engine-body]") {
+    const double sampleRate = 48000.0;
+    const std::size_t frames = static_cast<std::size_t>(sampleRate * 0.8);
+    const std::size_t burst = static_cast<std::size_t>(sampleRate * 0.3);
+    auto drive = [&](dsp::SympatheticStrings& bank, double hz) {
+        std::vector<float> x(frames, 0.0f);
+        for (std::size_t i = 0; i < burst; ++i) {
+            x[i] = 0.5f * static_cast<float>(
+                           std::sin(2.0 * 3.14159265358979323846 * hz * i / sampleRate));
+        }
+        bank.reset();
+        for (std::size_t i = 0; i < frames; i += 100) {
+            bank.processBlock(x.data() + i, std::min<std::size_t>(100, frames - i));
+        }
+        return x;
+    };
+
+    dsp::SympatheticStrings bank;
+    bank.setSampleRate(sampleRate);
+    REQUIRE(bank.stringCount() == 6);
+    // Bypassed, the input passes through untouched.
+    auto dry = drive(bank, 110.0);
+    REQUIRE(dry[burst - 1] != 0.0f);
+    REQUIRE(std::all_of(dry.begin() + static_cast<std::ptrdiff_t>(burst), dry.end(),
+                        [](float v) { return v == 0.0f; }));
+
+    // Past the burst only the strings are left; the A string rings on, and
+    // a pitch between the strings barely excites any of them.
+    bank.setAmount(1.0f);
+    const auto open = drive(bank, 110.0);
+    const auto between = drive(bank, 123.0);
+    REQUIRE(std::all_of(open.begin(), open.end(), [](float v) { return std::isfinite(v); }));
+    REQUIRE(maxAbs(open) < 2.0f);
+    const std::size_t tail = burst + static_cast<std::size_t>(0.05 * sampleRate);
+    const double openTail = rms(open, tail, frames);
+    CAPTURE(openTail, rms(between, tail, frames));
+    REQUIRE(openTail > 0.01);
+    REQUIRE(openTail > 10.0 * rms(between, tail, frames));
+    REQUIRE(estimateFundamentalAutocorr(
+                std::vector<float>(open.begin() + static_cast<std::ptrdiff_t>(burst), open.end()),
+                sampleRate, 110.0) == Catch::Approx(110.0).epsilon(0.01));
+
+    // The koto tuning has its own strings: D4 rings, the guitar's A2 does not.
+    bank.setTuning(dsp::SympatheticStrings::PresetTuning(dsp::SympatheticStrings::Preset::Koto));
+    REQUIRE(bank.stringCount() == 13);
+    const double kotoD = rms(drive(bank, 293.66), tail, frames);
+    REQUIRE(kotoD > 10.0 * rms(drive(bank, 110.0), tail, frames));
+}
+
+TEST_CASE("StringSynthEngine 共鸣弦在音符释放后继续发声", "[engine-body]") {
+    const double sampleRate = 44100.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 1.0);
+    auto render = [&](float amount) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::AmpRelease, 0.05f);
+        engine.setParam(engine::ParamId::SympatheticAmount, amount);
+        REQUIRE(engine.stringConfig().sympatheticAmount == amount);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 110.0;
+        on.velocity = 0.9f;
+        on.frameOffset = 0;
+        engine::Event off = on;
+        off.type = engine::EventType::NoteOff;
+        off.frameOffset = static_cast<std::uint64_t>(0.3 * sampleRate);
+        return renderEngineSequence(engine, {on, off}, totalFrames);
+    };
+
+    const auto dry = render(0.0f);
+    const auto wet = render(1.0f);
+    REQUIRE(std::all_of(wet.begin(), wet.end(), [](float v) { return std::isfinite(v); }));
+    REQUIRE(maxAbs(wet) < 2.0f);
+    const auto tail = static_cast<std::size_t>(0.5 * sampleRate);
+    CAPTURE(rms(dry, tail, totalFrames), rms(wet, tail, totalFrames));
+    REQUIRE(rms(wet, tail, totalFrames) > 10.0 * rms(dry, tail, totalFrames));
+}
+
+TEST_CASE("StringSynthEngine 实时输入按 InputMode 经琴体或共鸣弦发声", "[engine-body][live-input]") {
+    const double sampleRate = 44100.0;
+    const std::size_t block = 256;
+    const std::size_t totalFrames = 100 * block;
+    const std::size_t burstFrames = 30 * block;
+    // A stereo capture: a sine burst, then silence.
+    std::vector<float> input(2 * totalFrames, 0.0f);
+    for (std::size_t i = 0; i < burstFrames; ++i) {
+        const float v = 0.4f * std::sin(2.0f * 3.14159265f * 196.0f * static_cast<float>(i) /
+                                        static_cast<float>(sampleRate));
+        input[2 * i] = v;
+        input[2 * i + 1] = v;
+    }
+    auto render = [&](float mode, float gain, float sympathetic, bool planar = false) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::RoomAmount, 0.0f);
+        engine.setParam(engine::ParamId::SympatheticAmount, sympathetic);
+        engine.setParam(engine::ParamId::InputMode, mode);
+        engine.setParam(engine::ParamId::InputGain, gain);
+        std::vector<float> out(totalFrames, 0.0f);
+        std::vector<float> left(block);
+        std::vector<float> right(block);
+        for (std::size_t i = 0; i < totalFrames; i += block) {
+            if (planar) {
+                for (std::size_t f = 0; f < block; ++f) {
+                    left[f] = input[2 * (i + f)];
+                    right[f] = input[2 * (i + f) + 1];
+                }
+                float* channels[] = {out.data() + i};
+                const float* inputs[] = {left.data(), right.data()};
+                engine::PlanarProcessBlock planarBlock{channels, block, 1};
+                planarBlock.inputs = inputs;
+                planarBlock.inputCount = 2;
+                engine.process(planarBlock);
+            } else {
+                engine::ProcessBlock interleaved{out.data() + i, block, 1};
+                interleaved.input = input.data() + 2 * i;
+                interleaved.inputChannels = 2;
+                engine.process(interleaved);
+            }
+        }
+        return out;
+    };
+    const std::size_t steadyFrom = 10 * block;
+    const std::size_t tailFrom = burstFrames + 20 * block;
+
+    // Off by default: the input is ignored.
+    const auto off = render(0.0f, 1.0f, 0.5f);
+    REQUIRE(maxAbs(off) == 0.0f);
+    // Through the body: heard while it plays, scaled by InputGain, and
+    // nothing left once the body has rung out.
+    const auto body = render(1.0f, 1.0f, 0.0f);
+    const auto louder = render(1.0f, 2.0f, 0.0f);
+    REQUIRE(std::all_of(body.begin(), body.end(), [](float v) { return std::isfinite(v); }));
+    REQUIRE(rms(body, steadyFrom, burstFrames) > 0.02);
+    // In lock-step with the capture: the first input sample is heard in the
+    // same frame.
+    const auto heard = std::find_if(body.begin(), body.end(), [](float v) { return v != 0.0f; });
+    REQUIRE(heard - body.begin() == 1);
+    CAPTURE(rms(body, steadyFrom, burstFrames), rms(louder, steadyFrom, burstFrames));
+    REQUIRE(rms(louder, steadyFrom, burstFrames) ==
+            Catch::Approx(2.0 * rms(body, steadyFrom, burstFrames)).epsilon(0.01));
+    REQUIRE(render(1.0f, 1.0f, 0.0f, true) == body);
+    // Exciting the strings: only their resonance, which outlasts the burst.
+    REQUIRE(maxAbs(render(2.0f, 1.0f, 0.0f)) == 0.0f);
+    const auto strings = render(2.0f, 1.0f, 0.8f);
+    CAPTURE(rms(strings, tailFrom, totalFrames), rms(body, tailFrom, totalFrames));
+    REQUIRE(rms(strings, steadyFrom, burstFrames) > 0.0);
+    REQUIRE(rms(strings, tailFrom, totalFrames) > 10.0 * rms(body, tailFrom, totalFrames));
+}
+
+TEST_CASE("StringSynthEngine 切换 InputMode 时实时输入淡入淡出而不跳变", "[engine-body][live-input]") {
+    const double sampleRate = 44100.0;
+    const std::size_t block = 256;
+    const std::size_t totalFrames = 60 * block;
+    std::vector<float> input(totalFrames);
+    for (std::size_t i = 0; i < totalFrames; ++i) {
+        input[i] = 0.4f * std::sin(2.0f * 3.14159265f * 196.0f * static_cast<float>(i) /
+                                   static_cast<float>(sampleRate));
+    }
+    // Mode from each block on; sympathetic strings off, so the strings
+    // route is silent and Body <-> Strings fades the input out and in.
+    auto render = [&](const std::vector<std::pair<std::size_t, float>>& modes) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::RoomAmount, 0.0f);
+        engine.setParam(engine::ParamId::SympatheticAmount, 0.0f);
+        std::vector<float> out(totalFrames, 0.0f);
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < totalFrames; i += block) {
+            if (next < modes.size() && modes[next].first * block == i) {
+                engine.setParam(engine::ParamId::InputMode, modes[next].second);
+                ++next;
+            }
+            engine::ProcessBlock interleaved{out.data() + i, block, 1};
+            interleaved.input = input.data() + i;
+            interleaved.inputChannels = 1;
+            engine.process(interleaved);
+        }
+        return out;
+    };
+    const auto maxStep = [](const std::vector<float>& buffer, std::size_t from) {
+        float step = 0.0f;
+        for (std::size_t i = from + 1; i < buffer.size(); ++i) {
+            step = std::max(step, std::abs(buffer[i] - buffer[i - 1]));
+        }
+        return step;
+    };
+
+    // The steady input through the body sets the largest step a sine gives.
+    const auto steady = render({{0, 1.0f}});
+    const float steadyStep = maxStep(steady, 10 * block);
+    REQUIRE(rms(steady, 10 * block, totalFrames) > 0.02);
+
+    const auto switched =
+        render({{10, 1.0f}, {20, 2.0f}, {30, 1.0f}, {40, 0.0f}, {50, 1.0f}});
+    CAPTURE(steadyStep, maxStep(switched, 0));
+    REQUIRE(maxStep(switched, 0) <= steadyStep * 1.05f);
+    // Each switch takes one segment: on by the next, off after it.
+    REQUIRE(rms(switched, 11 * block, 20 * block) > 0.02);
+    REQUIRE(maxAbs(std::vector<float>(switched.begin() + 21 * block,
+                                      switched.begin() + 30 * block)) < 1e-3f);
+}
+
+TEST_CASE("StringSynthEngine 切换预设在块边界交叉淡入且不打断发声", "[engine-core][preset]") {
+    const double sampleRate = 44100.0;
+    const std::size_t block = 256;
+    auto make = [&] {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        auto engine = std::make_unique<engine::StringSynthEngine>(cfg);
+        engine->setSampleRate(sampleRate);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 110.0;
+        on.velocity = 0.9f;
+        engine->enqueueEventAt(on, 0);
+        return engine;
+    };
+    auto run = [&](engine::StringSynthEngine& engine, std::size_t frames) {
+        std::vector<float> out(frames, 0.0f);
+        for (std::size_t i = 0; i < frames; i += block) {
+            engine.process(engine::ProcessBlock{out.data() + i, block, 1});
+        }
+        return out;
+    };
+    auto switched = make();
+    auto steady = make();
+    REQUIRE(run(*switched, 10 * block) == run(*steady, 10 * block));
+
+    engine::Preset koto;
+    koto.config.bodyModel = synthesis::BodyModel::Koto;
+    koto.config.sympatheticAmount = 0.6f;
+    koto.config.decay = 5.0f;
+    koto.masterGain = 0.8f;
+    // Superseded before process() takes it.
+    engine::Preset skipped = koto;
+    skipped.config.bodyModel = synthesis::BodyModel::Guitar;
+    switched->loadPreset(skipped);
+    switched->loadPreset(koto);
+    // Published at once, clamped.
+    REQUIRE(switched->getParam(engine::ParamId::BodyModel) == Catch::Approx(2.0f));
+    REQUIRE(switched->getParam(engine::ParamId::Decay) == Catch::Approx(0.999f));
+    REQUIRE(switched->getParam(engine::ParamId::MasterGain) == Catch::Approx(0.8f));
+
+    // The crossfade starts from the old body, so the first sample carries on.
+    const auto a = run(*switched, 20 * block);
+    const auto b = run(*steady, 20 * block);
+    REQUIRE(b[0] != 0.0f);
+    REQUIRE(a[0] == Catch::Approx(b[0]).margin(1e-3));
+    double diff = 0.0;
+    for (std::size_t i = 10 * block; i < a.size(); ++i) {
+        diff = std::max(diff, static_cast<double>(std::abs(a[i] - b[i])));
+    }
+    REQUIRE(diff > 1e-3);
+    REQUIRE(std::all_of(a.begin(), a.end(), [](float v) { return std::isfinite(v); }));
+    REQUIRE(switched->activeVoiceCount() == 1);
+    REQUIRE(switched->stringConfig().bodyModel == synthesis::BodyModel::Koto);
+}
+
+TEST_CASE("调制矩阵按控制速率推进声源并跳过无效路由", "[engine-core][modulation]") {
+    engine::ModulationSettings settings;
+    settings.envelope.attackSeconds = 0.01f;
+    settings.envelope.sustain = 0.5f;
+    REQUIRE(settings.addRoute(engine::ModSource::Velocity, engine::ModTarget::Decay, 0.01f));
+    REQUIRE(settings.addRoute(engine::ModSource::Envelope, engine::ModTarget::Brightness, 0.4f));
+    REQUIRE(settings.addRoute(engine::ModSource::Lfo1, engine::ModTarget::Decay, 0.0f));
+    engine::ModulationMatrix matrix;
+    REQUIRE_FALSE(matrix.active());
+    matrix.configure(settings, 44100.0);
+    REQUIRE(matrix.active());
+
+    engine::ModulationMatrix::VoiceState state;
+    matrix.startVoice(state, 0.5f, 440.0);
+    REQUIRE(engine::ModulationMatrix::Offset(state, engine::ModTarget::Decay) ==
+            Catch::Approx(0.005f));
+    REQUIRE(engine::ModulationMatrix::Offset(state, engine::ModTarget::Brightness) == 0.0f);
+    // 10 ms of attack is ~14 ticks; then it settles on the sustain level.
+    for (int i = 0; i < 20; ++i) {
+        matrix.tick(state);
+    }
+    REQUIRE(state.envelope < 1.0f);
+    REQUIRE_FALSE(state.attacking);
+    for (int i = 0; i < 6000; ++i) {
+        matrix.tick(state);
+    }
+    REQUIRE(engine::ModulationMatrix::Offset(state, engine::ModTarget::Brightness) ==
+            Catch::Approx(0.2f).margin(1e-3));
+    REQUIRE(engine::ModulationMatrix::Offset(state, engine::ModTarget::PickPosition) == 0.0f);
+
+    for (std::size_t i = 3; i < engine::kMaxModRoutes; ++i) {
+        REQUIRE(settings.addRoute(engine::ModSource::KeyTrack, engine::ModTarget::Decay, 0.1f));
+    }
+    REQUIRE_FALSE(settings.addRoute(engine::ModSource::KeyTrack, engine::ModTarget::Decay, 0.1f));
+}
+
+TEST_CASE("StringSynthEngine 调制矩阵按控制速率驱动声部参数", "[engine-core][modulation]") {
+    const double sampleRate = 44100.0;
+    auto render = [&](const engine::ModulationSettings* settings, std::size_t block) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 99u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        if (settings) {
+            engine.setModulation(*settings);
+        }
+        for (int n = 0; n < 3; ++n) {
+            engine::Event on{};
+            on.type = engine::EventType::NoteOn;
+            on.noteId = n;
+            on.frequency = 110.0 * (n + 1);
+            on.velocity = 0.8f;
+            engine.enqueueEventAt(on, static_cast<std::uint64_t>(n) * 300);
+        }
+        std::vector<float> out(static_cast<std::size_t>(sampleRate * 0.5), 0.0f);
+        for (std::size_t i = 0; i < out.size(); i += block) {
+            const std::size_t frames = std::min(block, out.size() - i);
+            engine.process(engine::ProcessBlock{out.data() + i, frames, 1});
+        }
+        return out;
+    };
+    const auto plain = render(nullptr, 256);
+    // Routes with no amount leave the voices as they were.
+    engine::ModulationSettings idle;
+    idle.addRoute(engine::ModSource::Lfo1, engine::ModTarget::Brightness, 0.0f);
+    REQUIRE(render(&idle, 256) == plain);
+
+    engine::ModulationSettings wobble;
+    wobble.lfos[0].rateHz = 6.0f;
+    wobble.addRoute(engine::ModSource::Lfo1, engine::ModTarget::Brightness, 0.4f);
+    wobble.addRoute(engine::ModSource::Envelope, engine::ModTarget::Decay, -0.05f);
+    wobble.addRoute(engine::ModSource::Velocity, engine::ModTarget::PickPosition, -0.3f);
+    const auto modulated = render(&wobble, 256);
+    REQUIRE(std::all_of(modulated.begin(), modulated.end(),
+                        [](float v) { return std::isfinite(v); }));
+    double diff = 0.0;
+    for (std::size_t i = 0; i < plain.size(); ++i) {
+        diff = std::max(diff, static_cast<double>(std::abs(modulated[i] - plain[i])));
+    }
+    REQUIRE(diff > 1e-3);
+    // Ticks fall on the same frames whatever the host block size is.
+    const auto odd = render(&wobble, 100);
+    for (std::size_t i = 0; i < odd.size(); ++i) {
+        REQUIRE(odd[i] == Catch::Approx(modulated[i]).margin(1e-5));
+    }
+}
+
+TEST_CASE("StringSynthEngine 声部按音高声像并保持总能量", "[engine-core][stereo]") {
+    const double sampleRate = 44100.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.5);
+    auto render = [&](double frequency, float spread, float bodyModel = 0.0f) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 2024u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::StereoSpread, spread);
+        engine.setParam(engine::ParamId::BodyModel, bodyModel);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = frequency;
+        on.velocity = 1.0f;
+        on.frameOffset = 0;
+        return renderEngineSequence(engine, {on}, totalFrames, 2);
+    };
+    auto channel = [](const std::vector<float>& frames, std::size_t ch) {
+        std::vector<float> out(frames.size() / 2);
+        for (std::size_t i = 0; i < out.size(); ++i) {
+            out[i] = frames[i * 2 + ch];
+        }
+        return out;
+    };
+    auto energy = [](const std::vector<float>& x) {
+        double sum = 0.0;
+        for (float v : x) {
+            sum += static_cast<double>(v) * v;
+        }
+        return sum;
+    };
+
+    // No spread: a mono bus, both sides bit for bit the same.
+    const auto centred = render(55.0, 0.0f);
+    REQUIRE(channel(centred, 0) == channel(centred, 1));
+
+    // Low notes go left and high notes right; the pan law keeps the power.
+    const auto low = render(55.0, 1.0f);
+    const auto high = render(1760.0, 1.0f);
+    const double lowL = energy(channel(low, 0));
+    const double lowR = energy(channel(low, 1));
+    REQUIRE(lowL > 4.0 * lowR);
+    REQUIRE(energy(channel(high, 1)) > 4.0 * energy(channel(high, 0)));
+    REQUIRE(lowL + lowR == Catch::Approx(energy(centred)).epsilon(0.01));
+
+    // Modal bodies run one state per side and stay bounded.
+    for (const float model : {1.0f, 2.0f}) {
+        INFO("model=" << model);
+        const auto modal = render(55.0, 1.0f, model);
+        REQUIRE(std::all_of(modal.begin(), modal.end(), [](float v) { return std::isfinite(v); }));
+        REQUIRE(maxAbs(modal) < 2.0f);
+        REQUIRE(energy(channel(modal, 0)) > 4.0 * energy(channel(modal, 1)));
+    }
+
+    // Narrowing to zero mid-note glides back to the middle within a block,
+    // and the two sides of the body converge once they share an input.
+    synthesis::StringConfig cfg;
+    cfg.seed = 2024u;
+    engine::StringSynthEngine engine(cfg);
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::StereoSpread, 1.0f);
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 55.0;
+    on.velocity = 1.0f;
+    on.frameOffset = 0;
+    engine::Event narrow{};
+    narrow.type = engine::EventType::ParamChange;
+    narrow.param = engine::ParamId::StereoSpread;
+    narrow.paramValue = 0.0f;
+    narrow.frameOffset = totalFrames / 2;
+    const auto glide = renderEngineSequence(engine, {on, narrow}, totalFrames, 2);
+    const auto left = channel(glide, 0);
+    const auto right = channel(glide, 1);
+    const std::size_t settled = totalFrames / 2 + 256;
+    REQUIRE(rms(left, 0, totalFrames / 2) > 2.0f * rms(right, 0, totalFrames / 2));
+    float largestGap = 0.0f;
+    for (std::size_t i = settled + 256; i < totalFrames; ++i) {
+        largestGap = std::max(largestGap, std::abs(left[i] - right[i]));
+    }
+    REQUIRE(largestGap < 1e-4f * maxAbs(left));
+    float largestStep = 0.0f;
+    for (std::size_t i = totalFrames / 2 - 8; i < settled; ++i) {
+        largestStep = std::max(largestStep, std::abs(right[i + 1] - right[i]));
+    }
+    REQUIRE(largestStep < 0.25f);
+}
+
+TEST_CASE("StringSynthEngine 双弦组共用激励且可快照恢复", "[engine-core][course]") {
+    const double sampleRate = 44100.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.5);
+    auto render = [&](synthesis::ExcitationType type, float detune) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 77u;
+        cfg.excitationType = type;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::CourseDetune, detune);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 220.0;
+        on.velocity = 0.9f;
+        on.frameOffset = 0;
+        return renderEngineSequence(engine, {on}, totalFrames, 1);
+    };
+
+    for (const auto type : {synthesis::ExcitationType::Pluck, synthesis::ExcitationType::Hammer}) {
+        INFO("type=" << static_cast<int>(type));
+        // The course takes the excitation the string drew, not its own noise.
+        synthesis::StringConfig cfg;
+        cfg.seed = 77u;
+        cfg.sampleRate = sampleRate;
+        cfg.excitationType = type;
+        synthesis::KarplusStrongString string(cfg);
+        synthesis::KarplusStrongString course(cfg);
+        string.start(220.0, 0.9f);
+        string.start(220.0, 0.9f);  // past the course's first draw
+        course.startCourse(string, 220.0);
+        REQUIRE(course.excitationBufferPreview() == string.excitationBufferPreview());
+        course.start(220.0, 0.9f);
+        REQUIRE(course.excitationBufferPreview() != string.excitationBufferPreview());
+
+        const auto single = render(type, 0.0f);
+        // A barely detuned pair averages back to the single string.
+        const auto unison = render(type, 0.01f);
+        float largestGap = 0.0f;
+        for (std::size_t i = 0; i < totalFrames / 10; ++i) {
+            largestGap = std::max(largestGap, std::abs(unison[i] - single[i]));
+        }
+        REQUIRE(largestGap < 0.05f * maxAbs(single));
+        // A real detune beats away from it and keeps the level.
+        const auto doubled = render(type, 8.0f);
+        REQUIRE(std::all_of(doubled.begin(), doubled.end(), [](float v) { return std::isfinite(v); }));
+        REQUIRE(doubled != single);
+        const float level = rms(doubled, 0, totalFrames / 10) / rms(single, 0, totalFrames / 10);
+        REQUIRE(level > 0.7f);
+        REQUIRE(level < 1.2f);
+    }
+
+    // Both strings of the pair go into a snapshot and continue sample for
+    // sample, restruck or not.
+    constexpr std::size_t kBlock = 256;
+    synthesis::StringConfig cfg;
+    cfg.seed = 19u;
+    cfg.courseDetuneCents = 6.0f;
+    auto renderBlocks = [](engine::StringSynthEngine& engine, std::size_t blocks) {
+        std::vector<float> out(blocks * kBlock * 2, 0.0f);
+        for (std::size_t b = 0; b < blocks; ++b) {
+            engine.process(engine::ProcessBlock{out.data() + b * kBlock * 2, kBlock, 2});
+        }
+        return out;
+    };
+    engine::StringSynthEngine source(cfg, 8);
+    source.setParam(engine::ParamId::SustainPedal, 1.0f);
+    source.noteOn(1, 130.8, 0.8f);
+    source.noteOn(2, 2093.0, 0.7f);  // oversampled
+    source.noteOff(1);
+    renderBlocks(source, 6);
+    source.noteOn(1, 130.8, 0.6f);  // pedalled repeat: a restrike
+    renderBlocks(source, 2);
+    const std::vector<std::uint8_t> snapshot = source.saveSnapshot();
+    engine::StringSynthEngine restored(cfg, 8);
+    restored.setParam(engine::ParamId::SustainPedal, 1.0f);
+    std::string error;
+    REQUIRE(restored.restoreSnapshot(snapshot, error));
+    const auto expected = renderBlocks(source, 16);
+    REQUIRE(maxAbs(expected) > 0.0f);
+    REQUIRE(renderBlocks(restored, 16) == expected);
+}
+
+TEST_CASE("StringSynthEngine 多音色分部共享房间且互不干扰", "[engine-core][parts]") {
+    const double sampleRate = 44100.0;
+    const std::size_t totalFrames = 12000;
+    synthesis::StringConfig guitar;
+    guitar.seed = 11u;
+    guitar.sampleRate = sampleRate;
+    synthesis::StringConfig koto = guitar;
+    koto.seed = 29u;
+    koto.decay = 0.99f;
+    koto.bodyModel = synthesis::BodyModel::Koto;
+    koto.sympatheticAmount = 0.5f;
+    auto note = [](int noteId, double frequency, std::size_t part) {
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = noteId;
+        on.frequency = frequency;
+        on.velocity = 0.8f;
+        on.frameOffset = 0;
+        on.part = part;
+        return on;
+    };
+    auto solo = [&](const synthesis::StringConfig& cfg, double frequency) {
+        engine::StringSynthEngine engine(cfg);
+        return renderEngineSequence(engine, {note(1, frequency, 0)}, totalFrames);
+    };
+
+    // Both parts use note id 1; with the room dry the mix is the two
+    // instruments played alone, summed.
+    engine::StringSynthEngine layered(guitar, engine::StringSynthEngine::kDefaultMaxVoices, 0, 2);
+    REQUIRE(layered.partCount() == 2);
+    layered.setPartConfig(1, koto);
+    const auto mix =
+        renderEngineSequence(layered, {note(1, 110.0, 0), note(1, 293.66, 1)}, totalFrames);
+    REQUIRE(layered.activeVoiceCount() == 2);
+    const auto a = solo(guitar, 110.0);
+    const auto b = solo(koto, 293.66);
+    float largestError = 0.0f;
+    for (std::size_t i = 0; i < totalFrames; ++i) {
+        largestError = std::max(largestError, std::abs(mix[i] - (a[i] + b[i])));
+    }
+    REQUIRE(maxAbs(b) > 0.0f);
+    REQUIRE(largestError < 1e-5f * maxAbs(mix));
+
+    // Parameters stay in their part, except the room's, which are shared.
+    REQUIRE(layered.partConfig(1).bodyModel == synthesis::BodyModel::Koto);
+    REQUIRE(layered.stringConfig().bodyModel == guitar.bodyModel);
+    layered.setPartParam(1, engine::ParamId::Decay, 0.95f);
+    REQUIRE(layered.getPartParam(1, engine::ParamId::Decay) == Catch::Approx(0.95f));
+    REQUIRE(layered.getParam(engine::ParamId::Decay) == Catch::Approx(guitar.decay));
+    layered.setPartParam(1, engine::ParamId::RoomAmount, 0.4f);
+    REQUIRE(layered.getParam(engine::ParamId::RoomAmount) == Catch::Approx(0.4f));
+    REQUIRE(layered.partConfig(1).roomAmount == Catch::Approx(0.4f));
+
+    // Parts that do not exist are turned away.
+    REQUIRE_FALSE(layered.enqueueEventAt(note(2, 220.0, 2), 0));
+    REQUIRE(layered.getPartParam(2, engine::ParamId::Decay) == 0.0f);
+    engine::StringSynthEngine crowded(guitar, 4, 0, 100);
+    REQUIRE(crowded.partCount() == engine::StringSynthEngine::kMaxParts);
+}
+
+TEST_CASE("StringSynthEngine 分轨输出与混音同帧渲染且相加一致", "[engine-core][stems]") {
+    constexpr std::size_t kFrames = 8192;
+    constexpr std::size_t kBlock = 256;
+    for (const float roomType : {0.0f, 1.0f}) {
+        INFO("roomType=" << roomType);
+        const auto makeEngine = [&] {
+            synthesis::StringConfig cfg;
+            cfg.seed = 13u;
+            cfg.sampleRate = 44100.0;
+            cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+            cfg.sympatheticAmount = 0.5f;
+            cfg.bodyModel = synthesis::BodyModel::Guitar;
+            auto engine = std::make_unique<engine::StringSynthEngine>(
+                cfg, engine::StringSynthEngine::kDefaultMaxVoices, 0, 2);
+            engine->setRenderMode(engine::RenderMode::Offline);
+            engine->setParam(engine::ParamId::RoomType, roomType);
+            engine->setParam(engine::ParamId::RoomAmount, 0.4f);
+            engine->setParam(engine::ParamId::StereoSpread, 0.8f);
+            engine->noteOn(1, 196.0, 0.8f, 0.0, 0);
+            engine->noteOn(2, 329.63, 0.7f, 0.0, 1);
+            return engine;
+        };
+
+        auto plainEngine = makeEngine();
+        auto stemEngine = makeEngine();
+        std::vector<float> plain(kFrames * 2);
+        std::vector<float> mix(kFrames * 2);
+        // strings, body, room, part 0, part 1; left then right.
+        std::vector<std::vector<float>> stems(10, std::vector<float>(kFrames));
+        for (std::size_t cursor = 0; cursor < kFrames; cursor += kBlock) {
+            plainEngine->process(engine::ProcessBlock{plain.data() + cursor * 2, kBlock, 2});
+            const auto pair = [&](std::size_t s) {
+                return engine::StemOutputs::Pair{stems[2 * s].data() + cursor,
+                                                 stems[2 * s + 1].data() + cursor};
+            };
+            engine::StemOutputs outputs;
+            outputs.strings = pair(0);
+            outputs.body = pair(1);
+            outputs.room = pair(2);
+            outputs.parts[0] = pair(3);
+            outputs.parts[1] = pair(4);
+            stemEngine->process(engine::ProcessBlock{mix.data() + cursor * 2, kBlock, 2}, outputs);
+        }
+
+        // Rendering stems leaves the mix alone.
+        REQUIRE(mix == plain);
+        float stemError = 0.0f;
+        float partError = 0.0f;
+        for (std::size_t i = 0; i < kFrames; ++i) {
+            for (std::size_t ch = 0; ch < 2; ++ch) {
+                const float out = mix[i * 2 + ch];
+                const float room = stems[4 + ch][i];
+                stemError = std::max(
+                    stemError, std::abs(out - (stems[ch][i] + stems[2 + ch][i] + room)));
+                partError = std::max(
+                    partError, std::abs(out - (stems[6 + ch][i] + stems[8 + ch][i] + room)));
+            }
+        }
+        const float peak = maxAbs(mix);
+        REQUIRE(peak > 0.0f);
+        REQUIRE(stemError < 1e-5f * std::max(1.0f, peak));
+        REQUIRE(partError < 1e-5f * std::max(1.0f, peak));
+        for (const std::size_t s : {0, 2, 4, 6, 8}) {
+            INFO("stem " << s);
+            REQUIRE(maxAbs(stems[s]) > 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("Room 模块提供可控的立体扩展", "[engine-room]") {
+    const double sampleRate = 48000.0;
+
+    auto toFrames = [sampleRate](double seconds) {
+        return static_cast<std::uint64_t>(
+            std::max(0.0, std::round(seconds * sampleRate)));
+    };
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 330.0;
+    on.velocity = 0.7f;
+    on.frameOffset = 0;
+
+    engine::Event off{};
+    off.type = engine::EventType::NoteOff;
+    off.noteId = 1;
+    off.frameOffset = toFrames(0.2);
+
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.5);
+
+    auto stereoRms = [](const std::vector<float>& buffer, std::size_t startFrame,
+                        std::size_t endFrame) {
+        if (buffer.size() < 2) {
+            return 0.0f;
+        }
+        const std::size_t totalFrames = buffer.size() / 2;
+        const std::size_t clampedEnd = std::min(endFrame, totalFrames);
+        double sum = 0.0;
+        std::size_t count = 0;
+        for (std::size_t frame = startFrame; frame < clampedEnd; ++frame) {
+            const std::size_t idx = frame * 2;
+            if (idx + 1 >= buffer.size()) {
+                break;
+            }
+            const float mono = 0.5f * (buffer[idx] + buffer[idx + 1]);
+            sum += static_cast<double>(mono) * static_cast<double>(mono);
+            ++count;
+        }
+        if (count == 0) {
+            return 0.0f;
+        }
+        return static_cast<float>(std::sqrt(sum / static_cast<double>(count)));
+    };
+
+    auto renderWithRoom = [&](float amount) {
+        engine::StringSynthEngine engine;
+        engine.setSampleRate(sampleRate);
+        // Make excitation deterministic to avoid flaky energy/peak assertions.
+        auto cfg = engine.stringConfig();
+        cfg.seed = 1234;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine.setConfig(cfg);
+        engine.setParam(engine::ParamId::RoomAmount, amount);
+        return renderEngineSequence(engine, {on, off}, totalFrames, 2);
+    };
+
+    auto dry = renderWithRoom(0.0f);
+    auto wet = renderWithRoom(1.0f);
+
+    REQUIRE(std::all_of(dry.begin(), dry.end(),
+                        [](float v) { return std::isfinite(v); }));
+    REQUIRE(std::all_of(wet.begin(), wet.end(),
+                        [](float v) { return std::isfinite(v); }));
+
+    const auto energyStart = toFrames(0.05);
+    const auto energyEnd = toFrames(0.25);
+    const float dryEnergy = stereoRms(dry, energyStart, energyEnd);
+    const float wetEnergy = stereoRms(wet, energyStart, energyEnd);
+    auto stereoSideRms = [](const std::vector<float>& buffer, std::size_t startFrame,
+                            std::size_t endFrame) {
+        if (buffer.size() < 2) {
+            return 0.0f;
+        }
+        const std::size_t totalFrames = buffer.size() / 2;
+        const std::size_t clampedEnd = std::min(endFrame, totalFrames);
+        double sum = 0.0;
+        std::size_t count = 0;
+        for (std::size_t frame = startFrame; frame < clampedEnd; ++frame) {
+            const std::size_t idx = frame * 2;
+            if (idx + 1 >= buffer.size()) {
+                break;
+            }
+            const double side = static_cast<double>(buffer[idx] - buffer[idx + 1]);
+            sum += side * side;
+            ++count;
+        }
+        if (count == 0) {
+            return 0.0f;
+        }
+        return static_cast<float>(std::sqrt(sum / static_cast<double>(count)));
+    };
+    const float wetSide = stereoSideRms(wet, energyStart, energyEnd);
+
+    REQUIRE(dryEnergy > 0.0f);
+    REQUIRE(wetEnergy > 0.0f);
+    // Wet energy should stay in the same order of magnitude as dry.
+    REQUIRE(wetEnergy < dryEnergy * 6.0f);
+    REQUIRE(wetEnergy > dryEnergy * 0.1f);
+    // Stereo width should be present in the wet signal.
+    REQUIRE(wetSide > wetEnergy * 0.01f);
+
+    float leftPeak = 0.0f;
+    float rightPeak = 0.0f;
+    for (std::size_t frame = 0; frame + 1 < wet.size() / 2; ++frame) {
+        const std::size_t idx = frame * 2;
+        leftPeak = std::max(leftPeak, std::abs(wet[idx]));
+        rightPeak = std::max(rightPeak, std::abs(wet[idx + 1]));
+    }
+    REQUIRE(leftPeak > 0.001f);
+    REQUIRE(rightPeak > 0.001f);
+}
+
+TEST_CASE("RoomIrLibrary 提供构建期生成的包络、能量衰减曲线与 RT60", "[engine-room][ir]") {
+    const auto& irs = dsp::RoomIrLibrary::list();
+    REQUIRE_FALSE(irs.empty());
+    for (std::size_t i = 0; i < irs.size(); ++i) {
+        INFO("ir=" << irs[i].id);
+        const auto preview = dsp::RoomIrLibrary::preview(static_cast<int>(i));
+        REQUIRE(preview.waveformCount > 0);
+        REQUIRE(preview.envelopeCount > 0);
+        REQUIRE(preview.durationSeconds > 0.0f);
+
+        // The EDC starts at the total energy and can only fall.
+        REQUIRE(preview.edcDb[0] == Catch::Approx(0.0f).margin(1e-4f));
+        for (std::size_t p = 0; p < preview.envelopeCount; ++p) {
+            REQUIRE(preview.envelopeDb[p] <= 1e-4f);
+            if (p > 0) {
+                REQUIRE(preview.edcDb[p] <= preview.edcDb[p - 1] + 1e-4f);
+            }
+        }
+        const float lastEdc = preview.edcDb[preview.envelopeCount - 1];
+        if (lastEdc < -15.0f) {
+            REQUIRE(preview.rt60Seconds > 0.0f);
+            REQUIRE(std::isfinite(preview.rt60Seconds));
+        }
+    }
+    REQUIRE(dsp::RoomIrLibrary::preview(-1).empty());
+    REQUIRE(dsp::RoomIrLibrary::preview(static_cast<int>(irs.size())).empty());
+}
+
+TEST_CASE("RoomIrLibrary 样本按需解码且指针保持不变", "[engine-room][ir]") {
+    // Holds for either SATORI_IR_STORAGE: packed IRs are decoded once.
+    const auto& irs = dsp::RoomIrLibrary::list();
+    for (std::size_t i = 0; i < irs.size(); ++i) {
+        INFO("ir=" << irs[i].id);
+        const int index = static_cast<int>(i);
+        const auto first = dsp::RoomIrLibrary::samples(index);
+        const auto again = dsp::RoomIrLibrary::samples(index);
+        REQUIRE(first.left != nullptr);
+        REQUIRE(first.left == again.left);
+        REQUIRE(first.right == again.right);
+        REQUIRE(first.frameCount == irs[i].frameCount);
+        REQUIRE((first.right != nullptr) == (irs[i].channels == 2));
+
+        float peak = 0.0f;
+        for (std::size_t f = 0; f < first.frameCount; ++f) {
+            peak = std::max(peak, std::abs(first.left[f]));
+            if (first.right) {
+                peak = std::max(peak, std::abs(first.right[f]));
+            }
+        }
+        REQUIRE(peak == Catch::Approx(0.95f).margin(1e-3f));
+
+        std::size_t monoCount = 0;
+        REQUIRE(dsp::RoomIrLibrary::samplesMono(index, &monoCount, nullptr) == first.left);
+        REQUIRE(monoCount == first.frameCount);
+    }
+    REQUIRE(dsp::RoomIrLibrary::samples(static_cast<int>(irs.size())).left == nullptr);
+}
+
+TEST_CASE("StringSynthEngine 离线模式同步渲染混响尾部且可复现", "[engine-room]") {
+    const double sampleRate = 48000.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 1.0);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 220.0;
+    on.velocity = 0.8f;
+
+    engine::Event off{};
+    off.type = engine::EventType::NoteOff;
+    off.noteId = 1;
+    off.frameOffset = static_cast<std::uint64_t>(sampleRate * 0.1);
+
+    auto render = [&](float room, engine::RoomTelemetry* telemetry) {
+        engine::StringSynthEngine engine;
+        engine.setRenderMode(engine::RenderMode::Offline);
+        REQUIRE(engine.renderMode() == engine::RenderMode::Offline);
+        engine.setSampleRate(sampleRate);
+        auto cfg = engine.stringConfig();
+        cfg.seed = 99;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine.setConfig(cfg);
+        engine.setParam(engine::ParamId::AmpRelease, 0.05f);
+        engine.setParam(engine::ParamId::RoomAmount, room);
+        auto out = renderEngineSequence(engine, {on, off}, totalFrames, 2, 333);
+        if (telemetry) {
+            *telemetry = engine.roomTelemetry();
+        }
+        return out;
+    };
+
+    engine::RoomTelemetry telemetry;
+    telemetry.lateBlocks = 1;
+    const auto first = render(1.0f, &telemetry);
+    const auto second = render(1.0f, nullptr);
+    const auto dry = render(0.0f, nullptr);
+
+    // No worker in the loop: identical output every time, never a late block.
+    REQUIRE(telemetry.lateBlocks == 0);
+    REQUIRE(telemetry.droppedDryBlocks == 0);
+    REQUIRE(telemetry.droppedWetBlocks == 0);
+    // Each block is rendered at the next boundary, so at most one waits.
+    REQUIRE(telemetry.dryQueueHighWater == 1);
+    REQUIRE(telemetry.wetQueueHighWater >= 1);
+    REQUIRE(telemetry.tailBlocks + 1 >= totalFrames / 256);
+    REQUIRE(telemetry.tailBlockUsMax >= telemetry.tailBlockUsP99);
+    REQUIRE(telemetry.tailBlockUsMean > 0.0);
+    REQUIRE(first == second);
+
+    // The head answers at once and the tail rings on after the dry note dies.
+    auto segmentRms = [&](const std::vector<float>& buffer, double from, double to) {
+        return rms(buffer, static_cast<std::size_t>(from * sampleRate) * 2,
+                   static_cast<std::size_t>(to * sampleRate) * 2);
+    };
+    REQUIRE(segmentRms(first, 0.0, 0.005) > 0.0f);
+    const float wetTail = segmentRms(first, 0.4, 0.6);
+    const float dryTail = segmentRms(dry, 0.4, 0.6);
+    INFO("wetTail=" << wetTail << " dryTail=" << dryTail);
+    REQUIRE(wetTail > 1e-4f);
+    REQUIRE(wetTail > dryTail * 10.0f);
+}
+
+TEST_CASE("StringSynthEngine 混响量为零时挂起尾部并预热恢复", "[engine-room]") {
+    const double sampleRate = 48000.0;
+    const std::size_t bypassFrames = static_cast<std::size_t>(sampleRate * 0.3);
+    const std::size_t resumeFrames = static_cast<std::size_t>(sampleRate * 0.2);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 220.0;
+    on.velocity = 0.8f;
+
+    engine::StringSynthEngine engine;
+    engine.setRenderMode(engine::RenderMode::Offline);
+    engine.setSampleRate(sampleRate);
+    auto cfg = engine.stringConfig();
+    cfg.seed = 5;
+    cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    engine.setConfig(cfg);
+    engine.setParam(engine::ParamId::RoomAmount, 0.0f);
+
+    const auto bypassed = renderEngineSequence(engine, {on}, bypassFrames, 2);
+    const auto parked = engine.roomTelemetry();
+    REQUIRE(parked.suspended);
+    REQUIRE(parked.tailBlocks == 0);
+    for (std::size_t f = 0; f < bypassFrames; ++f) {
+        REQUIRE(bypassed[f * 2] == bypassed[f * 2 + 1]);
+    }
+
+    engine.setParam(engine::ParamId::RoomAmount, 0.8f);
+    const auto resumed = renderEngineSequence(engine, {}, resumeFrames, 2);
+    const auto running = engine.roomTelemetry();
+    REQUIRE_FALSE(running.suspended);
+    REQUIRE(running.tailBlocks > 0);
+
+    // The mix ramps in over a head already holding the sounding note, so the
+    // block across the switch steps no further than the dry signal did.
+    auto maxStep = [](const std::vector<float>& buffer, std::size_t from, std::size_t to,
+                      float previous) {
+        float step = 0.0f;
+        for (std::size_t f = from; f < to; ++f) {
+            step = std::max(step, std::abs(buffer[f * 2] - previous));
+            previous = buffer[f * 2];
+        }
+        return step;
+    };
+    const float dryStep =
+        maxStep(bypassed, bypassFrames - 2048, bypassFrames, bypassed[(bypassFrames - 2049) * 2]);
+    const float switchStep = maxStep(resumed, 0, 256, bypassed[(bypassFrames - 1) * 2]);
+    INFO("dryStep=" << dryStep << " switchStep=" << switchStep);
+    REQUIRE(switchStep < dryStep * 1.5f);
+    REQUIRE(rms(resumed, 0, resumeFrames * 2) > 0.0f);
+}
+
+TEST_CASE("StringSynthEngine 混响品质按能量衰减曲线截短 IR", "[engine-room]") {
+    const double sampleRate = 48000.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.7);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 220.0;
+    on.velocity = 0.8f;
+
+    engine::Event off{};
+    off.type = engine::EventType::NoteOff;
+    off.noteId = 1;
+    off.frameOffset = static_cast<std::uint64_t>(sampleRate * 0.05);
+
+    auto render = [&](engine::RoomQuality quality) {
+        engine::StringSynthEngine engine;
+        engine.setRenderMode(engine::RenderMode::Offline);
+        engine.setRoomQuality(quality);
+        REQUIRE(engine.roomQuality() == quality);
+        engine.setSampleRate(sampleRate);
+        auto cfg = engine.stringConfig();
+        cfg.seed = 13;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine.setConfig(cfg);
+        engine.setParam(engine::ParamId::AmpRelease, 0.02f);
+        engine.setParam(engine::ParamId::RoomAmount, 1.0f);
+        return renderEngineSequence(engine, {on, off}, totalFrames, 2);
+    };
+
+    const auto full = render(engine::RoomQuality::Full);
+    const auto medium = render(engine::RoomQuality::Medium);
+    const auto low = render(engine::RoomQuality::Low);
+
+    auto segmentRms = [&](const std::vector<float>& buffer, double from, double to) {
+        return rms(buffer, static_cast<std::size_t>(from * sampleRate) * 2,
+                   static_cast<std::size_t>(to * sampleRate) * 2);
+    };
+    // The early reflections are untouched; only the faint end goes.
+    const std::size_t early = static_cast<std::size_t>(sampleRate * 0.1) * 2;
+    float earlyDiff = 0.0f;
+    for (std::size_t i = 0; i < early; ++i) {
+        earlyDiff = std::max(earlyDiff, std::abs(full[i] - low[i]));
+    }
+    REQUIRE(earlyDiff == 0.0f);
+
+    // The library IRs run 0.5 s and reach -40 dB near 0.38 s: the Low tail
+    // ends early, while -60 dB leaves the audible part alone.
+    // Levels are taken against the early part and end points from the last
+    // nonzero sample, so none of it depends on the noise draw.
+    const auto lastSounding = [&](const std::vector<float>& buffer) {
+        std::size_t last = 0;
+        for (std::size_t i = 0; i < buffer.size(); ++i) {
+            if (buffer[i] != 0.0f) {
+                last = i;
+            }
+        }
+        return static_cast<double>(last / 2) / sampleRate;
+    };
+    const float fullEarly = segmentRms(full, 0.0, 0.1);
+    const float fullLate = segmentRms(full, 0.5, 0.575);
+    const float mediumLate = segmentRms(medium, 0.5, 0.575);
+    INFO("fullEarly=" << fullEarly << " fullLate=" << fullLate << " mediumLate=" << mediumLate
+                      << " fullEnd=" << lastSounding(full) << " lowEnd=" << lastSounding(low));
+    REQUIRE(fullLate > fullEarly * 1e-3f);
+    REQUIRE(mediumLate <= fullLate);
+    REQUIRE(lastSounding(full) > 0.6);
+    REQUIRE(lastSounding(low) < 0.55);
+    REQUIRE(segmentRms(low, 0.55, 0.6) == 0.0f);
+}
+
+TEST_CASE("FdnReverb 拟合 IR 的衰减时间、高频衰减与能量", "[dsp][reverb]") {
+    const double sampleRate = 48000.0;
+    const double rt60 = 0.8;
+    // Exponentially decaying noise, low-passed so the highs die faster.
+    const std::size_t frames = static_cast<std::size_t>(sampleRate * rt60 * 1.2);
+    std::vector<float> ir(frames);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    const double decayPerSample = std::pow(10.0, -3.0 / (rt60 * sampleRate));
+    double envelope = 1.0;
+    for (std::size_t f = 0; f < frames; ++f) {
+        ir[f] = static_cast<float>(noise(rng) * envelope);
+        envelope *= decayPerSample;
+    }
+
+    const auto fit = dsp::FdnReverb::FitToIr(ir.data(), nullptr, frames, sampleRate);
+    INFO("rt60=" << fit.rt60Seconds << " highRatio=" << fit.highRatio << " gain=" << fit.gain);
+    REQUIRE(fit.rt60Seconds == Catch::Approx(rt60).epsilon(0.1));
+    REQUIRE(fit.highRatio > 0.7);  // white noise: the highs decay alike
+    REQUIRE(fit.gain > 0.0f);
+
+    // The fitted network decays as asked and carries the IR's energy.
+    dsp::FdnReverb fdn;
+    fdn.setSampleRate(sampleRate);
+    fdn.setSettings(fit);
+    const std::size_t length = frames * 2;
+    std::vector<float> impulse(length, 0.0f);
+    std::vector<float> left(length);
+    std::vector<float> right(length);
+    impulse[0] = 1.0f;
+    fdn.process(impulse.data(), left.data(), right.data(), length);
+    double irEnergy = 0.0;
+    for (float v : ir) {
+        irEnergy += static_cast<double>(v) * v;
+    }
+    double fdnEnergy = 0.0;
+    for (std::size_t f = 0; f < length; ++f) {
+        REQUIRE(std::isfinite(left[f]));
+        fdnEnergy += 0.5 * (static_cast<double>(left[f]) * left[f] +
+                            static_cast<double>(right[f]) * right[f]);
+    }
+    REQUIRE(fdnEnergy == Catch::Approx(irEnergy).epsilon(0.1));
+    REQUIRE(left != right);
+
+    const std::size_t second = static_cast<std::size_t>(sampleRate * 0.4);
+    const float early = rms(left, second / 4, second / 2);
+    const float late = rms(left, second / 4 + second, second / 2 + second);
+    const double dropDb = 20.0 * std::log10(static_cast<double>(early) / late);
+    INFO("drop over 0.4 s: " << dropDb << " dB");
+    REQUIRE(dropDb == Catch::Approx(60.0 * 0.4 / rt60).margin(6.0));
+}
+
+TEST_CASE("StringSynthEngine 算法混响替代卷积且不占用尾部线程", "[engine-room]") {
+    const double sampleRate = 48000.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.8);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 220.0;
+    on.velocity = 0.8f;
+
+    engine::Event off{};
+    off.type = engine::EventType::NoteOff;
+    off.noteId = 1;
+    off.frameOffset = static_cast<std::uint64_t>(sampleRate * 0.1);
+
+    auto render = [&](float room, float type, engine::RoomTelemetry* telemetry) {
+        engine::StringSynthEngine engine;
+        engine.setRenderMode(engine::RenderMode::Offline);
+        engine.setSampleRate(sampleRate);
+        auto cfg = engine.stringConfig();
+        cfg.seed = 21;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine.setConfig(cfg);
+        engine.setParam(engine::ParamId::AmpRelease, 0.05f);
+        engine.setParam(engine::ParamId::RoomAmount, room);
+        engine.setParam(engine::ParamId::RoomType, type);
+        REQUIRE(engine.getParam(engine::ParamId::RoomType) == type);
+        auto out = renderEngineSequence(engine, {on, off}, totalFrames, 2, 333);
+        if (telemetry) {
+            *telemetry = engine.roomTelemetry();
+        }
+        return out;
+    };
+
+    engine::RoomTelemetry telemetry;
+    const auto algorithmic = render(0.8f, 1.0f, &telemetry);
+    const auto convolution = render(0.8f, 0.0f, nullptr);
+    const auto dry = render(0.0f, 1.0f, nullptr);
+    REQUIRE(algorithmic == render(0.8f, 1.0f, nullptr));
+    REQUIRE(telemetry.suspended);
+    REQUIRE(telemetry.tailBlocks == 0);
+
+    auto segmentRms = [&](const std::vector<float>& buffer, double from, double to) {
+        return rms(buffer, static_cast<std::size_t>(from * sampleRate) * 2,
+                   static_cast<std::size_t>(to * sampleRate) * 2);
+    };
+    for (float v : algorithmic) {
+        REQUIRE(std::isfinite(v));
+    }
+    // A tail after the note, at roughly the convolution's level.
+    const float algorithmicTail = segmentRms(algorithmic, 0.25, 0.45);
+    const float convolutionTail = segmentRms(convolution, 0.25, 0.45);
+    const float dryTail = segmentRms(dry, 0.25, 0.45);
+    INFO("algorithmic=" << algorithmicTail << " convolution=" << convolutionTail
+                        << " dry=" << dryTail);
+    REQUIRE(algorithmicTail > dryTail * 10.0f);
+    REQUIRE(algorithmicTail > convolutionTail * 0.25f);
+    REQUIRE(algorithmicTail < convolutionTail * 4.0f);
+}
+
+TEST_CASE("StringSynthEngine 在后台载入用户 IR 并可选用", "[engine-room]") {
+    const double sampleRate = 48000.0;
+    const std::size_t preroll = 4096;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.6);
+
+    // The library's first IR written out as a float WAV: loaded back as the
+    // user IR it must sound like the built-in one.
+    const auto ir = dsp::RoomIrLibrary::samples(0);
+    std::vector<float> interleaved(ir.frameCount * ir.channels);
+    for (std::size_t f = 0; f < ir.frameCount; ++f) {
+        interleaved[f * ir.channels] = ir.left[f];
+        if (ir.channels == 2) {
+            interleaved[f * 2 + 1] = ir.right[f];
+        }
+    }
+    const auto path = std::filesystem::temp_directory_path() / "satori_user_ir_test.wav";
+    audio::WaveFormat format;
+    format.sampleRate = static_cast<std::uint32_t>(ir.sampleRate);
+    format.sampleFormat = audio::SampleFormat::Float32;
+    format.channels = static_cast<std::uint16_t>(ir.channels);
+    std::string error;
+    REQUIRE(audio::WaveWriter().write(path, interleaved, format, error));
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 220.0;
+    on.velocity = 0.8f;
+    on.frameOffset = preroll;
+
+    auto render = [&](bool user) {
+        engine::StringSynthEngine engine;
+        engine.setRenderMode(engine::RenderMode::Offline);
+        engine.setSampleRate(sampleRate);
+        auto cfg = engine.stringConfig();
+        cfg.seed = 17;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine.setConfig(cfg);
+        engine.setParam(engine::ParamId::RoomAmount, 0.8f);
+        REQUIRE(engine.userRoomIrStatus() == engine::UserIrStatus::None);
+        renderEngineSequence(engine, {}, 1024, 2);
+        if (user) {
+            engine.loadUserRoomIr(path);
+            for (int i = 0; i < 5000 && engine.userRoomIrStatus() == engine::UserIrStatus::Loading;
+                 ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            REQUIRE(engine.userRoomIrStatus() == engine::UserIrStatus::Ready);
+            engine.setParam(engine::ParamId::RoomIR,
+                            static_cast<float>(engine::StringSynthEngine::userRoomIrIndex()));
+        }
+        return renderEngineSequence(engine, {on}, totalFrames, 2);
+    };
+
+    const auto builtIn = render(false);
+    const auto loaded = render(true);
+    std::filesystem::remove(path);
+    float worst = 0.0f;
+    for (std::size_t i = preroll * 2; i < builtIn.size(); ++i) {
+        worst = std::max(worst, std::abs(builtIn[i] - loaded[i]));
+    }
+    INFO("worst=" << worst << " peak=" << maxAbs(builtIn));
+    REQUIRE(maxAbs(builtIn) > 0.01f);
+    REQUIRE(worst < maxAbs(builtIn) * 1e-3f);
+
+    engine::StringSynthEngine missing;
+    missing.loadUserRoomIr(std::filesystem::temp_directory_path() / "satori_no_such_ir.wav");
+    for (int i = 0; i < 5000 && missing.userRoomIrStatus() == engine::UserIrStatus::Loading; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(missing.userRoomIrStatus() == engine::UserIrStatus::Failed);
+}
+
+TEST_CASE("StringSynthEngine reset 后的渲染与之前的内容无关", "[engine-core]") {
+    const double sampleRate = 48000.0;
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.4);
+
+    auto noteAt = [](double frequency, float velocity) {
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = frequency;
+        on.velocity = velocity;
+        return on;
+    };
+
+    auto renderAfter = [&](double previousFrequency) {
+        engine::StringSynthEngine engine;
+        engine.setRenderMode(engine::RenderMode::Offline);
+        engine.setSampleRate(sampleRate);
+        auto cfg = engine.stringConfig();
+        cfg.seed = 7;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine.setConfig(cfg);
+        engine.setParam(engine::ParamId::RoomAmount, 0.7f);
+        engine.setParam(engine::ParamId::BodyTone, 0.8f);
+        // Leave voices, body filter and room tail ringing, plus a pending note.
+        renderEngineSequence(engine, {noteAt(previousFrequency, 1.0f)}, totalFrames / 2, 2);
+        engine.noteOn(5, 880.0, 1.0f);
+
+        engine.reset();
+        REQUIRE(engine.renderedFrames() == 0);
+        REQUIRE(engine.activeVoiceCount() == 0);
+        REQUIRE(engine.queuedEventCount() == 0);
+        return renderEngineSequence(engine, {noteAt(330.0, 0.6f)}, totalFrames, 2);
+    };
+
+    const auto a = renderAfter(110.0);
+    const auto b = renderAfter(523.25);
+    REQUIRE(maxAbs(a) > 0.01f);
+    REQUIRE(a == b);
+}
+
+TEST_CASE("StringSynthEngine NoteOn/Off 控制尾音长度", "[engine-core]") {
+    const double sampleRate = 48000.0;
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::AmpRelease, 0.05f);
+    engine.setParam(engine::ParamId::Decay, 0.992f);
+    INFO("engine sampleRate=" << engine.sampleRate());
+
+    auto toFrames = [sampleRate](double seconds) {
+        return static_cast<std::uint64_t>(
+            std::max(0.0, std::round(seconds * sampleRate)));
+    };
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 440.0;
+    on.frameOffset = 0;
+
+    engine::Event off{};
+    off.type = engine::EventType::NoteOff;
+    off.noteId = 1;
+    off.frameOffset = toFrames(0.05);
+
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.3);
+    auto buffer = renderEngineSequence(engine, {on, off}, totalFrames);
+
+    const float earlyEnergy = rms(buffer, 0, toFrames(0.1));
+    const float tailEnergy = rms(buffer, toFrames(0.2), buffer.size());
+    INFO("peak=" << maxAbs(buffer) << " early=" << earlyEnergy << " tail=" << tailEnergy);
+
+    REQUIRE(earlyEnergy > 0.001f);
+    REQUIRE(tailEnergy < earlyEnergy * 0.25f);
+    REQUIRE(tailEnergy < 0.0005f);
+}
+
+TEST_CASE("StringSynthEngine 弯音与颤音在发声中重调且不重新拨弦", "[engine-core][pitch]") {
+    const double sampleRate = 48000.0;
+    const double baseHz = 220.0;
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::Decay, 0.999f);
+    engine.setParam(engine::ParamId::DispersionAmount, 0.0f);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = baseHz;
+    on.frameOffset = 0;
+    const std::size_t headFrames = static_cast<std::size_t>(sampleRate * 0.2);
+    const auto head = renderEngineSequence(engine, {on}, headFrames);
+
+    // A two-semitone bend retunes the sounding note; the level carries on
+    // from where it was instead of jumping like a new pluck.
+    engine.setParam(engine::ParamId::PitchBend, 2.0f);
+    const std::size_t tailFrames = static_cast<std::size_t>(sampleRate * 0.4);
+    const auto tail = renderEngineSequence(engine, {}, tailFrames);
+    const double bentHz = baseHz * std::exp2(2.0 / 12.0);
+    const double estimatedHz = estimateFundamentalAutocorr(tail, sampleRate, bentHz);
+    const double cents = 1200.0 * std::log2(estimatedHz / bentHz);
+    const float before = rms(head, headFrames - 2048, headFrames);
+    const float after = rms(tail, 0, 2048);
+    INFO("estimated=" << estimatedHz << " cents=" << cents << " before=" << before
+                      << " after=" << after);
+    REQUIRE(engine.getParam(engine::ParamId::PitchBend) == Catch::Approx(2.0f));
+    REQUIRE(std::abs(cents) < 3.0);
+    REQUIRE(after > before * 0.5f);
+    REQUIRE(after < before * 1.5f);
+
+    // Vibrato keeps the note finite and centred on the bent pitch.
+    engine.setParam(engine::ParamId::VibratoRate, 6.0f);
+    engine.setParam(engine::ParamId::VibratoDepth, 0.3f);
+    const auto vibrato =
+        renderEngineSequence(engine, {}, static_cast<std::size_t>(sampleRate * 0.5));
+    for (float sample : vibrato) {
+        REQUIRE(std::isfinite(sample));
+    }
+    REQUIRE(maxAbs(vibrato) < 2.0f);
+    const double vibratoHz = estimateFundamentalAutocorr(vibrato, sampleRate, bentHz);
+    REQUIRE(std::abs(1200.0 * std::log2(vibratoHz / bentHz)) < 40.0);
+
+    // Notes started under a bend start at the bent pitch.
+    engine.reset();
+    engine.setParam(engine::ParamId::VibratoDepth, 0.0f);
+    engine.setParam(engine::ParamId::PitchBend, -12.0f);
+    on.frameOffset = 0;
+    const auto lowered = renderEngineSequence(engine, {on}, tailFrames);
+    const double loweredHz = estimateFundamentalAutocorr(lowered, sampleRate, baseHz * 0.5);
+    REQUIRE(std::abs(1200.0 * std::log2(loweredHz / (baseHz * 0.5))) < 3.0);
+}
+
+TEST_CASE("StringSynthEngine 每音符表情只作用于对应音符", "[engine-core][mpe]") {
+    const double sampleRate = 48000.0;
+    const double baseHz = 220.0;
+    auto render = [&](const engine::ModulationSettings* settings, int expressed,
+                      engine::NoteExpression expression, float value) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 7u;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(sampleRate);
+        engine.setParam(engine::ParamId::Decay, 0.999f);
+        engine.setParam(engine::ParamId::DispersionAmount, 0.0f);
+        if (settings) {
+            engine.setModulation(*settings);
+        }
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = baseHz;
+        const std::size_t headFrames = static_cast<std::size_t>(sampleRate * 0.1);
+        (void)renderEngineSequence(engine, {on}, headFrames);
+        engine.noteExpression(expressed, expression, value);
+        return renderEngineSequence(engine, {}, static_cast<std::size_t>(sampleRate * 0.4));
+    };
+
+    const auto plain = render(nullptr, 1, engine::NoteExpression::PitchBend, 0.0f);
+    // Another note's expression, or one with no route, leaves this one alone.
+    REQUIRE(render(nullptr, 2, engine::NoteExpression::PitchBend, 12.0f) == plain);
+    REQUIRE(render(nullptr, 1, engine::NoteExpression::Pressure, 1.0f) == plain);
+
+    // The note's own bend retunes it in place, within its range.
+    const auto bent = render(nullptr, 1, engine::NoteExpression::PitchBend, 12.0f);
+    const double bentHz = estimateFundamentalAutocorr(bent, sampleRate, 2.0 * baseHz);
+    INFO("bent=" << bentHz);
+    REQUIRE(std::abs(1200.0 * std::log2(bentHz / (2.0 * baseHz))) < 3.0);
+
+    // Pressure moves the voice through its routes.
+    engine::ModulationSettings pressure;
+    pressure.addRoute(engine::ModSource::Pressure, engine::ModTarget::Brightness, -0.5f);
+    const auto routed = render(&pressure, 1, engine::NoteExpression::Pressure, 0.0f);
+    const auto pressed = render(&pressure, 1, engine::NoteExpression::Pressure, 1.0f);
+    REQUIRE(routed == plain);
+    double diff = 0.0;
+    for (std::size_t i = 0; i < plain.size(); ++i) {
+        REQUIRE(std::isfinite(pressed[i]));
+        diff = std::max(diff, static_cast<double>(std::abs(pressed[i] - plain[i])));
+    }
+    REQUIRE(diff > 1e-3);
+}
+
+TEST_CASE("StringSynthEngine 延音踏板保持音符且同键重复复用声部", "[engine-core][pedal]") {
+    const double sampleRate = 48000.0;
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::AmpRelease, 0.05f);
+    engine.setParam(engine::ParamId::Decay, 0.999f);
+    engine.setParam(engine::ParamId::SustainPedal, 1.0f);
+
+    auto note = [](engine::EventType type, int id, double frequency, std::uint64_t frame) {
+        engine::Event e{};
+        e.type = type;
+        e.noteId = id;
+        e.frequency = frequency;
+        e.frameOffset = frame;
+        return e;
+    };
+
+    // Released under the pedal, the note keeps sounding.
+    std::vector<engine::Event> events = {note(engine::EventType::NoteOn, 1, 220.0, 0),
+                                         note(engine::EventType::NoteOff, 1, 220.0, 2400)};
+    // Repeats on the same key strike the held string again.
+    for (int i = 1; i <= 8; ++i) {
+        const auto at = static_cast<std::uint64_t>(2400 * 2 * i);
+        events.push_back(note(engine::EventType::NoteOn, 1, 220.0, at));
+        events.push_back(note(engine::EventType::NoteOff, 1, 220.0, at + 2400));
+    }
+    // Checked just after the first repeat, while a stolen voice would still
+    // be fading out in a ghost slot.
+    const std::size_t repeatFrames = 2400 * 2 + 64;
+    auto held = renderEngineSequence(engine, events, repeatFrames);
+    REQUIRE(engine.activeVoiceCount() == 1);
+    const std::size_t heldFrames = 2400 * 20;
+    const auto rest = renderEngineSequence(engine, {}, heldFrames - repeatFrames);
+    held.insert(held.end(), rest.begin(), rest.end());
+    const float heldTail = rms(held, heldFrames - 4800, heldFrames);
+    INFO("heldTail=" << heldTail << " peak=" << maxAbs(held));
+    REQUIRE(engine.activeVoiceCount() == 1);
+    REQUIRE(heldTail > 0.01f);
+    REQUIRE(maxAbs(held) < 2.0f);
+    for (float sample : held) {
+        REQUIRE(std::isfinite(sample));
+    }
+
+    // Lifting the pedal releases it.
+    engine.setParam(engine::ParamId::SustainPedal, 0.0f);
+    const auto lifted = renderEngineSequence(engine, {}, 9600);
+    REQUIRE(rms(lifted, 4800, 9600) < heldTail * 0.01f);
+    REQUIRE(engine.activeVoiceCount() == 0);
+
+    // Sostenuto holds only the keys down when it went down.
+    const std::uint64_t base = engine.renderedFrames();
+    engine.enqueueEventAt(note(engine::EventType::NoteOn, 2, 330.0, base), base);
+    renderEngineSequence(engine, {}, 256);
+    engine.setParam(engine::ParamId::SostenutoPedal, 1.0f);
+    const std::uint64_t later = engine.renderedFrames();
+    renderEngineSequence(engine,
+                         {note(engine::EventType::NoteOn, 3, 440.0, later),
+                          note(engine::EventType::NoteOff, 2, 330.0, later + 1200),
+                          note(engine::EventType::NoteOff, 3, 440.0, later + 1200)},
+                         9600);
+    REQUIRE(engine.activeVoiceCount() == 1);
+    engine.setParam(engine::ParamId::SostenutoPedal, 0.0f);
+    renderEngineSequence(engine, {}, 9600);
+    REQUIRE(engine.activeVoiceCount() == 0);
+}
+
+TEST_CASE("StringSynthEngine 支持多复音叠加", "[engine-core]") {
+    const double sampleRate = 44100.0;
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::AmpRelease, 0.08f);
+    engine.setParam(engine::ParamId::Decay, 0.995f);
+
+    auto toFrames = [sampleRate](double seconds) {
+        return static_cast<std::uint64_t>(
+            std::max(0.0, std::round(seconds * sampleRate)));
+    };
+
+    engine::Event a{};
+    a.type = engine::EventType::NoteOn;
+    a.noteId = 1;
+    a.frequency = 220.0;
+    a.frameOffset = 0;
+
+    engine::Event b = a;
+    b.noteId = 2;
+    b.frequency = 330.0;
+    b.frameOffset = toFrames(0.1);
+
+    engine::Event c = b;
+    c.noteId = 3;
+    c.frequency = 440.0;
+    c.frameOffset = toFrames(0.18);
+
+    engine::Event offA{};
+    offA.type = engine::EventType::NoteOff;
+    offA.noteId = 1;
+    offA.frameOffset = toFrames(0.35);
+
+    engine::Event offB = offA;
+    offB.noteId = 2;
+    offB.frameOffset = toFrames(0.4);
+
+    engine::Event offC = offA;
+    offC.noteId = 3;
+    offC.frameOffset = toFrames(0.45);
+
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.6);
+    auto buffer =
+        renderEngineSequence(engine, {a, b, c, offA, offB, offC}, totalFrames);
+
+    const float peak = maxAbs(buffer);
+    INFO("peak=" << peak);
+    REQUIRE(peak > 0.01f);
+    REQUIRE(peak < 1.5f);
+}
+
+TEST_CASE("StringSynthEngine 在 voice stealing 下保持稳定输出", "[engine-core]") {
+    const double sampleRate = 48000.0;
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(sampleRate);
+    engine.setParam(engine::ParamId::AmpRelease, 0.02f);
+    engine.setParam(engine::ParamId::Decay, 0.991f);
+
+    auto toFrames = [sampleRate](double seconds) {
+        return static_cast<std::uint64_t>(
+            std::max(0.0, std::round(seconds * sampleRate)));
+    };
+
+    std::vector<engine::Event> events;
+    const std::vector<double> freqs = {110.0, 140.0, 176.0, 220.0, 261.63,
+                                       330.0, 392.0, 466.0, 523.25, 659.25};
+    int noteId = 1;
+    for (double freq : freqs) {
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = noteId;
+        on.frequency = freq;
+        on.frameOffset = 0;
+        events.push_back(on);
+
+        engine::Event off{};
+        off.type = engine::EventType::NoteOff;
+        off.noteId = noteId;
+        off.frameOffset = toFrames(0.12 + 0.01 * noteId);
+        events.push_back(off);
+        ++noteId;
+    }
+
+    const std::size_t totalFrames = static_cast<std::size_t>(sampleRate * 0.4);
+    auto buffer = renderEngineSequence(engine, events, totalFrames);
+
+    REQUIRE(std::all_of(buffer.begin(), buffer.end(),
+                        [](float s) { return std::isfinite(s); }));
+    const float lateEnergy = rms(buffer, toFrames(0.32), buffer.size());
     REQUIRE(lateEnergy < 0.0015f);
 }
+
+TEST_CASE("StringSynthEngine 按住但已衰减到 -120 dBFS 的音符提前回收", "[engine-core][polyphony]") {
+    synthesis::StringConfig config;
+    config.decay = 0.9f;
+    engine::StringSynthEngine engine(config, 4);
+    engine.setSampleRate(48000.0);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 7;
+    on.frequency = 440.0;
+    auto early = renderEngineSequence(engine, {on}, 4800);
+    REQUIRE(engine.activeVoiceCount() == 1);
+    REQUIRE(maxAbs(early) > 0.01f);
+
+    // Still held, but the loop has died away: the voice is retired.
+    auto late = renderEngineSequence(engine, {}, 48000);
+    REQUIRE(engine.activeVoiceCount() == 0);
+    REQUIRE(maxAbs(std::vector<float>(late.end() - 4800, late.end())) < 1e-6f);
+
+    // The eventual note-off finds nothing; the note can be played again.
+    engine::Event off{};
+    off.type = engine::EventType::NoteOff;
+    off.noteId = 7;
+    off.frameOffset = engine.renderedFrames();
+    on.frameOffset = engine.renderedFrames() + 256;
+    auto again = renderEngineSequence(engine, {off, on}, 2048);
+    REQUIRE(engine.activeVoiceCount() == 1);
+    REQUIRE(maxAbs(again) > 0.01f);
+}
+
+TEST_CASE("StringSynthEngine 抢占复音时旧音在幽灵槽位中快速淡出", "[engine-core][polyphony]") {
+    synthesis::StringConfig config;
+    config.seed = 1234u;
+    config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    config.decay = 0.999f;
+    const double sampleRate = 48000.0;
+    const std::uint64_t stealFrame = 4000;
+
+    auto render = [&](std::size_t maxVoices, bool playFirst, std::size_t* voicesAfterSteal) {
+        engine::StringSynthEngine engine(config, maxVoices);
+        engine.setSampleRate(sampleRate);
+        std::vector<engine::Event> events;
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        if (playFirst) {
+            on.noteId = 1;
+            on.frequency = 196.0;
+            events.push_back(on);
+        }
+        on.noteId = 2;
+        on.frequency = 293.66;
+        on.frameOffset = stealFrame;
+        events.push_back(on);
+        auto head = renderEngineSequence(engine, events, stealFrame + 16);
+        if (voicesAfterSteal) {
+            *voicesAfterSteal = engine.activeVoiceCount();
+        }
+        auto tail = renderEngineSequence(engine, {}, 4000);
+        head.insert(head.end(), tail.begin(), tail.end());
+        return head;
+    };
+
+    std::size_t voicesDuringFade = 0;
+    const auto stolen = render(1, true, &voicesDuringFade);
+    const auto unlimited = render(2, true, nullptr);
+    const auto secondOnly = render(1, false, nullptr);
+
+    // One note sounding, one fading in a ghost slot.
+    REQUIRE(voicesDuringFade == 2);
+    // No discontinuity: at the steal the old note is still at full level.
+    REQUIRE(stolen[stealFrame] == Catch::Approx(unlimited[stealFrame]).margin(1e-6));
+    REQUIRE(std::abs(stolen[stealFrame - 1]) > 1e-3f);
+    // A little after the 5 ms fade only the new note is left.
+    const std::size_t settled = stealFrame + static_cast<std::size_t>(0.02 * sampleRate);
+    float maxDiff = 0.0f;
+    for (std::size_t i = settled; i < stolen.size(); ++i) {
+        maxDiff = std::max(maxDiff, std::abs(stolen[i] - secondOnly[i]));
+    }
+    INFO("maxDiff=" << maxDiff);
+    REQUIRE(maxDiff < 1e-3f);
+}
+
+TEST_CASE("StringSynthEngine 复音上限可在构造时配置", "[engine-core][polyphony]") {
+    REQUIRE(engine::StringSynthEngine{}.maxVoices() ==
+            engine::StringSynthEngine::kDefaultMaxVoices);
+    REQUIRE(engine::StringSynthEngine({}, 0).maxVoices() == 1);
+    REQUIRE(engine::StringSynthEngine({}, 100000).maxVoices() ==
+            engine::StringSynthEngine::kMaxVoicesLimit);
+
+    auto sustainChord = [](std::size_t maxVoices, int notes) {
+        engine::StringSynthEngine engine({}, maxVoices);
+        engine.setSampleRate(48000.0);
+        engine.setParam(engine::ParamId::Decay, 0.999f);
+        std::vector<engine::Event> events;
+        for (int i = 0; i < notes; ++i) {
+            engine::Event on{};
+            on.type = engine::EventType::NoteOn;
+            on.noteId = i + 1;
+            on.frequency = 82.41 * std::pow(2.0, i / 12.0);
+            on.frameOffset = static_cast<std::uint64_t>(i) * 16;
+            events.push_back(on);
+        }
+        auto buffer = renderEngineSequence(engine, events, 4096);
+        REQUIRE(std::all_of(buffer.begin(), buffer.end(),
+                            [](float s) { return std::isfinite(s); }));
+        return engine.activeVoiceCount();
+    };
+
+    REQUIRE(sustainChord(64, 48) == 48);
+    REQUIRE(sustainChord(8, 48) == 8);
+}
+
+TEST_CASE("StringSynthEngine 多线程投递事件时不丢失", "[engine-core][events]") {
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(48000.0);
+
+    constexpr int kProducers = 4;
+    constexpr int kEventsPerProducer = 400;
+    std::atomic<int> accepted{0};
+    std::atomic<bool> producersDone{false};
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&engine, &accepted, p] {
+            for (int i = 0; i < kEventsPerProducer; ++i) {
+                engine::Event event{};
+                if (i % 2 == 0) {
+                    event.type = engine::EventType::ParamChange;
+                    event.param = engine::ParamId::BodyTone;
+                    event.paramValue = static_cast<float>(i % 10) / 10.0f;
+                } else {
+                    event.type = engine::EventType::NoteOn;
+                    event.noteId = p * kEventsPerProducer + i;
+                    event.frequency = 110.0 + 10.0 * p;
+                }
+                if (engine.enqueueEventAt(event, engine.renderedFrames() + i)) {
+                    accepted.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    std::vector<float> buffer(128, 0.0f);
+    std::thread audio([&] {
+        while (!producersDone.load()) {
+            engine::ProcessBlock block{buffer.data(), buffer.size(), 1};
+            engine.process(block);
+        }
+    });
+    for (auto& t : producers) {
+        t.join();
+    }
+    producersDone.store(true);
+    audio.join();
+
+    REQUIRE(accepted.load() == kProducers * kEventsPerProducer);
+    for (int i = 0; i < 64 && engine.queuedEventCount() > 0; ++i) {
+        engine::ProcessBlock block{buffer.data(), buffer.size(), 1};
+        engine.process(block);
+    }
+    REQUIRE(engine.queuedEventCount() == 0);
+    REQUIRE(std::all_of(buffer.begin(), buffer.end(),
+                        [](float s) { return std::isfinite(s); }));
+}
+
+TEST_CASE("StringSynthEngine 按时间戳调度大量未来事件", "[engine-core][events]") {
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(48000.0);
+
+    std::vector<std::uint64_t> frames;
+    std::uint32_t lcg = 12345u;
+    for (int i = 0; i < 3000; ++i) {
+        lcg = lcg * 1664525u + 1013904223u;
+        frames.push_back(lcg % 20000u);
+        engine::Event off{};
+        off.type = engine::EventType::NoteOff;
+        off.noteId = i;
+        REQUIRE(engine.enqueueEventAt(off, frames.back()));
+    }
+    REQUIRE(engine.queuedEventCount() == frames.size());
+
+    std::vector<float> buffer(512, 0.0f);
+    for (int block = 0; block < 40; ++block) {
+        engine::ProcessBlock pb{buffer.data(), buffer.size(), 1};
+        engine.process(pb);
+        const std::uint64_t rendered = engine.renderedFrames();
+        const auto remaining = static_cast<std::size_t>(
+            std::count_if(frames.begin(), frames.end(),
+                          [rendered](std::uint64_t f) { return f >= rendered; }));
+        REQUIRE(engine.queuedEventCount() == remaining);
+        const auto queued = engine.queuedEventFrames();
+        REQUIRE(queued.size() == remaining);
+        REQUIRE(std::all_of(queued.begin(), queued.end(),
+                            [rendered](std::uint64_t f) { return f >= rendered; }));
+    }
+}
+
+TEST_CASE("StringSynthEngine 批量投递事件与逐个投递一致且在队列满时停下", "[engine-core][events]") {
+    synthesis::StringConfig cfg;
+    cfg.seed = 7u;
+    cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+
+    std::vector<engine::Event> events;
+    for (int i = 0; i < 200; ++i) {
+        engine::Event event{};
+        event.frameOffset = static_cast<std::uint64_t>(i) * 37u;
+        if (i % 3 == 0) {
+            event.type = engine::EventType::ParamChange;
+            event.param = engine::ParamId::BodyTone;
+            event.paramValue = static_cast<float>(i % 7) / 6.0f;
+        } else if (i % 3 == 1) {
+            event.type = engine::EventType::NoteOn;
+            event.noteId = i;
+            event.frequency = 110.0 + 3.0 * i;
+            event.velocity = 0.8f;
+        } else {
+            event.type = engine::EventType::NoteOff;
+            event.noteId = i - 1;
+        }
+        events.push_back(event);
+    }
+
+    engine::StringSynthEngine single(cfg);
+    single.setSampleRate(48000.0);
+    const auto expected = renderEngineSequence(single, events, 8192);
+
+    engine::StringSynthEngine bulk(cfg);
+    bulk.setSampleRate(48000.0);
+    REQUIRE(bulk.enqueueEvents(events) == events.size());
+    REQUIRE(bulk.queuedEventCount() == events.size());
+    const auto actual = renderEngineSequence(bulk, {}, 8192);
+    REQUIRE(actual == expected);
+
+    engine::StringSynthEngine engine;
+    engine.setSampleRate(48000.0);
+    std::vector<engine::Event> offs(5000);
+    for (std::size_t i = 0; i < offs.size(); ++i) {
+        offs[i].type = engine::EventType::NoteOff;
+        offs[i].noteId = static_cast<int>(i);
+        offs[i].frameOffset = i;
+    }
+    const std::size_t accepted = engine.enqueueEvents(offs);
+    REQUIRE(accepted > 0);
+    REQUIRE(accepted < offs.size());
+    REQUIRE(engine.queuedEventCount() == accepted);
+
+    // A refused event ends the run; those in front of it are queued.
+    engine::StringSynthEngine refused;
+    std::vector<engine::Event> mixed(3);
+    mixed[1].type = engine::EventType::NoteOff;
+    mixed[1].part = engine::StringSynthEngine::kMaxParts;
+    REQUIRE(refused.enqueueEvents(mixed) == 1);
+    REQUIRE(refused.queuedEventCount() == 1);
+}
+
+TEST_CASE("StringSynthEngine 在块内按事件时间戳精确切分", "[engine-core][events]") {
+    synthesis::StringConfig cfg;
+    cfg.seed = 99u;
+    cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    const std::uint64_t onsetFrame = 173;
+
+    auto renderOnset = [&](std::size_t blockFrames) {
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(48000.0);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 220.0;
+        on.frameOffset = onsetFrame;
+        return renderEngineSequence(engine, {on}, 2048, 1, blockFrames);
+    };
+
+    const auto large = renderOnset(1024);
+    const auto small = renderOnset(64);
+    for (std::uint64_t i = 0; i < onsetFrame; ++i) {
+        REQUIRE(large[i] == 0.0f);
+    }
+    REQUIRE(maxAbs(std::vector<float>(large.begin() + onsetFrame, large.end())) > 0.0f);
+
+    float maxDiff = 0.0f;
+    for (std::size_t i = 0; i < large.size(); ++i) {
+        maxDiff = std::max(maxDiff, std::abs(large[i] - small[i]));
+    }
+    INFO("maxDiff=" << maxDiff);
+    REQUIRE(maxDiff < 1e-6f);
+}
+
+TEST_CASE("RealtimeThread 设置可配置且混响线程与渲染线程分核", "[engine-core][threads]") {
+    const auto saved = engine::GetRealtimeThreadSettings();
+    engine::RealtimeThreadSettings settings;
+    settings.renderPriority = engine::RealtimePriority::High;
+    settings.roomWorkerPriority = engine::RealtimePriority::Normal;
+    settings.pinRoomWorker = false;
+    engine::SetRealtimeThreadSettings(settings);
+    const auto read = engine::GetRealtimeThreadSettings();
+    REQUIRE(read.renderPriority == engine::RealtimePriority::High);
+    REQUIRE(read.roomWorkerPriority == engine::RealtimePriority::Normal);
+    REQUIRE_FALSE(read.pinRoomWorker);
+    engine::SetRealtimeThreadSettings(saved);
+
+    const int render = engine::PreferredCore(engine::RealtimeThreadRole::Render);
+    const int worker = engine::PreferredCore(engine::RealtimeThreadRole::RoomWorker);
+    if (std::thread::hardware_concurrency() >= 2) {
+        REQUIRE(render >= 0);
+        REQUIRE(worker >= 0);
+        REQUIRE(render != worker);
+    } else {
+        REQUIRE(render == -1);
+        REQUIRE(worker == -1);
+    }
+    // Registers and reverts on Windows; a no-op elsewhere.
+    {
+        const engine::ScopedRealtimeThread scoped(engine::RealtimeThreadRole::RoomWorker);
+    }
+
+    const engine::CpuTopology topology = engine::GetCpuTopology();
+    REQUIRE(topology.performanceCores >= 0);
+    REQUIRE(topology.efficiencyCores >= 0);
+    if (!topology.hybrid()) {
+        REQUIRE(topology.efficiencyCores == 0);
+        REQUIRE_FALSE(engine::SetThreadCoreClass(engine::CoreClass::Performance));
+    }
+    settings.hybridPlacement = false;
+    engine::SetRealtimeThreadSettings(settings);
+    REQUIRE_FALSE(engine::SetThreadCoreClass(engine::CoreClass::Efficiency));
+    engine::SetRealtimeThreadSettings(saved);
+    {
+        const engine::ScopedDspThread background("placement test", engine::CoreClass::Efficiency);
+    }
+}
+
+TEST_CASE("StringSynthEngine 分阶段计时仅在启用时累计", "[engine-core][metrics]") {
+    engine::StringSynthEngine engine(synthesis::StringConfig{}, 8);
+    engine.setRenderMode(engine::RenderMode::Offline);
+    engine.setSampleRate(48000.0);
+    engine.noteOn(1, 220.0, 0.8f);
+    std::vector<float> buffer(512 * 2);
+    for (int i = 0; i < 8; ++i) {
+        engine.process(engine::ProcessBlock{buffer.data(), 512, 2});
+    }
+    const auto profile = engine.stageProfile();
+    const auto ticks = [&](engine::ProfileStage stage) {
+        return profile.ticks[static_cast<std::size_t>(stage)];
+    };
+#if SATORI_PROFILING_ENABLED
+    REQUIRE(ticks(engine::ProfileStage::Voices) > 0);
+    REQUIRE(ticks(engine::ProfileStage::Room) > 0);
+#else
+    for (const std::uint64_t t : profile.ticks) {
+        REQUIRE(t == 0);
+    }
+#endif
+    // The resampler belongs to the device layer, not the synth.
+    REQUIRE(ticks(engine::ProfileStage::Resampler) == 0);
+}
+
+TEST_CASE("LatencyHistogram 统计分位数与超时且窗口可重置", "[engine-core][metrics]") {
+    auto histogram = std::make_unique<engine::LatencyHistogram>();
+    const double periodUs = 1000.0;
+    // 990 fast callbacks around 100 us, nine at 900 us, one 2 ms overrun.
+    for (int i = 0; i < 990; ++i) {
+        histogram->record(95.0 + static_cast<double>(i % 10), periodUs);
+    }
+    for (int i = 0; i < 9; ++i) {
+        histogram->record(900.0, periodUs);
+    }
+    histogram->record(2000.0, periodUs);
+
+    const auto all = histogram->snapshot();
+    REQUIRE(all.callbacks == 1000);
+    REQUIRE(all.overruns == 1);
+    REQUIRE(all.percentileUs(0.5) == Catch::Approx(110.0));
+    REQUIRE(all.percentileUs(0.99) == Catch::Approx(110.0));
+    REQUIRE(all.percentileUs(0.995) == Catch::Approx(910.0));
+    REQUIRE(all.percentileUs(1.0) == Catch::Approx(2010.0));
+    REQUIRE(all.maxUs() == Catch::Approx(2010.0));
+
+    // A window only sees what was recorded after its baseline.
+    for (int i = 0; i < 10; ++i) {
+        histogram->record(300.0, periodUs);
+    }
+    histogram->record(1e6, periodUs);  // lands in the overflow bucket
+    const auto window = histogram->snapshot().since(all);
+    REQUIRE(window.callbacks == 11);
+    REQUIRE(window.overruns == 1);
+    REQUIRE(window.percentileUs(0.5) == Catch::Approx(310.0));
+    REQUIRE(window.maxUs() ==
+            Catch::Approx(engine::LatencyHistogram::kBucketCount * engine::LatencyHistogram::kBucketUs));
+    REQUIRE(histogram->snapshot().since(histogram->snapshot()).percentileUs(0.99) == 0.0);
+}
+
+TEST_CASE("AmpEnvelope 块渲染与逐样本 next() 在起音保持与释音中逐样本一致", "[engine-core][envelope]") {
+    // 100-sample attack, 250-sample release: neither lines up with a block.
+    engine::AmpEnvelope stepped;
+    engine::AmpEnvelope block;
+    for (engine::AmpEnvelope* envelope : {&stepped, &block}) {
+        envelope->setSampleRate(1000.0);
+        envelope->setAttackSeconds(0.1);
+        envelope->setReleaseSeconds(0.25);
+    }
+    std::vector<float> gains(64);
+    std::size_t compared = 0;
+    const auto renderBoth = [&](std::size_t frames) {
+        block.render(gains.data(), frames);
+        for (std::size_t i = 0; i < frames; ++i) {
+            REQUIRE(gains[i] == stepped.next());
+        }
+        REQUIRE(block.level() == stepped.level());
+        REQUIRE(block.isIdle() == stepped.isIdle());
+        REQUIRE(block.isSustaining() == stepped.isSustaining());
+        REQUIRE(block.isReleasing() == stepped.isReleasing());
+        compared += frames;
+    };
+    const auto both = [&](auto&& action) {
+        action(stepped);
+        action(block);
+    };
+
+    both([](engine::AmpEnvelope& e) { e.noteOn(0.8f); });
+    renderBoth(64);
+    REQUIRE(block.level() < 0.8f);
+    renderBoth(64);  // the attack ends 36 samples in
+    REQUIRE(block.isSustaining());
+    REQUIRE(gains.back() == 0.8f);
+    renderBoth(17);
+
+    both([](engine::AmpEnvelope& e) { e.noteOff(); });
+    for (int i = 0; i < 3; ++i) {
+        renderBoth(64);
+    }
+    REQUIRE(block.isReleasing());
+    renderBoth(64);  // sample 250 of the release, 58 into this block
+    REQUIRE(block.isIdle());
+    REQUIRE(gains[57] == 0.0f);
+    REQUIRE(gains[56] > 0.0f);
+    REQUIRE(gains.back() == 0.0f);
+    renderBoth(64);
+
+    // Released mid-attack and struck again mid-release.
+    both([](engine::AmpEnvelope& e) { e.noteOn(0.5f); });
+    renderBoth(33);
+    both([](engine::AmpEnvelope& e) { e.noteOff(); });
+    renderBoth(64);
+    REQUIRE(block.isReleasing());
+    both([](engine::AmpEnvelope& e) { e.noteOn(0.9f); });
+    for (const std::size_t frames : {1u, 7u, 64u, 64u, 5u}) {
+        renderBoth(frames);
+    }
+
+    // A quiet note crosses the floor long before the release would end.
+    both([](engine::AmpEnvelope& e) { e.noteOn(2e-5f); });
+    renderBoth(64);
+    renderBoth(64);
+    both([](engine::AmpEnvelope& e) { e.noteOff(); });
+    renderBoth(64);
+    REQUIRE(block.isReleasing());
+    renderBoth(64);
+    REQUIRE(block.isIdle());
+
+    // A release shortened under the cursor ends on the next sample.
+    both([](engine::AmpEnvelope& e) { e.noteOn(1.0f); });
+    renderBoth(64);
+    renderBoth(64);
+    both([](engine::AmpEnvelope& e) { e.noteOff(); });
+    renderBoth(40);
+    both([](engine::AmpEnvelope& e) { e.setReleaseSeconds(0.02); });
+    renderBoth(3);
+    REQUIRE(block.isIdle());
+
+    // Zero-length stages jump straight to their end.
+    both([](engine::AmpEnvelope& e) {
+        e.setAttackSeconds(0.0);
+        e.setReleaseSeconds(0.25);
+        e.noteOn(0.7f);
+    });
+    renderBoth(10);
+    REQUIRE(gains[0] == 0.7f);
+    both([](engine::AmpEnvelope& e) { e.noteOff(); });
+    renderBoth(64);
+    REQUIRE(compared > 1000);
+}
+
+TEST_CASE("AdaptiveTailDelay 尾部迟到时加大延迟并在稳定窗口后逐块收回", "[engine-core][engine-room]") {
+    constexpr std::size_t kWindow = 32;
+    engine::AdaptiveTailDelay delay(6, 12, kWindow);
+    const auto onTimeBlocks = [&](std::size_t count, std::size_t spare) {
+        std::size_t shrinks = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            shrinks += delay.onTime(spare, true) ? 1 : 0;
+        }
+        return shrinks;
+    };
+
+    // Never below the minimum, however much is queued.
+    REQUIRE(delay.blocks() == 6);
+    REQUIRE(onTimeBlocks(4 * kWindow, 100) == 0);
+    REQUIRE(delay.blocks() == 6);
+
+    // Each underrun adds a block, up to the cap; a stall on purpose adds none.
+    delay.late(true);
+    delay.late(true);
+    REQUIRE(delay.blocks() == 8);
+    delay.late(false);
+    REQUIRE(delay.blocks() == 8);
+    for (int i = 0; i < 10; ++i) {
+        delay.late(true);
+    }
+    REQUIRE(delay.blocks() == 12);
+
+    // A full window with two blocks to spare takes one back, on its last block.
+    REQUIRE(onTimeBlocks(kWindow - 1, 2) == 0);
+    REQUIRE(delay.blocks() == 12);
+    REQUIRE(delay.onTime(2, true));
+    REQUIRE(delay.blocks() == 11);
+
+    // Running close to empty once in a window, a late block, or the next
+    // block not queued yet each cost that window its shrink.
+    REQUIRE(onTimeBlocks(kWindow / 2, 5) == 0);
+    REQUIRE_FALSE(delay.onTime(1, true));
+    REQUIRE(onTimeBlocks(kWindow / 2 - 1, 5) == 0);
+    REQUIRE(delay.blocks() == 11);
+    REQUIRE(onTimeBlocks(kWindow - 1, 5) == 0);
+    delay.late(false);
+    REQUIRE(onTimeBlocks(kWindow - 1, 5) == 0);
+    REQUIRE(delay.blocks() == 11);
+    REQUIRE_FALSE(delay.onTime(5, false));
+    REQUIRE(delay.blocks() == 11);
+
+    // Mid-window progress survives a snapshot; a delay out of range fails it.
+    REQUIRE(onTimeBlocks(kWindow - 2, 3) == 0);
+    dsp::StateWriter writer;
+    delay.saveState(writer);
+    engine::AdaptiveTailDelay restored(6, 12, kWindow);
+    dsp::StateReader reader(writer.bytes());
+    REQUIRE(restored.loadState(reader));
+    REQUIRE(reader.atEnd());
+    REQUIRE(restored.blocks() == 11);
+    REQUIRE_FALSE(restored.onTime(3, true));
+    REQUIRE(restored.onTime(3, true));
+    REQUIRE(restored.blocks() == 10);
+    engine::AdaptiveTailDelay narrow(6, 8, kWindow);
+    dsp::StateReader tooLong(writer.bytes());
+    REQUIRE_FALSE(narrow.loadState(tooLong));
+    REQUIRE_FALSE(tooLong.ok());
+    REQUIRE(narrow.blocks() == 6);
+
+    // Steady on-time blocks settle back at the minimum, a block per window,
+    // and stay there.
+    REQUIRE(onTimeBlocks(kWindow * 5, 2) == 5);
+    REQUIRE(delay.blocks() == 6);
+    REQUIRE(onTimeBlocks(kWindow * 3, 2) == 0);
+    REQUIRE(delay.blocks() == 6);
+
+    delay.late(true);
+    delay.reset();
+    REQUIRE(delay.blocks() == 6);
+}
+
+TEST_CASE("QualityGovernor 负载过高时逐级降级并在空闲后恢复", "[engine-core][metrics]") {
+    constexpr double kPeriodUs = 10000.0;  // 10 ms callbacks
+    const auto callbacks = [&](double seconds) {
+        return static_cast<int>(seconds * 1e6 / kPeriodUs);
+    };
+    engine::QualityGovernor governor;
+
+    // Comfortable load never steps down.
+    for (int i = 0; i < callbacks(10.0); ++i) {
+        REQUIRE(governor.record(0.6 * kPeriodUs, kPeriodUs) == 0);
+    }
+
+    // Sustained pressure steps down once per settle time, up to kMaxLevel.
+    for (int i = 0; i < callbacks(0.4); ++i) {
+        governor.record(0.95 * kPeriodUs, kPeriodUs);
+    }
+    REQUIRE(governor.level() == 1);
+    for (int i = 0; i < callbacks(0.2); ++i) {
+        governor.record(0.95 * kPeriodUs, kPeriodUs);
+    }
+    REQUIRE(governor.level() == 1);
+    for (int i = 0; i < callbacks(5.0); ++i) {
+        governor.record(0.95 * kPeriodUs, kPeriodUs);
+    }
+    REQUIRE(governor.level() == engine::QualityGovernor::kMaxLevel);
+
+    // Headroom brings it back one step per recovery time.
+    for (int i = 0; i < callbacks(6.0); ++i) {
+        governor.record(0.2 * kPeriodUs, kPeriodUs);
+    }
+    REQUIRE(governor.level() == engine::QualityGovernor::kMaxLevel - 1);
+    for (int i = 0; i < callbacks(20.0); ++i) {
+        governor.record(0.2 * kPeriodUs, kPeriodUs);
+    }
+    REQUIRE(governor.level() == 0);
+
+    // Two overruns close together count as pressure even at a low average.
+    governor.record(1.5 * kPeriodUs, kPeriodUs);
+    REQUIRE(governor.level() == 0);
+    governor.record(0.2 * kPeriodUs, kPeriodUs);
+    REQUIRE(governor.record(1.5 * kPeriodUs, kPeriodUs) == 1);
+
+    governor.reset();
+    REQUIRE(governor.level() == 0);
+    REQUIRE(governor.record(0.0, 0.0) == 0);
+}
+
+TEST_CASE("Tracer 导出各线程时间线为 Chrome trace JSON", "[engine-core][metrics]") {
+    std::ostringstream json;
+#if SATORI_TRACING_ENABLED
+    engine::ClearTrace();
+    std::thread([] {
+        engine::SetTraceThreadName("trace \"worker\"");
+        const engine::TraceZone zone("worker zone");
+    }).join();
+    {
+        const engine::TraceZone outer("outer zone");
+        const engine::TraceZone inner("inner zone");
+    }
+    REQUIRE(engine::WriteChromeTrace(json));
+    const std::string text = json.str();
+    REQUIRE(text.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(text.find("\"name\":\"worker zone\"") != std::string::npos);
+    REQUIRE(text.find("\"name\":\"inner zone\"") != std::string::npos);
+    REQUIRE(text.find("trace \\\"worker\\\"") != std::string::npos);  // escaped
+    // Zones come out oldest first.
+    REQUIRE(text.find("worker zone") < text.find("outer zone"));
+
+    // The ring keeps the newest kTraceEventsPerThread zones.
+    engine::ClearTrace();
+    for (std::size_t i = 0; i < engine::kTraceEventsPerThread + 100; ++i) {
+        engine::RecordTraceZone("wrapped", engine::TraceNowNs(), engine::TraceNowNs());
+    }
+    std::ostringstream wrapped;
+    REQUIRE(engine::WriteChromeTrace(wrapped));
+    const std::string wrappedText = wrapped.str();
+    std::size_t count = 0;
+    for (auto at = wrappedText.find("\"wrapped\""); at != std::string::npos;
+         at = wrappedText.find("\"wrapped\"", at + 1)) {
+        ++count;
+    }
+    REQUIRE(count == engine::kTraceEventsPerThread);
+
+    engine::ClearTrace();
+    std::ostringstream cleared;
+    REQUIRE(engine::WriteChromeTrace(cleared));
+    REQUIRE(cleared.str().find("wrapped") == std::string::npos);
+#else
+    const engine::TraceZone zone("compiled out");
+    REQUIRE_FALSE(engine::WriteChromeTrace(json));
+    REQUIRE(json.str().empty());
+#endif
+}
+
+TEST_CASE("HostFrameClock 将主机时间戳映射为块内精确帧", "[engine-core][events]") {
+    engine::HostFrameClock clock;
+    REQUIRE_FALSE(clock.frameAt(0).has_value());
+
+    // 1 MHz host clock, 48 kHz engine, 256-frame blocks.
+    const double framesPerTick = 48000.0 / 1.0e6;
+    clock.publish(5'000'000, 96'000, framesPerTick, 256);
+    REQUIRE(clock.frameAt(5'000'000) == 96'000u + 256u);
+    REQUIRE(clock.frameAt(5'001'000) == 96'000u + 256u + 48u);  // 1 ms later
+    // Stamped before the anchored block started: no earlier than its start.
+    REQUIRE(clock.frameAt(4'990'000) == 96'000u);
+
+    // The next block re-anchors; the same instant maps to the same frame.
+    clock.publish(5'000'000 + 5'333, 96'256, framesPerTick, 256);
+    REQUIRE(clock.frameAt(5'010'000) == 96'000u + 256u + 480u);
+    // Long after the last callback (stream stopped): no estimate.
+    REQUIRE_FALSE(clock.frameAt(6'000'000).has_value());
+    // Unless it is a time scheduled ahead of a fresh anchor.
+    REQUIRE(clock.frameAt(6'000'000, 5'010'000) == 96'256u + 256u + 47'744u);
+    REQUIRE_FALSE(clock.frameAt(6'000'000, 6'000'000).has_value());
+
+    // Events stamped at those times land sample-accurately in a render.
+    engine::StringSynthEngine engine{};
+    engine.setSampleRate(48000.0);
+    clock.publish(0, engine.renderedFrames(), framesPerTick, 256);
+    engine::Event on;
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 60;
+    on.frequency = 261.63;
+    REQUIRE(engine.enqueueEventAt(on, *clock.frameAt(1'000)));
+    std::vector<float> out(512, 0.0f);
+    engine.process(engine::ProcessBlock{out.data(), out.size(), 1});
+    const auto first = std::find_if(out.begin(), out.end(),
+                                    [](float v) { return v != 0.0f; });
+    REQUIRE(first != out.end());
+    REQUIRE(std::distance(out.begin(), first) == 256 + 48);
+}
+
+TEST_CASE("ScopeTap 输出单声道抽取样本且跨块保持相位", "[engine-core][metrics]") {
+    auto tap = std::make_unique<engine::ScopeTap>();
+    std::vector<float> out(4, 0.0f);
+    REQUIRE_FALSE(tap->readLatest(out.data(), out.size()));
+
+    // Stereo frame f is (0.5f, 1.5f), so the mono mix is f; odd block
+    // lengths make a decimation pair straddle two blocks.
+    std::vector<float> block;
+    int frame = 0;
+    for (const std::size_t frames : {3u, 5u, 7u, 1u}) {
+        block.clear();
+        for (std::size_t i = 0; i < frames; ++i, ++frame) {
+            block.push_back(static_cast<float>(frame) * 0.5f);
+            block.push_back(static_cast<float>(frame) * 1.5f);
+        }
+        tap->publish(block.data(), frames, 2);
+    }
+    REQUIRE(tap->written() == 8);  // 16 frames / 2
+    REQUIRE(tap->readLatest(out.data(), out.size()));
+    // Pairs (8,9) .. (14,15) average to 8.5 .. 14.5.
+    REQUIRE(out[0] == Catch::Approx(8.5f));
+    REQUIRE(out[3] == Catch::Approx(14.5f));
+    REQUIRE_FALSE(tap->readLatest(out.data(), engine::ScopeTap::kCapacity));
+}
+
+TEST_CASE("SpectrumAnalyzer 满幅正弦在对应频带读数约 0 dBFS", "[dsp]") {
+    const double sampleRate = 24000.0;
+    dsp::SpectrumAnalyzer analyzer(2048);
+    std::vector<float> samples(analyzer.fftSize());
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<float>(std::sin(2.0 * 3.14159265358979323846 * 1000.0 *
+                                                 static_cast<double>(i) / sampleRate));
+    }
+    std::vector<float> bands;
+    analyzer.analyze(samples.data(), sampleRate, 32, 40.0f, bands);
+    REQUIRE(bands.size() == 32);
+
+    const auto peak = std::max_element(bands.begin(), bands.end());
+    REQUIRE(*peak == Catch::Approx(0.0f).margin(1.5f));
+    // The peak band is the one covering 1 kHz on the log axis.
+    const double position = std::log(1000.0 / 40.0) / std::log(12000.0 / 40.0) * 32.0;
+    REQUIRE(std::abs(static_cast<double>(peak - bands.begin()) - position) <= 1.0);
+    REQUIRE(bands.front() < -40.0f);
+
+    std::vector<float> silence(analyzer.fftSize(), 0.0f);
+    analyzer.analyze(silence.data(), sampleRate, 8, 40.0f, bands, -90.0f);
+    REQUIRE(std::all_of(bands.begin(), bands.end(), [](float db) { return db == -90.0f; }));
+}
+
+TEST_CASE("StringSynthEngine 多线程渲染与单线程输出一致", "[engine-core][threads]") {
+    auto render = [](std::size_t renderThreads) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 31u;
+        engine::StringSynthEngine engine(cfg, 32, renderThreads);
+        engine.setSampleRate(48000.0);
+        std::vector<engine::Event> events;
+        for (int i = 0; i < 24; ++i) {
+            engine::Event on{};
+            on.type = engine::EventType::NoteOn;
+            on.noteId = i + 1;
+            on.frequency = 73.42 * std::pow(2.0, i / 7.0);
+            on.velocity = 0.4f + 0.02f * static_cast<float>(i);
+            on.frameOffset = static_cast<std::uint64_t>(i) * 37;
+            events.push_back(on);
+        }
+        return renderEngineSequence(engine, events, 6000, 2, 128);
+    };
+
+    const auto single = render(0);
+    const auto threaded = render(3);
+    REQUIRE(single.size() == threaded.size());
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < single.size(); ++i) {
+        if (single[i] != threaded[i]) {
+            ++mismatches;
+        }
+    }
+    REQUIRE(mismatches == 0);
+    REQUIRE(maxAbs(single) > 0.0f);
+}
+
+TEST_CASE("StringSynthEngine status() 无锁读取引擎状态", "[engine-core][params]") {
+    synthesis::StringConfig cfg;
+    cfg.seed = 42u;
+    cfg.excitationType = synthesis::ExcitationType::Hammer;
+    engine::StringSynthEngine engine(cfg);
+    REQUIRE(engine.stringConfig().seed == 42u);
+    REQUIRE(engine.stringConfig().excitationType == synthesis::ExcitationType::Hammer);
+    engine.setSampleRate(48000.0);
+
+    auto status = engine.status();
+    REQUIRE(status.sampleRate == Catch::Approx(48000.0));
+    REQUIRE(status.activeVoices == 0);
+    REQUIRE_FALSE(status.hasScheduledEvent);
+
+    engine::Event on{};
+    on.type = engine::EventType::NoteOn;
+    on.noteId = 1;
+    on.frequency = 220.0;
+    engine::Event late = on;
+    late.noteId = 2;
+    late.frameOffset = 1000;
+    const std::array<engine::Event, 2> events{on, late};
+    REQUIRE(engine.enqueueEvents(events) == 2);
+    REQUIRE(engine.status().queuedEvents == 2);
+
+    std::vector<float> out(256);
+    engine::ProcessBlock block{out.data(), out.size(), 1};
+    engine.process(block);
+    status = engine.status();
+    REQUIRE(status.renderedFrames == 256);
+    REQUIRE(status.activeVoices == 1);
+    REQUIRE(status.queuedEvents == 1);
+    REQUIRE(status.hasScheduledEvent);
+    REQUIRE(status.nextEventFrame == 1000);
+}
+
+TEST_CASE("StringSynthEngine setParams 一次提交多个参数", "[engine-core][params]") {
+    auto render = [](bool batched) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 9u;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(48000.0);
+        engine.noteOn(1, 330.0, 0.8f);
+        std::vector<float> out(256);
+        engine::ProcessBlock block{out.data(), out.size(), 1};
+        engine.process(block);
+        const std::array<engine::ParamValue, 3> values{{
+            {engine::ParamId::Brightness, 0.2f},
+            {engine::ParamId::MasterGain, 0.5f},
+            {engine::ParamId::Decay, 5.0f},  // clamped like setParam
+        }};
+        if (batched) {
+            engine.setParams(values);
+        } else {
+            for (const auto& value : values) {
+                engine.setParam(value.id, value.value);
+            }
+        }
+        REQUIRE(engine.getParam(engine::ParamId::Brightness) == Catch::Approx(0.2f));
+        REQUIRE(engine.getParam(engine::ParamId::MasterGain) == Catch::Approx(0.5f));
+        REQUIRE(engine.getParam(engine::ParamId::Decay) ==
+                Catch::Approx(engine::GetParamInfo(engine::ParamId::Decay)->maxValue));
+        std::vector<float> rendered(4096);
+        for (std::size_t offset = 0; offset < rendered.size(); offset += 256) {
+            engine::ProcessBlock next{rendered.data() + offset, 256, 1};
+            engine.process(next);
+        }
+        return rendered;
+    };
+
+    const auto batched = render(true);
+    const auto single = render(false);
+    REQUIRE(maxAbs(batched) > 0.0f);
+    REQUIRE(batched == single);
+}
+
+TEST_CASE("StringSynthEngine 连续参数变化平滑过渡", "[engine-core][params]") {
+    constexpr std::size_t kFrames = 24000;
+    constexpr std::uint64_t kChangeFrame = 4800;
+    auto render = [&](bool mute) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 5u;
+        cfg.decay = 0.999f;
+        engine::StringSynthEngine engine(cfg);
+        engine.setSampleRate(48000.0);
+        std::vector<engine::Event> events;
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = 220.0;
+        on.velocity = 0.9f;
+        events.push_back(on);
+        if (mute) {
+            engine::Event gain{};
+            gain.type = engine::EventType::ParamChange;
+            gain.param = engine::ParamId::MasterGain;
+            gain.paramValue = 0.0f;
+            gain.frameOffset = kChangeFrame;
+            events.push_back(gain);
+        }
+        return renderEngineSequence(engine, events, kFrames, 1, 256);
+    };
+
+    const auto reference = render(false);
+    const auto muted = render(true);
+    REQUIRE(std::equal(muted.begin(), muted.begin() + kChangeFrame, reference.begin()));
+    // The gain glides down instead of stepping to zero at the event.
+    const float first = std::abs(muted[kChangeFrame]);
+    REQUIRE(first > 0.9f * std::abs(reference[kChangeFrame]));
+    const std::size_t fiveMs = 240;
+    std::size_t louder = 0;
+    for (std::size_t i = kChangeFrame; i < kChangeFrame + fiveMs; ++i) {
+        if (std::abs(muted[i]) > std::abs(reference[i]) + 1.0e-6f) {
+            ++louder;
+        }
+    }
+    REQUIRE(louder == 0);
+    // Settled well within 200 ms.
+    float tail = 0.0f;
+    for (std::size_t i = kChangeFrame + 9600; i < kFrames; ++i) {
+        tail = std::max(tail, std::abs(muted[i]));
+    }
+    REQUIRE(tail < 1.0e-4f);
+    REQUIRE(maxAbs(reference) > 0.0f);
+}
+
+TEST_CASE("StringSynthEngine 平面输出与交错输出一致", "[engine-core]") {
+    constexpr std::size_t kFrames = 3000;
+    constexpr std::size_t kBlock = 160;
+    auto makeEngine = [] {
+        synthesis::StringConfig cfg;
+        cfg.seed = 17u;
+        auto engine = std::make_unique<engine::StringSynthEngine>(cfg);
+        engine->setSampleRate(48000.0);
+        for (int i = 0; i < 4; ++i) {
+            engine::Event on{};
+            on.type = engine::EventType::NoteOn;
+            on.noteId = i + 1;
+            on.frequency = 110.0 * (i + 1);
+            on.velocity = 0.8f;
+            engine->enqueueEventAt(on, static_cast<std::uint64_t>(i) * 211);
+        }
+        return engine;
+    };
+
+    for (uint16_t channels : {uint16_t{1}, uint16_t{2}, uint16_t{3}}) {
+        auto interleavedEngine = makeEngine();
+        const auto interleaved =
+            renderEngineSequence(*interleavedEngine, {}, kFrames, channels, kBlock);
+
+        auto planarEngine = makeEngine();
+        std::vector<std::vector<float>> planes(channels, std::vector<float>(kFrames, 0.0f));
+        std::vector<float*> pointers(channels);
+        for (std::size_t cursor = 0; cursor < kFrames; cursor += kBlock) {
+            const std::size_t frames = std::min(kBlock, kFrames - cursor);
+            for (uint16_t ch = 0; ch < channels; ++ch) {
+                pointers[ch] = planes[ch].data() + cursor;
+            }
+            planarEngine->process(engine::PlanarProcessBlock{pointers.data(), frames, channels});
+        }
+
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < kFrames; ++i) {
+            for (uint16_t ch = 0; ch < channels; ++ch) {
+                if (planes[ch][i] != interleaved[i * channels + ch]) {
+                    ++mismatches;
+                }
+            }
+        }
+        REQUIRE(mismatches == 0);
+        REQUIRE(maxAbs(interleaved) > 0.0f);
+    }
+}
+
+TEST_CASE("半带抽取保留通带并滤除镜像频段", "[dsp][oversampling]") {
+    // Input at 96 kHz: 1 kHz stays, 40 kHz (above the 24 kHz Nyquist) goes.
+    constexpr std::size_t kFrames = 2048;
+    const auto decimate = [&](double hz) {
+        std::vector<float> input(2 * kFrames);
+        for (std::size_t i = 0; i < input.size(); ++i) {
+            input[i] = static_cast<float>(std::sin(2.0 * 3.141592653589793 * hz * i / 96000.0));
+        }
+        dsp::HalfbandDecimator decimator;
+        std::vector<float> output(kFrames);
+        // Odd split: state carries across calls.
+        decimator.process(input.data(), output.data(), 333);
+        decimator.process(input.data() + 666, output.data() + 333, kFrames - 333);
+        return rms(output, 256, kFrames);
+    };
+    REQUIRE(decimate(1000.0) == Catch::Approx(std::sqrt(0.5)).margin(0.01));
+    REQUIRE(decimate(40000.0) < 1e-3f);
+
+    // Interpolating an impulse response keeps its sum and its timing.
+    std::vector<float> response(64, 0.0f);
+    response[30] = 1.0f;
+    response[31] = 0.5f;
+    std::vector<float> up(128, 0.0f);
+    REQUIRE(dsp::UpsampleHalfband(response.data(), response.size(), up.data(), up.size()) == 128);
+    REQUIRE(std::accumulate(up.begin(), up.end(), 0.0) == Catch::Approx(1.5).margin(1e-3));
+    REQUIRE(up[60] == Catch::Approx(0.5f));
+    REQUIRE(std::distance(up.begin(), std::max_element(up.begin(), up.end())) == 60);
+}
+
+TEST_CASE("StringSynthEngine 高音区声部过采样且低音不受影响", "[engine-core][oversampling]") {
+    constexpr std::size_t kFrames = 8192;
+    const auto render = [&](double threshold, double frequency) {
+        synthesis::StringConfig cfg;
+        cfg.seed = 17u;
+        cfg.sampleRate = 44100.0;
+        cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+        engine::StringSynthEngine engine(cfg);
+        REQUIRE(engine.oversamplingThreshold() ==
+                engine::StringSynthEngine::kDefaultOversamplingThresholdHz);
+        engine.setOversamplingThreshold(threshold);
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = frequency;
+        on.velocity = 0.8f;
+        return renderEngineSequence(engine, {on}, kFrames);
+    };
+
+    const auto plain = render(0.0, 3520.0);
+    const auto oversampled = render(2000.0, 3520.0);
+    REQUIRE(std::all_of(oversampled.begin(), oversampled.end(),
+                        [](float v) { return std::isfinite(v); }));
+    REQUIRE(oversampled != plain);
+    const double hz = estimateFundamentalAutocorr(oversampled, 44100.0, 3520.0);
+    INFO("hz=" << hz);
+    REQUIRE(hz == Catch::Approx(3520.0).epsilon(0.01));
+    // The loop's brightness is rescaled for the rate, so the note stays at
+    // its level; a little louder, as the 1x loop filter damps harder this
+    // close to Nyquist.
+    const float plainLevel = rms(plain, 64, 1024);
+    const float oversampledLevel = rms(oversampled, 64, 1024);
+    INFO("plain=" << plainLevel << " oversampled=" << oversampledLevel);
+    REQUIRE(oversampledLevel > 0.8f * plainLevel);
+    REQUIRE(oversampledLevel < 3.0f * plainLevel);
+
+    // Below the threshold nothing changes, bit for bit.
+    REQUIRE(render(2000.0, 440.0) == render(0.0, 440.0));
+}
+
+TEST_CASE("StringSynthEngine 降低复音上限时淡出多余音符", "[engine-core][voices]") {
+    constexpr std::size_t kBlock = 256;
+    synthesis::StringConfig cfg;
+    cfg.seed = 5u;
+    cfg.sampleRate = 44100.0;
+    engine::StringSynthEngine engine(cfg, 8);
+    REQUIRE(engine.voiceLimit() == 8);
+    std::vector<float> buffer(kBlock, 0.0f);
+    const auto render = [&](std::size_t blocks) {
+        for (std::size_t b = 0; b < blocks; ++b) {
+            engine.process(engine::ProcessBlock{buffer.data(), kBlock, 1});
+        }
+    };
+    for (int i = 0; i < 8; ++i) {
+        engine.noteOn(i + 1, 110.0 * (i + 1), 0.8f);
+    }
+    render(2);
+    REQUIRE(engine.activeVoiceCount() == 8);
+
+    // Shed down to two; the rest fade like stolen voices and then retire.
+    engine.setVoiceLimit(2);
+    REQUIRE(engine.voiceLimit() == 2);
+    render(40);
+    REQUIRE(engine.activeVoiceCount() == 2);
+
+    // New notes steal within the limit instead of growing past it.
+    engine.noteOn(20, 660.0, 0.8f);
+    engine.noteOn(21, 770.0, 0.8f);
+    render(40);
+    REQUIRE(engine.activeVoiceCount() == 2);
+    REQUIRE(maxAbs(buffer) > 0.0f);
+
+    // 0 lifts the cap and larger requests clamp to maxVoices().
+    engine.setVoiceLimit(0);
+    REQUIRE(engine.voiceLimit() == 8);
+    engine.setVoiceLimit(100);
+    REQUIRE(engine.voiceLimit() == 8);
+    for (int i = 0; i < 6; ++i) {
+        engine.noteOn(30 + i, 220.0 + 20.0 * i, 0.8f);
+    }
+    render(2);
+    REQUIRE(engine.activeVoiceCount() == 8);
+}
+
+TEST_CASE("StringSynthEngine 按渲染开销预算分配声部", "[engine-core][voices]") {
+    constexpr std::size_t kBlock = 256;
+    synthesis::StringConfig cfg;
+    cfg.seed = 5u;
+    cfg.sampleRate = 44100.0;
+    engine::StringSynthEngine engine(cfg, 8);
+    std::vector<float> buffer(kBlock, 0.0f);
+    const auto render = [&](std::size_t blocks) {
+        for (std::size_t b = 0; b < blocks; ++b) {
+            engine.process(engine::ProcessBlock{buffer.data(), kBlock, 1});
+        }
+    };
+    const auto strike = [&](int firstId) {
+        for (int i = 0; i < 6; ++i) {
+            engine.noteOn(firstId + i, 220.0 + 40.0 * i, 0.8f);
+        }
+        render(40);
+    };
+
+    // A default string costs 1, so a budget of 3 holds three of them.
+    engine.setVoiceBudget(3.0f);
+    REQUIRE(engine.voiceBudget() == 3.0f);
+    strike(1);
+    REQUIRE(engine.activeVoiceCount() == 3);
+    REQUIRE(maxAbs(buffer) > 0.0f);
+
+    // Oversampled strings cost more than twice as much: the same budget
+    // holds a single one.
+    engine.reset();
+    engine.setOversamplingThreshold(100.0);
+    strike(10);
+    REQUIRE(engine.activeVoiceCount() == 1);
+
+    // Lowering the budget sheds what no longer fits; 0 lifts it.
+    engine.reset();
+    engine.setOversamplingThreshold(0.0);
+    engine.setVoiceBudget(0.0f);
+    strike(20);
+    REQUIRE(engine.activeVoiceCount() == 6);
+    engine.setVoiceBudget(2.0f);
+    render(40);
+    REQUIRE(engine.activeVoiceCount() == 2);
+}
+
+TEST_CASE("StringSynthEngine 快照恢复后逐样本继续渲染", "[engine-core][snapshot]") {
+    constexpr std::size_t kBlock = 256;
+    synthesis::StringConfig cfg;
+    cfg.seed = 17u;
+    cfg.sampleRate = 48000.0;
+    cfg.sympatheticAmount = 0.4f;
+    cfg.stereoSpread = 0.6f;
+    cfg.roomAmount = 0.0f;
+    auto makeEngine = [&]() { return std::make_unique<engine::StringSynthEngine>(cfg, 8); };
+    auto render = [](engine::StringSynthEngine& engine, std::size_t blocks) {
+        std::vector<float> out(blocks * kBlock * 2, 0.0f);
+        for (std::size_t b = 0; b < blocks; ++b) {
+            engine.process(engine::ProcessBlock{out.data() + b * kBlock * 2, kBlock, 2});
+        }
+        return out;
+    };
+
+    auto source = makeEngine();
+    source->setParam(engine::ParamId::SustainPedal, 1.0f);
+    source->noteOn(1, 98.0, 0.9f);
+    source->noteOn(2, 246.9, 0.7f);
+    source->noteOn(3, 2093.0, 0.8f);  // oversampled
+    source->noteOff(2);
+    render(*source, 12);
+    source->setParam(engine::ParamId::PitchBend, 1.0f);
+    // Still scheduled when the snapshot is taken.
+    engine::Event late{};
+    late.type = engine::EventType::NoteOn;
+    late.noteId = 4;
+    late.frequency = 164.8f;
+    late.velocity = 0.6f;
+    REQUIRE(source->enqueueEventAt(late, source->renderedFrames() + 1000));
+
+    const std::vector<std::uint8_t> snapshot = source->saveSnapshot();
+    REQUIRE_FALSE(snapshot.empty());
+    const std::uint64_t frame = source->renderedFrames();
+
+    // Parameters are the restoring engine's own to match.
+    auto restored = makeEngine();
+    restored->setParam(engine::ParamId::SustainPedal, 1.0f);
+    restored->setParam(engine::ParamId::PitchBend, 1.0f);
+    std::string error;
+    REQUIRE(restored->restoreSnapshot(snapshot, error));
+    REQUIRE(restored->renderedFrames() == frame);
+    REQUIRE(restored->activeVoiceCount() == source->activeVoiceCount());
+    REQUIRE(restored->queuedEventCount() == source->queuedEventCount());
+
+    const auto expected = render(*source, 24);
+    const auto actual = render(*restored, 24);
+    REQUIRE(maxAbs(expected) > 0.0f);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i] != actual[i]) {
+            ++mismatches;
+        }
+    }
+    REQUIRE(mismatches == 0);
+
+    // Cut short, or for an engine laid out differently: refused, silent.
+    auto truncated = makeEngine();
+    truncated->noteOn(9, 440.0, 0.8f);
+    render(*truncated, 1);
+    error.clear();
+    REQUIRE_FALSE(truncated->restoreSnapshot(
+        std::span(snapshot.data(), snapshot.size() - 7), error));
+    REQUIRE_FALSE(error.empty());
+    REQUIRE(truncated->activeVoiceCount() == 0);
+    engine::StringSynthEngine twoParts(cfg, 8, 0, 2);
+    error.clear();
+    REQUIRE_FALSE(twoParts.restoreSnapshot(snapshot, error));
+    REQUIRE_FALSE(error.empty());
+}
+
+TEST_CASE("StringSynthEngine 房间开启时快照恢复后尾部逐样本一致", "[engine-core][snapshot]") {
+    // 200-frame blocks leave the save partway through a room block.
+    constexpr std::size_t kBlock = 200;
+    for (const float roomType : {0.0f, 1.0f}) {
+        INFO("roomType=" << roomType);
+        synthesis::StringConfig cfg;
+        cfg.seed = 23u;
+        cfg.sampleRate = 48000.0;
+        cfg.roomAmount = 0.5f;
+        // Away from IR 0, so the tail is still ringing the first IR out.
+        cfg.roomIrIndex = std::min(1, static_cast<int>(dsp::RoomIrLibrary::list().size()) - 1);
+        auto makeEngine = [&]() {
+            auto engine = std::make_unique<engine::StringSynthEngine>(cfg, 8);
+            engine->setRenderMode(engine::RenderMode::Offline);
+            engine->setParam(engine::ParamId::RoomType, roomType);
+            return engine;
+        };
+        auto render = [](engine::StringSynthEngine& engine, std::size_t blocks) {
+            std::vector<float> out(blocks * kBlock * 2, 0.0f);
+            for (std::size_t b = 0; b < blocks; ++b) {
+                engine.process(engine::ProcessBlock{out.data() + b * kBlock * 2, kBlock, 2});
+            }
+            return out;
+        };
+
+        auto source = makeEngine();
+        source->noteOn(1, 146.8, 0.9f);
+        source->noteOn(2, 440.0, 0.7f);
+        render(*source, 30);
+        source->noteOff(1);
+        source->noteOff(2);
+        render(*source, 7);
+        const std::vector<std::uint8_t> snapshot = source->saveSnapshot();
+
+        auto restored = makeEngine();
+        std::string error;
+        REQUIRE(restored->restoreSnapshot(snapshot, error));
+        const auto expected = render(*source, 60);
+        const auto actual = render(*restored, 60);
+        REQUIRE(maxAbs(expected) > 0.0f);
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i] != actual[i]) {
+                ++mismatches;
+            }
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("MemoryUsage 按子系统统计引擎占用的内存", "[engine-core][memory]") {
+    using engine::MemoryCategory;
+    const engine::MemoryUsage before = engine::ReadMemoryUsage();
+    {
+        synthesis::StringConfig cfg;
+        cfg.sampleRate = 44100.0;
+        engine::StringSynthEngine engine(cfg, 8);
+        const engine::MemoryUsage live = engine::ReadMemoryUsage();
+        REQUIRE(live[MemoryCategory::Voices] > before[MemoryCategory::Voices]);
+        REQUIRE(live[MemoryCategory::Queues] > before[MemoryCategory::Queues]);
+        REQUIRE(live.total() > before.total());
+    }
+    // Everything the engine counted is given back with it.
+    const engine::MemoryUsage after = engine::ReadMemoryUsage();
+    REQUIRE(after[MemoryCategory::Voices] == before[MemoryCategory::Voices]);
+    REQUIRE(after[MemoryCategory::Queues] == before[MemoryCategory::Queues]);
+
+    // A copy counts again; a move only hands the count over.
+    {
+        engine::TrackedBytes a(MemoryCategory::Preview, 1000);
+        engine::TrackedBytes b = a;
+        REQUIRE(engine::ReadMemoryUsage()[MemoryCategory::Preview] ==
+                before[MemoryCategory::Preview] + 2000);
+        engine::TrackedBytes c = std::move(b);
+        c.set(300);
+        REQUIRE(engine::ReadMemoryUsage()[MemoryCategory::Preview] ==
+                before[MemoryCategory::Preview] + 1300);
+    }
+    REQUIRE(engine::ReadMemoryUsage()[MemoryCategory::Preview] == before[MemoryCategory::Preview]);
+}
+
+TEST_CASE("StringSynthEngine 冻结的声部用预渲染的采样发声", "[engine-core][freeze]") {
+    constexpr std::size_t kFrames = 8192;
+    synthesis::StringConfig cfg;
+    cfg.seed = 7u;
+    cfg.sampleRate = 44100.0;
+    cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    cfg.roomAmount = 0.0f;
+    cfg.sympatheticAmount = 0.0f;
+    const auto strike = [](engine::StringSynthEngine& engine, double frequency) {
+        engine::Event on{};
+        on.type = engine::EventType::NoteOn;
+        on.noteId = 1;
+        on.frequency = frequency;
+        on.velocity = 1.0f;
+        return renderEngineSequence(engine, {on}, kFrames);
+    };
+
+    engine::StringSynthEngine modelled(cfg);
+    engine::StringSynthEngine frozen(cfg);
+    REQUIRE(frozen.partFreezeStatus(0) == engine::FreezeStatus::Off);
+    frozen.setPartFrozen(0, true);
+    REQUIRE(frozen.partFreezeStatus(0) != engine::FreezeStatus::Off);
+    for (int i = 0; i < 6000 && frozen.partFreezeStatus(0) != engine::FreezeStatus::Ready; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    REQUIRE(frozen.partFreezeStatus(0) == engine::FreezeStatus::Ready);
+
+    // A rendered key at a rendered velocity plays the string back as it was
+    // modelled, to 16-bit resolution.
+    const auto reference = strike(modelled, 440.0);
+    const auto played = strike(frozen, 440.0);
+    REQUIRE(maxAbs(reference) > 0.01f);
+    float error = 0.0f;
+    for (std::size_t i = 0; i < kFrames; ++i) {
+        error = std::max(error, std::abs(played[i] - reference[i]));
+    }
+    INFO("error=" << error);
+    REQUIRE(error < 1e-3f);
+
+    // Between keys the nearest one is repitched.
+    const auto between = strike(frozen, 452.0);
+    REQUIRE(estimateFundamentalAutocorr(between, 44100.0, 452.0) ==
+            Catch::Approx(452.0).epsilon(0.01));
+
+    frozen.setPartFrozen(0, false);
+    REQUIRE(frozen.partFreezeStatus(0) == engine::FreezeStatus::Off);
+}
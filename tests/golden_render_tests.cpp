@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "engine/StringSynthEngine.h"
+
+// Reference phrases rendered through StringSynthEngine with fixed seeds and
+// compared against tests/golden/renders.txt: an identical render matches the
+// stored hash; one that differs only by rounding (another compiler, FFT
+// backend or SIMD width) must still match the stored segment levels within
+// kRelativeTolerance. SATORI_UPDATE_GOLDEN=1 rewrites the file from the
+// current renders, for changes that are meant to alter the sound.
+// SATORI_GOLDEN_TIMINGS=<file> appends each phrase's render time to a CSV.
+
+namespace {
+
+constexpr double kSampleRate = 48000.0;
+constexpr std::size_t kSegments = 16;
+constexpr double kRelativeTolerance = 1e-3;
+constexpr double kAbsoluteTolerance = 1e-6;
+
+struct Phrase {
+    const char* name;
+    double seconds;
+    std::uint16_t channels;
+    std::size_t renderThreads;
+    std::function<void(engine::StringSynthEngine&)> setup;
+    std::vector<engine::Event> events;
+};
+
+struct Fingerprint {
+    std::size_t frames = 0;
+    std::uint64_t hash = 0;
+    std::vector<double> levels;  // RMS per segment, then the peak
+};
+
+engine::Event NoteOn(int id, double frequency, float velocity, double at) {
+    engine::Event event{};
+    event.type = engine::EventType::NoteOn;
+    event.noteId = id;
+    event.frequency = frequency;
+    event.velocity = velocity;
+    event.frameOffset = static_cast<std::uint64_t>(at * kSampleRate);
+    return event;
+}
+
+engine::Event NoteOff(int id, double at) {
+    engine::Event event{};
+    event.type = engine::EventType::NoteOff;
+    event.noteId = id;
+    event.frameOffset = static_cast<std::uint64_t>(at * kSampleRate);
+    return event;
+}
+
+engine::Event Param(engine::ParamId id, float value, double at) {
+    engine::Event event{};
+    event.type = engine::EventType::ParamChange;
+    event.param = id;
+    event.paramValue = value;
+    event.frameOffset = static_cast<std::uint64_t>(at * kSampleRate);
+    return event;
+}
+
+void FixedSeed(engine::StringSynthEngine& engine, std::uint32_t seed) {
+    auto cfg = engine.stringConfig();
+    cfg.seed = seed;
+    cfg.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    engine.setConfig(cfg);
+}
+
+std::vector<Phrase> ReferencePhrases() {
+    std::vector<Phrase> phrases;
+    phrases.push_back({"pluck", 1.0, 1, 0,
+                       [](engine::StringSynthEngine& engine) { FixedSeed(engine, 11); },
+                       {NoteOn(1, 220.0, 0.8f, 0.0), NoteOff(1, 0.6)}});
+    const auto chordSetup = [](engine::StringSynthEngine& engine) {
+        FixedSeed(engine, 23);
+        engine.setParam(engine::ParamId::BodyModel, 2.0f);
+        engine.setParam(engine::ParamId::SympatheticAmount, 0.5f);
+    };
+    const std::vector<engine::Event> chord = {
+        NoteOn(1, 196.0, 0.7f, 0.0),
+        NoteOn(2, 246.94, 0.6f, 0.05),
+        NoteOn(3, 293.66, 0.8f, 0.1),
+        Param(engine::ParamId::SustainPedal, 1.0f, 0.3),
+        NoteOff(1, 0.4),
+        NoteOff(2, 0.4),
+        NoteOn(4, 392.0, 0.9f, 0.5),
+        NoteOff(3, 0.7),
+        NoteOff(4, 0.8),
+        Param(engine::ParamId::SustainPedal, 0.0f, 1.0),
+    };
+    phrases.push_back({"chord-sustain", 1.5, 2, 0, chordSetup, chord});
+    // Same render on two helper threads.
+    phrases.push_back({"chord-sustain-pool", 1.5, 2, 2, chordSetup, chord});
+    phrases.push_back({"hammer-room", 1.5, 2, 0,
+                       [](engine::StringSynthEngine& engine) {
+                           FixedSeed(engine, 37);
+                           auto cfg = engine.stringConfig();
+                           cfg.excitationType = synthesis::ExcitationType::Hammer;
+                           engine.setConfig(cfg);
+                           engine.setParam(engine::ParamId::RoomAmount, 0.5f);
+                       },
+                       {NoteOn(1, 130.81, 0.9f, 0.0), NoteOn(2, 261.63, 0.5f, 0.25),
+                        NoteOff(1, 0.5), NoteOff(2, 0.75)}});
+    phrases.push_back({"algorithmic-room", 1.0, 2, 0,
+                       [](engine::StringSynthEngine& engine) {
+                           FixedSeed(engine, 41);
+                           engine.setParam(engine::ParamId::RoomType, 1.0f);
+                           engine.setParam(engine::ParamId::RoomAmount, 0.6f);
+                       },
+                       {NoteOn(1, 329.63, 0.8f, 0.0), NoteOff(1, 0.3)}});
+    phrases.push_back({"bend-vibrato-modulation", 1.0, 1, 0,
+                       [](engine::StringSynthEngine& engine) {
+                           FixedSeed(engine, 53);
+                           engine.setParam(engine::ParamId::VibratoDepth, 0.3f);
+                           engine::ModulationSettings modulation;
+                           modulation.lfos[0].rateHz = 4.0f;
+                           modulation.addRoute(engine::ModSource::Lfo1,
+                                               engine::ModTarget::Brightness, 0.3f);
+                           modulation.addRoute(engine::ModSource::Velocity,
+                                               engine::ModTarget::PickPosition, -0.2f);
+                           engine.setModulation(modulation);
+                       },
+                       {NoteOn(1, 261.63, 0.9f, 0.0),
+                        Param(engine::ParamId::PitchBend, 2.0f, 0.2), NoteOff(1, 0.8)}});
+    return phrases;
+}
+
+std::vector<float> Render(const Phrase& phrase, double& millis) {
+    synthesis::StringConfig cfg;
+    cfg.sampleRate = kSampleRate;
+    engine::StringSynthEngine engine(cfg, engine::StringSynthEngine::kDefaultMaxVoices,
+                                     phrase.renderThreads);
+    engine.setRenderMode(engine::RenderMode::Offline);
+    phrase.setup(engine);
+    for (const auto& event : phrase.events) {
+        engine.enqueueEventAt(event, event.frameOffset);
+    }
+    const auto frames = static_cast<std::size_t>(phrase.seconds * kSampleRate);
+    std::vector<float> out(frames * phrase.channels, 0.0f);
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t cursor = 0; cursor < frames;) {
+        const std::size_t count = std::min<std::size_t>(256, frames - cursor);
+        engine.process(
+            engine::ProcessBlock{out.data() + cursor * phrase.channels, count, phrase.channels});
+        cursor += count;
+    }
+    millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+                 .count();
+    return out;
+}
+
+Fingerprint Fingerprinted(const std::vector<float>& samples, std::uint16_t channels) {
+    Fingerprint print;
+    print.frames = samples.size() / channels;
+    // FNV-1a over the sample bits, with -0 folded into 0.
+    std::uint64_t hash = 14695981039346656037ull;
+    for (float sample : samples) {
+        std::uint32_t bits = 0;
+        const float value = sample == 0.0f ? 0.0f : sample;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int b = 0; b < 4; ++b) {
+            hash = (hash ^ ((bits >> (8 * b)) & 0xFFu)) * 1099511628211ull;
+        }
+    }
+    print.hash = hash;
+    const std::size_t segment = samples.size() / kSegments;
+    double peak = 0.0;
+    for (std::size_t s = 0; s < kSegments; ++s) {
+        double sum = 0.0;
+        for (std::size_t i = s * segment; i < (s + 1) * segment; ++i) {
+            sum += static_cast<double>(samples[i]) * samples[i];
+            peak = std::max(peak, static_cast<double>(std::abs(samples[i])));
+        }
+        const auto count = static_cast<double>(std::max<std::size_t>(1, segment));
+        print.levels.push_back(std::sqrt(sum / count));
+    }
+    print.levels.push_back(peak);
+    return print;
+}
+
+// One line per phrase: name frames hash level...
+std::map<std::string, Fingerprint> ReadGolden(const char* path) {
+    std::map<std::string, Fingerprint> golden;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string name;
+        Fingerprint print;
+        fields >> name >> print.frames >> std::hex >> print.hash >> std::dec;
+        double level = 0.0;
+        while (fields >> level) {
+            print.levels.push_back(level);
+        }
+        golden[name] = print;
+    }
+    return golden;
+}
+
+bool WriteGolden(const char* path, const std::vector<Phrase>& phrases,
+                 const std::vector<Fingerprint>& prints) {
+    std::ofstream out(path, std::ios::trunc);
+    out << "# Golden renders (tests/golden_render_tests.cpp): name frames hash, then the RMS of "
+        << kSegments << " equal segments and the peak.\n";
+    out << "# Regenerate with SATORI_UPDATE_GOLDEN=1 only for changes meant to alter the sound.\n";
+    for (std::size_t p = 0; p < phrases.size(); ++p) {
+        out << phrases[p].name << ' ' << prints[p].frames << ' ' << std::hex << std::setw(16)
+            << std::setfill('0') << prints[p].hash << std::dec << std::setfill(' ');
+        for (double level : prints[p].levels) {
+            out << ' ' << std::setprecision(9) << level;
+        }
+        out << '\n';
+    }
+    return out.good();
+}
+
+bool EnvFlag(const char* name) {
+    const char* value = std::getenv(name);
+    return value && *value && std::strcmp(value, "0") != 0;
+}
+
+}  // namespace
+
+TEST_CASE("黄金渲染与参考一致并记录耗时", "[golden]") {
+    const auto phrases = ReferencePhrases();
+    std::vector<Fingerprint> prints;
+    std::vector<double> millis;
+    for (const auto& phrase : phrases) {
+        double elapsed = 0.0;
+        const auto samples = Render(phrase, elapsed);
+        REQUIRE(std::all_of(samples.begin(), samples.end(),
+                            [](float v) { return std::isfinite(v); }));
+        prints.push_back(Fingerprinted(samples, phrase.channels));
+        millis.push_back(elapsed);
+    }
+
+    if (const char* timings = std::getenv("SATORI_GOLDEN_TIMINGS"); timings && *timings) {
+        std::ofstream csv(timings, std::ios::app);
+        for (std::size_t p = 0; p < phrases.size(); ++p) {
+            csv << phrases[p].name << ',' << prints[p].frames << ',' << millis[p] << ','
+                << phrases[p].seconds * 1000.0 / std::max(millis[p], 1e-6) << '\n';
+        }
+    }
+
+    // The pool renders the same voices, bit for bit.
+    REQUIRE(prints[2].hash == prints[1].hash);
+
+    if (EnvFlag("SATORI_UPDATE_GOLDEN")) {
+        REQUIRE(WriteGolden(SATORI_GOLDEN_FILE, phrases, prints));
+        WARN("golden renders rewritten: " SATORI_GOLDEN_FILE);
+        return;
+    }
+    const auto golden = ReadGolden(SATORI_GOLDEN_FILE);
+    for (std::size_t p = 0; p < phrases.size(); ++p) {
+        INFO("phrase " << phrases[p].name << " (" << millis[p] << " ms)");
+        const auto found = golden.find(phrases[p].name);
+        REQUIRE(found != golden.end());
+        const Fingerprint& expected = found->second;
+        REQUIRE(prints[p].frames == expected.frames);
+        if (prints[p].hash == expected.hash) {
+            continue;
+        }
+        REQUIRE(prints[p].levels.size() == expected.levels.size());
+        for (std::size_t i = 0; i < expected.levels.size(); ++i) {
+            INFO("level " << i);
+            REQUIRE(std::abs(prints[p].levels[i] - expected.levels[i]) <=
+                    kRelativeTolerance * expected.levels[i] + kAbsoluteTolerance);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "plugin/PluginProcessor.h"
+
+TEST_CASE("PluginProcessor 原地渲染宿主平面缓冲且事件按块内偏移生效", "[plugin]") {
+    plugin::PluginProcessor processor;
+    processor.activate(48000.0);
+    processor.setOffline(true);
+
+    std::vector<float> left(256, 1.0f);
+    std::vector<float> right(256, 1.0f);
+    float* outputs[] = {left.data(), right.data()};
+    std::vector<plugin::PluginEvent> events(2);
+    events[0].type = plugin::PluginEvent::Type::Param;
+    events[0].param = engine::ParamId::MasterGain;
+    events[0].value = 0.5f;
+    events[1].type = plugin::PluginEvent::Type::NoteOn;
+    events[1].offset = 100;
+    events[1].key = 69;
+    events[1].velocity = 0.9f;
+    processor.process(outputs, 2, 256, events);
+
+    // Written in place: nothing before the note, sound from its offset on.
+    REQUIRE(std::all_of(left.begin(), left.begin() + 100, [](float s) { return s == 0.0f; }));
+    const auto first = std::find_if(left.begin(), left.end(), [](float s) { return s != 0.0f; });
+    REQUIRE(first != left.end());
+    REQUIRE(std::distance(left.begin(), first) == 100);
+    REQUIRE(processor.getParam(engine::ParamId::MasterGain) == Catch::Approx(0.5f));
+    REQUIRE(processor.engine().activeVoiceCount() == 1);
+
+    // More events than one conversion run, all in one block.
+    std::vector<plugin::PluginEvent> offs(200);
+    for (std::size_t i = 0; i < offs.size(); ++i) {
+        offs[i].type = plugin::PluginEvent::Type::NoteOff;
+        offs[i].key = static_cast<std::int16_t>(i % 128);
+        offs[i].offset = static_cast<std::uint32_t>(i);
+    }
+    processor.process(outputs, 2, 256, offs);
+    REQUIRE(processor.engine().queuedEventCount() == 0);
+
+    REQUIRE(processor.latencyFrames() == 0);
+    REQUIRE(processor.tailFrames() > 48000u / 4);
+}
+
+TEST_CASE("PluginProcessor 状态保存后可在新实例恢复", "[plugin]") {
+    plugin::PluginProcessor source;
+    source.setParam(engine::ParamId::MasterGain, 0.3f);
+    source.setParam(engine::ParamId::BodyModel, 2.0f);
+    const std::string state = source.saveState();
+
+    plugin::PluginProcessor target;
+    std::string error;
+    REQUIRE(target.loadState(state, error));
+    REQUIRE(target.getParam(engine::ParamId::MasterGain) == Catch::Approx(0.3f));
+    REQUIRE(target.getParam(engine::ParamId::BodyModel) == Catch::Approx(2.0f));
+
+    // Unknown names and damaged lines are skipped; nothing usable fails.
+    REQUIRE(target.loadState("masterGain=0.7\nnope=1\nstereoSpread\n", error));
+    REQUIRE(target.getParam(engine::ParamId::MasterGain) == Catch::Approx(0.7f));
+    REQUIRE_FALSE(target.loadState("garbage", error));
+    REQUIRE_FALSE(error.empty());
+}
@@ -0,0 +1,190 @@
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "engine/RealtimeCheck.h"
+#include "posix/audio/NullAudioEngine.h"
+#include "posix/audio/SatoriRealtimeEngine.h"
+#include "posix/audio/UnifiedAudioEngine.h"
+#include "posix/net/OscServer.h"
+
+namespace {
+posixaudio::AudioEngineConfig NullConfig() {
+    posixaudio::AudioEngineConfig config;
+    config.backend = posixaudio::AudioBackendType::Null;
+    config.sampleRate = 48000;
+    config.channels = 2;
+    config.bufferFrames = 256;
+    return config;
+}
+}  // namespace
+
+TEST_CASE("NullAudioEngine 按周期回调且流位置连续", "[posix-audio]") {
+    struct Probe {
+        std::atomic<int> callbacks{0};
+        std::atomic<bool> contiguous{true};
+        std::uint64_t nextFrame = 0;
+
+        void render(float* output, std::size_t frames, const posixaudio::RenderTiming& timing) {
+            if (timing.streamFrame != nextFrame || timing.channels != 2 ||
+                timing.sampleRate != 48000) {
+                contiguous = false;
+            }
+            nextFrame = timing.streamFrame + frames;
+            std::fill_n(output, frames * timing.channels, 0.0f);
+            ++callbacks;
+        }
+    } probe;
+
+    posixaudio::NullAudioEngine device(NullConfig());
+    REQUIRE(device.initialize(posixaudio::RenderCallback::Member<&Probe::render>(&probe)));
+    REQUIRE(device.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    device.stop();
+    device.shutdown();
+    REQUIRE(probe.callbacks.load() >= 2);
+    REQUIRE(probe.contiguous.load());
+}
+
+TEST_CASE("UnifiedAudioEngine 对未编译的后端报错", "[posix-audio]") {
+    using posixaudio::AudioBackendType;
+    REQUIRE(posixaudio::UnifiedAudioEngine::BackendAvailable(AudioBackendType::Null));
+    for (const auto backend : {AudioBackendType::Jack, AudioBackendType::Alsa,
+                               AudioBackendType::CoreAudio}) {
+        if (posixaudio::UnifiedAudioEngine::BackendAvailable(backend)) {
+            continue;
+        }
+        posixaudio::AudioEngineConfig config = NullConfig();
+        config.backend = backend;
+        posixaudio::UnifiedAudioEngine device(config);
+        REQUIRE_FALSE(device.initialize({}));
+        REQUIRE_FALSE(device.lastError().empty());
+        REQUIRE_FALSE(device.start());
+    }
+}
+
+TEST_CASE("SatoriRealtimeEngine 在空设备上跟随设备采样率发声并统计回调", "[posix-audio]") {
+    posixaudio::AudioEngineConfig config = NullConfig();
+    config.sampleRate = 44100;
+    posixaudio::SatoriRealtimeEngine player(config);
+    REQUIRE(player.initialize());
+    REQUIRE(player.synthConfig().sampleRate == Catch::Approx(44100.0));
+    engine::ResetRealtimeViolations();
+    REQUIRE(player.start());
+    player.noteOn(60, 261.63, 0.9f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    const auto m = player.metrics();
+    std::vector<float> scope(64, 0.0f);
+    const bool haveScope = player.readScope(scope.data(), scope.size());
+    player.stop();
+
+    REQUIRE(m.callbackCount >= 2);
+    REQUIRE(m.callbackPeriodMs == Catch::Approx(256.0 * 1000.0 / 44100.0));
+    REQUIRE(m.windowCallbacks == m.callbackCount);
+    REQUIRE(m.activeVoices >= 1);
+    REQUIRE(haveScope);
+    REQUIRE(std::any_of(scope.begin(), scope.end(), [](float s) { return s != 0.0f; }));
+    if (engine::RealtimeHooksInstalled()) {
+        REQUIRE(engine::RealtimeViolationSnapshot().total() == 0);
+    }
+    player.shutdown();
+}
+
+TEST_CASE("SatoriRealtimeEngine 报告端到端输出延迟并随重新配置更新", "[posix-audio]") {
+    posixaudio::AudioEngineConfig config = NullConfig();
+    config.sampleRate = 44100;
+    posixaudio::SatoriRealtimeEngine player(config);
+    REQUIRE(player.initialize());
+    // The null device queues nothing; a note waits for the next callback.
+    auto latency = player.outputLatency();
+    REQUIRE(latency.sampleRate == 44100);
+    REQUIRE(latency.scheduleFrames == 256);
+    REQUIRE(latency.deviceFrames == 0);
+    REQUIRE(latency.resamplerFrames == 0);
+    REQUIRE(latency.totalMs() == Catch::Approx(256.0 * 1000.0 / 44100.0));
+
+    config.sampleRate = 48000;
+    config.bufferFrames = 128;
+    REQUIRE(player.reconfigureAudio(config));
+    latency = player.outputLatency();
+    REQUIRE(latency.totalFrames() == 128);
+    REQUIRE(latency.totalMs() == Catch::Approx(128.0 * 1000.0 / 48000.0));
+
+    REQUIRE(player.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    const auto m = player.metrics();
+    player.stop();
+    REQUIRE(m.latency.totalFrames() == 128);
+    player.shutdown();
+}
+
+TEST_CASE("OscServer 从 UDP 接收音符并推入引擎", "[posix-audio][osc]") {
+    posixaudio::SatoriRealtimeEngine player(NullConfig());
+    REQUIRE(player.initialize());
+    REQUIRE(player.start());
+    posixnet::OscServer osc(player);
+    posixnet::OscServerConfig config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;  // any free port
+    REQUIRE(osc.start(config));
+    REQUIRE(osc.port() != 0);
+
+    const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+    REQUIRE(sender >= 0);
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(osc.port());
+    target.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    auto send = [&](const audio::OscMessage& message) {
+        const auto bytes = audio::EncodeOscMessage(message);
+        return ::sendto(sender, bytes.data(), bytes.size(), 0,
+                        reinterpret_cast<const sockaddr*>(&target), sizeof(target)) ==
+               static_cast<ssize_t>(bytes.size());
+    };
+    audio::OscMessage noteOn;
+    noteOn.address = "/satori/note/on";
+    noteOn.arguments.resize(2);
+    noteOn.arguments[0].intValue = 60;
+    noteOn.arguments[1].type = 'f';
+    noteOn.arguments[1].floatValue = 0.8;
+    audio::OscMessage gain;
+    gain.address = "/satori/param/masterGain";
+    gain.arguments.resize(1);
+    gain.arguments[0].type = 'f';
+    gain.arguments[0].floatValue = 0.5;
+    audio::OscMessage bogus;
+    bogus.address = "/satori/unknown";
+    REQUIRE(send(noteOn));
+    REQUIRE(send(gain));
+    REQUIRE(send(bogus));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (osc.messageCount() + osc.rejectedCount() < 3 &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    const auto m = player.metrics();
+    ::close(sender);
+
+    REQUIRE(osc.packetCount() == 3);
+    REQUIRE(osc.messageCount() == 2);
+    REQUIRE(osc.rejectedCount() == 1);
+    REQUIRE(m.activeVoices >= 1);
+    REQUIRE(player.getParam(engine::ParamId::MasterGain) == Catch::Approx(0.5f));
+    osc.stop();
+    player.shutdown();
+}
+
+#endif  // _WIN32
@@ -0,0 +1,96 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "dsp/RoomIrLibrary.h"
+#include "engine/PresetBank.h"
+
+TEST_CASE("JSON 预设解析时夹紧数值并可往返序列化", "[engine-core][preset]") {
+    engine::Preset preset;
+    std::string error;
+    REQUIRE(engine::ParsePresetJson(R"({"name": "Warm \"Pad\"", "decay": 2.0,
+        "brightness": 0.25, "bodyModel": "koto", "roomAmount": 0.4,
+        "enableLowpass": false, "excitationType": "hammer", "seed": 77})",
+                                    preset, error));
+    REQUIRE(preset.name == "Warm \"Pad\"");
+    REQUIRE(preset.config.decay == Catch::Approx(0.999f));
+    REQUIRE(preset.config.brightness == Catch::Approx(0.25f));
+    REQUIRE(preset.config.bodyModel == synthesis::BodyModel::Koto);
+    REQUIRE(preset.config.roomAmount == Catch::Approx(0.4f));
+    REQUIRE_FALSE(preset.config.enableLowpass);
+    REQUIRE(preset.config.excitationType == synthesis::ExcitationType::Hammer);
+    REQUIRE(preset.config.seed == 77u);
+    // Left out: keeps what was there.
+    REQUIRE(preset.masterGain == Catch::Approx(1.0f));
+
+    engine::Preset copy;
+    REQUIRE(engine::ParsePresetJson(engine::SerializePresetJson(preset), copy, error));
+    REQUIRE(copy.name == preset.name);
+    REQUIRE(copy.config.decay == Catch::Approx(preset.config.decay));
+    REQUIRE(copy.config.bodyModel == preset.config.bodyModel);
+    REQUIRE(copy.config.seed == preset.config.seed);
+
+    REQUIRE_FALSE(engine::ParsePresetJson(R"({"decay": "soft"})", copy, error));
+    REQUIRE(error.find("decay") != std::string::npos);
+}
+
+TEST_CASE("预设库映射后按名称查找并解码记录", "[engine-core][preset]") {
+    std::vector<engine::Preset> presets(3);
+    presets[0].name = "zither";
+    presets[0].config.brightness = 0.8f;
+    presets[1].name = "Alpha";
+    presets[1].masterGain = 0.5f;
+    presets[1].ampRelease = 1.5f;
+    presets[1].config.bodyModel = synthesis::BodyModel::Guitar;
+    presets[1].config.excitationMode = synthesis::ExcitationMode::FixedNoisePick;
+    presets[1].config.seed = 1234;
+    if (dsp::RoomIrLibrary::list().size() > 1) {
+        presets[1].config.roomIrIndex = 1;
+    }
+    presets[2].name = std::string(100, 'm');
+
+    const auto path = std::filesystem::temp_directory_path() / "satori_preset_bank_test.satbank";
+    std::string error;
+    REQUIRE(engine::WritePresetBank(path, presets, error));
+
+    engine::PresetBank bank;
+    REQUIRE(bank.open(path, error));
+    REQUIRE(bank.size() == 3);
+    REQUIRE(bank.name(0) == "zither");
+    REQUIRE(bank.name(2).size() == engine::kPresetBankNameSize - 1);
+    // Name order ignores case.
+    REQUIRE(bank.sortedIndex(0) == 1);
+    REQUIRE(bank.sortedIndex(1) == 2);
+    REQUIRE(bank.sortedIndex(2) == 0);
+    REQUIRE(bank.find("ALPHA") == 1);
+    REQUIRE(bank.find("Zither") == 0);
+    REQUIRE(bank.find("missing") == -1);
+
+    engine::Preset loaded;
+    REQUIRE(bank.load(1, loaded));
+    REQUIRE(loaded.name == "Alpha");
+    REQUIRE(loaded.masterGain == Catch::Approx(0.5f));
+    REQUIRE(loaded.ampRelease == Catch::Approx(1.5f));
+    REQUIRE(loaded.config.bodyModel == synthesis::BodyModel::Guitar);
+    REQUIRE(loaded.config.excitationMode == synthesis::ExcitationMode::FixedNoisePick);
+    REQUIRE(loaded.config.seed == 1234u);
+    REQUIRE(loaded.config.roomIrIndex == presets[1].config.roomIrIndex);
+    REQUIRE(bank.load(0, loaded));
+    REQUIRE(loaded.config.brightness == Catch::Approx(0.8f));
+    REQUIRE_FALSE(bank.load(3, loaded));
+    bank.close();
+
+    // A truncated file and a foreign one are refused.
+    std::filesystem::resize_file(path, 40);
+    REQUIRE_FALSE(bank.open(path, error));
+    REQUIRE_FALSE(error.empty());
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "RIFF0000WAVEfmt plus some more bytes";
+    }
+    REQUIRE_FALSE(bank.open(path, error));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,177 @@
+// Realtime-safety hooks for the unit tests (engine/RealtimeCheck.h): the
+// global allocator is replaced everywhere, and on glibc the blocking pthread
+// and sleep calls are interposed and forwarded to the real ones. Each hook
+// reports to the checker, which only counts calls made inside a
+// RealtimeScope.
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "engine/RealtimeCheck.h"
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+void* Allocate(std::size_t size) {
+    engine::ReportRealtimeViolation(engine::RealtimeViolation::Allocation, "operator new");
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* AllocateAligned(std::size_t size, std::align_val_t align) {
+    engine::ReportRealtimeViolation(engine::RealtimeViolation::Allocation, "operator new");
+    const auto alignment = static_cast<std::size_t>(align);
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+#if defined(_MSC_VER)
+    void* p = _aligned_malloc(rounded ? rounded : alignment, alignment);
+#else
+    void* p = std::aligned_alloc(alignment, rounded ? rounded : alignment);
+#endif
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void Release(void* p) {
+    if (p) {
+        engine::ReportRealtimeViolation(engine::RealtimeViolation::Allocation, "operator delete");
+    }
+    std::free(p);
+}
+
+void ReleaseAligned(void* p) {
+    if (p) {
+        engine::ReportRealtimeViolation(engine::RealtimeViolation::Allocation, "operator delete");
+    }
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+[[maybe_unused]] const bool kInstalled = [] {
+    engine::SetRealtimeHooksInstalled();
+    return true;
+}();
+
+}  // namespace
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new(std::size_t size, std::align_val_t align) { return AllocateAligned(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return AllocateAligned(size, align);
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return AllocateAligned(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return AllocateAligned(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept { Release(p); }
+void operator delete[](void* p) noexcept { Release(p); }
+void operator delete(void* p, std::size_t) noexcept { Release(p); }
+void operator delete[](void* p, std::size_t) noexcept { Release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { ReleaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { ReleaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { ReleaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { ReleaseAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    ReleaseAligned(p);
+}
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    ReleaseAligned(p);
+}
+
+#if defined(__GLIBC__)
+
+// Definitions in the executable take precedence over libc's; each forwards to
+// the next definition in lookup order, resolved on first use.
+#define SATORI_FORWARD(name, kind, ...)                                                \
+    engine::ReportRealtimeViolation(engine::RealtimeViolation::kind, #name);            \
+    static auto* const real = reinterpret_cast<decltype(&name)>(dlsym(RTLD_NEXT, #name)); \
+    return real(__VA_ARGS__)
+
+extern "C" {
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    SATORI_FORWARD(pthread_mutex_lock, MutexWait, mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+    SATORI_FORWARD(pthread_cond_wait, BlockingCall, cond, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                           const struct timespec* abstime) {
+    SATORI_FORWARD(pthread_cond_timedwait, BlockingCall, cond, mutex, abstime);
+}
+
+int pthread_cond_clockwait(pthread_cond_t* cond, pthread_mutex_t* mutex, clockid_t clock,
+                           const struct timespec* abstime) {
+    SATORI_FORWARD(pthread_cond_clockwait, BlockingCall, cond, mutex, clock, abstime);
+}
+
+int pthread_join(pthread_t thread, void** result) {
+    SATORI_FORWARD(pthread_join, BlockingCall, thread, result);
+}
+
+int sem_wait(sem_t* sem) { SATORI_FORWARD(sem_wait, BlockingCall, sem); }
+
+int nanosleep(const struct timespec* duration, struct timespec* remaining) {
+    SATORI_FORWARD(nanosleep, BlockingCall, duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const struct timespec* request,
+                    struct timespec* remaining) {
+    SATORI_FORWARD(clock_nanosleep, BlockingCall, clock, flags, request, remaining);
+}
+
+int usleep(useconds_t microseconds) { SATORI_FORWARD(usleep, BlockingCall, microseconds); }
+
+}  // extern "C"
+
+#undef SATORI_FORWARD
+
+#endif  // __GLIBC__
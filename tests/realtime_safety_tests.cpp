@@ -0,0 +1,206 @@
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "engine/OutputRecorder.h"
+#include "engine/RealtimeCheck.h"
+#include "engine/StringSynthEngine.h"
+
+namespace {
+
+// Renders `blocks` blocks and returns what the checker saw while doing so.
+engine::RealtimeViolations renderChecked(engine::StringSynthEngine& synth, std::size_t blocks,
+                                         std::vector<float>& buffer, std::uint16_t channels,
+                                         std::size_t frames) {
+    engine::ResetRealtimeViolations();
+    for (std::size_t b = 0; b < blocks; ++b) {
+        synth.process(engine::ProcessBlock{buffer.data(), frames, channels});
+    }
+    return engine::RealtimeViolationSnapshot();
+}
+
+void requireClean(const engine::RealtimeViolations& seen) {
+    std::string counts;
+    for (std::size_t i = 0; i < engine::kRealtimeViolationCount; ++i) {
+        counts += std::string(engine::RealtimeViolationName(static_cast<engine::RealtimeViolation>(i))) +
+                  " " + std::to_string(seen.counts[i]) + "  ";
+    }
+    INFO(counts << "last call: " << (seen.lastCall ? seen.lastCall : "-"));
+    REQUIRE(seen.total() == 0);
+}
+
+}  // namespace
+
+TEST_CASE("实时检查在回调范围内捕获分配、加锁与阻塞调用", "[realtime-safety]") {
+    REQUIRE(engine::RealtimeHooksInstalled());
+    engine::ResetRealtimeViolations();
+
+    // Called directly: new-expressions may be elided, these calls may not.
+    // Outside a scope nothing counts.
+    ::operator delete(::operator new(16));
+    REQUIRE(engine::RealtimeViolationSnapshot().total() == 0);
+
+    {
+        engine::RealtimeScope realtime;
+        REQUIRE(engine::InRealtimeScope());
+        ::operator delete(::operator new(16));
+        {
+            engine::RealtimeAllowance allowed;
+            REQUIRE_FALSE(engine::InRealtimeScope());
+            ::operator delete(::operator new(16));
+        }
+    }
+    REQUIRE_FALSE(engine::InRealtimeScope());
+    auto seen = engine::RealtimeViolationSnapshot();
+    REQUIRE(seen.counts[static_cast<std::size_t>(engine::RealtimeViolation::Allocation)] == 2);
+
+#if defined(__GLIBC__)
+    std::mutex mutex;
+    engine::ResetRealtimeViolations();
+    {
+        engine::RealtimeScope realtime;
+        // try_lock never waits, so it stays allowed.
+        REQUIRE(mutex.try_lock());
+        mutex.unlock();
+        mutex.lock();
+        mutex.unlock();
+        std::this_thread::sleep_for(std::chrono::microseconds(1));
+    }
+    seen = engine::RealtimeViolationSnapshot();
+    REQUIRE(seen.counts[static_cast<std::size_t>(engine::RealtimeViolation::MutexWait)] == 1);
+    REQUIRE(seen.counts[static_cast<std::size_t>(engine::RealtimeViolation::BlockingCall)] == 1);
+#endif
+}
+
+TEST_CASE("StringSynthEngine::process 在实时检查下不分配、不加锁、不阻塞",
+          "[realtime-safety][engine-core]") {
+    constexpr std::size_t kFrames = 256;
+    synthesis::StringConfig cfg;
+    cfg.seed = 3u;
+    cfg.sampleRate = 48000.0;
+
+    SECTION("voices, stealing, pedals and parameter glides") {
+        engine::StringSynthEngine synth(cfg, 8);
+        synth.setRenderMode(engine::RenderMode::Realtime);
+        std::vector<float> buffer(kFrames * 2, 0.0f);
+        renderChecked(synth, 4, buffer, 2, kFrames);  // first block sets up the room
+        for (int i = 0; i < 12; ++i) {
+            synth.noteOn(i + 1, 110.0 * (1.0 + 0.25 * i), 0.8f);
+        }
+        synth.setParam(engine::ParamId::SustainPedal, 1.0f);
+        synth.setParam(engine::ParamId::Brightness, 0.3f);
+        synth.setParam(engine::ParamId::MasterGain, 0.7f);
+        synth.setParam(engine::ParamId::StereoSpread, 0.8f);
+        requireClean(renderChecked(synth, 40, buffer, 2, kFrames));
+        for (int i = 0; i < 12; ++i) {
+            synth.noteOff(i + 1);
+        }
+        synth.setParam(engine::ParamId::SustainPedal, 0.0f);
+        requireClean(renderChecked(synth, 40, buffer, 2, kFrames));
+    }
+
+    SECTION("mono output, odd block sizes and timestamped events") {
+        engine::StringSynthEngine synth(cfg);
+        synth.setRenderMode(engine::RenderMode::Realtime);
+        std::vector<float> buffer(1024, 0.0f);
+        renderChecked(synth, 2, buffer, 1, 64);
+        for (int i = 0; i < 8; ++i) {
+            engine::Event on{};
+            on.type = engine::EventType::NoteOn;
+            on.noteId = i + 1;
+            on.frequency = 196.0 + 30.0 * i;
+            on.velocity = 0.7f;
+            REQUIRE(synth.enqueueEventAt(on, synth.renderedFrames() + 37 * i));
+        }
+        engine::ResetRealtimeViolations();
+        for (std::size_t frames : {1u, 37u, 128u, 1000u, 3u, 512u}) {
+            synth.process(engine::ProcessBlock{buffer.data(), frames, 1});
+        }
+        requireClean(engine::RealtimeViolationSnapshot());
+    }
+
+    SECTION("planar output") {
+        engine::StringSynthEngine synth(cfg);
+        synth.setRenderMode(engine::RenderMode::Realtime);
+        std::vector<float> left(kFrames, 0.0f);
+        std::vector<float> right(kFrames, 0.0f);
+        float* channels[] = {left.data(), right.data()};
+        const engine::PlanarProcessBlock block{channels, kFrames, 2};
+        synth.process(block);
+        synth.noteOn(1, 220.0, 0.9f);
+        synth.noteOn(2, 330.0, 0.9f);
+        engine::ResetRealtimeViolations();
+        for (int b = 0; b < 20; ++b) {
+            synth.process(block);
+        }
+        requireClean(engine::RealtimeViolationSnapshot());
+    }
+
+    SECTION("room changes, quality steps and voice shedding") {
+        engine::StringSynthEngine synth(cfg, 8);
+        std::vector<float> buffer(kFrames * 2, 0.0f);
+        // Auto would switch a test this fast to the inline tail.
+        synth.setRenderMode(engine::RenderMode::Realtime);
+        synth.setParam(engine::ParamId::RoomAmount, 0.5f);
+        renderChecked(synth, 8, buffer, 2, kFrames);
+        for (int i = 0; i < 8; ++i) {
+            synth.noteOn(i + 1, 150.0 * (1.0 + 0.2 * i), 0.8f);
+        }
+        requireClean(renderChecked(synth, 20, buffer, 2, kFrames));
+        synth.setVoiceLimit(3);
+        synth.setParam(engine::ParamId::RoomAmount, 0.0f);
+        requireClean(renderChecked(synth, 20, buffer, 2, kFrames));
+        synth.setParam(engine::ParamId::RoomAmount, 0.6f);
+        requireClean(renderChecked(synth, 20, buffer, 2, kFrames));
+    }
+
+    SECTION("offline rendering runs the room tail inline") {
+        engine::StringSynthEngine synth(cfg);
+        synth.setRenderMode(engine::RenderMode::Offline);
+        synth.setParam(engine::ParamId::RoomAmount, 0.5f);
+        std::vector<float> buffer(kFrames * 2, 0.0f);
+        renderChecked(synth, 8, buffer, 2, kFrames);
+        synth.noteOn(1, 220.0, 0.9f);
+        requireClean(renderChecked(synth, 40, buffer, 2, kFrames));
+    }
+
+    SECTION("layered parts with render threads") {
+        engine::StringSynthEngine synth(cfg, 8, 2, 2);
+        synth.setRenderMode(engine::RenderMode::Realtime);
+        std::vector<float> buffer(kFrames * 2, 0.0f);
+        renderChecked(synth, 4, buffer, 2, kFrames);
+        for (int i = 0; i < 6; ++i) {
+            synth.noteOn(i + 1, 130.0 * (1.0 + 0.3 * i), 0.8f, 0.0, i % 2);
+        }
+        synth.setPartParam(1, engine::ParamId::SympatheticAmount, 0.5f);
+        requireClean(renderChecked(synth, 40, buffer, 2, kFrames));
+    }
+}
+
+TEST_CASE("OutputRecorder::push 在实时检查下只做拷贝", "[realtime-safety][recorder]") {
+    const auto path = std::filesystem::temp_directory_path() / "satori_recorder_rt_test.wav";
+    audio::WaveFormat format;
+    format.sampleRate = 48000;
+    format.sampleFormat = audio::SampleFormat::Int24;
+    format.channels = 2;
+    std::string error;
+    engine::OutputRecorder recorder(4096);
+    REQUIRE(recorder.start(path, format, error));
+    std::vector<float> block(2 * 512, 0.1f);
+    engine::ResetRealtimeViolations();
+    {
+        const engine::RealtimeScope realtime;
+        // Plenty of these overrun the small ring; dropping must be as cheap.
+        for (int b = 0; b < 64; ++b) {
+            recorder.push(block.data(), 512, 2);
+        }
+    }
+    requireClean(engine::RealtimeViolationSnapshot());
+    REQUIRE(recorder.stop(error));
+    std::filesystem::remove(path);
+}
@@ -1,5 +1,6 @@
 #include <catch2/catch_amalgamated.hpp>
 
+#include "dsp/RoomIrLibrary.h"
 #include "engine/StringParams.h"
 #include "engine/StringSynthEngine.h"
 
@@ -33,6 +34,25 @@ TEST_CASE("参数名称查找大小写不敏感", "[engine-params]") {
     REQUIRE(room->id == engine::ParamId::RoomAmount);
 }
 
+TEST_CASE("参数表按 ParamId 直接索引且名称哈希无冲突", "[engine-params]") {
+    static_assert(engine::GetParamInfo(engine::ParamId::MasterGain)->maxValue == 2.0f);
+    const auto params = engine::GetParamInfoList();
+    REQUIRE(params.size() == engine::kParamCount);
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        REQUIRE(static_cast<std::size_t>(params[i].id) == i);
+        REQUIRE(engine::GetParamInfo(params[i].id) == &params[i]);
+        REQUIRE(engine::FindParamByName(params[i].name) == &params[i]);
+    }
+    REQUIRE(engine::GetParamInfo(static_cast<engine::ParamId>(engine::kParamCount)) == nullptr);
+    REQUIRE(engine::GetParamInfo(engine::ParamId::RoomIR)->maxValue ==
+            static_cast<float>(dsp::RoomIrLibrary::list().size()));
+
+    REQUIRE(engine::FindParamByName("") == nullptr);
+    REQUIRE(engine::FindParamByName("deca") == nullptr);
+    REQUIRE(engine::FindParamByName("decayx") == nullptr);
+    REQUIRE(engine::FindParamByName("master gain") == nullptr);
+}
+
 TEST_CASE("StringSynthEngine 参数写入会按范围钳制", "[engine-params]") {
     engine::StringSynthEngine synth;
 
@@ -69,6 +69,29 @@ TEST_CASE("SatoriRealtimeEngine 支持更改工作采样率", "[realtime-engine]
     REQUIRE(syncedConfig.decay == Catch::Approx(alteredConfig.decay));
 }
 
+TEST_CASE("SatoriRealtimeEngine 可跟随设备采样率运行", "[realtime-engine]") {
+    ScopedCOM com;
+    winaudio::SatoriRealtimeEngine engine;
+    REQUIRE(engine.initialize());
+
+    const double deviceSampleRate = static_cast<double>(engine.audioConfig().sampleRate);
+    REQUIRE(deviceSampleRate > 0.0);
+
+    synthesis::StringConfig alteredConfig = engine.synthConfig();
+    alteredConfig.sampleRate = (std::abs(deviceSampleRate - 48000.0) < 1e-6) ? 44100.0 : 48000.0;
+    engine.setSynthConfig(alteredConfig);
+    REQUIRE(engine.synthConfig().sampleRate == Catch::Approx(alteredConfig.sampleRate));
+
+    engine.setFollowDeviceRate(true);
+    REQUIRE(engine.synthConfig().sampleRate == Catch::Approx(deviceSampleRate));
+    engine.setSynthConfig(alteredConfig);
+    REQUIRE(engine.synthConfig().sampleRate == Catch::Approx(deviceSampleRate));
+
+    engine.setFollowDeviceRate(false);
+    engine.setSynthConfig(alteredConfig);
+    REQUIRE(engine.synthConfig().sampleRate == Catch::Approx(alteredConfig.sampleRate));
+}
+
 TEST_CASE("StringSynthEngine 处理 NoteOn 并耗尽 voice", "[engine]") {
     synthesis::StringConfig config;
     config.sampleRate = 48000.0;